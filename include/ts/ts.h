@@ -727,6 +727,18 @@ tsapi TSReturnCode TSUrlPercentEncode(TSMBuffer bufp, TSMLoc offset, char *dst,
 */
 tsapi TSReturnCode TSStringPercentDecode(const char *str, size_t str_len, char *dst, size_t dst_size, size_t *length);
 
+/**
+   Similar to TSStringPercentDecode(), but works on a URL object.
+
+   @param bufp marshal buffer containing the URL.
+   @param offset location of the URL within bufp.
+   @param dst destination buffer.
+   @param dst_size size of the destination buffer.
+   @param length amount of data written to the destination buffer.
+
+*/
+tsapi TSReturnCode TSUrlPercentDecode(TSMBuffer bufp, TSMLoc offset, char *dst, size_t dst_size, size_t *length);
+
 /* --------------------------------------------------------------------------
    MIME headers */
 
@@ -913,6 +925,38 @@ tsapi TSMLoc TSMimeHdrFieldGet(TSMBuffer bufp, TSMLoc hdr, int idx);
  */
 tsapi TSMLoc TSMimeHdrFieldFind(TSMBuffer bufp, TSMLoc hdr, const char *name, int length);
 
+/**
+    Retrieves the values of several MIME fields of the MIME header located at hdr in one call,
+    without allocating a TSMLoc handle per field. For each of the count elements of fields, the
+    value of the first field named name is stored in value and value_len, or value is set to
+    nullptr if there is no such field. A TS_MIME_FIELD_XXX name is looked up without a string
+    comparison. The values point into the marshal buffer and are valid until the header is
+    modified, the duplicates of a field are not included.
+
+    @param bufp marshal buffer containing the MIME header.
+    @param hdr location of the MIME header.
+    @param fields the fields to retrieve.
+    @param count number of elements of fields.
+    @return the number of fields found.
+
+ */
+tsapi int TSMimeHdrFieldValuesGet(TSMBuffer bufp, TSMLoc hdr, TSMimeHdrFieldValue *fields, int count);
+
+/**
+    Sets the values of several MIME fields of the MIME header located at hdr in one call, without
+    allocating a TSMLoc handle per field. Each field named name is created if it is not present,
+    its duplicates are removed, and its value is set to value. A field with a nullptr value is
+    removed instead. A value_len of -1 means value is NUL terminated.
+
+    @param bufp marshal buffer containing the MIME header.
+    @param hdr location of the MIME header.
+    @param fields the fields to set.
+    @param count number of elements of fields.
+    @return TS_ERROR if bufp is not writeable, TS_SUCCESS otherwise.
+
+ */
+tsapi TSReturnCode TSMimeHdrFieldValuesSet(TSMBuffer bufp, TSMLoc hdr, const TSMimeHdrFieldValue *fields, int count);
+
 /**
     Returns the TSMLoc location of a specified MIME field from within
     the MIME header located at hdr. The retrieved_str parameter
@@ -1187,6 +1231,13 @@ tsapi TSReturnCode TSMgmtCounterGet(const char *var_name, TSMgmtCounter *result)
 tsapi TSReturnCode TSMgmtFloatGet(const char *var_name, TSMgmtFloat *result);
 tsapi TSReturnCode TSMgmtStringGet(const char *var_name, TSMgmtString *result);
 tsapi TSReturnCode TSMgmtSourceGet(const char *var_name, TSMgmtSource *source);
+
+/* Find a management value once, to get it later, e.g. for each transaction,
+   without the lookup of its name. Returns NULL if there is no such value. */
+tsapi TSMgmtRecord TSMgmtRecordFind(const char *var_name);
+tsapi TSReturnCode TSMgmtRecordIntGet(TSMgmtRecord record, TSMgmtInt *result);
+tsapi TSReturnCode TSMgmtRecordCounterGet(TSMgmtRecord record, TSMgmtCounter *result);
+tsapi TSReturnCode TSMgmtRecordFloatGet(TSMgmtRecord record, TSMgmtFloat *result);
 /* --------------------------------------------------------------------------
    Continuations */
 tsapi TSCont TSContCreate(TSEventFunc funcp, TSMutex mutexp);
@@ -1199,6 +1250,23 @@ tsapi TSAction TSContScheduleOnThread(TSCont contp, TSHRTime timeout, TSEventThr
 tsapi TSAction TSContScheduleEvery(TSCont contp, TSHRTime every /* millisecs */);
 tsapi TSAction TSContScheduleEveryOnPool(TSCont contp, TSHRTime every /* millisecs */, TSThreadPool tp);
 tsapi TSAction TSContScheduleEveryOnThread(TSCont contp, TSHRTime every /* millisecs */, TSEventThread ethread);
+/**
+    Schedules count continuations at once, each on its thread affinity or, if it has none, on the
+    calling event thread (which becomes its affinity). The actions are stored in actions if it is
+    not nullptr, nullptr for a continuation that could not be scheduled.
+
+    @return the number of continuations scheduled.
+
+ */
+tsapi int TSContScheduleBatch(TSCont *contps, int count, TSHRTime timeout, TSAction *actions);
+/**
+    Calls funcp with data on the calling event thread once the current event is handled, without
+    allocating an event or taking a lock. The callback can not be cancelled.
+
+    @return TS_ERROR if not called on an event thread.
+
+ */
+tsapi TSReturnCode TSEventThreadCallbackPost(TSEventThreadCallbackFunc funcp, void *data);
 tsapi TSReturnCode TSContThreadAffinitySet(TSCont contp, TSEventThread ethread);
 tsapi TSEventThread TSContThreadAffinityGet(TSCont contp);
 tsapi void TSContThreadAffinityClear(TSCont contp);
@@ -1551,6 +1619,13 @@ tsapi TSReturnCode TSHttpCacheReenable(TSCacheTxn txnp, const TSEvent event, con
 
 tsapi void TSHttpTxnArgSet(TSHttpTxn txnp, int arg_idx, void *arg);
 tsapi void *TSHttpTxnArgGet(TSHttpTxn txnp, int arg_idx);
+
+/**
+    Allocate @a size bytes that live as long as the transaction @a txnp. The memory is aligned for
+    any type and is released all at once when the transaction is done, it must not be freed.
+ */
+tsapi void *TSHttpTxnArenaAlloc(TSHttpTxn txnp, size_t size);
+
 tsapi void TSHttpSsnArgSet(TSHttpSsn ssnp, int arg_idx, void *arg);
 tsapi void *TSHttpSsnArgGet(TSHttpSsn ssnp, int arg_idx);
 tsapi void TSVConnArgSet(TSVConn connp, int arg_idx, void *arg);
@@ -1761,6 +1836,15 @@ tsapi TSVConn TSTransformOutputVConnGet(TSVConn connp);
    Net VConnections */
 tsapi struct sockaddr const *TSNetVConnRemoteAddrGet(TSVConn vc);
 
+/**
+    Get the value of the TLV @a type of the PROXY protocol v2 header the connection @a vc came
+    with. The sub TLVs of the SSL TLV can be asked for directly. The value is not nul terminated
+    and is valid for the life of @a vc.
+
+    @return TS_SUCCESS and sets @a value and @a length if there is such a TLV, TS_ERROR otherwise.
+ */
+tsapi TSReturnCode TSNetVConnProxyProtocolTlvGet(TSVConn vc, int type, const char **value, int *length);
+
 /**
     Opens a network connection to the host specified by ip on the port
     specified by port. If the connection is successfully opened, contp
@@ -2033,6 +2117,7 @@ typedef enum {
   TS_STAT_SYNC_COUNT,
   TS_STAT_SYNC_AVG,
   TS_STAT_SYNC_TIMEAVG,
+  TS_STAT_SYNC_HISTOGRAM,
 } TSStatSync;
 
 /* APIs to create new records.config configurations */
@@ -2047,6 +2132,8 @@ tsapi int TSStatCreate(const char *the_name, TSRecordDataType the_type, TSStatPe
 
 tsapi void TSStatIntIncrement(int the_stat, TSMgmtInt amount);
 tsapi void TSStatIntDecrement(int the_stat, TSMgmtInt amount);
+/* Only for a stat created with TS_STAT_SYNC_HISTOGRAM. */
+tsapi void TSStatHistogramRecord(int the_stat, TSMgmtInt value);
 /* Currently not supported. */
 /* tsapi void TSStatFloatIncrement(int the_stat, float amount); */
 /* tsapi void TSStatFloatDecrement(int the_stat, float amount); */
@@ -2059,6 +2146,39 @@ tsapi void TSStatIntSet(int the_stat, TSMgmtInt value);
 
 tsapi TSReturnCode TSStatFindName(const char *name, int *idp);
 
+/* --------------------------------------------------------------------------
+   Key value stores, shared by all the threads and plugins. */
+
+/**
+    Get the key value store @a name, it is created on the first call. All the plugins that get the
+    same name share the store, and it lives as long as the process, a reloaded plugin finds its
+    entries again. The least recently used entries are evicted to keep the store within about
+    max_bytes, 0 for no limit. The limit is set by the call that creates the store.
+
+    The keys are spread over many locks, the threads only contend on the keys of the same lock.
+ */
+tsapi TSKvStore TSKvStoreGet(const char *name, int64_t max_bytes);
+
+/**
+    Copy the value of @a key to @a buf, at most @a buf_len bytes. A @a key_len of -1 means strlen.
+
+    @return the length of the value, which can be more than @a buf_len, or -1 if there is no such key.
+ */
+tsapi int64_t TSKvStoreValueGet(TSKvStore store, const char *key, int key_len, char *buf, int64_t buf_len);
+
+/** Set the value of @a key, for @a ttl seconds or for ever if @a ttl is 0. */
+tsapi TSReturnCode TSKvStoreValueSet(TSKvStore store, const char *key, int key_len, const char *value, int64_t value_len, int ttl);
+
+/** Remove @a key, TS_ERROR if there was no such key. */
+tsapi TSReturnCode TSKvStoreValueRemove(TSKvStore store, const char *key, int key_len);
+
+/**
+    Atomically add @a delta to the counter @a key and return its new value. A new counter starts
+    from 0 and expires after @a ttl seconds, 0 for never, which doesn't change while it is counted.
+    The value of a counter is its decimal text for TSKvStoreValueGet.
+ */
+tsapi int64_t TSKvStoreCounterIncrement(TSKvStore store, const char *key, int key_len, int64_t delta, int ttl);
+
 /* --------------------------------------------------------------------------
    tracing api */
 
@@ -205,6 +205,12 @@ public:
   {
     return m_hostname;
   }
+  /// The name the file was last rolled to, nullptr if it has not been rolled.
+  const char *
+  get_rolled_name() const
+  {
+    return m_rolled_name;
+  }
   void
   set_hostname(const char *hn)
   {
@@ -231,6 +237,7 @@ private:
   // member variables
   ats_scoped_str m_name;
   ats_scoped_str m_hostname;
+  ats_scoped_str m_rolled_name;
   bool m_is_regfile         = false;
   bool m_is_init            = false;
   BaseMetaInfo *m_meta_info = nullptr;
@@ -0,0 +1,44 @@
+/** @file
+
+  CRC32C (Castagnoli) checksums.
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace ts
+{
+/** The CRC32C of @a length bytes at @a data, continued from @a crc.
+
+    This uses the SSE4.2 instruction if the CPU has it, or the ARMv8 one when built for it, and a
+    table otherwise. Passing the result of one call as @a crc of the next gives the CRC of the
+    concatenated data.
+ */
+uint32_t crc32c(const void *data, size_t length, uint32_t crc = 0);
+
+/// The table driven CRC32C, the reference for @c crc32c.
+uint32_t crc32c_portable(const void *data, size_t length, uint32_t crc = 0);
+
+/// Whether @c crc32c uses a CPU instruction.
+bool crc32c_hardware();
+} // namespace ts
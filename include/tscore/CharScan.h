@@ -0,0 +1,164 @@
+/** @file
+
+  Vectorized byte searches and compares.
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+namespace ts
+{
+/** Find the first byte in [ @a s, @a e ) equal to one of @a c.
+
+    This is a byte by byte loop, the reference for @c scan_any.
+ */
+template <typename... C>
+inline const char *
+scan_any_scalar(const char *s, const char *e, C... c)
+{
+  for (; s < e; ++s) {
+    if (((*s == c) || ...)) {
+      return s;
+    }
+  }
+  return e;
+}
+
+/** Find the first byte in [ @a s, @a e ) equal to one of @a c.
+
+    This tests 32 (AVX2) or 16 (SSE2, NEON) bytes at a time, with one compare per value. Nothing
+    past @a e is read. It is faster than separate @c memchr calls when more than one value is looked
+    for, e.g. the end of a header line and an embedded NUL in a single pass.
+
+    @return A pointer to the first match, @a e if there is none.
+ */
+template <typename... C>
+inline const char *
+scan_any(const char *s, const char *e, C... c)
+{
+#if defined(__AVX2__)
+  while (e - s >= 32) {
+    __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(s));
+    __m256i m = ((_mm256_cmpeq_epi8(v, _mm256_set1_epi8(c))) | ...);
+    if (uint32_t bits = _mm256_movemask_epi8(m); bits) {
+      return s + __builtin_ctz(bits);
+    }
+    s += 32;
+  }
+#endif
+#if defined(__SSE2__)
+  while (e - s >= 16) {
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(s));
+    __m128i m = ((_mm_cmpeq_epi8(v, _mm_set1_epi8(c))) | ...);
+    if (uint32_t bits = _mm_movemask_epi8(m); bits) {
+      return s + __builtin_ctz(bits);
+    }
+    s += 16;
+  }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+  while (e - s >= 16) {
+    uint8x16_t v = vld1q_u8(reinterpret_cast<const uint8_t *>(s));
+    uint8x16_t m = ((vceqq_u8(v, vdupq_n_u8(static_cast<uint8_t>(c)))) | ...);
+    if (vmaxvq_u8(m)) {
+      // Narrow each byte of the mask to a nibble to get a scalar bitmap.
+      uint64_t bits = vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(m), 4)), 0);
+      return s + __builtin_ctzll(bits) / 4;
+    }
+    s += 16;
+  }
+#endif
+  return scan_any_scalar(s, e, c...);
+}
+
+/// @a c with ASCII upper case letters converted to lower case, other bytes are unchanged.
+inline char
+ascii_tolower(char c)
+{
+  return static_cast<unsigned char>(c - 'A') < 26 ? c | 0x20 : c;
+}
+
+namespace detail
+{
+#if defined(__SSE2__)
+  /// Check if 16 bytes at @a a and @a b are equal ignoring ASCII case.
+  inline bool
+  equal_nocase_16(const char *a, const char *b)
+  {
+    // Bias so 'A' is the smallest signed value, then the letters are those below 'A' + 26.
+    auto fold = [](__m128i v) {
+      __m128i upper = _mm_cmplt_epi8(_mm_sub_epi8(v, _mm_set1_epi8(static_cast<char>('A' + 128))), _mm_set1_epi8(-128 + 26));
+      return _mm_or_si128(v, _mm_and_si128(upper, _mm_set1_epi8(0x20)));
+    };
+    __m128i va = fold(_mm_loadu_si128(reinterpret_cast<const __m128i *>(a)));
+    __m128i vb = fold(_mm_loadu_si128(reinterpret_cast<const __m128i *>(b)));
+    return _mm_movemask_epi8(_mm_cmpeq_epi8(va, vb)) == 0xFFFF;
+  }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+  inline bool
+  equal_nocase_16(const char *a, const char *b)
+  {
+    auto fold = [](uint8x16_t v) {
+      uint8x16_t upper = vcleq_u8(vsubq_u8(v, vdupq_n_u8('A')), vdupq_n_u8(25));
+      return vorrq_u8(v, vandq_u8(upper, vdupq_n_u8(0x20)));
+    };
+    uint8x16_t va = fold(vld1q_u8(reinterpret_cast<const uint8_t *>(a)));
+    uint8x16_t vb = fold(vld1q_u8(reinterpret_cast<const uint8_t *>(b)));
+    return vminvq_u8(vceqq_u8(va, vb)) == 0xFF;
+  }
+#endif
+} // namespace detail
+
+/** Check if the @a n bytes at @a a and @a b are equal ignoring ASCII case.
+
+    Strings of 16 bytes or more are compared 16 at a time, the last block overlapping the one
+    before it so nothing past @a n is read.
+ */
+inline bool
+equal_nocase(const char *a, const char *b, size_t n)
+{
+#if defined(__SSE2__) || (defined(__ARM_NEON) && defined(__aarch64__))
+  if (n >= 16) {
+    for (size_t i = 0; i + 16 < n; i += 16) {
+      if (!detail::equal_nocase_16(a + i, b + i)) {
+        return false;
+      }
+    }
+    return detail::equal_nocase_16(a + n - 16, b + n - 16);
+  }
+#endif
+  for (size_t i = 0; i < n; ++i) {
+    if (ascii_tolower(a[i]) != ascii_tolower(b[i])) {
+      return false;
+    }
+  }
+  return true;
+}
+} // namespace ts
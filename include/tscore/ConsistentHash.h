@@ -22,9 +22,10 @@
 #pragma once
 
 #include "Hash.h"
+#include <cstddef>
 #include <cstdint>
 #include <iostream>
-#include <map>
+#include <vector>
 
 /*
   Helper class to be extended to make ring nodes.
@@ -37,12 +38,17 @@ struct ATSConsistentHashNode {
 
 std::ostream &operator<<(std::ostream &os, ATSConsistentHashNode &thing);
 
-typedef std::map<uint64_t, ATSConsistentHashNode *>::iterator ATSConsistentHashIter;
+/// Position in the ring, @c size() of the ring is past the end.
+typedef size_t ATSConsistentHashIter;
 
 /*
   TSConsistentHash requires a TSHash64 object
 
   Caller is responsible for freeing ring node memory.
+
+  The ring is a sorted array of the hash points, with the nodes in a parallel array, so a lookup is
+  a branch free binary search over contiguous keys. The ring is built by insert() and is read only
+  afterwards, the lookups can run concurrently.
  */
 
 struct ATSConsistentHash {
@@ -55,8 +61,19 @@ struct ATSConsistentHash {
   ATSConsistentHashNode *lookup_by_hashval(uint64_t hashval, ATSConsistentHashIter *i = nullptr, bool *w = nullptr);
   ~ATSConsistentHash();
 
+  /// Number of points in the ring.
+  size_t
+  size() const
+  {
+    return keys.size();
+  }
+
 private:
+  /// Index of the first point not less than @a hashval, @c size() if there is none.
+  size_t lower_bound(uint64_t hashval) const;
+
   int replicas;
   ATSHash64 *hash;
-  std::map<uint64_t, ATSConsistentHashNode *> NodeMap;
+  std::vector<uint64_t> keys;                 ///< Hash points of the ring, sorted.
+  std::vector<ATSConsistentHashNode *> nodes; ///< Node of each point of @a keys.
 };
@@ -33,6 +33,7 @@
 
 #pragma once
 
+#include <atomic>
 #include <cstdarg>
 #include "ink_mutex.h"
 #include "Regex.h"
@@ -158,6 +159,9 @@ public:
 
   bool tag_activated(const char *tag, DiagsTagType mode = DiagsTagType_Debug) const;
 
+  /// Changed each time the activated tags of any Diags change, see DiagsTagCache.
+  static std::atomic<uint64_t> tag_generation;
+
   /////////////////////////////
   // raw printing interfaces //
   /////////////////////////////
@@ -263,6 +267,52 @@ private:
   }
 };
 
+//////////////////////////////////////////////////////////////////////////
+//
+//      class DiagsTagCache
+//
+//      The result of the tag check of one call site of the macros below,
+//      so that the tag is matched against the activated tags only after
+//      they change, instead of at each call. A site that is passed more
+//      than one tag only caches the first one, the others are checked
+//      each time.
+//
+//////////////////////////////////////////////////////////////////////////
+
+class DiagsTagCache
+{
+public:
+  bool
+  activated(const Diags *d, const char *tag, DiagsTagType mode = DiagsTagType_Debug)
+  {
+    if (tag == nullptr) {
+      return true;
+    }
+
+    // The tag of the site is set once, the result is only stored for it.
+    const char *site_tag = _tag.load(std::memory_order_relaxed);
+    if (site_tag == nullptr && _tag.compare_exchange_strong(site_tag, tag, std::memory_order_relaxed)) {
+      site_tag = tag;
+    }
+    if (site_tag != tag) {
+      return d->tag_activated(tag, mode);
+    }
+
+    // The generation is read first, so a change during the check leaves a result that is checked again.
+    uint64_t generation = Diags::tag_generation.load(std::memory_order_acquire);
+    uint64_t state      = _state.load(std::memory_order_relaxed);
+    if ((state >> 1) != generation) {
+      state = (generation << 1) | (d->tag_activated(tag, mode) ? 1 : 0);
+      _state.store(state, std::memory_order_relaxed);
+    }
+    return state & 1;
+  }
+
+private:
+  std::atomic<const char *> _tag{nullptr};
+  std::atomic<uint64_t> _state{0}; // the generation of the result, and the result in the low bit
+};
+
 //////////////////////////////////////////////////////////////////////////
 //                                                                      //
 //      Macros                                                          //
@@ -314,32 +364,48 @@ extern inkcoreapi Diags *diags;
 
 #ifdef TS_USE_DIAGS
 
-#define Diag(tag, ...)                                 \
-  do {                                                 \
-    if (unlikely(diags->on())) {                       \
-      const SourceLocation loc = MakeSourceLocation(); \
-      diags->log(tag, DL_Diag, &loc, __VA_ARGS__);     \
-    }                                                  \
+#define Diag(tag, ...)                                   \
+  do {                                                   \
+    if (unlikely(diags->on())) {                         \
+      static DiagsTagCache _diags_tag_cache;             \
+      if (_diags_tag_cache.activated(diags, tag)) {      \
+        const SourceLocation loc = MakeSourceLocation(); \
+        diags->print(tag, DL_Diag, &loc, __VA_ARGS__);   \
+      }                                                  \
+    }                                                    \
   } while (0)
 
-#define Debug(tag, ...)                                \
-  do {                                                 \
-    if (unlikely(diags->on())) {                       \
-      const SourceLocation loc = MakeSourceLocation(); \
-      diags->log(tag, DL_Debug, &loc, __VA_ARGS__);    \
-    }                                                  \
+#define Debug(tag, ...)                                  \
+  do {                                                   \
+    if (unlikely(diags->on())) {                         \
+      static DiagsTagCache _diags_tag_cache;             \
+      if (_diags_tag_cache.activated(diags, tag)) {      \
+        const SourceLocation loc = MakeSourceLocation(); \
+        diags->print(tag, DL_Debug, &loc, __VA_ARGS__);  \
+      }                                                  \
+    }                                                    \
   } while (0)
 
-#define SpecificDebug(flag, tag, ...)                                                                       \
-  do {                                                                                                      \
-    if (unlikely(diags->on())) {                                                                            \
-      const SourceLocation loc = MakeSourceLocation();                                                      \
-      flag ? diags->print(tag, DL_Debug, &loc, __VA_ARGS__) : diags->log(tag, DL_Debug, &loc, __VA_ARGS__); \
-    }                                                                                                       \
+#define SpecificDebug(flag, tag, ...)                         \
+  do {                                                        \
+    if (unlikely(diags->on())) {                              \
+      static DiagsTagCache _diags_tag_cache;                  \
+      if ((flag) || _diags_tag_cache.activated(diags, tag)) { \
+        const SourceLocation loc = MakeSourceLocation();      \
+        diags->print(tag, DL_Debug, &loc, __VA_ARGS__);       \
+      }                                                       \
+    }                                                         \
   } while (0)
 
-#define is_debug_tag_set(_t) unlikely(diags->on(_t, DiagsTagType_Debug))
-#define is_action_tag_set(_t) unlikely(diags->on(_t, DiagsTagType_Action))
+// The lambda gives each use a cache of its own.
+#define DiagsTagCached(_d, _t, _mode)                               \
+  [](const Diags *_cached_d, const char *_cached_t) {               \
+    static DiagsTagCache _diags_tag_cache;                          \
+    return _diags_tag_cache.activated(_cached_d, _cached_t, _mode); \
+  }(_d, _t)
+
+#define is_debug_tag_set(_t) unlikely(diags->on(DiagsTagType_Debug) && DiagsTagCached(diags, _t, DiagsTagType_Debug))
+#define is_action_tag_set(_t) unlikely(diags->on(DiagsTagType_Action) && DiagsTagCached(diags, _t, DiagsTagType_Action))
 #define debug_tag_assert(_t, _a) (is_debug_tag_set(_t) ? (ink_release_assert(_a), 0) : 0)
 #define action_tag_assert(_t, _a) (is_action_tag_set(_t) ? (ink_release_assert(_a), 0) : 0)
 #define is_diags_on(_t) unlikely(diags->on(_t))
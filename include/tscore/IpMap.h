@@ -61,8 +61,9 @@ namespace detail
     Metric _max; ///< Maximum value in span.
   };
 
-  class Ip4Map; // Forward declare.
-  class Ip6Map; // Forward declare.
+  class Ip4Map;     // Forward declare.
+  class Ip6Map;     // Forward declare.
+  struct IpMapFlat; // Forward declare.
 } // namespace detail
 } // namespace ts
 
@@ -351,6 +352,17 @@ public:
   */
   self_type &clear();
 
+  /** Build a compact copy of the map for lookups.
+
+      The ranges are copied into sorted arrays that @c contains searches instead of the trees,
+      which touches far less memory for a large map. This is meant for a map that is built once and
+      then only read, any later change to the map discards the copy. The client data is copied, so
+      this must be called after the data of the nodes is last set.
+
+      @return This object.
+  */
+  self_type &freeze();
+
   /// Iterator for first element.
   iterator begin() const;
   /// Iterator past last element.
@@ -378,9 +390,12 @@ protected:
   /// Force the IPv6 map to exist.
   /// @return The IPv6 map.
   ts::detail::Ip6Map *force6();
+  /// Discard the compact copy, if any.
+  void thaw();
 
-  ts::detail::Ip4Map *_m4 = nullptr; ///< Map of IPv4 addresses.
-  ts::detail::Ip6Map *_m6 = nullptr; ///< Map of IPv6 addresses.
+  ts::detail::Ip4Map *_m4      = nullptr; ///< Map of IPv4 addresses.
+  ts::detail::Ip6Map *_m6      = nullptr; ///< Map of IPv6 addresses.
+  ts::detail::IpMapFlat *_flat = nullptr; ///< Compact copy of the map, if frozen.
 };
 
 inline IpMap &
@@ -29,6 +29,9 @@
 #if (JEMALLOC_VERSION_MAJOR == 5) && defined(MADV_DONTDUMP)
 #define JEMALLOC_NODUMP_ALLOCATOR_SUPPORTED 1
 #endif /* MADV_DONTDUMP */
+#if JEMALLOC_VERSION_MAJOR >= 5
+#define JEMALLOC_FREELIST_ALLOCATOR_SUPPORTED 1
+#endif /* JEMALLOC_VERSION_MAJOR */
 #endif /* TS_HAS_JEMALLOC */
 
 namespace jearena
@@ -82,4 +85,57 @@ private:
  */
 JemallocNodumpAllocator &globalJemallocNodumpAllocator();
 
+/**
+ * An allocator for the items of the freelists, from a dedicated arena.
+ *
+ * Unlike the chunks the freelists carve their items from, which are kept for
+ * good, jemalloc purges the pages of the arena that stay unused, so the
+ * resident memory shrinks again after a spike. The alloc extent hook wraps the
+ * original one like JemallocNodumpAllocator does, and asks for transparent
+ * huge pages on the new extents when the huge pages are enabled. As the arena
+ * grows its extents exponentially, most of its memory is in extents large
+ * enough for huge pages. The memory is also left out of the core dumps if the
+ * allocator is created with @a dontdump.
+ *
+ * Each thread gets a cache of its own for the arena, the caches are not freed
+ * when the thread exits.
+ */
+class JemallocFreelistAllocator
+{
+public:
+  explicit JemallocFreelistAllocator(bool dontdump);
+
+  void *allocate(InkFreeList *f);
+  void deallocate(InkFreeList *f, void *ptr);
+
+private:
+#if JEMALLOC_FREELIST_ALLOCATOR_SUPPORTED
+  static constexpr int MAX_ALLOCATORS = 4;
+
+  // The hooks of the arena, jemalloc hands the alloc hook a pointer to them.
+  struct Hooks {
+    extent_hooks_t hooks;
+    extent_alloc_t *original_alloc;
+    bool dontdump;
+  };
+
+  static void *alloc(extent_hooks_t *extent, void *new_addr, size_t size, size_t alignment, bool *zero, bool *commit,
+                     unsigned arena_ind);
+  int tcache_flags();
+
+  Hooks hooks_;
+  unsigned arena_index_{0};
+  int index_{0};
+
+  static int count_;
+  static thread_local int tcaches_[MAX_ALLOCATORS];
+#endif /* JEMALLOC_FREELIST_ALLOCATOR_SUPPORTED */
+};
+
+/**
+ * The JemallocFreelistAllocator singletons, for the freelists that leave their memory out of core dumps
+ * if @a dontdump and for the others.
+ */
+JemallocFreelistAllocator &globalJemallocFreelistAllocator(bool dontdump);
+
 } /* namespace jearena */
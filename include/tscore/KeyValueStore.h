@@ -0,0 +1,121 @@
+/** @file
+
+  Concurrent key value store with expiration and a memory limit.
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <ctime>
+#include <list>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace ts
+{
+/** A hash map of strings that many threads can use at once.
+
+    The keys are spread over @c PARTITIONS partitions by their hash, each with its own lock, so
+    threads only contend when they use keys of the same partition. An entry can have an expiration
+    time, after which it is no longer found. Each partition gets an equal share of the memory limit
+    and evicts its least recently used entries to stay within it.
+
+    The times are passed in by the caller, in seconds, an expiration time of 0 never expires.
+ */
+class KeyValueStore
+{
+public:
+  static constexpr int PARTITIONS        = 64;
+  static constexpr size_t ENTRY_OVERHEAD = 96; ///< Memory charged to an entry in addition to its key and value.
+
+  /// A store that uses at most about @a max_bytes, 0 for no limit.
+  explicit KeyValueStore(size_t max_bytes = 0);
+
+  /// Copy the value of @a key to @a value, return @c false if there is none at @a now.
+  bool get(std::string_view key, std::string &value, time_t now);
+
+  /// Set the value of @a key to @a value, until @a expires.
+  void set(std::string_view key, std::string_view value, time_t expires);
+
+  /** Set the value of @a key to @a value, until @a expires, if it has no value at @a now.
+
+      Return @c false and leave the value alone if it has one. Threads that add the same key at the
+      same time can tell which one added it first.
+   */
+  bool add(std::string_view key, std::string_view value, time_t expires, time_t now);
+
+  /// Remove @a key, return @c false if there was no such key.
+  bool remove(std::string_view key);
+
+  /** Add @a delta to the counter @a key and return the new value.
+
+      A counter that does not exist at @a now starts from 0 and expires at @a expires, the
+      expiration time of an existing counter is not changed. The value of a counter is its decimal
+      text, a value that is not a number counts as 0.
+   */
+  int64_t increment(std::string_view key, int64_t delta, time_t expires, time_t now);
+
+  /// The number of entries, including the expired entries not yet removed.
+  size_t count();
+
+  /// The memory charged to the entries.
+  size_t bytes();
+
+private:
+  struct Entry;
+  using Map = std::unordered_map<std::string, Entry>;
+  using Lru = std::list<Map::iterator>;
+
+  struct Entry {
+    std::string value;
+    time_t expires = 0;
+    Lru::iterator lru;
+  };
+
+  struct Partition {
+    std::mutex mutex;
+    Map map;
+    Lru lru; ///< Most recently used first.
+    size_t bytes = 0;
+  };
+
+  Partition &partition_of(std::string_view key);
+
+  /// Find the live entry of @a key in @a p and make it the most recently used, erase it if it expired.
+  Map::iterator find(Partition &p, std::string_view key, time_t now);
+  Map::iterator insert(Partition &p, std::string_view key);
+  void erase(Partition &p, Map::iterator spot);
+  void resize(Partition &p, Map::iterator spot, std::string_view value);
+  void evict(Partition &p, Map::iterator keep);
+
+  static size_t
+  charge(std::string const &key, std::string const &value)
+  {
+    return key.size() + value.size() + ENTRY_OVERHEAD;
+  }
+
+  size_t _partition_max = 0; ///< Most bytes of a partition, 0 for no limit.
+  Partition _partitions[PARTITIONS];
+};
+
+} // namespace ts
@@ -0,0 +1,155 @@
+/** @file
+
+  Fixed size log-linear histogram for latency samples.
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+
+/** A histogram of non-negative values with a fixed relative error.
+
+    Values below @c SUB are counted exactly. Above that every power of two range is split into @c SUB
+    buckets of equal width, so a value is known to within 1 / @c SUB of itself, the same scheme as an
+    HDR histogram with one significant octal digit. Values past @c MAX_BITS bits go in the last
+    bucket.
+
+    Recording is a bit scan and an increment with no allocation or locking. A histogram is meant to
+    be written by one thread, another thread may read it (e.g. with @c delta) at the cost of missing
+    the samples that are in flight.
+ */
+class LatencyHistogram
+{
+public:
+  static constexpr int SUB_BITS  = 3;
+  static constexpr int SUB       = 1 << SUB_BITS;
+  static constexpr int MAX_BITS  = 40; ///< Largest value tracked is 2^40, about 18 minutes in nanoseconds.
+  static constexpr int N_BUCKETS = (MAX_BITS - SUB_BITS + 2) * SUB;
+
+  /// Count one sample of @a v.
+  void
+  record(int64_t v)
+  {
+    ++_count[bucket_of(v)];
+  }
+
+  /// The bucket @a v is counted in.
+  static int
+  bucket_of(int64_t v)
+  {
+    if (v < SUB) {
+      return v < 0 ? 0 : static_cast<int>(v);
+    }
+    int shift = 63 - __builtin_clzll(static_cast<uint64_t>(v)) - SUB_BITS;
+    int idx   = (shift + 1) * SUB + static_cast<int>((v >> shift) & (SUB - 1));
+    return idx < N_BUCKETS ? idx : N_BUCKETS - 1;
+  }
+
+  /// The largest value counted in bucket @a idx.
+  static int64_t
+  upper_bound(int idx)
+  {
+    if (idx < SUB) {
+      return idx;
+    }
+    int shift = idx / SUB - 1;
+    return ((static_cast<int64_t>(SUB + idx % SUB) + 1) << shift) - 1;
+  }
+
+  /// The number of samples.
+  uint64_t
+  count() const
+  {
+    uint64_t n = 0;
+    for (uint64_t c : _count) {
+      n += c;
+    }
+    return n;
+  }
+
+  /** The value at or below which a fraction @a p of the samples fall.
+
+      This is the upper bound of the bucket the sample is in, zero if there are no samples.
+   */
+  int64_t
+  percentile(double p) const
+  {
+    uint64_t total = count();
+    if (total == 0) {
+      return 0;
+    }
+    uint64_t rank = static_cast<uint64_t>(p * total + 0.5);
+    rank          = rank < 1 ? 1 : (rank > total ? total : rank);
+    uint64_t seen = 0;
+    for (int i = 0; i < N_BUCKETS; ++i) {
+      seen += _count[i];
+      if (seen >= rank) {
+        return upper_bound(i);
+      }
+    }
+    return upper_bound(N_BUCKETS - 1);
+  }
+
+  /// The upper bound of the highest used bucket, zero if there are no samples.
+  int64_t
+  max() const
+  {
+    for (int i = N_BUCKETS - 1; i >= 0; --i) {
+      if (_count[i]) {
+        return upper_bound(i);
+      }
+    }
+    return 0;
+  }
+
+  /** Set @a this to the samples in @a current that are not in @a prev, then set @a prev to @a current.
+
+      This is how an interval is read from a histogram that is only ever added to.
+   */
+  void
+  delta(LatencyHistogram const &current, LatencyHistogram &prev)
+  {
+    for (int i = 0; i < N_BUCKETS; ++i) {
+      uint64_t c     = current._count[i];
+      _count[i]      = c - prev._count[i];
+      prev._count[i] = c;
+    }
+  }
+
+  LatencyHistogram &
+  operator+=(LatencyHistogram const &that)
+  {
+    for (int i = 0; i < N_BUCKETS; ++i) {
+      _count[i] += that._count[i];
+    }
+    return *this;
+  }
+
+  void
+  clear()
+  {
+    memset(_count, 0, sizeof(_count));
+  }
+
+private:
+  uint64_t _count[N_BUCKETS] = {0};
+};
@@ -686,10 +686,11 @@ List<C, A>::reverse()
 //
 
 template <class C, class L = typename C::Link_link> struct AtomicSLL {
-  void
+  /// @return The previous head.
+  C *
   push(C *c)
   {
-    ink_atomiclist_push(&al, c);
+    return (C *)ink_atomiclist_push(&al, c);
   }
   C *
   pop()
@@ -0,0 +1,125 @@
+/** @file
+
+  Match a set of literal strings in one pass over a subject.
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ */
+
+#pragma once
+
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "tscore/ink_assert.h"
+
+/** A set of literal strings, matched in one pass over a subject (Aho-Corasick).
+
+    The literals are added, then the set is compiled, after which it is read only and can be
+    matched concurrently. Matching is linear in the length of the subject plus the number of
+    matches, however many literals there are.
+ */
+class LiteralMatcher
+{
+public:
+  /** Add @a literal to the set, before it is compiled.
+
+      @return The id of @a literal, the same id for a literal that was already added. Ids count up
+      from 0.
+   */
+  int add(std::string_view literal);
+
+  /// Build the links for matching, after which no more literals can be added.
+  void compile();
+
+  /// Remove all the literals.
+  void clear();
+
+  /// @return The number of different literals.
+  int
+  count() const
+  {
+    return _count;
+  }
+
+  bool
+  empty() const
+  {
+    return _count == 0;
+  }
+
+  /** Call @a f with the id of every literal in @a text.
+
+      A literal is passed once for each place it ends in @a text, so more than once if it is there
+      more than once.
+   */
+  template <typename F> void match(std::string_view text, F &&f) const;
+
+private:
+  struct Node {
+    std::vector<std::pair<char, int>> edges; ///< Transitions, sorted by character.
+    int fail   = 0;                          ///< The node of the longest proper suffix in the trie.
+    int output = -1;                         ///< The literal ending here, if any.
+    int dict   = -1;                         ///< The nearest node on the fail chain with an output.
+  };
+
+  /// @return The child of @a node for @a c, or -1.
+  int child(int node, char c) const;
+
+  std::vector<Node> _nodes{1};
+  int _count     = 0;
+  bool _compiled = false;
+};
+
+inline int
+LiteralMatcher::child(int node, char c) const
+{
+  auto const &edges = _nodes[node].edges;
+  // Few nodes branch much, a scan is as quick as a search.
+  for (auto const &[ch, next] : edges) {
+    if (ch == c) {
+      return next;
+    } else if (ch > c) {
+      break;
+    }
+  }
+  return -1;
+}
+
+template <typename F>
+void
+LiteralMatcher::match(std::string_view text, F &&f) const
+{
+  ink_assert(_compiled || _count == 0);
+  if (_count == 0) {
+    return;
+  }
+
+  int state = 0;
+  for (char c : text) {
+    int next;
+    while ((next = child(state, c)) < 0 && state != 0) {
+      state = _nodes[state].fail;
+    }
+    state = next < 0 ? 0 : next;
+    for (int n = _nodes[state].output >= 0 ? state : _nodes[state].dict; n >= 0; n = _nodes[n].dict) {
+      f(_nodes[n].output);
+    }
+  }
+}
@@ -0,0 +1,56 @@
+/** @file
+
+  MurmurHash3 128 bit hash, as a hash context.
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ */
+
+#pragma once
+
+#include <cstdint>
+
+#include "tscore/CryptoHash.h"
+
+/** The x64 128 bit variant of MurmurHash3, with a seed of 0.
+
+    It is not a cryptographic hash, it is several times faster than MD5 for the short strings of URLs
+    and is as well distributed. The hash can be computed over several updates, it is the same as over
+    the concatenation of their data. Like MMH it gives different values on big-endian machines.
+
+    The hash is 128 bits, the rest of a larger @c CryptoHash is zero.
+ */
+class Murmur3Context : public ats::CryptoContextBase
+{
+public:
+  /// Update the hash with @a data of @a length bytes.
+  bool update(void const *data, int length) override;
+  /// Finalize and extract the @a hash.
+  bool finalize(CryptoHash &hash) override;
+
+private:
+  static constexpr int BLOCK_BYTES = 16;
+
+  void block(const uint8_t *data);
+
+  uint64_t _h1     = 0;
+  uint64_t _h2     = 0;
+  uint64_t _length = 0;         ///< Bytes hashed so far.
+  int _buffer_size = 0;         ///< Bytes in @a _buffer.
+  uint8_t _buffer[BLOCK_BYTES]; ///< The bytes of the incomplete block.
+};
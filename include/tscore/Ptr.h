@@ -73,6 +73,13 @@ public:
     return ink_atomic_increment((int *)&m_refcount, -1) - 1;
   }
 
+  // Add @a n to the reference count, returning the new count.
+  int
+  refcount_add(int n)
+  {
+    return ink_atomic_increment((int *)&m_refcount, n) + n;
+  }
+
   int
   refcount() const
   {
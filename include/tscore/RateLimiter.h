@@ -0,0 +1,83 @@
+/** @file
+
+  Token bucket rate limits for many keys at once.
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace ts
+{
+/** A token bucket for each key, such as a client address.
+
+    Each key can be admitted @a burst times at once and then @a rate times per second. The buckets
+    are spread over @c PARTITIONS partitions by the hash of their key, each with its own lock, so
+    that threads only contend for keys of the same partition and every thread sees the same limit.
+
+    The buckets of the keys that were not seen for long enough to be full again are the same as no
+    bucket, they are dropped when a partition reaches its share of @a max_keys. A key that does not
+    fit after that is admitted, a flood of new keys makes the limiter miss some keys rather than
+    use more memory.
+
+    The times are passed in by the caller, in nanoseconds.
+ */
+class RateLimiter
+{
+public:
+  static constexpr int PARTITIONS = 64;
+
+  RateLimiter(double rate, double burst, size_t max_keys = 1 << 20);
+
+  /// Take a token from the bucket of @a key at @a now, return @c false if there is none.
+  bool admit(std::string_view key, int64_t now);
+
+  /// The number of buckets.
+  size_t count();
+
+private:
+  struct Bucket {
+    double tokens;
+    int64_t updated; ///< When @a tokens was computed.
+  };
+
+  struct Partition {
+    std::mutex mutex;
+    std::unordered_map<std::string, Bucket> buckets;
+  };
+
+  /// The tokens of @a bucket at @a now.
+  double refill(Bucket const &bucket, int64_t now) const;
+
+  /// Remove the buckets of @a p that are full at @a now.
+  void sweep(Partition &p, int64_t now);
+
+  double _rate;          ///< Tokens per nanosecond.
+  double _burst;         ///< Tokens of a full bucket.
+  size_t _partition_max; ///< Most buckets of a partition.
+  Partition _partitions[PARTITIONS];
+};
+
+} // namespace ts
@@ -93,6 +93,27 @@ public:
   /// @return The number of groups captured in the last call to @c exec.
   int get_capture_count();
 
+  /** Find a string every match of a pattern contains.
+   *
+   * @param pattern Source pattern for a regular expression, compiled without flags.
+   * @return The longest string of literal characters outside of groups that is in every match of
+   * @a pattern, or an empty string if there is none or @a pattern is not understood.
+   *
+   * This is meant for a quick check if a subject can match before the regular expression is run.
+   */
+  static std::string required_literal(std::string_view pattern);
+
+  /** Get the compiled @a pattern shared by every user of the same pattern and flags.
+   *
+   * @param pattern Source pattern for regular expression.
+   * @param flags Compilation flags.
+   * @return The compiled regular expression, or @c nullptr if @a pattern doesn't compile.
+   *
+   * A pattern is compiled once however many rules or plugins use it, and is freed with its
+   * last user.
+   */
+  static std::shared_ptr<Regex> intern(std::string_view pattern, unsigned flags = 0);
+
 private:
   pcre *regex             = nullptr;
   pcre_extra *regex_extra = nullptr;
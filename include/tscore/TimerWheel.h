@@ -0,0 +1,267 @@
+/** @file
+
+  Hierarchical timing wheel for intrusive timer lists.
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ */
+
+#pragma once
+
+#include <cstdint>
+
+#include "tscore/ink_assert.h"
+#include "tscore/ink_hrtime.h"
+#include "tscore/List.h"
+
+/** A hierarchical timing wheel.
+
+    Time is counted in ticks of a fixed length. There are @c LEVELS wheels of @c SLOTS slots, a
+    timer is kept on the lowest level whose span covers it, in the slot picked by the matching digit
+    of its tick. When the current tick reaches the start of a slot on a higher level the timers in it
+    are moved down, so every timer is moved at most @c LEVELS times. Timers more than the span of the
+    top level out wait on an overflow list.
+
+    The timer of an entry is the @a AT member, it must not change while the entry is in the wheel.
+    Because the slot of an entry can always be computed from its timer and the current tick, entries
+    need nothing but the link @a L and both insert and remove are O(1).
+
+    Timers round down to a tick, an entry comes due once the tick it is in is reached.
+ */
+template <class C, ink_hrtime C::*AT, class L = typename C::Link_link> class TimerWheel
+{
+public:
+  static constexpr int BITS   = 8;
+  static constexpr int SLOTS  = 1 << BITS;
+  static constexpr int LEVELS = 4;
+
+  TimerWheel(ink_hrtime tick, ink_hrtime now) : _tick(tick), _now_tick(now / tick) {}
+
+  /// Add @a e, it is due at once if its timer has passed.
+  void insert(C *e);
+  /// Remove @a e, which must be in the wheel.
+  void remove(C *e);
+  /// Move the current time up to @a now, making any entries that come due ready.
+  void advance(ink_hrtime now);
+  /// Take the next entry that is due, @c nullptr if there are none.
+  C *pop_ready();
+  /// The earliest time at which @c advance can have any work to do.
+  ink_hrtime earliest() const;
+
+  bool
+  empty() const
+  {
+    return _size == 0;
+  }
+
+  size_t
+  size() const
+  {
+    return _size;
+  }
+
+private:
+  using List = Queue<C, L>;
+
+  static constexpr uint64_t MASK = SLOTS - 1;
+
+  ink_hrtime _tick;
+  uint64_t _now_tick;
+  size_t _size    = 0;
+  size_t _waiting = 0; ///< Entries not yet ready.
+
+  List _slot[LEVELS][SLOTS];
+  uint64_t _used[LEVELS][SLOTS / 64] = {{0}}; ///< Bit per non-empty slot.
+  List _ready;
+  List _overflow;
+
+  uint64_t
+  tick_of(C *e) const
+  {
+    return static_cast<uint64_t>(e->*AT) / _tick;
+  }
+
+  /// The list @a e belongs on given the current tick.
+  List &list_for(uint64_t tick, int *level, int *slot);
+  bool level_empty(int level) const;
+  /// First used slot of @a level after the current tick's digit.
+  int next_slot(int level) const;
+  /// The next tick at which a slot of the lowest used level has to be moved down.
+  uint64_t next_tick() const;
+};
+
+template <class C, ink_hrtime C::*AT, class L>
+typename TimerWheel<C, AT, L>::List &
+TimerWheel<C, AT, L>::list_for(uint64_t tick, int *level, int *slot)
+{
+  *level = -1;
+  if (tick <= _now_tick) {
+    return _ready;
+  }
+  // The highest digit that differs from now picks the level.
+  int l = (63 - __builtin_clzll(tick ^ _now_tick)) / BITS;
+  if (l >= LEVELS) {
+    return _overflow;
+  }
+  *level = l;
+  *slot  = (tick >> (BITS * l)) & MASK;
+  return _slot[l][*slot];
+}
+
+template <class C, ink_hrtime C::*AT, class L>
+void
+TimerWheel<C, AT, L>::insert(C *e)
+{
+  int level, slot = 0;
+  List &list = list_for(tick_of(e), &level, &slot);
+  list.enqueue(e);
+  if (level >= 0) {
+    _used[level][slot / 64] |= uint64_t(1) << (slot % 64);
+  }
+  if (&list != &_ready) {
+    ++_waiting;
+  }
+  ++_size;
+}
+
+template <class C, ink_hrtime C::*AT, class L>
+void
+TimerWheel<C, AT, L>::remove(C *e)
+{
+  int level, slot = 0;
+  List &list = list_for(tick_of(e), &level, &slot);
+  ink_assert(list.in(e));
+  list.remove(e);
+  if (level >= 0 && list.empty()) {
+    _used[level][slot / 64] &= ~(uint64_t(1) << (slot % 64));
+  }
+  if (&list != &_ready) {
+    --_waiting;
+  }
+  --_size;
+}
+
+template <class C, ink_hrtime C::*AT, class L>
+C *
+TimerWheel<C, AT, L>::pop_ready()
+{
+  C *e = _ready.dequeue();
+  if (e) {
+    --_size;
+  }
+  return e;
+}
+
+template <class C, ink_hrtime C::*AT, class L>
+bool
+TimerWheel<C, AT, L>::level_empty(int level) const
+{
+  for (uint64_t bits : _used[level]) {
+    if (bits) {
+      return false;
+    }
+  }
+  return true;
+}
+
+template <class C, ink_hrtime C::*AT, class L>
+int
+TimerWheel<C, AT, L>::next_slot(int level) const
+{
+  int slot = ((_now_tick >> (BITS * level)) & MASK) + 1;
+  while (slot < SLOTS) {
+    uint64_t bits = _used[level][slot / 64] >> (slot % 64);
+    if (bits) {
+      return slot + __builtin_ctzll(bits);
+    }
+    slot = (slot | 63) + 1;
+  }
+  // Every entry on a level is after the current digit, so a used level always has one.
+  ink_release_assert(!"timer wheel level without a slot ahead");
+  return SLOTS;
+}
+
+template <class C, ink_hrtime C::*AT, class L>
+uint64_t
+TimerWheel<C, AT, L>::next_tick() const
+{
+  for (int l = 0; l < LEVELS; ++l) {
+    if (!level_empty(l)) {
+      int shift = BITS * (l + 1);
+      return ((_now_tick >> shift) << shift) | (static_cast<uint64_t>(next_slot(l)) << (BITS * l));
+    }
+  }
+  // Only the overflow list is left, it is sorted out when the top level wraps.
+  int shift = BITS * LEVELS;
+  return ((_now_tick >> shift) + 1) << shift;
+}
+
+template <class C, ink_hrtime C::*AT, class L>
+void
+TimerWheel<C, AT, L>::advance(ink_hrtime now)
+{
+  uint64_t target = static_cast<uint64_t>(now) / _tick;
+
+  while (_now_tick < target) {
+    if (_waiting == 0) {
+      _now_tick = target;
+      break;
+    }
+    uint64_t next = next_tick();
+    if (next > target) {
+      _now_tick = target;
+      break;
+    }
+    _now_tick = next;
+
+    // Re-file the slot (or the overflow list) that starts at this tick, the entries go to lower
+    // levels or straight to ready.
+    List moved;
+    int level = 0;
+    while (level < LEVELS && level_empty(level)) {
+      ++level;
+    }
+    if (level < LEVELS) {
+      int slot = (next >> (BITS * level)) & MASK;
+      moved    = _slot[level][slot];
+      _slot[level][slot].clear();
+      _used[level][slot / 64] &= ~(uint64_t(1) << (slot % 64));
+    } else {
+      moved = _overflow;
+      _overflow.clear();
+    }
+    while (C *e = moved.dequeue()) {
+      --_waiting;
+      --_size;
+      insert(e);
+    }
+  }
+}
+
+template <class C, ink_hrtime C::*AT, class L>
+ink_hrtime
+TimerWheel<C, AT, L>::earliest() const
+{
+  if (_ready.head) {
+    return _now_tick * _tick;
+  }
+  if (_waiting == 0) {
+    return INT64_MAX;
+  }
+  return next_tick() * _tick;
+}
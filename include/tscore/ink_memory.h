@@ -158,6 +158,49 @@ ats_stringdup(std::string_view const &p)
   return p.empty() ? nullptr : _xstrdup(p.data(), p.size(), nullptr);
 }
 
+/** The subsystems the memory allocated with ats_malloc() and the like is accounted to.
+
+    Each thread accounts its allocations to its current tag, in counters of its own, so that the
+    accounting costs no more than an increment. With jemalloc 5, the memory of each tag other than
+    ATS_MEM_TAG_OTHER also comes from an arena of the tag, which gives the bytes it has in use.
+ */
+enum AtsMemTag {
+  ATS_MEM_TAG_OTHER,
+  ATS_MEM_TAG_CACHE,
+  ATS_MEM_TAG_HOSTDB,
+  ATS_MEM_TAG_SSL,
+  ATS_MEM_TAG_HDRS,
+  ATS_MEM_TAG_LOGGING,
+  ATS_MEM_TAG_PLUGIN,
+  ATS_MEM_TAG_COUNT
+};
+
+/// The tag the allocations of this thread are accounted to.
+extern thread_local AtsMemTag ats_mem_tag;
+
+/// Account the allocations of this thread to a tag until the end of the scope.
+class AtsMemTagScope
+{
+public:
+  explicit AtsMemTagScope(AtsMemTag tag) : _prev(ats_mem_tag) { ats_mem_tag = tag; }
+  ~AtsMemTagScope() { ats_mem_tag = _prev; }
+
+  AtsMemTagScope(const AtsMemTagScope &) = delete;
+  AtsMemTagScope &operator=(const AtsMemTagScope &) = delete;
+
+private:
+  AtsMemTag _prev;
+};
+
+/// The name of @a tag in the statistics.
+const char *ats_mem_tag_name(AtsMemTag tag);
+
+/// The bytes allocated for @a tag by all of the threads so far.
+int64_t ats_mem_tag_allocated(AtsMemTag tag);
+
+/// The bytes in use in the arena of @a tag, or -1 if the tags don't have arenas of their own in this build.
+int64_t ats_mem_tag_in_use(AtsMemTag tag);
+
 template <typename PtrType, typename SizeType>
 static inline IOVec
 make_iovec(PtrType ptr, SizeType sz)
@@ -170,6 +170,9 @@ struct _InkFreeList {
   uint32_t type_size, chunk_size, used, allocated, alignment;
   uint32_t allocated_base, used_base;
   int advice;
+  uint32_t id;                     // index of the per-thread magazines of this freelist
+  struct _InkMagazineDepot *depot; // full magazines shared by threads, per NUMA node
+  uint64_t allocs;                 // items handed out while counting, see ink_freelists_count_allocs()
 };
 
 typedef struct ink_freelist_ops InkFreeListOps;
@@ -178,6 +181,15 @@ typedef struct _InkFreeList InkFreeList;
 const InkFreeListOps *ink_freelist_malloc_ops();
 const InkFreeListOps *ink_freelist_freelist_ops();
 void ink_freelist_init_ops(int nofl_class, int nofl_proxy);
+/*
+ * Put per-thread magazines of @a magazine_size items in front of every freelist, 0 disables them.
+ * Has no effect unless the freelist ops are in use.
+ */
+void ink_freelist_init_magazines(uint32_t magazine_size);
+/*
+ * Set the NUMA node whose magazine depots the calling thread uses.
+ */
+void ink_freelist_set_thread_node(int node);
 
 /*
  * alignment must be a power of 2
@@ -193,6 +205,16 @@ inkcoreapi void ink_freelist_free_bulk(InkFreeList *f, void *head, void *tail, s
 void ink_freelists_dump(FILE *f);
 void ink_freelists_dump_baselinerel(FILE *f);
 void ink_freelists_snap_baseline();
+/*
+ * Count the items every freelist hands out from now on, or stop counting. The counts start over
+ * from 0 when counting starts. Counting costs an atomic increment per item, it is meant for
+ * benchmarks.
+ */
+void ink_freelists_count_allocs(bool enable);
+/*
+ * Call @a cb with the name and the count of every freelist that handed out items since counting started.
+ */
+void ink_freelists_get_allocs(void (*cb)(const char *name, uint64_t allocs, void *data), void *data);
 
 struct InkAtomicList {
   InkAtomicList() {}
@@ -0,0 +1,359 @@
+/**
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ */
+
+/**
+ * @file Coroutine.h
+ * @brief C++20 coroutines over the event threads of Traffic Server.
+ *
+ * A plugin built with C++20 can write a sequence of asynchronous steps as one coroutine returning
+ * atscppapi::Task instead of a continuation with a handler that switches on the event of each step:
+ *
+ * @code
+ * atscppapi::Task
+ * refresh(TSCacheKey key)
+ * {
+ *   co_await atscppapi::AwaitThreadPool(TS_THREAD_POOL_TASK);
+ *   sockaddr_storage origin = co_await atscppapi::AwaitHostLookup("origin.example.com");
+ *   if (origin.ss_family == AF_UNSPEC) {
+ *     co_return;
+ *   }
+ *   TSVConn vc = co_await atscppapi::AwaitCacheRead(key);
+ *   ...
+ * }
+ * @endcode
+ *
+ * The state of all of the steps lives in the coroutine frame, which is allocated once when the
+ * coroutine is called. Each co_await creates a continuation for the one event it waits for, and the
+ * coroutine resumes on the thread that event is delivered on, holding the mutex of that continuation.
+ * Pass the mutex of the plugin state to the awaitables to resume under it, otherwise each step gets a
+ * mutex of its own. The core and the library are built as C++17, this header is only for plugins.
+ */
+
+#pragma once
+
+#if !defined(__cpp_impl_coroutine) || !__has_include(<coroutine>)
+#error "tscpp/api/Coroutine.h needs C++20 coroutines, build the plugin with -std=c++20"
+#endif
+
+#include <atomic>
+#include <coroutine>
+#include <cstring>
+#include <exception>
+#include <string>
+#include <string_view>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <ts/ts.h>
+
+namespace atscppapi
+{
+/**
+ * @brief The return type of a coroutine that starts when it is called and runs to its end on its own.
+ *
+ * The coroutine frame is freed when it returns. An exception escaping the coroutine terminates the process,
+ * as there is nobody to hand it to.
+ */
+class Task
+{
+public:
+  struct promise_type {
+    Task
+    get_return_object() noexcept
+    {
+      return {};
+    }
+
+    std::suspend_never
+    initial_suspend() noexcept
+    {
+      return {};
+    }
+
+    std::suspend_never
+    final_suspend() noexcept
+    {
+      return {};
+    }
+
+    void
+    return_void() noexcept
+    {
+    }
+
+    void
+    unhandled_exception() noexcept
+    {
+      TSError("[atscppapi] exception escaped a coroutine");
+      std::terminate();
+    }
+  };
+};
+
+/**
+ * @brief Base of the awaitables, suspends the coroutine until a one shot continuation gets its event.
+ *
+ * The event can be delivered before the call that asks for it returns, on the same thread or another, in
+ * which case the coroutine carries on without suspending.
+ */
+class EventAwaiter
+{
+public:
+  explicit EventAwaiter(TSMutex mutex) : _mutex(mutex) {}
+
+  // No copying, the continuation points at the awaiter.
+  EventAwaiter(const EventAwaiter &) = delete;
+  EventAwaiter &operator=(const EventAwaiter &) = delete;
+
+  virtual ~EventAwaiter() = default;
+
+  bool
+  await_ready() const noexcept
+  {
+    return false;
+  }
+
+  bool
+  await_suspend(std::coroutine_handle<> handle)
+  {
+    _handle     = handle;
+    TSCont cont = TSContCreate(_eventFunc, _mutex ? _mutex : TSMutexCreate());
+    TSContDataSet(cont, static_cast<void *>(this));
+    _start(cont);
+    // Once the state is set the event function may resume the coroutine, and the awaiter is gone.
+    return _state.exchange(SUSPENDED) != DONE;
+  }
+
+protected:
+  // Ask for the event to be delivered to @a cont.
+  virtual void _start(TSCont cont) = 0;
+
+  // Keep what the coroutine needs of the event, @a edata is only valid during this call.
+  virtual void _done(TSEvent event, void *edata) = 0;
+
+private:
+  enum State { STARTED, SUSPENDED, DONE };
+
+  static int
+  _eventFunc(TSCont cont, TSEvent event, void *edata)
+  {
+    EventAwaiter *self = static_cast<EventAwaiter *>(TSContDataGet(cont));
+    self->_done(event, edata);
+    TSContDestroy(cont);
+    // If the coroutine has not suspended yet, await_suspend() sees DONE and does not.
+    if (self->_state.exchange(DONE) == SUSPENDED) {
+      self->_handle.resume();
+    }
+    return 0;
+  }
+
+  TSMutex _mutex;
+  std::coroutine_handle<> _handle;
+  std::atomic<int> _state{STARTED};
+};
+
+/**
+ * @brief Resumes the coroutine on a thread of @a thread_pool after @a timeout milliseconds, at once if it is 0.
+ */
+class AwaitTimer : public EventAwaiter
+{
+public:
+  explicit AwaitTimer(TSHRTime timeout, TSThreadPool thread_pool = TS_THREAD_POOL_NET, TSMutex mutex = nullptr)
+    : EventAwaiter(mutex), _timeout(timeout), _thread_pool(thread_pool)
+  {
+  }
+
+  void
+  await_resume() const noexcept
+  {
+  }
+
+protected:
+  void
+  _start(TSCont cont) override
+  {
+    TSContScheduleOnPool(cont, _timeout, _thread_pool);
+  }
+
+  void
+  _done(TSEvent, void *) override
+  {
+  }
+
+private:
+  TSHRTime _timeout;
+  TSThreadPool _thread_pool;
+};
+
+/**
+ * @brief Moves the coroutine to a thread of @a thread_pool, e.g. TS_THREAD_POOL_TASK for blocking work.
+ */
+class AwaitThreadPool : public AwaitTimer
+{
+public:
+  explicit AwaitThreadPool(TSThreadPool thread_pool, TSMutex mutex = nullptr) : AwaitTimer(0, thread_pool, mutex) {}
+};
+
+/**
+ * @brief Looks up the address of @a hostname, co_await gives AF_UNSPEC in ss_family if it is not found.
+ */
+class AwaitHostLookup : public EventAwaiter
+{
+public:
+  explicit AwaitHostLookup(std::string_view hostname, TSMutex mutex = nullptr) : EventAwaiter(mutex), _hostname(hostname)
+  {
+    memset(&_addr, 0, sizeof(_addr));
+    _addr.ss_family = AF_UNSPEC;
+  }
+
+  sockaddr_storage
+  await_resume() const noexcept
+  {
+    return _addr;
+  }
+
+protected:
+  void
+  _start(TSCont cont) override
+  {
+    TSHostLookup(cont, _hostname.data(), _hostname.size());
+  }
+
+  void
+  _done(TSEvent event, void *edata) override
+  {
+    const sockaddr *addr = nullptr;
+    if (event == TS_EVENT_HOST_LOOKUP && edata != nullptr) {
+      addr = TSHostLookupResultAddrGet(static_cast<TSHostLookupResult>(edata));
+    }
+    if (addr != nullptr && addr->sa_family == AF_INET) {
+      memcpy(&_addr, addr, sizeof(sockaddr_in));
+    } else if (addr != nullptr && addr->sa_family == AF_INET6) {
+      memcpy(&_addr, addr, sizeof(sockaddr_in6));
+    }
+  }
+
+private:
+  std::string _hostname;
+  sockaddr_storage _addr;
+};
+
+/**
+ * @brief Opens a connection to @a addr, co_await gives the connected TSVConn or nullptr if it failed.
+ */
+class AwaitNetConnect : public EventAwaiter
+{
+public:
+  explicit AwaitNetConnect(const sockaddr *addr, TSMutex mutex = nullptr) : EventAwaiter(mutex)
+  {
+    memset(&_addr, 0, sizeof(_addr));
+    memcpy(&_addr, addr, addr->sa_family == AF_INET6 ? sizeof(sockaddr_in6) : sizeof(sockaddr_in));
+  }
+
+  TSVConn
+  await_resume() const noexcept
+  {
+    return _vc;
+  }
+
+protected:
+  void
+  _start(TSCont cont) override
+  {
+    TSNetConnect(cont, reinterpret_cast<const sockaddr *>(&_addr));
+  }
+
+  void
+  _done(TSEvent event, void *edata) override
+  {
+    _vc = event == TS_EVENT_NET_CONNECT ? static_cast<TSVConn>(edata) : nullptr;
+  }
+
+private:
+  sockaddr_storage _addr;
+  TSVConn _vc = nullptr;
+};
+
+/**
+ * @brief Opens the cache object of @a key for reading, co_await gives its TSVConn or nullptr on a miss.
+ *
+ * The key is not copied, it must outlive the co_await.
+ */
+class AwaitCacheRead : public EventAwaiter
+{
+public:
+  explicit AwaitCacheRead(TSCacheKey key, TSMutex mutex = nullptr) : EventAwaiter(mutex), _key(key) {}
+
+  TSVConn
+  await_resume() const noexcept
+  {
+    return _vc;
+  }
+
+protected:
+  void
+  _start(TSCont cont) override
+  {
+    TSCacheRead(cont, _key);
+  }
+
+  void
+  _done(TSEvent event, void *edata) override
+  {
+    _vc = event == TS_EVENT_CACHE_OPEN_READ ? static_cast<TSVConn>(edata) : nullptr;
+  }
+
+private:
+  TSCacheKey _key;
+  TSVConn _vc = nullptr;
+};
+
+/**
+ * @brief Opens the cache object of @a key for writing, co_await gives its TSVConn or nullptr if it failed.
+ *
+ * The key is not copied, it must outlive the co_await.
+ */
+class AwaitCacheWrite : public EventAwaiter
+{
+public:
+  explicit AwaitCacheWrite(TSCacheKey key, TSMutex mutex = nullptr) : EventAwaiter(mutex), _key(key) {}
+
+  TSVConn
+  await_resume() const noexcept
+  {
+    return _vc;
+  }
+
+protected:
+  void
+  _start(TSCont cont) override
+  {
+    TSCacheWrite(cont, _key);
+  }
+
+  void
+  _done(TSEvent event, void *edata) override
+  {
+    _vc = event == TS_EVENT_CACHE_OPEN_WRITE ? static_cast<TSVConn>(edata) : nullptr;
+  }
+
+private:
+  TSCacheKey _key;
+  TSVConn _vc = nullptr;
+};
+
+} // end namespace atscppapi
@@ -23,13 +23,14 @@
 #pragma once
 
 #include "tscpp/api/noncopyable.h"
+#include <memory>
 #include <string>
+#include <string_view>
+#include <ts/apidefs.h>
 
 namespace atscppapi
 {
 struct HeadersState;
-struct HeaderFieldIteratorState;
-struct HeaderFieldValueIteratorState;
 class Request;
 class ClientRequest;
 class Response;
@@ -106,13 +107,37 @@ public:
 
 class HeaderField;
 
+/**
+ * @private
+ */
+struct HeaderFieldValueIteratorState {
+  TSMBuffer hdr_buf_ = nullptr;
+  TSMLoc hdr_loc_    = nullptr;
+  TSMLoc field_loc_  = nullptr;
+  int index_         = 0;
+};
+
+/**
+ * @private
+ * The field handle is shared by the copies of an iterator and released with the last one. An end
+ * iterator has no field handle, so it costs no allocation.
+ */
+struct HeaderFieldIteratorState {
+  TSMBuffer hdr_buf_ = nullptr;
+  TSMLoc hdr_loc_    = nullptr;
+  TSMLoc field_loc_  = nullptr;
+  std::shared_ptr<void> field_handle_;
+
+  HeaderFieldIteratorState(TSMBuffer bufp, TSMLoc hdr_loc, TSMLoc field_loc);
+};
+
 /**
  * @brief A header field value iterator iterates through all header fields.
  */
 class header_field_value_iterator : public std::iterator<std::forward_iterator_tag, int>
 {
 private:
-  HeaderFieldValueIteratorState *state_;
+  HeaderFieldValueIteratorState state_;
 
 public:
   /**
@@ -139,6 +164,12 @@ public:
    */
   std::string operator*();
 
+  /**
+   * Get the value pointed to by this iterator without copying it.
+   * @return a view of the value, valid until the header is modified.
+   */
+  std::string_view view() const;
+
   /**
    * Advance the iterator to the next header field value
    * @return a reference to a the next iterator
@@ -172,7 +203,7 @@ public:
 class header_field_iterator : public std::iterator<std::forward_iterator_tag, int>
 {
 private:
-  HeaderFieldIteratorState *state_;
+  HeaderFieldIteratorState state_;
   header_field_iterator(void *hdr_buf, void *hdr_loc, void *field_loc);
 
 public:
@@ -268,6 +299,18 @@ public:
    */
   HeaderFieldName name() const;
 
+  /**
+   * Get the name of this HeaderField without copying it.
+   * @return a view of the name, valid until the header is modified.
+   */
+  std::string_view nameView() const;
+
+  /**
+   * Get the index^th value of this HeaderField without copying it.
+   * @return a view of the value, valid until the header is modified, empty if there is no such value.
+   */
+  std::string_view valueView(int index) const;
+
   /**
    * Join all the values of this HeaderField into a single string separated by the join string.
    * @param an optional join string (defaults to ",")
@@ -29,7 +29,7 @@
 
 #include "P_AIO.h"
 
-#if AIO_MODE == AIO_MODE_NATIVE
+#if AIO_MODE_PER_THREAD
 #define AIO_PERIOD -HRTIME_MSECONDS(10)
 #else
 
@@ -48,10 +48,41 @@ int num_filedes = 1;
 static ink_mutex insert_mutex;
 
 int thread_is_created = 0;
-#endif // AIO_MODE == AIO_MODE_NATIVE
+#endif // AIO_MODE_PER_THREAD
+
+#if AIO_MODE == AIO_MODE_IO_URING
+RecInt aio_io_uring_entries = MAX_AIO_EVENTS;
+
+// Fixed file table shared by all the per thread rings. Slots are only ever appended, under
+// aio_fixed_files_mutex, and each ring picks up the new slots on its own thread.
+static int aio_fixed_files[AIO_MAX_FIXED_FILES];
+static int aio_n_fixed_files = 0;
+static std::atomic<int> aio_fixed_files_version{0};
+static ink_mutex aio_fixed_files_mutex = PTHREAD_MUTEX_INITIALIZER;
+#endif
 RecInt cache_config_threads_per_disk = 12;
 RecInt api_config_threads_per_disk   = 12;
 
+#if AIO_MODE == AIO_MODE_THREAD
+// Disk request scheduling between the AIOClass queues of each file descriptor.
+#define AIO_SCHED_STRIDE (1 << 20)
+
+static const char *aio_class_names[AIO_CLASS_COUNT] = {"read", "write", "evacuation", "sync"};
+static RecInt aio_sched_enabled                     = 0;
+static int aio_sched_weight[AIO_CLASS_COUNT]        = {8, 2, 1, 1};
+static ink_hrtime aio_sched_deadline[AIO_CLASS_COUNT];
+
+// Adaptive number of requests run at once on each disk.
+#define AIO_ADAPT_WINDOW 16 // fewest requests completed before the depth limit changes
+static RecInt aio_adaptive_depth   = 0;
+static RecInt aio_adaptive_latency = 200; // percent of the base service time above which the depth shrinks
+
+#if TS_USE_HWLOC
+// Run the threads of a disk on the NUMA node it is attached to.
+static RecInt aio_numa = 0;
+#endif
+#endif
+
 RecRawStatBlock *aio_rsb      = nullptr;
 Continuation *aio_err_callbck = nullptr;
 // AIO Stats
@@ -158,14 +189,52 @@ ink_aio_init(ts::ModuleVersion v)
                      (int)AIO_STAT_KB_READ_PER_SEC, aio_stats_cb);
   RecRegisterRawStat(aio_rsb, RECT_PROCESS, "proxy.process.cache.KB_write_per_sec", RECD_FLOAT, RECP_PERSISTENT,
                      (int)AIO_STAT_KB_WRITE_PER_SEC, aio_stats_cb);
-#if AIO_MODE != AIO_MODE_NATIVE
+#if !AIO_MODE_PER_THREAD
   memset(&aio_reqs, 0, MAX_DISKS_POSSIBLE * sizeof(AIO_Reqs *));
   ink_mutex_init(&insert_mutex);
 #endif
   REC_ReadConfigInteger(cache_config_threads_per_disk, "proxy.config.cache.threads_per_disk");
+#if AIO_MODE == AIO_MODE_THREAD
+  REC_ReadConfigInteger(aio_sched_enabled, "proxy.config.cache.io_sched.enabled");
+  REC_ReadConfigInteger(aio_adaptive_depth, "proxy.config.cache.io_sched.adaptive_depth");
+  REC_ReadConfigInteger(aio_adaptive_latency, "proxy.config.cache.io_sched.depth_latency_percent");
+  aio_adaptive_latency = std::max(aio_adaptive_latency, static_cast<RecInt>(101));
+#if TS_USE_HWLOC
+  REC_ReadConfigInteger(aio_numa, "proxy.config.exec_thread.numa");
+#endif
+  for (int i = 0; i < AIO_CLASS_COUNT; i++) {
+    char name[128];
+    RecInt val;
+
+    snprintf(name, sizeof(name), "proxy.config.cache.io_sched.weight.%s", aio_class_names[i]);
+    REC_ReadConfigInteger(val, name);
+    aio_sched_weight[i] = std::max(1, std::min(static_cast<int>(val), AIO_SCHED_STRIDE));
+    snprintf(name, sizeof(name), "proxy.config.cache.io_sched.deadline.%s", aio_class_names[i]);
+    REC_ReadConfigInteger(val, name);
+    aio_sched_deadline[i] = val > 0 ? HRTIME_MSECONDS(val) : 0;
+
+    snprintf(name, sizeof(name), "proxy.process.cache.io_sched.%s.queue_depth", aio_class_names[i]);
+    RecRegisterRawStat(aio_rsb, RECT_PROCESS, name, RECD_INT, RECP_NON_PERSISTENT, (int)AIO_STAT_CLASS_QUEUED + i,
+                       RecRawStatSyncSum);
+    snprintf(name, sizeof(name), "proxy.process.cache.io_sched.%s.queue_time", aio_class_names[i]);
+    RecRegisterRawStat(aio_rsb, RECT_PROCESS, name, RECD_INT, RECP_PERSISTENT, (int)AIO_STAT_CLASS_QUEUE_TIME + i,
+                       RecRawStatSyncSum);
+    snprintf(name, sizeof(name), "proxy.process.cache.io_sched.%s.requests", aio_class_names[i]);
+    RecRegisterRawStat(aio_rsb, RECT_PROCESS, name, RECD_INT, RECP_PERSISTENT, (int)AIO_STAT_CLASS_DISPATCHED + i,
+                       RecRawStatSyncSum);
+  }
+#endif
 #if TS_USE_LINUX_NATIVE_AIO
   Warning("Running with Linux AIO, there are known issues with this feature");
 #endif
+#if TS_USE_LINUX_IO_URING
+  REC_ReadConfigInteger(aio_io_uring_entries, "proxy.config.aio.io_uring.entries");
+  if (aio_io_uring_entries <= 0 || aio_io_uring_entries > MAX_AIO_EVENTS) {
+    Warning("proxy.config.aio.io_uring.entries must be between 1 and %d, using %d", MAX_AIO_EVENTS, MAX_AIO_EVENTS);
+    aio_io_uring_entries = MAX_AIO_EVENTS;
+  }
+  Warning("Running with Linux io_uring AIO, this feature is experimental");
+#endif
 }
 
 int
@@ -178,13 +247,19 @@ ink_aio_start()
   return 0;
 }
 
-#if AIO_MODE != AIO_MODE_NATIVE
+#if AIO_MODE == AIO_MODE_THREAD
+
+void
+ink_aio_register_file(int /* fd ATS_UNUSED */)
+{
+}
 
 static void *aio_thread_main(void *arg);
 
 struct AIOThreadInfo : public Continuation {
   AIO_Reqs *req;
   int sleep_wait;
+  int numa_node = -1;
 
   int
   start(int event, Event *e)
@@ -192,8 +267,19 @@ struct AIOThreadInfo : public Continuation {
     (void)event;
     (void)e;
 #if TS_USE_HWLOC
-    hwloc_set_membind_nodeset(ink_get_topology(), hwloc_topology_get_topology_nodeset(ink_get_topology()), HWLOC_MEMBIND_INTERLEAVE,
-                              HWLOC_MEMBIND_THREAD);
+    if (numa_node >= 0) {
+      hwloc_nodeset_t nodeset = hwloc_bitmap_alloc();
+      hwloc_cpuset_t cpuset   = hwloc_bitmap_alloc();
+      hwloc_bitmap_only(nodeset, numa_node);
+      hwloc_cpuset_from_nodeset(ink_get_topology(), cpuset, nodeset);
+      hwloc_set_cpubind(ink_get_topology(), cpuset, HWLOC_CPUBIND_THREAD);
+      hwloc_set_membind_nodeset(ink_get_topology(), nodeset, HWLOC_MEMBIND_BIND, HWLOC_MEMBIND_THREAD);
+      hwloc_bitmap_free(cpuset);
+      hwloc_bitmap_free(nodeset);
+    } else {
+      hwloc_set_membind_nodeset(ink_get_topology(), hwloc_topology_get_topology_nodeset(ink_get_topology()),
+                                HWLOC_MEMBIND_INTERLEAVE, HWLOC_MEMBIND_THREAD);
+    }
 #endif
     aio_thread_main(this);
     delete this;
@@ -213,6 +299,37 @@ struct AIOThreadInfo : public Continuation {
   put the request in the atomic list.
  */
 
+#if TS_USE_HWLOC && defined(linux)
+/* The NUMA node of the disk behind fildes as the kernel reports it, -1 if unknown. */
+static int
+aio_fildes_numa_node(int fildes)
+{
+  struct stat st;
+
+  if (fildes < 0 || fstat(fildes, &st) != 0) {
+    return -1;
+  }
+  dev_t dev = S_ISBLK(st.st_mode) ? st.st_rdev : st.st_dev;
+  // A partition has no device of its own, that of the whole disk is one up.
+  static const char *const paths[] = {"/sys/dev/block/%u:%u/device/numa_node", "/sys/dev/block/%u:%u/../device/numa_node"};
+  for (const char *fmt : paths) {
+    char path[PATH_NAME_MAX];
+    char buf[16];
+
+    snprintf(path, sizeof(path), fmt, major(dev), minor(dev));
+    ats_scoped_fd fd(open(path, O_RDONLY));
+    if (fd >= 0) {
+      ssize_t n = read(fd, buf, sizeof(buf) - 1);
+      if (n > 0) {
+        buf[n] = '\0';
+        return atoi(buf);
+      }
+    }
+  }
+  return -1;
+}
+#endif
+
 /* insert  an entry for file descriptor fildes into aio_reqs */
 static AIO_Reqs *
 aio_init_fildes(int fildes, int fromAPI = 0)
@@ -239,11 +356,41 @@ aio_init_fildes(int fildes, int fromAPI = 0)
     request->filedes      = fildes;
     aio_reqs[num_filedes] = request;
     thread_num            = cache_config_threads_per_disk;
+
+    // Without room for it in the thread data, the disk goes without the histogram.
+    char name[256];
+    snprintf(name, sizeof(name), "proxy.process.aio.disk.%d.latency_us", num_filedes - 1);
+    request->latency_rsb = RecAllocateRawStatBlock(REC_HISTOGRAM_BUCKETS);
+    if (request->latency_rsb) {
+      RecRegisterRawStatHistogram(request->latency_rsb, RECT_PROCESS, name, 0);
+    }
+
+    // Start with one request at a time and let the service time tell how deep the disk goes.
+    if (aio_adaptive_depth && thread_num > 1) {
+      request->depth_limit = 1;
+      request->depth_max   = thread_num;
+      request->depth_rsb   = RecAllocateRawStatBlock(AIO_DISK_STAT_COUNT);
+      snprintf(name, sizeof(name), "proxy.process.aio.disk.%d.queue_depth", num_filedes - 1);
+      RecRegisterRawStat(request->depth_rsb, RECT_PROCESS, name, RECD_INT, RECP_NON_PERSISTENT, AIO_DISK_STAT_QUEUE_DEPTH,
+                         RecRawStatSyncSum);
+      snprintf(name, sizeof(name), "proxy.process.aio.disk.%d.base_latency_us", num_filedes - 1);
+      RecRegisterRawStat(request->depth_rsb, RECT_PROCESS, name, RECD_INT, RECP_NON_PERSISTENT, AIO_DISK_STAT_BASE_LATENCY_US,
+                         RecRawStatSyncSum);
+      RecSetGlobalRawStatSum(request->depth_rsb, AIO_DISK_STAT_QUEUE_DEPTH, request->depth_limit);
+    }
   }
 
   /* create the main thread */
   AIOThreadInfo *thr_info;
   size_t stacksize;
+  int numa_node = -1;
+
+#if TS_USE_HWLOC && defined(linux)
+  if (aio_numa && !fromAPI && hwloc_get_nbobjs_by_type(ink_get_topology(), HWLOC_OBJ_NODE) > 1) {
+    numa_node = aio_fildes_numa_node(fildes);
+    Debug("aio", "fd %d is on NUMA node %d", fildes, numa_node);
+  }
+#endif
 
   REC_ReadConfigInteger(stacksize, "proxy.config.thread.default.stacksize");
   for (i = 0; i < thread_num; i++) {
@@ -252,6 +399,7 @@ aio_init_fildes(int fildes, int fromAPI = 0)
     } else {
       thr_info = new AIOThreadInfo(request, 0);
     }
+    thr_info->numa_node = numa_node;
     snprintf(thr_name, MAX_THREAD_NAME_LENGTH, "[ET_AIO %d:%d]", i, fildes);
     ink_assert(eventProcessor.spawn_thread(thr_info, thr_name, stacksize));
   }
@@ -272,7 +420,77 @@ aio_insert(AIOCallback *op, AIO_Reqs *req)
   num_requests++;
   req->queued++;
 #endif
-  req->aio_todo.enqueue(op);
+  int c = aio_sched_enabled ? static_cast<AIOCallbackInternal *>(op)->sched_class : AIO_CLASS_READ;
+  // A class coming back from idle does not get to make up for the time it had nothing queued.
+  if (req->aio_todo[c].empty() && req->sched_pass[c] < req->sched_vtime) {
+    req->sched_pass[c] = req->sched_vtime;
+  }
+  req->aio_todo[c].enqueue(op);
+}
+
+/* pick the next request to run, the mutex of @a req must be held */
+static AIOCallback *
+aio_next(AIO_Reqs *req)
+{
+  if (!aio_sched_enabled) {
+    return req->aio_todo[AIO_CLASS_READ].pop();
+  }
+
+  // A request past its deadline goes first, the one that is most overdue. Otherwise the classes
+  // share the disk in proportion to their weights.
+  ink_hrtime now  = Thread::get_hrtime_updated();
+  ink_hrtime late = 0;
+  int c           = -1;
+  for (int i = 0; i < AIO_CLASS_COUNT; i++) {
+    AIOCallbackInternal *head = static_cast<AIOCallbackInternal *>(req->aio_todo[i].head);
+    if (head && aio_sched_deadline[i] && now - head->queued_at - aio_sched_deadline[i] > late) {
+      late = now - head->queued_at - aio_sched_deadline[i];
+      c    = i;
+    }
+  }
+  if (c < 0) {
+    for (int i = 0; i < AIO_CLASS_COUNT; i++) {
+      if (req->aio_todo[i].head && (c < 0 || req->sched_pass[i] < req->sched_pass[c])) {
+        c = i;
+      }
+    }
+    if (c < 0) {
+      return nullptr;
+    }
+  }
+  req->sched_vtime = req->sched_pass[c];
+  req->sched_pass[c] += AIO_SCHED_STRIDE / aio_sched_weight[c];
+  return req->aio_todo[c].pop();
+}
+
+/* adapt the depth limit of @a req to the service time @a op_time of a request, the mutex of @a req must be held */
+static void
+aio_adapt(AIO_Reqs *req, ink_hrtime op_time)
+{
+  req->window_time += op_time;
+  if (++req->window_ops < std::max(req->depth_limit, AIO_ADAPT_WINDOW)) {
+    return;
+  }
+
+  ink_hrtime mean  = req->window_time / req->window_ops;
+  req->window_ops  = 0;
+  req->window_time = 0;
+  // The base follows a disk that got slower for good, or it would be held shallow for ever.
+  if (req->base_latency == 0 || mean < req->base_latency) {
+    req->base_latency = mean;
+  } else {
+    req->base_latency += (mean - req->base_latency) / 64;
+  }
+
+  if (mean * 100 > req->base_latency * aio_adaptive_latency) {
+    req->depth_limit = std::max(1, req->depth_limit - std::max(1, req->depth_limit / 4));
+  } else if (req->depth_limit < req->depth_max && req->requests_queued > req->active) {
+    // Only go deeper if requests waited for the limit.
+    ++req->depth_limit;
+    ink_cond_signal(&req->aio_cond);
+  }
+  RecSetGlobalRawStatSum(req->depth_rsb, AIO_DISK_STAT_QUEUE_DEPTH, req->depth_limit);
+  RecSetGlobalRawStatSum(req->depth_rsb, AIO_DISK_STAT_BASE_LATENCY_US, ink_hrtime_to_usec(req->base_latency));
 }
 
 /* move the request from the atomic list to the queue */
@@ -352,6 +570,14 @@ aio_queue_req(AIOCallbackInternal *op, int fromAPI = 0)
     ink_mutex_release(&insert_mutex);
     op->aio_req = req;
   }
+  if (op->io_class != AIO_CLASS_AUTO) {
+    op->sched_class = op->io_class;
+  } else {
+    op->sched_class = op->aiocb.aio_lio_opcode == LIO_WRITE ? AIO_CLASS_WRITE : AIO_CLASS_READ;
+  }
+  op->io_class  = AIO_CLASS_AUTO;
+  op->queued_at = Thread::get_hrtime_updated();
+  RecIncrGlobalRawStatSum(aio_rsb, AIO_STAT_CLASS_QUEUED + op->sched_class, 1);
   ink_atomic_increment(&req->requests_queued, 1);
   if (!ink_mutex_try_acquire(&req->aio_mutex)) {
 #ifdef AIO_STATS
@@ -446,9 +672,13 @@ aio_thread_main(void *arg)
       current_req = my_aio_req;
       /* check if any pending requests on the atomic list */
       aio_move(my_aio_req);
-      if (!(op = my_aio_req->aio_todo.pop())) {
+      if (my_aio_req->depth_limit && my_aio_req->active >= my_aio_req->depth_limit) {
+        break;
+      }
+      if (!(op = aio_next(my_aio_req))) {
         break;
       }
+      ++current_req->active;
 #ifdef AIO_STATS
       num_requests--;
       current_req->queued--;
@@ -463,7 +693,19 @@ aio_thread_main(void *arg)
         aio_bytes_read += op->aiocb.aio_nbytes;
       }
       ink_mutex_release(&current_req->aio_mutex);
+      {
+        AIOCallbackInternal *cbi = static_cast<AIOCallbackInternal *>(op);
+        RecIncrGlobalRawStatSum(aio_rsb, AIO_STAT_CLASS_QUEUED + cbi->sched_class, -1);
+        RecIncrGlobalRawStatSum(aio_rsb, AIO_STAT_CLASS_QUEUE_TIME + cbi->sched_class,
+                                ink_hrtime_to_msec(Thread::get_hrtime_updated() - cbi->queued_at));
+        RecIncrGlobalRawStatSum(aio_rsb, AIO_STAT_CLASS_DISPATCHED + cbi->sched_class, 1);
+      }
+      ink_hrtime op_start = Thread::get_hrtime_updated();
       cache_op((AIOCallbackInternal *)op);
+      ink_hrtime op_time = Thread::get_hrtime_updated() - op_start;
+      if (current_req->latency_rsb) {
+        RecIncrRawStatHistogram(current_req->latency_rsb, this_ethread(), 0, ink_hrtime_to_usec(op_time));
+      }
       ink_atomic_increment((int *)&current_req->requests_queued, -1);
 #ifdef AIO_STATS
       ink_atomic_increment((int *)&current_req->pending, -1);
@@ -480,13 +722,22 @@ aio_thread_main(void *arg)
         op->thread->schedule_imm_signal(op);
       }
       ink_mutex_acquire(&my_aio_req->aio_mutex);
+      --current_req->active;
+      if (current_req->depth_limit) {
+        aio_adapt(current_req, op_time);
+      }
     } while (true);
     timespec timedwait_msec = ink_hrtime_to_timespec(Thread::get_hrtime_updated() + HRTIME_MSECONDS(net_config_poll_timeout));
     ink_cond_timedwait(&my_aio_req->aio_cond, &my_aio_req->aio_mutex, &timedwait_msec);
   }
   return nullptr;
 }
-#else
+#elif AIO_MODE == AIO_MODE_NATIVE
+void
+ink_aio_register_file(int /* fd ATS_UNUSED */)
+{
+}
+
 int
 DiskHandler::startAIOEvent(int /* event ATS_UNUSED */, Event *e)
 {
@@ -642,4 +893,233 @@ ink_aio_writev(AIOCallback *op, int /* fromAPI ATS_UNUSED */)
   }
   return 1;
 }
-#endif // AIO_MODE != AIO_MODE_NATIVE
+#else // AIO_MODE == AIO_MODE_IO_URING
+void
+ink_aio_register_file(int fd)
+{
+  ink_scoped_mutex_lock lock(aio_fixed_files_mutex);
+  for (int i = 0; i < aio_n_fixed_files; ++i) {
+    if (aio_fixed_files[i] == fd) {
+      return;
+    }
+  }
+  if (aio_n_fixed_files >= AIO_MAX_FIXED_FILES) {
+    Debug("aio", "fixed file table full, fd %d will not be registered", fd);
+    return;
+  }
+  aio_fixed_files[aio_n_fixed_files++] = fd;
+  aio_fixed_files_version++;
+}
+
+DiskHandler::DiskHandler()
+{
+  SET_HANDLER(&DiskHandler::startAIOEvent);
+  int ret = io_uring_queue_init(aio_io_uring_entries, &ring, 0);
+  if (ret < 0) {
+    Fatal("io_uring_queue_init(%" PRId64 ") failed: %s (%d)", aio_io_uring_entries, strerror(-ret), -ret);
+  }
+  // Register a sparse table up front so spans opened later only need an update, not a re-register.
+  std::fill(std::begin(fixed_files), std::end(fixed_files), -1);
+  ret = io_uring_register_files(&ring, fixed_files, AIO_MAX_FIXED_FILES);
+  if (ret < 0) {
+    Debug("aio", "io_uring_register_files failed, fixed files disabled: %s (%d)", strerror(-ret), -ret);
+  } else {
+    files_registered = true;
+  }
+}
+
+DiskHandler::~DiskHandler()
+{
+  io_uring_queue_exit(&ring);
+}
+
+int
+DiskHandler::fixed_file_index(int fd) const
+{
+  if (files_registered) {
+    for (int i = 0; i < AIO_MAX_FIXED_FILES && fixed_files[i] != -1; ++i) {
+      if (fixed_files[i] == fd) {
+        return i;
+      }
+    }
+  }
+  return -1;
+}
+
+void
+DiskHandler::update_files()
+{
+  if (!files_registered || files_version == aio_fixed_files_version.load(std::memory_order_acquire)) {
+    return;
+  }
+
+  int n;
+  {
+    ink_scoped_mutex_lock lock(aio_fixed_files_mutex);
+    n             = aio_n_fixed_files;
+    files_version = aio_fixed_files_version;
+    memcpy(fixed_files, aio_fixed_files, n * sizeof(int));
+  }
+  int ret = io_uring_register_files_update(&ring, 0, fixed_files, n);
+  if (ret < 0) {
+    Debug("aio", "io_uring_register_files_update failed, fixed files disabled: %s (%d)", strerror(-ret), -ret);
+    files_registered = false;
+  }
+}
+
+void
+DiskHandler::submit()
+{
+  AIOCallback *op;
+  int num = 0;
+
+  while (ready_list.head != nullptr) {
+    io_uring_sqe *sqe = io_uring_get_sqe(&ring);
+    if (sqe == nullptr) {
+      // The submission queue is full, the rest goes out on the next pass.
+      break;
+    }
+    op            = ready_list.dequeue();
+    ink_aiocb *a  = &op->aiocb;
+    int fd        = a->aio_fildes;
+    unsigned flag = 0;
+    int slot      = fixed_file_index(fd);
+    if (slot >= 0) {
+      fd   = slot;
+      flag = IOSQE_FIXED_FILE;
+    }
+    if (a->aio_lio_opcode == LIO_READ) {
+      io_uring_prep_read(sqe, fd, a->aio_buf, a->aio_nbytes, a->aio_offset);
+      aio_num_read++;
+      aio_bytes_read += a->aio_nbytes;
+    } else {
+      io_uring_prep_write(sqe, fd, a->aio_buf, a->aio_nbytes, a->aio_offset);
+      aio_num_write++;
+      aio_bytes_written += a->aio_nbytes;
+    }
+    io_uring_sqe_set_flags(sqe, flag);
+    io_uring_sqe_set_data(sqe, op);
+    ++num;
+  }
+
+  if (num > 0) {
+    int ret;
+    do {
+      ret = io_uring_submit(&ring);
+    } while (ret == -EINTR);
+    // On -EAGAIN / -EBUSY the entries stay in the submission queue and are retried on the next pass.
+    if (ret < 0 && ret != -EAGAIN && ret != -EBUSY) {
+      Warning("io_uring_submit failed: %s (%d)", strerror(-ret), -ret);
+    }
+  }
+}
+
+void
+DiskHandler::reap()
+{
+  io_uring_cqe *cqes[MAX_AIO_EVENTS];
+  unsigned n;
+
+  while ((n = io_uring_peek_batch_cqe(&ring, cqes, MAX_AIO_EVENTS)) > 0) {
+    for (unsigned i = 0; i < n; ++i) {
+      AIOCallback *op = static_cast<AIOCallback *>(io_uring_cqe_get_data(cqes[i]));
+      op->aio_result  = cqes[i]->res;
+      ink_assert(op->action.continuation);
+      complete_list.enqueue(op);
+    }
+    io_uring_cq_advance(&ring, n);
+  }
+}
+
+int
+DiskHandler::startAIOEvent(int /* event ATS_UNUSED */, Event *e)
+{
+  SET_HANDLER(&DiskHandler::mainAIOEvent);
+#ifdef HAVE_EVENTFD
+  // Completions poke the thread's event fd so the event loop wakes up to reap them.
+  int ret = io_uring_register_eventfd(&ring, e->ethread->evfd);
+  if (ret < 0) {
+    Debug("aio", "io_uring_register_eventfd failed: %s (%d)", strerror(-ret), -ret);
+  }
+#endif
+  e->schedule_every(AIO_PERIOD);
+  trigger_event = e;
+  return EVENT_CONT;
+}
+
+int
+DiskHandler::mainAIOEvent(int /* event ATS_UNUSED */, Event * /* e ATS_UNUSED */)
+{
+  AIOCallback *op = nullptr;
+
+  update_files();
+  reap();
+  submit();
+
+  while ((op = complete_list.dequeue()) != nullptr) {
+    op->mutex = op->action.mutex;
+    MUTEX_TRY_LOCK(lock, op->mutex, trigger_event->ethread);
+    if (!lock.is_locked()) {
+      trigger_event->ethread->schedule_imm(op);
+    } else {
+      op->handleEvent(EVENT_NONE, nullptr);
+    }
+  }
+  return EVENT_CONT;
+}
+
+static int
+aio_queue_chain(AIOCallback *op, int opcode)
+{
+  DiskHandler *dh = this_ethread()->diskHandler;
+  AIOCallback *io = op;
+  int sz          = 0;
+
+  while (io) {
+    io->aiocb.aio_lio_opcode = opcode;
+    dh->ready_list.enqueue(io);
+    ++sz;
+    io = io->then;
+  }
+
+  if (sz > 1) {
+    ink_assert(op->action.continuation);
+    AIOVec *vec = new AIOVec(sz, op);
+    while (--sz >= 0) {
+      op->action = vec;
+      op         = op->then;
+    }
+  }
+  return 1;
+}
+
+int
+ink_aio_read(AIOCallback *op, int /* fromAPI ATS_UNUSED */)
+{
+  op->aiocb.aio_lio_opcode = LIO_READ;
+  this_ethread()->diskHandler->ready_list.enqueue(op);
+
+  return 1;
+}
+
+int
+ink_aio_write(AIOCallback *op, int /* fromAPI ATS_UNUSED */)
+{
+  op->aiocb.aio_lio_opcode = LIO_WRITE;
+  this_ethread()->diskHandler->ready_list.enqueue(op);
+
+  return 1;
+}
+
+int
+ink_aio_readv(AIOCallback *op, int /* fromAPI ATS_UNUSED */)
+{
+  return aio_queue_chain(op, LIO_READ);
+}
+
+int
+ink_aio_writev(AIOCallback *op, int /* fromAPI ATS_UNUSED */)
+{
+  return aio_queue_chain(op, LIO_WRITE);
+}
+#endif // AIO_MODE == AIO_MODE_THREAD
@@ -40,9 +40,12 @@ static constexpr ts::ModuleVersion AIO_MODULE_PUBLIC_VERSION(1, 0, ts::ModuleVer
 
 #define AIO_MODE_THREAD 0
 #define AIO_MODE_NATIVE 1
+#define AIO_MODE_IO_URING 2
 
 #if TS_USE_LINUX_NATIVE_AIO
 #define AIO_MODE AIO_MODE_NATIVE
+#elif TS_USE_LINUX_IO_URING
+#define AIO_MODE AIO_MODE_IO_URING
 #else
 #define AIO_MODE AIO_MODE_THREAD
 #endif
@@ -77,20 +80,46 @@ struct ink_aiocb {
   int aio__pad[1];        /* extension padding */
 };
 
+#if AIO_MODE == AIO_MODE_IO_URING
+
+#include <liburing.h>
+
+#define MAX_AIO_EVENTS 1024
+#define AIO_MAX_FIXED_FILES 64
+
+#else
+
 bool ink_aio_thread_num_set(int thread_num);
 
 #endif
 
+#endif
+
+// The native and io_uring modes submit from, and complete on, a per thread DiskHandler.
+#define AIO_MODE_PER_THREAD (AIO_MODE == AIO_MODE_NATIVE || AIO_MODE == AIO_MODE_IO_URING)
+
 // AIOCallback::thread special values
 #define AIO_CALLBACK_THREAD_ANY ((EThread *)0) // any regular event thread
 #define AIO_CALLBACK_THREAD_AIO ((EThread *)-1)
 
+// Scheduling classes of disk requests, see proxy.config.cache.io_sched.enabled. Requests left at
+// AIO_CLASS_AUTO are classed as reads or writes.
+enum AIOClass {
+  AIO_CLASS_AUTO = -1,
+  AIO_CLASS_READ,     // client reads
+  AIO_CLASS_WRITE,    // aggregation writes
+  AIO_CLASS_EVACUATE, // evacuation and scan reads
+  AIO_CLASS_SYNC,     // directory sync writes
+  AIO_CLASS_COUNT
+};
+
 struct AIOCallback : public Continuation {
   // set before calling aio_read/aio_write
   ink_aiocb aiocb;
   Action action;
   EThread *thread   = AIO_CALLBACK_THREAD_ANY;
   AIOCallback *then = nullptr;
+  int io_class      = AIO_CLASS_AUTO; // reset to AIO_CLASS_AUTO once the request is queued
   // set on return from aio_read/aio_write
   int64_t aio_result = 0;
 
@@ -98,7 +127,7 @@ struct AIOCallback : public Continuation {
   AIOCallback() {}
 };
 
-#if AIO_MODE == AIO_MODE_NATIVE
+#if AIO_MODE_PER_THREAD
 
 struct AIOVec : public Continuation {
   Action action;
@@ -115,6 +144,10 @@ struct AIOVec : public Continuation {
   int mainEvent(int event, Event *e);
 };
 
+#endif
+
+#if AIO_MODE == AIO_MODE_NATIVE
+
 struct DiskHandler : public Continuation {
   Event *trigger_event;
   io_context_t ctx;
@@ -133,8 +166,38 @@ struct DiskHandler : public Continuation {
     }
   }
 };
+
+#elif AIO_MODE == AIO_MODE_IO_URING
+
+struct DiskHandler : public Continuation {
+  Event *trigger_event = nullptr;
+  io_uring ring;
+  bool files_registered = false;
+  int files_version     = 0; ///< Version of the global fixed file table last pushed to @a ring.
+  int fixed_files[AIO_MAX_FIXED_FILES];
+  Que(AIOCallback, link) ready_list;
+  Que(AIOCallback, link) complete_list;
+  int startAIOEvent(int event, Event *e);
+  int mainAIOEvent(int event, Event *e);
+  DiskHandler();
+  ~DiskHandler() override;
+
+private:
+  int fixed_file_index(int fd) const;
+  void update_files();
+  void submit();
+  void reap();
+};
+
 #endif
 
+/** Register @a fd as a fixed file with the per thread io_uring instances.
+
+    Requests on a registered descriptor skip the per-request file table lookup in the kernel. This
+    is a no-op for the other AIO modes.
+ */
+void ink_aio_register_file(int fd);
+
 void ink_aio_init(ts::ModuleVersion version);
 int ink_aio_start();
 void ink_aio_set_callback(Continuation *error_callback);
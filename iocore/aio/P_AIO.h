@@ -46,7 +46,7 @@ AIOCallback::ok()
 
 extern Continuation *aio_err_callbck;
 
-#if AIO_MODE == AIO_MODE_NATIVE
+#if AIO_MODE_PER_THREAD
 
 struct AIOCallbackInternal : public AIOCallback {
   int io_complete(int event, void *data);
@@ -74,13 +74,15 @@ AIOVec::mainEvent(int /* event */, Event *)
   return EVENT_ERROR;
 }
 
-#else /* AIO_MODE != AIO_MODE_NATIVE */
+#else /* !AIO_MODE_PER_THREAD */
 
 struct AIO_Reqs;
 
 struct AIOCallbackInternal : public AIOCallback {
   AIO_Reqs *aio_req     = nullptr;
   ink_hrtime sleep_time = 0;
+  int sched_class       = AIO_CLASS_READ;
+  ink_hrtime queued_at  = 0;
   SLINK(AIOCallbackInternal, alink); /* for AIO_Reqs::aio_temp_list */
 
   int io_complete(int event, void *data);
@@ -89,20 +91,32 @@ struct AIOCallbackInternal : public AIOCallback {
 };
 
 struct AIO_Reqs {
-  Que(AIOCallback, link) aio_todo; /* queue for AIO operations */
+  Que(AIOCallback, link) aio_todo[AIO_CLASS_COUNT]; /* queues for AIO operations, per class when scheduling */
+  uint64_t sched_pass[AIO_CLASS_COUNT] = {0};       /* stride scheduling position of each class */
+  uint64_t sched_vtime                 = 0;         /* pass of the last dispatched request */
                                    /* Atomic list to temporarily hold the request if the
                                       lock for a particular queue cannot be acquired */
   ASLL(AIOCallbackInternal, alink) aio_temp_list;
   ink_mutex aio_mutex;
   ink_cond aio_cond;
-  int index           = 0; /* position of this struct in the aio_reqs array */
-  int pending         = 0; /* number of outstanding requests on the disk */
-  int queued          = 0; /* total number of aio_todo requests */
-  int filedes         = 0; /* the file descriptor for the requests */
-  int requests_queued = 0;
+  int index                    = 0;       /* position of this struct in the aio_reqs array */
+  int pending                  = 0;       /* number of outstanding requests on the disk */
+  int queued                   = 0;       /* total number of aio_todo requests */
+  int filedes                  = 0;       /* the file descriptor for the requests */
+  int requests_queued          = 0;
+  RecRawStatBlock *latency_rsb = nullptr; /* the service time histogram of the disk */
+  /* With proxy.config.cache.io_sched.adaptive_depth, the number of requests run at once on the disk grows
+     by one while their service time stays close to the lowest seen and shrinks by a quarter when it does not. */
+  int active                 = 0; /* requests being run by the threads */
+  int depth_limit            = 0; /* requests that may be run at once, 0 for as many as there are threads */
+  int depth_max              = 0;
+  int window_ops             = 0; /* requests completed in the current window */
+  ink_hrtime window_time     = 0; /* their total service time */
+  ink_hrtime base_latency    = 0; /* the lowest mean service time of a window, drifting up */
+  RecRawStatBlock *depth_rsb = nullptr;
 };
 
-#endif // AIO_MODE == AIO_MODE_NATIVE
+#endif // AIO_MODE_PER_THREAD
 
 TS_INLINE int
 AIOCallbackInternal::io_complete(int event, void *data)
@@ -147,6 +161,15 @@ enum aio_stat_enum {
   AIO_STAT_KB_READ_PER_SEC,
   AIO_STAT_WRITE_PER_SEC,
   AIO_STAT_KB_WRITE_PER_SEC,
-  AIO_STAT_COUNT
+  AIO_STAT_CLASS_QUEUED,                                               // per class queue depth
+  AIO_STAT_CLASS_QUEUE_TIME = AIO_STAT_CLASS_QUEUED + AIO_CLASS_COUNT, // per class msec spent queued
+  AIO_STAT_CLASS_DISPATCHED = AIO_STAT_CLASS_QUEUE_TIME + AIO_CLASS_COUNT,
+  AIO_STAT_COUNT            = AIO_STAT_CLASS_DISPATCHED + AIO_CLASS_COUNT
+};
+
+enum aio_disk_stat_enum {
+  AIO_DISK_STAT_QUEUE_DEPTH,     // the adaptive depth limit of the disk
+  AIO_DISK_STAT_BASE_LATENCY_US, // the service time the limit is adapted against
+  AIO_DISK_STAT_COUNT
 };
 extern RecRawStatBlock *aio_rsb;
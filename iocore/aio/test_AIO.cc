@@ -421,10 +421,10 @@ main(int /* argc ATS_UNUSED */, char *argv[])
   Thread *main_thread = new EThread;
   main_thread->set_specific();
 
-#if AIO_MODE == AIO_MODE_NATIVE
+#if AIO_MODE_PER_THREAD
   int etype            = ET_NET;
-  int n_netthreads     = eventProcessor.n_threads_for_type[etype];
-  EThread **netthreads = eventProcessor.eventthread[etype];
+  int n_netthreads     = eventProcessor.thread_group[etype]._count;
+  EThread **netthreads = eventProcessor.thread_group[etype]._thread;
   for (int i = 0; i < n_netthreads; ++i) {
     netthreads[i]->diskHandler = new DiskHandler();
     netthreads[i]->schedule_imm(netthreads[i]->diskHandler);
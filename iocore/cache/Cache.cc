@@ -38,6 +38,7 @@
 #include "tscore/hugepages.h"
 
 #include <atomic>
+#include <cmath>
 
 constexpr ts::VersionNumber CACHE_DB_VERSION(CACHE_DB_MAJOR_VERSION, CACHE_DB_MINOR_VERSION);
 
@@ -63,8 +64,11 @@ int cache_config_ram_cache_algorithm           = 1;
 int cache_config_ram_cache_compress            = 0;
 int cache_config_ram_cache_compress_percent    = 90;
 int cache_config_ram_cache_use_seen_filter     = 1;
+int cache_config_ram_cache_persist             = 0;
 int cache_config_http_max_alts                 = 3;
 int cache_config_dir_sync_frequency            = 60;
+int cache_config_dir_numa_interleave           = 0;
+int cache_config_open_volumes_early            = 0;
 int cache_config_permit_pinning                = 0;
 int cache_config_select_alternate              = 1;
 int cache_config_max_doc_size                  = 0;
@@ -73,6 +77,11 @@ int64_t cache_config_ram_cache_cutoff          = AGG_SIZE;
 int cache_config_max_disk_errors               = 5;
 int cache_config_hit_evacuate_percent          = 10;
 int cache_config_hit_evacuate_size_limit       = 0;
+int cache_config_admission_min_hits            = 0;
+int cache_config_url_hash                      = 0;
+int cache_config_stripe_assignment             = 0;
+int cache_config_read_ahead_fragments          = 0;
+int64_t cache_config_read_ahead_max_memory     = 64 * 1024 * 1024;
 int cache_config_force_sector_size             = 0;
 int cache_config_target_fragment_size          = DEFAULT_TARGET_FRAGMENT_SIZE;
 int cache_config_agg_write_backlog             = AGG_SIZE * 2;
@@ -114,10 +123,142 @@ ClassAllocator<EvacuationKey> evacuationKeyAllocator("evacuationKey");
 int CacheVC::size_to_init = -1;
 CacheKey zero_key;
 
+// Recovery scans the data written since the last directory sync one RECOVERY_SIZE chunk at a
+// time. This reads the following chunk while the current one is being scanned. Each buffer keeps
+// AGG_SIZE of headroom in front of the read so the document straddling the end of the current
+// chunk can be copied in front of the next one instead of being read again.
+struct VolRecoverAhead : public Continuation {
+  Vol *vol;
+  AIOCallbackInternal ahead;
+  char *buf[2];
+  int cur        = 0;     // buf[cur] holds the chunk in Vol::io, the other one is read ahead
+  off_t cur_pos  = 0;     // disk offset of the chunk in buf[cur]
+  bool issued    = false; // ahead holds, or is reading, the chunk after cur_pos
+  bool in_flight = false;
+  bool waiting   = false; // the vol is blocked on the read ahead
+  bool abandoned = false;
+
+  char *
+  read_buf(int i) const
+  {
+    return buf[i] + AGG_SIZE;
+  }
+
+  int
+  handle_read(int /* event ATS_UNUSED */, void * /* data ATS_UNUSED */)
+  {
+    in_flight = false;
+    if (abandoned) {
+      delete this;
+      return EVENT_DONE;
+    }
+    if (waiting) {
+      waiting = false;
+      return use_ahead();
+    }
+    return EVENT_DONE;
+  }
+
+  // Start reading the chunk following the one that just landed in Vol::io.
+  void
+  start()
+  {
+    off_t end  = vol->skip + vol->len;
+    off_t next = vol->io.aiocb.aio_offset + vol->io.aiocb.aio_nbytes;
+    cur_pos    = vol->io.aiocb.aio_offset;
+    if (issued && ahead.aiocb.aio_offset == next) {
+      return;
+    }
+    issued = false;
+    if (in_flight || next >= end) {
+      return;
+    }
+    ahead.aiocb.aio_fildes = vol->fd;
+    ahead.aiocb.aio_buf    = read_buf(!cur);
+    ahead.aiocb.aio_offset = next;
+    ahead.aiocb.aio_nbytes = std::min(static_cast<off_t>(RECOVERY_SIZE), end - next);
+    ahead.action           = this;
+    ahead.thread           = AIO_CALLBACK_THREAD_ANY;
+    ahead.then             = nullptr;
+    issued                 = true;
+    in_flight              = true;
+    ink_assert(ink_aio_read(&ahead));
+  }
+
+  // Continue recovery at @a pos from the read ahead if it covers it. Returns false
+  // if the caller must read the chunk itself.
+  bool
+  next(off_t pos, int *ret)
+  {
+    off_t ahead_pos = ahead.aiocb.aio_offset;
+    if (!issued || vol->io.aiocb.aio_offset != cur_pos || pos < cur_pos || pos > ahead_pos || ahead_pos - pos > AGG_SIZE) {
+      return false;
+    }
+    if (in_flight) {
+      waiting = true;
+      *ret    = EVENT_CONT;
+    } else {
+      *ret = use_ahead();
+    }
+    return true;
+  }
+
+  int
+  use_ahead()
+  {
+    issued = false;
+    if ((size_t)ahead.aio_result != (size_t)ahead.aiocb.aio_nbytes) {
+      // Let the plain read report the error, if there really is one.
+      vol->io.aiocb.aio_buf    = read_buf(cur);
+      vol->io.aiocb.aio_offset = vol->recover_pos;
+      ink_assert(ink_aio_read(&vol->io));
+      return EVENT_CONT;
+    }
+    off_t carry = ahead.aiocb.aio_offset - vol->recover_pos;
+    char *dst   = read_buf(!cur) - carry;
+    memcpy(dst, read_buf(cur) + (vol->recover_pos - cur_pos), carry);
+    cur                      = !cur;
+    vol->io.aiocb.aio_buf    = dst;
+    vol->io.aiocb.aio_offset = vol->recover_pos;
+    vol->io.aiocb.aio_nbytes = carry + ahead.aiocb.aio_nbytes;
+    vol->io.aio_result       = vol->io.aiocb.aio_nbytes;
+    return vol->handleEvent(AIO_EVENT_DONE, &vol->io);
+  }
+
+  // Called when the recovery is over, an outstanding read ahead cleans up after itself.
+  void
+  release()
+  {
+    if (in_flight) {
+      abandoned = true;
+    } else {
+      delete this;
+    }
+  }
+
+  explicit VolRecoverAhead(Vol *v) : Continuation(v->mutex), vol(v)
+  {
+    for (auto &b : buf) {
+      b = (char *)ats_memalign(ats_pagesize(), AGG_SIZE + RECOVERY_SIZE);
+    }
+    SET_HANDLER(&VolRecoverAhead::handle_read);
+  }
+
+  ~VolRecoverAhead() override
+  {
+    ahead.action = nullptr;
+    ahead.mutex.clear();
+    mutex.clear();
+    free(buf[0]);
+    free(buf[1]);
+  }
+};
+
 struct VolInitInfo {
   off_t recover_pos;
   AIOCallbackInternal vol_aio[4];
   char *vol_h_f;
+  VolRecoverAhead *recover_ahead = nullptr;
 
   VolInitInfo()
   {
@@ -133,10 +274,12 @@ struct VolInitInfo {
       i.mutex.clear();
     }
     free(vol_h_f);
+    if (recover_ahead) {
+      recover_ahead->release();
+    }
   }
 };
 
-#if AIO_MODE == AIO_MODE_NATIVE
 struct VolInit : public Continuation {
   Vol *vol;
   char *path;
@@ -159,6 +302,8 @@ struct VolInit : public Continuation {
   }
 };
 
+#if AIO_MODE_PER_THREAD
+
 struct DiskInit : public Continuation {
   CacheDisk *disk;
   char *s;
@@ -577,10 +722,10 @@ CacheProcessor::start_internal(int flags)
   ink_assert((int)TS_EVENT_CACHE_SCAN_OPERATION_FAILED == (int)CACHE_EVENT_SCAN_OPERATION_FAILED);
   ink_assert((int)TS_EVENT_CACHE_SCAN_DONE == (int)CACHE_EVENT_SCAN_DONE);
 
-#if AIO_MODE == AIO_MODE_NATIVE
+#if AIO_MODE_PER_THREAD
   int etype            = ET_NET;
-  int n_netthreads     = eventProcessor.n_threads_for_type[etype];
-  EThread **netthreads = eventProcessor.eventthread[etype];
+  int n_netthreads     = eventProcessor.thread_group[etype]._count;
+  EThread **netthreads = eventProcessor.thread_group[etype]._thread;
   for (int i = 0; i < n_netthreads; ++i) {
     netthreads[i]->diskHandler = new DiskHandler();
     netthreads[i]->schedule_imm(netthreads[i]->diskHandler);
@@ -604,6 +749,15 @@ CacheProcessor::start_internal(int flags)
 
   config_volumes.read_config_file();
 
+  if (theCacheStore.dir_span && !cache_dir_device) {
+    cache_dir_device = new CacheDirDevice;
+    if (!cache_dir_device->open(theCacheStore.dir_span, check)) {
+      Warning("cache directory device unavailable, keeping the directories on the spans");
+      delete cache_dir_device;
+      cache_dir_device = nullptr;
+    }
+  }
+
   /*
    create CacheDisk objects for each span in the configuration file and store in gdisks
    */
@@ -664,6 +818,7 @@ CacheProcessor::start_internal(int flags)
           gdisks[gndisks]->read_only_p = true;
         }
         gdisks[gndisks]->forced_volume_num = sd->forced_volume_num;
+        gdisks[gndisks]->fast_tier         = sd->fast_tier;
         if (sd->hash_base_string) {
           gdisks[gndisks]->hash_base_string = ats_strdup(sd->hash_base_string);
         }
@@ -682,7 +837,7 @@ CacheProcessor::start_internal(int flags)
 
         off_t skip = ROUND_TO_STORE_BLOCK((sd->offset < START_POS ? START_POS + sd->alignment : sd->offset));
         blocks     = blocks - (skip >> STORE_BLOCK_SHIFT);
-#if AIO_MODE == AIO_MODE_NATIVE
+#if AIO_MODE_PER_THREAD
         eventProcessor.schedule_imm(new DiskInit(gdisks[gndisks], path, blocks, skip, sector_size, fd, clear));
 #else
         gdisks[gndisks]->open(path, blocks, skip, sector_size, fd, clear);
@@ -836,6 +991,21 @@ CacheProcessor::diskInitialized()
   }
 }
 
+// new ram_cache, with algorithm from the config
+static RamCache *
+new_configured_RamCache()
+{
+  switch (cache_config_ram_cache_algorithm) {
+  default:
+  case RAM_CACHE_ALGORITHM_CLFUS:
+    return new_RamCacheCLFUS();
+  case RAM_CACHE_ALGORITHM_LRU:
+    return new_RamCacheLRU();
+  case RAM_CACHE_ALGORITHM_SHARDED:
+    return new_RamCacheSharded();
+  }
+}
+
 void
 CacheProcessor::cacheInitialized()
 {
@@ -899,15 +1069,7 @@ CacheProcessor::cacheInitialized()
     if (gnvol) {
       // new ram_caches, with algorithm from the config
       for (i = 0; i < gnvol; i++) {
-        switch (cache_config_ram_cache_algorithm) {
-        default:
-        case RAM_CACHE_ALGORITHM_CLFUS:
-          gvol[i]->ram_cache = new_RamCacheCLFUS();
-          break;
-        case RAM_CACHE_ALGORITHM_LRU:
-          gvol[i]->ram_cache = new_RamCacheLRU();
-          break;
-        }
+        gvol[i]->ram_cache = new_configured_RamCache();
       }
       // let us calculate the Size
       if (cache_config_ram_cache_size == AUTO_SIZE_RAM_CACHE) {
@@ -997,6 +1159,16 @@ CacheProcessor::cacheInitialized()
       case CACHE_COMPRESSION_LIBLZMA:
 #ifndef HAVE_LZMA_H
         Fatal("lzma not available for RAM cache compression");
+#endif
+        break;
+      case CACHE_COMPRESSION_LZ4:
+#ifndef HAVE_LZ4_H
+        Fatal("lz4 not available for RAM cache compression");
+#endif
+        break;
+      case CACHE_COMPRESSION_ZSTD:
+#ifndef HAVE_ZSTD_H
+        Fatal("zstd not available for RAM cache compression");
 #endif
         break;
       }
@@ -1007,6 +1179,11 @@ CacheProcessor::cacheInitialized()
       GLOBAL_CACHE_SET_DYN_STAT(cache_direntries_used_stat, used_direntries);
       if (!check) {
         dir_sync_init();
+        if (cache_config_ram_cache_persist) {
+          for (i = 0; i < gnvol; i++) {
+            ram_cache_restore(gvol[i]);
+          }
+        }
       }
       cache_init_ok = 1;
     } else {
@@ -1135,8 +1312,8 @@ vol_init_data_internal(Vol *d)
   off_t total_entries = (d->len - (d->start - d->skip)) / cache_config_min_average_object_size;
   // step2: calculate the number of buckets
   off_t total_buckets = total_entries / DIR_DEPTH;
-  // step3: calculate the number of segments, no segment has more than 16384 buckets
-  d->segments = (total_buckets + (((1 << 16) - 1) / DIR_DEPTH)) / ((1 << 16) / DIR_DEPTH);
+  // step3: calculate the number of segments, no segment has more than MAX_BUCKETS_PER_SEGMENT buckets
+  d->segments = (total_buckets + MAX_BUCKETS_PER_SEGMENT - 1) / MAX_BUCKETS_PER_SEGMENT;
   // step4: divide total_buckets into segments on average.
   d->buckets = (total_buckets + d->segments - 1) / d->segments;
   // step5: set the start pointer.
@@ -1173,6 +1350,7 @@ void
 vol_clear_init(Vol *d)
 {
   size_t dir_len = d->dirlen();
+  dir_all_dirty(d);
   memset(d->raw_dir, 0, dir_len);
   vol_init_dir(d);
   d->header->magic          = VOL_MAGIC;
@@ -1184,6 +1362,7 @@ vol_clear_init(Vol *d)
   d->header->cycle                                        = 0;
   d->header->create_time                                  = time(nullptr);
   d->header->dirty                                        = 0;
+  d->header->url_hash                                     = cache_config_url_hash;
   d->sector_size = d->header->sector_size = d->disk->hw_sector_size;
   *d->footer                              = *d->header;
 }
@@ -1194,7 +1373,7 @@ vol_dir_clear(Vol *d)
   size_t dir_len = d->dirlen();
   vol_clear_init(d);
 
-  if (pwrite(d->fd, d->raw_dir, dir_len, d->skip) < 0) {
+  if (pwrite(d->dir_fd, d->raw_dir, dir_len, d->dir_pos) < 0) {
     Warning("unable to clear cache directory '%s'", d->hash_text.get());
     return -1;
   }
@@ -1209,10 +1388,10 @@ Vol::clear_dir()
 
   SET_HANDLER(&Vol::handle_dir_clear);
 
-  io.aiocb.aio_fildes = fd;
+  io.aiocb.aio_fildes = dir_fd;
   io.aiocb.aio_buf    = raw_dir;
   io.aiocb.aio_nbytes = dir_len;
-  io.aiocb.aio_offset = skip;
+  io.aiocb.aio_offset = dir_pos;
   io.action           = this;
   io.thread           = AIO_CALLBACK_THREAD_ANY;
   io.then             = nullptr;
@@ -1220,9 +1399,56 @@ Vol::clear_dir()
   return 0;
 }
 
+/* Move the directory of @a d to the directory device. The copies on the span are wiped as it is
+   moved, so a directory still found on the span was written without the device since, and the one
+   on the device is out of date. Returns true if the directory has to be cleared. */
+static bool
+vol_dir_place(Vol *d)
+{
+  bool found = false;
+  off_t pos  = cache_dir_device->place(d->hash_id, d->dirlen(), found);
+  if (pos < 0) {
+    Warning("no room for the directory of '%s' on the cache directory device, keeping it on its span", d->hash_text.get());
+    return false;
+  }
+
+  size_t footerlen     = ROUND_TO_STORE_BLOCK(sizeof(VolHeaderFooter));
+  const off_t copies[] = {d->skip, d->skip + static_cast<off_t>(d->dirlen())};
+  char *buf            = static_cast<char *>(ats_memalign(ats_pagesize(), footerlen));
+  bool on_span         = false;
+  for (off_t at : copies) {
+    if (pread(d->fd, buf, footerlen, at) == static_cast<ssize_t>(footerlen) &&
+        reinterpret_cast<VolHeaderFooter *>(buf)->magic == VOL_MAGIC) {
+      on_span = true;
+    }
+  }
+  if (on_span) {
+    bool wiped = !d->disk->read_only_p;
+    memset(buf, 0, footerlen);
+    for (off_t at : copies) {
+      wiped = wiped && pwrite(d->fd, buf, footerlen, at) == static_cast<ssize_t>(footerlen);
+    }
+    if (!wiped) {
+      Warning("unable to move the directory of '%s' to the cache directory device, keeping it on its span", d->hash_text.get());
+      ats_memalign_free(buf);
+      return false;
+    }
+  }
+  ats_memalign_free(buf);
+
+  d->dir_fd  = cache_dir_device->fd;
+  d->dir_pos = pos;
+  if (!found || on_span) {
+    Note("moving the directory of '%s' to the cache directory device", d->hash_text.get());
+    return true;
+  }
+  return false;
+}
+
 int
 Vol::init(char *s, off_t blocks, off_t dir_skip, bool clear)
 {
+  AtsMemTagScope mem_tag(ATS_MEM_TAG_CACHE);
   char *seed_str              = disk->hash_base_string ? disk->hash_base_string : s;
   const size_t hash_seed_size = strlen(seed_str);
   const size_t hash_text_size = hash_seed_size + 32;
@@ -1238,6 +1464,8 @@ Vol::init(char *s, off_t blocks, off_t dir_skip, bool clear)
   len      = blocks * STORE_BLOCK_SIZE;
   ink_assert(len <= MAX_VOL_SIZE);
   skip             = dir_skip;
+  dir_fd           = fd;
+  dir_pos          = skip;
   prev_recover_pos = 0;
 
   // successive approximation, directory/meta data eats up some storage
@@ -1250,6 +1478,9 @@ Vol::init(char *s, off_t blocks, off_t dir_skip, bool clear)
   int evac_len  = (int)evacuate_size * sizeof(DLL<EvacuationBlock>);
   evacuate      = (DLL<EvacuationBlock> *)ats_malloc(evac_len);
   memset(static_cast<void *>(evacuate), 0, evac_len);
+  if (cache_config_admission_min_hits > 0) {
+    admission.init(direntries());
+  }
 
   Debug("cache_init", "Vol %s: allocating %zu directory bytes for a %lld byte volume (%lf%%)", hash_text.get(), dirlen(),
         (long long)this->len, (double)dirlen() / (double)this->len * 100.0);
@@ -1261,10 +1492,26 @@ Vol::init(char *s, off_t blocks, off_t dir_skip, bool clear)
   if (raw_dir == nullptr) {
     raw_dir = (char *)ats_memalign(ats_pagesize(), this->dirlen());
   }
+#if TS_USE_HWLOC
+  // The directory is probed from every net thread, so spread its pages over all NUMA nodes
+  // before they are first touched rather than leaving them all on the node of this thread.
+  if (cache_config_dir_numa_interleave && hwloc_get_nbobjs_by_type(ink_get_topology(), HWLOC_OBJ_NODE) > 1) {
+    if (hwloc_set_area_membind_nodeset(ink_get_topology(), raw_dir, this->dirlen(),
+                                       hwloc_topology_get_complete_nodeset(ink_get_topology()), HWLOC_MEMBIND_INTERLEAVE,
+                                       HWLOC_MEMBIND_MIGRATE) != 0) {
+      Warning("unable to interleave the cache directory of '%s' across NUMA nodes: %s", hash_text.get(), strerror(errno));
+    }
+  }
+#endif
 
   dir    = (Dir *)(raw_dir + this->headerlen());
   header = (VolHeaderFooter *)raw_dir;
   footer = (VolHeaderFooter *)(raw_dir + this->dirlen() - ROUND_TO_STORE_BLOCK(sizeof(VolHeaderFooter)));
+  dir_sync_init_vol(this);
+
+  if (cache_dir_device && vol_dir_place(this)) {
+    clear = true;
+  }
 
   if (clear) {
     Note("clearing cache directory '%s'", hash_text.get());
@@ -1275,26 +1522,26 @@ Vol::init(char *s, off_t blocks, off_t dir_skip, bool clear)
   int footerlen       = ROUND_TO_STORE_BLOCK(sizeof(VolHeaderFooter));
   off_t footer_offset = this->dirlen() - footerlen;
   // try A
-  off_t as = skip;
+  off_t as = dir_pos;
 
   Debug("cache_init", "reading directory '%s'", hash_text.get());
   SET_HANDLER(&Vol::handle_header_read);
   init_info->vol_aio[0].aiocb.aio_offset = as;
   init_info->vol_aio[1].aiocb.aio_offset = as + footer_offset;
-  off_t bs                               = skip + this->dirlen();
+  off_t bs                               = dir_pos + this->dirlen();
   init_info->vol_aio[2].aiocb.aio_offset = bs;
   init_info->vol_aio[3].aiocb.aio_offset = bs + footer_offset;
 
   for (unsigned i = 0; i < countof(init_info->vol_aio); i++) {
     AIOCallback *aio      = &(init_info->vol_aio[i]);
-    aio->aiocb.aio_fildes = fd;
+    aio->aiocb.aio_fildes = dir_fd;
     aio->aiocb.aio_buf    = &(init_info->vol_h_f[i * STORE_BLOCK_SIZE]);
     aio->aiocb.aio_nbytes = footerlen;
     aio->action           = this;
     aio->thread           = AIO_CALLBACK_THREAD_ANY;
     aio->then             = (i < 3) ? &(init_info->vol_aio[i + 1]) : nullptr;
   }
-#if AIO_MODE == AIO_MODE_NATIVE
+#if AIO_MODE_PER_THREAD
   ink_assert(ink_aio_readv(init_info->vol_aio));
 #else
   ink_assert(ink_aio_read(init_info->vol_aio));
@@ -1319,9 +1566,9 @@ Vol::handle_dir_clear(int event, void *data)
     if (op->aiocb.aio_nbytes == dir_len) {
       /* clear the header for directory B. We don't need to clear the
          whole of directory B. The header for directory B starts at
-         skip + len */
+         dir_pos + dir_len */
       op->aiocb.aio_nbytes = ROUND_TO_STORE_BLOCK(sizeof(VolHeaderFooter));
-      op->aiocb.aio_offset = skip + dir_len;
+      op->aiocb.aio_offset = dir_pos + dir_len;
       ink_assert(ink_aio_write(op));
       return EVENT_DONE;
     }
@@ -1357,6 +1604,14 @@ Vol::handle_dir_read(int event, void *data)
     clear_dir();
     return EVENT_DONE;
   }
+  // None of the objects can be found with another hash of the keys. Stripes from before 4.0
+  // fall back to their own hash, see CB_After_Cache_Init.
+  if (header->version._major >= 23 && header->url_hash != static_cast<uint32_t>(cache_config_url_hash)) {
+    Note("cache directory '%s' has keys of proxy.config.cache.url_hash %u instead of %d, clearing", hash_text.get(),
+         header->url_hash, cache_config_url_hash);
+    clear_dir();
+    return EVENT_DONE;
+  }
   CHECK_DIR(this);
 
   sector_size = header->sector_size;
@@ -1430,8 +1685,10 @@ Vol::handle_recover_from_data(int event, void * /* data ATS_UNUSED */)
       recover_wrapped = true;
       recover_pos     = start;
     }
-    io.aiocb.aio_buf    = (char *)ats_memalign(ats_pagesize(), RECOVERY_SIZE);
-    io.aiocb.aio_nbytes = RECOVERY_SIZE;
+    init_info->recover_ahead = new VolRecoverAhead(this);
+    io.aiocb.aio_fildes      = fd; // the directory may have been read from the directory device
+    io.aiocb.aio_buf         = init_info->recover_ahead->read_buf(0);
+    io.aiocb.aio_nbytes      = RECOVERY_SIZE;
     if ((off_t)(recover_pos + io.aiocb.aio_nbytes) > (off_t)(skip + len)) {
       io.aiocb.aio_nbytes = (skip + len) - recover_pos;
     }
@@ -1441,6 +1698,7 @@ Vol::handle_recover_from_data(int event, void * /* data ATS_UNUSED */)
       disk->incrErrors(&io);
       goto Lclear;
     }
+    init_info->recover_ahead->start();
     if (io.aiocb.aio_offset == header->last_write_pos) {
       /* check that we haven't wrapped around without syncing
          the directory. Start from last_write_serial (write pos the documents
@@ -1588,7 +1846,14 @@ Vol::handle_recover_from_data(int event, void * /* data ATS_UNUSED */)
   if (recover_pos == prev_recover_pos) { // this should never happen, but if it does break the loop
     goto Lclear;
   }
-  prev_recover_pos    = recover_pos;
+  prev_recover_pos = recover_pos;
+  {
+    int ret;
+    if (init_info->recover_ahead->next(recover_pos, &ret)) {
+      return ret;
+    }
+  }
+  io.aiocb.aio_buf    = init_info->recover_ahead->read_buf(init_info->recover_ahead->cur);
   io.aiocb.aio_offset = recover_pos;
   ink_assert(ink_aio_read(&io));
   return EVENT_CONT;
@@ -1636,7 +1901,7 @@ Ldone : {
 
   for (int i = 0; i < 3; i++) {
     AIOCallback *aio      = &(init_info->vol_aio[i]);
-    aio->aiocb.aio_fildes = fd;
+    aio->aiocb.aio_fildes = dir_fd;
     aio->action           = this;
     aio->thread           = AIO_CALLBACK_THREAD_ANY;
     aio->then             = (i < 2) ? &(init_info->vol_aio[i + 1]) : nullptr;
@@ -1644,7 +1909,7 @@ Ldone : {
   int footerlen = ROUND_TO_STORE_BLOCK(sizeof(VolHeaderFooter));
   size_t dirlen = this->dirlen();
   int B         = header->sync_serial & 1;
-  off_t ss      = skip + (B ? dirlen : 0);
+  off_t ss      = dir_pos + (B ? dirlen : 0);
 
   init_info->vol_aio[0].aiocb.aio_buf    = raw_dir;
   init_info->vol_aio[0].aiocb.aio_nbytes = footerlen;
@@ -1657,7 +1922,7 @@ Ldone : {
   init_info->vol_aio[2].aiocb.aio_offset = ss + dirlen - footerlen;
 
   SET_HANDLER(&Vol::handle_recover_write_dir);
-#if AIO_MODE == AIO_MODE_NATIVE
+#if AIO_MODE_PER_THREAD
   ink_assert(ink_aio_writev(init_info->vol_aio));
 #else
   ink_assert(ink_aio_write(init_info->vol_aio));
@@ -1666,7 +1931,7 @@ Ldone : {
 }
 
 Lclear:
-  free((char *)io.aiocb.aio_buf);
+  io.aiocb.aio_buf = nullptr;
   delete init_info;
   init_info = nullptr;
   clear_dir();
@@ -1676,9 +1941,7 @@ Lclear:
 int
 Vol::handle_recover_write_dir(int /* event ATS_UNUSED */, void * /* data ATS_UNUSED */)
 {
-  if (io.aiocb.aio_buf) {
-    free((char *)io.aiocb.aio_buf);
-  }
+  io.aiocb.aio_buf = nullptr;
   delete init_info;
   init_info = nullptr;
   set_io_not_in_progress();
@@ -1707,7 +1970,7 @@ Vol::handle_header_read(int event, void *data)
       op = op->then;
     }
 
-    io.aiocb.aio_fildes = fd;
+    io.aiocb.aio_fildes = dir_fd;
     io.aiocb.aio_nbytes = this->dirlen();
     io.aiocb.aio_buf    = raw_dir;
     io.action           = this;
@@ -1720,7 +1983,7 @@ Vol::handle_header_read(int event, void *data)
       if (is_debug_tag_set("cache_init")) {
         Note("using directory A for '%s'", hash_text.get());
       }
-      io.aiocb.aio_offset = skip;
+      io.aiocb.aio_offset = dir_pos;
       ink_assert(ink_aio_read(&io));
     }
     // try B
@@ -1729,7 +1992,7 @@ Vol::handle_header_read(int event, void *data)
       if (is_debug_tag_set("cache_init")) {
         Note("using directory B for '%s'", hash_text.get());
       }
-      io.aiocb.aio_offset = skip + this->dirlen();
+      io.aiocb.aio_offset = dir_pos + this->dirlen();
       ink_assert(ink_aio_read(&io));
     } else {
       Note("no good directory, clearing '%s' since sync_serials on both A and B copies are invalid", hash_text.get());
@@ -1753,15 +2016,8 @@ Vol::dir_init_done(int /* event ATS_UNUSED */, void * /* data ATS_UNUSED */)
     eventProcessor.schedule_in(this, HRTIME_MSECONDS(5), ET_CALL);
     return EVENT_CONT;
   } else {
-    int vol_no = gnvol++;
-    ink_assert(!gvol[vol_no]);
-    gvol[vol_no] = this;
     SET_HANDLER(&Vol::aggWrite);
-    if (fd == -1) {
-      cache->vol_initialized(false);
-    } else {
-      cache->vol_initialized(true);
-    }
+    cache->vol_initialized(this);
     return EVENT_DONE;
   }
 }
@@ -1788,8 +2044,108 @@ cmprtable(const void *aa, const void *bb)
   return 0;
 }
 
-void
-build_vol_hash_table(CacheHostRecord *cp)
+static inline bool
+vol_is_usable(Vol *vol)
+{
+  return !DISK_BAD(vol->disk) && vol->online;
+}
+
+// Consistent hashing on a ring: every stripe draws points in proportion to its size from a random
+// sequence seeded by its hash, and every bucket goes to the stripe of the next point.
+static void
+build_vol_hash_table_ring(Vol **p, int num_vols, unsigned int *mapping, unsigned int *rtable_entries, unsigned int rtable_size,
+                          unsigned short *ttable, unsigned int *gotvol)
+{
+  unsigned int *rnd = (unsigned int *)ats_malloc(sizeof(unsigned int) * num_vols);
+
+  // seed random number generator
+  for (int i = 0; i < num_vols; i++) {
+    uint64_t x = p[i]->hash_id.fold();
+    rnd[i]     = (unsigned int)x;
+  }
+  // initialize table to "empty"
+  for (int i = 0; i < VOL_HASH_TABLE_SIZE; i++) {
+    ttable[i] = VOL_HASH_EMPTY;
+  }
+  // generate random numbers proportional to allocation
+  rtable_pair *rtable = (rtable_pair *)ats_malloc(sizeof(rtable_pair) * rtable_size);
+  int rindex          = 0;
+  for (int i = 0; i < num_vols; i++) {
+    for (int j = 0; j < (int)rtable_entries[i]; j++) {
+      rtable[rindex].rval = next_rand(&rnd[i]);
+      rtable[rindex].idx  = i;
+      rindex++;
+    }
+  }
+  ink_assert(rindex == (int)rtable_size);
+  // sort (rand #, vol $ pairs)
+  qsort(rtable, rtable_size, sizeof(rtable_pair), cmprtable);
+  unsigned int width = (1LL << 32) / VOL_HASH_TABLE_SIZE;
+  unsigned int pos; // target position to allocate
+  // select vol with closest random number for each bucket
+  int i = 0; // index moving through the random numbers
+  for (int j = 0; j < VOL_HASH_TABLE_SIZE; j++) {
+    pos = width / 2 + j * width; // position to select closest to
+    while (pos > rtable[i].rval && i < (int)rtable_size - 1) {
+      i++;
+    }
+    ttable[j] = mapping[rtable[i].idx];
+    gotvol[rtable[i].idx]++;
+  }
+  ats_free(rnd);
+  ats_free(rtable);
+}
+
+// A 64 bit finalizer (splitmix64) to derive the independent pseudo random draws of rendezvous
+// hashing from the stripe and bucket numbers.
+static inline uint64_t
+vol_hash_mix(uint64_t x)
+{
+  x += 0x9e3779b97f4a7c15ULL;
+  x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+  return x ^ (x >> 31);
+}
+
+/* Weighted rendezvous hashing: every bucket goes to the stripe with the highest score, where a
+   stripe scores weight / -ln(u) with u drawn uniformly from its hash and the bucket. The score of
+   a stripe in a bucket does not depend on the other stripes, so when a stripe goes away only its
+   buckets move, spread over the others in proportion to their size, and a new stripe only takes
+   buckets from the others.
+ */
+static void
+build_vol_hash_table_rendezvous(Vol **p, int num_vols, unsigned int *mapping, unsigned short *ttable, unsigned int *gotvol)
+{
+  uint64_t *seed = (uint64_t *)ats_malloc(sizeof(uint64_t) * num_vols);
+  double *weight = (double *)ats_malloc(sizeof(double) * num_vols);
+
+  for (int i = 0; i < num_vols; i++) {
+    seed[i]   = p[i]->hash_id.fold();
+    weight[i] = (double)(p[i]->len >> STORE_BLOCK_SHIFT);
+  }
+  for (int j = 0; j < VOL_HASH_TABLE_SIZE; j++) {
+    uint64_t bucket = vol_hash_mix(j);
+    double best     = -1;
+    int pick        = 0;
+    for (int i = 0; i < num_vols; i++) {
+      // The top 53 bits as a double in (0, 1), never 0 so the logarithm is finite.
+      double u     = ((vol_hash_mix(seed[i] ^ bucket) >> 11) + 0.5) * (1.0 / (1ULL << 53));
+      double score = weight[i] / -log(u);
+      if (score > best) {
+        best = score;
+        pick = i;
+      }
+    }
+    ttable[j] = mapping[pick];
+    gotvol[pick]++;
+  }
+  ats_free(seed);
+  ats_free(weight);
+}
+
+// Build @a table over the usable stripes of @a cp, or only those of the tier @a fast if @a tiered.
+static void
+build_vol_hash_table(CacheHostRecord *cp, unsigned short **table, bool tiered, bool fast)
 {
   int num_vols          = cp->num_vols;
   unsigned int *mapping = (unsigned int *)ats_malloc(sizeof(unsigned int) * num_vols);
@@ -1803,7 +2159,7 @@ build_vol_hash_table(CacheHostRecord *cp)
   uint64_t used  = 0;
   // initialize number of elements per vol
   for (int i = 0; i < num_vols; i++) {
-    if (DISK_BAD(cp->vols[i]->disk)) {
+    if (!vol_is_usable(cp->vols[i]) || (tiered && cp->vols[i]->disk->fast_tier != fast)) {
       bad_vols++;
       continue;
     }
@@ -1816,10 +2172,10 @@ build_vol_hash_table(CacheHostRecord *cp)
 
   if (!num_vols || !total) {
     // all the disks are corrupt,
-    if (cp->vol_hash_table) {
-      new_Freer(cp->vol_hash_table, CACHE_MEM_FREE_TIMEOUT);
+    if (*table) {
+      new_Freer(*table, CACHE_MEM_FREE_TIMEOUT);
     }
-    cp->vol_hash_table = nullptr;
+    *table = nullptr;
     ats_free(mapping);
     ats_free(p);
     return;
@@ -1827,7 +2183,6 @@ build_vol_hash_table(CacheHostRecord *cp)
 
   unsigned int *forvol   = (unsigned int *)ats_malloc(sizeof(unsigned int) * num_vols);
   unsigned int *gotvol   = (unsigned int *)ats_malloc(sizeof(unsigned int) * num_vols);
-  unsigned int *rnd      = (unsigned int *)ats_malloc(sizeof(unsigned int) * num_vols);
   unsigned short *ttable = (unsigned short *)ats_malloc(sizeof(unsigned short) * VOL_HASH_TABLE_SIZE);
   unsigned short *old_table;
   unsigned int *rtable_entries = (unsigned int *)ats_malloc(sizeof(unsigned int) * num_vols);
@@ -1846,64 +2201,129 @@ build_vol_hash_table(CacheHostRecord *cp)
   for (int i = 0; i < extra; i++) {
     forvol[i % num_vols]++;
   }
-  // seed random number generator
-  for (int i = 0; i < num_vols; i++) {
-    uint64_t x = p[i]->hash_id.fold();
-    rnd[i]     = (unsigned int)x;
-  }
-  // initialize table to "empty"
-  for (int i = 0; i < VOL_HASH_TABLE_SIZE; i++) {
-    ttable[i] = VOL_HASH_EMPTY;
-  }
-  // generate random numbers proportional to allocation
-  rtable_pair *rtable = (rtable_pair *)ats_malloc(sizeof(rtable_pair) * rtable_size);
-  int rindex          = 0;
-  for (int i = 0; i < num_vols; i++) {
-    for (int j = 0; j < (int)rtable_entries[i]; j++) {
-      rtable[rindex].rval = next_rand(&rnd[i]);
-      rtable[rindex].idx  = i;
-      rindex++;
-    }
-  }
-  ink_assert(rindex == (int)rtable_size);
-  // sort (rand #, vol $ pairs)
-  qsort(rtable, rtable_size, sizeof(rtable_pair), cmprtable);
-  unsigned int width = (1LL << 32) / VOL_HASH_TABLE_SIZE;
-  unsigned int pos; // target position to allocate
-  // select vol with closest random number for each bucket
-  int i = 0; // index moving through the random numbers
-  for (int j = 0; j < VOL_HASH_TABLE_SIZE; j++) {
-    pos = width / 2 + j * width; // position to select closest to
-    while (pos > rtable[i].rval && i < (int)rtable_size - 1) {
-      i++;
-    }
-    ttable[j] = mapping[rtable[i].idx];
-    gotvol[rtable[i].idx]++;
+  if (cache_config_stripe_assignment == 1) {
+    build_vol_hash_table_rendezvous(p, num_vols, mapping, ttable, gotvol);
+  } else {
+    build_vol_hash_table_ring(p, num_vols, mapping, rtable_entries, rtable_size, ttable, gotvol);
   }
   for (int i = 0; i < num_vols; i++) {
     Debug("cache_init", "build_vol_hash_table index %d mapped to %d requested %d got %d", i, mapping[i], forvol[i], gotvol[i]);
   }
   // install new table
-  if (nullptr != (old_table = ink_atomic_swap(&(cp->vol_hash_table), ttable))) {
+  if (nullptr != (old_table = ink_atomic_swap(table, ttable))) {
     new_Freer(old_table, CACHE_MEM_FREE_TIMEOUT);
   }
   ats_free(mapping);
   ats_free(p);
   ats_free(forvol);
   ats_free(gotvol);
-  ats_free(rnd);
   ats_free(rtable_entries);
-  ats_free(rtable);
 }
 
+/* A host record with usable stripes on both fast (SSD) and other spans is tiered: the stripe of an
+   object is picked among the other stripes, it is copied to one of the fast stripes picked by the
+   fast table once it is read often. Otherwise every stripe is in the single table.
+ */
 void
-Cache::vol_initialized(bool result)
+build_vol_hash_table(CacheHostRecord *cp)
 {
+  int num_fast = 0;
+  int num_home = 0;
+  for (int i = 0; i < cp->num_vols; i++) {
+    if (vol_is_usable(cp->vols[i])) {
+      ++(cp->vols[i]->disk->fast_tier ? num_fast : num_home);
+    }
+  }
+  bool tiered = num_fast > 0 && num_home > 0;
+
+  build_vol_hash_table(cp, &cp->vol_hash_table, tiered, false);
+  if (tiered) {
+    build_vol_hash_table(cp, &cp->fast_hash_table, true, true);
+  } else if (unsigned short *old_table = ink_atomic_swap(&(cp->fast_hash_table), (unsigned short *)nullptr); old_table) {
+    new_Freer(old_table, CACHE_MEM_FREE_TIMEOUT);
+  }
+}
+
+// Give a stripe that comes up after the cache opened its RAM cache and add it to the cache totals,
+// the way CacheProcessor::cacheInitialized() does for the stripes that were up at that point.
+static void
+vol_add_to_open_cache(Vol *vol)
+{
+  ProxyMutex *mutex = this_ethread()->mutex.get();
+  int64_t ram_cache_bytes;
+
+  vol->ram_cache = new_configured_RamCache();
+  if (cache_config_ram_cache_size == AUTO_SIZE_RAM_CACHE) {
+    vol->ram_cache->init(vol->dirlen() * DEFAULT_RAM_CACHE_MULTIPLIER, vol);
+    ram_cache_bytes = vol->dirlen();
+  } else {
+    // Only the http cache has stripes, so it gets all of the configured RAM.
+    ram_cache_bytes = (int64_t)(cache_config_ram_cache_size * ((double)(int64_t)(vol->len >> STORE_BLOCK_SHIFT) /
+                                                               (int64_t)vol->cache->cache_size));
+    vol->ram_cache->init(ram_cache_bytes, vol);
+  }
+  int64_t cache_bytes      = vol->len - vol->dirlen();
+  int64_t total_direntries = vol->buckets * vol->segments * DIR_DEPTH;
+  int64_t used_direntries  = dir_entries_used(vol);
+
+  CACHE_VOL_SUM_DYN_STAT(cache_ram_cache_bytes_total_stat, ram_cache_bytes);
+  CACHE_VOL_SUM_DYN_STAT(cache_bytes_total_stat, cache_bytes);
+  CACHE_VOL_SUM_DYN_STAT(cache_direntries_total_stat, total_direntries);
+  CACHE_VOL_SUM_DYN_STAT(cache_direntries_used_stat, used_direntries);
+  GLOBAL_CACHE_SUM_GLOBAL_DYN_STAT(cache_ram_cache_bytes_total_stat, ram_cache_bytes);
+  GLOBAL_CACHE_SUM_GLOBAL_DYN_STAT(cache_bytes_total_stat, cache_bytes);
+  GLOBAL_CACHE_SUM_GLOBAL_DYN_STAT(cache_direntries_total_stat, total_direntries);
+  GLOBAL_CACHE_SUM_GLOBAL_DYN_STAT(cache_direntries_used_stat, used_direntries);
+
+  if (vol->header->version < cacheProcessor.min_stripe_version) {
+    cacheProcessor.min_stripe_version = vol->header->version;
+  }
+  if (cacheProcessor.max_stripe_version < vol->header->version) {
+    cacheProcessor.max_stripe_version = vol->header->version;
+  }
+}
+
+static ink_mutex vol_initialized_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+void
+Cache::vol_initialized(Vol *vol)
+{
+  bool result = vol->fd != -1;
+  ink_scoped_mutex_lock lock(vol_initialized_mutex);
+
+  // Publish the stripe before counting it, the directory sync walks gvol up to gnvol.
+  ink_assert(!gvol[gnvol]);
+  gvol[gnvol] = vol;
+  ++gnvol;
   if (result) {
-    ink_atomic_increment(&total_good_nvol, 1);
+    ++total_good_nvol;
+  }
+  bool last = ++total_initialized_vol == total_nvol;
+
+  if (ready == CACHE_INITIALIZED) {
+    // The cache opened before this stripe was done, start hashing objects to it.
+    vol_add_to_open_cache(vol);
+    vol->online = true;
+    rebuild_host_table(this);
+    Note("cache volume '%s' online, %d of %d volumes initialized", vol->hash_text.get(), total_initialized_vol, total_nvol);
+    return;
   }
-  if (total_nvol == ink_atomic_increment(&total_initialized_vol, 1) + 1) {
+
+  vol->online = true;
+  if (last) {
     open_done();
+  } else if (cache_config_open_volumes_early && result) {
+    if (hosttable) {
+      rebuild_host_table(this);
+    } else {
+      hosttable = new CacheHostTable(this, scheme);
+      hosttable->register_config_callback(&hosttable);
+    }
+    // Open as soon as objects without a volume assignment have somewhere to go.
+    if (hosttable->gen_host_rec.vol_hash_table) {
+      Note("opening the cache with %d of %d volumes initialized", total_initialized_vol, total_nvol);
+      open_done();
+    }
   }
 }
 
@@ -2031,8 +2451,13 @@ Cache::open_done()
     return 0;
   }
 
-  hosttable = new CacheHostTable(this, scheme);
-  hosttable->register_config_callback(&hosttable);
+  if (hosttable) {
+    // Built by vol_initialized() while waiting for a stripe to open early on.
+    rebuild_host_table(this);
+  } else {
+    hosttable = new CacheHostTable(this, scheme);
+    hosttable->register_config_callback(&hosttable);
+  }
 
   if (hosttable->gen_host_rec.num_cachevols == 0) {
     ready = CACHE_INIT_FAILED;
@@ -2081,11 +2506,9 @@ Cache::open(bool clear, bool /* fix ATS_UNUSED */)
             blocks                      = q->b->len;
 
             bool vol_clear = clear || d->cleared || q->new_block;
-#if AIO_MODE == AIO_MODE_NATIVE
+            // Set up the stripes on the event threads so their directories are allocated and
+            // read concurrently, dir_init_done() holds them until the whole list is built.
             eventProcessor.schedule_imm(new VolInit(cp->vols[vol_no], d->path, blocks, q->b->offset, vol_clear));
-#else
-            cp->vols[vol_no]->init(d->path, blocks, q->b->offset, vol_clear);
-#endif
             vol_no++;
             cache_size += blocks;
           }
@@ -2122,7 +2545,7 @@ CacheVC::is_pread_capable()
 
 #define STORE_COLLISION 1
 
-static void
+void
 unmarshal_helper(Doc *doc, Ptr<IOBufferData> &buf, int &okay)
 {
   using UnmarshalFunc           = int(char *buf, int len, RefCountObj *block_ref);
@@ -2230,6 +2653,8 @@ upgrade_doc_version(Ptr<IOBufferData> &buf)
       n_doc->v_major = 0;
       n_doc->v_minor = 0;
       n_doc->unused  = 0; // force to zero to make future use easier.
+      // The header was rewritten, a checksum of the old one would not match.
+      n_doc->checksum = DOC_NO_CHECKSUM;
     }
   }
   return zret;
@@ -2324,13 +2749,9 @@ CacheVC::handleReadDone(int event, Event *e)
       if (!f.doc_from_ram_cache) {
         f.not_from_ram_cache = 1;
       }
-      if (cache_config_enable_checksum && doc->checksum != DOC_NO_CHECKSUM) {
-        // verify that the checksum matches
-        uint32_t checksum = 0;
-        for (char *b = doc->hdr(); b < (char *)doc + doc->len; b++) {
-          checksum += *b;
-        }
-        ink_assert(checksum == doc->checksum);
+      // Verify the checksum of every fragment read from disk that has one, the ram cache only holds verified or written ones.
+      if (doc->checksum != DOC_NO_CHECKSUM && !f.doc_from_ram_cache) {
+        uint32_t checksum = doc->compute_checksum();
         if (checksum != doc->checksum) {
           Note("cache: checksum error for [%" PRIu64 " %" PRIu64 "] len %d, hlen %d, disk %s, offset %" PRIu64 " size %zu",
                doc->first_key.b[0], doc->first_key.b[1], doc->len, doc->hlen, vol->path, (uint64_t)io.aiocb.aio_offset,
@@ -2347,6 +2768,11 @@ CacheVC::handleReadDone(int event, Event *e)
       // unless it could be compressed
       if (!http_copy_hdr && doc->doc_type == CACHE_FRAG_TYPE_HTTP && doc->hlen && okay) {
         unmarshal_helper(doc, buf, okay);
+        // A copy out of the ram cache, let the ram cache keep it if it can so later hits skip this.
+        if (okay && f.doc_from_ram_cache && !f.compressed_in_ram) {
+          uint64_t o = dir_offset(&dir);
+          vol->ram_cache->put_unmarshalled(read_key, buf.get(), (uint32_t)(o >> 32), (uint32_t)o);
+        }
       }
       // Put the request in the ram cache only if its a open_read or lookup
       if (vio.op == VIO::READ && okay) {
@@ -2399,6 +2825,22 @@ CacheVC::handleRead(int /* event ATS_UNUSED */, Event * /* e ATS_UNUSED */)
     goto LramHit;
   }
 
+  // check if it was read ahead, it may still be on its way
+  if (CacheReadAhead *ra = readAheadTake(read_key, dir_offset(&dir)); ra != nullptr) {
+    CACHE_INCREMENT_DYN_STAT(cache_read_ahead_hit_stat);
+    io.aiocb.aio_nbytes = ra->io.aiocb.aio_nbytes;
+    SET_HANDLER(&CacheVC::handleReadDone);
+    if (!ra->done) {
+      ra->waiter          = this;
+      io.aiocb.aio_fildes = vol->fd;
+      return EVENT_CONT;
+    }
+    buf           = ra->buf;
+    io.aio_result = ra->io.aio_result;
+    ra->destroy();
+    return EVENT_RETURN;
+  }
+
   // check if it was read in the last open_read call
   if (*read_key == vol->first_fragment_key && dir_offset(&dir) == vol->first_fragment_offset) {
     buf = vol->first_fragment_data;
@@ -2407,7 +2849,7 @@ CacheVC::handleRead(int /* event ATS_UNUSED */, Event * /* e ATS_UNUSED */)
   // see if its in the aggregation buffer
   if (dir_agg_buf_valid(vol, &dir)) {
     int agg_offset = vol->vol_offset(&dir) - vol->header->write_pos;
-    buf            = new_IOBufferData(iobuffer_size_to_index(io.aiocb.aio_nbytes, MAX_BUFFER_SIZE_INDEX), MEMALIGNED);
+    buf            = new_IOBufferData(iobuffer_size_to_fit_index(io.aiocb.aio_nbytes, MAX_BUFFER_SIZE_INDEX), MEMALIGNED);
     ink_assert((agg_offset + io.aiocb.aio_nbytes) <= (unsigned)vol->agg_buf_pos);
     char *doc = buf->data();
     char *agg = vol->agg_buffer + agg_offset;
@@ -2422,7 +2864,7 @@ CacheVC::handleRead(int /* event ATS_UNUSED */, Event * /* e ATS_UNUSED */)
   if ((off_t)(io.aiocb.aio_offset + io.aiocb.aio_nbytes) > (off_t)(vol->skip + vol->len)) {
     io.aiocb.aio_nbytes = vol->skip + vol->len - io.aiocb.aio_offset;
   }
-  buf              = new_IOBufferData(iobuffer_size_to_index(io.aiocb.aio_nbytes, MAX_BUFFER_SIZE_INDEX), MEMALIGNED);
+  buf              = new_IOBufferData(iobuffer_size_to_fit_index(io.aiocb.aio_nbytes, MAX_BUFFER_SIZE_INDEX), MEMALIGNED);
   io.aiocb.aio_buf = buf->data();
   io.action        = this;
   io.thread        = mutex->thread_holding->tt == DEDICATED ? AIO_CALLBACK_THREAD_ANY : mutex->thread_holding;
@@ -2960,6 +3402,13 @@ cplist_reconfigure()
       gnvol += cp->num_vols;
     }
   }
+
+  for (config_vol = config_volumes.cp_queue.head; config_vol; config_vol = config_vol->link.next) {
+    if (config_vol->cachep) {
+      config_vol->cachep->fragment_size = config_vol->fragment_size;
+      config_vol->cachep->no_evacuate   = config_vol->no_evacuate;
+    }
+  }
   return 0;
 }
 
@@ -3046,7 +3495,7 @@ rebuild_host_table(Cache *cache)
 
 // if generic_host_rec.vols == nullptr, what do we do???
 Vol *
-Cache::key_to_vol(const CacheKey *key, const char *hostname, int host_len)
+Cache::key_to_vol(const CacheKey *key, const char *hostname, int host_len, Vol **fast_vol)
 {
   uint32_t h                 = (key->slice32(2) >> DIR_TAG_WIDTH) % VOL_HASH_TABLE_SIZE;
   unsigned short *hash_table = hosttable->gen_host_rec.vol_hash_table;
@@ -3063,6 +3512,10 @@ Cache::key_to_vol(const CacheKey *key, const char *hostname, int host_len)
           snprintf(format_str, sizeof(format_str), "Volume: %%xd for host: %%.%ds", host_len);
           Debug("cache_hosting", format_str, res.record, hostname);
         }
+        if (fast_vol) {
+          unsigned short *fast_table = res.record->fast_hash_table;
+          *fast_vol                  = fast_table ? res.record->vols[fast_table[h]] : nullptr;
+        }
         return res.record->vols[host_hash_table[h]];
       }
     }
@@ -3073,8 +3526,15 @@ Cache::key_to_vol(const CacheKey *key, const char *hostname, int host_len)
       snprintf(format_str, sizeof(format_str), "Generic volume: %%xd for host: %%.%ds", host_len);
       Debug("cache_hosting", format_str, host_rec, hostname);
     }
+    if (fast_vol) {
+      unsigned short *fast_table = host_rec->fast_hash_table;
+      *fast_vol                  = fast_table ? host_rec->vols[fast_table[h]] : nullptr;
+    }
     return host_rec->vols[hash_table[h]];
   } else {
+    if (fast_vol) {
+      *fast_vol = nullptr;
+    }
     return host_rec->vols[0];
   }
 }
@@ -3101,6 +3561,10 @@ register_cache_stats(RecRawStatBlock *rsb, const char *prefix)
   REG_INT("ram_cache.bytes_used", cache_ram_cache_bytes_stat);
   REG_INT("ram_cache.hits", cache_ram_cache_hits_stat);
   REG_INT("ram_cache.misses", cache_ram_cache_misses_stat);
+  REG_INT("ram_cache.compress.bytes_in", cache_ram_cache_compress_in_stat);
+  REG_INT("ram_cache.compress.bytes_out", cache_ram_cache_compress_out_stat);
+  REG_INT("ram_cache.compress.time", cache_ram_cache_compress_time_stat);
+  REG_INT("ram_cache.decompress.time", cache_ram_cache_decompress_time_stat);
   REG_INT("pread_count", cache_pread_count_stat);
   REG_INT("percent_full", cache_percent_full_stat);
   REG_INT("lookup.active", cache_lookup_active_stat);
@@ -3116,6 +3580,8 @@ register_cache_stats(RecRawStatBlock *rsb, const char *prefix)
   REG_INT("update.active", cache_update_active_stat);
   REG_INT("update.success", cache_update_success_stat);
   REG_INT("update.failure", cache_update_failure_stat);
+  REG_INT("update.header_only", cache_update_header_only_stat);
+  REG_INT("update.header_only.bytes", cache_update_header_only_bytes_stat);
   REG_INT("remove.active", cache_remove_active_stat);
   REG_INT("remove.success", cache_remove_success_stat);
   REG_INT("remove.failure", cache_remove_failure_stat);
@@ -3143,6 +3609,12 @@ register_cache_stats(RecRawStatBlock *rsb, const char *prefix)
   REG_INT("sync.count", cache_directory_sync_count_stat);
   REG_INT("sync.bytes", cache_directory_sync_bytes_stat);
   REG_INT("sync.time", cache_directory_sync_time_stat);
+  REG_INT("tier.hits", cache_tier_hit_stat);
+  REG_INT("tier.promotions", cache_tier_promote_stat);
+  REG_INT("admission.admitted", cache_admission_admit_stat);
+  REG_INT("admission.rejected", cache_admission_reject_stat);
+  REG_INT("read_ahead.reads", cache_read_ahead_stat);
+  REG_INT("read_ahead.hits", cache_read_ahead_hit_stat);
   REG_INT("span.errors.read", cache_span_errors_read_stat);
   REG_INT("span.errors.write", cache_span_errors_write_stat);
   REG_INT("span.failing", cache_span_failing_stat);
@@ -3177,6 +3649,7 @@ ink_cache_init(ts::ModuleVersion v)
   REC_EstablishStaticConfigInt32(cache_config_ram_cache_compress, "proxy.config.cache.ram_cache.compress");
   REC_EstablishStaticConfigInt32(cache_config_ram_cache_compress_percent, "proxy.config.cache.ram_cache.compress_percent");
   REC_ReadConfigInt32(cache_config_ram_cache_use_seen_filter, "proxy.config.cache.ram_cache.use_seen_filter");
+  REC_EstablishStaticConfigInt32(cache_config_ram_cache_persist, "proxy.config.cache.ram_cache.persist");
 
   REC_EstablishStaticConfigInt32(cache_config_http_max_alts, "proxy.config.cache.limits.http.max_alts");
   Debug("cache_init", "proxy.config.cache.limits.http.max_alts = %d", cache_config_http_max_alts);
@@ -3191,6 +3664,9 @@ ink_cache_init(ts::ModuleVersion v)
   REC_EstablishStaticConfigInt32(cache_config_dir_sync_frequency, "proxy.config.cache.dir.sync_frequency");
   Debug("cache_init", "proxy.config.cache.dir.sync_frequency = %d", cache_config_dir_sync_frequency);
 
+  REC_ReadConfigInt32(cache_config_dir_numa_interleave, "proxy.config.cache.dir.numa_interleave");
+  REC_ReadConfigInt32(cache_config_open_volumes_early, "proxy.config.cache.open_volumes_early");
+
   REC_EstablishStaticConfigInt32(cache_config_select_alternate, "proxy.config.cache.select_alternate");
   Debug("cache_init", "proxy.config.cache.select_alternate = %d", cache_config_select_alternate);
 
@@ -3213,6 +3689,22 @@ ink_cache_init(ts::ModuleVersion v)
   REC_EstablishStaticConfigInt32(cache_config_hit_evacuate_size_limit, "proxy.config.cache.hit_evacuate_size_limit");
   Debug("cache_init", "proxy.config.cache.hit_evacuate_size_limit = %d", cache_config_hit_evacuate_size_limit);
 
+  REC_EstablishStaticConfigInt32(cache_config_admission_min_hits, "proxy.config.cache.admission.min_hits");
+  Debug("cache_init", "proxy.config.cache.admission.min_hits = %d", cache_config_admission_min_hits);
+
+  REC_EstablishStaticConfigInt32(cache_config_url_hash, "proxy.config.cache.url_hash");
+  Debug("cache_init", "proxy.config.cache.url_hash = %d", cache_config_url_hash);
+  url_hash_method_set(cache_config_url_hash == 1 ? URL_HASH_MURMUR3 : URL_HASH_CRYPTO);
+
+  REC_EstablishStaticConfigInt32(cache_config_stripe_assignment, "proxy.config.cache.stripe_assignment");
+  Debug("cache_init", "proxy.config.cache.stripe_assignment = %d", cache_config_stripe_assignment);
+
+  REC_EstablishStaticConfigInt32(cache_config_read_ahead_fragments, "proxy.config.cache.read_ahead.fragments");
+  Debug("cache_init", "proxy.config.cache.read_ahead.fragments = %d", cache_config_read_ahead_fragments);
+
+  REC_EstablishStaticConfigInteger(cache_config_read_ahead_max_memory, "proxy.config.cache.read_ahead.max_memory");
+  Debug("cache_init", "proxy.config.cache.read_ahead.max_memory = %" PRId64, cache_config_read_ahead_max_memory);
+
   REC_EstablishStaticConfigInt32(cache_config_force_sector_size, "proxy.config.cache.force_sector_size");
 
   ink_assert(REC_RegisterConfigUpdateFunc("proxy.config.cache.target_fragment_size", FragmentSizeUpdateCb, nullptr) !=
@@ -3268,6 +3760,24 @@ CacheProcessor::open_write(Continuation *cont, int expected_size, const HttpCach
   return caches[type]->open_write(cont, &key->hash, old_info, pin_in_cache, nullptr /* key1 */, type, key->hostname, key->hostlen);
 }
 
+//----------------------------------------------------------------------------
+bool
+CacheProcessor::admit_write(const HttpCacheKey *key)
+{
+  if (cache_config_admission_min_hits <= 0 || CACHE_INITIALIZED != initialized) {
+    return true;
+  }
+
+  Vol *vol          = caches[CACHE_FRAG_TYPE_HTTP]->key_to_vol(&key->hash, key->hostname, key->hostlen);
+  ProxyMutex *mutex = this_ethread()->mutex.get();
+  if (vol->admission.increment(key->hash) >= cache_config_admission_min_hits) {
+    CACHE_INCREMENT_DYN_STAT(cache_admission_admit_stat);
+    return true;
+  }
+  CACHE_INCREMENT_DYN_STAT(cache_admission_reject_stat);
+  return false;
+}
+
 //----------------------------------------------------------------------------
 // Note: this should not be called from from the cluster processor, or bad
 // recursion could occur. This is merely a convenience wrapper.
@@ -0,0 +1,114 @@
+/** @file
+
+  Admission filter of the cache writes.
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ */
+
+#include <algorithm>
+
+#include "P_CacheAdmission.h"
+
+namespace
+{
+/// Smallest width, not to have the sketch of a small stripe saturate.
+constexpr uint64_t MIN_WIDTH = 1024;
+/// Halve every counter, each counter is kept within its 4 bits.
+constexpr uint64_t HALF_MASK = 0x7777777777777777ULL;
+} // namespace
+
+void
+CacheAdmission::init(int64_t entries)
+{
+  _width = MIN_WIDTH;
+  while (_width < static_cast<uint64_t>(entries) / 16) {
+    _width <<= 1;
+  }
+  _sample = _width * 10;
+
+  size_t n = DEPTH * _width / COUNTERS_PER_WORD;
+  _words.reset(new std::atomic<uint64_t>[n]);
+  for (size_t i = 0; i < n; ++i) {
+    _words[i].store(0, std::memory_order_relaxed);
+  }
+}
+
+std::atomic<uint64_t> &
+CacheAdmission::counter(const CryptoHash &key, int row, int &shift) const
+{
+  // The rows are indexed by a combination of two halves of the key, as good as independent hashes.
+  uint64_t h   = key.u64[0] + row * (key.u64[1] | 1);
+  uint64_t idx = (h ^ (h >> 32)) & (_width - 1);
+  shift        = (idx % COUNTERS_PER_WORD) * 4;
+  return _words[(row * _width + idx) / COUNTERS_PER_WORD];
+}
+
+int
+CacheAdmission::estimate(const CryptoHash &key) const
+{
+  int count = MAX_COUNT;
+  for (int row = 0; row < DEPTH; ++row) {
+    int shift;
+    uint64_t w = counter(key, row, shift).load(std::memory_order_relaxed);
+    count      = std::min(count, static_cast<int>((w >> shift) & 0xF));
+  }
+  return count;
+}
+
+int
+CacheAdmission::increment(const CryptoHash &key)
+{
+  if (!_words) {
+    return MAX_COUNT;
+  }
+
+  int count = estimate(key);
+  if (count < MAX_COUNT) {
+    // Conservative update, only the counters that are the smallest are incremented.
+    for (int row = 0; row < DEPTH; ++row) {
+      int shift;
+      std::atomic<uint64_t> &word = counter(key, row, shift);
+      uint64_t w                  = word.load(std::memory_order_relaxed);
+      while (static_cast<int>((w >> shift) & 0xF) == count &&
+             !word.compare_exchange_weak(w, w + (1ULL << shift), std::memory_order_relaxed)) {
+        ;
+      }
+    }
+    ++count;
+  }
+
+  if (_increments.fetch_add(1, std::memory_order_relaxed) + 1 == _sample) {
+    age();
+  }
+  return count;
+}
+
+void
+CacheAdmission::age()
+{
+  // Only the thread that reached the sample gets here, the others keep counting meanwhile.
+  size_t n = DEPTH * _width / COUNTERS_PER_WORD;
+  for (size_t i = 0; i < n; ++i) {
+    uint64_t w = _words[i].load(std::memory_order_relaxed);
+    while (!_words[i].compare_exchange_weak(w, (w >> 1) & HALF_MASK, std::memory_order_relaxed)) {
+      ;
+    }
+  }
+  _increments.fetch_sub(_sample, std::memory_order_relaxed);
+}
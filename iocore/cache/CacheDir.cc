@@ -23,7 +23,6 @@
 
 #include "P_Cache.h"
 
-#include "tscore/hugepages.h"
 #include "tscore/Regression.h"
 
 // #define LOOP_CHECK_MODE 1
@@ -115,7 +114,8 @@ OpenDir::signal_readers(int /* event ATS_UNUSED */, Event * /* e ATS_UNUSED */)
     CACHE_TRY_LOCK(lock, c->mutex, t);
     if (lock.is_locked()) {
       c->f.open_read_timeout = 0;
-      c->handleEvent(EVENT_IMMEDIATE, nullptr);
+      // EVENT_INTERVAL, as the read handlers take it for a retry and drop EVENT_IMMEDIATE.
+      c->handleEvent(EVENT_INTERVAL, nullptr);
       continue;
     }
     newly_delayed_readers.push(c);
@@ -163,13 +163,60 @@ OpenDir::open_read(const CryptoHash *key)
   return nullptr;
 }
 
+/*
+   Wake the readers waiting on od, after a writer wrote a fragment. They are
+   called back from an event so that they do not run within the writer.
+   */
+void
+OpenDir::signal_waiters(OpenDirEntry *od)
+{
+  ink_assert(mutex->thread_holding == this_ethread());
+  if (od->readers.head) {
+    delayed_readers.append(od->readers);
+    od->readers.clear();
+    mutex->thread_holding->schedule_imm(this);
+  }
+}
+
+/*
+   Take a reader off the waiting lists if it is still on one, because it
+   timed out or is closing. A reader that was signaled has already left.
+   */
+void
+OpenDir::cancel_wait(CacheVC *cont)
+{
+  ink_assert(mutex->thread_holding == this_ethread());
+  if (!cont->f.open_read_timeout) {
+    return;
+  }
+  cont->f.open_read_timeout = 0;
+  if (OpenDirEntry *d = open_read(&cont->first_key)) {
+    for (CacheVC *c = d->readers.head; c; c = static_cast<CacheVC *>(c->opendir_link.next)) {
+      if (c == cont) {
+        d->readers.remove(cont);
+        return;
+      }
+    }
+  }
+  // The entry was closed or signaled but the reader lock was missed.
+  delayed_readers.remove(cont);
+}
+
+/*
+   Park a reader until a writer of the entry writes a fragment or closes. If
+   timeout is not zero the reader is also called back when it expires.
+   */
 int
-OpenDirEntry::wait(CacheVC *cont, int msec)
+OpenDirEntry::wait(CacheVC *cont, ink_hrtime timeout)
 {
   ink_assert(cont->vol->mutex->thread_holding == this_ethread());
+  ink_assert(!cont->f.open_read_timeout && !cont->trigger);
   cont->f.open_read_timeout = 1;
-  ink_assert(!cont->trigger);
-  cont->trigger = cont->vol->mutex->thread_holding->schedule_in_local(cont, HRTIME_MSECONDS(msec));
+  cont->opendir_link.next   = nullptr;
+  cont->opendir_link.prev   = nullptr;
+  if (timeout) {
+    cont->trigger = cont->vol->mutex->thread_holding->schedule_in_local(cont, timeout);
+  }
   readers.push(cont);
   return EVENT_CONT;
 }
@@ -209,11 +256,78 @@ dir_bucket_loop_check(Dir *start_dir, Dir *seg)
   return 1;
 }
 
+// The directory is synced to disk in DIR_SYNC_CHUNK sized chunks, and a sync only writes
+// the chunks that changed since the copy it targets was last written. A pending chunk that
+// is about to be modified while a sync is running is saved first, so the sync still writes
+// the directory as it was when the sync started without a full size staging copy.
+
+static inline size_t
+dir_sync_chunk_len(Vol *d, int c)
+{
+  size_t body = d->dirlen() - ROUND_TO_STORE_BLOCK(sizeof(VolHeaderFooter));
+  return std::min(static_cast<size_t>(DIR_SYNC_CHUNK), body - static_cast<size_t>(c) * DIR_SYNC_CHUNK);
+}
+
+static void
+dir_sync_touch(Vol *d, int first, int last)
+{
+  for (int c = first; c <= last; c++) {
+    if ((d->dir_sync_flags[c] & DIR_SYNC_PENDING) && !d->dir_sync_preimage[c]) {
+      size_t l                = dir_sync_chunk_len(d, c);
+      d->dir_sync_preimage[c] = static_cast<char *>(ats_malloc(l));
+      memcpy(d->dir_sync_preimage[c], d->raw_dir + static_cast<size_t>(c) * DIR_SYNC_CHUNK, l);
+    }
+    d->dir_sync_flags[c] |= DIR_SYNC_DIRTY(0) | DIR_SYNC_DIRTY(1);
+  }
+}
+
+void
+dir_sync_init_vol(Vol *d)
+{
+  // The footer is written on its own, the chunks cover the header and the entries.
+  size_t body        = d->dirlen() - ROUND_TO_STORE_BLOCK(sizeof(VolHeaderFooter));
+  d->dir_sync_chunks = (body + DIR_SYNC_CHUNK - 1) / DIR_SYNC_CHUNK;
+  d->dir_sync_flags  = static_cast<uint8_t *>(ats_malloc(d->dir_sync_chunks));
+  memset(d->dir_sync_flags, DIR_SYNC_DIRTY(0) | DIR_SYNC_DIRTY(1), d->dir_sync_chunks);
+  d->dir_sync_preimage = static_cast<char **>(ats_calloc(d->dir_sync_chunks, sizeof(char *)));
+}
+
+// Must be called before the entries of segment s are modified.
+void
+dir_segment_dirty(int s, Vol *d)
+{
+  if (d->dir_sync_flags) {
+    size_t start = reinterpret_cast<char *>(d->dir_segment(s)) - d->raw_dir;
+    size_t end   = start + SIZEOF_DIR * DIR_DEPTH * d->buckets;
+    dir_sync_touch(d, start / DIR_SYNC_CHUNK, (end - 1) / DIR_SYNC_CHUNK);
+  }
+}
+
+// Forget the state of an interrupted sync, everything has to be written again.
+static void
+dir_sync_abort(Vol *d)
+{
+  for (int c = 0; c < d->dir_sync_chunks; c++) {
+    ats_free(d->dir_sync_preimage[c]);
+    d->dir_sync_preimage[c] = nullptr;
+    d->dir_sync_flags[c]    = DIR_SYNC_DIRTY(0) | DIR_SYNC_DIRTY(1);
+  }
+}
+
+void
+dir_all_dirty(Vol *d)
+{
+  if (d->dir_sync_flags) {
+    dir_sync_touch(d, 0, d->dir_sync_chunks - 1);
+  }
+}
+
 // adds all the directory entries
 // in a segment to the segment freelist
 void
 dir_init_segment(int s, Vol *d)
 {
+  dir_segment_dirty(s, d);
   d->header->freelist[s] = 0;
   Dir *seg               = d->dir_segment(s);
   int l, b;
@@ -301,6 +415,7 @@ check_dir(Vol *d)
 inline void
 unlink_from_freelist(Dir *e, int s, Vol *d)
 {
+  dir_segment_dirty(s, d);
   Dir *seg = d->dir_segment(s);
   Dir *p   = dir_from_offset(dir_prev(e), seg);
   if (p) {
@@ -317,6 +432,7 @@ unlink_from_freelist(Dir *e, int s, Vol *d)
 inline Dir *
 dir_delete_entry(Dir *e, Dir *p, int s, Vol *d)
 {
+  dir_segment_dirty(s, d);
   Dir *seg         = d->dir_segment(s);
   int no           = dir_next(e);
   d->header->dirty = 1;
@@ -400,7 +516,8 @@ dir_clear_range(off_t start, off_t end, Vol *vol)
 {
   for (off_t i = 0; i < vol->buckets * DIR_DEPTH * vol->segments; i++) {
     Dir *e = dir_index(vol, i);
-    if (!dir_token(e) && dir_offset(e) >= (int64_t)start && dir_offset(e) < (int64_t)end) {
+    if (dir_offset(e) >= (int64_t)start && dir_offset(e) < (int64_t)end) {
+      dir_segment_dirty(i / (vol->buckets * DIR_DEPTH), vol);
       CACHE_DEC_DIR_USED(vol->mutex);
       dir_set_offset(e, 0); // delete
     }
@@ -429,6 +546,7 @@ freelist_clean(int s, Vol *vol)
     return;
   }
   Warning("cache directory overflow on '%s' segment %d, purging...", vol->path, s);
+  dir_segment_dirty(s, vol);
   int n    = 0;
   Dir *seg = vol->dir_segment(s);
   for (int bi = 0; bi < vol->buckets; bi++) {
@@ -447,6 +565,7 @@ freelist_clean(int s, Vol *vol)
 inline Dir *
 freelist_pop(int s, Vol *d)
 {
+  dir_segment_dirty(s, d);
   Dir *seg = d->dir_segment(s);
   Dir *e   = dir_from_offset(d->header->freelist[s], seg);
   if (!e) {
@@ -522,6 +641,7 @@ dir_segment_accounted(int s, Vol *d, int offby, int *f, int *u, int *et, int *v,
 void
 dir_free_entry(Dir *e, int s, Vol *d)
 {
+  dir_segment_dirty(s, d);
   Dir *seg        = d->dir_segment(s);
   unsigned int fo = d->header->freelist[s];
   unsigned int eo = dir_to_offset(e, seg);
@@ -541,6 +661,8 @@ dir_probe(const CacheKey *key, Vol *d, Dir *result, Dir **last_collision)
   Dir *seg = d->dir_segment(s);
   Dir *e = nullptr, *p = nullptr, *collision = *last_collision;
   Vol *vol = d;
+  dir_prefetch(dir_bucket(b, seg));
+  dir_prefetch(dir_bucket(b, seg) + DIR_DEPTH - 1);
   CHECK_DIR(d);
 #ifdef LOOP_CHECK_MODE
   if (dir_bucket_loop_fix(dir_bucket(b, seg), s, d))
@@ -550,6 +672,8 @@ Lagain:
   e = dir_bucket(b, seg);
   if (dir_offset(e)) {
     do {
+      // Chained entries outside the bucket come from the segment freelist and are likely cold.
+      dir_prefetch(next_dir(e, seg));
       if (dir_compare_tag(e, key)) {
         ink_assert(dir_offset(e));
         // Bug: 51680. Need to check collision before checking
@@ -619,6 +743,7 @@ dir_insert(const CacheKey *key, Vol *d, Dir *to_part)
   }
 #endif
   CHECK_DIR(d);
+  dir_segment_dirty(s, d);
 
 Lagain:
   // get from this row first
@@ -670,6 +795,7 @@ dir_overwrite(const CacheKey *key, Vol *d, Dir *dir, Dir *overwrite, bool must_o
 #endif
   Vol *vol = d;
   CHECK_DIR(d);
+  dir_segment_dirty(s, d);
 
   ink_assert((unsigned int)dir_approx_size(dir) <= (unsigned int)(MAX_FRAG_SIZE + sizeof(Doc))); // XXX - size should be unsigned
 Lagain:
@@ -767,6 +893,17 @@ dir_delete(const CacheKey *key, Vol *d, Dir *del)
   return 0;
 }
 
+// Delete every entry with the tag of @a key, some may be of colliding documents.
+void
+dir_delete_all(const CacheKey *key, Vol *d)
+{
+  Dir dir, *last_collision = nullptr;
+  while (dir_probe(key, d, &dir, &last_collision)) {
+    dir_delete(key, d, &dir);
+    last_collision = nullptr;
+  }
+}
+
 // Lookaside Cache
 
 int
@@ -896,6 +1033,7 @@ CacheSync::aio_write(int fd, char *b, int n, off_t o)
   io.aiocb.aio_buf    = b;
   io.action           = this;
   io.thread           = AIO_CALLBACK_THREAD_ANY;
+  io.io_class         = AIO_CLASS_SYNC;
   ink_assert(ink_aio_write(&io) >= 0);
 }
 
@@ -937,9 +1075,6 @@ void
 sync_cache_dir_on_shutdown()
 {
   Debug("cache_dir_sync", "sync started");
-  char *buf     = nullptr;
-  size_t buflen = 0;
-  bool buf_huge = false;
 
   EThread *t = (EThread *)0xdeadbeef;
   for (int i = 0; i < gnvol; i++) {
@@ -983,26 +1118,6 @@ sync_cache_dir_on_shutdown()
       d->header->write_serial++;
     }
 
-    if (buflen < dirlen) {
-      if (buf) {
-        if (buf_huge) {
-          ats_free_hugepage(buf, buflen);
-        } else {
-          ats_memalign_free(buf);
-        }
-        buf = nullptr;
-      }
-      buflen = dirlen;
-      if (ats_hugepage_enabled()) {
-        buf      = (char *)ats_alloc_hugepage(buflen);
-        buf_huge = true;
-      }
-      if (buf == nullptr) {
-        buf      = (char *)ats_memalign(ats_pagesize(), buflen);
-        buf_huge = false;
-      }
-    }
-
     if (!d->dir_sync_in_progress) {
       d->header->sync_serial++;
     } else {
@@ -1011,22 +1126,23 @@ sync_cache_dir_on_shutdown()
     d->footer->sync_serial = d->header->sync_serial;
 
     CHECK_DIR(d);
-    memcpy(buf, d->raw_dir, dirlen);
+    // The volume stays locked until the process exits, so the directory can be written in place.
     size_t B    = d->header->sync_serial & 1;
-    off_t start = d->skip + (B ? dirlen : 0);
-    B           = pwrite(d->fd, buf, dirlen, start);
+    off_t start = d->dir_pos + (B ? dirlen : 0);
+    B           = pwrite(d->dir_fd, d->raw_dir, dirlen, start);
     ink_assert(B == dirlen);
     Debug("cache_dir_sync", "done syncing dir for vol %s", d->hash_text.get());
   }
-  Debug("cache_dir_sync", "sync done");
-  if (buf) {
-    if (buf_huge) {
-      ats_free_hugepage(buf, buflen);
-    } else {
-      ats_memalign_free(buf);
+
+  // The RAM cache goes with the directory just written, the volumes are still locked.
+  if (cache_config_ram_cache_persist) {
+    for (int i = 0; i < gnvol; i++) {
+      if (gvol[i]->ram_cache && !DISK_BAD(gvol[i]->disk)) {
+        ram_cache_save(gvol[i]);
+      }
     }
-    buf = nullptr;
   }
+  Debug("cache_dir_sync", "sync done");
 }
 
 int
@@ -1040,16 +1156,11 @@ CacheSync::mainEvent(int event, Event *e)
 Lrestart:
   if (vol_idx >= gnvol) {
     vol_idx = 0;
-    if (buf) {
-      if (buf_huge) {
-        ats_free_hugepage(buf, buflen);
-      } else {
-        ats_memalign_free(buf);
-      }
-      buflen   = 0;
-      buf      = nullptr;
-      buf_huge = false;
-    }
+    ats_memalign_free(buf);
+    ats_memalign_free(hdr);
+    buf    = nullptr;
+    hdr    = nullptr;
+    hdrlen = 0;
     Debug("cache_dir_sync", "sync done");
     if (event == EVENT_INTERVAL) {
       trigger = e->ethread->schedule_in(this, HRTIME_SECONDS(cache_config_dir_sync_frequency));
@@ -1091,8 +1202,9 @@ Lrestart:
       goto Ldone;
     }
 
-    int headerlen = ROUND_TO_STORE_BLOCK(sizeof(VolHeaderFooter));
+    int footerlen = ROUND_TO_STORE_BLOCK(sizeof(VolHeaderFooter));
     size_t dirlen = vol->dirlen();
+    size_t B      = vol->header->sync_serial & 1;
     if (!writepos) {
       // start
       Debug("cache_dir_sync", "sync started");
@@ -1116,51 +1228,82 @@ Lrestart:
       }
       Debug("cache_dir_sync", "pos: %" PRIu64 " Dir %s dirty...syncing to disk", vol->header->write_pos, vol->hash_text.get());
       vol->header->dirty = 0;
-      if (buflen < dirlen) {
-        if (buf) {
-          if (buf_huge) {
-            ats_free_hugepage(buf, buflen);
-          } else {
-            ats_memalign_free(buf);
-          }
-          buf = nullptr;
-        }
-        buflen = dirlen;
-        if (ats_hugepage_enabled()) {
-          buf      = (char *)ats_alloc_hugepage(buflen);
-          buf_huge = true;
-        }
-        if (buf == nullptr) {
-          buf      = (char *)ats_memalign(ats_pagesize(), buflen);
-          buf_huge = false;
-        }
+      if (buf == nullptr) {
+        buf = static_cast<char *>(ats_memalign(ats_pagesize(), SYNC_MAX_WRITE));
+      }
+      size_t headerlen = vol->headerlen();
+      if (hdrlen < headerlen + footerlen) {
+        ats_memalign_free(hdr);
+        hdrlen = headerlen + footerlen;
+        hdr    = static_cast<char *>(ats_memalign(ats_pagesize(), hdrlen));
       }
       vol->header->sync_serial++;
       vol->footer->sync_serial = vol->header->sync_serial;
+      B                        = vol->header->sync_serial & 1;
       CHECK_DIR(d);
-      memcpy(buf, vol->raw_dir, dirlen);
+      // The header, freelists included, and the footer change without going through
+      // dir_segment_dirty(), so they are snapshotted whole and always written.
+      memcpy(hdr, vol->raw_dir, headerlen);
+      memcpy(hdr + headerlen, vol->footer, footerlen);
+      int pending = 0;
+      for (int c = 0; c < vol->dir_sync_chunks; c++) {
+        if (vol->dir_sync_flags[c] & DIR_SYNC_PENDING) {
+          // left over from a sync that failed part way, its target copy is unknown now
+          dir_sync_abort(vol);
+          break;
+        }
+      }
+      for (int c = 0; c < vol->dir_sync_chunks; c++) {
+        if ((vol->dir_sync_flags[c] & DIR_SYNC_DIRTY(B)) || static_cast<size_t>(c) * DIR_SYNC_CHUNK < headerlen) {
+          vol->dir_sync_flags[c] = (vol->dir_sync_flags[c] & ~DIR_SYNC_DIRTY(B)) | DIR_SYNC_PENDING;
+          pending++;
+        }
+      }
+      Debug("cache_dir_sync", "Dir %s: %d of %d chunks to write", vol->hash_text.get(), pending, vol->dir_sync_chunks);
       vol->dir_sync_in_progress = true;
+      chunk                     = 0;
     }
-    size_t B    = vol->header->sync_serial & 1;
-    off_t start = vol->skip + (B ? dirlen : 0);
+    off_t start = vol->dir_pos + (B ? dirlen : 0);
 
     if (!writepos) {
-      // write header
-      aio_write(vol->fd, buf + writepos, headerlen, start + writepos);
-      writepos += headerlen;
-    } else if (writepos < (off_t)dirlen - headerlen) {
-      // write part of body
-      int l = SYNC_MAX_WRITE;
-      if (writepos + l > (off_t)dirlen - headerlen) {
-        l = dirlen - headerlen - writepos;
+      // write header, this invalidates the copy until the footer is written
+      aio_write(vol->dir_fd, hdr, footerlen, start);
+      writepos = footerlen;
+      return EVENT_CONT;
+    }
+
+    while (chunk < vol->dir_sync_chunks && !(vol->dir_sync_flags[chunk] & DIR_SYNC_PENDING)) {
+      chunk++;
+    }
+
+    if (chunk < vol->dir_sync_chunks) {
+      // write a run of pending chunks, as they were when the sync started
+      size_t headerlen = vol->headerlen();
+      off_t pos        = static_cast<off_t>(chunk) * DIR_SYNC_CHUNK;
+      size_t l         = 0;
+      while (chunk < vol->dir_sync_chunks && (vol->dir_sync_flags[chunk] & DIR_SYNC_PENDING) &&
+             l + DIR_SYNC_CHUNK <= SYNC_MAX_WRITE) {
+        size_t cl = dir_sync_chunk_len(vol, chunk);
+        if (vol->dir_sync_preimage[chunk]) {
+          memcpy(buf + l, vol->dir_sync_preimage[chunk], cl);
+          ats_free(vol->dir_sync_preimage[chunk]);
+          vol->dir_sync_preimage[chunk] = nullptr;
+        } else {
+          memcpy(buf + l, vol->raw_dir + pos + l, cl);
+        }
+        vol->dir_sync_flags[chunk] &= ~DIR_SYNC_PENDING;
+        l += cl;
+        chunk++;
       }
-      aio_write(vol->fd, buf + writepos, l, start + writepos);
-      writepos += l;
+      if (static_cast<size_t>(pos) < headerlen) {
+        memcpy(buf, hdr + pos, std::min(headerlen - pos, l));
+      }
+      aio_write(vol->dir_fd, buf, l, start + pos);
+      writepos = pos + l;
     } else if (writepos < (off_t)dirlen) {
-      ink_assert(writepos == (off_t)dirlen - headerlen);
       // write footer
-      aio_write(vol->fd, buf + writepos, headerlen, start + writepos);
-      writepos += headerlen;
+      aio_write(vol->dir_fd, hdr + vol->headerlen(), footerlen, start + dirlen - footerlen);
+      writepos = dirlen;
     } else {
       vol->dir_sync_in_progress = false;
       CACHE_INCREMENT_DYN_STAT(cache_directory_sync_count_stat);
@@ -1408,9 +1551,50 @@ dir_corrupt_bucket(Dir *b, int s, Vol *d)
     e = next_dir(e, seg);
   }
   ink_release_assert(e);
+  dir_segment_dirty(s, d);
   dir_set_next(e, dir_to_offset(e, seg));
 }
 
+// Every field of an entry holds its largest value without touching the others, in either layout.
+REGRESSION_TEST(Cache_dir_entry)(RegressionTest *t, int /* atype ATS_UNUSED */, int *status)
+{
+  int64_t const offset = DIR_OFFSET_MAX;
+  uint32_t const tag   = (1 << DIR_TAG_WIDTH) - 1;
+  uint16_t const next  = MAX_ENTRIES_PER_SEGMENT - 1;
+  Dir e;
+
+  *status = REGRESSION_TEST_PASSED;
+  for (int round = 0; round < 2; ++round) {
+    // Set everything in the first round, then clear the offset and tag to see they stay apart.
+    dir_clear(&e);
+    dir_set_offset(&e, offset);
+    dir_set_approx_size(&e, DIR_SIZE_WITH_BLOCK(3));
+    dir_set_tag(&e, tag);
+    dir_set_phase(&e, 1);
+    dir_set_head(&e, 1);
+    dir_set_pinned(&e, 1);
+    dir_set_token(&e, 1);
+    dir_set_next(&e, next);
+    if (round) {
+      dir_set_offset(&e, 0);
+      dir_set_tag(&e, 0);
+    }
+    if (dir_offset(&e) != (round ? 0 : offset) || dir_tag(&e) != (round ? 0 : tag) || dir_next(&e) != next ||
+        dir_approx_size(&e) != DIR_SIZE_WITH_BLOCK(3) || !dir_phase(&e) || !dir_head(&e) || !dir_pinned(&e) || !dir_token(&e)) {
+      rprintf(t, "entry fields overlap in round %d\n", round);
+      *status = REGRESSION_TEST_FAILED;
+    }
+  }
+  // Free entries keep their previous entry where a used one has its tag and flags.
+  dir_clear(&e);
+  dir_set_prev(&e, next);
+  dir_set_next(&e, next);
+  if (dir_prev(&e) != next || dir_next(&e) != next || !dir_is_empty(&e)) {
+    rprintf(t, "free entry fields overlap\n");
+    *status = REGRESSION_TEST_FAILED;
+  }
+}
+
 EXCLUSIVE_REGRESSION_TEST(Cache_dir)(RegressionTest *t, int /* atype ATS_UNUSED */, int *status)
 {
   ink_hrtime ttime;
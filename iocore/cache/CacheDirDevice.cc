@@ -0,0 +1,130 @@
+/** @file
+
+  Device of the stripe directories.
+
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ */
+
+#include "P_Cache.h"
+#include "P_CacheDirDevice.h"
+
+CacheDirDevice *cache_dir_device = nullptr;
+
+bool
+CacheDirDevice::open(Span *span, bool read_only)
+{
+  char path[PATH_NAME_MAX];
+  int opts = read_only ? O_RDONLY : O_RDWR;
+
+  ink_strlcpy(path, span->pathname, sizeof(path));
+  if (!span->file_pathname) {
+    ink_strlcat(path, "/cache.dir", sizeof(path));
+    if (!read_only) {
+      opts |= O_CREAT;
+    }
+  }
+#ifdef O_DIRECT
+  opts |= O_DIRECT;
+#endif
+#ifdef O_DSYNC
+  opts |= O_DSYNC;
+#endif
+
+  fd = ::open(path, opts, 0644);
+  if (fd < 0 && (opts & O_CREAT)) { // Try without O_DIRECT if this is a file on filesystem, e.g. tmpfs.
+    fd = ::open(path, O_RDWR | O_CREAT, 0644);
+  }
+  if (fd < 0) {
+    Warning("unable to open cache directory device '%s': %s", path, strerror(errno));
+    return false;
+  }
+
+  _read_only = read_only;
+  _skip      = ROUND_TO_STORE_BLOCK((span->offset < START_POS ? START_POS + span->alignment : span->offset));
+  _end       = span->blocks * STORE_BLOCK_SIZE;
+  if (!span->file_pathname && !read_only && ftruncate(fd, _end) < 0) {
+    Warning("unable to truncate cache directory device '%s' to %" PRId64 " blocks", path, span->blocks);
+    _end = 0;
+  }
+  if (_skip + static_cast<off_t>(TABLE_SIZE) > _end) {
+    Warning("cache directory device '%s' is too small", path);
+    close(fd);
+    fd = -1;
+    return false;
+  }
+
+  _table = static_cast<Table *>(ats_memalign(ats_pagesize(), TABLE_SIZE));
+  if (pread(fd, _table, TABLE_SIZE, _skip) != static_cast<ssize_t>(TABLE_SIZE) || _table->magic != MAGIC ||
+      _table->version != FORMAT_VERSION || _table->n_entries > MAX_ENTRIES) {
+    Note("initializing cache directory device '%s'", path);
+    memset(static_cast<void *>(_table), 0, TABLE_SIZE);
+    _table->magic       = MAGIC;
+    _table->version     = FORMAT_VERSION;
+    _table->next_offset = _skip + TABLE_SIZE;
+  }
+  Debug("cache_init", "cache directory device '%s': %u directories, %" PRId64 " of %" PRId64 " bytes used", path,
+        _table->n_entries, static_cast<int64_t>(_table->next_offset), static_cast<int64_t>(_end));
+  return true;
+}
+
+off_t
+CacheDirDevice::place(const CryptoHash &hash_id, size_t len, bool &found)
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  Entry *entry = nullptr;
+
+  found = false;
+  for (uint32_t i = 0; i < _table->n_entries; ++i) {
+    if (_table->entries[i].hash_id == hash_id) {
+      entry = &_table->entries[i];
+      break;
+    }
+  }
+  if (entry && entry->len == static_cast<int64_t>(len)) {
+    found = true;
+    return entry->offset;
+  }
+
+  // A new stripe, or one that changed size and whose directory is cleared anyway.
+  int64_t size = 2 * static_cast<int64_t>(len);
+  if (_read_only || _table->next_offset + size > _end || (!entry && _table->n_entries >= MAX_ENTRIES)) {
+    return -1;
+  }
+  Entry saved = entry ? *entry : Entry();
+  if (!entry) {
+    entry = &_table->entries[_table->n_entries++];
+  }
+  entry->hash_id = hash_id;
+  entry->offset  = _table->next_offset;
+  entry->len     = len;
+  _table->next_offset += size;
+
+  if (pwrite(fd, _table, TABLE_SIZE, _skip) != static_cast<ssize_t>(TABLE_SIZE)) {
+    Warning("unable to write the table of the cache directory device: %s", strerror(errno));
+    _table->next_offset -= size;
+    if (saved.len) {
+      *entry = saved;
+    } else {
+      --_table->n_entries;
+    }
+    return -1;
+  }
+  return entry->offset;
+}
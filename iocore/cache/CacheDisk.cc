@@ -64,6 +64,7 @@ CacheDisk::open(char *s, off_t blocks, off_t askip, int ahw_sector_size, int fil
   len                 = blocks;
   io.aiocb.aio_fildes = fd;
   io.action           = this;
+  ink_aio_register_file(fd);
   // determine header size and hence start point by successive approximation
   uint64_t l;
   for (int i = 0; i < 3; i++) {
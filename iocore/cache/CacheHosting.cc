@@ -648,6 +648,8 @@ ConfigVolumes::BuildListFromString(char *config_file_path, char *file_buf)
     CacheType scheme  = CACHE_NONE_TYPE;
     int size          = 0;
     int in_percent    = 0;
+    int fragment_size = 0;
+    bool no_evacuate  = false;
 
     while (true) {
       // skip all blank spaces at beginning of line
@@ -735,6 +737,29 @@ ConfigVolumes::BuildListFromString(char *config_file_path, char *file_buf)
         } else {
           in_percent = 0;
         }
+      } else if (strcasecmp(tmp, "fragment_size") == 0) { // match fragment_size
+        tmp += 14;
+        int64_t value = ink_atoi64(tmp);
+
+        // a fragment is written at once out of the aggregation buffer, it can't be larger
+        if (value <= static_cast<int64_t>(sizeof(Doc)) || value - sizeof(Doc) > MAX_FRAG_SIZE) {
+          err = "Bad fragment size";
+          break;
+        }
+        fragment_size = value;
+        tmp           = end;
+      } else if (strcasecmp(tmp, "evacuate") == 0) { // match evacuate
+        tmp += 9;
+
+        if (!strcasecmp(tmp, "true")) {
+          no_evacuate = false;
+        } else if (!strcasecmp(tmp, "false")) {
+          no_evacuate = true;
+        } else {
+          err = "Bad evacuate value";
+          break;
+        }
+        tmp = end;
       }
 
       // ends here
@@ -757,9 +782,11 @@ ConfigVolumes::BuildListFromString(char *config_file_path, char *file_buf)
       } else {
         configp->in_percent = false;
       }
-      configp->scheme = scheme;
-      configp->size   = size;
-      configp->cachep = nullptr;
+      configp->scheme        = scheme;
+      configp->size          = size;
+      configp->fragment_size = fragment_size;
+      configp->no_evacuate   = no_evacuate;
+      configp->cachep        = nullptr;
       cp_queue.enqueue(configp);
       num_volumes++;
       if (scheme == CACHE_HTTP_TYPE) {
@@ -767,7 +794,8 @@ ConfigVolumes::BuildListFromString(char *config_file_path, char *file_buf)
       } else {
         ink_release_assert(!"Unexpected non-HTTP cache volume");
       }
-      Debug("cache_hosting", "added volume=%d, scheme=%d, size=%d percent=%d", volume_number, scheme, size, in_percent);
+      Debug("cache_hosting", "added volume=%d, scheme=%d, size=%d percent=%d fragment_size=%d evacuate=%d", volume_number, scheme,
+            size, in_percent, fragment_size, !no_evacuate);
     }
 
     tmp = bufTok.iterNext(&i_state);
@@ -27,6 +27,18 @@
 
 extern int cache_config_compatibility_4_2_0_fixup;
 
+// Bytes of the fragments read ahead, in progress or not read yet, bounded by proxy.config.cache.read_ahead.max_memory.
+static std::atomic<int64_t> read_ahead_bytes{0};
+
+// Check if the fast stripe @a fast has a copy of @a key, without waiting for its lock.
+static bool
+tier_probe(Vol *fast, const CacheKey *key, EThread *t)
+{
+  CACHE_TRY_LOCK(lock, fast->mutex, t);
+  Dir dir, *last_collision = nullptr;
+  return lock.is_locked() && dir_probe(key, fast, &dir, &last_collision);
+}
+
 Action *
 Cache::open_read(Continuation *cont, const CacheKey *key, CacheFragType type, const char *hostname, int host_len)
 {
@@ -36,7 +48,8 @@ Cache::open_read(Continuation *cont, const CacheKey *key, CacheFragType type, co
   }
   ink_assert(caches[type] == this);
 
-  Vol *vol = key_to_vol(key, hostname, host_len);
+  Vol *fast_vol = nullptr;
+  Vol *vol      = key_to_vol(key, hostname, host_len, &fast_vol);
   Dir result, *last_collision = nullptr;
   ProxyMutex *mutex = cont->mutex.get();
   OpenDirEntry *od  = nullptr;
@@ -51,6 +64,7 @@ Cache::open_read(Continuation *cont, const CacheKey *key, CacheFragType type, co
       CACHE_INCREMENT_DYN_STAT(c->base_stat + CACHE_STAT_ACTIVE);
       c->first_key = c->key = c->earliest_key = *key;
       c->vol                                  = vol;
+      c->tier_vol                             = fast_vol;
       c->frag_type                            = type;
       c->od                                   = od;
     }
@@ -64,6 +78,10 @@ Cache::open_read(Continuation *cont, const CacheKey *key, CacheFragType type, co
     if (c->od) {
       goto Lwriter;
     }
+    // a document read before may have a copy in the fast tier
+    if (fast_vol && dir_token(&result) && tier_probe(fast_vol, key, mutex->thread_holding)) {
+      goto Lfast;
+    }
     c->dir            = result;
     c->last_collision = last_collision;
     switch (c->do_read_call(&c->key)) {
@@ -75,6 +93,13 @@ Cache::open_read(Continuation *cont, const CacheKey *key, CacheFragType type, co
       return &c->_action;
     }
   }
+Lfast:
+  c->vol      = fast_vol;
+  c->tier_vol = vol;
+  if (c->handleEvent(EVENT_IMMEDIATE, nullptr) == EVENT_DONE) {
+    return ACTION_RESULT_DONE;
+  }
+  return &c->_action;
 Lmiss:
   CACHE_INCREMENT_DYN_STAT(cache_read_failure_stat);
   cont->handleEvent(CACHE_EVENT_OPEN_READ_FAILED, (void *)-ECACHE_NO_DOC);
@@ -102,7 +127,8 @@ Cache::open_read(Continuation *cont, const CacheKey *key, CacheHTTPHdr *request,
   }
   ink_assert(caches[type] == this);
 
-  Vol *vol = key_to_vol(key, hostname, host_len);
+  Vol *fast_vol = nullptr;
+  Vol *vol      = key_to_vol(key, hostname, host_len, &fast_vol);
   Dir result, *last_collision = nullptr;
   ProxyMutex *mutex = cont->mutex.get();
   OpenDirEntry *od  = nullptr;
@@ -114,6 +140,7 @@ Cache::open_read(Continuation *cont, const CacheKey *key, CacheHTTPHdr *request,
       c            = new_CacheVC(cont);
       c->first_key = c->key = c->earliest_key = *key;
       c->vol                                  = vol;
+      c->tier_vol                             = fast_vol;
       c->vio.op                               = VIO::READ;
       c->base_stat                            = cache_read_active_stat;
       CACHE_INCREMENT_DYN_STAT(c->base_stat + CACHE_STAT_ACTIVE);
@@ -134,9 +161,13 @@ Cache::open_read(Continuation *cont, const CacheKey *key, CacheHTTPHdr *request,
       goto Lwriter;
     }
     // hit
+    SET_CONTINUATION_HANDLER(c, &CacheVC::openReadStartHead);
+    // a document read before may have a copy in the fast tier
+    if (fast_vol && dir_token(&result) && tier_probe(fast_vol, key, mutex->thread_holding)) {
+      goto Lfast;
+    }
     c->dir = c->first_dir = result;
     c->last_collision     = last_collision;
-    SET_CONTINUATION_HANDLER(c, &CacheVC::openReadStartHead);
     switch (c->do_read_call(&c->key)) {
     case EVENT_DONE:
       return ACTION_RESULT_DONE;
@@ -146,6 +177,13 @@ Cache::open_read(Continuation *cont, const CacheKey *key, CacheHTTPHdr *request,
       return &c->_action;
     }
   }
+Lfast:
+  c->vol      = fast_vol;
+  c->tier_vol = vol;
+  if (c->handleEvent(EVENT_IMMEDIATE, nullptr) == EVENT_DONE) {
+    return ACTION_RESULT_DONE;
+  }
+  return &c->_action;
 Lmiss:
   CACHE_INCREMENT_DYN_STAT(cache_read_failure_stat);
   cont->handleEvent(CACHE_EVENT_OPEN_READ_FAILED, (void *)-ECACHE_NO_DOC);
@@ -181,6 +219,25 @@ CacheVC::load_http_info(CacheHTTPInfoVector *info, Doc *doc, RefCountObj *block_
   return zret;
 }
 
+/*
+   Wait on cod for its writers to write a fragment or leave, instead of
+   polling them. Returns false if the reader has already waited the
+   read_while_writer retries without the writer making progress.
+   */
+bool
+CacheVC::wait_for_writer(OpenDirEntry *cod)
+{
+  ink_hrtime now = Thread::get_hrtime();
+  if (!writer_wait_until) {
+    writer_wait_until = now + HRTIME_MSECONDS(cache_read_while_writer_retry_delay) * cache_config_read_while_writer_max_retries;
+  }
+  if (now >= writer_wait_until) {
+    return false;
+  }
+  cod->wait(this, writer_wait_until - now);
+  return true;
+}
+
 int
 CacheVC::openReadFromWriterFailure(int event, Event *e)
 {
@@ -315,7 +372,7 @@ CacheVC::openReadFromWriter(int event, Event *e)
   cancel_trigger();
   intptr_t err = ECACHE_DOC_BUSY;
   DDebug("cache_read_agg", "%p: key: %X In openReadFromWriter", this, first_key.slice32(1));
-  if (_action.cancelled) {
+  if (_action.cancelled && !f.open_read_timeout) {
     od = nullptr; // only open for read so no need to close
     return free_CacheVC(this);
   }
@@ -323,7 +380,14 @@ CacheVC::openReadFromWriter(int event, Event *e)
   if (!lock.is_locked()) {
     VC_SCHED_LOCK_RETRY();
   }
-  od = vol->open_read(&first_key); // recheck in case the lock failed
+  vol->open_dir.cancel_wait(this);
+  if (_action.cancelled) {
+    MUTEX_RELEASE(lock);
+    od = nullptr;
+    return free_CacheVC(this);
+  }
+  od                = vol->open_read(&first_key); // recheck in case the lock failed
+  OpenDirEntry *cod = od;
   if (!od) {
     MUTEX_RELEASE(lock);
     write_vc = nullptr;
@@ -344,11 +408,11 @@ CacheVC::openReadFromWriter(int event, Event *e)
       return openReadStartHead(event, e);
     } else if (ret == EVENT_CONT) {
       ink_assert(!write_vc);
-      if (writer_lock_retry < cache_config_read_while_writer_max_retries) {
-        VC_SCHED_WRITER_RETRY();
-      } else {
-        return openReadFromWriterFailure(CACHE_EVENT_OPEN_READ_FAILED, (Event *)-err);
+      // the writer has no headers yet, wait for it to write the first fragment.
+      if (wait_for_writer(cod)) {
+        return EVENT_CONT;
       }
+      return openReadFromWriterFailure(CACHE_EVENT_OPEN_READ_FAILED, (Event *)-err);
     } else {
       ink_assert(write_vc);
     }
@@ -362,8 +426,7 @@ CacheVC::openReadFromWriter(int event, Event *e)
       return openReadStartHead(event, e);
     }
   }
-  OpenDirEntry *cod = od;
-  od                = nullptr;
+  od = nullptr;
   // someone is currently writing the document
   if (write_vc->closed < 0) {
     MUTEX_RELEASE(lock);
@@ -375,14 +438,13 @@ CacheVC::openReadFromWriter(int event, Event *e)
   // allow reading from unclosed writer for http requests only.
   ink_assert(frag_type == CACHE_FRAG_TYPE_HTTP || write_vc->closed);
   if (!write_vc->closed && !write_vc->fragment) {
-    if (!cache_config_read_while_writer || frag_type != CACHE_FRAG_TYPE_HTTP ||
-        writer_lock_retry >= cache_config_read_while_writer_max_retries) {
+    if (!cache_config_read_while_writer || frag_type != CACHE_FRAG_TYPE_HTTP || !wait_for_writer(cod)) {
       MUTEX_RELEASE(lock);
       return openReadFromWriterFailure(CACHE_EVENT_OPEN_READ_FAILED, (Event *)-err);
     }
-    DDebug("cache_read_agg", "%p: key: %X writer: closed:%d, fragment:%d, retry: %d", this, first_key.slice32(1), write_vc->closed,
-           write_vc->fragment, writer_lock_retry);
-    VC_SCHED_WRITER_RETRY();
+    DDebug("cache_read_agg", "%p: key: %X writer: closed:%d, fragment:%d, waiting", this, first_key.slice32(1), write_vc->closed,
+           write_vc->fragment);
+    return EVENT_CONT;
   }
 
   CACHE_TRY_LOCK(writer_lock, write_vc->mutex, mutex->thread_holding);
@@ -537,6 +599,7 @@ CacheVC::openReadClose(int event, Event * /* e ATS_UNUSED */)
   if (!lock.is_locked()) {
     VC_SCHED_LOCK_RETRY();
   }
+  vol->open_dir.cancel_wait(this);
   if (f.hit_evacuate && dir_valid(vol, &first_dir) && closed > 0) {
     if (f.single_fragment) {
       vol->force_evacuate_head(&first_dir, dir_pinned(&first_dir));
@@ -564,6 +627,7 @@ CacheVC::openReadReadDone(int event, Event *e)
     if (!lock.is_locked()) {
       VC_SCHED_LOCK_RETRY();
     }
+    vol->open_dir.cancel_wait(this);
     if (event == AIO_EVENT_DONE && !io.ok()) {
       dir_delete(&earliest_key, vol, &earliest_dir);
       goto Lerror;
@@ -607,9 +671,9 @@ CacheVC::openReadReadDone(int event, Event *e)
         DDebug("cache_read_agg", "%p: key: %X ReadRead writer aborted: %d", this, first_key.slice32(1), (int)vio.ndone);
         goto Lerror;
       }
-      if (writer_lock_retry < cache_config_read_while_writer_max_retries) {
-        DDebug("cache_read_agg", "%p: key: %X ReadRead retrying: %d", this, first_key.slice32(1), (int)vio.ndone);
-        VC_SCHED_WRITER_RETRY(); // wait for writer
+      if (wait_for_writer(vol->open_read(&first_key))) {
+        DDebug("cache_read_agg", "%p: key: %X ReadRead waiting: %d", this, first_key.slice32(1), (int)vio.ndone);
+        return EVENT_CONT;
       } else {
         DDebug("cache_read_agg", "%p: key: %X ReadRead retries exhausted, bailing..: %d", this, first_key.slice32(1),
                (int)vio.ndone);
@@ -759,7 +823,7 @@ Lread : {
     return calluser(VC_EVENT_EOS);
   }
   last_collision    = nullptr;
-  writer_lock_retry = 0;
+  writer_wait_until = 0;
   // if the state machine calls reenable on the callback from the cache,
   // we set up a schedule_imm event. The openReadReadDone discards
   // EVENT_IMMEDIATE events. So, we have to cancel that trigger and set
@@ -770,7 +834,9 @@ Lread : {
     SET_HANDLER(&CacheVC::openReadMain);
     VC_SCHED_LOCK_RETRY();
   }
+  vol->open_dir.cancel_wait(this);
   if (dir_probe(&key, vol, &dir, &last_collision)) {
+    readAhead();
     SET_HANDLER(&CacheVC::openReadReadDone);
     int ret = do_read_call(&key);
     if (ret == EVENT_RETURN) {
@@ -790,9 +856,10 @@ Lread : {
       DDebug("cache_read_agg", "%p: key: %X ReadMain writer aborted: %d", this, first_key.slice32(1), (int)vio.ndone);
       goto Lerror;
     }
-    DDebug("cache_read_agg", "%p: key: %X ReadMain retrying: %d", this, first_key.slice32(1), (int)vio.ndone);
+    DDebug("cache_read_agg", "%p: key: %X ReadMain waiting: %d", this, first_key.slice32(1), (int)vio.ndone);
     SET_HANDLER(&CacheVC::openReadMain);
-    VC_SCHED_WRITER_RETRY();
+    // until the writer writes the next fragment or leaves.
+    return vol->open_read(&first_key)->wait(this, 0);
   }
   if (is_action_tag_set("cache")) {
     ink_release_assert(false);
@@ -1163,6 +1230,14 @@ CacheVC::openReadStartHead(int event, Event *e)
       f.hit_evacuate = 1;
     }
 
+    if (tier_vol) {
+      if (vol->disk->fast_tier) {
+        CACHE_INCREMENT_DYN_STAT(cache_tier_hit_stat);
+      } else {
+        tierRead(doc);
+      }
+    }
+
     first_buf = buf;
     vol->begin_read(this);
 
@@ -1195,6 +1270,14 @@ CacheVC::openReadStartHead(int event, Event *e)
     }
   }
 Ldone:
+  if (tier_vol && vol->disk->fast_tier && err == ECACHE_NO_DOC) {
+    // the copy in the fast tier is gone, read the home stripe
+    vol            = tier_vol;
+    tier_vol       = nullptr;
+    last_collision = nullptr;
+    buf.clear();
+    return handleEvent(EVENT_IMMEDIATE, nullptr);
+  }
   if (!f.lookup) {
     CACHE_INCREMENT_DYN_STAT(cache_read_failure_stat);
     _action.continuation->handleEvent(CACHE_EVENT_OPEN_READ_FAILED, (void *)-err);
@@ -1220,3 +1303,206 @@ Learliest:
   SET_HANDLER(&CacheVC::openReadStartEarliest);
   return openReadStartEarliest(event, e);
 }
+
+/*
+  Track the reads of a document of a tiered volume, @a doc is its head just read from the home
+  stripe, whose lock is held.
+
+  The token bit of the directory entry of the head is set on the first read, once any stale copy
+  in the fast stripe is deleted, so that a copy is only looked for in the fast stripe for an entry
+  with the bit set. A document read again while it has no copy in the fast stripe is copied there,
+  if it is in a single fragment with every alternate. The copies in the fast stripe are overwritten
+  as it cycles like any other, except for those read often enough to be evacuated when hit.
+*/
+void
+CacheVC::tierRead(Doc *doc)
+{
+  Vol *fast = tier_vol;
+  CACHE_TRY_LOCK(lock, fast->mutex, mutex->thread_holding);
+  if (!lock.is_locked()) {
+    return;
+  }
+  if (!dir_token(&dir)) {
+    Dir seen = dir;
+    dir_delete_all(&first_key, fast);
+    dir_set_token(&seen, 1);
+    if (dir_overwrite(&first_key, vol, &seen, &dir)) {
+      dir = seen;
+    }
+    return;
+  }
+  if ((frag_type == CACHE_FRAG_TYPE_HTTP && vector.count() != 1) || fast->round_to_approx_size(dir_approx_size(&dir)) > AGG_SIZE ||
+      fast->agg_todo_size > cache_config_agg_write_backlog) {
+    return;
+  }
+  Dir copy, *last_collision = nullptr;
+  if (dir_probe(&first_key, fast, &copy, &last_collision)) {
+    return;
+  }
+
+  // the document is read again from the disk, the one in memory has its headers unmarshalled
+  CacheVC *c             = new_DocEvacuator(dir_approx_size(&dir), fast);
+  c->first_key           = first_key;
+  c->overwrite_dir       = dir;
+  c->earliest_dir        = dir;
+  c->tier_vol            = vol;
+  c->io.aiocb.aio_fildes = vol->fd;
+  c->io.aiocb.aio_nbytes = dir_approx_size(&dir);
+  c->io.aiocb.aio_offset = vol->vol_offset(&dir);
+  if ((off_t)(c->io.aiocb.aio_offset + c->io.aiocb.aio_nbytes) > (off_t)(vol->skip + vol->len)) {
+    c->io.aiocb.aio_nbytes = vol->skip + vol->len - c->io.aiocb.aio_offset;
+  }
+  c->io.aiocb.aio_buf = c->buf->data();
+  c->io.action        = c;
+  c->io.thread        = AIO_CALLBACK_THREAD_ANY;
+  c->io.io_class      = AIO_CLASS_EVACUATE;
+  SET_CONTINUATION_HANDLER(c, &CacheVC::tierPromoteRead);
+  ink_assert(ink_aio_read(&c->io) >= 0);
+}
+
+int
+CacheReadAhead::handleReadDone(int /* event ATS_UNUSED */, void * /* data ATS_UNUSED */)
+{
+  done = true;
+  if (CacheVC *vc = waiter; vc != nullptr) {
+    // the CacheVC took the read over when it got to it, hand it the fragment as if it had read it
+    vc->buf           = buf;
+    vc->io.aio_result = io.aio_result;
+    destroy();
+    return vc->handleEvent(AIO_EVENT_DONE, nullptr);
+  }
+  if (released) {
+    destroy();
+  }
+  return EVENT_DONE;
+}
+
+void
+CacheReadAhead::release()
+{
+  if (done) {
+    destroy();
+  } else {
+    released = true;
+  }
+}
+
+void
+CacheReadAhead::destroy()
+{
+  read_ahead_bytes.fetch_sub(io.aiocb.aio_nbytes, std::memory_order_relaxed);
+  delete this;
+}
+
+/*
+  Read ahead the fragments that follow the one of key, which the stripe write lock is held for and
+  which is about to be read, so that the disk works on several fragments of an object read
+  sequentially at a time rather than one. Only as many fragments as the reader still wants are read
+  and none while the object comes from the ram cache or from a writer. The reads are kept in
+  read_ahead and picked up by handleRead, those the reader moves past are let go of.
+*/
+void
+CacheVC::readAhead()
+{
+  int depth = std::min(cache_config_read_ahead_fragments, CACHE_READ_AHEAD_MAX);
+  if (depth <= 0 || write_vc || f.doc_from_ram_cache) {
+    readAheadRelease();
+    return;
+  }
+
+  CacheKey keys[CACHE_READ_AHEAD_MAX];
+  Dir dirs[CACHE_READ_AHEAD_MAX];
+  int n        = 0;
+  CacheKey k   = key;
+  int64_t left = std::min<int64_t>(vio.ntodo(), doc_len - vio.ndone) - dir_approx_size(&dir);
+  while (n < depth && left > 0) {
+    Dir *lc = nullptr;
+    next_CacheKey(&k, &k);
+    if (!dir_probe(&k, vol, &dirs[n], &lc)) {
+      break;
+    }
+    left -= dir_approx_size(&dirs[n]);
+    keys[n++] = k;
+  }
+
+  // let go of the fragments that the reader moved past
+  for (auto &ra : read_ahead) {
+    if (ra == nullptr || (ra->key == key && ra->offset == dir_offset(&dir))) {
+      continue;
+    }
+    bool wanted = false;
+    for (int i = 0; i < n && !wanted; ++i) {
+      wanted = ra->key == keys[i] && ra->offset == dir_offset(&dirs[i]);
+    }
+    if (!wanted) {
+      ra->release();
+      ra = nullptr;
+    }
+  }
+
+  for (int i = 0; i < n; ++i) {
+    CacheReadAhead **slot = nullptr;
+    bool found            = false;
+    for (auto &ra : read_ahead) {
+      if (ra == nullptr) {
+        slot = slot ? slot : &ra;
+      } else if (ra->key == keys[i] && ra->offset == dir_offset(&dirs[i])) {
+        found = true;
+      }
+    }
+    if (found || dir_agg_buf_valid(vol, &dirs[i])) {
+      continue;
+    }
+    int64_t nbytes = dir_approx_size(&dirs[i]);
+    if (slot == nullptr ||
+        read_ahead_bytes.fetch_add(nbytes, std::memory_order_relaxed) + nbytes > cache_config_read_ahead_max_memory) {
+      if (slot) {
+        read_ahead_bytes.fetch_sub(nbytes, std::memory_order_relaxed);
+      }
+      break;
+    }
+
+    CacheReadAhead *ra      = new CacheReadAhead(mutex.get());
+    ra->key                 = keys[i];
+    ra->offset              = dir_offset(&dirs[i]);
+    ra->io.aiocb.aio_fildes = vol->fd;
+    ra->io.aiocb.aio_offset = vol->vol_offset(&dirs[i]);
+    ra->io.aiocb.aio_nbytes = nbytes;
+    if ((off_t)(ra->io.aiocb.aio_offset + ra->io.aiocb.aio_nbytes) > (off_t)(vol->skip + vol->len)) {
+      ra->io.aiocb.aio_nbytes = vol->skip + vol->len - ra->io.aiocb.aio_offset;
+      read_ahead_bytes.fetch_sub(nbytes - ra->io.aiocb.aio_nbytes, std::memory_order_relaxed);
+    }
+    ra->buf              = new_IOBufferData(iobuffer_size_to_fit_index(ra->io.aiocb.aio_nbytes, MAX_BUFFER_SIZE_INDEX), MEMALIGNED);
+    ra->io.aiocb.aio_buf = ra->buf->data();
+    ra->io.action        = ra;
+    ra->io.thread        = mutex->thread_holding->tt == DEDICATED ? AIO_CALLBACK_THREAD_ANY : mutex->thread_holding;
+    *slot                = ra;
+    ink_assert(ink_aio_read(&ra->io) >= 0);
+    CACHE_INCREMENT_DYN_STAT(cache_read_ahead_stat);
+  }
+}
+
+// Take the fragment of @a akey at @a offset out of those read ahead, if it is one of them.
+CacheReadAhead *
+CacheVC::readAheadTake(const CacheKey *akey, int64_t offset)
+{
+  for (auto &ra : read_ahead) {
+    if (ra != nullptr && ra->key == *akey && ra->offset == offset) {
+      CacheReadAhead *taken = ra;
+      ra                    = nullptr;
+      return taken;
+    }
+  }
+  return nullptr;
+}
+
+void
+CacheVC::readAheadRelease()
+{
+  for (auto &ra : read_ahead) {
+    if (ra != nullptr) {
+      ra->release();
+      ra = nullptr;
+    }
+  }
+}
@@ -448,9 +448,10 @@ REGRESSION_TEST(cache_disk_replacement_stability)(RegressionTest *t, int level,
   disk.num_errors = 0;
 
   for (int i = 0; i < MAX_VOLS; ++i) {
-    vol_ptrs[i]  = vols + i;
-    vols[i].disk = &disk;
-    vols[i].len  = DEFAULT_STRIPE_SIZE;
+    vol_ptrs[i]    = vols + i;
+    vols[i].disk   = &disk;
+    vols[i].len    = DEFAULT_STRIPE_SIZE;
+    vols[i].online = true;
     snprintf(buff, sizeof(buff), "/dev/sd%c %" PRIu64 ":%" PRIu64, 'a' + i, DEFAULT_SKIP, vols[i].len);
     CryptoContext().hash_immediate(vols[i].hash_id, buff, strlen(buff));
   }
@@ -498,6 +499,86 @@ REGRESSION_TEST(cache_disk_replacement_stability)(RegressionTest *t, int level,
   hr2.vols = nullptr;
 }
 
+// Taking a stripe offline may only move the objects of that stripe, with either assignment.
+REGRESSION_TEST(cache_stripe_failure_stability)(RegressionTest *t, int /* atype ATS_UNUSED */, int *pstatus)
+{
+  static int const NUM_VOLS    = 12;
+  static int const offline_idx = 5;
+  CacheDisk disk;
+  Vol vols[NUM_VOLS];
+  Vol *vol_ptrs[NUM_VOLS];
+  char buff[2048];
+  int saved_assignment = cache_config_stripe_assignment;
+
+  *pstatus        = REGRESSION_TEST_PASSED;
+  disk.num_errors = 0;
+  for (int i = 0; i < NUM_VOLS; ++i) {
+    vol_ptrs[i]    = vols + i;
+    vols[i].disk   = &disk;
+    vols[i].len    = 1024ULL * 1024 * 1024 * (100 + 50 * (i % 3)); // 100G, 150G and 200G stripes
+    snprintf(buff, sizeof(buff), "/dev/sd%c 8192:%" PRIu64, 'a' + i, vols[i].len);
+    CryptoContext().hash_immediate(vols[i].hash_id, buff, strlen(buff));
+  }
+
+  for (int assignment = 0; assignment <= 1; ++assignment) {
+    CacheHostRecord hr;
+    unsigned short *before;
+    int moved = 0, lost = 0;
+
+    cache_config_stripe_assignment = assignment;
+    for (int i = 0; i < NUM_VOLS; ++i) {
+      vols[i].online = true;
+    }
+    hr.vol_hash_table = nullptr;
+    hr.vols           = vol_ptrs;
+    hr.num_vols       = NUM_VOLS;
+    build_vol_hash_table(&hr);
+    before = hr.vol_hash_table;
+    // Keep the first table, the rebuild would otherwise hand it to a delayed free.
+    hr.vol_hash_table = nullptr;
+
+    vols[offline_idx].online = false;
+    build_vol_hash_table(&hr);
+    for (int i = 0; i < VOL_HASH_TABLE_SIZE; ++i) {
+      if (before[i] == offline_idx) {
+        ++lost;
+      } else if (before[i] != hr.vol_hash_table[i]) {
+        ++moved;
+      }
+      if (hr.vol_hash_table[i] == offline_idx) {
+        *pstatus = REGRESSION_TEST_FAILED;
+      }
+    }
+    if (assignment == 1) {
+      // Every stripe should get its share of the buckets, within a few standard deviations.
+      uint64_t total      = 0;
+      int count[NUM_VOLS] = {0};
+      for (int i = 0; i < NUM_VOLS; ++i) {
+        total += vols[i].len;
+      }
+      for (int i = 0; i < VOL_HASH_TABLE_SIZE; ++i) {
+        ++count[before[i]];
+      }
+      for (int i = 0; i < NUM_VOLS; ++i) {
+        double expected = (double)VOL_HASH_TABLE_SIZE * vols[i].len / total;
+        if (fabs(count[i] - expected) > 0.15 * expected) {
+          rprintf(t, "stripe %d got %d buckets, expected %.0f\n", i, count[i], expected);
+          *pstatus = REGRESSION_TEST_FAILED;
+        }
+      }
+    }
+    rprintf(t, "assignment %d: %d buckets of the offline stripe moved, %d others moved\n", assignment, lost, moved);
+    if (moved || !lost) {
+      *pstatus = REGRESSION_TEST_FAILED;
+    }
+    ats_free(before);
+    ats_free(hr.vol_hash_table);
+    hr.vol_hash_table = nullptr;
+    hr.vols           = nullptr;
+  }
+  cache_config_stripe_assignment = saved_assignment;
+}
+
 static double zipf_alpha        = 1.2;
 static int64_t zipf_bucket_size = 1;
 
@@ -667,7 +748,8 @@ REGRESSION_TEST(ram_cache)(RegressionTest *t, int level, int *pstatus)
   for (int s = 20; s <= 28; s += 4) {
     int64_t cache_size = 1LL << s;
     *pstatus           = REGRESSION_TEST_PASSED;
-    if (!test_RamCache(t, new_RamCacheLRU(), "LRU", cache_size) || !test_RamCache(t, new_RamCacheCLFUS(), "CLFUS", cache_size)) {
+    if (!test_RamCache(t, new_RamCacheLRU(), "LRU", cache_size) || !test_RamCache(t, new_RamCacheCLFUS(), "CLFUS", cache_size) ||
+        !test_RamCache(t, new_RamCacheSharded(), "Sharded", cache_size)) {
       *pstatus = REGRESSION_TEST_FAILED;
     }
   }
@@ -276,7 +276,7 @@ Vol::force_evacuate_head(Dir *evac_dir, int pinned)
 void
 Vol::scan_for_pinned_documents()
 {
-  if (cache_config_permit_pinning) {
+  if (cache_config_permit_pinning && !cache_vol->no_evacuate) {
     // we can't evacuate anything between header->write_pos and
     // header->write_pos + AGG_SIZE.
     int ps                = this->offset_to_vol_offset(header->write_pos + AGG_SIZE);
@@ -381,7 +381,7 @@ new_DocEvacuator(int nbytes, Vol *vol)
   ProxyMutex *mutex = vol->mutex.get();
   c->base_stat      = cache_evacuate_active_stat;
   CACHE_INCREMENT_DYN_STAT(c->base_stat + CACHE_STAT_ACTIVE);
-  c->buf          = new_IOBufferData(iobuffer_size_to_index(nbytes, MAX_BUFFER_SIZE_INDEX), MEMALIGNED);
+  c->buf          = new_IOBufferData(iobuffer_size_to_fit_index(nbytes, MAX_BUFFER_SIZE_INDEX), MEMALIGNED);
   c->vol          = vol;
   c->f.evacuator  = 1;
   c->earliest_key = zero_key;
@@ -546,6 +546,54 @@ CacheVC::evacuateDocDone(int /* event ATS_UNUSED */, Event * /* e ATS_UNUSED */)
   return free_CacheVC(this);
 }
 
+// The copy of the document of a tiered volume read from its home stripe, to be written to the fast one.
+int
+CacheVC::tierPromoteRead(int event, Event *e)
+{
+  ink_assert(vol->mutex->thread_holding == this_ethread());
+  cancel_trigger();
+  set_io_not_in_progress();
+  Doc *doc = (Doc *)buf->data();
+  if (!io.ok() || doc->magic != DOC_MAGIC || !(doc->first_key == first_key) || vol->round_to_approx_size(doc->len) > AGG_SIZE) {
+    return free_CacheVC(this);
+  }
+  // behind the writers, there is no hurry
+  agg_len = vol->round_to_approx_size(doc->len);
+  vol->agg_todo_size += agg_len;
+  vol->agg.enqueue(this);
+  SET_HANDLER(&CacheVC::tierPromoteDone);
+  if (!vol->is_io_in_progress()) {
+    return vol->aggWrite(event, e);
+  }
+  return EVENT_CONT;
+}
+
+// The copy is in the aggregation buffer of the fast stripe.
+int
+CacheVC::tierPromoteDone(int /* event ATS_UNUSED */, Event * /* e ATS_UNUSED */)
+{
+  ink_assert(vol->mutex->thread_holding == this_ethread());
+  // the copy is only entered if the document is still where it was read from in the home
+  // stripe, it may have been rewritten, removed or evacuated meanwhile.
+  bool current = false;
+  {
+    CACHE_TRY_LOCK(lock, tier_vol->mutex, mutex->thread_holding);
+    if (lock.is_locked()) {
+      Dir home, *last_collision = nullptr;
+      while (!current && dir_probe(&first_key, tier_vol, &home, &last_collision)) {
+        current = dir_offset(&home) == dir_offset(&earliest_dir) && dir_token(&home);
+      }
+    }
+  }
+  if (current) {
+    dir_set_token(&dir, 0);
+    dir_delete_all(&first_key, vol);
+    dir_insert(&first_key, vol, &dir);
+    CACHE_INCREMENT_DYN_STAT(cache_tier_promote_stat);
+  }
+  return free_CacheVC(this);
+}
+
 static int
 evacuate_fragments(CacheKey *key, CacheKey *earliest_key, int force, Vol *vol)
 {
@@ -727,6 +775,7 @@ Vol::evac_range(off_t low, off_t high, int evac_phase)
       io.aiocb.aio_buf = doc_evacuator->buf->data();
       io.action        = this;
       io.thread        = AIO_CALLBACK_THREAD_ANY;
+      io.io_class      = AIO_CLASS_EVACUATE;
       DDebug("cache_evac", "evac_range evacuating %X %d", (int)dir_tag(&first->dir), (int)dir_offset(&first->dir));
       SET_HANDLER(&Vol::evacuateDocReadDone);
       ink_assert(ink_aio_read(&io) >= 0);
@@ -851,10 +900,7 @@ agg_copy(char *p, CacheVC *vc)
 #endif
     }
     if (cache_config_enable_checksum) {
-      doc->checksum = 0;
-      for (char *b = doc->hdr(); b < (char *)doc + doc->len; b++) {
-        doc->checksum += *b;
-      }
+      doc->checksum = doc->compute_checksum();
     }
     if (vc->frag_type == CACHE_FRAG_TYPE_HTTP && vc->f.single_fragment) {
       ink_assert(doc->hlen);
@@ -1172,6 +1218,11 @@ CacheVC::openWriteCloseHeadDone(int event, Event *e)
       goto Lclose;
     }
     ink_assert(f.use_first_key);
+    if (f.update && !total_len && !f.allow_empty_doc && alternate_index != CACHE_ALT_REMOVED) {
+      // A revalidation only writes the vector, and the resident body if it is below alt_rewrite_max_size.
+      CACHE_INCREMENT_DYN_STAT(cache_update_header_only_stat);
+      CACHE_SUM_DYN_STAT(cache_update_header_only_bytes_stat, agg_len);
+    }
     if (!od->dont_update_directory) {
       if (dir_is_empty(&od->first_dir)) {
         dir_insert(&first_key, vol, &dir);
@@ -1259,6 +1310,9 @@ CacheVC::openWriteCloseDataDone(int event, Event *e)
     fragment++;
     write_pos += write_len;
     dir_insert(&key, vol, &dir);
+    if (od) {
+      vol->open_dir.signal_waiters(od);
+    }
     blocks = iobufferblock_skip(blocks.get(), &offset, &length, write_len);
     next_CacheKey(&key, &key);
     if (length) {
@@ -1355,6 +1409,10 @@ CacheVC::openWriteWriteDone(int event, Event *e)
     ++fragment;
     write_pos += write_len;
     dir_insert(&key, vol, &dir);
+    // readers waiting for this fragment can go on.
+    if (od) {
+      vol->open_dir.signal_waiters(od);
+    }
     DDebug("cache_insert", "WriteDone: %X, %X, %d", key.slice32(0), first_key.slice32(0), write_len);
     blocks = iobufferblock_skip(blocks.get(), &offset, &length, write_len);
     next_CacheKey(&key, &key);
@@ -1366,10 +1424,12 @@ CacheVC::openWriteWriteDone(int event, Event *e)
   return openWriteMain(event, e);
 }
 
+// The fragment size of the volume of @a vol, or the global one.
 static inline int
-target_fragment_size()
+target_fragment_size(const Vol *vol)
 {
-  uint64_t value = cache_config_target_fragment_size - sizeof(Doc);
+  int size       = vol->cache_vol->fragment_size ? vol->cache_vol->fragment_size : cache_config_target_fragment_size;
+  uint64_t value = size - sizeof(Doc);
   ink_release_assert(value <= MAX_FRAG_SIZE);
   return value;
 }
@@ -1421,12 +1481,13 @@ Lagain:
     total_len += avail;
   }
   length = (uint64_t)towrite;
-  if (length > target_fragment_size() && (length < target_fragment_size() + target_fragment_size() / 4)) {
-    write_len = target_fragment_size();
+  int frag_size = target_fragment_size(vol);
+  if (length > frag_size && (length < frag_size + frag_size / 4)) {
+    write_len = frag_size;
   } else {
     write_len = length;
   }
-  bool not_writing = towrite != ntodo && towrite < target_fragment_size();
+  bool not_writing = towrite != ntodo && towrite < frag_size;
   if (!called_user) {
     if (not_writing) {
       called_user = 1;
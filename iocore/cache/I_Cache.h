@@ -40,13 +40,24 @@ static constexpr ts::ModuleVersion CACHE_MODULE_VERSION(1, 0);
 
 #define RAM_CACHE_ALGORITHM_CLFUS 0
 #define RAM_CACHE_ALGORITHM_LRU 1
+#define RAM_CACHE_ALGORITHM_SHARDED 2
 
 #define CACHE_COMPRESSION_NONE 0
 #define CACHE_COMPRESSION_FASTLZ 1
 #define CACHE_COMPRESSION_LIBZ 2
 #define CACHE_COMPRESSION_LIBLZMA 3
-
-enum { RAM_HIT_COMPRESS_NONE = 1, RAM_HIT_COMPRESS_FASTLZ, RAM_HIT_COMPRESS_LIBZ, RAM_HIT_COMPRESS_LIBLZMA, RAM_HIT_LAST_ENTRY };
+#define CACHE_COMPRESSION_LZ4 4
+#define CACHE_COMPRESSION_ZSTD 5
+
+enum {
+  RAM_HIT_COMPRESS_NONE = 1,
+  RAM_HIT_COMPRESS_FASTLZ,
+  RAM_HIT_COMPRESS_LIBZ,
+  RAM_HIT_COMPRESS_LIBLZMA,
+  RAM_HIT_COMPRESS_LZ4,
+  RAM_HIT_COMPRESS_ZSTD,
+  RAM_HIT_LAST_ENTRY
+};
 
 struct CacheVC;
 struct CacheDisk;
@@ -91,6 +102,8 @@ struct CacheProcessor : public Processor {
   Action *open_write(Continuation *cont, int expected_size, const HttpCacheKey *key, CacheHTTPHdr *request, CacheHTTPInfo *old_info,
                      time_t pin_in_cache = (time_t)0, CacheFragType frag_type = CACHE_FRAG_TYPE_HTTP);
   Action *remove(Continuation *cont, const HttpCacheKey *key, CacheFragType frag_type = CACHE_FRAG_TYPE_HTTP);
+  /// Count a miss of @a key, and check if it has missed often enough to be written.
+  bool admit_write(const HttpCacheKey *key);
   Action *link(Continuation *cont, CacheKey *from, CacheKey *to, CacheFragType frag_type = CACHE_FRAG_TYPE_HTTP,
                char *hostname = nullptr, int host_len = 0);
 
@@ -33,7 +33,9 @@
 #define CACHE_ALT_REMOVED -2
 
 static const uint8_t CACHE_DB_MAJOR_VERSION = 24;
-static const uint8_t CACHE_DB_MINOR_VERSION = 2;
+static const uint8_t CACHE_DB_MINOR_VERSION = 3;
+// Doc checksums are a CRC32C from this minor version of CACHE_DB_MAJOR_VERSION on, a byte sum before.
+static const uint8_t CACHE_DB_CRC32C_MINOR_VERSION = 3;
 // This is used in various comparisons because otherwise if the minor version is 0,
 // the compile fails because the condition is always true or false. Running it through
 // VersionNumber prevents that.
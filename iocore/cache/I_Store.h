@@ -75,7 +75,8 @@ struct Span {
   unsigned hw_sector_size = DEFAULT_HW_SECTOR_SIZE;
   unsigned alignment      = 0;
   span_diskid_t disk_id;
-  int forced_volume_num = -1; ///< Force span in to specific volume.
+  int forced_volume_num = -1;    ///< Force span in to specific volume.
+  bool fast_tier        = false; ///< Span is in the fast (SSD) tier of its volumes.
 private:
   bool is_mmapable_internal = false;
 
@@ -259,6 +260,8 @@ struct Store {
   // The number of disks/paths we could actually read and parse.
   unsigned n_disks = 0;
   Span **disk      = nullptr;
+  /// The span of the @c directory line of storage.config, it holds the stripe directories.
+  Span *dir_span = nullptr;
 
   Result read_config();
 
@@ -267,6 +270,8 @@ struct Store {
   /// Additional configuration key values.
   static const char VOLUME_KEY[];
   static const char HASH_BASE_STRING_KEY[];
+  static const char TIER_KEY[];
+  static const char DIRECTORY_KEY[];
 };
 
 // store either free or in the cache, can be stolen for reconfiguration
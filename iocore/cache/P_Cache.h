@@ -37,6 +37,7 @@
 #include "P_CacheDir.h"
 #include "P_RamCache.h"
 #include "P_CacheVol.h"
+#include "P_CacheDirDevice.h"
 #include "P_CacheInternal.h"
 #include "P_CacheHosting.h"
 #include "P_CacheHttp.h"
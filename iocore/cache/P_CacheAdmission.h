@@ -0,0 +1,68 @@
+/** @file
+
+  Admission filter of the cache writes.
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <memory>
+
+#include "tscore/CryptoHash.h"
+
+/** Count-min sketch of the misses of the objects of a stripe.
+
+    An object is only written to the cache once it has missed @c proxy.config.cache.admission.min_hits
+    times, so that objects requested once don't overwrite those requested again. The sketch has
+    @c DEPTH rows of 4 bit counters, as many per row as a sixteenth of the directory entries of the
+    stripe, 16 to a word. An object counts in one counter per row, its count is the smallest of
+    them, and only those are incremented. The counters are halved once there have been ten times as
+    many increments as counters per row, so that the objects that are not requested anymore fade out.
+
+    The counters are updated without a lock, an increment may be lost as the counters are halved.
+ */
+class CacheAdmission
+{
+public:
+  static constexpr int DEPTH     = 4;
+  static constexpr int MAX_COUNT = 15;
+
+  /// Size the sketch for a stripe of @a entries directory entries.
+  void init(int64_t entries);
+
+  /// Count a miss of @a key, return its number of misses so far, this one included.
+  int increment(const CryptoHash &key);
+
+  /// Number of misses of @a key so far.
+  int estimate(const CryptoHash &key) const;
+
+private:
+  static constexpr int COUNTERS_PER_WORD = 16;
+
+  /// Word and shift of the counter of @a key in @a row.
+  std::atomic<uint64_t> &counter(const CryptoHash &key, int row, int &shift) const;
+  void age();
+
+  std::unique_ptr<std::atomic<uint64_t>[]> _words;
+  uint64_t _width  = 0; ///< Counters per row, a power of 2.
+  uint64_t _sample = 0; ///< Increments between two agings.
+  std::atomic<uint64_t> _increments{0};
+};
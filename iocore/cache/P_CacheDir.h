@@ -35,25 +35,39 @@ struct CacheVC;
 
 // Constants
 
+// A compact directory (--enable-compact-cache-dir) has 8 byte entries instead of 10, for volumes of
+// many small objects. It has shorter tags, so more probes read a document that turns out not to be
+// the one looked for, segments of 4096 entries and stripes of at most 1TB.
+#if TS_USE_COMPACT_CACHE_DIR
+#define DIR_TAG_WIDTH 8
+#define SIZEOF_DIR 8
+#define MAX_ENTRIES_PER_SEGMENT (1 << 12)
+#define DIR_OFFSET_BITS 32
+#else
 #define DIR_TAG_WIDTH 12
-#define DIR_MASK_TAG(_t) ((_t) & ((1 << DIR_TAG_WIDTH) - 1))
 #define SIZEOF_DIR 10
+#define MAX_ENTRIES_PER_SEGMENT (1 << 16)
+#define DIR_OFFSET_BITS 40
+#endif
+#define DIR_MASK_TAG(_t) ((_t) & ((1 << DIR_TAG_WIDTH) - 1))
 #define ESTIMATED_OBJECT_SIZE 8000
 
 #define MAX_DIR_SEGMENTS (32 * (1 << 16))
 #define DIR_DEPTH 4
-#define MAX_ENTRIES_PER_SEGMENT (1 << 16)
 #define MAX_BUCKETS_PER_SEGMENT (MAX_ENTRIES_PER_SEGMENT / DIR_DEPTH)
 #define DIR_SIZE_WIDTH 6
 #define DIR_BLOCK_SIZES 4
 #define DIR_BLOCK_SHIFT(_i) (3 * (_i))
 #define DIR_BLOCK_SIZE(_i) (CACHE_BLOCK_SIZE << DIR_BLOCK_SHIFT(_i))
 #define DIR_SIZE_WITH_BLOCK(_i) ((1 << DIR_SIZE_WIDTH) * DIR_BLOCK_SIZE(_i))
-#define DIR_OFFSET_BITS 40
 #define DIR_OFFSET_MAX ((((off_t)1) << DIR_OFFSET_BITS) - 1)
 
 #define SYNC_MAX_WRITE (2 * 1024 * 1024)
 #define SYNC_DELAY HRTIME_MSECONDS(500)
+// Directory sync tracks changes in chunks of this many bytes, a multiple of STORE_BLOCK_SIZE.
+#define DIR_SYNC_CHUNK (256 * 1024)
+#define DIR_SYNC_DIRTY(_copy) (1 << (_copy)) // chunk differs from on disk copy A (0) or B (1)
+#define DIR_SYNC_PENDING 4                   // chunk still has to be written by the running sync
 #define DO_NOT_REMOVE_THIS 0
 
 // Debugging Options
@@ -70,6 +84,15 @@ struct CacheVC;
 #endif
 
 #define dir_index(_e, _i) ((Dir *)((char *)(_e)->dir + (SIZEOF_DIR * (_i))))
+#if TS_USE_COMPACT_CACHE_DIR
+#define dir_assign(_e, _x)   \
+  do {                       \
+    (_e)->w[0] = (_x)->w[0]; \
+    (_e)->w[1] = (_x)->w[1]; \
+    (_e)->w[2] = (_x)->w[2]; \
+    (_e)->w[3] = (_x)->w[3]; \
+  } while (0)
+#else
 #define dir_assign(_e, _x)   \
   do {                       \
     (_e)->w[0] = (_x)->w[0]; \
@@ -78,6 +101,7 @@ struct CacheVC;
     (_e)->w[3] = (_x)->w[3]; \
     (_e)->w[4] = (_x)->w[4]; \
   } while (0)
+#endif
 #define dir_assign_data(_e, _x)         \
   do {                                  \
     unsigned short next = dir_next(_e); \
@@ -93,6 +117,15 @@ struct CacheVC;
   (_d->header->phase == dir_phase(_e) ? vol_in_phase_valid(_d, _e) : vol_out_of_phase_write_valid(_d, _e))
 #define dir_agg_buf_valid(_d, _e) (_d->header->phase == dir_phase(_e) && _d->vol_in_phase_agg_buf_valid(_e))
 #define dir_is_empty(_e) (!dir_offset(_e))
+#if TS_USE_COMPACT_CACHE_DIR
+#define dir_clear(_e) \
+  do {                \
+    (_e)->w[0] = 0;   \
+    (_e)->w[1] = 0;   \
+    (_e)->w[2] = 0;   \
+    (_e)->w[3] = 0;   \
+  } while (0)
+#else
 #define dir_clear(_e) \
   do {                \
     (_e)->w[0] = 0;   \
@@ -101,6 +134,7 @@ struct CacheVC;
     (_e)->w[3] = 0;   \
     (_e)->w[4] = 0;   \
   } while (0)
+#endif
 #define dir_clean(_e) dir_set_offset(_e, 0)
 
 // OpenDir
@@ -134,8 +168,20 @@ struct Dir {
   unsigned int token : 1;        // (2:15)
   unsigned int next : 16;        // (3)
   unsigned int offset_high : 16; // 8GB * 65k = 0.5PB (4)
+  // THE COMPACT DIRECTORY INSTEAD HAS
+  unsigned int offset : 24;     // (0,1:0-7)
+  unsigned int big : 2;         // (1:8-9)
+  unsigned int size : 6;        // (1:10-15)
+  unsigned int offset_mid : 4;  // (2:0-3)
+  unsigned int tag : 8;         // (2:4-11) 256 / 8 entries/bucket = 3%
+  unsigned int phase : 1;       // (2:12)
+  unsigned int head : 1;        // (2:13)
+  unsigned int pinned : 1;      // (2:14)
+  unsigned int token : 1;       // (2:15)
+  unsigned int next : 12;       // (3:0-11) 4096 entries per segment
+  unsigned int offset_high : 4; // (3:12-15) 8GB * 256 = 2TB
 #else
-  uint16_t w[5];
+  uint16_t w[SIZEOF_DIR / sizeof(uint16_t)];
   Dir() { dir_clear(this); }
 #endif
 };
@@ -151,12 +197,31 @@ struct FreeDir {
   unsigned int prev : 16;        // (2)
   unsigned int next : 16;        // (3)
   unsigned int offset_high : 16; // 0: empty
+  // THE COMPACT DIRECTORY INSTEAD HAS
+  unsigned int offset : 24;     // 0: empty
+  unsigned int reserved : 8;
+  unsigned int offset_mid : 4;  // 0: empty
+  unsigned int prev : 12;       // (2:4-15)
+  unsigned int next : 12;       // (3:0-11)
+  unsigned int offset_high : 4; // 0: empty
 #else
-  uint16_t w[5];
+  uint16_t w[SIZEOF_DIR / sizeof(uint16_t)];
   FreeDir() { dir_clear(this); }
 #endif
 };
 
+#if TS_USE_COMPACT_CACHE_DIR
+#define dir_offset(_e)                                                                                                   \
+  ((int64_t)(((uint64_t)(_e)->w[0]) | (((uint64_t)((_e)->w[1] & 0xFF)) << 16) | (((uint64_t)((_e)->w[2] & 0xF)) << 24) | \
+             (((uint64_t)((_e)->w[3] >> 12)) << 28)))
+#define dir_set_offset(_e, _o)                                                     \
+  do {                                                                             \
+    (_e)->w[0] = (uint16_t)_o;                                                     \
+    (_e)->w[1] = (uint16_t)((((_o) >> 16) & 0xFF) | ((_e)->w[1] & 0xFF00));        \
+    (_e)->w[2] = (uint16_t)((((_o) >> 24) & 0xF) | ((_e)->w[2] & 0xFFF0));         \
+    (_e)->w[3] = (uint16_t)(((((_o) >> 28) & 0xF) << 12) | ((_e)->w[3] & 0x0FFF)); \
+  } while (0)
+#else
 #define dir_offset(_e) \
   ((int64_t)(((uint64_t)(_e)->w[0]) | (((uint64_t)((_e)->w[1] & 0xFF)) << 16) | (((uint64_t)(_e)->w[4]) << 24)))
 #define dir_set_offset(_e, _o)                                              \
@@ -165,6 +230,7 @@ struct FreeDir {
     (_e)->w[1] = (uint16_t)((((_o) >> 16) & 0xFF) | ((_e)->w[1] & 0xFF00)); \
     (_e)->w[4] = (uint16_t)((_o) >> 24);                                    \
   } while (0)
+#endif
 #define dir_bit(_e, _w, _b) ((uint32_t)(((_e)->w[_w] >> (_b)) & 1))
 #define dir_set_bit(_e, _w, _b, _v) (_e)->w[_w] = (uint16_t)(((_e)->w[_w] & ~(1 << (_b))) | (((_v) ? 1 : 0) << (_b)))
 #define dir_big(_e) ((uint32_t)((((_e)->w[1]) >> 8) & 0x3))
@@ -194,9 +260,15 @@ struct FreeDir {
      (_s <= DIR_SIZE_WITH_BLOCK(1) ?      \
         ROUND_TO(_s, DIR_BLOCK_SIZE(1)) : \
         (_s <= DIR_SIZE_WITH_BLOCK(2) ? ROUND_TO(_s, DIR_BLOCK_SIZE(2)) : ROUND_TO(_s, DIR_BLOCK_SIZE(3)))))
+#if TS_USE_COMPACT_CACHE_DIR
+#define dir_tag(_e) ((uint32_t)(((_e)->w[2] >> 4) & ((1 << DIR_TAG_WIDTH) - 1)))
+#define dir_set_tag(_e, _t) \
+  (_e)->w[2] = (uint16_t)(((_e)->w[2] & ~(((1 << DIR_TAG_WIDTH) - 1) << 4)) | (((_t) & ((1 << DIR_TAG_WIDTH) - 1)) << 4))
+#else
 #define dir_tag(_e) ((uint32_t)((_e)->w[2] & ((1 << DIR_TAG_WIDTH) - 1)))
 #define dir_set_tag(_e, _t) \
   (_e)->w[2] = (uint16_t)(((_e)->w[2] & ~((1 << DIR_TAG_WIDTH) - 1)) | ((_t) & ((1 << DIR_TAG_WIDTH) - 1)))
+#endif
 #define dir_phase(_e) dir_bit(_e, 2, 12)
 #define dir_set_phase(_e, _v) dir_set_bit(_e, 2, 12, _v)
 #define dir_head(_e) dir_bit(_e, 2, 13)
@@ -205,10 +277,23 @@ struct FreeDir {
 #define dir_set_pinned(_e, _v) dir_set_bit(_e, 2, 14, _v)
 #define dir_token(_e) dir_bit(_e, 2, 15)
 #define dir_set_token(_e, _v) dir_set_bit(_e, 2, 15, _v)
+#if TS_USE_COMPACT_CACHE_DIR
+#define dir_next(_e) ((uint16_t)((_e)->w[3] & 0x0FFF))
+#define dir_set_next(_e, _o) (_e)->w[3] = (uint16_t)(((_e)->w[3] & 0xF000) | ((_o) & 0x0FFF))
+#define dir_prev(_e) ((uint16_t)((_e)->w[2] >> 4))
+#define dir_set_prev(_e, _o) (_e)->w[2] = (uint16_t)(((_e)->w[2] & 0xF) | ((_o) << 4))
+#else
 #define dir_next(_e) (_e)->w[3]
 #define dir_set_next(_e, _o) (_e)->w[3] = (uint16_t)(_o)
 #define dir_prev(_e) (_e)->w[2]
 #define dir_set_prev(_e, _o) (_e)->w[2] = (uint16_t)(_o)
+#endif
+// Hint the CPU to start loading an entry, a bucket (DIR_DEPTH * SIZEOF_DIR bytes) may span two cache lines.
+#if defined(__GNUC__)
+#define dir_prefetch(_e) __builtin_prefetch(_e)
+#else
+#define dir_prefetch(_e)
+#endif
 
 // INKqa11166 - Cache can not store 2 HTTP alternates simultaneously.
 // To allow this, move the vector from the CacheVC to the OpenDirEntry.
@@ -219,7 +304,7 @@ struct FreeDir {
 LINK_FORWARD_DECLARATION(CacheVC, opendir_link) // forward declaration
 struct OpenDirEntry {
   DLL<CacheVC, Link_CacheVC_opendir_link> writers; // list of all the current writers
-  DLL<CacheVC, Link_CacheVC_opendir_link> readers; // list of all the current readers - not used
+  DLL<CacheVC, Link_CacheVC_opendir_link> readers; // readers waiting for the writers to make progress
   CacheHTTPInfoVector vector;                      // Vector for the http document. Each writer
                                                    // maintains a pointer to this vector and
                                                    // writes it down to disk.
@@ -236,7 +321,7 @@ struct OpenDirEntry {
 
   LINK(OpenDirEntry, link);
 
-  int wait(CacheVC *c, int msec);
+  int wait(CacheVC *c, ink_hrtime timeout);
 
   bool
   has_multiple_writers()
@@ -253,16 +338,19 @@ struct OpenDir : public Continuation {
   int close_write(CacheVC *c);
   OpenDirEntry *open_read(const CryptoHash *key);
   int signal_readers(int event, Event *e);
+  void signal_waiters(OpenDirEntry *od);
+  void cancel_wait(CacheVC *c);
 
   OpenDir();
 };
 
 struct CacheSync : public Continuation {
   int vol_idx    = 0;
-  char *buf      = nullptr;
-  size_t buflen  = 0;
-  bool buf_huge  = false;
+  char *buf      = nullptr; // SYNC_MAX_WRITE bytes of staging for the chunks being written
+  char *hdr      = nullptr; // header and footer as of the start of the running sync
+  size_t hdrlen  = 0;
   off_t writepos = 0;
+  int chunk      = 0; // next chunk to consider
   AIOCallbackInternal io;
   Event *trigger        = nullptr;
   ink_hrtime start_time = 0;
@@ -275,11 +363,15 @@ struct CacheSync : public Continuation {
 // Global Functions
 
 void vol_init_dir(Vol *d);
+void dir_sync_init_vol(Vol *d);
+void dir_segment_dirty(int s, Vol *d);
+void dir_all_dirty(Vol *d);
 int dir_token_probe(const CacheKey *, Vol *, Dir *);
 int dir_probe(const CacheKey *, Vol *, Dir *, Dir **);
 int dir_insert(const CacheKey *key, Vol *d, Dir *to_part);
 int dir_overwrite(const CacheKey *key, Vol *d, Dir *to_part, Dir *overwrite, bool must_overwrite = true);
 int dir_delete(const CacheKey *key, Vol *d, Dir *del);
+void dir_delete_all(const CacheKey *key, Vol *d);
 int dir_lookaside_probe(const CacheKey *key, Vol *d, Dir *result, EvacuationBlock **eblock);
 int dir_lookaside_insert(EvacuationBlock *b, Vol *d, Dir *to);
 int dir_lookaside_fixup(const CacheKey *key, Vol *d);
@@ -0,0 +1,86 @@
+/** @file
+
+  Device of the stripe directories.
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ */
+
+#pragma once
+
+#include <mutex>
+
+#include "tscore/CryptoHash.h"
+
+struct Span;
+
+/** A device that holds the directories of the stripes instead of their spans.
+
+    It is the span of the @c directory line of storage.config, typically a small fast device, so that
+    the directories are read at startup and checkpointed without competing with the reads and writes
+    of the objects. It starts with a table of the stripes it holds, by stripe hash, each with the
+    offset of its two directory copies. A stripe is given space the first time it is opened with the
+    device, and the table is written as it is. The spans still reserve the space of the directories,
+    so the stripe layout is the same with or without the device.
+ */
+class CacheDirDevice
+{
+public:
+  /// Open the device of @a span, read only if @a read_only. @return @c false if it can't be used.
+  bool open(Span *span, bool read_only);
+
+  /** Find the directory of the stripe @a hash_id, of @a len bytes per copy, on the device.
+
+      It is allocated if the stripe has none yet, in which case @a found is cleared.
+      @return The offset of the first copy, the second follows it, or -1 if there is no room.
+   */
+  off_t place(const CryptoHash &hash_id, size_t len, bool &found);
+
+  int fd = -1;
+
+private:
+  static constexpr uint32_t MAGIC     = 0xD1CEC0DE;
+  static constexpr size_t TABLE_SIZE  = 1024 * 1024;
+  static constexpr int FORMAT_VERSION = 1;
+
+  struct Entry {
+    CryptoHash hash_id;
+    int64_t offset;
+    int64_t len;
+  };
+
+  struct Table {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t n_entries;
+    uint32_t reserved;
+    int64_t next_offset; ///< Start of the free space.
+    Entry entries[1];
+  };
+
+  static constexpr size_t MAX_ENTRIES = (TABLE_SIZE - sizeof(Table)) / sizeof(Entry) + 1;
+
+  std::mutex _mutex;
+  Table *_table   = nullptr; ///< Aligned for direct I/O.
+  off_t _skip     = 0;       ///< Offset of the table.
+  off_t _end      = 0;       ///< End of the device.
+  bool _read_only = false;
+};
+
+/// The directory device, @c nullptr if there is none.
+extern CacheDirDevice *cache_dir_device;
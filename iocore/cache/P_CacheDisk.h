@@ -100,6 +100,7 @@ struct CacheDisk : public Continuation {
 
   // Extra configuration values
   int forced_volume_num = -1;      ///< Volume number for this disk.
+  bool fast_tier        = false;   ///< Disk is in the fast tier of its volumes.
   ats_scoped_str hash_base_string; ///< Base string for hash seed.
 
   CacheDisk() : Continuation(new_ProxyMutex()) {}
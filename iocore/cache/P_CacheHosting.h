@@ -43,17 +43,20 @@ struct CacheHostRecord {
   {
     ats_free(vols);
     ats_free(vol_hash_table);
+    ats_free(fast_hash_table);
     ats_free(cp);
   }
 
-  CacheType type                 = CACHE_NONE_TYPE;
-  Vol **vols                     = nullptr;
-  int good_num_vols              = 0;
-  int num_vols                   = 0;
-  int num_initialized            = 0;
-  unsigned short *vol_hash_table = nullptr;
-  CacheVol **cp                  = nullptr;
-  int num_cachevols              = 0;
+  CacheType type                  = CACHE_NONE_TYPE;
+  Vol **vols                      = nullptr;
+  int good_num_vols               = 0;
+  int num_vols                    = 0;
+  int num_initialized             = 0;
+  unsigned short *vol_hash_table  = nullptr;
+  /// The stripes of the fast tier, if the record has stripes of both tiers. @a vol_hash_table then only has the others.
+  unsigned short *fast_hash_table = nullptr;
+  CacheVol **cp                   = nullptr;
+  int num_cachevols               = 0;
 
   CacheHostRecord() {}
 };
@@ -172,6 +175,8 @@ struct ConfigVol {
   off_t size;
   bool in_percent;
   int percent;
+  int fragment_size; // 0 for proxy.config.cache.target_fragment_size
+  bool no_evacuate;  // the hit and pinned objects are not evacuated
   CacheVol *cachep;
   LINK(ConfigVol, link);
 };
@@ -84,17 +84,6 @@ struct EvacuationBlock;
 
 #define CONT_SCHED_LOCK_RETRY(_c) _c->mutex->thread_holding->schedule_in_local(_c, HRTIME_MSECONDS(cache_config_mutex_retry_delay))
 
-#define VC_SCHED_WRITER_RETRY()                                           \
-  do {                                                                    \
-    ink_assert(!trigger);                                                 \
-    writer_lock_retry++;                                                  \
-    ink_hrtime _t = HRTIME_MSECONDS(cache_read_while_writer_retry_delay); \
-    if (writer_lock_retry > 2)                                            \
-      _t = HRTIME_MSECONDS(cache_read_while_writer_retry_delay) * 2;      \
-    trigger = mutex->thread_holding->schedule_in_local(this, _t);         \
-    return EVENT_CONT;                                                    \
-  } while (0)
-
 // cache stats definitions
 enum {
   cache_bytes_used_stat,
@@ -105,6 +94,10 @@ enum {
   cache_direntries_used_stat,
   cache_ram_cache_hits_stat,
   cache_ram_cache_misses_stat,
+  cache_ram_cache_compress_in_stat,
+  cache_ram_cache_compress_out_stat,
+  cache_ram_cache_compress_time_stat,
+  cache_ram_cache_decompress_time_stat,
   cache_pread_count_stat,
   cache_percent_full_stat,
   cache_lookup_active_stat,
@@ -120,6 +113,8 @@ enum {
   cache_update_active_stat,
   cache_update_success_stat,
   cache_update_failure_stat,
+  cache_update_header_only_stat,
+  cache_update_header_only_bytes_stat,
   cache_remove_active_stat,
   cache_remove_success_stat,
   cache_remove_failure_stat,
@@ -145,6 +140,12 @@ enum {
   cache_directory_sync_count_stat,
   cache_directory_sync_time_stat,
   cache_directory_sync_bytes_stat,
+  cache_tier_hit_stat,
+  cache_tier_promote_stat,
+  cache_admission_admit_stat,
+  cache_admission_reject_stat,
+  cache_read_ahead_stat,
+  cache_read_ahead_hit_stat,
   /* AIO read/write error counters */
   cache_span_errors_read_stat,
   cache_span_errors_write_stat,
@@ -219,14 +220,46 @@ extern int cache_config_agg_write_backlog;
 extern int cache_config_ram_cache_compress;
 extern int cache_config_ram_cache_compress_percent;
 extern int cache_config_ram_cache_use_seen_filter;
+extern int cache_config_ram_cache_persist;
 extern int cache_config_hit_evacuate_percent;
 extern int cache_config_hit_evacuate_size_limit;
+extern int cache_config_admission_min_hits;
+extern int cache_config_url_hash;
+extern int cache_config_stripe_assignment;
+extern int cache_config_read_ahead_fragments;
+extern int64_t cache_config_read_ahead_max_memory;
 extern int cache_config_force_sector_size;
 extern int cache_config_target_fragment_size;
 extern int cache_config_mutex_retry_delay;
 extern int cache_read_while_writer_retry_delay;
 extern int cache_config_read_while_writer_max_retries;
 
+#define CACHE_READ_AHEAD_MAX 8
+
+struct CacheVC;
+
+/** A fragment read ahead of a CacheVC reading an object, see proxy.config.cache.read_ahead.fragments.
+
+    The read shares the mutex of its CacheVC, which keeps it until it reads that fragment or moves
+    past it. A read the CacheVC lets go of while still in progress frees itself once done.
+ */
+struct CacheReadAhead : public Continuation {
+  explicit CacheReadAhead(ProxyMutex *m) : Continuation(m) { SET_HANDLER(&CacheReadAhead::handleReadDone); }
+
+  int handleReadDone(int event, void *data);
+  /// Let go of the read, it is freed now or once done.
+  void release();
+  void destroy();
+
+  CacheKey key;
+  int64_t offset = 0; ///< Directory offset of the fragment.
+  Ptr<IOBufferData> buf;
+  AIOCallbackInternal io;
+  CacheVC *waiter = nullptr; ///< The CacheVC to hand the fragment to once done.
+  bool done       = false;
+  bool released   = false;
+};
+
 // CacheVC
 struct CacheVC : public CacheVConnection {
   CacheVC();
@@ -301,6 +334,7 @@ struct CacheVC : public CacheVConnection {
   }
 
   bool writer_done();
+  bool wait_for_writer(OpenDirEntry *cod);
   int calluser(int event);
   int callcont(int event);
   int die();
@@ -372,6 +406,13 @@ struct CacheVC : public CacheVConnection {
   int evacuateDocDone(int event, Event *e);
   int evacuateReadHead(int event, Event *e);
 
+  void tierRead(Doc *doc);
+  void readAhead();
+  CacheReadAhead *readAheadTake(const CacheKey *akey, int64_t offset);
+  void readAheadRelease();
+  int tierPromoteRead(int event, Event *e);
+  int tierPromoteDone(int event, Event *e);
+
   void cancel_trigger();
   int64_t get_object_size() override;
   void set_http_info(CacheHTTPInfo *info) override;
@@ -448,7 +489,9 @@ struct CacheVC : public CacheVConnection {
   uint32_t agg_len;      // for communicating with aggWrite
   uint32_t write_serial; // serial of the final write for SYNC
   Vol *vol;
+  Vol *tier_vol; // the other stripe of a tiered volume, the fast one or the home one when reading from the fast one
   Dir *last_collision;
+  CacheReadAhead *read_ahead[CACHE_READ_AHEAD_MAX]; // fragments read ahead of key
   Event *trigger;
   CacheKey *read_key;
   ContinuationHandler save_handler;
@@ -474,6 +517,7 @@ struct CacheVC : public CacheVConnection {
   int header_to_write_len;
   void *header_to_write;
   short writer_lock_retry;
+  ink_hrtime writer_wait_until; // when a reader stops waiting for its writer
   union {
     uint32_t flags;
     struct {
@@ -488,7 +532,7 @@ struct CacheVC : public CacheVConnection {
       unsigned int update : 1;
       unsigned int remove : 1;
       unsigned int remove_aborted_writers : 1;
-      unsigned int open_read_timeout : 1; // UNUSED
+      unsigned int open_read_timeout : 1; // waiting on OpenDirEntry::readers
       unsigned int data_done : 1;
       unsigned int read_from_writer_called : 1;
       unsigned int not_from_ram_cache : 1; // entire object was from ram cache
@@ -535,6 +579,8 @@ extern CacheSync *cacheDirSync;
 // Function Prototypes
 int cache_write(CacheVC *, CacheHTTPInfoVector *);
 int get_alternate_index(CacheHTTPInfoVector *cache_vector, CacheKey key);
+// unmarshal the headers of the fragment doc in buf in place, okay is cleared if they are bad
+void unmarshal_helper(Doc *doc, Ptr<IOBufferData> &buf, int &okay);
 CacheVC *new_DocEvacuator(int nbytes, Vol *d);
 
 // inline Functions
@@ -605,6 +651,7 @@ free_CacheVC(CacheVC *cont)
   if (cont->scan_vol_map) {
     ats_free(cont->scan_vol_map);
   }
+  cont->readAheadRelease();
   memset((char *)&cont->vio, 0, cont->size_to_init);
 #ifdef CACHE_STAT_PAGES
   ink_assert(!cont->stat_link.next && !cont->stat_link.prev);
@@ -1000,11 +1047,12 @@ struct Cache {
                int host_len);
   Action *deref(Continuation *cont, const CacheKey *key, CacheFragType type, const char *hostname, int host_len);
 
-  void vol_initialized(bool result);
+  void vol_initialized(Vol *vol);
 
   int open_done();
 
-  Vol *key_to_vol(const CacheKey *key, const char *hostname, int host_len);
+  /// The stripe of @a key, and in @a fast_vol its stripe in the fast tier if the volume is tiered.
+  Vol *key_to_vol(const CacheKey *key, const char *hostname, int host_len, Vol **fast_vol = nullptr);
 
   Cache() {}
 };
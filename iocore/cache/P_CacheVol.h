@@ -25,6 +25,10 @@
 
 #include <atomic>
 
+#include "tscore/CRC32C.h"
+
+#include "P_CacheAdmission.h"
+
 #define CACHE_BLOCK_SHIFT 9
 #define CACHE_BLOCK_SIZE (1 << CACHE_BLOCK_SHIFT) // 512, smallest sector size
 #define ROUND_TO_STORE_BLOCK(_x) INK_ALIGN((_x), STORE_BLOCK_SIZE)
@@ -33,13 +37,22 @@
 #define ROUND_TO(_x, _y) INK_ALIGN((_x), (_y))
 
 // Vol (volumes)
+#if TS_USE_COMPACT_CACHE_DIR
+// A stripe with a compact directory is not readable by nor with a standard directory, and is cleared.
+#define VOL_MAGIC 0xF1D0C0DE
+#else
 #define VOL_MAGIC 0xF1D0F00D
+#endif
 #define START_BLOCKS 16 // 8k, STORE_BLOCK_SIZE
 #define START_POS ((off_t)START_BLOCKS * CACHE_BLOCK_SIZE)
 #define AGG_SIZE (4 * 1024 * 1024)     // 4MB
 #define AGG_HIGH_WATER (AGG_SIZE / 2)  // 2MB
 #define EVACUATION_SIZE (2 * AGG_SIZE) // 8MB
+#if TS_USE_COMPACT_CACHE_DIR
+#define MAX_VOL_SIZE ((off_t)1024 * 1024 * 1024 * 1024) // the 32 bit offsets of compact entries reach 2TB
+#else
 #define MAX_VOL_SIZE ((off_t)512 * 1024 * 1024 * 1024 * 1024)
+#endif
 #define STORE_BLOCKS_PER_CACHE_BLOCK (STORE_BLOCK_SIZE / CACHE_BLOCK_SIZE)
 #define MAX_VOL_BLOCKS (MAX_VOL_SIZE / CACHE_BLOCK_SIZE)
 #define MAX_FRAG_SIZE (AGG_SIZE - sizeof(Doc)) // true max
@@ -88,7 +101,7 @@ struct VolHeaderFooter {
   uint32_t write_serial;
   uint32_t dirty;
   uint32_t sector_size;
-  uint32_t unused; // pad out to 8 byte boundary
+  uint32_t url_hash; // proxy.config.cache.url_hash of the keys, 0 in the stripes written before it was kept
   uint16_t freelist[1];
 };
 
@@ -123,7 +136,8 @@ struct Vol : public Continuation {
   char *path = nullptr;
   ats_scoped_str hash_text;
   CryptoHash hash_id;
-  int fd = -1;
+  int fd     = -1;
+  int dir_fd = -1; ///< Descriptor of the directory, @a fd unless it is on the directory device.
 
   char *raw_dir           = nullptr;
   Dir *dir                = nullptr;
@@ -135,12 +149,19 @@ struct Vol : public Continuation {
   off_t prev_recover_pos  = 0;
   off_t scan_pos          = 0;
   off_t skip              = 0; // start of headers
+  off_t dir_pos           = 0; // start of headers on dir_fd
   off_t start             = 0; // start of data
   off_t len               = 0;
   off_t data_blocks       = 0;
   int hit_evacuate_window = 0;
   AIOCallbackInternal io;
 
+  // Per DIR_SYNC_CHUNK of raw_dir: DIR_SYNC_* flags, and for pending chunks modified since the
+  // running sync started their content as of that start. See dir_segment_dirty().
+  uint8_t *dir_sync_flags  = nullptr;
+  char **dir_sync_preimage = nullptr;
+  int dir_sync_chunks      = 0;
+
   Queue<CacheVC, Continuation::Link_link> agg;
   Queue<CacheVC, Continuation::Link_link> stat_cache_vcs;
   Queue<CacheVC, Continuation::Link_link> sync;
@@ -156,6 +177,7 @@ struct Vol : public Continuation {
   DLL<EvacuationBlock> *evacuate = nullptr;
   DLL<EvacuationBlock> lookaside[LOOKASIDE_SIZE];
   CacheVC *doc_evacuator = nullptr;
+  CacheAdmission admission; ///< Misses of the objects of this stripe, see proxy.config.cache.admission.min_hits.
 
   VolInitInfo *init_info = nullptr;
 
@@ -169,6 +191,7 @@ struct Vol : public Continuation {
   bool dir_sync_waiting      = false;
   bool dir_sync_in_progress  = false;
   bool writing_end_marker    = false;
+  bool online                = false; // directory loaded, may be picked by the volume hash tables
 
   CacheKey first_fragment_key;
   int64_t first_fragment_offset = 0;
@@ -283,6 +306,8 @@ struct CacheVol {
   int scheme          = 0;
   off_t size          = 0;
   int num_vols        = 0;
+  int fragment_size   = 0;     // target fragment size, 0 for proxy.config.cache.target_fragment_size
+  bool no_evacuate    = false; // the hit and pinned objects are not evacuated
   Vol **vols          = nullptr;
   DiskVol **disk_vols = nullptr;
   LINK(CacheVol, link);
@@ -325,6 +350,7 @@ struct Doc {
   int no_data_in_fragment();
   char *hdr();
   char *data();
+  uint32_t compute_checksum();
 };
 
 // Global Data
@@ -447,6 +473,20 @@ Doc::data()
   return this->hdr() + hlen;
 }
 
+/// The checksum of the header and data, the byte sum of documents written before CRC32C was used.
+TS_INLINE uint32_t
+Doc::compute_checksum()
+{
+  if (v_major < CACHE_DB_MAJOR_VERSION || (v_major == CACHE_DB_MAJOR_VERSION && v_minor < CACHE_DB_CRC32C_MINOR_VERSION)) {
+    uint32_t sum = 0;
+    for (char *b = this->hdr(); b < reinterpret_cast<char *>(this) + len; b++) {
+      sum += *b;
+    }
+    return sum;
+  }
+  return ts::crc32c(this->hdr(), len - sizeof(Doc));
+}
+
 int vol_dir_clear(Vol *d);
 int vol_init(Vol *d, char *s, off_t blocks, off_t skip, bool clear);
 
@@ -503,6 +543,8 @@ Vol::open_read(const CryptoHash *key)
 TS_INLINE int
 Vol::within_hit_evacuate_window(Dir *xdir)
 {
+  if (cache_vol->no_evacuate)
+    return 0;
   off_t oft       = dir_offset(xdir) - 1;
   off_t write_off = (header->write_pos + AGG_SIZE - start) / CACHE_BLOCK_SIZE;
   off_t delta     = oft - write_off;
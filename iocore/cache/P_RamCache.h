@@ -25,6 +25,8 @@
 
 #include "I_Cache.h"
 
+#include <functional>
+
 // Generic Ram Cache interface
 
 struct RamCache {
@@ -34,11 +36,34 @@ struct RamCache {
                   uint32_t auxkey2 = 0)                                                                     = 0;
   virtual int fixup(const CryptoHash *key, uint32_t old_auxkey1, uint32_t old_auxkey2, uint32_t new_auxkey1,
                     uint32_t new_auxkey2)                                                                   = 0;
+  // an entry put with copy set was read back and unmarshalled into data, the cache may keep data and return it
+  // without copying from then on if it will not need the marshalled form again. returns 1 if data was kept
+  virtual int
+  put_unmarshalled(CryptoHash * /* key ATS_UNUSED */, IOBufferData * /* data ATS_UNUSED */, uint32_t /* auxkey1 ATS_UNUSED */,
+                   uint32_t /* auxkey2 ATS_UNUSED */)
+  {
+    return 0;
+  }
   virtual int64_t size() const                                                                              = 0;
+  // call visit with the key and auxkeys of each object held, least recently used first, and its data unless it is only
+  // held compressed. marshalled is set if the data is held as it was put with copy, with its headers marshalled.
+  using Visitor =
+    std::function<void(const CryptoHash &key, uint32_t auxkey1, uint32_t auxkey2, IOBufferData *data, bool marshalled)>;
+  virtual void
+  for_each(const Visitor & /* visit ATS_UNUSED */) const
+  {
+  }
 
   virtual void init(int64_t max_bytes, Vol *vol) = 0;
   virtual ~RamCache(){};
 };
 
+// save the keys of the objects in the RAM cache of vol, which must be locked, to be restored by ram_cache_restore(),
+// and with proxy.config.cache.ram_cache.persist 2 also the objects that can be restored without reading the disk
+void ram_cache_save(Vol *vol);
+// read the objects saved by ram_cache_save() back into the RAM cache of vol, in the background
+void ram_cache_restore(Vol *vol);
+
 RamCache *new_RamCacheLRU();
 RamCache *new_RamCacheCLFUS();
+RamCache *new_RamCacheSharded();
@@ -33,12 +33,19 @@
 #ifdef HAVE_LZMA_H
 #include <lzma.h>
 #endif
+#ifdef HAVE_LZ4_H
+#include <lz4.h>
+#endif
+#ifdef HAVE_ZSTD_H
+#include <zstd.h>
+#endif
 
 #define REQUIRED_COMPRESSION 0.9 // must get to this size or declared incompressible
 #define REQUIRED_SHRINK 0.8      // must get to this size or keep original buffer (with padding)
 #define HISTORY_HYSTERIA 10      // extra temporary history
 #define ENTRY_OVERHEAD 256       // per-entry overhead to consider when computing cache value/size
 #define LZMA_BASE_MEMLIMIT (64 * 1024 * 1024)
+#define ZSTD_LEVEL 3 // zstd's own default, well over libz's ratio at several times its speed
 //#define CHECK_ACOUNTING 1 // very expensive double checking of all sizes
 
 #define REQUEUE_HITS(_h) ((_h) ? ((_h)-1) : 0)
@@ -80,7 +87,9 @@ struct RamCacheCLFUS : public RamCache {
   int put(CryptoHash *key, IOBufferData *data, uint32_t len, bool copy = false, uint32_t auxkey1 = 0,
           uint32_t auxkey2 = 0) override;
   int fixup(const CryptoHash *key, uint32_t old_auxkey1, uint32_t old_auxkey2, uint32_t new_auxkey1, uint32_t new_auxkey2) override;
+  int put_unmarshalled(CryptoHash *key, IOBufferData *data, uint32_t auxkey1, uint32_t auxkey2) override;
   int64_t size() const override;
+  void for_each(const Visitor &visit) const override;
 
   void init(int64_t max_bytes, Vol *vol) override;
 
@@ -122,6 +131,18 @@ RamCacheCLFUS::size() const
   return s;
 }
 
+// Only lru[0] holds objects, lru[1] is the history of the objects seen.
+void
+RamCacheCLFUS::for_each(const Visitor &visit) const
+{
+  forl_LL(RamCacheCLFUSEntry, e, lru[0])
+  {
+    if (e->data) {
+      visit(e->key, e->auxkey1, e->auxkey2, e->flag_bits.compressed ? nullptr : e->data.get(), e->flag_bits.copy);
+    }
+  }
+}
+
 class RamCacheCLFUSCompressor : public Continuation
 {
 public:
@@ -148,6 +169,16 @@ RamCacheCLFUSCompressor::mainEvent(int /* event ATS_UNUSED */, Event *e)
   case CACHE_COMPRESSION_LIBLZMA:
 #ifndef HAVE_LZMA_H
     Warning("lzma not available for RAM cache compression");
+#endif
+    break;
+  case CACHE_COMPRESSION_LZ4:
+#ifndef HAVE_LZ4_H
+    Warning("lz4 not available for RAM cache compression");
+#endif
+    break;
+  case CACHE_COMPRESSION_ZSTD:
+#ifndef HAVE_ZSTD_H
+    Warning("zstd not available for RAM cache compression");
 #endif
     break;
   }
@@ -250,7 +281,8 @@ RamCacheCLFUS::get(CryptoHash *key, Ptr<IOBufferData> *ret_data, uint32_t auxkey
         e->hits++;
         uint32_t ram_hit_state = RAM_HIT_COMPRESS_NONE;
         if (e->flag_bits.compressed) {
-          b = (char *)ats_malloc(e->len);
+          b                = (char *)ats_malloc(e->len);
+          ink_hrtime start = Thread::get_hrtime_updated();
           switch (e->flag_bits.compressed) {
           default:
             goto Lfailed;
@@ -284,7 +316,27 @@ RamCacheCLFUS::get(CryptoHash *key, Ptr<IOBufferData> *ret_data, uint32_t auxkey
             break;
           }
 #endif
+#ifdef HAVE_LZ4_H
+          case CACHE_COMPRESSION_LZ4: {
+            if (LZ4_decompress_safe(e->data->data(), b, e->compressed_len, e->len) != static_cast<int>(e->len)) {
+              goto Lfailed;
+            }
+            ram_hit_state = RAM_HIT_COMPRESS_LZ4;
+            break;
           }
+#endif
+#ifdef HAVE_ZSTD_H
+          case CACHE_COMPRESSION_ZSTD: {
+            static thread_local ZSTD_DCtx *dctx = ZSTD_createDCtx();
+            if (ZSTD_decompressDCtx(dctx, b, e->len, e->data->data(), e->compressed_len) != e->len) {
+              goto Lfailed;
+            }
+            ram_hit_state = RAM_HIT_COMPRESS_ZSTD;
+            break;
+          }
+#endif
+          }
+          CACHE_SUM_DYN_STAT_THREAD(cache_ram_cache_decompress_time_stat, Thread::get_hrtime_updated() - start);
           IOBufferData *data = new_xmalloc_IOBufferData(b, e->len);
           data->_mem_type    = DEFAULT_ALLOC;
           if (!e->flag_bits.copy) { // don't bother if we have to copy anyway
@@ -300,7 +352,7 @@ RamCacheCLFUS::get(CryptoHash *key, Ptr<IOBufferData> *ret_data, uint32_t auxkey
         } else {
           IOBufferData *data = e->data.get();
           if (e->flag_bits.copy) {
-            data = new_IOBufferData(iobuffer_size_to_index(e->len, MAX_BUFFER_SIZE_INDEX), MEMALIGNED);
+            data = new_IOBufferData(iobuffer_size_to_fit_index(e->len, MAX_BUFFER_SIZE_INDEX), MEMALIGNED);
             ::memcpy(data->data(), e->data->data(), e->len);
           }
           (*ret_data) = data;
@@ -417,9 +469,9 @@ RamCacheCLFUS::compress_entries(EThread *thread, int do_at_most)
   }
   float target = (cache_config_ram_cache_compress_percent / 100.0) * objects;
   int n        = 0;
-  char *b = nullptr, *bb = nullptr;
   while (compressed && target > ncompressed) {
     RamCacheCLFUSEntry *e = compressed;
+    char *b               = nullptr;
     if (e->flag_bits.incompressible || e->flag_bits.compressed) {
       goto Lcontinue;
     }
@@ -435,6 +487,9 @@ RamCacheCLFUS::compress_entries(EThread *thread, int do_at_most)
       default:
         goto Lcontinue;
       case CACHE_COMPRESSION_FASTLZ:
+        if (e->len < 16) {
+          goto Lfailed;
+        }
         l = (uint32_t)((double)e->len * 1.05 + 66);
         break;
 #ifdef HAVE_ZLIB_H
@@ -446,22 +501,29 @@ RamCacheCLFUS::compress_entries(EThread *thread, int do_at_most)
       case CACHE_COMPRESSION_LIBLZMA:
         l = e->len;
         break;
+#endif
+#ifdef HAVE_LZ4_H
+      case CACHE_COMPRESSION_LZ4:
+        l = static_cast<uint32_t>(LZ4_compressBound(e->len));
+        break;
+#endif
+#ifdef HAVE_ZSTD_H
+      case CACHE_COMPRESSION_ZSTD:
+        l = static_cast<uint32_t>(ZSTD_compressBound(e->len));
+        break;
 #endif
       }
       // store transient data for lock release
       Ptr<IOBufferData> edata = e->data;
       uint32_t elen           = e->len;
+      uint32_t esize          = e->size;
       CryptoHash key          = e->key;
       MUTEX_UNTAKE_LOCK(vol->mutex, thread);
-      b           = (char *)ats_malloc(l);
-      bool failed = false;
+      b                = (char *)ats_malloc(l);
+      bool failed      = false;
+      ink_hrtime start = Thread::get_hrtime_updated();
       switch (ctype) {
-      default:
-        goto Lfailed;
       case CACHE_COMPRESSION_FASTLZ:
-        if (e->len < 16) {
-          goto Lfailed;
-        }
         if ((l = fastlz_compress(edata->data(), elen, b)) <= 0) {
           failed = true;
         }
@@ -486,14 +548,49 @@ RamCacheCLFUS::compress_entries(EThread *thread, int do_at_most)
         l = (int)pos;
         break;
       }
+#endif
+#ifdef HAVE_LZ4_H
+      case CACHE_COMPRESSION_LZ4: {
+        int ll = LZ4_compress_default(edata->data(), b, elen, l);
+        if (ll <= 0) {
+          failed = true;
+        }
+        l = ll;
+        break;
+      }
+#endif
+#ifdef HAVE_ZSTD_H
+      case CACHE_COMPRESSION_ZSTD: {
+        static thread_local ZSTD_CCtx *cctx = ZSTD_createCCtx();
+        size_t ll                           = ZSTD_compressCCtx(cctx, b, l, edata->data(), elen, ZSTD_LEVEL);
+        if (ZSTD_isError(ll)) {
+          failed = true;
+        }
+        l = ll;
+        break;
+      }
 #endif
       }
+      CACHE_SUM_DYN_STAT_THREAD(cache_ram_cache_compress_time_stat, Thread::get_hrtime_updated() - start);
+      uint32_t compressed_len = l;
+      if (!failed) {
+        CACHE_SUM_DYN_STAT_THREAD(cache_ram_cache_compress_in_stat, elen);
+        CACHE_SUM_DYN_STAT_THREAD(cache_ram_cache_compress_out_stat, l);
+        // Make the buffer to keep before the lock is taken again, so it is only held to swap the data.
+        if (l > REQUIRED_SHRINK * esize) {
+          failed = true;
+        } else if (l < elen) {
+          b = (char *)ats_realloc(b, l);
+        } else {
+          ats_free(b);
+          b = (char *)ats_malloc(elen);
+          memcpy(b, edata->data(), elen);
+          l = elen;
+        }
+      }
       MUTEX_TAKE_LOCK(vol->mutex, thread);
       // see if the entry is till around
       {
-        if (failed) {
-          goto Lfailed;
-        }
         uint32_t i             = key.slice32(3) % nbuckets;
         RamCacheCLFUSEntry *ee = bucket[i].head;
         while (ee) {
@@ -508,34 +605,23 @@ RamCacheCLFUS::compress_entries(EThread *thread, int do_at_most)
           goto Lcontinue;
         }
       }
-      if (l > REQUIRED_COMPRESSION * e->len) {
-        e->flag_bits.incompressible = true;
-      }
-      if (l > REQUIRED_SHRINK * e->size) {
+      if (failed) {
         goto Lfailed;
       }
+      if (compressed_len > REQUIRED_COMPRESSION * e->len) {
+        e->flag_bits.incompressible = true;
+      }
       if (l < e->len) {
-        e->flag_bits.compressed = cache_config_ram_cache_compress;
-        bb                      = (char *)ats_malloc(l);
-        memcpy(bb, b, l);
-        ats_free(b);
-        e->compressed_len = l;
-        int64_t delta     = ((int64_t)l) - (int64_t)e->size;
-        bytes += delta;
-        CACHE_SUM_DYN_STAT_THREAD(cache_ram_cache_bytes_stat, delta);
-        e->size = l;
+        e->flag_bits.compressed = ctype;
+        e->compressed_len       = l;
       } else {
-        ats_free(b);
         e->flag_bits.compressed = 0;
-        bb                      = (char *)ats_malloc(e->len);
-        memcpy(bb, e->data->data(), e->len);
-        int64_t delta = ((int64_t)e->len) - (int64_t)e->size;
-        bytes += delta;
-        CACHE_SUM_DYN_STAT_THREAD(cache_ram_cache_bytes_stat, delta);
-        e->size = e->len;
-        l       = e->len;
       }
-      e->data            = new_xmalloc_IOBufferData(bb, l);
+      int64_t delta = ((int64_t)l) - (int64_t)e->size;
+      bytes += delta;
+      CACHE_SUM_DYN_STAT_THREAD(cache_ram_cache_bytes_stat, delta);
+      e->size            = l;
+      e->data            = new_xmalloc_IOBufferData(b, l);
       e->data->_mem_type = DEFAULT_ALLOC;
       check_accounting(this);
     }
@@ -763,6 +849,34 @@ RamCacheCLFUS::fixup(const CryptoHash *key, uint32_t old_auxkey1, uint32_t old_a
   return 0;
 }
 
+// Entries are copied in and out so that they stay marshalled and can be compressed. Once an entry has been found
+// incompressible it never will be, so it can keep the unmarshalled form and hits share it without a copy or fixups.
+int
+RamCacheCLFUS::put_unmarshalled(CryptoHash *key, IOBufferData *data, uint32_t auxkey1, uint32_t auxkey2)
+{
+  if (!max_bytes) {
+    return 0;
+  }
+  uint32_t i = key->slice32(3) % nbuckets;
+  for (RamCacheCLFUSEntry *e = bucket[i].head; e; e = e->hash_link.next) {
+    if (e->key == *key && e->auxkey1 == auxkey1 && e->auxkey2 == auxkey2) {
+      if (e->flag_bits.lru || !e->flag_bits.copy || !e->flag_bits.incompressible || e->flag_bits.compressed) {
+        return 0;
+      }
+      int64_t delta = ((int64_t)data->block_size()) - (int64_t)e->size;
+      bytes += delta;
+      CACHE_SUM_DYN_STAT_THREAD(cache_ram_cache_bytes_stat, delta);
+      e->size           = data->block_size();
+      e->data           = data;
+      e->flag_bits.copy = 0;
+      check_accounting(this);
+      DDebug("ram_cache", "put %X %d %d size %d UNMARSHALLED", key->slice32(3), auxkey1, auxkey2, e->size);
+      return 1;
+    }
+  }
+  return 0;
+}
+
 RamCache *
 new_RamCacheCLFUS()
 {
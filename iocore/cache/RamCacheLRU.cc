@@ -45,6 +45,7 @@ struct RamCacheLRU : public RamCache {
           uint32_t auxkey2 = 0) override;
   int fixup(const CryptoHash *key, uint32_t old_auxkey1, uint32_t old_auxkey2, uint32_t new_auxkey1, uint32_t new_auxkey2) override;
   int64_t size() const override;
+  void for_each(const Visitor &visit) const override;
 
   void init(int64_t max_bytes, Vol *vol) override;
 
@@ -73,6 +74,15 @@ RamCacheLRU::size() const
   return s;
 }
 
+void
+RamCacheLRU::for_each(const Visitor &visit) const
+{
+  forl_LL(RamCacheLRUEntry, e, lru)
+  {
+    visit(e->key, e->auxkey1, e->auxkey2, e->data.get(), false);
+  }
+}
+
 ClassAllocator<RamCacheLRUEntry> ramCacheLRUEntryAllocator("RamCacheLRUEntry");
 
 static const int bucket_sizes[] = {127,     251,      509,      1021,     2039,      4093,      8191,     16381,
@@ -0,0 +1,287 @@
+/** @file
+
+  Keep the RAM cache of a stripe across a restart.
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ */
+
+// Objects whose headers are held unmarshalled have pointers into themselves and are not written
+// out, only their keys and directory offsets are saved when the directory is synced at shutdown,
+// and the stripe reads them back from the disk into the RAM cache when it comes up again. With
+// proxy.config.cache.ram_cache.persist 2 the objects that are position independent, those held
+// marshalled or without headers, are saved with their bytes and put back without reading the
+// disk. Placing proxy.config.cache.ram_cache.persist_path on tmpfs or a DAX mounted persistent
+// memory file system makes the save and restore run at memory speed. An object is only restored
+// if the directory still has it at the same offset and it is the object, so a stale or foreign
+// file does no harm.
+
+#include "P_Cache.h"
+#include "tscore/I_Layout.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace
+{
+constexpr uint32_t RAM_CACHE_KEYS_MAGIC     = 0x52414d4b; // "RAMK"
+constexpr uint32_t RAM_CACHE_KEYS_VERSION   = 2;          // 1 had only the keys
+constexpr int RAM_CACHE_PROBES_PER_EVENT    = 1024;       // directory probes before letting other events in
+constexpr int64_t RAM_CACHE_BYTES_PER_EVENT = 16 << 20;   // bytes of objects read from the file before letting other events in
+
+struct RamCacheKeysHeader {
+  uint32_t magic;
+  uint32_t version;
+  uint64_t count;
+};
+
+struct RamCacheSavedKey {
+  CryptoHash key;
+  uint32_t auxkey1;
+  uint32_t auxkey2;
+};
+
+// Follows each key from version 2 on, len bytes of the object follow it, none if only the key is saved.
+struct RamCacheSavedData {
+  uint32_t len;
+  uint32_t reserved;
+};
+
+std::string
+ram_cache_keys_path(Vol *vol)
+{
+  char hex[CRYPTO_HEX_SIZE];
+  ats_scoped_str dir;
+  REC_ReadConfigStringAlloc(dir, "proxy.config.cache.ram_cache.persist_path");
+  std::string path = dir && *dir ? Layout::relative_to(RecConfigReadRuntimeDir(), dir.get()) : RecConfigReadRuntimeDir();
+  return path + "/ram_cache." + vol->hash_id.toHexStr(hex);
+}
+
+// Whether the object can be written out and read back as it is held.
+bool
+ram_cache_position_independent(IOBufferData *data, bool marshalled)
+{
+  if (data == nullptr || data->block_size() < static_cast<int64_t>(sizeof(Doc))) {
+    return false;
+  }
+  Doc *doc = reinterpret_cast<Doc *>(data->data());
+  return doc->magic == DOC_MAGIC && doc->len <= static_cast<uint32_t>(data->block_size()) &&
+         (marshalled || doc->doc_type != CACHE_FRAG_TYPE_HTTP || !doc->hlen);
+}
+
+struct RamCacheRestore : public Continuation {
+  Vol *vol;
+  FILE *fp;
+  uint32_t version;
+  uint64_t count;
+  uint64_t next    = 0;
+  size_t restored  = 0;
+  size_t from_file = 0; // restored without reading the disk
+  RamCacheSavedKey saved;
+  AIOCallbackInternal io;
+  Ptr<IOBufferData> buf;
+
+  RamCacheRestore(Vol *v, FILE *f, uint32_t ver, uint64_t n) : Continuation(v->mutex), vol(v), fp(f), version(ver), count(n)
+  {
+    SET_HANDLER(&RamCacheRestore::handle_next);
+  }
+
+  ~RamCacheRestore() override { fclose(fp); }
+
+  // Restore the next object that the directory still has, from the file or by reading it from the disk.
+  int
+  handle_next(int /* event ATS_UNUSED */, void * /* data ATS_UNUSED */)
+  {
+    int64_t bytes = 0;
+    for (int probes = 0; next < count; ++probes) {
+      if (probes >= RAM_CACHE_PROBES_PER_EVENT || bytes >= RAM_CACHE_BYTES_PER_EVENT) {
+        eventProcessor.schedule_imm(this, ET_TASK);
+        return EVENT_CONT;
+      }
+      RamCacheSavedData data = {0, 0};
+      if (fread(&saved, sizeof(saved), 1, fp) != 1 || (version > 1 && fread(&data, sizeof(data), 1, fp) != 1)) {
+        break;
+      }
+      ++next;
+      Dir dir;
+      if (data.len) {
+        bytes += data.len;
+        if (!read_saved(data.len)) {
+          break;
+        }
+        if (find(saved, &dir) && put(data.len)) {
+          ++from_file;
+        }
+        buf = nullptr;
+      } else if (find(saved, &dir)) {
+        read(&dir);
+        return EVENT_CONT;
+      }
+    }
+
+    Note("restored %zu of %" PRIu64 " RAM cache objects of stripe %s, %zu without reading the disk", restored, next,
+         vol->hash_text.get(), from_file);
+    delete this;
+    return EVENT_DONE;
+  }
+
+  int
+  handle_read(int /* event ATS_UNUSED */, void * /* data ATS_UNUSED */)
+  {
+    Dir dir;
+    // The object may have been replaced while it was read.
+    if (io.ok() && find(saved, &dir)) {
+      put(static_cast<uint32_t>(io.aio_result));
+    }
+    buf = nullptr;
+
+    SET_HANDLER(&RamCacheRestore::handle_next);
+    return handle_next(EVENT_NONE, nullptr);
+  }
+
+  // Put the object in buf, of which len bytes are valid, into the RAM cache if it is the saved object.
+  bool
+  put(uint32_t len)
+  {
+    Doc *doc = reinterpret_cast<Doc *>(buf->data());
+    if (len < sizeof(Doc) || doc->magic != DOC_MAGIC || !(doc->first_key == saved.key || doc->key == saved.key) ||
+        doc->len > len || !(doc->doc_type == CACHE_FRAG_TYPE_HTTP || doc->doc_type == CACHE_FRAG_TYPE_NONE)) {
+      return false;
+    }
+    int okay = 1;
+    // Mirror CacheVC::handleReadDone(), the headers are kept marshalled only if the RAM cache compresses.
+    bool copy = cache_config_ram_cache_compress && doc->doc_type == CACHE_FRAG_TYPE_HTTP && doc->hlen;
+    if (!copy && doc->doc_type == CACHE_FRAG_TYPE_HTTP && doc->hlen) {
+      unmarshal_helper(doc, buf, okay);
+    }
+    // The seen filter turns away the first put of an object, this one was in the RAM cache before.
+    if (okay && (vol->ram_cache->put(&saved.key, buf.get(), doc->len, copy, saved.auxkey1, saved.auxkey2) ||
+                 vol->ram_cache->put(&saved.key, buf.get(), doc->len, copy, saved.auxkey1, saved.auxkey2))) {
+      ++restored;
+      return true;
+    }
+    return false;
+  }
+
+  bool
+  find(RamCacheSavedKey &key, Dir *dir)
+  {
+    int64_t o      = (static_cast<int64_t>(key.auxkey1) << 32) | key.auxkey2;
+    Dir *collision = nullptr;
+    while (dir_probe(&key.key, vol, dir, &collision)) {
+      if (dir_offset(dir) == o) {
+        return !dir_agg_buf_valid(vol, dir);
+      }
+    }
+    return false;
+  }
+
+  // Read the len bytes of the saved object that follow its key in the file into buf.
+  bool
+  read_saved(uint32_t len)
+  {
+    if (len > BUFFER_SIZE_FOR_INDEX(MAX_BUFFER_SIZE_INDEX)) {
+      return false;
+    }
+    buf = new_IOBufferData(iobuffer_size_to_fit_index(len, MAX_BUFFER_SIZE_INDEX), MEMALIGNED);
+    return fread(buf->data(), len, 1, fp) == 1;
+  }
+
+  void
+  read(Dir *dir)
+  {
+    size_t n = dir_approx_size(dir);
+    buf      = new_IOBufferData(iobuffer_size_to_fit_index(n, MAX_BUFFER_SIZE_INDEX), MEMALIGNED);
+
+    io.aiocb.aio_fildes = vol->fd;
+    io.aiocb.aio_buf    = buf->data();
+    io.aiocb.aio_offset = vol->vol_offset(dir);
+    io.aiocb.aio_nbytes = n;
+    if (static_cast<off_t>(io.aiocb.aio_offset + io.aiocb.aio_nbytes) > static_cast<off_t>(vol->skip + vol->len)) {
+      io.aiocb.aio_nbytes = vol->skip + vol->len - io.aiocb.aio_offset;
+    }
+    io.action = this;
+    io.thread = AIO_CALLBACK_THREAD_ANY;
+    io.then   = nullptr;
+    SET_HANDLER(&RamCacheRestore::handle_read);
+    ink_assert(ink_aio_read(&io) >= 0);
+  }
+};
+} // namespace
+
+void
+ram_cache_save(Vol *vol)
+{
+  std::string path = ram_cache_keys_path(vol);
+  std::string tmp  = path + ".tmp";
+  FILE *fp         = fopen(tmp.c_str(), "w");
+  if (fp == nullptr) {
+    Warning("unable to save the RAM cache of stripe %s to %s: %s", vol->hash_text.get(), tmp.c_str(), strerror(errno));
+    return;
+  }
+
+  uint64_t count = 0;
+  vol->ram_cache->for_each([&count](const CryptoHash &, uint32_t, uint32_t, IOBufferData *, bool) { ++count; });
+
+  RamCacheKeysHeader header = {RAM_CACHE_KEYS_MAGIC, RAM_CACHE_KEYS_VERSION, count};
+  bool ok                   = fwrite(&header, sizeof(header), 1, fp) == 1;
+  uint64_t objects          = 0;
+  vol->ram_cache->for_each([&](const CryptoHash &key, uint32_t auxkey1, uint32_t auxkey2, IOBufferData *data, bool marshalled) {
+    RamCacheSavedKey saved = {key, auxkey1, auxkey2};
+    RamCacheSavedData len  = {0, 0};
+    if (cache_config_ram_cache_persist == 2 && ram_cache_position_independent(data, marshalled)) {
+      len.len = reinterpret_cast<Doc *>(data->data())->len;
+    }
+    ok = ok && fwrite(&saved, sizeof(saved), 1, fp) == 1 && fwrite(&len, sizeof(len), 1, fp) == 1 &&
+         (!len.len || fwrite(data->data(), len.len, 1, fp) == 1);
+    objects += len.len != 0;
+  });
+  if (fclose(fp) != 0 || !ok || rename(tmp.c_str(), path.c_str()) != 0) {
+    Warning("unable to save the RAM cache of stripe %s to %s: %s", vol->hash_text.get(), path.c_str(), strerror(errno));
+    unlink(tmp.c_str());
+    return;
+  }
+  Debug("ram_cache", "saved %" PRIu64 " RAM cache keys of stripe %s to %s, %" PRIu64 " with their objects", count,
+        vol->hash_text.get(), path.c_str(), objects);
+}
+
+void
+ram_cache_restore(Vol *vol)
+{
+  std::string path = ram_cache_keys_path(vol);
+  FILE *fp         = fopen(path.c_str(), "r");
+  if (fp == nullptr) {
+    return;
+  }
+  // The file is only good for the directory it was saved with.
+  unlink(path.c_str());
+
+  RamCacheKeysHeader header;
+  // The RAM cache can not hold more objects than the directory.
+  uint64_t max_keys = static_cast<uint64_t>(vol->buckets) * vol->segments * DIR_DEPTH;
+  if (fread(&header, sizeof(header), 1, fp) != 1 || header.magic != RAM_CACHE_KEYS_MAGIC || header.version < 1 ||
+      header.version > RAM_CACHE_KEYS_VERSION || header.count == 0 || DISK_BAD(vol->disk)) {
+    fclose(fp);
+    return;
+  }
+  uint64_t count = std::min(header.count, max_keys);
+  Debug("ram_cache", "restoring %" PRIu64 " RAM cache objects of stripe %s", count, vol->hash_text.get());
+  eventProcessor.schedule_imm(new RamCacheRestore(vol, fp, header.version, count), ET_TASK);
+}
@@ -0,0 +1,318 @@
+/** @file
+
+  A RAM cache split into independently locked shards.
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ */
+
+// The key space is split into shards, each with its own lock, hash index, seen filter
+// and CLOCK replacement queue, so the cache is safe to use without the Vol mutex and
+// concurrent lookups only contend when they land in the same shard. A hit only sets
+// the entry's reference bit, the queue is reordered lazily on eviction, which keeps
+// the critical section of a hit down to the bucket walk.
+
+#include "P_Cache.h"
+
+struct RamCacheShardedEntry {
+  CryptoHash key;
+  uint32_t auxkey1;
+  uint32_t auxkey2;
+  bool referenced;
+  LINK(RamCacheShardedEntry, lru_link);
+  LINK(RamCacheShardedEntry, hash_link);
+  Ptr<IOBufferData> data;
+};
+
+#define ENTRY_OVERHEAD 128 // per-entry overhead to consider when computing sizes
+
+#define RAM_CACHE_MAX_SHARDS 64
+#define RAM_CACHE_MIN_SHARD_BYTES (4 * 1024 * 1024)
+
+struct RamCacheShard {
+  ink_mutex mutex;
+  int64_t max_bytes = 0;
+  int64_t bytes     = 0;
+  int64_t objects   = 0;
+  uint16_t *seen    = nullptr;
+  Que(RamCacheShardedEntry, lru_link) lru;
+  DList(RamCacheShardedEntry, hash_link) *bucket = nullptr;
+  int nbuckets                                   = 0;
+  int ibuckets                                   = 0;
+};
+
+struct RamCacheSharded : public RamCache {
+  // returns 1 on found/stored, 0 on not found/stored, if provided auxkey1 and auxkey2 must match
+  int get(CryptoHash *key, Ptr<IOBufferData> *ret_data, uint32_t auxkey1 = 0, uint32_t auxkey2 = 0) override;
+  int put(CryptoHash *key, IOBufferData *data, uint32_t len, bool copy = false, uint32_t auxkey1 = 0,
+          uint32_t auxkey2 = 0) override;
+  int fixup(const CryptoHash *key, uint32_t old_auxkey1, uint32_t old_auxkey2, uint32_t new_auxkey1, uint32_t new_auxkey2) override;
+  int64_t size() const override;
+  void for_each(const Visitor &visit) const override;
+
+  void init(int64_t max_bytes, Vol *vol) override;
+
+  // private
+  RamCacheShard *shards = nullptr;
+  int nshards           = 0;
+  Vol *vol              = nullptr;
+
+  RamCacheShard *
+  shard_for(const CryptoHash *key) const
+  {
+    // The buckets hash on slice32(3), pick the shard from independent bits.
+    return &shards[key->slice32(1) & (nshards - 1)];
+  }
+
+  void resize_hashtable(RamCacheShard *s);
+  RamCacheShardedEntry *remove(RamCacheShard *s, RamCacheShardedEntry *e);
+  void evict(RamCacheShard *s);
+};
+
+int64_t
+RamCacheSharded::size() const
+{
+  int64_t s = 0;
+  for (int i = 0; i < nshards; i++) {
+    ink_scoped_mutex_lock lock(shards[i].mutex);
+    forl_LL(RamCacheShardedEntry, e, shards[i].lru)
+    {
+      s += sizeof(*e);
+      s += sizeof(*e->data);
+      s += e->data->block_size();
+    }
+  }
+  return s;
+}
+
+void
+RamCacheSharded::for_each(const Visitor &visit) const
+{
+  for (int i = 0; i < nshards; i++) {
+    ink_scoped_mutex_lock lock(shards[i].mutex);
+    forl_LL(RamCacheShardedEntry, e, shards[i].lru)
+    {
+      visit(e->key, e->auxkey1, e->auxkey2, e->data.get(), false);
+    }
+  }
+}
+
+ClassAllocator<RamCacheShardedEntry> ramCacheShardedEntryAllocator("RamCacheShardedEntry");
+
+static const int bucket_sizes[] = {127,     251,      509,      1021,     2039,      4093,      8191,     16381,
+                                   32749,   65521,    131071,   262139,   524287,    1048573,   2097143,  4194301,
+                                   8388593, 16777213, 33554393, 67108859, 134217689, 268435399, 536870909};
+
+void
+RamCacheSharded::resize_hashtable(RamCacheShard *s)
+{
+  int anbuckets = bucket_sizes[s->ibuckets];
+  DDebug("ram_cache", "resize hashtable %d", anbuckets);
+  int64_t sz                                         = anbuckets * sizeof(DList(RamCacheShardedEntry, hash_link));
+  DList(RamCacheShardedEntry, hash_link) *new_bucket = (DList(RamCacheShardedEntry, hash_link) *)ats_malloc(sz);
+  memset(static_cast<void *>(new_bucket), 0, sz);
+  if (s->bucket) {
+    for (int64_t i = 0; i < s->nbuckets; i++) {
+      RamCacheShardedEntry *e = nullptr;
+      while ((e = s->bucket[i].pop())) {
+        new_bucket[e->key.slice32(3) % anbuckets].push(e);
+      }
+    }
+    ats_free(s->bucket);
+  }
+  s->bucket   = new_bucket;
+  s->nbuckets = anbuckets;
+  ats_free(s->seen);
+  s->seen = nullptr;
+  if (cache_config_ram_cache_use_seen_filter) {
+    int size = anbuckets * sizeof(uint16_t);
+    s->seen  = (uint16_t *)ats_malloc(size);
+    memset(s->seen, 0, size);
+  }
+}
+
+void
+RamCacheSharded::init(int64_t abytes, Vol *avol)
+{
+  vol = avol;
+  DDebug("ram_cache", "initializing ram_cache %" PRId64 " bytes", abytes);
+  if (!abytes) {
+    return;
+  }
+
+  // Keep shards big enough that per shard eviction still approximates a global LRU.
+  nshards = 1;
+  while (nshards < RAM_CACHE_MAX_SHARDS && abytes / (nshards * 2) >= RAM_CACHE_MIN_SHARD_BYTES) {
+    nshards *= 2;
+  }
+  shards = new RamCacheShard[nshards];
+  for (int i = 0; i < nshards; i++) {
+    ink_mutex_init(&shards[i].mutex);
+    shards[i].max_bytes = abytes / nshards;
+    resize_hashtable(&shards[i]);
+  }
+  Debug("ram_cache", "sharded ram_cache %" PRId64 " bytes in %d shards", abytes, nshards);
+}
+
+int
+RamCacheSharded::get(CryptoHash *key, Ptr<IOBufferData> *ret_data, uint32_t auxkey1, uint32_t auxkey2)
+{
+  if (!nshards) {
+    return 0;
+  }
+  RamCacheShard *s = shard_for(key);
+  bool hit         = false;
+  {
+    ink_scoped_mutex_lock lock(s->mutex);
+    uint32_t i              = key->slice32(3) % s->nbuckets;
+    RamCacheShardedEntry *e = s->bucket[i].head;
+    while (e) {
+      if (e->key == *key && e->auxkey1 == auxkey1 && e->auxkey2 == auxkey2) {
+        e->referenced = true;
+        (*ret_data)   = e->data;
+        hit           = true;
+        break;
+      }
+      e = e->hash_link.next;
+    }
+  }
+  if (hit) {
+    DDebug("ram_cache", "get %X %d %d HIT", key->slice32(3), auxkey1, auxkey2);
+    CACHE_SUM_DYN_STAT_THREAD(cache_ram_cache_hits_stat, 1);
+    return 1;
+  }
+  DDebug("ram_cache", "get %X %d %d MISS", key->slice32(3), auxkey1, auxkey2);
+  CACHE_SUM_DYN_STAT_THREAD(cache_ram_cache_misses_stat, 1);
+  return 0;
+}
+
+// Must be called with the shard lock held.
+RamCacheShardedEntry *
+RamCacheSharded::remove(RamCacheShard *s, RamCacheShardedEntry *e)
+{
+  RamCacheShardedEntry *ret = e->hash_link.next;
+  uint32_t b                = e->key.slice32(3) % s->nbuckets;
+  s->bucket[b].remove(e);
+  s->lru.remove(e);
+  s->bytes -= ENTRY_OVERHEAD + e->data->block_size();
+  CACHE_SUM_DYN_STAT_THREAD(cache_ram_cache_bytes_stat, -(ENTRY_OVERHEAD + e->data->block_size()));
+  DDebug("ram_cache", "put %X %d %d FREED", e->key.slice32(3), e->auxkey1, e->auxkey2);
+  e->data = nullptr;
+  THREAD_FREE(e, ramCacheShardedEntryAllocator, this_thread());
+  s->objects--;
+  return ret;
+}
+
+// Second chance eviction, must be called with the shard lock held.
+void
+RamCacheSharded::evict(RamCacheShard *s)
+{
+  while (s->bytes > s->max_bytes) {
+    RamCacheShardedEntry *e = s->lru.head;
+    if (!e) {
+      break;
+    }
+    if (e->referenced) {
+      e->referenced = false;
+      s->lru.remove(e);
+      s->lru.enqueue(e);
+    } else {
+      remove(s, e);
+    }
+  }
+}
+
+// ignore 'copy' since we don't touch the data
+int
+RamCacheSharded::put(CryptoHash *key, IOBufferData *data, uint32_t len, bool, uint32_t auxkey1, uint32_t auxkey2)
+{
+  if (!nshards) {
+    return 0;
+  }
+  RamCacheShard *s = shard_for(key);
+  ink_scoped_mutex_lock lock(s->mutex);
+  uint32_t i = key->slice32(3) % s->nbuckets;
+  if (s->seen) {
+    uint16_t k  = key->slice32(3) >> 16;
+    uint16_t kk = s->seen[i];
+    s->seen[i]  = k;
+    if ((kk != (uint16_t)k)) {
+      DDebug("ram_cache", "put %X %d %d len %d UNSEEN", key->slice32(3), auxkey1, auxkey2, len);
+      return 0;
+    }
+  }
+  RamCacheShardedEntry *e = s->bucket[i].head;
+  while (e) {
+    if (e->key == *key) {
+      if (e->auxkey1 == auxkey1 && e->auxkey2 == auxkey2) {
+        e->referenced = true;
+        return 1;
+      } else { // discard when aux keys conflict
+        e = remove(s, e);
+        continue;
+      }
+    }
+    e = e->hash_link.next;
+  }
+  e             = THREAD_ALLOC(ramCacheShardedEntryAllocator, this_ethread());
+  e->key        = *key;
+  e->auxkey1    = auxkey1;
+  e->auxkey2    = auxkey2;
+  e->referenced = false;
+  e->data       = data;
+  s->bucket[i].push(e);
+  s->lru.enqueue(e);
+  s->bytes += ENTRY_OVERHEAD + data->block_size();
+  s->objects++;
+  CACHE_SUM_DYN_STAT_THREAD(cache_ram_cache_bytes_stat, ENTRY_OVERHEAD + data->block_size());
+  evict(s);
+  DDebug("ram_cache", "put %X %d %d INSERTED", key->slice32(3), auxkey1, auxkey2);
+  if (s->objects > s->nbuckets) {
+    ++s->ibuckets;
+    resize_hashtable(s);
+  }
+  return 1;
+}
+
+int
+RamCacheSharded::fixup(const CryptoHash *key, uint32_t old_auxkey1, uint32_t old_auxkey2, uint32_t new_auxkey1,
+                       uint32_t new_auxkey2)
+{
+  if (!nshards) {
+    return 0;
+  }
+  RamCacheShard *s = shard_for(key);
+  ink_scoped_mutex_lock lock(s->mutex);
+  uint32_t i              = key->slice32(3) % s->nbuckets;
+  RamCacheShardedEntry *e = s->bucket[i].head;
+  while (e) {
+    if (e->key == *key && e->auxkey1 == old_auxkey1 && e->auxkey2 == old_auxkey2) {
+      e->auxkey1 = new_auxkey1;
+      e->auxkey2 = new_auxkey2;
+      return 1;
+    }
+    e = e->hash_link.next;
+  }
+  return 0;
+}
+
+RamCache *
+new_RamCacheSharded()
+{
+  return new RamCacheSharded;
+}
@@ -39,6 +39,8 @@
 
 const char Store::VOLUME_KEY[]           = "volume";
 const char Store::HASH_BASE_STRING_KEY[] = "id";
+const char Store::TIER_KEY[]             = "tier";
+const char Store::DIRECTORY_KEY[]        = "directory";
 
 static span_error_t
 make_span_error(int error)
@@ -260,6 +262,8 @@ Store::delete_all()
   n_disks = 0;
   ats_free(disk);
   disk = nullptr;
+  delete dir_span;
+  dir_span = nullptr;
 }
 
 Store::~Store()
@@ -366,6 +370,8 @@ Store::read_config()
 
     int64_t size   = -1;
     int volume_num = -1;
+    bool fast_tier = false;
+    bool directory = false;
     const char *e;
     while (nullptr != (e = tokens.getNext())) {
       if (ParseRules::is_digit(*e)) {
@@ -393,14 +399,32 @@ Store::read_config()
           Error("storage.config failed to load");
           return Result::failure("failed to parse volume number '%s'", e);
         }
+      } else if (0 == strncasecmp(TIER_KEY, e, sizeof(TIER_KEY) - 1)) {
+        e += sizeof(TIER_KEY) - 1;
+        if ('=' == *e) {
+          ++e;
+        }
+        if (0 == strcasecmp(e, "ssd")) {
+          fast_tier = true;
+        } else if (0 != strcasecmp(e, "hdd")) {
+          delete sd;
+          Error("storage.config failed to load");
+          return Result::failure("failed to parse tier '%s'", e);
+        }
+      } else if (0 == strcasecmp(DIRECTORY_KEY, e)) {
+        directory = true;
       }
     }
+    if (directory) {
+      // Not a data span, it is not counted with the disks.
+      --n_disks_in_config;
+    }
 
     std::string pp = Layout::get()->relative(path);
 
     ns = new Span;
-    Debug("cache_init", "Store::read_config - ns = new Span; ns->init(\"%s\",%" PRId64 "), forced volume=%d%s%s", pp.c_str(), size,
-          volume_num, seed ? " id=" : "", seed ? seed : "");
+    Debug("cache_init", "Store::read_config - ns = new Span; ns->init(\"%s\",%" PRId64 "), forced volume=%d%s%s%s", pp.c_str(),
+          size, volume_num, seed ? " id=" : "", seed ? seed : "", fast_tier ? " tier=ssd" : "");
     if ((err = ns->init(pp.c_str(), size))) {
       RecSignalWarning(REC_SIGNAL_SYSTEM_ERROR, "could not initialize storage \"%s\" [%s]", pp.c_str(), err);
       Debug("cache_init", "Store::read_config - could not initialize storage \"%s\" [%s]", pp.c_str(), err);
@@ -408,6 +432,16 @@ Store::read_config()
       continue;
     }
 
+    if (directory) {
+      if (dir_span) {
+        Warning("storage.config: more than one directory device, ignoring \"%s\"", pp.c_str());
+        delete ns;
+      } else {
+        dir_span = ns;
+      }
+      continue;
+    }
+
     n_dsstore++;
 
     // Set side values if present.
@@ -417,6 +451,7 @@ Store::read_config()
     if (volume_num > 0) {
       ns->volume_number_set(volume_num);
     }
+    ns->fast_tier = fast_tier;
 
     // new Span
     {
@@ -0,0 +1,612 @@
+/** @file
+
+  Cache micro-benchmark, drives the cache with a synthetic workload without HttpSM.
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ */
+
+// Each client runs one cache operation at a time, back to back: it picks an object by its Zipf
+// popularity and reads it, or writes it instead with the given probability. A read that misses
+// fills the object, as a proxy would. An object has a fixed size, drawn log-uniformly from the size
+// range, and its alternates are told apart by the Accept header of the request, which the response
+// varies on. The run reports the operations per second and their latencies, the AIO queue depths
+// sampled while it ran, the RAM cache hit rate of the reads and the lengths of the directory chains.
+
+#include <algorithm>
+#include <atomic>
+#include <cinttypes>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "tscore/I_Layout.h"
+#include "tscore/I_Version.h"
+#include "tscore/Diags.h"
+#include "tscore/TSSystemState.h"
+#include "tscore/ink_args.h"
+
+#include "RecordsConfig.h"
+#include "records/I_RecProcess.h"
+#include "P_AIO.h"
+#include "P_CacheDisk.h"
+#include "P_Net.h"
+#include "P_Cache.h"
+#include "HttpConfig.h"
+
+static AppVersionInfo appVersionInfo;
+
+static int objects         = 10000;
+static int min_size        = 1024;
+static int max_size        = 1024 * 1024;
+static double zipf_alpha   = 0.9;
+static double read_ratio   = 0.9;
+static int alternates      = 1;
+static int clients         = 64;
+static int seconds         = 30;
+static int threads         = 4;
+static int ram_cache_size  = -1;
+static char cache_dir[256] = "";
+
+static const ArgumentDescription argument_descriptions[] = {
+  {"objects", 'o', "Number of Objects", "I", &objects, "BENCH_OBJECTS", nullptr},
+  {"min_size", 'm', "Smallest Object Size (bytes)", "I", &min_size, "BENCH_MIN_SIZE", nullptr},
+  {"max_size", 'M', "Largest Object Size (bytes)", "I", &max_size, "BENCH_MAX_SIZE", nullptr},
+  {"zipf", 'z', "Zipf Exponent of the Popularity (0:uniform)", "D", &zipf_alpha, "BENCH_ZIPF", nullptr},
+  {"read_ratio", 'r', "Share of Operations that are Reads", "D", &read_ratio, "BENCH_READ_RATIO", nullptr},
+  {"alternates", 'a', "Alternates of each Object", "I", &alternates, "BENCH_ALTERNATES", nullptr},
+  {"clients", 'c', "Concurrent Operations", "I", &clients, "BENCH_CLIENTS", nullptr},
+  {"seconds", 's', "Duration (seconds)", "I", &seconds, "BENCH_SECONDS", nullptr},
+  {"threads", 't', "Event Threads", "I", &threads, "BENCH_THREADS", nullptr},
+  {"ram_cache", 'R', "RAM Cache Size (bytes, -1:automatic)", "I", &ram_cache_size, "BENCH_RAM_CACHE", nullptr},
+  {"cache_dir", 'd', "Directory of storage.config", "S255", cache_dir, "BENCH_CACHE_DIR", nullptr},
+  HELP_ARGUMENT_DESCRIPTION(),
+  VERSION_ARGUMENT_DESCRIPTION()};
+
+static constexpr int64_t WRITE_CHUNK = 32 * 1024;
+static char *object_data             = nullptr; ///< Body of every object, @c max_size bytes.
+static std::vector<double> popularity;          ///< Cumulative probability of the objects, most popular first.
+
+/// Counts of latencies in microseconds, in 16 buckets for each power of two.
+class Histogram
+{
+public:
+  static constexpr int SUB     = 16;
+  static constexpr int BUCKETS = 61 * SUB;
+
+  void
+  add(uint64_t us)
+  {
+    ++_counts[index(us)];
+    ++_count;
+    _max = std::max(_max, us);
+  }
+
+  void
+  merge(const Histogram &that)
+  {
+    for (int i = 0; i < BUCKETS; ++i) {
+      _counts[i] += that._counts[i];
+    }
+    _count += that._count;
+    _max = std::max(_max, that._max);
+  }
+
+  uint64_t
+  count() const
+  {
+    return _count;
+  }
+
+  /// The least latency that @a p of the latencies are not above, to within a bucket.
+  uint64_t
+  percentile(double p) const
+  {
+    uint64_t rank = static_cast<uint64_t>(p * _count + 0.5);
+    uint64_t seen = 0;
+    for (int i = 0; i < BUCKETS; ++i) {
+      seen += _counts[i];
+      if (seen >= rank && seen > 0) {
+        return std::min(upper(i), _max);
+      }
+    }
+    return _max;
+  }
+
+  uint64_t
+  max() const
+  {
+    return _max;
+  }
+
+private:
+  static int
+  index(uint64_t v)
+  {
+    if (v < SUB) {
+      return static_cast<int>(v);
+    }
+    int e = 63 - __builtin_clzll(v);
+    return (e - 3) * SUB + static_cast<int>((v >> (e - 4)) - SUB);
+  }
+
+  static uint64_t
+  upper(int i)
+  {
+    if (i < SUB) {
+      return i;
+    }
+    int e = i / SUB + 3;
+    return ((static_cast<uint64_t>(i % SUB + SUB) + 1) << (e - 4)) - 1;
+  }
+
+  uint64_t _counts[BUCKETS] = {0};
+  uint64_t _count           = 0;
+  uint64_t _max             = 0;
+};
+
+enum BenchOp { OP_READ_HIT, OP_READ_MISS, OP_WRITE, OP_COUNT };
+static const char *op_names[OP_COUNT] = {"read hit", "read miss", "write"};
+
+struct BenchStats {
+  Histogram latency[OP_COUNT];
+  uint64_t ram_hits      = 0; ///< Read hits served by the RAM cache.
+  uint64_t write_busy    = 0; ///< Writes turned away as the object was being written.
+  uint64_t errors        = 0;
+  uint64_t bytes_read    = 0;
+  uint64_t bytes_written = 0;
+
+  void
+  merge(const BenchStats &that)
+  {
+    for (int i = 0; i < OP_COUNT; ++i) {
+      latency[i].merge(that.latency[i]);
+    }
+    ram_hits += that.ram_hits;
+    write_busy += that.write_busy;
+    errors += that.errors;
+    bytes_read += that.bytes_read;
+    bytes_written += that.bytes_written;
+  }
+};
+
+static std::atomic<bool> stopping{false};
+static std::atomic<int> running_clients{0};
+static ink_hrtime bench_start = 0;
+static ink_hrtime bench_end   = 0;
+
+class BenchClient;
+static std::vector<BenchClient *> bench_clients;
+static void bench_report();
+
+/// The size of object @a id, the same on every run.
+static int64_t
+object_size(int id)
+{
+  std::mt19937_64 rng(id);
+  double u = std::uniform_real_distribution<double>(0, 1)(rng);
+  return static_cast<int64_t>(min_size * std::pow(static_cast<double>(max_size) / min_size, u));
+}
+
+static void
+parse_hdr(HTTPHdr &hdr, HTTPType type, const char *text, int len)
+{
+  HTTPParser parser;
+  const char *start = text;
+  ParseResult err;
+
+  hdr.create(type);
+  http_parser_init(&parser);
+  if (type == HTTP_TYPE_REQUEST) {
+    err = hdr.parse_req(&parser, &start, text + len, true);
+  } else {
+    err = hdr.parse_resp(&parser, &start, text + len, true);
+  }
+  http_parser_clear(&parser);
+  ink_release_assert(err == PARSE_RESULT_DONE);
+}
+
+/// Build the headers of alternate @a alt of object @a id into @a info.
+static void
+build_object_hdrs(HTTPInfo &info, int id, int alt)
+{
+  char buf[512];
+  int len;
+  HTTPHdr req;
+  HTTPHdr resp;
+
+  len = snprintf(buf, sizeof(buf), "GET http://bench.example.com/%d HTTP/1.1\r\nAccept: type/%d\r\n\r\n", id, alt);
+  parse_hdr(req, HTTP_TYPE_REQUEST, buf, len);
+  len = snprintf(buf, sizeof(buf),
+                 "HTTP/1.1 200 OK\r\nContent-Type: type/%d\r\nContent-Length: %" PRId64 "\r\n"
+                 "Cache-Control: max-age=86400\r\nVary: Accept\r\n\r\n",
+                 alt, object_size(id));
+  parse_hdr(resp, HTTP_TYPE_RESPONSE, buf, len);
+
+  info.create();
+  info.request_set(&req);
+  info.response_set(&resp);
+  req.destroy();
+  resp.destroy();
+}
+
+class BenchClient : public Continuation
+{
+public:
+  BenchClient(int n) : Continuation(new_ProxyMutex()), rng(n)
+  {
+    buffer = new_MIOBuffer(BUFFER_SIZE_INDEX_32K);
+    reader = buffer->alloc_reader();
+    SET_HANDLER(&BenchClient::start_event);
+  }
+
+  BenchStats stats;
+
+private:
+  int
+  start_event(int /* event ATS_UNUSED */, void * /* data ATS_UNUSED */)
+  {
+    next_op();
+    return EVENT_DONE;
+  }
+
+  void
+  next_op()
+  {
+    if (stopping) {
+      if (--running_clients == 0) {
+        bench_report();
+      }
+      return;
+    }
+
+    double u = std::uniform_real_distribution<double>(0, 1)(rng);
+    id       = static_cast<int>(std::upper_bound(popularity.begin(), popularity.end(), u) - popularity.begin());
+    id       = std::min(id, objects - 1);
+    alt      = std::uniform_int_distribution<int>(0, alternates - 1)(rng);
+    if (std::uniform_real_distribution<double>(0, 1)(rng) < read_ratio) {
+      start_read();
+    } else {
+      start_write();
+    }
+  }
+
+  void
+  finish_op(BenchOp op)
+  {
+    stats.latency[op].add(ink_hrtime_to_usec(Thread::get_hrtime_updated() - start));
+    info.destroy();
+    vc  = nullptr;
+    vio = nullptr;
+    reader->consume(reader->read_avail());
+    next_op();
+  }
+
+  void
+  start_read()
+  {
+    build_object_hdrs(info, id, alt);
+    start = Thread::get_hrtime_updated();
+    Cache::generate_key(&key, info.request_get()->url_get(), 1);
+    SET_HANDLER(&BenchClient::read_event);
+    cacheProcessor.open_read(this, &key, info.request_get(), &params);
+  }
+
+  void
+  start_write()
+  {
+    if (!info.valid()) {
+      build_object_hdrs(info, id, alt);
+      start = Thread::get_hrtime_updated();
+    }
+    Cache::generate_key(&key, info.request_get()->url_get(), 1);
+    SET_HANDLER(&BenchClient::write_event);
+    cacheProcessor.open_write(this, 0, &key, info.request_get(), nullptr);
+  }
+
+  int
+  read_event(int event, void *data)
+  {
+    switch (event) {
+    case CACHE_EVENT_OPEN_READ:
+      vc  = static_cast<CacheVC *>(data);
+      vio = vc->do_io_read(this, vc->get_object_size(), buffer);
+      break;
+    case CACHE_EVENT_OPEN_READ_FAILED: {
+      // Fill the object, the write is timed from the start of the read.
+      stats.latency[OP_READ_MISS].add(ink_hrtime_to_usec(Thread::get_hrtime_updated() - start));
+      start_write();
+      break;
+    }
+    case VC_EVENT_READ_READY:
+      stats.bytes_read += reader->read_avail();
+      reader->consume(reader->read_avail());
+      vio->reenable();
+      break;
+    case VC_EVENT_READ_COMPLETE:
+    case VC_EVENT_EOS:
+      stats.bytes_read += reader->read_avail();
+      stats.ram_hits += vc->is_ram_cache_hit();
+      vc->do_io_close();
+      finish_op(OP_READ_HIT);
+      break;
+    default:
+      ++stats.errors;
+      vc->do_io_close();
+      finish_op(OP_READ_HIT);
+      break;
+    }
+    return EVENT_CONT;
+  }
+
+  int
+  write_event(int event, void *data)
+  {
+    switch (event) {
+    case CACHE_EVENT_OPEN_WRITE:
+      vc = static_cast<CacheVC *>(data);
+      // The cache takes the headers over.
+      vc->set_http_info(&info);
+      size    = object_size(id);
+      written = 0;
+      vio     = vc->do_io_write(this, size, reader);
+      fill();
+      break;
+    case CACHE_EVENT_OPEN_WRITE_FAILED:
+      ++stats.write_busy;
+      finish_op(OP_WRITE);
+      break;
+    case VC_EVENT_WRITE_READY:
+      fill();
+      vio->reenable();
+      break;
+    case VC_EVENT_WRITE_COMPLETE:
+      stats.bytes_written += written;
+      vc->do_io_close();
+      finish_op(OP_WRITE);
+      break;
+    default:
+      ++stats.errors;
+      vc->do_io_close(1);
+      finish_op(OP_WRITE);
+      break;
+    }
+    return EVENT_CONT;
+  }
+
+  /// Keep about one chunk of the object buffered for the cache.
+  void
+  fill()
+  {
+    int64_t n = std::min(WRITE_CHUNK - reader->read_avail(), size - written);
+    if (n > 0) {
+      buffer->write(object_data, n);
+      written += n;
+    }
+  }
+
+  std::mt19937_64 rng;
+  int id  = 0;
+  int alt = 0;
+  HttpCacheKey key;
+  HTTPInfo info;
+  OverridableHttpConfigParams params;
+  ink_hrtime start       = 0;
+  int64_t size           = 0; ///< Of the object being written.
+  int64_t written        = 0;
+  CacheVC *vc            = nullptr;
+  VIO *vio               = nullptr;
+  MIOBuffer *buffer      = nullptr;
+  IOBufferReader *reader = nullptr;
+};
+
+/// Samples the AIO queue depths, and ends the run when its time is up.
+class BenchSampler : public Continuation
+{
+public:
+  BenchSampler() : Continuation(new_ProxyMutex()) { SET_HANDLER(&BenchSampler::sample_event); }
+
+  int
+  sample_event(int /* event ATS_UNUSED */, void *data)
+  {
+    if (stopping) {
+      static_cast<Event *>(data)->cancel();
+      return EVENT_DONE;
+    }
+    for (int i = 0; i < AIO_CLASS_COUNT; ++i) {
+      int64_t queued = 0;
+      RecGetGlobalRawStatSum(aio_rsb, AIO_STAT_CLASS_QUEUED + i, &queued);
+      queued_sum[i] += queued;
+      queued_max[i] = std::max(queued_max[i], queued);
+    }
+    ++samples;
+    if (Thread::get_hrtime_updated() - bench_start >= HRTIME_SECONDS(seconds)) {
+      bench_end = Thread::get_hrtime_updated();
+      stopping  = true;
+    }
+    return EVENT_CONT;
+  }
+
+  int64_t queued_sum[AIO_CLASS_COUNT] = {0};
+  int64_t queued_max[AIO_CLASS_COUNT] = {0};
+  int64_t samples                     = 0;
+};
+
+static BenchSampler *bench_sampler = nullptr;
+
+static void
+report_directory()
+{
+  static constexpr int LONGEST = 16;
+  uint64_t chains[LONGEST + 1] = {0}; // the last counts the chains at least that long
+  uint64_t buckets = 0, entries = 0, entries_probed = 0;
+
+  for (int v = 0; v < gnvol; ++v) {
+    Vol *vol = gvol[v];
+    SCOPED_MUTEX_LOCK(lock, vol->mutex, this_ethread());
+    for (int s = 0; s < vol->segments; ++s) {
+      Dir *seg = vol->dir_segment(s);
+      for (int b = 0; b < vol->buckets; ++b) {
+        int length = 0;
+        for (Dir *e = dir_bucket(b, seg); e && dir_offset(e); e = next_dir(e, seg)) {
+          ++length;
+        }
+        ++chains[std::min(length, LONGEST)];
+        ++buckets;
+        entries += length;
+        // A lookup of an entry probes the entries before it too.
+        entries_probed += static_cast<uint64_t>(length) * (length + 1) / 2;
+      }
+    }
+  }
+
+  printf("directory: %" PRIu64 " entries in %" PRIu64 " buckets, %.1f%% of the buckets used\n", entries, buckets,
+         buckets ? 100.0 * (buckets - chains[0]) / buckets : 0.0);
+  printf("  mean probes of a hit %.2f\n", entries ? static_cast<double>(entries_probed) / entries : 0.0);
+  for (int i = 1; i <= LONGEST; ++i) {
+    if (chains[i]) {
+      printf("  chains %s%2d: %10" PRIu64 " %6.2f%%\n", i == LONGEST ? ">=" : "  ", i, chains[i], 100.0 * chains[i] / buckets);
+    }
+  }
+}
+
+static void
+bench_report()
+{
+  BenchStats total;
+  for (auto client : bench_clients) {
+    total.merge(client->stats);
+  }
+  double elapsed = static_cast<double>(bench_end - bench_start) / HRTIME_SECOND;
+  uint64_t ops   = total.latency[OP_READ_HIT].count() + total.latency[OP_WRITE].count();
+  uint64_t reads = total.latency[OP_READ_HIT].count() + total.latency[OP_READ_MISS].count();
+
+  printf("%d objects of %d..%d bytes, zipf %.2f, %.0f%% reads, %d alternates, %d clients, %d threads\n", objects, min_size,
+         max_size, zipf_alpha, 100 * read_ratio, alternates, clients, threads);
+  printf("%.1f seconds: %.0f ops/sec, read %.1f MB/sec, written %.1f MB/sec\n", elapsed, ops / elapsed,
+         total.bytes_read / elapsed / (1 << 20), total.bytes_written / elapsed / (1 << 20));
+  for (int i = 0; i < OP_COUNT; ++i) {
+    const Histogram &h = total.latency[i];
+    printf("  %-9s %10" PRIu64 " %8.0f/sec, latency (ms) p50 %.3f p99 %.3f p99.9 %.3f max %.3f\n", op_names[i], h.count(),
+           h.count() / elapsed, h.percentile(0.5) / 1000.0, h.percentile(0.99) / 1000.0, h.percentile(0.999) / 1000.0,
+           h.max() / 1000.0);
+  }
+  uint64_t hits = total.latency[OP_READ_HIT].count();
+  printf("reads: %.1f%% hits, %.1f%% of the hits from the RAM cache\n", reads ? 100.0 * hits / reads : 0.0,
+         hits ? 100.0 * total.ram_hits / hits : 0.0);
+  printf("writes: %" PRIu64 " turned away busy, %" PRIu64 " errors\n", total.write_busy, total.errors);
+
+  static const char *class_names[AIO_CLASS_COUNT] = {"read", "write", "evacuate", "sync"};
+  printf("AIO queue depth:");
+  for (int i = 0; i < AIO_CLASS_COUNT; ++i) {
+    printf(" %s mean %.1f max %" PRId64 "%s", class_names[i],
+           bench_sampler->samples ? static_cast<double>(bench_sampler->queued_sum[i]) / bench_sampler->samples : 0.0,
+           bench_sampler->queued_max[i], i + 1 < AIO_CLASS_COUNT ? "," : "\n");
+  }
+  report_directory();
+
+  TSSystemState::shut_down_event_system();
+}
+
+class BenchStart : public Continuation
+{
+public:
+  BenchStart() : Continuation(new_ProxyMutex()) { SET_HANDLER(&BenchStart::start_event); }
+
+  int
+  start_event(int /* event ATS_UNUSED */, void * /* data ATS_UNUSED */)
+  {
+    if (!CacheProcessor::IsCacheReady(CACHE_FRAG_TYPE_HTTP)) {
+      this_ethread()->schedule_in(this, HRTIME_MSECONDS(20));
+      return EVENT_CONT;
+    }
+
+    bench_start   = Thread::get_hrtime_updated();
+    bench_sampler = new BenchSampler();
+    eventProcessor.schedule_every(bench_sampler, HRTIME_MSECONDS(100), ET_NET);
+    running_clients = clients;
+    for (int i = 0; i < clients; ++i) {
+      bench_clients.push_back(new BenchClient(i));
+      eventProcessor.schedule_imm(bench_clients.back(), ET_NET);
+    }
+    delete this;
+    return EVENT_DONE;
+  }
+};
+
+int
+main(int /* argc ATS_UNUSED */, const char *argv[])
+{
+  appVersionInfo.setup(PACKAGE_NAME, "bench_Cache", PACKAGE_VERSION, __DATE__, __TIME__, BUILD_MACHINE, BUILD_PERSON, "");
+  process_args(&appVersionInfo, argument_descriptions, countof(argument_descriptions), argv);
+  objects    = std::max(objects, 1);
+  alternates = std::max(alternates, 1);
+  clients    = std::max(clients, 1);
+  min_size   = std::max(min_size, 1);
+  max_size   = std::max(max_size, min_size);
+
+  // Zipf popularity, object 0 is the most popular.
+  double sum = 0;
+  popularity.resize(objects);
+  for (int i = 0; i < objects; ++i) {
+    sum += 1.0 / std::pow(i + 1, zipf_alpha);
+    popularity[i] = sum;
+  }
+  for (auto &p : popularity) {
+    p /= sum;
+  }
+  object_data = static_cast<char *>(ats_malloc(max_size));
+  for (int i = 0; i < max_size; ++i) {
+    object_data[i] = 'a' + i % 26;
+  }
+
+  BaseLogFile *base_log_file = new BaseLogFile("stderr");
+  diags                      = new Diags("bench_Cache", "" /* tags */, "" /* actions */, base_log_file);
+
+  mime_init();
+  Layout::create();
+  RecProcessInit(RECM_STAND_ALONE);
+  LibRecordsConfigInit();
+  if (ram_cache_size >= 0) {
+    RecSetRecordInt("proxy.config.cache.ram_cache.size", ram_cache_size, REC_SOURCE_EXPLICIT);
+  }
+  ink_net_init(ts::ModuleVersion(1, 0, ts::ModuleVersion::PRIVATE));
+
+  statPagesManager.init(); // mutex needs to be initialized before calling netProcessor.init
+  netProcessor.init();
+  eventProcessor.start(threads);
+
+  ink_aio_init(AIO_MODULE_PUBLIC_VERSION);
+
+  EThread *thread = new EThread();
+  thread->set_specific();
+  init_buffer_allocators(0);
+
+  std::string src_dir       = *cache_dir ? std::string(cache_dir) : std::string(TS_ABS_TOP_SRCDIR) + "/iocore/cache/test";
+  Layout::get()->sysconfdir = src_dir;
+  Layout::get()->prefix     = src_dir;
+
+  ink_cache_init(ts::ModuleVersion(1, 0, ts::ModuleVersion::PRIVATE));
+  cacheProcessor.start();
+
+  eventProcessor.schedule_imm(new BenchStart(), ET_NET);
+  this_thread()->execute();
+
+  return 0;
+}
@@ -391,6 +391,63 @@ private:
   bool _is_read_start = false;
 };
 
+class CacheRWWWaitTest : public CacheRWWTest
+{
+public:
+  CacheRWWWaitTest(size_t size, const char *url = DEFAULT_URL) : CacheRWWTest(size, url) {}
+  /*
+   * The reader opens before the writer has written a fragment. It waits on the
+   * OpenDirEntry until the writer wakes it, then follows the writer fragment by
+   * fragment without either side reenabling the other.
+   */
+
+  void
+  process_write_event(int event, CacheTestBase *base) override
+  {
+    switch (event) {
+    case CACHE_EVENT_OPEN_WRITE:
+      base->do_io_write();
+      this->_read_event = this_ethread()->schedule_imm(this->_rt);
+      break;
+    case VC_EVENT_WRITE_READY:
+      base->reenable();
+      break;
+    case VC_EVENT_WRITE_COMPLETE:
+      this->close_write();
+      break;
+    default:
+      REQUIRE(false);
+      delete this;
+      return;
+    }
+  }
+
+  void
+  process_read_event(int event, CacheTestBase *base) override
+  {
+    switch (event) {
+    case CACHE_EVENT_OPEN_READ:
+      // only once the writer has a fragment to read.
+      REQUIRE((!this->_wt || this->_wt->vc->fragment > 0));
+      this->_read_event = nullptr;
+      base->do_io_read();
+      break;
+    case VC_EVENT_READ_READY:
+      base->reenable();
+      break;
+    case VC_EVENT_READ_COMPLETE:
+      REQUIRE(base->vio->ndone == static_cast<int64_t>(this->_size));
+      this->close_read();
+      break;
+    default:
+      REQUIRE(event == 0);
+      this->close_read();
+      this->close_write();
+      break;
+    }
+  }
+};
+
 class CacheRWWCacheInit : public CacheInit
 {
 public:
@@ -398,13 +455,15 @@ public:
   int
   cache_init_success_callback(int event, void *e) override
   {
-    CacheRWWTest *crww        = new CacheRWWTest(LARGE_FILE);
-    CacheRWWErrorTest *crww_l = new CacheRWWErrorTest(LARGE_FILE, "http://www.scw22.com/");
-    CacheRWWEOSTest *crww_eos = new CacheRWWEOSTest(LARGE_FILE, "ttp://www.scw44.com/");
-    TerminalTest *tt          = new TerminalTest();
+    CacheRWWTest *crww          = new CacheRWWTest(LARGE_FILE);
+    CacheRWWErrorTest *crww_l   = new CacheRWWErrorTest(LARGE_FILE, "http://www.scw22.com/");
+    CacheRWWEOSTest *crww_eos   = new CacheRWWEOSTest(LARGE_FILE, "ttp://www.scw44.com/");
+    CacheRWWWaitTest *crww_wait = new CacheRWWWaitTest(LARGE_FILE, "http://www.scw55.com/");
+    TerminalTest *tt            = new TerminalTest();
 
     crww->add(crww_l);
     crww->add(crww_eos);
+    crww->add(crww_wait);
     crww->add(tt);
     this_ethread()->schedule_imm(crww);
     delete this;
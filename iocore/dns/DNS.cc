@@ -57,6 +57,10 @@ char *dns_local_ipv4                 = nullptr;
 int dns_thread                       = 0;
 int dns_prefer_ipv6                  = 0;
 DNS_CONN_MODE dns_conn_mode          = DNS_CONN_MODE::UDP_ONLY;
+int dns_tcp_connections              = 1;
+int dns_tls_enabled                  = 0;
+char *dns_tls_server_name            = nullptr;
+SSL_CTX *dns_tls_ctx                 = nullptr;
 
 namespace
 {
@@ -223,6 +227,29 @@ DNSProcessor::start(int, size_t stacksize)
   int dns_conn_mode_i = 0;
   REC_EstablishStaticConfigInt32(dns_conn_mode_i, "proxy.config.dns.connection_mode");
   dns_conn_mode = static_cast<DNS_CONN_MODE>(dns_conn_mode_i);
+  REC_EstablishStaticConfigInt32(dns_tcp_connections, "proxy.config.dns.tcp.connections");
+  dns_tcp_connections = std::clamp(dns_tcp_connections, 1, MAX_DNS_TCP_CONNECTIONS);
+  REC_EstablishStaticConfigInt32(dns_tls_enabled, "proxy.config.dns.tls.enabled");
+  REC_ReadConfigStringAlloc(dns_tls_server_name, "proxy.config.dns.tls.server_name");
+
+  if (dns_tls_enabled) {
+    if (dns_conn_mode != DNS_CONN_MODE::TCP_ONLY) {
+      Note("proxy.config.dns.tls.enabled is set, talking to the nameservers over TCP only");
+      dns_conn_mode = DNS_CONN_MODE::TCP_ONLY;
+    }
+    dns_tls_ctx = SSL_CTX_new(TLS_client_method());
+    SSL_CTX_set_min_proto_version(dns_tls_ctx, TLS1_2_VERSION);
+    // The query buffer of a connection grows and is compacted between the retries of a write.
+    SSL_CTX_set_mode(dns_tls_ctx, SSL_MODE_ENABLE_PARTIAL_WRITE | SSL_MODE_ACCEPT_MOVING_WRITE_BUFFER);
+    if (dns_tls_server_name && *dns_tls_server_name) {
+      SSL_CTX_set_default_verify_paths(dns_tls_ctx);
+      SSL_CTX_set_verify(dns_tls_ctx, SSL_VERIFY_PEER, nullptr);
+    } else {
+      ats_free(dns_tls_server_name);
+      dns_tls_server_name = nullptr;
+      Warning("proxy.config.dns.tls.server_name is not set, the certificates of the nameservers are not verified");
+    }
+  }
 
   if (dns_thread > 0) {
     // TODO: Hmmm, should we just get a single thread some other way?
@@ -459,17 +486,51 @@ DNSHandler::open_cons(sockaddr const *target, bool failed, int icon)
     open_con(target, failed, icon, false);
   }
   if (dns_conn_mode != DNS_CONN_MODE::UDP_ONLY) {
-    open_con(target, failed, icon, true);
+    for (int slot = 0; slot < dns_tcp_connections; ++slot) {
+      open_con(target, failed, icon, true, slot);
+      // A failure has already been handled, and the pool is opened again with the next attempt.
+      if (tcpcon[icon][slot].fd == NO_FD) {
+        break;
+      }
+    }
+  }
+}
+
+/** Close the UDP and/or TCP connections to a nameserver. */
+void
+DNSHandler::close_cons(int icon)
+{
+  if (dns_conn_mode != DNS_CONN_MODE::TCP_ONLY) {
+    udpcon[icon].close();
+  }
+  if (dns_conn_mode != DNS_CONN_MODE::UDP_ONLY) {
+    for (int slot = 0; slot < dns_tcp_connections; ++slot) {
+      tcpcon[icon][slot].close();
+    }
   }
 }
 
+/** The TCP connection to a nameserver for the next query, round-robin across the pool. */
+DNSConnection &
+DNSHandler::next_tcp_con(int icon)
+{
+  for (int i = 0; i < dns_tcp_connections; ++i) {
+    DNSConnection &con = tcpcon[icon][tcp_next[icon]];
+    tcp_next[icon]     = (tcp_next[icon] + 1) % dns_tcp_connections;
+    if (con.fd != NO_FD) {
+      return con;
+    }
+  }
+  return tcpcon[icon][0];
+}
+
 /**
   Open (and close) connections as necessary and also assures that the
   epoll fd struct is properly updated.
 
 */
 void
-DNSHandler::open_con(sockaddr const *target, bool failed, int icon, bool over_tcp)
+DNSHandler::open_con(sockaddr const *target, bool failed, int icon, bool over_tcp, int slot)
 {
   ip_port_text_buffer ip_text;
   PollDescriptor *pd = get_PollDescriptor(dnsProcessor.thread);
@@ -479,7 +540,7 @@ DNSHandler::open_con(sockaddr const *target, bool failed, int icon, bool over_tc
   } else if (!target) {
     target = &ip.sa;
   }
-  DNSConnection &cur_con = over_tcp ? tcpcon[icon] : udpcon[icon];
+  DNSConnection &cur_con = over_tcp ? tcpcon[icon][slot] : udpcon[icon];
 
   Debug("dns", "open_con: opening connection %s", ats_ip_nptop(target, ip_text, sizeof ip_text));
 
@@ -493,7 +554,9 @@ DNSHandler::open_con(sockaddr const *target, bool failed, int icon, bool over_tc
                                 .setUseTcp(over_tcp)
                                 .setBindRandomPort(true)
                                 .setLocalIpv6(&local_ipv6.sa)
-                                .setLocalIpv4(&local_ipv4.sa)) < 0) {
+                                .setLocalIpv4(&local_ipv4.sa)
+                                .setTlsContext(over_tcp ? dns_tls_ctx : nullptr)
+                                .setTlsServerName(dns_tls_server_name)) < 0) {
     Debug("dns", "opening connection %s FAILED for %d", ip_text, icon);
     if (!failed) {
       if (dns_ns_rr) {
@@ -618,23 +681,18 @@ DNSHandler::retry_named(int ndx, ink_hrtime t, bool reopen)
   if (reopen && ((t - last_primary_reopen) > DNS_PRIMARY_REOPEN_PERIOD)) {
     Debug("dns", "retry_named: reopening DNS connection for index %d", ndx);
     last_primary_reopen = t;
-    if (dns_conn_mode != DNS_CONN_MODE::TCP_ONLY) {
-      udpcon[ndx].close();
-    }
-    if (dns_conn_mode != DNS_CONN_MODE::UDP_ONLY) {
-      tcpcon[ndx].close();
-    }
+    close_cons(ndx);
     open_cons(&m_res->nsaddr_list[ndx].sa, true, ndx);
   }
-  bool over_tcp = dns_conn_mode == DNS_CONN_MODE::TCP_ONLY;
-  int con_fd    = over_tcp ? tcpcon[ndx].fd : udpcon[ndx].fd;
+  bool over_tcp     = dns_conn_mode == DNS_CONN_MODE::TCP_ONLY;
+  DNSConnection &con = over_tcp ? next_tcp_con(ndx) : udpcon[ndx];
   unsigned char buffer[MAX_DNS_PACKET_LEN];
   Debug("dns", "trying to resolve '%s' from DNS connection, ndx %d", try_server_names[try_servers], ndx);
   int r       = _ink_res_mkquery(m_res, try_server_names[try_servers], T_A, buffer, over_tcp);
   try_servers = (try_servers + 1) % countof(try_server_names);
   ink_assert(r >= 0);
   if (r >= 0) { // looking for a bounce
-    int res = socketManager.send(con_fd, buffer, r, 0);
+    int res = con.send(buffer, r);
     Debug("dns", "ping result = %d", res);
   }
 }
@@ -651,7 +709,7 @@ DNSHandler::try_primary_named(bool reopen)
   if ((t - last_primary_retry) > DNS_PRIMARY_RETRY_PERIOD) {
     unsigned char buffer[MAX_DNS_PACKET_LEN];
     bool over_tcp      = dns_conn_mode == DNS_CONN_MODE::TCP_ONLY;
-    int con_fd         = over_tcp ? tcpcon[0].fd : udpcon[0].fd;
+    DNSConnection &con = over_tcp ? next_tcp_con(0) : udpcon[0];
     last_primary_retry = t;
     Debug("dns", "trying to resolve '%s' from primary DNS connection", try_server_names[try_servers]);
     int r = _ink_res_mkquery(m_res, try_server_names[try_servers], T_A, buffer, over_tcp);
@@ -664,7 +722,7 @@ DNSHandler::try_primary_named(bool reopen)
     }
     ink_assert(r >= 0);
     if (r >= 0) { // looking for a bounce
-      int res = socketManager.send(con_fd, buffer, r, 0);
+      int res = con.send(buffer, r);
       Debug("dns", "ping result = %d", res);
     }
   }
@@ -716,12 +774,7 @@ DNSHandler::failover()
     }
     switch_named(name_server);
   } else {
-    if (dns_conn_mode != DNS_CONN_MODE::TCP_ONLY) {
-      udpcon[0].close();
-    }
-    if (dns_conn_mode != DNS_CONN_MODE::UDP_ONLY) {
-      tcpcon[0].close();
-    }
+    close_cons(0);
     ip_text_buffer buff;
     Warning("failover: connection to DNS server %s lost, retrying", ats_ip_ntop(&ip.sa, buff, sizeof(buff)));
   }
@@ -804,32 +857,28 @@ DNSHandler::recv_dns(int /* event ATS_UNUSED */, Event * /* e ATS_UNUSED */)
         if (dnsc->tcp_data.buf_ptr == nullptr) {
           dnsc->tcp_data.buf_ptr = make_ptr(dnsBufAllocator.alloc());
         }
-        if (dnsc->tcp_data.total_length == 0) {
-          // see if TS gets a two-byte size
-          uint16_t tmp = 0;
-          res          = socketManager.recv(dnsc->fd, &tmp, sizeof(tmp), MSG_PEEK);
-          if (res == -EAGAIN || res == 1) {
+        if (dnsc->tcp_data.length_done < sizeof(dnsc->tcp_data.total_length)) {
+          // reading total size, which can come in two pieces
+          char *length_start = reinterpret_cast<char *>(&dnsc->tcp_data.total_length) + dnsc->tcp_data.length_done;
+          res                = dnsc->recv(length_start, sizeof(dnsc->tcp_data.total_length) - dnsc->tcp_data.length_done);
+          if (res == -EAGAIN) {
             break;
           }
           if (res <= 0) {
             goto Lerror;
           }
-          // reading total size
-          res = socketManager.recv(dnsc->fd, &(dnsc->tcp_data.total_length), sizeof(dnsc->tcp_data.total_length), 0);
-          if (res == -EAGAIN) {
+          dnsc->tcp_data.length_done += res;
+          if (dnsc->tcp_data.length_done < sizeof(dnsc->tcp_data.total_length)) {
             break;
           }
-          if (res <= 0) {
-            goto Lerror;
-          }
           dnsc->tcp_data.total_length = ntohs(dnsc->tcp_data.total_length);
-          if (res != sizeof(dnsc->tcp_data.total_length) || dnsc->tcp_data.total_length > MAX_DNS_PACKET_LEN) {
+          if (dnsc->tcp_data.total_length > MAX_DNS_PACKET_LEN) {
             goto Lerror;
           }
         }
         // continue reading data
         void *buf_start = (char *)dnsc->tcp_data.buf_ptr->buf + dnsc->tcp_data.done_reading;
-        res             = socketManager.recv(dnsc->fd, buf_start, dnsc->tcp_data.total_length - dnsc->tcp_data.done_reading, 0);
+        res             = dnsc->recv(buf_start, dnsc->tcp_data.total_length - dnsc->tcp_data.done_reading);
         if (res == -EAGAIN) {
           break;
         }
@@ -1109,14 +1158,15 @@ write_dns_event(DNSHandler *h, DNSEntry *e, bool over_tcp)
     h->release_query_id(e->id[dns_retries - e->retries]);
   }
   e->id[dns_retries - e->retries] = i;
-  int con_fd                      = over_tcp ? h->tcpcon[h->name_server].fd : h->udpcon[h->name_server].fd;
-  Debug("dns", "send query (qtype=%d) for %s to fd %d", e->qtype, e->qname, con_fd);
+  DNSConnection &con              = over_tcp ? h->next_tcp_con(h->name_server) : h->udpcon[h->name_server];
+  Debug("dns", "send query (qtype=%d) for %s to fd %d", e->qtype, e->qname, con.fd);
 
-  int s = socketManager.send(con_fd, buffer, r, 0);
+  int s = con.send(buffer, r);
   if (s != r) {
     Debug("dns", "send() failed: qname = %s, %d != %d, nameserver= %d", e->qname, s, r, h->name_server);
     // changed if condition from 'r < 0' to 's < 0' - 8/2001 pas
-    if (s < 0) {
+    // a TCP connection with too many queries waiting to be written is not down
+    if (s < 0 && !(over_tcp && s == -EAGAIN)) {
       if (dns_ns_rr) {
         h->rr_failure(h->name_server);
       } else {
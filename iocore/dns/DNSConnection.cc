@@ -31,6 +31,8 @@
 #include "P_DNSConnection.h"
 #include "P_DNSProcessor.h"
 
+#include <openssl/err.h>
+
 #define SET_TCP_NO_DELAY
 #define SET_NO_LINGER
 #define SET_SO_KEEPALIVE
@@ -39,6 +41,8 @@
 // #define SEND_BUF_SIZE            (1024*64)
 #define FIRST_RANDOM_PORT (16000)
 #define LAST_RANDOM_PORT (60000)
+// queries kept for a TCP connection that does not take them fast enough
+#define MAX_WRITE_PENDING (64 * 1024)
 
 #define ROUNDUP(x, y) ((((x) + ((y)-1)) / (y)) * (y))
 
@@ -62,6 +66,13 @@ int
 DNSConnection::close()
 {
   eio.stop();
+  if (ssl) {
+    SSL_free(ssl);
+    ssl = nullptr;
+  }
+  write_pending.clear();
+  write_done   = 0;
+  write_wanted = false;
   // don't close any of the standards
   if (fd >= 2) {
     int fd_save = fd;
@@ -87,6 +98,148 @@ DNSConnection::trigger()
   handler->handleEvent(0, nullptr);
 }
 
+void
+DNSConnection::want_write(bool flag)
+{
+  if (flag != write_wanted) {
+    write_wanted = flag;
+    eio.modify(flag ? EVENTIO_WRITE : -EVENTIO_WRITE);
+  }
+}
+
+int
+DNSConnection::handshake()
+{
+  if (SSL_is_init_finished(ssl)) {
+    return 0;
+  }
+
+  ERR_clear_error();
+  int r = SSL_do_handshake(ssl);
+  if (r == 1) {
+    ip_port_text_buffer b;
+    Debug("dns", "TLS handshake with %s done", ats_ip_nptop(&ip.sa, b, sizeof b));
+    return 0;
+  }
+  switch (SSL_get_error(ssl, r)) {
+  case SSL_ERROR_WANT_READ:
+    return -EAGAIN;
+  case SSL_ERROR_WANT_WRITE:
+    want_write(true);
+    return -EAGAIN;
+  default: {
+    ip_port_text_buffer b;
+    Warning("TLS handshake with DNS server %s failed: %s", ats_ip_nptop(&ip.sa, b, sizeof b),
+            ERR_reason_error_string(ERR_peek_last_error()));
+    return -EIO;
+  }
+  }
+}
+
+int
+DNSConnection::flush()
+{
+  if (ssl) {
+    if (int r = handshake(); r < 0) {
+      return r;
+    }
+  }
+
+  while (write_done < write_pending.size()) {
+    unsigned char *start = write_pending.data() + write_done;
+    int len              = write_pending.size() - write_done;
+    int r;
+    if (ssl) {
+      ERR_clear_error();
+      r = SSL_write(ssl, start, len);
+      if (r <= 0) {
+        switch (SSL_get_error(ssl, r)) {
+        case SSL_ERROR_WANT_WRITE:
+          want_write(true);
+          return -EAGAIN;
+        case SSL_ERROR_WANT_READ:
+          return -EAGAIN;
+        default:
+          return -EIO;
+        }
+      }
+    } else {
+      r = socketManager.send(fd, start, len, 0);
+      if (r == -EAGAIN) {
+        want_write(true);
+      }
+      if (r < 0) {
+        return r;
+      }
+    }
+    write_done += r;
+  }
+
+  write_pending.clear();
+  write_done = 0;
+  want_write(false);
+  return 0;
+}
+
+int
+DNSConnection::send(void const *buf, int len)
+{
+  if (!opt._use_tcp) {
+    return socketManager.send(fd, const_cast<void *>(buf), len, 0);
+  }
+  if (fd == NO_FD) {
+    return -EBADF;
+  }
+  if (write_pending.size() - write_done + len > MAX_WRITE_PENDING) {
+    return -EAGAIN;
+  }
+
+  // Drop what is written once it is most of the buffer, the contexts allow a moving write buffer.
+  if (write_done > 0 && write_done >= write_pending.size() / 2) {
+    write_pending.erase(write_pending.begin(), write_pending.begin() + write_done);
+    write_done = 0;
+  }
+  unsigned char const *data = static_cast<unsigned char const *>(buf);
+  write_pending.insert(write_pending.end(), data, data + len);
+
+  int r = flush();
+  return (r < 0 && r != -EAGAIN) ? r : len;
+}
+
+int
+DNSConnection::recv(void *buf, int len)
+{
+  if (ssl || write_done < write_pending.size()) {
+    // Reads also move the handshake and the kept queries along.
+    if (int r = flush(); r < 0 && r != -EAGAIN) {
+      return r;
+    }
+  }
+  if (ssl == nullptr) {
+    return socketManager.recv(fd, buf, len, 0);
+  }
+  if (!SSL_is_init_finished(ssl)) {
+    return -EAGAIN;
+  }
+
+  ERR_clear_error();
+  int r = SSL_read(ssl, buf, len);
+  if (r > 0) {
+    return r;
+  }
+  switch (SSL_get_error(ssl, r)) {
+  case SSL_ERROR_WANT_READ:
+    return -EAGAIN;
+  case SSL_ERROR_WANT_WRITE:
+    want_write(true);
+    return -EAGAIN;
+  case SSL_ERROR_ZERO_RETURN:
+    return 0;
+  default:
+    return -EIO;
+  }
+}
+
 int
 DNSConnection::connect(sockaddr const *addr, Options const &opt)
 //                       bool non_blocking_connect, bool use_tcp, bool non_blocking, bool bind_random_port)
@@ -210,6 +363,19 @@ DNSConnection::connect(sockaddr const *addr, Options const &opt)
     goto Lerror;
   }
 
+  // The handshake is started by the first write, when the connection is up.
+  if (opt._use_tcp && opt._tls_ctx) {
+    if ((ssl = SSL_new(opt._tls_ctx)) == nullptr || !SSL_set_fd(ssl, fd)) {
+      res = -ENOMEM;
+      goto Lerror;
+    }
+    SSL_set_connect_state(ssl);
+    if (opt._tls_server_name) {
+      SSL_set_tlsext_host_name(ssl, opt._tls_server_name);
+      SSL_set1_host(ssl, opt._tls_server_name);
+    }
+  }
+
   return 0;
 
 Lerror:
@@ -30,6 +30,9 @@
 
 #pragma once
 
+#include <vector>
+#include <openssl/ssl.h>
+
 #include "I_EventSystem.h"
 #include "I_DNSProcessor.h"
 
@@ -62,6 +65,12 @@ struct DNSConnection {
     /// Bind to this local address when using IPv4.
     /// Default: unset, bind to INADDRY_ANY.
     sockaddr const *_local_ipv4 = nullptr;
+    /// Run TLS over the TCP connection with this context.
+    /// Default: unset, plain TCP.
+    SSL_CTX *_tls_ctx = nullptr;
+    /// The name sent as SNI and verified in the server certificate.
+    /// Default: unset, no SNI and the certificate is not matched to a name.
+    char const *_tls_server_name = nullptr;
 
     Options();
 
@@ -71,6 +80,8 @@ struct DNSConnection {
     self &setBindRandomPort(bool p);
     self &setLocalIpv6(sockaddr const *addr);
     self &setLocalIpv4(sockaddr const *addr);
+    self &setTlsContext(SSL_CTX *ctx);
+    self &setTlsServerName(char const *name);
   };
 
   int fd;
@@ -81,21 +92,31 @@ struct DNSConnection {
   EventIO eio;
   InkRand generator;
   DNSHandler *handler = nullptr;
+  SSL *ssl            = nullptr;
 
   /// TCPData structure is to track the reading progress of a TCP connection
   struct TCPData {
     Ptr<HostEnt> buf_ptr;
     unsigned short total_length = 0;
+    unsigned short length_done  = 0; ///< Bytes of the length prefix read so far.
     unsigned short done_reading = 0;
     void
     reset()
     {
       buf_ptr.clear();
       total_length = 0;
+      length_done  = 0;
       done_reading = 0;
     }
   } tcp_data;
 
+  /// Queries accepted by @c send but not yet written to a TCP connection.
+  std::vector<unsigned char> write_pending;
+  /// Bytes of @a write_pending already written.
+  size_t write_done = 0;
+  /// EVENTIO_WRITE is set on @a eio.
+  bool write_wanted = false;
+
   int connect(sockaddr const *addr, Options const &opt = DEFAULT_OPTIONS);
   /*
                 bool non_blocking_connect = NON_BLOCKING_CONNECT,
@@ -104,10 +125,30 @@ struct DNSConnection {
   int close();
   void trigger();
 
+  /** Send @a len bytes of @a buf.
+
+      Over TCP whatever is not written at once, or everything while a TLS handshake is in progress,
+      is kept and written by @c flush, so the queries are never cut off.
+
+      @return @a len if the data is written or kept, else a negative errno, -EAGAIN if too much is
+      already kept.
+   */
+  int send(void const *buf, int len);
+  /// Receive up to @a len bytes into @a buf, same as @c recv(2) but returning a negative errno.
+  int recv(void *buf, int len);
+  /// Write the data kept by @c send. @return 0 or a negative errno, -EAGAIN is not an error.
+  int flush();
+
   virtual ~DNSConnection();
   DNSConnection();
 
   static Options const DEFAULT_OPTIONS;
+
+private:
+  /// Drive the TLS handshake. @return 0 once done, else -EAGAIN or a negative errno.
+  int handshake();
+  /// Set or clear EVENTIO_WRITE on @a eio.
+  void want_write(bool flag);
 };
 
 inline DNSConnection::Options::Options() {}
@@ -148,3 +189,15 @@ DNSConnection::Options::setLocalIpv6(sockaddr const *ip)
   _local_ipv6 = ip;
   return *this;
 }
+inline DNSConnection::Options &
+DNSConnection::Options::setTlsContext(SSL_CTX *ctx)
+{
+  _tls_ctx = ctx;
+  return *this;
+}
+inline DNSConnection::Options &
+DNSConnection::Options::setTlsServerName(char const *name)
+{
+  _tls_server_name = name;
+  return *this;
+}
@@ -32,6 +32,7 @@
 #include "I_EventSystem.h"
 
 #define MAX_NAMED 32
+#define MAX_DNS_TCP_CONNECTIONS 8
 #define DEFAULT_DNS_RETRIES 5
 #define MAX_DNS_RETRIES 9
 #define DEFAULT_DNS_TIMEOUT 30
@@ -188,8 +189,9 @@ struct DNSHandler : public Continuation {
   IpEndpoint local_ipv4; ///< Local V4 address if set.
   int ifd[MAX_NAMED];
   int n_con = 0;
-  DNSConnection tcpcon[MAX_NAMED];
+  DNSConnection tcpcon[MAX_NAMED][MAX_DNS_TCP_CONNECTIONS];
   DNSConnection udpcon[MAX_NAMED];
+  int tcp_next[MAX_NAMED]; ///< Pool slot of the TCP connection for the next query.
   Queue<DNSEntry> entries;
   Queue<DNSConnection> triggered;
   int in_flight          = 0;
@@ -252,7 +254,9 @@ struct DNSHandler : public Continuation {
   int mainEvent(int event, Event *e);
 
   void open_cons(sockaddr const *addr, bool failed = false, int icon = 0);
-  void open_con(sockaddr const *addr, bool failed = false, int icon = 0, bool over_tcp = false);
+  void open_con(sockaddr const *addr, bool failed = false, int icon = 0, bool over_tcp = false, int slot = 0);
+  void close_cons(int icon);
+  DNSConnection &next_tcp_con(int icon);
   void failover();
   void rr_failure(int ndx);
   void recover();
@@ -323,8 +327,11 @@ DNSHandler::DNSHandler()
     failover_soon_number[i]    = 0;
     crossed_failover_number[i] = 0;
     ns_down[i]                 = 1;
-    tcpcon[i].handler          = this;
+    tcp_next[i]                = 0;
     udpcon[i].handler          = this;
+    for (auto &con : tcpcon[i]) {
+      con.handler = this;
+    }
   }
   memset(&qid_in_flight, 0, sizeof(qid_in_flight));
   SET_HANDLER(&DNSHandler::startEvent);
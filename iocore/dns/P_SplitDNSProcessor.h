@@ -96,6 +96,9 @@ struct SplitDNS : public ConfigInfo {
 
   DNS_table *m_DNSSrvrTable = nullptr;
 
+  /// Tells the configurations apart for the per thread memo of getDNSRecord().
+  uint64_t m_generation;
+
   int32_t m_SplitDNSlEnable = 0;
 
   /* ----------------------------
@@ -33,6 +33,9 @@
 
 #ifdef SPLIT_DNS
 #include <sys/types.h>
+#include <atomic>
+#include <string>
+#include <unordered_map>
 #include "P_SplitDNS.h"
 #include "tscore/MatcherUtils.h"
 #include "tscore/HostLookup.h"
@@ -50,6 +53,23 @@ ConfigUpdateHandler<SplitDNSConfig> *SplitDNSConfig::splitDNSUpdate = nullptr;
 
 static ClassAllocator<DNSRequestData> DNSReqAllocator("DNSRequestDataAllocator");
 
+/* --------------------------------------------------------------
+   the rule search only depends on the host name, so each thread
+   remembers its result for the names it has seen under the
+   current configuration. The memo is dropped when it is full.
+   -------------------------------------------------------------- */
+static constexpr size_t SDNS_MEMO_MAX = 4096;
+
+static std::atomic<uint64_t> sdns_generation{0};
+
+struct SplitDNSMemo {
+  uint64_t generation = 0;
+  std::string key; // reused to look up without allocating
+  std::unordered_map<std::string, void *> records;
+};
+
+static thread_local SplitDNSMemo sdns_memo;
+
 /* --------------------------------------------------------------
    used by a lot of protocols. We do not have dest ip in most
    cases.
@@ -79,7 +99,7 @@ inline SplitDNSResult::SplitDNSResult() {}
 /* --------------------------------------------------------------
    SplitDNS::SplitDNS()
    -------------------------------------------------------------- */
-SplitDNS::SplitDNS() {}
+SplitDNS::SplitDNS() : m_generation(++sdns_generation) {}
 
 SplitDNS::~SplitDNS()
 {
@@ -185,6 +205,16 @@ SplitDNS::getDNSRecord(const char *hostname)
 {
   Debug("splitdns", "Called SplitDNS::getDNSRecord(%s)", hostname);
 
+  if (sdns_memo.generation != m_generation) {
+    sdns_memo.records.clear();
+    sdns_memo.generation = m_generation;
+  }
+  sdns_memo.key.assign(hostname);
+  auto spot = sdns_memo.records.find(sdns_memo.key);
+  if (spot != sdns_memo.records.end()) {
+    return spot->second;
+  }
+
   DNSRequestData *pRD = DNSReqAllocator.alloc();
   pRD->m_pHost        = hostname;
 
@@ -193,8 +223,14 @@ SplitDNS::getDNSRecord(const char *hostname)
 
   DNSReqAllocator.free(pRD);
 
-  if (DNS_SRVR_SPECIFIED == res.r) {
-    return (void *)&(res.m_rec->m_servers);
+  void *record = (DNS_SRVR_SPECIFIED == res.r) ? (void *)&(res.m_rec->m_servers) : nullptr;
+  if (sdns_memo.records.size() >= SDNS_MEMO_MAX) {
+    sdns_memo.records.clear();
+  }
+  sdns_memo.records.emplace(sdns_memo.key, record);
+
+  if (record) {
+    return record;
   }
 
   Debug("splitdns", "Fail to match a valid splitdns rule, fallback to default dns resolver");
@@ -0,0 +1,293 @@
+/** @file
+
+  Sampling CPU profiler for the event threads.
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ */
+
+#include <atomic>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <execinfo.h>
+#include <sys/time.h>
+
+#include "P_EventSystem.h"
+
+int32_t CpuProfiler::frequency                         = 0;
+thread_local CpuProfiler::Context CpuProfiler::context = {0, 0, nullptr};
+
+namespace
+{
+/// The frames of the signal handler and of the signal trampoline, on top of every stack.
+constexpr int SKIP_FRAMES = 2;
+
+struct Sample {
+  uintptr_t handler;
+  uintptr_t state;
+  const char *hook;
+  int depth;
+  void *frames[CpuProfiler::MAX_FRAMES]; ///< The interrupted frame first.
+};
+
+/// The samples of one thread. These are never freed, the dump can read them at any time.
+struct Ring {
+  char thread_name[MAX_THREAD_NAME_LENGTH];
+  std::atomic<uint64_t> head{0}; ///< # of samples ever written.
+  std::atomic<uint64_t> tail{0}; ///< # of samples dropped by a reset.
+  Sample samples[CpuProfiler::RING_SIZE];
+  Ring *next = nullptr;
+};
+
+thread_local Ring *thread_ring = nullptr;
+std::atomic<Ring *> rings{nullptr};
+
+/// The frequency of the samples taken last, sampling may be off by the time they are written.
+int sampled_hz = 0;
+
+void
+attach_ring()
+{
+  Ring *r = new Ring;
+  ink_get_thread_name(r->thread_name, sizeof(r->thread_name));
+  r->next = rings.load();
+  while (!rings.compare_exchange_weak(r->next, r)) {
+    ;
+  }
+  std::atomic_signal_fence(std::memory_order_release);
+  thread_ring = r;
+}
+
+/// Copy the samples of @a r that are not overwritten meanwhile to @a out.
+void
+copy_ring(Ring *r, std::vector<Sample> &out)
+{
+  uint64_t end   = r->head.load(std::memory_order_acquire);
+  uint64_t begin = end > CpuProfiler::RING_SIZE ? end - CpuProfiler::RING_SIZE : 0;
+  begin          = std::max(begin, r->tail.load(std::memory_order_relaxed));
+  size_t first   = out.size();
+  for (uint64_t i = begin; i < end; ++i) {
+    out.push_back(r->samples[i % CpuProfiler::RING_SIZE]);
+  }
+  // Anything the thread has written over since, or is writing now, is unreliable.
+  uint64_t now = r->head.load(std::memory_order_acquire);
+  if (now + 1 > begin + CpuProfiler::RING_SIZE) {
+    uint64_t lost = std::min(now + 1 - CpuProfiler::RING_SIZE - begin, end - begin);
+    out.erase(out.begin() + first, out.begin() + first + lost);
+  }
+}
+
+bool
+write_collapsed(FILE *fp, std::map<std::string, std::vector<Sample>> const &samples)
+{
+  std::unordered_map<uintptr_t, std::string> symbols;
+  auto symbol = [&symbols](uintptr_t address) -> std::string const & {
+    auto spot = symbols.find(address);
+    if (spot == symbols.end()) {
+      spot = symbols.emplace(address, DispatchTrace::symbol_name(address)).first;
+    }
+    return spot->second;
+  };
+
+  std::map<std::string, uint64_t> stacks;
+  for (auto const &[thread, list] : samples) {
+    for (auto const &s : list) {
+      std::string key = thread;
+      if (s.handler) {
+        key += ';';
+        key += symbol(s.handler);
+      }
+      if (s.state) {
+        key += ';';
+        key += symbol(s.state);
+      }
+      if (s.hook) {
+        key += ";[";
+        key += s.hook;
+        key += ']';
+      }
+      for (int d = s.depth - 1; d >= 0; --d) {
+        key += ';';
+        key += symbol(reinterpret_cast<uintptr_t>(s.frames[d]));
+      }
+      ++stacks[key];
+    }
+  }
+  for (auto const &[key, count] : stacks) {
+    fprintf(fp, "%s %" PRIu64 "\n", key.c_str(), count);
+  }
+  return !ferror(fp);
+}
+
+bool
+write_pprof(FILE *fp, std::map<std::string, std::vector<Sample>> const &samples)
+{
+  std::map<std::vector<uintptr_t>, uintptr_t> stacks;
+  for (auto const &[thread, list] : samples) {
+    for (auto const &s : list) {
+      auto frames = reinterpret_cast<uintptr_t const *>(s.frames);
+      std::vector<uintptr_t> pcs(frames, frames + s.depth);
+      if (s.handler) {
+        pcs.push_back(s.handler);
+      }
+      ++stacks[pcs];
+    }
+  }
+
+  // The header is the # of header words, the version, the sampling period in microseconds and a padding word.
+  std::vector<uintptr_t> words = {0, 3, 0, static_cast<uintptr_t>(1000000 / std::max(sampled_hz, 1)), 0};
+  for (auto const &[pcs, count] : stacks) {
+    words.push_back(count);
+    words.push_back(pcs.size());
+    words.insert(words.end(), pcs.begin(), pcs.end());
+  }
+  // The trailer is an empty sample with a single frame.
+  words.insert(words.end(), {0, 1, 0});
+  fwrite(words.data(), sizeof(uintptr_t), words.size(), fp);
+
+  // pprof needs the mappings to symbolize the addresses.
+  if (FILE *maps = fopen("/proc/self/maps", "r"); maps != nullptr) {
+    char buff[4096];
+    size_t n;
+    while ((n = fread(buff, 1, sizeof(buff), maps)) > 0) {
+      fwrite(buff, 1, n, fp);
+    }
+    fclose(maps);
+  }
+  return !ferror(fp);
+}
+} // namespace
+
+void
+CpuProfiler::handle_signal(int, siginfo_t *, void *)
+{
+  Ring *r = thread_ring;
+  if (r == nullptr) {
+    return;
+  }
+
+  int saved_errno = errno;
+  void *frames[MAX_FRAMES + SKIP_FRAMES];
+  int depth = backtrace(frames, countof(frames)) - SKIP_FRAMES;
+
+  uint64_t n = r->head.load(std::memory_order_relaxed);
+  Sample &s  = r->samples[n % RING_SIZE];
+  s.handler  = context.handler;
+  s.state    = context.state;
+  s.hook     = context.hook;
+  s.depth    = std::max(depth, 0);
+  memcpy(s.frames, frames + SKIP_FRAMES, s.depth * sizeof(void *));
+  r->head.store(n + 1, std::memory_order_release);
+  errno = saved_errno;
+}
+
+void
+CpuProfiler::configure(int hz)
+{
+  static bool installed = false;
+
+  if (hz > 0 && !installed) {
+    // backtrace() loads the unwinder on its first call, which is not safe to do in a signal handler.
+    void *frames[1];
+    backtrace(frames, 1);
+
+    struct sigaction act;
+    memset(&act, 0, sizeof(act));
+    act.sa_sigaction = &CpuProfiler::handle_signal;
+    act.sa_flags     = SA_SIGINFO | SA_RESTART;
+    sigemptyset(&act.sa_mask);
+    if (sigaction(SIGPROF, &act, nullptr) < 0) {
+      Warning("unable to install the CPU profiler signal handler: %s", strerror(errno));
+      return;
+    }
+    installed = true;
+  }
+
+  itimerval timer;
+  memset(&timer, 0, sizeof(timer));
+  if (hz > 0) {
+    frequency                 = hz;
+    sampled_hz                = hz;
+    timer.it_interval.tv_sec  = 1 / hz;
+    timer.it_interval.tv_usec = (1000000 / hz) % 1000000;
+    timer.it_value            = timer.it_interval;
+  }
+  if (setitimer(ITIMER_PROF, &timer, nullptr) < 0) {
+    Warning("unable to set the CPU profiler timer: %s", strerror(errno));
+    hz = 0;
+  }
+  if (hz <= 0) {
+    frequency = 0;
+  }
+  Debug("cpu_profile", "sampling at %d Hz", frequency);
+}
+
+int
+CpuProfiler::dispatch(Continuation *c, int event, void *data)
+{
+  ContinuationHandler h = c->handler;
+
+  if (thread_ring == nullptr) {
+    attach_ring();
+  }
+
+  // The handler may free @a c, take all that is needed from it first.
+  uintptr_t outer = context.handler;
+  context.handler = DispatchTrace::handler_address(h);
+  std::atomic_signal_fence(std::memory_order_release);
+  int ret         = (c->*h)(event, data);
+  context.handler = outer;
+
+  return ret;
+}
+
+void
+CpuProfiler::reset()
+{
+  for (Ring *r = rings.load(); r; r = r->next) {
+    r->tail.store(r->head.load(std::memory_order_acquire), std::memory_order_relaxed);
+  }
+}
+
+bool
+CpuProfiler::dump(const char *path, Format format)
+{
+  std::map<std::string, std::vector<Sample>> samples;
+  size_t count = 0;
+
+  for (Ring *r = rings.load(); r; r = r->next) {
+    std::vector<Sample> &list = samples[r->thread_name];
+    copy_ring(r, list);
+    count += list.size();
+  }
+
+  FILE *fp = fopen(path, "w");
+  if (!fp) {
+    Warning("unable to write the CPU profile to '%s': %s", path, strerror(errno));
+    return false;
+  }
+  bool ok = format == PPROF ? write_pprof(fp, samples) : write_collapsed(fp, samples);
+  if (fclose(fp) != 0 || !ok) {
+    Warning("unable to write the CPU profile to '%s': %s", path, strerror(errno));
+    return false;
+  }
+  Note("CPU profile of %zu samples written to '%s'", count, path);
+  return true;
+}
@@ -0,0 +1,203 @@
+/** @file
+
+  Sampled tracing of continuation dispatch.
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ */
+
+#include <atomic>
+#include <map>
+#include <string>
+#include <cxxabi.h>
+#include <dlfcn.h>
+
+#include "P_EventSystem.h"
+
+int32_t DispatchTrace::sample_rate        = 0;
+thread_local int DispatchTrace::nesting   = 0;
+thread_local int DispatchTrace::countdown = 0;
+
+namespace
+{
+struct Frame {
+  uintptr_t handler;
+  const char *name; ///< From @c SET_HANDLER, only set in debug builds.
+  int event;
+};
+
+struct Call {
+  ink_hrtime self;
+  int depth;
+  Frame stack[DispatchTrace::MAX_DEPTH];
+};
+
+/// The trace of one thread. These are never freed, the dump can read them at any time.
+struct Ring {
+  char thread_name[MAX_THREAD_NAME_LENGTH];
+  Frame stack[DispatchTrace::MAX_DEPTH];
+  ink_hrtime child[DispatchTrace::MAX_DEPTH]; ///< Time of the finished nested calls at each depth.
+  std::atomic<uint64_t> head{0};              ///< # of calls ever written.
+  Call calls[DispatchTrace::RING_SIZE];
+  Ring *next = nullptr;
+};
+
+thread_local Ring *thread_ring = nullptr;
+std::atomic<Ring *> rings{nullptr};
+
+Ring *
+attach_ring()
+{
+  Ring *r = new Ring;
+  ink_get_thread_name(r->thread_name, sizeof(r->thread_name));
+  r->next = rings.load();
+  while (!rings.compare_exchange_weak(r->next, r)) {
+    ;
+  }
+  thread_ring = r;
+  return r;
+}
+
+/// A label for @a f naming the handler and the event.
+std::string
+frame_label(Frame const &f, DispatchTrace::EventNamer namer)
+{
+  std::string label;
+  char buff[64];
+
+  if (f.name) {
+    label = f.name[0] == '&' ? f.name + 1 : f.name;
+  } else {
+    label = DispatchTrace::symbol_name(f.handler);
+  }
+  const char *event = namer ? namer(f.event, sizeof(buff), buff) : nullptr;
+  if (!event) {
+    snprintf(buff, sizeof(buff), "%d", f.event);
+    event = buff;
+  }
+  label += '[';
+  label += event;
+  label += ']';
+  return label;
+}
+} // namespace
+
+std::string
+DispatchTrace::symbol_name(uintptr_t address)
+{
+  std::string name;
+  Dl_info info;
+
+  if (address && dladdr(reinterpret_cast<void *>(address), &info) && info.dli_sname) {
+    int status;
+    char *demangled = abi::__cxa_demangle(info.dli_sname, nullptr, nullptr, &status);
+    name            = demangled ? demangled : info.dli_sname;
+    free(demangled);
+  } else {
+    char buff[32];
+    snprintf(buff, sizeof(buff), "0x%" PRIxPTR, address);
+    name = buff;
+  }
+  // Drop the argument list, every handler has the same one.
+  auto paren = name.find('(');
+  if (paren != std::string::npos) {
+    name.erase(paren);
+  }
+  return name;
+}
+
+int
+DispatchTrace::dispatch(Continuation *c, int event, void *data)
+{
+  ContinuationHandler h = c->handler;
+
+  if (nesting >= MAX_DEPTH) {
+    return (c->*h)(event, data);
+  }
+
+  Ring *r   = thread_ring ? thread_ring : attach_ring();
+  int depth = nesting++;
+
+  // The handler may free @a c, take all that is needed from it first.
+#ifdef DEBUG
+  r->stack[depth] = Frame{handler_address(h), c->handler_name, event};
+#else
+  r->stack[depth] = Frame{handler_address(h), nullptr, event};
+#endif
+  r->child[depth] = 0;
+
+  ink_hrtime start = ink_get_hrtime_internal();
+  int ret          = (c->*h)(event, data);
+  ink_hrtime total = ink_get_hrtime_internal() - start;
+
+  --nesting;
+  if (depth > 0) {
+    r->child[depth - 1] += total;
+  }
+
+  uint64_t n = r->head.load(std::memory_order_relaxed);
+  Call &call = r->calls[n % RING_SIZE];
+  call.self  = total - r->child[depth];
+  call.depth = depth + 1;
+  memcpy(call.stack, r->stack, (depth + 1) * sizeof(Frame));
+  r->head.store(n + 1, std::memory_order_release);
+
+  return ret;
+}
+
+bool
+DispatchTrace::dump(const char *path, EventNamer namer)
+{
+  std::map<std::string, ink_hrtime> stacks;
+  Call *copy = new Call[RING_SIZE];
+
+  for (Ring *r = rings.load(); r; r = r->next) {
+    uint64_t end   = r->head.load(std::memory_order_acquire);
+    uint64_t begin = end > RING_SIZE ? end - RING_SIZE : 0;
+    for (uint64_t i = begin; i < end; ++i) {
+      copy[i % RING_SIZE] = r->calls[i % RING_SIZE];
+    }
+    // Anything the thread has written over since, or is writing now, is unreliable.
+    uint64_t now = r->head.load(std::memory_order_acquire);
+    if (now + 1 > begin + RING_SIZE) {
+      begin = now + 1 - RING_SIZE;
+    }
+    for (uint64_t i = begin; i < end; ++i) {
+      Call const &call = copy[i % RING_SIZE];
+      std::string key  = r->thread_name;
+      for (int d = 0; d < call.depth && d < MAX_DEPTH; ++d) {
+        key += ';';
+        key += frame_label(call.stack[d], namer);
+      }
+      stacks[key] += call.self;
+    }
+  }
+  delete[] copy;
+
+  FILE *fp = fopen(path, "w");
+  if (!fp) {
+    Warning("unable to write the dispatch trace to '%s': %s", path, strerror(errno));
+    return false;
+  }
+  for (auto const &[key, ns] : stacks) {
+    fprintf(fp, "%s %" PRId64 "\n", key.c_str(), ns);
+  }
+  fclose(fp);
+  Note("dispatch trace of %zu call stacks written to '%s'", stacks.size(), path);
+  return true;
+}
@@ -30,12 +30,24 @@
 
 #include "P_EventSystem.h"
 
+static int
+cpu_profile_update(const char * /* name */, RecDataT /* data_type */, RecData data, void * /* cookie */)
+{
+  CpuProfiler::configure(data.rec_int);
+  return REC_ERR_OKAY;
+}
+
 void
 ink_event_system_init(ts::ModuleVersion v)
 {
   ink_release_assert(v.check(EVENT_SYSTEM_MODULE_INTERNAL_VERSION));
   int config_max_iobuffer_size = DEFAULT_MAX_BUFFER_SIZE;
   int iobuffer_advice          = 0;
+  int magazine_size            = 0;
+  int iobuffer_slab            = 0;
+  int iobuffer_slab_trim       = 0;
+  int lock_profile             = 0;
+  int cpu_profile              = 0;
 
   // For backwards compatibility make sure to allow thread_freelist_size
   // This needs to change in 6.0
@@ -45,6 +57,20 @@ ink_event_system_init(ts::ModuleVersion v)
 
   REC_ReadConfigInteger(config_max_iobuffer_size, "proxy.config.io.max_buffer_size");
 
+  REC_EstablishStaticConfigInt32(DispatchTrace::sample_rate, "proxy.config.exec_thread.dispatch_trace");
+
+  REC_ReadConfigInteger(cpu_profile, "proxy.config.exec_thread.cpu_profile");
+  if (cpu_profile > 0) {
+    CpuProfiler::configure(cpu_profile);
+  }
+  RecRegisterConfigUpdateCb("proxy.config.exec_thread.cpu_profile", &cpu_profile_update, nullptr);
+
+  REC_ReadConfigInteger(lock_profile, "proxy.config.lock_profiling");
+  lock_profiling = lock_profile != 0;
+
+  REC_ReadConfigInteger(magazine_size, "proxy.config.allocator.magazine_size");
+  ink_freelist_init_magazines(magazine_size);
+
   max_iobuffer_size = buffer_size_to_index(config_max_iobuffer_size, DEFAULT_BUFFER_SIZES - 1);
   if (default_small_iobuffer_size > max_iobuffer_size) {
     default_small_iobuffer_size = max_iobuffer_size;
@@ -63,4 +89,8 @@ ink_event_system_init(ts::ModuleVersion v)
 #endif
 
   init_buffer_allocators(iobuffer_advice);
+
+  REC_ReadConfigInteger(iobuffer_slab, "proxy.config.allocator.iobuffer_slab");
+  REC_ReadConfigInteger(iobuffer_slab_trim, "proxy.config.allocator.iobuffer_slab_trim_interval");
+  init_buffer_slabs(iobuffer_slab != 0, iobuffer_advice, iobuffer_slab_trim);
 }
@@ -198,6 +198,32 @@ MIOBuffer::puts(char *s, int64_t len)
   return 0;
 }
 
+int64_t
+MIOBuffer::release_blocks()
+{
+  int64_t size = 0;
+
+  for (auto &reader : readers) {
+    if (reader.allocated() && reader.is_read_avail_more_than(0)) {
+      return 0; // Data not read yet, keep it.
+    }
+  }
+
+  _writer = nullptr;
+  for (auto &reader : readers) {
+    if (reader.allocated()) {
+      // The readers share the blocks, count the longest chain.
+      int64_t n = 0;
+      for (IOBufferBlock *b = reader.block.get(); b; b = b->next.get()) {
+        n += b->block_size();
+      }
+      size = std::max(size, n);
+      reader.reset();
+    }
+  }
+  return size;
+}
+
 int64_t
 IOBufferReader::read(void *ab, int64_t len)
 {
@@ -256,6 +282,35 @@ IOBufferReader::memchr(char c, int64_t len, int64_t offset)
   return -1;
 }
 
+int64_t
+IOBufferReader::get_iovec(IOVec *vec, int *niov, int64_t len, int64_t offset)
+{
+  IOBufferBlock *b = block.get();
+  int64_t total    = 0;
+  int n            = 0;
+  offset += start_offset;
+
+  while (b && len > 0 && n < *niov) {
+    int64_t max_bytes = b->read_avail();
+    max_bytes -= offset;
+    if (max_bytes <= 0) {
+      offset = -max_bytes;
+      b      = b->next.get();
+      continue;
+    }
+    int64_t bytes     = std::min(len, max_bytes);
+    vec[n].iov_base   = b->start() + offset;
+    vec[n++].iov_len  = bytes;
+    total            += bytes;
+    len              -= bytes;
+    b                 = b->next.get();
+    offset            = 0;
+  }
+
+  *niov = n;
+  return total;
+}
+
 char *
 IOBufferReader::memcpy(void *ap, int64_t len, int64_t offset)
 {
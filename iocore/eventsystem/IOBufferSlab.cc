@@ -0,0 +1,412 @@
+/** @file
+
+  Slab allocator for IOBuffer data blocks between the power of two sizes.
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ */
+
+// Data sized to its content, cache fragments in particular, rounds up to the next power of two
+// with the fast allocators, so a 9K fragment holds on to a 16K block. The slab classes add three
+// sizes between each power of two from 8K up, each a multiple of 4K so disk I/O stays aligned.
+//
+// Blocks are carved from slabs, naturally aligned mappings of a power of two size, the slab of a
+// block is found by masking its address. A slab whose blocks are all free is kept for reuse and
+// unmapped once it has stayed empty for the trim interval, unlike the freelists which never give
+// memory back. Each thread caches a few blocks per class so most allocations take no lock.
+
+#include <sys/mman.h>
+
+#include "P_EventSystem.h"
+
+const int64_t iobuffer_slab_sizes[BUFFER_SIZE_SLAB_CLASSES] = {
+  12 << 10,  20 << 10,  24 << 10,  28 << 10,  40 << 10,  48 << 10,  56 << 10,  80 << 10,  96 << 10,  112 << 10,
+  160 << 10, 192 << 10, 224 << 10, 320 << 10, 384 << 10, 448 << 10, 640 << 10, 768 << 10, 896 << 10,
+};
+
+bool iobuffer_slab_enabled = false;
+
+namespace
+{
+#define SLAB_HEADER_SIZE 4096
+#define SLAB_MIN_SIZE (256 * 1024)
+#define SLAB_MIN_BLOCKS 8
+#define SLAB_THREAD_CACHE_BYTES (256 * 1024)
+#define SLAB_THREAD_CACHE_MAX 8
+
+// Request statistics cover the fast sizes and the slab classes.
+#define SLAB_STAT_CLASSES (DEFAULT_BUFFER_SIZES + BUFFER_SIZE_SLAB_CLASSES)
+
+struct IOBufferSlabClass;
+
+struct IOBufferSlab {
+  IOBufferSlabClass *cls;
+  void *free;           ///< Blocks given back.
+  int used;             ///< Blocks handed out.
+  int carved;           ///< Blocks taken from the slab so far, the rest has never been touched.
+  ink_hrtime empty_at;  ///< When @a used dropped to 0.
+  LINK(IOBufferSlab, link);
+};
+
+struct IOBufferSlabClass {
+  ink_mutex lock = PTHREAD_MUTEX_INITIALIZER;
+  int64_t size      = 0;
+  int64_t slab_size = 0;
+  int per_slab      = 0;
+  int cache_max     = 0; ///< Blocks a thread may keep.
+  DLL<IOBufferSlab> partial;
+  Queue<IOBufferSlab> empty; ///< Newest at the head.
+};
+
+IOBufferSlabClass slab_class[BUFFER_SIZE_SLAB_CLASSES];
+int slab_advice          = 0;
+ink_hrtime slab_trim_age = 0;
+std::atomic<int64_t> slab_bytes{0};
+
+// Per thread block caches and request counters.
+struct IOBufferSlabThread {
+  struct {
+    void *head;
+    int count;
+  } cache[BUFFER_SIZE_SLAB_CLASSES] = {};
+  int64_t requests[SLAB_STAT_CLASSES] = {0};
+  int64_t waste[SLAB_STAT_CLASSES]    = {0};
+  bool registered                     = false;
+  LINK(IOBufferSlabThread, link);
+
+  ~IOBufferSlabThread();
+};
+
+ink_mutex slab_threads_lock = PTHREAD_MUTEX_INITIALIZER;
+DLL<IOBufferSlabThread> slab_threads;
+// Counters of threads that are gone, under slab_threads_lock.
+int64_t slab_retired_requests[SLAB_STAT_CLASSES];
+int64_t slab_retired_waste[SLAB_STAT_CLASSES];
+
+thread_local IOBufferSlabThread slab_thread;
+
+IOBufferSlabThread *
+slab_this_thread()
+{
+  IOBufferSlabThread *t = &slab_thread;
+  if (unlikely(!t->registered)) {
+    ink_scoped_mutex_lock lock(slab_threads_lock);
+    slab_threads.push(t);
+    t->registered = true;
+  }
+  return t;
+}
+
+int
+stat_class(int64_t size_index)
+{
+  if (BUFFER_SIZE_INDEX_IS_FAST_ALLOCATED(size_index)) {
+    return size_index;
+  }
+  if (BUFFER_SIZE_INDEX_IS_SLAB(size_index)) {
+    return DEFAULT_BUFFER_SIZES + (size_index - BUFFER_SIZE_INDEX_SLAB_BASE);
+  }
+  return -1;
+}
+
+int64_t
+stat_class_size(int c)
+{
+  return c < DEFAULT_BUFFER_SIZES ? BUFFER_SIZE_FOR_INDEX(c) : iobuffer_slab_sizes[c - DEFAULT_BUFFER_SIZES];
+}
+
+IOBufferSlab *
+slab_of(IOBufferSlabClass *cls, void *ptr)
+{
+  return reinterpret_cast<IOBufferSlab *>(reinterpret_cast<uintptr_t>(ptr) & ~static_cast<uintptr_t>(cls->slab_size - 1));
+}
+
+IOBufferSlab *
+slab_map(IOBufferSlabClass *cls)
+{
+  // Map twice the size and cut it down to an aligned slab.
+  size_t len = cls->slab_size * 2;
+  void *m    = mmap(nullptr, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (m == MAP_FAILED) {
+    ink_fatal("failed to map a %" PRId64 " byte IOBuffer slab: %s", cls->slab_size, strerror(errno));
+  }
+  uintptr_t start = reinterpret_cast<uintptr_t>(m);
+  uintptr_t slab  = INK_ALIGN(start, static_cast<uintptr_t>(cls->slab_size));
+  if (slab > start) {
+    munmap(m, slab - start);
+  }
+  if (slab + cls->slab_size < start + len) {
+    munmap(reinterpret_cast<void *>(slab + cls->slab_size), start + len - slab - cls->slab_size);
+  }
+  if (slab_advice) {
+    ats_madvise(reinterpret_cast<caddr_t>(slab), cls->slab_size, slab_advice);
+  }
+  slab_bytes += cls->slab_size;
+
+  IOBufferSlab *s = reinterpret_cast<IOBufferSlab *>(slab);
+  s->cls          = cls;
+  s->free         = nullptr;
+  s->used         = 0;
+  s->carved       = 0;
+  s->empty_at     = 0;
+  s->link.next    = nullptr;
+  s->link.prev    = nullptr;
+  return s;
+}
+
+void
+slab_unmap(IOBufferSlab *s)
+{
+  int64_t size = s->cls->slab_size;
+  munmap(s, size);
+  slab_bytes -= size;
+}
+
+void *
+slab_take(IOBufferSlabClass *cls)
+{
+  ink_scoped_mutex_lock lock(cls->lock);
+  IOBufferSlab *s = cls->partial.head;
+  if (!s) {
+    if ((s = cls->empty.pop()) == nullptr) {
+      s = slab_map(cls);
+    }
+    cls->partial.push(s);
+  }
+
+  void *ptr;
+  if (s->free) {
+    ptr     = s->free;
+    s->free = *static_cast<void **>(ptr);
+  } else {
+    ptr = reinterpret_cast<char *>(s) + SLAB_HEADER_SIZE + s->carved * cls->size;
+    ++s->carved;
+  }
+  if (++s->used == cls->per_slab) {
+    // Full slabs are on no list, they come back with their first free block.
+    cls->partial.remove(s);
+  }
+  return ptr;
+}
+
+void
+slab_give(IOBufferSlabClass *cls, void *ptr)
+{
+  ink_scoped_mutex_lock lock(cls->lock);
+  IOBufferSlab *s = slab_of(cls, ptr);
+
+  ink_assert(s->cls == cls && s->used > 0);
+  *static_cast<void **>(ptr) = s->free;
+  s->free                    = ptr;
+  if (s->used-- == cls->per_slab) {
+    cls->partial.push(s);
+  }
+  if (s->used == 0) {
+    cls->partial.remove(s);
+    s->empty_at = Thread::get_hrtime_updated();
+    cls->empty.push(s);
+  }
+}
+
+// Unmap the slabs that have been empty for the trim interval.
+void
+slab_trim(IOBufferSlabClass *cls, ink_hrtime now)
+{
+  DLL<IOBufferSlab> trimmed;
+  {
+    ink_scoped_mutex_lock lock(cls->lock);
+    IOBufferSlab *s = cls->empty.tail;
+    while (s && now - s->empty_at >= slab_trim_age) {
+      IOBufferSlab *prev = s->link.prev;
+      cls->empty.remove(s);
+      trimmed.push(s);
+      s = prev;
+    }
+  }
+  while (IOBufferSlab *s = trimmed.pop()) {
+    slab_unmap(s);
+  }
+}
+
+struct IOBufferSlabTrimmer : public Continuation {
+  IOBufferSlabTrimmer() : Continuation(new_ProxyMutex()) { SET_HANDLER(&IOBufferSlabTrimmer::trim); }
+
+  int
+  trim(int, Event *)
+  {
+    ink_hrtime now = Thread::get_hrtime_updated();
+    for (auto &cls : slab_class) {
+      slab_trim(&cls, now);
+    }
+    return EVENT_CONT;
+  }
+};
+
+IOBufferSlabThread::~IOBufferSlabThread()
+{
+  for (int c = 0; c < BUFFER_SIZE_SLAB_CLASSES; ++c) {
+    while (void *ptr = cache[c].head) {
+      cache[c].head = *static_cast<void **>(ptr);
+      slab_give(&slab_class[c], ptr);
+    }
+  }
+  if (registered) {
+    ink_scoped_mutex_lock lock(slab_threads_lock);
+    for (int c = 0; c < SLAB_STAT_CLASSES; ++c) {
+      slab_retired_requests[c] += requests[c];
+      slab_retired_waste[c] += waste[c];
+    }
+    slab_threads.remove(this);
+  }
+}
+
+enum {
+  SLAB_STAT_BYTES,
+  SLAB_STAT_REQUESTS,
+  SLAB_STAT_WASTE = SLAB_STAT_REQUESTS + SLAB_STAT_CLASSES,
+  SLAB_STAT_COUNT = SLAB_STAT_WASTE + SLAB_STAT_CLASSES,
+};
+
+void
+set_stat(RecRawStatBlock *rsb, int id, int64_t value)
+{
+  rsb->global[id]->sum   = value;
+  rsb->global[id]->count = 1;
+  RecRawStatUpdateSum(rsb, id);
+}
+
+int
+slab_stat_sync(const char *, RecDataT, RecData *, RecRawStatBlock *rsb, int)
+{
+  int64_t requests[SLAB_STAT_CLASSES];
+  int64_t waste[SLAB_STAT_CLASSES];
+  {
+    ink_scoped_mutex_lock lock(slab_threads_lock);
+    memcpy(requests, slab_retired_requests, sizeof(requests));
+    memcpy(waste, slab_retired_waste, sizeof(waste));
+    for (IOBufferSlabThread *t = slab_threads.head; t; t = t->link.next) {
+      for (int c = 0; c < SLAB_STAT_CLASSES; ++c) {
+        requests[c] += t->requests[c];
+        waste[c] += t->waste[c];
+      }
+    }
+  }
+
+  ink_mutex_acquire(&(rsb->mutex));
+  set_stat(rsb, SLAB_STAT_BYTES, slab_bytes.load());
+  for (int c = 0; c < SLAB_STAT_CLASSES; ++c) {
+    set_stat(rsb, SLAB_STAT_REQUESTS + c, requests[c]);
+    set_stat(rsb, SLAB_STAT_WASTE + c, waste[c]);
+  }
+  ink_mutex_release(&(rsb->mutex));
+
+  return REC_ERR_OKAY;
+}
+} // namespace
+
+void
+init_buffer_slabs(bool enabled, int iobuffer_advice, int trim_interval)
+{
+  for (int c = 0; c < BUFFER_SIZE_SLAB_CLASSES; ++c) {
+    IOBufferSlabClass &cls = slab_class[c];
+    cls.size               = iobuffer_slab_sizes[c];
+    cls.slab_size          = SLAB_MIN_SIZE;
+    while (cls.slab_size - SLAB_HEADER_SIZE < SLAB_MIN_BLOCKS * cls.size) {
+      cls.slab_size *= 2;
+    }
+    cls.per_slab  = (cls.slab_size - SLAB_HEADER_SIZE) / cls.size;
+    cls.cache_max = std::max(1, std::min<int>(SLAB_THREAD_CACHE_MAX, SLAB_THREAD_CACHE_BYTES / cls.size));
+  }
+  slab_advice           = iobuffer_advice;
+  slab_trim_age         = HRTIME_SECONDS(trim_interval);
+  iobuffer_slab_enabled = enabled;
+
+  RecRawStatBlock *rsb = RecAllocateRawStatBlock(SLAB_STAT_COUNT);
+  char name[256];
+
+  RecRegisterRawStat(rsb, RECT_PROCESS, "proxy.process.allocator.iobuffer.slab_bytes", RECD_INT, RECP_NON_PERSISTENT,
+                     SLAB_STAT_BYTES, nullptr);
+  for (int c = 0; c < SLAB_STAT_CLASSES; ++c) {
+    snprintf(name, sizeof(name), "proxy.process.allocator.iobuffer.%" PRId64 ".requests", stat_class_size(c));
+    RecRegisterRawStat(rsb, RECT_PROCESS, name, RECD_INT, RECP_NON_PERSISTENT, SLAB_STAT_REQUESTS + c, nullptr);
+    snprintf(name, sizeof(name), "proxy.process.allocator.iobuffer.%" PRId64 ".waste", stat_class_size(c));
+    RecRegisterRawStat(rsb, RECT_PROCESS, name, RECD_INT, RECP_NON_PERSISTENT, SLAB_STAT_WASTE + c, nullptr);
+  }
+  RecRegisterRawStatSyncCb("proxy.process.allocator.iobuffer.slab_bytes", slab_stat_sync, rsb, 0);
+}
+
+void
+start_buffer_slab_trim()
+{
+  if (iobuffer_slab_enabled && slab_trim_age > 0) {
+    eventProcessor.schedule_every(new IOBufferSlabTrimmer, slab_trim_age, ET_TASK);
+  }
+}
+
+int
+iobuffer_slab_class(int64_t size)
+{
+  if (size <= BUFFER_SIZE_FOR_INDEX(BUFFER_SIZE_INDEX_8K) || size > iobuffer_slab_sizes[BUFFER_SIZE_SLAB_CLASSES - 1]) {
+    return -1;
+  }
+  int c = 0;
+  while (iobuffer_slab_sizes[c] < size) {
+    ++c;
+  }
+  return c;
+}
+
+void
+iobuffer_size_request(int64_t size_index, int64_t size)
+{
+  int c = stat_class(size_index);
+  if (c >= 0) {
+    IOBufferSlabThread *t = slab_this_thread();
+    ++t->requests[c];
+    t->waste[c] += stat_class_size(c) - size;
+  }
+}
+
+void *
+iobuffer_slab_alloc(int64_t size_index)
+{
+  int c                 = size_index - BUFFER_SIZE_INDEX_SLAB_BASE;
+  IOBufferSlabThread *t = &slab_thread;
+
+  if (void *ptr = t->cache[c].head) {
+    t->cache[c].head = *static_cast<void **>(ptr);
+    --t->cache[c].count;
+    return ptr;
+  }
+  return slab_take(&slab_class[c]);
+}
+
+void
+iobuffer_slab_free(int64_t size_index, void *ptr)
+{
+  int c                 = size_index - BUFFER_SIZE_INDEX_SLAB_BASE;
+  IOBufferSlabThread *t = &slab_thread;
+
+  if (t->cache[c].count < slab_class[c].cache_max) {
+    *static_cast<void **>(ptr) = t->cache[c].head;
+    t->cache[c].head           = ptr;
+    ++t->cache[c].count;
+    return;
+  }
+  slab_give(&slab_class[c], ptr);
+}
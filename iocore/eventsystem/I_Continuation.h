@@ -39,6 +39,8 @@
 #include "tscore/List.h"
 #include "I_Lock.h"
 #include "tscore/ContFlags.h"
+#include "I_DispatchTrace.h"
+#include "I_CpuProfiler.h"
 
 class Continuation;
 class ContinuationQueue;
@@ -187,6 +189,12 @@ public:
   {
     // If there is a lock, we must be holding it on entry
     ink_release_assert(!mutex || mutex->thread_holding == this_ethread());
+    if (unlikely(DispatchTrace::sampled())) {
+      return DispatchTrace::dispatch(this, event, data);
+    }
+    if (unlikely(CpuProfiler::running())) {
+      return CpuProfiler::dispatch(this, event, data);
+    }
     return (this->*handler)(event, data);
   }
 
@@ -0,0 +1,145 @@
+/** @file
+
+  Sampling CPU profiler for the event threads.
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+ */
+
+#pragma once
+
+#include <csignal>
+#include <cstdint>
+
+#include "tscore/ink_defs.h"
+#include "I_DispatchTrace.h"
+
+class Continuation;
+
+/** Sampling CPU profiler.
+
+    While @a frequency is set, @c SIGPROF is raised that many times per second of CPU time used by
+    the process. The handler takes the stack of the interrupted thread into a ring buffer of that
+    thread, along with the continuation handler being dispatched, and the state and plugin hook it
+    was annotated with by @c Scope. A thread gets a ring on its first dispatch while sampling, the
+    samples of threads that don't dispatch continuations are dropped. @c dump writes the samples of
+    all threads out as collapsed stacks or as a gperftools CPU profile read by @c pprof.
+
+    The cost of @c handleEvent is a single test while @a frequency is 0.
+ */
+class CpuProfiler
+{
+public:
+  /// Frames kept per sample.
+  static constexpr int MAX_FRAMES = 32;
+  /// Samples kept per thread.
+  static constexpr int RING_SIZE = 2048;
+
+  /// Samples per second of CPU time, 0 to disable.
+  static int32_t frequency;
+
+  enum Format {
+    COLLAPSED, ///< One line per stack, the input of flame graph tools.
+    PPROF,     ///< The gperftools binary CPU profile.
+  };
+
+  /// Check if samples are taken.
+  static bool
+  running()
+  {
+    return frequency > 0;
+  }
+
+  /// Start, retime or stop (@a hz 0) the sampling.
+  static void configure(int hz);
+
+  /// Call the handler of @a c, with the handler attached to the samples taken meanwhile.
+  static int dispatch(Continuation *c, int event, void *data);
+
+  /** Annotate the samples taken on this thread while in scope.
+
+      @a state is the code address of a handler, as per @c DispatchTrace::handler_address, @a hook
+      the name of a plugin hook. Either is kept as of the enclosing scope if not given.
+   */
+  class Scope
+  {
+  public:
+    explicit Scope(uintptr_t state, const char *hook = nullptr);
+    explicit Scope(const char *hook) : Scope(0, hook) {}
+    ~Scope();
+
+    Scope(const Scope &)            = delete;
+    Scope &operator=(const Scope &) = delete;
+
+  private:
+    uintptr_t _state  = 0;
+    const char *_hook = nullptr;
+    bool _active      = false;
+  };
+
+  /** Write the samples of every thread to @a path in @a format.
+
+      Collapsed stacks start with the thread name, the dispatched handler, the state and the hook,
+      followed by the frames from the outermost one to the one that was interrupted, separated by
+      ';' and followed by the number of samples. A gperftools profile keeps the dispatched handler
+      as the outermost frame, the state and the hook are left out. The rings are read while they
+      are written to, samples that are overwritten while being copied are skipped.
+
+      @return @c true if the file was written.
+   */
+  static bool dump(const char *path, Format format = COLLAPSED);
+
+  /// Drop the samples taken so far.
+  static void reset();
+
+private:
+  /// What the current thread is doing, as of the last dispatch and scope.
+  struct Context {
+    uintptr_t handler;
+    uintptr_t state;
+    const char *hook;
+  };
+
+  static thread_local Context context;
+
+  static void handle_signal(int sig, siginfo_t *info, void *ucontext);
+};
+
+inline CpuProfiler::Scope::Scope(uintptr_t state, const char *hook)
+{
+  if (unlikely(running())) {
+    _active = true;
+    _state  = context.state;
+    _hook   = context.hook;
+    if (state) {
+      context.state = state;
+    }
+    if (hook) {
+      context.hook = hook;
+    }
+  }
+}
+
+inline CpuProfiler::Scope::~Scope()
+{
+  if (_active) {
+    context.state = _state;
+    context.hook  = _hook;
+  }
+}
@@ -0,0 +1,108 @@
+/** @file
+
+  Sampled tracing of continuation dispatch.
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+#include "tscore/ink_defs.h"
+
+class Continuation;
+
+/** Sampled tracing of @c Continuation::handleEvent.
+
+    One in @a sample_rate dispatches is timed, along with every dispatch made from inside it, so a
+    sample is a whole call tree rooted at an event loop or I/O callback. Each finished call is
+    written to a ring buffer of the dispatching thread with the handlers on its stack, the event
+    and its own time, not counting the nested calls. @c dump folds the rings of all threads into the
+    collapsed stack format read by flame graph tools.
+
+    Nothing is recorded and the cost of @c handleEvent is a single test while @a sample_rate is 0.
+ */
+class DispatchTrace
+{
+public:
+  /// Calls nested deeper than this are accounted to their ancestor at this depth.
+  static constexpr int MAX_DEPTH = 8;
+  /// Calls kept per thread.
+  static constexpr int RING_SIZE = 1024;
+
+  /// Trace one in this many top level dispatches, 0 to disable.
+  static int32_t sample_rate;
+
+  /// Check if this dispatch on the current thread is traced.
+  static bool
+  sampled()
+  {
+    if (likely(sample_rate <= 0)) {
+      return false;
+    }
+    if (nesting > 0) {
+      return true;
+    }
+    if (--countdown > 0) {
+      return false;
+    }
+    countdown = sample_rate;
+    return true;
+  }
+
+  /// Call the handler of @a c, recording the call.
+  static int dispatch(Continuation *c, int event, void *data);
+
+  /// The code address of the member function @a h. Virtual functions have no fixed address and give 0.
+  template <typename H>
+  static uintptr_t
+  handler_address(H h)
+  {
+    // Itanium ABI, a member function pointer is the function address or 1 + the vtable offset,
+    // followed by the this adjustment.
+    uintptr_t ptr;
+    memcpy(&ptr, &h, sizeof(ptr));
+    return (ptr & 1) ? 0 : ptr;
+  }
+
+  /// The demangled name of the function containing @a address, without its argument list.
+  static std::string symbol_name(uintptr_t address);
+
+  /// Name an event code into @a buffer, @c event_int_to_string has this signature.
+  using EventNamer = const char *(*)(int event, int blen, char *buffer);
+
+  /** Write the traced calls of every thread to @a path in collapsed stack format.
+
+      Each line is the thread name and the handlers down to a call, separated by ';', followed by
+      the nanoseconds spent in that call itself. Events are shown by @a namer if given, as numbers
+      otherwise. The rings are read while they are written to, calls that are overwritten while
+      being copied are skipped.
+
+      @return @c true if the file was written.
+   */
+  static bool dump(const char *path, EventNamer namer = nullptr);
+
+private:
+  static thread_local int nesting;   ///< # of traced calls active on this thread.
+  static thread_local int countdown; ///< Dispatches until the next sample.
+};
@@ -24,8 +24,13 @@
 
 #pragma once
 
+#include <atomic>
+#include <utility>
+#include <vector>
+
 #include "tscore/ink_platform.h"
 #include "tscore/ink_rand.h"
+#include "tscore/LatencyHistogram.h"
 #include "tscore/I_Version.h"
 #include "I_Thread.h"
 #include "I_PriorityEventQueue.h"
@@ -314,11 +319,40 @@ public:
   ProtectedQueue EventQueueExternal;
   PriorityEventQueue EventQueue;
 
+  /** Immediate events of a work stealing thread group.
+
+      These are run in order by this thread, and taken from the head by the other threads of
+      @a steal_group when they have nothing else to do. Only events whose continuation has its
+      own mutex are queued here, see @c EventProcessor::schedule.
+  */
+  ink_mutex steal_lock = PTHREAD_MUTEX_INITIALIZER;
+  Que(Event, link) steal_queue;
+  std::atomic<int> steal_queue_size = 0;
+  EventType steal_group             = -1; ///< Thread group to steal from, -1 if none.
+  uint64_t steal_queued             = 0;  ///< Events put on @a steal_queue, under @a steal_lock.
+  uint64_t steal_stolen             = 0;  ///< Events this thread took from other threads.
+
+  /// Queue @a e on @a steal_queue, returns the queue length including @a e.
+  int steal_enqueue(Event *e);
+
+  /** Callbacks posted by the code running on this thread.
+
+      These are run by the event loop after the event that posted them, in order, without an
+      @c Event and without taking any lock. They can only be posted from this thread.
+  */
+  using LocalCallback = void (*)(void *data);
+  std::vector<std::pair<LocalCallback, void *>> local_callbacks;
+  std::vector<std::pair<LocalCallback, void *>> local_callbacks_running; ///< Spare, swapped with @a local_callbacks to run them.
+
+  /// Run @a cb with @a data after the current event, must be called on this thread.
+  void post_local(LocalCallback cb, void *data);
+
   EThread **ethreads_to_be_signalled = nullptr;
   int n_ethreads_to_be_signalled     = 0;
 
   static constexpr int NO_ETHREAD_ID = -1;
   int id                             = NO_ETHREAD_ID;
+  int numa_node                      = -1; ///< NUMA node the thread and its memory are bound to, -1 if none.
   unsigned int event_types           = 0;
   bool is_event_type(EventType et);
   void set_event_type(EventType et);
@@ -329,6 +363,9 @@ public:
   void execute_regular();
   void process_queue(Que(Event, link) * NegativeQueue, int *ev_count, int *nq_count);
   void process_event(Event *e, int calling_code);
+  void process_steal_queue(int *ev_count);
+  void process_local_callbacks(int *ev_count);
+  bool steal_event();
   void free_event(Event *e);
   LoopTailHandler *tail_cb = &DEFAULT_TAIL_HANDLER;
 
@@ -390,6 +427,7 @@ public:
       ink_hrtime _start = 0;         ///< The time of the first loop for this sample. Used to mark valid entries.
       ink_hrtime _min   = INT64_MAX; ///< Shortest loop time.
       ink_hrtime _max   = 0;         ///< Longest loop time.
+      ink_hrtime _total = 0;         ///< Time of all the loops, with the wait time.
       LoopTimes() {}
     } _loop_time;
 
@@ -400,8 +438,11 @@ public:
       Events() {}
     } _events;
 
-    int _count = 0; ///< # of times the loop executed.
-    int _wait  = 0; ///< # of timed wait for events
+    int _count  = 0; ///< # of times the loop executed.
+    int _wait   = 0; ///< # of timed wait for events
+    int _wakeup = 0; ///< # of times another thread signalled this one out of a wait
+
+    ink_hrtime _idle = 0; ///< Time the tail handler waited for activity.
 
     /// Add @a that to @a this data.
     /// This embodies the custom logic per member concerning whether each is a sum, min, or max.
@@ -432,11 +473,29 @@ public:
     STAT_LOOP_WAIT,       ///< # of loops that did a conditional wait.
     STAT_LOOP_TIME_MIN,   ///< Shortest time spent in loop.
     STAT_LOOP_TIME_MAX,   ///< Longest time spent in loop.
+    STAT_LOOP_WAKEUP,     ///< # of cross thread wakeups.
     N_EVENT_STATS         ///< NOT A VALID STAT INDEX - # of different stat types.
   };
 
   static char const *const STAT_NAME[N_EVENT_STATS];
 
+  /// The parts of an event loop iteration timed in @a phase_histograms.
+  enum LoopPhase {
+    LOOP_PHASE_DRAIN,   ///< Running the external, stolen, timed and poll events.
+    LOOP_PHASE_POLL,    ///< NetHandler waiting in the poll, including any sleep.
+    LOOP_PHASE_PROCESS, ///< NetHandler handling the poll results and the ready lists.
+    LOOP_PHASE_TAIL,    ///< The whole tail handler call.
+    N_LOOP_PHASES       ///< NOT A VALID PHASE - # of phases.
+  };
+
+  static char const *const LOOP_PHASE_NAME[N_LOOP_PHASES];
+
+  /// Time the loop phases, set from @c proxy.config.exec_thread.loop_histograms.
+  static bool loop_histograms;
+
+  /// Duration of each @c LoopPhase in nanoseconds, @c nullptr unless @a loop_histograms is set.
+  LatencyHistogram *phase_histograms = nullptr;
+
   /** The number of time scales used in the event statistics.
       Currently these are 10s, 100s, 1000s.
   */
@@ -205,7 +205,6 @@ public:
   unsigned int in_the_priority_queue : 1;
   unsigned int immediate : 1;
   unsigned int globally_allocated : 1;
-  unsigned int in_heap : 4;
   int callback_event = 0;
 
   ink_hrtime timeout_at = 0;
@@ -28,6 +28,7 @@
 #include "I_Processor.h"
 #include "I_Event.h"
 #include <atomic>
+#include <string_view>
 
 #ifdef TS_MAX_THREADS_IN_EACH_THREAD_TYPE
 constexpr int MAX_THREADS_IN_EACH_TYPE = TS_MAX_THREADS_IN_EACH_THREAD_TYPE;
@@ -124,13 +125,27 @@ public:
 
       @return EventType or thread id for the new group of threads (@a ev_type)
 
+      If @a base_type is not -1 the threads are also of that type, see @c spawn_isolated_threads.
   */
-  EventType spawn_event_threads(EventType ev_type, int n_threads, size_t stacksize = DEFAULT_STACKSIZE);
+  EventType spawn_event_threads(EventType ev_type, int n_threads, size_t stacksize = DEFAULT_STACKSIZE, EventType base_type = -1);
 
   /// Convenience overload.
   /// This registers @a name as an event type using @c registerEventType and then calls the real @c spawn_event_threads
   EventType spawn_event_threads(const char *name, int n_thread, size_t stacksize = DEFAULT_STACKSIZE);
 
+  /** Spawn a group of @a n_threads threads that also are of the type @a base_type.
+
+      The threads run the thread initialization of @a base_type and pass its @c EThread::is_event_type checks,
+      so they can do the same work, but they are not in the @a base_type group and nothing scheduled on the
+      @a base_type is assigned to them. Must be called after the @a base_type threads are spawned.
+
+      @return EventType of the new group.
+  */
+  EventType spawn_isolated_threads(const char *name, int n_threads, EventType base_type, size_t stacksize = DEFAULT_STACKSIZE);
+
+  /// The event type of the thread group @a name, or -1 if there is none.
+  EventType find_event_type(std::string_view name) const;
+
   /**
     Schedules the continuation on a specific EThread to receive an event
     at the given timeout.  Requests the EventProcessor to schedule
@@ -309,6 +324,7 @@ public:
     Que(Event, link) _spawnQueue;                    ///< Events to dispatch when thread is spawned.
     EThread *_thread[MAX_THREADS_IN_EACH_TYPE] = {}; ///< The actual threads in this group.
     std::function<void()> _afterStartCallback  = nullptr;
+    bool _work_stealing                        = false; ///< Idle threads run immediate events queued on busy ones.
   };
 
   /// Storage for per group data.
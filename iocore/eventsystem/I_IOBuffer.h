@@ -44,6 +44,7 @@
 #include "tscore/Allocator.h"
 #include "tscore/Ptr.h"
 #include "tscore/ink_assert.h"
+#include "tscore/ink_memory.h"
 #include "tscore/ink_resource.h"
 
 struct MIOBufferAccessor;
@@ -110,23 +111,53 @@ enum AllocType {
 #define MIN_IOBUFFER_SIZE BUFFER_SIZE_INDEX_128
 #define MAX_IOBUFFER_SIZE (DEFAULT_BUFFER_SIZES - 1)
 
-#define BUFFER_SIZE_ALLOCATED(_i) (BUFFER_SIZE_INDEX_IS_FAST_ALLOCATED(_i) || BUFFER_SIZE_INDEX_IS_XMALLOCED(_i))
+// Slab classes fill the gaps between the power of two sizes from 8K up, see IOBufferSlab.cc.
+#define BUFFER_SIZE_SLAB_CLASSES 19
+#define BUFFER_SIZE_INDEX_SLAB_BASE (DEFAULT_BUFFER_SIZES + 1)
+#define BUFFER_SIZE_INDEX_CONSTANT_BASE (BUFFER_SIZE_INDEX_SLAB_BASE + BUFFER_SIZE_SLAB_CLASSES)
+
+#define BUFFER_SIZE_ALLOCATED(_i) \
+  (BUFFER_SIZE_INDEX_IS_FAST_ALLOCATED(_i) || BUFFER_SIZE_INDEX_IS_XMALLOCED(_i) || BUFFER_SIZE_INDEX_IS_SLAB(_i))
 
 #define BUFFER_SIZE_NOT_ALLOCATED DEFAULT_BUFFER_SIZES
 #define BUFFER_SIZE_INDEX_IS_XMALLOCED(_size_index) (_size_index < 0)
 #define BUFFER_SIZE_INDEX_IS_FAST_ALLOCATED(_size_index) (((uint64_t)_size_index) < DEFAULT_BUFFER_SIZES)
-#define BUFFER_SIZE_INDEX_IS_CONSTANT(_size_index) (_size_index >= DEFAULT_BUFFER_SIZES)
+#define BUFFER_SIZE_INDEX_IS_SLAB(_size_index) \
+  (_size_index >= BUFFER_SIZE_INDEX_SLAB_BASE && _size_index < BUFFER_SIZE_INDEX_CONSTANT_BASE)
+#define BUFFER_SIZE_INDEX_IS_CONSTANT(_size_index) (_size_index >= BUFFER_SIZE_INDEX_CONSTANT_BASE)
 
 #define BUFFER_SIZE_FOR_XMALLOC(_size) (-(_size))
 #define BUFFER_SIZE_INDEX_FOR_XMALLOC_SIZE(_size) (-(_size))
 
-#define BUFFER_SIZE_FOR_CONSTANT(_size) (_size - DEFAULT_BUFFER_SIZES)
-#define BUFFER_SIZE_INDEX_FOR_CONSTANT_SIZE(_size) (_size + DEFAULT_BUFFER_SIZES)
+#define BUFFER_SIZE_FOR_SLAB(_i) (iobuffer_slab_sizes[(_i)-BUFFER_SIZE_INDEX_SLAB_BASE])
+#define BUFFER_SIZE_INDEX_FOR_SLAB_CLASS(_c) ((_c) + BUFFER_SIZE_INDEX_SLAB_BASE)
+
+#define BUFFER_SIZE_FOR_CONSTANT(_size) (_size - BUFFER_SIZE_INDEX_CONSTANT_BASE)
+#define BUFFER_SIZE_INDEX_FOR_CONSTANT_SIZE(_size) (_size + BUFFER_SIZE_INDEX_CONSTANT_BASE)
 
 inkcoreapi extern Allocator ioBufAllocator[DEFAULT_BUFFER_SIZES];
+extern const int64_t iobuffer_slab_sizes[BUFFER_SIZE_SLAB_CLASSES];
+extern bool iobuffer_slab_enabled;
 
 void init_buffer_allocators(int iobuffer_advice);
 
+/** Set up the slab classes, if @a enabled blocks of those sizes come from @c iobuffer_slab_alloc.
+
+    Empty slabs are returned to the OS once they have been unused for @a trim_interval seconds, 0
+    keeps them forever. This also registers the per class request and waste statistics, which are
+    kept whether or not the slabs are enabled.
+*/
+void init_buffer_slabs(bool enabled, int iobuffer_advice, int trim_interval);
+/// Start the periodic trim of empty slabs, needs the event threads.
+void start_buffer_slab_trim();
+
+void *iobuffer_slab_alloc(int64_t size_index);
+void iobuffer_slab_free(int64_t size_index, void *ptr);
+/// The slab class holding @a size, -1 if it is not smaller than the power of two size that would.
+int iobuffer_slab_class(int64_t size);
+/// Account a request for @a size bytes served by a block of @a size_index.
+void iobuffer_size_request(int64_t size_index, int64_t size);
+
 /**
   A reference counted wrapper around fast allocated or malloced memory.
   The IOBufferData class provides two basic services around a portion
@@ -826,6 +857,24 @@ public:
   */
   inkcoreapi int64_t memchr(char c, int64_t len = INT64_MAX, int64_t offset = 0);
 
+  /**
+    Describe data in place. Fills @a vec with one entry per block for
+    the data available to the reader, so data spanning blocks can be
+    scanned or handed to writev() without copying it out. No data is
+    consumed, the entries are valid until it is.
+
+    @param vec entries to fill.
+    @param niov number of entries in @a vec, set to the number filled.
+    @param len bytes to describe. If len exceeds the bytes available to
+      the reader or INT64_MAX is passed in, the number of bytes available
+      is used instead.
+    @param offset bytes to skip from the current position.
+    @return number of bytes the filled entries cover, less than @a len
+      if @a vec ran out first.
+
+  */
+  inkcoreapi int64_t get_iovec(IOVec *vec, int *niov, int64_t len = INT64_MAX, int64_t offset = 0);
+
   /**
     Copies and consumes data. Copies len bytes of data from the buffer
     into the supplied buffer, which must be allocated prior to the call
@@ -1198,6 +1247,17 @@ public:
   */
   void dealloc_all_readers();
 
+  /**
+    Free the blocks of a buffer whose readers have read all of it, keeping
+    the readers. The blocks are allocated again when data is written, so
+    a buffer that is idle for a long time does not hold any memory. Nothing
+    is released if a reader has data left.
+
+    @return the size of the blocks released.
+
+  */
+  int64_t release_blocks();
+
   void set(void *b, int64_t len);
   void set_xmalloced(void *b, int64_t len);
   void alloc(int64_t i = default_large_iobuffer_size);
@@ -1499,6 +1559,13 @@ public:
 #endif
 
 extern int64_t iobuffer_size_to_index(int64_t size, int64_t max = max_iobuffer_size);
+/** The index of the smallest block holding @a size bytes.
+
+    Unlike @c iobuffer_size_to_index this can be a slab class, so it is only for data whose
+    block size is not assumed to be a power of two and which is allocated through @c IOBufferData.
+    Requests are accounted in the per class waste statistics.
+*/
+extern int64_t iobuffer_size_to_fit_index(int64_t size, int64_t max = max_iobuffer_size);
 extern int64_t index_to_buffer_size(int64_t idx);
 /**
   Clone a IOBufferBlock chain. Used to snarf a IOBufferBlock chain
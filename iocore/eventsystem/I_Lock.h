@@ -49,9 +49,9 @@
 
 */
 #ifdef DEBUG
-#define SCOPED_MUTEX_LOCK(_l, _m, _t) MutexLock _l(MakeSourceLocation(), nullptr, _m, _t)
+#define SCOPED_MUTEX_LOCK(_l, _m, _t) MutexLock _l(MakeSourceLocation(), nullptr, _m, _t, MakeLockSite())
 #else
-#define SCOPED_MUTEX_LOCK(_l, _m, _t) MutexLock _l(_m, _t)
+#define SCOPED_MUTEX_LOCK(_l, _m, _t) MutexLock _l(_m, _t, MakeLockSite())
 #endif // DEBUG
 
 #ifdef DEBUG
@@ -68,10 +68,10 @@
   @param _t The current EThread executing your code.
 
 */
-#define MUTEX_TRY_LOCK(_l, _m, _t) MutexTryLock _l(MakeSourceLocation(), (char *)nullptr, _m, _t)
+#define MUTEX_TRY_LOCK(_l, _m, _t) MutexTryLock _l(MakeSourceLocation(), (char *)nullptr, _m, _t, MakeLockSite())
 
 #else // DEBUG
-#define MUTEX_TRY_LOCK(_l, _m, _t) MutexTryLock _l(_m, _t)
+#define MUTEX_TRY_LOCK(_l, _m, _t) MutexTryLock _l(_m, _t, MakeLockSite())
 #endif // DEBUG
 
 /**
@@ -91,17 +91,17 @@
 /////////////////////////////////////
 // DEPRECATED DEPRECATED DEPRECATED
 #ifdef DEBUG
-#define MUTEX_TAKE_TRY_LOCK(_m, _t) Mutex_trylock(MakeSourceLocation(), (char *)nullptr, _m, _t)
+#define MUTEX_TAKE_TRY_LOCK(_m, _t) Mutex_trylock(MakeSourceLocation(), (char *)nullptr, _m, _t, MakeLockSite())
 #else
-#define MUTEX_TAKE_TRY_LOCK(_m, _t) Mutex_trylock(_m, _t)
+#define MUTEX_TAKE_TRY_LOCK(_m, _t) Mutex_trylock(_m, _t, MakeLockSite())
 #endif
 
 #ifdef DEBUG
-#define MUTEX_TAKE_LOCK(_m, _t) Mutex_lock(MakeSourceLocation(), (char *)nullptr, _m, _t)
-#define MUTEX_TAKE_LOCK_FOR(_m, _t, _c) Mutex_lock(MakeSourceLocation(), nullptr, _m, _t)
+#define MUTEX_TAKE_LOCK(_m, _t) Mutex_lock(MakeSourceLocation(), (char *)nullptr, _m, _t, MakeLockSite())
+#define MUTEX_TAKE_LOCK_FOR(_m, _t, _c) Mutex_lock(MakeSourceLocation(), nullptr, _m, _t, MakeLockSite())
 #else
-#define MUTEX_TAKE_LOCK(_m, _t) Mutex_lock(_m, _t)
-#define MUTEX_TAKE_LOCK_FOR(_m, _t, _c) Mutex_lock(_m, _t)
+#define MUTEX_TAKE_LOCK(_m, _t) Mutex_lock(_m, _t, MakeLockSite())
+#define MUTEX_TAKE_LOCK_FOR(_m, _t, _c) Mutex_lock(_m, _t, MakeLockSite())
 #endif // DEBUG
 
 #define MUTEX_UNTAKE_LOCK(_m, _t) Mutex_unlock(_m, _t)
@@ -111,6 +111,56 @@
 class EThread;
 typedef EThread *EThreadPtr;
 
+/** Lock counters for one place in the code that takes a ProxyMutex.
+
+    Each use of the lock macros passes its own static instance, made by @c MakeLockSite. While @c
+    lock_profiling is set the acquisitions, failed try locks, waits for blocking locks and the time
+    the lock is held are counted per site and published as @c proxy.process.lock.<file>:<line>.*
+    stats. A site is linked into the published list the first time it counts anything.
+ */
+struct LockSite {
+  static constexpr int N_HOLD_BUCKETS = 6;
+  /// Upper bounds of the hold time buckets, the last bucket has none.
+  static const ink_hrtime HOLD_BOUND[N_HOLD_BUCKETS - 1];
+  static const char *const HOLD_NAME[N_HOLD_BUCKETS];
+
+  const char *file;
+  int line;
+  int64_t acquires     = 0; ///< Acquisitions, not counting those by the thread already holding it.
+  int64_t try_failures = 0; ///< Try locks that failed.
+  int64_t waits        = 0; ///< Blocking acquisitions that had to wait.
+  int64_t hold[N_HOLD_BUCKETS] = {0};
+  LockSite *next               = nullptr;
+  bool linked                  = false;
+
+  constexpr LockSite(const char *f, int l) : file(f), line(l) {}
+
+  void
+  link()
+  {
+    if (unlikely(!linked)) {
+      link_site(this);
+    }
+  }
+
+  void record_hold(ink_hrtime t);
+
+private:
+  static void link_site(LockSite *site);
+};
+
+/// A static @c LockSite for the place this is used.
+#define MakeLockSite() ([]() -> LockSite * {        \
+  static LockSite _lock_site(__FILE__, __LINE__); \
+  return &_lock_site;                             \
+}())
+
+/// Count lock use per site, set from @c proxy.config.lock_profiling.
+extern bool lock_profiling;
+
+/// Publish the lock site stats periodically, if @c lock_profiling is set.
+void start_lock_profiling();
+
 #if DEBUG
 inkcoreapi extern void lock_waiting(const SourceLocation &, const char *handler);
 inkcoreapi extern void lock_holding(const SourceLocation &, const char *handler);
@@ -167,6 +217,9 @@ public:
 
   int nthread_holding;
 
+  LockSite *site         = nullptr; ///< Where the lock was taken, only set if @c lock_profiling.
+  ink_hrtime acquired_at = 0;
+
 #ifdef DEBUG
   ink_hrtime hold_time;
   SourceLocation srcloc;
@@ -237,17 +290,31 @@ public:
 // The ClassAllocator for ProxyMutexes
 extern inkcoreapi ClassAllocator<ProxyMutex> mutexAllocator;
 
+/// Note @a m was taken at @a site.
+inline void
+lock_profile_acquired(ProxyMutex *m, LockSite *site)
+{
+  site->link();
+  ink_atomic_increment(&site->acquires, 1);
+  m->site        = site;
+  m->acquired_at = ink_get_hrtime_internal();
+}
+
 inline bool
 Mutex_trylock(
 #ifdef DEBUG
   const SourceLocation &location, const char *ahandler,
 #endif
-  Ptr<ProxyMutex> &m, EThread *t)
+  Ptr<ProxyMutex> &m, EThread *t, LockSite *site = nullptr)
 {
   ink_assert(t != nullptr);
   ink_assert(t == reinterpret_cast<EThread *>(this_thread()));
   if (m->thread_holding != t) {
     if (!ink_mutex_try_acquire(&m->the_mutex)) {
+      if (unlikely(lock_profiling) && site) {
+        site->link();
+        ink_atomic_increment(&site->try_failures, 1);
+      }
 #ifdef DEBUG
       lock_waiting(m->srcloc, m->handler);
 #ifdef LOCK_CONTENTION_PROFILING
@@ -260,6 +327,9 @@ Mutex_trylock(
       return false;
     }
     m->thread_holding = t;
+    if (unlikely(lock_profiling) && site) {
+      lock_profile_acquired(m.get(), site);
+    }
 #ifdef DEBUG
     m->srcloc    = location;
     m->handler   = ahandler;
@@ -286,11 +356,20 @@ Mutex_lock(
 #ifdef DEBUG
   const SourceLocation &location, const char *ahandler,
 #endif
-  Ptr<ProxyMutex> &m, EThread *t)
+  Ptr<ProxyMutex> &m, EThread *t, LockSite *site = nullptr)
 {
   ink_assert(t != nullptr);
   if (m->thread_holding != t) {
-    ink_mutex_acquire(&m->the_mutex);
+    if (unlikely(lock_profiling) && site) {
+      if (!ink_mutex_try_acquire(&m->the_mutex)) {
+        site->link();
+        ink_atomic_increment(&site->waits, 1);
+        ink_mutex_acquire(&m->the_mutex);
+      }
+      lock_profile_acquired(m.get(), site);
+    } else {
+      ink_mutex_acquire(&m->the_mutex);
+    }
     m->thread_holding = t;
     ink_assert(m->thread_holding);
 #ifdef DEBUG
@@ -330,6 +409,10 @@ Mutex_unlock(Ptr<ProxyMutex> &m, EThread *t)
       m->srcloc  = SourceLocation(nullptr, nullptr, 0);
       m->handler = nullptr;
 #endif // DEBUG
+      if (m->site) {
+        m->site->record_hold(ink_get_hrtime_internal() - m->acquired_at);
+        m->site = nullptr;
+      }
       ink_assert(m->thread_holding);
       m->thread_holding = nullptr;
       ink_mutex_release(&m->the_mutex);
@@ -350,14 +433,14 @@ public:
 #ifdef DEBUG
     const SourceLocation &location, const char *ahandler,
 #endif // DEBUG
-    Ptr<ProxyMutex> &am, EThread *t)
+    Ptr<ProxyMutex> &am, EThread *t, LockSite *site = nullptr)
     : m(am), locked_p(true)
   {
     Mutex_lock(
 #ifdef DEBUG
       location, ahandler,
 #endif // DEBUG
-      m, t);
+      m, t, site);
   }
 
   void
@@ -379,21 +462,22 @@ class MutexTryLock
 private:
   Ptr<ProxyMutex> m;
   bool lock_acquired;
+  LockSite *site;
 
 public:
   MutexTryLock(
 #ifdef DEBUG
     const SourceLocation &location, const char *ahandler,
 #endif // DEBUG
-    Ptr<ProxyMutex> &am, EThread *t)
-    : m(am)
+    Ptr<ProxyMutex> &am, EThread *t, LockSite *asite = nullptr)
+    : m(am), site(asite)
   {
     if (am) {
       lock_acquired = Mutex_trylock(
 #ifdef DEBUG
         location, ahandler,
 #endif // DEBUG
-        m, t);
+        m, t, site);
     } else {
       lock_acquired = true;
     }
@@ -413,7 +497,11 @@ public:
   {
     lock_acquired = true;
     if (m.get()) {
-      MUTEX_TAKE_LOCK(m, t);
+      Mutex_lock(
+#ifdef DEBUG
+        MakeSourceLocation(), nullptr,
+#endif // DEBUG
+        m, t, site);
     }
   }
 
@@ -36,6 +36,9 @@
 
 #include "tscore/ink_platform.h"
 #include "I_Event.h"
+
+#include <atomic>
+
 struct ProtectedQueue {
   void enqueue(Event *e, bool fast_signal = false);
   void signal();
@@ -46,12 +49,19 @@ struct ProtectedQueue {
   void dequeue_timed(ink_hrtime cur_time, ink_hrtime timeout, bool sleep);
   void dequeue_external();       // Dequeue any external events.
   void wait(ink_hrtime timeout); // Wait for @a timeout nanoseconds on a condition variable if there are no events.
+  bool prepare_wait();           // Mark the owner idle, false if there are events and it should not wait.
 
   InkAtomicList al;
   ink_mutex lock;
   ink_cond might_have_data;
   Que(Event, link) localQueue;
 
+  /// Set by the owning thread just before it waits. Only the first enqueue after that signals the thread,
+  /// enqueues on a busy thread rely on it checking the queue before it waits again.
+  std::atomic<bool> idle{false};
+  /// # of times an enqueue signalled the owning thread.
+  std::atomic<uint64_t> wakeups{0};
+
   ProtectedQueue();
 };
 
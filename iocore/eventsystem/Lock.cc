@@ -28,11 +28,124 @@
 
 
 **************************************************************************/
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
 #include "P_EventSystem.h"
 #include "tscore/Diags.h"
 
 ClassAllocator<ProxyMutex> mutexAllocator("mutexAllocator");
 
+bool lock_profiling = false;
+
+const ink_hrtime LockSite::HOLD_BOUND[] = {HRTIME_USECONDS(10), HRTIME_USECONDS(100), HRTIME_MSECONDS(1), HRTIME_MSECONDS(10),
+                                           HRTIME_MSECONDS(100)};
+// !! THIS MUST BE IN THE BUCKET ORDER !!
+const char *const LockSite::HOLD_NAME[] = {"10us", "100us", "1ms", "10ms", "100ms", "more"};
+
+namespace
+{
+LockSite *lock_sites = nullptr; ///< Every site that has counted anything, newest first.
+int lock_site_count  = 0;
+} // namespace
+
+void
+LockSite::link_site(LockSite *site)
+{
+  if (!ink_atomic_cas(&site->linked, false, true)) {
+    return; // another thread got there first.
+  }
+  do {
+    site->next = lock_sites;
+  } while (!ink_atomic_cas(&lock_sites, site->next, site));
+  ink_atomic_increment(&lock_site_count, 1);
+}
+
+void
+LockSite::record_hold(ink_hrtime t)
+{
+  int i = 0;
+  while (i < N_HOLD_BUCKETS - 1 && t >= HOLD_BOUND[i]) {
+    ++i;
+  }
+  ink_atomic_increment(&hold[i], 1);
+}
+
+namespace
+{
+/// Registers the stats of each new lock site and copies the site counters to them.
+struct LockProfiler : public Continuation {
+  /// Sites by stat name prefix. A template or a file name used twice can give more than one site
+  /// the same name, their counts are added up.
+  std::map<std::string, std::vector<LockSite *>> sites;
+  LockSite *newest = nullptr; ///< Head of the site list as of the last update.
+
+  LockProfiler() : Continuation(new_ProxyMutex()) { SET_HANDLER(&LockProfiler::update); }
+
+  static void
+  set(std::string const &prefix, const char *counter, int64_t v, bool create)
+  {
+    char name[256];
+    snprintf(name, sizeof(name), "%s.%s", prefix.c_str(), counter);
+    if (create) {
+      RecRegisterStatInt(RECT_PROCESS, name, static_cast<RecInt>(0), RECP_NON_PERSISTENT);
+    }
+    RecSetRecordInt(name, v, REC_SOURCE_DEFAULT);
+  }
+
+  int
+  update(int, Event *)
+  {
+    // Sites are only ever pushed on the head, the new ones are those before the last head seen.
+    LockSite *head = lock_sites;
+    std::set<std::string> created;
+    for (LockSite *site = head; site && site != newest; site = site->next) {
+      char prefix[256];
+      const char *file = strrchr(site->file, '/');
+      snprintf(prefix, sizeof(prefix), "proxy.process.lock.%s:%d", file ? file + 1 : site->file, site->line);
+      auto &list = sites[prefix];
+      if (list.empty()) {
+        created.insert(prefix);
+      }
+      list.push_back(site);
+    }
+    newest = head;
+
+    char counter[32];
+    for (auto const &[prefix, list] : sites) {
+      int64_t acquires = 0, try_failures = 0, waits = 0, hold[LockSite::N_HOLD_BUCKETS]{0};
+      for (LockSite *site : list) {
+        acquires += site->acquires;
+        try_failures += site->try_failures;
+        waits += site->waits;
+        for (int i = 0; i < LockSite::N_HOLD_BUCKETS; ++i) {
+          hold[i] += site->hold[i];
+        }
+      }
+      bool create = created.count(prefix) > 0;
+      set(prefix, "acquires", acquires, create);
+      set(prefix, "try_failures", try_failures, create);
+      set(prefix, "waits", waits, create);
+      for (int i = 0; i < LockSite::N_HOLD_BUCKETS; ++i) {
+        snprintf(counter, sizeof(counter), "hold.%s", LockSite::HOLD_NAME[i]);
+        set(prefix, counter, hold[i], create);
+      }
+    }
+    return EVENT_CONT;
+  }
+};
+} // namespace
+
+void
+start_lock_profiling()
+{
+  if (lock_profiling) {
+    eventProcessor.schedule_every(new LockProfiler, HRTIME_SECONDS(10), ET_TASK);
+  }
+}
+
 void
 lock_waiting(const SourceLocation &srcloc, const char *handler)
 {
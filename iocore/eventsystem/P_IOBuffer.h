@@ -55,11 +55,28 @@ iobuffer_size_to_index(int64_t size, int64_t max)
   return buffer_size_to_index(size, max);
 }
 
+TS_INLINE int64_t
+iobuffer_size_to_fit_index(int64_t size, int64_t max)
+{
+  int64_t idx = iobuffer_size_to_index(size, max);
+
+  if (iobuffer_slab_enabled && BUFFER_SIZE_INDEX_IS_FAST_ALLOCATED(idx)) {
+    int c = iobuffer_slab_class(size);
+    if (c >= 0 && iobuffer_slab_sizes[c] < BUFFER_SIZE_FOR_INDEX(idx)) {
+      idx = BUFFER_SIZE_INDEX_FOR_SLAB_CLASS(c);
+    }
+  }
+  iobuffer_size_request(idx, size);
+  return idx;
+}
+
 TS_INLINE int64_t
 index_to_buffer_size(int64_t idx)
 {
   if (BUFFER_SIZE_INDEX_IS_FAST_ALLOCATED(idx)) {
     return BUFFER_SIZE_FOR_INDEX(idx);
+  } else if (BUFFER_SIZE_INDEX_IS_SLAB(idx)) {
+    return BUFFER_SIZE_FOR_SLAB(idx);
   } else if (BUFFER_SIZE_INDEX_IS_XMALLOCED(idx)) {
     return BUFFER_SIZE_FOR_XMALLOC(idx);
     // coverity[dead_error_condition]
@@ -154,7 +171,7 @@ iobuffer_mem_inc(const char *_loc, int64_t _size_index)
     return;
   }
 
-  if (!BUFFER_SIZE_INDEX_IS_FAST_ALLOCATED(_size_index)) {
+  if (!BUFFER_SIZE_INDEX_IS_FAST_ALLOCATED(_size_index) && !BUFFER_SIZE_INDEX_IS_SLAB(_size_index)) {
     return;
   }
 
@@ -171,7 +188,7 @@ iobuffer_mem_dec(const char *_loc, int64_t _size_index)
     return;
   }
 
-  if (!BUFFER_SIZE_INDEX_IS_FAST_ALLOCATED(_size_index)) {
+  if (!BUFFER_SIZE_INDEX_IS_FAST_ALLOCATED(_size_index) && !BUFFER_SIZE_INDEX_IS_SLAB(_size_index)) {
     return;
   }
   if (!_loc) {
@@ -292,6 +309,8 @@ IOBufferData::alloc(int64_t size_index, AllocType type)
   case MEMALIGNED:
     if (BUFFER_SIZE_INDEX_IS_FAST_ALLOCATED(size_index)) {
       _data = (char *)ioBufAllocator[size_index].alloc_void();
+    } else if (BUFFER_SIZE_INDEX_IS_SLAB(size_index)) {
+      _data = (char *)iobuffer_slab_alloc(size_index);
       // coverity[dead_error_condition]
     } else if (BUFFER_SIZE_INDEX_IS_XMALLOCED(size_index)) {
       _data = (char *)ats_memalign(ats_pagesize(), index_to_buffer_size(size_index));
@@ -301,6 +320,8 @@ IOBufferData::alloc(int64_t size_index, AllocType type)
   case DEFAULT_ALLOC:
     if (BUFFER_SIZE_INDEX_IS_FAST_ALLOCATED(size_index)) {
       _data = (char *)ioBufAllocator[size_index].alloc_void();
+    } else if (BUFFER_SIZE_INDEX_IS_SLAB(size_index)) {
+      _data = (char *)iobuffer_slab_alloc(size_index);
     } else if (BUFFER_SIZE_INDEX_IS_XMALLOCED(size_index)) {
       _data = (char *)ats_malloc(BUFFER_SIZE_FOR_XMALLOC(size_index));
     }
@@ -320,6 +341,8 @@ IOBufferData::dealloc()
   case MEMALIGNED:
     if (BUFFER_SIZE_INDEX_IS_FAST_ALLOCATED(_size_index)) {
       ioBufAllocator[_size_index].free_void(_data);
+    } else if (BUFFER_SIZE_INDEX_IS_SLAB(_size_index)) {
+      iobuffer_slab_free(_size_index, _data);
     } else if (BUFFER_SIZE_INDEX_IS_XMALLOCED(_size_index)) {
       ::free((void *)_data);
     }
@@ -328,6 +351,8 @@ IOBufferData::dealloc()
   case DEFAULT_ALLOC:
     if (BUFFER_SIZE_INDEX_IS_FAST_ALLOCATED(_size_index)) {
       ioBufAllocator[_size_index].free_void(_data);
+    } else if (BUFFER_SIZE_INDEX_IS_SLAB(_size_index)) {
+      iobuffer_slab_free(_size_index, _data);
     } else if (BUFFER_SIZE_INDEX_IS_XMALLOCED(_size_index)) {
       ats_free(_data);
     }
@@ -537,7 +562,10 @@ IOBufferBlock::realloc(int64_t i)
     return;
   }
 
-  ink_release_assert(i > data->_size_index && i != BUFFER_SIZE_NOT_ALLOCATED);
+  // Slab classes sort after the fast sizes, compare what they hold.
+  ink_release_assert((BUFFER_SIZE_INDEX_IS_SLAB(data->_size_index) ? BUFFER_SIZE_FOR_INDEX(i) > data->block_size() :
+                                                                      i > data->_size_index) &&
+                     i != BUFFER_SIZE_NOT_ALLOCATED);
   void *b = ioBufAllocator[i].alloc_void();
   realloc_set_internal(b, BUFFER_SIZE_FOR_INDEX(i), i);
 }
@@ -109,6 +109,18 @@ EventProcessor::schedule(Event *e, EventType etype, bool fast_signal)
 
   if (e->continuation->mutex) {
     e->mutex = e->continuation->mutex;
+    ThreadGroupDescriptor *tg = &thread_group[etype];
+    // An immediate event that does not run under the thread mutex can run on any thread of the group.
+    if (tg->_work_stealing && !e->timeout_at && !e->period) {
+      if (e->ethread->steal_enqueue(e) > 1 && tg->_count > 1) {
+        // The thread is behind, wake another one to take some of its work.
+        EThread *thief = tg->_thread[++tg->_next_round_robin % tg->_count];
+        if (thief != e->ethread && thief != this_ethread()) {
+          thief->tail_cb->signalActivity();
+        }
+      }
+      return e;
+    }
   } else {
     e->mutex = e->continuation->mutex = e->ethread->mutex;
   }
@@ -49,16 +49,27 @@ ProtectedQueue::enqueue(Event *e, bool fast_signal)
   ink_assert(!e->in_the_prot_queue && !e->in_the_priority_queue);
   EThread *e_ethread   = e->ethread;
   e->in_the_prot_queue = 1;
-  bool was_empty       = (ink_atomiclist_push(&al, e) == nullptr);
-
-  if (was_empty) {
-    EThread *inserting_thread = this_ethread();
-    // queue e->ethread in the list of threads to be signalled
-    // inserting_thread == 0 means it is not a regular EThread
-    if (inserting_thread != e_ethread) {
-      e_ethread->tail_cb->signalActivity();
-    }
+  ink_atomiclist_push(&al, e);
+
+  // A burst of enqueues costs a single signal, the one that takes the owner out of idle.
+  // inserting_thread == 0 means it is not a regular EThread
+  EThread *inserting_thread = this_ethread();
+  if (inserting_thread != e_ethread && idle.exchange(false)) {
+    wakeups.fetch_add(1, std::memory_order_relaxed);
+    e_ethread->tail_cb->signalActivity();
+  }
+}
+
+bool
+ProtectedQueue::prepare_wait()
+{
+  // Pairs with the push / exchange in enqueue: either this sees the event or the enqueue sees idle.
+  idle = true;
+  if (INK_ATOMICLIST_EMPTY(al)) {
+    return true;
   }
+  idle = false;
+  return false;
 }
 
 void
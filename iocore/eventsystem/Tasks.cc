@@ -34,11 +34,53 @@ TasksProcessor::register_event_type()
   return ET_TASK;
 }
 
+enum {
+  TASK_STAT_STEAL_QUEUED,
+  TASK_STAT_STOLEN,
+  TASK_STAT_COUNT,
+};
+
+static int
+TaskStealStatSync(const char *, RecDataT, RecData *, RecRawStatBlock *rsb, int)
+{
+  uint64_t queued = 0;
+  uint64_t stolen = 0;
+
+  for (EThread *t : eventProcessor.active_group_threads(ET_TASK)) {
+    queued += t->steal_queued;
+    stolen += t->steal_stolen;
+  }
+
+  ink_mutex_acquire(&(rsb->mutex));
+  rsb->global[TASK_STAT_STEAL_QUEUED]->sum   = queued;
+  rsb->global[TASK_STAT_STEAL_QUEUED]->count = 1;
+  RecRawStatUpdateSum(rsb, TASK_STAT_STEAL_QUEUED);
+  rsb->global[TASK_STAT_STOLEN]->sum   = stolen;
+  rsb->global[TASK_STAT_STOLEN]->count = 1;
+  RecRawStatUpdateSum(rsb, TASK_STAT_STOLEN);
+  ink_mutex_release(&(rsb->mutex));
+
+  return REC_ERR_OKAY;
+}
+
 // Note that if the number of task_threads is 0, all continuations scheduled for
 // ET_TASK ends up running on ET_CALL (which is the net-threads).
 int
 TasksProcessor::start(int task_threads, size_t stacksize)
 {
+  int work_stealing = 0;
+  REC_ReadConfigInteger(work_stealing, "proxy.config.task_threads.work_stealing");
+  eventProcessor.thread_group[ET_TASK]._work_stealing = work_stealing != 0;
+
+  if (work_stealing) {
+    RecRawStatBlock *rsb = RecAllocateRawStatBlock(TASK_STAT_COUNT);
+    RecRegisterRawStat(rsb, RECT_PROCESS, "proxy.process.eventloop.task.steal_queued", RECD_INT, RECP_NON_PERSISTENT,
+                       TASK_STAT_STEAL_QUEUED, nullptr);
+    RecRegisterRawStat(rsb, RECT_PROCESS, "proxy.process.eventloop.task.stolen", RECD_INT, RECP_NON_PERSISTENT, TASK_STAT_STOLEN,
+                       nullptr);
+    RecRegisterRawStatSyncCb("proxy.process.eventloop.task.stolen", TaskStealStatSync, rsb, 0);
+  }
+
   eventProcessor.spawn_event_threads(ET_TASK, std::max(1, task_threads), stacksize);
   return 0;
 }
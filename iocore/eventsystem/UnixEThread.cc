@@ -43,10 +43,15 @@ struct AIOCallback;
 char const *const EThread::STAT_NAME[] = {"proxy.process.eventloop.count",      "proxy.process.eventloop.events",
                                           "proxy.process.eventloop.events.min", "proxy.process.eventloop.events.max",
                                           "proxy.process.eventloop.wait",       "proxy.process.eventloop.time.min",
-                                          "proxy.process.eventloop.time.max"};
+                                          "proxy.process.eventloop.time.max",   "proxy.process.eventloop.wakeup"};
 
 int const EThread::SAMPLE_COUNT[N_EVENT_TIMESCALES] = {10, 100, 1000};
 
+// !! THIS MUST BE IN THE ENUM ORDER !!
+char const *const EThread::LOOP_PHASE_NAME[] = {"drain", "poll", "process", "tail"};
+
+bool EThread::loop_histograms = false;
+
 int thread_max_heartbeat_mseconds = THREAD_MAX_HEARTBEAT_MSECONDS;
 
 EThread::EThread()
@@ -98,6 +103,7 @@ EThread::~EThread()
     flush_signals(this);
   }
   ats_free(ethreads_to_be_signalled);
+  delete[] phase_histograms;
   // TODO: This can't be deleted ....
   // delete[]l1_hash;
 }
@@ -192,6 +198,95 @@ EThread::process_queue(Que(Event, link) * NegativeQueue, int *ev_count, int *nq_
   }
 }
 
+int
+EThread::steal_enqueue(Event *e)
+{
+  int n;
+  ink_mutex_acquire(&steal_lock);
+  steal_queue.enqueue(e);
+  ++steal_queued;
+  n = ++steal_queue_size;
+  ink_mutex_release(&steal_lock);
+  if (this_ethread() != this) {
+    tail_cb->signalActivity();
+  }
+  return n;
+}
+
+void
+EThread::process_steal_queue(int *ev_count)
+{
+  // Only run what is queued now, so a stream of new events can't starve the timers.
+  for (int n = steal_queue_size; n > 0; --n) {
+    ink_mutex_acquire(&steal_lock);
+    Event *e = steal_queue.dequeue();
+    if (e) {
+      --steal_queue_size;
+    }
+    ink_mutex_release(&steal_lock);
+    if (!e) {
+      break;
+    }
+    ++(*ev_count);
+    if (e->cancelled) {
+      free_event(e);
+    } else {
+      process_event(e, e->callback_event);
+    }
+  }
+}
+
+void
+EThread::post_local(LocalCallback cb, void *data)
+{
+  ink_assert(this == this_ethread());
+  local_callbacks.emplace_back(cb, data);
+}
+
+void
+EThread::process_local_callbacks(int *ev_count)
+{
+  // Only run what is posted now, the callbacks posted by these are run in the next pass. The
+  // vectors are swapped back and forth so their storage is reused.
+  local_callbacks_running.swap(local_callbacks);
+  for (auto &cb : local_callbacks_running) {
+    ++(*ev_count);
+    cb.first(cb.second);
+  }
+  local_callbacks_running.clear();
+}
+
+// Take the oldest queued event of the first sibling that has any and run it.
+bool
+EThread::steal_event()
+{
+  EventProcessor::ThreadGroupDescriptor *tg = &eventProcessor.thread_group[steal_group];
+  int start                                 = generator.random() % tg->_count;
+  for (int i = 0; i < tg->_count; ++i) {
+    EThread *victim = tg->_thread[(start + i) % tg->_count];
+    if (victim == this || victim->steal_queue_size <= 0) {
+      continue;
+    }
+    ink_mutex_acquire(&victim->steal_lock);
+    Event *e = victim->steal_queue.dequeue();
+    if (e) {
+      --victim->steal_queue_size;
+    }
+    ink_mutex_release(&victim->steal_lock);
+    if (e) {
+      if (e->cancelled) {
+        free_event(e);
+      } else {
+        ++steal_stolen;
+        e->ethread = this;
+        process_event(e, e->callback_event);
+      }
+      return true;
+    }
+  }
+  return false;
+}
+
 void
 EThread::execute_regular()
 {
@@ -201,16 +296,23 @@ EThread::execute_regular()
   ink_hrtime delta;            // time spent in the event loop
   ink_hrtime loop_start_time;  // Time the loop started.
   ink_hrtime loop_finish_time; // Time at the end of the loop.
+  ink_hrtime tail_start_time = 0; // Time the tail handler was called.
 
   // Track this so we can update on boundary crossing.
   EventMetrics *prev_metric = this->prev(metrics + (ink_get_hrtime_internal() / HRTIME_SECOND) % N_EVENT_METRICS);
 
   int nq_count;
   int ev_count;
+  uint64_t wakeups;
+  uint64_t prev_wakeups = EventQueueExternal.wakeups;
 
   // A statically initialized instance we can use as a prototype for initializing other instances.
   static EventMetrics METRIC_INIT;
 
+  if (loop_histograms && !phase_histograms) {
+    phase_histograms = new LatencyHistogram[N_LOOP_PHASES];
+  }
+
   // give priority to immediate events
   for (;;) {
     if (TSSystemState::is_event_system_shut_down()) {
@@ -233,6 +335,9 @@ EThread::execute_regular()
     ++(current_metric->_count);
 
     process_queue(&NegativeQueue, &ev_count, &nq_count);
+    if (steal_queue_size > 0) {
+      process_steal_queue(&ev_count);
+    }
 
     bool done_one;
     do {
@@ -249,6 +354,10 @@ EThread::execute_regular()
           process_event(e, e->callback_event);
         }
       }
+      if (!local_callbacks.empty()) {
+        done_one = true;
+        process_local_callbacks(&ev_count);
+      }
     } while (done_one);
 
     // execute any negative (poll) events
@@ -269,21 +378,53 @@ EThread::execute_regular()
     } else {
       sleep_time = 0;
     }
+    // Don't sleep on the callbacks posted by the poll events.
+    if (!local_callbacks.empty()) {
+      sleep_time = 0;
+    }
+    // Rather than going idle, help out a busy sibling.
+    if (steal_queue_size > 0 || (steal_group >= 0 && sleep_time > 0 && steal_event())) {
+      ++ev_count;
+      sleep_time = 0;
+    }
 
     if (n_ethreads_to_be_signalled) {
       flush_signals(this);
     }
 
-    tail_cb->waitForActivity(sleep_time);
+    if (sleep_time > 0 && !EventQueueExternal.prepare_wait()) {
+      sleep_time = 0;
+    }
+    if (phase_histograms) {
+      tail_start_time = Thread::get_hrtime_updated();
+      phase_histograms[LOOP_PHASE_DRAIN].record(tail_start_time - loop_start_time);
+    }
+    if (tail_cb == &DEFAULT_TAIL_HANDLER) {
+      // The NetHandler times its own poll, this handler does nothing but wait.
+      ink_hrtime wait_start = Thread::get_hrtime_updated();
+      tail_cb->waitForActivity(sleep_time);
+      current_metric->_idle += Thread::get_hrtime_updated() - wait_start;
+    } else {
+      tail_cb->waitForActivity(sleep_time);
+    }
+    EventQueueExternal.idle = false;
+
+    wakeups = EventQueueExternal.wakeups.load(std::memory_order_relaxed);
+    current_metric->_wakeup += wakeups - prev_wakeups;
+    prev_wakeups = wakeups;
 
     // loop cleanup
     loop_finish_time = this->get_hrtime_updated();
     delta            = loop_finish_time - loop_start_time;
+    if (phase_histograms) {
+      phase_histograms[LOOP_PHASE_TAIL].record(loop_finish_time - tail_start_time);
+    }
 
     // This can happen due to time of day adjustments (which apparently happen quite frequently). I
     // tried using the monotonic clock to get around this but it was *very* stuttery (up to hundreds
     // of milliseconds), far too much to be actually used.
     if (delta > 0) {
+      current_metric->_loop_time._total += delta;
       if (delta > current_metric->_loop_time._max) {
         current_metric->_loop_time._max = delta;
       }
@@ -357,8 +498,11 @@ EThread::EventMetrics::operator+=(EventMetrics const &that)
   this->_events._total += that._events._total;
   this->_loop_time._min = std::min(this->_loop_time._min, that._loop_time._min);
   this->_loop_time._max = std::max(this->_loop_time._max, that._loop_time._max);
+  this->_loop_time._total += that._loop_time._total;
   this->_count += that._count;
   this->_wait += that._wait;
+  this->_wakeup += that._wakeup;
+  this->_idle += that._idle;
   return *this;
 }
 
@@ -65,6 +65,7 @@ private:
   hwloc_obj_type_t obj_type = HWLOC_OBJ_MACHINE;
   int obj_count             = 0;
   char const *obj_name      = nullptr;
+  bool numa                 = false; ///< Bind thread memory to the NUMA node of the thread.
 #endif
 };
 
@@ -103,6 +104,10 @@ EventMetricStatSync(const char *, RecDataT, RecData *, RecRawStatBlock *rsb, int
     rsb->global[id + EThread::STAT_LOOP_TIME_MAX]->count = 1;
     RecRawStatUpdateSum(rsb, id + EThread::STAT_LOOP_TIME_MAX);
 
+    rsb->global[id + EThread::STAT_LOOP_WAKEUP]->sum   = m->_wakeup;
+    rsb->global[id + EThread::STAT_LOOP_WAKEUP]->count = 1;
+    RecRawStatUpdateSum(rsb, id + EThread::STAT_LOOP_WAKEUP);
+
     rsb->global[id + EThread::STAT_LOOP_EVENTS]->sum   = m->_events._total;
     rsb->global[id + EThread::STAT_LOOP_EVENTS]->count = 1;
     RecRawStatUpdateSum(rsb, id + EThread::STAT_LOOP_EVENTS);
@@ -118,6 +123,86 @@ EventMetricStatSync(const char *, RecDataT, RecData *, RecRawStatBlock *rsb, int
   return REC_ERR_OKAY;
 }
 
+/// Loop phase stats per thread, each phase has these in order.
+enum { PHASE_STAT_P50, PHASE_STAT_P99, PHASE_STAT_MAX, N_PHASE_STATS };
+char const *const PHASE_STAT_NAME[N_PHASE_STATS] = {"p50", "p99", "max"};
+
+int loop_phase_threads            = 0;
+LatencyHistogram *loop_phase_prev = nullptr; ///< Histograms as of the previous sync, per thread and phase.
+
+/// Publish the loop phase percentiles of each thread over the time since the previous sync.
+int
+LoopPhaseStatSync(const char *, RecDataT, RecData *, RecRawStatBlock *rsb, int)
+{
+  LatencyHistogram interval;
+  int idx = 0;
+
+  ink_mutex_acquire(&(rsb->mutex));
+  for (EThread *t : eventProcessor.active_group_threads(ET_CALL)) {
+    if (idx >= loop_phase_threads) {
+      break;
+    }
+    for (int phase = 0; phase < EThread::N_LOOP_PHASES; ++phase) {
+      int id = (idx * EThread::N_LOOP_PHASES + phase) * N_PHASE_STATS;
+      int64_t v[N_PHASE_STATS]{0};
+      if (t->phase_histograms) {
+        interval.delta(t->phase_histograms[phase], loop_phase_prev[idx * EThread::N_LOOP_PHASES + phase]);
+        v[PHASE_STAT_P50] = interval.percentile(0.5);
+        v[PHASE_STAT_P99] = interval.percentile(0.99);
+        v[PHASE_STAT_MAX] = interval.max();
+      }
+      for (int s = 0; s < N_PHASE_STATS; ++s) {
+        rsb->global[id + s]->sum   = v[s];
+        rsb->global[id + s]->count = 1;
+        RecRawStatUpdateSum(rsb, id + s);
+      }
+    }
+    ++idx;
+  }
+  ink_mutex_release(&(rsb->mutex));
+  return REC_ERR_OKAY;
+}
+
+/// Utilization stats per thread, over the shortest timescale.
+enum { THREAD_STAT_BUSY_PCT, THREAD_STAT_LOOPS, THREAD_STAT_EVENTS, THREAD_STAT_EVENTS_MAX, N_THREAD_STATS };
+char const *const THREAD_STAT_NAME[N_THREAD_STATS] = {"busy_pct", "loops", "events", "events_max"};
+
+int thread_stat_threads = 0;
+
+/// Publish how busy each thread is, the part of its loop time it didn't spend waiting for activity.
+int
+ThreadStatSync(const char *, RecDataT, RecData *, RecRawStatBlock *rsb, int)
+{
+  int idx = 0;
+
+  ink_mutex_acquire(&(rsb->mutex));
+  for (EThread *t : eventProcessor.active_group_threads(ET_CALL)) {
+    if (idx >= thread_stat_threads) {
+      break;
+    }
+    EThread::EventMetrics summary[EThread::N_EVENT_TIMESCALES];
+    t->summarize_stats(summary);
+
+    EThread::EventMetrics const &m = summary[0];
+    int64_t v[N_THREAD_STATS]{0};
+    if (m._loop_time._total > 0) {
+      v[THREAD_STAT_BUSY_PCT] = std::max<int64_t>(0, 100 * (m._loop_time._total - m._idle) / m._loop_time._total);
+    }
+    v[THREAD_STAT_LOOPS]      = m._count;
+    v[THREAD_STAT_EVENTS]     = m._events._total;
+    v[THREAD_STAT_EVENTS_MAX] = m._events._max;
+    for (int s = 0; s < N_THREAD_STATS; ++s) {
+      int id                 = idx * N_THREAD_STATS + s;
+      rsb->global[id]->sum   = v[s];
+      rsb->global[id]->count = 1;
+      RecRawStatUpdateSum(rsb, id);
+    }
+    ++idx;
+  }
+  ink_mutex_release(&(rsb->mutex));
+  return REC_ERR_OKAY;
+}
+
 /// This is a wrapper used to convert a static function into a continuation. The function pointer is
 /// passed in the cookie. For this reason the class is used as a singleton.
 /// @internal This is the implementation for @c schedule_spawn... overloads.
@@ -179,8 +264,18 @@ ThreadAffinityInitializer::init()
     obj_name = "Machine";
   }
 
+  int numa_mode = 0;
+  REC_ReadConfigInteger(numa_mode, "proxy.config.exec_thread.numa");
+  numa = numa_mode && hwloc_get_nbobjs_by_type(ink_get_topology(), HWLOC_OBJ_NODE) > 1;
+  if (numa && obj_type == HWLOC_OBJ_MACHINE) {
+    // A thread free to run anywhere has no local node, pin to nodes at least.
+    obj_type = HWLOC_OBJ_NODE;
+    obj_name = "NUMA Node";
+  }
+
   obj_count = hwloc_get_nbobjs_by_type(ink_get_topology(), obj_type);
-  Debug("iocore_thread", "Affinity: %d %ss: %d PU: %d", affinity, obj_name, obj_count, ink_number_of_processors());
+  Debug("iocore_thread", "Affinity: %d %ss: %d PU: %d NUMA: %d", affinity, obj_name, obj_count, ink_number_of_processors(),
+        numa);
 }
 
 int
@@ -200,6 +295,21 @@ ThreadAffinityInitializer::set_affinity(int, Event *)
     Debug("iocore_thread", "EThread: %d %s: %d", _name, obj->logical_index);
 #endif // HWLOC_API_VERSION
     hwloc_set_thread_cpubind(ink_get_topology(), t->tid, obj->cpuset, HWLOC_CPUBIND_STRICT);
+
+    if (numa) {
+      hwloc_nodeset_t nodeset = hwloc_bitmap_alloc();
+      hwloc_cpuset_to_nodeset(ink_get_topology(), obj->cpuset, nodeset);
+      if (hwloc_bitmap_weight(nodeset) == 1) {
+        // Not strict, so on Linux this is a preference and allocation falls back to other nodes
+        // rather than fail. Everything the thread allocates from now on, buffer and freelist chunks
+        // included, comes from its own node.
+        hwloc_set_membind_nodeset(ink_get_topology(), nodeset, HWLOC_MEMBIND_BIND, HWLOC_MEMBIND_THREAD);
+        t->numa_node = hwloc_bitmap_first(nodeset);
+        ink_freelist_set_thread_node(t->numa_node);
+        Debug("iocore_thread", "EThread: %p memory bound to NUMA node %d", t, t->numa_node);
+      }
+      hwloc_bitmap_free(nodeset);
+    }
   } else {
     Warning("hwloc returned an unexpected number of objects -- CPU affinity disabled");
   }
@@ -341,7 +451,26 @@ EventProcessor::spawn_event_threads(char const *name, int n_threads, size_t stac
 }
 
 EventType
-EventProcessor::spawn_event_threads(EventType ev_type, int n_threads, size_t stacksize)
+EventProcessor::spawn_isolated_threads(char const *name, int n_threads, EventType base_type, size_t stacksize)
+{
+  int ev_type = this->register_event_type(name);
+  this->spawn_event_threads(ev_type, n_threads, stacksize, base_type);
+  return ev_type;
+}
+
+EventType
+EventProcessor::find_event_type(std::string_view name) const
+{
+  for (int i = 0; i < n_thread_groups; ++i) {
+    if (thread_group[i]._name == name) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+EventType
+EventProcessor::spawn_event_threads(EventType ev_type, int n_threads, size_t stacksize, EventType base_type)
 {
   char thr_name[MAX_THREAD_NAME_LENGTH];
   int i;
@@ -367,6 +496,12 @@ EventProcessor::spawn_event_threads(EventType ev_type, int n_threads, size_t sta
     tg->_thread[i]               = t;
     t->id                        = i; // unfortunately needed to support affinity and NUMA logic.
     t->set_event_type(ev_type);
+    if (base_type >= 0) {
+      t->set_event_type(base_type);
+    }
+    if (tg->_work_stealing) {
+      t->steal_group = ev_type;
+    }
     t->schedule_spawn(&thread_initializer);
   }
   tg->_count = n_threads;
@@ -395,8 +530,9 @@ EventProcessor::initThreadState(EThread *t)
   // Run all thread type initialization continuations that match the event types for this thread.
   for (int i = 0; i < MAX_EVENT_TYPES; ++i) {
     if (t->is_event_type(i)) { // that event type done here, roll thread start events of that type.
-      ++thread_group[i]._started;
-      if (thread_group[i]._started == thread_group[i]._count && thread_group[i]._afterStartCallback != nullptr) {
+      // Only the threads of the group itself count, not those of isolated groups that share its type.
+      if (thread_group[i]._thread[t->id] == t && ++thread_group[i]._started == thread_group[i]._count &&
+          thread_group[i]._afterStartCallback != nullptr) {
         thread_group[i]._afterStartCallback();
       }
       // To avoid race conditions on the event in the spawn queue, create a local one to actually send.
@@ -446,6 +582,36 @@ EventProcessor::start(int n_event_threads, size_t stacksize)
   // Name must be that of a stat, pick one at random since we do all of them in one pass/callback.
   RecRegisterRawStatSyncCb(name, EventMetricStatSync, rsb, 0);
 
+  thread_stat_threads = n_event_threads;
+  rsb                 = RecAllocateRawStatBlock(n_event_threads * N_THREAD_STATS);
+  for (int i = 0; i < n_event_threads; ++i) {
+    for (int s = 0; s < N_THREAD_STATS; ++s) {
+      snprintf(name, sizeof(name), "proxy.process.eventloop.thread.%d.%s", i, THREAD_STAT_NAME[s]);
+      RecRegisterRawStat(rsb, RECT_PROCESS, name, RECD_INT, RECP_NON_PERSISTENT, i * N_THREAD_STATS + s, NULL);
+    }
+  }
+  RecRegisterRawStatSyncCb(name, ThreadStatSync, rsb, 0);
+
+  int loop_histograms = 0;
+  REC_ReadConfigInteger(loop_histograms, "proxy.config.exec_thread.loop_histograms");
+  if (loop_histograms) {
+    EThread::loop_histograms = true;
+    loop_phase_threads       = n_event_threads;
+    loop_phase_prev          = new LatencyHistogram[n_event_threads * EThread::N_LOOP_PHASES];
+    rsb                      = RecAllocateRawStatBlock(n_event_threads * EThread::N_LOOP_PHASES * N_PHASE_STATS);
+    for (int i = 0; i < n_event_threads; ++i) {
+      for (int phase = 0; phase < EThread::N_LOOP_PHASES; ++phase) {
+        for (int s = 0; s < N_PHASE_STATS; ++s) {
+          int id = (i * EThread::N_LOOP_PHASES + phase) * N_PHASE_STATS + s;
+          snprintf(name, sizeof(name), "proxy.process.eventloop.thread.%d.%s.%s", i, EThread::LOOP_PHASE_NAME[phase],
+                   PHASE_STAT_NAME[s]);
+          RecRegisterRawStat(rsb, RECT_PROCESS, name, RECD_INT, RECP_NON_PERSISTENT, id, NULL);
+        }
+      }
+    }
+    RecRegisterRawStatSyncCb(name, LoopPhaseStatSync, rsb, 0);
+  }
+
   this->spawn_event_threads(ET_CALL, n_event_threads, stacksize);
 
   Debug("iocore_thread", "Created event thread group id %d with %d threads", ET_CALL, n_event_threads);
@@ -0,0 +1,145 @@
+/** @file
+
+    Catch-based unit tests for the sampling CPU profiler.
+
+    @section license License
+
+    Licensed to the Apache Software Foundation (ASF) under one
+    or more contributor license agreements.  See the NOTICE file
+    distributed with this work for additional information
+    regarding copyright ownership.  The ASF licenses this file
+    to you under the Apache License, Version 2.0 (the
+    "License"); you may not use this file except in compliance
+    with the License.  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+ */
+
+#define CATCH_CONFIG_RUNNER
+#include "catch.hpp"
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "I_EventSystem.h"
+#include "tscore/I_Layout.h"
+
+#include "diags.i"
+
+int
+main(int argc, char *argv[])
+{
+  // global setup...
+  Layout::create();
+  init_diags("", nullptr);
+  RecProcessInit(RECM_STAND_ALONE);
+
+  int result = Catch::Session().run(argc, argv);
+
+  // global clean-up...
+
+  exit(result);
+}
+
+namespace
+{
+struct Busy : public Continuation {
+  Busy() : Continuation(nullptr) { SET_HANDLER(&Busy::handle); }
+
+  int
+  handle(int, void *)
+  {
+    CpuProfiler::Scope scope("test_hook");
+    // CPU time, the timer of the profiler does not run while the thread sleeps.
+    timespec start, now;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &start);
+    do {
+      clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+    } while ((now.tv_sec - start.tv_sec) * 1000000000 + (now.tv_nsec - start.tv_nsec) < 300000000);
+    return EVENT_DONE;
+  }
+};
+
+std::string
+temp_path()
+{
+  char path[] = "/tmp/cpu_profile.XXXXXX";
+  int fd      = mkstemp(path);
+  REQUIRE(fd >= 0);
+  close(fd);
+  return path;
+}
+
+std::vector<std::string>
+read_lines(const std::string &path)
+{
+  std::vector<std::string> lines;
+  std::ifstream in(path);
+  for (std::string line; std::getline(in, line);) {
+    lines.push_back(line);
+  }
+  return lines;
+}
+} // namespace
+
+TEST_CASE("CpuProfiler samples", "[CpuProfiler]")
+{
+  Busy busy;
+
+  CpuProfiler::configure(1000);
+  REQUIRE(CpuProfiler::running());
+  busy.handleEvent(EVENT_IMMEDIATE, nullptr);
+  CpuProfiler::configure(0);
+  REQUIRE_FALSE(CpuProfiler::running());
+
+  SECTION("collapsed")
+  {
+    std::string path = temp_path();
+    REQUIRE(CpuProfiler::dump(path.c_str()));
+    std::vector<std::string> lines = read_lines(path);
+    unlink(path.c_str());
+
+    uint64_t total = 0, hooked = 0;
+    for (auto const &line : lines) {
+      auto space = line.rfind(' ');
+      REQUIRE(space != std::string::npos);
+      uint64_t count = std::stoull(line.substr(space + 1));
+      total += count;
+      if (line.find(";[test_hook];") != std::string::npos) {
+        hooked += count;
+      }
+    }
+    REQUIRE(total > 0);
+    // Most of the time is in the loop, a few samples may land on the test itself.
+    REQUIRE(hooked * 2 > total);
+  }
+
+  SECTION("pprof")
+  {
+    std::string path = temp_path();
+    REQUIRE(CpuProfiler::dump(path.c_str(), CpuProfiler::PPROF));
+    std::ifstream in(path, std::ios::binary);
+    std::vector<uintptr_t> header(5);
+    in.read(reinterpret_cast<char *>(header.data()), header.size() * sizeof(uintptr_t));
+    unlink(path.c_str());
+
+    REQUIRE(in.good());
+    REQUIRE(header == std::vector<uintptr_t>{0, 3, 0, 1000, 0});
+  }
+
+  SECTION("reset")
+  {
+    CpuProfiler::reset();
+    std::string path = temp_path();
+    REQUIRE(CpuProfiler::dump(path.c_str()));
+    REQUIRE(read_lines(path).empty());
+    unlink(path.c_str());
+  }
+}
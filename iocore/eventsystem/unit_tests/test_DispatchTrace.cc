@@ -0,0 +1,147 @@
+/** @file
+
+    Catch-based unit tests for the continuation dispatch trace.
+
+    @section license License
+
+    Licensed to the Apache Software Foundation (ASF) under one
+    or more contributor license agreements.  See the NOTICE file
+    distributed with this work for additional information
+    regarding copyright ownership.  The ASF licenses this file
+    to you under the Apache License, Version 2.0 (the
+    "License"); you may not use this file except in compliance
+    with the License.  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+ */
+
+#define CATCH_CONFIG_RUNNER
+#include "catch.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "I_EventSystem.h"
+#include "tscore/I_Layout.h"
+
+#include "diags.i"
+
+int
+main(int argc, char *argv[])
+{
+  // global setup...
+  Layout::create();
+  init_diags("", nullptr);
+  RecProcessInit(RECM_STAND_ALONE);
+
+  int result = Catch::Session().run(argc, argv);
+
+  // global clean-up...
+
+  exit(result);
+}
+
+namespace
+{
+struct Leaf : public Continuation {
+  Leaf() : Continuation(nullptr) { SET_HANDLER(&Leaf::handle); }
+
+  int
+  handle(int, void *)
+  {
+    ink_hrtime until = ink_get_hrtime_internal() + HRTIME_USECONDS(100);
+    while (ink_get_hrtime_internal() < until) {
+      ;
+    }
+    return EVENT_DONE;
+  }
+};
+
+struct Root : public Continuation {
+  Leaf *leaf;
+
+  explicit Root(Leaf *l) : Continuation(nullptr), leaf(l) { SET_HANDLER(&Root::handle); }
+
+  int
+  handle(int event, void *)
+  {
+    return leaf->handleEvent(event + 1000, nullptr);
+  }
+};
+
+const char *
+name_event(int event, int blen, char *buffer)
+{
+  snprintf(buffer, blen, "EV%d", event);
+  return buffer;
+}
+
+std::vector<std::string>
+read_lines(const char *path)
+{
+  std::vector<std::string> lines;
+  std::ifstream in(path);
+  for (std::string line; std::getline(in, line);) {
+    lines.push_back(line);
+  }
+  return lines;
+}
+} // namespace
+
+TEST_CASE("DispatchTrace nested calls", "[DispatchTrace]")
+{
+  char path[] = "/tmp/dispatch_trace.XXXXXX";
+  int fd      = mkstemp(path);
+  REQUIRE(fd >= 0);
+  close(fd);
+
+  Leaf leaf;
+  Root root(&leaf);
+
+  // Disabled, nothing is kept.
+  DispatchTrace::sample_rate = 0;
+  root.handleEvent(1, nullptr);
+
+  // Every other top level call and everything under it.
+  DispatchTrace::sample_rate = 2;
+  for (int event = 100; event < 104; ++event) {
+    root.handleEvent(event, nullptr);
+  }
+  DispatchTrace::sample_rate = 0;
+
+  REQUIRE(DispatchTrace::dump(path, &name_event));
+  std::vector<std::string> lines = read_lines(path);
+  unlink(path);
+
+  int roots = 0, leaves = 0;
+  for (auto const &line : lines) {
+    auto space = line.rfind(' ');
+    REQUIRE(space != std::string::npos);
+    std::string stack = line.substr(0, space);
+    int64_t ns        = std::stoll(line.substr(space + 1));
+
+    REQUIRE(stack.find("[EV1]") == std::string::npos);
+    REQUIRE(stack.find("[EV101]") == std::string::npos);
+    REQUIRE(stack.find("[EV103]") == std::string::npos);
+    if (stack.find("[EV1100]") != std::string::npos || stack.find("[EV1102]") != std::string::npos) {
+      // Thread, root, leaf - the leaf does the work.
+      REQUIRE(std::count(stack.begin(), stack.end(), ';') == 2);
+      REQUIRE(ns >= 100000);
+      ++leaves;
+    } else {
+      REQUIRE(std::count(stack.begin(), stack.end(), ';') == 1);
+      REQUIRE(ns < 100000);
+      ++roots;
+    }
+  }
+  REQUIRE(roots == 2);
+  REQUIRE(leaves == 2);
+}
@@ -0,0 +1,137 @@
+/** @file
+
+    Catch-based unit tests for the IOBuffer slab classes.
+
+    @section license License
+
+    Licensed to the Apache Software Foundation (ASF) under one
+    or more contributor license agreements.  See the NOTICE file
+    distributed with this work for additional information
+    regarding copyright ownership.  The ASF licenses this file
+    to you under the Apache License, Version 2.0 (the
+    "License"); you may not use this file except in compliance
+    with the License.  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+ */
+
+#define CATCH_CONFIG_RUNNER
+#include "catch.hpp"
+
+#include <set>
+#include <vector>
+
+#include "I_EventSystem.h"
+#include "tscore/I_Layout.h"
+
+#include "diags.i"
+
+int
+main(int argc, char *argv[])
+{
+  // global setup...
+  Layout::create();
+  init_diags("", nullptr);
+  RecProcessInit(RECM_STAND_ALONE);
+
+  ink_event_system_init(EVENT_SYSTEM_MODULE_PUBLIC_VERSION);
+  eventProcessor.start(2);
+
+  Thread *main_thread = new EThread;
+  main_thread->set_specific();
+
+  // The classes are set up either way, turn them on.
+  iobuffer_slab_enabled = true;
+
+  int result = Catch::Session().run(argc, argv);
+
+  // global clean-up...
+
+  exit(result);
+}
+
+TEST_CASE("IOBufferSlab fit index", "[IOBufferSlab]")
+{
+  REQUIRE(iobuffer_size_to_fit_index(100, MAX_BUFFER_SIZE_INDEX) == BUFFER_SIZE_INDEX_128);
+  REQUIRE(iobuffer_size_to_fit_index(8 * 1024, MAX_BUFFER_SIZE_INDEX) == BUFFER_SIZE_INDEX_8K);
+  REQUIRE(iobuffer_size_to_fit_index(16 * 1024, MAX_BUFFER_SIZE_INDEX) == BUFFER_SIZE_INDEX_16K);
+
+  int64_t idx = iobuffer_size_to_fit_index(9 * 1024, MAX_BUFFER_SIZE_INDEX);
+  REQUIRE(BUFFER_SIZE_INDEX_IS_SLAB(idx));
+  REQUIRE(index_to_buffer_size(idx) == 12 * 1024);
+
+  idx = iobuffer_size_to_fit_index(33 * 1024, MAX_BUFFER_SIZE_INDEX);
+  REQUIRE(index_to_buffer_size(idx) == 40 * 1024);
+  idx = iobuffer_size_to_fit_index(900 * 1024, MAX_BUFFER_SIZE_INDEX);
+  REQUIRE(idx == BUFFER_SIZE_INDEX_1M);
+
+  // Never more than the cap allows, past it the data is malloced.
+  idx = iobuffer_size_to_fit_index(9 * 1024, BUFFER_SIZE_INDEX_8K);
+  REQUIRE(BUFFER_SIZE_INDEX_IS_XMALLOCED(idx));
+
+  // Constant data is still told apart from the slab classes.
+  REQUIRE(!BUFFER_SIZE_INDEX_IS_SLAB(BUFFER_SIZE_INDEX_FOR_CONSTANT_SIZE(0)));
+  REQUIRE(!BUFFER_SIZE_INDEX_IS_SLAB(BUFFER_SIZE_NOT_ALLOCATED));
+  REQUIRE(BUFFER_SIZE_FOR_CONSTANT(BUFFER_SIZE_INDEX_FOR_CONSTANT_SIZE(12345)) == 12345);
+}
+
+TEST_CASE("IOBufferSlab alloc", "[IOBufferSlab]")
+{
+  for (int c = 0; c < BUFFER_SIZE_SLAB_CLASSES; c += 4) {
+    int64_t idx  = BUFFER_SIZE_INDEX_FOR_SLAB_CLASS(c);
+    int64_t size = index_to_buffer_size(idx);
+    std::vector<Ptr<IOBufferData>> data;
+    std::set<char *> seen;
+
+    // Enough to go through a few slabs.
+    for (int i = 0; i < 64; ++i) {
+      Ptr<IOBufferData> d = make_ptr(new_IOBufferData(idx, MEMALIGNED));
+      REQUIRE(d->block_size() == size);
+      REQUIRE((reinterpret_cast<uintptr_t>(d->data()) & 4095) == 0);
+      REQUIRE(seen.insert(d->data()).second);
+      memset(d->data(), i, size);
+      data.push_back(d);
+    }
+    for (int i = 0; i < 64; ++i) {
+      REQUIRE(data[i]->data()[0] == static_cast<char>(i));
+      REQUIRE(data[i]->data()[size - 1] == static_cast<char>(i));
+    }
+    data.clear();
+
+    // Freed blocks are handed out again.
+    Ptr<IOBufferData> d = make_ptr(new_IOBufferData(idx, MEMALIGNED));
+    REQUIRE(seen.count(d->data()) == 1);
+  }
+}
+
+TEST_CASE("MIOBuffer release blocks", "[IOBufferSlab]")
+{
+  MIOBuffer *buf         = new_MIOBuffer(BUFFER_SIZE_INDEX_4K);
+  IOBufferReader *reader = buf->alloc_reader();
+  char data[6000];
+
+  memset(data, 'x', sizeof(data));
+  buf->write(data, sizeof(data));
+
+  // Data not read yet is kept.
+  REQUIRE(buf->release_blocks() == 0);
+  REQUIRE(reader->read_avail() == static_cast<int64_t>(sizeof(data)));
+
+  reader->consume(reader->read_avail());
+  REQUIRE(buf->release_blocks() == 2 * 4096);
+  REQUIRE(buf->empty());
+  REQUIRE(reader->read_avail() == 0);
+
+  // The reader sees what is written next.
+  buf->write("next", 4);
+  REQUIRE(reader->read_avail() == 4);
+  REQUIRE(memcmp(reader->start(), "next", 4) == 0);
+
+  free_MIOBuffer(buf);
+}
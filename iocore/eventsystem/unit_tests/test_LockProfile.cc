@@ -0,0 +1,131 @@
+/** @file
+
+    Catch-based unit tests for the per site lock counters.
+
+    @section license License
+
+    Licensed to the Apache Software Foundation (ASF) under one
+    or more contributor license agreements.  See the NOTICE file
+    distributed with this work for additional information
+    regarding copyright ownership.  The ASF licenses this file
+    to you under the Apache License, Version 2.0 (the
+    "License"); you may not use this file except in compliance
+    with the License.  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+ */
+
+#define CATCH_CONFIG_RUNNER
+#include "catch.hpp"
+
+#include "I_EventSystem.h"
+#include "tscore/I_Layout.h"
+
+#include "diags.i"
+
+int
+main(int argc, char *argv[])
+{
+  // global setup...
+  Layout::create();
+  init_diags("", nullptr);
+  RecProcessInit(RECM_STAND_ALONE);
+
+  ink_event_system_init(EVENT_SYSTEM_MODULE_PUBLIC_VERSION);
+
+  Thread *main_thread = new EThread;
+  main_thread->set_specific();
+
+  int result = Catch::Session().run(argc, argv);
+
+  // global clean-up...
+
+  exit(result);
+}
+
+TEST_CASE("LockSite hold buckets", "[LockProfile]")
+{
+  LockSite site(__FILE__, __LINE__);
+
+  site.record_hold(0);
+  site.record_hold(HRTIME_USECONDS(10) - 1);
+  site.record_hold(HRTIME_USECONDS(10));
+  site.record_hold(HRTIME_MSECONDS(5));
+  site.record_hold(HRTIME_SECONDS(2));
+  REQUIRE(site.hold[0] == 2);
+  REQUIRE(site.hold[1] == 1);
+  REQUIRE(site.hold[2] == 0);
+  REQUIRE(site.hold[3] == 1);
+  REQUIRE(site.hold[LockSite::N_HOLD_BUCKETS - 1] == 1);
+}
+
+TEST_CASE("LockSite counters", "[LockProfile]")
+{
+  EThread *t = this_ethread();
+  Ptr<ProxyMutex> m(new_ProxyMutex());
+  LockSite try_site(__FILE__, __LINE__);
+  LockSite lock_site(__FILE__, __LINE__);
+
+  // Nothing is counted unless profiling.
+  lock_profiling = false;
+  {
+    MutexTryLock lock(
+#ifdef DEBUG
+      MakeSourceLocation(), nullptr,
+#endif
+      m, t, &try_site);
+    REQUIRE(lock.is_locked());
+  }
+  REQUIRE(try_site.acquires == 0);
+  REQUIRE(!try_site.linked);
+
+  lock_profiling = true;
+  {
+    MutexTryLock lock(
+#ifdef DEBUG
+      MakeSourceLocation(), nullptr,
+#endif
+      m, t, &try_site);
+    REQUIRE(lock.is_locked());
+    REQUIRE(m->site == &try_site);
+
+    // Taking it again on the holding thread is not an acquisition.
+    MutexLock again(
+#ifdef DEBUG
+      MakeSourceLocation(), nullptr,
+#endif
+      m, t, &lock_site);
+    REQUIRE(lock_site.acquires == 0);
+  }
+  REQUIRE(try_site.acquires == 1);
+  REQUIRE(try_site.linked);
+  REQUIRE(m->site == nullptr);
+
+  int64_t held = 0;
+  for (int64_t h : try_site.hold) {
+    held += h;
+  }
+  REQUIRE(held == 1);
+
+  // Held outside of the ProxyMutex bookkeeping, as another thread would.
+  ink_mutex_acquire(&m->the_mutex);
+  {
+    MutexTryLock lock(
+#ifdef DEBUG
+      MakeSourceLocation(), nullptr,
+#endif
+      m, t, &try_site);
+    REQUIRE(!lock.is_locked());
+  }
+  ink_mutex_release(&m->the_mutex);
+  REQUIRE(try_site.try_failures == 1);
+  REQUIRE(try_site.acquires == 1);
+
+  lock_profiling = false;
+}
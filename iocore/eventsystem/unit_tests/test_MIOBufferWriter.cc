@@ -136,3 +136,40 @@ TEST_CASE("MIOBufferWriter", "[MIOBW]")
   REQUIRE(bw.extent() == 3000);
 #endif
 }
+
+TEST_CASE("IOBufferReader get_iovec", "[MIOBW]")
+{
+  MIOBuffer *theMIOBuffer = new_MIOBuffer(BUFFER_SIZE_INDEX_128);
+  IOBufferReader *reader  = theMIOBuffer->alloc_reader();
+  std::string s{genData(1000)};
+
+  theMIOBuffer->write(s.data(), s.size());
+  reader->consume(10);
+
+  IOVec vec[16];
+  int niov      = 16;
+  int64_t bytes = reader->get_iovec(vec, &niov, INT64_MAX, 20);
+  REQUIRE(bytes == 970);
+  REQUIRE(niov > 1);
+
+  std::string joined;
+  for (int i = 0; i < niov; ++i) {
+    REQUIRE(vec[i].iov_len <= 128);
+    joined.append(static_cast<char *>(vec[i].iov_base), vec[i].iov_len);
+  }
+  REQUIRE(joined == s.substr(30));
+
+  // Limited by the entries and by the length asked for.
+  niov = 2;
+  REQUIRE(reader->get_iovec(vec, &niov) == static_cast<int64_t>(vec[0].iov_len + vec[1].iov_len));
+  REQUIRE(niov == 2);
+  niov = 16;
+  REQUIRE(reader->get_iovec(vec, &niov, 5) == 5);
+  REQUIRE(niov == 1);
+  REQUIRE(std::string(static_cast<char *>(vec[0].iov_base), 5) == s.substr(10, 5));
+
+  // Nothing was consumed.
+  REQUIRE(reader->read_avail() == 990);
+
+  free_MIOBuffer(theMIOBuffer);
+}
@@ -23,7 +23,7 @@
 
 #include "Main.h"
 #include "P_HostDB.h"
-#include "P_RefCountCacheSerializer.h"
+#include "P_RefCountCacheJournal.h"
 #include "tscore/I_Layout.h"
 #include "Show.h"
 #include "tscore/Tokenizer.h"
@@ -51,6 +51,8 @@ unsigned int hostdb_ip_stale_interval          = HOST_DB_IP_STALE;
 unsigned int hostdb_ip_timeout_interval        = HOST_DB_IP_TIMEOUT;
 unsigned int hostdb_ip_fail_timeout_interval   = HOST_DB_IP_FAIL_TIMEOUT;
 unsigned int hostdb_serve_stale_but_revalidate = 0;
+unsigned int hostdb_prefetch_window            = 0;
+unsigned int hostdb_prefetch_max_per_second    = 100;
 unsigned int hostdb_hostfile_check_interval    = 86400; // 1 day
 // Epoch timestamp of the current hosts file check.
 ink_time_t hostdb_current_interval = 0;
@@ -62,6 +64,7 @@ static char hostdb_filename[PATH_NAME_MAX]         = DEFAULT_HOST_DB_FILENAME;
 int hostdb_max_count                               = DEFAULT_HOST_DB_SIZE;
 char hostdb_hostfile_path[PATH_NAME_MAX]           = "";
 int hostdb_sync_frequency                          = 0;
+int hostdb_sync_journal                            = 0;
 int hostdb_disable_reverse_lookup                  = 0;
 
 ClassAllocator<HostDBContinuation> hostDBContAllocator("hostDBContAllocator");
@@ -325,6 +328,17 @@ HostDBCache::start(int flags)
   REC_ReadConfigInt32(hostdb_partitions, "proxy.config.hostdb.partitions");
   // how often to sync hostdb to disk
   REC_EstablishStaticConfigInt32(hostdb_sync_frequency, "proxy.config.cache.hostdb.sync_frequency");
+  // sync the changes only, and load in the background
+  REC_ReadConfigInt32(hostdb_sync_journal, "proxy.config.cache.hostdb.sync_journal");
+  // slots of the lock free cache of each thread
+  int thread_cache_size = 0;
+  REC_ReadConfigInt32(thread_cache_size, "proxy.config.hostdb.thread_cache_size");
+  if (thread_cache_size > 0) {
+    HostDBThreadCache::size = 1;
+    while (HostDBThreadCache::size < static_cast<unsigned int>(thread_cache_size)) {
+      HostDBThreadCache::size <<= 1;
+    }
+  }
 
   if (hostdb_max_size == 0) {
     Fatal("proxy.config.hostdb.max_size must be a non-zero number");
@@ -360,12 +374,18 @@ HostDBCache::start(int flags)
 
     Debug("hostdb", "Opening %s, partitions=%d storage_size=%" PRIu64 " items=%d", full_path, hostdb_partitions, hostdb_max_size,
           hostdb_max_count);
-    int load_ret = LoadRefCountCacheFromPath<HostDBInfo>(*this->refcountcache, storage_path, full_path, HostDBInfo::unmarshall);
-    if (load_ret != 0) {
-      Warning("Error loading cache from %s: %d", full_path, load_ret);
-    }
+    if (hostdb_sync_journal) {
+      auto journal = new RefCountCacheJournal<HostDBInfo>(this->refcountcache, hostdb_sync_frequency, storage_path, full_path);
+      this->refcountcache->set_listener(journal);
+      new RefCountCacheLoader<HostDBInfo>(this->refcountcache, journal, HostDBInfo::unmarshall);
+    } else {
+      int load_ret = LoadRefCountCacheFromPath<HostDBInfo>(*this->refcountcache, storage_path, full_path, HostDBInfo::unmarshall);
+      if (load_ret != 0) {
+        Warning("Error loading cache from %s: %d", full_path, load_ret);
+      }
 
-    eventProcessor.schedule_imm(new HostDBSync(hostdb_sync_frequency, storage_path, full_path), ET_TASK);
+      eventProcessor.schedule_imm(new HostDBSync(hostdb_sync_frequency, storage_path, full_path), ET_TASK);
+    }
   }
 
   this->pending_dns       = new Queue<HostDBContinuation, Continuation::Link_link>[hostdb_partitions];
@@ -387,6 +407,7 @@ HostDBProcessor::start(int, size_t)
 
   if (auto_clear_hostdb_flag) {
     hostDB.refcountcache->clear();
+    HostDBThreadCache::invalidate_all();
   }
 
   statPagesManager.register_http("hostdb", register_ShowHostDB);
@@ -405,6 +426,8 @@ HostDBProcessor::start(int, size_t)
   REC_EstablishStaticConfigInt32U(hostdb_ip_stale_interval, "proxy.config.hostdb.verify_after");
   REC_EstablishStaticConfigInt32U(hostdb_ip_fail_timeout_interval, "proxy.config.hostdb.fail.timeout");
   REC_EstablishStaticConfigInt32U(hostdb_serve_stale_but_revalidate, "proxy.config.hostdb.serve_stale_for");
+  REC_EstablishStaticConfigInt32U(hostdb_prefetch_window, "proxy.config.hostdb.prefetch.window");
+  REC_EstablishStaticConfigInt32U(hostdb_prefetch_max_per_second, "proxy.config.hostdb.prefetch.max_per_second");
   REC_EstablishStaticConfigInt32U(hostdb_hostfile_check_interval, "proxy.config.hostdb.host_file.interval");
   REC_EstablishStaticConfigInt32U(hostdb_round_robin_max_count, "proxy.config.hostdb.round_robin_max_count");
 
@@ -477,6 +500,7 @@ reply_to_cont(Continuation *cont, HostDBInfo *r, bool is_srv = false)
       cont->handleEvent(is_srv ? EVENT_SRV_LOOKUP : EVENT_HOST_DB_LOOKUP, nullptr);
       Warning("bogus entry deleted from HostDB: missing hostname");
       hostDB.refcountcache->erase(r->key);
+      HostDBThreadCache::invalidate(r->key);
       return false;
     }
     Debug("hostdb", "hostname = %s", r->hostname());
@@ -488,6 +512,7 @@ reply_to_cont(Continuation *cont, HostDBInfo *r, bool is_srv = false)
       cont->handleEvent(is_srv ? EVENT_SRV_LOOKUP : EVENT_HOST_DB_LOOKUP, nullptr);
       Warning("bogus entry deleted from HostDB: missing round-robin");
       hostDB.refcountcache->erase(r->key);
+      HostDBThreadCache::invalidate(r->key);
       return false;
     }
     ip_text_buffer ipb;
@@ -535,6 +560,21 @@ db_mark_for(IpAddr const &ip)
   return ip.isIp6() ? HOSTDB_MARK_IPV6 : HOSTDB_MARK_IPV4;
 }
 
+// Take one of the refreshes of this second for a record about to time out.
+static bool
+hostdb_prefetch_allowed()
+{
+  static std::atomic<unsigned int> second{0};
+  static std::atomic<unsigned int> used{0};
+  unsigned int now  = hostdb_current_interval;
+  unsigned int seen = second.load(std::memory_order_relaxed);
+
+  if (seen != now && second.compare_exchange_strong(seen, now)) {
+    used = 0;
+  }
+  return used++ < hostdb_prefetch_max_per_second;
+}
+
 Ptr<HostDBInfo>
 probe(const Ptr<ProxyMutex> &mutex, HostDBHash const &hash, bool ignore_timeout)
 {
@@ -563,8 +603,18 @@ probe(const Ptr<ProxyMutex> &mutex, HostDBHash const &hash, bool ignore_timeout)
     return make_ptr((HostDBInfo *)nullptr);
   }
 
+  // A record that is still used shortly before it times out is refreshed in the background, within
+  // the budget for that, so its lookups do not wait for DNS when it does.
+  bool prefetch = !ignore_timeout && !r->reverse_dns && !r->is_failed() && r->is_ip_prefetch() &&
+                  !hostDB.is_pending_dns_for_hash(hash.hash) && hostdb_prefetch_allowed();
+  if (prefetch) {
+    HOSTDB_INCREMENT_DYN_STAT(hostdb_prefetch_stat);
+    Debug("hostdb", "prefetch %u %u %u, using it and refreshing it", r->ip_interval(), r->ip_timestamp, r->ip_timeout_interval);
+  }
+
   // If the record is stale, but we want to revalidate-- lets start that up
-  if ((!ignore_timeout && r->is_ip_stale() && !r->reverse_dns) || (r->is_ip_timeout() && r->serve_stale_but_revalidate())) {
+  if (prefetch || (!ignore_timeout && r->is_ip_stale() && !r->reverse_dns) ||
+      (r->is_ip_timeout() && r->serve_stale_but_revalidate())) {
     if (hostDB.is_pending_dns_for_hash(hash.hash)) {
       Debug("hostdb", "stale %u %u %u, using it and pending to refresh it", r->ip_interval(), r->ip_timestamp,
             r->ip_timeout_interval);
@@ -580,6 +630,75 @@ probe(const Ptr<ProxyMutex> &mutex, HostDBHash const &hash, bool ignore_timeout)
   return r;
 }
 
+unsigned int HostDBThreadCache::size = 0;
+std::atomic<uint64_t> HostDBThreadCache::_versions[HostDBThreadCache::N_STRIPES];
+
+namespace
+{
+struct HostDBThreadCacheSlot {
+  uint64_t key     = 0;
+  uint64_t version = 0;
+  Ptr<HostDBInfo> record;
+};
+
+thread_local std::vector<HostDBThreadCacheSlot> hostdb_thread_slots;
+} // namespace
+
+Ptr<HostDBInfo>
+HostDBThreadCache::get(uint64_t key)
+{
+  if (hostdb_thread_slots.empty()) {
+    return Ptr<HostDBInfo>();
+  }
+
+  HostDBThreadCacheSlot &slot = hostdb_thread_slots[key & (size - 1)];
+  if (!slot.record || slot.key != key) {
+    return Ptr<HostDBInfo>();
+  }
+  // Anything but a fresh record goes through probe(), for the timeouts and the refresh.
+  if (slot.version != version(key) || slot.record->is_ip_stale() || slot.record->is_ip_prefetch() || slot.record->is_ip_timeout()) {
+    slot.record = nullptr;
+    return Ptr<HostDBInfo>();
+  }
+  return slot.record;
+}
+
+uint64_t
+HostDBThreadCache::version(uint64_t key)
+{
+  return _versions[key % N_STRIPES].load(std::memory_order_acquire);
+}
+
+void
+HostDBThreadCache::put(uint64_t key, Ptr<HostDBInfo> const &r, uint64_t version)
+{
+  if (size == 0 || r->is_failed() || (r->reverse_dns && !r->hostname()) || (!r->is_srv && r->round_robin && !r->rr())) {
+    return;
+  }
+  if (hostdb_thread_slots.empty()) {
+    hostdb_thread_slots.resize(size);
+  }
+
+  HostDBThreadCacheSlot &slot = hostdb_thread_slots[key & (size - 1)];
+  slot.key                    = key;
+  slot.version                = version;
+  slot.record                 = r;
+}
+
+void
+HostDBThreadCache::invalidate(uint64_t key)
+{
+  _versions[key % N_STRIPES].fetch_add(1, std::memory_order_release);
+}
+
+void
+HostDBThreadCache::invalidate_all()
+{
+  for (auto &version : _versions) {
+    version.fetch_add(1, std::memory_order_release);
+  }
+}
+
 //
 // Insert a HostDBInfo into the database
 // A null value indicates that the block is empty.
@@ -601,6 +720,41 @@ HostDBContinuation::insert(unsigned int attl)
         folded_hash, r->ip_timestamp, r->ip_timeout_interval, attl);
 
   hostDB.refcountcache->put(folded_hash, r, 0, r->expiry_time());
+  HostDBThreadCache::invalidate(folded_hash);
+  return r;
+}
+
+//
+// A literal address or an entry of the host file needs no DNS, record it in line
+// instead of handing it to a continuation which would find it in do_dns().
+// The record still goes to the HostDB so that the down marks of the address stick.
+// The caller holds the lock of the bucket of @a hash.
+//
+static Ptr<HostDBInfo>
+static_lookup(HostDBHash const &hash, HostDBProcessor::Options const &opt)
+{
+  if (!hash.host_name || !hash.host_len || hash.db_mark == HOSTDB_MARK_SRV) {
+    return Ptr<HostDBInfo>();
+  }
+
+  IpAddr ip;
+  unsigned int ttl = HOST_DB_MAX_TTL;
+  if (0 != ip.load(std::string_view(hash.host_name, hash.host_len))) {
+    Ptr<RefCountedHostsFileMap> current_host_file_map = hostDB.hosts_file_ptr;
+    HostsFileMap::iterator find_result = current_host_file_map->hosts_file_map.find(ts::ConstBuffer(hash.host_name, hash.host_len));
+    if (find_result == current_host_file_map->hosts_file_map.end()) {
+      return Ptr<HostDBInfo>();
+    }
+    ip  = find_result->second;
+    ttl = std::max<ink_time_t>(current_host_file_map->next_sync_time - ink_time(), 1);
+  }
+
+  HostDBContinuation *c = hostDBContAllocator.alloc();
+  HostDBContinuation::Options copt;
+  copt.host_res_style = opt.host_res_style;
+  c->init(hash, copt);
+  Ptr<HostDBInfo> r = make_ptr(c->lookup_done(ip, c->hash.host_name, false, ttl, nullptr));
+  hostdb_cont_free(c);
   return r;
 }
 
@@ -647,13 +801,30 @@ HostDBProcessor::getby(Continuation *cont, cb_process_result_pfn cb_process_resu
     bool loop = lock.is_locked();
     while (loop) {
       loop = false; // Only loop on explicit set for retry.
+      // A fresh record of this thread needs no lock
+      if (Ptr<HostDBInfo> r = HostDBThreadCache::get(hash.hash.fold()); r) {
+        Debug("hostdb", "immediate answer for %.*s from the thread cache", hash.host_len, hash.host_name ? hash.host_name : "");
+        HOSTDB_INCREMENT_DYN_STAT(hostdb_total_hits_stat);
+        if (cb_process_result) {
+          (cont->*cb_process_result)(r.get());
+        } else {
+          reply_to_cont(cont, r.get());
+        }
+        return ACTION_RESULT_DONE;
+      }
       // find the partition lock
       Ptr<ProxyMutex> bucket_mutex = hostDB.refcountcache->lock_for_key(hash.hash.fold());
       MUTEX_TRY_LOCK(lock2, bucket_mutex, thread);
       if (lock2.is_locked()) {
         // If we can get the lock and a level 1 probe succeeds, return
+        uint64_t version  = HostDBThreadCache::version(hash.hash.fold());
         Ptr<HostDBInfo> r = probe(bucket_mutex, hash, false);
+        if (!r && (r = static_lookup(hash, opt))) {
+          Debug("hostdb", "static answer for %.*s", hash.host_len, hash.host_name);
+          version = HostDBThreadCache::version(hash.hash.fold());
+        }
         if (r) {
+          HostDBThreadCache::put(hash.hash.fold(), r, version);
           // fail, see if we should retry with alternate
           if (hash.db_mark != HOSTDB_MARK_SRV && r->is_failed() && hash.host_name) {
             loop = check_for_retry(hash.db_mark, opt.host_res_style);
@@ -964,6 +1135,7 @@ remove_round_robin(HostDBInfo *r, const char *hostname, IpAddr const &ip)
         rr->good--;
         if (rr->good <= 0) {
           hostDB.refcountcache->erase(r->key);
+          HostDBThreadCache::invalidate(r->key);
           return false;
         } else {
           if (is_debug_tag_set("hostdb")) {
@@ -1169,6 +1341,7 @@ restore_info(HostDBInfo *r, HostDBInfo *old_r, HostDBInfo &old_info, HostDBRound
 int
 HostDBContinuation::dnsEvent(int event, HostEnt *e)
 {
+  AtsMemTagScope mem_tag(ATS_MEM_TAG_HOSTDB);
   ink_assert(this_ethread() == hostDB.refcountcache->lock_for_key(hash.hash.fold())->thread_holding);
   if (timeout) {
     timeout->cancel(this);
@@ -1218,6 +1391,7 @@ HostDBContinuation::dnsEvent(int event, HostEnt *e)
     // If the DNS lookup failed with NXDOMAIN, remove the old record
     if (e && e->isNameError() && old_r) {
       hostDB.refcountcache->erase(old_r->key);
+      HostDBThreadCache::invalidate(old_r->key);
       old_r = nullptr;
       Debug("hostdb", "Removing the old record when the DNS lookup failed with NXDOMAIN");
     }
@@ -1401,6 +1575,7 @@ HostDBContinuation::dnsEvent(int event, HostEnt *e)
     ink_assert(failed || !r->round_robin || r->app.rr.offset);
 
     hostDB.refcountcache->put(hash.hash.fold(), r, allocSize, r->expiry_time());
+    HostDBThreadCache::invalidate(hash.hash.fold());
 
     // try to callback the user
     //
@@ -2144,6 +2319,9 @@ ink_hostdb_init(ts::ModuleVersion v)
   RecRegisterRawStat(hostdb_rsb, RECT_PROCESS, "proxy.process.hostdb.re_dns_on_reload", RECD_INT, RECP_PERSISTENT,
                      (int)hostdb_re_dns_on_reload_stat, RecRawStatSyncSum);
 
+  RecRegisterRawStat(hostdb_rsb, RECT_PROCESS, "proxy.process.hostdb.prefetches", RECD_INT, RECP_PERSISTENT,
+                     (int)hostdb_prefetch_stat, RecRawStatSyncSum);
+
   ts_host_res_global_init();
 }
 
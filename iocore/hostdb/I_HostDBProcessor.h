@@ -60,6 +60,7 @@ extern unsigned int hostdb_ip_stale_interval;
 extern unsigned int hostdb_ip_timeout_interval;
 extern unsigned int hostdb_ip_fail_timeout_interval;
 extern unsigned int hostdb_serve_stale_but_revalidate;
+extern unsigned int hostdb_prefetch_window;
 extern unsigned int hostdb_round_robin_max_count;
 
 static inline unsigned int
@@ -238,6 +239,15 @@ struct HostDBInfo : public RefCountObj {
     return ip_timeout_interval >= 2 * hostdb_ip_stale_interval && ip_interval() >= hostdb_ip_stale_interval;
   }
 
+  /// Is this close enough to its timeout to be refreshed ahead of it? At most half its TTL is left for that.
+  bool
+  is_ip_prefetch() const
+  {
+    int remaining = ip_time_remaining();
+    return hostdb_prefetch_window > 0 && remaining > 0 &&
+           static_cast<unsigned int>(remaining) <= std::min(hostdb_prefetch_window, ip_timeout_interval / 2);
+  }
+
   bool
   is_ip_timeout() const
   {
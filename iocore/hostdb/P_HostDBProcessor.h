@@ -27,6 +27,8 @@
 
 #pragma once
 
+#include <atomic>
+
 #include "I_HostDBProcessor.h"
 #include "tscore/TsBuffer.h"
 
@@ -141,6 +143,7 @@ enum HostDB_Stats {
   hostdb_ttl_stat,         // D average TTL
   hostdb_ttl_expires_stat, // D == TTL Expires
   hostdb_re_dns_on_reload_stat,
+  hostdb_prefetch_stat,
   HostDB_Stat_Count
 };
 
@@ -204,6 +207,37 @@ struct HostDBCache {
   bool is_pending_dns_for_hash(const CryptoHash &hash);
 };
 
+/** The records recently found by the lookups of one thread, read without a lock.
+
+    A lookup normally takes the lock of the partition of its record, and is rescheduled if that is
+    busy. With @c proxy.config.hostdb.thread_cache_size each thread also keeps the records it found in
+    a small direct mapped table, and answers the lookups that hit a fresh record there without a lock.
+    A change to a record in the HostDB bumps the version of the stripe of its key, and a thread drops
+    its copy once the version it read the record at is gone. Stale, timed out and failed records are not
+    answered from here, so those lookups go through the HostDB as before.
+ */
+class HostDBThreadCache
+{
+public:
+  /// Slots per thread, a power of 2, @c 0 if disabled.
+  static unsigned int size;
+
+  /// @return The fresh record of @a key, or @c nullptr.
+  static Ptr<HostDBInfo> get(uint64_t key);
+  /// @return The version of @a key, read before reading its record from the HostDB.
+  static uint64_t version(uint64_t key);
+  /// Keep @a r, the record of @a key in the HostDB at @a version.
+  static void put(uint64_t key, Ptr<HostDBInfo> const &r, uint64_t version);
+  /// The record of @a key was changed or removed in the HostDB.
+  static void invalidate(uint64_t key);
+  /// All of the records were removed.
+  static void invalidate_all();
+
+private:
+  static constexpr unsigned int N_STRIPES = 4096;
+  static std::atomic<uint64_t> _versions[N_STRIPES];
+};
+
 inline int
 HostDBRoundRobin::index_of(sockaddr const *ip)
 {
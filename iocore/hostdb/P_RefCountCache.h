@@ -113,6 +113,21 @@ public:
   }
 };
 
+// Receives the changes made to a RefCountCache, to persist them incrementally (RefCountCacheJournal).
+// The methods are called with the partition of the key locked.
+class RefCountCacheListener
+{
+public:
+  virtual ~RefCountCacheListener() = default;
+
+  // `entry` is the new value of its key
+  virtual void put(const RefCountCacheHashEntry &entry) = 0;
+  // `key` was removed
+  virtual void erase(uint64_t key) = 0;
+  // all the keys were removed
+  virtual void clear() = 0;
+};
+
 // Since the hashing values are all fixed size, we can simply use a classAllocator to avoid mallocs
 extern ClassAllocator<PriorityQueueEntry<RefCountCacheHashEntry *>> expiryQueueEntry;
 
@@ -156,8 +171,8 @@ public:
 
   RefCountCachePartition(unsigned int part_num, uint64_t max_size, unsigned int max_items, RecRawStatBlock *rsb = nullptr);
   Ptr<C> get(uint64_t key);
-  void put(uint64_t key, C *item, int size = 0, int expire_time = 0);
-  void erase(uint64_t key, ink_time_t expiry_time = -1);
+  void put(uint64_t key, C *item, int size = 0, int expire_time = 0, bool notify = true);
+  void erase(uint64_t key, ink_time_t expiry_time = -1, bool notify = true);
 
   void clear();
   bool is_full() const;
@@ -169,7 +184,8 @@ public:
 
   hash_type &get_map();
 
-  Ptr<ProxyMutex> lock; // Lock
+  Ptr<ProxyMutex> lock;                       // Lock
+  RefCountCacheListener *listener = nullptr; // Told of the changes, if set
 
 private:
   void metric_inc(RefCountCache_Stats metric_enum, int64_t data);
@@ -209,17 +225,20 @@ RefCountCachePartition<C>::get(uint64_t key)
 
 template <class C>
 void
-RefCountCachePartition<C>::put(uint64_t key, C *item, int size, int expire_time)
+RefCountCachePartition<C>::put(uint64_t key, C *item, int size, int expire_time, bool notify)
 {
   this->metric_inc(refcountcache_total_inserts_stat, 1);
   size += sizeof(C);
-  // Remove any colliding entries
-  this->erase(key);
+  // Remove any colliding entries, the listener is told of the new value below
+  this->erase(key, -1, false);
 
   // if we are full, and can't make space-- then don't store the item
   if (this->is_full() && !this->make_space_for(size)) {
     Debug("refcountcache", "partition %d is full-- not storing item key=%" PRIu64, this->part_num, key);
     this->metric_inc(refcountcache_total_failed_inserts_stat, 1);
+    if (notify && this->listener) {
+      this->listener->erase(key);
+    }
     return;
   }
 
@@ -242,11 +261,14 @@ RefCountCachePartition<C>::put(uint64_t key, C *item, int size, int expire_time)
   this->items++;
   this->metric_inc(refcountcache_current_size_stat, (int64_t)val->meta.size);
   this->metric_inc(refcountcache_current_items_stat, 1);
+  if (notify && this->listener) {
+    this->listener->put(*val);
+  }
 }
 
 template <class C>
 void
-RefCountCachePartition<C>::erase(uint64_t key, ink_time_t expiry_time)
+RefCountCachePartition<C>::erase(uint64_t key, ink_time_t expiry_time, bool notify)
 {
   if (auto it = this->item_map.find(key); it != this->item_map.end()) {
     if (expiry_time >= 0 && it->meta.expiry_time != expiry_time) {
@@ -254,6 +276,9 @@ RefCountCachePartition<C>::erase(uint64_t key, ink_time_t expiry_time)
     }
     this->item_map.erase(it);
     this->dealloc_entry(it);
+    if (notify && this->listener) {
+      this->listener->erase(key);
+    }
   }
 }
 
@@ -320,9 +345,10 @@ RefCountCachePartition<C>::make_space_for(unsigned int size)
       return false;
     }
 
-    // If the first item has expired, lets evict it, and then go around again
+    // If the first item has expired, lets evict it, and then go around again. It is not loaded
+    // back from disk either, having expired, so the listener is not told.
     if (top_item->node->meta.expiry_time < now) {
-      this->erase(top_item->node->meta.key);
+      this->erase(top_item->node->meta.key, -1, false);
     } else { // if the first item isn't expired-- the rest won't be either (queue is sorted)
       return false;
     }
@@ -406,6 +432,11 @@ public:
   void erase(uint64_t key);
   void clear();
 
+  // Put or erase (`item` is nullptr) a value read back from disk, the listener is not told
+  void restore(uint64_t key, C *item, int size = 0, ink_time_t expiry_time = -1);
+  // Tell `listener` of the changes from now on, it must outlive the cache
+  void set_listener(RefCountCacheListener *listener);
+
   // Some methods to get some internal state
   int partition_for_key(uint64_t key);
   Ptr<ProxyMutex> lock_for_key(uint64_t key);
@@ -423,6 +454,7 @@ private:
   // Header
   RefCountCacheHeader header; // Our header
   RecRawStatBlock *rsb;
+  RefCountCacheListener *listener = nullptr;
 };
 
 template <class C>
@@ -562,6 +594,30 @@ RefCountCache<C>::clear()
   for (unsigned int i = 0; i < this->num_partitions; i++) {
     this->partitions[i]->clear();
   }
+  if (this->listener) {
+    this->listener->clear();
+  }
+}
+
+template <class C>
+void
+RefCountCache<C>::restore(uint64_t key, C *item, int size, ink_time_t expiry_time)
+{
+  if (item) {
+    this->partitions[this->partition_for_key(key)]->put(key, item, size, expiry_time, false);
+  } else {
+    this->partitions[this->partition_for_key(key)]->erase(key, -1, false);
+  }
+}
+
+template <class C>
+void
+RefCountCache<C>::set_listener(RefCountCacheListener *listener)
+{
+  this->listener = listener;
+  for (unsigned int i = 0; i < this->num_partitions; i++) {
+    this->partitions[i]->listener = listener;
+  }
 }
 
 // Fill `cache` with items in file `filepath` using `load_func` to unmarshall the record.
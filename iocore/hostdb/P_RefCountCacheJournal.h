@@ -0,0 +1,488 @@
+/** @file
+
+  Incremental persistence of a RefCountCache.
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ */
+
+#pragma once
+
+#include "P_RefCountCacheSerializer.h"
+
+#include <algorithm>
+#include <mutex>
+#include <string>
+#include <unordered_set>
+#include <vector>
+#include <sys/stat.h>
+
+// Instead of writing a snapshot of the whole cache at each sync, the journal appends the changes
+// made to the cache since the previous sync to a file next to the snapshot:
+//    - the snapshot, written by RefCountCacheSerializer
+//    - `<snapshot>.journal.old`, the changes since the start of the snapshot, if that is not done
+//    - `<snapshot>.journal`, the changes since
+// Replayed in that order they are the cache at the last sync. Once the journal is larger than the
+// snapshot it is compacted: it is renamed to the old journal, a new snapshot is written and the old
+// journal is removed. An item is written with its RefCountCacheItemMeta as for the snapshot, and an
+// erase as a RefCountCacheItemMeta of size 0.
+//
+// Changes to the items in place, without a `put`, are only persisted by the next snapshot.
+template <class C> class RefCountCacheJournal : public Continuation, public RefCountCacheListener
+{
+public:
+  RefCountCacheJournal(RefCountCache<C> *cc, int frequency, std::string dirname, std::string filename);
+  ~RefCountCacheJournal() override;
+
+  void put(const RefCountCacheHashEntry &entry) override;
+  void erase(uint64_t key) override;
+  void clear() override;
+
+  // The files to load, in order
+  std::vector<std::string> files() const;
+  // Should the load skip `key`? It has changed since the load started. Call with its partition locked.
+  bool changed_since_load(uint64_t key);
+  // Was the cache cleared since the load started?
+  bool cleared_since_load();
+  // The load is done, the changes are not tracked any more and compactions can start
+  void loaded();
+
+  int sync_event(int event, Event *e);
+
+private:
+  void append(RefCountCacheHashEntry *entry);
+  int write_pending();
+  bool open_journal();
+  void close_journal();
+  void start_compaction();
+  void finish_compaction();
+  int write_to_disk(const void *ptr, size_t n_bytes);
+
+  RefCountCache<C> *cache;
+  int frequency;
+  std::string dirname;
+  std::string filename;
+  std::string journal_filename;
+  std::string old_journal_filename;
+
+  int fd               = -1;
+  int64_t journal_size = 0;
+  bool compacting      = false;
+  time_t compaction_start;
+
+  std::mutex pending_mutex; // for the members below, changed from any thread
+  std::vector<RefCountCacheHashEntry *> pending;
+  bool loading = true;
+  bool cleared = false;
+  bool wipe    = false; // remove the files at the next sync, for a `clear`
+  std::unordered_set<uint64_t> changed;
+};
+
+// Loads the files of a journal in the background, a few items at a time, while the cache serves.
+template <class C> class RefCountCacheLoader : public Continuation
+{
+public:
+  using LoadFunc = C *(*)(char *, unsigned int);
+
+  RefCountCacheLoader(RefCountCache<C> *cc, RefCountCacheJournal<C> *journal, LoadFunc load_func);
+
+  int load_event(int event, Event *e);
+
+private:
+  bool open_next();
+  void done();
+
+  static constexpr int ITEMS_PER_EVENT = 1000;
+
+  RefCountCache<C> *cache;
+  RefCountCacheJournal<C> *journal;
+  LoadFunc load_func;
+
+  std::vector<std::string> paths;
+  size_t next_path = 0;
+  int fd           = -1;
+  int total_items  = 0;
+  std::vector<char> buf;
+};
+
+template <class C>
+RefCountCacheJournal<C>::RefCountCacheJournal(RefCountCache<C> *cc, int frequency, std::string dirname, std::string filename)
+  : Continuation(new_ProxyMutex()),
+    cache(cc),
+    frequency(frequency),
+    dirname(std::move(dirname)),
+    filename(std::move(filename)),
+    compaction_start(0)
+{
+  this->journal_filename     = this->filename + ".journal";
+  this->old_journal_filename = this->journal_filename + ".old";
+
+  SET_HANDLER(&RefCountCacheJournal::sync_event);
+  eventProcessor.schedule_every(this, HRTIME_SECONDS(frequency), ET_TASK);
+}
+
+template <class C> RefCountCacheJournal<C>::~RefCountCacheJournal()
+{
+  this->close_journal();
+  for (auto &entry : this->pending) {
+    RefCountCacheHashEntry::free<C>(entry);
+  }
+}
+
+template <class C>
+void
+RefCountCacheJournal<C>::put(const RefCountCacheHashEntry &entry)
+{
+  RefCountCacheHashEntry *copy = RefCountCacheHashEntry::alloc();
+  copy->set(entry.item.get(), entry.meta.key, entry.meta.size, entry.meta.expiry_time);
+  this->append(copy);
+}
+
+template <class C>
+void
+RefCountCacheJournal<C>::erase(uint64_t key)
+{
+  RefCountCacheHashEntry *copy = RefCountCacheHashEntry::alloc();
+  copy->meta                   = RefCountCacheItemMeta(key, 0, 0);
+  this->append(copy);
+}
+
+template <class C>
+void
+RefCountCacheJournal<C>::clear()
+{
+  std::lock_guard<std::mutex> lock(this->pending_mutex);
+  for (auto &entry : this->pending) {
+    RefCountCacheHashEntry::free<C>(entry);
+  }
+  this->pending.clear();
+  this->cleared = true;
+  this->wipe    = true;
+}
+
+template <class C>
+void
+RefCountCacheJournal<C>::append(RefCountCacheHashEntry *entry)
+{
+  std::lock_guard<std::mutex> lock(this->pending_mutex);
+  if (this->loading) {
+    this->changed.insert(entry->meta.key);
+  }
+  this->pending.push_back(entry);
+}
+
+template <class C>
+std::vector<std::string>
+RefCountCacheJournal<C>::files() const
+{
+  return {this->filename, this->old_journal_filename, this->journal_filename};
+}
+
+template <class C>
+bool
+RefCountCacheJournal<C>::changed_since_load(uint64_t key)
+{
+  std::lock_guard<std::mutex> lock(this->pending_mutex);
+  return this->changed.count(key) > 0;
+}
+
+template <class C>
+bool
+RefCountCacheJournal<C>::cleared_since_load()
+{
+  std::lock_guard<std::mutex> lock(this->pending_mutex);
+  return this->cleared;
+}
+
+template <class C>
+void
+RefCountCacheJournal<C>::loaded()
+{
+  std::lock_guard<std::mutex> lock(this->pending_mutex);
+  this->loading = false;
+  this->changed.clear();
+  this->changed.rehash(0);
+}
+
+template <class C>
+int
+RefCountCacheJournal<C>::sync_event(int event, Event * /* e */)
+{
+  if (event == REFCOUNT_CACHE_EVENT_SYNC) {
+    this->finish_compaction();
+    return EVENT_DONE;
+  }
+
+  bool wipe_files = false;
+  if (!this->compacting) {
+    std::lock_guard<std::mutex> lock(this->pending_mutex);
+    std::swap(wipe_files, this->wipe);
+  }
+  if (wipe_files) {
+    this->close_journal();
+    for (auto &path : this->files()) {
+      unlink(path.c_str());
+    }
+  }
+
+  int ret = this->write_pending();
+  if (ret < 0) {
+    Warning("Error writing to the journal %s: %s", this->journal_filename.c_str(), strerror(-ret));
+    this->close_journal();
+    return EVENT_CONT;
+  }
+
+  bool loading_now;
+  {
+    std::lock_guard<std::mutex> lock(this->pending_mutex);
+    loading_now = this->loading;
+  }
+  struct stat st;
+  int64_t snapshot_size = stat(this->filename.c_str(), &st) == 0 ? st.st_size : 0;
+  // Small journals are not worth a snapshot.
+  if (!loading_now && !this->compacting && this->journal_size > std::max<int64_t>(snapshot_size, 1 << 20)) {
+    this->start_compaction();
+  }
+  return EVENT_CONT;
+}
+
+template <class C>
+int
+RefCountCacheJournal<C>::write_pending()
+{
+  std::vector<RefCountCacheHashEntry *> entries;
+  {
+    std::lock_guard<std::mutex> lock(this->pending_mutex);
+    entries.swap(this->pending);
+  }
+  if (entries.empty()) {
+    return 0;
+  }
+
+  int ret = this->open_journal() ? 0 : -errno;
+  for (auto &entry : entries) {
+    if (ret == 0) {
+      ret = this->write_to_disk(&entry->meta, sizeof(entry->meta));
+    }
+    if (ret == 0 && entry->meta.size > 0) {
+      ret = this->write_to_disk(entry->item.get(), entry->meta.size);
+    }
+    if (ret == 0) {
+      this->journal_size += sizeof(entry->meta) + entry->meta.size;
+    }
+    RefCountCacheHashEntry::free<C>(entry);
+  }
+  if (ret == 0) {
+    ret = socketManager.fsync(this->fd);
+  }
+  return ret;
+}
+
+template <class C>
+bool
+RefCountCacheJournal<C>::open_journal()
+{
+  if (this->fd >= 0) {
+    return true;
+  }
+
+  this->fd = socketManager.open(this->journal_filename.c_str(), O_RDWR | O_CREAT | O_APPEND, 0644);
+  if (this->fd < 0) {
+    return false;
+  }
+
+  struct stat st;
+  if (fstat(this->fd, &st) == 0 && st.st_size > 0) {
+    this->journal_size = st.st_size;
+  } else {
+    this->journal_size = sizeof(RefCountCacheHeader);
+    if (this->write_to_disk(&this->cache->get_header(), sizeof(RefCountCacheHeader)) < 0) {
+      this->close_journal();
+      return false;
+    }
+  }
+  return true;
+}
+
+template <class C>
+void
+RefCountCacheJournal<C>::close_journal()
+{
+  if (this->fd >= 0) {
+    socketManager.close(this->fd);
+    this->fd = -1;
+  }
+}
+
+template <class C>
+void
+RefCountCacheJournal<C>::start_compaction()
+{
+  Debug("refcountcache", "compacting the journal %s of %" PRId64 " bytes", this->journal_filename.c_str(), this->journal_size);
+
+  // If the old journal is still there the last snapshot failed, and this one replaces it as well.
+  this->close_journal();
+  if (access(this->old_journal_filename.c_str(), F_OK) != 0 &&
+      rename(this->journal_filename.c_str(), this->old_journal_filename.c_str()) != 0) {
+    Warning("Unable to rename the journal %s: %s", this->journal_filename.c_str(), strerror(errno));
+    return;
+  }
+  this->journal_size     = 0;
+  this->compacting       = true;
+  this->compaction_start = time(nullptr);
+  new RefCountCacheSerializer<C>(this, this->cache, this->frequency, this->dirname, this->filename);
+}
+
+template <class C>
+void
+RefCountCacheJournal<C>::finish_compaction()
+{
+  struct stat st;
+
+  this->compacting = false;
+  // The serializer only renames the snapshot in place once it is written out.
+  if (stat(this->filename.c_str(), &st) == 0 && st.st_mtime >= this->compaction_start) {
+    unlink(this->old_journal_filename.c_str());
+    Debug("refcountcache", "compacted the journal %s", this->journal_filename.c_str());
+  } else {
+    Warning("Unable to write the snapshot %s, keeping the journal %s", this->filename.c_str(), this->old_journal_filename.c_str());
+  }
+}
+
+template <class C>
+int
+RefCountCacheJournal<C>::write_to_disk(const void *ptr, size_t n_bytes)
+{
+  size_t written = 0;
+  while (written < n_bytes) {
+    int ret = socketManager.write(this->fd, (char *)ptr + written, n_bytes - written);
+    if (ret <= 0) {
+      return ret < 0 ? ret : -EIO;
+    }
+    written += ret;
+  }
+  return 0;
+}
+
+template <class C>
+RefCountCacheLoader<C>::RefCountCacheLoader(RefCountCache<C> *cc, RefCountCacheJournal<C> *journal, LoadFunc load_func)
+  : Continuation(new_ProxyMutex()), cache(cc), journal(journal), load_func(load_func), paths(journal->files())
+{
+  SET_HANDLER(&RefCountCacheLoader::load_event);
+  eventProcessor.schedule_imm(this, ET_TASK);
+}
+
+template <class C>
+int
+RefCountCacheLoader<C>::load_event(int /* event */, Event *e)
+{
+  ink_time_t now = ink_time();
+
+  for (int n = 0; n < ITEMS_PER_EVENT; ++n) {
+    if (this->journal->cleared_since_load()) {
+      this->done();
+      return EVENT_DONE;
+    }
+    if (this->fd < 0 && !this->open_next()) {
+      this->done();
+      return EVENT_DONE;
+    }
+
+    RefCountCacheItemMeta meta(0, 0);
+    int read_ret = read(this->fd, &meta, sizeof(meta));
+    if (read_ret != sizeof(meta)) {
+      // The end of the file, or of what was written of it.
+      socketManager.close(this->fd);
+      this->fd = -1;
+      continue;
+    }
+
+    C *item = nullptr;
+    if (meta.size > 0) {
+      this->buf.resize(meta.size);
+      read_ret = read(this->fd, this->buf.data(), meta.size);
+      if (read_ret != static_cast<int>(meta.size)) {
+        Warning("Encountered error reading item from cache: %d", read_ret);
+        socketManager.close(this->fd);
+        this->fd = -1;
+        continue;
+      }
+      if (meta.expiry_time >= 0 && meta.expiry_time < now) {
+        continue;
+      }
+      if ((item = this->load_func(this->buf.data(), meta.size)) == nullptr) {
+        continue;
+      }
+    }
+
+    Ptr<ProxyMutex> partition_mutex = this->cache->lock_for_key(meta.key);
+    SCOPED_MUTEX_LOCK(lock, partition_mutex, e->ethread);
+    if (this->journal->changed_since_load(meta.key)) {
+      if (item) {
+        item->free();
+      }
+      continue;
+    }
+    this->cache->restore(meta.key, item, item ? meta.size - sizeof(C) : 0, meta.expiry_time);
+    this->total_items += item ? 1 : 0;
+  }
+
+  e->schedule_imm(ET_TASK);
+  return EVENT_CONT;
+}
+
+template <class C>
+bool
+RefCountCacheLoader<C>::open_next()
+{
+  while (this->next_path < this->paths.size()) {
+    const std::string &path = this->paths[this->next_path++];
+
+    this->fd = socketManager.open(path.c_str(), O_RDONLY);
+    if (this->fd < 0) {
+      if (errno != ENOENT) {
+        Warning("Unable to open file %s; [Error]: %s", path.c_str(), strerror(errno));
+      }
+      continue;
+    }
+
+    RefCountCacheHeader header;
+    int read_ret = read(this->fd, &header, sizeof(header));
+    if (read_ret != sizeof(header) || !this->cache->get_header().compatible(&header)) {
+      Warning("Incompatible cache at %s, not loading.", path.c_str());
+      socketManager.close(this->fd);
+      this->fd = -1;
+      continue;
+    }
+    Debug("refcountcache", "loading %s", path.c_str());
+    return true;
+  }
+  return false;
+}
+
+template <class C>
+void
+RefCountCacheLoader<C>::done()
+{
+  if (this->fd >= 0) {
+    socketManager.close(this->fd);
+  }
+  Note("loaded %d items from %s", this->total_items, this->paths.front().c_str());
+  this->journal->loaded();
+  delete this;
+}
@@ -27,6 +27,7 @@
 #include "tscore/I_Layout.h"
 #include <diags.i>
 #include <set>
+#include <vector>
 
 // TODO: add tests with expiry_time
 
@@ -203,6 +204,67 @@ testclear()
   return ret;
 }
 
+// Records the changes it is told of
+class ExampleListener : public RefCountCacheListener
+{
+public:
+  std::vector<uint64_t> puts;
+  std::vector<uint64_t> erases;
+  int clears = 0;
+
+  void
+  put(const RefCountCacheHashEntry &entry) override
+  {
+    puts.push_back(entry.meta.key);
+  }
+  void
+  erase(uint64_t key) override
+  {
+    erases.push_back(key);
+  }
+  void
+  clear() override
+  {
+    clears++;
+  }
+};
+
+int
+testListener()
+{
+  int ret = 0;
+
+  RefCountCache<ExampleStruct> *cache = new RefCountCache<ExampleStruct>(4);
+  ExampleListener listener;
+  cache->set_listener(&listener);
+
+  // A put is a single change, even if it replaces an item
+  cache->put(1, ExampleStruct::alloc());
+  cache->put(1, ExampleStruct::alloc());
+  ret |= listener.puts != std::vector<uint64_t>{1, 1};
+  ret |= !listener.erases.empty();
+
+  // Only the keys that are there are erased
+  cache->erase(1);
+  cache->erase(2);
+  ret |= listener.erases != std::vector<uint64_t>{1};
+
+  // What is restored from disk was not a change
+  cache->restore(3, ExampleStruct::alloc());
+  ret |= cache->get(3).get() == nullptr;
+  cache->restore(3, nullptr);
+  ret |= cache->get(3).get() != nullptr;
+  ret |= listener.puts.size() != 2 || listener.erases.size() != 1;
+
+  cache->put(4, ExampleStruct::alloc());
+  cache->clear();
+  ret |= listener.clears != 1;
+
+  delete cache;
+
+  return ret;
+}
+
 int
 test()
 {
@@ -221,6 +283,10 @@ test()
   ret |= testRefcounting();
   printf("refcount ret %d\n", ret);
 
+  printf("Testing listener\n");
+  ret |= testListener();
+  printf("listener ret %d\n", ret);
+
   // Initialize our cache
   int cachePartitions                 = 4;
   RefCountCache<ExampleStruct> *cache = new RefCountCache<ExampleStruct>(cachePartitions);
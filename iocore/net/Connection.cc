@@ -213,6 +213,12 @@ Server::setup_fd_for_listen(bool non_blocking, const NetProcessor::AcceptOptions
     goto Lerror;
   }
 
+#ifdef SO_REUSEPORT
+  if (opt.f_reuseport && (res = safe_setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, SOCKOPT_ON, sizeof(int))) < 0) {
+    goto Lerror;
+  }
+#endif
+
   if ((opt.sockopt_flags & NetVCOptions::SOCK_OPT_NO_DELAY) &&
       (res = safe_setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, SOCKOPT_ON, sizeof(int))) < 0) {
     goto Lerror;
@@ -246,6 +252,10 @@ Server::setup_fd_for_listen(bool non_blocking, const NetProcessor::AcceptOptions
     Debug("proxyprotocol", "Proxy Protocol enabled.");
   }
 
+  if (opt.f_deny_filter) {
+    attach_deny_filter(fd);
+  }
+
 #if defined(TCP_MAXSEG)
   if (NetProcessor::accept_mss > 0) {
     if ((res = safe_setsockopt(fd, IPPROTO_TCP, TCP_MAXSEG, (char *)&NetProcessor::accept_mss, sizeof(int))) < 0) {
@@ -43,6 +43,8 @@
 #include "tscore/I_Version.h"
 #include "I_EventSystem.h"
 #include <netinet/in.h>
+#include <utility>
+#include <vector>
 
 #ifndef UIO_MAXIOV
 #define NET_MAX_IOV 16 // UIO_MAXIOV shall be at least 16 1003.1g (5.4.1.1)
@@ -60,6 +62,21 @@ extern int net_event_period;
 extern int net_accept_period;
 extern int net_retry_delay;
 extern int net_throttle_delay;
+extern int net_io_uring_poll;
+extern int net_zerocopy_min_write;
+extern int net_busy_poll_threads;
+extern int net_busy_poll_idle_us;
+extern int net_busy_poll_sock_us;
+extern int net_overload_lag_high;
+extern int net_overload_lag_low;
+extern int net_rebalance_lag_diff;
+extern int net_rebalance_max_sessions;
+
+/// Set while the net threads are overloaded, new connections should be turned away.
+extern bool net_overloaded;
+
+/// Start checking the net threads for overload once a second.
+void start_overload_monitor();
 
 extern std::string_view net_ccp_in;
 extern std::string_view net_ccp_out;
@@ -79,6 +96,7 @@ extern std::string_view net_ccp_out;
 #define NET_EVENT_DATAGRAM_ERROR (NET_EVENT_EVENTS_START + 12)
 #define NET_EVENT_ACCEPT_INTERNAL (NET_EVENT_EVENTS_START + 22)
 #define NET_EVENT_CONNECT_INTERNAL (NET_EVENT_EVENTS_START + 23)
+#define NET_EVENT_MIGRATE (NET_EVENT_EVENTS_START + 24)
 
 #define MAIN_ACCEPT_PORT -1
 
@@ -94,3 +112,9 @@ extern std::string_view net_ccp_out;
 #include "I_SessionAccept.h"
 
 void ink_net_init(ts::ModuleVersion version);
+/// Register the connection stats of each of the @a n_threads net threads, once they are started.
+void ink_net_register_thread_stats(int n_threads);
+/// Spawn the net thread groups of proxy.config.net.thread_groups, after the ET_NET threads.
+void ink_net_spawn_thread_groups(size_t stacksize);
+/// Drop the IPv4 sources in @a ranges, inclusive and in host order, on the listen sockets with AcceptOptions::f_deny_filter.
+void ink_net_set_deny_filter(std::vector<std::pair<uint32_t, uint32_t>> const &ranges);
@@ -106,6 +106,12 @@ public:
     /// Proxy Protocol enabled
     bool f_proxy_protocol;
 
+    /// Set @c SO_REUSEPORT on the listen socket so several sockets can share the port.
+    bool f_reuseport;
+
+    /// Drop the sources of ink_net_set_deny_filter() in the kernel, before they are accepted.
+    bool f_deny_filter;
+
     /// Default constructor.
     /// Instance is constructed with default values.
     AcceptOptions() { this->reset(); }
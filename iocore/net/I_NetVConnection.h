@@ -204,6 +204,10 @@ struct NetVCOptions {
    * Directory containing CA certs for verifying origin's cert
    */
   const char *ssl_client_ca_cert_path = nullptr;
+  /** Protocols to offer by ALPN on an outbound TLS connection, in the wire format (each name
+   *  prefixed by its length). The storage must outlive the connection.
+   */
+  std::string_view alpn_protos;
 
   /// Reset all values to defaults.
 
@@ -638,6 +642,17 @@ public:
   /** Set the TCP congestion control algorithm */
   virtual int set_tcp_congestion_control(int side) = 0;
 
+  /** Set the TCP policy of this connection, such as for the sessions of a video service.
+
+      @a ccp is the congestion control algorithm, @a pacing_rate the most bytes per second to send
+      and @a notsent_lowat the most bytes to keep unsent in the socket. Empty and 0 values are left
+      alone. An algorithm set here is kept when the session sets the default one.
+  */
+  virtual void
+  set_tcp_policy(std::string_view /* ccp ATS_UNUSED */, int64_t /* pacing_rate ATS_UNUSED */, int /* notsent_lowat ATS_UNUSED */)
+  {
+  }
+
   /** Set local sock addr struct. */
   virtual void set_local_addr() = 0;
 
@@ -811,11 +826,24 @@ public:
     return ats_ip_port_host_order(this->get_proxy_protocol_addr(ProxyProtocolData::DST));
   };
 
+  std::string_view
+  get_proxy_protocol_tlv(uint8_t type) const
+  {
+    return pp_info.get_tlv(type);
+  }
+
   struct ProxyProtocol {
+    static constexpr size_t TLV_MAX = 512; ///< Most bytes of v2 TLVs kept, the TLVs of a longer header are dropped.
+
     ProxyProtocolVersion proxy_protocol_version = ProxyProtocolVersion::UNDEFINED;
     uint16_t ip_family;
     IpEndpoint src_addr;
     IpEndpoint dst_addr;
+    uint16_t tlv_len = 0; ///< The TLVs of a v2 header, as they were sent.
+    char tlv[TLV_MAX];
+
+    /// The value of the v2 TLV @a type, including the sub TLVs of PP2_TYPE_SSL, empty if there is none.
+    std::string_view get_tlv(uint8_t type) const;
   };
 
   ProxyProtocol pp_info;
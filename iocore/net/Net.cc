@@ -29,6 +29,7 @@
 ************************************************************************/
 
 #include "P_Net.h"
+#include "tscpp/util/TextView.h"
 #include <utility>
 
 RecRawStatBlock *net_rsb = nullptr;
@@ -39,6 +40,25 @@ int net_event_period        = 10;
 int net_accept_period       = 10;
 int net_retry_delay         = 10;
 int net_throttle_delay      = 50; /* milliseconds */
+int net_io_uring_poll       = 0;
+int net_zerocopy_min_write  = 0; /* bytes, 0 disables MSG_ZEROCOPY */
+
+// Net threads that poll without sleeping while they are busy, and for how long after it, in microseconds.
+int net_busy_poll_threads = 0;
+int net_busy_poll_idle_us = 1000;
+int net_busy_poll_sock_us = 0; /* SO_BUSY_POLL of the sockets of those threads, 0 leaves it */
+
+// Loop lag of the net threads to start and stop shedding load at, in milliseconds, 0 disables.
+int net_overload_lag_high = 0;
+int net_overload_lag_low  = 0;
+bool net_overloaded       = false;
+
+// Loop lag the busiest net thread must be ahead of the least busy one by to hand idle sessions over, 0 disables.
+int net_rebalance_lag_diff     = 0;
+int net_rebalance_max_sessions = 64; /* sessions a thread hands over per second */
+
+// Per client address connection rate limit, nullptr if there is none.
+ts::RateLimiter *net_client_rate_limiter = nullptr;
 
 // For the in/out congestion control: ToDo: this probably would be better as ports: specifications
 std::string_view net_ccp_in;
@@ -52,10 +72,27 @@ configure_net()
 
   REC_EstablishStaticConfigInt32(net_retry_delay, "proxy.config.net.retry_delay");
   REC_EstablishStaticConfigInt32(net_throttle_delay, "proxy.config.net.throttle_delay");
+  REC_EstablishStaticConfigInt32(net_overload_lag_high, "proxy.config.net.overload.loop_lag_high");
+  REC_EstablishStaticConfigInt32(net_overload_lag_low, "proxy.config.net.overload.loop_lag_low");
+  REC_EstablishStaticConfigInt32(net_rebalance_lag_diff, "proxy.config.net.rebalance.loop_lag_diff");
+  REC_EstablishStaticConfigInt32(net_rebalance_max_sessions, "proxy.config.net.rebalance.max_sessions");
 
   // These are not reloadable
   REC_ReadConfigInteger(net_event_period, "proxy.config.net.event_period");
   REC_ReadConfigInteger(net_accept_period, "proxy.config.net.accept_period");
+  REC_ReadConfigInteger(net_io_uring_poll, "proxy.config.net.io_uring_poll");
+  REC_ReadConfigInteger(net_zerocopy_min_write, "proxy.config.net.zerocopy_min_write");
+  REC_ReadConfigInteger(net_busy_poll_threads, "proxy.config.net.busy_poll.threads");
+  REC_ReadConfigInteger(net_busy_poll_idle_us, "proxy.config.net.busy_poll.idle_timeout_us");
+  REC_ReadConfigInteger(net_busy_poll_sock_us, "proxy.config.net.busy_poll.socket_us");
+
+  int client_rate  = 0;
+  int client_burst = 0;
+  REC_ReadConfigInteger(client_rate, "proxy.config.net.per_client.connection_rate");
+  REC_ReadConfigInteger(client_burst, "proxy.config.net.per_client.connection_burst");
+  if (client_rate > 0) {
+    net_client_rate_limiter = new ts::RateLimiter(client_rate, client_burst > 0 ? client_burst : client_rate);
+  }
 
   // This is kinda fugly, but better than it was before (on every connection in and out)
   // Note that these would need to be ats_free()'d if we ever want to clean that up, but
@@ -90,6 +127,8 @@ register_net_stats()
     {"proxy.process.net.write_bytes", net_write_bytes_stat},
     {"proxy.process.net.fastopen_out.attempts", net_fastopen_attempts_stat},
     {"proxy.process.net.fastopen_out.successes", net_fastopen_successes_stat},
+    {"proxy.process.net.zerocopy.writes", net_zerocopy_writes_stat},
+    {"proxy.process.net.zerocopy.copied", net_zerocopy_copied_stat},
     {"proxy.process.socks.connections_successful", socks_connections_successful_stat},
     {"proxy.process.socks.connections_unsuccessful", socks_connections_unsuccessful_stat},
   };
@@ -135,6 +174,101 @@ register_net_stats()
                      (int)net_connections_throttled_in_stat, RecRawStatSyncSum);
   RecRegisterRawStat(net_rsb, RECT_PROCESS, "proxy.process.net.connections_throttled_out", RECD_INT, RECP_PERSISTENT,
                      (int)net_connections_throttled_out_stat, RecRawStatSyncSum);
+  RecRegisterRawStat(net_rsb, RECT_PROCESS, "proxy.process.net.connections_rate_limited_in", RECD_INT, RECP_PERSISTENT,
+                     (int)net_connections_rate_limited_in_stat, RecRawStatSyncSum);
+  RecRegisterRawStat(net_rsb, RECT_PROCESS, "proxy.process.net.overloaded", RECD_INT, RECP_NON_PERSISTENT,
+                     (int)net_overloaded_stat, RecRawStatSyncSum);
+  NET_CLEAR_DYN_STAT(net_overloaded_stat);
+  RecRegisterRawStat(net_rsb, RECT_PROCESS, "proxy.process.net.overload_loop_lag", RECD_INT, RECP_NON_PERSISTENT,
+                     (int)net_overload_loop_lag_stat, RecRawStatSyncSum);
+  NET_CLEAR_DYN_STAT(net_overload_loop_lag_stat);
+  RecRegisterRawStat(net_rsb, RECT_PROCESS, "proxy.process.net.sessions_migrated", RECD_INT, RECP_PERSISTENT,
+                     (int)net_sessions_migrated_stat, RecRawStatSyncSum);
+  RecRegisterRawStat(net_rsb, RECT_PROCESS, "proxy.process.net.listen_drops", RECD_INT, RECP_NON_PERSISTENT,
+                     (int)net_listen_drops_stat, nullptr);
+  RecRegisterRawStatSyncCb("proxy.process.net.listen_drops", net_listen_drops_sync, net_rsb, (int)net_listen_drops_stat);
+}
+
+/// Connection stats per net thread, each thread has these in order.
+enum { NET_THREAD_STAT_CONNECTIONS, NET_THREAD_STAT_ACTIVE, N_NET_THREAD_STATS };
+static char const *const NET_THREAD_STAT_NAME[N_NET_THREAD_STATS] = {"connections", "active_connections"};
+
+static int net_thread_stat_threads = 0;
+
+/// Publish the size of the queues of the NetHandler of each thread.
+static int
+net_thread_stat_sync(const char *, RecDataT, RecData *, RecRawStatBlock *rsb, int)
+{
+  int idx = 0;
+
+  ink_mutex_acquire(&(rsb->mutex));
+  for (EThread *t : eventProcessor.active_group_threads(ET_NET)) {
+    if (idx >= net_thread_stat_threads) {
+      break;
+    }
+    // Read without the lock of the handler, a stale value is good enough here.
+    NetHandler *nh = get_NetHandler(t);
+    int64_t v[N_NET_THREAD_STATS];
+    v[NET_THREAD_STAT_CONNECTIONS] = nh->active_queue_size + nh->keep_alive_queue_size;
+    v[NET_THREAD_STAT_ACTIVE]      = nh->active_queue_size;
+    for (int s = 0; s < N_NET_THREAD_STATS; ++s) {
+      int id                 = idx * N_NET_THREAD_STATS + s;
+      rsb->global[id]->sum   = v[s];
+      rsb->global[id]->count = 1;
+      RecRawStatUpdateSum(rsb, id);
+    }
+    ++idx;
+  }
+  ink_mutex_release(&(rsb->mutex));
+  return REC_ERR_OKAY;
+}
+
+void
+ink_net_register_thread_stats(int n_threads)
+{
+  char name[256];
+
+  net_thread_stat_threads = n_threads;
+  RecRawStatBlock *rsb    = RecAllocateRawStatBlock(n_threads * N_NET_THREAD_STATS);
+  for (int i = 0; i < n_threads; ++i) {
+    for (int s = 0; s < N_NET_THREAD_STATS; ++s) {
+      snprintf(name, sizeof(name), "proxy.process.net.thread.%d.%s", i, NET_THREAD_STAT_NAME[s]);
+      RecRegisterRawStat(rsb, RECT_PROCESS, name, RECD_INT, RECP_NON_PERSISTENT, i * N_NET_THREAD_STATS + s, nullptr);
+    }
+  }
+  // One callback does all of them, any of the names will do.
+  RecRegisterRawStatSyncCb(name, net_thread_stat_sync, rsb, 0);
+}
+
+void
+ink_net_spawn_thread_groups(size_t stacksize)
+{
+  ats_scoped_str groups;
+  REC_ReadConfigStringAlloc(groups, "proxy.config.net.thread_groups");
+  if (!groups) {
+    return;
+  }
+
+  // "name:threads" separated by commas or spaces. The threads are net threads of their own, the ports that name the
+  // group accept on them and their sessions, origin connections included, stay on them.
+  auto separator = [](char c) { return c == ',' || ParseRules::is_space(c); };
+  ts::TextView text{groups.get(), strlen(groups.get())};
+  while (text.ltrim_if(separator)) {
+    ts::TextView item  = text.take_prefix_if(separator);
+    ts::TextView name  = item.take_prefix_at(':');
+    ts::TextView count = item;
+    int n              = ts::svtoi(count);
+    if (name.empty() || n <= 0 || eventProcessor.find_event_type(name) >= 0) {
+      Warning("invalid net thread group '%.*s:%.*s' in proxy.config.net.thread_groups", static_cast<int>(name.size()),
+              name.data(), static_cast<int>(count.size()), count.data());
+      continue;
+    }
+    std::string group_name{name};
+    EventType etype                        = eventProcessor.register_event_type(group_name.c_str());
+    NetHandler::active_thread_types[etype] = true;
+    eventProcessor.spawn_event_threads(etype, n, stacksize, ET_NET);
+    Note("net thread group %s has %d threads", group_name.c_str(), n);
+  }
 }
 
 void
@@ -22,9 +22,18 @@
 #include "P_OCSPStapling.h"
 #if TS_USE_TLS_OCSP
 
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <memory>
+#include <string>
+#include <vector>
+
 #include <openssl/bio.h>
 #include <openssl/ssl.h>
 #include <openssl/ocsp.h>
+#include "tscore/ink_rand.h"
 #include "P_Net.h"
 #include "P_SSLConfig.h"
 #include "P_SSLUtils.h"
@@ -35,6 +44,9 @@
 // so 10K should be more than enough.
 #define MAX_STAPLING_DER 10240
 
+// How long ocsp_update() waits for the sockets of the requests in flight before it checks the timeouts again.
+static constexpr int OCSP_POLL_MSEC = 100;
+
 // Cached info stored in SSL_CTX ex_info
 struct certinfo {
   unsigned char idx[20]; // Index in session cache SHA1 hash of certificate
@@ -47,6 +59,7 @@ struct certinfo {
   bool is_prefetched;
   bool is_expire;
   time_t expire_time;
+  time_t refresh_time; // When ocsp_update() fetches a new response, a little before expire_time
 };
 
 /*
@@ -143,8 +156,57 @@ end:
   return issuer;
 }
 
+// The file a response is saved to for the next start, empty if the responses are not saved.
+static std::string
+stapling_cache_file(const certinfo *cinf)
+{
+  SSLConfig::scoped_config params;
+  if (!params || !params->ssl_ocsp_cache_path_only) {
+    return std::string();
+  }
+
+  char hex[sizeof(cinf->idx) * 2 + 1];
+  for (size_t i = 0; i < sizeof(cinf->idx); ++i) {
+    snprintf(hex + 2 * i, 3, "%02x", cinf->idx[i]);
+  }
+  return std::string(params->ssl_ocsp_cache_path_only) + "/ocsp-" + hex + ".der";
+}
+
+static void
+stapling_save_response(const certinfo *cinf, const unsigned char *der, unsigned int len)
+{
+  std::string path = stapling_cache_file(cinf);
+  if (path.empty()) {
+    return;
+  }
+
+  // Write a temporary file and rename it, a crash never leaves a truncated response behind.
+  std::string tmp = path + ".tmp";
+  int fd          = open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0640);
+  if (fd < 0) {
+    Debug("ssl_ocsp", "cannot save the OCSP response of %s to %s: %s", cinf->certname, tmp.c_str(), strerror(errno));
+    return;
+  }
+  bool ok = write(fd, der, len) == static_cast<ssize_t>(len);
+  ok      = close(fd) == 0 && ok;
+  if (!ok || rename(tmp.c_str(), path.c_str()) != 0) {
+    Debug("ssl_ocsp", "cannot save the OCSP response of %s to %s: %s", cinf->certname, path.c_str(), strerror(errno));
+    unlink(tmp.c_str());
+  }
+}
+
+// A random part of the cache timeout, so that the certificates loaded together do not all come due together.
+static time_t
+stapling_refresh_jitter()
+{
+  static thread_local InkRand generator(Thread::get_hrtime_updated());
+  int spread = SSLConfigParams::ssl_ocsp_cache_timeout / 4;
+
+  return spread > 0 ? generator.random() % spread : 0;
+}
+
 static bool
-stapling_cache_response(OCSP_RESPONSE *rsp, certinfo *cinf)
+stapling_cache_response(OCSP_RESPONSE *rsp, certinfo *cinf, time_t fetched, bool save)
 {
   unsigned char resp_der[MAX_STAPLING_DER];
   unsigned char *p;
@@ -165,15 +227,50 @@ stapling_cache_response(OCSP_RESPONSE *rsp, certinfo *cinf)
 
   ink_mutex_acquire(&cinf->stapling_mutex);
   memcpy(cinf->resp_der, resp_der, resp_derlen);
-  cinf->resp_derlen = resp_derlen;
-  cinf->is_expire   = false;
-  cinf->expire_time = time(nullptr) + SSLConfigParams::ssl_ocsp_cache_timeout;
+  cinf->resp_derlen  = resp_derlen;
+  cinf->is_expire    = false;
+  cinf->expire_time  = fetched + SSLConfigParams::ssl_ocsp_cache_timeout;
+  cinf->refresh_time = cinf->expire_time - stapling_refresh_jitter();
   ink_mutex_release(&cinf->stapling_mutex);
 
+  if (save) {
+    stapling_save_response(cinf, resp_der, resp_derlen);
+  }
+
   Debug("ssl_ocsp", "stapling_cache_response: success to cache response");
   return true;
 }
 
+// Load the response saved by an earlier run, so that the handshakes are stapled before the first refresh.
+static void
+stapling_load_response(certinfo *cinf)
+{
+  std::string path = stapling_cache_file(cinf);
+  struct stat st;
+
+  if (path.empty() || stat(path.c_str(), &st) != 0) {
+    return;
+  }
+  if (st.st_mtime + SSLConfigParams::ssl_ocsp_cache_timeout <= time(nullptr)) {
+    Debug("ssl_ocsp", "saved OCSP response of %s in %s expired", cinf->certname, path.c_str());
+    return;
+  }
+
+  BIO *bio = BIO_new_file(path.c_str(), "r");
+  if (!bio) {
+    return;
+  }
+  OCSP_RESPONSE *rsp = d2i_OCSP_RESPONSE_bio(bio, nullptr);
+  BIO_free(bio);
+
+  if (rsp) {
+    if (OCSP_response_status(rsp) == OCSP_RESPONSE_STATUS_SUCCESSFUL && stapling_cache_response(rsp, cinf, st.st_mtime, false)) {
+      Debug("ssl_ocsp", "loaded the saved OCSP response of %s from %s", cinf->certname, path.c_str());
+    }
+    OCSP_RESPONSE_free(rsp);
+  }
+}
+
 bool
 ssl_stapling_init_cert(SSL_CTX *ctx, X509 *cert, const char *certname, const char *rsp_file)
 {
@@ -212,6 +309,7 @@ ssl_stapling_init_cert(SSL_CTX *ctx, X509 *cert, const char *certname, const cha
   cinf->is_prefetched = rsp_file ? true : false;
   cinf->is_expire     = true;
   cinf->expire_time   = 0;
+  cinf->refresh_time  = 0;
 
   if (cinf->is_prefetched) {
     Debug("ssl_ocsp", "using OCSP prefetched response file %s", rsp_file);
@@ -225,7 +323,7 @@ ssl_stapling_init_cert(SSL_CTX *ctx, X509 *cert, const char *certname, const cha
       goto err;
     }
 
-    if (!stapling_cache_response(rsp, cinf)) {
+    if (!stapling_cache_response(rsp, cinf, time(nullptr), false)) {
       Error("stapling_refresh_response: can not cache response");
       goto err;
     } else {
@@ -261,6 +359,10 @@ ssl_stapling_init_cert(SSL_CTX *ctx, X509 *cert, const char *certname, const cha
     goto err;
   }
 
+  if (!cinf->is_prefetched) {
+    stapling_load_response(cinf);
+  }
+
   map->insert(std::make_pair(cert, cinf));
   SSL_CTX_set_ex_data(ctx, ssl_stapling_index, map);
 
@@ -352,137 +454,149 @@ stapling_check_response(certinfo *cinf, OCSP_RESPONSE *rsp)
   return SSL_TLSEXT_ERR_OK;
 }
 
-static OCSP_RESPONSE *
-query_responder(BIO *b, char *host, char *path, OCSP_REQUEST *req, int req_timeout)
-{
-  ink_hrtime start, end;
-  OCSP_RESPONSE *resp = nullptr;
-  OCSP_REQ_CTX *ctx;
-  int rv;
-
-  start = Thread::get_hrtime();
-  end   = ink_hrtime_add(start, ink_hrtime_from_sec(req_timeout));
-
-  ctx = OCSP_sendreq_new(b, path, nullptr, -1);
-  OCSP_REQ_CTX_add1_header(ctx, "Host", host);
-  OCSP_REQ_CTX_set1_req(ctx, req);
-
-  do {
-    rv = OCSP_sendreq_nbio(&resp, ctx);
-    ink_hrtime_sleep(HRTIME_MSECONDS(1));
-  } while ((rv == -1) && BIO_should_retry(b) && (Thread::get_hrtime() < end));
-
-  OCSP_REQ_CTX_free(ctx);
-
-  if (rv) {
-    return resp;
-  }
-
-  return nullptr;
-}
+// An OCSP request in flight. ocsp_update() runs up to proxy.config.ssl.ocsp.max_requests of these at
+// once on non blocking sockets, so that slow responders do not hold up the refresh of the other certificates.
+struct OCSPFetch {
+  explicit OCSPFetch(certinfo *c) : cinf(c) {}
+  ~OCSPFetch();
+
+  bool start();
+  int step();
+  void wait_for(std::vector<struct pollfd> &pfds) const;
+
+  certinfo *cinf      = nullptr;
+  char *host          = nullptr;
+  char *port          = nullptr;
+  char *path          = nullptr;
+  OCSP_REQUEST *req   = nullptr;
+  BIO *bio            = nullptr;
+  OCSP_REQ_CTX *ctx   = nullptr;
+  ink_hrtime deadline = 0;
+};
 
-static OCSP_RESPONSE *
-process_responder(OCSP_REQUEST *req, char *host, char *path, char *port, int req_timeout)
+OCSPFetch::~OCSPFetch()
 {
-  BIO *cbio           = nullptr;
-  OCSP_RESPONSE *resp = nullptr;
-  cbio                = BIO_new_connect(host);
-  if (!cbio) {
-    goto end;
+  if (ctx) {
+    OCSP_REQ_CTX_free(ctx);
   }
-  if (port) {
-    BIO_set_conn_port(cbio, port);
+  if (bio) {
+    BIO_free_all(bio);
   }
-
-  BIO_set_nbio(cbio, 1);
-  if (BIO_do_connect(cbio) <= 0 && !BIO_should_retry(cbio)) {
-    Debug("ssl_ocsp", "process_responder: failed to connect to OCSP response server. host=%s port=%s path=%s", host, port, path);
-    goto end;
-  }
-  resp = query_responder(cbio, host, path, req, req_timeout);
-
-end:
-  if (cbio) {
-    BIO_free_all(cbio);
+  if (req) {
+    OCSP_REQUEST_free(req);
   }
-  return resp;
+  OPENSSL_free(host);
+  OPENSSL_free(path);
+  OPENSSL_free(port);
 }
 
-static bool
-stapling_refresh_response(certinfo *cinf, OCSP_RESPONSE **prsp)
+// Connect to the responder and queue the request, @c false if the request can not be made.
+bool
+OCSPFetch::start()
 {
-  bool rv           = true;
-  OCSP_REQUEST *req = nullptr;
-  OCSP_CERTID *id   = nullptr;
-  char *host = nullptr, *port = nullptr, *path = nullptr;
-  int ssl_flag    = 0;
-  int req_timeout = -1;
-
-  Debug("ssl_ocsp", "stapling_refresh_response: querying responder");
-  *prsp = nullptr;
+  int ssl_flag = 0;
 
+  Debug("ssl_ocsp", "querying responder for %s, url=%s", cinf->certname, cinf->uri);
   if (!OCSP_parse_url(cinf->uri, &host, &port, &path, &ssl_flag)) {
-    goto err;
+    return false;
   }
 
   req = OCSP_REQUEST_new();
   if (!req) {
-    goto err;
+    return false;
   }
-  id = OCSP_CERTID_dup(cinf->cid);
-  if (!id) {
-    goto err;
+  OCSP_CERTID *id = OCSP_CERTID_dup(cinf->cid);
+  if (!id || !OCSP_request_add0_id(req, id)) {
+    OCSP_CERTID_free(id);
+    return false;
   }
-  if (!OCSP_request_add0_id(req, id)) {
-    goto err;
+
+  bio = BIO_new_connect(host);
+  if (!bio) {
+    return false;
+  }
+  if (port) {
+    BIO_set_conn_port(bio, port);
+  }
+  BIO_set_nbio(bio, 1);
+  if (BIO_do_connect(bio) <= 0 && !BIO_should_retry(bio)) {
+    Debug("ssl_ocsp", "failed to connect to OCSP response server. host=%s port=%s path=%s", host, port, path);
+    return false;
   }
 
-  req_timeout = SSLConfigParams::ssl_ocsp_request_timeout;
-  *prsp       = process_responder(req, host, path, port, req_timeout);
+  ctx = OCSP_sendreq_new(bio, path, nullptr, -1);
+  if (!ctx) {
+    return false;
+  }
+  OCSP_REQ_CTX_add1_header(ctx, "Host", host);
+  OCSP_REQ_CTX_set1_req(ctx, req);
+  deadline = ink_hrtime_add(Thread::get_hrtime_updated(), ink_hrtime_from_sec(SSLConfigParams::ssl_ocsp_request_timeout));
+  return true;
+}
 
-  if (*prsp == nullptr) {
-    goto done;
+// Move the request along, return -1 while it is in flight, 1 if a response was cached and 0 if it failed.
+int
+OCSPFetch::step()
+{
+  OCSP_RESPONSE *rsp = nullptr;
+  int rv             = OCSP_sendreq_nbio(&rsp, ctx);
+
+  if (rv == -1 && BIO_should_retry(bio)) {
+    return Thread::get_hrtime_updated() < deadline ? -1 : 0;
+  }
+  if (rv != 1 || rsp == nullptr) {
+    return 0;
   }
 
-  if (OCSP_response_status(*prsp) == OCSP_RESPONSE_STATUS_SUCCESSFUL) {
-    Debug("ssl_ocsp", "stapling_refresh_response: query response received");
-    stapling_check_response(cinf, *prsp);
+  bool successful = OCSP_response_status(rsp) == OCSP_RESPONSE_STATUS_SUCCESSFUL;
+  if (successful) {
+    Debug("ssl_ocsp", "query response received for %s", cinf->certname);
+    stapling_check_response(cinf, rsp);
   } else {
     // TODO: We should log the actual openssl error
-    Error("stapling_refresh_response: responder error");
+    Error("ocsp_update: responder error for %s", cinf->certname);
   }
 
-  if (!stapling_cache_response(*prsp, cinf)) {
-    Error("stapling_refresh_response: can not cache response");
-  } else {
-    Debug("ssl_ocsp", "stapling_refresh_response: successful refresh OCSP response");
+  // Error responses are cached too so the responder is not asked again before the cache timeout,
+  // but only good responses are saved for the next start.
+  bool cached = stapling_cache_response(rsp, cinf, time(nullptr), successful);
+  if (!cached) {
+    Error("ocsp_update: can not cache response");
   }
-  goto done;
-
-err:
-  rv = false;
-  Error("stapling_refresh_response: failed to refresh OCSP response");
+  OCSP_RESPONSE_free(rsp);
+  return cached ? 1 : 0;
+}
 
-done:
-  if (req) {
-    OCSP_REQUEST_free(req);
+// Add the socket of the request to @a pfds, for the direction it waits on.
+void
+OCSPFetch::wait_for(std::vector<struct pollfd> &pfds) const
+{
+  int fd = -1;
+  if (BIO_get_fd(bio, &fd) >= 0 && fd >= 0) {
+    pfds.push_back({fd, static_cast<short>(BIO_should_read(bio) ? POLLIN : POLLOUT), 0});
   }
-  if (*prsp) {
-    OCSP_RESPONSE_free(*prsp);
+}
+
+static void
+ocsp_fetch_done(const certinfo *cinf, bool refreshed)
+{
+  if (refreshed) {
+    Debug("ssl_ocsp", "Successfully refreshed OCSP for %s certificate. url=%s", cinf->certname, cinf->uri);
+    SSL_INCREMENT_DYN_STAT(ssl_ocsp_refreshed_cert_stat);
+  } else {
+    Error("Failed to refresh OCSP for %s certificate. url=%s", cinf->certname, cinf->uri);
+    SSL_INCREMENT_DYN_STAT(ssl_ocsp_refresh_cert_failure_stat);
   }
-  OPENSSL_free(host);
-  OPENSSL_free(path);
-  OPENSSL_free(port);
-  return rv;
 }
 
 void
 ocsp_update()
 {
   shared_SSL_CTX ctx;
-  OCSP_RESPONSE *resp = nullptr;
-  time_t current_time;
+  time_t current_time = time(nullptr);
+  std::vector<certinfo *> due;
 
+  // The lookup keeps the contexts, and with them the certinfos, alive until all the requests are done.
   SSLCertificateConfig::scoped_config certLookup;
   const unsigned ctxCount = certLookup->count();
 
@@ -491,31 +605,56 @@ ocsp_update()
     if (cc) {
       ctx = cc->getCtx();
       if (ctx) {
-        certinfo *cinf    = nullptr;
         certinfo_map *map = stapling_get_cert_info(ctx.get());
         if (map) {
           // Walk over all certs associated with this CTX
-          for (certinfo_map::iterator iter = map->begin(); iter != map->end(); ++iter) {
-            cinf = iter->second;
+          for (auto &&iter : *map) {
+            certinfo *cinf = iter.second;
             ink_mutex_acquire(&cinf->stapling_mutex);
-            current_time = time(nullptr);
-            if (cinf->resp_derlen == 0 || cinf->is_expire || cinf->expire_time < current_time) {
-              ink_mutex_release(&cinf->stapling_mutex);
-              if (stapling_refresh_response(cinf, &resp)) {
-                Debug("Successfully refreshed OCSP for %s certificate. url=%s", cinf->certname, cinf->uri);
-                SSL_INCREMENT_DYN_STAT(ssl_ocsp_refreshed_cert_stat);
-              } else {
-                Error("Failed to refresh OCSP for %s certificate. url=%s", cinf->certname, cinf->uri);
-                SSL_INCREMENT_DYN_STAT(ssl_ocsp_refresh_cert_failure_stat);
-              }
-            } else {
-              ink_mutex_release(&cinf->stapling_mutex);
+            if (cinf->resp_derlen == 0 || cinf->is_expire || cinf->refresh_time <= current_time) {
+              due.push_back(cinf);
             }
+            ink_mutex_release(&cinf->stapling_mutex);
           }
         }
       }
     }
   }
+  Debug("ssl_ocsp", "refreshing the OCSP responses of %zu certificates", due.size());
+
+  size_t max_requests = std::max(SSLConfigParams::ssl_ocsp_max_requests, 1);
+  size_t next         = 0;
+  std::vector<std::unique_ptr<OCSPFetch>> active;
+  std::vector<struct pollfd> pfds;
+
+  while (next < due.size() || !active.empty()) {
+    while (next < due.size() && active.size() < max_requests) {
+      auto fetch = std::make_unique<OCSPFetch>(due[next++]);
+      if (fetch->start()) {
+        active.push_back(std::move(fetch));
+      } else {
+        ocsp_fetch_done(fetch->cinf, false);
+      }
+    }
+
+    for (auto spot = active.begin(); spot != active.end();) {
+      int rv = (*spot)->step();
+      if (rv < 0) {
+        ++spot;
+      } else {
+        ocsp_fetch_done((*spot)->cinf, rv > 0);
+        spot = active.erase(spot);
+      }
+    }
+
+    if (!active.empty()) {
+      pfds.clear();
+      for (auto const &fetch : active) {
+        fetch->wait_for(pfds);
+      }
+      poll(pfds.data(), pfds.size(), OCSP_POLL_MSEC);
+    }
+  }
 }
 
 // RFC 6066 Section-8: Certificate Status Request
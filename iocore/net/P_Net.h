@@ -54,9 +54,16 @@ enum Net_Stats {
   default_inactivity_timeout_stat,
   net_fastopen_attempts_stat,
   net_fastopen_successes_stat,
+  net_zerocopy_writes_stat,
+  net_zerocopy_copied_stat,
   net_tcp_accept_stat,
   net_connections_throttled_in_stat,
   net_connections_throttled_out_stat,
+  net_connections_rate_limited_in_stat,
+  net_overloaded_stat,
+  net_overload_loop_lag_stat,
+  net_sessions_migrated_stat,
+  net_listen_drops_stat,
   Net_Stat_Count
 };
 
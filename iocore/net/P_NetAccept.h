@@ -98,6 +98,7 @@ struct NetAccept : public Continuation {
   virtual void init_accept(EThread *t = nullptr);
   void init_accept_loop();
   void init_accept_per_thread();
+  bool listen_reuseport();
   virtual void stop_accept();
   virtual NetAccept *clone() const;
 
@@ -116,3 +117,10 @@ struct NetAccept : public Continuation {
 
 extern Ptr<ProxyMutex> naVecMutex;
 extern std::vector<NetAccept *> naVec;
+
+/// Attach the deny filter of ink_net_set_deny_filter() to the listen socket @a fd, and keep it up to date.
+void attach_deny_filter(int fd);
+/// Stop updating the deny filter of @a fd, before it is closed.
+void detach_deny_filter(int fd);
+/// Sync the packets the listen sockets with the deny filter dropped.
+int net_listen_drops_sync(const char *, RecDataT, RecData *, RecRawStatBlock *rsb, int id);
@@ -76,6 +76,23 @@ public:
   }
 };
 
+class DisableEarlyData : public ActionItem
+{
+public:
+  DisableEarlyData() {}
+  ~DisableEarlyData() override {}
+
+  int
+  SNIAction(Continuation *cont) const override
+  {
+    auto ssl_vc = dynamic_cast<SSLNetVConnection *>(cont);
+    if (ssl_vc) {
+      ssl_vc->early_data_disabled = true;
+    }
+    return SSL_TLSEXT_ERR_OK;
+  }
+};
+
 class TunnelDestination : public ActionItem
 {
 public:
@@ -96,6 +113,28 @@ public:
   bool tunnel_decrypt = false;
 };
 
+class TcpPolicy : public ActionItem
+{
+public:
+  TcpPolicy(const std::string &ccp, int64_t rate, int lowat) : congestion_control(ccp), pacing_rate(rate), notsent_lowat(lowat) {}
+  ~TcpPolicy() override {}
+
+  int
+  SNIAction(Continuation *cont) const override
+  {
+    auto ssl_vc = dynamic_cast<SSLNetVConnection *>(cont);
+    if (ssl_vc) {
+      ssl_vc->set_tcp_policy(congestion_control, pacing_rate, notsent_lowat);
+    }
+    return SSL_TLSEXT_ERR_OK;
+  }
+
+private:
+  std::string congestion_control;
+  int64_t pacing_rate = 0;
+  int notsent_lowat   = 0;
+};
+
 class VerifyClient : public ActionItem
 {
   uint8_t mode;
@@ -58,6 +58,7 @@ struct SSLMultiCertConfigParams {
   ats_scoped_str dialog;        ///< Private key dialog
   ats_scoped_str servername;    ///< Destination server
   SSLCertContextOption opt;     ///< SSLCertContext special handling option
+  bool lazy = false;            ///< The context is built on first use, see SSLLazyCertCache
 };
 
 struct ssl_ticket_key_t {
@@ -158,3 +159,4 @@ void ticket_block_free(void *ptr);
 ssl_ticket_key_block *ticket_block_alloc(unsigned count);
 ssl_ticket_key_block *ticket_block_create(char *ticket_key_data, int ticket_key_len);
 ssl_ticket_key_block *ssl_create_ticket_keyblock(const char *ticket_key_path);
+ssl_ticket_key_block *ssl_derive_ticket_keyblock(const char *secret, int secret_len, int64_t period, unsigned previous);
@@ -101,14 +101,19 @@ struct SSLConfigParams : public ConfigInfo {
   char *client_groups_list;
 
   static int ssl_maxrecord;
+  static bool ssl_ktls_enabled;
+  static int server_max_early_data;
+  static int server_early_data_replay_window;
   static bool ssl_allow_client_renegotiation;
 
   static bool ssl_ocsp_enabled;
   static int ssl_ocsp_cache_timeout;
   static int ssl_ocsp_request_timeout;
   static int ssl_ocsp_update_period;
+  static int ssl_ocsp_max_requests;
   static int ssl_handshake_timeout_in;
   char *ssl_ocsp_response_path_only;
+  char *ssl_ocsp_cache_path_only; ///< Where the OCSP responses are saved for the next start, nullptr to not save them.
 
   static size_t session_cache_number_buckets;
   static size_t session_cache_max_bucket_size;
@@ -176,6 +181,7 @@ private:
 struct SSLTicketParams : public ConfigInfo {
   ssl_ticket_key_block *default_global_keyblock = nullptr;
   time_t load_time                              = 0;
+  int64_t rotation_period                       = -1; ///< The period of the derived keys, -1 if they are the keys of the file.
   char *ticket_key_filename;
   bool LoadTicket(bool &nochange);
   void LoadTicketData(char *ticket_data, int ticket_data_len);
@@ -209,4 +215,4 @@ private:
   static int configid;
 };
 
-extern SSLSessionCache *session_cache;
+extern SSLSessionCacheBackend *session_cache;
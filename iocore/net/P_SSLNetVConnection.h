@@ -66,6 +66,8 @@
 #define SSL_MAX_TLS_RECORD_SIZE 16383 // 2^14 - 1
 #define SSL_DEF_TLS_RECORD_BYTE_THRESHOLD 1000000
 #define SSL_DEF_TLS_RECORD_MSEC_THRESHOLD 1000
+// With TCP_INFO the small records fill one segment of the actual MSS, less the TLS record overhead.
+#define SSL_TLS_RECORD_OVERHEAD 60
 
 class SSLNextProtocolSet;
 class SSLNextProtocolAccept;
@@ -304,6 +306,18 @@ public:
     return ssl ? SSL_get_version(ssl) : nullptr;
   }
 
+  /// The protocol selected by ALPN, empty if there is none (yet).
+  std::string_view
+  get_alpn_selected() const
+  {
+    const unsigned char *proto = nullptr;
+    unsigned len               = 0;
+    if (ssl) {
+      SSL_get0_alpn_selected(ssl, &proto, &len);
+    }
+    return {reinterpret_cast<const char *>(proto), len};
+  }
+
   const char *
   getSSLCipherSuite() const
   {
@@ -392,6 +406,9 @@ public:
   /// Set by asynchronous hooks to request a specific operation.
   SslVConnOp hookOpRequested = SSL_HOOK_OP_DEFAULT;
 
+  /// The handshake is paused for a context from the @c lazyCertCache.
+  bool lazy_cert_waiting = false;
+
   // noncopyable
   SSLNetVConnection(const SSLNetVConnection &) = delete;
   SSLNetVConnection &operator=(const SSLNetVConnection &) = delete;
@@ -399,6 +416,19 @@ public:
   bool protocol_mask_set = false;
   unsigned long protocol_mask;
 
+  /// Set by the SNI actions to reject the TLS 1.3 early data of this connection.
+  bool early_data_disabled = false;
+
+  /// The bytes of TLS 1.3 early data received in the handshake.
+  int64_t
+  get_early_data_len() const
+  {
+    return early_data_len;
+  }
+
+  /// Move at most @a len bytes of the early data kept from the handshake to @a buf.
+  int64_t take_early_data(MIOBuffer *buf, int64_t len);
+
   // Only applies during the VERIFY certificate hooks (client and server side)
   // Means to give the plugin access to the data structure passed in during the underlying
   // openssl callback so the plugin can make more detailed decisions about the
@@ -417,7 +447,9 @@ public:
 private:
   std::string_view map_tls_protocol_to_tag(const char *proto_string) const;
   bool update_rbio(bool move_to_socket);
+  int read_early_data();
   void increment_ssl_version_metric(int version) const;
+  uint32_t tls_record_size_from_tcp_info() const;
 
   enum SSLHandshakeStatus sslHandshakeStatus = SSL_HANDSHAKE_ONGOING;
   bool sslClientRenegotiationAbort           = false;
@@ -426,6 +458,10 @@ private:
   IOBufferReader *handShakeHolder            = nullptr;
   IOBufferReader *handShakeReader            = nullptr;
   int handShakeBioStored                     = 0;
+  MIOBuffer *early_data_buf                  = nullptr;
+  IOBufferReader *early_data_reader          = nullptr;
+  int64_t early_data_len                     = 0;
+  bool early_data_finished                   = false;
 
   bool transparentPassThrough = false;
 
@@ -454,6 +490,7 @@ private:
   SessionAccept *sessionAcceptPtr  = nullptr;
   bool sslTrace                    = false;
   int64_t redoWriteSize            = 0;
+  bool ktls_send                   = false; // the kernel encrypts outgoing records, see proxy.config.ssl.ktls.enabled
   char *tunnel_host                = nullptr;
   in_port_t tunnel_port            = 0;
   bool tunnel_decrypt              = false;
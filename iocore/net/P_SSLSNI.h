@@ -38,6 +38,8 @@
 #include <strings.h>
 #include "YamlSNIConfig.h"
 
+#include <deque>
+#include <string_view>
 #include <unordered_map>
 
 // Properties for the next hop server
@@ -71,7 +73,8 @@ public:
       name.replace(pos, 1, ".{0,}");
     }
     Debug("ssl_sni", "Regexed fqdn=%s", name.c_str());
-    setRegexName(name);
+    // The whole servername has to match.
+    setRegexName(name + '$');
   }
 
   void
@@ -104,10 +107,53 @@ typedef std::vector<actionElement> SNIList;
 // typedef HashMap<cchar *, StringHashFns, NextHopProperty *> NextHopPropertyTable;
 typedef std::vector<NextHopItem> NextHopPropertyList;
 
+/** Finds the first entry of sni.yaml whose fqdn matches a servername.
+
+    An exact fqdn is hashed by name and "*.domain" by the domain, a servername is then resolved with
+    a hash lookup for itself and one for each of its parent domains, like the names of SSLCertLookup.
+    Only an fqdn with a '*' elsewhere is left to its regex, tried in the order of the file.
+ */
+class SNINameIndex
+{
+public:
+  /// Index @a fqdn as the entry @a idx, entries must be added in order.
+  /// @return @c false if @a fqdn needs its regex.
+  bool insert(const std::string &fqdn, int idx);
+
+  /// The first entry of @a list that matches @a servername, or -1.
+  template <typename List> int find(const List &list, std::string_view servername) const;
+
+private:
+  int find_name(std::string_view servername) const;
+
+  std::deque<std::string> names; ///< Storage for the keys of the maps.
+  std::unordered_map<std::string_view, int> hostnames;
+  std::unordered_map<std::string_view, int> wilddomains;
+  /// The entries matched by their regex.
+  std::vector<int> regexed;
+};
+
+template <typename List>
+int
+SNINameIndex::find(const List &list, std::string_view servername) const
+{
+  int found = this->find_name(servername);
+  for (int idx : regexed) {
+    if (found >= 0 && idx > found) {
+      break;
+    }
+    if (pcre_exec(list[idx].match, nullptr, servername.data(), servername.length(), 0, 0, nullptr, 0) >= 0) {
+      return idx;
+    }
+  }
+  return found;
+}
+
 struct SNIConfigParams : public ConfigInfo {
   char *sni_filename = nullptr;
   SNIList sni_action_list;
   NextHopPropertyList next_hop_list;
+  SNINameIndex sni_index; ///< Both lists have an entry for each item of sni.yaml.
   YamlSNIConfig Y_sni;
   const NextHopProperty *getPropertyConfig(const std::string &servername) const;
   SNIConfigParams();
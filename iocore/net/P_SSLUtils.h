@@ -34,6 +34,9 @@
 #include "records/I_RecCore.h"
 #include "P_SSLCertLookup.h"
 
+#include <string>
+#include <unordered_map>
+
 struct SSLConfigParams;
 class SSLNetVConnection;
 
@@ -46,7 +49,7 @@ class SSLMultiCertConfigLoader
 {
 public:
   SSLMultiCertConfigLoader(const SSLConfigParams *p) : _params(p) {}
-  virtual ~SSLMultiCertConfigLoader(){};
+  virtual ~SSLMultiCertConfigLoader();
 
   bool load(SSLCertLookup *lookup);
 
@@ -58,6 +61,9 @@ public:
   static bool set_session_id_context(SSL_CTX *ctx, const SSLConfigParams *params,
                                      const SSLMultiCertConfigParams *sslMultCertSettings);
 
+  /// Build the context of an entry indexed with @c lazy set.
+  shared_SSL_CTX build_lazy_ssl_ctx(const SSLMultiCertConfigParams *sslMultCertSettings);
+
   static bool index_certificate(SSLCertLookup *lookup, SSLCertContext const &cc, X509 *cert, const char *certname);
   static int check_server_cert_now(X509 *cert, const char *certname);
   static void clear_pw_references(SSL_CTX *ssl_ctx);
@@ -68,6 +74,15 @@ protected:
 private:
   virtual SSL_CTX *_store_ssl_ctx(SSLCertLookup *lookup, const shared_SSLMultiCertConfigParams ssl_multi_cert_params);
   virtual void _set_handshake_callbacks(SSL_CTX *ctx);
+  bool _index_lazy_certs(SSLCertLookup *lookup, const shared_SSLMultiCertConfigParams &ssl_multi_cert_params);
+
+  /// A context built for a line, reused by the other lines of the load that would build the same one.
+  struct SharedContext {
+    shared_SSL_CTX ctx;
+    shared_ssl_ticket_key_block keyblock;
+    std::vector<X509 *> cert_list; ///< Owns a reference to each.
+  };
+  std::unordered_map<std::string, SharedContext> _shared_contexts;
 };
 
 // Create a new SSL server context fully configured (cert and keys are optional).
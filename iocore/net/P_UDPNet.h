@@ -278,6 +278,19 @@ class UDPQueue
   int packets             = 0;
   int added               = 0;
 
+  // Packets of one connection, sent by one sendmmsg. With UDP GSO packets of one size to one
+  // address are a single message, segmented by the kernel.
+  static constexpr int SEND_BATCH       = 64;
+  static constexpr int GSO_MAX_SEGMENTS = 64;
+  static constexpr int GSO_MAX_BYTES    = 65507;
+  UDPPacketInternal *send_batch[SEND_BATCH];
+  int64_t send_len[SEND_BATCH];
+  int send_count    = 0;
+  bool gso_disabled = false; ///< Set once the kernel has refused a GSO send.
+
+  void BatchUDPPacket(UDPPacketInternal *p, int64_t pktLen);
+  void FlushBatch();
+
 public:
   // Outgoing UDP Packet Queue
   ASLL(UDPPacketInternal, alink) outQueue;
@@ -288,7 +301,8 @@ public:
   void SendUDPPacket(UDPPacketInternal *p, int32_t pktLen);
 
   // Interface exported to the outside world
-  void send(UDPPacket *p);
+  /// Queue @a p, @return @c true if the queue was empty.
+  bool send(UDPPacket *p);
 
   UDPQueue();
   ~UDPQueue();
@@ -316,6 +330,11 @@ public:
   ink_hrtime nextCheck;
   ink_hrtime lastCheck;
 
+  // Datagrams received by one recvmmsg.
+  static constexpr int RECV_BATCH    = 16;
+  static constexpr int RECV_BUF_SIZE = 65536; ///< The largest UDP payload, or a GRO coalesced read.
+  char *recv_buf                     = nullptr;
+
   int startNetEvent(int event, Event *data);
   int mainNetEvent(int event, Event *data);
 
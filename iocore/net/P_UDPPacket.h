@@ -175,7 +175,7 @@ new_UDPPacket(struct sockaddr const *to, ink_hrtime when, char *buf, int len)
 
   if (buf) {
     IOBufferBlock *body = new_IOBufferBlock();
-    body->alloc(iobuffer_size_to_index(len));
+    body->alloc(iobuffer_size_to_fit_index(len));
     memcpy(body->end(), buf, len);
     body->fill(len);
     p->append_block(body);
@@ -236,7 +236,7 @@ new_incoming_UDPPacket(struct sockaddr *from, struct sockaddr *to, char *buf, in
   ats_ip_copy(&p->to, to);
 
   IOBufferBlock *body = new_IOBufferBlock();
-  body->alloc(iobuffer_size_to_index(len));
+  body->alloc(iobuffer_size_to_fit_index(len));
   memcpy(body->end(), buf, len);
   body->fill(len);
   p->append_block(body);
@@ -23,9 +23,12 @@
 
 #pragma once
 
+#include <atomic>
 #include <bitset>
 
 #include "tscore/ink_platform.h"
+#include "tscore/TimerWheel.h"
+#include "tscore/RateLimiter.h"
 
 #define USE_EDGE_TRIGGER_EPOLL 1
 #define USE_EDGE_TRIGGER_KQUEUE 1
@@ -84,6 +87,9 @@ struct EventIO {
   EventLoop event_loop = nullptr;
   bool syscall         = true;
   int type             = 0;
+#if TS_USE_LINUX_IO_URING
+  uint64_t uring_token = 0; ///< Registration with an io_uring event loop, 0 if none.
+#endif
   union {
     Continuation *c;
     UnixNetVConnection *vc;
@@ -124,6 +130,7 @@ extern ink_hrtime last_throttle_warning;
 extern ink_hrtime last_shedding_warning;
 extern ink_hrtime emergency_throttle_time;
 extern int net_connections_throttle;
+extern ts::RateLimiter *net_client_rate_limiter;
 extern bool net_memory_throttle;
 extern int fds_throttle;
 extern int fds_limit;
@@ -236,7 +243,18 @@ public:
   QueM(UnixNetVConnection, NetState, read, ready_link) read_ready_list;
   QueM(UnixNetVConnection, NetState, write, ready_link) write_ready_list;
   Que(UnixNetVConnection, link) open_list;
-  DList(UnixNetVConnection, cop_link) cop_list;
+  /// NetVCs in open_list by the time InactivityCop has to check them next.
+  TimerWheel<UnixNetVConnection, &UnixNetVConnection::next_cop_check_at, UnixNetVConnection::Link_cop_link> cop_wheel{
+    HRTIME_SECOND, Thread::get_hrtime()};
+  /// NetVCs whose inactivity timeout was moved up or which were closed on another thread.
+  ASLL(UnixNetVConnection, cop_enable_link) cop_enable_list;
+  ink_hrtime cop_interval = HRTIME_SECOND; ///< How often InactivityCop runs.
+  /// How long the thread polls without sleeping after it last had something to do, 0 if it does not.
+  ink_hrtime busy_poll_idle  = 0;
+  ink_hrtime busy_poll_until = 0; ///< When the thread goes back to sleeping in the poll.
+  /// Set by the overload monitor while this thread is much busier than this less busy one.
+  std::atomic<EThread *> rebalance_to{nullptr};
+  std::atomic<int> rebalance_budget{0}; ///< Idle sessions still to hand over this second.
   ASLLM(UnixNetVConnection, NetState, read, enable_link) read_enable_list;
   ASLLM(UnixNetVConnection, NetState, write, enable_link) write_enable_list;
   Que(UnixNetVConnection, keep_alive_queue_link) keep_alive_queue;
@@ -328,9 +346,19 @@ public:
     @param netvc UnixNetVConnection to be managed by InactivityCop
    */
   void startCop(UnixNetVConnection *netvc);
+  /**
+    File @a netvc with InactivityCop to be checked at @a at, but not before the next time the cop runs.
+    Only be called when holding the mutex of this NetHandler.
+   */
+  void cop_schedule(UnixNetVConnection *netvc, ink_hrtime at);
+  /**
+    Make sure InactivityCop looks at @a netvc in time after its inactivity timeout was moved up or
+    it was closed. Only be called when holding the mutex of this NetHandler.
+   */
+  void cop_update(UnixNetVConnection *netvc);
   /**
     Stop to handle active timeout and inactivity on a UnixNetVConnection.
-    Remove the netvc from open_list and cop_list.
+    Remove the netvc from open_list and cop_wheel.
     Also remove the netvc from keep_alive_queue and active_queue if its context is IN.
     Only be called when holding the mutex of this NetHandler.
 
@@ -415,6 +443,19 @@ check_net_throttle(ThrottleType t)
   return false;
 }
 
+/// Check the connection rate limit of the client at @a addr, return @c false if it is over the limit.
+TS_INLINE bool
+check_net_client_rate(sockaddr const *addr)
+{
+  uint8_t const *raw = ats_ip_addr8_cast(addr);
+
+  if (net_client_rate_limiter == nullptr || raw == nullptr) {
+    return true;
+  }
+  return net_client_rate_limiter->admit(std::string_view(reinterpret_cast<char const *>(raw), ats_ip_addr_size(addr)),
+                                        Thread::get_hrtime());
+}
+
 TS_INLINE void
 check_throttle_warning(ThrottleType type)
 {
@@ -596,6 +637,12 @@ EventIO::start(EventLoop l, int afd, Continuation *c, int e)
   ev.data.ptr = this;
 #ifndef USE_EDGE_TRIGGER
   events = e;
+#endif
+#if TS_USE_LINUX_IO_URING
+  if (event_loop->uring) {
+    uring_token = event_loop->uring_add(fd, e, this);
+    return uring_token ? 0 : -1;
+  }
 #endif
   return epoll_ctl(event_loop->epoll_fd, EPOLL_CTL_ADD, fd, &ev);
 #endif
@@ -755,6 +802,14 @@ EventIO::stop()
   if (event_loop) {
     int retval = 0;
 #if TS_USE_EPOLL
+#if TS_USE_LINUX_IO_URING
+    if (event_loop->uring) {
+      event_loop->uring_remove(uring_token);
+      uring_token = 0;
+      event_loop  = nullptr;
+      return 0;
+    }
+#endif
     struct epoll_event ev;
     memset(&ev, 0, sizeof(struct epoll_event));
     ev.events = EPOLLIN | EPOLLOUT | EPOLLET;
@@ -791,6 +846,13 @@ NetHandler::startIO(UnixNetVConnection *netvc)
   if (netvc->read.triggered == 1) {
     read_ready_list.enqueue(netvc);
   }
+#ifdef SO_BUSY_POLL
+  // Let the socket spin on the device queue for its data too, the thread is spinning anyway.
+  if (busy_poll_idle && net_busy_poll_sock_us > 0 &&
+      setsockopt(netvc->con.fd, SOL_SOCKET, SO_BUSY_POLL, &net_busy_poll_sock_us, sizeof(net_busy_poll_sock_us)) < 0) {
+    Debug("iocore_net", "NetHandler::startIO : SO_BUSY_POLL failed, errno = [%d](%s)", errno, strerror(errno));
+  }
+#endif
   netvc->nh = this;
   return res;
 }
@@ -824,6 +886,32 @@ NetHandler::startCop(UnixNetVConnection *netvc)
   ink_assert(!open_list.in(netvc));
 
   open_list.enqueue(netvc);
+  cop_schedule(netvc, netvc->next_inactivity_timeout_at);
+}
+
+TS_INLINE void
+NetHandler::cop_schedule(UnixNetVConnection *netvc, ink_hrtime at)
+{
+  at = std::max(at, Thread::get_hrtime() + cop_interval);
+  if (netvc->next_cop_check_at) {
+    cop_wheel.remove(netvc);
+  }
+  netvc->next_cop_check_at = at;
+  cop_wheel.insert(netvc);
+}
+
+TS_INLINE void
+NetHandler::cop_update(UnixNetVConnection *netvc)
+{
+  // Not filed means InactivityCop has it in hand right now.
+  if (!netvc->next_cop_check_at) {
+    return;
+  }
+  // Timeouts that move out are picked up lazily when the cop gets to the netvc, only earlier ones need a move.
+  ink_hrtime at = netvc->closed ? 0 : netvc->next_inactivity_timeout_at;
+  if ((at || netvc->closed) && std::max(at, Thread::get_hrtime() + cop_interval) < netvc->next_cop_check_at) {
+    cop_schedule(netvc, at);
+  }
 }
 
 TS_INLINE void
@@ -832,7 +920,14 @@ NetHandler::stopCop(UnixNetVConnection *netvc)
   ink_release_assert(netvc->nh == this);
 
   open_list.remove(netvc);
-  cop_list.remove(netvc);
+  if (netvc->next_cop_check_at) {
+    cop_wheel.remove(netvc);
+    netvc->next_cop_check_at = 0;
+  }
+  if (netvc->in_cop_enable_list) {
+    cop_enable_list.remove(netvc);
+    netvc->in_cop_enable_list = 0;
+  }
   remove_from_keep_alive_queue(netvc);
   remove_from_active_queue(netvc);
 }
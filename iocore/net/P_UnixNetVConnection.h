@@ -38,6 +38,7 @@
 #include "P_NetAccept.h"
 
 class UnixNetVConnection;
+struct NetZeroCopyState;
 class NetHandler;
 struct PollDescriptor;
 
@@ -71,6 +72,7 @@ NetVCOptions::reset()
   ssl_client_cert_name        = nullptr;
   ssl_client_private_key_name = nullptr;
   ssl_client_ca_cert_name     = nullptr;
+  alpn_protos                 = {};
 }
 
 inline void
@@ -230,6 +232,16 @@ public:
    * current NetVC and mark the current NetVC to be closed.
    */
   UnixNetVConnection *migrateToCurrentThread(Continuation *c, EThread *t);
+  /**
+   * Move this NetVC to the NetHandler of the current thread @a t as it is, keeping its VIOs, if
+   * the NetHandler it is on can be locked. Return whether it is on @a t now.
+   */
+  bool moveToCurrentThread(EThread *t);
+  /// The less busy thread an idle session on this NetVC should move to, nullptr to stay.
+  EThread *rebalance_target();
+
+  /// Tell InactivityCop the inactivity timeout may have moved up or the netvc was closed.
+  void update_cop();
 
   Action action_;
   int closed = 0;
@@ -237,6 +249,7 @@ public:
   NetState write;
 
   LINK(UnixNetVConnection, cop_link);
+  SLINK(UnixNetVConnection, cop_enable_link);
   LINKM(UnixNetVConnection, read, ready_link)
   SLINKM(UnixNetVConnection, read, enable_link)
   LINKM(UnixNetVConnection, write, ready_link)
@@ -248,6 +261,8 @@ public:
   ink_hrtime active_timeout_in          = 0;
   ink_hrtime next_inactivity_timeout_at = 0;
   ink_hrtime next_activity_timeout_at   = 0;
+  ink_hrtime next_cop_check_at          = 0; ///< When InactivityCop looks at this again, 0 if it is not filed.
+  int in_cop_enable_list                = 0;
 
   EventIO ep;
   NetHandler *nh  = nullptr;
@@ -269,6 +284,13 @@ public:
   OOB_callback *oob_ptr    = nullptr;
   bool from_accept_thread  = false;
   NetAccept *accept_object = nullptr;
+  bool tcp_policy_ccp      = false; ///< The congestion control algorithm was set by set_tcp_policy().
+
+  /// Buffer blocks pinned by MSG_ZEROCOPY sends that the kernel has not released yet.
+  /// Allocated on the first zero copy write, see proxy.config.net.zerocopy_min_write.
+  NetZeroCopyState *zerocopy = nullptr;
+  bool zerocopy_enable();
+  void zerocopy_reap();
 
   // es - origin_trace associated connections
   bool origin_trace;
@@ -296,6 +318,7 @@ public:
   void set_remote_addr() override;
   void set_remote_addr(const sockaddr *) override;
   int set_tcp_congestion_control(int side) override;
+  void set_tcp_policy(std::string_view ccp, int64_t pacing_rate, int notsent_lowat) override;
   void apply_options() override;
 
   friend void write_to_net_io(NetHandler *, UnixNetVConnection *, EThread *);
@@ -31,6 +31,12 @@
 
 #include "tscore/ink_platform.h"
 
+#if TS_USE_LINUX_IO_URING
+#include <liburing.h>
+#include <mutex>
+#include <vector>
+#endif
+
 #if TS_USE_KQUEUE
 #include <sys/event.h>
 #define INK_EVP_IN 0x001
@@ -43,6 +49,7 @@
 #define POLL_DESCRIPTOR_SIZE 32768
 
 typedef struct pollfd Pollfd;
+class EThread;
 
 struct PollDescriptor {
   int result; // result of poll
@@ -52,6 +59,38 @@ struct PollDescriptor {
   Pollfd pfd[POLL_DESCRIPTOR_SIZE];
   struct epoll_event ePoll_Triggered_Events[POLL_DESCRIPTOR_SIZE];
 #endif
+#if TS_USE_LINUX_IO_URING
+  /** Multishot io_uring poll used in place of epoll_ctl / epoll_wait, see @c enable_io_uring.
+
+      Registrations are identified by a token holding a slot index and a generation, so completions
+      that are still in flight for a registration that has been stopped are dropped instead of
+      dereferencing a stale @c EventIO.
+   */
+  struct UringSlot {
+    void *data      = nullptr; ///< The registered @c EventIO, @c nullptr if the slot is free.
+    int fd          = -1;
+    int events      = 0;
+    uint32_t gen    = 0;
+  };
+  io_uring *uring      = nullptr;
+  EThread *uring_owner = nullptr; ///< Only this thread may touch @a uring.
+  std::vector<UringSlot> uring_slots;
+  std::vector<uint32_t> uring_free;
+  std::vector<uint64_t> uring_pending_remove; ///< Removals requested from other threads.
+  std::mutex uring_pending_mutex;
+
+  bool enable_io_uring(EThread *owner, unsigned entries);
+  uint64_t uring_add(int fd, int events, void *data);
+  void uring_remove(uint64_t token);
+  int uring_wait(int timeout_msec);
+
+private:
+  UringSlot *uring_slot(uint64_t token);
+  io_uring_sqe *uring_sqe();
+  void uring_arm(uint64_t token, const UringSlot &slot);
+
+public:
+#endif
 #if TS_USE_KQUEUE
   int kqueue_fd;
 #endif
@@ -60,6 +99,9 @@ struct PollDescriptor {
 #endif
 
   PollDescriptor() { init(); }
+#if TS_USE_LINUX_IO_URING
+  ~PollDescriptor();
+#endif
 #if TS_USE_EPOLL
 #define get_ev_port(a) ((a)->epoll_fd)
 #define get_ev_events(a, x) ((a)->ePoll_Triggered_Events[(x)].events)
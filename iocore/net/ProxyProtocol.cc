@@ -177,3 +177,204 @@ proxy_protov1_parse(NetVConnection *netvc, ts::TextView hdr)
 
   return true;
 }
+
+namespace
+{
+// The address block sizes of the v2 address families
+constexpr size_t PP2_ADDR_LEN_INET  = 12;
+constexpr size_t PP2_ADDR_LEN_INET6 = 36;
+constexpr size_t PP2_ADDR_LEN_UNIX  = 216;
+
+// The client and verify fields that come before the sub TLVs of PP2_TYPE_SSL
+constexpr size_t PP2_SSL_FIXED_LEN = 5;
+
+uint16_t
+pp2_uint16(const char *p)
+{
+  return (static_cast<uint8_t>(p[0]) << 8) | static_cast<uint8_t>(p[1]);
+}
+
+// Check that @a tlvs is a sequence of whole TLVs.
+bool
+pp2_tlvs_valid(ts::TextView tlvs)
+{
+  while (tlvs.size() >= 3) {
+    size_t len = pp2_uint16(tlvs.data() + 1);
+    if (tlvs.size() < 3 + len) {
+      return false;
+    }
+    tlvs.remove_prefix(3 + len);
+  }
+  return tlvs.empty();
+}
+
+ts::TextView
+pp2_find_tlv(ts::TextView tlvs, uint8_t type)
+{
+  while (tlvs.size() >= 3) {
+    uint8_t t          = tlvs[0];
+    size_t len         = pp2_uint16(tlvs.data() + 1);
+    ts::TextView value = tlvs.substr(3, len);
+    tlvs.remove_prefix(3 + len);
+
+    if (t == type) {
+      return value;
+    }
+    if (t == PP2_TYPE_SSL && type > PP2_TYPE_SSL && type <= PP2_SUBTYPE_SSL_KEY_ALG && value.size() >= PP2_SSL_FIXED_LEN) {
+      ts::TextView sub = pp2_find_tlv(value.substr(PP2_SSL_FIXED_LEN), type);
+      if (!sub.empty()) {
+        return sub;
+      }
+    }
+  }
+  return ts::TextView();
+}
+} // namespace
+
+std::string_view
+NetVConnection::ProxyProtocol::get_tlv(uint8_t type) const
+{
+  return pp2_find_tlv(ts::TextView(tlv, tlv_len), type);
+}
+
+size_t
+proxy_protov2_parse(NetVConnection *netvc, ts::TextView hdr)
+{
+  if (hdr.size() < PROXY_V2_CONNECTION_HEADER_LEN_MIN ||
+      0 != memcmp(PROXY_V2_CONNECTION_PREFACE, hdr.data(), PROXY_V2_CONNECTION_PREFACE_LEN)) {
+    return 0;
+  }
+
+  // The fixed part: the preface, the version and command, the address family and transport, then the length of the rest.
+  uint8_t ver_cmd = hdr[12];
+  uint8_t fam     = hdr[13];
+  size_t len      = pp2_uint16(hdr.data() + 14);
+  size_t hdr_len  = PROXY_V2_CONNECTION_HEADER_LEN_MIN + len;
+
+  if ((ver_cmd >> 4) != 2) {
+    Debug("proxyprotocol_v2", "proxy_protov2_parse: unsupported version 0x%x", ver_cmd >> 4);
+    return 0;
+  }
+  if (hdr_len > PROXY_V2_CONNECTION_HEADER_LEN_MAX || hdr_len > hdr.size()) {
+    Debug("proxyprotocol_v2", "proxy_protov2_parse: header of %zu bytes, %zu received", hdr_len, hdr.size());
+    return 0;
+  }
+
+  ts::TextView body = hdr.substr(PROXY_V2_CONNECTION_HEADER_LEN_MIN, len);
+
+  // LOCAL is sent by the balancer for its own connections, health checks, keep the real addresses.
+  if ((ver_cmd & 0x0F) == 0x00) {
+    Debug("proxyprotocol_v2", "proxy_protov2_parse: LOCAL command");
+    return hdr_len;
+  }
+  if ((ver_cmd & 0x0F) != 0x01) {
+    Debug("proxyprotocol_v2", "proxy_protov2_parse: unsupported command 0x%x", ver_cmd & 0x0F);
+    return 0;
+  }
+
+  NetVConnection::ProxyProtocol &pp = netvc->pp_info;
+  size_t addr_len                    = 0;
+  in_port_t src_port, dst_port; // network order, as sent
+
+  // The fields are not aligned in the buffer, copy them out.
+  switch (fam >> 4) {
+  case 0x1: { // AF_INET
+    in_addr_t src, dst;
+    if (body.size() < PP2_ADDR_LEN_INET) {
+      return 0;
+    }
+    memcpy(&src, body.data(), sizeof(src));
+    memcpy(&dst, body.data() + 4, sizeof(dst));
+    memcpy(&src_port, body.data() + 8, sizeof(src_port));
+    memcpy(&dst_port, body.data() + 10, sizeof(dst_port));
+    ats_ip4_set(&pp.src_addr, src, src_port);
+    ats_ip4_set(&pp.dst_addr, dst, dst_port);
+    pp.ip_family = AF_INET;
+    addr_len     = PP2_ADDR_LEN_INET;
+    break;
+  }
+  case 0x2: { // AF_INET6
+    in6_addr src, dst;
+    if (body.size() < PP2_ADDR_LEN_INET6) {
+      return 0;
+    }
+    memcpy(&src, body.data(), sizeof(src));
+    memcpy(&dst, body.data() + 16, sizeof(dst));
+    memcpy(&src_port, body.data() + 32, sizeof(src_port));
+    memcpy(&dst_port, body.data() + 34, sizeof(dst_port));
+    ats_ip6_set(&pp.src_addr, src, src_port);
+    ats_ip6_set(&pp.dst_addr, dst, dst_port);
+    pp.ip_family = AF_INET6;
+    addr_len     = PP2_ADDR_LEN_INET6;
+    break;
+  }
+  case 0x3: // AF_UNIX, there is no address to use
+    addr_len = PP2_ADDR_LEN_UNIX;
+    break;
+  default: // AF_UNSPEC
+    break;
+  }
+  if (body.size() < addr_len) {
+    return 0;
+  }
+
+  ts::TextView tlvs = body.substr(addr_len);
+  if (!pp2_tlvs_valid(tlvs)) {
+    Debug("proxyprotocol_v2", "proxy_protov2_parse: malformed TLVs");
+    return 0;
+  }
+  if (tlvs.size() <= sizeof(pp.tlv)) {
+    memcpy(pp.tlv, tlvs.data(), tlvs.size());
+    pp.tlv_len = tlvs.size();
+  } else {
+    Debug("proxyprotocol_v2", "proxy_protov2_parse: dropping %zu bytes of TLVs", tlvs.size());
+  }
+
+  if (addr_len == PP2_ADDR_LEN_INET || addr_len == PP2_ADDR_LEN_INET6) {
+    netvc->set_proxy_protocol_version(NetVConnection::ProxyProtocolVersion::V2);
+  }
+  Debug("proxyprotocol_v2", "proxy_protov2_parse: family 0x%x, %zu bytes of TLVs", fam, tlvs.size());
+
+  return hdr_len;
+}
+
+bool
+ssl_has_proxy_v2(NetVConnection *sslvc, char *buffer, int64_t *bytes_r)
+{
+  size_t hdr_len = proxy_protov2_parse(sslvc, ts::TextView(buffer, static_cast<size_t>(*bytes_r)));
+  if (hdr_len == 0) {
+    return false;
+  }
+
+  // The header was read along with the start of the handshake, keep the handshake bytes for the SSL session.
+  *bytes_r -= hdr_len;
+  if (*bytes_r <= 0) {
+    *bytes_r = -EAGAIN;
+  } else {
+    Debug("ssl", "Moving %" PRId64 " characters remaining in the buffer from %p to %p", *bytes_r, buffer + hdr_len, buffer);
+    memmove(buffer, buffer + hdr_len, *bytes_r);
+  }
+  return true;
+}
+
+bool
+http_has_proxy_v2(IOBufferReader *reader, NetVConnection *netvc)
+{
+  char buf[PROXY_V2_CONNECTION_HEADER_LEN_MAX];
+  ts::TextView tv;
+
+  // Look at the fixed part first, the whole header is only copied out once it is known to be one.
+  tv.assign(buf, reader->memcpy(buf, PROXY_V2_CONNECTION_HEADER_LEN_MIN, 0));
+  if (tv.size() < PROXY_V2_CONNECTION_HEADER_LEN_MIN ||
+      0 != memcmp(PROXY_V2_CONNECTION_PREFACE, buf, PROXY_V2_CONNECTION_PREFACE_LEN)) {
+    return false;
+  }
+
+  tv.assign(buf, reader->memcpy(buf, sizeof(buf), 0));
+  size_t hdr_len = proxy_protov2_parse(netvc, tv);
+  if (hdr_len == 0) {
+    return false;
+  }
+  reader->consume(hdr_len); // clear out the header.
+  return true;
+}
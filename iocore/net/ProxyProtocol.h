@@ -40,16 +40,36 @@ extern bool proxy_protov1_parse(NetVConnection *, ts::TextView hdr);
 extern bool ssl_has_proxy_v1(NetVConnection *, char *, int64_t *);
 extern bool http_has_proxy_v1(IOBufferReader *, NetVConnection *);
 
+// Parse the binary v2 header at the start of @a hdr, return its length or 0 if there is no complete valid header.
+extern size_t proxy_protov2_parse(NetVConnection *, ts::TextView hdr);
+extern bool ssl_has_proxy_v2(NetVConnection *, char *, int64_t *);
+extern bool http_has_proxy_v2(IOBufferReader *, NetVConnection *);
+
 const char *const PROXY_V1_CONNECTION_PREFACE = R"(PROXY)";
-const char *const PROXY_V2_CONNECTION_PREFACE = "\x0D\x0A\x0D\x0A\x00\x0D\x0A\x51\x55\x49\x54\x0A\x02";
+const char *const PROXY_V2_CONNECTION_PREFACE = "\x0D\x0A\x0D\x0A\x00\x0D\x0A\x51\x55\x49\x54\x0A";
 
 const size_t PROXY_V1_CONNECTION_PREFACE_LEN = strlen(PROXY_V1_CONNECTION_PREFACE); // 5
-const size_t PROXY_V2_CONNECTION_PREFACE_LEN = 13;
+const size_t PROXY_V2_CONNECTION_PREFACE_LEN = 12;
 
 const size_t PROXY_V1_CONNECTION_HEADER_LEN_MIN = 15;
 const size_t PROXY_V2_CONNECTION_HEADER_LEN_MIN = 16;
 
 const size_t PROXY_V1_CONNECTION_HEADER_LEN_MAX = 108;
-const size_t PROXY_V2_CONNECTION_HEADER_LEN_MAX = 16;
+// The fixed part, the IPv6 addresses and the TLVs that are kept, longer headers are refused.
+const size_t PROXY_V2_CONNECTION_HEADER_LEN_MAX = 16 + 36 + NetVConnection::ProxyProtocol::TLV_MAX;
+
+// The TLV types of the v2 header
+const uint8_t PP2_TYPE_ALPN           = 0x01;
+const uint8_t PP2_TYPE_AUTHORITY      = 0x02;
+const uint8_t PP2_TYPE_CRC32C         = 0x03;
+const uint8_t PP2_TYPE_NOOP           = 0x04;
+const uint8_t PP2_TYPE_UNIQUE_ID      = 0x05;
+const uint8_t PP2_TYPE_SSL            = 0x20;
+const uint8_t PP2_SUBTYPE_SSL_VERSION = 0x21;
+const uint8_t PP2_SUBTYPE_SSL_CN      = 0x22;
+const uint8_t PP2_SUBTYPE_SSL_CIPHER  = 0x23;
+const uint8_t PP2_SUBTYPE_SSL_SIG_ALG = 0x24;
+const uint8_t PP2_SUBTYPE_SSL_KEY_ALG = 0x25;
+const uint8_t PP2_TYPE_NETNS          = 0x30;
 
 #endif /* ProxyProtocol_H_ */
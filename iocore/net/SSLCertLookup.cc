@@ -31,6 +31,9 @@
 #include "tscore/BufferWriter.h"
 #include "tscore/bwf_std_format.h"
 #include "tscore/TestBox.h"
+#if TS_USE_HKDF
+#include "tscore/HKDF.h"
+#endif
 
 #include "I_EventSystem.h"
 
@@ -246,6 +249,61 @@ fail:
 #endif /* TS_HAVE_OPENSSL_SESSION_TICKETS */
 }
 
+/**
+   Derive the ticket keys of the rotation period @a period from @a secret. The keys of the period
+   come first, for the new tickets, then those of the @a previous periods before it and the one of
+   the next period, so that the tickets of the nodes whose clock is a little ahead are accepted too.
+   All the nodes with the same secret have the same keys.
+ */
+ssl_ticket_key_block *
+ssl_derive_ticket_keyblock(const char *secret, int secret_len, int64_t period, unsigned previous)
+{
+#if TS_HAVE_OPENSSL_SESSION_TICKETS && TS_USE_HKDF
+  static const char salt[]       = "ATS session ticket keys";
+  ssl_ticket_key_block *keyblock = nullptr;
+  uint8_t prk[EVP_MAX_MD_SIZE];
+  size_t prk_len = sizeof(prk);
+  HKDF hkdf(EVP_sha256());
+
+  if (secret_len < static_cast<int>(sizeof(ssl_ticket_key_t::hmac_secret))) {
+    Error("SSL session ticket secret is too short (>= 16 bytes are required)");
+    return nullptr;
+  }
+  if (hkdf.extract(prk, &prk_len, reinterpret_cast<const uint8_t *>(salt), sizeof(salt) - 1,
+                   reinterpret_cast<const uint8_t *>(secret), secret_len) != 1) {
+    Error("failed to derive the SSL session ticket keys");
+    return nullptr;
+  }
+
+  keyblock = ticket_block_alloc(previous + 2);
+  for (unsigned i = 0; i < keyblock->num_keys; ++i) {
+    int64_t key_period = i <= previous ? period - i : period + 1;
+    uint8_t info[16]   = {'t', 'i', 'c', 'k', 'e', 't', ' ', 'k'};
+    for (int b = 0; b < 8; ++b) {
+      info[8 + b] = static_cast<uint8_t>(static_cast<uint64_t>(key_period) >> (56 - 8 * b));
+    }
+    size_t key_len = sizeof(ssl_ticket_key_t);
+    if (hkdf.expand(reinterpret_cast<uint8_t *>(&keyblock->keys[i]), &key_len, prk, prk_len, info, sizeof(info),
+                    sizeof(ssl_ticket_key_t)) != 1) {
+      Error("failed to derive the SSL session ticket keys");
+      ticket_block_free(keyblock);
+      keyblock = nullptr;
+      break;
+    }
+  }
+  OPENSSL_cleanse(prk, sizeof(prk));
+  return keyblock;
+
+#else
+  (void)secret;
+  (void)secret_len;
+  (void)period;
+  (void)previous;
+  Error("SSL session ticket key rotation needs a crypto library with HKDF");
+  return nullptr;
+#endif
+}
+
 SSLCertContext::SSLCertContext(SSLCertContext const &other)
 {
   opt        = other.opt;
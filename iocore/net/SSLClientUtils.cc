@@ -156,6 +156,10 @@ SSLInitClientContext(const SSLConfigParams *params)
   }
 
   SSL_CTX_set_options(client_ctx, params->ssl_client_ctx_options);
+#ifdef SSL_MODE_RELEASE_BUFFERS
+  // Pooled origin connections are mostly idle, don't keep their record buffers.
+  SSL_CTX_set_mode(client_ctx, SSL_MODE_RELEASE_BUFFERS);
+#endif
   if (params->client_cipherSuite != nullptr) {
     if (!SSL_CTX_set_cipher_list(client_ctx, params->client_cipherSuite)) {
       SSLError("invalid client cipher suite in records.config");
@@ -45,19 +45,25 @@
 #include "P_SSLClientUtils.h"
 #include "P_SSLCertLookup.h"
 #include "SSLDiags.h"
+#include "SSLLazyCert.h"
 #include "SSLSessionCache.h"
 #include "SSLSessionTicket.h"
+#include "SSLStats.h"
 #include "YamlSNIConfig.h"
 
 int SSLConfig::configid                                     = 0;
 int SSLCertificateConfig::configid                          = 0;
 int SSLTicketKeyConfig::configid                            = 0;
 int SSLConfigParams::ssl_maxrecord                          = 0;
+bool SSLConfigParams::ssl_ktls_enabled                      = false;
+int SSLConfigParams::server_max_early_data                  = 0;
+int SSLConfigParams::server_early_data_replay_window        = 10;
 bool SSLConfigParams::ssl_allow_client_renegotiation        = false;
 bool SSLConfigParams::ssl_ocsp_enabled                      = false;
 int SSLConfigParams::ssl_ocsp_cache_timeout                 = 3600;
 int SSLConfigParams::ssl_ocsp_request_timeout               = 10;
 int SSLConfigParams::ssl_ocsp_update_period                 = 60;
+int SSLConfigParams::ssl_ocsp_max_requests                  = 32;
 int SSLConfigParams::ssl_handshake_timeout_in               = 0;
 size_t SSLConfigParams::session_cache_number_buckets        = 1024;
 bool SSLConfigParams::session_cache_skip_on_lock_contention = false;
@@ -102,6 +108,7 @@ SSLConfigParams::reset()
   server_groups_list                         = nullptr;
   client_groups_list                         = nullptr;
   client_ctx                                 = nullptr;
+  ssl_ocsp_cache_path_only                   = nullptr;
   clientCertLevel = client_verify_depth = verify_depth = 0;
   verifyServerPolicy                                   = YamlSNIConfig::Policy::DISABLED;
   verifyServerProperties                               = YamlSNIConfig::Property::NONE;
@@ -134,6 +141,7 @@ SSLConfigParams::cleanup()
   cipherSuite             = (char *)ats_free_null(cipherSuite);
   client_cipherSuite      = (char *)ats_free_null(client_cipherSuite);
   dhparamsFile            = (char *)ats_free_null(dhparamsFile);
+  ssl_ocsp_cache_path_only = (char *)ats_free_null(ssl_ocsp_cache_path_only);
 
   server_tls13_cipher_suites = (char *)ats_free_null(server_tls13_cipher_suites);
   client_tls13_cipher_suites = (char *)ats_free_null(client_tls13_cipher_suites);
@@ -184,6 +192,7 @@ SSLConfigParams::initialize()
   char *ssl_server_ca_cert_filename     = nullptr;
   char *ssl_client_ca_cert_filename     = nullptr;
   char *ssl_ocsp_response_path          = nullptr;
+  char *ssl_ocsp_cache_path             = nullptr;
 
   cleanup();
 
@@ -308,13 +317,21 @@ SSLConfigParams::initialize()
   SSLConfigParams::session_cache_skip_on_lock_contention = ssl_session_cache_skip_on_contention;
   SSLConfigParams::session_cache_number_buckets          = ssl_session_cache_num_buckets;
 
-  if (ssl_session_cache == SSL_SESSION_CACHE_MODE_SERVER_ATS_IMPL) {
-    session_cache = new SSLSessionCache();
+  // The sessions are kept over a reload, the cache settings need a restart.
+  if (ssl_session_cache == SSL_SESSION_CACHE_MODE_SERVER_ATS_IMPL && session_cache == nullptr) {
+    session_cache = SSLSessionCacheBackend::create();
   }
 
   // SSL record size
   REC_EstablishStaticConfigInt32(ssl_maxrecord, "proxy.config.ssl.max_record_size");
 
+  // Kernel TLS offload for inbound connections
+  REC_ReadConfigInt32(ssl_ktls_enabled, "proxy.config.ssl.ktls.enabled");
+
+  // TLS 1.3 early data
+  REC_ReadConfigInt32(server_max_early_data, "proxy.config.ssl.server.max_early_data");
+  REC_ReadConfigInt32(server_early_data_replay_window, "proxy.config.ssl.server.early_data_replay_window");
+
   // SSL OCSP Stapling configurations
   REC_ReadConfigInt32(ssl_ocsp_enabled, "proxy.config.ssl.ocsp.enabled");
   REC_EstablishStaticConfigInt32(ssl_ocsp_cache_timeout, "proxy.config.ssl.ocsp.cache_timeout");
@@ -323,6 +340,13 @@ SSLConfigParams::initialize()
   REC_ReadConfigStringAlloc(ssl_ocsp_response_path, "proxy.config.ssl.ocsp.response.path");
   set_paths_helper(ssl_ocsp_response_path, nullptr, &ssl_ocsp_response_path_only, nullptr);
   ats_free(ssl_ocsp_response_path);
+  REC_EstablishStaticConfigInt32(ssl_ocsp_max_requests, "proxy.config.ssl.ocsp.max_requests");
+  // An empty path turns off saving the responses.
+  REC_ReadConfigStringAlloc(ssl_ocsp_cache_path, "proxy.config.ssl.ocsp.cache_path");
+  if (ssl_ocsp_cache_path && *ssl_ocsp_cache_path) {
+    set_paths_helper(ssl_ocsp_cache_path, nullptr, &ssl_ocsp_cache_path_only, nullptr);
+  }
+  ats_free(ssl_ocsp_cache_path);
 
   REC_ReadConfigInt32(async_handshake_enabled, "proxy.config.ssl.async.handshake.enabled");
   REC_ReadConfigStringAlloc(engine_conf_file, "proxy.config.ssl.engine.conf_file");
@@ -489,6 +513,7 @@ SSLCertificateConfig::startup()
   sslCertUpdate->attach("proxy.config.ssl.server.private_key.path");
   sslCertUpdate->attach("proxy.config.ssl.server.cert_chain.filename");
   sslCertUpdate->attach("proxy.config.ssl.server.session_ticket.enable");
+  sslCertUpdate->attach("proxy.config.ssl.server.cert.lazy_load");
   // Exit if there are problems on the certificate loading and the
   // proxy.config.ssl.server.multicert.exit_on_load_fail is true
   SSLConfig::scoped_config params;
@@ -524,6 +549,8 @@ SSLCertificateConfig::reconfigure()
   // we won't want to reset the config
   if (lookup->is_valid || !params->configExitOnLoadError) {
     configid = configProcessor.set(configid, lookup);
+    // The lazy contexts are of the entries of the previous configuration.
+    lazyCertCache.clear();
   } else {
     delete lookup;
   }
@@ -563,11 +590,19 @@ SSLTicketParams::LoadTicket(bool &nochange)
   bool no_default_keyblock = true;
 
   SSLTicketKeyConfig::scoped_config ticket_params;
+  int64_t last_rotation_period = -1;
   if (ticket_params) {
-    last_load_time      = ticket_params->load_time;
-    no_default_keyblock = ticket_params->default_global_keyblock == nullptr;
+    last_load_time       = ticket_params->load_time;
+    no_default_keyblock  = ticket_params->default_global_keyblock == nullptr;
+    last_rotation_period = ticket_params->rotation_period;
   }
 
+  // With a rotation period the file holds a secret that the keys of each period are derived from.
+  int64_t rotation_length = 0;
+  int64_t previous_keys   = 2;
+  REC_ReadConfigInteger(rotation_length, "proxy.config.ssl.server.ticket_key.rotation_period");
+  REC_ReadConfigInteger(previous_keys, "proxy.config.ssl.server.ticket_key.previous_keys");
+
   // elevate/allow file access to root read only files/certs
   uint32_t elevate_setting = 0;
   REC_ReadConfigInteger(elevate_setting, "proxy.config.ssl.cert.load_elevated");
@@ -576,17 +611,31 @@ SSLTicketParams::LoadTicket(bool &nochange)
   if (REC_ReadConfigStringAlloc(ticket_key_filename, "proxy.config.ssl.server.ticket_key.filename") == REC_ERR_OKAY &&
       ticket_key_filename != nullptr) {
     ats_scoped_str ticket_key_path(Layout::relative_to(params->serverCertPathOnly, ticket_key_filename));
+    int64_t period = rotation_length > 0 ? time(nullptr) / rotation_length : -1;
     // See if the file changed since we last loaded
     struct stat sdata;
     if (last_load_time && (stat(ticket_key_filename, &sdata) >= 0)) {
-      if (sdata.st_mtime && sdata.st_mtime <= last_load_time) {
+      if (sdata.st_mtime && sdata.st_mtime <= last_load_time && period == last_rotation_period) {
         Debug("ssl", "ticket key %s has not changed", ticket_key_filename);
         // No updates since last load
         return true;
       }
     }
     nochange = false;
-    keyblock = ssl_create_ticket_keyblock(ticket_key_path);
+    if (period >= 0) {
+      int secret_len = 0;
+      ats_scoped_str secret(readIntoBuffer(ticket_key_path, __func__, &secret_len));
+      if (secret) {
+        keyblock = ssl_derive_ticket_keyblock(secret, secret_len, period, std::max<int64_t>(previous_keys, 0));
+        OPENSSL_cleanse(secret.get(), secret_len);
+      }
+      rotation_period = period;
+      if (keyblock && ssl_rsb != nullptr) {
+        SSL_INCREMENT_DYN_STAT(ssl_total_ticket_keys_renewed_stat);
+      }
+    } else {
+      keyblock = ssl_create_ticket_keyblock(ticket_key_path);
+    }
     // Initialize if we don't have one yet
   } else if (no_default_keyblock) {
     nochange = false;
@@ -621,16 +670,60 @@ SSLTicketParams::LoadTicketData(char *ticket_data, int ticket_data_len)
 #endif
 }
 
+namespace
+{
+/// Derives the ticket keys of each rotation period when it starts.
+class TicketKeyRotation : public Continuation
+{
+public:
+  TicketKeyRotation() : Continuation(new_ProxyMutex()) { SET_HANDLER(&TicketKeyRotation::rotate_event); }
+
+  int
+  rotate_event(int /* event */, void * /* data */)
+  {
+    if (this->rotation_length() > 0) {
+      SSLTicketKeyConfig::reconfigure();
+    }
+    this->schedule_next();
+    return EVENT_DONE;
+  }
+
+  void
+  schedule_next()
+  {
+    // Wake up at the start of the next period, and every minute to notice a change of the period.
+    int64_t length   = this->rotation_length();
+    ink_hrtime delay = HRTIME_MINUTE;
+    if (length > 0) {
+      delay = std::min(delay, HRTIME_SECONDS(length - time(nullptr) % length));
+    }
+    eventProcessor.schedule_in(this, delay, ET_TASK);
+  }
+
+private:
+  int64_t
+  rotation_length() const
+  {
+    int64_t length = 0;
+    REC_ReadConfigInteger(length, "proxy.config.ssl.server.ticket_key.rotation_period");
+    return length;
+  }
+};
+} // namespace
+
 void
 SSLTicketKeyConfig::startup()
 {
   sslTicketKey.reset(new ConfigUpdateHandler<SSLTicketKeyConfig>());
 
   sslTicketKey->attach("proxy.config.ssl.server.ticket_key.filename");
+  sslTicketKey->attach("proxy.config.ssl.server.ticket_key.rotation_period");
+  sslTicketKey->attach("proxy.config.ssl.server.ticket_key.previous_keys");
   SSLConfig::scoped_config params;
   if (!reconfigure() && params->configExitOnLoadError) {
     Fatal("Failed to load SSL ticket key file");
   }
+  (new TicketKeyRotation())->schedule_next();
 }
 
 bool
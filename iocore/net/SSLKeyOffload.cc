@@ -0,0 +1,341 @@
+/** @file
+
+  Private key operations offloaded from the net threads.
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ */
+
+#include "SSLKeyOffload.h"
+
+#include "tscore/ink_config.h"
+#include "P_EventSystem.h"
+#include "P_SSLConfig.h"
+
+#if TS_USE_TLS_ASYNC
+
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <fcntl.h>
+#include <sched.h>
+#include <unistd.h>
+
+#include <openssl/async.h>
+#include <openssl/ec.h>
+#include <openssl/rsa.h>
+
+namespace
+{
+constexpr char const DEBUG_TAG[] = "ssl.key_offload";
+/// Key of the wait fd in the wait contexts of the async jobs.
+char const WAIT_KEY[] = "ats_key_offload";
+
+EventType ET_SSL_KEY     = -1;
+RSA_METHOD *rsa_method   = nullptr;
+EC_KEY_METHOD *ec_method = nullptr;
+
+int (*rsa_priv_enc)(int flen, const unsigned char *from, unsigned char *to, RSA *rsa, int padding) = nullptr;
+int (*rsa_priv_dec)(int flen, const unsigned char *from, unsigned char *to, RSA *rsa, int padding) = nullptr;
+int (*ec_sign)(int type, const unsigned char *dgst, int dlen, unsigned char *sig, unsigned int *siglen, const BIGNUM *kinv,
+               const BIGNUM *r, EC_KEY *eckey)                                                     = nullptr;
+
+/** One private key operation.
+
+    The operation has copies of its input and of the key, because the handshake can be closed, and
+    its async job freed, while the operation runs.
+ */
+struct KeyOperation {
+  enum Kind { RSA_PRIV_ENC, RSA_PRIV_DEC, EC_SIGN } kind = RSA_PRIV_ENC;
+  RSA *rsa                                              = nullptr;
+  EC_KEY *eckey                                         = nullptr;
+  int arg                                               = 0; ///< The padding for RSA, the type for EC.
+  std::vector<unsigned char> input;
+  std::vector<unsigned char> output;
+  unsigned int output_len = 0;
+  int result              = 0;
+  std::atomic<bool> done{false};
+
+  ~KeyOperation()
+  {
+    RSA_free(rsa);
+    EC_KEY_free(eckey);
+  }
+
+  void
+  execute()
+  {
+    switch (kind) {
+    case RSA_PRIV_ENC:
+      result = rsa_priv_enc(input.size(), input.data(), output.data(), rsa, arg);
+      break;
+    case RSA_PRIV_DEC:
+      result = rsa_priv_dec(input.size(), input.data(), output.data(), rsa, arg);
+      break;
+    case EC_SIGN:
+      output_len = output.size();
+      result     = ec_sign(arg, input.data(), input.size(), output.data(), &output_len, nullptr, nullptr, eckey);
+      break;
+    }
+  }
+};
+
+/// Runs a @c KeyOperation on an ET_SSL_KEY thread and signals its async job.
+class KeyOperationEvent : public Continuation
+{
+public:
+  KeyOperationEvent(std::shared_ptr<KeyOperation> op, int signal_fd)
+    : Continuation(new_ProxyMutex()), _op(std::move(op)), _signal_fd(signal_fd)
+  {
+    SET_HANDLER(&KeyOperationEvent::run_event);
+  }
+
+  int
+  run_event(int /* event */, void * /* data */)
+  {
+    char c = 1;
+    _op->execute();
+    _op->done.store(true, std::memory_order_release);
+    // The signal fd is a duplicate of our own, it is valid even if the job is gone.
+    if (write(_signal_fd, &c, 1) < 0) {
+      Debug(DEBUG_TAG, "failed to signal the async job: %s", strerror(errno));
+    }
+    close(_signal_fd);
+    delete this;
+    return EVENT_DONE;
+  }
+
+private:
+  std::shared_ptr<KeyOperation> _op;
+  int _signal_fd;
+};
+
+/// The wait fd of an async job, and its operation in progress.
+struct WaitState {
+  OSSL_ASYNC_FD writefd = -1;
+  std::shared_ptr<KeyOperation> pending;
+};
+
+void
+wait_cleanup(ASYNC_WAIT_CTX * /* ctx */, const void * /* key */, OSSL_ASYNC_FD readfd, void *custom)
+{
+  WaitState *state = static_cast<WaitState *>(custom);
+  close(readfd);
+  close(state->writefd);
+  delete state;
+}
+
+/** Run @a op on an ET_SSL_KEY thread if this is in an async job, else in place.
+
+    The stack of a paused job is dropped without unwinding if the handshake is closed, so while the
+    job is paused the operation is held by the wait state of the job, which is cleaned up then.
+ */
+std::shared_ptr<KeyOperation>
+offload(std::shared_ptr<KeyOperation> op)
+{
+  ASYNC_JOB *job = ASYNC_get_current_job();
+  if (job == nullptr) {
+    op->execute();
+    return op;
+  }
+
+  ASYNC_WAIT_CTX *waitctx = ASYNC_get_wait_ctx(job);
+  OSSL_ASYNC_FD readfd;
+  WaitState *state = nullptr;
+  if (!ASYNC_WAIT_CTX_get_fd(waitctx, WAIT_KEY, &readfd, reinterpret_cast<void **>(&state))) {
+    int fds[2];
+    if (pipe2(fds, O_NONBLOCK | O_CLOEXEC) != 0) {
+      op->execute();
+      return op;
+    }
+    state          = new WaitState;
+    state->writefd = fds[1];
+    readfd         = fds[0];
+    if (!ASYNC_WAIT_CTX_set_wait_fd(waitctx, WAIT_KEY, readfd, state, wait_cleanup)) {
+      wait_cleanup(waitctx, WAIT_KEY, readfd, state);
+      op->execute();
+      return op;
+    }
+  }
+
+  int signal_fd = dup(state->writefd);
+  if (signal_fd < 0) {
+    op->execute();
+    return op;
+  }
+  KeyOperation *running = op.get();
+  state->pending        = op;
+  eventProcessor.schedule_imm(new KeyOperationEvent(std::move(op), signal_fd), ET_SSL_KEY);
+
+  // The connection is woken by the wait fd, but the job can be resumed before for other reasons.
+  while (!running->done.load(std::memory_order_acquire)) {
+    if (!ASYNC_pause_job()) {
+      sched_yield();
+    }
+  }
+
+  char buf[16];
+  while (read(readfd, buf, sizeof(buf)) > 0) {
+  }
+  return std::move(state->pending);
+}
+
+int
+offload_rsa_priv_enc(int flen, const unsigned char *from, unsigned char *to, RSA *rsa, int padding)
+{
+  auto op  = std::make_shared<KeyOperation>();
+  op->kind = KeyOperation::RSA_PRIV_ENC;
+  op->arg  = padding;
+  op->input.assign(from, from + flen);
+  op->output.resize(RSA_size(rsa));
+  RSA_up_ref(rsa);
+  op->rsa = rsa;
+
+  op = offload(std::move(op));
+  if (op->result > 0) {
+    memcpy(to, op->output.data(), op->result);
+  }
+  return op->result;
+}
+
+int
+offload_rsa_priv_dec(int flen, const unsigned char *from, unsigned char *to, RSA *rsa, int padding)
+{
+  auto op  = std::make_shared<KeyOperation>();
+  op->kind = KeyOperation::RSA_PRIV_DEC;
+  op->arg  = padding;
+  op->input.assign(from, from + flen);
+  op->output.resize(RSA_size(rsa));
+  RSA_up_ref(rsa);
+  op->rsa = rsa;
+
+  op = offload(std::move(op));
+  if (op->result > 0) {
+    memcpy(to, op->output.data(), op->result);
+  }
+  return op->result;
+}
+
+int
+offload_ec_sign(int type, const unsigned char *dgst, int dlen, unsigned char *sig, unsigned int *siglen, const BIGNUM *kinv,
+                const BIGNUM *r, EC_KEY *eckey)
+{
+  // Precomputed values are not used by TLS, they are not copied.
+  if (kinv != nullptr || r != nullptr) {
+    return ec_sign(type, dgst, dlen, sig, siglen, kinv, r, eckey);
+  }
+
+  auto op  = std::make_shared<KeyOperation>();
+  op->kind = KeyOperation::EC_SIGN;
+  op->arg  = type;
+  op->input.assign(dgst, dgst + dlen);
+  op->output.resize(ECDSA_size(eckey));
+  EC_KEY_up_ref(eckey);
+  op->eckey = eckey;
+
+  op = offload(std::move(op));
+  if (op->result > 0) {
+    memcpy(sig, op->output.data(), op->output_len);
+    *siglen = op->output_len;
+  }
+  return op->result;
+}
+} // namespace
+
+void
+SSLKeyOffloadInitialize(int n_threads, size_t stacksize)
+{
+  if (n_threads <= 0) {
+    return;
+  }
+  if (!SSLConfigParams::async_handshake_enabled) {
+    Warning("proxy.config.ssl.async.key_offload.threads requires proxy.config.ssl.async.handshake.enabled, keys are not offloaded");
+    return;
+  }
+
+  rsa_method   = RSA_meth_dup(RSA_get_default_method());
+  rsa_priv_enc = RSA_meth_get_priv_enc(rsa_method);
+  rsa_priv_dec = RSA_meth_get_priv_dec(rsa_method);
+  RSA_meth_set1_name(rsa_method, "ATS offloaded RSA");
+  RSA_meth_set_priv_enc(rsa_method, offload_rsa_priv_enc);
+  RSA_meth_set_priv_dec(rsa_method, offload_rsa_priv_dec);
+
+  ec_method = EC_KEY_METHOD_new(EC_KEY_get_default_method());
+  int (*ec_sign_setup)(EC_KEY *, BN_CTX *, BIGNUM **, BIGNUM **)                                     = nullptr;
+  ECDSA_SIG *(*ec_sign_sig)(const unsigned char *, int, const BIGNUM *, const BIGNUM *, EC_KEY *) = nullptr;
+  EC_KEY_METHOD_get_sign(ec_method, &ec_sign, &ec_sign_setup, &ec_sign_sig);
+  EC_KEY_METHOD_set_sign(ec_method, offload_ec_sign, ec_sign_setup, ec_sign_sig);
+
+  ET_SSL_KEY = eventProcessor.spawn_event_threads("ET_SSL_KEY", n_threads, stacksize);
+  Note("offloading TLS private key operations to %d threads", n_threads);
+}
+
+void
+SSLKeyOffloadAttach(SSL_CTX *ctx)
+{
+  EVP_PKEY *pkey = SSL_CTX_get0_privatekey(ctx);
+  if (ET_SSL_KEY < 0 || pkey == nullptr) {
+    return;
+  }
+
+  // A key with methods of its own is used through them, not exported to a provider.
+  EVP_PKEY *offloaded = EVP_PKEY_new();
+  bool assigned       = false;
+  switch (EVP_PKEY_base_id(pkey)) {
+  case EVP_PKEY_RSA:
+    if (RSA *rsa = EVP_PKEY_get1_RSA(pkey); rsa != nullptr) {
+      RSA_set_method(rsa, rsa_method);
+      if (!(assigned = EVP_PKEY_assign_RSA(offloaded, rsa))) {
+        RSA_free(rsa);
+      }
+    }
+    break;
+  case EVP_PKEY_EC:
+    if (EC_KEY *eckey = EVP_PKEY_get1_EC_KEY(pkey); eckey != nullptr) {
+      EC_KEY_set_method(eckey, ec_method);
+      if (!(assigned = EVP_PKEY_assign_EC_KEY(offloaded, eckey))) {
+        EC_KEY_free(eckey);
+      }
+    }
+    break;
+  default:
+    break;
+  }
+
+  if (assigned && !SSL_CTX_use_PrivateKey(ctx, offloaded)) {
+    Debug(DEBUG_TAG, "failed to use the offloaded key, it is used in place");
+  }
+  EVP_PKEY_free(offloaded);
+}
+
+#else /* !TS_USE_TLS_ASYNC */
+
+void
+SSLKeyOffloadInitialize(int n_threads, size_t /* stacksize */)
+{
+  if (n_threads > 0) {
+    Warning("proxy.config.ssl.async.key_offload.threads requires OpenSSL async job support, keys are not offloaded");
+  }
+}
+
+void
+SSLKeyOffloadAttach(SSL_CTX * /* ctx */)
+{
+}
+
+#endif /* TS_USE_TLS_ASYNC */
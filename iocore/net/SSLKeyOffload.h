@@ -0,0 +1,42 @@
+/** @file
+
+  Private key operations offloaded from the net threads.
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <openssl/ssl.h>
+
+/*
+  With proxy.config.ssl.async.key_offload.threads the RSA and ECDSA private key operations of the
+  server certificates run on a pool of ET_SSL_KEY threads. The operation is started from the OpenSSL
+  async job of the handshake, which is paused until the operation is done, and the job's wait fd
+  wakes the connection on its net thread the same as for an asynchronous crypto engine. Outside of
+  an async job, or if the offload is not started, the operations run in place.
+ */
+
+// Start the threads. Requires proxy.config.ssl.async.handshake.enabled.
+void SSLKeyOffloadInitialize(int n_threads, size_t stacksize);
+
+// Have the operations of the private key just loaded into @a ctx offloaded, if offload is started
+// and it is an RSA or EC key. The key is replaced by a copy that uses the offloading methods.
+void SSLKeyOffloadAttach(SSL_CTX *ctx);
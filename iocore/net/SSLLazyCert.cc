@@ -0,0 +1,221 @@
+/** @file
+
+  Server certificates loaded on first use.
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ */
+
+#include "SSLLazyCert.h"
+
+#include "tscore/ink_cap.h"
+#include "P_Net.h"
+#include "P_SSLConfig.h"
+#include "P_SSLUtils.h"
+
+SSLLazyCertCache lazyCertCache;
+
+namespace
+{
+constexpr char const DEBUG_TAG[] = "ssl.lazy_cert";
+
+/// Builds the context of one entry on a task thread.
+class LazyCertLoad : public Continuation
+{
+public:
+  explicit LazyCertLoad(shared_SSLMultiCertConfigParams params) : Continuation(new_ProxyMutex()), _params(std::move(params))
+  {
+    SET_HANDLER(&LazyCertLoad::load_event);
+  }
+
+  int
+  load_event(int /* event */, void * /* data */)
+  {
+    SSLConfig::scoped_config params;
+    uint32_t elevate_setting = 0;
+    shared_SSL_CTX ctx;
+
+    REC_ReadConfigInteger(elevate_setting, "proxy.config.ssl.cert.load_elevated");
+    {
+      ElevateAccess elevate_access(elevate_setting ? ElevateAccess::FILE_PRIVILEGE : 0);
+      ink_hrtime start = Thread::get_hrtime_updated();
+      ctx              = SSLMultiCertConfigLoader(params).build_lazy_ssl_ctx(_params.get());
+      Debug(DEBUG_TAG, "built the context of %s in %" PRId64 " ms", _params->cert.get(),
+            ink_hrtime_to_msec(Thread::get_hrtime_updated() - start));
+    }
+    if (!ctx) {
+      Error("failed to load the certificate %s on demand", _params->cert.get());
+    }
+
+    lazyCertCache.loaded(_params.get(), ctx);
+    delete this;
+    return EVENT_DONE;
+  }
+
+private:
+  shared_SSLMultiCertConfigParams _params;
+};
+
+/// Resumes a paused handshake on the thread of its connection.
+class LazyCertWake : public Continuation
+{
+public:
+  explicit LazyCertWake(SSLNetVConnection *vc) : Continuation(vc->nh->mutex), _vc(vc) { SET_HANDLER(&LazyCertWake::wake_event); }
+
+  int
+  wake_event(int /* event */, void * /* data */)
+  {
+    // A connection is only freed on its own thread, with its net handler locked, so once it is
+    // known to still be waiting it stays valid here.
+    if (lazyCertCache.resume(_vc)) {
+      _vc->readReschedule(_vc->nh);
+    }
+    delete this;
+    return EVENT_DONE;
+  }
+
+private:
+  SSLNetVConnection *_vc;
+};
+
+/// Drops the idle contexts.
+class LazyCertIdleCheck : public Continuation
+{
+public:
+  LazyCertIdleCheck() : Continuation(new_ProxyMutex()) { SET_HANDLER(&LazyCertIdleCheck::check_event); }
+
+  int
+  check_event(int /* event */, void * /* data */)
+  {
+    lazyCertCache.evict_idle();
+    return EVENT_CONT;
+  }
+};
+} // namespace
+
+void
+SSLLazyCertCache::start()
+{
+  int max_size     = 1000;
+  int idle_timeout = 3600;
+
+  REC_ReadConfigInteger(max_size, "proxy.config.ssl.server.cert.lazy_cache_size");
+  REC_ReadConfigInteger(idle_timeout, "proxy.config.ssl.server.cert.lazy_idle_timeout");
+  _max_size = std::max(max_size, 1);
+  if (idle_timeout > 0) {
+    _idle_timeout = HRTIME_SECONDS(idle_timeout);
+    eventProcessor.schedule_every(new LazyCertIdleCheck(), std::max(_idle_timeout / 4, HRTIME_SECONDS(1)), ET_TASK);
+  }
+}
+
+bool
+SSLLazyCertCache::get(shared_SSLMultiCertConfigParams const &params, SSLNetVConnection *vc, shared_SSL_CTX &ctx)
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  auto [spot, added] = _entries.try_emplace(params.get());
+  Entry &entry       = spot->second;
+
+  if (!entry.loading) {
+    _lru.splice(_lru.begin(), _lru, entry.lru);
+    entry.last_used = Thread::get_hrtime_updated();
+    ctx             = entry.ctx;
+    return true;
+  }
+
+  entry.waiters.push_back(vc);
+  _waiting.insert(vc);
+  vc->lazy_cert_waiting = true;
+  if (added) {
+    Debug(DEBUG_TAG, "loading the context of %s for %s", params->cert.get(), vc->serverName);
+    entry.params = params;
+    eventProcessor.schedule_imm(new LazyCertLoad(params), ET_TASK);
+  }
+  return false;
+}
+
+void
+SSLLazyCertCache::cancel(SSLNetVConnection *vc)
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  _waiting.erase(vc);
+}
+
+bool
+SSLLazyCertCache::resume(SSLNetVConnection *vc)
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  if (_waiting.erase(vc) == 0) {
+    return false;
+  }
+  vc->lazy_cert_waiting = false;
+  return true;
+}
+
+void
+SSLLazyCertCache::loaded(SSLMultiCertConfigParams const *params, shared_SSL_CTX ctx)
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  auto spot = _entries.find(params);
+  ink_assert(spot != _entries.end());
+  Entry &entry = spot->second;
+
+  entry.ctx       = std::move(ctx);
+  entry.loading   = false;
+  entry.last_used = Thread::get_hrtime_updated();
+  entry.lru       = _lru.insert(_lru.begin(), params);
+
+  for (SSLNetVConnection *vc : entry.waiters) {
+    if (_waiting.count(vc)) {
+      vc->thread->schedule_imm(new LazyCertWake(vc));
+    }
+  }
+  entry.waiters.clear();
+  entry.waiters.shrink_to_fit();
+
+  evict(_max_size);
+}
+
+void
+SSLLazyCertCache::clear()
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  evict(0);
+}
+
+void
+SSLLazyCertCache::evict_idle()
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  ink_hrtime idle_since = Thread::get_hrtime_updated() - _idle_timeout;
+
+  while (!_lru.empty() && _entries[_lru.back()].last_used < idle_since) {
+    Debug(DEBUG_TAG, "dropping the idle context of %s", _entries[_lru.back()].params->cert.get());
+    _entries.erase(_lru.back());
+    _lru.pop_back();
+  }
+}
+
+void
+SSLLazyCertCache::evict(size_t max)
+{
+  while (_lru.size() > max) {
+    Debug(DEBUG_TAG, "dropping the context of %s", _entries[_lru.back()].params->cert.get());
+    _entries.erase(_lru.back());
+    _lru.pop_back();
+  }
+}
@@ -0,0 +1,101 @@
+/** @file
+
+  Server certificates loaded on first use.
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ */
+
+#pragma once
+
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "tscore/ink_hrtime.h"
+#include "P_SSLCertLookup.h"
+
+class SSLNetVConnection;
+
+/** The contexts of the lazy entries of ssl_multicert.config.
+
+    With @c proxy.config.ssl.server.cert.lazy_load the entries that are matched by name only are
+    indexed by the names of their certificates when the configuration is loaded, but their @c SSL_CTX
+    is built on a task thread when a handshake first asks for one of those names. The handshake is
+    paused in the certificate callback until the context is ready, the same as for a plugin on the
+    @c TS_SSL_CERT_HOOK.
+
+    At most @c proxy.config.ssl.server.cert.lazy_cache_size contexts are kept, the least recently used
+    is dropped to make room, and contexts not used for @c proxy.config.ssl.server.cert.lazy_idle_timeout
+    seconds are dropped. A connection holds its own reference to its context, so dropping one does not
+    affect the connections using it.
+ */
+class SSLLazyCertCache
+{
+public:
+  /// Read the configuration and start the idle check.
+  void start();
+
+  /** Get the context of the lazy entry @a params for a handshake on @a vc.
+
+      @return @c true if @a ctx is the context, @c nullptr if it failed to load. @c false if it is
+      being loaded, the handshake of @a vc is resumed when it is done.
+   */
+  bool get(shared_SSLMultiCertConfigParams const &params, SSLNetVConnection *vc, shared_SSL_CTX &ctx);
+
+  /// @a vc is closed, do not resume it.
+  void cancel(SSLNetVConnection *vc);
+
+  /// Drop the contexts, for a new configuration. Loads in progress are kept.
+  void clear();
+
+  /// The context of @a params is loaded, or failed if @a ctx is @c nullptr.
+  void loaded(SSLMultiCertConfigParams const *params, shared_SSL_CTX ctx);
+
+  /// @return @c true if @a vc was waiting for a context, it is not any more.
+  bool resume(SSLNetVConnection *vc);
+
+  /// Drop the contexts that have not been used for the idle timeout.
+  void evict_idle();
+
+private:
+  using Key = SSLMultiCertConfigParams const *;
+
+  struct Entry {
+    shared_SSLMultiCertConfigParams params;
+    shared_SSL_CTX ctx;
+    ink_hrtime last_used = 0;
+    bool loading         = true;
+    std::vector<SSLNetVConnection *> waiters;
+    std::list<Key>::iterator lru; ///< Valid if not @a loading.
+  };
+
+  void evict(size_t max);
+
+  std::mutex _mutex;
+  std::unordered_map<Key, Entry> _entries;
+  std::list<Key> _lru; ///< Loaded entries, the most recently used first.
+  std::unordered_set<SSLNetVConnection *> _waiting;
+
+  size_t _max_size         = 1000;
+  ink_hrtime _idle_timeout = 0;
+};
+
+extern SSLLazyCertCache lazyCertCache;
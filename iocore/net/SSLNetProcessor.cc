@@ -27,6 +27,8 @@
 #include "P_SSLUtils.h"
 #include "P_OCSPStapling.h"
 #include "P_SSLSNI.h"
+#include "SSLKeyOffload.h"
+#include "SSLLazyCert.h"
 #include "SSLStats.h"
 
 //
@@ -65,10 +67,16 @@ SSLNetProcessor::start(int, size_t stacksize)
   SSLPostConfigInitialize();
   SNIConfig::startup();
 
+  // Before the certificates are loaded, so their keys are offloaded.
+  int key_offload_threads = 0;
+  REC_ReadConfigInteger(key_offload_threads, "proxy.config.ssl.async.key_offload.threads");
+  SSLKeyOffloadInitialize(key_offload_threads, stacksize);
+
   if (!SSLCertificateConfig::startup()) {
     return -1;
   }
   SSLTicketKeyConfig::startup();
+  lazyCertCache.start();
 
   // Acquire a SSLConfigParams instance *after* we start SSL up.
   // SSLConfig::scoped_config params;
@@ -78,10 +86,12 @@ SSLNetProcessor::start(int, size_t stacksize)
 
 #if TS_USE_TLS_OCSP
   if (SSLConfigParams::ssl_ocsp_enabled) {
-    // Call the update initially to get things populated
-    ocsp_update();
+    // Populate the stapling caches on the OCSP thread rather than hold up the start, the responses
+    // saved by the last run staple the handshakes in the meantime.
     EventType ET_OCSP = eventProcessor.spawn_event_threads("ET_OCSP", 1, stacksize);
-    eventProcessor.schedule_every(new OCSPContinuation(), HRTIME_SECONDS(SSLConfigParams::ssl_ocsp_update_period), ET_OCSP);
+    OCSPContinuation *ocsp_cont = new OCSPContinuation();
+    eventProcessor.schedule_imm(ocsp_cont, ET_OCSP);
+    eventProcessor.schedule_every(ocsp_cont, HRTIME_SECONDS(SSLConfigParams::ssl_ocsp_update_period), ET_OCSP);
   }
 #endif /* TS_USE_TLS_OCSP */
 
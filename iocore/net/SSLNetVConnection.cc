@@ -42,6 +42,7 @@
 #include "BIO_fastopen.h"
 #include "SSLStats.h"
 #include "SSLInternal.h"
+#include "SSLLazyCert.h"
 
 #include <climits>
 #include <string>
@@ -57,6 +58,13 @@ using namespace std::literals;
 #define BIO_eof(b) (int)BIO_ctrl(b, BIO_CTRL_EOF, 0, nullptr)
 #endif
 
+// Kernel TLS needs OpenSSL 3.0 or later built with KTLS support
+#if defined(SSL_OP_ENABLE_KTLS) && defined(BIO_get_ktls_send)
+#define TS_HAS_KTLS 1
+#else
+#define TS_HAS_KTLS 0
+#endif
+
 #define SSL_READ_ERROR_NONE 0
 #define SSL_READ_ERROR 1
 #define SSL_READ_READY 2
@@ -173,7 +181,17 @@ make_ssl_connection(SSL_CTX *ctx, SSLNetVConnection *netvc)
     } else {
       netvc->initialize_handshake_buffers();
       BIO *rbio = BIO_new(BIO_s_mem());
-      BIO *wbio = BIO_new_fd(netvc->get_socket(), BIO_NOCLOSE);
+      BIO *wbio = nullptr;
+#if TS_HAS_KTLS
+      // OpenSSL only hands the keys to the kernel when writing through a socket BIO.
+      if (SSLConfigParams::ssl_ktls_enabled) {
+        wbio = BIO_new_socket(netvc->get_socket(), BIO_NOCLOSE);
+        SSL_set_options(ssl, SSL_OP_ENABLE_KTLS);
+      } else
+#endif
+      {
+        wbio = BIO_new_fd(netvc->get_socket(), BIO_NOCLOSE);
+      }
       BIO_set_mem_eof_return(wbio, -1);
       SSL_set_bio(ssl, rbio, wbio);
     }
@@ -223,7 +241,12 @@ ssl_read_from_net(SSLNetVConnection *sslvc, EThread *lthread, int64_t &ret)
     toread = s->vio.ntodo();
   }
 
-  bytes_read = 0;
+  // The early data kept from the handshake comes before anything still in the SSL object.
+  bytes_read = sslvc->take_early_data(buf.writer(), toread);
+  if (bytes_read > 0) {
+    sslvc->netActivity(lthread);
+  }
+
   while (sslErr == SSL_ERROR_NONE && bytes_read < toread) {
     int64_t nread             = 0;
     int64_t block_write_avail = buf.writer()->block_write_avail();
@@ -406,6 +429,12 @@ SSLNetVConnection::read_raw_data()
     if (ssl_has_proxy_v1(this, buffer, &r)) {
       Debug("proxyprotocol", "ssl has proxy_v1 header");
       set_remote_addr(get_proxy_protocol_src_addr());
+    } else if (ssl_has_proxy_v2(this, buffer, &r)) {
+      // The header came in the read of the ClientHello, the client address is set before the handshake.
+      Debug("proxyprotocol", "ssl has proxy_v2 header");
+      if (get_proxy_protocol_version() != ProxyProtocolVersion::UNDEFINED) {
+        set_remote_addr(get_proxy_protocol_src_addr());
+      }
     } else {
       Debug("proxyprotocol", "proxy protocol was enabled, but required header was not present in the "
                              "transaction - closing connection");
@@ -606,6 +635,10 @@ SSLNetVConnection::net_read_io(NetHandler *nh, EThread *lthread)
       // the handshake is complete. Otherwise set up for continuing read
       // operations.
       if (ntodo <= 0) {
+        // Early data is already decrypted, the next read must not wait for the socket.
+        if (early_data_reader) {
+          read.triggered = 1;
+        }
         readSignalDone(VC_EVENT_READ_COMPLETE, nh);
       } else {
         read.triggered = 1;
@@ -703,6 +736,35 @@ SSLNetVConnection::net_read_io(NetHandler *nh, EThread *lthread)
   }
 }
 
+// The TLS record size for a write burst from the congestion window of the socket, 0 if it can not
+// be queried. A record is only decrypted once all of it has arrived, so while the window left is not
+// enough for a full record each record fits in one segment and the client can use the first bytes
+// after one round trip. Once the window opens up full records save the per record CPU cost.
+uint32_t
+SSLNetVConnection::tls_record_size_from_tcp_info() const
+{
+#if defined(TCP_INFO) && defined(HAVE_STRUCT_TCP_INFO)
+  struct tcp_info info = {};
+  socklen_t len        = sizeof(info);
+
+  if (getsockopt(con.fd, IPPROTO_TCP, TCP_INFO, &info, &len) != 0 || info.tcpi_snd_mss == 0) {
+    return 0;
+  }
+  uint64_t window = 0;
+  if (info.tcpi_snd_cwnd > info.tcpi_unacked) {
+    window = static_cast<uint64_t>(info.tcpi_snd_cwnd - info.tcpi_unacked) * info.tcpi_snd_mss;
+  }
+  Debug("ssl", "cwnd=%u unacked=%u mss=%u window=%" PRIu64, info.tcpi_snd_cwnd, info.tcpi_unacked, info.tcpi_snd_mss, window);
+
+  if (window >= SSL_MAX_TLS_RECORD_SIZE) {
+    return SSL_MAX_TLS_RECORD_SIZE;
+  }
+  return info.tcpi_snd_mss > SSL_TLS_RECORD_OVERHEAD ? info.tcpi_snd_mss - SSL_TLS_RECORD_OVERHEAD : SSL_DEF_TLS_RECORD_SIZE;
+#else
+  return 0;
+#endif
+}
+
 int64_t
 SSLNetVConnection::load_buffer_and_write(int64_t towrite, MIOBufferAccessor &buf, int64_t &total_written, int &needs)
 {
@@ -723,12 +785,26 @@ SSLNetVConnection::load_buffer_and_write(int64_t towrite, MIOBufferAccessor &buf
       sslTotalBytesSent = 0;
     }
     Debug("ssl", "now=%" PRId64 " lastwrite=%" PRId64 " msec_since_last_write=%d", now, sslLastWriteTime, msec_since_last_write);
+
+    // Size the records of this burst by the congestion window, or by the bytes sent since the last
+    // idle period if the window is not known.
+    dynamic_tls_record_size = tls_record_size_from_tcp_info();
+    if (dynamic_tls_record_size == 0) {
+      dynamic_tls_record_size =
+        sslTotalBytesSent < SSL_DEF_TLS_RECORD_BYTE_THRESHOLD ? SSL_DEF_TLS_RECORD_SIZE : SSL_MAX_TLS_RECORD_SIZE;
+    }
   }
 
   if (HttpProxyPort::TRANSPORT_BLIND_TUNNEL == this->attributes) {
     return this->super::load_buffer_and_write(towrite, buf, total_written, needs);
   }
 
+  // With kTLS the kernel frames and encrypts the records, so application data can go straight
+  // down the plain socket write path. A partial SSL_write still has to be finished by OpenSSL.
+  if (ktls_send && redoWriteSize == 0) {
+    return this->super::load_buffer_and_write(towrite, buf, total_written, needs);
+  }
+
   Debug("ssl", "towrite=%" PRId64, towrite);
 
   do {
@@ -756,11 +832,9 @@ SSLNetVConnection::load_buffer_and_write(int64_t towrite, MIOBufferAccessor &buf
       if (SSLConfigParams::ssl_maxrecord > 0 && l > SSLConfigParams::ssl_maxrecord) {
         l = SSLConfigParams::ssl_maxrecord;
       } else if (SSLConfigParams::ssl_maxrecord == -1) {
-        if (sslTotalBytesSent < SSL_DEF_TLS_RECORD_BYTE_THRESHOLD) {
-          dynamic_tls_record_size = SSL_DEF_TLS_RECORD_SIZE;
+        if (dynamic_tls_record_size < SSL_MAX_TLS_RECORD_SIZE) {
           SSL_INCREMENT_DYN_STAT(ssl_total_dyn_def_tls_record_count);
         } else {
-          dynamic_tls_record_size = SSL_MAX_TLS_RECORD_SIZE;
           SSL_INCREMENT_DYN_STAT(ssl_total_dyn_max_tls_record_count);
         }
         if (l > dynamic_tls_record_size) {
@@ -910,7 +984,16 @@ SSLNetVConnection::clear()
   sslLastWriteTime            = 0;
   sslTotalBytesSent           = 0;
   sslClientRenegotiationAbort = false;
+  ktls_send                   = false;
   sslSessionCacheHit          = false;
+  early_data_disabled         = false;
+  early_data_len              = 0;
+  early_data_finished         = false;
+  if (early_data_buf) {
+    free_MIOBuffer(early_data_buf);
+    early_data_buf    = nullptr;
+    early_data_reader = nullptr;
+  }
 
   curHook         = nullptr;
   hookOpRequested = SSL_HOOK_OP_DEFAULT;
@@ -919,6 +1002,11 @@ SSLNetVConnection::clear()
   free_handshake_buffers();
   sslTrace = false;
 
+  if (lazy_cert_waiting) {
+    lazyCertCache.cancel(this);
+    lazy_cert_waiting = false;
+  }
+
   super::clear();
 }
 void
@@ -1099,6 +1187,12 @@ SSLNetVConnection::sslStartHandShake(int event, int &err)
           SSL_INCREMENT_DYN_STAT(ssl_sni_name_set_failure);
         }
       }
+
+      if (!this->options.alpn_protos.empty() &&
+          SSL_set_alpn_protos(this->ssl, reinterpret_cast<const unsigned char *>(this->options.alpn_protos.data()),
+                              this->options.alpn_protos.size()) != 0) {
+        Debug("ssl.error", "failed to set ALPN protocols for client handshake");
+      }
     }
 
     return sslClientHandShakeEvent(err);
@@ -1109,6 +1203,74 @@ SSLNetVConnection::sslStartHandShake(int event, int &err)
   }
 }
 
+/** Read the TLS 1.3 early data of a resumed session.
+
+    The early data must be read before the handshake completes. It is kept in @c early_data_buf and
+    read from the connection first once the handshake is done, so it is only used for a client that
+    completed the handshake. Returns @c SSL_ERROR_NONE when all the early data was read or there is
+    none, then the handshake goes on with @c SSLAccept.
+ */
+int
+SSLNetVConnection::read_early_data()
+{
+#ifdef SSL_READ_EARLY_DATA_SUCCESS
+  if (SSLConfigParams::server_max_early_data <= 0 || early_data_finished) {
+    return SSL_ERROR_NONE;
+  }
+
+  char data[4096];
+  for (;;) {
+    size_t nread = 0;
+    ERR_clear_error();
+    int ret = SSL_read_early_data(ssl, data, sizeof(data), &nread);
+    if (ret == SSL_READ_EARLY_DATA_ERROR) {
+      return SSL_get_error(ssl, ret);
+    }
+    if (nread > 0) {
+      if (early_data_buf == nullptr) {
+        early_data_buf    = new_MIOBuffer(BUFFER_SIZE_INDEX_4K);
+        early_data_reader = early_data_buf->alloc_reader();
+      }
+      early_data_buf->write(data, nread);
+      early_data_len += nread;
+    }
+    if (ret == SSL_READ_EARLY_DATA_FINISH) {
+      break;
+    }
+  }
+
+  early_data_finished = true;
+  if (early_data_len > 0) {
+    Debug("ssl.early_data", "read %" PRId64 " bytes of early data", early_data_len);
+    SSL_INCREMENT_DYN_STAT(ssl_early_data_accepted);
+  }
+#endif
+  return SSL_ERROR_NONE;
+}
+
+int64_t
+SSLNetVConnection::take_early_data(MIOBuffer *buf, int64_t len)
+{
+  if (early_data_reader == nullptr) {
+    return 0;
+  }
+
+  // Copy the data, a block shared with the reader would leave no room to read into.
+  int64_t n = 0;
+  while (n < len && early_data_reader->is_read_avail_more_than(0)) {
+    int64_t avail = std::min(len - n, early_data_reader->block_read_avail());
+    buf->write(early_data_reader->start(), avail);
+    early_data_reader->consume(avail);
+    n += avail;
+  }
+  if (!early_data_reader->is_read_avail_more_than(0)) {
+    free_MIOBuffer(early_data_buf);
+    early_data_buf    = nullptr;
+    early_data_reader = nullptr;
+  }
+  return n;
+}
+
 int
 SSLNetVConnection::sslServerHandShakeEvent(int &err)
 {
@@ -1193,7 +1355,10 @@ SSLNetVConnection::sslServerHandShakeEvent(int &err)
     SSL_set_mode(ssl, SSL_MODE_ASYNC);
   }
 #endif
-  ssl_error_t ssl_error = SSLAccept(ssl);
+  ssl_error_t ssl_error = read_early_data();
+  if (ssl_error == SSL_ERROR_NONE) {
+    ssl_error = SSLAccept(ssl);
+  }
 #if TS_USE_TLS_ASYNC
   if (ssl_error == SSL_ERROR_WANT_ASYNC) {
     size_t numfds;
@@ -1255,6 +1420,14 @@ SSLNetVConnection::sslServerHandShakeEvent(int &err)
 
     sslHandshakeStatus = SSL_HANDSHAKE_DONE;
 
+#if TS_HAS_KTLS
+    if (SSLConfigParams::ssl_ktls_enabled && BIO_get_ktls_send(SSL_get_wbio(ssl))) {
+      Debug("ssl", "kTLS send offload enabled");
+      ktls_send = true;
+      SSL_INCREMENT_DYN_STAT(ssl_total_ktls_send_count);
+    }
+#endif
+
     if (sslHandshakeBeginTime) {
       sslHandshakeEndTime                 = Thread::get_hrtime();
       const ink_hrtime ssl_handshake_time = sslHandshakeEndTime - sslHandshakeBeginTime;
@@ -43,32 +43,71 @@ static ConfigUpdateHandler<SNIConfig> *sniConfigUpdate;
 struct NetAccept;
 std::unordered_map<int, SSLNextProtocolSet *> snpsMap;
 
-const NextHopProperty *
-SNIConfigParams::getPropertyConfig(const std::string &servername) const
+bool
+SNINameIndex::insert(const std::string &fqdn, int idx)
+{
+  std::string_view name = fqdn;
+  bool wild             = false;
+  if (name.size() > 2 && name[0] == '*' && name[1] == '.') {
+    name.remove_prefix(2);
+    wild = true;
+  }
+  if (name.find('*') != std::string_view::npos) {
+    regexed.push_back(idx);
+    return false;
+  }
+
+  // The earlier entry of a name wins, as it matched first in the list.
+  auto &map = wild ? wilddomains : hostnames;
+  if (map.find(name) == map.end()) {
+    map.emplace(names.emplace_back(name), idx);
+  }
+  return true;
+}
+
+int
+SNINameIndex::find_name(std::string_view servername) const
 {
-  const NextHopProperty *nps = nullptr;
-  for (auto &&item : next_hop_list) {
-    if (pcre_exec(item.match, nullptr, servername.c_str(), servername.length(), 0, 0, nullptr, 0) >= 0) {
-      // Found a match
-      nps = &item.prop;
-      break;
+  int found = -1;
+  if (auto spot = hostnames.find(servername); spot != hostnames.end()) {
+    found = spot->second;
+  }
+  // "*.domain" matches any name that ends in ".domain", however many labels are in front.
+  for (size_t dot = servername.find('.', 1); dot != std::string_view::npos; dot = servername.find('.', dot + 1)) {
+    if (auto spot = wilddomains.find(servername.substr(dot + 1)); spot != wilddomains.end()) {
+      if (found < 0 || spot->second < found) {
+        found = spot->second;
+      }
     }
   }
-  return nps;
+  return found;
+}
+
+const NextHopProperty *
+SNIConfigParams::getPropertyConfig(const std::string &servername) const
+{
+  int idx = sni_index.find(next_hop_list, servername);
+  return idx < 0 ? nullptr : &next_hop_list[idx].prop;
 }
 
 void
 SNIConfigParams::loadSNIConfig()
 {
   for (auto &item : Y_sni.items) {
-    auto ai = sni_action_list.emplace(sni_action_list.end());
-    ai->setGlobName(item.fqdn);
+    bool regexed = !sni_index.insert(item.fqdn, sni_action_list.size());
+    auto ai      = sni_action_list.emplace(sni_action_list.end());
+    if (regexed) {
+      ai->setGlobName(item.fqdn);
+    }
     Debug("ssl", "name: %s", item.fqdn.data());
 
     // set SNI based actions to be called in the ssl_servername_only callback
     if (item.disable_h2) {
       ai->actions.push_back(std::make_unique<DisableH2>());
     }
+    if (item.disable_early_data) {
+      ai->actions.push_back(std::make_unique<DisableEarlyData>());
+    }
     if (item.verify_client_level != 255) {
       ai->actions.push_back(std::make_unique<VerifyClient>(item.verify_client_level));
     }
@@ -78,6 +117,9 @@ SNIConfigParams::loadSNIConfig()
     if (item.tunnel_destination.length() > 0) {
       ai->actions.push_back(std::make_unique<TunnelDestination>(item.tunnel_destination, item.tunnel_decrypt));
     }
+    if (!item.tcp_congestion_control.empty() || item.tcp_pacing_rate > 0 || item.tcp_notsent_lowat > 0) {
+      ai->actions.push_back(std::make_unique<TcpPolicy>(item.tcp_congestion_control, item.tcp_pacing_rate, item.tcp_notsent_lowat));
+    }
 
     ai->actions.push_back(std::make_unique<SNI_IpAllow>(item.ip_allow, item.fqdn));
 
@@ -97,7 +139,9 @@ SNIConfigParams::loadSNIConfig()
                      params->clientCACertPath);
     }
 
-    nps->setGlobName(item.fqdn);
+    if (regexed) {
+      nps->setGlobName(item.fqdn);
+    }
     nps->prop.verifyServerPolicy     = item.verify_server_policy;
     nps->prop.verifyServerProperties = item.verify_server_properties;
   } // end for
@@ -110,14 +154,8 @@ SNIConfigParams::SNIConfigParams() {}
 const actionVector *
 SNIConfigParams::get(const std::string &servername) const
 {
-  for (const auto &retval : sni_action_list) {
-    if (retval.match == nullptr && servername.length() == 0) {
-      return &retval.actions;
-    } else if (pcre_exec(retval.match, nullptr, servername.c_str(), servername.length(), 0, 0, nullptr, 0) >= 0) {
-      return &retval.actions;
-    }
-  }
-  return nullptr;
+  int idx = sni_index.find(sni_action_list, servername);
+  return idx < 0 ? nullptr : &sni_action_list[idx].actions;
 }
 
 int
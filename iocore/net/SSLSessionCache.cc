@@ -22,8 +22,12 @@
 #include "P_SSLConfig.h"
 #include "SSLSessionCache.h"
 #include "SSLStats.h"
+#include "tscore/I_Layout.h"
 
 #include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 #define SSLSESSIONCACHE_STRINGIFY0(x) #x
 #define SSLSESSIONCACHE_STRINGIFY(x) SSLSESSIONCACHE_STRINGIFY0(x)
@@ -35,6 +39,26 @@
 #define PRINT_BUCKET(x)
 #endif
 
+SSLSessionCacheBackend *
+SSLSessionCacheBackend::create()
+{
+  int backend = 0;
+  ats_scoped_str shared_file;
+
+  REC_ReadConfigInteger(backend, "proxy.config.ssl.session_cache.backend");
+  REC_ReadConfigStringAlloc(shared_file, "proxy.config.ssl.session_cache.shared_file");
+
+  if (backend == 1) {
+    size_t n_sessions = SSLConfigParams::session_cache_number_buckets * SSLConfigParams::session_cache_max_bucket_size;
+    if (shared_file && *shared_file) {
+      std::string path = Layout::relative_to(RecConfigReadRuntimeDir(), shared_file.get());
+      return new SSLSessionSlotCache(n_sessions, path.c_str());
+    }
+    return new SSLSessionSlotCache(n_sessions, nullptr);
+  }
+  return new SSLSessionCache();
+}
+
 /* Session Cache */
 SSLSessionCache::SSLSessionCache() : nbuckets(SSLConfigParams::session_cache_number_buckets)
 {
@@ -302,3 +326,180 @@ SSLSessionBucket::removeSession(const SSLSessionID &id)
 SSLSessionBucket::SSLSessionBucket() : mutex(new_ProxyMutex()) {}
 
 SSLSessionBucket::~SSLSessionBucket() {}
+
+/* Slot Cache */
+namespace
+{
+constexpr uint32_t SLOT_CACHE_MAGIC   = 0x53534c43; // "SSLC"
+constexpr uint32_t SLOT_CACHE_VERSION = 1;
+} // namespace
+
+SSLSessionSlotCache::SSLSessionSlotCache(size_t n_sessions, const char *path)
+{
+  uint64_t n_sets = std::max<uint64_t>((n_sessions + WAYS - 1) / WAYS, 1);
+  _map_size       = sizeof(Header) + n_sets * WAYS * sizeof(Slot);
+
+  if (path) {
+    int fd = open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+    if (fd >= 0) {
+      struct stat st;
+      // A file of another size or layout is started over, the same geometry keeps its sessions.
+      if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) != _map_size) {
+        if (ftruncate(fd, 0) != 0 || ftruncate(fd, _map_size) != 0) {
+          Warning("failed to size the SSL session cache file %s: %s", path, strerror(errno));
+        }
+      }
+      _map = mmap(nullptr, _map_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+      close(fd);
+    }
+    if (fd < 0 || _map == MAP_FAILED) {
+      Warning("failed to map the SSL session cache file %s, the sessions are not shared: %s", path, strerror(errno));
+      _map = nullptr;
+    }
+  }
+  if (_map == nullptr) {
+    _map = mmap(nullptr, _map_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    ink_release_assert(_map != MAP_FAILED);
+    path = nullptr;
+  }
+
+  _header = static_cast<Header *>(_map);
+  _slots  = reinterpret_cast<Slot *>(_header + 1);
+  if (_header->magic != SLOT_CACHE_MAGIC || _header->version != SLOT_CACHE_VERSION || _header->n_sets != n_sets) {
+    memset(_map, 0, _map_size);
+    _header->n_sets  = n_sets;
+    _header->version = SLOT_CACHE_VERSION;
+    std::atomic_thread_fence(std::memory_order_release);
+    _header->magic = SLOT_CACHE_MAGIC;
+  }
+
+  Debug("ssl.session_cache", "Created new ssl session slot cache %p with %" PRIu64 " sets of %u slots in %s", this, n_sets, WAYS,
+        path ? path : "memory");
+}
+
+SSLSessionSlotCache::~SSLSessionSlotCache()
+{
+  munmap(_map, _map_size);
+}
+
+SSLSessionSlotCache::Slot *
+SSLSessionSlotCache::set_of(const SSLSessionID &sid) const
+{
+  return _slots + (sid.hash() % _header->n_sets) * WAYS;
+}
+
+uint32_t
+SSLSessionSlotCache::find(const SSLSessionID &sid, unsigned char *data) const
+{
+  Slot *set = this->set_of(sid);
+
+  for (unsigned i = 0; i < WAYS; ++i) {
+    Slot &slot   = set[i];
+    uint32_t seq = slot.seq.load(std::memory_order_acquire);
+    if ((seq & 1) || slot.id_len != sid.len || memcmp(slot.id, sid.bytes, sid.len) != 0) {
+      continue;
+    }
+    uint32_t len = std::min<uint32_t>(slot.data_len, SSL_MAX_SESSION_SIZE);
+    memcpy(data, slot.data, len);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (slot.seq.load(std::memory_order_relaxed) == seq) {
+      return len;
+    }
+    // Written while it was copied, it is not the session any more.
+  }
+  return 0;
+}
+
+bool
+SSLSessionSlotCache::getSession(const SSLSessionID &sid, SSL_SESSION **sess) const
+{
+  unsigned char data[SSL_MAX_SESSION_SIZE];
+  uint32_t len = this->find(sid, data);
+
+  if (len == 0) {
+    return false;
+  }
+  const unsigned char *loc = data;
+  *sess                    = d2i_SSL_SESSION(nullptr, &loc, len);
+  return *sess != nullptr;
+}
+
+int
+SSLSessionSlotCache::getSessionBuffer(const SSLSessionID &sid, char *buffer, int &len) const
+{
+  unsigned char data[SSL_MAX_SESSION_SIZE];
+  int true_len = this->find(sid, data);
+
+  if (true_len && buffer) {
+    if (true_len < len) {
+      len = true_len;
+    }
+    memcpy(buffer, data, len);
+  }
+  return true_len;
+}
+
+void
+SSLSessionSlotCache::insertSession(const SSLSessionID &sid, SSL_SESSION *sess)
+{
+  size_t len = i2d_SSL_SESSION(sess, nullptr);
+  if (len > SSL_MAX_SESSION_SIZE) {
+    Debug("ssl.session_cache", "Unable to save SSL session because size of %zd exceeds the max of %d", len, SSL_MAX_SESSION_SIZE);
+    return;
+  }
+
+  // Replace the session itself, else an empty slot, else the oldest.
+  Slot *set    = this->set_of(sid);
+  Slot *target = &set[0];
+  for (unsigned i = 0; i < WAYS; ++i) {
+    Slot &slot = set[i];
+    if (slot.id_len == sid.len && memcmp(slot.id, sid.bytes, sid.len) == 0) {
+      target = &slot;
+      break;
+    }
+    if (slot.id_len == 0 ? target->id_len != 0 : (target->id_len != 0 && slot.stamp < target->stamp)) {
+      target = &slot;
+    }
+  }
+
+  uint32_t seq = target->seq.load(std::memory_order_relaxed);
+  if ((seq & 1) || !target->seq.compare_exchange_strong(seq, seq + 1, std::memory_order_acquire)) {
+    // Another writer has the slot, this session is not cached rather than waiting.
+    if (ssl_rsb) {
+      SSL_INCREMENT_DYN_STAT(ssl_session_cache_lock_contention);
+    }
+    return;
+  }
+  std::atomic_thread_fence(std::memory_order_release);
+
+  unsigned char *loc = target->data;
+  target->data_len   = i2d_SSL_SESSION(sess, &loc);
+  target->id_len     = sid.len;
+  memcpy(target->id, sid.bytes, sid.len);
+  target->stamp = _header->stamp.fetch_add(1, std::memory_order_relaxed);
+
+  target->seq.store(seq + 2, std::memory_order_release);
+}
+
+void
+SSLSessionSlotCache::removeSession(const SSLSessionID &sid)
+{
+  Slot *set = this->set_of(sid);
+
+  if (ssl_rsb) {
+    SSL_INCREMENT_DYN_STAT(ssl_session_cache_eviction);
+  }
+  for (unsigned i = 0; i < WAYS; ++i) {
+    Slot &slot   = set[i];
+    uint32_t seq = slot.seq.load(std::memory_order_relaxed);
+    if ((seq & 1) || slot.id_len != sid.len || memcmp(slot.id, sid.bytes, sid.len) != 0) {
+      continue;
+    }
+    if (slot.seq.compare_exchange_strong(seq, seq + 1, std::memory_order_acquire)) {
+      std::atomic_thread_fence(std::memory_order_release);
+      slot.id_len   = 0;
+      slot.data_len = 0;
+      slot.seq.store(seq + 2, std::memory_order_release);
+    }
+  }
+}
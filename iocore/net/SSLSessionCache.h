@@ -29,6 +29,7 @@
 #include "P_SSLUtils.h"
 #include "ts/apidefs.h"
 #include <openssl/ssl.h>
+#include <atomic>
 
 #define SSL_MAX_SESSION_SIZE 256
 
@@ -143,15 +144,41 @@ private:
   CountQueue<SSLSession> queue;
 };
 
-class SSLSessionCache
+/** Where the sessions of the ATS session cache are kept.
+
+    The OpenSSL callbacks and the TS API session functions go through this, the implementation is
+    picked by @c proxy.config.ssl.session_cache.backend.
+ */
+class SSLSessionCacheBackend
 {
 public:
-  bool getSession(const SSLSessionID &sid, SSL_SESSION **sess) const;
-  int getSessionBuffer(const SSLSessionID &sid, char *buffer, int &len) const;
-  void insertSession(const SSLSessionID &sid, SSL_SESSION *sess);
-  void removeSession(const SSLSessionID &sid);
+  virtual ~SSLSessionCacheBackend() {}
+
+  /// Get a copy of the session @a sid. @return @c true if it was found, @a sess is set.
+  virtual bool getSession(const SSLSessionID &sid, SSL_SESSION **sess) const = 0;
+  /** Copy the ASN.1 encoding of the session @a sid to @a buffer, at most @a len bytes.
+      @return The full length of the encoding, or 0 if the session was not found.
+   */
+  virtual int getSessionBuffer(const SSLSessionID &sid, char *buffer, int &len) const = 0;
+  /// Keep the session @a sess under @a sid, it is copied.
+  virtual void insertSession(const SSLSessionID &sid, SSL_SESSION *sess) = 0;
+  /// Drop the session @a sid.
+  virtual void removeSession(const SSLSessionID &sid) = 0;
+
+  /// Create the backend of the configuration.
+  static SSLSessionCacheBackend *create();
+};
+
+/// The sessions in buckets of lists, each under a mutex.
+class SSLSessionCache : public SSLSessionCacheBackend
+{
+public:
+  bool getSession(const SSLSessionID &sid, SSL_SESSION **sess) const override;
+  int getSessionBuffer(const SSLSessionID &sid, char *buffer, int &len) const override;
+  void insertSession(const SSLSessionID &sid, SSL_SESSION *sess) override;
+  void removeSession(const SSLSessionID &sid) override;
   SSLSessionCache();
-  ~SSLSessionCache();
+  ~SSLSessionCache() override;
 
   SSLSessionCache(const SSLSessionCache &) = delete;
   SSLSessionCache &operator=(const SSLSessionCache &) = delete;
@@ -160,3 +187,62 @@ private:
   SSLSessionBucket *session_bucket = nullptr;
   size_t nbuckets;
 };
+
+/** The sessions in a table of fixed size slots, without locks.
+
+    The table is split in sets of @c WAYS slots, a session is kept in the set picked by its id. Each
+    slot has a sequence number that is odd while the slot is written, a writer takes the slot by
+    making it odd and skips the slot if another writer has it. Readers copy the slot and keep the copy
+    only if the sequence number has not changed, so neither ever waits.
+
+    The table is in memory of its own, or in @c proxy.config.ssl.session_cache.shared_file. The
+    file is mapped shared, so the processes of a host that map the same file share their sessions
+    and the sessions outlive a restart.
+ */
+class SSLSessionSlotCache : public SSLSessionCacheBackend
+{
+public:
+  static constexpr unsigned WAYS = 8;
+
+  /** Make a table of at least @a n_sessions slots.
+      @a path is the file to map, or @c nullptr for memory of its own.
+   */
+  SSLSessionSlotCache(size_t n_sessions, const char *path);
+  ~SSLSessionSlotCache() override;
+
+  SSLSessionSlotCache(const SSLSessionSlotCache &) = delete;
+  SSLSessionSlotCache &operator=(const SSLSessionSlotCache &) = delete;
+
+  bool getSession(const SSLSessionID &sid, SSL_SESSION **sess) const override;
+  int getSessionBuffer(const SSLSessionID &sid, char *buffer, int &len) const override;
+  void insertSession(const SSLSessionID &sid, SSL_SESSION *sess) override;
+  void removeSession(const SSLSessionID &sid) override;
+
+private:
+  struct Slot {
+    std::atomic<uint32_t> seq;
+    uint32_t stamp; ///< When the slot was written, the oldest slot of a set is replaced.
+    uint32_t id_len;
+    uint32_t data_len;
+    char id[TS_SSL_MAX_SSL_SESSION_ID_LENGTH];
+    unsigned char data[SSL_MAX_SESSION_SIZE];
+  };
+
+  struct Header {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t n_sets;
+    std::atomic<uint32_t> stamp;
+  };
+
+  static_assert(std::atomic<uint32_t>::is_always_lock_free, "the slots are shared between processes");
+
+  Slot *set_of(const SSLSessionID &sid) const;
+  /// Copy the session @a sid to @a data. @return The length of the session, or 0 if it was not found.
+  uint32_t find(const SSLSessionID &sid, unsigned char *data) const;
+
+  void *_map       = nullptr;
+  size_t _map_size = 0;
+  Header *_header  = nullptr;
+  Slot *_slots     = nullptr;
+};
@@ -67,7 +67,10 @@ ssl_callback_session_ticket(SSL *ssl, unsigned char *keyname, unsigned char *iv,
     cc = lookup->find(ip);
   }
   ssl_ticket_key_block *keyblock = nullptr;
-  if (cc == nullptr || cc->keyblock == nullptr) {
+  if (params->rotation_period >= 0) {
+    // The derived keys are the same on every node, they take the place of the keys of the contexts.
+    keyblock = params->default_global_keyblock;
+  } else if (cc == nullptr || cc->keyblock == nullptr) {
     // Try the default
     keyblock = params->default_global_keyblock;
   } else {
@@ -177,6 +177,16 @@ SSLInitializeStatistics()
   RecRegisterRawStat(ssl_rsb, RECT_PROCESS, "proxy.process.ssl.redo_record_size_count", RECD_COUNTER, RECP_PERSISTENT,
                      (int)ssl_total_dyn_redo_tls_record_count, RecRawStatSyncCount);
 
+  /* Track kernel TLS offload */
+  RecRegisterRawStat(ssl_rsb, RECT_PROCESS, "proxy.process.ssl.ktls_send_count", RECD_COUNTER, RECP_PERSISTENT,
+                     (int)ssl_total_ktls_send_count, RecRawStatSyncSum);
+
+  /* Track TLS 1.3 early data */
+  RecRegisterRawStat(ssl_rsb, RECT_PROCESS, "proxy.process.ssl.early_data_accepted", RECD_COUNTER, RECP_PERSISTENT,
+                     (int)ssl_early_data_accepted, RecRawStatSyncSum);
+  RecRegisterRawStat(ssl_rsb, RECT_PROCESS, "proxy.process.ssl.early_data_replays", RECD_COUNTER, RECP_PERSISTENT,
+                     (int)ssl_early_data_replays, RecRawStatSyncSum);
+
   /* error stats */
   RecRegisterRawStat(ssl_rsb, RECT_PROCESS, "proxy.process.ssl.ssl_error_want_write", RECD_COUNTER, RECP_PERSISTENT,
                      (int)ssl_error_want_write, RecRawStatSyncCount);
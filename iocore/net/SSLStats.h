@@ -78,6 +78,9 @@ enum SSL_Stats {
   ssl_total_dyn_def_tls_record_count,
   ssl_total_dyn_max_tls_record_count,
   ssl_total_dyn_redo_tls_record_count,
+  ssl_total_ktls_send_count,
+  ssl_early_data_accepted,
+  ssl_early_data_replays,
   ssl_session_cache_hit,
   ssl_session_cache_miss,
   ssl_session_cache_eviction,
@@ -27,6 +27,7 @@
 #include "tscore/I_Layout.h"
 #include "tscore/ink_cap.h"
 #include "tscore/ink_mutex.h"
+#include "tscore/KeyValueStore.h"
 #include "records/I_RecHttp.h"
 
 #include "P_Net.h"
@@ -39,11 +40,15 @@
 #include "SSLSessionTicket.h"
 #include "SSLDynlock.h"
 #include "SSLDiags.h"
+#include "SSLKeyOffload.h"
+#include "SSLLazyCert.h"
 #include "SSLStats.h"
 
+#include <map>
 #include <string>
 #include <unistd.h>
 #include <termios.h>
+#include <unordered_map>
 #include <vector>
 
 #include <openssl/asn1.h>
@@ -86,7 +91,7 @@ static constexpr char SSL_CERT_SEPARATE_DELIM = ',';
 #endif
 #endif
 
-SSLSessionCache *session_cache; // declared extern in P_SSLConfig.h
+SSLSessionCacheBackend *session_cache; // declared extern in P_SSLConfig.h
 
 #if TS_HAVE_OPENSSL_SESSION_TICKETS
 static int ssl_session_ticket_index = -1;
@@ -94,6 +99,9 @@ static int ssl_session_ticket_index = -1;
 
 static int ssl_vc_index = -1;
 
+// The memory for the client randoms of the handshakes with early data, about 128 bytes each.
+static constexpr size_t EARLY_DATA_REPLAY_MAX_BYTES = 16 * 1024 * 1024;
+
 static ink_mutex *mutex_buf      = nullptr;
 static bool open_ssl_initialized = false;
 
@@ -136,38 +144,180 @@ SSL_locking_callback(int mode, int type, const char *file, int line)
 }
 #endif
 
+// While ssl_multicert.config loads, the certificate files, CA stores and client CA lists it names
+// are read once and shared by all the contexts that use them, instead of each context parsing and
+// holding a copy of its own. The contexts keep their references, the cache is dropped after the load.
+namespace
+{
+struct SSLCertIntern {
+  ink_mutex mutex = PTHREAD_MUTEX_INITIALIZER;
+  int loads       = 0; ///< Loads in progress, nothing is cached without one.
+  std::unordered_map<std::string, std::vector<X509 *>> files;
+  std::map<std::pair<std::string, std::string>, X509_STORE *> stores;
+  std::unordered_map<std::string, STACK_OF(X509_NAME) *> client_ca_lists;
+  int hits = 0;
+
+  void
+  clear()
+  {
+    for (auto &[path, certs] : files) {
+      for (X509 *cert : certs) {
+        X509_free(cert);
+      }
+    }
+    for (auto &[paths, store] : stores) {
+      X509_STORE_free(store);
+    }
+    for (auto &[path, names] : client_ca_lists) {
+      sk_X509_NAME_pop_free(names, X509_NAME_free);
+    }
+    if (!files.empty() || hits > 0) {
+      Debug("ssl", "%zu certificate files, %zu CA stores and %zu client CA lists were shared %d times", files.size(), stores.size(),
+            client_ca_lists.size(), hits);
+    }
+    files.clear();
+    stores.clear();
+    client_ca_lists.clear();
+    hits = 0;
+  }
+};
+
+SSLCertIntern ssl_cert_intern;
+
+// Keeps what is read shared while it is in scope.
+struct SSLCertInternScope {
+  SSLCertInternScope()
+  {
+    ink_scoped_mutex_lock lock(ssl_cert_intern.mutex);
+    ++ssl_cert_intern.loads;
+  }
+  ~SSLCertInternScope()
+  {
+    ink_scoped_mutex_lock lock(ssl_cert_intern.mutex);
+    if (--ssl_cert_intern.loads == 0) {
+      ssl_cert_intern.clear();
+    }
+  }
+};
+} // namespace
+
+// Append the certificates in @a path to @a certs, each with a reference for the caller. Return
+// whether the file could be opened.
 static bool
-SSL_CTX_add_extra_chain_cert_bio(SSL_CTX *ctx, BIO *bio)
+ssl_read_cert_file(const char *path, std::vector<X509 *> &certs)
 {
-  X509 *cert;
+  ink_scoped_mutex_lock lock(ssl_cert_intern.mutex);
+  bool cache = ssl_cert_intern.loads > 0;
+  if (cache) {
+    if (auto spot = ssl_cert_intern.files.find(path); spot != ssl_cert_intern.files.end()) {
+      for (X509 *cert : spot->second) {
+        X509_up_ref(cert);
+        certs.push_back(cert);
+      }
+      ++ssl_cert_intern.hits;
+      return true;
+    }
+  }
 
-  for (;;) {
-    cert = PEM_read_bio_X509_AUX(bio, nullptr, nullptr, nullptr);
+  scoped_BIO bio(BIO_new_file(path, "r"));
+  if (!bio) {
+    return false;
+  }
+  std::vector<X509 *> read;
+  while (X509 *cert = PEM_read_bio_X509_AUX(bio.get(), nullptr, nullptr, nullptr)) {
+    read.push_back(cert);
+  }
+  // What is left on the error queue is the end of the file.
+  ERR_clear_error();
 
-    if (!cert) {
-      // No more the certificates in this file.
-      break;
+  for (X509 *cert : read) {
+    if (cache) {
+      X509_up_ref(cert);
     }
+    certs.push_back(cert);
+  }
+  if (cache) {
+    ssl_cert_intern.files.emplace(path, std::move(read));
+  }
+  return true;
+}
 
+// Add the certificates in @a first .. @a last to the chain of @a ctx, which takes the references.
+static bool
+SSL_CTX_add_extra_chain_certs(SSL_CTX *ctx, std::vector<X509 *>::iterator first, std::vector<X509 *>::iterator last)
+{
+  bool result = true;
+
+  for (; first != last; ++first) {
 // This transfers ownership of the cert (X509) to the SSL context, if successful.
 #ifdef SSL_CTX_add0_chain_cert
-    if (!SSL_CTX_add0_chain_cert(ctx, cert)) {
+    if (!result || !SSL_CTX_add0_chain_cert(ctx, *first)) {
 #else
-    if (!SSL_CTX_add_extra_chain_cert(ctx, cert)) {
+    if (!result || !SSL_CTX_add_extra_chain_cert(ctx, *first)) {
 #endif
-      X509_free(cert);
-      return false;
+      X509_free(*first);
+      result = false;
     }
   }
 
-  return true;
+  return result;
 }
 
 static bool
 SSL_CTX_add_extra_chain_cert_file(SSL_CTX *ctx, const char *chainfile)
 {
-  scoped_BIO bio(BIO_new_file(chainfile, "r"));
-  return SSL_CTX_add_extra_chain_cert_bio(ctx, bio);
+  std::vector<X509 *> certs;
+  ssl_read_cert_file(chainfile, certs);
+  return SSL_CTX_add_extra_chain_certs(ctx, certs.begin(), certs.end());
+}
+
+// Verify against the CA certificates of @a file and the hashed directory @a path. The contexts of
+// a load share one store for them, where the library has SSL_CTX_set1_cert_store().
+static bool
+ssl_context_load_verify_locations(SSL_CTX *ctx, const char *file, const char *path)
+{
+#if OPENSSL_VERSION_NUMBER >= 0x10101000L && !defined(LIBRESSL_VERSION_NUMBER)
+  ink_scoped_mutex_lock lock(ssl_cert_intern.mutex);
+  if (ssl_cert_intern.loads > 0) {
+    auto key  = std::make_pair(std::string(file ? file : ""), std::string(path ? path : ""));
+    auto spot = ssl_cert_intern.stores.find(key);
+    X509_STORE *store;
+    if (spot != ssl_cert_intern.stores.end()) {
+      store = spot->second;
+      ++ssl_cert_intern.hits;
+    } else {
+      store = X509_STORE_new();
+      if (!store || !X509_STORE_load_locations(store, file, path) || !X509_STORE_set_default_paths(store)) {
+        X509_STORE_free(store);
+        return false;
+      }
+      ssl_cert_intern.stores.emplace(std::move(key), store);
+    }
+    SSL_CTX_set1_cert_store(ctx, store);
+    return true;
+  }
+#endif
+  return SSL_CTX_load_verify_locations(ctx, file, path) && SSL_CTX_set_default_verify_paths(ctx);
+}
+
+// The names of the CA certificates in @a file, a copy owned by the caller.
+static STACK_OF(X509_NAME) * ssl_load_client_ca_list(const char *file)
+{
+  ink_scoped_mutex_lock lock(ssl_cert_intern.mutex);
+  if (ssl_cert_intern.loads == 0) {
+    return SSL_load_client_CA_file(file);
+  }
+  auto spot = ssl_cert_intern.client_ca_lists.find(file);
+  if (spot == ssl_cert_intern.client_ca_lists.end()) {
+    STACK_OF(X509_NAME) *names = SSL_load_client_CA_file(file);
+    if (names == nullptr) {
+      return nullptr;
+    }
+    spot = ssl_cert_intern.client_ca_lists.emplace(file, names).first;
+  } else {
+    ++ssl_cert_intern.hits;
+  }
+  return SSL_dup_CA_list(spot->second);
 }
 
 static bool
@@ -302,6 +452,11 @@ set_context_cert(SSL *ssl)
     cc = lookup->find(const_cast<char *>(servername));
     if (cc) {
       ctx = cc->getCtx();
+      // Pause until the context of a lazy entry is loaded, the callback is called again then.
+      if (ctx == nullptr && cc->userconfig && cc->userconfig->lazy && !lazyCertCache.get(cc->userconfig, netvc, ctx)) {
+        retval = -1;
+        goto done;
+      }
     }
     if (cc && ctx && SSLCertContextOption::OPT_TUNNEL == cc->opt && netvc->get_is_transparent()) {
       netvc->attributes = HttpProxyPort::TRANSPORT_BLIND_TUNNEL;
@@ -810,12 +965,14 @@ ssl_private_key_validate_exec(const char *cmdLine)
 void *
 ssl_malloc(size_t size, const char * /*filename */, int /*lineno*/)
 {
+  AtsMemTagScope mem_tag(ATS_MEM_TAG_SSL);
   return ats_malloc(size);
 }
 
 void *
 ssl_realloc(void *ptr, size_t size, const char * /*filename*/, int /*lineno*/)
 {
+  AtsMemTagScope mem_tag(ATS_MEM_TAG_SSL);
   return ats_realloc(ptr, size);
 }
 
@@ -828,12 +985,14 @@ ssl_free(void *ptr, const char * /*filename*/, int /*lineno*/)
 void *
 ssl_track_malloc(size_t size, const char * /*filename*/, int /*lineno*/)
 {
+  AtsMemTagScope mem_tag(ATS_MEM_TAG_SSL);
   return ats_track_malloc(size, &ssl_memory_allocated);
 }
 
 void *
 ssl_track_realloc(void *ptr, size_t size, const char * /*filename*/, int /*lineno*/)
 {
+  AtsMemTagScope mem_tag(ATS_MEM_TAG_SSL);
   return ats_track_realloc(ptr, size, &ssl_memory_allocated, &ssl_memory_freed);
 }
 
@@ -965,6 +1124,10 @@ SSLPrivateKeyHandler(SSL_CTX *ctx, const SSLConfigParams *params, const std::str
     return false;
   }
 
+  if (e == nullptr) {
+    SSLKeyOffloadAttach(ctx);
+  }
+
   return true;
 }
 
@@ -1096,6 +1259,33 @@ SSLMultiCertConfigLoader::index_certificate(SSLCertLookup *lookup, SSLCertContex
   return inserted;
 }
 
+#ifdef SSL_READ_EARLY_DATA_SUCCESS
+// Decide whether to accept the early data of a resumed TLS 1.3 session. A replayed ClientHello
+// carries the random of the original one, so the randoms are remembered for a while and the early
+// data of a repeat is rejected.
+static int
+ssl_allow_early_data_callback(SSL *ssl, void * /* arg ATS_UNUSED */)
+{
+  static ts::KeyValueStore seen_randoms(EARLY_DATA_REPLAY_MAX_BYTES);
+
+  SSLNetVConnection *netvc = SSLNetVCAccess(ssl);
+  if (netvc == nullptr || netvc->early_data_disabled) {
+    return 0;
+  }
+
+  unsigned char random[SSL3_RANDOM_SIZE];
+  size_t len = SSL_get_client_random(ssl, random, sizeof(random));
+  time_t now = ink_hrtime_to_sec(Thread::get_hrtime());
+  std::string_view key{reinterpret_cast<char *>(random), len};
+  if (!seen_randoms.add(key, std::string_view(), now + SSLConfigParams::server_early_data_replay_window, now)) {
+    Debug("ssl.early_data", "rejecting the early data of a replayed handshake");
+    SSL_INCREMENT_DYN_STAT(ssl_early_data_replays);
+    return 0;
+  }
+  return 1;
+}
+#endif
+
 // This callback function is executed while OpenSSL processes the SSL
 // handshake and does SSL record layer stuff.  It's used to trap
 // client-initiated renegotiations and update cipher stats
@@ -1290,8 +1480,7 @@ SSLMultiCertConfigLoader::init_server_ssl_ctx(std::vector<X509 *> &cert_list, co
     //       proxy.config.ssl.CA.cert.filename is nullptr)
     //   use the hashed symlinks in that directory to build the chain
     if (!sslMultCertSettings->ca && params->serverCACertPath != nullptr) {
-      if ((!SSL_CTX_load_verify_locations(ctx, params->serverCACertFilename, params->serverCACertPath)) ||
-          (!SSL_CTX_set_default_verify_paths(ctx))) {
+      if (!ssl_context_load_verify_locations(ctx, params->serverCACertFilename, params->serverCACertPath)) {
         SSLError("invalid CA Certificate file or CA Certificate path");
         goto fail;
       }
@@ -1308,8 +1497,7 @@ SSLMultiCertConfigLoader::init_server_ssl_ctx(std::vector<X509 *> &cert_list, co
 
   if (params->clientCertLevel != 0) {
     if (params->serverCACertFilename != nullptr && params->serverCACertPath != nullptr) {
-      if ((!SSL_CTX_load_verify_locations(ctx, params->serverCACertFilename, params->serverCACertPath)) ||
-          (!SSL_CTX_set_default_verify_paths(ctx))) {
+      if (!ssl_context_load_verify_locations(ctx, params->serverCACertFilename, params->serverCACertPath)) {
         SSLError("CA Certificate file or CA Certificate path invalid");
         goto fail;
       }
@@ -1372,6 +1560,14 @@ SSLMultiCertConfigLoader::init_server_ssl_ctx(std::vector<X509 *> &cert_list, co
   }
   SSL_CTX_set_info_callback(ctx, ssl_callback_info);
 
+#ifdef SSL_READ_EARLY_DATA_SUCCESS
+  if (SSLConfigParams::server_max_early_data > 0) {
+    SSL_CTX_set_max_early_data(ctx, SSLConfigParams::server_max_early_data);
+    SSL_CTX_set_recv_max_early_data(ctx, SSLConfigParams::server_max_early_data);
+    SSL_CTX_set_allow_early_data_cb(ctx, ssl_allow_early_data_callback, nullptr);
+  }
+#endif
+
   SSL_CTX_set_next_protos_advertised_cb(ctx, SSLNetVConnection::advertise_next_protocol, nullptr);
   SSL_CTX_set_alpn_select_cb(ctx, SSLNetVConnection::select_next_protocol, nullptr);
 
@@ -1422,6 +1618,32 @@ SSLCreateServerContext(const SSLConfigParams *params, const SSLMultiCertConfigPa
   return ctx.release();
 }
 
+SSLMultiCertConfigLoader::~SSLMultiCertConfigLoader()
+{
+  for (auto &[key, shared] : _shared_contexts) {
+    for (X509 *cert : shared.cert_list) {
+      X509_free(cert);
+    }
+  }
+}
+
+// The settings of a line that go into its SSL_CTX, lines with the same key get the same context.
+static std::string
+ssl_shared_context_key(const SSLMultiCertConfigParams *settings)
+{
+  std::string key;
+  for (const char *value : {settings->cert.get(), settings->key.get(), settings->ca.get(), settings->ocsp_response.get(),
+                            settings->dialog.get()}) {
+    // Tell an unset value from an empty one.
+    key += value ? value : "\x01";
+    key += '\0';
+  }
+  key += std::to_string(settings->session_ticket_enabled);
+  key += '\0';
+  key += std::to_string(static_cast<int>(settings->opt));
+  return key;
+}
+
 /**
    Insert SSLCertContext (SSL_CTX ans options) into SSLCertLookup with key.
    Do NOT call SSL_CTX_set_* functions from here. SSL_CTX should be set up by SSLMultiCertConfigLoader::init_server_ssl_ctx().
@@ -1432,26 +1654,53 @@ SSLMultiCertConfigLoader::_store_ssl_ctx(SSLCertLookup *lookup, const shared_SSL
   std::vector<X509 *> cert_list;
   shared_ssl_ticket_key_block keyblock = nullptr;
   bool inserted                        = false;
-  shared_SSL_CTX ctx(this->init_server_ssl_ctx(cert_list, sslMultCertSettings.get()), SSL_CTX_free);
+  shared_SSL_CTX ctx;
 
-  if (!ctx || !sslMultCertSettings) {
+  if (!sslMultCertSettings) {
     lookup->is_valid = false;
     return nullptr;
   }
 
+  // The default context gets the handshake callbacks, it is not shared with the other lines.
+  SharedContext *shared = nullptr;
+  std::string shared_key;
+  bool is_default = sslMultCertSettings->addr && strcmp(sslMultCertSettings->addr, "*") == 0;
+  if (!is_default && sslMultCertSettings->cert) {
+    shared_key = ssl_shared_context_key(sslMultCertSettings.get());
+    if (auto spot = _shared_contexts.find(shared_key); spot != _shared_contexts.end()) {
+      shared = &spot->second;
+    }
+  }
+
   const char *certname = sslMultCertSettings->cert.get();
-  for (auto cert : cert_list) {
-    if (0 > SSLMultiCertConfigLoader::check_server_cert_now(cert, certname)) {
-      /* At this point, we know cert is bad, and we've already printed a
-         descriptive reason as to why cert is bad to the log file */
-      Debug("ssl", "Marking certificate as NOT VALID: %s", certname);
+  if (shared) {
+    Debug("ssl", "sharing the context of an earlier line with the same settings for %s", certname);
+    ctx      = shared->ctx;
+    keyblock = shared->keyblock;
+    for (X509 *cert : shared->cert_list) {
+      X509_up_ref(cert);
+      cert_list.push_back(cert);
+    }
+  } else {
+    ctx = shared_SSL_CTX(this->init_server_ssl_ctx(cert_list, sslMultCertSettings.get()), SSL_CTX_free);
+    if (!ctx) {
       lookup->is_valid = false;
+      return nullptr;
     }
-  }
 
-  // Load the session ticket key if session tickets are not disabled
-  if (sslMultCertSettings->session_ticket_enabled != 0) {
-    keyblock = shared_ssl_ticket_key_block(ssl_context_enable_tickets(ctx.get(), nullptr), ticket_block_free);
+    for (auto cert : cert_list) {
+      if (0 > SSLMultiCertConfigLoader::check_server_cert_now(cert, certname)) {
+        /* At this point, we know cert is bad, and we've already printed a
+           descriptive reason as to why cert is bad to the log file */
+        Debug("ssl", "Marking certificate as NOT VALID: %s", certname);
+        lookup->is_valid = false;
+      }
+    }
+
+    // Load the session ticket key if session tickets are not disabled
+    if (sslMultCertSettings->session_ticket_enabled != 0) {
+      keyblock = shared_ssl_ticket_key_block(ssl_context_enable_tickets(ctx.get(), nullptr), ticket_block_free);
+    }
   }
 
   // Index this certificate by the specified IP(v6) address. If the address is "*", make it the default context.
@@ -1487,10 +1736,19 @@ SSLMultiCertConfigLoader::_store_ssl_ctx(SSLCertLookup *lookup, const shared_SSL
     }
   }
 
-  if (inserted) {
+  if (inserted && !shared) {
     if (SSLConfigParams::init_ssl_ctx_cb) {
       SSLConfigParams::init_ssl_ctx_cb(ctx.get(), true);
     }
+    if (!shared_key.empty()) {
+      auto &entry    = _shared_contexts[shared_key];
+      entry.ctx      = ctx;
+      entry.keyblock = keyblock;
+      for (X509 *cert : cert_list) {
+        X509_up_ref(cert);
+        entry.cert_list.push_back(cert);
+      }
+    }
   }
 
   if (!inserted) {
@@ -1504,6 +1762,70 @@ SSLMultiCertConfigLoader::_store_ssl_ctx(SSLCertLookup *lookup, const shared_SSL
   return ctx.get();
 }
 
+/**
+   Insert the names of the certificates of a lazy entry into SSLCertLookup, without a context.
+   Only the certificates are read, the keys and the chains are loaded with the context.
+ */
+bool
+SSLMultiCertConfigLoader::_index_lazy_certs(SSLCertLookup *lookup, const shared_SSLMultiCertConfigParams &sslMultCertSettings)
+{
+  SimpleTokenizer cert_tok((const char *)sslMultCertSettings->cert, SSL_CERT_SEPARATE_DELIM);
+  bool inserted = false;
+
+  sslMultCertSettings->lazy = true;
+  Debug("ssl", "importing SNI names from %s, the context is loaded on demand", (const char *)sslMultCertSettings->cert);
+  for (const char *certname = cert_tok.getNext(); certname; certname = cert_tok.getNext()) {
+    std::string completeServerCertPath = Layout::relative_to(this->_params->serverCertPathOnly, certname);
+    scoped_BIO bio(BIO_new_file(completeServerCertPath.c_str(), "r"));
+    X509 *cert = nullptr;
+    if (bio) {
+      cert = PEM_read_bio_X509(bio.get(), nullptr, nullptr, nullptr);
+    }
+    if (!cert) {
+      SSLError("failed to load certificate from %s", completeServerCertPath.c_str());
+      lookup->is_valid = false;
+      continue;
+    }
+    if (0 > SSLMultiCertConfigLoader::check_server_cert_now(cert, certname)) {
+      Debug("ssl", "Marking certificate as NOT VALID: %s", certname);
+      lookup->is_valid = false;
+    }
+    if (SSLConfigParams::load_ssl_file_cb) {
+      SSLConfigParams::load_ssl_file_cb(completeServerCertPath.c_str());
+    }
+    if (SSLMultiCertConfigLoader::index_certificate(lookup, SSLCertContext(nullptr, sslMultCertSettings, nullptr), cert,
+                                                    certname)) {
+      inserted = true;
+    }
+    X509_free(cert);
+  }
+
+  return inserted;
+}
+
+shared_SSL_CTX
+SSLMultiCertConfigLoader::build_lazy_ssl_ctx(const SSLMultiCertConfigParams *sslMultCertSettings)
+{
+  std::vector<X509 *> cert_list;
+  shared_SSL_CTX ctx(this->init_server_ssl_ctx(cert_list, sslMultCertSettings), SSL_CTX_free);
+
+  for (auto &i : cert_list) {
+    X509_free(i);
+  }
+  if (!ctx) {
+    return nullptr;
+  }
+
+  if (sslMultCertSettings->session_ticket_enabled != 0) {
+    ticket_block_free(ssl_context_enable_tickets(ctx.get(), nullptr));
+  }
+  if (SSLConfigParams::init_ssl_ctx_cb) {
+    SSLConfigParams::init_ssl_ctx_cb(ctx.get(), true);
+  }
+
+  return ctx;
+}
+
 static bool
 ssl_extract_certificate(const matcher_line *line_info, SSLMultiCertConfigParams *sslMultCertSettings)
 {
@@ -1601,6 +1923,13 @@ SSLMultiCertConfigLoader::load(SSLCertLookup *lookup)
   REC_ReadConfigInteger(elevate_setting, "proxy.config.ssl.cert.load_elevated");
   ElevateAccess elevate_access(elevate_setting ? ElevateAccess::FILE_PRIVILEGE : 0);
 
+  // Read each certificate file and CA store once for all the lines.
+  SSLCertInternScope intern_scope;
+
+  // Entries matched by name only can have their contexts built on first use.
+  int lazy_load = 0;
+  REC_ReadConfigInteger(lazy_load, "proxy.config.ssl.server.cert.lazy_load");
+
   line = tokLine(file_buf, &tok_state);
   while (line != nullptr) {
     line_num++;
@@ -1622,7 +1951,10 @@ SSLMultiCertConfigLoader::load(SSLCertLookup *lookup)
       } else {
         if (ssl_extract_certificate(&line_info, sslMultiCertSettings.get())) {
           // There must be a certificate specified unless the tunnel action is set
-          if (sslMultiCertSettings->cert || sslMultiCertSettings->opt != SSLCertContextOption::OPT_TUNNEL) {
+          if (lazy_load && sslMultiCertSettings->cert && !sslMultiCertSettings->addr &&
+              sslMultiCertSettings->opt == SSLCertContextOption::OPT_NONE) {
+            this->_index_lazy_certs(lookup, sslMultiCertSettings);
+          } else if (sslMultiCertSettings->cert || sslMultiCertSettings->opt != SSLCertContextOption::OPT_TUNNEL) {
             this->_store_ssl_ctx(lookup, sslMultiCertSettings);
           } else {
             Warning("No ssl_cert_name specified and no tunnel action set");
@@ -1818,23 +2150,22 @@ SSLMultiCertConfigLoader::load_certs(SSL_CTX *ctx, std::vector<X509 *> &cert_lis
 
   for (const char *certname = cert_tok.getNext(); certname; certname = cert_tok.getNext()) {
     std::string completeServerCertPath = Layout::relative_to(params->serverCertPathOnly, certname);
-    scoped_BIO bio(BIO_new_file(completeServerCertPath.c_str(), "r"));
-    X509 *cert = nullptr;
-    if (bio) {
-      cert = PEM_read_bio_X509(bio.get(), nullptr, nullptr, nullptr);
-    }
-    if (!bio || !cert) {
+    std::vector<X509 *> certs;
+    if (!ssl_read_cert_file(completeServerCertPath.c_str(), certs) || certs.empty()) {
       SSLError("failed to load certificate chain from %s", completeServerCertPath.c_str());
       return false;
     }
+    X509 *cert = certs.front();
     if (!SSL_CTX_use_certificate(ctx, cert)) {
       SSLError("Failed to assign cert from %s to SSL_CTX", completeServerCertPath.c_str());
-      X509_free(cert);
+      for (X509 *c : certs) {
+        X509_free(c);
+      }
       return false;
     }
 
     // Load up any additional chain certificates
-    SSL_CTX_add_extra_chain_cert_bio(ctx, bio);
+    SSL_CTX_add_extra_chain_certs(ctx, certs.begin() + 1, certs.end());
 
     const char *keyPath = key_tok.getNext();
     if (!SSLPrivateKeyHandler(ctx, params, completeServerCertPath, keyPath)) {
@@ -1913,7 +2244,7 @@ SSLMultiCertConfigLoader::set_session_id_context(SSL_CTX *ctx, const SSLConfigPa
 
   // Set the list of CA's to send to client if we ask for a client certificate
   if (params->serverCACertFilename) {
-    ca_list = SSL_load_client_CA_file(params->serverCACertFilename);
+    ca_list = ssl_load_client_ca_list(params->serverCACertFilename);
     if (ca_list) {
       SSL_CTX_set_client_CA_list(ctx, ca_list);
     }
@@ -33,6 +33,10 @@ int fds_throttle;
 int fds_limit = 8000;
 ink_hrtime last_transient_accept_error;
 
+#if TS_USE_LINUX_IO_URING
+static constexpr unsigned MAX_URING_POLL_ENTRIES = 4096;
+#endif
+
 NetHandler::Config NetHandler::global_config;
 std::bitset<std::numeric_limits<unsigned int>::digits> NetHandler::active_thread_types;
 const std::bitset<NetHandler::CONFIG_ITEM_COUNT> NetHandler::config_value_affects_per_thread_value{0x3};
@@ -41,7 +45,7 @@ extern "C" void fd_reify(struct ev_loop *);
 
 // INKqa10496
 // One Inactivity cop runs on each thread once every second and
-// loops through the list of NetVCs and calls the timeouts
+// calls the timeouts of the NetVCs that come due in the cop wheel
 class InactivityCop : public Continuation
 {
 public:
@@ -54,13 +58,16 @@ public:
     NetHandler &nh = *get_NetHandler(this_ethread());
 
     Debug("inactivity_cop_check", "Checking inactivity on Thread-ID #%d", this_ethread()->id);
-    // The rest NetVCs in cop_list which are not triggered between InactivityCop runs.
-    // Use pop() to catch any closes caused by callbacks.
-    while (UnixNetVConnection *vc = nh.cop_list.pop()) {
+    // NetVCs are filed by the inactivity timeout they had when last checked, activity since then
+    // only moves the timeout out so those are simply filed again.
+    nh.cop_wheel.advance(now);
+    while (UnixNetVConnection *vc = nh.cop_wheel.pop_ready()) {
+      vc->next_cop_check_at = 0;
       // If we cannot get the lock don't stop just keep cleaning
       MUTEX_TRY_LOCK(lock, vc->mutex, this_ethread());
       if (!lock.is_locked()) {
         NET_INCREMENT_DYN_STAT(inactivity_cop_lock_acquire_failure_stat);
+        nh.cop_schedule(vc, 0);
         continue;
       }
 
@@ -78,21 +85,13 @@ public:
         }
         Debug("inactivity_cop_verbose", "vc: %p now: %" PRId64 " timeout at: %" PRId64 " timeout in: %" PRId64, vc,
               ink_hrtime_to_sec(now), vc->next_inactivity_timeout_at, vc->inactivity_timeout_in);
+        // File it before the handler gets a chance to free it, in case the timeout is not reset.
+        nh.cop_schedule(vc, 0);
         vc->handleEvent(EVENT_IMMEDIATE, e);
+      } else {
+        nh.cop_schedule(vc, vc->next_inactivity_timeout_at);
       }
     }
-    // The cop_list is empty now.
-    // Let's reload the cop_list from open_list again.
-    forl_LL(UnixNetVConnection, vc, nh.open_list)
-    {
-      if (vc->thread == this_ethread()) {
-        nh.cop_list.push(vc);
-      }
-    }
-    // NetHandler will remove NetVC from cop_list if it is triggered.
-    // As the NetHandler runs, the number of NetVCs in the cop_list is decreasing.
-    // NetHandler runs 100 times maximum between InactivityCop runs.
-    // Therefore we don't have to check all the NetVCs as much as open_list.
 
     // Cleanup the active and keep-alive queues periodically
     nh.manage_active_queue(true); // close any connections over the active timeout
@@ -102,6 +101,86 @@ public:
   }
 };
 
+// Once a second, checks how long the net threads spend in their longest loop. When that lag, or
+// the memory use, gets over the limit new work is shed until the lag is back under the low mark.
+// When the busiest thread lags far behind the least busy one, it hands idle sessions over to it.
+class OverloadMonitor : public Continuation
+{
+public:
+  OverloadMonitor() : Continuation(new_ProxyMutex()) { SET_HANDLER(&OverloadMonitor::check_overload); }
+
+  int
+  check_overload(int /* event */, Event * /* e */)
+  {
+    auto &group        = eventProcessor.thread_group[ET_NET];
+    ink_hrtime ms      = 0;
+    int n              = 0;
+    EThread *hot       = nullptr; // The busiest thread and the least busy one.
+    EThread *cool      = nullptr;
+    ink_hrtime hot_ms  = 0;
+    ink_hrtime cool_ms = 0;
+
+    // The longest loop of each thread in the last full second, the current one is still filling.
+    for (int i = 0; i < group._count; ++i) {
+      EThread *t                   = group._thread[i];
+      EThread::EventMetrics *prior = t->prev(t->current_metric);
+      get_NetHandler(t)->rebalance_to.store(nullptr, std::memory_order_relaxed);
+      if (prior->_loop_time._start != 0) {
+        ink_hrtime t_ms = ink_hrtime_to_msec(prior->_loop_time._max);
+        if (hot == nullptr || t_ms > hot_ms) {
+          hot    = t;
+          hot_ms = t_ms;
+        }
+        if (cool == nullptr || t_ms < cool_ms) {
+          cool    = t;
+          cool_ms = t_ms;
+        }
+        ms += t_ms;
+        ++n;
+      }
+    }
+    if (net_rebalance_lag_diff > 0 && hot != cool && hot_ms - cool_ms >= net_rebalance_lag_diff) {
+      NetHandler *nh = get_NetHandler(hot);
+      nh->rebalance_budget.store(net_rebalance_max_sessions, std::memory_order_relaxed);
+      nh->rebalance_to.store(cool, std::memory_order_relaxed);
+      Debug("iocore_net", "net thread %p lags %" PRId64 " ms, %p %" PRId64 " ms, moving idle sessions", hot, hot_ms, cool,
+            cool_ms);
+    }
+    int lag  = n > 0 ? ms / n : 0;
+    int high = net_overload_lag_high;
+    int low  = net_overload_lag_low > 0 ? net_overload_lag_low : high / 2;
+
+    bool overloaded;
+    if (net_memory_throttle) {
+      overloaded = true;
+    } else if (high <= 0) {
+      overloaded = false;
+    } else {
+      overloaded = net_overloaded ? lag >= low : lag >= high;
+    }
+
+    if (overloaded != net_overloaded) {
+      net_overloaded = overloaded;
+      if (overloaded) {
+        Warning("overloaded, net thread loop lag %d ms%s, shedding new connections", lag,
+                net_memory_throttle ? " and memory over its limit" : "");
+      } else {
+        Note("no longer overloaded, net thread loop lag %d ms", lag);
+      }
+    }
+    RecSetGlobalRawStatSum(net_rsb, net_overloaded_stat, overloaded);
+    RecSetGlobalRawStatSum(net_rsb, net_overload_loop_lag_stat, lag);
+
+    return EVENT_CONT;
+  }
+};
+
+void
+start_overload_monitor()
+{
+  eventProcessor.schedule_every(new OverloadMonitor, HRTIME_SECOND, ET_TASK);
+}
+
 PollCont::PollCont(Ptr<ProxyMutex> &m, int pt)
   : Continuation(m.get()), net_handler(nullptr), nextPollDescriptor(nullptr), poll_timeout(pt)
 {
@@ -124,6 +203,162 @@ PollCont::~PollCont()
   }
 }
 
+#if TS_USE_LINUX_IO_URING
+// Token layout: generation in the high 32 bits, slot index in the low 32 bits. Generations are
+// never 0 so a live token is never 0, which is the user data of the poll remove requests.
+PollDescriptor::~PollDescriptor()
+{
+  if (uring) {
+    io_uring_queue_exit(uring);
+    delete uring;
+  }
+}
+
+bool
+PollDescriptor::enable_io_uring(EThread *owner, unsigned entries)
+{
+  io_uring *ring = new io_uring;
+  int ret        = io_uring_queue_init(entries, ring, 0);
+  if (ret < 0) {
+    Warning("io_uring_queue_init(%u) failed, staying with epoll: %s (%d)", entries, strerror(-ret), -ret);
+    delete ring;
+    return false;
+  }
+  uring       = ring;
+  uring_owner = owner;
+  return true;
+}
+
+PollDescriptor::UringSlot *
+PollDescriptor::uring_slot(uint64_t token)
+{
+  uint32_t idx = static_cast<uint32_t>(token);
+  if (token == 0 || idx >= uring_slots.size()) {
+    return nullptr;
+  }
+  UringSlot *slot = &uring_slots[idx];
+  return (slot->data != nullptr && slot->gen == static_cast<uint32_t>(token >> 32)) ? slot : nullptr;
+}
+
+io_uring_sqe *
+PollDescriptor::uring_sqe()
+{
+  io_uring_sqe *sqe = io_uring_get_sqe(uring);
+  if (sqe == nullptr) {
+    // The submission queue is full, flush it without waiting and try again.
+    io_uring_submit(uring);
+    sqe = io_uring_get_sqe(uring);
+  }
+  return sqe;
+}
+
+void
+PollDescriptor::uring_arm(uint64_t token, const UringSlot &slot)
+{
+  io_uring_sqe *sqe = uring_sqe();
+  if (sqe != nullptr) {
+    // Multishot poll fires on every wake up of the socket, which matches the edge triggered epoll use.
+    io_uring_prep_poll_multishot(sqe, slot.fd, slot.events & ~EPOLLET);
+    io_uring_sqe_set_data64(sqe, token);
+  } else {
+    Warning("io_uring submission queue full, fd %d not armed", slot.fd);
+  }
+}
+
+uint64_t
+PollDescriptor::uring_add(int fd, int events, void *data)
+{
+  uint32_t idx;
+  if (uring_free.empty()) {
+    idx = uring_slots.size();
+    uring_slots.emplace_back();
+  } else {
+    idx = uring_free.back();
+    uring_free.pop_back();
+  }
+
+  UringSlot &slot = uring_slots[idx];
+  if (++slot.gen == 0) {
+    slot.gen = 1;
+  }
+  slot.data      = data;
+  slot.fd        = fd;
+  slot.events    = events;
+  uint64_t token = (static_cast<uint64_t>(slot.gen) << 32) | idx;
+
+  uring_arm(token, slot);
+  return token;
+}
+
+void
+PollDescriptor::uring_remove(uint64_t token)
+{
+  if (this_ethread() != uring_owner) {
+    // The ring is single threaded, let the owner retire the registration on its next poll.
+    std::lock_guard<std::mutex> lock(uring_pending_mutex);
+    uring_pending_remove.push_back(token);
+    return;
+  }
+
+  UringSlot *slot = uring_slot(token);
+  if (slot == nullptr) {
+    return;
+  }
+  slot->data = nullptr;
+  uring_free.push_back(static_cast<uint32_t>(token));
+
+  io_uring_sqe *sqe = uring_sqe();
+  if (sqe != nullptr) {
+    io_uring_prep_poll_remove(sqe, token);
+    io_uring_sqe_set_data64(sqe, 0);
+  }
+}
+
+int
+PollDescriptor::uring_wait(int timeout_msec)
+{
+  {
+    std::lock_guard<std::mutex> lock(uring_pending_mutex);
+    // uring_remove() does not re-enter the lock on the owner thread.
+    for (uint64_t token : uring_pending_remove) {
+      uring_remove(token);
+    }
+    uring_pending_remove.clear();
+  }
+
+  io_uring_cqe *cqe = nullptr;
+  __kernel_timespec ts;
+  ts.tv_sec  = timeout_msec / 1000;
+  ts.tv_nsec = (timeout_msec % 1000) * 1000000LL;
+  // Registrations and removals queued since the last poll go out with the wait, in one system call.
+  io_uring_submit_and_wait_timeout(uring, &cqe, 1, timeout_msec < 0 ? nullptr : &ts, nullptr);
+
+  int n = 0;
+  io_uring_cqe *cqes[256];
+  unsigned count;
+  while (n < POLL_DESCRIPTOR_SIZE && (count = io_uring_peek_batch_cqe(uring, cqes, countof(cqes))) > 0) {
+    for (unsigned i = 0; i < count; ++i) {
+      uint64_t token  = io_uring_cqe_get_data64(cqes[i]);
+      UringSlot *slot = uring_slot(token);
+      if (slot == nullptr) {
+        continue; // a stopped registration, or a poll remove completion
+      }
+      if (cqes[i]->res > 0 && n < POLL_DESCRIPTOR_SIZE) {
+        ePoll_Triggered_Events[n].events   = cqes[i]->res;
+        ePoll_Triggered_Events[n].data.ptr = slot->data;
+        ++n;
+      }
+      if (!(cqes[i]->flags & IORING_CQE_F_MORE)) {
+        // The kernel ended the multishot poll (e.g. CQ overflow), re-arm it while the registration is live.
+        uring_arm(token, *slot);
+      }
+    }
+    io_uring_cq_advance(uring, count);
+  }
+  return n;
+}
+#endif
+
 //
 // PollCont continuation which does the epoll_wait
 // and stores the resultant events in ePoll_Triggered_Events
@@ -154,6 +389,13 @@ PollCont::do_poll(ink_hrtime timeout)
   }
 // wait for fd's to trigger, or don't wait if timeout is 0
 #if TS_USE_EPOLL
+#if TS_USE_LINUX_IO_URING
+  if (pollDescriptor->uring) {
+    pollDescriptor->result = pollDescriptor->uring_wait(poll_timeout);
+    NetDebug("iocore_net_poll", "[PollCont::pollEvent] io_uring, timeout: %d, results: %d", poll_timeout, pollDescriptor->result);
+    return;
+  }
+#endif
   pollDescriptor->result =
     epoll_wait(pollDescriptor->epoll_fd, pollDescriptor->ePoll_Triggered_Events, POLL_DESCRIPTOR_SIZE, poll_timeout);
   NetDebug("iocore_net_poll", "[PollCont::pollEvent] epoll_fd: %d, timeout: %d, results: %d", pollDescriptor->epoll_fd,
@@ -224,6 +466,11 @@ initialize_thread_for_net(EThread *thread)
 
   PollCont *pc       = get_PollCont(thread);
   PollDescriptor *pd = pc->pollDescriptor;
+#if TS_USE_LINUX_IO_URING
+  if (net_io_uring_poll) {
+    pd->enable_io_uring(thread, MAX_URING_POLL_ENTRIES);
+  }
+#endif
 
   InactivityCop *inactivityCop = new InactivityCop(get_NetHandler(thread)->mutex);
   int cop_freq                 = 1;
@@ -231,8 +478,15 @@ initialize_thread_for_net(EThread *thread)
   REC_ReadConfigInteger(cop_freq, "proxy.config.net.inactivity_check_frequency");
   memcpy(&nh->config, &NetHandler::global_config, sizeof(NetHandler::global_config));
   nh->configure_per_thread_values();
+  nh->cop_interval = HRTIME_SECONDS(cop_freq);
   thread->schedule_every(inactivityCop, HRTIME_SECONDS(cop_freq));
 
+  static std::atomic<int> busy_poll_threads{0};
+  if (thread->is_event_type(ET_NET) && net_busy_poll_idle_us > 0 && busy_poll_threads++ < net_busy_poll_threads) {
+    nh->busy_poll_idle = HRTIME_USECONDS(net_busy_poll_idle_us);
+    Debug("iocore_net", "thread %p busy polls for %d us after its last activity", thread, net_busy_poll_idle_us);
+  }
+
   thread->set_tail_handler(nh);
   thread->ep = (EventIO *)ats_malloc(sizeof(EventIO));
   new (thread->ep) EventIO();
@@ -375,6 +629,12 @@ NetHandler::process_enabled_list()
       write_ready_list.in_or_enqueue(vc);
     }
   }
+
+  SList(UnixNetVConnection, cop_enable_link) cq(cop_enable_list.popall());
+  while ((vc = cq.pop())) {
+    vc->in_cop_enable_list = 0;
+    cop_update(vc);
+  }
 }
 
 //
@@ -474,8 +734,21 @@ NetHandler::waitForActivity(ink_hrtime timeout)
   process_enabled_list();
 
   // Polling event by PollCont
-  PollCont *p = get_PollCont(this->thread);
+  LatencyHistogram *phases = this->thread->phase_histograms;
+  ink_hrtime poll_start    = Thread::get_hrtime_updated();
+  PollCont *p              = get_PollCont(this->thread);
+  // A busy polling thread does not sleep until it has had nothing to do for busy_poll_idle, so it sees new events and
+  // signals from the other threads without a wakeup.
+  bool had_work = timeout == 0;
+  if (busy_poll_idle && poll_start < busy_poll_until) {
+    timeout = 0;
+  }
   p->do_poll(timeout);
+  ink_hrtime poll_finish = Thread::get_hrtime_updated();
+  this->thread->current_metric->_idle += poll_finish - poll_start;
+  if (busy_poll_idle && (had_work || get_PollDescriptor(this->thread)->result > 0)) {
+    busy_poll_until = poll_finish + busy_poll_idle;
+  }
 
   // Get & Process polling result
   PollDescriptor *pd     = get_PollDescriptor(this->thread);
@@ -484,9 +757,9 @@ NetHandler::waitForActivity(ink_hrtime timeout)
     epd = (EventIO *)get_ev_data(pd, x);
     if (epd->type == EVENTIO_READWRITE_VC) {
       vc = epd->data.vc;
-      // Remove triggered NetVC from cop_list because it won't be timeout before next InactivityCop runs.
-      if (cop_list.in(vc)) {
-        cop_list.remove(vc);
+      // Zero copy completions arrive on the socket error queue and are reported as EPOLLERR.
+      if ((get_ev_events(pd, x) & EVENTIO_ERROR) && vc->zerocopy) {
+        vc->zerocopy_reap();
       }
       if (get_ev_events(pd, x) & (EVENTIO_READ | EVENTIO_ERROR)) {
         vc->read.triggered = 1;
@@ -528,6 +801,11 @@ NetHandler::waitForActivity(ink_hrtime timeout)
 
   process_ready_list();
 
+  if (phases) {
+    phases[EThread::LOOP_PHASE_POLL].record(poll_finish - poll_start);
+    phases[EThread::LOOP_PHASE_PROCESS].record(Thread::get_hrtime_updated() - poll_finish);
+  }
+
   return EVENT_CONT;
 }
 
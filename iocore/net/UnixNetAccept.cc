@@ -25,6 +25,13 @@
 
 #include "P_Net.h"
 
+#if defined(SO_ATTACH_REUSEPORT_CBPF) || defined(SO_ATTACH_FILTER)
+#include <linux/filter.h>
+#endif
+#if defined(SO_MEMINFO)
+#include <linux/sock_diag.h>
+#endif
+
 #ifdef ROUNDUP
 #undef ROUNDUP
 #endif
@@ -200,13 +207,175 @@ NetAccept::init_accept(EThread *t)
   t->schedule_every(this, period);
 }
 
+#if defined(SO_ATTACH_REUSEPORT_CBPF)
+//
+// Steer each connection to the listen socket of the thread with the same index as the CPU that
+// received it. The kernel uses the program result as an index into the reuseport group, in which
+// sockets appear in listen order: first the original NetAccept, which serves the last thread, then
+// the clones for threads 0 .. n-2. (cpu + 1) % n therefore selects the socket of thread cpu % n.
+//
+static int
+attach_reuseport_cpu_steering(int fd, int n)
+{
+  struct sock_filter code[] = {
+    {BPF_LD | BPF_W | BPF_ABS, 0, 0, static_cast<uint32_t>(SKF_AD_OFF + SKF_AD_CPU)},
+    {BPF_ALU | BPF_ADD | BPF_K, 0, 0, 1},
+    {BPF_ALU | BPF_MOD | BPF_K, 0, 0, static_cast<uint32_t>(n)},
+    {BPF_RET | BPF_A, 0, 0, 0},
+  };
+  struct sock_fprog prog = {static_cast<unsigned short>(countof(code)), code};
+
+  return safe_setsockopt(fd, SOL_SOCKET, SO_ATTACH_REUSEPORT_CBPF, reinterpret_cast<char *>(&prog), sizeof(prog));
+}
+#endif
+
+//
+// The deny filter drops the packets of the sources ip_allow denies on the listen sockets, so the
+// kernel neither answers their SYN nor queues their connections for accept. It is a classic BPF
+// socket filter, a chain of range checks on the IPv4 source address. IPv6 packets are passed to
+// the accept check, IPv4 clients of IPv6 sockets are filtered as well. Connections accepted from
+// a listen socket inherit its filter.
+//
+static ink_mutex deny_filter_lock = PTHREAD_MUTEX_INITIALIZER;
+static std::vector<int> deny_filter_fds; // Listen sockets with the filter.
+#if defined(SO_ATTACH_FILTER)
+static std::vector<sock_filter> deny_filter; // Empty if no source is denied.
+
+static int
+apply_deny_filter(int fd)
+{
+  if (deny_filter.empty()) {
+    // ENOENT if the socket has no filter yet.
+    int res = safe_setsockopt(fd, SOL_SOCKET, SO_DETACH_FILTER, SOCKOPT_ON, sizeof(int));
+    return (res < 0 && errno == ENOENT) ? 0 : res;
+  }
+  struct sock_fprog prog = {static_cast<unsigned short>(deny_filter.size()), deny_filter.data()};
+  return safe_setsockopt(fd, SOL_SOCKET, SO_ATTACH_FILTER, reinterpret_cast<char *>(&prog), sizeof(prog));
+}
+#endif
+
+void
+ink_net_set_deny_filter(std::vector<std::pair<uint32_t, uint32_t>> const &ranges)
+{
+#if defined(SO_ATTACH_FILTER)
+  // Five instructions to check the version and load the address, three per range and the final accept.
+  size_t n = std::min(ranges.size(), static_cast<size_t>((BPF_MAXINSNS - 6) / 3));
+  if (n < ranges.size()) {
+    Warning("%zu denied IPv4 ranges, only the first %zu are dropped by the listen sockets, the rest at accept", ranges.size(), n);
+  }
+
+  std::vector<sock_filter> code;
+  if (n > 0) {
+    code.push_back({BPF_LD | BPF_B | BPF_ABS, 0, 0, static_cast<uint32_t>(SKF_NET_OFF)});
+    code.push_back({BPF_ALU | BPF_RSH | BPF_K, 0, 0, 4});
+    code.push_back({BPF_JMP | BPF_JEQ | BPF_K, 1, 0, 4});
+    code.push_back({BPF_RET | BPF_K, 0, 0, 0xffffffff});
+    code.push_back({BPF_LD | BPF_W | BPF_ABS, 0, 0, static_cast<uint32_t>(SKF_NET_OFF + 12)});
+    for (size_t i = 0; i < n; ++i) {
+      // Below or above the range on to the next one, in it drop the packet.
+      code.push_back({BPF_JMP | BPF_JGE | BPF_K, 0, 2, ranges[i].first});
+      code.push_back({BPF_JMP | BPF_JGT | BPF_K, 1, 0, ranges[i].second});
+      code.push_back({BPF_RET | BPF_K, 0, 0, 0});
+    }
+    code.push_back({BPF_RET | BPF_K, 0, 0, 0xffffffff});
+  }
+
+  ink_scoped_mutex_lock lock(deny_filter_lock);
+  deny_filter.swap(code);
+  for (int fd : deny_filter_fds) {
+    if (apply_deny_filter(fd) < 0) {
+      Warning("unable to update the deny filter of listen socket %d: %s", fd, strerror(errno));
+    }
+  }
+  Debug("iocore_net_accept", "deny filter of %zu IPv4 ranges on %zu listen sockets", n, deny_filter_fds.size());
+#else
+  if (!ranges.empty()) {
+    Debug("iocore_net_accept", "no socket filters, the %zu denied IPv4 ranges are checked at accept", ranges.size());
+  }
+#endif
+}
+
+void
+attach_deny_filter(int fd)
+{
+  ink_scoped_mutex_lock lock(deny_filter_lock);
+#if defined(SO_ATTACH_FILTER)
+  if (apply_deny_filter(fd) < 0) {
+    Warning("unable to attach the deny filter to listen socket %d: %s", fd, strerror(errno));
+    return;
+  }
+#endif
+  if (std::find(deny_filter_fds.begin(), deny_filter_fds.end(), fd) == deny_filter_fds.end()) {
+    deny_filter_fds.push_back(fd);
+  }
+}
+
+void
+detach_deny_filter(int fd)
+{
+  ink_scoped_mutex_lock lock(deny_filter_lock);
+  deny_filter_fds.erase(std::remove(deny_filter_fds.begin(), deny_filter_fds.end(), fd), deny_filter_fds.end());
+}
+
+int
+net_listen_drops_sync(const char *, RecDataT, RecData *, RecRawStatBlock *rsb, int id)
+{
+  int64_t drops = 0;
+#if defined(SO_MEMINFO)
+  {
+    ink_scoped_mutex_lock lock(deny_filter_lock);
+    for (int fd : deny_filter_fds) {
+      uint32_t meminfo[SK_MEMINFO_VARS];
+      socklen_t len = sizeof(meminfo);
+      if (getsockopt(fd, SOL_SOCKET, SO_MEMINFO, meminfo, &len) == 0 && len > SK_MEMINFO_DROPS * sizeof(uint32_t)) {
+        drops += meminfo[SK_MEMINFO_DROPS];
+      }
+    }
+  }
+#endif
+
+  ink_mutex_acquire(&(rsb->mutex));
+  rsb->global[id]->sum   = drops;
+  rsb->global[id]->count = 1;
+  RecRawStatUpdateSum(rsb, id);
+  ink_mutex_release(&(rsb->mutex));
+  return REC_ERR_OKAY;
+}
+
+//
+// Give this (cloned) NetAccept a listen socket of its own in the SO_REUSEPORT group of the
+// original. If that fails, e.g. because the original socket was bound by traffic_manager without
+// SO_REUSEPORT, this keeps accepting on the shared socket.
+//
+bool
+NetAccept::listen_reuseport()
+{
+  int shared_fd = server.fd;
+
+  server.fd = NO_FD;
+  if (server.listen(NON_BLOCKING, opt) == 0) {
+    Debug("iocore_net_accept_start", "SO_REUSEPORT listen socket %d for port %d", server.fd,
+          ats_ip_port_host_order(&server.accept_addr));
+    return true;
+  }
+  server.fd = shared_fd;
+  return false;
+}
+
 void
 NetAccept::init_accept_per_thread()
 {
   int i, n;
+  int reuseport = 0;
 
   ink_assert(opt.etype >= 0);
 
+  n = eventProcessor.thread_group[opt.etype]._count;
+#ifdef SO_REUSEPORT
+  REC_ReadConfigInteger(reuseport, "proxy.config.net.accept_reuseport");
+  opt.f_reuseport = reuseport > 0 && n > 1;
+#endif
+
   if (do_listen(NON_BLOCKING)) {
     return;
   }
@@ -218,13 +387,17 @@ NetAccept::init_accept_per_thread()
   }
 
   period = -HRTIME_MSECONDS(net_accept_period);
-  n      = eventProcessor.thread_group[opt.etype]._count;
 
+  int n_shared = 0;
   for (i = 0; i < n; i++) {
     NetAccept *a       = (i < n - 1) ? clone() : this;
     EThread *t         = eventProcessor.thread_group[opt.etype]._thread[i];
     PollDescriptor *pd = get_PollDescriptor(t);
 
+    if (a != this && opt.f_reuseport && !a->listen_reuseport()) {
+      ++n_shared;
+    }
+
     if (a->ep.start(pd, a, EVENTIO_READ) < 0) {
       Warning("[NetAccept::init_accept_per_thread]:error starting EventIO");
     }
@@ -232,6 +405,19 @@ NetAccept::init_accept_per_thread()
     a->mutex = get_NetHandler(t)->mutex;
     t->schedule_every(a, period);
   }
+
+  if (opt.f_reuseport) {
+    if (n_shared > 0) {
+      Warning("port %d: %d of %d threads could not get a SO_REUSEPORT socket and share the original listen socket",
+              ats_ip_port_host_order(&server.accept_addr), n_shared, n);
+    }
+#if defined(SO_ATTACH_REUSEPORT_CBPF)
+    if (reuseport > 1 && n_shared == 0 && attach_reuseport_cpu_steering(server.fd, n) < 0) {
+      Warning("port %d: unable to attach the SO_REUSEPORT CPU steering program: %s", ats_ip_port_host_order(&server.accept_addr),
+              strerror(errno));
+    }
+#endif
+  }
 }
 
 void
@@ -240,6 +426,9 @@ NetAccept::stop_accept()
   if (!action_->cancelled) {
     action_->cancel();
   }
+  if (opt.f_deny_filter) {
+    detach_deny_filter(server.fd);
+  }
   server.close();
 }
 
@@ -299,6 +488,11 @@ NetAccept::do_blocking_accept(EThread *t)
       NET_SUM_DYN_STAT(net_connections_throttled_in_stat, 1);
       continue;
     }
+    if (!opt.backdoor && !check_net_client_rate(&con.addr.sa)) {
+      con.close();
+      NET_SUM_DYN_STAT(net_connections_rate_limited_in_stat, 1);
+      continue;
+    }
 
     if (TSSystemState::is_event_system_shut_down()) {
       return -1;
@@ -458,6 +652,11 @@ NetAccept::acceptFastEvent(int event, void *ep)
       }
       goto Lerror;
     }
+    if (!opt.backdoor && !check_net_client_rate(&con.addr.sa)) {
+      con.close();
+      NET_SUM_DYN_STAT(net_connections_rate_limited_in_stat, 1);
+      continue;
+    }
 
     vc = (UnixNetVConnection *)this->getNetProcessor()->allocate_vc(e->ethread);
     if (!vc) {
@@ -53,6 +53,8 @@ NetProcessor::AcceptOptions::reset()
   f_inbound_transparent = false;
   f_mptcp               = false;
   f_proxy_protocol      = false;
+  f_reuseport           = false;
+  f_deny_filter         = false;
   return *this;
 }
 
@@ -27,6 +27,15 @@
 #include "Log.h"
 
 #include <termios.h>
+#include <deque>
+#include <vector>
+
+#if defined(SO_ZEROCOPY) && defined(MSG_ZEROCOPY)
+#include <linux/errqueue.h>
+#define TS_HAS_ZEROCOPY 1
+#else
+#define TS_HAS_ZEROCOPY 0
+#endif
 
 #define STATE_VIO_OFFSET ((uintptr_t) & ((NetState *)0)->vio)
 #define STATE_FROM_VIO(_x) ((NetState *)(((char *)(_x)) - STATE_VIO_OFFSET))
@@ -34,6 +43,42 @@
 // Global
 ClassAllocator<UnixNetVConnection> netVCAllocator("netVCAllocator");
 
+// Cap on outstanding zero copy sends per connection, past this we copy until the kernel catches up.
+static constexpr size_t ZEROCOPY_MAX_PENDING = 64;
+// How long the blocks of a closed connection stay pinned, the kernel may still be transmitting from them.
+static constexpr ink_hrtime ZEROCOPY_LINGER = HRTIME_SECONDS(30);
+
+struct NetZeroCopyState {
+  struct Send {
+    uint32_t id = 0;
+    bool done   = false;
+    std::vector<Ptr<IOBufferBlock>> blocks;
+  };
+
+  std::deque<Send> pending;
+  uint32_t next_id = 0;    // the kernel numbers zero copy sends per socket, starting at 0
+  bool enabled     = false; // SO_ZEROCOPY is set on the socket
+  bool disabled    = false; // the socket refused SO_ZEROCOPY or the kernel had to copy
+};
+
+// Holds on to the pinned blocks of a closed connection until the kernel is surely done with them.
+struct NetZeroCopyLinger : public Continuation {
+  NetZeroCopyState *state;
+
+  explicit NetZeroCopyLinger(NetZeroCopyState *s) : Continuation(new_ProxyMutex()), state(s)
+  {
+    SET_HANDLER(&NetZeroCopyLinger::mainEvent);
+  }
+
+  int
+  mainEvent(int /* event */, Event * /* e */)
+  {
+    delete state;
+    delete this;
+    return EVENT_DONE;
+  }
+};
+
 //
 // Reschedule a UnixNetVConnection by moving it
 // onto or off of the ready_list
@@ -661,6 +706,9 @@ UnixNetVConnection::do_io_close(int alerrno /* = -1 */)
     } else {
       free(t);
     }
+  } else {
+    // Have InactivityCop free it soon rather than when its inactivity timeout comes up.
+    update_cop();
   }
 }
 
@@ -898,44 +946,32 @@ UnixNetVConnection::net_read_io(NetHandler *nh, EThread *lthread)
 int64_t
 UnixNetVConnection::load_buffer_and_write(int64_t towrite, MIOBufferAccessor &buf, int64_t &total_written, int &needs)
 {
-  int64_t r                  = 0;
-  int64_t try_to_write       = 0;
-  IOBufferReader *tmp_reader = buf.reader()->clone();
+  int64_t r              = 0;
+  int64_t try_to_write   = 0;
+  IOBufferReader *reader = buf.reader();
+
+  if (zerocopy) {
+    zerocopy_reap();
+  }
 
   do {
     IOVec tiovec[NET_MAX_IOV];
-    unsigned niov = 0;
-    try_to_write  = 0;
-
-    while (niov < NET_MAX_IOV) {
-      int64_t wavail = towrite - total_written;
-      int64_t len    = tmp_reader->block_read_avail();
-
-      // Check if we have done this block.
-      if (len <= 0) {
-        break;
-      }
-
-      // Check if the amount to write exceeds that in this buffer.
-      if (len > wavail) {
-        len = wavail;
-      }
-
-      if (len == 0) {
-        break;
-      }
-
-      // build an iov entry
-      tiovec[niov].iov_len  = len;
-      tiovec[niov].iov_base = tmp_reader->start();
-      niov++;
-
-      try_to_write += len;
-      tmp_reader->consume(len);
+    int niov = NET_MAX_IOV;
+
+    // Large writes from plain TCP connections may go out with MSG_ZEROCOPY, in which case the
+    // blocks backing the iovecs have to stay alive until the kernel reports the send complete.
+    std::vector<Ptr<IOBufferBlock>> pinned;
+    bool use_zerocopy = net_zerocopy_min_write > 0 && this->con.is_connected &&
+                        towrite - total_written >= net_zerocopy_min_write && zerocopy_enable();
+
+    // Nothing is consumed until it is written, so the iovecs can point straight into the reader.
+    try_to_write = reader->get_iovec(tiovec, &niov, towrite - total_written);
+    if (use_zerocopy) {
+      // A block holds on to the rest of the chain.
+      pinned.push_back(reader->block);
     }
 
     ink_assert(niov > 0);
-    ink_assert(niov <= countof(tiovec));
 
     // If the platform doesn't support TCP Fast Open, verify that we
     // correctly disabled support in the socket option configuration.
@@ -962,6 +998,28 @@ UnixNetVConnection::load_buffer_and_write(int64_t towrite, MIOBufferAccessor &bu
         this->con.is_connected = true;
       }
 
+    } else if (use_zerocopy) {
+      struct msghdr msg;
+
+      ink_zero(msg);
+      msg.msg_iov    = &tiovec[0];
+      msg.msg_iovlen = niov;
+
+      r = socketManager.sendmsg(con.fd, &msg, MSG_ZEROCOPY);
+      if (r > 0) {
+        NetZeroCopyState::Send send;
+        send.id     = zerocopy->next_id++;
+        send.blocks = std::move(pinned);
+        zerocopy->pending.push_back(std::move(send));
+        NET_INCREMENT_DYN_STAT(net_zerocopy_writes_stat);
+      } else if (r == -ENOBUFS) {
+        // Out of optmem for the notifications, copy this one instead.
+        r = socketManager.writev(con.fd, &tiovec[0], niov);
+      } else if (r == -EOPNOTSUPP || r == -EINVAL) {
+        // Some socket types, e.g. kTLS, refuse MSG_ZEROCOPY even with SO_ZEROCOPY set.
+        zerocopy->disabled = true;
+        r                  = socketManager.writev(con.fd, &tiovec[0], niov);
+      }
     } else {
       r = socketManager.writev(con.fd, &tiovec[0], niov);
     }
@@ -975,13 +1033,93 @@ UnixNetVConnection::load_buffer_and_write(int64_t towrite, MIOBufferAccessor &bu
     NET_INCREMENT_DYN_STAT(net_calls_to_write_stat);
   } while (r == try_to_write && total_written < towrite);
 
-  tmp_reader->dealloc();
-
   needs |= EVENTIO_WRITE;
 
   return r;
 }
 
+// Switch the socket to SO_ZEROCOPY on first use, returns whether the next send may use MSG_ZEROCOPY.
+bool
+UnixNetVConnection::zerocopy_enable()
+{
+#if TS_HAS_ZEROCOPY
+  if (zerocopy == nullptr) {
+    zerocopy = new NetZeroCopyState;
+  }
+  if (zerocopy->disabled) {
+    return false;
+  }
+  if (!zerocopy->enabled) {
+    int one = 1;
+    if (safe_setsockopt(con.fd, SOL_SOCKET, SO_ZEROCOPY, reinterpret_cast<char *>(&one), sizeof(one)) < 0) {
+      Debug("iocore_net", "SO_ZEROCOPY not available on fd %d: %s", con.fd, strerror(errno));
+      zerocopy->disabled = true;
+      return false;
+    }
+    zerocopy->enabled = true;
+  }
+  return !zerocopy->disabled && zerocopy->pending.size() < ZEROCOPY_MAX_PENDING;
+#else
+  return false;
+#endif
+}
+
+// Drain the zero copy completion notifications from the socket error queue and release the
+// blocks of every send the kernel is done with.
+void
+UnixNetVConnection::zerocopy_reap()
+{
+#if TS_HAS_ZEROCOPY
+  if (zerocopy == nullptr || zerocopy->pending.empty() || con.fd == NO_FD) {
+    return;
+  }
+
+  for (;;) {
+    char control[CMSG_SPACE(sizeof(struct sock_extended_err)) + CMSG_SPACE(sizeof(struct sockaddr_in6))];
+    struct msghdr msg;
+
+    ink_zero(msg);
+    msg.msg_control    = control;
+    msg.msg_controllen = sizeof(control);
+
+    if (recvmsg(con.fd, &msg, MSG_ERRQUEUE | MSG_DONTWAIT) < 0) {
+      break;
+    }
+
+    for (struct cmsghdr *cm = CMSG_FIRSTHDR(&msg); cm != nullptr; cm = CMSG_NXTHDR(&msg, cm)) {
+      if (!((cm->cmsg_level == SOL_IP && cm->cmsg_type == IP_RECVERR) ||
+            (cm->cmsg_level == SOL_IPV6 && cm->cmsg_type == IPV6_RECVERR))) {
+        continue;
+      }
+
+      const struct sock_extended_err *serr = reinterpret_cast<const struct sock_extended_err *>(CMSG_DATA(cm));
+      if (serr->ee_errno != 0 || serr->ee_origin != SO_EE_ORIGIN_ZEROCOPY) {
+        continue;
+      }
+
+      if (serr->ee_code & SO_EE_CODE_ZEROCOPY_COPIED) {
+        // The device could not transmit from our pages, so zero copy only costs us here.
+        NET_SUM_GLOBAL_DYN_STAT(net_zerocopy_copied_stat, 1);
+        zerocopy->disabled = true;
+      }
+
+      // Notifications cover the inclusive range [ee_info, ee_data] and may arrive out of order.
+      uint32_t lo = serr->ee_info;
+      uint32_t hi = serr->ee_data;
+      for (auto &send : zerocopy->pending) {
+        if (send.id - lo <= hi - lo) {
+          send.done = true;
+        }
+      }
+    }
+  }
+
+  while (!zerocopy->pending.empty() && zerocopy->pending.front().done) {
+    zerocopy->pending.pop_front();
+  }
+#endif
+}
+
 void
 UnixNetVConnection::readDisable(NetHandler *nh)
 {
@@ -1304,13 +1442,15 @@ UnixNetVConnection::clear()
   read.vio.vc_server  = nullptr;
   write.vio.vc_server = nullptr;
   options.reset();
-  closed        = 0;
-  netvc_context = NET_VCONNECTION_UNSET;
+  closed         = 0;
+  netvc_context  = NET_VCONNECTION_UNSET;
+  tcp_policy_ccp = false;
   ink_assert(!read.ready_link.prev && !read.ready_link.next);
   ink_assert(!read.enable_link.next);
   ink_assert(!write.ready_link.prev && !write.ready_link.next);
   ink_assert(!write.enable_link.next);
   ink_assert(!link.next && !link.prev);
+  ink_assert(!cop_enable_link.next && !next_cop_check_at);
 }
 
 void
@@ -1324,6 +1464,15 @@ UnixNetVConnection::free(EThread *t)
   if (con.fd != NO_FD) {
     NET_SUM_GLOBAL_DYN_STAT(net_connections_currently_open_stat, -1);
   }
+  if (zerocopy) {
+    zerocopy_reap();
+    if (zerocopy->pending.empty()) {
+      delete zerocopy;
+    } else {
+      t->schedule_in(new NetZeroCopyLinger(zerocopy), ZEROCOPY_LINGER);
+    }
+    zerocopy = nullptr;
+  }
   con.close();
 
   clear();
@@ -1354,6 +1503,21 @@ UnixNetVConnection::set_inactivity_timeout(ink_hrtime timeout_in)
   }
   inactivity_timeout_in      = timeout_in;
   next_inactivity_timeout_at = Thread::get_hrtime() + inactivity_timeout_in;
+  update_cop();
+}
+
+void
+UnixNetVConnection::update_cop()
+{
+  if (!nh) {
+    return;
+  }
+  if (nh->mutex->thread_holding == this_ethread()) {
+    nh->cop_update(this);
+  } else if (!ink_atomic_swap(&in_cop_enable_list, 1)) {
+    // Let the NetHandler do it, like read and write enabling from other threads.
+    nh->cop_enable_list.push(this);
+  }
 }
 
 /*
@@ -1374,17 +1538,7 @@ UnixNetVConnection::migrateToCurrentThread(Continuation *cont, EThread *t)
   // It is safe and no performance issue to get the mutex lock for a NetHandler of current ethread.
   SCOPED_MUTEX_LOCK(lock, client_nh->mutex, t);
 
-  // Try to get the mutex lock for NetHandler of this NetVC
-  MUTEX_TRY_LOCK(lock_src, this->nh->mutex, t);
-  if (lock_src.is_locked()) {
-    // Detach this NetVC from original NetHandler & InactivityCop.
-    this->nh->stopCop(this);
-    this->nh->stopIO(this);
-    // Put this NetVC into current NetHandler & InactivityCop.
-    this->thread = t;
-    client_nh->startIO(this);
-    client_nh->startCop(this);
-    // Move this NetVC to current EThread Successfully.
+  if (moveToCurrentThread(t)) {
     return this;
   }
 
@@ -1437,6 +1591,46 @@ UnixNetVConnection::migrateToCurrentThread(Continuation *cont, EThread *t)
   return ret_vc;
 }
 
+bool
+UnixNetVConnection::moveToCurrentThread(EThread *t)
+{
+  NetHandler *client_nh = get_NetHandler(t);
+  if (this->nh == client_nh) {
+    return true;
+  }
+
+  SCOPED_MUTEX_LOCK(lock, client_nh->mutex, t);
+
+  // Try to get the mutex lock for NetHandler of this NetVC
+  MUTEX_TRY_LOCK(lock_src, this->nh->mutex, t);
+  if (!lock_src.is_locked()) {
+    return false;
+  }
+
+  bool keep_alive = this->nh->keep_alive_queue.in(this);
+  // Detach this NetVC from original NetHandler & InactivityCop.
+  this->nh->stopCop(this);
+  this->nh->stopIO(this);
+  // Put this NetVC into current NetHandler & InactivityCop.
+  this->thread = t;
+  client_nh->startIO(this);
+  client_nh->startCop(this);
+  if (keep_alive) {
+    client_nh->add_to_keep_alive_queue(this);
+  }
+  return true;
+}
+
+EThread *
+UnixNetVConnection::rebalance_target()
+{
+  EThread *t = this->nh ? this->nh->rebalance_to.load(std::memory_order_relaxed) : nullptr;
+  if (t == nullptr || t == this->thread || this->nh->rebalance_budget.fetch_sub(1, std::memory_order_relaxed) <= 0) {
+    return nullptr;
+  }
+  return t;
+}
+
 void
 UnixNetVConnection::add_to_keep_alive_queue()
 {
@@ -1520,6 +1714,9 @@ UnixNetVConnection::set_tcp_congestion_control(int side)
 #ifdef TCP_CONGESTION
   std::string_view ccp;
 
+  if (tcp_policy_ccp) {
+    return 0;
+  }
   if (side == CLIENT_SIDE) {
     ccp = net_ccp_in;
   } else {
@@ -1543,3 +1740,47 @@ UnixNetVConnection::set_tcp_congestion_control(int side)
   return -1;
 #endif
 }
+
+void
+UnixNetVConnection::set_tcp_policy(std::string_view ccp, int64_t pacing_rate, int notsent_lowat)
+{
+  // These come from sni.yaml and remap rules, so failures are only debugged rather than logged
+  // for every connection.
+  if (!ccp.empty()) {
+#ifdef TCP_CONGESTION
+    if (setsockopt(con.fd, IPPROTO_TCP, TCP_CONGESTION, ccp.data(), ccp.size()) < 0) {
+      Debug("socket", "Unable to set TCP congestion control on socket %d to \"%.*s\", errno=%d (%s)", con.fd,
+            static_cast<int>(ccp.size()), ccp.data(), errno, strerror(errno));
+    } else {
+      tcp_policy_ccp = true;
+    }
+#else
+    Debug("socket", "Setting TCP congestion control is not supported on this platform.");
+#endif
+  }
+
+  if (pacing_rate > 0) {
+#ifdef SO_MAX_PACING_RATE
+    // Older kernels take a 32 bit rate, larger rates are capped.
+    unsigned int rate = std::min<int64_t>(pacing_rate, UINT_MAX);
+    if (setsockopt(con.fd, SOL_SOCKET, SO_MAX_PACING_RATE, &rate, sizeof(rate)) < 0) {
+      Debug("socket", "Unable to set the pacing rate of socket %d to %u, errno=%d (%s)", con.fd, rate, errno, strerror(errno));
+    }
+#else
+    Debug("socket", "Setting the pacing rate is not supported on this platform.");
+#endif
+  }
+
+  if (notsent_lowat > 0) {
+#ifdef TCP_NOTSENT_LOWAT
+    if (setsockopt(con.fd, IPPROTO_TCP, TCP_NOTSENT_LOWAT, &notsent_lowat, sizeof(notsent_lowat)) < 0) {
+      Debug("socket", "Unable to set the unsent low water mark of socket %d to %d, errno=%d (%s)", con.fd, notsent_lowat, errno,
+            strerror(errno));
+    }
+#else
+    Debug("socket", "Setting the unsent low water mark is not supported on this platform.");
+#endif
+  }
+  Debug("socket", "TCP policy of socket %d: ccp=\"%.*s\" pacing_rate=%" PRId64 " notsent_lowat=%d", con.fd,
+        static_cast<int>(ccp.size()), ccp.data(), pacing_rate, notsent_lowat);
+}
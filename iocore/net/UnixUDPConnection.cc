@@ -131,7 +131,12 @@ UDPConnection::send(Continuation *c, UDPPacket *xp)
   ink_assert(conn->continuation != nullptr);
   mutex               = c->mutex;
   p->reqGenerationNum = conn->sendGenerationNum;
-  get_UDPNetHandler(conn->ethread)->udpOutQueue.send(p);
+
+  // Wake the UDP thread when the queue was empty, it may be waiting in poll.
+  UDPNetHandler *nh = get_UDPNetHandler(conn->ethread);
+  if (nh->udpOutQueue.send(p) && conn->ethread != this_ethread()) {
+    nh->signalActivity();
+  }
   return ACTION_RESULT_NONE;
 }
 
@@ -37,6 +37,8 @@
 #include "P_Net.h"
 #include "P_UDPNet.h"
 
+#include <netinet/udp.h>
+
 using UDPNetContHandler = int (UDPNetHandler::*)(int, void *);
 
 inkcoreapi ClassAllocator<UDPPacketInternal> udpPacketAllocator("udpPacketAllocator");
@@ -52,6 +54,7 @@ UDPNetProcessor &udpNet = udpNetInternal;
 int32_t g_udp_periodicCleanupSlots;
 int32_t g_udp_periodicFreeCancelledPkts;
 int32_t g_udp_numSendRetries;
+int32_t g_udp_enableGSO;
 
 //
 // Public functions
@@ -91,6 +94,9 @@ initialize_thread_for_udp_net(EThread *thread)
   REC_ReadConfigInt32(g_udp_numSendRetries, "proxy.config.udp.send_retries");
   g_udp_numSendRetries = g_udp_numSendRetries < 0 ? 0 : g_udp_numSendRetries;
 
+  // Send the datagrams queued for one address together, segmented by the kernel (UDP GSO).
+  REC_ReadConfigInt32(g_udp_enableGSO, "proxy.config.udp.enable_gso");
+
   thread->set_tail_handler(nh);
   thread->ep = (EventIO *)ats_malloc(sizeof(EventIO));
   new (thread->ep) EventIO();
@@ -119,133 +125,177 @@ UDPNetProcessorInternal::start(int n_upd_threads, size_t stacksize)
   return 0;
 }
 
-void
-UDPNetProcessorInternal::udp_read_from_net(UDPNetHandler *nh, UDPConnection *xuc)
-{
-  UnixUDPConnection *uc = (UnixUDPConnection *)xuc;
+#if HAVE_RECVMMSG && HAVE_SENDMMSG
+using udp_mmsghdr = struct mmsghdr;
+#else
+struct udp_mmsghdr {
+  struct msghdr msg_hdr;
+  unsigned int msg_len;
+};
+#endif
 
-  // receive packet and queue onto UDPConnection.
-  // don't call back connection at this time.
-  int64_t r;
-  int iters         = 0;
-  unsigned max_niov = 32;
+/** Receive up to @a n datagrams from @a fd, with one call if the system has @c recvmmsg.
 
-  struct msghdr msg;
-  Ptr<IOBufferBlock> chain, next_chain;
-  struct iovec tiovec[max_niov];
-  int64_t size_index  = BUFFER_SIZE_INDEX_2K;
-  int64_t buffer_size = BUFFER_SIZE_FOR_INDEX(size_index);
-  // The max length of receive buffer is 32 * buffer_size (2048) = 65536 bytes.
-  // Because the 'UDP Length' is type of uint16_t defined in RFC 768.
-  // And there is 8 octets in 'User Datagram Header' which means the max length of payload is no more than 65527 bytes.
-  do {
-    // create IOBufferBlock chain to receive data
-    unsigned int niov;
-    IOBufferBlock *b, *last;
-
-    // build struct iov
-    // reuse the block in chain if available
-    b    = chain.get();
-    last = nullptr;
-    for (niov = 0; niov < max_niov; niov++) {
-      if (b == nullptr) {
-        b = new_IOBufferBlock();
-        b->alloc(size_index);
-        if (last == nullptr) {
-          chain = b;
-        } else {
-          last->next = b;
-        }
-      }
+    @return The number of datagrams, -errno on failure.
+ */
+static int
+udp_recvmmsg(int fd, udp_mmsghdr *msgs, unsigned int n)
+{
+#if HAVE_RECVMMSG
+  int r = ::recvmmsg(fd, msgs, n, 0, nullptr);
+  return r < 0 ? -errno : r;
+#else
+  unsigned int i = 0;
+  for (; i < n; ++i) {
+    int64_t r = socketManager.recvmsg(fd, &msgs[i].msg_hdr, 0);
+    if (r < 0) {
+      return i == 0 ? r : i;
+    }
+    msgs[i].msg_len = r;
+  }
+  return i;
+#endif
+}
 
-      tiovec[niov].iov_base = b->buf();
-      tiovec[niov].iov_len  = b->block_size();
+/** Send up to @a n messages on @a fd, with one call if the system has @c sendmmsg.
 
-      last = b;
-      b    = b->next.get();
+    @return The number of messages sent, -errno if the first could not be.
+ */
+static int
+udp_sendmmsg(int fd, udp_mmsghdr *msgs, unsigned int n)
+{
+#if HAVE_SENDMMSG
+  int r = ::sendmmsg(fd, msgs, n, 0);
+  return r < 0 ? -errno : r;
+#else
+  unsigned int i = 0;
+  for (; i < n; ++i) {
+    ssize_t r = ::sendmsg(fd, &msgs[i].msg_hdr, 0);
+    if (r < 0) {
+      return i == 0 ? -errno : i;
     }
+    msgs[i].msg_len = r;
+  }
+  return i;
+#endif
+}
 
-    // build struct msghdr
-    sockaddr_in6 fromaddr;
-    sockaddr_in6 toaddr;
-    int toaddr_len = sizeof(toaddr);
-    char *cbuf[1024];
-    msg.msg_name       = &fromaddr;
-    msg.msg_namelen    = sizeof(fromaddr);
-    msg.msg_iov        = tiovec;
-    msg.msg_iovlen     = niov;
-    msg.msg_control    = cbuf;
-    msg.msg_controllen = sizeof(cbuf);
-
-    // receive data by recvmsg
-    r = socketManager.recvmsg(uc->getFd(), &msg, 0);
-    if (r <= 0) {
-      // error
-      break;
-    }
+/** Queue the @a len bytes received by @a msg onto @a uc, as one packet per datagram.
 
-    // truncated check
-    if (msg.msg_flags & MSG_TRUNC) {
-      Debug("udp-read", "The UDP packet is truncated");
-    }
+    @a toaddr is the local address of the socket, the destination of the packet unless @a msg
+    says otherwise.
+ */
+static void
+udp_queue_datagrams(UnixUDPConnection *uc, struct msghdr &msg, int64_t len, sockaddr_in6 toaddr)
+{
+  char *buf        = static_cast<char *>(msg.msg_iov[0].iov_base);
+  int64_t seg_size = len;
 
-    // fill the IOBufferBlock chain
-    int64_t saved = r;
-    b             = chain.get();
-    while (b && saved > 0) {
-      if (saved > buffer_size) {
-        b->fill(buffer_size);
-        saved -= buffer_size;
-        b = b->next.get();
-      } else {
-        b->fill(saved);
-        saved      = 0;
-        next_chain = b->next.get();
-        b->next    = nullptr;
-      }
-    }
+  // truncated check
+  if (msg.msg_flags & MSG_TRUNC) {
+    Debug("udp-read", "The UDP packet is truncated");
+  }
 
-    safe_getsockname(xuc->getFd(), reinterpret_cast<struct sockaddr *>(&toaddr), &toaddr_len);
-    for (auto cmsg = CMSG_FIRSTHDR(&msg); cmsg != nullptr; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
-      switch (cmsg->cmsg_type) {
+  for (auto cmsg = CMSG_FIRSTHDR(&msg); cmsg != nullptr; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+    switch (cmsg->cmsg_type) {
 #ifdef IP_PKTINFO
-      case IP_PKTINFO:
-        if (cmsg->cmsg_level == IPPROTO_IP) {
-          struct in_pktinfo *pktinfo                                = reinterpret_cast<struct in_pktinfo *>(CMSG_DATA(cmsg));
-          reinterpret_cast<sockaddr_in *>(&toaddr)->sin_addr.s_addr = pktinfo->ipi_addr.s_addr;
-        }
-        break;
+    case IP_PKTINFO:
+      if (cmsg->cmsg_level == IPPROTO_IP) {
+        struct in_pktinfo *pktinfo                                = reinterpret_cast<struct in_pktinfo *>(CMSG_DATA(cmsg));
+        reinterpret_cast<sockaddr_in *>(&toaddr)->sin_addr.s_addr = pktinfo->ipi_addr.s_addr;
+      }
+      break;
 #endif
 #ifdef IP_RECVDSTADDR
-      case IP_RECVDSTADDR:
-        if (cmsg->cmsg_level == IPPROTO_IP) {
-          struct in_addr *addr                                      = reinterpret_cast<struct in_addr *>(CMSG_DATA(cmsg));
-          reinterpret_cast<sockaddr_in *>(&toaddr)->sin_addr.s_addr = addr->s_addr;
-        }
-        break;
+    case IP_RECVDSTADDR:
+      if (cmsg->cmsg_level == IPPROTO_IP) {
+        struct in_addr *addr                                      = reinterpret_cast<struct in_addr *>(CMSG_DATA(cmsg));
+        reinterpret_cast<sockaddr_in *>(&toaddr)->sin_addr.s_addr = addr->s_addr;
+      }
+      break;
 #endif
 #if defined(IPV6_PKTINFO) || defined(IPV6_RECVPKTINFO)
-      case IPV6_PKTINFO: // IPV6_RECVPKTINFO uses IPV6_PKTINFO too
-        if (cmsg->cmsg_level == IPPROTO_IPV6) {
-          struct in6_pktinfo *pktinfo = reinterpret_cast<struct in6_pktinfo *>(CMSG_DATA(cmsg));
-          memcpy(toaddr.sin6_addr.s6_addr, &pktinfo->ipi6_addr, 16);
-        }
-        break;
+    case IPV6_PKTINFO: // IPV6_RECVPKTINFO uses IPV6_PKTINFO too
+      if (cmsg->cmsg_level == IPPROTO_IPV6) {
+        struct in6_pktinfo *pktinfo = reinterpret_cast<struct in6_pktinfo *>(CMSG_DATA(cmsg));
+        memcpy(toaddr.sin6_addr.s6_addr, &pktinfo->ipi6_addr, 16);
+      }
+      break;
 #endif
+#ifdef UDP_GRO
+    case UDP_GRO:
+      // The kernel coalesced datagrams of this size from one peer, the last one may be shorter.
+      if (cmsg->cmsg_level == SOL_UDP) {
+        int gro_size;
+        memcpy(&gro_size, CMSG_DATA(cmsg), sizeof(gro_size));
+        if (gro_size > 0) {
+          seg_size = gro_size;
+        }
       }
+      break;
+#endif
     }
+  }
 
+  for (int64_t offset = 0; offset < len; offset += seg_size) {
+    int n = static_cast<int>(std::min(seg_size, len - offset));
     // create packet
-    UDPPacket *p = new_incoming_UDPPacket(ats_ip_sa_cast(&fromaddr), ats_ip_sa_cast(&toaddr), chain);
+    UDPPacket *p = new_incoming_UDPPacket(static_cast<sockaddr *>(msg.msg_name), ats_ip_sa_cast(&toaddr), buf + offset, n);
     p->setConnection(uc);
     // queue onto the UDPConnection
     uc->inQueue.push((UDPPacketInternal *)p);
+  }
+}
+
+void
+UDPNetProcessorInternal::udp_read_from_net(UDPNetHandler *nh, UDPConnection *xuc)
+{
+  UnixUDPConnection *uc = (UnixUDPConnection *)xuc;
 
-    // reload the unused block
-    chain      = next_chain;
-    next_chain = nullptr;
-    iters++;
-  } while (r > 0);
+  // receive packets and queue onto UDPConnection.
+  // don't call back connection at this time.
+  constexpr int batch = UDPNetHandler::RECV_BATCH;
+  int n, iters = 0;
+
+  // Each datagram is received into a buffer of the largest UDP payload (or GRO read) and copied
+  // out to a packet of its own size, so a burst of small datagrams does not pin that memory.
+  if (nh->recv_buf == nullptr) {
+    nh->recv_buf = static_cast<char *>(ats_malloc(batch * UDPNetHandler::RECV_BUF_SIZE));
+  }
+
+  udp_mmsghdr msgs[batch];
+  struct iovec iov[batch];
+  sockaddr_in6 fromaddr[batch];
+  char cbuf[batch][128];
+
+  sockaddr_in6 toaddr;
+  int toaddr_len = sizeof(toaddr);
+  safe_getsockname(xuc->getFd(), reinterpret_cast<struct sockaddr *>(&toaddr), &toaddr_len);
+
+  do {
+    for (int i = 0; i < batch; ++i) {
+      iov[i].iov_base = nh->recv_buf + i * UDPNetHandler::RECV_BUF_SIZE;
+      iov[i].iov_len  = UDPNetHandler::RECV_BUF_SIZE;
+
+      struct msghdr &msg = msgs[i].msg_hdr;
+      msg.msg_name       = &fromaddr[i];
+      msg.msg_namelen    = sizeof(fromaddr[i]);
+      msg.msg_iov        = &iov[i];
+      msg.msg_iovlen     = 1;
+      msg.msg_control    = cbuf[i];
+      msg.msg_controllen = sizeof(cbuf[i]);
+      msg.msg_flags      = 0;
+    }
+
+    n = udp_recvmmsg(uc->getFd(), msgs, batch);
+    for (int i = 0; i < n; ++i) {
+      if (msgs[i].msg_len > 0) {
+        udp_queue_datagrams(uc, msgs[i].msg_hdr, msgs[i].msg_len, toaddr);
+      }
+    }
+    iters += std::max(n, 0);
+    // Fewer than asked for means the socket is drained.
+  } while (n == batch);
   if (iters >= 1) {
     Debug("udp-read", "read %d at a time", iters);
   }
@@ -806,6 +856,13 @@ UDPNetProcessor::UDPBind(Continuation *cont, sockaddr const *addr, int send_bufs
     goto Lerror;
   }
 
+#ifdef UDP_GRO
+  // Let the kernel coalesce datagrams from one peer, they are split again in udp_read_from_net.
+  if (REC_ConfigReadInteger("proxy.config.udp.enable_gro") && safe_setsockopt(fd, SOL_UDP, UDP_GRO, SOCKOPT_ON, sizeof(int)) < 0) {
+    Debug("udpnet", "setsockopt for UDP_GRO failed");
+  }
+#endif
+
   if ((res = socketManager.ink_bind(fd, addr, ats_ip_size(addr))) < 0) {
     goto Lerror;
   }
@@ -926,17 +983,21 @@ sendPackets:
       goto next_pkt;
     }
 
-    SendUDPPacket(p, pktLen);
+    BatchUDPPacket(p, pktLen);
+    p = nullptr; // Freed once the batch is sent.
     bytesUsed += pktLen;
     bytesThisPipe -= pktLen;
   next_pkt:
     sentOne = true;
-    p->free();
+    if (p) {
+      p->free();
+    }
 
     if (bytesThisPipe < 0) {
       break;
     }
   }
+  FlushBatch();
 
   bytesThisSlot -= bytesUsed;
 
@@ -1004,10 +1065,158 @@ UDPQueue::SendUDPPacket(UDPPacketInternal *p, int32_t /* pktLen ATS_UNUSED */)
 }
 
 void
+UDPQueue::BatchUDPPacket(UDPPacketInternal *p, int64_t pktLen)
+{
+  if (send_count == SEND_BATCH || (send_count > 0 && p->conn != send_batch[0]->conn)) {
+    FlushBatch();
+  }
+  send_batch[send_count] = p;
+  send_len[send_count++] = pktLen;
+}
+
+/** Send the messages @a msgs on @a fd, retrying on @c EAGAIN as @c SendUDPPacket does.
+
+    @return The number of messages sent. If that is less than @a n, @a err is why the next failed.
+ */
+static int
+udp_send_messages(int fd, udp_mmsghdr *msgs, int n, int &err)
+{
+  int done = 0, count = 0;
+  while (done < n) {
+    int r = udp_sendmmsg(fd, msgs + done, n - done);
+    if (r > 0) {
+      done += r;
+      count = 0;
+    } else if (r != -EAGAIN) {
+      err = -r;
+      break;
+    } else if ((g_udp_numSendRetries > 0) && (++count >= g_udp_numSendRetries)) {
+      // tried too many times; give up
+      Debug("udpnet", "Send failed: too many retries");
+      err = EAGAIN;
+      break;
+    }
+  }
+  return done;
+}
+
+void
+UDPQueue::FlushBatch()
+{
+  constexpr int max_iov = SEND_BATCH * 2;
+  udp_mmsghdr msgs[SEND_BATCH];
+  struct iovec iov[max_iov];
+  char control[SEND_BATCH][CMSG_SPACE(sizeof(uint16_t))];
+  int first[SEND_BATCH + 1]; // The first packet of each message, then the end of the last.
+  int nmsgs = 0, niov = 0;
+  int fd    = send_count > 0 ? send_batch[0]->conn->getFd() : NO_FD;
+#ifdef UDP_SEGMENT
+  bool gso = g_udp_enableGSO && !gso_disabled;
+#else
+  bool gso = false;
+#endif
+
+  auto send_messages = [&]() {
+    for (int k = 0; k < nmsgs;) {
+      int err = 0;
+      k += udp_send_messages(fd, msgs + k, nmsgs - k, err);
+      if (k == nmsgs) {
+        break;
+      }
+      if (first[k + 1] - first[k] > 1 && (err == EIO || err == EINVAL)) {
+        // The kernel or the device can not segment, don't try again.
+        Debug("udpnet", "GSO send failed: %s", strerror(err));
+        gso_disabled = true;
+        for (int i = first[k]; i < first[k + 1]; ++i) {
+          SendUDPPacket(send_batch[i], send_len[i]);
+        }
+      } else {
+        Debug("udpnet", "Send failed: %s", strerror(err));
+      }
+      ++k;
+    }
+    nmsgs = niov = 0;
+  };
+
+  for (int i = 0; i < send_count;) {
+    // With GSO a message is a run of packets to one address of the size of the first one, but
+    // the last may be shorter.
+    int j         = i + 1;
+    int64_t bytes = send_len[i];
+    if (gso) {
+      while (j < send_count && j - i < GSO_MAX_SEGMENTS && send_len[j] <= send_len[i] && bytes + send_len[j] <= GSO_MAX_BYTES &&
+             ats_ip_addr_port_eq(&send_batch[j]->to.sa, &send_batch[i]->to.sa)) {
+        bytes += send_len[j++];
+        if (send_len[j - 1] < send_len[i]) {
+          break;
+        }
+      }
+    }
+
+    int need = 0;
+    for (int k = i; k < j; ++k) {
+      for (IOBufferBlock *b = send_batch[k]->chain.get(); b != nullptr; b = b->next.get()) {
+        ++need;
+      }
+    }
+    if (niov + need > max_iov) {
+      send_messages();
+      if (need > max_iov) {
+        for (int k = i; k < j; ++k) {
+          SendUDPPacket(send_batch[k], send_len[k]);
+        }
+        i = j;
+        continue;
+      }
+    }
+
+    struct msghdr &msg = msgs[nmsgs].msg_hdr;
+    msg.msg_name       = (caddr_t)&send_batch[i]->to.sa;
+    msg.msg_namelen    = ats_ip_size(send_batch[i]->to);
+    msg.msg_iov        = iov + niov;
+    msg.msg_iovlen     = need;
+    msg.msg_control    = nullptr;
+    msg.msg_controllen = 0;
+    msg.msg_flags      = 0;
+    for (int k = i; k < j; ++k) {
+      send_batch[k]->conn->lastSentPktStartTime = send_batch[k]->delivery_time;
+      for (IOBufferBlock *b = send_batch[k]->chain.get(); b != nullptr; b = b->next.get()) {
+        iov[niov].iov_base = (caddr_t)b->start();
+        iov[niov].iov_len  = b->size();
+        niov++;
+      }
+    }
+#ifdef UDP_SEGMENT
+    if (j - i > 1) {
+      uint16_t segment = send_len[i];
+      memset(control[nmsgs], 0, sizeof(control[nmsgs]));
+      msg.msg_control      = control[nmsgs];
+      msg.msg_controllen   = sizeof(control[nmsgs]);
+      struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+      cmsg->cmsg_level     = SOL_UDP;
+      cmsg->cmsg_type      = UDP_SEGMENT;
+      cmsg->cmsg_len       = CMSG_LEN(sizeof(segment));
+      memcpy(CMSG_DATA(cmsg), &segment, sizeof(segment));
+      Debug("udp-send", "Sending %d packets of %d bytes by GSO", j - i, segment);
+    }
+#endif
+    first[nmsgs++] = i;
+    first[nmsgs]   = j;
+    i              = j;
+  }
+  send_messages();
+
+  for (int i = 0; i < send_count; ++i) {
+    send_batch[i]->free();
+  }
+  send_count = 0;
+}
+
+bool
 UDPQueue::send(UDPPacket *p)
 {
   // XXX: maybe fastpath for immediate send?
-  outQueue.push((UDPPacketInternal *)p);
+  return outQueue.push((UDPPacketInternal *)p) == nullptr;
 }
 
 #undef LINK
@@ -1055,6 +1264,11 @@ UDPNetHandler::waitForActivity(ink_hrtime timeout)
 {
   UnixUDPConnection *uc;
   PollCont *pc = get_UDPPollCont(this->thread);
+
+  // Send what was queued on this thread since the last pass, not after the poll times out.
+  if (!udpOutQueue.outQueue.empty()) {
+    udpOutQueue.service(this);
+  }
   pc->do_poll(timeout);
 
   /* Notice: the race between traversal of newconn_list and UDPBind()
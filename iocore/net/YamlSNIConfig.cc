@@ -95,6 +95,7 @@ TsEnumDescriptor TLS_PROTOCOLS_DESCRIPTOR = {{{"TLSv1", 0}, {"TLSv1_1", 1}, {"TL
 
 std::set<std::string> valid_sni_config_keys = {TS_fqdn,
                                                TS_disable_h2,
+                                               TS_disable_early_data,
                                                TS_verify_client,
                                                TS_tunnel_route,
                                                TS_forward_route,
@@ -103,7 +104,10 @@ std::set<std::string> valid_sni_config_keys = {TS_fqdn,
                                                TS_verify_server_properties,
                                                TS_client_cert,
                                                TS_client_key,
-                                               TS_ip_allow
+                                               TS_ip_allow,
+                                               TS_tcp_congestion_control,
+                                               TS_tcp_pacing_rate,
+                                               TS_tcp_notsent_lowat
 #if TS_USE_HELLO_CB
                                                ,
                                                TS_valid_tls_versions_in
@@ -131,6 +135,9 @@ template <> struct convert<YamlSNIConfig::Item> {
     if (node[TS_disable_h2]) {
       item.disable_h2 = node[TS_disable_h2].as<bool>();
     }
+    if (node[TS_disable_early_data]) {
+      item.disable_early_data = node[TS_disable_early_data].as<bool>();
+    }
 
     // enum
     if (node[TS_verify_client]) {
@@ -197,6 +204,15 @@ template <> struct convert<YamlSNIConfig::Item> {
     if (node[TS_ip_allow]) {
       item.ip_allow = node[TS_ip_allow].as<std::string>();
     }
+    if (node[TS_tcp_congestion_control]) {
+      item.tcp_congestion_control = node[TS_tcp_congestion_control].as<std::string>();
+    }
+    if (node[TS_tcp_pacing_rate]) {
+      item.tcp_pacing_rate = node[TS_tcp_pacing_rate].as<int64_t>();
+    }
+    if (node[TS_tcp_notsent_lowat]) {
+      item.tcp_notsent_lowat = node[TS_tcp_notsent_lowat].as<int>();
+    }
     if (node[TS_valid_tls_versions_in]) {
       for (unsigned int i = 0; i < node[TS_valid_tls_versions_in].size(); i++) {
         auto value   = node[TS_valid_tls_versions_in][i].as<std::string>();
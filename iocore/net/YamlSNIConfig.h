@@ -29,6 +29,7 @@
 #define TSDECL(id) constexpr char TS_##id[] = #id
 TSDECL(fqdn);
 TSDECL(disable_h2);
+TSDECL(disable_early_data);
 TSDECL(verify_client);
 TSDECL(tunnel_route);
 TSDECL(forward_route);
@@ -39,6 +40,9 @@ TSDECL(client_cert);
 TSDECL(client_key);
 TSDECL(ip_allow);
 TSDECL(valid_tls_versions_in);
+TSDECL(tcp_congestion_control);
+TSDECL(tcp_pacing_rate);
+TSDECL(tcp_notsent_lowat);
 #undef TSDECL
 
 const int start = 0;
@@ -62,6 +66,7 @@ struct YamlSNIConfig {
   struct Item {
     std::string fqdn;
     bool disable_h2             = false;
+    bool disable_early_data     = false;
     uint8_t verify_client_level = 255;
     std::string tunnel_destination;
     bool tunnel_decrypt               = false;
@@ -72,6 +77,9 @@ struct YamlSNIConfig {
     std::string ip_allow;
     bool protocol_unset = true;
     unsigned long protocol_mask;
+    std::string tcp_congestion_control;
+    int64_t tcp_pacing_rate = 0;
+    int tcp_notsent_lowat   = 0;
 
     void EnableProtocol(YamlSNIConfig::TLSProtocol proto);
   };
@@ -152,6 +152,13 @@ RecErrT RecGetRecordString_Xmalloc(const char *name, RecString *rec_string, bool
 RecErrT RecGetRecordCounter(const char *name, RecCounter *rec_counter, bool lock = true);
 // Convenience to allow us to treat the RecInt as a single byte internally
 RecErrT RecGetRecordByte(const char *name, RecByte *rec_byte, bool lock = true);
+
+// Find a record once, to get its value later without looking its name up again.
+// The records are never freed, the pointer stays valid.
+RecRecord *RecFindRecord(const char *name, bool lock = true);
+RecErrT RecGetRecordInt(RecRecord *record, RecInt *rec_int);
+RecErrT RecGetRecordFloat(RecRecord *record, RecFloat *rec_float);
+RecErrT RecGetRecordCounter(RecRecord *record, RecCounter *rec_counter);
 // Convenience to allow us to treat the RecInt as a bool internally
 RecErrT RecGetRecordBool(const char *name, RecBool *rec_byte, bool lock = true);
 
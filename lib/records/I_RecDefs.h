@@ -158,13 +158,35 @@ struct RecRawStat {
   uint32_t version;
 };
 
+// A raw stat histogram takes REC_HISTOGRAM_BUCKETS consecutive ids of a
+// block, one for each bucket. The buckets are log-linear: each value below
+// REC_HISTOGRAM_SUB_BUCKETS has a bucket of its own, and every power of two
+// above is split in REC_HISTOGRAM_SUB_BUCKETS buckets, so a bucket is never
+// wider than 1/REC_HISTOGRAM_SUB_BUCKETS of its values. The values from
+// 2^REC_HISTOGRAM_MAX_BITS up all go to the last bucket.
+#define REC_HISTOGRAM_SUB_BITS 3
+#define REC_HISTOGRAM_SUB_BUCKETS (1 << REC_HISTOGRAM_SUB_BITS)
+#define REC_HISTOGRAM_MAX_BITS 32
+#define REC_HISTOGRAM_BUCKETS ((REC_HISTOGRAM_MAX_BITS - REC_HISTOGRAM_SUB_BITS + 1) * REC_HISTOGRAM_SUB_BUCKETS)
+
+// The thread local raw stats of a block are followed by a bitmap of the
+// ones that changed since the last sync, so that a sync only folds those.
+// The sync clears the bitmap, it is kept a cache line away from the
+// values on both sides.
+#define REC_CACHE_LINE_SIZE 64
+
+struct RecRawStatSeen;
+
 // WARNING!  It's advised that developers do not modify the contents of
 // the RecRawStatBlock.  ^_^
 struct RecRawStatBlock {
-  off_t ethr_stat_offset; // thread local raw-stat storage
-  RecRawStat **global;    // global raw-stat storage (ptr to RecRecord)
-  int num_stats;          // number of stats in this block
-  int max_stats;          // maximum number of stats for this block
+  off_t ethr_stat_offset;  // thread local raw-stat storage
+  off_t ethr_dirty_offset; // thread local bitmap of the raw-stats changed since the last sync
+  RecRawStat **global;     // global raw-stat storage (ptr to RecRecord)
+  RecRawStatSeen *seen[2]; // thread local values at the last sync, of the event and the dedicated threads
+  int seen_threads[2];     // number of threads in seen
+  int num_stats;           // number of stats in this block
+  int max_stats;           // maximum number of stats for this block
   ink_mutex mutex;
 };
 
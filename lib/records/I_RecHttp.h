@@ -253,6 +253,10 @@ public:
   bool m_transparent_passthrough = false;
   /// True if MPTCP is enabled on this port.
   bool m_mptcp = false;
+  /// True if HTTP/2 streams on this port are scheduled by the RFC 9218 priority parameters.
+  bool m_http2_urgency = false;
+  /// Net thread group of proxy.config.net.thread_groups to accept on, empty for the ET_NET threads.
+  std::string m_thread_group;
   /// Local address for inbound connections (listen address).
   IpAddr m_inbound_ip;
   /// Local address for outbound connections (to origin server).
@@ -405,6 +409,8 @@ public:
   static const char *const OPT_HOST_RES_PREFIX;         ///< Set DNS family preference.
   static const char *const OPT_PROTO_PREFIX;            ///< Transport layer protocols.
   static const char *const OPT_MPTCP;                   ///< MPTCP.
+  static const char *const OPT_HTTP2_URGENCY;           ///< HTTP/2 urgency scheduling.
+  static const char *const OPT_THREADS_PREFIX;          ///< Net thread group.
 
   static std::vector<self> &m_global; ///< Global ("default") data.
 
@@ -50,15 +50,14 @@ int _RecRegisterRawStat(RecRawStatBlock *rsb, RecT rec_type, const char *name, R
 #define RecRegisterRawStat(rsb, rec_type, name, data_type, persist_type, id, sync_cb) \
   _RecRegisterRawStat((rsb), (rec_type), (name), (data_type), REC_PERSISTENCE_TYPE(persist_type), (id), (sync_cb))
 
-// RecRawStatRange* RecAllocateRawStatRange (int num_buckets);
+// Register a histogram on the REC_HISTOGRAM_BUCKETS ids from @a id. It is
+// exported as the records <name>.count, <name>.sum and the percentiles
+// <name>.p50, <name>.p90, <name>.p99 and <name>.p999, which are upper bounds
+// of the values of each percentile. The records are not persistent.
+int RecRegisterRawStatHistogram(RecRawStatBlock *rsb, RecT rec_type, const char *name, int id);
 
-// int RecRegisterRawStatRange (RecRawStatRange *rsr,
-//                           RecT rec_type,
-//                           char *name,
-//                           RecPersistT persist_type,
-//                           int id,
-//                           RecInt min,
-//                           RecInt max);
+// The percentile @a permille / 1000 of the histogram with bucket @a counts.
+int64_t RecRawStatHistogramPercentile(const int64_t *counts, int permille);
 
 //-------------------------------------------------------------------------
 // Predefined RawStat Callbacks
@@ -83,6 +82,7 @@ int RecRawStatUpdateSum(RecRawStatBlock *rsb, int id);
 inline int RecIncrRawStat(RecRawStatBlock *rsb, EThread *ethread, int id, int64_t incr = 1);
 inline int RecIncrRawStatSum(RecRawStatBlock *rsb, EThread *ethread, int id, int64_t incr = 1);
 inline int RecIncrRawStatCount(RecRawStatBlock *rsb, EThread *ethread, int id, int64_t incr = 1);
+inline int RecIncrRawStatHistogram(RecRawStatBlock *rsb, EThread *ethread, int id, int64_t value);
 
 int RecSetRawStatSum(RecRawStatBlock *rsb, int id, int64_t data);
 int RecSetRawStatCount(RecRawStatBlock *rsb, int id, int64_t data);
@@ -122,12 +122,23 @@ raw_stat_get_tlp(RecRawStatBlock *rsb, int id, EThread *ethread)
   return (((RecRawStat *)((char *)(ethread) + rsb->ethr_stat_offset)) + id);
 }
 
+// Flag the raw stat @a id of the thread of @a tlp as changed since the last sync. The flag is
+// stored after the value, so that a sync that sees the flag sees the value.
+inline void
+raw_stat_set_dirty(RecRawStatBlock *rsb, int id, RecRawStat *tlp)
+{
+  char *base      = reinterpret_cast<char *>(tlp - id) - rsb->ethr_stat_offset;
+  uint64_t *dirty = reinterpret_cast<uint64_t *>(base + rsb->ethr_dirty_offset) + id / 64;
+  __atomic_store_n(dirty, __atomic_load_n(dirty, __ATOMIC_RELAXED) | (uint64_t(1) << (id % 64)), __ATOMIC_RELEASE);
+}
+
 inline int
 RecIncrRawStat(RecRawStatBlock *rsb, EThread *ethread, int id, int64_t incr)
 {
   RecRawStat *tlp = raw_stat_get_tlp(rsb, id, ethread);
   tlp->sum += incr;
   tlp->count += 1;
+  raw_stat_set_dirty(rsb, id, tlp);
   return REC_ERR_OKAY;
 }
 
@@ -137,6 +148,7 @@ RecDecrRawStat(RecRawStatBlock *rsb, EThread *ethread, int id, int64_t decr)
   RecRawStat *tlp = raw_stat_get_tlp(rsb, id, ethread);
   tlp->sum -= decr;
   tlp->count += 1;
+  raw_stat_set_dirty(rsb, id, tlp);
   return REC_ERR_OKAY;
 }
 
@@ -145,6 +157,7 @@ RecIncrRawStatSum(RecRawStatBlock *rsb, EThread *ethread, int id, int64_t incr)
 {
   RecRawStat *tlp = raw_stat_get_tlp(rsb, id, ethread);
   tlp->sum += incr;
+  raw_stat_set_dirty(rsb, id, tlp);
   return REC_ERR_OKAY;
 }
 
@@ -153,5 +166,43 @@ RecIncrRawStatCount(RecRawStatBlock *rsb, EThread *ethread, int id, int64_t incr
 {
   RecRawStat *tlp = raw_stat_get_tlp(rsb, id, ethread);
   tlp->count += incr;
+  raw_stat_set_dirty(rsb, id, tlp);
   return REC_ERR_OKAY;
 }
+
+// The bucket of @a value in a histogram.
+inline int
+RecRawStatHistogramBucket(int64_t value)
+{
+  if (value < REC_HISTOGRAM_SUB_BUCKETS) {
+    return value < 0 ? 0 : value;
+  }
+
+  int msb = 63 - __builtin_clzll(value);
+  if (msb >= REC_HISTOGRAM_MAX_BITS) {
+    return REC_HISTOGRAM_BUCKETS - 1;
+  }
+
+  int shift = msb - REC_HISTOGRAM_SUB_BITS;
+  return (shift + 1) * REC_HISTOGRAM_SUB_BUCKETS + ((value >> shift) & (REC_HISTOGRAM_SUB_BUCKETS - 1));
+}
+
+// The largest value of histogram bucket @a bucket.
+inline int64_t
+RecRawStatHistogramBucketMax(int bucket)
+{
+  if (bucket < REC_HISTOGRAM_SUB_BUCKETS) {
+    return bucket;
+  }
+
+  int shift   = bucket / REC_HISTOGRAM_SUB_BUCKETS - 1;
+  int64_t sub = bucket % REC_HISTOGRAM_SUB_BUCKETS;
+  return ((REC_HISTOGRAM_SUB_BUCKETS + sub + 1) << shift) - 1;
+}
+
+// Add @a value to the histogram registered at @a id.
+inline int
+RecIncrRawStatHistogram(RecRawStatBlock *rsb, EThread *ethread, int id, int64_t value)
+{
+  return RecIncrRawStat(rsb, ethread, id + RecRawStatHistogramBucket(value), value);
+}
@@ -0,0 +1,101 @@
+/** @file
+
+  A snapshot of the stats in a shared memory segment
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <string>
+
+#include "I_RecDefs.h"
+
+//-------------------------------------------------------------------------
+// types/defines
+//-------------------------------------------------------------------------
+
+#define REC_STATS_SHM_FILE "stats.shm"
+#define REC_STATS_SHM_MAGIC 0x53544154 // "STAT"
+#define REC_STATS_SHM_VERSION 2
+#define REC_STATS_SHM_NAME_LEN 112
+#define REC_STATS_SHM_ENTRIES_OFFSET 64 // the entries start on a cache line of their own
+#define REC_STATS_SHM_STRING_SPACE 128  // bytes of string values per entry
+#define REC_STATS_SHM_MAX_AGE 10        // seconds after which a snapshot is that of a server that is gone
+
+// The segment is a file in the runtime directory, mapped by the server and
+// by any reader. The server rewrites all the stats after each raw stat sync,
+// the generation is odd while it does, so that a reader can tell a torn copy
+// from a consistent one, without a lock and without the manager.
+//
+// The capacity entries start at REC_STATS_SHM_ENTRIES_OFFSET, and the values
+// of the string stats follow them.
+struct RecStatsShmHeader {
+  uint32_t magic;
+  uint32_t version;
+  std::atomic<uint64_t> generation; // odd while the entries are written
+  uint32_t capacity;                // entries the segment has room for
+  uint32_t count;                   // entries of the snapshot
+  int64_t updated;                  // time of the snapshot, seconds since the epoch
+  uint32_t string_space;            // bytes for the string values
+  uint32_t string_used;             // bytes of string values of the snapshot
+};
+
+struct RecStatsShmEntry {
+  char name[REC_STATS_SHM_NAME_LEN]; // nul terminated, longer names are left out
+  int32_t data_type;                 // a RecDataT, RECD_INT, RECD_FLOAT, RECD_COUNTER or RECD_STRING
+  int32_t reserved;
+  union {
+    int64_t rec_int;
+    double rec_float;
+    struct {
+      uint32_t offset; // of the nul terminated value in the string space
+      uint32_t len;
+    } rec_string;
+  } value;
+};
+
+static_assert(sizeof(RecStatsShmHeader) <= REC_STATS_SHM_ENTRIES_OFFSET, "the stats segment header fits in the first cache line");
+static_assert(sizeof(RecStatsShmEntry) == 128, "a stats segment entry is two cache lines");
+
+//-------------------------------------------------------------------------
+// Writer, in the server
+//-------------------------------------------------------------------------
+
+// Create the segment if proxy.config.stats.shm_enabled is set.
+void RecStatsShmInit();
+// Write the current value of every stat to the segment, if there is one.
+void RecStatsShmUpdate();
+
+//-------------------------------------------------------------------------
+// Reader
+//-------------------------------------------------------------------------
+
+std::string RecStatsShmPath();
+
+using RecStatsShmEntryCb = std::function<void(const char *name, RecDataT data_type, const RecData &data)>;
+
+// Call @a cb for each stat of a consistent snapshot of the segment at @a
+// path, with the time of the snapshot in @a updated. Returns false, without
+// calling @a cb, if there is no segment or if the writer kept it busy for
+// all the attempts to read it.
+bool RecStatsShmRead(const char *path, const RecStatsShmEntryCb &cb, int64_t *updated = nullptr);
@@ -440,7 +440,7 @@ RecSetRecord(RecT rec_type, const char *name, RecDataT data_type, RecData *data,
     } else {
       err = send_set_message(r1);
     }
-    g_records_ht.emplace(name, r1);
+    g_records_ht.emplace(r1->name, r1);
   }
 
 Ldone:
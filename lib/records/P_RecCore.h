@@ -32,12 +32,14 @@
 #include "P_RecDefs.h"
 #include "P_RecUtils.h"
 
+#include <string_view>
 #include <unordered_set>
 #include <unordered_map>
 
-// records, record hash-table, and hash-table rwlock
+// records, record hash-table, and hash-table rwlock. The records are never freed, so
+// the table is keyed by their own names and a lookup by name doesn't copy it.
 extern RecRecord *g_records;
-extern std::unordered_map<std::string, RecRecord *> g_records_ht;
+extern std::unordered_map<std::string_view, RecRecord *> g_records_ht;
 extern ink_rwlock g_records_rwlock;
 extern int g_num_records;
 extern RecModeT g_mode_type;
@@ -38,7 +38,7 @@ int max_records_entries = REC_INTERNAL_RECORDS + REC_MIN_API_RECORDS;
 static bool g_initialized = false;
 
 RecRecord *g_records = nullptr;
-std::unordered_map<std::string, RecRecord *> g_records_ht;
+std::unordered_map<std::string_view, RecRecord *> g_records_ht;
 ink_rwlock g_records_rwlock;
 int g_num_records = 0;
 
@@ -91,7 +91,7 @@ register_record(RecT rec_type, const char *name, RecDataT data_type, RecData dat
     // Set the r->data to its default value as this is a new record
     RecDataSet(r->data_type, &(r->data), &(data_default));
     RecDataSet(r->data_type, &(r->data_default), &(data_default));
-    g_records_ht.emplace(name, r);
+    g_records_ht.emplace(r->name, r);
 
     if (REC_TYPE_IS_STAT(r->rec_type)) {
       r->stat_meta.persist_type = persist_type;
@@ -917,36 +917,104 @@ RecRegisterConfig(RecT rec_type, const char *name, RecDataT data_type, RecData d
 //-------------------------------------------------------------------------
 // RecGetRecord_Xmalloc
 //-------------------------------------------------------------------------
+static RecErrT
+get_record_data(RecRecord *r, RecDataT data_type, RecData *data)
+{
+  RecErrT err = REC_ERR_OKAY;
+
+  rec_mutex_acquire(&(r->lock));
+  if (!r->registered || (r->data_type != data_type)) {
+    err = REC_ERR_FAIL;
+  } else {
+    // Clear the caller's record just in case it has trash in it.
+    // Passing trashy records to RecDataSet will cause confusion.
+    memset(data, 0, sizeof(RecData));
+    RecDataSet(data_type, data, &(r->data));
+  }
+  rec_mutex_release(&(r->lock));
+
+  return err;
+}
+
 RecErrT
 RecGetRecord_Xmalloc(const char *name, RecDataT data_type, RecData *data, bool lock)
 {
-  RecErrT err = REC_ERR_OKAY;
+  RecErrT err = REC_ERR_FAIL;
 
   if (lock) {
     ink_rwlock_rdlock(&g_records_rwlock);
   }
 
   if (auto it = g_records_ht.find(name); it != g_records_ht.end()) {
-    RecRecord *r = it->second;
+    err = get_record_data(it->second, data_type, data);
+  }
 
-    rec_mutex_acquire(&(r->lock));
-    if (!r->registered || (r->data_type != data_type)) {
-      err = REC_ERR_FAIL;
-    } else {
-      // Clear the caller's record just in case it has trash in it.
-      // Passing trashy records to RecDataSet will cause confusion.
-      memset(data, 0, sizeof(RecData));
-      RecDataSet(data_type, data, &(r->data));
-    }
-    rec_mutex_release(&(r->lock));
-  } else {
-    err = REC_ERR_FAIL;
+  if (lock) {
+    ink_rwlock_unlock(&g_records_rwlock);
+  }
+
+  return err;
+}
+
+//-------------------------------------------------------------------------
+// RecFindRecord
+//-------------------------------------------------------------------------
+RecRecord *
+RecFindRecord(const char *name, bool lock)
+{
+  RecRecord *r = nullptr;
+
+  if (lock) {
+    ink_rwlock_rdlock(&g_records_rwlock);
+  }
+
+  if (auto it = g_records_ht.find(name); it != g_records_ht.end()) {
+    r = it->second;
   }
 
   if (lock) {
     ink_rwlock_unlock(&g_records_rwlock);
   }
 
+  return r;
+}
+
+//-------------------------------------------------------------------------
+// RecGetRecordXXX of a record found by RecFindRecord
+//-------------------------------------------------------------------------
+RecErrT
+RecGetRecordInt(RecRecord *record, RecInt *rec_int)
+{
+  RecErrT err;
+  RecData data;
+
+  if ((err = get_record_data(record, RECD_INT, &data)) == REC_ERR_OKAY) {
+    *rec_int = data.rec_int;
+  }
+  return err;
+}
+
+RecErrT
+RecGetRecordFloat(RecRecord *record, RecFloat *rec_float)
+{
+  RecErrT err;
+  RecData data;
+
+  if ((err = get_record_data(record, RECD_FLOAT, &data)) == REC_ERR_OKAY) {
+    *rec_float = data.rec_float;
+  }
+  return err;
+}
+
+RecErrT
+RecGetRecordCounter(RecRecord *record, RecCounter *rec_counter)
+{
+  RecErrT err;
+  RecData data;
+
+  if ((err = get_record_data(record, RECD_COUNTER, &data)) == REC_ERR_OKAY) {
+    *rec_counter = data.rec_counter;
+  }
   return err;
 }
 
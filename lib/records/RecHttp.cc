@@ -161,6 +161,7 @@ const char *const HttpProxyPort::OPT_OUTBOUND_IP_PREFIX = "ip-out";
 const char *const HttpProxyPort::OPT_INBOUND_IP_PREFIX  = "ip-in";
 const char *const HttpProxyPort::OPT_HOST_RES_PREFIX    = "ip-resolve";
 const char *const HttpProxyPort::OPT_PROTO_PREFIX       = "proto";
+const char *const HttpProxyPort::OPT_THREADS_PREFIX     = "threads";
 
 const char *const HttpProxyPort::OPT_IPV6                    = "ipv6";
 const char *const HttpProxyPort::OPT_IPV4                    = "ipv4";
@@ -174,6 +175,7 @@ const char *const HttpProxyPort::OPT_PLUGIN                  = "plugin";
 const char *const HttpProxyPort::OPT_BLIND_TUNNEL            = "blind";
 const char *const HttpProxyPort::OPT_COMPRESSED              = "compressed";
 const char *const HttpProxyPort::OPT_MPTCP                   = "mptcp";
+const char *const HttpProxyPort::OPT_HTTP2_URGENCY           = "h2-urgency";
 
 // File local constants.
 namespace
@@ -184,6 +186,7 @@ size_t const OPT_OUTBOUND_IP_PREFIX_LEN = strlen(HttpProxyPort::OPT_OUTBOUND_IP_
 size_t const OPT_INBOUND_IP_PREFIX_LEN  = strlen(HttpProxyPort::OPT_INBOUND_IP_PREFIX);
 size_t const OPT_HOST_RES_PREFIX_LEN    = strlen(HttpProxyPort::OPT_HOST_RES_PREFIX);
 size_t const OPT_PROTO_PREFIX_LEN       = strlen(HttpProxyPort::OPT_PROTO_PREFIX);
+size_t const OPT_THREADS_PREFIX_LEN     = strlen(HttpProxyPort::OPT_THREADS_PREFIX);
 } // namespace
 
 namespace
@@ -410,12 +413,16 @@ HttpProxyPort::processOptions(const char *opts)
       } else {
         Warning("Multipath TCP requested [%s] in port descriptor '%s' but it is not supported by this host.", item, opts);
       }
+    } else if (0 == strcasecmp(OPT_HTTP2_URGENCY, item)) {
+      m_http2_urgency = true;
     } else if (nullptr != (value = this->checkPrefix(item, OPT_HOST_RES_PREFIX, OPT_HOST_RES_PREFIX_LEN))) {
       this->processFamilyPreference(value);
       host_res_set_p = true;
     } else if (nullptr != (value = this->checkPrefix(item, OPT_PROTO_PREFIX, OPT_PROTO_PREFIX_LEN))) {
       this->processSessionProtocolPreference(value);
       sp_set_p = true;
+    } else if (nullptr != (value = this->checkPrefix(item, OPT_THREADS_PREFIX, OPT_THREADS_PREFIX_LEN))) {
+      m_thread_group = value;
     } else {
       Warning("Invalid option '%s' in proxy port descriptor '%s'", item, opts);
     }
@@ -599,6 +606,14 @@ HttpProxyPort::print(char *out, size_t n)
     zret += snprintf(out + zret, n - zret, ":%s", OPT_TRANSPARENT_PASSTHROUGH);
   }
 
+  if (m_http2_urgency) {
+    zret += snprintf(out + zret, n - zret, ":%s", OPT_HTTP2_URGENCY);
+  }
+
+  if (!m_thread_group.empty()) {
+    zret += snprintf(out + zret, n - zret, ":%s=%s", OPT_THREADS_PREFIX, m_thread_group.c_str());
+  }
+
   /* Don't print the IP resolution preferences if the port is outbound
    * transparent (which means the preference order is forced) or if
    * the order is the same as the default.
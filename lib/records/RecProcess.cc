@@ -32,6 +32,7 @@
 #include "P_RecMessage.h"
 #include "P_RecUtils.h"
 #include "P_RecFile.h"
+#include "I_RecStatsShm.h"
 
 #include "mgmtapi.h"
 #include "ProcessManager.h"
@@ -144,6 +145,7 @@ struct raw_stat_sync_cont : public Continuation {
   exec_callbacks(int /* event */, Event * /* e */)
   {
     RecExecRawStatSyncCbs();
+    RecStatsShmUpdate();
     Debug("statsproc", "raw_stat_sync_cont() processed");
 
     return EVENT_CONT;
@@ -267,6 +269,8 @@ RecProcessStart()
     return REC_ERR_OKAY;
   }
 
+  RecStatsShmInit();
+
   Debug("statsproc", "Starting sync continuations:");
   raw_stat_sync_cont *rssc = new raw_stat_sync_cont(new_ProxyMutex());
   Debug("statsproc", "raw-stat syncer");
@@ -23,7 +23,18 @@
 
 #include "P_RecCore.h"
 #include "P_RecProcess.h"
+#include "tscore/ink_align.h"
+#include <algorithm>
+#include <mutex>
+#include <string>
 #include <string_view>
+#include <vector>
+
+// The thread local sum and count of a raw stat, when they were last folded in its global.
+struct RecRawStatSeen {
+  int64_t sum;
+  int64_t count;
+};
 
 //-------------------------------------------------------------------------
 // raw_stat_get_total
@@ -37,8 +48,123 @@ thread_stat(EThread *et, RecRawStatBlock *rsb, int id)
 {
   return (reinterpret_cast<RecRawStat *>(reinterpret_cast<char *>(et) + rsb->ethr_stat_offset)) + id;
 }
+
+inline uint64_t *
+thread_dirty(EThread *et, RecRawStatBlock *rsb)
+{
+  return reinterpret_cast<uint64_t *>(reinterpret_cast<char *>(et) + rsb->ethr_dirty_offset);
+}
+
+// All the blocks, for the sync to fold each of them once.
+std::mutex raw_stat_blocks_mutex;
+std::vector<RecRawStatBlock *> raw_stat_blocks;
+
+// Set while RecExecRawStatSyncCbs runs the sync callbacks, after it folded every block.
+thread_local bool raw_stat_folded = false;
 } // namespace
 
+//-------------------------------------------------------------------------
+// raw_stat_fold
+//-------------------------------------------------------------------------
+
+// The values seen of the event threads (@a group 0) or the dedicated threads (@a group 1) of @a rsb,
+// for @a n_threads threads. Each group only grows, so a thread keeps its index. Called with the block
+// locked.
+static RecRawStatSeen *
+raw_stat_seen(RecRawStatBlock *rsb, int group, int n_threads)
+{
+  if (n_threads > rsb->seen_threads[group]) {
+    size_t old_size = static_cast<size_t>(rsb->seen_threads[group]) * rsb->max_stats;
+    size_t new_size = static_cast<size_t>(n_threads) * rsb->max_stats;
+
+    rsb->seen[group] = static_cast<RecRawStatSeen *>(ats_realloc(rsb->seen[group], new_size * sizeof(RecRawStatSeen)));
+    memset(rsb->seen[group] + old_size, 0, (new_size - old_size) * sizeof(RecRawStatSeen));
+    rsb->seen_threads[group] = n_threads;
+  }
+  return rsb->seen[group];
+}
+
+// Fold in the globals the values of the thread @a et that changed since it was last folded, all of
+// them or only @a id. The globals keep the thread local total in last_sum and last_count, the sum
+// never goes below zero.
+static void
+raw_stat_fold_thread(RecRawStatBlock *rsb, EThread *et, RecRawStatSeen *seen, int id)
+{
+  uint64_t *dirty = thread_dirty(et, rsb);
+  int first       = id < 0 ? 0 : id / 64;
+  int last        = id < 0 ? (rsb->max_stats + 63) / 64 : id / 64 + 1;
+
+  for (int w = first; w < last; ++w) {
+    uint64_t mask = id < 0 ? ~uint64_t(0) : uint64_t(1) << (id % 64);
+    if ((__atomic_load_n(&dirty[w], __ATOMIC_RELAXED) & mask) == 0) {
+      continue;
+    }
+
+    uint64_t bits = __atomic_fetch_and(&dirty[w], ~mask, __ATOMIC_ACQUIRE) & mask;
+    while (bits) {
+      int i = w * 64 + __builtin_ctzll(bits);
+      bits &= bits - 1;
+
+      RecRawStat *global = rsb->global[i];
+      if (global == nullptr) {
+        // Not registered yet, it is folded whole the next time it changes.
+        continue;
+      }
+
+      RecRawStat *tlp = thread_stat(et, rsb, i);
+      int64_t sum     = tlp->sum;
+      int64_t count   = tlp->count;
+      int64_t total   = global->last_sum + (sum - seen[i].sum);
+
+      ink_atomic_increment(&global->sum, std::max<int64_t>(total, 0) - std::max<int64_t>(global->last_sum, 0));
+      ink_atomic_increment(&global->count, count - seen[i].count);
+      ink_atomic_swap(&global->last_sum, total);
+      ink_atomic_increment(&global->last_count, count - seen[i].count);
+      seen[i].sum   = sum;
+      seen[i].count = count;
+    }
+  }
+}
+
+// Fold the changed thread local values of @a rsb in its globals, all of them or only @a id.
+static void
+raw_stat_fold(RecRawStatBlock *rsb, int id)
+{
+  auto ethreads = eventProcessor.active_ethreads();
+  auto dthreads = eventProcessor.active_dthreads();
+
+  ink_scoped_mutex_lock lock(rsb->mutex);
+
+  RecRawStatSeen *seen = raw_stat_seen(rsb, 0, std::distance(ethreads.begin(), ethreads.end()));
+  for (EThread *et : ethreads) {
+    raw_stat_fold_thread(rsb, et, seen, id);
+    seen += rsb->max_stats;
+  }
+
+  seen = raw_stat_seen(rsb, 1, std::distance(dthreads.begin(), dthreads.end()));
+  for (EThread *et : dthreads) {
+    raw_stat_fold_thread(rsb, et, seen, id);
+    seen += rsb->max_stats;
+  }
+}
+
+// Forget the values seen of @a id, after its thread local values are reset. Called with the block locked.
+static void
+raw_stat_clear_seen(RecRawStatBlock *rsb, int id, bool sum, bool count)
+{
+  for (int group = 0; group < 2; ++group) {
+    for (int t = 0; t < rsb->seen_threads[group]; ++t) {
+      RecRawStatSeen &seen = rsb->seen[group][static_cast<size_t>(t) * rsb->max_stats + id];
+      if (sum) {
+        seen.sum = 0;
+      }
+      if (count) {
+        seen.count = 0;
+      }
+    }
+  }
+}
+
 static int
 raw_stat_get_total(RecRawStatBlock *rsb, int id, RecRawStat *total)
 {
@@ -75,44 +201,9 @@ raw_stat_get_total(RecRawStatBlock *rsb, int id, RecRawStat *total)
 static int
 raw_stat_sync_to_global(RecRawStatBlock *rsb, int id)
 {
-  RecRawStat total;
-
-  total.sum   = 0;
-  total.count = 0;
-
-  // sum the thread local values
-  for (EThread *et : eventProcessor.active_ethreads()) {
-    RecRawStat *tlp = thread_stat(et, rsb, id);
-    total.sum += tlp->sum;
-    total.count += tlp->count;
-  }
-
-  for (EThread *et : eventProcessor.active_dthreads()) {
-    RecRawStat *tlp = thread_stat(et, rsb, id);
-    total.sum += tlp->sum;
-    total.count += tlp->count;
-  }
-
-  if (total.sum < 0) { // Assure that we stay positive
-    total.sum = 0;
-  }
-
-  // lock so the setting of the globals and last values are atomic
-  {
-    ink_scoped_mutex_lock lock(rsb->mutex);
-
-    // get the delta from the last sync
-    RecRawStat delta;
-    delta.sum   = total.sum - rsb->global[id]->last_sum;
-    delta.count = total.count - rsb->global[id]->last_count;
-
-    // increment the global values by the delta
-    ink_atomic_increment(&(rsb->global[id]->sum), delta.sum);
-    ink_atomic_increment(&(rsb->global[id]->count), delta.count);
-
-    // set the new totals as the last values seen
-    ink_atomic_swap(&(rsb->global[id]->last_sum), total.sum);
-    ink_atomic_swap(&(rsb->global[id]->last_count), total.count);
+  // RecExecRawStatSyncCbs folded all the changes already
+  if (!raw_stat_folded) {
+    raw_stat_fold(rsb, id);
   }
 
   return REC_ERR_OKAY;
@@ -134,18 +225,20 @@ raw_stat_clear(RecRawStatBlock *rsb, int id)
     ink_atomic_swap(&(rsb->global[id]->last_sum), (int64_t)0);
     ink_atomic_swap(&(rsb->global[id]->count), (int64_t)0);
     ink_atomic_swap(&(rsb->global[id]->last_count), (int64_t)0);
-  }
-  // reset the local stats
-  for (EThread *et : eventProcessor.active_ethreads()) {
-    RecRawStat *tlp = thread_stat(et, rsb, id);
-    ink_atomic_swap(&(tlp->sum), (int64_t)0);
-    ink_atomic_swap(&(tlp->count), (int64_t)0);
-  }
 
-  for (EThread *et : eventProcessor.active_dthreads()) {
-    RecRawStat *tlp = thread_stat(et, rsb, id);
-    ink_atomic_swap(&(tlp->sum), (int64_t)0);
-    ink_atomic_swap(&(tlp->count), (int64_t)0);
+    // reset the local stats, with the lock so that a fold doesn't see them half done
+    for (EThread *et : eventProcessor.active_ethreads()) {
+      RecRawStat *tlp = thread_stat(et, rsb, id);
+      ink_atomic_swap(&(tlp->sum), (int64_t)0);
+      ink_atomic_swap(&(tlp->count), (int64_t)0);
+    }
+
+    for (EThread *et : eventProcessor.active_dthreads()) {
+      RecRawStat *tlp = thread_stat(et, rsb, id);
+      ink_atomic_swap(&(tlp->sum), (int64_t)0);
+      ink_atomic_swap(&(tlp->count), (int64_t)0);
+    }
+    raw_stat_clear_seen(rsb, id, true, true);
   }
 
   return REC_ERR_OKAY;
@@ -165,17 +258,18 @@ raw_stat_clear_sum(RecRawStatBlock *rsb, int id)
     ink_scoped_mutex_lock lock(rsb->mutex);
     ink_atomic_swap(&(rsb->global[id]->sum), (int64_t)0);
     ink_atomic_swap(&(rsb->global[id]->last_sum), (int64_t)0);
-  }
 
-  // reset the local stats
-  for (EThread *et : eventProcessor.active_ethreads()) {
-    RecRawStat *tlp = thread_stat(et, rsb, id);
-    ink_atomic_swap(&(tlp->sum), (int64_t)0);
-  }
+    // reset the local stats
+    for (EThread *et : eventProcessor.active_ethreads()) {
+      RecRawStat *tlp = thread_stat(et, rsb, id);
+      ink_atomic_swap(&(tlp->sum), (int64_t)0);
+    }
 
-  for (EThread *et : eventProcessor.active_dthreads()) {
-    RecRawStat *tlp = thread_stat(et, rsb, id);
-    ink_atomic_swap(&(tlp->sum), (int64_t)0);
+    for (EThread *et : eventProcessor.active_dthreads()) {
+      RecRawStat *tlp = thread_stat(et, rsb, id);
+      ink_atomic_swap(&(tlp->sum), (int64_t)0);
+    }
+    raw_stat_clear_seen(rsb, id, true, false);
   }
 
   return REC_ERR_OKAY;
@@ -195,17 +289,18 @@ raw_stat_clear_count(RecRawStatBlock *rsb, int id)
     ink_scoped_mutex_lock lock(rsb->mutex);
     ink_atomic_swap(&(rsb->global[id]->count), (int64_t)0);
     ink_atomic_swap(&(rsb->global[id]->last_count), (int64_t)0);
-  }
 
-  // reset the local stats
-  for (EThread *et : eventProcessor.active_ethreads()) {
-    RecRawStat *tlp = thread_stat(et, rsb, id);
-    ink_atomic_swap(&(tlp->count), (int64_t)0);
-  }
+    // reset the local stats
+    for (EThread *et : eventProcessor.active_ethreads()) {
+      RecRawStat *tlp = thread_stat(et, rsb, id);
+      ink_atomic_swap(&(tlp->count), (int64_t)0);
+    }
 
-  for (EThread *et : eventProcessor.active_dthreads()) {
-    RecRawStat *tlp = thread_stat(et, rsb, id);
-    ink_atomic_swap(&(tlp->count), (int64_t)0);
+    for (EThread *et : eventProcessor.active_dthreads()) {
+      RecRawStat *tlp = thread_stat(et, rsb, id);
+      ink_atomic_swap(&(tlp->count), (int64_t)0);
+    }
+    raw_stat_clear_seen(rsb, id, false, true);
   }
 
   return REC_ERR_OKAY;
@@ -220,8 +315,10 @@ RecAllocateRawStatBlock(int num_stats)
   off_t ethr_stat_offset;
   RecRawStatBlock *rsb;
 
-  // allocate thread-local raw-stat memory
-  if ((ethr_stat_offset = eventProcessor.allocate(num_stats * sizeof(RecRawStat))) == -1) {
+  // allocate thread-local raw-stat memory, and the dirty bitmap with a cache line of padding on both sides
+  int stat_size  = INK_ALIGN(num_stats * sizeof(RecRawStat), REC_CACHE_LINE_SIZE);
+  int dirty_size = INK_ALIGN((num_stats + 63) / 64 * sizeof(uint64_t), REC_CACHE_LINE_SIZE);
+  if ((ethr_stat_offset = eventProcessor.allocate(stat_size + REC_CACHE_LINE_SIZE + dirty_size + REC_CACHE_LINE_SIZE)) == -1) {
     return nullptr;
   }
 
@@ -232,11 +329,15 @@ RecAllocateRawStatBlock(int num_stats)
   rsb->global = (RecRawStat **)ats_malloc(num_stats * sizeof(RecRawStat *));
   memset(rsb->global, 0, num_stats * sizeof(RecRawStat *));
 
-  rsb->num_stats        = 0;
-  rsb->max_stats        = num_stats;
-  rsb->ethr_stat_offset = ethr_stat_offset;
+  rsb->num_stats         = 0;
+  rsb->max_stats         = num_stats;
+  rsb->ethr_stat_offset  = ethr_stat_offset;
+  rsb->ethr_dirty_offset = ethr_stat_offset + stat_size + REC_CACHE_LINE_SIZE;
 
   ink_mutex_init(&(rsb->mutex));
+
+  std::lock_guard<std::mutex> lock(raw_stat_blocks_mutex);
+  raw_stat_blocks.push_back(rsb);
   return rsb;
 }
 
@@ -285,6 +386,140 @@ Ldone:
   return err;
 }
 
+//-------------------------------------------------------------------------
+// RecRegisterRawStatHistogram
+//-------------------------------------------------------------------------
+
+// The sync callback of the .count record brings the buckets up to date, the
+// other records of the histogram are registered after it, so they are
+// synced after it and only read the globals.
+static int
+raw_stat_sync_histogram_count(const char *name, RecDataT data_type, RecData *data, RecRawStatBlock *rsb, int id)
+{
+  int64_t count = 0;
+
+  Debug("stats", "raw sync:histogram count for %s", name);
+  for (int i = 0; i < REC_HISTOGRAM_BUCKETS; i++) {
+    raw_stat_sync_to_global(rsb, id + i);
+    count += rsb->global[id + i]->count;
+  }
+  RecDataSetFromInt64(data_type, data, count);
+
+  return REC_ERR_OKAY;
+}
+
+static int
+raw_stat_sync_histogram_sum(const char *name, RecDataT data_type, RecData *data, RecRawStatBlock *rsb, int id)
+{
+  int64_t sum = 0;
+
+  Debug("stats", "raw sync:histogram sum for %s", name);
+  for (int i = 0; i < REC_HISTOGRAM_BUCKETS; i++) {
+    sum += rsb->global[id + i]->sum;
+  }
+  RecDataSetFromInt64(data_type, data, sum);
+
+  return REC_ERR_OKAY;
+}
+
+template <int PERMILLE>
+static int
+raw_stat_sync_histogram_percentile(const char *name, RecDataT data_type, RecData *data, RecRawStatBlock *rsb, int id)
+{
+  int64_t counts[REC_HISTOGRAM_BUCKETS];
+
+  Debug("stats", "raw sync:histogram percentile for %s", name);
+  for (int i = 0; i < REC_HISTOGRAM_BUCKETS; i++) {
+    counts[i] = rsb->global[id + i]->count;
+  }
+  RecDataSetFromInt64(data_type, data, RecRawStatHistogramPercentile(counts, PERMILLE));
+
+  return REC_ERR_OKAY;
+}
+
+static const struct {
+  const char *suffix;
+  RecRawStatSyncCb sync_cb;
+} histogram_records[] = {
+  {"count", raw_stat_sync_histogram_count},
+  {"sum", raw_stat_sync_histogram_sum},
+  {"p50", raw_stat_sync_histogram_percentile<500>},
+  {"p90", raw_stat_sync_histogram_percentile<900>},
+  {"p99", raw_stat_sync_histogram_percentile<990>},
+  {"p999", raw_stat_sync_histogram_percentile<999>},
+};
+
+static bool
+raw_stat_is_histogram(RecRawStatSyncCb sync_cb)
+{
+  for (auto const &hr : histogram_records) {
+    if (hr.sync_cb == sync_cb) {
+      return true;
+    }
+  }
+  return false;
+}
+
+int
+RecRegisterRawStatHistogram(RecRawStatBlock *rsb, RecT rec_type, const char *name, int id)
+{
+  Debug("stats", "RecRegisterRawStatHistogram(%s): rsb pointer:%p id:%d", name, rsb, id);
+
+  // check to see if we're good to proceed
+  ink_assert(id + REC_HISTOGRAM_BUCKETS <= rsb->max_stats);
+
+  RecData data_default;
+  memset(&data_default, 0, sizeof(RecData));
+
+  // The buckets have no record of their own to keep their globals in.
+  RecRawStat *buckets = static_cast<RecRawStat *>(ats_calloc(REC_HISTOGRAM_BUCKETS, sizeof(RecRawStat)));
+  for (int i = 0; i < REC_HISTOGRAM_BUCKETS; i++) {
+    rsb->global[id + i] = &buckets[i];
+  }
+
+  for (auto const &hr : histogram_records) {
+    std::string record_name = std::string(name) + '.' + hr.suffix;
+    RecRecord *r            = RecRegisterStat(rec_type, record_name.c_str(), RECD_INT, data_default, RECP_NON_PERSISTENT);
+
+    if (r == nullptr) {
+      return REC_ERR_FAIL;
+    }
+
+    r->rsb_id = id;
+    if (i_am_the_record_owner(r->rec_type)) {
+      r->sync_required = r->sync_required | REC_PEER_SYNC_REQUIRED;
+    } else {
+      send_register_message(r);
+    }
+    RecRegisterRawStatSyncCb(record_name.c_str(), hr.sync_cb, rsb, id);
+  }
+
+  return REC_ERR_OKAY;
+}
+
+int64_t
+RecRawStatHistogramPercentile(const int64_t *counts, int permille)
+{
+  int64_t total = 0;
+  for (int i = 0; i < REC_HISTOGRAM_BUCKETS; i++) {
+    total += counts[i];
+  }
+  if (total <= 0) {
+    return 0;
+  }
+
+  // the smallest value that is at least as large as permille of the values
+  int64_t rank = (total * permille + 999) / 1000;
+  int64_t seen = 0;
+  for (int i = 0; i < REC_HISTOGRAM_BUCKETS; i++) {
+    seen += counts[i];
+    if (seen >= rank) {
+      return RecRawStatHistogramBucketMax(i);
+    }
+  }
+  return RecRawStatHistogramBucketMax(REC_HISTOGRAM_BUCKETS - 1);
+}
+
 //-------------------------------------------------------------------------
 // RecRawStatSync...
 //-------------------------------------------------------------------------
@@ -572,13 +807,31 @@ RecExecRawStatSyncCbs()
   RecRecord *r;
   int i, num_records;
 
+  // Fold each block once, rather than each stat from every thread.
+  {
+    std::lock_guard<std::mutex> lock(raw_stat_blocks_mutex);
+    for (RecRawStatBlock *rsb : raw_stat_blocks) {
+      raw_stat_fold(rsb, -1);
+    }
+  }
+  raw_stat_folded = true;
+
   num_records = g_num_records;
   for (i = 0; i < num_records; i++) {
     r = &(g_records[i]);
     rec_mutex_acquire(&(r->lock));
     if (REC_TYPE_IS_STAT(r->rec_type)) {
       if (r->stat_meta.sync_cb) {
-        if (r->version && r->version != r->stat_meta.sync_rsb->global[r->stat_meta.sync_id]->version) {
+        // The records of a histogram share its first bucket, only the .count record owns its version.
+        bool histogram = raw_stat_is_histogram(r->stat_meta.sync_cb);
+        if (r->version && r->version != r->stat_meta.sync_rsb->global[r->stat_meta.sync_id]->version &&
+            (!histogram || r->stat_meta.sync_cb == raw_stat_sync_histogram_count)) {
+          if (histogram) {
+            // clearing the .count record of a histogram clears all of its buckets
+            for (int b = 1; b < REC_HISTOGRAM_BUCKETS; b++) {
+              raw_stat_clear(r->stat_meta.sync_rsb, r->stat_meta.sync_id + b);
+            }
+          }
           raw_stat_clear(r->stat_meta.sync_rsb, r->stat_meta.sync_id);
           r->stat_meta.sync_rsb->global[r->stat_meta.sync_id]->version = r->version;
         } else {
@@ -589,6 +842,7 @@ RecExecRawStatSyncCbs()
     }
     rec_mutex_release(&(r->lock));
   }
+  raw_stat_folded = false;
 
   return REC_ERR_OKAY;
 }
@@ -0,0 +1,279 @@
+/** @file
+
+  A snapshot of the stats in a shared memory segment
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ */
+
+#include "tscore/ink_platform.h"
+#include "tscore/I_Layout.h"
+#include "RecordsConfig.h"
+#include "I_RecStatsShm.h"
+#include "P_RecCore.h"
+#include "P_RecUtils.h"
+
+#include <algorithm>
+#include <ctime>
+#include <vector>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+namespace
+{
+constexpr size_t ENTRIES_OFFSET = REC_STATS_SHM_ENTRIES_OFFSET;
+
+// Attempts to read a snapshot before giving up on a busy writer.
+constexpr int READ_ATTEMPTS = 10;
+
+RecStatsShmHeader *shm_header = nullptr;
+
+inline const RecStatsShmEntry *
+shm_entries(const RecStatsShmHeader *h)
+{
+  return reinterpret_cast<const RecStatsShmEntry *>(reinterpret_cast<const char *>(h) + ENTRIES_OFFSET);
+}
+
+inline RecStatsShmEntry *
+shm_entries(RecStatsShmHeader *h)
+{
+  return reinterpret_cast<RecStatsShmEntry *>(reinterpret_cast<char *>(h) + ENTRIES_OFFSET);
+}
+
+inline const char *
+shm_strings(const RecStatsShmHeader *h)
+{
+  return reinterpret_cast<const char *>(shm_entries(h) + h->capacity);
+}
+
+inline char *
+shm_strings(RecStatsShmHeader *h)
+{
+  return reinterpret_cast<char *>(shm_entries(h) + h->capacity);
+}
+} // namespace
+
+//-------------------------------------------------------------------------
+// RecStatsShmPath
+//-------------------------------------------------------------------------
+std::string
+RecStatsShmPath()
+{
+  return Layout::relative_to(RecConfigReadRuntimeDir(), REC_STATS_SHM_FILE);
+}
+
+//-------------------------------------------------------------------------
+// RecStatsShmInit
+//-------------------------------------------------------------------------
+void
+RecStatsShmInit()
+{
+  RecInt enabled = 0;
+  if (shm_header || RecGetRecordInt("proxy.config.stats.shm_enabled", &enabled) != REC_ERR_OKAY || !enabled) {
+    return;
+  }
+
+  std::string path = RecStatsShmPath();
+  size_t size      = ENTRIES_OFFSET + max_records_entries * (sizeof(RecStatsShmEntry) + REC_STATS_SHM_STRING_SPACE);
+
+  // A new file, a reader may still have the one of a previous run mapped.
+  ::unlink(path.c_str());
+  int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+  if (fd < 0 || ftruncate(fd, size) < 0) {
+    RecLog(DL_Warning, "could not create the stats segment %s: %s", path.c_str(), strerror(errno));
+    if (fd >= 0) {
+      ::close(fd);
+    }
+    return;
+  }
+  void *base = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  ::close(fd);
+  if (base == MAP_FAILED) {
+    RecLog(DL_Warning, "could not map the stats segment %s: %s", path.c_str(), strerror(errno));
+    return;
+  }
+
+  RecStatsShmHeader *h = static_cast<RecStatsShmHeader *>(base);
+  h->version           = REC_STATS_SHM_VERSION;
+  h->capacity          = max_records_entries;
+  h->count             = 0;
+  h->updated           = 0;
+  h->string_space      = max_records_entries * REC_STATS_SHM_STRING_SPACE;
+  h->string_used       = 0;
+  h->generation.store(0, std::memory_order_relaxed);
+  // The magic goes last, a reader ignores the segment until the header is complete.
+  std::atomic_thread_fence(std::memory_order_release);
+  h->magic   = REC_STATS_SHM_MAGIC;
+  shm_header = h;
+  RecDebug(DL_Debug, "writing the stats to %s", path.c_str());
+}
+
+//-------------------------------------------------------------------------
+// RecStatsShmUpdate
+//-------------------------------------------------------------------------
+void
+RecStatsShmUpdate()
+{
+  if (shm_header == nullptr) {
+    return;
+  }
+
+  RecStatsShmEntry *entries = shm_entries(shm_header);
+  char *strings             = shm_strings(shm_header);
+  uint32_t count            = 0;
+  uint32_t string_used      = 0;
+  uint64_t generation       = shm_header->generation.load(std::memory_order_relaxed);
+
+  shm_header->generation.store(generation + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+
+  int num_records = g_num_records;
+  for (int i = 0; i < num_records && count < shm_header->capacity; ++i) {
+    RecRecord *r = &(g_records[i]);
+    if (!REC_TYPE_IS_STAT(r->rec_type) || !r->registered) {
+      continue;
+    }
+    size_t len = strlen(r->name);
+    if (len >= REC_STATS_SHM_NAME_LEN) {
+      continue;
+    }
+
+    RecStatsShmEntry &entry = entries[count];
+    bool stored             = true;
+    rec_mutex_acquire(&(r->lock));
+    switch (r->data_type) {
+    case RECD_INT:
+      entry.value.rec_int = r->data.rec_int;
+      break;
+    case RECD_COUNTER:
+      entry.value.rec_int = r->data.rec_counter;
+      break;
+    case RECD_FLOAT:
+      entry.value.rec_float = r->data.rec_float;
+      break;
+    case RECD_STRING: {
+      // The string space is shared, a string that doesn't fit any more is left out.
+      const char *str = r->data.rec_string ? r->data.rec_string : "";
+      size_t str_len  = strlen(str);
+      stored          = string_used + str_len + 1 <= shm_header->string_space;
+      if (stored) {
+        memcpy(strings + string_used, str, str_len + 1);
+        entry.value.rec_string.offset = string_used;
+        entry.value.rec_string.len    = str_len;
+        string_used += str_len + 1;
+      }
+      break;
+    }
+    default:
+      stored = false;
+      break;
+    }
+    rec_mutex_release(&(r->lock));
+
+    if (stored) {
+      memcpy(entry.name, r->name, len + 1);
+      entry.data_type = r->data_type;
+      entry.reserved  = 0;
+      ++count;
+    }
+  }
+  shm_header->count       = count;
+  shm_header->string_used = string_used;
+  shm_header->updated     = time(nullptr);
+
+  shm_header->generation.store(generation + 2, std::memory_order_release);
+}
+
+//-------------------------------------------------------------------------
+// RecStatsShmRead
+//-------------------------------------------------------------------------
+bool
+RecStatsShmRead(const char *path, const RecStatsShmEntryCb &cb, int64_t *updated)
+{
+  int fd = ::open(path, O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    return false;
+  }
+  struct stat st;
+  if (fstat(fd, &st) < 0 || static_cast<size_t>(st.st_size) < ENTRIES_OFFSET) {
+    ::close(fd);
+    return false;
+  }
+  void *base = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  ::close(fd);
+  if (base == MAP_FAILED) {
+    return false;
+  }
+
+  const RecStatsShmHeader *h = static_cast<const RecStatsShmHeader *>(base);
+  std::vector<RecStatsShmEntry> snapshot;
+  std::vector<char> strings;
+  bool consistent = false;
+
+  if (h->magic == REC_STATS_SHM_MAGIC && h->version == REC_STATS_SHM_VERSION &&
+      ENTRIES_OFFSET + static_cast<size_t>(h->capacity) * sizeof(RecStatsShmEntry) + h->string_space <=
+        static_cast<size_t>(st.st_size)) {
+    for (int attempt = 0; attempt < READ_ATTEMPTS && !consistent; ++attempt) {
+      uint64_t generation = h->generation.load(std::memory_order_acquire);
+      if (generation & 1) {
+        usleep(1000);
+        continue;
+      }
+      const RecStatsShmEntry *entries = shm_entries(h);
+      const char *string_space        = shm_strings(h);
+      snapshot.assign(entries, entries + std::min(h->count, h->capacity));
+      strings.assign(string_space, string_space + std::min(h->string_used, h->string_space));
+      int64_t when = h->updated;
+      std::atomic_thread_fence(std::memory_order_acquire);
+      consistent = h->generation.load(std::memory_order_relaxed) == generation;
+      if (consistent && updated) {
+        *updated = when;
+      }
+    }
+  }
+  munmap(base, st.st_size);
+
+  if (consistent) {
+    for (auto &entry : snapshot) {
+      RecData data;
+      entry.name[REC_STATS_SHM_NAME_LEN - 1] = '\0';
+      switch (entry.data_type) {
+      case RECD_INT:
+        data.rec_int = entry.value.rec_int;
+        break;
+      case RECD_COUNTER:
+        data.rec_counter = entry.value.rec_int;
+        break;
+      case RECD_FLOAT:
+        data.rec_float = entry.value.rec_float;
+        break;
+      case RECD_STRING:
+        if (static_cast<size_t>(entry.value.rec_string.offset) + entry.value.rec_string.len >= strings.size()) {
+          continue;
+        }
+        data.rec_string                             = strings.data() + entry.value.rec_string.offset;
+        data.rec_string[entry.value.rec_string.len] = '\0';
+        break;
+      default:
+        continue;
+      }
+      cb(entry.name, static_cast<RecDataT>(entry.data_type), data);
+    }
+  }
+  return consistent;
+}
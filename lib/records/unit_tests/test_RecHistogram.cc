@@ -0,0 +1,76 @@
+/** @file
+
+   Catch-based tests for the raw stat histograms.
+
+   @section license License
+
+   Licensed to the Apache Software Foundation (ASF) under one or more contributor license agreements.
+   See the NOTICE file distributed with this work for additional information regarding copyright
+   ownership.  The ASF licenses this file to you under the Apache License, Version 2.0 (the
+   "License"); you may not use this file except in compliance with the License.  You may obtain a
+   copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software distributed under the License
+   is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+   or implied. See the License for the specific language governing permissions and limitations under
+   the License.
+ */
+
+#include <algorithm>
+#include <array>
+
+#include "catch.hpp"
+
+#include "records/I_RecProcess.h"
+
+TEST_CASE("RecHistogram", "[librecords][RecHistogram]")
+{
+  SECTION("buckets")
+  {
+    for (int64_t v = 0; v < REC_HISTOGRAM_SUB_BUCKETS; ++v) {
+      REQUIRE(RecRawStatHistogramBucket(v) == v);
+    }
+    REQUIRE(RecRawStatHistogramBucket(-1) == 0);
+    REQUIRE(RecRawStatHistogramBucket(int64_t(1) << 40) == REC_HISTOGRAM_BUCKETS - 1);
+    REQUIRE(RecRawStatHistogramBucketMax(REC_HISTOGRAM_BUCKETS - 1) == (int64_t(1) << REC_HISTOGRAM_MAX_BITS) - 1);
+
+    // Every value is in the bucket that ends at or above it, and right after the one before.
+    int64_t low = 0;
+    for (int b = 0; b < REC_HISTOGRAM_BUCKETS; ++b) {
+      int64_t high = RecRawStatHistogramBucketMax(b);
+      REQUIRE(high >= low);
+      REQUIRE(RecRawStatHistogramBucket(low) == b);
+      REQUIRE(RecRawStatHistogramBucket(high) == b);
+      // A bucket is never wider than an eighth of its values.
+      REQUIRE((high - low) * REC_HISTOGRAM_SUB_BUCKETS <= std::max<int64_t>(low, REC_HISTOGRAM_SUB_BUCKETS));
+      low = high + 1;
+    }
+  }
+
+  SECTION("percentiles")
+  {
+    std::array<int64_t, REC_HISTOGRAM_BUCKETS> counts{};
+    REQUIRE(RecRawStatHistogramPercentile(counts.data(), 500) == 0);
+
+    for (int64_t v = 1; v <= 1000; ++v) {
+      ++counts[RecRawStatHistogramBucket(v)];
+    }
+    struct {
+      int permille;
+      int64_t value;
+    } const expected[] = {{500, 500}, {900, 900}, {990, 990}, {999, 999}};
+    for (auto const &e : expected) {
+      int64_t p = RecRawStatHistogramPercentile(counts.data(), e.permille);
+      REQUIRE(p >= e.value);
+      REQUIRE(p <= e.value + e.value / REC_HISTOGRAM_SUB_BUCKETS);
+    }
+
+    // A single value is every percentile.
+    counts.fill(0);
+    counts[RecRawStatHistogramBucket(3)] = 10;
+    REQUIRE(RecRawStatHistogramPercentile(counts.data(), 500) == 3);
+    REQUIRE(RecRawStatHistogramPercentile(counts.data(), 999) == 3);
+  }
+}
@@ -0,0 +1,143 @@
+/** @file
+
+   Catch-based tests for reading the shared stats segment.
+
+   @section license License
+
+   Licensed to the Apache Software Foundation (ASF) under one or more contributor license agreements.
+   See the NOTICE file distributed with this work for additional information regarding copyright
+   ownership.  The ASF licenses this file to you under the Apache License, Version 2.0 (the
+   "License"); you may not use this file except in compliance with the License.  You may obtain a
+   copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software distributed under the License
+   is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+   or implied. See the License for the specific language governing permissions and limitations under
+   the License.
+ */
+
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+#include "catch.hpp"
+
+#include "records/I_RecStatsShm.h"
+
+namespace
+{
+constexpr uint32_t CAPACITY = 4;
+
+// A segment as the server lays it out, with an int, a float and a string stat.
+std::vector<char>
+make_segment()
+{
+  std::vector<char> segment(REC_STATS_SHM_ENTRIES_OFFSET + CAPACITY * (sizeof(RecStatsShmEntry) + REC_STATS_SHM_STRING_SPACE));
+  RecStatsShmHeader *h = reinterpret_cast<RecStatsShmHeader *>(segment.data());
+  RecStatsShmEntry *e  = reinterpret_cast<RecStatsShmEntry *>(segment.data() + REC_STATS_SHM_ENTRIES_OFFSET);
+  char *strings        = reinterpret_cast<char *>(e + CAPACITY);
+  h->magic             = REC_STATS_SHM_MAGIC;
+  h->version           = REC_STATS_SHM_VERSION;
+  h->capacity          = CAPACITY;
+  h->count             = 3;
+  h->updated           = 1234;
+  h->string_space      = CAPACITY * REC_STATS_SHM_STRING_SPACE;
+  h->string_used       = 5;
+  h->generation        = 2;
+  strcpy(e[0].name, "proxy.process.a");
+  e[0].data_type     = RECD_INT;
+  e[0].value.rec_int = 42;
+  strcpy(e[1].name, "proxy.process.b");
+  e[1].data_type       = RECD_FLOAT;
+  e[1].value.rec_float = 0.5;
+  strcpy(e[2].name, "proxy.process.c");
+  e[2].data_type               = RECD_STRING;
+  e[2].value.rec_string.offset = 0;
+  e[2].value.rec_string.len    = 4;
+  memcpy(strings, "down", 5);
+  return segment;
+}
+
+std::string
+write_segment(const std::vector<char> &segment)
+{
+  char path[] = "/tmp/test_RecStatsShm.XXXXXX";
+  int fd      = mkstemp(path);
+  REQUIRE(fd >= 0);
+  REQUIRE(write(fd, segment.data(), segment.size()) == static_cast<ssize_t>(segment.size()));
+  close(fd);
+  return path;
+}
+
+bool
+read_segment(const std::string &path, std::map<std::string, std::string> &stats, int64_t *updated = nullptr)
+{
+  return RecStatsShmRead(
+    path.c_str(),
+    [&stats](const char *name, RecDataT data_type, const RecData &data) {
+      if (data_type == RECD_STRING) {
+        stats[name] = data.rec_string;
+      } else if (data_type == RECD_FLOAT) {
+        stats[name] = std::to_string(data.rec_float);
+      } else {
+        stats[name] = std::to_string(data.rec_int);
+      }
+    },
+    updated);
+}
+} // namespace
+
+TEST_CASE("RecStatsShm", "[librecords][RecStatsShm]")
+{
+  std::map<std::string, std::string> stats;
+
+  SECTION("snapshot")
+  {
+    std::string path = write_segment(make_segment());
+    int64_t updated  = 0;
+    REQUIRE(read_segment(path, stats, &updated));
+    REQUIRE(updated == 1234);
+    REQUIRE(stats.size() == 3);
+    REQUIRE(stats["proxy.process.a"] == "42");
+    REQUIRE(stats["proxy.process.b"] == std::to_string(0.5f));
+    REQUIRE(stats["proxy.process.c"] == "down");
+    unlink(path.c_str());
+  }
+
+  SECTION("being written")
+  {
+    std::vector<char> segment = make_segment();
+    reinterpret_cast<RecStatsShmHeader *>(segment.data())->generation = 3;
+    std::string path                                                = write_segment(segment);
+    REQUIRE_FALSE(read_segment(path, stats));
+    REQUIRE(stats.empty());
+    unlink(path.c_str());
+  }
+
+  SECTION("not a segment")
+  {
+    std::vector<char> segment = make_segment();
+    reinterpret_cast<RecStatsShmHeader *>(segment.data())->version = REC_STATS_SHM_VERSION + 1;
+    std::string path                                             = write_segment(segment);
+    REQUIRE_FALSE(read_segment(path, stats));
+    unlink(path.c_str());
+
+    REQUIRE_FALSE(read_segment("/nonexistent/stats.shm", stats));
+  }
+
+  SECTION("string out of bounds")
+  {
+    std::vector<char> segment = make_segment();
+    reinterpret_cast<RecStatsShmHeader *>(segment.data())->string_used = 2;
+    std::string path                                                 = write_segment(segment);
+    REQUIRE(read_segment(path, stats));
+    REQUIRE(stats.size() == 2);
+    REQUIRE(stats.count("proxy.process.c") == 0);
+    unlink(path.c_str());
+  }
+}
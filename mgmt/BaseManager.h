@@ -59,6 +59,8 @@
 #define MGMT_EVENT_DRAIN 10013
 #define MGMT_EVENT_HOST_STATUS_UP 10014
 #define MGMT_EVENT_HOST_STATUS_DOWN 10015
+#define MGMT_EVENT_DISPATCH_TRACE 10016
+#define MGMT_EVENT_CPU_PROFILE 10017
 
 /***********************************************************************
  *
@@ -459,6 +459,12 @@ ProcessManager::handleMgmtMsgFromLM(MgmtMessageHdr *mh)
   case MGMT_EVENT_HOST_STATUS_DOWN:
     executeMgmtCallback(MGMT_EVENT_HOST_STATUS_DOWN, payload);
     break;
+  case MGMT_EVENT_DISPATCH_TRACE:
+    executeMgmtCallback(MGMT_EVENT_DISPATCH_TRACE, payload);
+    break;
+  case MGMT_EVENT_CPU_PROFILE:
+    executeMgmtCallback(MGMT_EVENT_CPU_PROFILE, payload);
+    break;
   case MGMT_EVENT_ROLL_LOG_FILES:
     executeMgmtCallback(MGMT_EVENT_ROLL_LOG_FILES, {});
     break;
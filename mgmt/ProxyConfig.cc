@@ -29,6 +29,49 @@
 
 ConfigProcessor configProcessor;
 
+namespace
+{
+/// References to a config cached by an event thread.
+struct ConfigCache {
+  ConfigInfo *info = nullptr; ///< The config the references are to.
+  int refs         = 0;       ///< References to @a info owned by the thread, not handed out yet.
+};
+
+// The references taken from a config at once, and the most a thread keeps.
+constexpr int CONFIG_CACHE_REFS     = 64;
+constexpr int CONFIG_CACHE_REFS_MAX = 4 * CONFIG_CACHE_REFS;
+
+thread_local ConfigCache config_cache[MAX_CONFIGS];
+
+void
+config_cache_drop(unsigned int id, ConfigCache &cache)
+{
+  ConfigInfo *info = cache.info;
+  int refs         = cache.refs;
+
+  cache.info = nullptr;
+  cache.refs = 0;
+  if (info && refs > 0 && info->refcount_add(-refs) == 0) {
+    Debug("config", "Release config %d 0x%" PRId64, id, (int64_t)info);
+    delete info;
+  }
+}
+
+// Run on each event thread when a config is replaced, so that a thread that does not get that
+// config again does not keep the old one alive.
+struct ConfigCacheFlusher : public Continuation {
+  explicit ConfigCacheFlusher(EThread *t) : Continuation(t->mutex) { SET_HANDLER(&ConfigCacheFlusher::handle_event); }
+
+  int
+  handle_event(int /* event ATS_UNUSED */, void * /* edata ATS_UNUSED */)
+  {
+    configProcessor.flush_thread_cache();
+    delete this;
+    return EVENT_DONE;
+  }
+};
+} // namespace
+
 void *
 config_int_cb(void *data, void *value)
 {
@@ -148,6 +191,10 @@ ConfigProcessor::set(unsigned int id, ConfigInfo *info, unsigned timeout_secs)
     // some other thread might also have one ...
     ink_assert(old_info->refcount() > 0);
     eventProcessor.schedule_in(new ConfigInfoReleaser(id, old_info), HRTIME_SECONDS(timeout_secs));
+
+    for (EThread *t : eventProcessor.active_ethreads()) {
+      t->schedule_imm(new ConfigCacheFlusher(t));
+    }
   }
 
   return id;
@@ -169,9 +216,25 @@ ConfigProcessor::get(unsigned int id)
   idx  = id - 1;
   info = infos[idx];
 
-  // Hand out a refcount to the caller. We should still have out
-  // own refcount, so it should be at least 2.
-  ink_release_assert(info->refcount_inc() > 1);
+  if (this_event_thread() == nullptr) {
+    // Hand out a refcount to the caller. We should still have out
+    // own refcount, so it should be at least 2.
+    ink_release_assert(info->refcount_inc() > 1);
+    return info;
+  }
+
+  // Hand out one of the references of this thread, taking a new batch when they run out. Reading
+  // the current config does not write to shared memory, so the threads don't contend here.
+  ConfigCache &cache = config_cache[idx];
+  if (cache.info != info) {
+    config_cache_drop(id, cache);
+    cache.info = info;
+  }
+  if (cache.refs == 0) {
+    ink_release_assert(info->refcount_add(CONFIG_CACHE_REFS) > CONFIG_CACHE_REFS);
+    cache.refs = CONFIG_CACHE_REFS;
+  }
+  --cache.refs;
   return info;
 }
 
@@ -187,6 +250,15 @@ ConfigProcessor::release(unsigned int id, ConfigInfo *info)
 
   idx = id - 1;
 
+  // A reference to the current config goes back to this thread's batch, if it has one.
+  if (info && this_event_thread() != nullptr) {
+    ConfigCache &cache = config_cache[idx];
+    if (cache.info == info && info == this->infos[idx] && cache.refs < CONFIG_CACHE_REFS_MAX) {
+      ++cache.refs;
+      return;
+    }
+  }
+
   if (info && info->refcount_dec() == 0) {
     // When we release, we should already have replaced this object in the index.
     Debug("config", "Release config %d 0x%" PRId64, id, (int64_t)info);
@@ -195,6 +267,17 @@ ConfigProcessor::release(unsigned int id, ConfigInfo *info)
   }
 }
 
+void
+ConfigProcessor::flush_thread_cache()
+{
+  for (int id = 1; id <= ninfos && id <= MAX_CONFIGS; ++id) {
+    ConfigCache &cache = config_cache[id - 1];
+    if (cache.info && cache.info != infos[id - 1]) {
+      config_cache_drop(id, cache);
+    }
+  }
+}
+
 #if TS_HAS_TESTS
 
 enum {
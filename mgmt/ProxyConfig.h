@@ -75,9 +75,19 @@ public:
   };
 
   unsigned int set(unsigned int id, ConfigInfo *info, unsigned timeout_secs = CONFIG_PROCESSOR_RELEASE_SECS);
+
+  /** Get a reference to the current config of @a id, to be given back with release().
+
+      On an event thread this does not touch the reference count of the config. Each event thread
+      takes a batch of references at once and hands them out, and the references released on that
+      thread go back to its batch. The batch is returned when the config is replaced.
+   */
   ConfigInfo *get(unsigned int id);
   void release(unsigned int id, ConfigInfo *data);
 
+  /// Return the references cached by this thread for the configs that were replaced.
+  void flush_thread_cache();
+
 public:
   std::atomic<ConfigInfo *> infos[MAX_CONFIGS] = {nullptr};
   std::atomic<int> ninfos{0};
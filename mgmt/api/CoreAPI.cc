@@ -478,6 +478,37 @@ StorageDeviceCmdOffline(const char *dev)
   lmgmt->signalEvent(MGMT_EVENT_STORAGE_DEVICE_CMD_OFFLINE, dev);
   return TS_ERR_OKAY;
 }
+/*-------------------------------------------------------------------------
+ * DispatchTraceDump
+ *-------------------------------------------------------------------------
+ * Write the continuation dispatch trace of traffic_server to @a path.
+ */
+TSMgmtError
+DispatchTraceDump(const char *path)
+{
+  lmgmt->signalEvent(MGMT_EVENT_DISPATCH_TRACE, path ? path : "");
+  return TS_ERR_OKAY;
+}
+
+/*-------------------------------------------------------------------------
+ * CpuProfileDump
+ *-------------------------------------------------------------------------
+ * Write the CPU profile of traffic_server to @a path. traffic_server gets
+ * a '1' or a '0' for each of TS_PROFILE_OPT_PPROF and TS_PROFILE_OPT_RESET,
+ * followed by the path.
+ */
+TSMgmtError
+CpuProfileDump(const char *path, unsigned options)
+{
+  std::string msg;
+
+  msg += (options & TS_PROFILE_OPT_PPROF) ? '1' : '0';
+  msg += (options & TS_PROFILE_OPT_RESET) ? '1' : '0';
+  msg += path ? path : "";
+  lmgmt->signalEvent(MGMT_EVENT_CPU_PROFILE, msg.c_str());
+  return TS_ERR_OKAY;
+}
+
 /*-------------------------------------------------------------------------
  * Lifecycle Message
  *-------------------------------------------------------------------------
@@ -52,6 +52,8 @@ TSMgmtError Bounce(unsigned options);
 TSMgmtError Stop(unsigned options);                                                // stop traffic_server
 TSMgmtError Drain(unsigned options);                                               // drain requests of traffic_server
 TSMgmtError StorageDeviceCmdOffline(const char *dev);                              // Storage device operation.
+TSMgmtError DispatchTraceDump(const char *path);                                   // Write out the dispatch trace.
+TSMgmtError CpuProfileDump(const char *path, unsigned options);                    // Write out the CPU profile.
 TSMgmtError LifecycleMessage(const char *tag, void const *data, size_t data_size); // Lifecycle alert to plugins.
 
 /***************************************************************************
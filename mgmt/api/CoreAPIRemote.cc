@@ -483,6 +483,39 @@ StorageDeviceCmdOffline(const char *dev)
   return (ret == TS_ERR_OKAY) ? parse_generic_response(OpType::STORAGE_DEVICE_CMD_OFFLINE, main_socket_fd) : ret;
 }
 
+/*-------------------------------------------------------------------------
+ * DispatchTraceDump
+ *-------------------------------------------------------------------------
+ * Write the continuation dispatch trace of traffic_server to @a path.
+ */
+TSMgmtError
+DispatchTraceDump(const char *path)
+{
+  TSMgmtError ret;
+  OpType optype           = OpType::DISPATCH_TRACE;
+  MgmtMarshallString name = const_cast<MgmtMarshallString>(path ? path : "");
+
+  ret = MGMTAPI_SEND_MESSAGE(main_socket_fd, OpType::DISPATCH_TRACE, &optype, &name);
+  return (ret == TS_ERR_OKAY) ? parse_generic_response(OpType::DISPATCH_TRACE, main_socket_fd) : ret;
+}
+
+/*-------------------------------------------------------------------------
+ * CpuProfileDump
+ *-------------------------------------------------------------------------
+ * Write the CPU profile of traffic_server to @a path.
+ */
+TSMgmtError
+CpuProfileDump(const char *path, unsigned options)
+{
+  TSMgmtError ret;
+  OpType optype           = OpType::CPU_PROFILE;
+  MgmtMarshallString name = const_cast<MgmtMarshallString>(path ? path : "");
+  MgmtMarshallInt opts    = options;
+
+  ret = MGMTAPI_SEND_MESSAGE(main_socket_fd, OpType::CPU_PROFILE, &optype, &name, &opts);
+  return (ret == TS_ERR_OKAY) ? parse_generic_response(OpType::CPU_PROFILE, main_socket_fd) : ret;
+}
+
 /*-------------------------------------------------------------------------
  * Lifecycle Alert
  *-------------------------------------------------------------------------
@@ -515,6 +515,8 @@ static const event_message_handler handlers[] = {
   nullptr,                     // LIFECYCLE_MESSAGE
   nullptr,                     // HOST_STATUS_UP
   nullptr,                     // HOST_STATUS_DOWN
+  nullptr,                     // DISPATCH_TRACE
+  nullptr,                     // CPU_PROFILE
 };
 
 static TSMgmtError
@@ -834,6 +834,18 @@ TSStorageDeviceCmdOffline(const char *dev)
   return StorageDeviceCmdOffline(dev);
 }
 
+tsapi TSMgmtError
+TSDispatchTraceDump(const char *path)
+{
+  return DispatchTraceDump(path);
+}
+
+tsapi TSMgmtError
+TSCpuProfileDump(const char *path, unsigned options)
+{
+  return CpuProfileDump(path, options);
+}
+
 tsapi TSMgmtError
 TSLifecycleMessage(const char *tag, void const *data, size_t data_size)
 {
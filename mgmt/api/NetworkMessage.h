@@ -56,6 +56,8 @@ enum class OpType : MgmtMarshallInt {
   LIFECYCLE_MESSAGE,
   HOST_STATUS_UP,
   HOST_STATUS_DOWN,
+  DISPATCH_TRACE,
+  CPU_PROFILE,
   UNDEFINED_OP /* This must be last */
 };
 
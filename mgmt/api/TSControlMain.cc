@@ -642,6 +642,54 @@ handle_storage_device_cmd_offline(int fd, void *req, size_t reqlen)
   return send_mgmt_response(fd, OpType::STORAGE_DEVICE_CMD_OFFLINE, &err);
 }
 
+/**************************************************************************
+ * handle_dispatch_trace
+ *
+ * purpose: handle request to write out the continuation dispatch trace.
+ * output: TS_ERR_xx
+ * note: None
+ *************************************************************************/
+static TSMgmtError
+handle_dispatch_trace(int fd, void *req, size_t reqlen)
+{
+  MgmtMarshallInt optype;
+  MgmtMarshallString path = nullptr;
+  MgmtMarshallInt err;
+
+  err = recv_mgmt_request(req, reqlen, OpType::DISPATCH_TRACE, &optype, &path);
+  if (err == TS_ERR_OKAY) {
+    // forward to server
+    lmgmt->signalEvent(MGMT_EVENT_DISPATCH_TRACE, path ? path : "");
+  }
+
+  ats_free(path);
+  return send_mgmt_response(fd, OpType::DISPATCH_TRACE, &err);
+}
+
+/**************************************************************************
+ * handle_cpu_profile
+ *
+ * purpose: handle request to write out the CPU profile.
+ * output: TS_ERR_xx
+ * note: None
+ *************************************************************************/
+static TSMgmtError
+handle_cpu_profile(int fd, void *req, size_t reqlen)
+{
+  MgmtMarshallInt optype;
+  MgmtMarshallString path = nullptr;
+  MgmtMarshallInt options;
+  MgmtMarshallInt err;
+
+  err = recv_mgmt_request(req, reqlen, OpType::CPU_PROFILE, &optype, &path, &options);
+  if (err == TS_ERR_OKAY) {
+    err = CpuProfileDump(path, options);
+  }
+
+  ats_free(path);
+  return send_mgmt_response(fd, OpType::CPU_PROFILE, &err);
+}
+
 /**************************************************************************
  * handle_event_resolve
  *
@@ -1040,6 +1088,8 @@ static const control_message_handler handlers[] = {
   /* LIFECYCLE_MESSAGE          */ {MGMT_API_PRIVILEGED, handle_lifecycle_message},
   /* HOST_STATUS_UP             */ {MGMT_API_PRIVILEGED, handle_host_status_up},
   /* HOST_STATUS_DOWN           */ {MGMT_API_PRIVILEGED, handle_host_status_down},
+  /* DISPATCH_TRACE             */ {MGMT_API_PRIVILEGED, handle_dispatch_trace},
+  /* CPU_PROFILE                */ {MGMT_API_PRIVILEGED, handle_cpu_profile},
 };
 
 // This should use countof(), but we need a constexpr :-/
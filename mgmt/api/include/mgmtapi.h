@@ -157,6 +157,12 @@ typedef enum {
   TS_DRAIN_OPT_UNDO, /* Recover TS from drain mode */
 } TSDrainOptionT;
 
+typedef enum {
+  TS_PROFILE_OPT_NONE  = 0x0,
+  TS_PROFILE_OPT_PPROF = 0x01, /* Write a gperftools CPU profile instead of collapsed stacks. */
+  TS_PROFILE_OPT_RESET = 0x02, /* Drop the samples once written. */
+} TSProfileOptionT;
+
 /***************************************************************************
  * Structures
  ***************************************************************************/
@@ -379,6 +385,19 @@ tsapi TSMgmtError TSDrain(unsigned options);
  */
 tsapi TSMgmtError TSStorageDeviceCmdOffline(const char *dev);
 
+/* TSDispatchTraceDump: Request traffic_server to write out its continuation dispatch trace.
+ * @arg path File to write, the default in the log directory if empty.
+ * @return Success.
+ */
+tsapi TSMgmtError TSDispatchTraceDump(const char *path);
+
+/* TSCpuProfileDump: Request traffic_server to write out the samples of its CPU profiler.
+ * @arg path File to write, the default in the log directory if empty.
+ * @arg options TSProfileOptionT
+ * @return Success.
+ */
+tsapi TSMgmtError TSCpuProfileDump(const char *path, unsigned options);
+
 /* TSLifecycleMessage: Send a lifecycle message to the plugins.
  * @arg tag Alert tag string (null-terminated)
  * @return Success
@@ -27,11 +27,13 @@
 
 #include "utils.h"
 #include <string>
+#include <unordered_map>
 #include <memory> // placement new
 #include <limits>
 #include <cstring>
 #include <cstdlib>
 #include <cstdio>
+#include <ctime>
 
 #include <getopt.h>
 #include <arpa/inet.h>
@@ -53,11 +55,72 @@ static int AuthTaggedRequestArg = -1;
 
 static TSCont AuthOsDnsContinuation;
 
+// The authorizations granted by the auth proxy in the last cache_ttl seconds. A request that was
+// authorized is then authorized again without a request to the auth proxy.
+class AuthDecisionCache
+{
+public:
+  AuthDecisionCache() : mutex(TSMutexCreate()) {}
+  ~AuthDecisionCache() { TSMutexDestroy(this->mutex); }
+
+  // Return whether the request with this key was authorized recently.
+  bool
+  lookup(const std::string &key)
+  {
+    time_t now = time(nullptr);
+    bool found = false;
+
+    TSMutexLock(this->mutex);
+    auto spot = this->expires.find(key);
+    if (spot != this->expires.end()) {
+      if (spot->second > now) {
+        found = true;
+      } else {
+        this->expires.erase(spot);
+      }
+    }
+    TSMutexUnlock(this->mutex);
+
+    return found;
+  }
+
+  void
+  insert(const std::string &key, time_t ttl)
+  {
+    time_t now = time(nullptr);
+
+    TSMutexLock(this->mutex);
+    if (this->expires.size() >= MAX_ENTRIES) {
+      // Make room from the expired entries, start over if they all are still valid.
+      for (auto spot = this->expires.begin(); spot != this->expires.end();) {
+        spot = spot->second > now ? std::next(spot) : this->expires.erase(spot);
+      }
+      if (this->expires.size() >= MAX_ENTRIES) {
+        this->expires.clear();
+      }
+    }
+    this->expires[key] = now + ttl;
+    TSMutexUnlock(this->mutex);
+  }
+
+  // noncopyable
+  AuthDecisionCache(const AuthDecisionCache &) = delete;
+  AuthDecisionCache &operator=(const AuthDecisionCache &) = delete;
+
+private:
+  static const size_t MAX_ENTRIES = 64 * 1024;
+
+  TSMutex mutex;
+  std::unordered_map<std::string, time_t> expires; // request key -> expiration time
+};
+
 struct AuthOptions {
   std::string hostname;
   int hostport                   = -1;
   AuthRequestTransform transform = nullptr;
   bool force                     = false;
+  time_t cache_ttl               = 0; // Seconds to remember an authorization for, 0 to always ask the auth proxy.
+  std::unique_ptr<AuthDecisionCache> cache;
 
   AuthOptions() {}
   ~AuthOptions() {}
@@ -129,6 +192,7 @@ static const StateTransition StateTableProxyReadHeader[] = {
 static const StateTransition StateTableProxyRequest[] = {
   {TS_EVENT_VCONN_WRITE_COMPLETE, StateAuthProxyWriteComplete, StateTableProxyReadHeader},
   {TS_EVENT_ERROR, StateUnauthorized, nullptr},
+  {TS_EVENT_IMMEDIATE, StateAuthorized, nullptr}, // Authorized from the cache, no request was sent.
   {TS_EVENT_NONE, nullptr, nullptr}};
 
 // Initial state table.
@@ -145,6 +209,7 @@ struct AuthRequestContext {
   HttpIoBuffer iobuf;
   const char *method = nullptr; // Client request method (e.g. GET)
   bool read_body     = true;
+  std::string cache_key; // Identifies the client request in the authorization cache.
 
   const StateTransition *state = nullptr;
 
@@ -254,6 +319,48 @@ AuthRequestGetMethod(TSHttpTxn txn)
   return method;
 }
 
+// Append the values of all the @a name fields of the client request to @a key.
+static void
+AuthAppendMimeFields(std::string &key, TSMBuffer mbuf, TSMLoc mhdr, const char *name, int name_len)
+{
+  TSMLoc field = TSMimeHdrFieldFind(mbuf, mhdr, name, name_len);
+
+  while (field) {
+    int len;
+    const char *value = TSMimeHdrFieldValueStringGet(mbuf, mhdr, field, -1, &len);
+    TSMLoc next       = TSMimeHdrFieldNextDup(mbuf, mhdr, field);
+
+    key.append("\n").append(name, name_len).append(": ").append(value, len);
+    TSHandleMLocRelease(mbuf, mhdr, field);
+    field = next;
+  }
+}
+
+// Build the authorization cache key of the client request, from its method, its URL and its
+// credentials. Return false if the request can't be cached.
+static bool
+AuthRequestCacheKey(AuthRequestContext *auth)
+{
+  TSMBuffer mbuf;
+  TSMLoc mhdr;
+  int len;
+  char *url = TSHttpTxnEffectiveUrlStringGet(auth->txn, &len);
+
+  if (url == nullptr) {
+    return false;
+  }
+
+  auth->cache_key.assign(auth->method ? auth->method : "").append(" ").append(url, len);
+  TSfree(url);
+
+  TSReleaseAssert(TSHttpTxnClientReqGet(auth->txn, &mbuf, &mhdr) == TS_SUCCESS);
+  AuthAppendMimeFields(auth->cache_key, mbuf, mhdr, TS_MIME_FIELD_AUTHORIZATION, TS_MIME_LEN_AUTHORIZATION);
+  AuthAppendMimeFields(auth->cache_key, mbuf, mhdr, TS_MIME_FIELD_COOKIE, TS_MIME_LEN_COOKIE);
+  TSHandleMLocRelease(mbuf, TS_NULL_MLOC, mhdr);
+
+  return true;
+}
+
 // Chain the response header hook to send the proxy's authorization response.
 static void
 AuthChainAuthorizationResponse(AuthRequestContext *auth)
@@ -397,6 +504,12 @@ StateAuthProxyConnect(AuthRequestContext *auth, void * /* edata ATS_UNUSED */)
   auth->method = AuthRequestGetMethod(auth->txn);
   AuthLogDebug("client request %s a HEAD request", auth->method == TS_HTTP_METHOD_HEAD ? "is" : "is not");
 
+  // Skip the auth proxy request if the same request was authorized recently.
+  if (options->cache && AuthRequestCacheKey(auth) && options->cache->lookup(auth->cache_key)) {
+    AuthLogDebug("request authorized from the cache");
+    return TS_EVENT_IMMEDIATE;
+  }
+
   auth->vconn = TSHttpConnect(ip);
   if (auth->vconn == nullptr) {
     return TS_EVENT_ERROR;
@@ -423,6 +536,10 @@ StateAuthProxyCompleteHeaders(AuthRequestContext *auth, void * /* edata ATS_UNUS
 
   // Authorize the original request on a 2xx response.
   if (status >= 200 && status < 300) {
+    const AuthOptions *options = auth->options();
+    if (options->cache && !auth->cache_key.empty()) {
+      options->cache->insert(auth->cache_key, options->cache_ttl);
+    }
     return TS_EVENT_IMMEDIATE;
   }
 
@@ -674,6 +791,7 @@ AuthParseOptions(int argc, const char **argv)
     {const_cast<char *>("auth-port"), required_argument, nullptr, 'p'},
     {const_cast<char *>("auth-transform"), required_argument, nullptr, 't'},
     {const_cast<char *>("force-cacheability"), no_argument, nullptr, 'c'},
+    {const_cast<char *>("cache-authorization"), required_argument, nullptr, 'a'},
     {nullptr, 0, nullptr, 0},
   };
 
@@ -695,6 +813,13 @@ AuthParseOptions(int argc, const char **argv)
     case 'c':
       options->force = true;
       break;
+    case 'a':
+      options->cache_ttl = std::atoi(optarg);
+      if (options->cache_ttl < 0) {
+        AuthLogError("invalid authorization cache time '%s'", optarg);
+        options->cache_ttl = 0;
+      }
+      break;
     case 't':
       if (strcasecmp(optarg, "redirect") == 0) {
         options->transform = AuthWriteRedirectedRequest;
@@ -718,6 +843,10 @@ AuthParseOptions(int argc, const char **argv)
     options->hostname = "127.0.0.1";
   }
 
+  if (options->cache_ttl > 0) {
+    options->cache.reset(new AuthDecisionCache());
+  }
+
   return options;
 }
 
@@ -31,6 +31,7 @@
 #include <cinttypes>
 #include <string_view>
 #include <array>
+#include <vector>
 
 #include "ts/ts.h"
 #include "ts/remap.h"
@@ -51,11 +52,18 @@ static const std::array<const std::string_view, 6> FILTER_HEADERS{
    {TS_MIME_FIELD_IF_RANGE, static_cast<size_t>(TS_MIME_LEN_IF_RANGE)},
    {TS_MIME_FIELD_IF_UNMODIFIED_SINCE, static_cast<size_t>(TS_MIME_LEN_IF_UNMODIFIED_SINCE)}}};
 
+struct BgFetchData;
+
 ///////////////////////////////////////////////////////////////////////////
 // Hold the global background fetch state. This is currently shared across all
 // configurations, as a singleton. ToDo: Would it ever make sense to do this
 // per remap rule? Maybe for per-remap logging ??
-typedef std::unordered_map<std::string, bool> OutstandingRequests;
+//
+// The outstanding URLs map to the number of requests that wanted them
+// fetched, which is the priority of the fetches queued up when the limits
+// on concurrent fetches are reached.
+typedef std::unordered_map<std::string, int> OutstandingRequests;
+typedef std::unordered_map<std::string, int> OriginFetches;
 
 class BgFetchState
 {
@@ -90,16 +98,28 @@ public:
     return _log;
   }
 
+  void
+  setLimits(int max_fetches, int max_origin_fetches, int max_queued)
+  {
+    TSMutexLock(_lock);
+    _max_fetches        = max_fetches;
+    _max_origin_fetches = max_origin_fetches;
+    _max_queued         = max_queued;
+    TSMutexUnlock(_lock);
+  }
+
   bool
   acquire(const std::string &url)
   {
     bool ret;
 
     TSMutexLock(_lock);
-    if (_urls.end() == _urls.find(url)) {
-      _urls[url] = true;
+    auto spot = _urls.find(url);
+    if (_urls.end() == spot) {
+      _urls[url] = 1;
       ret        = true;
     } else {
+      ++spot->second; // One more request for it, a queued fetch moves up
       ret = false;
     }
     TSMutexUnlock(_lock);
@@ -109,27 +129,24 @@ public:
     return ret;
   }
 
-  bool
-  release(const std::string &url)
-  {
-    bool ret;
+  bool release(const std::string &url, const std::string &origin);
 
-    TSMutexLock(_lock);
-    if (_urls.end() == _urls.find(url)) {
-      ret = false;
-    } else {
-      _urls.erase(url);
-      ret = true;
-    }
-    TSMutexUnlock(_lock);
-
-    return ret;
-  }
+  // Start the fetch of an acquired URL, or queue it up if too many fetches are running.
+  void start(BgFetchData *data);
 
 private:
+  bool _canStart(const std::string &origin) const;
+  void _started(const std::string &origin);
+
   OutstandingRequests _urls;
-  TSTextLogObject _log = nullptr;
-  TSMutex _lock        = TSMutexCreate();
+  OriginFetches _origin_fetches;
+  std::vector<BgFetchData *> _queue;
+  int _fetches            = 0;
+  int _max_fetches        = 0;
+  int _max_origin_fetches = 0;
+  int _max_queued         = 0;
+  TSTextLogObject _log    = nullptr;
+  TSMutex _lock           = TSMutexCreate();
 };
 
 //////////////////////////////////////////////////////////////////////////////
@@ -173,7 +190,7 @@ struct BgFetchData {
   bool
   releaseUrl() const
   {
-    return BgFetchState::getInstance().release(_url);
+    return BgFetchState::getInstance().release(_url, _origin);
   }
 
   const char *
@@ -182,6 +199,18 @@ struct BgFetchData {
     return _url.c_str();
   }
 
+  const std::string &
+  getUrlString() const
+  {
+    return _url;
+  }
+
+  const std::string &
+  getOrigin() const
+  {
+    return _origin;
+  }
+
   void
   addBytes(int64_t b)
   {
@@ -209,6 +238,7 @@ struct BgFetchData {
 
 private:
   std::string _url;
+  std::string _origin; // the Host, for the per origin limit
   int64_t _bytes = 0;
   TSCont _cont   = nullptr;
 };
@@ -276,6 +306,9 @@ BgFetchData::initialize(TSMBuffer request, TSMLoc req_hdr, TSHttpTxn txnp)
             if (set_header(mbuf, hdr_loc, TS_MIME_FIELD_HOST, TS_MIME_LEN_HOST, hostp, len)) {
               TSDebug(PLUGIN_NAME, "Set header Host: %.*s", len, hostp);
             }
+            if (hostp) {
+              _origin.assign(hostp, len);
+            }
 
             // Next, remove the Range headers and IMS (conditional) headers from the request
             for (auto const &header : FILTER_HEADERS) {
@@ -298,6 +331,106 @@ BgFetchData::initialize(TSMBuffer request, TSMLoc req_hdr, TSHttpTxn txnp)
 
 static int cont_bg_fetch(TSCont contp, TSEvent event, void *edata);
 
+bool
+BgFetchState::_canStart(const std::string &origin) const
+{
+  if (_max_fetches > 0 && _fetches >= _max_fetches) {
+    return false;
+  }
+  if (_max_origin_fetches > 0) {
+    auto spot = _origin_fetches.find(origin);
+    if (spot != _origin_fetches.end() && spot->second >= _max_origin_fetches) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void
+BgFetchState::_started(const std::string &origin)
+{
+  ++_fetches;
+  ++_origin_fetches[origin];
+}
+
+void
+BgFetchState::start(BgFetchData *data)
+{
+  bool run  = false;
+  bool drop = false;
+
+  TSMutexLock(_lock);
+  if (_canStart(data->getOrigin())) {
+    _started(data->getOrigin());
+    run = true;
+  } else if (_max_queued > 0 && static_cast<int>(_queue.size()) >= _max_queued) {
+    _urls.erase(data->getUrlString());
+    drop = true;
+  } else {
+    _queue.push_back(data);
+  }
+  TSMutexUnlock(_lock);
+
+  if (run) {
+    data->schedule();
+  } else if (drop) {
+    TSDebug(PLUGIN_NAME, "Background fetch queue is full, dropping %s", data->getUrl());
+    delete data;
+  } else {
+    TSDebug(PLUGIN_NAME, "Queued up background fetch of %s", data->getUrl());
+  }
+}
+
+// Called as a started fetch is done, which makes room for the most requested of the queued up
+// fetches that is within the limits.
+bool
+BgFetchState::release(const std::string &url, const std::string &origin)
+{
+  bool ret;
+  BgFetchData *next = nullptr;
+
+  TSMutexLock(_lock);
+  if (_urls.end() == _urls.find(url)) {
+    ret = false;
+  } else {
+    _urls.erase(url);
+    ret = true;
+  }
+
+  auto spot = _origin_fetches.find(origin);
+  if (spot != _origin_fetches.end()) {
+    --_fetches;
+    if (--spot->second <= 0) {
+      _origin_fetches.erase(spot);
+    }
+  }
+
+  auto best     = _queue.end();
+  int best_hits = 0;
+  for (auto it = _queue.begin(); it != _queue.end(); ++it) {
+    if (_canStart((*it)->getOrigin())) {
+      auto hits = _urls.find((*it)->getUrlString());
+      if (hits != _urls.end() && hits->second > best_hits) {
+        best      = it;
+        best_hits = hits->second;
+      }
+    }
+  }
+  if (best != _queue.end()) {
+    next = *best;
+    _queue.erase(best);
+    _started(next->getOrigin());
+  }
+  TSMutexUnlock(_lock);
+
+  if (next) {
+    TSDebug(PLUGIN_NAME, "Starting queued up background fetch of %s", next->getUrl());
+    next->schedule();
+  }
+
+  return ret;
+}
+
 // Create, setup and schedule the background fetch continuation.
 void
 BgFetchData::schedule()
@@ -475,7 +608,7 @@ cont_check_cacheable(TSCont contp, TSEvent /* event ATS_UNUSED */, void *edata)
 
         // Initialize the data structure (can fail) and acquire a privileged lock on the URL
         if (data->initialize(request, req_hdr, txnp) && data->acquireUrl()) {
-          data->schedule();
+          BgFetchState::getInstance().start(data);
         } else {
           delete data; // Not sure why this would happen, but ok.
         }
@@ -577,6 +710,7 @@ TSPluginInit(int argc, const char *argv[])
     if (!gConfig->logFile().empty()) {
       BgFetchState::getInstance().createLog(gConfig->logFile());
     }
+    BgFetchState::getInstance().setLimits(gConfig->maxFetches(), gConfig->maxOriginFetches(), gConfig->maxQueued());
     TSDebug(PLUGIN_NAME, "Initialized");
     TSHttpHookAdd(TS_HTTP_READ_RESPONSE_HDR_HOOK, cont);
   } else {
@@ -637,6 +771,10 @@ TSRemapNewInstance(int argc, char *argv[], void **ih, char * /* errbuf */, int /
       if (config->logFile().size()) {
         BgFetchState::getInstance().createLog(config->logFile());
       }
+      // The limits are global too, the last instance that sets them wins
+      if (config->maxFetches() || config->maxOriginFetches() || config->maxQueued()) {
+        BgFetchState::getInstance().setLimits(config->maxFetches(), config->maxOriginFetches(), config->maxQueued());
+      }
     } else {
       success = false;
     }
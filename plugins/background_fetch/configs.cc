@@ -37,6 +37,9 @@ BgFetchConfig::parseOptions(int argc, const char *argv[])
   static const struct option longopt[] = {{const_cast<char *>("log"), required_argument, nullptr, 'l'},
                                           {const_cast<char *>("config"), required_argument, nullptr, 'c'},
                                           {const_cast<char *>("allow-304"), no_argument, nullptr, 'a'},
+                                          {const_cast<char *>("max-fetches"), required_argument, nullptr, 'f'},
+                                          {const_cast<char *>("max-origin-fetches"), required_argument, nullptr, 'o'},
+                                          {const_cast<char *>("max-queued"), required_argument, nullptr, 'q'},
                                           {nullptr, no_argument, nullptr, '\0'}};
 
   while (true) {
@@ -62,6 +65,18 @@ BgFetchConfig::parseOptions(int argc, const char *argv[])
       TSDebug(PLUGIN_NAME, "option: --allow-304 set");
       _allow_304 = true;
       break;
+    case 'f':
+      TSDebug(PLUGIN_NAME, "option: --max-fetches %s", optarg);
+      _max_fetches = atoi(optarg);
+      break;
+    case 'o':
+      TSDebug(PLUGIN_NAME, "option: --max-origin-fetches %s", optarg);
+      _max_origin_fetches = atoi(optarg);
+      break;
+    case 'q':
+      TSDebug(PLUGIN_NAME, "option: --max-queued %s", optarg);
+      _max_queued = atoi(optarg);
+      break;
     default:
       TSError("[%s] invalid plugin option: %c", PLUGIN_NAME, opt);
       return false;
@@ -75,14 +75,35 @@ public:
     return _allow_304;
   }
 
+  int
+  maxFetches() const
+  {
+    return _max_fetches;
+  }
+
+  int
+  maxOriginFetches() const
+  {
+    return _max_origin_fetches;
+  }
+
+  int
+  maxQueued() const
+  {
+    return _max_queued;
+  }
+
   // This parses and populates the BgFetchRule linked list (_rules).
   bool readConfig(const char *file_name);
 
   bool bgFetchAllowed(TSHttpTxn txnp) const;
 
 private:
-  TSCont _cont        = nullptr;
-  BgFetchRule *_rules = nullptr;
-  bool _allow_304     = false;
+  TSCont _cont            = nullptr;
+  BgFetchRule *_rules     = nullptr;
+  bool _allow_304         = false;
+  int _max_fetches        = 0; // Limits of the background fetches, 0 means no limit
+  int _max_origin_fetches = 0;
+  int _max_queued         = 0;
   std::string _log_file;
 };
@@ -28,6 +28,10 @@
 #include <brotli/encode.h>
 #endif
 
+#if HAVE_ZSTD_H
+#include <zstd.h>
+#endif
+
 #include "ts/ts.h"
 #include "tscore/ink_defs.h"
 
@@ -55,6 +59,8 @@ const int ZLIB_COMPRESSION_LEVEL = 6;
 const char *dictionary           = nullptr;
 const char *TS_HTTP_VALUE_BROTLI = "br";
 const int TS_HTTP_LEN_BROTLI     = 2;
+const char *TS_HTTP_VALUE_ZSTD   = "zstd";
+const int TS_HTTP_LEN_ZSTD       = 4;
 
 // brotli compression quality 1-11. Testing proved level '6'
 #if HAVE_BROTLI_ENCODE_H
@@ -62,6 +68,11 @@ const int BROTLI_COMPRESSION_LEVEL = 6;
 const int BROTLI_LGW               = 16;
 #endif
 
+// zstd compression level 1-19, its default is 3. The level of the other algorithms is used.
+#if HAVE_ZSTD_H
+const int ZSTD_COMPRESSION_LEVEL = 6;
+#endif
+
 static const char *global_hidden_header_name = nullptr;
 
 // Current global configuration, and the previous one (for cleanup)
@@ -82,6 +93,14 @@ data_alloc(int compression_type, int compression_algorithms)
   data->state                  = transform_state_initialized;
   data->compression_type       = compression_type;
   data->compression_algorithms = compression_algorithms;
+  data->transform_contp        = nullptr;
+  data->offload_contp          = nullptr;
+  data->offload_thread         = nullptr;
+  data->offload_todo           = 0;
+  data->offload_written        = 0;
+  data->offload_pending        = false;
+  data->offload_compressed     = false;
+  data->offload_closed         = false;
   data->zstrm.next_in          = Z_NULL;
   data->zstrm.avail_in         = 0;
   data->zstrm.total_in         = 0;
@@ -127,6 +146,19 @@ data_alloc(int compression_type, int compression_algorithms)
     data->bstrm.avail_out = 0;
     data->bstrm.total_out = 0;
   }
+#endif
+#if HAVE_ZSTD_H
+  data->zstdstrm.cctx      = nullptr;
+  data->zstdstrm.total_in  = 0;
+  data->zstdstrm.total_out = 0;
+  if (compression_type & COMPRESSION_TYPE_ZSTD) {
+    debug("zstd compression. Create zstd compression context.");
+    data->zstdstrm.cctx = ZSTD_createCCtx();
+    if (!data->zstdstrm.cctx) {
+      fatal("zstd compression context creation failed");
+    }
+    ZSTD_CCtx_setParameter(data->zstdstrm.cctx, ZSTD_c_compressionLevel, ZSTD_COMPRESSION_LEVEL);
+  }
 #endif
   return data;
 }
@@ -144,10 +176,17 @@ data_destroy(Data *data)
     TSIOBufferDestroy(data->downstream_buffer);
   }
 
+  if (data->offload_contp) {
+    TSContDestroy(data->offload_contp);
+  }
+
 // brotlidestory
 #if HAVE_BROTLI_ENCODE_H
   BrotliEncoderDestroyInstance(data->bstrm.br);
 #endif
+#if HAVE_ZSTD_H
+  ZSTD_freeCCtx(data->zstdstrm.cctx);
+#endif
 
   TSfree(data);
 }
@@ -160,7 +199,10 @@ content_encoding_header(TSMBuffer bufp, TSMLoc hdr_loc, const int compression_ty
   const char *value = nullptr;
   int value_len     = 0;
   // Delete Content-Encoding if present???
-  if (compression_type & COMPRESSION_TYPE_BROTLI && (algorithm & ALGORITHM_BROTLI)) {
+  if (compression_type & COMPRESSION_TYPE_ZSTD && (algorithm & ALGORITHM_ZSTD)) {
+    value     = TS_HTTP_VALUE_ZSTD;
+    value_len = TS_HTTP_LEN_ZSTD;
+  } else if (compression_type & COMPRESSION_TYPE_BROTLI && (algorithm & ALGORITHM_BROTLI)) {
     value     = TS_HTTP_VALUE_BROTLI;
     value_len = TS_HTTP_LEN_BROTLI;
   } else if (compression_type & COMPRESSION_TYPE_GZIP && (algorithm & ALGORITHM_GZIP)) {
@@ -398,6 +440,53 @@ brotli_transform_one(Data *data, const char *upstream_buffer, int64_t upstream_l
 }
 #endif
 
+#if HAVE_ZSTD_H
+static bool
+zstd_compress_operation(Data *data, const char *upstream_buffer, int64_t upstream_length, ZSTD_EndDirective op)
+{
+  TSIOBufferBlock downstream_blkp;
+  int64_t downstream_length;
+  ZSTD_inBuffer input = {upstream_buffer, static_cast<size_t>(upstream_length), 0};
+
+  for (;;) {
+    downstream_blkp         = TSIOBufferStart(data->downstream_buffer);
+    char *downstream_buffer = TSIOBufferBlockWriteStart(downstream_blkp, &downstream_length);
+    ZSTD_outBuffer output   = {downstream_buffer, static_cast<size_t>(downstream_length), 0};
+
+    size_t remaining = ZSTD_compressStream2(data->zstdstrm.cctx, &output, &input, op);
+    if (ZSTD_isError(remaining)) {
+      error("ZSTD_compressStream2(%d) call failed: %s", op, ZSTD_getErrorName(remaining));
+      return false;
+    }
+
+    TSIOBufferProduce(data->downstream_buffer, output.pos);
+    data->downstream_length += output.pos;
+    data->zstdstrm.total_out += output.pos;
+
+    // continue until the input is consumed, flush and end until the frame is written out
+    if (op == ZSTD_e_continue ? input.pos == input.size : remaining == 0) {
+      break;
+    }
+  }
+
+  return true;
+}
+
+static void
+zstd_transform_one(Data *data, const char *upstream_buffer, int64_t upstream_length)
+{
+  if (!zstd_compress_operation(data, upstream_buffer, upstream_length, ZSTD_e_continue)) {
+    return;
+  }
+
+  data->zstdstrm.total_in += upstream_length;
+
+  if (data->hc->flush()) {
+    zstd_compress_operation(data, nullptr, 0, ZSTD_e_flush);
+  }
+}
+#endif
+
 static void
 compress_transform_one(Data *data, TSIOBufferReader upstream_reader, int amount)
 {
@@ -420,8 +509,13 @@ compress_transform_one(Data *data, TSIOBufferReader upstream_reader, int amount)
       upstream_length = amount;
     }
 
+#if HAVE_ZSTD_H
+    if (data->compression_type & COMPRESSION_TYPE_ZSTD && (data->compression_algorithms & ALGORITHM_ZSTD)) {
+      zstd_transform_one(data, upstream_buffer, upstream_length);
+    } else
+#endif
 #if HAVE_BROTLI_ENCODE_H
-    if (data->compression_type & COMPRESSION_TYPE_BROTLI && (data->compression_algorithms & ALGORITHM_BROTLI)) {
+      if (data->compression_type & COMPRESSION_TYPE_BROTLI && (data->compression_algorithms & ALGORITHM_BROTLI)) {
       brotli_transform_one(data, upstream_buffer, upstream_length);
     } else
 #endif
@@ -504,11 +598,40 @@ brotli_transform_finish(Data *data)
 }
 #endif
 
+#if HAVE_ZSTD_H
+static void
+zstd_transform_finish(Data *data)
+{
+  if (data->state != transform_state_output) {
+    return;
+  }
+
+  data->state = transform_state_finished;
+
+  if (!zstd_compress_operation(data, nullptr, 0, ZSTD_e_end)) {
+    return;
+  }
+
+  if (data->downstream_length != (int64_t)(data->zstdstrm.total_out)) {
+    error("zstd-transform: output lengths don't match (%d, %zu)", data->downstream_length, data->zstdstrm.total_out);
+  }
+
+  debug("zstd-transform: Finished zstd");
+  log_compression_ratio(data->zstdstrm.total_in, data->downstream_length);
+}
+#endif
+
 static void
 compress_transform_finish(Data *data)
 {
+#if HAVE_ZSTD_H
+  if (data->compression_type & COMPRESSION_TYPE_ZSTD && data->compression_algorithms & ALGORITHM_ZSTD) {
+    zstd_transform_finish(data);
+    debug("compress_transform_finish: zstd compression finish");
+  } else
+#endif
 #if HAVE_BROTLI_ENCODE_H
-  if (data->compression_type & COMPRESSION_TYPE_BROTLI && data->compression_algorithms & ALGORITHM_BROTLI) {
+    if (data->compression_type & COMPRESSION_TYPE_BROTLI && data->compression_algorithms & ALGORITHM_BROTLI) {
     brotli_transform_finish(data);
     debug("compress_transform_finish: brotli compression finish");
   } else
@@ -522,6 +645,70 @@ compress_transform_finish(Data *data)
   }
 }
 
+// Let downstream and upstream know about the progress of the transform, once @a upstream_todo
+// bytes were compressed into the downstream buffer that had @a downstream_bytes_written bytes.
+static void
+compress_transform_progress(TSCont contp, Data *data, int64_t upstream_todo, int64_t downstream_bytes_written)
+{
+  TSVIO upstream_vio = TSVConnWriteVIOGet(contp);
+
+  if (TSVIONTodoGet(upstream_vio) > 0) {
+    if (upstream_todo > 0) {
+      if (data->downstream_length > downstream_bytes_written) {
+        TSVIOReenable(data->downstream_vio);
+      }
+      TSContCall(TSVIOContGet(upstream_vio), TS_EVENT_VCONN_WRITE_READY, upstream_vio);
+    }
+  } else {
+    compress_transform_finish(data);
+    TSVIONBytesSet(data->downstream_vio, data->downstream_length);
+
+    if (data->downstream_length > downstream_bytes_written) {
+      TSVIOReenable(data->downstream_vio);
+    }
+
+    TSContCall(TSVIOContGet(upstream_vio), TS_EVENT_VCONN_WRITE_COMPLETE, upstream_vio);
+  }
+}
+
+// Compress the upstream data on a task thread and come back to the net thread to hand it
+// downstream. The continuation has the mutex of the transform, so the transform is left alone
+// while it runs, and only one runs at a time, which keeps the output in order.
+static int
+compress_offload(TSCont contp, TSEvent /* event ATS_UNUSED */, void * /* edata ATS_UNUSED */)
+{
+  Data *data = (Data *)TSContDataGet(contp);
+
+  if (data->offload_closed) {
+    // the transform was closed while this was scheduled, it is left to clean up
+    TSContDestroy(contp);
+    data->offload_contp = nullptr;
+    data_destroy(data);
+    return 0;
+  }
+
+  if (!data->offload_compressed) {
+    TSVIO upstream_vio = TSVConnWriteVIOGet(data->transform_contp);
+
+    compress_transform_one(data, TSVIOReaderGet(upstream_vio), data->offload_todo);
+    TSVIONDoneSet(upstream_vio, TSVIONDoneGet(upstream_vio) + data->offload_todo);
+    data->offload_compressed = true;
+    TSContScheduleOnThread(contp, 0, data->offload_thread);
+    return 0;
+  }
+
+  data->offload_pending    = false;
+  data->offload_compressed = false;
+  compress_transform_progress(data->transform_contp, data, data->offload_todo, data->offload_written);
+
+  // upstream may have added data meanwhile, the events of the transform were ignored
+  TSVIO upstream_vio = TSVConnWriteVIOGet(data->transform_contp);
+  if (TSVIOBufferGet(upstream_vio) && TSVIONTodoGet(upstream_vio) > 0 && TSIOBufferReaderAvail(TSVIOReaderGet(upstream_vio)) > 0) {
+    TSVIOReenable(upstream_vio);
+  }
+  return 0;
+}
+
 static void
 compress_transform_do(TSCont contp)
 {
@@ -535,6 +722,11 @@ compress_transform_do(TSCont contp)
     compress_transform_init(contp, data);
   }
 
+  if (data->offload_pending) {
+    // the task thread resumes the transform once it is done
+    return;
+  }
+
   upstream_vio             = TSVConnWriteVIOGet(contp);
   downstream_bytes_written = data->downstream_length;
 
@@ -558,36 +750,39 @@ compress_transform_do(TSCont contp)
       upstream_todo = upstream_avail;
     }
 
+    if (data->hc->offload_min_size() > 0 && upstream_todo >= data->hc->offload_min_size()) {
+      if (!data->offload_contp) {
+        data->offload_contp = TSContCreate(compress_offload, TSContMutexGet(contp));
+        TSContDataSet(data->offload_contp, data);
+      }
+      data->transform_contp = contp;
+      data->offload_thread  = TSEventThreadSelf();
+      data->offload_todo    = upstream_todo;
+      data->offload_written = downstream_bytes_written;
+      data->offload_pending = true;
+      TSContScheduleOnPool(data->offload_contp, 0, TS_THREAD_POOL_TASK);
+      return;
+    }
+
     if (upstream_todo > 0) {
       compress_transform_one(data, TSVIOReaderGet(upstream_vio), upstream_todo);
       TSVIONDoneSet(upstream_vio, TSVIONDoneGet(upstream_vio) + upstream_todo);
     }
   }
 
-  if (TSVIONTodoGet(upstream_vio) > 0) {
-    if (upstream_todo > 0) {
-      if (data->downstream_length > downstream_bytes_written) {
-        TSVIOReenable(data->downstream_vio);
-      }
-      TSContCall(TSVIOContGet(upstream_vio), TS_EVENT_VCONN_WRITE_READY, upstream_vio);
-    }
-  } else {
-    compress_transform_finish(data);
-    TSVIONBytesSet(data->downstream_vio, data->downstream_length);
-
-    if (data->downstream_length > downstream_bytes_written) {
-      TSVIOReenable(data->downstream_vio);
-    }
-
-    TSContCall(TSVIOContGet(upstream_vio), TS_EVENT_VCONN_WRITE_COMPLETE, upstream_vio);
-  }
+  compress_transform_progress(contp, data, upstream_todo, downstream_bytes_written);
 }
 
 static int
 compress_transform(TSCont contp, TSEvent event, void * /* edata ATS_UNUSED */)
 {
   if (TSVConnClosedGet(contp)) {
-    data_destroy((Data *)TSContDataGet(contp));
+    Data *data = (Data *)TSContDataGet(contp);
+    if (data->offload_pending) {
+      data->offload_closed = true;
+    } else {
+      data_destroy(data);
+    }
     TSContDestroy(contp);
     return 0;
   } else {
@@ -680,7 +875,12 @@ transformable(TSHttpTxn txnp, bool server, HostConfiguration *host_configuration
         continue;
       }
 
-      if (strncasecmp(value, "br", sizeof("br") - 1) == 0) {
+      if (strncasecmp(value, "zstd", sizeof("zstd") - 1) == 0) {
+        if (*algorithms & ALGORITHM_ZSTD) {
+          compression_acceptable = 1;
+        }
+        *compress_type |= COMPRESSION_TYPE_ZSTD;
+      } else if (strncasecmp(value, "br", sizeof("br") - 1) == 0) {
         if (*algorithms & ALGORITHM_BROTLI) {
           compression_acceptable = 1;
         }
@@ -773,6 +973,11 @@ compress_transform_add(TSHttpTxn txnp, HostConfiguration *hc, int compress_type,
   if (!hc->cache()) {
     debug("TransformedRespCache  not enabled");
     TSHttpTxnTransformedRespCache(txnp, 0);
+  } else if (hc->cache_variants()) {
+    // Cache the compressed variant next to the uncompressed one, each encoding is then compressed
+    // once, when it is first requested, and served from the cache afterwards.
+    debug("TransformedRespCache and UntransformedRespCache enabled");
+    TSHttpTxnTransformedRespCache(txnp, 1);
   } else {
     debug("TransformedRespCache  enabled");
     TSHttpTxnUntransformedRespCache(txnp, 0);
@@ -102,9 +102,11 @@ enum ParserState {
   kParseRemoveAcceptEncoding,
   kParseEnable,
   kParseCache,
+  kParseCacheVariants,
   kParseFlush,
   kParseAllow,
-  kParseMinimumContentLength
+  kParseMinimumContentLength,
+  kParseOffloadMinSize
 };
 
 void
@@ -237,13 +239,19 @@ HostConfiguration::add_compression_algorithms(string &line)
       compression_algorithms_ |= ALGORITHM_BROTLI;
 #else
       error("supported-algorithms: brotli support not compiled in.");
+#endif
+    } else if (token == "zstd") {
+#ifdef HAVE_ZSTD_H
+      compression_algorithms_ |= ALGORITHM_ZSTD;
+#else
+      error("supported-algorithms: zstd support not compiled in.");
 #endif
     } else if (token == "gzip") {
       compression_algorithms_ |= ALGORITHM_GZIP;
     } else if (token == "deflate") {
       compression_algorithms_ |= ALGORITHM_DEFLATE;
     } else {
-      error("Unknown compression type. Supported compression-algorithms <br,gzip,deflate>.");
+      error("Unknown compression type. Supported compression-algorithms <br,zstd,gzip,deflate>.");
     }
   }
 }
@@ -351,6 +359,8 @@ Configuration::Parse(const char *path)
           state = kParseEnable;
         } else if (token == "cache") {
           state = kParseCache;
+        } else if (token == "cache-variants") {
+          state = kParseCacheVariants;
         } else if (token == "flush") {
           state = kParseFlush;
         } else if (token == "supported-algorithms") {
@@ -363,6 +373,8 @@ Configuration::Parse(const char *path)
           state = kParseStart;
         } else if (token == "minimum-content-length") {
           state = kParseMinimumContentLength;
+        } else if (token == "offload-min-size") {
+          state = kParseOffloadMinSize;
         } else {
           warning("failed to interpret \"%s\" at line %zu", token.c_str(), lineno);
         }
@@ -383,6 +395,10 @@ Configuration::Parse(const char *path)
         current_host_configuration->set_cache(token == "true");
         state = kParseStart;
         break;
+      case kParseCacheVariants:
+        current_host_configuration->set_cache_variants(token == "true");
+        state = kParseStart;
+        break;
       case kParseFlush:
         current_host_configuration->set_flush(token == "true");
         state = kParseStart;
@@ -395,6 +411,10 @@ Configuration::Parse(const char *path)
         current_host_configuration->set_minimum_content_length(strtoul(token.c_str(), nullptr, 10));
         state = kParseStart;
         break;
+      case kParseOffloadMinSize:
+        current_host_configuration->set_offload_min_size(strtoll(token.c_str(), nullptr, 10));
+        state = kParseStart;
+        break;
       }
     }
   }
@@ -38,7 +38,8 @@ enum CompressionAlgorithm {
   ALGORITHM_DEFAULT = 0,
   ALGORITHM_DEFLATE = 1,
   ALGORITHM_GZIP    = 2,
-  ALGORITHM_BROTLI  = 4 // For bit manipulations
+  ALGORITHM_BROTLI  = 4, // For bit manipulations
+  ALGORITHM_ZSTD    = 8
 };
 
 class HostConfiguration : private atscppapi::noncopyable
@@ -48,10 +49,12 @@ public:
     : host_(host),
       enabled_(true),
       cache_(true),
+      cache_variants_(false),
       remove_accept_encoding_(false),
       flush_(false),
       compression_algorithms_(ALGORITHM_GZIP),
       minimum_content_length_(1024),
+      offload_min_size_(0),
       ref_count_(0)
   {
   }
@@ -77,6 +80,16 @@ public:
     cache_ = x;
   }
   bool
+  cache_variants()
+  {
+    return cache_variants_;
+  }
+  void
+  set_cache_variants(bool x)
+  {
+    cache_variants_ = x;
+  }
+  bool
   flush()
   {
     return flush_;
@@ -117,6 +130,16 @@ public:
   {
     minimum_content_length_ = x;
   }
+  int64_t
+  offload_min_size() const
+  {
+    return offload_min_size_;
+  }
+  void
+  set_offload_min_size(int64_t x)
+  {
+    offload_min_size_ = x;
+  }
 
   void update_defaults();
   void add_allow(const std::string &allow);
@@ -147,10 +170,12 @@ private:
   std::string host_;
   bool enabled_;
   bool cache_;
+  bool cache_variants_;
   bool remove_accept_encoding_;
   bool flush_;
   int compression_algorithms_;
   unsigned int minimum_content_length_;
+  int64_t offload_min_size_; ///< Compress on the task threads at least this much at once, 0 to not.
   int ref_count_;
 
   StringContainer compressible_content_types_;
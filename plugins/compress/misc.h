@@ -32,6 +32,10 @@
 #include <brotli/encode.h>
 #endif
 
+#if HAVE_ZSTD_H
+#include <zstd.h>
+#endif
+
 #include "configuration.h"
 
 using namespace Gzip;
@@ -46,7 +50,8 @@ enum CompressionType {
   COMPRESSION_TYPE_DEFAULT = 0,
   COMPRESSION_TYPE_DEFLATE = 1,
   COMPRESSION_TYPE_GZIP    = 2,
-  COMPRESSION_TYPE_BROTLI  = 4
+  COMPRESSION_TYPE_BROTLI  = 4,
+  COMPRESSION_TYPE_ZSTD    = 8
 };
 
 // this one is used to rename the accept encoding header
@@ -72,6 +77,14 @@ typedef struct {
 } b_stream;
 #endif
 
+#if HAVE_ZSTD_H
+typedef struct {
+  ZSTD_CCtx *cctx;
+  size_t total_in;
+  size_t total_out;
+} zstd_stream;
+#endif
+
 typedef struct {
   TSHttpTxn txn;
   HostConfiguration *hc;
@@ -86,6 +99,17 @@ typedef struct {
 #if HAVE_BROTLI_ENCODE_H
   b_stream bstrm;
 #endif
+#if HAVE_ZSTD_H
+  zstd_stream zstdstrm;
+#endif
+  TSCont transform_contp;       // the transform, once it offloads
+  TSCont offload_contp;         // compresses on the task threads
+  TSEventThread offload_thread; // net thread to resume the transform on
+  int64_t offload_todo;         // upstream bytes being compressed on the task threads
+  int64_t offload_written;      // downstream length before they were compressed
+  bool offload_pending;         // the transform waits for the task threads
+  bool offload_compressed;      // the task threads are done, the transform resumes next
+  bool offload_closed;          // the transform was closed while waiting
 } Data;
 
 voidpf gzip_alloc(voidpf opaque, uInt items, uInt size);
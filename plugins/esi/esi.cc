@@ -58,6 +58,7 @@ struct OptionInfo {
   bool private_response;
   bool disable_gzip_output;
   bool first_byte_flush;
+  int fetch_timeout; // ms the includes of a document are waited for, 0 for no limit
 };
 
 static HandlerManager *gHandlerManager = nullptr;
@@ -103,6 +104,7 @@ struct ContData {
   TSIOBufferReader output_reader;
   Variables *esi_vars;
   HttpDataFetcherImpl *data_fetcher;
+  TSAction fetch_timeout_action;
   EsiProcessor *esi_proc;
   EsiGzip *esi_gzip;
   EsiGunzip *esi_gunzip;
@@ -133,6 +135,7 @@ struct ContData {
       output_reader(nullptr),
       esi_vars(nullptr),
       data_fetcher(nullptr),
+      fetch_timeout_action(nullptr),
       esi_proc(nullptr),
       esi_gzip(nullptr),
       esi_gunzip(nullptr),
@@ -268,6 +271,11 @@ ContData::init()
 
     TSDebug(debug_tag, "[%s] Set input data type to [%s]", __FUNCTION__, DATA_TYPE_NAMES_[input_type]);
 
+    // The includes are fetched as they are parsed, all of them share a single deadline.
+    if (option_info->fetch_timeout > 0) {
+      fetch_timeout_action = TSContScheduleOnPool(contp, option_info->fetch_timeout, TS_THREAD_POOL_NET);
+    }
+
     retval = true;
   } else {
     TSDebug(debug_tag, "[%s] Transformation closed during initialization; Returning false", __FUNCTION__);
@@ -495,6 +503,9 @@ ContData::~ContData()
   if (esi_vars) {
     delete esi_vars;
   }
+  if (fetch_timeout_action) {
+    TSActionCancel(fetch_timeout_action);
+  }
   if (data_fetcher) {
     delete data_fetcher;
   }
@@ -645,7 +656,7 @@ transformData(TSCont contp)
       TSDebug(cont_data->debug_tag, "[%s] input_vio NULL while in read state. Assuming end of input", __FUNCTION__);
       process_input_complete = true;
     } else {
-      if (!cont_data->data_fetcher->isFetchComplete()) {
+      if (!cont_data->data_fetcher->isFetchReady()) {
         TSDebug(cont_data->debug_tag, "[%s] input_vio NULL, but data needs to be fetched. Returning control", __FUNCTION__);
         if (!cont_data->option_info->first_byte_flush) {
           return 1;
@@ -744,7 +755,7 @@ transformData(TSCont contp)
 
   if ((cont_data->curr_state == ContData::FETCHING_DATA) &&
       (!cont_data->option_info->first_byte_flush)) { // retest as state may have changed in previous block
-    if (cont_data->data_fetcher->isFetchComplete()) {
+    if (cont_data->data_fetcher->isFetchReady()) {
       TSDebug(cont_data->debug_tag, "[%s] data ready; going to process doc", __FUNCTION__);
       const char *out_data;
       int out_data_len;
@@ -817,7 +828,7 @@ transformData(TSCont contp)
     int overall_len;
     EsiProcessor::ReturnCode retval = cont_data->esi_proc->flush(out_data, overall_len);
 
-    if ((cont_data->curr_state == ContData::FETCHING_DATA) && cont_data->data_fetcher->isFetchComplete()) {
+    if ((cont_data->curr_state == ContData::FETCHING_DATA) && cont_data->data_fetcher->isFetchReady()) {
       TSDebug(cont_data->debug_tag, "[%s] data ready; last process() will have finished the entire processing", __FUNCTION__);
       cont_data->curr_state = ContData::PROCESSING_COMPLETE;
     }
@@ -919,11 +930,19 @@ transformHandler(TSCont contp, TSEvent event, void *edata)
 
   is_fetch_event = cont_data->data_fetcher->isFetchEvent(event);
 
+  if (event == TS_EVENT_TIMEOUT && !is_fetch_event) {
+    cont_data->fetch_timeout_action = nullptr;
+  }
+
   if (cont_data->xform_closed) {
     TSDebug(cont_debug_tag, "[%s] Transformation closed, post-processing", __FUNCTION__);
     if (cont_data->curr_state == ContData::PROCESSING_COMPLETE) {
       TSDebug(cont_debug_tag, "[%s] Processing is complete, not processing current event %d", __FUNCTION__, event);
       process_event = false;
+      if (is_fetch_event && !cont_data->data_fetcher->isFetchComplete()) {
+        // an include that outlived the fetch timeout; the transformation waits for all of them
+        cont_data->data_fetcher->handleFetchEvent(event, edata);
+      }
     } else if (cont_data->curr_state == ContData::READING_ESI_DOC) {
       TSDebug(cont_debug_tag, "[%s] Parsing is incomplete, will force end of input", __FUNCTION__);
       cont_data->curr_state = ContData::FETCHING_DATA;
@@ -980,6 +999,12 @@ transformHandler(TSCont contp, TSEvent event, void *edata)
       transformData(contp);
       break;
 
+    case TS_EVENT_TIMEOUT:
+      TSDebug(cont_debug_tag, "[%s] fetch timeout, processing without the pending includes", __FUNCTION__);
+      cont_data->data_fetcher->expire();
+      transformData(contp);
+      break;
+
     default:
       if (is_fetch_event) {
         TSDebug(cont_debug_tag, "[%s] Handling fetch event %d", __FUNCTION__, event);
@@ -987,7 +1012,7 @@ transformHandler(TSCont contp, TSEvent event, void *edata)
           if ((cont_data->curr_state == ContData::FETCHING_DATA) || (cont_data->curr_state == ContData::READING_ESI_DOC)) {
             // there's a small chance that fetcher is ready even before
             // parsing is complete; hence we need to check the state too
-            if (cont_data->option_info->first_byte_flush || cont_data->data_fetcher->isFetchComplete()) {
+            if (cont_data->option_info->first_byte_flush || cont_data->data_fetcher->isFetchReady()) {
               TSDebug(cont_debug_tag, "[%s] fetcher is ready with data, going into process stage", __FUNCTION__);
               transformData(contp);
             }
@@ -1005,13 +1030,20 @@ transformHandler(TSCont contp, TSEvent event, void *edata)
   TSDebug(cont_data->debug_tag, "[%s] transformHandler, event: %d, curr_state: %d", __FUNCTION__, (int)event,
           (int)cont_data->curr_state);
 
-  shutdown = (cont_data->xform_closed && (cont_data->curr_state == ContData::PROCESSING_COMPLETE));
+  // the fetches that outlived the fetch timeout still call us back, so the transformation
+  // is only shut down once all of them are done
+  shutdown = (cont_data->xform_closed && (cont_data->curr_state == ContData::PROCESSING_COMPLETE) &&
+              cont_data->data_fetcher->isFetchComplete());
   if (shutdown) {
-    if (process_event && is_fetch_event) {
+    if (is_fetch_event) {
       // we need to return control to the fetch API to give up it's
       // lock on our continuation which will fail if we destroy
       // ourselves right now
       TSDebug(cont_debug_tag, "[%s] Deferring shutdown as data event was just processed", __FUNCTION__);
+      if (cont_data->fetch_timeout_action) {
+        TSActionCancel(cont_data->fetch_timeout_action);
+        cont_data->fetch_timeout_action = nullptr;
+      }
       TSContScheduleOnPool(contp, 10, TS_THREAD_POOL_TASK);
     } else {
       goto lShutdown;
@@ -1597,12 +1629,13 @@ esiPluginInit(int argc, const char *argv[], struct OptionInfo *pOptionInfo)
       {const_cast<char *>("private-response"), no_argument, nullptr, 'p'},
       {const_cast<char *>("disable-gzip-output"), no_argument, nullptr, 'z'},
       {const_cast<char *>("first-byte-flush"), no_argument, nullptr, 'b'},
+      {const_cast<char *>("fetch-timeout"), required_argument, nullptr, 't'},
       {const_cast<char *>("handler-filename"), required_argument, nullptr, 'f'},
       {nullptr, 0, nullptr, 0},
     };
 
     int longindex = 0;
-    while ((c = getopt_long(argc, (char *const *)argv, "npzbf:", longopts, &longindex)) != -1) {
+    while ((c = getopt_long(argc, (char *const *)argv, "npzbt:f:", longopts, &longindex)) != -1) {
       switch (c) {
       case 'n':
         pOptionInfo->packed_node_support = true;
@@ -1616,6 +1649,9 @@ esiPluginInit(int argc, const char *argv[], struct OptionInfo *pOptionInfo)
       case 'b':
         pOptionInfo->first_byte_flush = true;
         break;
+      case 't':
+        pOptionInfo->fetch_timeout = atoi(optarg);
+        break;
       case 'f': {
         Utils::KeyValueMap handler_conf;
         loadHandlerConf(optarg, handler_conf);
@@ -1644,9 +1680,9 @@ esiPluginInit(int argc, const char *argv[], struct OptionInfo *pOptionInfo)
     TSDebug(DEBUG_TAG,
             "[%s] Plugin started%s, "
             "packed-node-support: %d, private-response: %d, "
-            "disable-gzip-output: %d, first-byte-flush: %d ",
+            "disable-gzip-output: %d, first-byte-flush: %d, fetch-timeout: %d ",
             __FUNCTION__, bKeySet ? " and key is set" : "", pOptionInfo->packed_node_support, pOptionInfo->private_response,
-            pOptionInfo->disable_gzip_output, pOptionInfo->first_byte_flush);
+            pOptionInfo->disable_gzip_output, pOptionInfo->first_byte_flush, pOptionInfo->fetch_timeout);
   }
 
   return result;
@@ -47,7 +47,12 @@ HttpDataFetcherImpl::_release(RequestData &req_data)
 }
 
 HttpDataFetcherImpl::HttpDataFetcherImpl(TSCont contp, sockaddr const *client_addr, const char *debug_tag)
-  : _contp(contp), _n_pending_requests(0), _curr_event_id_base(FETCH_EVENT_ID_BASE), _headers_str(""), _client_addr(client_addr)
+  : _contp(contp),
+    _n_pending_requests(0),
+    _expired(false),
+    _curr_event_id_base(FETCH_EVENT_ID_BASE),
+    _headers_str(""),
+    _client_addr(client_addr)
 {
   _http_parser = TSHttpParserCreate();
   snprintf(_debug_tag, sizeof(_debug_tag), "%s", debug_tag);
@@ -276,6 +281,15 @@ HttpDataFetcherImpl::getData(const string &url, ResponseData &resp_data) const
   return true;
 }
 
+void
+HttpDataFetcherImpl::expire()
+{
+  if (!_expired && _n_pending_requests) {
+    TSDebug(_debug_tag, "[%s] Giving up on %d pending requests", __FUNCTION__, _n_pending_requests);
+  }
+  _expired = true;
+}
+
 void
 HttpDataFetcherImpl::clear()
 {
@@ -283,6 +297,7 @@ HttpDataFetcherImpl::clear()
     _release(iter->second);
   }
   _n_pending_requests = 0;
+  _expired            = false;
   _pages.clear();
   _page_entry_lookup.clear();
   _headers_str.clear();
@@ -299,7 +314,7 @@ HttpDataFetcherImpl::getRequestStatus(const string &url) const
   }
 
   if (!(iter->second).complete) {
-    return STATUS_DATA_PENDING;
+    return (_expired ? STATUS_ERROR : STATUS_DATA_PENDING);
   }
 
   if ((iter->second).resp_status != TS_HTTP_STATUS_OK) {
@@ -58,12 +58,22 @@ public:
     return (_n_pending_requests == 0);
   };
 
+  // Stop waiting for the pending requests, which are then failed. Their fetches are still
+  // running, which isFetchComplete() keeps reporting until their events are handled.
+  void expire();
+
+  bool
+  isFetchReady() const
+  {
+    return (_expired || (_n_pending_requests == 0));
+  }
+
   DataStatus getRequestStatus(const std::string &url) const override;
 
   int
   getNumPendingRequests() const override
   {
-    return _n_pending_requests;
+    return (_expired ? 0 : _n_pending_requests);
   };
 
   // used to return data to callers
@@ -128,6 +138,7 @@ private:
   IteratorArray _page_entry_lookup; // used to map event ids to requests
 
   int _n_pending_requests;
+  bool _expired;
   int _curr_event_id_base;
   TSHttpParser _http_parser;
 
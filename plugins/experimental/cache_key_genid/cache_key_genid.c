@@ -15,16 +15,177 @@
 /* cache-key-genid.c - Plugin to modify the URL used as a cache key for
  * requests, without modifying the URL used for actually fetching data from
  * the origin server.
+ *
+ * The host->genid database is loaded into memory, and loaded again on a task
+ * thread when it changes, so that the requests don't wait on the disk. The
+ * optional second argument is how often, in seconds, it is checked.
  */
 
 #include <ts/ts.h>
+#include <errno.h>
 #include <stdio.h>
+#include <stdint.h>
 #include <string.h>
+#include <sys/stat.h>
 #include "kclangc.h"
 
 #define PLUGIN_NAME "cache-key-genid"
 
+#define DEFAULT_REFRESH_INTERVAL 60
+
 static char genid_kyoto_db[PATH_MAX + 1];
+static int genid_refresh_interval = DEFAULT_REFRESH_INTERVAL;
+
+/* The host->genid map of the database, an open addressing hash table. It is
+ * never changed once published, a reload publishes a new one.
+ */
+struct genid_entry {
+  char *host; /* NULL for an empty slot */
+  size_t len;
+  uint32_t hash;
+  int genid;
+};
+
+struct genid_table {
+  size_t mask;
+  struct genid_entry *entries;
+  time_t mtime; /* of the database it was loaded from */
+  off_t size;
+};
+
+static struct genid_table *genid_table;
+/* The table the last reload replaced. It is freed by the next one, well after
+ * the lookups that may have been reading it are done.
+ */
+static struct genid_table *genid_table_retired;
+
+static uint32_t
+genid_hash(const char *host, size_t len)
+{
+  uint32_t hash = 2166136261u; /* FNV-1a */
+  size_t i;
+
+  for (i = 0; i < len; ++i) {
+    hash = (hash ^ (unsigned char)host[i]) * 16777619u;
+  }
+  return hash;
+}
+
+static void
+genid_table_free(struct genid_table *table)
+{
+  size_t i;
+
+  if (table) {
+    for (i = 0; i <= table->mask; ++i) {
+      TSfree(table->entries[i].host);
+    }
+    TSfree(table->entries);
+    TSfree(table);
+  }
+}
+
+static void
+genid_table_insert(struct genid_table *table, const char *host, size_t len, int genid)
+{
+  uint32_t hash = genid_hash(host, len);
+  size_t i      = hash & table->mask;
+
+  while (table->entries[i].host && (table->entries[i].len != len || memcmp(table->entries[i].host, host, len) != 0)) {
+    i = (i + 1) & table->mask;
+  }
+  if (!table->entries[i].host) {
+    table->entries[i].host = TSstrndup(host, len);
+    table->entries[i].len  = len;
+    table->entries[i].hash = hash;
+  }
+  table->entries[i].genid = genid;
+}
+
+/* genid_table_load
+ * Reads all of the records of the database into a new table, NULL if the
+ * database can't be read.
+ */
+static struct genid_table *
+genid_table_load(const struct stat *st)
+{
+  struct genid_table *table;
+  KCDB *db;
+  KCCUR *cur;
+  char *kbuf;
+  const char *vbuf;
+  size_t ksiz, vsiz, slots = 16;
+  int64_t count;
+
+  db = kcdbnew();
+  if (!kcdbopen(db, genid_kyoto_db, KCOREADER | KCONOLOCK)) {
+    TSError("[%s] could not open the genid database %s: %s", PLUGIN_NAME, genid_kyoto_db, kcecodename(kcdbecode(db)));
+    kcdbdel(db);
+    return NULL;
+  }
+
+  /* Keep the table at most half full */
+  count = kcdbcount(db);
+  while ((int64_t)slots < 2 * count) {
+    slots *= 2;
+  }
+  table          = TSmalloc(sizeof(*table));
+  table->mask    = slots - 1;
+  table->entries = TSmalloc(slots * sizeof(*table->entries));
+  table->mtime   = st->st_mtime;
+  table->size    = st->st_size;
+  memset(table->entries, 0, slots * sizeof(*table->entries));
+
+  cur = kcdbcursor(db);
+  kccurjump(cur);
+  while ((kbuf = kccurget(cur, &ksiz, &vbuf, &vsiz, 1)) != NULL) {
+    /* The records added since the count would fill the table up */
+    if (count-- <= 0) {
+      kcfree(kbuf);
+      break;
+    }
+    genid_table_insert(table, kbuf, ksiz, (int)strtol(vbuf, NULL, 10));
+    kcfree(kbuf);
+  }
+  kccurdel(cur);
+  kcdbclose(db);
+  kcdbdel(db);
+
+  TSDebug(PLUGIN_NAME, "loaded the genid database %s into %zu slots", genid_kyoto_db, slots);
+  return table;
+}
+
+/* genid_table_refresh
+ * Loads the database again if it changed since the current table was loaded.
+ */
+static void
+genid_table_refresh(void)
+{
+  struct genid_table *current = __atomic_load_n(&genid_table, __ATOMIC_ACQUIRE);
+  struct genid_table *table;
+  struct stat st;
+
+  if (stat(genid_kyoto_db, &st) != 0) {
+    TSDebug(PLUGIN_NAME, "could not stat the genid database %s: %s", genid_kyoto_db, strerror(errno));
+    return;
+  }
+  if (current && current->mtime == st.st_mtime && current->size == st.st_size) {
+    return;
+  }
+  if ((table = genid_table_load(&st)) == NULL) {
+    return;
+  }
+
+  genid_table_free(genid_table_retired);
+  genid_table_retired = __atomic_exchange_n(&genid_table, table, __ATOMIC_ACQ_REL);
+}
+
+static int
+handle_refresh(TSCont contp, TSEvent event, void *edata)
+{
+  genid_table_refresh();
+  return 0;
+}
 
 // Find the host in url and set host to it
 static void
@@ -50,41 +211,32 @@ get_genid_host(char **host, char *url)
 }
 
 /* get_genid
- * Looks up the host's genid in the host->genid database
+ * Looks up the host's genid in the in memory copy of the host->genid database
  */
 static int
 get_genid(char *host)
 {
-  KCDB *db;
-  char *vbuf;
-  size_t vsiz;
-  int answer = 0;
-  int host_size;
+  struct genid_table *table = __atomic_load_n(&genid_table, __ATOMIC_ACQUIRE);
+  size_t host_size          = strlen(host);
+  uint32_t hash;
+  size_t i;
 
-  /* create the database object */
-  db = kcdbnew();
-
-  /* open the database */
-  if (!kcdbopen(db, genid_kyoto_db, KCOREADER | KCONOLOCK)) {
-    TSDebug(PLUGIN_NAME, "could not open the genid database %s", genid_kyoto_db);
-    TSError("[%s] could not open the genid database %s: %s", PLUGIN_NAME, genid_kyoto_db, strerror(errno));
+  if (!table) {
     return 0;
   }
 
-  vbuf = kcdbget(db, host, strlen(host), &vsiz);
+  hash = genid_hash(host, host_size);
+  for (i = hash & table->mask; table->entries[i].host; i = (i + 1) & table->mask) {
+    const struct genid_entry *entry = &table->entries[i];
 
-  if (vbuf) {
-    TSDebug(PLUGIN_NAME, "kcdbget(%s) = %s", host, vbuf);
-    answer = (int)strtol(vbuf, NULL, 10);
-    kcfree(vbuf);
-  } else {
-    host_size = strlen(host);
-    TSDebug(PLUGIN_NAME, "kcdbget(%s) - no record found, len(%d)", host, host_size);
-    answer = 0;
+    if (entry->hash == hash && entry->len == host_size && memcmp(entry->host, host, host_size) == 0) {
+      TSDebug(PLUGIN_NAME, "genid(%s) = %d", host, entry->genid);
+      return entry->genid;
+    }
   }
 
-  kcdbclose(db);
-  return answer;
+  TSDebug(PLUGIN_NAME, "genid(%s) - no record found, len(%zu)", host, host_size);
+  return 0;
 }
 
 /* handle_hook
@@ -166,11 +318,19 @@ TSPluginInit(int argc, const char *argv[])
     TSError("[%s] plugin registration failed. check argv[1] for db path", PLUGIN_NAME);
     return;
   }
+  if (argc > 2 && (genid_refresh_interval = (int)strtol(argv[2], NULL, 10)) <= 0) {
+    TSError("[%s] invalid refresh interval %s, using %d seconds", PLUGIN_NAME, argv[2], DEFAULT_REFRESH_INTERVAL);
+    genid_refresh_interval = DEFAULT_REFRESH_INTERVAL;
+  }
 
   if (TSPluginRegister(&info) != TS_SUCCESS) {
     TSError("[%s] plugin registration failed, check version", PLUGIN_NAME);
     return;
   }
 
+  /* The first load is done here, the later ones on a task thread */
+  genid_table_refresh();
+  TSContScheduleEveryOnPool(TSContCreate(handle_refresh, TSMutexCreate()), genid_refresh_interval * 1000, TS_THREAD_POOL_TASK);
+
   TSHttpHookAdd(TS_HTTP_READ_REQUEST_HDR_HOOK, TSContCreate((TSEventFunc)handle_hook, NULL));
 }
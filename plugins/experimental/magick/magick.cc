@@ -29,6 +29,7 @@
 #include <cassert>
 #include <cstring>
 
+#include <tscpp/api/Continuation.h>
 #include <tscpp/api/GlobalPlugin.h>
 #include <tscpp/api/PluginInit.h>
 #include <tscpp/api/TransformationPlugin.h>
@@ -273,7 +274,7 @@ struct Wand {
   {
     assert(nullptr != wand);
     wand = DestroyMagickWand(wand);
-    if (nullptr == blob) {
+    if (nullptr != blob) {
       blob = MagickRelinquishMemory(blob);
     }
   }
@@ -453,14 +454,44 @@ QueryParameterToArguments(CharVector &v)
   return result;
 }
 
+struct ImageTransform;
+
+/**
+ * the state of a background transformation, owned by the thread pool until the image is converted and then
+ * by a net thread which hands the output to the transformation, under the mutex of the transaction.
+ */
+struct ImageOutput : atscppapi::Continuation {
+  ImageTransform *transform_; // nullptr once the transaction is gone
+  CharVector arguments_;
+  CharPointerVector argumentMap_;
+  CharVector blob_;
+  std::string output_;
+
+  ImageOutput(ImageTransform *t, TSMutex m, CharVector &&a, CharPointerVector &&p, CharVector &&b)
+    : Continuation(m), transform_(t), arguments_(std::move(a)), argumentMap_(std::move(p)), blob_(std::move(b))
+  {
+  }
+
+  void convert();
+
+private:
+  int _run(TSEvent, void *) override;
+};
+
 struct ImageTransform : TransformationPlugin {
-  ~ImageTransform() override {}
+  ~ImageTransform() override
+  {
+    if (nullptr != output_) {
+      output_->transform_ = nullptr;
+    }
+  }
 
   ImageTransform(Transaction &t, CharVector &&a, CharPointerVector &&m, ThreadPool &p)
     : TransformationPlugin(t, TransformationPlugin::RESPONSE_TRANSFORMATION),
       arguments_(std::move(a)),
       argumentMap_(std::move(m)),
-      threadPool_(p)
+      threadPool_(p),
+      mutex_(TSContMutexGet(reinterpret_cast<TSCont>(t.getAtsHandle())))
   {
     TSDebug(PLUGIN_TAG, "ImageTransform");
   }
@@ -477,39 +508,70 @@ struct ImageTransform : TransformationPlugin {
   {
     TSDebug(PLUGIN_TAG, "handleInputComplete");
 
-    threadPool_.emplace_back([this](void) {
-      magick::Image image;
-      magick::Exception exception;
-      magick::Wand wand;
-
-      assert(!this->blob_.empty());
-
-      wand.readBlob(this->blob_);
-      wand.write("mpr:b");
-
-      const bool result = MagickCommandGenesis(image.info, ConvertImageCommand, this->argumentMap_.size(),
-                                               this->argumentMap_.data(), nullptr, exception.info) == MagickTrue;
-
-      wand.clear();
-      wand.read("mpr:a");
+    // the output is produced on a net thread, the transformation may be gone by the time the image is converted.
+    ImageOutput *const output = new ImageOutput(this, mutex_, std::move(arguments_), std::move(argumentMap_), std::move(blob_));
+    output_ = output;
 
-      const std::string_view output = wand.get();
-      this->produce(output);
-
-      TSDebug(PLUGIN_TAG, "Background transformation is done, resuming continuation (%p)", this);
-
-      this->setOutputComplete();
+    threadPool_.emplace_back([output](void) {
+      output->convert();
+      TSDebug(PLUGIN_TAG, "Background transformation is done, resuming continuation (%p)", output);
+      output->schedule(0, TS_THREAD_POOL_NET);
     });
 
     TSDebug(PLUGIN_TAG, "Scheduling background transformation (%p)", this);
   }
 
+  void
+  outputComplete(const std::string_view s)
+  {
+    output_ = nullptr;
+    produce(s);
+    setOutputComplete();
+  }
+
   CharVector arguments_;
   CharPointerVector argumentMap_;
   CharVector blob_;
   ThreadPool &threadPool_;
+  TSMutex mutex_;
+  ImageOutput *output_ = nullptr;
 };
 
+void
+ImageOutput::convert()
+{
+  magick::Image image;
+  magick::Exception exception;
+  magick::Wand wand;
+
+  assert(!blob_.empty());
+
+  wand.readBlob(blob_);
+  wand.write("mpr:b");
+
+  const bool result =
+    MagickCommandGenesis(image.info, ConvertImageCommand, argumentMap_.size(), argumentMap_.data(), nullptr, exception.info) ==
+    MagickTrue;
+  if (!result) {
+    TSDebug(PLUGIN_TAG, "ImageMagick's convert failed (%p)", this);
+  }
+
+  wand.clear();
+  wand.read("mpr:a");
+
+  output_ = wand.get();
+}
+
+int
+ImageOutput::_run(TSEvent, void *)
+{
+  if (nullptr != transform_) {
+    transform_->outputComplete(output_);
+  }
+  delete this;
+  return 0;
+}
+
 struct GlobalHookPlugin : GlobalPlugin {
   magick::Core core_;
   magick::EVPKey *key_ = nullptr;
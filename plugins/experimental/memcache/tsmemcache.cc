@@ -181,6 +181,10 @@ MC::die()
   }
   if (tbuf) {
     ats_free(tbuf);
+    tbuf = 0;
+  }
+  if (mget) {
+    mget_free();
   }
   mutex = NULL;
   theMCAllocator.free(this);
@@ -275,6 +279,7 @@ MC::write_binary_error(protocol_binary_response_status err, int swallow)
 
   size_t len = strlen(errstr);
   add_binary_header(err, 0, 0, len);
+  wbuf->write(errstr, len);
   if (swallow > 0) {
     int64_t avail = reader->read_avail();
     if (avail >= swallow) {
@@ -353,6 +358,7 @@ MC::read_from_client()
   ink_assert(!crvc && !cwvc);
   if (tbuf) {
     ats_free(tbuf);
+    tbuf = 0;
   }
   return TS_SET_CALL(&MC::read_from_client_event, VC_EVENT_READ_READY, rvio);
 }
@@ -420,43 +426,43 @@ get_pointer(MC *mc, int start, int len)
 static inline char *
 binary_get_key(MC *mc)
 {
-  return get_pointer(mc, 0, mc->binary_header.request.keylen);
+  return get_pointer(mc, sizeof(mc->binary_header) + mc->binary_header.request.extlen, mc->binary_header.request.keylen);
+}
+
+// whether the object opened by vc is the live item of key, not a collision or an expired or flushed item
+static bool
+valid_item(CacheVConnection *vc, const char *key, int nkey, MCCacheHeader **h)
+{
+  int hlen = 0;
+  if (vc->get_header((void **)h, &hlen) < 0) {
+    return false;
+  }
+  if (hlen < (int)sizeof(MCCacheHeader) || (*h)->magic != TSMEMCACHE_HEADER_MAGIC) {
+    return false;
+  }
+  if (nkey != (int)(*h)->nkey || hlen < (int)(sizeof(MCCacheHeader) + (*h)->nkey)) {
+    return false;
+  }
+  if (memcmp(key, (*h)->key(), nkey)) {
+    return false;
+  }
+  ink_hrtime t = Thread::get_hrtime();
+  return ((ink_hrtime)(*h)->settime) > MC::last_flush && t < ((ink_hrtime)(*h)->settime) + HRTIME_SECONDS((*h)->exptime);
 }
 
 int
 MC::cache_read_event(int event, void *data)
 {
   switch (event) {
-  case CACHE_EVENT_OPEN_READ: {
-    crvc     = (CacheVConnection *)data;
-    int hlen = 0;
-    if (crvc->get_header((void **)&rcache_header, &hlen) < 0) {
-      goto Lfail;
-    }
-    if (hlen < (int)sizeof(MCCacheHeader) || rcache_header->magic != TSMEMCACHE_HEADER_MAGIC) {
-      goto Lfail;
-    }
-    if (header.nkey != rcache_header->nkey || hlen < (int)(sizeof(MCCacheHeader) + rcache_header->nkey)) {
-      goto Lfail;
-    }
-    if (memcmp(key, rcache_header->key(), header.nkey)) {
-      goto Lfail;
-    }
-    {
-      ink_hrtime t = Thread::get_hrtime();
-      if (((ink_hrtime)rcache_header->settime) <= last_flush ||
-          t >= ((ink_hrtime)rcache_header->settime) + HRTIME_SECONDS(rcache_header->exptime)) {
-        goto Lfail;
-      }
+  case CACHE_EVENT_OPEN_READ:
+    crvc = (CacheVConnection *)data;
+    if (!valid_item(crvc, key, header.nkey, &rcache_header)) {
+      crvc->do_io_close();
+      crvc  = 0;
+      crvio = NULL;
+      event = CACHE_EVENT_OPEN_READ_FAILED; // convert to failure
     }
     break;
-  Lfail:
-    crvc->do_io_close();
-    crvc  = 0;
-    crvio = NULL;
-    event = CACHE_EVENT_OPEN_READ_FAILED; // convert to failure
-    break;
-  }
   case VC_EVENT_EOS:
   case VC_EVENT_ERROR:
   case CACHE_EVENT_OPEN_READ_FAILED:
@@ -494,48 +500,189 @@ MC::delete_item()
 }
 
 int
-MC::binary_get_event(int event, void *data)
+MCGet::cache_read_event(int event, void *data)
 {
-  ink_assert(!"EVENT_ITEM_GOT is incorrect here");
-  if (event != TSMEMCACHE_EVENT_GOT_ITEM) {
-    CHECK_READ_AVAIL(binary_header.request.keylen, &MC::binary_get);
-    key         = binary_get_key(this);
-    header.nkey = binary_header.request.keylen;
-    return get_item();
-  } else if (event == CACHE_EVENT_OPEN_READ_FAILED) {
-    if (f.noreply) {
-      return read_from_client();
+  pending_action = nullptr;
+  if (event == CACHE_EVENT_OPEN_READ) {
+    crvc = (CacheVConnection *)data;
+    if (!valid_item(crvc, key, nkey, &rcache_header)) {
+      crvc->do_io_close();
+      crvc = nullptr;
     }
-    if (binary_header.request.opcode == PROTOCOL_BINARY_CMD_GETK) {
-      add_binary_header(PROTOCOL_BINARY_RESPONSE_KEY_ENOENT, 0, header.nkey, header.nkey);
-      wbuf->write(key, header.nkey);
-      return write_then_read_from_client();
+  }
+  if (--mc->mget_pending == 0) {
+    return mc->handleEvent(TSMEMCACHE_EVENT_GOT_ITEM, this);
+  }
+  return EVENT_DONE;
+}
+
+// look up all of the keys in mget at once, the responses are written in order once all of them are done
+int
+MC::mget_start()
+{
+  SET_HANDLER(&MC::mget_event);
+  imget        = 0;
+  mget_pending = nmget + 1; // until all of the reads are issued
+  for (int i = 0; i < nmget; i++) {
+    MCGet *g = &mget[i];
+    g->mc    = this;
+    g->mutex = mutex;
+    SET_CONTINUATION_HANDLER(g, &MCGet::cache_read_event);
+    CryptoContext().hash_immediate(g->cache_key, (void *)g->key, g->nkey);
+    Action *a = cacheProcessor.open_read(g, &g->cache_key);
+    if (a != ACTION_RESULT_DONE) {
+      g->pending_action = a;
+    }
+  }
+  if (--mget_pending == 0) {
+    return mget_next();
+  }
+  return EVENT_CONT;
+}
+
+int
+MC::mget_next()
+{
+  for (; imget < nmget; imget++) {
+    MCGet *g  = &mget[imget];
+    bool getk = g->opcode == PROTOCOL_BINARY_CMD_GETK || g->opcode == PROTOCOL_BINARY_CMD_GETKQ;
+    if (f.mget_binary) {
+      binary_header.request.opcode = g->opcode;
+      binary_header.request.opaque = g->opaque;
+      header.cas                   = g->crvc ? g->rcache_header->cas : 0;
+    }
+    if (!g->crvc) {
+      if (!f.mget_binary || g->opcode == PROTOCOL_BINARY_CMD_GETQ || g->opcode == PROTOCOL_BINARY_CMD_GETKQ) {
+        continue;
+      }
+      if (getk) {
+        add_binary_header(PROTOCOL_BINARY_RESPONSE_KEY_ENOENT, 0, g->nkey, g->nkey);
+        wbuf->write(g->key, g->nkey);
+      } else {
+        write_binary_error(PROTOCOL_BINARY_RESPONSE_KEY_ENOENT, 0);
+      }
+      continue;
+    }
+    crvc          = g->crvc;
+    rcache_header = g->rcache_header;
+    g->crvc       = nullptr;
+    if (f.mget_binary) {
+      uint32_t flags = htonl(rcache_header->flags);
+      int keylen     = getk ? g->nkey : 0;
+      add_binary_header(0, sizeof(flags), keylen, sizeof(flags) + keylen + rcache_header->nbytes);
+      wbuf->write(&flags, sizeof(flags));
+      if (keylen) {
+        wbuf->write(g->key, keylen);
+      }
     } else {
-      return write_binary_error(PROTOCOL_BINARY_RESPONSE_KEY_ENOENT, 0);
-    }
-  } else if (event == CACHE_EVENT_OPEN_READ) {
-    protocol_binary_response_get *rsp = &res.get;
-    uint16_t keylen                   = 0;
-    uint32_t bodylen                  = sizeof(rsp->message.body) + (rcache_header->nbytes - 2);
-    bool getk =
-      (binary_header.request.opcode == PROTOCOL_BINARY_CMD_GETK || binary_header.request.opcode == PROTOCOL_BINARY_CMD_GETKQ);
-    if (getk) {
-      bodylen += header.nkey;
-      keylen = header.nkey;
-    }
-    add_binary_header(0, sizeof(rsp->message.body), keylen, bodylen);
-    rsp->message.header.response.cas = ink_hton64(rcache_header->cas);
-    rsp->message.body.flags          = htonl(rcache_header->flags);
-    wbuf->write(&rsp->message.body, sizeof(rsp->message.body));
-    if (getk) {
-      wbuf->write(key, header.nkey);
-    }
-    crvio = crvc->do_io_read(this, rcache_header->nbytes, wbuf);
-    return stream_then_read_from_client(rcache_header->nbytes);
-  } else {
-    return unexpected_event();
+      write_ascii_value(g->key, g->nkey);
+    }
+    if (!rcache_header->nbytes) {
+      crvc->do_io_close();
+      crvc = 0;
+      if (!f.mget_binary) {
+        wbuf->WRITE("\r\n");
+      }
+      continue;
+    }
+    crvio   = crvc->do_io_read(this, rcache_header->nbytes, wbuf);
+    creader = reader;
+    TS_PUSH_HANDLER(&MC::stream_event);
+    return write_to_client();
   }
-  return 0;
+  mget_free();
+  if (f.mget_binary) {
+    // go on with the commands after the gets
+    reader->consume(end_of_cmd);
+    write_to_client();
+    return read_from_client();
+  }
+  return ASCII_RESPONSE("END");
+}
+
+int
+MC::mget_event(int event, void *data)
+{
+  switch (event) {
+  case TSMEMCACHE_EVENT_GOT_ITEM:
+    return mget_next();
+  case TSMEMCACHE_STREAM_DONE:
+    crvc->do_io_close();
+    crvc  = 0;
+    crvio = NULL;
+    if (!f.mget_binary) {
+      wbuf->WRITE("\r\n");
+    }
+    imget++;
+    return mget_next();
+  case VC_EVENT_READ_READY:
+  case VC_EVENT_EOS:
+  case VC_EVENT_WRITE_READY:
+  case VC_EVENT_WRITE_COMPLETE:
+    return EVENT_CONT; // the next commands wait for the gets
+  default:
+    return die();
+  }
+}
+
+void
+MC::mget_free()
+{
+  for (int i = 0; i < nmget; i++) {
+    if (mget[i].pending_action) {
+      mget[i].pending_action->cancel();
+    }
+    if (mget[i].crvc) {
+      mget[i].crvc->do_io_close(1); // abort
+    }
+  }
+  delete[] mget;
+  mget  = nullptr;
+  nmget = 0;
+}
+
+static inline bool
+is_binary_get(uint8_t opcode)
+{
+  return opcode == PROTOCOL_BINARY_CMD_GET || opcode == PROTOCOL_BINARY_CMD_GETQ || opcode == PROTOCOL_BINARY_CMD_GETK ||
+         opcode == PROTOCOL_BINARY_CMD_GETKQ;
+}
+
+// take the run of complete gets at the start of the buffer, the first one already checked
+int
+MC::binary_mget()
+{
+  protocol_binary_request_header h;
+  int64_t avail  = reader->read_avail();
+  int64_t offset = 0;
+  int n          = 0;
+  while (n < TSMEMCACHE_MAX_MGET && offset + (int64_t)sizeof(h) <= avail) {
+    reader->memcpy(&h, sizeof(h), offset);
+    int keylen = ntohs(h.request.keylen);
+    if (h.request.magic != PROTOCOL_BINARY_REQ || !is_binary_get(h.request.opcode) || h.request.extlen != 0 ||
+        (int64_t)ntohl(h.request.bodylen) != keylen || keylen <= 0 || keylen > TSMEMCACHE_MAX_KEY_LEN ||
+        offset + (int64_t)sizeof(h) + keylen > avail) {
+      break;
+    }
+    offset += sizeof(h) + keylen;
+    n++;
+  }
+  ink_assert(n > 0);
+  mget   = new MCGet[n];
+  nmget  = n;
+  offset = 0;
+  for (int i = 0; i < n; i++) {
+    MCGet *g = &mget[i];
+    reader->memcpy(&h, sizeof(h), offset);
+    g->opcode = h.request.opcode;
+    g->opaque = h.request.opaque;
+    g->nkey   = ntohs(h.request.keylen);
+    reader->memcpy(g->key, g->nkey, offset + sizeof(h));
+    offset += sizeof(h) + g->nkey;
+  }
+  end_of_cmd    = offset;
+  f.mget_binary = 1;
+  return mget_start();
 }
 
 int
@@ -569,18 +716,25 @@ MC::read_binary_from_client_event(int event, void *data)
   switch (binary_header.request.opcode) {
   case PROTOCOL_BINARY_CMD_VERSION:
     CHECK_PROTOCOL(extlen == 0 && keylen == 0 && bodylen == 0);
-    return write_to_client(write_binary_response(TSMEMCACHE_VERSION, 0, 0, STRLEN(TSMEMCACHE_VERSION)));
+    write_to_client(write_binary_response(TSMEMCACHE_VERSION, 0, 0, STRLEN(TSMEMCACHE_VERSION)));
+    reader->consume(sizeof(binary_header));
+    return read_from_client();
   case PROTOCOL_BINARY_CMD_NOOP:
     CHECK_PROTOCOL(extlen == 0 && keylen == 0 && bodylen == 0);
-    return write_to_client(write_binary_response(NULL, 0, 0, 0));
+    write_to_client(write_binary_response(NULL, 0, 0, 0));
+    reader->consume(sizeof(binary_header));
+    return read_from_client();
   case PROTOCOL_BINARY_CMD_GETKQ:
     f.noreply = 1; // fall through
   case PROTOCOL_BINARY_CMD_GETQ:
     f.noreply = 1; // fall through
   case PROTOCOL_BINARY_CMD_GETK:
   case PROTOCOL_BINARY_CMD_GET:
-    CHECK_PROTOCOL(extlen == 0 && (int)bodylen == keylen && keylen > 0);
-    return TS_SET_CALL(&MC::binary_get_event, event, data);
+    CHECK_PROTOCOL(extlen == 0 && (int)bodylen == keylen && keylen > 0 && keylen <= TSMEMCACHE_MAX_KEY_LEN);
+    if (reader->read_avail() < (int64_t)sizeof(binary_header) + bodylen) {
+      return EVENT_CONT;
+    }
+    return binary_mget();
   case PROTOCOL_BINARY_CMD_APPENDQ:
   case PROTOCOL_BINARY_CMD_APPEND:
     f.set_append = 1;
@@ -607,7 +761,7 @@ MC::read_binary_from_client_event(int event, void *data)
     CHECK_PROTOCOL(extlen == 8 && keylen != 0 && bodylen >= keylen + 8);
   Lset:
     if (bin_read_key() < 0) {
-      return EVENT_CONT;
+      break;
     }
     key                              = binary_get_key(this);
     header.nkey                      = keylen;
@@ -667,7 +821,10 @@ MC::read_binary_from_client_event(int event, void *data)
     Warning("tsmemcache: unexpected binary opcode %x", binary_header.request.opcode);
     return die();
   }
-  return EVENT_CONT;
+  // not (yet) supported over the binary protocol, skip the command
+  write_to_client(write_binary_error(PROTOCOL_BINARY_RESPONSE_UNKNOWN_COMMAND, 0));
+  swallow_bytes = sizeof(binary_header) + bodylen;
+  return read_from_client();
 }
 
 int
@@ -712,6 +869,26 @@ MC::get_ascii_input(int n, int *end)
   return c;
 }
 
+void
+MC::write_ascii_value(const char *k, int nk)
+{
+  wbuf->WRITE("VALUE ");
+  wbuf->write(k, nk);
+  wbuf->WRITE(" ");
+  char t[32], *te = t + 32;
+  char *flags = xutoa(rcache_header->flags, te);
+  wbuf->write(flags, te - flags);
+  wbuf->WRITE(" ");
+  char *bytes = xutoa(rcache_header->nbytes, te);
+  wbuf->write(bytes, te - bytes);
+  if (f.return_cas) {
+    wbuf->WRITE(" ");
+    char *pcas = xutoa(rcache_header->cas, te);
+    wbuf->write(pcas, te - pcas);
+  }
+  wbuf->WRITE("\r\n");
+}
+
 int
 MC::ascii_get_event(int event, void *data)
 {
@@ -721,21 +898,7 @@ MC::ascii_get_event(int event, void *data)
     read_offset = 0;
     break;
   case CACHE_EVENT_OPEN_READ: {
-    wbuf->WRITE("VALUE ");
-    wbuf->write(key, header.nkey);
-    wbuf->WRITE(" ");
-    char t[32], *te = t + 32;
-    char *flags = xutoa(rcache_header->flags, te);
-    wbuf->write(flags, te - flags);
-    wbuf->WRITE(" ");
-    char *bytes = xutoa(rcache_header->nbytes, te);
-    wbuf->write(bytes, te - bytes);
-    if (f.return_cas) {
-      wbuf->WRITE(" ");
-      char *pcas = xutoa(rcache_header->cas, te);
-      wbuf->write(pcas, te - pcas);
-    }
-    wbuf->WRITE("\r\n");
+    write_ascii_value(key, header.nkey);
     int ntowrite = writer->read_avail() + rcache_header->nbytes;
     crvio        = crvc->do_io_read(this, rcache_header->nbytes, wbuf);
     creader      = reader;
@@ -1057,9 +1220,61 @@ MC::get_ascii_key(char *as, char *e)
   return TSMEMCACHE_EVENT_GOT_KEY;
 }
 
+static int
+count_ascii_keys(const char *s, const char *e)
+{
+  int n = 0;
+  while (s < e) {
+    if (isspace(*s)) {
+      s++;
+      continue;
+    }
+    const char *k = s;
+    while (s < e && !isspace(*s)) {
+      s++;
+    }
+    if (s - k > TSMEMCACHE_MAX_KEY_LEN) {
+      return -1;
+    }
+    n++;
+  }
+  return n;
+}
+
+int
+MC::ascii_mget(char *s, char *e, int n)
+{
+  mget  = new MCGet[n];
+  nmget = 0;
+  while (s < e) {
+    if (isspace(*s)) {
+      s++;
+      continue;
+    }
+    MCGet *g = &mget[nmget++];
+    char *k  = s;
+    while (s < e && !isspace(*s)) {
+      s++;
+    }
+    g->nkey = s - k;
+    memcpy(g->key, k, g->nkey);
+  }
+  end_of_cmd    = 0; // END swallows the line
+  f.mget_binary = 0;
+  return mget_start();
+}
+
 int
 MC::ascii_get(char *as, char *e)
 {
+  // with the whole line at hand, look up all of its keys at once
+  if (!ngets) {
+    char *nl = (char *)memchr(as, '\n', e - as);
+    int n    = nl ? count_ascii_keys(as, nl) : 0;
+    if (n > 1 && n <= TSMEMCACHE_MAX_MGET) {
+      return ascii_mget(as, nl, n);
+    }
+  }
   SET_HANDLER(&MC::ascii_get_event);
   CHECK_RET(get_ascii_key(as, e), TSMEMCACHE_EVENT_GOT_KEY);
   ngets++;
@@ -39,6 +39,7 @@
 #define TSMEMCACHE_MAX_CMD_SIZE (128 * 1024 * 1024) // silly large
 #define TSMEMCACHE_MAX_KEY_LEN 250
 #define TSMEMCACHE_TMP_CMD_BUFFER_SIZE 320
+#define TSMEMCACHE_MAX_MGET 256 // keys looked up in parallel by one get
 #define TSMEMCACHE_HEADER_MAGIC 0x8765ACDC
 #define TSMEMCACHE_RETRY_WRITE_INTERVAL HRTIME_MSECONDS(20)
 
@@ -112,6 +113,23 @@ struct MCAccept : public Continuation {
 #define ASCII_SERVER_ERROR(_s) ascii_response(("SERVER_ERROR: " _s "\r\n"), sizeof("SERVER_ERROR: " _s "\r\n") - 1)
 #define STRCMP(_s, _const_string) strncmp(_s, _const_string "", sizeof(_const_string) - 1)
 
+struct MC;
+
+// One of the keys of a multi-key get, looked up in parallel with the others.
+struct MCGet : Continuation {
+  MC *mc                       = nullptr;
+  Action *pending_action       = nullptr;
+  CacheVConnection *crvc       = nullptr; // NULL on a miss
+  MCCacheHeader *rcache_header = nullptr;
+  CacheKey cache_key;
+  uint32_t opaque = 0; // binary protocol only
+  uint8_t opcode  = 0;
+  int nkey        = 0;
+  char key[TSMEMCACHE_MAX_KEY_LEN];
+
+  int cache_read_event(int event, void *data);
+};
+
 struct MC : Continuation {
   Action *pending_action;
   int ihandler_stack;
@@ -136,6 +154,8 @@ struct MC : Continuation {
   int read_offset;
   int end_of_cmd; // -1 means that it is already consumed
   int ngets;
+  MCGet *mget; // the keys of a multi-key get
+  int nmget, imget, mget_pending;
   char tmp_cmd_buffer[TSMEMCACHE_TMP_CMD_BUFFER_SIZE];
   union {
     struct {
@@ -148,6 +168,7 @@ struct MC : Continuation {
       unsigned int set_replace : 1;
       unsigned int set_incr : 1;
       unsigned int set_decr : 1;
+      unsigned int mget_binary : 1;
     } f;
     unsigned int ff;
   };
@@ -171,7 +192,7 @@ struct MC : Continuation {
   int swallow_cmd_then_read_from_client_event(int event, void *data);
   int read_binary_from_client_event(int event, void *data);
   int read_ascii_from_client_event(int event, void *data);
-  int binary_get_event(int event, void *data);
+  int mget_event(int event, void *data);
   int cache_read_event(int event, void *data);
   int write_then_close_event(int event, void *data);
   int stream_event(int event, void *data); // cache <=> client
@@ -180,8 +201,10 @@ struct MC : Continuation {
   char *get_ascii_input(int n, int *end);
   int get_ascii_key(char *s, char *e);
   int ascii_response(const char *s, int len);
+  void write_ascii_value(const char *k, int nk);
   int ascii_get(char *s, char *e);
   int ascii_gets();
+  int ascii_mget(char *s, char *e, int n);
   int ascii_set(char *s, char *e);
   int ascii_delete(char *s, char *e);
   int ascii_incr_decr(char *s, char *e);
@@ -195,6 +218,11 @@ struct MC : Continuation {
   int write_binary_response(const void *d, int hlen, int keylen, int dlen);
   int protocol_error();
   int bin_read_key();
+  int binary_mget();
+
+  int mget_start();
+  int mget_next();
+  void mget_free();
 
   void new_connection(NetVConnection *netvc, EThread *thread);
   int unexpected_event();
@@ -450,6 +450,8 @@ mp4_parse_meta(Mp4TransformContext *mtc, bool body_complete)
   avail = TSIOBufferReaderAvail(mtc->dup_reader);
   blk   = TSIOBufferReaderStart(mtc->dup_reader);
 
+  // The meta data is copied, not referenced with TSIOBufferCopy(), the atoms are patched in place
+  // while they are rewritten. Only the meta data is materialized, the payload is referenced.
   while (blk != nullptr) {
     data = TSIOBufferBlockReadStart(blk, mtc->dup_reader, &bytes);
     if (bytes > 0) {
@@ -24,6 +24,7 @@
 
 #include "ts/ts.h"
 #include <stdint.h>
+#include <stdlib.h>
 #include <stdbool.h>
 #include <string.h>
 #include <stdio.h>
@@ -35,18 +36,27 @@
 
 #define MAX_STAT_LENGTH (1 << 8)
 
+// The hosts beyond --max-hosts share the stats of this one.
+#define OTHER_HOST "other"
+#define DEFAULT_MAX_HOSTS 1000
+
 typedef struct {
   bool post_remap_host;
+  bool origin_stats;
   int txn_slot;
+  int max_hosts;
   TSStatPersistence persist_type;
   TSMutex stat_creation_mutex;
+  void *hosts; // tsearch() tree of the hosts with stats, under stat_creation_mutex
+  int host_count;
 } config_t;
 
 // From "core".... sigh, but we need it for now at least.
 extern int max_records_entries;
 
-static void
-stat_add(char *name, TSMgmtInt amount, TSStatPersistence persist_type, TSMutex create_mutex)
+// The id of the stat @a name, created on first use.
+static int
+stat_get(char *name, TSStatPersistence persist_type, TSStatSync sync, TSMutex create_mutex)
 {
   int stat_id = -1;
   ENTRY search, *result = NULL;
@@ -69,9 +79,13 @@ stat_add(char *name, TSMgmtInt amount, TSStatPersistence persist_type, TSMutex c
     // This is an unlikely path because we most likely have the stat cached
     // so this mutex won't be much overhead and it fixes a race condition
     // in the RecCore. Hopefully this can be removed in the future.
+    char find_name[MAX_STAT_LENGTH + 8];
+
+    // A histogram is found by the name of its count.
+    snprintf(find_name, sizeof(find_name), sync == TS_STAT_SYNC_HISTOGRAM ? "%s.count" : "%s", name);
     TSMutexLock(create_mutex);
-    if (TS_ERROR == TSStatFindName((const char *)name, &stat_id)) {
-      stat_id = TSStatCreate((const char *)name, TS_RECORDDATATYPE_INT, persist_type, TS_STAT_SYNC_SUM);
+    if (TS_ERROR == TSStatFindName(find_name, &stat_id)) {
+      stat_id = TSStatCreate((const char *)name, TS_RECORDDATATYPE_INT, persist_type, sync);
       if (stat_id == TS_ERROR) {
         TSDebug(DEBUG_TAG, "Error creating stat_name: %s", name);
       } else {
@@ -91,11 +105,86 @@ stat_add(char *name, TSMgmtInt amount, TSStatPersistence persist_type, TSMutex c
     stat_id = (int)((intptr_t)result->data);
   }
 
+  if (unlikely(stat_id < 0)) {
+    TSDebug(DEBUG_TAG, "stat error! stat_name: %s stat_id: %d", name, stat_id);
+  }
+  return stat_id;
+}
+
+static void
+stat_add(char *name, TSMgmtInt amount, TSStatPersistence persist_type, TSMutex create_mutex)
+{
+  int stat_id = stat_get(name, persist_type, TS_STAT_SYNC_SUM, create_mutex);
+
   if (likely(stat_id >= 0)) {
     TSStatIntIncrement(stat_id, amount);
+  }
+}
+
+static void
+stat_record(char *name, TSMgmtInt value, TSMutex create_mutex)
+{
+  // The records of a histogram are never persistent.
+  int stat_id = stat_get(name, TS_STAT_NON_PERSISTENT, TS_STAT_SYNC_HISTOGRAM, create_mutex);
+
+  if (likely(stat_id >= 0)) {
+    TSStatHistogramRecord(stat_id, value);
+  }
+}
+
+static int
+host_compare(const void *a, const void *b)
+{
+  return strcmp((const char *)a, (const char *)b);
+}
+
+// The name the stats of @a host go under, OTHER_HOST once there are stats for max_hosts hosts.
+static const char *
+host_admit(config_t *config, const char *host)
+{
+  ENTRY search, *result = NULL;
+  static __thread struct hsearch_data host_cache;
+  static __thread bool hash_init = false;
+
+  if (config->max_hosts <= 0) {
+    return host;
+  }
+
+  if (unlikely(!hash_init)) {
+    // NOLINTNEXTLINE
+    hcreate_r(config->max_hosts << 2, &host_cache);
+    hash_init = true;
+  }
+
+  search.key  = (char *)host;
+  search.data = 0;
+  // NOLINTNEXTLINE
+  hsearch_r(search, FIND, &result, &host_cache);
+  if (likely(result != NULL)) {
+    return result->data ? host : OTHER_HOST;
+  }
+
+  bool admitted;
+  TSMutexLock(config->stat_creation_mutex);
+  if (tfind(host, &config->hosts, host_compare)) {
+    admitted = true;
+  } else if (config->host_count < config->max_hosts) {
+    tsearch(TSstrdup(host), &config->hosts, host_compare);
+    ++config->host_count;
+    admitted = true;
   } else {
-    TSDebug(DEBUG_TAG, "stat error! stat_name: %s stat_id: %d", name, stat_id);
+    admitted = false;
+  }
+  TSMutexUnlock(config->stat_creation_mutex);
+
+  // Only the admitted hosts are cached, the others are at most as many lookups as there are hosts.
+  if (admitted) {
+    search.key  = TSstrdup(host);
+    search.data = (void *)1;
+    // NOLINTNEXTLINE
+    hsearch_r(search, ENTER, &result, &host_cache);
   }
+  return admitted ? host : OTHER_HOST;
 }
 
 static char *
@@ -162,6 +251,52 @@ handle_post_remap(TSCont cont, TSEvent event ATS_UNUSED, void *edata)
 
 #define CREATE_STAT_NAME(s, h, b) snprintf(s, MAX_STAT_LENGTH, "plugin.%s.%s.%s", PLUGIN_NAME, h, b)
 
+// The microseconds from milestone @a from to milestone @a to, or -1 if the transaction didn't reach both.
+static TSMgmtInt
+milestone_usecs(TSHttpTxn txn, TSMilestonesType from, TSMilestonesType to)
+{
+  TSHRTime start = 0, end = 0;
+
+  if (TSHttpTxnMilestoneGet(txn, from, &start) != TS_SUCCESS || TSHttpTxnMilestoneGet(txn, to, &end) != TS_SUCCESS ||
+      start == 0 || end < start) {
+    return -1;
+  }
+  return (TSMgmtInt)((end - start) / 1000);
+}
+
+// The origin side stats of @a txn, under @a key: the origin latencies, the cache hits and the bytes from and to the origin.
+static void
+add_origin_stats(TSHttpTxn txn, config_t *config, const char *key)
+{
+  char stat_name[MAX_STAT_LENGTH];
+  int lookup_status;
+  TSMgmtInt usecs;
+
+  if (TSHttpTxnCacheLookupStatusGet(txn, &lookup_status) == TS_SUCCESS && lookup_status != TS_CACHE_LOOKUP_SKIPPED) {
+    CREATE_STAT_NAME(stat_name, key, lookup_status == TS_CACHE_LOOKUP_HIT_FRESH ? "cache_hit" : "cache_miss");
+    stat_add(stat_name, 1, config->persist_type, config->stat_creation_mutex);
+  }
+
+  // Nothing went to the origin for a cache hit.
+  if ((usecs = milestone_usecs(txn, TS_MILESTONE_SERVER_CONNECT, TS_MILESTONE_SERVER_CONNECT_END)) >= 0) {
+    CREATE_STAT_NAME(stat_name, key, "connect_time_us");
+    stat_record(stat_name, usecs, config->stat_creation_mutex);
+  }
+  if ((usecs = milestone_usecs(txn, TS_MILESTONE_SERVER_BEGIN_WRITE, TS_MILESTONE_SERVER_FIRST_READ)) >= 0) {
+    CREATE_STAT_NAME(stat_name, key, "ttfb_us");
+    stat_record(stat_name, usecs, config->stat_creation_mutex);
+
+    TSMgmtInt origin_in_bytes  = TSHttpTxnServerRespHdrBytesGet(txn) + TSHttpTxnServerRespBodyBytesGet(txn);
+    TSMgmtInt origin_out_bytes = TSHttpTxnServerReqHdrBytesGet(txn) + TSHttpTxnServerReqBodyBytesGet(txn);
+
+    CREATE_STAT_NAME(stat_name, key, "origin_in_bytes");
+    stat_add(stat_name, origin_in_bytes, config->persist_type, config->stat_creation_mutex);
+
+    CREATE_STAT_NAME(stat_name, key, "origin_out_bytes");
+    stat_add(stat_name, origin_out_bytes, config->persist_type, config->stat_creation_mutex);
+  }
+}
+
 static int
 handle_txn_close(TSCont cont, TSEvent event ATS_UNUSED, void *edata)
 {
@@ -174,6 +309,7 @@ handle_txn_close(TSCont cont, TSEvent event ATS_UNUSED, void *edata)
   uint64_t out_bytes, in_bytes;
   char *remap, *hostname;
   char *unknown = "unknown";
+  const char *key;
   char stat_name[MAX_STAT_LENGTH];
 
   config = (config_t *)TSContDataGet(cont);
@@ -193,17 +329,18 @@ handle_txn_close(TSCont cont, TSEvent event ATS_UNUSED, void *edata)
       if (!remap) {
         remap = unknown;
       }
+      key = host_admit(config, remap);
 
       in_bytes = TSHttpTxnClientReqHdrBytesGet(txn);
       in_bytes += TSHttpTxnClientReqBodyBytesGet(txn);
 
-      CREATE_STAT_NAME(stat_name, remap, "in_bytes");
+      CREATE_STAT_NAME(stat_name, key, "in_bytes");
       stat_add(stat_name, (TSMgmtInt)in_bytes, config->persist_type, config->stat_creation_mutex);
 
       out_bytes = TSHttpTxnClientRespHdrBytesGet(txn);
       out_bytes += TSHttpTxnClientRespBodyBytesGet(txn);
 
-      CREATE_STAT_NAME(stat_name, remap, "out_bytes");
+      CREATE_STAT_NAME(stat_name, key, "out_bytes");
       stat_add(stat_name, (TSMgmtInt)out_bytes, config->persist_type, config->stat_creation_mutex);
 
       if (TSHttpTxnClientRespGet(txn, &buf, &hdr_loc) == TS_SUCCESS) {
@@ -211,25 +348,37 @@ handle_txn_close(TSCont cont, TSEvent event ATS_UNUSED, void *edata)
         TSHandleMLocRelease(buf, TS_NULL_MLOC, hdr_loc);
 
         if (status_code < 200) {
-          CREATE_STAT_NAME(stat_name, remap, "status_other");
+          CREATE_STAT_NAME(stat_name, key, "status_other");
         } else if (status_code <= 299) {
-          CREATE_STAT_NAME(stat_name, remap, "status_2xx");
+          CREATE_STAT_NAME(stat_name, key, "status_2xx");
         } else if (status_code <= 399) {
-          CREATE_STAT_NAME(stat_name, remap, "status_3xx");
+          CREATE_STAT_NAME(stat_name, key, "status_3xx");
         } else if (status_code <= 499) {
-          CREATE_STAT_NAME(stat_name, remap, "status_4xx");
+          CREATE_STAT_NAME(stat_name, key, "status_4xx");
         } else if (status_code <= 599) {
-          CREATE_STAT_NAME(stat_name, remap, "status_5xx");
+          CREATE_STAT_NAME(stat_name, key, "status_5xx");
         } else {
-          CREATE_STAT_NAME(stat_name, remap, "status_other");
+          CREATE_STAT_NAME(stat_name, key, "status_other");
         }
 
         stat_add(stat_name, 1, config->persist_type, config->stat_creation_mutex);
       } else {
-        CREATE_STAT_NAME(stat_name, remap, "status_unknown");
+        CREATE_STAT_NAME(stat_name, key, "status_unknown");
         stat_add(stat_name, 1, config->persist_type, config->stat_creation_mutex);
       }
 
+      add_origin_stats(txn, config, key);
+
+      if (config->origin_stats) {
+        // The origin is the host after remap.
+        char *origin = config->post_remap_host ? NULL : get_effective_host(txn);
+        char origin_key[MAX_STAT_LENGTH];
+
+        snprintf(origin_key, sizeof(origin_key), "origin.%s", host_admit(config, origin ? origin : remap));
+        add_origin_stats(txn, config, origin_key);
+        TSfree(origin);
+      }
+
       if (remap != unknown) {
         TSfree(remap);
       }
@@ -264,15 +413,22 @@ TSPluginInit(int argc, const char *argv[])
 
   config                      = TSmalloc(sizeof(config_t));
   config->post_remap_host     = false;
+  config->origin_stats        = false;
+  config->max_hosts           = DEFAULT_MAX_HOSTS;
   config->persist_type        = TS_STAT_NON_PERSISTENT;
   config->stat_creation_mutex = TSMutexCreate();
+  config->hosts               = NULL;
+  config->host_count          = 0;
 
   if (argc > 1) {
     int c;
-    static const struct option longopts[] = {
-      {"post-remap-host", no_argument, NULL, 'P'}, {"persistent", no_argument, NULL, 'p'}, {NULL, 0, NULL, 0}};
+    static const struct option longopts[] = {{"post-remap-host", no_argument, NULL, 'P'},
+                                             {"persistent", no_argument, NULL, 'p'},
+                                             {"origin-stats", no_argument, NULL, 'o'},
+                                             {"max-hosts", required_argument, NULL, 'm'},
+                                             {NULL, 0, NULL, 0}};
 
-    while ((c = getopt_long(argc, (char *const *)argv, "Pp", longopts, NULL)) != -1) {
+    while ((c = getopt_long(argc, (char *const *)argv, "Ppom:", longopts, NULL)) != -1) {
       switch (c) {
       case 'P':
         config->post_remap_host = true;
@@ -282,6 +438,14 @@ TSPluginInit(int argc, const char *argv[])
         config->persist_type = TS_STAT_PERSISTENT;
         TSDebug(DEBUG_TAG, "Using persistent stats");
         break;
+      case 'o':
+        config->origin_stats = true;
+        TSDebug(DEBUG_TAG, "Adding per origin stats");
+        break;
+      case 'm':
+        config->max_hosts = atoi(optarg);
+        TSDebug(DEBUG_TAG, "Stats for at most %d hosts", config->max_hosts);
+        break;
       default:
         break;
       }
@@ -96,6 +96,8 @@ Config::fromArgs(int const argc, char const *const argv[])
     {const_cast<char *>("test-blockbytes"), required_argument, nullptr, 't'},
     {const_cast<char *>("pace-errorlog"), required_argument, nullptr, 'p'},
     {const_cast<char *>("disable-errorlog"), no_argument, nullptr, 'd'},
+    {const_cast<char *>("prefetch-count"), required_argument, nullptr, 'f'},
+    {const_cast<char *>("prefetch-fill"), no_argument, nullptr, 'F'},
     {nullptr, 0, nullptr, 0},
   };
 
@@ -103,7 +105,7 @@ Config::fromArgs(int const argc, char const *const argv[])
   char *const *argvp = ((char *const *)argv - 1);
 
   for (;;) {
-    int const opt = getopt_long(argc + 1, argvp, "b:t:p:d", longopts, nullptr);
+    int const opt = getopt_long(argc + 1, argvp, "b:t:p:df:F", longopts, nullptr);
     if (-1 == opt) {
       break;
     }
@@ -144,6 +146,17 @@ Config::fromArgs(int const argc, char const *const argv[])
     case 'd':
       m_paceerrsecs = -1;
       break;
+    case 'f': {
+      int const countread = atoi(optarg);
+      if (0 <= countread) {
+        m_prefetchcount = countread;
+      } else {
+        ERROR_LOG("Invalid prefetch-count: %s", optarg);
+      }
+    } break;
+    case 'F':
+      m_prefetchfill = true;
+      break;
     default:
       break;
     }
@@ -164,6 +177,14 @@ Config::fromArgs(int const argc, char const *const argv[])
     DEBUG_LOG("Block stitching error logs at most every %d sec(s)", m_paceerrsecs);
   }
 
+  if (0 < m_prefetchcount) {
+    if (m_prefetchfill) {
+      DEBUG_LOG("Filling the remaining blocks %d at a time", m_prefetchcount);
+    } else {
+      DEBUG_LOG("Prefetching %d block(s) ahead", m_prefetchcount);
+    }
+  }
+
   return true;
 }
 
@@ -29,7 +29,9 @@ struct Config {
   static constexpr int64_t const blockbytesdefault = 1024 * 1024;      // 1MB
 
   int64_t m_blockbytes{blockbytesdefault};
-  int m_paceerrsecs{0}; // -1 disable logging, 0 no pacing, max 60s
+  int m_paceerrsecs{0};       // -1 disable logging, 0 no pacing, max 60s
+  int m_prefetchcount{0};     // number of blocks to fetch ahead in the background
+  bool m_prefetchfill{false}; // fetch all the remaining blocks, m_prefetchcount at a time
 
   // Convert optarg to bytes
   static int64_t bytesFrom(char const *const valstr);
@@ -63,6 +63,8 @@ struct Data {
   int64_t m_blockconsumed; // body bytes consumed
   bool m_iseos;            // server in EOS state
 
+  int64_t m_blockprefetched{-1}; // last block handed to a background fetch
+
   int64_t m_bytestosend; // header + content bytes to send
   int64_t m_bytessent;   // number of bytes written to the client
 
@@ -18,6 +18,7 @@
 
 #include "client.h"
 
+#include "prefetch.h"
 #include "transfer.h"
 
 namespace
@@ -82,6 +83,11 @@ requestBlock(TSCont contp, Data *const data)
   data->m_iseos                      = false;
   data->m_server_block_header_parsed = false;
 
+  // the blocks to prefetch are known once the first header gave the content length
+  if (data->m_server_first_header_parsed) {
+    prefetch_blocks(data);
+  }
+
   return true;
 }
 
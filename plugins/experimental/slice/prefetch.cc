@@ -0,0 +1,249 @@
+/** @file
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ */
+
+#include "prefetch.h"
+
+#include <algorithm>
+#include <cinttypes>
+#include <memory>
+#include <vector>
+
+namespace
+{
+struct BgBlockFetch {
+  BgBlockFetch(BgBlockFetch const &) = delete;
+  BgBlockFetch &operator=(BgBlockFetch const &) = delete;
+
+  Stage m_stream;
+  int64_t m_blocknum;
+
+  explicit BgBlockFetch(int64_t const blocknum) : m_blocknum(blocknum) {}
+};
+
+/** Fill of a whole range by a fixed number of parallel block fetches.
+ * Each fetch that is done starts the next block, independently of the
+ * client, which may even be gone already: the fill keeps its own copy
+ * of the block request header.
+ */
+struct BgFill {
+  BgFill(BgFill const &) = delete;
+  BgFill &operator=(BgFill const &) = delete;
+
+  HdrMgr m_req_hdrmgr;
+  sockaddr_storage m_client_ip;
+  int64_t m_blockbytes;
+  int64_t m_nextblock;
+  int64_t m_endblock; // one past the last block to fill
+  std::vector<std::unique_ptr<Stage>> m_streams;
+  int m_active{0};
+
+  BgFill(Data const *const data, int64_t const begblock, int64_t const endblock)
+    : m_client_ip(data->m_client_ip), m_blockbytes(data->m_config->m_blockbytes), m_nextblock(begblock), m_endblock(endblock)
+  {
+    m_req_hdrmgr.m_buffer = TSMBufferCreate();
+    m_req_hdrmgr.m_lochdr = TSHttpHdrCreate(m_req_hdrmgr.m_buffer);
+    TSHttpHdrCopy(m_req_hdrmgr.m_buffer, m_req_hdrmgr.m_lochdr, data->m_req_hdrmgr.m_buffer, data->m_req_hdrmgr.m_lochdr);
+  }
+};
+
+// write the request of a block to the given stream, on a new connection back into ATS
+bool
+writeBlockRequest(Stage &stream, TSCont const contp, HdrMgr const &hdrmgr, sockaddr_storage const &client_ip,
+                  int64_t const blockbytes, int64_t const blocknum)
+{
+  int64_t const blockbeg = (blockbytes * blocknum);
+  Range blockbe(blockbeg, blockbeg + blockbytes);
+
+  char rangestr[1024];
+  int rangelen      = sizeof(rangestr);
+  bool const rpstat = blockbe.toStringClosed(rangestr, &rangelen);
+  TSAssert(rpstat);
+
+  // the block requests set their own range, so the header can be shared with them
+  HttpHeader header(hdrmgr.m_buffer, hdrmgr.m_lochdr);
+  if (!header.setKeyVal(TS_MIME_FIELD_RANGE, TS_MIME_LEN_RANGE, rangestr, rangelen)) {
+    ERROR_LOG("Error trying to set range request header %s", rangestr);
+    return false;
+  }
+
+  DEBUG_LOG("background fetch: %s", rangestr);
+
+  stream.setupConnection(TSHttpConnect((sockaddr *)&client_ip));
+  stream.setupVioWrite(contp);
+
+  TSHttpHdrPrint(header.m_buffer, header.m_lochdr, stream.m_write.m_iobuf);
+  TSVIOReenable(stream.m_write.m_vio);
+
+  stream.setupVioRead(contp);
+
+  return true;
+}
+
+int
+bg_fill_handler(TSCont contp, TSEvent event, void *edata)
+{
+  BgFill *const fill = static_cast<BgFill *>(TSContDataGet(contp));
+  TSVIO const vio    = static_cast<TSVIO>(edata);
+
+  auto const spot = std::find_if(fill->m_streams.begin(), fill->m_streams.end(), [vio](std::unique_ptr<Stage> const &stream) {
+    return stream->m_read.m_vio == vio || stream->m_write.m_vio == vio;
+  });
+  if (fill->m_streams.end() == spot) {
+    return 0;
+  }
+  Stage &stream = **spot;
+
+  switch (event) {
+  case TS_EVENT_VCONN_READ_READY:
+    stream.m_read.drainReader();
+    TSVIOReenable(stream.m_read.m_vio);
+    break;
+  case TS_EVENT_VCONN_WRITE_READY:
+  case TS_EVENT_VCONN_WRITE_COMPLETE:
+    break;
+  default:
+    // read complete, eos or error: on to the next block
+    stream.close();
+    if (fill->m_nextblock < fill->m_endblock &&
+        writeBlockRequest(stream, contp, fill->m_req_hdrmgr, fill->m_client_ip, fill->m_blockbytes, fill->m_nextblock)) {
+      ++fill->m_nextblock;
+    } else if (0 == --fill->m_active) {
+      DEBUG_LOG("background fill done");
+      delete fill;
+      TSContDestroy(contp);
+    }
+    break;
+  }
+
+  return 0;
+}
+
+// start a background fill of the blocks in [begblock, endblock)
+void
+startBgFill(Data *const data, int64_t const begblock, int64_t const endblock)
+{
+  int const count    = data->m_config->m_prefetchcount;
+  BgFill *const fill = new BgFill(data, begblock, endblock);
+  TSCont const contp = TSContCreate(bg_fill_handler, TSMutexCreate());
+  TSContDataSet(contp, fill);
+
+  DEBUG_LOG("background fill of blocks %" PRId64 "-%" PRId64 " with %d fetches", begblock, endblock - 1, count);
+
+  // the continuation mutex is not ours until the events start coming in
+  TSMutexLock(TSContMutexGet(contp));
+
+  while (fill->m_active < count && fill->m_nextblock < endblock) {
+    fill->m_streams.emplace_back(new Stage);
+    if (!writeBlockRequest(*fill->m_streams.back(), contp, fill->m_req_hdrmgr, fill->m_client_ip, fill->m_blockbytes,
+                           fill->m_nextblock)) {
+      fill->m_streams.pop_back();
+      break;
+    }
+    ++fill->m_nextblock;
+    ++fill->m_active;
+  }
+
+  bool const idle = (0 == fill->m_active);
+
+  TSMutexUnlock(TSContMutexGet(contp));
+
+  if (idle) {
+    delete fill;
+    TSContDestroy(contp);
+  }
+}
+
+int
+bg_block_fetch_handler(TSCont contp, TSEvent event, void * /* edata ATS_UNUSED */)
+{
+  BgBlockFetch *const bg = static_cast<BgBlockFetch *>(TSContDataGet(contp));
+
+  switch (event) {
+  case TS_EVENT_VCONN_READ_READY:
+    bg->m_stream.m_read.drainReader();
+    TSVIOReenable(bg->m_stream.m_read.m_vio);
+    break;
+  case TS_EVENT_VCONN_WRITE_READY:
+  case TS_EVENT_VCONN_WRITE_COMPLETE:
+    break;
+  default:
+    // read complete, eos or error: all done either way
+    DEBUG_LOG("background fetch of block %" PRId64 " done, event: %d", bg->m_blocknum, event);
+    delete bg;
+    TSContDestroy(contp);
+    break;
+  }
+
+  return 0;
+}
+
+// issue a block request whose response is discarded
+bool
+requestBgBlock(Data *const data, int64_t const blocknum)
+{
+  BgBlockFetch *const bg = new BgBlockFetch(blocknum);
+  TSCont const contp     = TSContCreate(bg_block_fetch_handler, TSMutexCreate());
+  TSContDataSet(contp, bg);
+
+  // the continuation mutex is not ours until the events start coming in
+  TSMutexLock(TSContMutexGet(contp));
+  bool const stat =
+    writeBlockRequest(bg->m_stream, contp, data->m_req_hdrmgr, data->m_client_ip, data->m_config->m_blockbytes, blocknum);
+  TSMutexUnlock(TSContMutexGet(contp));
+
+  if (!stat) {
+    delete bg;
+    TSContDestroy(contp);
+  }
+
+  return stat;
+}
+
+} // namespace
+
+void
+prefetch_blocks(Data *const data)
+{
+  int const count = data->m_config->m_prefetchcount;
+  if (count <= 0 || data->m_blocknum < 0 || data->m_bail) {
+    return;
+  }
+
+  int64_t const blockbytes = data->m_config->m_blockbytes;
+
+  // the fill takes all the remaining blocks of the range at once
+  if (data->m_config->m_prefetchfill) {
+    if (data->m_blockprefetched < 0 && 0 < data->m_req_range.m_end) {
+      int64_t const endblock = (data->m_req_range.m_end - 1) / blockbytes + 1;
+      if (data->m_blocknum + 1 < endblock) {
+        startBgFill(data, data->m_blocknum + 1, endblock);
+      }
+      data->m_blockprefetched = endblock - 1;
+    }
+    return;
+  }
+
+  int64_t const lastblock = data->m_blocknum + count;
+
+  for (int64_t blocknum = std::max(data->m_blocknum, data->m_blockprefetched) + 1; blocknum <= lastblock; ++blocknum) {
+    if (!data->m_req_range.blockIsInside(blockbytes, blocknum) || !requestBgBlock(data, blocknum)) {
+      break;
+    }
+    data->m_blockprefetched = blocknum;
+  }
+}
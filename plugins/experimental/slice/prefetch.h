@@ -0,0 +1,30 @@
+/** @file
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ */
+
+#pragma once
+
+#include "Data.h"
+
+/** Background fetches of the blocks ahead of the one being sent to
+ * the client. The responses are only drained, the point is to have
+ * cache_range_requests fill the cache for those blocks while the
+ * current one is still being transferred.
+ */
+
+// schedule background fetches of the next blocks, per --prefetch-count and --prefetch-fill
+void prefetch_blocks(Data *const data);
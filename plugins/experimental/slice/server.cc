@@ -19,6 +19,7 @@
 #include "server.h"
 
 #include "ContentRange.h"
+#include "prefetch.h"
 #include "response.h"
 #include "transfer.h"
 
@@ -370,6 +371,9 @@ handle_server_resp(TSCont contp, TSEvent event, Data *const data)
       if (!data->m_server_first_header_parsed) {
         headerStat                         = handleFirstServerHeader(data, contp);
         data->m_server_first_header_parsed = true;
+        if (headerStat) {
+          prefetch_blocks(data);
+        }
       } else {
         headerStat = handleNextServerHeader(data, contp);
       }
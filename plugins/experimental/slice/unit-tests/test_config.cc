@@ -32,6 +32,17 @@ TEST_CASE("config default", "[AWS][slice][utility]")
   Config const config;
   int64_t const defval = Config::blockbytesdefault;
   CHECK(defval == config.m_blockbytes);
+  CHECK(0 == config.m_prefetchcount);
+  CHECK(!config.m_prefetchfill);
+}
+
+TEST_CASE("config prefetch parsing", "[AWS][slice][utility]")
+{
+  Config config;
+  char const *const argv[] = {"--prefetch-count=3", "--prefetch-fill"};
+  CHECK(config.fromArgs(2, argv));
+  CHECK(3 == config.m_prefetchcount);
+  CHECK(config.m_prefetchfill);
 }
 
 TEST_CASE("config bytesfrom valid parsing", "[AWS][slice][utility]")
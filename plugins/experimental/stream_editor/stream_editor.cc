@@ -583,6 +583,18 @@ typedef struct contdata_t {
   }
 } contdata_t;
 
+/* Pass through unedited bytes.  While they are still in the input block
+ * (nothing buffered in contbuf) the block is referenced rather than copied.
+ */
+static size_t
+pass_through(contdata_t *contdata, TSIOBufferReader reader, const char *buf, size_t offset, size_t len)
+{
+  if (reader != nullptr) {
+    return TSIOBufferCopy(contdata->out_buf, reader, len, offset);
+  }
+  return TSIOBufferWrite(contdata->out_buf, buf + offset, len);
+}
+
 static int64_t
 process_block(contdata_t *contdata, TSIOBufferReader reader)
 {
@@ -592,6 +604,7 @@ process_block(contdata_t *contdata, TSIOBufferReader reader)
   size_t keep;
   const char *buf;
   TSIOBufferBlock block;
+  TSIOBufferReader direct = nullptr; /* the reader of buf, if buf is the input block */
 
   if (reader == nullptr) { // We're just flushing anything we have buffered
     keep   = 0;
@@ -605,6 +618,7 @@ process_block(contdata_t *contdata, TSIOBufferReader reader)
     if (contdata->contbuf.empty()) {
       /* Use the data as-is */
       buflen = nbytes;
+      direct = reader;
     } else {
       contdata->contbuf.append(buf, nbytes);
       buf    = contdata->contbuf.c_str();
@@ -630,9 +644,7 @@ process_block(contdata_t *contdata, TSIOBufferReader reader)
     start = p->start - bytes_read;
 
     while (start > 0) {
-      // FIXME: would this be quicker if we managed a TSIOBuffer
-      //        so we could use TSIOBufferCopy ?
-      n = TSIOBufferWrite(contdata->out_buf, buf + bytes_read, start);
+      n = pass_through(contdata, direct, buf, bytes_read, start);
       assert(n > 0); // FIXME - handle error
       bytes_read += n;
       contdata->bytes_out += n;
@@ -653,13 +665,13 @@ process_block(contdata_t *contdata, TSIOBufferReader reader)
 
   /* data after the last edit */
   if (bytes_read < buflen - keep) {
-    n = TSIOBufferWrite(contdata->out_buf, buf + bytes_read, buflen - bytes_read - keep);
+    n = pass_through(contdata, direct, buf, bytes_read, buflen - bytes_read - keep);
     contdata->bytes_in += n;
     contdata->bytes_out += n;
     bytes_read += n;
   }
   /* reset buf to what we've not processed */
-  contdata->contbuf = buf + bytes_read;
+  contdata->contbuf = std::string(buf + bytes_read, buflen - bytes_read);
 
   return nbytes;
 }
@@ -20,6 +20,7 @@
 #include "config.h"
 #include "timing.h"
 #include "jwt.h"
+#include "verify_cache.h"
 
 #include <cjose/cjose.h>
 #include <jansson.h>
@@ -32,6 +33,7 @@
 
 #define AUTH_DENY 0
 #define AUTH_ALLOW 1
+#define VERIFY_CACHE_DEFAULT_SIZE 1024
 struct auth_directive {
   char auth;
   char *container;
@@ -45,6 +47,7 @@ struct config {
   struct auth_directive *auth_directives;
   char *id;
   bool strip_token;
+  struct verify_cache *verify_cache;
 };
 
 cjose_jwk_t **
@@ -92,6 +95,12 @@ config_strip_token(struct config *cfg)
   return cfg->strip_token;
 }
 
+struct verify_cache *
+config_verify_cache(struct config *cfg)
+{
+  return cfg->verify_cache;
+}
+
 struct config *
 config_new(size_t n)
 {
@@ -119,7 +128,8 @@ config_new(size_t n)
   cfg->auth_directives = NULL;
   cfg->id              = NULL;
 
-  cfg->strip_token = false;
+  cfg->strip_token  = false;
+  cfg->verify_cache = NULL;
 
   PluginDebug("New config object created at %p", cfg);
   return cfg;
@@ -146,6 +156,8 @@ config_delete(struct config *cfg)
     free(cfg->id);
   }
 
+  verify_cache_delete(cfg->verify_cache);
+
   for (char **name = cfg->issuer_names; *name; ++name) {
     free(*name);
   }
@@ -204,6 +216,7 @@ read_config(const char *path)
     PluginError("Unable to allocate config.");
     goto issuer_fail;
   }
+  json_int_t verify_cache_size = VERIFY_CACHE_DEFAULT_SIZE;
 
   cjose_jwk_t ***jwkis = cfg->jwkis;
   char **issuer        = cfg->issuer_names;
@@ -296,6 +309,16 @@ read_config(const char *path)
       cfg->strip_token = json_boolean_value(strip_json);
     }
 
+    json_t *verify_cache_json = json_object_get(jwks, "verify_cache_size");
+    if (verify_cache_json) {
+      if (!json_is_integer(verify_cache_json) || json_integer_value(verify_cache_json) < 0) {
+        PluginError("verify_cache_size for issuer %s must be a non-negative integer", *issuer);
+        *jwkis = NULL;
+        goto cfg_fail;
+      }
+      verify_cache_size = json_integer_value(verify_cache_json);
+    }
+
     size_t jwks_ct     = json_array_size(key_ary);
     cjose_jwk_t **jwks = (*jwkis++ = malloc((jwks_ct + 1) * sizeof *jwks));
     PluginDebug("Created table with size %d", cfg->issuers->size);
@@ -340,6 +363,8 @@ read_config(const char *path)
     PluginError("Cannot load remap without signing key.");
     goto cfg_fail;
   }
+  /* A new cache per config, so the tokens verified with keys since removed are forgotten on reload. */
+  cfg->verify_cache = verify_cache_new(verify_cache_size);
   json_decref(issuer_json);
   PluginDebug("Loaded config file successfully.");
   return cfg;
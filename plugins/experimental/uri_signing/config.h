@@ -35,3 +35,4 @@ struct _cjose_jwk_int *find_key_by_kid(struct config *cfg, const char *issuer, c
 bool uri_matches_auth_directive(struct config *cfg, const char *uri, size_t uri_ct);
 const char *config_get_id(struct config *cfg);
 bool config_strip_token(struct config *cfg);
+struct verify_cache *config_verify_cache(struct config *cfg);
@@ -22,6 +22,7 @@
 #include "jwt.h"
 #include "cookie.h"
 #include "timing.h"
+#include "verify_cache.h"
 #include <cjose/cjose.h>
 #include <jansson.h>
 #include <string.h>
@@ -188,6 +189,18 @@ validate_jws(cjose_jws_t *jws, struct config *cfg, const char *uri, size_t uri_c
   }
   TimerDebug("initial validation of jwt");
 
+  /* The token is hashed whole, the signature alone would let a verified one vouch for another payload. */
+  const char *token                 = NULL;
+  struct verify_cache *verify_cache = config_verify_cache(cfg);
+  if (verify_cache && !cjose_jws_export(jws, &token, NULL)) {
+    token = NULL;
+  }
+  if (token && verify_cache_check(verify_cache, token, strlen(token), now())) {
+    PluginDebug("Signature of %16p was verified before", jws);
+    TimerDebug("finding the verified jwt in the cache");
+    goto verified;
+  }
+
   cjose_header_t *hdr = cjose_jws_get_protected(jws);
   TimerDebug("getting header of jws");
   if (!hdr) {
@@ -227,7 +240,11 @@ validate_jws(cjose_jws_t *jws, struct config *cfg, const char *uri, size_t uri_c
       goto jwt_fail;
     }
   }
+  if (token) {
+    verify_cache_add(verify_cache, token, strlen(token), jwt->exp);
+  }
 
+verified:
   if (!jwt_check_aud(jwt->aud, config_get_id(cfg))) {
     PluginDebug("Valid key for %16p that does not match aud.", jws);
     goto jwt_fail;
@@ -22,6 +22,7 @@
 
 #define CATCH_CONFIG_MAIN
 #include "catch.hpp"
+#include <cmath>
 
 extern "C" {
 #include <jansson.h>
@@ -31,6 +32,7 @@ extern "C" {
 #include "../parse.h"
 #include "../match.h"
 #include "../config.h"
+#include "../verify_cache.h"
 }
 
 bool
@@ -661,3 +663,51 @@ TEST_CASE("8", "[TestsWithConfig]")
   config_delete(cfg);
   fprintf(stderr, "\n");
 }
+
+TEST_CASE("9", "[VerifyCache]")
+{
+  INFO("TEST 9, Cache of Verified Tokens");
+
+  SECTION("Verified tokens are found until they expire")
+  {
+    struct verify_cache *cache = verify_cache_new(16);
+    const char *token          = "header.payload.signature";
+    REQUIRE(!verify_cache_check(cache, token, strlen(token), 100.0));
+    verify_cache_add(cache, token, strlen(token), 200.0);
+    REQUIRE(verify_cache_check(cache, token, strlen(token), 100.0));
+    REQUIRE(!verify_cache_check(cache, "header.other.signature", strlen(token), 100.0));
+    REQUIRE(!verify_cache_check(cache, token, strlen(token), 300.0));
+    REQUIRE(!verify_cache_check(cache, token, strlen(token), 100.0));
+    verify_cache_delete(cache);
+  }
+
+  SECTION("Tokens without an expiry stay verified")
+  {
+    struct verify_cache *cache = verify_cache_new(16);
+    const char *token          = "header.payload.signature";
+    verify_cache_add(cache, token, strlen(token), NAN);
+    REQUIRE(verify_cache_check(cache, token, strlen(token), 1.0e12));
+    verify_cache_delete(cache);
+  }
+
+  SECTION("A disabled cache finds nothing")
+  {
+    struct verify_cache *cache = verify_cache_new(0);
+    REQUIRE(cache == NULL);
+    verify_cache_add(cache, "token", 5, 200.0);
+    REQUIRE(!verify_cache_check(cache, "token", 5, 100.0));
+  }
+
+  SECTION("Validation with a cached signature")
+  {
+    struct config *cfg = read_config("experimental/uri_signing/unit_tests/testConfig.config");
+    const char *url    = "http://www.foobar.com/"
+                      "URISigningPackage=eyJLZXlJREtleSI6IjUiLCJhbGciOiJIUzI1NiJ9."
+                      "eyJjZG5pZXRzIjozMCwiY2RuaXN0dCI6MSwiaXNzIjoiTWFzdGVyIElzc3VlciIsImF1ZCI6InRlc3RlciIsImNkbml1YyI6"
+                      "InJlZ2V4Omh0dHA6Ly93d3cuZm9vYmFyLmNvbS8qIn0.InBxVm6OOAglNqc-U5wAZaRQVebJ9PK7Y9i7VFHWYHU";
+    REQUIRE(jws_validation_helper(url, "URISigningPackage", cfg));
+    REQUIRE(jws_validation_helper(url, "URISigningPackage", cfg));
+    config_delete(cfg);
+  }
+  fprintf(stderr, "\n");
+}
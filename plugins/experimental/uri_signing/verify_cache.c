@@ -0,0 +1,126 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "common.h"
+#include "verify_cache.h"
+
+#include <openssl/sha.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#define VERIFY_CACHE_LOCKS 64
+
+struct verify_entry {
+  unsigned char digest[SHA256_DIGEST_LENGTH];
+  double exp;
+  bool used;
+};
+
+struct verify_cache {
+  size_t mask;
+  struct verify_entry *entries;
+  pthread_mutex_t locks[VERIFY_CACHE_LOCKS];
+};
+
+struct verify_cache *
+verify_cache_new(size_t size)
+{
+  if (!size) {
+    return NULL;
+  }
+
+  size_t n = 1;
+  while (n < size) {
+    n <<= 1;
+  }
+
+  struct verify_cache *cache = malloc(sizeof *cache);
+  cache->mask                = n - 1;
+  cache->entries             = calloc(n, sizeof *cache->entries);
+  for (int i = 0; i < VERIFY_CACHE_LOCKS; ++i) {
+    pthread_mutex_init(&cache->locks[i], NULL);
+  }
+  PluginDebug("Created verification cache of %zu tokens", n);
+  return cache;
+}
+
+void
+verify_cache_delete(struct verify_cache *cache)
+{
+  if (!cache) {
+    return;
+  }
+  for (int i = 0; i < VERIFY_CACHE_LOCKS; ++i) {
+    pthread_mutex_destroy(&cache->locks[i]);
+  }
+  free(cache->entries);
+  free(cache);
+}
+
+static size_t
+verify_cache_slot(struct verify_cache *cache, const char *token, size_t token_ct, unsigned char *digest)
+{
+  SHA256((const unsigned char *)token, token_ct, digest);
+  uint64_t h;
+  memcpy(&h, digest, sizeof h);
+  return h & cache->mask;
+}
+
+bool
+verify_cache_check(struct verify_cache *cache, const char *token, size_t token_ct, double now)
+{
+  if (!cache) {
+    return false;
+  }
+
+  unsigned char digest[SHA256_DIGEST_LENGTH];
+  size_t slot                = verify_cache_slot(cache, token, token_ct, digest);
+  struct verify_entry *entry = &cache->entries[slot];
+  pthread_mutex_t *lock      = &cache->locks[slot % VERIFY_CACHE_LOCKS];
+
+  pthread_mutex_lock(lock);
+  bool hit = entry->used && !memcmp(entry->digest, digest, sizeof digest);
+  if (hit && now > entry->exp) {
+    /* Expired, which the claims check catches on its own, but the slot can go. */
+    entry->used = false;
+    hit         = false;
+  }
+  pthread_mutex_unlock(lock);
+  return hit;
+}
+
+void
+verify_cache_add(struct verify_cache *cache, const char *token, size_t token_ct, double exp)
+{
+  if (!cache) {
+    return;
+  }
+
+  unsigned char digest[SHA256_DIGEST_LENGTH];
+  size_t slot                = verify_cache_slot(cache, token, token_ct, digest);
+  struct verify_entry *entry = &cache->entries[slot];
+  pthread_mutex_t *lock      = &cache->locks[slot % VERIFY_CACHE_LOCKS];
+
+  pthread_mutex_lock(lock);
+  memcpy(entry->digest, digest, sizeof digest);
+  entry->exp  = exp;
+  entry->used = true;
+  pthread_mutex_unlock(lock);
+}
@@ -0,0 +1,37 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/*
+ * A bounded cache of the tokens whose signature was verified, so that the crypto runs once per token rather than once per
+ * request. The tokens are keyed by their SHA-256, a token that collides with another in the table replaces it.
+ */
+struct verify_cache;
+
+struct verify_cache *verify_cache_new(size_t size);
+void verify_cache_delete(struct verify_cache *cache);
+
+/* Whether the signature of the token was verified and the token does not expire before now. */
+bool verify_cache_check(struct verify_cache *cache, const char *token, size_t token_ct, double now);
+
+/* Remember the verified token until it expires at exp, which is NaN for a token that does not expire. */
+void verify_cache_add(struct verify_cache *cache, const char *token, size_t token_ct, double exp);
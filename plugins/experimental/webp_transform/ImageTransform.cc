@@ -16,9 +16,10 @@
   limitations under the License.
  */
 
-#include <sstream>
-#include <iostream>
+#include <cstring>
+#include <string>
 #include <string_view>
+#include "tscpp/api/Continuation.h"
 #include "tscpp/api/PluginInit.h"
 #include "tscpp/api/GlobalPlugin.h"
 #include "tscpp/api/TransformationPlugin.h"
@@ -35,12 +36,73 @@ using namespace atscppapi;
 namespace
 {
 GlobalPlugin *plugin;
+
+// The responses that can be converted are cached as a variant of the Accept of the request.
+void
+addVaryAccept(Headers &headers)
+{
+  string vary = headers.values("Vary");
+  if (vary.empty()) {
+    headers["Vary"] = "Accept";
+  } else if (strcasestr(vary.c_str(), "accept") == nullptr) {
+    headers["Vary"] = vary + ", Accept";
+  }
 }
+} // namespace
+
+class ImageTransform;
+
+// Hands the converted image to the transformation, on a net thread under the mutex of the transaction.
+class ImageOutput : public atscppapi::Continuation
+{
+public:
+  ImageOutput(ImageTransform *transform, TSMutex mutex) : Continuation(mutex), transform_(transform) {}
+
+  ImageTransform *transform_; // nullptr once the transaction is gone
+  string data_;
+
+private:
+  int _run(TSEvent event, void *edata) override;
+};
+
+// Converts the image on a task thread, so that the net threads are not held by ImageMagick.
+class ImageConversion : public atscppapi::Continuation
+{
+public:
+  ImageConversion(string &&input, ImageOutput *output) : Continuation(nullptr), input_(std::move(input)), output_(output) {}
+
+private:
+  int
+  _run(TSEvent, void *) override
+  {
+    try {
+      Blob input_blob(input_.data(), input_.length());
+      Image image;
+      image.read(input_blob);
+
+      Blob output_blob;
+      image.magick("WEBP");
+      image.write(&output_blob);
+      output_->data_.assign(reinterpret_cast<const char *>(output_blob.data()), output_blob.length());
+    } catch (const Magick::Exception &e) {
+      TSError("[%s] unable to convert the image to webp: %s", TAG, e.what());
+      output_->data_ = std::move(input_);
+    }
+    output_->schedule(0, TS_THREAD_POOL_NET);
+    delete this;
+    return 0;
+  }
+
+  string input_;
+  ImageOutput *output_;
+};
 
 class ImageTransform : public TransformationPlugin
 {
 public:
-  ImageTransform(Transaction &transaction) : TransformationPlugin(transaction, TransformationPlugin::RESPONSE_TRANSFORMATION)
+  ImageTransform(Transaction &transaction)
+    : TransformationPlugin(transaction, TransformationPlugin::RESPONSE_TRANSFORMATION),
+      _mutex(TSContMutexGet(reinterpret_cast<TSCont>(transaction.getAtsHandle())))
   {
     TransformationPlugin::registerHook(HOOK_READ_RESPONSE_HEADERS);
   }
@@ -49,7 +111,6 @@ public:
   handleReadResponseHeaders(Transaction &transaction) override
   {
     transaction.getServerResponse().getHeaders()["Content-Type"] = "image/webp";
-    transaction.getServerResponse().getHeaders()["Vary"]         = "Content-Type"; // to have a separate cache entry.
 
     TS_DEBUG(TAG, "url %s", transaction.getServerRequest().getUrl().getUrlString().c_str());
     transaction.resume();
@@ -58,31 +119,47 @@ public:
   void
   consume(std::string_view data) override
   {
-    _img.write(data.data(), data.length());
+    _img.append(data.data(), data.length());
   }
 
   void
   handleInputComplete() override
   {
-    string input_data = _img.str();
-    Blob input_blob(input_data.data(), input_data.length());
-    Image image;
-    image.read(input_blob);
-
-    Blob output_blob;
-    image.magick("WEBP");
-    image.write(&output_blob);
-    produce(std::string_view(reinterpret_cast<const char *>(output_blob.data()), output_blob.length()));
+    _output = new ImageOutput(this, _mutex);
+    (new ImageConversion(std::move(_img), _output))->schedule(0, TS_THREAD_POOL_TASK);
+  }
 
+  void
+  outputComplete(std::string_view data)
+  {
+    _output = nullptr;
+    produce(data);
     setOutputComplete();
   }
 
-  ~ImageTransform() override {}
+  ~ImageTransform() override
+  {
+    if (_output != nullptr) {
+      _output->transform_ = nullptr;
+    }
+  }
 
 private:
-  std::stringstream _img;
+  TSMutex _mutex;
+  string _img;
+  ImageOutput *_output = nullptr;
 };
 
+int
+ImageOutput::_run(TSEvent, void *)
+{
+  if (transform_ != nullptr) {
+    transform_->outputComplete(data_);
+  }
+  delete this;
+  return 0;
+}
+
 class GlobalHookPlugin : public GlobalPlugin
 {
 public:
@@ -90,13 +167,18 @@ public:
   void
   handleReadResponseHeaders(Transaction &transaction) override
   {
-    string ctype      = transaction.getServerResponse().getHeaders().values("Content-Type");
-    string user_agent = transaction.getServerRequest().getHeaders().values("User-Agent");
-    string accept     = transaction.getServerRequest().getHeaders().values("Accept");
+    Headers &headers = transaction.getServerResponse().getHeaders();
+    string ctype     = headers.values("Content-Type");
+    string accept    = transaction.getServerRequest().getHeaders().values("Accept");
 
-    bool webp_supported = accept.find("image/webp") != string::npos || user_agent.find("Chrome") != string::npos;
+    bool webp_supported = accept.find("image/webp") != string::npos;
     bool image_format   = ctype.find("jpeg") != string::npos || ctype.find("png") != string::npos;
 
+    // Both the original and the converted images vary on Accept, or the first one cached would be served to all.
+    if (image_format) {
+      addVaryAccept(headers);
+    }
+
     if (webp_supported && image_format) {
       TS_DEBUG(TAG, "Content type is either jpeg or png. Converting to webp");
       transaction.addPlugin(new ImageTransform(transaction));
@@ -41,6 +41,12 @@ enum CondModifiers {
   COND_CHAIN  = 32 // Not implemented
 };
 
+// Relative costs of evaluating conditions, see Condition::cost()
+static constexpr int COND_COST_CHEAP  = 1; // Plain values of the transaction
+static constexpr int COND_COST_STRING = 2; // Values built out of headers or addresses
+static constexpr int COND_COST_LOOKUP = 4; // External lookups, such as the geo databases
+static constexpr int COND_COST_REGEX  = 4; // Added for a regular expression match
+
 ///////////////////////////////////////////////////////////////////////////////
 // Base class for all Conditions (this is also the interface)
 //
@@ -59,15 +65,20 @@ public:
   Condition(const Condition &) = delete;
   void operator=(const Condition &) = delete;
 
-  // Inline this, it's critical for speed (and only used twice)
+  // Evaluate only this condition, with its NOT modifier.
   bool
-  do_eval(const Resources &res)
+  eval_one(const Resources &res)
   {
     bool rt = eval(res);
 
-    if (_mods & COND_NOT) {
-      rt = !rt;
-    }
+    return (_mods & COND_NOT) ? !rt : rt;
+  }
+
+  // Inline this, it's critical for speed (and only used twice)
+  bool
+  do_eval(const Resources &res)
+  {
+    bool rt = eval_one(res);
 
     if (_next) {
       if (_mods & COND_OR) {
@@ -93,6 +104,26 @@ public:
     return _mods & COND_LAST;
   }
 
+  CondModifiers
+  mods() const
+  {
+    return _mods;
+  }
+
+  Condition *
+  next() const
+  {
+    return static_cast<Condition *>(_next);
+  }
+
+  // How expensive the condition is to evaluate, the conditions of a rule that are all ANDed
+  // together are evaluated cheapest first.
+  virtual int
+  cost() const
+  {
+    return COND_COST_CHEAP + (_cond_op == MATCH_REGULAR_EXPRESSION ? COND_COST_REGEX : 0);
+  }
+
   // Setters
   virtual void
   set_qualifier(const std::string &q)
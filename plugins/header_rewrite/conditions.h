@@ -162,6 +162,12 @@ public:
   void initialize(Parser &p) override;
   void append_value(std::string &s, const Resources &res) override;
 
+  int
+  cost() const override
+  {
+    return Condition::cost() + COND_COST_LOOKUP;
+  }
+
 protected:
   bool eval(const Resources &res) override;
 
@@ -185,6 +191,12 @@ public:
   void initialize(Parser &p) override;
   void append_value(std::string &s, const Resources &res) override;
 
+  int
+  cost() const override
+  {
+    return Condition::cost() + COND_COST_STRING;
+  }
+
 protected:
   bool eval(const Resources &res) override;
 
@@ -259,6 +271,12 @@ public:
   void initialize(Parser &p) override;
   void append_value(std::string &s, const Resources &res) override;
 
+  int
+  cost() const override
+  {
+    return Condition::cost() + COND_COST_STRING;
+  }
+
 protected:
   bool eval(const Resources &res) override;
 
@@ -284,6 +302,12 @@ public:
   void set_qualifier(const std::string &q) override;
   void append_value(std::string &s, const Resources &res) override;
 
+  int
+  cost() const override
+  {
+    return Condition::cost() + COND_COST_STRING;
+  }
+
 protected:
   bool eval(const Resources &res) override;
 
@@ -360,6 +384,12 @@ public:
   void set_qualifier(const std::string &q) override;
   void append_value(std::string &s, const Resources &res) override;
 
+  int
+  cost() const override
+  {
+    return Condition::cost() + COND_COST_STRING;
+  }
+
 protected:
   bool eval(const Resources &res) override;
 
@@ -437,6 +467,12 @@ public:
     _int_type = flag;
   }
 
+  int
+  cost() const override
+  {
+    return Condition::cost() + COND_COST_LOOKUP;
+  }
+
 protected:
   bool eval(const Resources &res) override;
 
@@ -488,6 +524,12 @@ public:
   void set_qualifier(const std::string &q) override;
   void append_value(std::string &s, const Resources &res) override;
 
+  int
+  cost() const override
+  {
+    return Condition::cost() + COND_COST_STRING;
+  }
+
 protected:
   bool eval(const Resources &res) override;
 
@@ -518,6 +560,12 @@ public:
 
   static constexpr const char *TAG = "INBOUND";
 
+  int
+  cost() const override
+  {
+    return Condition::cost() + COND_COST_STRING;
+  }
+
 protected:
   bool eval(const Resources &res) override;
 
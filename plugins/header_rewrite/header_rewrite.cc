@@ -123,6 +123,7 @@ RulesConfig::add_rule(RuleSet *rule)
 {
   if (rule && rule->has_operator()) {
     TSDebug(PLUGIN_NAME_DBG, "   Adding rule to hook=%s", TSHttpHookNameLookup(rule->get_hook()));
+    rule->compile();
     if (nullptr == _rules[rule->get_hook()]) {
       _rules[rule->get_hook()] = rule;
     } else {
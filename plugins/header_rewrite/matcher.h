@@ -189,7 +189,7 @@ private:
     int ovector[OVECCOUNT];
 
     TSDebug(PLUGIN_NAME, "Test regular expression %s : %s", _data.c_str(), t.c_str());
-    if (helper.regexMatch(t.c_str(), t.length(), ovector) > 0) {
+    if (helper.regexMatch(t.c_str(), t.length(), ovector)) {
       TSDebug(PLUGIN_NAME, "Successfully found regular expression match");
       return true;
     }
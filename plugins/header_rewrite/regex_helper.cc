@@ -20,35 +20,14 @@
 bool
 regexHelper::setRegexMatch(const std::string &s)
 {
-  const char *errorComp  = nullptr;
-  const char *errorStudy = nullptr;
-  int erroffset;
-
   regexString = s;
-  regex       = pcre_compile(regexString.c_str(), 0, &errorComp, &erroffset, nullptr);
+  regex       = Regex::intern(regexString);
 
-  if (regex == nullptr) {
-    return false;
-  }
-  regexExtra = pcre_study(regex, 0, &errorStudy);
-  if ((regexExtra == nullptr) && (errorStudy != nullptr)) {
-    return false;
-  }
-  if (pcre_fullinfo(regex, regexExtra, PCRE_INFO_CAPTURECOUNT, &regexCcount) != 0) {
-    return false;
-  }
-  return true;
+  return regex != nullptr;
 }
 
-int
+bool
 regexHelper::regexMatch(const char *str, int len, int ovector[]) const
 {
-  return pcre_exec(regex,      // the compiled pattern
-                   regexExtra, // Extra data from study (maybe)
-                   str,        // the subject std::string
-                   len,        // the length of the subject
-                   0,          // start at offset 0 in the subject
-                   0,          // default options
-                   ovector,    // output vector for substring information
-                   OVECCOUNT); // number of elements in the output vector
-};
+  return regex->exec(std::string_view(str, len), ovector, OVECCOUNT);
+}
@@ -18,32 +18,22 @@
 #pragma once
 
 #include "tscore/ink_defs.h"
+#include "tscore/Regex.h"
 
-#ifdef HAVE_PCRE_PCRE_H
-#include <pcre/pcre.h>
-#else
-#include <pcre.h>
-#endif
-
+#include <memory>
 #include <string>
 
 const int OVECCOUNT = 30; // We support $1 - $9 only, and this needs to be 3x that
 
+// The compiled regular expressions are shared by all of the rules, and remap
+// instances, with the same pattern.
 class regexHelper
 {
 public:
-  ~regexHelper()
-  {
-    pcre_free(regex);
-    pcre_free(regexExtra);
-  }
-
   bool setRegexMatch(const std::string &s);
-  int regexMatch(const char *, int, int ovector[]) const;
+  bool regexMatch(const char *, int, int ovector[]) const;
 
 private:
   std::string regexString;
-  pcre *regex            = nullptr;
-  pcre_extra *regexExtra = nullptr;
-  int regexCcount        = 0;
+  std::shared_ptr<Regex> regex;
 };
@@ -19,6 +19,7 @@
 // ruleset.cc: implementation of the ruleset class
 //
 //
+#include <algorithm>
 #include <string>
 
 #include "ruleset.h"
@@ -102,6 +103,22 @@ RuleSet::add_operator(Parser &p, const char *filename, int lineno)
   return false;
 }
 
+// Flatten the condition list of a complete rule for eval(). The conditions have no side effects,
+// so when they are all ANDed together they can be evaluated in any order, the cheaper ones first.
+void
+RuleSet::compile()
+{
+  _program.clear();
+  for (Condition *c = _cond; c; c = c->next()) {
+    _program.push_back(c);
+  }
+
+  if (std::none_of(_program.begin(), _program.end(), [](const Condition *c) { return c->mods() & COND_OR; })) {
+    std::stable_sort(_program.begin(), _program.end(),
+                     [](const Condition *lhs, const Condition *rhs) { return lhs->cost() < rhs->cost(); });
+  }
+}
+
 ResourceIDs
 RuleSet::get_all_resource_ids() const
 {
@@ -22,6 +22,7 @@
 #pragma once
 
 #include <string>
+#include <vector>
 
 #include "matcher.h"
 #include "factory.h"
@@ -53,6 +54,7 @@ public:
   void append(RuleSet *rule);
   bool add_condition(Parser &p, const char *filename, int lineno);
   bool add_operator(Parser &p, const char *filename, int lineno);
+  void compile();
   ResourceIDs get_all_resource_ids() const;
 
   bool
@@ -85,14 +87,24 @@ public:
     return _ids;
   }
 
+  // Walk the compiled conditions, an OR condition is ORed with everything after it, and the other
+  // conditions ANDed, which is how Condition::do_eval() evaluates the condition list.
   bool
   eval(const Resources &res) const
   {
-    if (nullptr == _cond) {
-      return true;
-    } else {
-      return _cond->do_eval(res);
+    for (Condition *c : _program) {
+      bool rt = c->eval_one(res);
+
+      if (c->mods() & COND_OR) {
+        if (rt) {
+          return true;
+        }
+      } else if (!rt) {
+        return false;
+      }
     }
+
+    return _program.empty() || !(_program.back()->mods() & COND_OR);
   }
 
   bool
@@ -113,6 +125,7 @@ public:
 private:
   Condition *_cond   = nullptr;                        // First pre-condition (linked list)
   Operator *_oper    = nullptr;                        // First operator (linked list)
+  std::vector<Condition *> _program;                   // The conditions, in evaluation order (compile())
   TSHttpHookID _hook = TS_HTTP_READ_RESPONSE_HDR_HOOK; // Which hook is this rule for
 
   // State values (updated when conds / operators are added)
@@ -25,12 +25,61 @@
 
 #define TS_LUA_MAX_STATE_COUNT 256
 
-static uint64_t ts_lua_http_next_id   = 0;
+#define TS_LUA_STAT_THREADS "plugin.lua.threads"
+#define TS_LUA_STAT_MEMORY "plugin.lua.memory_kb"
+
 static uint64_t ts_lua_g_http_next_id = 0;
 
 static ts_lua_main_ctx *ts_lua_main_ctx_array;
 static ts_lua_main_ctx *ts_lua_g_main_ctx_array;
 
+// Each thread sticks to the same lua vm, so that the vm's lock is only contended when there are
+// more threads than states, or when a script continues on another thread.
+static int ts_lua_next_thread_index     = 0;
+static __thread int ts_lua_thread_index = -1;
+static int ts_lua_threads_stat_id       = -1;
+static int ts_lua_memory_stat_id        = -1;
+
+static void
+ts_lua_init_stats()
+{
+  if (ts_lua_threads_stat_id == -1 && TSStatFindName(TS_LUA_STAT_THREADS, &ts_lua_threads_stat_id) == TS_ERROR) {
+    ts_lua_threads_stat_id = TSStatCreate(TS_LUA_STAT_THREADS, TS_RECORDDATATYPE_INT, TS_STAT_NON_PERSISTENT, TS_STAT_SYNC_SUM);
+  }
+  if (ts_lua_memory_stat_id == -1 && TSStatFindName(TS_LUA_STAT_MEMORY, &ts_lua_memory_stat_id) == TS_ERROR) {
+    ts_lua_memory_stat_id = TSStatCreate(TS_LUA_STAT_MEMORY, TS_RECORDDATATYPE_INT, TS_STAT_NON_PERSISTENT, TS_STAT_SYNC_SUM);
+  }
+}
+
+static ts_lua_main_ctx *
+ts_lua_thread_main_ctx(ts_lua_main_ctx *arr, int states)
+{
+  if (ts_lua_thread_index < 0) {
+    ts_lua_thread_index = __sync_fetch_and_add(&ts_lua_next_thread_index, 1);
+    TSStatIntIncrement(ts_lua_threads_stat_id, 1);
+  }
+
+  return &arr[ts_lua_thread_index % states];
+}
+
+// Called with the vm locked once a hook is done with it: take a step of the incremental
+// collector now, rather than in the middle of the next script to run, and track the memory.
+static void
+ts_lua_main_ctx_gc_step(ts_lua_main_ctx *main_ctx)
+{
+  int kb;
+
+  lua_gc(main_ctx->lua, LUA_GCSTEP, 0);
+
+  kb = lua_gc(main_ctx->lua, LUA_GCCOUNT, 0);
+  if (kb > main_ctx->mem_kb) {
+    TSStatIntIncrement(ts_lua_memory_stat_id, kb - main_ctx->mem_kb);
+  } else if (kb < main_ctx->mem_kb) {
+    TSStatIntDecrement(ts_lua_memory_stat_id, main_ctx->mem_kb - kb);
+  }
+  main_ctx->mem_kb = kb;
+}
+
 TSReturnCode
 TSRemapInit(TSRemapInterface *api_info, char *errbuf, int errbuf_size)
 {
@@ -46,6 +95,8 @@ TSRemapInit(TSRemapInterface *api_info, char *errbuf, int errbuf_size)
     return TS_SUCCESS;
   }
 
+  ts_lua_init_stats();
+
   ts_lua_main_ctx_array = TSmalloc(sizeof(ts_lua_main_ctx) * TS_LUA_MAX_STATE_COUNT);
   memset(ts_lua_main_ctx_array, 0, sizeof(ts_lua_main_ctx) * TS_LUA_MAX_STATE_COUNT);
 
@@ -190,7 +241,6 @@ static TSRemapStatus
 ts_lua_remap_plugin_init(void *ih, TSHttpTxn rh, TSRemapRequestInfo *rri)
 {
   int ret;
-  uint64_t req_id;
 
   TSCont contp;
   lua_State *L;
@@ -203,9 +253,8 @@ ts_lua_remap_plugin_init(void *ih, TSHttpTxn rh, TSRemapRequestInfo *rri)
 
   int remap     = (rri == NULL ? 0 : 1);
   instance_conf = (ts_lua_instance_conf *)ih;
-  req_id        = __sync_fetch_and_add(&ts_lua_http_next_id, 1);
 
-  main_ctx = &ts_lua_main_ctx_array[req_id % instance_conf->states];
+  main_ctx = ts_lua_thread_main_ctx(ts_lua_main_ctx_array, instance_conf->states);
 
   TSMutexLock(main_ctx->mutexp);
 
@@ -256,6 +305,7 @@ ts_lua_remap_plugin_init(void *ih, TSHttpTxn rh, TSRemapRequestInfo *rri)
     ts_lua_destroy_http_ctx(http_ctx);
   }
 
+  ts_lua_main_ctx_gc_step(main_ctx);
   TSMutexUnlock(main_ctx->mutexp);
 
   return ret;
@@ -307,7 +357,7 @@ globalHookHandler(TSCont contp, TSEvent event ATS_UNUSED, void *edata)
 
   req_id = __sync_fetch_and_add(&ts_lua_g_http_next_id, 1);
 
-  main_ctx = &ts_lua_g_main_ctx_array[req_id % conf->states];
+  main_ctx = ts_lua_thread_main_ctx(ts_lua_g_main_ctx_array, conf->states);
 
   TSDebug(TS_LUA_DEBUG_TAG, "[%s] req_id: %" PRId64, __FUNCTION__, req_id);
   TSMutexLock(main_ctx->mutexp);
@@ -431,6 +481,7 @@ globalHookHandler(TSCont contp, TSEvent event ATS_UNUSED, void *edata)
     ts_lua_destroy_http_ctx(http_ctx);
   }
 
+  ts_lua_main_ctx_gc_step(main_ctx);
   TSMutexUnlock(main_ctx->mutexp);
 
   if (ret) {
@@ -455,6 +506,8 @@ TSPluginInit(int argc, const char *argv[])
     TSError("[ts_lua] Plugin registration failed");
   }
 
+  ts_lua_init_stats();
+
   int ret                 = 0;
   ts_lua_g_main_ctx_array = TSmalloc(sizeof(ts_lua_main_ctx) * TS_LUA_MAX_STATE_COUNT);
   memset(ts_lua_g_main_ctx_array, 0, sizeof(ts_lua_main_ctx) * TS_LUA_MAX_STATE_COUNT);
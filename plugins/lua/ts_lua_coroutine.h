@@ -33,6 +33,7 @@ typedef struct {
   lua_State *lua; // basic lua vm, injected
   TSMutex mutexp; // mutex for lua vm
   int gref;       // reference for lua vm self, in reg table
+  int mem_kb;     // memory in use by the vm, as last reported to the memory stat
 } ts_lua_main_ctx;
 
 /* coroutine */
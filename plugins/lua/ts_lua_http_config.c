@@ -135,6 +135,9 @@ typedef enum {
   TS_LUA_CONFIG_SSL_CLIENT_SNI_POLICY                         = TS_CONFIG_SSL_CLIENT_SNI_POLICY,
   TS_LUA_CONFIG_SSL_CLIENT_PRIVATE_KEY_FILENAME               = TS_CONFIG_SSL_CLIENT_PRIVATE_KEY_FILENAME,
   TS_LUA_CONFIG_SSL_CLIENT_CA_CERT_FILENAME                   = TS_CONFIG_SSL_CLIENT_CA_CERT_FILENAME,
+  TS_LUA_CONFIG_NET_SOCK_CONGESTION_CONTROL_IN                = TS_CONFIG_NET_SOCK_CONGESTION_CONTROL_IN,
+  TS_LUA_CONFIG_NET_SOCK_PACING_RATE_IN                       = TS_CONFIG_NET_SOCK_PACING_RATE_IN,
+  TS_LUA_CONFIG_NET_SOCK_NOTSENT_LOWAT_IN                     = TS_CONFIG_NET_SOCK_NOTSENT_LOWAT_IN,
   TS_LUA_CONFIG_LAST_ENTRY                                    = TS_CONFIG_LAST_ENTRY,
 } TSLuaOverridableConfigKey;
 
@@ -260,6 +263,9 @@ ts_lua_var_item ts_lua_http_config_vars[] = {
   TS_LUA_MAKE_VAR_ITEM(TS_CONFIG_SSL_CLIENT_SNI_POLICY),
   TS_LUA_MAKE_VAR_ITEM(TS_CONFIG_SSL_CLIENT_PRIVATE_KEY_FILENAME),
   TS_LUA_MAKE_VAR_ITEM(TS_CONFIG_SSL_CLIENT_CA_CERT_FILENAME),
+  TS_LUA_MAKE_VAR_ITEM(TS_CONFIG_NET_SOCK_CONGESTION_CONTROL_IN),
+  TS_LUA_MAKE_VAR_ITEM(TS_CONFIG_NET_SOCK_PACING_RATE_IN),
+  TS_LUA_MAKE_VAR_ITEM(TS_CONFIG_NET_SOCK_NOTSENT_LOWAT_IN),
   TS_LUA_MAKE_VAR_ITEM(TS_LUA_CONFIG_HTTP_PER_SERVER_CONNECTION_MAX),
   TS_LUA_MAKE_VAR_ITEM(TS_LUA_CONFIG_HTTP_PER_SERVER_CONNECTION_MATCH),
   TS_LUA_MAKE_VAR_ITEM(TS_LUA_CONFIG_LAST_ENTRY),
@@ -38,6 +38,9 @@
 // 1s
 const size_t DEFAULT_TIMEOUT = 1000000000000;
 
+// 64MB
+const int64_t DEFAULT_MAX_PENDING = 64 * 1024 * 1024;
+
 Statistics statistics;
 
 TSReturnCode
@@ -55,6 +58,15 @@ TSRemapInit(TSRemapInterface *, char *, int)
     TSDebug(PLUGIN_TAG, "timeout is set to: %zu", timeout);
   }
 
+  {
+    maxPending                      = DEFAULT_MAX_PENDING;
+    const char *const maxPendingEnv = getenv(PLUGIN_TAG "__max_pending");
+    if (maxPendingEnv != nullptr && atoll(maxPendingEnv) >= 0) {
+      maxPending = atoll(maxPendingEnv);
+    }
+    TSDebug(PLUGIN_TAG, "max pending is set to: %" PRId64, maxPending);
+  }
+
   statistics.failures = TSStatCreate(PLUGIN_TAG ".failures", TS_RECORDDATATYPE_INT, TS_STAT_NON_PERSISTENT, TS_STAT_SYNC_COUNT);
 
   statistics.hits = TSStatCreate(PLUGIN_TAG ".hits", TS_RECORDDATATYPE_INT, TS_STAT_NON_PERSISTENT, TS_STAT_SYNC_COUNT);
@@ -67,6 +79,8 @@ TSRemapInit(TSRemapInterface *, char *, int)
 
   statistics.size = TSStatCreate(PLUGIN_TAG ".size", TS_RECORDDATATYPE_INT, TS_STAT_NON_PERSISTENT, TS_STAT_SYNC_AVG);
 
+  statistics.dropped = TSStatCreate(PLUGIN_TAG ".dropped", TS_RECORDDATATYPE_INT, TS_STAT_NON_PERSISTENT, TS_STAT_SYNC_COUNT);
+
   return TS_SUCCESS;
 }
 
@@ -76,8 +90,8 @@ TSRemapNewInstance(int argc, char **argv, void **i, char *, int)
   assert(i != nullptr);
   Instance *instance = new Instance;
 
-  if (argc > 2) {
-    std::copy(argv + 2, argv + argc, std::back_inserter(instance->origins));
+  for (int index = 2; index < argc; ++index) {
+    instance->origins.emplace_back(argv[index]);
   }
 
   *i = static_cast<void *>(instance);
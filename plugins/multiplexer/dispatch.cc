@@ -34,8 +34,10 @@
 extern Statistics statistics;
 
 size_t timeout;
+int64_t maxPending;
 
-Request::Request(const std::string &h, const TSMBuffer b, const TSMLoc l) : host(h), length(0), io(new ats::io::IO())
+Request::Request(const Origin &o, const TSMBuffer b, const TSMLoc l)
+  : host(o.host), length(0), io(new ats::io::IO()), pending(o.pending)
 {
   assert(!host.empty());
   assert(b != nullptr);
@@ -52,7 +54,8 @@ Request::Request(const std::string &h, const TSMBuffer b, const TSMLoc l) : host
   assert(TSHttpHdrLengthGet(b, l) >= length);
 }
 
-Request::Request(Request &&that) : host(std::move(that.host)), length(that.length), io(std::move(that.io))
+Request::Request(Request &&that)
+  : host(std::move(that.host)), length(that.length), io(std::move(that.io)), pending(std::move(that.pending))
 {
   assert(!host.empty());
   assert(length > 0);
@@ -65,6 +68,7 @@ Request::operator=(const Request &r)
   host   = r.host;
   length = r.length;
   io.reset(const_cast<Request &>(r).io.release());
+  pending = r.pending;
   assert(!host.empty());
   assert(length > 0);
   assert(io.get() != nullptr);
@@ -72,27 +76,16 @@ Request::operator=(const Request &r)
   return *this;
 }
 
+/*
+ * The blocks of the reader are appended to the buffer, so that all of the copies share the
+ * data of the body instead of each one holding a copy of it.
+ */
 uint64_t
 copy(const TSIOBufferReader &r, const TSIOBuffer b)
 {
   assert(r != nullptr);
   assert(b != nullptr);
-  TSIOBufferBlock block = TSIOBufferReaderStart(r);
-
-  uint64_t length = 0;
-
-  for (; block; block = TSIOBufferBlockNext(block)) {
-    int64_t size              = 0;
-    const void *const pointer = TSIOBufferBlockReadStart(block, r, &size);
-
-    if (pointer != nullptr && size > 0) {
-      const int64_t size2 = TSIOBufferWrite(b, pointer, size);
-      assert(size == size2);
-      length += size;
-    }
-  }
-
-  return length;
+  return TSIOBufferCopy(b, r, TSIOBufferReaderAvail(r), 0);
 }
 
 uint64_t
@@ -137,11 +130,20 @@ class Handler
   int64_t length;
   struct timeval start;
   std::string response;
+  Pending pending;
+  int64_t requestLength;
+
+  // The copy is not pending anymore once it is answered or it failed.
+  void
+  release()
+  {
+    *pending -= requestLength;
+  }
 
 public:
   const std::string url;
 
-  Handler(std::string u) : length(0)
+  Handler(std::string u, Pending p, int64_t l) : length(0), pending(std::move(p)), requestLength(l)
   {
     assert(!u.empty());
     const_cast<std::string &>(url).swap(u);
@@ -153,6 +155,7 @@ public:
   {
     TSError("[" PLUGIN_TAG "] error when communicating with \"%s\"\n", url.c_str());
     TSStatIntIncrement(statistics.failures, 1);
+    release();
   }
 
   void
@@ -160,6 +163,7 @@ public:
   {
     TSError("[" PLUGIN_TAG "] timeout when communicating with \"%s\"\n", url.c_str());
     TSStatIntIncrement(statistics.timeouts, 1);
+    release();
   }
 
   void
@@ -203,6 +207,7 @@ public:
     TSStatIntIncrement(statistics.hits, 1);
     TSStatIntIncrement(statistics.time, diff);
     TSStatIntIncrement(statistics.size, length);
+    release();
   }
 };
 
@@ -222,10 +227,9 @@ generateRequests(const Origins &o, const TSMBuffer buffer, const TSMLoc location
   request.xMultiplexerHeader("copy");
 
   for (; iterator != end; ++iterator) {
-    const std::string &host = *iterator;
-    assert(!host.empty());
-    request.hostHeader(host);
-    r.push_back(Request(host, buffer, location));
+    assert(!iterator->host.empty());
+    request.hostHeader(iterator->host);
+    r.push_back(Request(*iterator, buffer, location));
   }
 }
 
@@ -255,14 +259,27 @@ dispatch(Requests &r, const int t)
   const Requests::iterator end = r.end();
   for (; iterator != end; ++iterator) {
     assert(iterator->io.get() != nullptr);
+    /*
+     * An origin which does not keep up with the copies would have them pile up in memory,
+     * the copy is dropped instead once the origin has too many bytes pending.
+     */
+    const int64_t pending = *iterator->pending += iterator->length;
+    if (maxPending > 0 && pending > maxPending) {
+      *iterator->pending -= iterator->length;
+      TSDebug(PLUGIN_TAG, "Dropping %" PRId64 " bytes to \"%s\", %" PRId64 " bytes are pending", iterator->length,
+              iterator->host.c_str(), pending - iterator->length);
+      TSStatIntIncrement(statistics.dropped, 1);
+      iterator->io.reset();
+      continue;
+    }
     if (TSIsDebugTagSet(PLUGIN_TAG) > 0) {
-      TSDebug(PLUGIN_TAG, "Dispatching %i bytes to \"%s\"", iterator->length, iterator->host.c_str());
+      TSDebug(PLUGIN_TAG, "Dispatching %" PRId64 " bytes to \"%s\"", iterator->length, iterator->host.c_str());
       std::string b;
       read(iterator->io->reader, b);
       assert(b.size() == static_cast<uint64_t>(iterator->length));
       TSDebug(PLUGIN_TAG, "%s", b.c_str());
     }
     // forwarding iterator->io pointer ownership
-    ats::get(iterator->io.release(), iterator->length, Handler(iterator->host), t);
+    ats::get(iterator->io.release(), iterator->length, Handler(iterator->host, iterator->pending, iterator->length), t);
   }
 }
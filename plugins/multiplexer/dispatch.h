@@ -23,6 +23,7 @@
 
 #pragma once
 
+#include <atomic>
 #include <cassert>
 #include <memory>
 #include <string>
@@ -44,16 +45,28 @@ struct Statistics {
   int requests;
   int timeouts;
   int size; // average
+  int dropped;
 };
 
-typedef std::vector<std::string> Origins;
+/// Bytes of the copies sent to an origin which are not answered yet, shared with the copies in flight.
+typedef std::shared_ptr<std::atomic<int64_t>> Pending;
+
+struct Origin {
+  std::string host;
+  Pending pending;
+
+  explicit Origin(const std::string &h) : host(h), pending(std::make_shared<std::atomic<int64_t>>(0)) {}
+};
+
+typedef std::vector<Origin> Origins;
 
 struct Request {
   std::string host;
-  int length;
+  int64_t length;
   std::unique_ptr<ats::io::IO> io;
+  Pending pending;
 
-  Request(const std::string &, const TSMBuffer, const TSMLoc);
+  Request(const Origin &, const TSMBuffer, const TSMLoc);
   Request(const Request &) = delete;
   Request(Request &&);
   Request &operator=(const Request &);
@@ -66,6 +79,7 @@ struct Instance {
 };
 
 extern size_t timeout;
+extern int64_t maxPending;
 
 void generateRequests(const Origins &, const TSMBuffer, const TSMLoc, Requests &);
 void addBody(Requests &, const TSIOBufferReader);
@@ -21,6 +21,7 @@
   limitations under the License.
  */
 #include <cassert>
+#include <cinttypes>
 #include <limits>
 
 #include "post.h"
@@ -29,6 +30,8 @@
 #error Please define a PLUGIN_TAG before including this file.
 #endif
 
+extern Statistics statistics;
+
 PostState::~PostState()
 {
   if (buffer != nullptr) {
@@ -37,7 +40,7 @@ PostState::~PostState()
   }
 }
 
-PostState::PostState(Requests &r) : buffer(nullptr), reader(nullptr), vio(nullptr)
+PostState::PostState(Requests &r) : buffer(nullptr), reader(nullptr), vio(nullptr), dropped(false)
 {
   assert(!r.empty());
   requests.swap(r);
@@ -88,6 +91,16 @@ postTransform(const TSCont c, PostState &s)
     }
   }
 
+  /*
+   * No origin would take a copy of a body larger than the pending limit, stop keeping it
+   * for them so that the body is only buffered for the original request.
+   */
+  if (s.reader != nullptr && maxPending > 0 && TSIOBufferReaderAvail(s.reader) > maxPending) {
+    TSIOBufferReaderFree(s.reader);
+    s.reader  = nullptr;
+    s.dropped = true;
+  }
+
   if (TSVIONTodoGet(vio) > 0) {
     if (toWrite > 0) {
       TSVIOReenable(s.vio);
@@ -109,10 +122,15 @@ handlePost(TSCont c, TSEvent e, void *data)
   assert(state != nullptr);
   if (TSVConnClosedGet(c)) {
     assert(data != nullptr);
-    if (state->reader != nullptr) {
-      addBody(state->requests, state->reader);
+    if (state->dropped) {
+      TSDebug(PLUGIN_TAG, "Dropping %zu copies, the body is larger than %" PRId64 " bytes", state->requests.size(), maxPending);
+      TSStatIntIncrement(statistics.dropped, state->requests.size());
+    } else {
+      if (state->reader != nullptr) {
+        addBody(state->requests, state->reader);
+      }
+      dispatch(state->requests, timeout);
     }
-    dispatch(state->requests, timeout);
     delete state;
     TSContDataSet(c, nullptr);
     TSContDestroy(c);
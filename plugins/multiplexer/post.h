@@ -33,6 +33,7 @@ struct PostState {
   TSIOBuffer buffer;
   TSIOBufferReader reader;
   TSVIO vio;
+  bool dropped; // the body got too large for the copies
 
   ~PostState();
   PostState(Requests &);
@@ -66,6 +66,9 @@ PrefetchConfig::init(int argc, char *argv[])
                                           {const_cast<char *>("metrics-prefix"), optional_argument, nullptr, 'm'},
                                           {const_cast<char *>("exact-match"), optional_argument, nullptr, 'y'},
                                           {const_cast<char *>("log-name"), optional_argument, nullptr, 'l'},
+                                          {const_cast<char *>("learn-size"), optional_argument, nullptr, 'z'},
+                                          {const_cast<char *>("learn-min-hits"), optional_argument, nullptr, 'k'},
+                                          {const_cast<char *>("fetch-bandwidth"), optional_argument, nullptr, 'w'},
                                           {nullptr, 0, nullptr, 0}};
 
   bool status = true;
@@ -141,6 +144,18 @@ PrefetchConfig::init(int argc, char *argv[])
     case 'l': /* --log-name */
       setLogName(optarg);
       break;
+
+    case 'z': /* --learn-size */
+      setLearnSize(optarg);
+      break;
+
+    case 'k': /* --learn-min-hits */
+      setLearnMinHits(optarg);
+      break;
+
+    case 'w': /* --fetch-bandwidth */
+      setFetchBandwidth(optarg);
+      break;
     }
   }
 
@@ -167,6 +182,9 @@ PrefetchConfig::finalize()
   PrefetchDebug("replace host name: %s", _replaceHost.c_str());
   PrefetchDebug("name space: %s", _namespace.c_str());
   PrefetchDebug("log name: %s", _logName.c_str());
+  PrefetchDebug("learn size: %u", _learnSize);
+  PrefetchDebug("learn min hits: %u", _learnMinHits);
+  PrefetchDebug("fetch bandwidth max: %zu", _fetchBandwidth);
 
   return true;
 }
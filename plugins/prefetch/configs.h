@@ -159,6 +159,42 @@ public:
     return _metricsPrefix;
   }
 
+  void
+  setLearnSize(const char *optarg)
+  {
+    _learnSize = getValue(optarg);
+  }
+
+  unsigned
+  getLearnSize() const
+  {
+    return _learnSize;
+  }
+
+  void
+  setLearnMinHits(const char *optarg)
+  {
+    _learnMinHits = getValue(optarg);
+  }
+
+  unsigned
+  getLearnMinHits() const
+  {
+    return _learnMinHits;
+  }
+
+  void
+  setFetchBandwidth(const char *optarg)
+  {
+    _fetchBandwidth = getValue(optarg);
+  }
+
+  size_t
+  getFetchBandwidth() const
+  {
+    return _fetchBandwidth;
+  }
+
   MultiPattern &
   getNextPath()
   {
@@ -191,9 +227,12 @@ private:
   std::string _namespace;
   std::string _metricsPrefix;
   std::string _logName;
-  unsigned _fetchCount = 1;
-  unsigned _fetchMax   = 0;
-  bool _front          = false;
-  bool _exactMatch     = false;
+  unsigned _fetchCount   = 1;
+  unsigned _fetchMax     = 0;
+  unsigned _learnSize    = 0; /* 0 - don't learn the request sequences */
+  unsigned _learnMinHits = 2;
+  size_t _fetchBandwidth = 0; /* bytes per second, 0 - no limit */
+  bool _front            = false;
+  bool _exactMatch       = false;
   MultiPattern _nextPaths;
 };
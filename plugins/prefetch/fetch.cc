@@ -82,6 +82,18 @@ getPrefetchMetricsNames(int metric)
   case FETCH_POLICY_MAXSIZE:
     return "fetch.policy.maxsize";
     break;
+  case FETCH_LEARN_HIT:
+    return "fetch.learn.hit";
+    break;
+  case FETCH_LEARN_MISS:
+    return "fetch.learn.miss";
+    break;
+  case FETCH_LEARN_PREDICTED:
+    return "fetch.learn.predicted";
+    break;
+  case FETCH_LEARN_SIZE:
+    return "fetch.learn.size";
+    break;
   default:
     return "unknown";
     break;
@@ -129,6 +141,13 @@ BgFetchState::BgFetchState()
   } else {
     PrefetchDebug("initialized lock");
   }
+
+  _learnerLock = TSMutexCreate();
+  if (nullptr == _learnerLock) {
+    PrefetchError("failed to initialize lock");
+  } else {
+    PrefetchDebug("initialized lock");
+  }
 }
 
 BgFetchState::~BgFetchState()
@@ -141,8 +160,13 @@ BgFetchState::~BgFetchState()
   delete _unique;
   TSMutexUnlock(_lock);
 
+  TSMutexLock(_learnerLock);
+  delete _learner;
+  TSMutexUnlock(_learnerLock);
+
   TSMutexDestroy(_policyLock);
   TSMutexDestroy(_lock);
+  TSMutexDestroy(_learnerLock);
 
   TSTextLogObjectFlush(_log);
   TSTextLogObjectDestroy(_log);
@@ -208,6 +232,7 @@ BgFetchState::init(const PrefetchConfig &config)
 
   /* Is throttling configured, 0 - don't throttle */
   _concurrentFetchesMax = config.getFetchMax();
+  _bandwidthMax         = config.getFetchBandwidth();
 
   /* Initialize the state */
   TSMutexLock(_lock);
@@ -237,6 +262,20 @@ BgFetchState::init(const PrefetchConfig &config)
 
   TSMutexUnlock(_policyLock);
 
+  /* Initialize the learner of the request sequences */
+  TSMutexLock(_learnerLock);
+
+  if (0 < config.getLearnSize()) {
+    if (nullptr == _learner) {
+      _learner = new SequenceLearner();
+      _learner->init(config.getLearnSize(), config.getLearnMinHits(), config.getFetchCount());
+    } else {
+      PrefetchDebug("learner already initialized");
+    }
+  }
+
+  TSMutexUnlock(_learnerLock);
+
   return status;
 }
 
@@ -334,6 +373,77 @@ BgFetchState::uniqueRelease(const String &url)
   return permitted;
 }
 
+bool
+BgFetchState::isLearning() const
+{
+  return nullptr != _learner;
+}
+
+void
+BgFetchState::learn(const String &client, const String &path)
+{
+  SequenceLearner::LearnResult result;
+  size_t size;
+
+  TSMutexLock(_learnerLock);
+  result = _learner->learn(client, path);
+  size   = _learner->getSize();
+  TSMutexUnlock(_learnerLock);
+
+  if (SequenceLearner::LEARN_HIT == result) {
+    incrementMetric(FETCH_LEARN_HIT);
+  } else if (SequenceLearner::LEARN_MISS == result) {
+    incrementMetric(FETCH_LEARN_MISS);
+  }
+  setMetric(FETCH_LEARN_SIZE, size);
+}
+
+void
+BgFetchState::predict(const String &path, StringVector &next)
+{
+  TSMutexLock(_learnerLock);
+  _learner->predict(path, next);
+  TSMutexUnlock(_learnerLock);
+}
+
+/**
+ * @brief Check if the fetches are still under the bandwidth limit in the current second.
+ * @return true if another fetch can be scheduled, false if throttled.
+ */
+bool
+BgFetchState::bandwidthAcquire()
+{
+  if (0 == _bandwidthMax) {
+    return true;
+  }
+
+  bool permitted;
+  TSHRTime now = TShrtime();
+
+  TSMutexLock(_lock);
+  if (now - _windowStart >= 1000000000) {
+    _windowStart = now;
+    _windowBytes = 0;
+  }
+  permitted = _windowBytes < _bandwidthMax;
+  TSMutexUnlock(_lock);
+
+  if (!permitted) {
+    incrementMetric(FETCH_THROTTLED);
+  }
+  return permitted;
+}
+
+void
+BgFetchState::addBytes(int64_t b)
+{
+  if (0 != _bandwidthMax) {
+    TSMutexLock(_lock);
+    _windowBytes += b;
+    TSMutexUnlock(_lock);
+  }
+}
+
 void
 BgFetchState::incrementMetric(PrefetchMetric m)
 {
@@ -445,6 +555,7 @@ inline void
 BgFetch::addBytes(int64_t b)
 {
   _bytes += b;
+  _state->addBytes(b);
 }
 /**
  * Initialize the background fetch
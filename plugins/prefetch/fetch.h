@@ -33,6 +33,7 @@
 #include "common.h"
 #include "configs.h"
 #include "fetch_policy.h"
+#include "learner.h"
 
 enum PrefetchMetric {
   FETCH_ACTIVE = 0,
@@ -50,6 +51,10 @@ enum PrefetchMetric {
   FETCH_POLICY_NO,  /* metric id for counting fetch policy failures */
   FETCH_POLICY_SIZE,
   FETCH_POLICY_MAXSIZE,
+  FETCH_LEARN_HIT,       /* metric id for requests of objects predicted by the learned sequences */
+  FETCH_LEARN_MISS,      /* metric id for requests of objects that were not predicted */
+  FETCH_LEARN_PREDICTED, /* metric id for counting the fetches scheduled from the learned sequences */
+  FETCH_LEARN_SIZE,
   FETCHES_MAX_METRICS,
 };
 
@@ -79,6 +84,15 @@ public:
   bool uniqueAcquire(const String &url);
   bool uniqueRelease(const String &url);
 
+  /* Learned request sequences */
+  bool isLearning() const;
+  void learn(const String &client, const String &path);
+  void predict(const String &path, StringVector &next);
+
+  /* Bandwidth limit of the fetches */
+  bool bandwidthAcquire();
+  void addBytes(int64_t b);
+
   /* Metrics and logs */
   void incrementMetric(PrefetchMetric m);
   void setMetric(PrefetchMetric m, size_t value);
@@ -95,8 +109,18 @@ private:
   /* Mechanisms to avoid concurrent fetches and applying limits */
   FetchPolicy *_unique = nullptr; /* make sure we never download same object multiple times at the same time */
   TSMutex _lock;                  /* protects the de-duplication object only */
-  size_t _concurrentFetches                        = 0;
-  size_t _concurrentFetchesMax                     = 0;
+  size_t _concurrentFetches    = 0;
+  size_t _concurrentFetchesMax = 0;
+
+  /* Learned request sequences */
+  SequenceLearner *_learner = nullptr;
+  TSMutex _learnerLock; /* protects the learner object only */
+
+  /* Bytes fetched in the current second, to cap the bandwidth of the fetches */
+  size_t _bandwidthMax  = 0;
+  size_t _windowBytes   = 0;
+  TSHRTime _windowStart = 0;
+
   PrefetchMetricInfo _metrics[FETCHES_MAX_METRICS] = {
     {FETCH_ACTIVE, TS_RECORDDATATYPE_INT, -1},        {FETCH_COMPLETED, TS_RECORDDATATYPE_COUNTER, -1},
     {FETCH_ERRORS, TS_RECORDDATATYPE_COUNTER, -1},    {FETCH_TIMEOOUTS, TS_RECORDDATATYPE_COUNTER, -1},
@@ -105,7 +129,9 @@ private:
     {FETCH_UNIQUE_NO, TS_RECORDDATATYPE_COUNTER, -1}, {FETCH_MATCH_YES, TS_RECORDDATATYPE_COUNTER, -1},
     {FETCH_MATCH_NO, TS_RECORDDATATYPE_COUNTER, -1},  {FETCH_POLICY_YES, TS_RECORDDATATYPE_COUNTER, -1},
     {FETCH_POLICY_NO, TS_RECORDDATATYPE_COUNTER, -1}, {FETCH_POLICY_SIZE, TS_RECORDDATATYPE_INT, -1},
-    {FETCH_POLICY_MAXSIZE, TS_RECORDDATATYPE_INT, -1}};
+    {FETCH_POLICY_MAXSIZE, TS_RECORDDATATYPE_INT, -1}, {FETCH_LEARN_HIT, TS_RECORDDATATYPE_COUNTER, -1},
+    {FETCH_LEARN_MISS, TS_RECORDDATATYPE_COUNTER, -1}, {FETCH_LEARN_PREDICTED, TS_RECORDDATATYPE_COUNTER, -1},
+    {FETCH_LEARN_SIZE, TS_RECORDDATATYPE_INT, -1}};
 
   /* plugin specific fetch logging */
   TSTextLogObject _log = nullptr;
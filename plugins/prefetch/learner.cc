@@ -0,0 +1,108 @@
+/*
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+  http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+*/
+
+/**
+ * @file learner.cc
+ * @brief Learns the sequences of objects requested by the clients.
+ */
+
+#include <algorithm>
+
+#include "learner.h"
+
+void
+SequenceLearner::init(size_t maxSize, unsigned minHits, unsigned count)
+{
+  _maxSize = maxSize;
+  _minHits = std::max(minHits, 1u);
+  _count   = std::min(std::max(count, 1u), LearnerTransitions::SLOTS);
+
+  _transitions.setMaxSize(_maxSize);
+  _last.setMaxSize(_maxSize);
+
+  PrefetchDebug("initialized learner: size: %zu, min hits: %u, count: %u", _maxSize, _minHits, _count);
+}
+
+bool
+SequenceLearner::predicted(const LearnerTransitions &t, const String &path) const
+{
+  for (unsigned i = 0; i < _count && t.hits[i] >= _minHits; i++) {
+    if (t.next[i] == path) {
+      return true;
+    }
+  }
+  return false;
+}
+
+SequenceLearner::LearnResult
+SequenceLearner::learn(const String &client, const String &path)
+{
+  size_t pos = path.find_last_of('/');
+  String key(client);
+  key.append(" ").append(path, 0, String::npos == pos ? 0 : pos + 1);
+
+  String &last = _last.get(key);
+  if (last.empty() || last == path) {
+    /* First request of the client under this prefix, or a retry / range request of the same object */
+    last.assign(path);
+    return LEARN_NONE;
+  }
+
+  LearnerTransitions &t = _transitions.get(last);
+  LearnResult result    = predicted(t, path) ? LEARN_HIT : LEARN_MISS;
+
+  /* Count the transition, a new one takes the slot of the least frequent one */
+  unsigned i = 0;
+  while (i < LearnerTransitions::SLOTS - 1 && 0 != t.hits[i] && t.next[i] != path) {
+    i++;
+  }
+  if (t.next[i] != path) {
+    t.next[i].assign(path);
+    t.hits[i] = 0;
+  }
+  t.hits[i]++;
+
+  /* Keep the slots sorted, most frequent first */
+  while (i > 0 && t.hits[i] > t.hits[i - 1]) {
+    std::swap(t.next[i], t.next[i - 1]);
+    std::swap(t.hits[i], t.hits[i - 1]);
+    i--;
+  }
+
+  if (t.hits[0] >= LearnerTransitions::MAX_HITS) {
+    for (unsigned &hits : t.hits) {
+      hits /= 2;
+    }
+  }
+
+  last.assign(path);
+  return result;
+}
+
+void
+SequenceLearner::predict(const String &path, StringVector &next)
+{
+  LearnerTransitions *t = _transitions.find(path);
+  if (nullptr == t) {
+    return;
+  }
+
+  for (unsigned i = 0; i < _count && t->hits[i] >= _minHits; i++) {
+    next.push_back(t->next[i]);
+  }
+}
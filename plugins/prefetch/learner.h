@@ -0,0 +1,164 @@
+/*
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+  http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+*/
+
+/**
+ * @file learner.h
+ * @brief Learns the sequences of objects requested by the clients (header file).
+ */
+
+#pragma once
+
+#include <list>
+#include <unordered_map>
+#include <utility>
+
+#include "common.h"
+
+/**
+ * @brief A table with a bounded number of entries, the least recently used entry is evicted to make room.
+ */
+template <typename Value> class LearnerTable
+{
+public:
+  void
+  setMaxSize(size_t maxSize)
+  {
+    _maxSize = maxSize;
+  }
+
+  size_t
+  size() const
+  {
+    return _list.size();
+  }
+
+  /* Find an entry and make it the most recently used, nullptr if not found */
+  Value *
+  find(const String &key)
+  {
+    auto it = _map.find(key);
+    if (_map.end() == it) {
+      return nullptr;
+    }
+    _list.splice(_list.begin(), _list, it->second);
+    return &it->second->second;
+  }
+
+  /* Find an entry or add an empty one */
+  Value &
+  get(const String &key)
+  {
+    Value *value = find(key);
+    if (nullptr != value) {
+      return *value;
+    }
+
+    if (_list.size() >= _maxSize && !_list.empty()) {
+      /* Reuse the least recently used entry */
+      _list.splice(_list.begin(), _list, --_list.end());
+      _map.erase(_list.begin()->first);
+      _list.begin()->first  = key;
+      _list.begin()->second = Value();
+    } else {
+      _list.emplace_front(key, Value());
+    }
+    _map[key] = _list.begin();
+    return _list.begin()->second;
+  }
+
+private:
+  typedef std::list<std::pair<String, Value>> List;
+
+  List _list;
+  std::unordered_map<String, typename List::iterator> _map;
+  size_t _maxSize = 0;
+};
+
+/**
+ * @brief The most frequent next objects of an object.
+ *
+ * Only a few candidates are kept, sorted by their hits, a new candidate replaces the least frequent one.
+ */
+struct LearnerTransitions {
+  static constexpr unsigned SLOTS    = 4;
+  static constexpr unsigned MAX_HITS = 1024; /* all the hits are halved once a candidate reaches this, old habits fade */
+
+  String next[SLOTS];
+  unsigned hits[SLOTS] = {0};
+};
+
+/**
+ * @brief Learns the transitions from an object to the next one requested by the same client under the same path prefix, and
+ * predicts the most likely next objects of an object.
+ *
+ * Meant for sequences like HLS / DASH segments, the path prefix is the path up to its last '/' so that the requests of a
+ * client playing two streams at once don't mix.
+ */
+class SequenceLearner
+{
+public:
+  enum LearnResult {
+    LEARN_NONE = 0, /* no previous object of the client to learn from */
+    LEARN_HIT,      /* the object was one of the predicted next objects of the previous one */
+    LEARN_MISS,     /* the object was not predicted */
+  };
+
+  /**
+   * @brief initializes the learner
+   * @param maxSize the most objects to keep the transitions of (and the most clients to track)
+   * @param minHits the hits of a transition before it is predicted
+   * @param count how many next objects to predict
+   */
+  void init(size_t maxSize, unsigned minHits, unsigned count);
+
+  /**
+   * @brief records that a client requested an object.
+   * @param client identifies the client, i.e. its address
+   * @param path the path of the object
+   * @return if the object was predicted from the previous object of the client
+   */
+  LearnResult learn(const String &client, const String &path);
+
+  /**
+   * @brief predicts the most likely next objects, most likely first.
+   * @param path the path of the current object
+   * @param next the predictions are appended here
+   */
+  void predict(const String &path, StringVector &next);
+
+  size_t
+  getSize() const
+  {
+    return _transitions.size();
+  }
+
+  size_t
+  getMaxSize() const
+  {
+    return _maxSize;
+  }
+
+private:
+  bool predicted(const LearnerTransitions &t, const String &path) const;
+
+  LearnerTable<LearnerTransitions> _transitions; /* object path -> its next objects */
+  LearnerTable<String> _last;                    /* client + path prefix -> last object path */
+  size_t _maxSize   = 0;
+  unsigned _minHits = 2;
+  unsigned _count   = 1;
+};
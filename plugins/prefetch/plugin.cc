@@ -23,6 +23,7 @@
 
 #include <sstream>
 #include <iomanip>
+#include <arpa/inet.h>
 
 #include "ts/ts.h" /* ATS API */
 
@@ -366,6 +367,28 @@ getPristineUrlPath(TSHttpTxn txnp)
   return pristinePath;
 }
 
+/**
+ * @brief get the client address, which identifies the client in the learned request sequences
+ *
+ * @param txnp HTTP transaction structure
+ * @return client address string, empty if failure
+ */
+static String
+getClientKey(TSHttpTxn txnp)
+{
+  char buf[INET6_ADDRSTRLEN] = {0};
+  const sockaddr *addr       = TSHttpTxnClientAddrGet(txnp);
+
+  if (nullptr != addr) {
+    if (AF_INET == addr->sa_family) {
+      inet_ntop(AF_INET, &(reinterpret_cast<const sockaddr_in *>(addr)->sin_addr), buf, sizeof(buf));
+    } else if (AF_INET6 == addr->sa_family) {
+      inet_ntop(AF_INET6, &(reinterpret_cast<const sockaddr_in6 *>(addr)->sin6_addr), buf, sizeof(buf));
+    }
+  }
+  return String(buf);
+}
+
 /**
  * @brief short-cut to set the response .
  */
@@ -522,6 +545,32 @@ contHandleFetch(const TSCont contp, TSEvent event, void *edata)
     if (data->frontend()) {
       /* front-end instance */
 
+      String learnedPath;
+      if (data->firstPass() && state->isLearning()) {
+        /* Learn from every request, the prediction hits and misses are counted here */
+        learnedPath = getPristineUrlPath(txnp);
+        String client(getClientKey(txnp));
+        if (!learnedPath.empty() && !client.empty()) {
+          state->learn(client, learnedPath);
+        }
+      }
+
+      if (data->firstPass() && data->_fetchable && !learnedPath.empty() && respToTriggerPrefetch(txnp)) {
+        /* Trigger the background fetches of the most likely next objects */
+        StringVector next;
+        state->predict(learnedPath, next);
+        for (const String &path : next) {
+          if (!state->bandwidthAcquire()) {
+            PrefetchDebug("fetch bandwidth limit reached");
+            break;
+          }
+          PrefetchDebug("predicted: %s", path.c_str());
+          state->incrementMetric(FETCH_LEARN_PREDICTED);
+          BgFetch::schedule(state, config, /* askPermission */ false, reqBuffer, reqHdrLoc, txnp, path.c_str(), path.length(),
+                            data->_cachekey);
+        }
+      }
+
       if (data->firstPass() && data->_fetchable && !config.getNextPath().empty() && respToTriggerPrefetch(txnp)) {
         /* Trigger all necessary background fetches based on the next path pattern */
 
@@ -529,6 +578,10 @@ contHandleFetch(const TSCont contp, TSEvent event, void *edata)
         if (!currentPath.empty()) {
           unsigned total = config.getFetchCount();
           for (unsigned i = 0; i < total; ++i) {
+            if (!state->bandwidthAcquire()) {
+              PrefetchDebug("fetch bandwidth limit reached");
+              break;
+            }
             PrefetchDebug("generating prefetch request %d/%d", i + 1, total);
             String expandedPath;
 
@@ -700,9 +753,14 @@ TSRemapDoRemap(void *instance, TSHttpTxn txnp, TSRemapRequestInfo *rri)
       if (front && firstPass) {
         /* Front-end plug-in instance + first pass. */
         if (config.getNextPath().empty()) {
-          /* No next path pattern specified then pass this request untouched. */
-          PrefetchDebug("next object pattern not specified, skip");
-          handleFetch = false;
+          if (inst->_state->isLearning()) {
+            /* No next path pattern specified but the next objects are learned from all requests. */
+            PrefetchDebug("next object pattern not specified, learning");
+          } else {
+            /* No next path pattern specified then pass this request untouched. */
+            PrefetchDebug("next object pattern not specified, skip");
+            handleFetch = false;
+          }
         } else {
           /* Next path pattern specified hence try to match. */
           String pristinePath = getPristineUrlPath(txnp);
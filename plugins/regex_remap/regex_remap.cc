@@ -122,7 +122,7 @@ public:
       pcre_free(_rex);
     }
     if (_extra) {
-      pcre_free(_extra);
+      pcre_free_study(_extra);
     }
   }
 
@@ -400,7 +400,11 @@ RemapRegex::compile(const char *&error, int &erroffset)
     return -1;
   }
 
+#ifdef PCRE_CONFIG_JIT
+  _extra = pcre_study(_rex, PCRE_STUDY_JIT_COMPILE, &error);
+#else
   _extra = pcre_study(_rex, 0, &error);
+#endif
   if ((_extra == nullptr) && (error != nullptr)) {
     return -1;
   }
@@ -23,10 +23,12 @@
  */
 
 #include <cstring>        /* strlen() */
+#include <strings.h>      /* strncasecmp() */
 #include <string>         /* stoi() */
 #include <ctime>          /* strftime(), time(), gmtime_r() */
 #include <iomanip>        /* std::setw */
 #include <sstream>        /* std::stringstream */
+#include <vector>         /* std::vector */
 #include <openssl/sha.h>  /* SHA(), sha256_Update(), SHA256_Final, etc. */
 #include <openssl/hmac.h> /* HMAC() */
 
@@ -82,11 +84,11 @@ uriEncode(const String &in, bool isObjectName)
 {
   std::stringstream result;
 
-  for (char i : in) {
+  for (unsigned char i : in) {
     if (isalnum(i) || i == '-' || i == '_' || i == '.' || i == '~') {
       /* URI encode every byte except the unreserved characters:
        * 'A'-'Z', 'a'-'z', '0'-'9', '-', '.', '_', and '~'. */
-      result << i;
+      result << static_cast<char>(i);
     } else if (i == ' ') {
       /* The space character is a reserved character and must be encoded as "%20" (and not as "+"). */
       result << "%20";
@@ -227,6 +229,80 @@ sha256Final(unsigned char hex[SHA256_DIGEST_LENGTH], SHA256_CTX *ctx)
   SHA256_Final(hex, ctx);
 }
 
+/**
+ * @brief Hash the lower-cased input without making a lower-cased copy of it.
+ */
+static void
+sha256UpdateLowercase(SHA256_CTX *ctx, const char *in, size_t inLen)
+{
+  char buf[64];
+  while (inLen > 0) {
+    size_t len = std::min(inLen, sizeof(buf));
+    std::transform(in, in + len, buf, ::tolower);
+    sha256Update(ctx, buf, len);
+    in += len;
+    inLen -= len;
+  }
+}
+
+/**
+ * @brief Hash the URI-encoded input (same encoding as uriEncode()) without making an encoded copy of it.
+ */
+static void
+sha256UpdateUriEncoded(SHA256_CTX *ctx, const char *in, size_t inLen, bool isObjectName)
+{
+  static const char hexDigits[] = "0123456789ABCDEF";
+  char buf[256];
+  size_t len = 0;
+
+  for (const char *end = in + inLen; in < end; in++) {
+    unsigned char c = *in;
+    if (len + 3 > sizeof(buf)) {
+      sha256Update(ctx, buf, len);
+      len = 0;
+    }
+    if (isalnum(c) || c == '-' || c == '_' || c == '.' || c == '~' || (isObjectName && c == '/')) {
+      buf[len++] = c;
+    } else {
+      buf[len++] = '%';
+      buf[len++] = hexDigits[c >> 4];
+      buf[len++] = hexDigits[c & 0xF];
+    }
+  }
+  sha256Update(ctx, buf, len);
+}
+
+namespace
+{
+/* A header field to be signed, pointing into the request header */
+struct CanonicalHeader {
+  const char *name;
+  size_t nameLen;
+  const char *value;
+  size_t valueLen;
+};
+
+/* Order of the lower-cased header names, without lower-casing them */
+bool
+canonicalHeaderLess(const CanonicalHeader &a, const CanonicalHeader &b)
+{
+  int cmp = strncasecmp(a.name, b.name, std::min(a.nameLen, b.nameLen));
+  return cmp < 0 || (cmp == 0 && a.nameLen < b.nameLen);
+}
+
+bool
+canonicalHeaderEqual(const CanonicalHeader &a, const CanonicalHeader &b)
+{
+  return a.nameLen == b.nameLen && 0 == strncasecmp(a.name, b.name, a.nameLen);
+}
+
+bool
+headerNameIs(const char *name, size_t nameLen, const String &lowercaseName)
+{
+  return nameLen == lowercaseName.length() && 0 == strncasecmp(name, lowercaseName.c_str(), nameLen);
+}
+} // namespace
+
 /**
  * @brief: Payload SHA 256 = Hex(SHA256Hash(<payload>) (no new-line char at end)
  *
@@ -285,10 +361,8 @@ getCanonicalRequestSha256Hash(TsInterface &api, bool signPayload, const StringSe
   /* URI Encoded Canonical URI
    * <CanonicalURI>\n */
   str = api.getPath(&length);
-  String path("/");
-  path.append(str, length);
-  String canonicalUri = uriEncode(path, /* isObjectName */ true);
-  sha256Update(&canonicalRequestSha256Ctx, canonicalUri);
+  sha256Update(&canonicalRequestSha256Ctx, "/");
+  sha256UpdateUriEncoded(&canonicalRequestSha256Ctx, str, length, /* isObjectName */ true);
   sha256Update(&canonicalRequestSha256Ctx, "\n");
 
   /* Sorted Canonical Query String
@@ -320,21 +394,25 @@ getCanonicalRequestSha256Hash(TsInterface &api, bool signPayload, const StringSe
     }
   }
 
-  String queryStr;
+  bool firstParam = true;
   for (const auto &paramName : paramNames) {
-    if (!queryStr.empty()) {
-      queryStr.append("&");
+    if (!firstParam) {
+      sha256Update(&canonicalRequestSha256Ctx, "&");
     }
-    queryStr.append(paramName);
-    queryStr.append("=").append(paramsMap[paramName]);
+    firstParam = false;
+    sha256Update(&canonicalRequestSha256Ctx, paramName);
+    sha256Update(&canonicalRequestSha256Ctx, "=");
+    sha256Update(&canonicalRequestSha256Ctx, paramsMap[paramName]);
   }
-  sha256Update(&canonicalRequestSha256Ctx, queryStr);
   sha256Update(&canonicalRequestSha256Ctx, "\n");
 
   /* Sorted Canonical Headers
-   *  <CanonicalHeaders>\n */
-  StringSet signedHeadersSet;
-  StringMap headersMap;
+   *  <CanonicalHeaders>\n
+   * The names and the values are hashed straight from the request header, the vectors of the thread are reused so
+   * that in the steady state no memory is allocated per request. */
+  thread_local std::vector<CanonicalHeader> headers;
+  thread_local String lowercaseName;
+  headers.clear();
 
   for (HeaderIterator it = api.headerBegin(); it != api.headerEnd(); it++) {
     int nameLen;
@@ -346,19 +424,19 @@ getCanonicalRequestSha256Hash(TsInterface &api, bool signPayload, const StringSe
       continue;
     }
 
-    String lowercaseName(name, nameLen);
-    std::transform(lowercaseName.begin(), lowercaseName.end(), lowercaseName.begin(), ::tolower);
-
     /* Host, content-type and x-amx-* headers are mandatory */
-    bool xAmzHeader        = (lowercaseName.length() >= X_AMZ.length() && 0 == lowercaseName.compare(0, X_AMZ.length(), X_AMZ));
-    bool contentTypeHeader = (0 == CONTENT_TYPE.compare(lowercaseName));
-    bool hostHeader        = (0 == HOST.compare(lowercaseName));
+    bool xAmzHeader = (static_cast<size_t>(nameLen) >= X_AMZ.length() && 0 == strncasecmp(name, X_AMZ.c_str(), X_AMZ.length()));
+    bool contentTypeHeader = headerNameIs(name, nameLen, CONTENT_TYPE);
+    bool hostHeader        = headerNameIs(name, nameLen, HOST);
     if (!xAmzHeader && !contentTypeHeader && !hostHeader) {
       /* Skip internal headers (starting with '@'*/
       if ('@' == name[0] /* exclude internal headers */) {
         continue;
       }
 
+      lowercaseName.assign(name, nameLen);
+      std::transform(lowercaseName.begin(), lowercaseName.end(), lowercaseName.begin(), ::tolower);
+
       /* @todo do better here, since iterating over the headers in ATS is known to be less efficient,
        * come up with a better way if include headers set is non-empty */
       bool include =
@@ -377,24 +455,29 @@ getCanonicalRequestSha256Hash(TsInterface &api, bool signPayload, const StringSe
     size_t trimValueLen   = 0;
     const char *trimValue = trimWhiteSpaces(value, valueLen, trimValueLen);
 
-    signedHeadersSet.insert(lowercaseName);
-    headersMap[lowercaseName] = String(trimValue, trimValueLen);
+    headers.push_back({name, static_cast<size_t>(nameLen), trimValue, trimValueLen});
   }
 
-  for (const auto &it : signedHeadersSet) {
-    sha256Update(&canonicalRequestSha256Ctx, it);
+  /* A header repeated under the same name is signed once, with its last value */
+  std::stable_sort(headers.begin(), headers.end(), canonicalHeaderLess);
+  auto last = headers.end();
+  for (auto it = headers.begin(); it != last; ++it) {
+    if (it + 1 != last && canonicalHeaderEqual(*it, *(it + 1))) {
+      continue;
+    }
+    sha256UpdateLowercase(&canonicalRequestSha256Ctx, it->name, it->nameLen);
     sha256Update(&canonicalRequestSha256Ctx, ":");
-    sha256Update(&canonicalRequestSha256Ctx, headersMap[it]);
+    sha256Update(&canonicalRequestSha256Ctx, it->value, it->valueLen);
     sha256Update(&canonicalRequestSha256Ctx, "\n");
-  }
-  sha256Update(&canonicalRequestSha256Ctx, "\n");
 
-  for (const auto &it : signedHeadersSet) {
     if (!signedHeaders.empty()) {
       signedHeaders.append(";");
     }
-    signedHeaders.append(it);
+    size_t pos = signedHeaders.length();
+    signedHeaders.append(it->name, it->nameLen);
+    std::transform(signedHeaders.begin() + pos, signedHeaders.end(), signedHeaders.begin() + pos, ::tolower);
   }
+  sha256Update(&canonicalRequestSha256Ctx, "\n");
 
   sha256Update(&canonicalRequestSha256Ctx, signedHeaders);
   sha256Update(&canonicalRequestSha256Ctx, "\n");
@@ -609,12 +692,87 @@ getStringToSign(const char *entryPoint, size_t EntryPointLen, const char *dateTi
   return stringToSign;
 }
 
+namespace
+{
+/* A derived signing key, it only changes with the secret, the day, the region and the service */
+struct SigningKey {
+  String secret;
+  String date;
+  String region;
+  String service;
+  unsigned char key[EVP_MAX_MD_SIZE];
+  unsigned int keyLen = 0;
+};
+
+/* The last signing keys derived by this thread, most requests of a thread go to a few regions with the same secret */
+const size_t SIGNING_KEY_CACHE_SIZE = 4;
+thread_local SigningKey signingKeyCache[SIGNING_KEY_CACHE_SIZE];
+thread_local size_t signingKeyCacheNext = 0;
+
+inline bool
+equals(const String &s, const char *in, size_t inLen)
+{
+  return s.length() == inLen && 0 == memcmp(s.data(), in, inLen);
+}
+
 /**
- * @brief Calculates the final signature based on the following parameters and base16 encodes it.
+ * @brief Derives the signing key, or gets it from the cache of the thread.
  *
  * signing key = HMAC-SHA256(HMAC-SHA256(HMAC-SHA256(HMAC-SHA256("AWS4" + "<awsSecret>", <dateTime>),
  *                   <awsRegion>), <awsService>),"aws4_request")
  *
+ * @return the signing key, nullptr if it could not be derived.
+ */
+const SigningKey *
+getSigningKey(const char *awsSecret, size_t awsSecretLen, const char *awsRegion, size_t awsRegionLen, const char *awsService,
+              size_t awsServiceLen, const char *dateTime, size_t dateTimeLen)
+{
+  for (const SigningKey &cached : signingKeyCache) {
+    if (cached.keyLen > 0 && equals(cached.date, dateTime, dateTimeLen) && equals(cached.region, awsRegion, awsRegionLen) &&
+        equals(cached.service, awsService, awsServiceLen) && equals(cached.secret, awsSecret, awsSecretLen)) {
+      return &cached;
+    }
+  }
+
+  unsigned int dateKeyLen = EVP_MAX_MD_SIZE;
+  unsigned char dateKey[EVP_MAX_MD_SIZE];
+  unsigned int dateRegionKeyLen = EVP_MAX_MD_SIZE;
+  unsigned char dateRegionKey[EVP_MAX_MD_SIZE];
+  unsigned int dateRegionServiceKeyLen = EVP_MAX_MD_SIZE;
+  unsigned char dateRegionServiceKey[EVP_MAX_MD_SIZE];
+
+  size_t keyLen = 4 + awsSecretLen;
+  char key[keyLen];
+  memcpy(key, "AWS4", 4);
+  memcpy(key + 4, awsSecret, awsSecretLen);
+
+  SigningKey &signingKey = signingKeyCache[signingKeyCacheNext];
+  signingKey.keyLen      = EVP_MAX_MD_SIZE;
+  if (!(HMAC(EVP_sha256(), key, keyLen, (unsigned char *)dateTime, dateTimeLen, dateKey, &dateKeyLen) &&
+        HMAC(EVP_sha256(), dateKey, dateKeyLen, (unsigned char *)awsRegion, awsRegionLen, dateRegionKey, &dateRegionKeyLen) &&
+        HMAC(EVP_sha256(), dateRegionKey, dateRegionKeyLen, (unsigned char *)awsService, awsServiceLen, dateRegionServiceKey,
+             &dateRegionServiceKeyLen) &&
+        HMAC(EVP_sha256(), dateRegionServiceKey, dateRegionServiceKeyLen, (unsigned char *)"aws4_request", 12, signingKey.key,
+             &signingKey.keyLen))) {
+    signingKey.keyLen = 0;
+    return nullptr;
+  }
+
+  signingKey.secret.assign(awsSecret, awsSecretLen);
+  signingKey.date.assign(dateTime, dateTimeLen);
+  signingKey.region.assign(awsRegion, awsRegionLen);
+  signingKey.service.assign(awsService, awsServiceLen);
+  signingKeyCacheNext = (signingKeyCacheNext + 1) % SIGNING_KEY_CACHE_SIZE;
+  return &signingKey;
+}
+} // namespace
+
+/**
+ * @brief Calculates the final signature based on the following parameters and base16 encodes it.
+ *
+ * signature = HMAC-SHA256(<signing key>, <stringToSign>), the signing key is derived once per day for a secret, region
+ * and service by every thread, see getSigningKey().
+ *
  * @see AWS spec: http://docs.aws.amazon.com/AmazonS3/latest/API/sig-v4-header-based-auth.html
  *
  * @param awsSecret AWS secret
@@ -637,29 +795,12 @@ getSignature(const char *awsSecret, size_t awsSecretLen, const char *awsRegion,
              size_t awsServiceLen, const char *dateTime, size_t dateTimeLen, const char *stringToSign, size_t stringToSignLen,
              char *signature, size_t signatureLen)
 {
-  unsigned int dateKeyLen = EVP_MAX_MD_SIZE;
-  unsigned char dateKey[EVP_MAX_MD_SIZE];
-  unsigned int dateRegionKeyLen = EVP_MAX_MD_SIZE;
-  unsigned char dateRegionKey[EVP_MAX_MD_SIZE];
-  unsigned int dateRegionServiceKeyLen = EVP_MAX_MD_SIZE;
-  unsigned char dateRegionServiceKey[EVP_MAX_MD_SIZE];
-  unsigned int signingKeyLen = EVP_MAX_MD_SIZE;
-  unsigned char signingKey[EVP_MAX_MD_SIZE];
-
-  size_t keyLen = 4 + awsSecretLen;
-  char key[keyLen];
-  memcpy(key, "AWS4", 4);
-  memcpy(key + 4, awsSecret, awsSecretLen);
+  const SigningKey *signingKey =
+    getSigningKey(awsSecret, awsSecretLen, awsRegion, awsRegionLen, awsService, awsServiceLen, dateTime, dateTimeLen);
 
   unsigned int len = signatureLen;
-  if (HMAC(EVP_sha256(), key, keyLen, (unsigned char *)dateTime, dateTimeLen, dateKey, &dateKeyLen) &&
-      HMAC(EVP_sha256(), dateKey, dateKeyLen, (unsigned char *)awsRegion, awsRegionLen, dateRegionKey, &dateRegionKeyLen) &&
-      HMAC(EVP_sha256(), dateRegionKey, dateRegionKeyLen, (unsigned char *)awsService, awsServiceLen, dateRegionServiceKey,
-           &dateRegionServiceKeyLen) &&
-      HMAC(EVP_sha256(), dateRegionServiceKey, dateRegionServiceKeyLen, (unsigned char *)"aws4_request", 12, signingKey,
-           &signingKeyLen) &&
-      HMAC(EVP_sha256(), signingKey, signingKeyLen, (unsigned char *)stringToSign, stringToSignLen, (unsigned char *)signature,
-           &len)) {
+  if (signingKey && HMAC(EVP_sha256(), signingKey->key, signingKey->keyLen, (unsigned char *)stringToSign, stringToSignLen,
+                         (unsigned char *)signature, &len)) {
     return len;
   }
 
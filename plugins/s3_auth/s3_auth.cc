@@ -737,7 +737,6 @@ TSHttpStatus
 S3Request::authorizeV2(S3Config *s3)
 {
   TSHttpStatus status = TS_HTTP_STATUS_INTERNAL_SERVER_ERROR;
-  TSMLoc host_loc = TS_NULL_MLOC, md5_loc = TS_NULL_MLOC, contype_loc = TS_NULL_MLOC;
   int method_len = 0, path_len = 0, param_len = 0, host_len = 0, con_md5_len = 0, con_type_len = 0, date_len = 0;
   const char *method = nullptr, *path = nullptr, *param = nullptr, *host = nullptr, *con_md5 = nullptr, *con_type = nullptr,
              *host_endp = nullptr;
@@ -767,12 +766,19 @@ S3Request::authorizeV2(S3Config *s3)
   // Add the Date: header to the request (this overwrites any existing Date header)
   set_header(TS_MIME_FIELD_DATE, TS_MIME_LEN_DATE, date, date_len);
 
+  // Get the Host:, Content-MD5: and Content-Type: headers in one go, (buggy) clients
+  // may send a Content-Type for GET requests too.
+  TSMimeHdrFieldValue fields[] = {{TS_MIME_FIELD_HOST, TS_MIME_LEN_HOST, nullptr, 0},
+                                  {TS_MIME_FIELD_CONTENT_MD5, TS_MIME_LEN_CONTENT_MD5, nullptr, 0},
+                                  {TS_MIME_FIELD_CONTENT_TYPE, TS_MIME_LEN_CONTENT_TYPE, nullptr, 0}};
+  TSMimeHdrFieldValuesGet(_bufp, _hdr_loc, fields, sizeof(fields) / sizeof(fields[0]));
+
   // If the configuration is a "virtual host" (foo.s3.aws ...), extract the
   // first portion into the Host: header.
   if (s3->virt_host()) {
-    host_loc = TSMimeHdrFieldFind(_bufp, _hdr_loc, TS_MIME_FIELD_HOST, TS_MIME_LEN_HOST);
-    if (host_loc) {
-      host      = TSMimeHdrFieldValueStringGet(_bufp, _hdr_loc, host_loc, -1, &host_len);
+    if (fields[0].value) {
+      host      = fields[0].value;
+      host_len  = fields[0].value_len;
       host_endp = static_cast<const char *>(memchr(host, '.', host_len));
     } else {
       return TS_HTTP_STATUS_INTERNAL_SERVER_ERROR;
@@ -780,17 +786,11 @@ S3Request::authorizeV2(S3Config *s3)
   }
 
   // Just in case we add Content-MD5 if present
-  md5_loc = TSMimeHdrFieldFind(_bufp, _hdr_loc, TS_MIME_FIELD_CONTENT_MD5, TS_MIME_LEN_CONTENT_MD5);
-  if (md5_loc) {
-    con_md5 = TSMimeHdrFieldValueStringGet(_bufp, _hdr_loc, md5_loc, -1, &con_md5_len);
-  }
+  con_md5     = fields[1].value;
+  con_md5_len = fields[1].value_len;
 
-  // get the Content-Type if available - (buggy) clients may send it
-  // for GET requests too
-  contype_loc = TSMimeHdrFieldFind(_bufp, _hdr_loc, TS_MIME_FIELD_CONTENT_TYPE, TS_MIME_LEN_CONTENT_TYPE);
-  if (contype_loc) {
-    con_type = TSMimeHdrFieldValueStringGet(_bufp, _hdr_loc, contype_loc, -1, &con_type_len);
-  }
+  con_type     = fields[2].value;
+  con_type_len = fields[2].value_len;
 
   // For debugging, lets produce some nice output
   if (TSIsDebugTagSet(PLUGIN_NAME)) {
@@ -882,11 +882,6 @@ S3Request::authorizeV2(S3Config *s3)
     }
   }
 
-  // Cleanup
-  TSHandleMLocRelease(_bufp, _hdr_loc, contype_loc);
-  TSHandleMLocRelease(_bufp, _hdr_loc, md5_loc);
-  TSHandleMLocRelease(_bufp, _hdr_loc, host_loc);
-
   return status;
 }
 
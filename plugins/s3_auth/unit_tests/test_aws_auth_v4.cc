@@ -992,3 +992,68 @@ TEST_CASE("S3AuthV4UtilParams: include missing content type", "[AWS][auth][utili
 
   ValidateBenchCanonicalRequest(api, /*signePayload */ false, &now, bench, include, exclude);
 }
+
+/*
+ * The canonical header names are lower-case no matter how the request spells them.
+ */
+TEST_CASE("S3AuthV4UtilParams: header names in mixed case", "[AWS][auth][utility]")
+{
+  time_t now = 1369353600; /* 5/24/2013 00:00:00 GMT */
+
+  /* Define the HTTP request elements */
+  MockTsInterface api;
+  api._method.assign("GET");
+  api._host.assign("examplebucket.s3.amazonaws.com");
+  api._path.assign("");
+  api._query.assign("max-keys=2&prefix=J");
+  api._headers["HOST"]                 = "examplebucket.s3.amazonaws.com";
+  api._headers["X-Amz-Content-Sha256"] = "UNSIGNED-PAYLOAD";
+  api._headers["X-AMZ-DATE"]           = "20130524T000000Z";
+
+  const char *bench[] = {
+    /* Signed Headers */
+    "host;x-amz-content-sha256;x-amz-date",
+    /* Canonical Request sha256 */
+    "528623330c85041d6fb82795b6f8d5771825d3568b9f0bc1faa8a49e1f5f9cfc",
+  };
+
+  ValidateBenchCanonicalRequest(api, /*signePayload */ false, &now, bench, defaultIncludeHeaders, defaultExcludeHeaders);
+}
+
+/*
+ * The signing keys derived for other days, regions and secrets in between don't change the signature.
+ */
+TEST_CASE("S3AuthV4SigningKey: signing keys of other days, regions and secrets", "[AWS][auth][utility]")
+{
+  const String stringToSign = "AWS4-HMAC-SHA256\n"
+                              "20130524T000000Z\n"
+                              "20130524/us-east-1/s3/aws4_request\n"
+                              "7344ae5b7ee6c3e7e6b0fe0640412a37625d1fbfff95c48bbb2dc43964946972";
+  const char *bench = "f0e8bdb87c964420e857bd35b5d6ed310bd44f0170aba48dd91039c6036bdb41";
+
+  char signature[EVP_MAX_MD_SIZE];
+  size_t signatureLen = getSignature(awsSecretAccessKey, strlen(awsSecretAccessKey), "us-east-1", 9, awsService,
+                                     strlen(awsService), "20130524", 8, stringToSign.c_str(), stringToSign.length(), signature,
+                                     EVP_MAX_MD_SIZE);
+  CHECK_FALSE(base16Encode(signature, signatureLen).compare(bench));
+
+  const char *regions[] = {"us-west-1", "us-west-2", "eu-west-1", "eu-west-2", "ap-south-1", "sa-east-1"};
+  for (const char *region : regions) {
+    signatureLen = getSignature(awsSecretAccessKey, strlen(awsSecretAccessKey), region, strlen(region), awsService,
+                                strlen(awsService), "20130524", 8, stringToSign.c_str(), stringToSign.length(), signature,
+                                EVP_MAX_MD_SIZE);
+    CHECK(base16Encode(signature, signatureLen).compare(bench));
+  }
+
+  signatureLen = getSignature(awsSecretAccessKey, strlen(awsSecretAccessKey), "us-east-1", 9, awsService, strlen(awsService),
+                              "20130525", 8, stringToSign.c_str(), stringToSign.length(), signature, EVP_MAX_MD_SIZE);
+  CHECK(base16Encode(signature, signatureLen).compare(bench));
+
+  signatureLen = getSignature("otherSecret", 11, "us-east-1", 9, awsService, strlen(awsService), "20130524", 8,
+                              stringToSign.c_str(), stringToSign.length(), signature, EVP_MAX_MD_SIZE);
+  CHECK(base16Encode(signature, signatureLen).compare(bench));
+
+  signatureLen = getSignature(awsSecretAccessKey, strlen(awsSecretAccessKey), "us-east-1", 9, awsService, strlen(awsService),
+                              "20130524", 8, stringToSign.c_str(), stringToSign.length(), signature, EVP_MAX_MD_SIZE);
+  CHECK_FALSE(base16Encode(signature, signatureLen).compare(bench));
+}
@@ -45,6 +45,19 @@ static int url_path_len;
 static bool integer_counters = false;
 static bool wrap_counters    = false;
 
+/* the OpenMetrics exposition is served on this path below url_path */
+static const char OPENMETRICS_PATH[] = "/metrics";
+
+/* milliseconds between two OpenMetrics snapshots */
+static int openmetrics_interval = 1000;
+
+/* The last OpenMetrics snapshot. A scrape clones the blocks of the snapshot
+   into its response, rather than format the records, and a new snapshot
+   replaces the buffer, so the blocks are never written again. */
+static TSMutex snapshot_mutex;
+static TSIOBuffer snapshot_buffer;
+static TSIOBufferReader snapshot_reader;
+
 typedef struct stats_state_t {
   TSVConn net_vc;
   TSVIO read_vio;
@@ -56,6 +69,7 @@ typedef struct stats_state_t {
 
   int output_bytes;
   int body_written;
+  bool openmetrics;
 } stats_state;
 
 static void
@@ -95,11 +109,13 @@ stats_add_data_to_resp_buffer(const char *s, stats_state *my_state)
 }
 
 static const char RESP_HEADER[] = "HTTP/1.0 200 Ok\r\nContent-Type: text/javascript\r\nCache-Control: no-cache\r\n\r\n";
+static const char OPENMETRICS_RESP_HEADER[] = "HTTP/1.0 200 Ok\r\nContent-Type: application/openmetrics-text; version=1.0.0; "
+                                              "charset=utf-8\r\nCache-Control: no-cache\r\n\r\n";
 
 static int
 stats_add_resp_header(stats_state *my_state)
 {
-  return stats_add_data_to_resp_buffer(RESP_HEADER, my_state);
+  return stats_add_data_to_resp_buffer(my_state->openmetrics ? OPENMETRICS_RESP_HEADER : RESP_HEADER, my_state);
 }
 
 static void
@@ -194,6 +210,271 @@ json_out_stats(stats_state *my_state)
   APPEND("  }\n}\n");
 }
 
+/* One sample of the OpenMetrics exposition. The samples are sorted by family,
+   since all the samples of a family have to be together. */
+typedef struct om_sample_t {
+  char family[256];
+  char sample[256];
+  char labels[128];
+  char value[32];
+  bool summary;
+  int summary_tail; /* the length of the _count or _sum of the family of a summary */
+} om_sample;
+
+typedef struct om_samples_t {
+  om_sample *samples;
+  int count;
+  int size;
+} om_samples;
+
+static const struct {
+  const char *suffix;
+  const char *quantile;
+} om_quantiles[] = {{"p50", "0.5"}, {"p90", "0.9"}, {"p99", "0.99"}, {"p999", "0.999"}};
+
+/* The segments of a record name that are a label, with the value in the same segment. */
+static const char *om_label_prefixes[] = {"volume_"};
+/* The segments of a record name that are a label, with the value in the next segment. */
+static const char *om_label_segments[] = {"thread", "port"};
+
+static bool
+om_is_number(const char *s, int len)
+{
+  if (len <= 0) {
+    return false;
+  }
+  for (int i = 0; i < len; ++i) {
+    if (!isdigit((unsigned char)s[i])) {
+      return false;
+    }
+  }
+  return true;
+}
+
+static void
+om_add_label(char *labels, size_t size, const char *name, int name_len, const char *value, int value_len)
+{
+  size_t len = strlen(labels);
+  snprintf(labels + len, size - len, "%s%.*s=\"%.*s\"", len ? "," : "", name_len, name, value_len, value);
+}
+
+static void
+om_add_family_segment(char *family, size_t size, const char *segment, int len)
+{
+  size_t used = strlen(family);
+  if (used && used + 1 < size) {
+    family[used++] = '_';
+    family[used]   = '\0';
+  }
+  for (int i = 0; i < len && used + 1 < size; ++i) {
+    char c         = segment[i];
+    family[used++] = (isalnum((unsigned char)c) || c == '_' || c == ':') ? c : '_';
+  }
+  family[used] = '\0';
+}
+
+/* Split the record @a name in the name of its family and its labels. */
+static void
+om_parse_name(const char *name, om_sample *s)
+{
+  const char *seg = name;
+
+  s->family[0]    = '\0';
+  s->labels[0]    = '\0';
+  s->summary      = false;
+  s->summary_tail = 0;
+
+  while (seg) {
+    const char *dot = strchr(seg, '.');
+    int len         = dot ? dot - seg : (int)strlen(seg);
+    bool label      = false;
+
+    for (size_t i = 0; i < sizeof(om_label_prefixes) / sizeof(om_label_prefixes[0]) && !label; ++i) {
+      int plen = strlen(om_label_prefixes[i]);
+      if (len > plen && !strncmp(seg, om_label_prefixes[i], plen) && om_is_number(seg + plen, len - plen)) {
+        om_add_label(s->labels, sizeof(s->labels), seg, plen - 1, seg + plen, len - plen);
+        label = true;
+      }
+    }
+    for (size_t i = 0; i < sizeof(om_label_segments) / sizeof(om_label_segments[0]) && !label && dot; ++i) {
+      const char *next     = dot + 1;
+      const char *next_dot = strchr(next, '.');
+      int next_len         = next_dot ? next_dot - next : (int)strlen(next);
+      if (len == (int)strlen(om_label_segments[i]) && !strncmp(seg, om_label_segments[i], len) && om_is_number(next, next_len)) {
+        om_add_label(s->labels, sizeof(s->labels), seg, len, next, next_len);
+        dot   = next_dot;
+        label = true;
+      }
+    }
+    if (!label && !dot) {
+      /* the percentiles of a histogram are the quantiles of a summary */
+      for (size_t i = 0; i < sizeof(om_quantiles) / sizeof(om_quantiles[0]) && !label; ++i) {
+        if (!strcmp(seg, om_quantiles[i].suffix) && s->family[0]) {
+          om_add_label(s->labels, sizeof(s->labels), "quantile", 8, om_quantiles[i].quantile, strlen(om_quantiles[i].quantile));
+          s->summary = true;
+          label      = true;
+        }
+      }
+    }
+    if (!label) {
+      om_add_family_segment(s->family, sizeof(s->family), seg, len);
+    }
+    seg = dot ? dot + 1 : NULL;
+  }
+
+  snprintf(s->sample, sizeof(s->sample), "%s", s->family);
+}
+
+static void
+om_collect(TSRecordType rec_type ATS_UNUSED, void *edata, int registered ATS_UNUSED, const char *name, TSRecordDataType data_type,
+           TSRecordData *datum)
+{
+  om_samples *samples = edata;
+  om_sample *s;
+
+  if (samples->count == samples->size) {
+    samples->size    = samples->size ? samples->size * 2 : 1024;
+    samples->samples = TSrealloc(samples->samples, samples->size * sizeof(om_sample));
+  }
+  s = &samples->samples[samples->count];
+
+  switch (data_type) {
+  case TS_RECORDDATATYPE_COUNTER:
+    snprintf(s->value, sizeof(s->value), "%" PRIu64, wrap_unsigned_counter(datum->rec_counter));
+    break;
+  case TS_RECORDDATATYPE_INT:
+    snprintf(s->value, sizeof(s->value), "%" PRIu64, wrap_unsigned_counter(datum->rec_int));
+    break;
+  case TS_RECORDDATATYPE_FLOAT:
+    snprintf(s->value, sizeof(s->value), "%.17g", datum->rec_float);
+    break;
+  default:
+    /* OpenMetrics has no strings */
+    return;
+  }
+
+  om_parse_name(name, s);
+  ++samples->count;
+}
+
+static int
+om_compare(const void *a, const void *b)
+{
+  const om_sample *sa = a;
+  const om_sample *sb = b;
+  int c               = strcmp(sa->family, sb->family);
+
+  if (c == 0) {
+    c = strcmp(sa->sample, sb->sample);
+  }
+  if (c == 0) {
+    c = strcmp(sa->labels, sb->labels);
+  }
+  return c;
+}
+
+static int
+om_compare_family(const void *key, const void *elt)
+{
+  return strcmp(key, ((const om_sample *)elt)->family);
+}
+
+/* Build an OpenMetrics exposition of all the records. */
+static TSIOBuffer
+openmetrics_build(void)
+{
+  om_samples samples = {NULL, 0, 0};
+  TSIOBuffer buffer  = TSIOBufferCreate();
+  char line[512];
+
+  TSRecordDump((TSRecordType)(TS_RECORDTYPE_PLUGIN | TS_RECORDTYPE_NODE | TS_RECORDTYPE_PROCESS), om_collect, &samples);
+  qsort(samples.samples, samples.count, sizeof(om_sample), om_compare);
+
+  /* The .count and .sum records of a histogram are the _count and _sum of its summary. They are
+     found first and moved to the family of the summary after, to keep the samples sorted meanwhile. */
+  for (int i = 0; i < samples.count; ++i) {
+    om_sample *s = &samples.samples[i];
+    size_t len   = strlen(s->family);
+    for (int suffix = 0; suffix < 2 && !s->summary; ++suffix) {
+      const char *tail = suffix ? "_sum" : "_count";
+      size_t tail_len  = strlen(tail);
+      if (len > tail_len && !strcmp(s->family + len - tail_len, tail)) {
+        char base[256];
+        snprintf(base, sizeof(base), "%.*s", (int)(len - tail_len), s->family);
+        om_sample *q = bsearch(base, samples.samples, samples.count, sizeof(om_sample), om_compare_family);
+        if (q && q->summary) {
+          s->summary_tail = tail_len;
+        }
+      }
+    }
+  }
+  for (int i = 0; i < samples.count; ++i) {
+    om_sample *s = &samples.samples[i];
+    if (s->summary_tail) {
+      s->family[strlen(s->family) - s->summary_tail] = '\0';
+      s->summary                                     = true;
+    }
+  }
+  qsort(samples.samples, samples.count, sizeof(om_sample), om_compare);
+
+  for (int i = 0; i < samples.count; ++i) {
+    om_sample *s = &samples.samples[i];
+    int len;
+    if (i == 0 || strcmp(s->family, samples.samples[i - 1].family)) {
+      len = snprintf(line, sizeof(line), "# TYPE %s %s\n", s->family, s->summary ? "summary" : "unknown");
+      TSIOBufferWrite(buffer, line, len < (int)sizeof(line) ? len : (int)sizeof(line) - 1);
+    }
+    if (s->labels[0]) {
+      len = snprintf(line, sizeof(line), "%s{%s} %s\n", s->sample, s->labels, s->value);
+    } else {
+      len = snprintf(line, sizeof(line), "%s %s\n", s->sample, s->value);
+    }
+    TSIOBufferWrite(buffer, line, len < (int)sizeof(line) ? len : (int)sizeof(line) - 1);
+  }
+  TSIOBufferWrite(buffer, "# EOF\n", 6);
+
+  TSfree(samples.samples);
+  return buffer;
+}
+
+static void
+openmetrics_snapshot_set(TSIOBuffer buffer)
+{
+  TSIOBuffer old_buffer;
+
+  TSMutexLock(snapshot_mutex);
+  old_buffer      = snapshot_buffer;
+  snapshot_buffer = buffer;
+  snapshot_reader = TSIOBufferReaderAlloc(buffer);
+  TSMutexUnlock(snapshot_mutex);
+
+  /* The responses still hold the blocks they cloned. */
+  if (old_buffer) {
+    TSIOBufferDestroy(old_buffer);
+  }
+}
+
+static int
+openmetrics_snapshot(TSCont contp ATS_UNUSED, TSEvent event ATS_UNUSED, void *edata ATS_UNUSED)
+{
+  openmetrics_snapshot_set(openmetrics_build());
+  return 0;
+}
+
+static void
+openmetrics_out_stats(stats_state *my_state)
+{
+  TSMutexLock(snapshot_mutex);
+  if (!snapshot_buffer) {
+    /* The first scrape comes before the first snapshot. */
+    TSMutexUnlock(snapshot_mutex);
+    openmetrics_snapshot_set(openmetrics_build());
+    TSMutexLock(snapshot_mutex);
+  }
+  my_state->output_bytes += TSIOBufferCopy(my_state->resp_buffer, snapshot_reader, TSIOBufferReaderAvail(snapshot_reader), 0);
+  TSMutexUnlock(snapshot_mutex);
+}
+
 static void
 stats_process_write(TSCont contp, TSEvent event, stats_state *my_state)
 {
@@ -201,7 +482,11 @@ stats_process_write(TSCont contp, TSEvent event, stats_state *my_state)
     if (my_state->body_written == 0) {
       TSDebug(PLUGIN_NAME, "plugin adding response body");
       my_state->body_written = 1;
-      json_out_stats(my_state);
+      if (my_state->openmetrics) {
+        openmetrics_out_stats(my_state);
+      } else {
+        json_out_stats(my_state);
+      }
       TSVIONBytesSet(my_state->write_vio, my_state->output_bytes);
     }
     TSVIOReenable(my_state->write_vio);
@@ -255,7 +540,9 @@ stats_origin(TSCont contp ATS_UNUSED, TSEvent event ATS_UNUSED, void *edata)
   const char *path = TSUrlPathGet(reqp, url_loc, &path_len);
   TSDebug(PLUGIN_NAME, "Path: %.*s", path_len, path);
 
-  if (!(path_len != 0 && path_len == url_path_len && !memcmp(path, url_path, url_path_len))) {
+  bool openmetrics = path_len == url_path_len + (int)sizeof(OPENMETRICS_PATH) - 1 && !memcmp(path, url_path, url_path_len) &&
+                     !memcmp(path + url_path_len, OPENMETRICS_PATH, sizeof(OPENMETRICS_PATH) - 1);
+  if (!openmetrics && !(path_len != 0 && path_len == url_path_len && !memcmp(path, url_path, url_path_len))) {
     goto notforme;
   }
 
@@ -267,6 +554,7 @@ stats_origin(TSCont contp ATS_UNUSED, TSEvent event ATS_UNUSED, void *edata)
   icontp   = TSContCreate(stats_dostuff, TSMutexCreate());
   my_state = (stats_state *)TSmalloc(sizeof(*my_state));
   memset(my_state, 0, sizeof(*my_state));
+  my_state->openmetrics = openmetrics;
   TSContDataSet(icontp, my_state);
   TSHttpTxnIntercept(icontp, txnp);
   goto cleanup;
@@ -290,9 +578,10 @@ TSPluginInit(int argc, const char *argv[])
 {
   TSPluginRegistrationInfo info;
 
-  static const char usage[]             = PLUGIN_NAME ".so [--integer-counters] [PATH]";
+  static const char usage[] = PLUGIN_NAME ".so [--integer-counters] [--wrap-counters] [--openmetrics-interval MSECS] [PATH]";
   static const struct option longopts[] = {{(char *)("integer-counters"), no_argument, NULL, 'i'},
                                            {(char *)("wrap-counters"), no_argument, NULL, 'w'},
+                                           {(char *)("openmetrics-interval"), required_argument, NULL, 'm'},
                                            {NULL, 0, NULL, 0}};
 
   info.plugin_name   = PLUGIN_NAME;
@@ -304,13 +593,20 @@ TSPluginInit(int argc, const char *argv[])
   }
 
   for (;;) {
-    switch (getopt_long(argc, (char *const *)argv, "iw", longopts, NULL)) {
+    switch (getopt_long(argc, (char *const *)argv, "iwm:", longopts, NULL)) {
     case 'i':
       integer_counters = true;
       break;
     case 'w':
       wrap_counters = true;
       break;
+    case 'm':
+      openmetrics_interval = atoi(optarg);
+      if (openmetrics_interval <= 0) {
+        TSError("[%s] invalid --openmetrics-interval %s, using 1000", PLUGIN_NAME, optarg);
+        openmetrics_interval = 1000;
+      }
+      break;
     case -1:
       goto init;
     default:
@@ -330,5 +626,9 @@ init:
   /* Create a continuation with a mutex as there is a shared global structure
      containing the headers to add */
   TSHttpHookAdd(TS_HTTP_READ_REQUEST_HDR_HOOK, TSContCreate(stats_origin, TSMutexCreate()));
+
+  /* The snapshots are built on a task thread, away from the scrapes. */
+  snapshot_mutex = TSMutexCreate();
+  TSContScheduleEveryOnPool(TSContCreate(openmetrics_snapshot, TSMutexCreate()), openmetrics_interval, TS_THREAD_POOL_TASK);
   TSDebug(PLUGIN_NAME, "stats module registered");
 }
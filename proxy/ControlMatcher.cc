@@ -374,10 +374,13 @@ RegexMatcher<Data, MatchResult>::RegexMatcher(const char *name, const char *file
 template <class Data, class MatchResult> RegexMatcher<Data, MatchResult>::~RegexMatcher()
 {
   for (int i = 0; i < num_el; i++) {
+    pcre_free_study(re_extra[i]);
     pcre_free(re_array[i]);
     ats_free(re_str[i]);
   }
   delete[] re_str;
+  delete[] re_literals;
+  ats_free(re_extra);
   ats_free(re_array);
 }
 
@@ -410,6 +413,11 @@ RegexMatcher<Data, MatchResult>::AllocateSpace(int num_entries)
   re_array = (pcre **)ats_malloc(sizeof(pcre *) * num_entries);
   memset(re_array, 0, sizeof(pcre *) * num_entries);
 
+  re_extra = (pcre_extra **)ats_malloc(sizeof(pcre_extra *) * num_entries);
+  memset(re_extra, 0, sizeof(pcre_extra *) * num_entries);
+
+  re_literals = new std::string[num_entries];
+
   data_array = new Data[num_entries];
 
   re_str = new char *[num_entries];
@@ -430,7 +438,8 @@ RegexMatcher<Data, MatchResult>::NewEntry(matcher_line *line_info)
   char *pattern;
   const char *errptr;
   int erroffset;
-  Result error = Result::ok();
+  int study_opts = 0;
+  Result error   = Result::ok();
 
   // Make sure space has been allocated
   ink_assert(num_el >= 0);
@@ -450,7 +459,12 @@ RegexMatcher<Data, MatchResult>::NewEntry(matcher_line *line_info)
     return Result::failure("%s regular expression error at line %d position %d : %s", matcher_name, line_info->line_num, erroffset,
                            errptr);
   }
-  re_str[num_el] = ats_strdup(pattern);
+#ifdef PCRE_CONFIG_JIT
+  study_opts |= PCRE_STUDY_JIT_COMPILE;
+#endif
+  re_extra[num_el]    = pcre_study(re_array[num_el], study_opts, &errptr);
+  re_str[num_el]      = ats_strdup(pattern);
+  re_literals[num_el] = Regex::required_literal(pattern);
 
   // Remove our consumed label from the parsed line
   line_info->line[0][line_info->dest_entry] = nullptr;
@@ -464,6 +478,9 @@ RegexMatcher<Data, MatchResult>::NewEntry(matcher_line *line_info)
     // There was a problem so undo the effects this function
     ats_free(re_str[num_el]);
     re_str[num_el] = nullptr;
+    re_literals[num_el].clear();
+    pcre_free_study(re_extra[num_el]);
+    re_extra[num_el] = nullptr;
     pcre_free(re_array[num_el]);
     re_array[num_el] = nullptr;
   } else {
@@ -473,18 +490,46 @@ RegexMatcher<Data, MatchResult>::NewEntry(matcher_line *line_info)
   return error;
 }
 
+//
+// void RegexMatcher<Data,MatchResult>::MatchString(const char* str, RequestData* rdata, MatchResult* result)
+//
+//   Conducts a linear search through the regex array and
+//     updates arg result for each regex that matches arg str.
+//     A regex is only run if str contains its required literal,
+//     which rules out most of them with a plain string search
+//
+template <class Data, class MatchResult>
+void
+RegexMatcher<Data, MatchResult>::MatchString(const char *str, RequestData *rdata, MatchResult *result)
+{
+  std::string_view subject(str);
+  int r;
+
+  for (int i = 0; i < num_el; i++) {
+    if (!re_literals[i].empty() && subject.find(re_literals[i]) == std::string_view::npos) {
+      continue;
+    }
+    r = pcre_exec(re_array[i], re_extra[i], subject.data(), subject.size(), 0, 0, nullptr, 0);
+    if (r > -1) {
+      Debug("matcher", "%s Matched %s with regex at line %d", matcher_name, str, data_array[i].line_num);
+      data_array[i].UpdateMatch(result, rdata);
+    } else if (r < -1) {
+      // An error has occured
+      Warning("Error [%d] matching regex at line %d.", r, data_array[i].line_num);
+    } // else it's -1 which means no match was found.
+  }
+}
+
 //
 // void RegexMatcher<Data,MatchResult>::Match(RequestData* rdata, MatchResult* result)
 //
-//   Coduncts a linear search through the regex array and
-//     updates arg result for each regex that matches arg URL
+//   Matches the regexs against the URL of arg rdata
 //
 template <class Data, class MatchResult>
 void
 RegexMatcher<Data, MatchResult>::Match(RequestData *rdata, MatchResult *result)
 {
   char *url_str;
-  int r;
 
   // Check to see there is any work to before we copy the
   //   URL
@@ -504,16 +549,7 @@ RegexMatcher<Data, MatchResult>::Match(RequestData *rdata, MatchResult *result)
   // HttpRequestData::get_string(); therefore, no need to call again here.
   // unescapifyStr(url_str);
 
-  for (int i = 0; i < num_el; i++) {
-    r = pcre_exec(re_array[i], nullptr, url_str, strlen(url_str), 0, 0, nullptr, 0);
-    if (r > -1) {
-      Debug("matcher", "%s Matched %s with regex at line %d", matcher_name, url_str, data_array[i].line_num);
-      data_array[i].UpdateMatch(result, rdata);
-    } else if (r < -1) {
-      // An error has occured
-      Warning("Error [%d] matching regex at line %d.", r, data_array[i].line_num);
-    } // else it's -1 which means no match was found.
-  }
+  MatchString(url_str, rdata, result);
   ats_free(url_str);
 }
 
@@ -529,15 +565,13 @@ HostRegexMatcher<Data, MatchResult>::HostRegexMatcher(const char *name, const ch
 //
 // void HostRegexMatcher<Data,MatchResult>::Match(RequestData* rdata, MatchResult* result)
 //
-//   Conducts a linear search through the regex array and
-//     updates arg result for each regex that matches arg host_regex
+//   Matches the regexs against the host of arg rdata
 //
 template <class Data, class MatchResult>
 void
 HostRegexMatcher<Data, MatchResult>::Match(RequestData *rdata, MatchResult *result)
 {
   const char *url_str;
-  int r;
 
   // Check to see there is any work to before we copy the
   //   URL
@@ -552,17 +586,7 @@ HostRegexMatcher<Data, MatchResult>::Match(RequestData *rdata, MatchResult *resu
   if (url_str == nullptr) {
     url_str = "";
   }
-  for (int i = 0; i < this->num_el; i++) {
-    r = pcre_exec(this->re_array[i], nullptr, url_str, strlen(url_str), 0, 0, nullptr, 0);
-    if (r != -1) {
-      Debug("matcher", "%s Matched %s with regex at line %d", const_cast<char *>(this->matcher_name), url_str,
-            this->data_array[i].line_num);
-      this->data_array[i].UpdateMatch(result, rdata);
-    } else {
-      // An error has occured
-      Warning("error matching regex at line %d", this->data_array[i].line_num);
-    }
-  }
+  this->MatchString(url_str, rdata, result);
 }
 
 //
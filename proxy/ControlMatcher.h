@@ -219,8 +219,13 @@ public:
   using super::array_len;
 
 protected:
-  pcre **re_array = nullptr; // array of compiled regexs
-  char **re_str   = nullptr; // array of uncompiled regex strings
+  /// Run the regexs against @a str and update @a result for each one that matches.
+  void MatchString(const char *str, RequestData *rdata, MatchResult *result);
+
+  pcre **re_array          = nullptr; // array of compiled regexs
+  pcre_extra **re_extra    = nullptr; // array of the study data of the regexs, JIT compiled if available
+  char **re_str            = nullptr; // array of uncompiled regex strings
+  std::string *re_literals = nullptr; // array of strings a match must contain, empty if none is known
 };
 
 template <class Data, class MatchResult> class HostRegexMatcher : public RegexMatcher<Data, MatchResult>
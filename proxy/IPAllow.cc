@@ -26,6 +26,7 @@
 
 #include <sstream>
 #include "IPAllow.h"
+#include "I_Net.h"
 #include "tscore/BufferWriter.h"
 
 extern char *readIntoBuffer(const char *file_path, const char *module_name, int *read_size_ptr);
@@ -83,10 +84,39 @@ IpAllow::reconfigure()
   new_table->BuildTable();
 
   configid = configProcessor.set(configid, new_table);
+  updateDenyFilter();
 
   Note("ip_allow.config finished loading");
 }
 
+void
+IpAllow::updateDenyFilter()
+{
+  std::vector<std::pair<uint32_t, uint32_t>> ranges;
+  self_type *self = configid ? acquire() : nullptr;
+
+  // The same records match() denies right away, remap rules can not allow them again.
+  if (self && accept_check_p) {
+    for (auto &spot : self->_src_map) {
+      Record const *r = static_cast<Record const *>(spot.data());
+      if (r->_method_mask != 0 || !r->_nonstandard_methods.empty() || !ats_is_ip4(spot.min())) {
+        continue;
+      }
+      uint32_t min = ntohl(ats_ip4_addr_cast(spot.min()));
+      uint32_t max = ntohl(ats_ip4_addr_cast(spot.max()));
+      if (!ranges.empty() && ranges.back().second + 1 == min) {
+        ranges.back().second = max;
+      } else {
+        ranges.emplace_back(min, max);
+      }
+    }
+  }
+  if (self) {
+    self->release();
+  }
+  ink_net_set_deny_filter(ranges);
+}
+
 IpAllow *
 IpAllow::acquire()
 {
@@ -340,6 +370,9 @@ IpAllow::BuildTable()
     for (auto &item : _dst_map) {
       item.setData(&_dst_acls[reinterpret_cast<size_t>(item.data())]);
     }
+    // Every connection is checked against the maps, which no longer change.
+    _src_map.freeze();
+    _dst_map.freeze();
   }
 
   if (is_debug_tag_set("ip-allow")) {
@@ -166,6 +166,9 @@ public:
    */
   static bool isAcceptCheckEnabled();
 
+  /// Have the listen sockets drop the sources that are denied at accept, see ink_net_set_deny_filter().
+  static void updateDenyFilter();
+
 private:
   static size_t configid;               ///< Configuration ID for update management.
   static const Record ALLOW_ALL_RECORD; ///< Static record that allows all access.
@@ -295,6 +298,9 @@ IpAllow::enableAcceptCheck(bool state)
 {
   bool temp      = accept_check_p;
   accept_check_p = state;
+  if (temp != state) {
+    updateDenyFilter();
+  }
   return temp;
 }
 
@@ -183,8 +183,11 @@ ParentConsistentHash::selectParent(bool first_call, ParentResult *result, Reques
     }
   }
 
-  // Do the initial parent look-up.
-  path_hash = getPathHash(request_info, (ATSHash64 *)&hash);
+  // Do the initial parent look-up. The request is only hashed once, nextParent() reuses the hash.
+  if (firstCall || result->chash_path_hash == 0) {
+    result->chash_path_hash = getPathHash(request_info, (ATSHash64 *)&hash);
+  }
+  path_hash = result->chash_path_hash;
   fhash     = chash[last_lookup];
   do { // search until we've selected a different parent if !firstCall
     prtmp = (pRecord *)chash_lookup(fhash, path_hash, &result->chashIter[last_lookup], &wrap_around[last_lookup], &hash,
@@ -44,6 +44,9 @@ ParentRoundRobin::ParentRoundRobin(ParentRecord *parent_record, ParentRR_t _roun
     case P_LATCHED_ROUND_ROBIN:
       Debug("parent_select", "Using a round robin parent selection strategy of type P_LATCHED_ROUND_ROBIN.");
       break;
+    case P_LATENCY_ROUND_ROBIN:
+      Debug("parent_select", "Using a round robin parent selection strategy of type P_LATENCY_ROUND_ROBIN.");
+      break;
     default:
       // should never see this, there is a problem if you do.
       Debug("parent_select", "Using a round robin parent selection strategy of type UNKNOWN TYPE.");
@@ -108,6 +111,9 @@ ParentRoundRobin::selectParent(bool first_call, ParentResult *result, RequestDat
       case P_LATCHED_ROUND_ROBIN:
         cur_index = result->start_parent = latched_parent;
         break;
+      case P_LATENCY_ROUND_ROBIN:
+        cur_index = result->start_parent = latencyChoice(result);
+        break;
       default:
         ink_release_assert(0);
       }
@@ -193,6 +199,30 @@ ParentRoundRobin::selectParent(bool first_call, ParentResult *result, RequestDat
   result->port     = 0;
 }
 
+// Pick two parents and keep the one with the lower response time, so that slow parents get less
+// traffic well before they fail. Comparing two random parents instead of looking for the fastest
+// avoids sending all the traffic to the same parent until its average catches up. A parent that
+// was never measured wins, so that each one gets measured.
+int
+ParentRoundRobin::latencyChoice(ParentResult *result)
+{
+  uint32_t n = ink_atomic_increment(&result->rec->rr_next, 1);
+
+  if (num_parents < 2) {
+    return 0;
+  }
+
+  int first  = n % num_parents;
+  int second = (first + 1 + (n * 2654435761u >> 8) % (num_parents - 1)) % num_parents;
+
+  int64_t first_latency  = parents[first].latency;
+  int64_t second_latency = parents[second].latency;
+  Debug("parent_select", "latency choice between %s (%" PRId64 "us) and %s (%" PRId64 "us)", parents[first].hostname,
+        first_latency, parents[second].hostname, second_latency);
+
+  return (second_latency < first_latency) ? second : first;
+}
+
 uint32_t
 ParentRoundRobin::numParents(ParentResult *result) const
 {
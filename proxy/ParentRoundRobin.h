@@ -38,6 +38,8 @@ class ParentRoundRobin : public ParentSelectionStrategy
   pRecord *parents;
   int num_parents;
 
+  int latencyChoice(ParentResult *result);
+
 public:
   ParentRoundRobin(ParentRecord *_parent_record, ParentRR_t _round_robin_type);
   ~ParentRoundRobin() override;
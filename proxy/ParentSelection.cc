@@ -496,6 +496,7 @@ ParentRecord::ProcessParents(char *val, bool isPrimary)
       this->parents[i].name                    = this->parents[i].hostname;
       this->parents[i].available               = true;
       this->parents[i].weight                  = weight;
+      this->parents[i].latency                 = 0;
       if (tmp3) {
         memcpy(this->parents[i].hash_string, tmp3 + 1, strlen(tmp3));
         this->parents[i].name = this->parents[i].hash_string;
@@ -515,6 +516,7 @@ ParentRecord::ProcessParents(char *val, bool isPrimary)
       this->secondary_parents[i].name                    = this->secondary_parents[i].hostname;
       this->secondary_parents[i].available               = true;
       this->secondary_parents[i].weight                  = weight;
+      this->secondary_parents[i].latency                 = 0;
       if (tmp3) {
         memcpy(this->secondary_parents[i].hash_string, tmp3 + 1, strlen(tmp3));
         this->secondary_parents[i].name = this->secondary_parents[i].hash_string;
@@ -633,6 +635,8 @@ ParentRecord::Init(matcher_line *line_info)
         round_robin = P_CONSISTENT_HASH;
       } else if (strcasecmp(val, "latched") == 0) {
         round_robin = P_LATCHED_ROUND_ROBIN;
+      } else if (strcasecmp(val, "latency") == 0) {
+        round_robin = P_LATENCY_ROUND_ROBIN;
       } else {
         round_robin = P_NO_ROUND_ROBIN;
         errPtr      = "invalid argument to round_robin directive";
@@ -773,6 +777,7 @@ ParentRecord::Init(matcher_line *line_info)
   case P_STRICT_ROUND_ROBIN:
   case P_HASH_ROUND_ROBIN:
   case P_LATCHED_ROUND_ROBIN:
+  case P_LATENCY_ROUND_ROBIN:
     Debug("parent_select", "allocating ParentRoundRobin() lookup strategy.");
     selection_strategy = new ParentRoundRobin(this, round_robin);
     break;
@@ -1781,6 +1786,35 @@ EXCLUSIVE_REGRESSION_TEST(PARENTSELECTION)(RegressionTest * /* t ATS_UNUSED */,
   FP;
   RE(verify(result, PARENT_SPECIFIED, "carol", 80), 211);
 
+  // Test 212
+  // Each parent is tried once before it has a response time, then the faster one wins.
+  tbl[0] = '\0';
+  ST(212);
+  T("dest_domain=race.net parent=tortoise:80,hare:80 round_robin=latency go_direct=false\n");
+  REBUILD;
+  for (int i = 0; i < 2; i++) {
+    REINIT;
+    br(request, "i.am.race.net");
+    FP;
+    params->markParentLatency(result, HRTIME_MSECONDS(strcmp(result->hostname, "tortoise") == 0 ? 500 : 5));
+  }
+  for (int i = 0; i < 4; i++) {
+    REINIT;
+    br(request, "i.am.race.net");
+    FP;
+    RE(verify(result, PARENT_SPECIFIED, "hare", 80), 212);
+  }
+
+  // Test 213
+  // The slower parent is still used when the faster one is down.
+  ST(213);
+  _st.setHostStatus("hare", HOST_STATUS_DOWN, 0, Reason::MANUAL);
+  REINIT;
+  br(request, "i.am.race.net");
+  FP;
+  RE(verify(result, PARENT_SPECIFIED, "tortoise", 80), 213);
+  _st.setHostStatus("hare", HOST_STATUS_UP, 0, Reason::MANUAL);
+
   delete request;
   delete result;
   delete params;
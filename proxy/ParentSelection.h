@@ -65,6 +65,7 @@ enum ParentRR_t {
   P_HASH_ROUND_ROBIN,
   P_CONSISTENT_HASH,
   P_LATCHED_ROUND_ROBIN,
+  P_LATENCY_ROUND_ROBIN,
 };
 
 enum ParentRetry_t {
@@ -103,6 +104,7 @@ struct pRecord : ATSConsistentHashNode {
   int idx;
   float weight;
   char hash_string[MAXDNAME + 1];
+  int64_t latency; // moving average of the response time in microseconds, 0 until one is measured.
 };
 
 typedef ControlMatcher<ParentRecord, ParentResult> P_table;
@@ -259,6 +261,7 @@ private:
   // state for consistent hash.
   int last_lookup;
   ATSConsistentHashIter chashIter[2];
+  uint64_t chash_path_hash; ///< Hash of the request path, the same for all its retries.
 
   friend class ParentConsistentHash;
   friend class ParentRoundRobin;
@@ -297,6 +300,7 @@ public:
   virtual uint32_t numParents(ParentResult *result) const = 0;
   void markParentDown(ParentResult *result, unsigned int fail_threshold, unsigned int retry_time);
   void markParentUp(ParentResult *result);
+  void markParentLatency(ParentResult *result, ink_hrtime latency);
 
   // virtual destructor.
   virtual ~ParentSelectionStrategy(){};
@@ -341,6 +345,14 @@ public:
     }
   }
 
+  void
+  markParentLatency(ParentResult *result, ink_hrtime latency)
+  {
+    if (!result->is_api_result()) {
+      result->rec->selection_strategy->markParentLatency(result, latency);
+    }
+  }
+
   uint32_t
   numParents(ParentResult *result)
   {
@@ -126,3 +126,23 @@ ParentSelectionStrategy::markParentUp(ParentResult *result)
     Note("http parent proxy %s:%d restored", pRec->hostname, pRec->port);
   }
 }
+
+void
+ParentSelectionStrategy::markParentLatency(ParentResult *result, ink_hrtime latency)
+{
+  pRecord *pRec, *parents = result->rec->selection_strategy->getParents(result);
+
+  ink_assert(result->result == PARENT_SPECIFIED);
+  if (result->result != PARENT_SPECIFIED || latency < 0) {
+    return;
+  }
+
+  ink_assert(result->last_parent < numParents(result));
+  pRec = parents + result->last_parent;
+
+  // Exponentially weighted with a weight of 1/8 for the new sample, as TCP does for its round trip
+  // time. Concurrent updates can lose a sample, which only matters as much as the sample does.
+  int64_t sample  = std::max<int64_t>(ink_hrtime_to_usec(latency), 1);
+  int64_t average = pRec->latency;
+  ink_atomic_swap(&pRec->latency, average == 0 ? sample : average + (sample - average) / 8);
+}
@@ -22,12 +22,18 @@
  */
 
 #include <cstdio>
+#include <ctime>
+#include <map>
+#include <mutex>
+#include <string>
+#include <dlfcn.h>
 #include "tscore/ink_platform.h"
 #include "tscore/ink_file.h"
 #include "tscore/ParseRules.h"
 #include "records/I_RecCore.h"
 #include "tscore/I_Layout.h"
 #include "InkAPIInternal.h"
+#include "HttpDebugNames.h"
 #include "Plugin.h"
 #include "tscore/ink_cap.h"
 
@@ -132,6 +138,7 @@ plugin_load(int argc, char *argv[], bool validateOnly)
 #endif
     opterr = 0;
     optarg = nullptr;
+    AtsMemTagScope mem_tag(ATS_MEM_TAG_PLUGIN);
     init(argc, argv);
   } // done elevating access
 
@@ -227,6 +234,7 @@ plugin_init(bool validateOnly)
 
   if (INIT_ONCE) {
     api_init();
+    PluginHookStats::init();
     plugin_dir = ats_stringdup(RecConfigReadPluginDir());
     INIT_ONCE  = false;
   }
@@ -317,3 +325,123 @@ plugin_init(bool validateOnly)
   }
   return retVal;
 }
+
+int32_t PluginHookStats::sample_rate       = 0;
+thread_local int PluginHookStats::countdown = 0;
+
+namespace
+{
+/// Stats of the plugin hooks, two per plugin and hook pair.
+constexpr int HOOK_STATS_MAX = 1024;
+
+enum {
+  HOOK_STAT_CALLS,
+  HOOK_STAT_CPU_US,
+  HOOK_STAT_COUNT,
+};
+
+RecRawStatBlock *hook_rsb = nullptr;
+int hook_rsb_next         = 0;
+std::mutex hook_stats_mutex;
+std::map<std::pair<uintptr_t, int>, int> hook_stats_by_func; ///< Event function and event to the first stat.
+std::map<std::string, int> hook_stats_by_name;               ///< Plugin and hook to the first stat.
+
+/// The name of the plugin of @a func, the shared object it is in without the directory and extension.
+std::string
+plugin_of(uintptr_t func)
+{
+  Dl_info info;
+  if (!func || !dladdr(reinterpret_cast<void *>(func), &info) || !info.dli_fname) {
+    return "unknown";
+  }
+  std::string name = info.dli_fname;
+  name.erase(0, name.rfind('/') + 1);
+  name.erase(std::min(name.find('.'), name.size()));
+  return name.empty() ? "unknown" : name;
+}
+
+/// The hook of @a event, its event name without the prefix, in lower case.
+std::string
+hook_of(int event)
+{
+  std::string name = HttpDebugNames::get_event_name(event);
+  name.erase(0, name.rfind('/') + 1);
+  if (name.compare(0, 9, "TS_EVENT_") == 0) {
+    name.erase(0, 9);
+  }
+  for (char &c : name) {
+    c = ParseRules::ink_tolower(c);
+  }
+  return name;
+}
+
+/// The first stat of the plugin of @a func on @a event, registered on the first call, -1 if there is no room left.
+int
+hook_stat(uintptr_t func, int event)
+{
+  std::lock_guard<std::mutex> lock(hook_stats_mutex);
+
+  auto spot = hook_stats_by_func.find({func, event});
+  if (spot != hook_stats_by_func.end()) {
+    return spot->second;
+  }
+
+  std::string name = plugin_of(func) + '.' + hook_of(event);
+  int id           = -1;
+  if (auto named = hook_stats_by_name.find(name); named != hook_stats_by_name.end()) {
+    id = named->second;
+  } else if (hook_rsb_next + HOOK_STAT_COUNT <= HOOK_STATS_MAX) {
+    id = hook_rsb_next;
+    hook_rsb_next += HOOK_STAT_COUNT;
+    RecRegisterRawStat(hook_rsb, RECT_PROCESS, ("proxy.process.plugin." + name + ".calls").c_str(), RECD_INT, RECP_NON_PERSISTENT,
+                       id + HOOK_STAT_CALLS, RecRawStatSyncSum);
+    RecRegisterRawStat(hook_rsb, RECT_PROCESS, ("proxy.process.plugin." + name + ".cpu_us").c_str(), RECD_INT, RECP_NON_PERSISTENT,
+                       id + HOOK_STAT_CPU_US, RecRawStatSyncSum);
+    hook_stats_by_name.emplace(name, id);
+  } else {
+    Warning("no room left for the stats of plugin hook %s", name.c_str());
+    hook_stats_by_name.emplace(name, -1);
+  }
+  hook_stats_by_func.emplace(std::make_pair(func, event), id);
+  return id;
+}
+
+int64_t
+thread_cpu_ns()
+{
+  timespec ts;
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+  return ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+} // namespace
+
+void
+PluginHookStats::init()
+{
+  hook_rsb = RecAllocateRawStatBlock(HOOK_STATS_MAX);
+  REC_EstablishStaticConfigInt32(sample_rate, "proxy.config.plugin.hook_stats");
+}
+
+int
+PluginHookStats::invoke(INKContInternal *cont, int event, void *edata)
+{
+  // The plugin may free @a cont, take all that is needed from it first.
+  int id       = hook_rsb ? hook_stat(reinterpret_cast<uintptr_t>(cont->m_event_func), event) : -1;
+  int64_t rate = sample_rate;
+
+  int64_t start = thread_cpu_ns();
+  int ret       = cont->handleEvent(event, edata);
+  int64_t spent = thread_cpu_ns() - start;
+
+  if (id >= 0) {
+    // Lifecycle hooks may be called before the event threads are up.
+    if (EThread *ethread = this_ethread(); ethread != nullptr) {
+      RecIncrRawStat(hook_rsb, ethread, id + HOOK_STAT_CALLS, rate);
+      RecIncrRawStat(hook_rsb, ethread, id + HOOK_STAT_CPU_US, spent * rate / 1000);
+    } else {
+      RecIncrGlobalRawStat(hook_rsb, id + HOOK_STAT_CALLS, rate);
+      RecIncrGlobalRawStat(hook_rsb, id + HOOK_STAT_CPU_US, spent * rate / 1000);
+    }
+  }
+  return ret;
+}
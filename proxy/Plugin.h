@@ -23,6 +23,9 @@
 
 #pragma once
 
+#include <cstdint>
+
+#include "tscore/ink_defs.h"
 #include "tscore/List.h"
 
 struct PluginRegInfo {
@@ -85,3 +88,45 @@ public:
     return 0;
   }
 };
+
+class INKContInternal;
+
+/** Sampled accounting of the time plugins spend in their hooks.
+
+    One in @a sample_rate hook invocations on each thread is timed in CPU time. The calls and the
+    time, multiplied by @a sample_rate to estimate the totals, are added to the stats
+    proxy.process.plugin.<plugin>.<hook>.calls and .cpu_us, registered on the first call of each
+    pair. The plugin is named by the shared object its event function is in, without the directory
+    and the extension.
+
+    Nothing is timed and the cost of a hook invocation is a single test while @a sample_rate is 0.
+ */
+class PluginHookStats
+{
+public:
+  /// Time one in this many hook invocations, 0 to disable.
+  static int32_t sample_rate;
+
+  /// Set up the stats and the configuration.
+  static void init();
+
+  /// Check if this hook invocation on the current thread is timed.
+  static bool
+  sampled()
+  {
+    if (likely(sample_rate <= 0)) {
+      return false;
+    }
+    if (--countdown > 0) {
+      return false;
+    }
+    countdown = sample_rate;
+    return true;
+  }
+
+  /// Call @a cont for @a event, accounting the time to its plugin and hook.
+  static int invoke(INKContInternal *cont, int event, void *edata);
+
+private:
+  static thread_local int countdown; ///< Invocations until the next sample.
+};
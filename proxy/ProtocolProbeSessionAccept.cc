@@ -122,6 +122,11 @@ struct ProtocolProbeTrampoline : public Continuation, public ProtocolProbeSessio
       if (http_has_proxy_v1(reader, netvc)) {
         Debug("proxyprotocol", "ioCompletionEvent: http has proxy_v1 header");
         netvc->set_remote_addr(netvc->get_proxy_protocol_src_addr());
+      } else if (http_has_proxy_v2(reader, netvc)) {
+        Debug("proxyprotocol", "ioCompletionEvent: http has proxy_v2 header");
+        if (netvc->get_proxy_protocol_version() != NetVConnection::ProxyProtocolVersion::UNDEFINED) {
+          netvc->set_remote_addr(netvc->get_proxy_protocol_src_addr());
+        }
       } else {
         Debug("proxyprotocol",
               "ioCompletionEvent: proxy protocol was enabled, but required header was not present in the transaction - "
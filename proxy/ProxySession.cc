@@ -56,6 +56,36 @@ ProxySession::next_connection_id()
   return ink_atomic_increment(&next_cs_id, 1);
 }
 
+void
+ProxySession::rebalance()
+{
+  UnixNetVConnection *vc = dynamic_cast<UnixNetVConnection *>(this->get_netvc());
+  if (migrate_event == nullptr && vc != nullptr) {
+    if (EThread *t = vc->rebalance_target(); t != nullptr) {
+      migrate_event = t->schedule_imm(this, NET_EVENT_MIGRATE);
+    }
+  }
+}
+
+void
+ProxySession::finish_rebalance(bool idle)
+{
+  migrate_event          = nullptr;
+  UnixNetVConnection *vc = dynamic_cast<UnixNetVConnection *>(this->get_netvc());
+  if (idle && vc != nullptr && vc->moveToCurrentThread(this_ethread())) {
+    NET_INCREMENT_DYN_STAT(net_sessions_migrated_stat);
+  }
+}
+
+void
+ProxySession::cancel_rebalance()
+{
+  if (migrate_event) {
+    migrate_event->cancel();
+    migrate_event = nullptr;
+  }
+}
+
 static const TSEvent eventmap[TS_HTTP_LAST_HOOK + 1] = {
   TS_EVENT_HTTP_READ_REQUEST_HDR,      // TS_HTTP_READ_REQUEST_HDR_HOOK
   TS_EVENT_HTTP_OS_DNS,                // TS_HTTP_OS_DNS_HOOK
@@ -90,6 +120,7 @@ ProxySession::free()
     schedule_event->cancel();
     schedule_event = nullptr;
   }
+  this->cancel_rebalance();
   this->api_hooks.clear();
   this->mutex.clear();
   this->acl.clear();
@@ -257,6 +288,13 @@ ProxySession::set_half_close_flag(bool flag)
 {
 }
 
+// Override if your session protocol pipelines requests.
+void
+ProxySession::prefetch_pipelined(IOBufferReader * /* reader ATS_UNUSED */, int /* max_requests ATS_UNUSED */,
+                                 ink_hrtime /* timeout ATS_UNUSED */)
+{
+}
+
 bool
 ProxySession::get_half_close_flag() const
 {
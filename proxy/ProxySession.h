@@ -110,6 +110,9 @@ public:
   virtual void set_half_close_flag(bool flag);
   virtual bool get_half_close_flag() const;
 
+  /// Start fetching up to @a max_requests of the requests pipelined in @a reader after the current one.
+  virtual void prefetch_pipelined(IOBufferReader *reader, int max_requests, ink_hrtime timeout);
+
   virtual in_port_t get_outbound_port() const;
   virtual IpAddr get_outbound_ip4() const;
   virtual IpAddr get_outbound_ip6() const;
@@ -138,6 +141,12 @@ public:
 
   void set_session_active();
   void clear_session_active();
+
+  /// Move this session, idle between requests, to a less busy net thread if its own is handing sessions over.
+  void rebalance();
+  /// Handle the NET_EVENT_MIGRATE of rebalance() on the new thread, the connection moves if the session is still @a idle.
+  void finish_rebalance(bool idle);
+  void cancel_rebalance();
   bool is_active() const;
   bool is_draining() const;
   bool is_client_closed() const;
@@ -172,6 +181,7 @@ protected:
 
   int64_t con_id        = 0;
   Event *schedule_event = nullptr;
+  Event *migrate_event  = nullptr; ///< NET_EVENT_MIGRATE on the thread the session is moving to.
 
 private:
   void handle_api_return(int event);
@@ -135,13 +135,21 @@ bool
 reloadUrlRewrite()
 {
   UrlRewrite *newTable, *oldTable;
+  int incremental = 0;
 
   Note("remap.config loading ...");
   Debug("url_rewrite", "remap.config updated, reloading...");
   newTable = new UrlRewrite();
+  REC_ReadConfigInteger(incremental, "proxy.config.url_remap.incremental_reload");
+  if (incremental && rewrite_table != nullptr) {
+    // Plugin instances of rules that did not change are reused instead of initialized again.
+    newTable->pluginFactory.carryOverFrom(&rewrite_table->pluginFactory);
+  }
   if (newTable->load()) {
     static const char *msg = "remap.config finished loading";
 
+    newTable->pluginFactory.finishCarryOver(true);
+
     // Hold at least one lease, until we reload the configuration
     newTable->acquire();
 
@@ -160,6 +168,7 @@ reloadUrlRewrite()
   } else {
     static const char *msg = "remap.config failed to load";
 
+    newTable->pluginFactory.finishCarryOver(false);
     delete newTable;
     Debug("url_rewrite", "%s", msg);
     Error("%s", msg);
@@ -29,6 +29,7 @@
 #include <cstring>
 #include "HTTP.h"
 #include "HdrToken.h"
+#include "HdrUtils.h"
 #include "tscore/Diags.h"
 
 /***********************************************************************
@@ -1879,6 +1880,48 @@ HTTPHdrImpl::check_strings(HeapCheck *heaps, int num_heaps)
   }
 }
 
+void
+HTTPCachePolicy::init(HTTPHdr *response)
+{
+  cc_mask           = response->get_cooked_cc_mask();
+  cc_max_age        = response->get_cooked_cc_max_age();
+  cc_s_maxage       = response->get_cooked_cc_s_maxage();
+  pragma_no_cache   = response->is_pragma_no_cache_set();
+  has_expires       = response->presence(MIME_PRESENCE_EXPIRES) != 0;
+  has_last_modified = response->presence(MIME_PRESENCE_LAST_MODIFIED) != 0;
+  date              = response->get_date();
+  expires           = response->get_expires();
+  last_modified     = response->get_last_modified();
+  age               = response->get_age();
+
+  cc_stale_while_revalidate = -1;
+  cc_stale_if_error         = -1;
+  if (response->presence(MIME_PRESENCE_CACHE_CONTROL)) {
+    MIMEField *field = response->field_find(MIME_FIELD_CACHE_CONTROL, MIME_LEN_CACHE_CONTROL);
+    HdrCsvIter csv_iter;
+    int len;
+
+    for (const char *s = csv_iter.get_first(field, &len); s != nullptr; s = csv_iter.get_next(&len)) {
+      const char *e = s + len;
+      int32_t *value;
+
+      if (len > 22 && strncasecmp(s, "stale-while-revalidate", 22) == 0) {
+        value = &cc_stale_while_revalidate;
+        s += 22;
+      } else if (len > 14 && strncasecmp(s, "stale-if-error", 14) == 0) {
+        value = &cc_stale_if_error;
+        s += 14;
+      } else {
+        continue;
+      }
+      int secs;
+      if (*s == '=' && mime_parse_integer(s, e, &secs) && secs >= 0) {
+        *value = secs;
+      }
+    }
+  }
+}
+
 ClassAllocator<HTTPCacheAlt> httpCacheAltAllocator("httpCacheAltAllocator");
 
 /*-------------------------------------------------------------------------
@@ -1333,6 +1333,36 @@ struct HTTPCacheAlt {
   RefCountObj *m_ext_buffer = nullptr;
 };
 
+/** The values of a response that its caching and freshness decisions look at.
+
+    The dates and the Age of a header are parsed from its text each time they are asked for. This
+    takes them once, with the cooked Cache-Control values, so that the checks of a transaction can
+    share them. It is a copy, it has to be taken again if the response is changed.
+ */
+struct HTTPCachePolicy {
+  uint32_t cc_mask       = 0; ///< Cooked Cache-Control mask.
+  int32_t cc_max_age     = 0;
+  int32_t cc_s_maxage    = 0;
+  bool pragma_no_cache   = false;
+  bool has_expires       = false;
+  bool has_last_modified = false;
+  time_t date            = 0;
+  time_t expires         = 0;
+  time_t last_modified   = 0;
+  time_t age             = 0; ///< As HTTPHdr::get_age(), -1 if it overflows.
+
+  /// The RFC 5861 extensions of Cache-Control, in seconds, -1 if not present. The cooked Cache-Control is
+  /// part of the marshalled header in the cache, so these are taken from the field rather than cooked.
+  int32_t cc_stale_while_revalidate = -1;
+  int32_t cc_stale_if_error         = -1;
+
+  HTTPCachePolicy() = default;
+  explicit HTTPCachePolicy(HTTPHdr *response) { init(response); }
+
+  /// Take the values of @a response.
+  void init(HTTPHdr *response);
+};
+
 class HTTPInfo
 {
 public:
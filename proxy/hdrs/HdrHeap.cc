@@ -43,6 +43,8 @@ static constexpr uint32_t MAX_HDR_HEAP_OBJ_LENGTH = (1 << 20) - 1; ///< m_length
 Allocator hdrHeapAllocator("hdrHeap", HdrHeap::DEFAULT_SIZE);
 Allocator strHeapAllocator("hdrStrHeap", HdrStrHeap::DEFAULT_SIZE);
 
+HdrStrHeapStats hdr_str_heap_stats;
+
 /*-------------------------------------------------------------------------
   -------------------------------------------------------------------------*/
 
@@ -118,6 +120,7 @@ new_HdrHeap(int size)
     size = HdrHeap::DEFAULT_SIZE;
     h    = (HdrHeap *)(THREAD_ALLOC(hdrHeapAllocator, this_ethread()));
   } else {
+    AtsMemTagScope mem_tag(ATS_MEM_TAG_HDRS);
     h = (HdrHeap *)ats_malloc(size);
   }
 
@@ -142,6 +145,7 @@ new_HdrStrHeap(int requested_size)
     alloc_size = HdrStrHeap::DEFAULT_SIZE;
     sh         = (HdrStrHeap *)(THREAD_ALLOC(strHeapAllocator, this_ethread()));
   } else {
+    AtsMemTagScope mem_tag(ATS_MEM_TAG_HDRS);
     alloc_size = ts::round_up<HdrStrHeap::DEFAULT_SIZE * 2>(alloc_size);
     sh         = static_cast<HdrStrHeap *>(ats_malloc(alloc_size));
   }
@@ -181,6 +185,36 @@ HdrHeap::destroy()
   }
 }
 
+void
+HdrHeap::reset()
+{
+  ink_assert(m_writeable);
+
+  if (m_next) {
+    m_next->destroy();
+    m_next = nullptr;
+  }
+
+  for (auto &i : m_ronly_heap) {
+    i.m_ref_count_ptr = nullptr;
+    i.m_heap_start    = nullptr;
+    i.m_heap_len      = 0;
+    i.m_locked        = false;
+  }
+
+  // The string heap can only be emptied if no other header heap inherited it.
+  if (m_read_write_heap && m_read_write_heap->refcount() == 1) {
+    m_read_write_heap->m_free_start = reinterpret_cast<char *>(m_read_write_heap.get() + 1);
+    m_read_write_heap->m_free_size  = m_read_write_heap->m_heap_size - sizeof(HdrStrHeap);
+  } else {
+    m_read_write_heap = nullptr;
+  }
+  m_lost_string_space = 0;
+
+  m_data_start = m_free_start = reinterpret_cast<char *>(this) + HDR_HEAP_HDR_SIZE;
+  m_free_size                 = m_size - HDR_HEAP_HDR_SIZE;
+}
+
 HdrHeapObjImpl *
 HdrHeap::allocate_obj(int nbytes, int type)
 {
@@ -244,8 +278,10 @@ HdrHeap::allocate_str(int nbytes)
   //   Ideally this should be done on free_string()
   //   but I already no that this code path is
   //   safe for forcing a str coalesce so I'm doing
-  //   it here for sanity's sake
-  if (m_lost_string_space > (int)MAX_LOST_STR_SPACE) {
+  //   it here for sanity's sake.  Only once the dead
+  //   strings outweigh the live ones, so the copying
+  //   stays proportional to what is freed
+  if (lost_str_space_exceeded(m_lost_string_space)) {
     goto FAILED;
   }
 
@@ -275,8 +311,9 @@ RETRY:
 
 FAILED:
   // We failed to demote.  We'll have to coalesce
-  //  the heaps
-  coalesce_str_heaps();
+  //  the heaps, leaving at least as much room as the
+  //  heap that filled up so the next coalesce is far off
+  coalesce_str_heaps(std::max(nbytes, last_size));
   goto RETRY;
 }
 
@@ -298,6 +335,23 @@ HdrHeap::expand_str(const char *old_str, int old_len, int new_len)
   return nullptr;
 }
 
+// void HdrHeap::shrink_str(const char* str, int old_len, int new_len)
+//
+//   Give back the end of a string that was allocated larger than
+//      needed, e.g. before decoding into it.  If the string is
+//      the last one in the read-write string heap the space is
+//      reused, otherwise it is counted as lost
+//
+void
+HdrHeap::shrink_str(const char *str, int old_len, int new_len)
+{
+  ink_assert(new_len <= old_len);
+
+  if (!(m_read_write_heap && m_read_write_heap->contains(str) && m_read_write_heap->shrink(str, old_len, new_len))) {
+    free_string(str + new_len, old_len - new_len);
+  }
+}
+
 // char* HdrHeap::duplicate_str(char* str, int nbytes)
 //
 //  Allocates a new string and copies the old data.
@@ -358,7 +412,10 @@ HdrHeap::coalesce_str_heaps(int incoming_size)
   ink_assert(incoming_size >= 0);
   ink_assert(m_writeable);
 
-  new_heap_size += required_space_for_evacuation();
+  int live_size = required_space_for_evacuation();
+  new_heap_size += live_size;
+  hdr_str_heap_stats.coalesce_count.fetch_add(1, std::memory_order_relaxed);
+  hdr_str_heap_stats.coalesce_bytes.fetch_add(live_size, std::memory_order_relaxed);
 
   HdrStrHeap *new_heap = new_HdrStrHeap(new_heap_size);
   evacuate_from_str_heaps(new_heap);
@@ -385,6 +442,36 @@ HdrHeap::coalesce_str_heaps(int incoming_size)
   ink_assert(heaps_removed > 0 || incoming_size > 0 || m_ronly_heap[0].m_heap_start == nullptr);
 }
 
+// int HdrHeap::str_heap_used()
+//
+//   Bytes in use in all the string heaps, live and lost
+//
+int
+HdrHeap::str_heap_used() const
+{
+  int used = 0;
+
+  if (m_read_write_heap) {
+    used += m_read_write_heap->m_heap_size - (sizeof(HdrStrHeap) + m_read_write_heap->m_free_size);
+  }
+  for (auto const &j : m_ronly_heap) {
+    used += j.m_heap_len;
+  }
+  return used;
+}
+
+// bool HdrHeap::lost_str_space_exceeded(int lost_space, int more_used)
+//
+//   Whether @a lost_space is worth a coalesce, which it is once
+//     it is over MAX_LOST_STR_SPACE and more than half of the
+//     string space used, with @a more_used about to be added
+//
+bool
+HdrHeap::lost_str_space_exceeded(int lost_space, int more_used) const
+{
+  return lost_space > static_cast<int>(MAX_LOST_STR_SPACE) && lost_space * 2 > str_heap_used() + more_used;
+}
+
 void
 HdrHeap::evacuate_from_str_heaps(HdrStrHeap *new_heap)
 {
@@ -415,6 +502,7 @@ HdrHeap::evacuate_from_str_heaps(HdrStrHeap *new_heap)
         break;
       case HDR_HEAP_OBJ_EMPTY:
       case HDR_HEAP_OBJ_RAW:
+      case HDR_HEAP_OBJ_FIELD_INDEX:
         // Nothing to do
         break;
       default:
@@ -455,6 +543,7 @@ HdrHeap::required_space_for_evacuation()
         break;
       case HDR_HEAP_OBJ_EMPTY:
       case HDR_HEAP_OBJ_RAW:
+      case HDR_HEAP_OBJ_FIELD_INDEX:
         // Nothing to do
         break;
       default:
@@ -529,6 +618,7 @@ HdrHeap::sanity_check_strs()
         break;
       case HDR_HEAP_OBJ_EMPTY:
       case HDR_HEAP_OBJ_RAW:
+      case HDR_HEAP_OBJ_FIELD_INDEX:
         // Nothing to do
         break;
       default:
@@ -552,6 +642,15 @@ HdrHeap::marshal_length()
 {
   int len;
 
+  // Coalescing is put off as long as the lost space is no
+  //  more than the live strings, but there is no reason
+  //  to store it.  Marshal copies whatever marshal_length
+  //  sized the buffer for, so this is the place to drop it
+  if (m_writeable && m_lost_string_space > static_cast<int>(MAX_LOST_STR_SPACE)) {
+    hdr_str_heap_stats.marshal_count.fetch_add(1, std::memory_order_relaxed);
+    coalesce_str_heaps();
+  }
+
   // If there is more than one HdrHeap block, we'll
   //  coalesce the HdrHeap blocks together so we
   //  only need one block header
@@ -695,10 +794,8 @@ HdrHeap::marshal(char *buf, int len)
   //   translation table for string marshaling in the heap
   //   objects
   //
-  // FIX ME - really ought to check to see if lost_string_space
-  //   is too big and only copy over live strings if it is.  May
-  //   not be too much of a problem since I've prevented too much
-  //   lost string space both in string alloc and inherit
+  // Too much lost string space was dropped by marshal_length(),
+  //   which coalesces the heaps first
 
   if (m_read_write_heap) {
     char *copy_start = ((char *)m_read_write_heap.get()) + sizeof(HdrStrHeap);
@@ -778,6 +875,10 @@ HdrHeap::marshal(char *buf, int len)
           goto Failed;
         }
         break;
+      case HDR_HEAP_OBJ_FIELD_INDEX:
+        // It refers to the fields by slot and is rebuilt when needed, so it is not kept.
+        obj->m_type = HDR_HEAP_OBJ_EMPTY;
+        break;
       case HDR_HEAP_OBJ_EMPTY:
       case HDR_HEAP_OBJ_RAW:
         // Check to make sure we aren't stuck
@@ -976,12 +1077,8 @@ HdrHeap::unmarshal(int buf_length, int obj_type, HdrHeapObjImpl **found_obj, Ref
 inline bool
 HdrHeap::attach_str_heap(char const *h_start, int h_len, RefCountObj *h_ref_obj, int *index)
 {
-  if (*index >= static_cast<int>(HDR_BUF_RONLY_HEAPS)) {
-    return false;
-  }
-
   // Loop over existing entries to see if this one is already present
-  for (int z = 0; z < *index; z++) {
+  for (int z = 0; z < static_cast<int>(HDR_BUF_RONLY_HEAPS); z++) {
     if (m_ronly_heap[z].m_heap_start == h_start) {
       ink_assert(m_ronly_heap[z].m_ref_count_ptr.object() == h_ref_obj);
 
@@ -996,6 +1093,10 @@ HdrHeap::attach_str_heap(char const *h_start, int h_len, RefCountObj *h_ref_obj,
     }
   }
 
+  if (*index >= static_cast<int>(HDR_BUF_RONLY_HEAPS)) {
+    return false;
+  }
+
   m_ronly_heap[*index].m_ref_count_ptr = h_ref_obj;
   m_ronly_heap[*index].m_heap_start    = h_start;
   m_ronly_heap[*index].m_heap_len      = h_len;
@@ -1033,14 +1134,20 @@ HdrHeap::inherit_string_heaps(const HdrHeap *inherit_from)
     }
   }
 
-  // Find out if we have enough slots
+  // Find out if we have enough slots. Heaps that are already ours, typically from copying the same
+  // header into this heap before or from a chain of copies, are shared and need no slot.
+  int new_heaps = 0;
   if (inherit_from->m_read_write_heap) {
-    free_slots--;
+    if (!has_str_heap(reinterpret_cast<char *>(inherit_from->m_read_write_heap.get() + 1))) {
+      ++new_heaps;
+    }
     inherit_str_size = inherit_from->m_read_write_heap->m_heap_size;
   }
   for (const auto &index : inherit_from->m_ronly_heap) {
     if (index.m_heap_start != nullptr) {
-      free_slots--;
+      if (!has_str_heap(index.m_heap_start)) {
+        ++new_heaps;
+      }
       inherit_str_size += index.m_heap_len;
     } else {
       // Heaps are allocated from the front of the array, so if
@@ -1048,11 +1155,12 @@ HdrHeap::inherit_string_heaps(const HdrHeap *inherit_from)
       break;
     }
   }
+  free_slots -= new_heaps;
 
   // Find out if we are building up too much lost space
   int new_lost_space = m_lost_string_space + inherit_from->m_lost_string_space;
 
-  if (free_slots < 0 || new_lost_space > (int)MAX_LOST_STR_SPACE) {
+  if (new_heaps > 0 && (free_slots < 0 || lost_str_space_exceeded(new_lost_space, inherit_str_size))) {
     // Not enough free slots.  We need to force a coalesce of
     //  string heaps for both old heaps and the inherited from heaps.
     // Coalesce can't know the inherited str size so we pass it
@@ -1063,8 +1171,9 @@ HdrHeap::inherit_string_heaps(const HdrHeap *inherit_from)
     //  are put into the heap
     coalesce_str_heaps(inherit_str_size);
   } else {
-    // Copy over read/write string heap if it exists
-    if (inherit_from->m_read_write_heap) {
+    // Copy over read/write string heap if it exists, or extend it if it is already attached.
+    if (inherit_from->m_read_write_heap &&
+        !owns_rw_str_heap(reinterpret_cast<char *>(inherit_from->m_read_write_heap.get() + 1))) {
       int str_size =
         inherit_from->m_read_write_heap->m_heap_size - sizeof(HdrStrHeap) - inherit_from->m_read_write_heap->m_free_size;
       ink_release_assert(attach_str_heap(reinterpret_cast<char *>(inherit_from->m_read_write_heap.get() + 1), str_size,
@@ -1072,12 +1181,14 @@ HdrHeap::inherit_string_heaps(const HdrHeap *inherit_from)
     }
     // Copy over read only string heaps
     for (const auto &i : inherit_from->m_ronly_heap) {
-      if (i.m_heap_start) {
+      if (i.m_heap_start && !owns_rw_str_heap(i.m_heap_start)) {
         ink_release_assert(attach_str_heap(i.m_heap_start, i.m_heap_len, i.m_ref_count_ptr.get(), &first_free));
       }
     }
 
-    m_lost_string_space += inherit_from->m_lost_string_space;
+    if (new_heaps > 0) {
+      m_lost_string_space += inherit_from->m_lost_string_space;
+    }
   }
 
   return;
@@ -1175,3 +1286,20 @@ HdrStrHeap::expand(char *ptr, int old_size, int new_size)
     return nullptr;
   }
 }
+
+// bool HdrStrHeap::shrink(const char* ptr, int old_size, int new_size)
+//
+//   Try to return the end of ptr to the heap.  This succeeds
+//     only if str is the last allocation
+//
+bool
+HdrStrHeap::shrink(const char *ptr, int old_size, int new_size)
+{
+  if (ptr + old_size == m_free_start) {
+    m_free_start -= old_size - new_size;
+    m_free_size += old_size - new_size;
+    return true;
+  } else {
+    return false;
+  }
+}
@@ -32,6 +32,8 @@
 
 #pragma once
 
+#include <atomic>
+
 #include "tscore/Ptr.h"
 #include "tscore/ink_defs.h"
 #include "tscore/ink_assert.h"
@@ -64,6 +66,7 @@ enum {
   HDR_HEAP_OBJ_FIELD_BLOCK      = 5,
   HDR_HEAP_OBJ_FIELD_STANDALONE = 6, // not a type that lives in HdrHeaps
   HDR_HEAP_OBJ_FIELD_SDK_HANDLE = 7, // not a type that lives in HdrHeaps
+  HDR_HEAP_OBJ_FIELD_INDEX      = 8, // marshalled as empty, it is rebuilt on demand
 
   HDR_HEAP_OBJ_MAGIC = 0x0FEEB1E0
 };
@@ -139,6 +142,7 @@ public:
 
   char *allocate(int nbytes);
   char *expand(char *ptr, int old_size, int new_size);
+  bool shrink(const char *ptr, int old_size, int new_size);
   int space_avail();
 
   uint32_t m_heap_size;
@@ -178,6 +182,8 @@ public:
 
   void init();
   inkcoreapi void destroy();
+  /// Drop all the objects and strings to reuse the heap, keeping its first block and an unshared string heap.
+  void reset();
 
   // PtrHeap allocation
   HdrHeapObjImpl *allocate_obj(int nbytes, int type);
@@ -186,6 +192,7 @@ public:
   // StrHeap allocation
   char *allocate_str(int nbytes);
   char *expand_str(const char *old_str, int old_len, int new_len);
+  void shrink_str(const char *str, int old_len, int new_len);
   char *duplicate_str(const char *str, int nbytes);
   void free_string(const char *s, int len);
 
@@ -283,10 +290,34 @@ public:
 
   int demote_rw_str_heap();
   void coalesce_str_heaps(int incoming_size = 0);
+  int str_heap_used() const;
+  bool lost_str_space_exceeded(int lost_space, int more_used = 0) const;
   void evacuate_from_str_heaps(HdrStrHeap *new_heap);
   size_t required_space_for_evacuation();
   bool attach_str_heap(char const *h_start, int h_len, RefCountObj *h_ref_obj, int *index);
 
+  /// Check if the string heap starting at @a h_start is the read-write heap of this heap.
+  bool
+  owns_rw_str_heap(char const *h_start) const
+  {
+    return m_read_write_heap && reinterpret_cast<char const *>(m_read_write_heap.get() + 1) == h_start;
+  }
+
+  /// Check if the string heap starting at @a h_start is already used by this heap.
+  bool
+  has_str_heap(char const *h_start) const
+  {
+    if (owns_rw_str_heap(h_start)) {
+      return true;
+    }
+    for (auto const &i : m_ronly_heap) {
+      if (i.m_heap_start == h_start) {
+        return true;
+      }
+    }
+    return false;
+  }
+
   /** Struct to prevent garbage collection on heaps.
       This bumps the reference count to the heap containing the pointer
       while the instance of this class exists. When it goes out of scope
@@ -322,6 +353,15 @@ public:
   int m_lost_string_space;
 };
 
+/// Counts of string heap coalescing over all header heaps, published as proxy.process.http.header_heap stats.
+struct HdrStrHeapStats {
+  std::atomic<int64_t> coalesce_count{0}; ///< Times the live strings were copied into a new heap.
+  std::atomic<int64_t> coalesce_bytes{0}; ///< Bytes of live strings copied by the coalesces.
+  std::atomic<int64_t> marshal_count{0};  ///< Coalesces done to drop lost space before marshalling.
+};
+
+extern HdrStrHeapStats hdr_str_heap_stats;
+
 static constexpr HdrHeapMarshalBlocks HDR_HEAP_HDR_SIZE{ts::round_up(sizeof(HdrHeap))};
 static constexpr size_t HDR_MAX_ALLOC_SIZE = HdrHeap::DEFAULT_SIZE - HDR_HEAP_HDR_SIZE;
 
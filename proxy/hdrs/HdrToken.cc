@@ -22,7 +22,7 @@
  */
 
 #include "tscore/ink_platform.h"
-#include "tscore/HashFNV.h"
+#include "tscore/CharScan.h"
 #include "tscore/Diags.h"
 #include "tscore/ink_memory.h"
 #include <cstdio>
@@ -47,7 +47,10 @@
   /ericb
 */
 
-static const char *_hdrtoken_strs[] = {
+// WARNING:  Indexes into this array are stored on disk for cached objects.  New strings must be added at the end of the array to
+// avoid changing the indexes of pre-existing entries, unless the cache format version number is increased.
+//
+static constexpr const char *_hdrtoken_strs[] = {
   // MIME Field names
   "Accept-Charset", "Accept-Encoding", "Accept-Language", "Accept-Ranges", "Accept", "Age", "Allow",
   "Approved", // NNTP
@@ -261,142 +264,66 @@ DFA *hdrtoken_strs_dfa = nullptr;
  *                                                                     *
  ***********************************************************************/
 
-#define HDRTOKEN_HASH_TABLE_SIZE 65536
+// The well-known strings hash to distinct slots of this table, which is built at compile time. A
+// name is looked up with one hash and one compare against the single candidate in its slot.
+static constexpr int HDRTOKEN_HASH_TABLE_SIZE = 2048;
 
-struct HdrTokenHashBucket {
-  const char *wks;
-  uint32_t hash;
+struct HdrTokenHashTable {
+  uint32_t seed                             = 0;
+  int16_t wks_idx[HDRTOKEN_HASH_TABLE_SIZE] = {0}; ///< -1 for an empty slot.
 };
 
-HdrTokenHashBucket hdrtoken_hash_table[HDRTOKEN_HASH_TABLE_SIZE];
-
 /**
-  basic FNV hash
+  FNV-1a hash, with @a seed for the offset basis and ASCII letters folded to lower case.
 **/
-#define TINY_MASK(x) (((uint32_t)1 << (x)) - 1)
-
-inline uint32_t
-hash_to_slot(uint32_t hash)
+static constexpr uint32_t
+hdrtoken_hash(const char *string, int length, uint32_t seed)
 {
-  return ((hash >> 15) ^ hash) & TINY_MASK(15);
+  uint32_t hash = seed;
+  for (int i = 0; i < length; ++i) {
+    hash = (hash ^ (static_cast<unsigned char>(string[i]) | 0x20)) * 16777619;
+  }
+  return hash;
 }
 
-inline uint32_t
-hdrtoken_hash(const unsigned char *string, unsigned int length)
+static constexpr int
+hash_to_slot(uint32_t hash)
 {
-  ATSHash32FNV1a fnv;
-  fnv.update(string, length, ATSHash::nocase());
-  fnv.final();
-  return fnv.get();
+  return ((hash >> 15) ^ hash) & (HDRTOKEN_HASH_TABLE_SIZE - 1);
 }
 
-/*-------------------------------------------------------------------------
-  -------------------------------------------------------------------------*/
-
-// WARNING:  Indexes into this array are stored on disk for cached objects.  New strings must be added at the end of the array to
-// avoid changing the indexes of pre-existing entries, unless the cache format version number is increased.
-//
-static const char *_hdrtoken_commonly_tokenized_strs[] = {
-  // MIME Field names
-  "Accept-Charset", "Accept-Encoding", "Accept-Language", "Accept-Ranges", "Accept", "Age", "Allow",
-  "Approved", // NNTP
-  "Authorization",
-  "Bytes", // NNTP
-  "Cache-Control", "Client-ip", "Connection", "Content-Base", "Content-Encoding", "Content-Language", "Content-Length",
-  "Content-Location", "Content-MD5", "Content-Range", "Content-Type",
-  "Control", // NNTP
-  "Cookie", "Date",
-  "Distribution", // NNTP
-  "Etag", "Expect", "Expires",
-  "Followup-To", // NNTP
-  "From", "Host", "If-Match", "If-Modified-Since", "If-None-Match", "If-Range", "If-Unmodified-Since", "Keep-Alive",
-  "Keywords", // NNTP
-  "Last-Modified",
-  "Lines", // NNTP
-  "Location", "Max-Forwards",
-  "Message-ID", // NNTP
-  "MIME-Version",
-  "Newsgroups",   // NNTP
-  "Organization", // NNTP
-  "Path",         // NNTP
-  "Pragma", "Proxy-Authenticate", "Proxy-Authorization", "Proxy-Connection", "Public", "Range",
-  "References", // NNTP
-  "Referer",
-  "Reply-To", // NNTP
-  "Retry-After",
-  "Sender", // NNTP
-  "Server", "Set-Cookie",
-  "Subject", // NNTP
-  "Summary", // NNTP
-  "Transfer-Encoding", "Upgrade", "User-Agent", "Vary", "Via", "Warning", "Www-Authenticate",
-  "Xref",          // NNTP
-  "@Ats-Internal", // Internal Hack
-
-  // Accept-Encoding
-  "compress", "deflate", "gzip", "identity",
-
-  // Cache-Control flags
-  "max-age", "max-stale", "min-fresh", "must-revalidate", "no-cache", "no-store", "no-transform", "only-if-cached", "private",
-  "proxy-revalidate", "s-maxage", "need-revalidate-once",
-
-  // HTTP miscellaneous
-  "none", "chunked", "close",
-
-  // WS
-  "websocket", "Sec-WebSocket-Key", "Sec-WebSocket-Version",
-
-  // HTTP/2 cleartext
-  MIME_UPGRADE_H2C_TOKEN, "HTTP2-Settings",
-
-  // URL schemes
-  "file", "ftp", "gopher", "https", "http", "mailto", "news", "nntp", "prospero", "telnet", "tunnel", "wais", "pnm", "rtspu",
-  "rtsp", "mmsu", "mmst", "mms", "wss", "ws",
-
-  // HTTP methods
-  "CONNECT", "DELETE", "GET", "POST", "HEAD", "OPTIONS", "PURGE", "PUT", "TRACE", "PUSH",
-
-  // Header extensions
-  "X-ID", "X-Forwarded-For", "TE", "Strict-Transport-Security", "100-continue",
-
-  // RFC-2739
-  "Forwarded"};
-
-/*-------------------------------------------------------------------------
-  -------------------------------------------------------------------------*/
-
-void
-hdrtoken_hash_init()
+/// Starting from the FNV offset basis, find a seed for which the well-known strings do not collide.
+static constexpr HdrTokenHashTable
+hdrtoken_hash_build()
 {
-  uint32_t i;
-  int num_collisions;
-
-  memset(hdrtoken_hash_table, 0, sizeof(hdrtoken_hash_table));
-  num_collisions = 0;
-
-  for (i = 0; i < (int)SIZEOF(_hdrtoken_commonly_tokenized_strs); i++) {
-    // convert the common string to the well-known token
-    unsigned const char *wks;
-    int wks_idx = hdrtoken_tokenize_dfa(_hdrtoken_commonly_tokenized_strs[i], (int)strlen(_hdrtoken_commonly_tokenized_strs[i]),
-                                        (const char **)&wks);
-    ink_release_assert(wks_idx >= 0);
-
-    uint32_t hash = hdrtoken_hash(wks, hdrtoken_str_lengths[wks_idx]);
-    uint32_t slot = hash_to_slot(hash);
-
-    if (hdrtoken_hash_table[slot].wks) {
-      printf("ERROR: hdrtoken_hash_table[%u] collision: '%s' replacing '%s'\n", slot, (const char *)wks,
-             hdrtoken_hash_table[slot].wks);
-      ++num_collisions;
-    }
-    hdrtoken_hash_table[slot].wks  = (const char *)wks;
-    hdrtoken_hash_table[slot].hash = hash;
-  }
+  HdrTokenHashTable table;
 
-  if (num_collisions > 0) {
-    abort();
+  for (uint32_t seed = 2166136261; seed != 2166136261 + 1000; ++seed) {
+    bool collision = false;
+    table.seed     = seed;
+    for (auto &idx : table.wks_idx) {
+      idx = -1;
+    }
+    for (int i = 0; i < static_cast<int>(SIZEOF(_hdrtoken_strs)) && !collision; ++i) {
+      int length = 0;
+      while (_hdrtoken_strs[i][length]) {
+        ++length;
+      }
+      int slot            = hash_to_slot(hdrtoken_hash(_hdrtoken_strs[i], length, seed));
+      collision           = table.wks_idx[slot] >= 0;
+      table.wks_idx[slot] = i;
+    }
+    if (!collision) {
+      return table;
+    }
   }
+  table.seed = 0;
+  return table;
 }
 
+static constexpr HdrTokenHashTable hdrtoken_hash_table = hdrtoken_hash_build();
+static_assert(hdrtoken_hash_table.seed != 0, "No collision free seed for the well-known strings, enlarge HDRTOKEN_HASH_TABLE_SIZE");
+
 /***********************************************************************
  *                                                                     *
  *                 M A I N    H D R T O K E N    C O D E               *
@@ -426,7 +353,7 @@ hdrtoken_init()
     inited = 1;
 
     hdrtoken_strs_dfa = new DFA;
-    hdrtoken_strs_dfa->compile(_hdrtoken_strs, SIZEOF(_hdrtoken_strs), (REFlags)(RE_CASE_INSENSITIVE));
+    hdrtoken_strs_dfa->compile(const_cast<const char **>(_hdrtoken_strs), SIZEOF(_hdrtoken_strs), (REFlags)(RE_CASE_INSENSITIVE));
 
     // all the tokenized hdrtoken strings are placed in a special heap,
     // and each string is prepended with a HdrTokenHeapPrefix ---
@@ -478,7 +405,7 @@ hdrtoken_init()
       HdrTokenHeapPrefix *prefix;
 
       wks_idx =
-        hdrtoken_tokenize_dfa(_hdrtoken_strs_type_initializers[i].name, (int)strlen(_hdrtoken_strs_type_initializers[i].name));
+        hdrtoken_tokenize(_hdrtoken_strs_type_initializers[i].name, (int)strlen(_hdrtoken_strs_type_initializers[i].name));
 
       ink_assert((wks_idx >= 0) && (wks_idx < (int)SIZEOF(hdrtoken_strs)));
       // coverity[negative_returns]
@@ -492,7 +419,7 @@ hdrtoken_init()
       HdrTokenHeapPrefix *prefix;
 
       wks_idx =
-        hdrtoken_tokenize_dfa(_hdrtoken_strs_field_initializers[i].name, (int)strlen(_hdrtoken_strs_field_initializers[i].name));
+        hdrtoken_tokenize(_hdrtoken_strs_field_initializers[i].name, (int)strlen(_hdrtoken_strs_field_initializers[i].name));
 
       ink_assert((wks_idx >= 0) && (wks_idx < (int)SIZEOF(hdrtoken_strs)));
       prefix                  = hdrtoken_index_to_prefix(wks_idx);
@@ -509,8 +436,6 @@ hdrtoken_init()
       hdrtoken_str_masks[i]       = prefix->wks_info.mask;   // parallel array for speed
       hdrtoken_str_flags[i]       = prefix->wks_info.flags;  // parallel array for speed
     }
-
-    hdrtoken_hash_init();
   }
 }
 
@@ -546,7 +471,6 @@ int
 hdrtoken_tokenize(const char *string, int string_len, const char **wks_string_out)
 {
   int wks_idx;
-  HdrTokenHashBucket *bucket;
 
   ink_assert(string != nullptr);
 
@@ -558,14 +482,11 @@ hdrtoken_tokenize(const char *string, int string_len, const char **wks_string_ou
     return wks_idx;
   }
 
-  uint32_t hash = hdrtoken_hash((const unsigned char *)string, (unsigned int)string_len);
-  uint32_t slot = hash_to_slot(hash);
-
-  bucket = &(hdrtoken_hash_table[slot]);
-  if ((bucket->wks != nullptr) && (bucket->hash == hash) && (hdrtoken_wks_to_length(bucket->wks) == string_len)) {
-    wks_idx = hdrtoken_wks_to_index(bucket->wks);
+  wks_idx = hdrtoken_hash_table.wks_idx[hash_to_slot(hdrtoken_hash(string, string_len, hdrtoken_hash_table.seed))];
+  if ((wks_idx >= 0) && (hdrtoken_str_lengths[wks_idx] == string_len) &&
+      ts::equal_nocase(string, hdrtoken_strs[wks_idx], string_len)) {
     if (wks_string_out) {
-      *wks_string_out = bucket->wks;
+      *wks_string_out = hdrtoken_strs[wks_idx];
     }
     return wks_idx;
   }
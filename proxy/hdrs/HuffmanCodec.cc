@@ -25,6 +25,7 @@
 #include "tscore/ink_platform.h"
 #include "tscore/ink_memory.h"
 #include "tscore/ink_defs.h"
+#include "tscore/ink_assert.h"
 
 struct huffman_entry {
   uint32_t code_as_hex;
@@ -70,129 +71,122 @@ static const huffman_entry huffman_table[] = {
   {0x7ffffe8, 27}, {0x7ffffe9, 27},  {0x7ffffea, 27}, {0x7ffffeb, 27},  {0xffffffe, 28}, {0x7ffffec, 27}, {0x7ffffed, 27},
   {0x7ffffee, 27}, {0x7ffffef, 27},  {0x7fffff0, 27}, {0x3ffffee, 26},  {0x3fffffff, 30}};
 
-typedef struct node {
-  node *left, *right;
-  char ascii_code;
-  bool leaf_node;
-} Node;
+namespace
+{
+/// Decoding is a state machine over the internal nodes of the code tree that reads 4 bits at a step.
+enum : uint8_t {
+  HUFFMAN_DECODE_SYM    = 1, ///< A symbol is complete in this step.
+  HUFFMAN_DECODE_ACCEPT = 2, ///< The input may end in the new state, only padding has been read since the last symbol.
+  HUFFMAN_DECODE_FAIL   = 4, ///< EOS was decoded.
+};
+
+struct HuffmanDecodeEntry {
+  uint8_t next; ///< The tree node reached, 0 is the root.
+  uint8_t flags;
+  uint8_t sym; ///< The symbol completed, if @c HUFFMAN_DECODE_SYM is set.
+};
 
-Node *HUFFMAN_TREE_ROOT;
+constexpr int HUFFMAN_EOS       = 256;
+constexpr int HUFFMAN_NODES_NUM = 256; ///< Internal nodes of a complete tree of 257 codes.
 
-static Node *
-make_huffman_tree_node()
-{
-  Node *n       = static_cast<Node *>(ats_malloc(sizeof(Node)));
-  n->left       = nullptr;
-  n->right      = nullptr;
-  n->ascii_code = '\0';
-  n->leaf_node  = false;
-  return n;
-}
+// The codes are at least 5 bits so at most one symbol is completed in a step.
+HuffmanDecodeEntry huffman_decode_table[HUFFMAN_NODES_NUM][16];
+bool huffman_decode_table_ready = false;
+} // namespace
 
-static Node *
-make_huffman_tree()
+void
+hpack_huffman_init()
 {
-  Node *root = make_huffman_tree_node();
+  if (huffman_decode_table_ready) {
+    return;
+  }
 
-  // insert leafs for each ascii code
-  for (unsigned i = 0; i < countof(huffman_table); i++) {
-    uint32_t bit_len = huffman_table[i].bit_len;
-    Node *current    = root;
+  // Children are internal nodes if positive, -(symbol + 1) for leaves. The root is never a child.
+  int16_t child[HUFFMAN_NODES_NUM][2] = {{0}};
+  // Padding is at most 7 bits of the EOS code, which is all ones.
+  bool accept[HUFFMAN_NODES_NUM] = {true};
+  int n_nodes                    = 1;
 
-    while (bit_len > 0) {
-      if (huffman_table[i].code_as_hex & (1 << (bit_len - 1))) {
-        if (!current->right) {
-          current->right = make_huffman_tree_node();
-        }
-        current = current->right;
-      } else {
-        if (!current->left) {
-          current->left = make_huffman_tree_node();
-        }
-        current = current->left;
+  for (unsigned i = 0; i < countof(huffman_table); i++) {
+    uint32_t code = huffman_table[i].code_as_hex;
+    int current   = 0;
+
+    for (int bit = huffman_table[i].bit_len - 1; bit > 0; --bit) {
+      int b = (code >> bit) & 1;
+      if (!child[current][b]) {
+        ink_release_assert(n_nodes < HUFFMAN_NODES_NUM);
+        accept[n_nodes]   = accept[current] && b && (huffman_table[i].bit_len - bit <= 7);
+        child[current][b] = n_nodes++;
       }
-      bit_len--;
+      current = child[current][b];
     }
-    current->ascii_code = i;
-    current->leaf_node  = true;
+    child[current][code & 1] = -static_cast<int16_t>(i + 1);
   }
 
-  return root;
-}
-
-static void
-free_huffman_tree(Node *node)
-{
-  if (node->left) {
-    free_huffman_tree(node->left);
-  }
-  if (node->right) {
-    free_huffman_tree(node->right);
+  for (int state = 0; state < n_nodes; ++state) {
+    for (int nibble = 0; nibble < 16; ++nibble) {
+      HuffmanDecodeEntry &entry = huffman_decode_table[state][nibble];
+      int current               = state;
+
+      entry.flags = 0;
+      entry.sym   = 0;
+      for (int bit = 3; bit >= 0; --bit) {
+        int next = child[current][(nibble >> bit) & 1];
+        if (next < 0) {
+          if (-next - 1 == HUFFMAN_EOS) {
+            entry.flags = HUFFMAN_DECODE_FAIL;
+            break;
+          }
+          entry.flags |= HUFFMAN_DECODE_SYM;
+          entry.sym = -next - 1;
+          current   = 0;
+        } else {
+          current = next;
+        }
+      }
+      entry.next = current;
+      if (!(entry.flags & HUFFMAN_DECODE_FAIL) && accept[current]) {
+        entry.flags |= HUFFMAN_DECODE_ACCEPT;
+      }
+    }
   }
 
-  ats_free(node);
-}
-
-void
-hpack_huffman_init()
-{
-  if (!HUFFMAN_TREE_ROOT) {
-    HUFFMAN_TREE_ROOT = make_huffman_tree();
-  }
+  huffman_decode_table_ready = true;
 }
 
 void
 hpack_huffman_fin()
 {
-  if (HUFFMAN_TREE_ROOT) {
-    free_huffman_tree(HUFFMAN_TREE_ROOT);
-  }
+  // Nothing to release, the decoding table is static.
 }
 
 int64_t
 huffman_decode(char *dst_start, const uint8_t *src, uint32_t src_len)
 {
-  char *dst_end             = dst_start;
-  uint8_t shift             = 7;
-  Node *current             = HUFFMAN_TREE_ROOT;
-  int byte_boundary_crossed = 0;
-  bool includes_zero        = false;
-
-  while (src_len) {
-    if (*src & (1 << shift)) {
-      current = current->right;
-    } else {
-      current       = current->left;
-      includes_zero = true;
-    }
-
-    if (current->leaf_node == true) {
-      *dst_end = current->ascii_code;
-      ++dst_end;
-      current               = HUFFMAN_TREE_ROOT;
-      byte_boundary_crossed = 0;
-      includes_zero         = false;
-    }
-    if (shift) {
-      --shift;
-    } else {
-      shift = 7;
-      ++src;
-      --src_len;
-      ++byte_boundary_crossed;
-    }
-    if (byte_boundary_crossed > 3) {
-      return -1;
+  char *dst     = dst_start;
+  uint8_t state = 0;
+  uint8_t flags = HUFFMAN_DECODE_ACCEPT;
+
+  for (const uint8_t *end = src + src_len; src < end; ++src) {
+    for (int nibble : {*src >> 4, *src & 0xf}) {
+      const HuffmanDecodeEntry &entry = huffman_decode_table[state][nibble];
+      if (entry.flags & HUFFMAN_DECODE_FAIL) {
+        return -1;
+      }
+      if (entry.flags & HUFFMAN_DECODE_SYM) {
+        *dst++ = entry.sym;
+      }
+      state = entry.next;
+      flags = entry.flags;
     }
   }
-  if (byte_boundary_crossed > 1) {
-    return -1;
-  }
-  if (includes_zero) {
+
+  // The string has to end on a symbol boundary or in the padding.
+  if (!(flags & HUFFMAN_DECODE_ACCEPT)) {
     return -1;
   }
 
-  return dst_end - dst_start;
+  return dst - dst_start;
 }
 
 uint8_t *
@@ -208,36 +202,30 @@ int64_t
 huffman_encode(uint8_t *dst_start, const uint8_t *src, uint32_t src_len)
 {
   uint8_t *dst = dst_start;
-  // NOTE: The maximum length of Huffman Code is 30, thus using uint32_t as buffer.
-  uint32_t buf         = 0;
-  uint32_t remain_bits = 32;
+  // Bits not yet written are the low @a n_bits of @a buf. The longest code is 30 bits, so after
+  // a code is added there are at most 61 and 32 of them are written at a time.
+  uint64_t buf = 0;
+  int n_bits   = 0;
 
   for (uint32_t i = 0; i < src_len; ++i) {
-    const uint32_t hex     = huffman_table[src[i]].code_as_hex;
-    const uint32_t bit_len = huffman_table[src[i]].bit_len;
-
-    if (remain_bits > bit_len) {
-      remain_bits = remain_bits - bit_len;
-      buf |= hex << remain_bits;
-    } else if (remain_bits == bit_len) {
-      buf |= hex;
-      dst         = huffman_encode_append(dst, buf);
-      remain_bits = 32;
-      buf         = 0;
-    } else {
-      buf |= hex >> (bit_len - remain_bits);
-      dst         = huffman_encode_append(dst, buf);
-      remain_bits = (32 - (bit_len - remain_bits));
-      buf         = hex << remain_bits;
+    const huffman_entry &entry = huffman_table[src[i]];
+
+    buf = (buf << entry.bit_len) | entry.code_as_hex;
+    n_bits += entry.bit_len;
+    if (n_bits >= 32) {
+      n_bits -= 32;
+      dst = huffman_encode_append(dst, static_cast<uint32_t>(buf >> n_bits));
     }
   }
 
-  dst = huffman_encode_append(dst, buf, remain_bits / 8);
-
   // NOTE: Add padding w/ EOS
-  uint32_t pad_len = remain_bits % 8;
-  if (pad_len) {
-    *(dst - 1) |= 0xff >> (8 - pad_len);
+  if (int pad_len = -n_bits & 7; pad_len) {
+    buf = (buf << pad_len) | (0xff >> (8 - pad_len));
+    n_bits += pad_len;
+  }
+  while (n_bits > 0) {
+    n_bits -= 8;
+    *dst++ = (buf >> n_bits) & 255;
   }
 
   return dst - dst_start;
@@ -25,6 +25,7 @@
 #include "tscore/ink_platform.h"
 #include "tscore/ink_memory.h"
 #include "tscore/TsBuffer.h"
+#include "tscore/CharScan.h"
 #include <cassert>
 #include <cstdio>
 #include <cstring>
@@ -998,6 +999,71 @@ mime_init_date_format_table()
   }
 }
 
+// The low bit of MIMEHdrImpl::m_field_index marks the index as stale, heap objects are aligned so
+// the position of the index never has it set.
+static const uint32_t MIME_FIELD_INDEX_STALE = 1;
+
+/** Find the field index of @a mh by its position in the blocks of @a heap.
+
+    The blocks of a heap are separately allocated, so the position is the sum of the sizes of the
+    blocks before the one the index is in plus its offset in that block.
+ */
+static MIMEFieldIndexImpl *
+mime_hdr_field_index_get(HdrHeap *heap, MIMEHdrImpl *mh)
+{
+  uint32_t position = mh->m_field_index & ~MIME_FIELD_INDEX_STALE;
+
+  if (position == 0) {
+    return nullptr;
+  }
+  for (HdrHeap *h = heap; h != nullptr; h = h->m_next) {
+    if (position < h->m_size) {
+      MIMEFieldIndexImpl *index = reinterpret_cast<MIMEFieldIndexImpl *>(reinterpret_cast<char *>(h) + position);
+      // Guard against being handed a heap the header is not in.
+      if (index->m_type != HDR_HEAP_OBJ_FIELD_INDEX || index->m_owner != mh) {
+        return nullptr;
+      }
+      return index;
+    }
+    position -= h->m_size;
+  }
+  return nullptr;
+}
+
+static uint32_t
+mime_hdr_field_index_position(HdrHeap *heap, MIMEFieldIndexImpl *index)
+{
+  uint64_t position = 0;
+
+  for (HdrHeap *h = heap; h != nullptr; h = h->m_next) {
+    char *start = reinterpret_cast<char *>(h);
+    char *obj   = reinterpret_cast<char *>(index);
+    if (obj >= start && obj < start + h->m_size) {
+      position += obj - start;
+      return position <= INT32_MAX ? static_cast<uint32_t>(position) : 0;
+    }
+    position += h->m_size;
+  }
+  return 0;
+}
+
+static inline void
+mime_hdr_field_index_invalidate(MIMEHdrImpl *mh)
+{
+  if (mh->m_field_index) {
+    mh->m_field_index |= MIME_FIELD_INDEX_STALE;
+  }
+}
+
+static inline void
+mime_hdr_field_index_destroy(HdrHeap *heap, MIMEHdrImpl *mh)
+{
+  if (MIMEFieldIndexImpl *index = mime_hdr_field_index_get(heap, mh)) {
+    heap->deallocate_obj(index);
+  }
+  mh->m_field_index = 0;
+}
+
 MIMEHdrImpl *
 mime_hdr_create(HdrHeap *heap)
 {
@@ -1048,6 +1114,7 @@ mime_hdr_cooked_stuff_init(MIMEHdrImpl *mh, MIMEField *changing_field_or_null)
 void
 mime_hdr_init(MIMEHdrImpl *mh)
 {
+  mh->m_field_index = 0;
   mime_hdr_init_accelerators_and_presence_bits(mh);
 
   mime_hdr_cooked_stuff_init(mh, nullptr);
@@ -1114,6 +1181,7 @@ mime_hdr_copy_onto(MIMEHdrImpl *s_mh, HdrHeap *s_heap, MIMEHdrImpl *d_mh, HdrHea
   if (d_mh->m_first_fblock.m_next) {
     mime_hdr_destroy_field_block_list(d_heap, d_mh->m_first_fblock.m_next);
   }
+  mime_hdr_field_index_destroy(d_heap, d_mh);
 
   ink_assert(((char *)&(s_mh->m_first_fblock.m_field_slots[MIME_FIELD_BLOCK_SLOTS]) - (char *)s_mh) == sizeof(struct MIMEHdrImpl));
 
@@ -1123,6 +1191,7 @@ mime_hdr_copy_onto(MIMEHdrImpl *s_mh, HdrHeap *s_heap, MIMEHdrImpl *d_mh, HdrHea
 
   // copies useful part of enclosed first block too
   memcpy(d_mh, s_mh, bytes_below_top);
+  d_mh->m_field_index = 0; // the index of the source is in the source heap
 
   if (d_mh->m_first_fblock.m_next == nullptr) // common case: no other block
   {
@@ -1224,6 +1293,7 @@ mime_hdr_length_get(MIMEHdrImpl *mh)
 void
 mime_hdr_fields_clear(HdrHeap *heap, MIMEHdrImpl *mh)
 {
+  mime_hdr_field_index_destroy(heap, mh);
   mime_hdr_destroy_field_block_list(heap, mh->m_first_fblock.m_next);
   mime_hdr_init(mh);
 }
@@ -1304,8 +1374,162 @@ _mime_hdr_field_list_search_by_slotnum(MIMEHdrImpl *mh, int slotnum)
   }
 }
 
+static inline uint32_t
+mime_field_name_hash(const char *name, int length)
+{
+  // FNV-1a of the lower cased name, names compare case insensitively.
+  uint32_t hash = 2166136261U;
+  for (int i = 0; i < length; ++i) {
+    hash = (hash ^ static_cast<unsigned char>(ParseRules::ink_tolower(name[i]))) * 16777619U;
+  }
+  return hash;
+}
+
+static MIMEFieldIndexImpl *
+mime_hdr_field_index_build(HdrHeap *heap, MIMEHdrImpl *mh)
+{
+  MIMEFieldBlockImpl *fblock;
+  uint32_t slots = 0, heads = 0, covered = 0;
+  bool detached = false;
+
+  // The index stops at the first detached field, attaching it later must not go unnoticed.
+  for (fblock = &(mh->m_first_fblock); fblock != nullptr && !detached; fblock = fblock->m_next) {
+    for (unsigned int i = 0; i < fblock->m_freetop; ++i) {
+      MIMEField *field = &(fblock->m_field_slots[i]);
+      if (field->is_detached()) {
+        detached = true;
+        break;
+      }
+      if (field->is_live() && field->is_dup_head()) {
+        ++heads;
+      }
+      ++covered;
+    }
+  }
+  for (fblock = &(mh->m_first_fblock); fblock != nullptr; fblock = fblock->m_next) {
+    slots += fblock->m_freetop;
+  }
+  if (covered <= MIME_FIELD_INDEX_MIN_SLOTS || slots >= 0xFFFF) {
+    return nullptr;
+  }
+
+  // At most half full, so a probe always ends at an unused entry.
+  uint32_t capacity = 32;
+  while (capacity < heads * 2) {
+    capacity *= 2;
+  }
+  size_t size = sizeof(MIMEFieldIndexImpl) + (capacity - 1) * sizeof(uint32_t);
+  if (size > HDR_MAX_ALLOC_SIZE) {
+    return nullptr;
+  }
+
+  MIMEFieldIndexImpl *index = mime_hdr_field_index_get(heap, mh);
+  if (index == nullptr || index->m_capacity < capacity) {
+    mime_hdr_field_index_destroy(heap, mh);
+    index             = static_cast<MIMEFieldIndexImpl *>(heap->allocate_obj(size, HDR_HEAP_OBJ_FIELD_INDEX));
+    uint32_t position = mime_hdr_field_index_position(heap, index);
+    if (position == 0) {
+      heap->deallocate_obj(index);
+      return nullptr;
+    }
+    index->m_capacity = capacity;
+    index->m_owner    = mh;
+    mh->m_field_index = position;
+  }
+  mh->m_field_index &= ~MIME_FIELD_INDEX_STALE;
+
+  uint32_t mask = index->m_capacity - 1;
+  memset(index->m_entries, 0, index->m_capacity * sizeof(uint32_t));
+  slots = 0;
+  for (fblock = &(mh->m_first_fblock); fblock != nullptr && slots < covered; fblock = fblock->m_next) {
+    for (unsigned int i = 0; i < fblock->m_freetop && slots + i < covered; ++i) {
+      MIMEField *field = &(fblock->m_field_slots[i]);
+      if (field->is_live() && field->is_dup_head()) {
+        uint32_t hash = mime_field_name_hash(field->m_ptr_name, field->m_len_name);
+        uint32_t e    = hash & mask;
+        while (index->m_entries[e] != 0) {
+          e = (e + 1) & mask;
+        }
+        index->m_entries[e] = (hash & 0xFFFF0000) | (slots + i + 1);
+      }
+    }
+    slots += fblock->m_freetop;
+  }
+  index->m_covered = covered;
+
+  return index;
+}
+
+/** Find a field with the index of the header, building it if needed and possible.
+
+    @return @c true if @a found is the answer, @c false if the index can not answer and the field
+    blocks have to be walked.
+ */
+static bool
+mime_hdr_field_index_find(MIMEHdrImpl *mh, HdrHeap *heap, const char *field_name_str, int field_name_len, MIMEField **found)
+{
+  // Cheap tests first, the index is not worth it for fewer than 3 blocks.
+  if (heap == nullptr || mh->m_first_fblock.m_next == nullptr || mh->m_first_fblock.m_next->m_next == nullptr) {
+    return false;
+  }
+
+  MIMEFieldIndexImpl *index = nullptr;
+  if (mh->m_field_index & MIME_FIELD_INDEX_STALE || (index = mime_hdr_field_index_get(heap, mh)) == nullptr) {
+    if (!heap->m_writeable || (index = mime_hdr_field_index_build(heap, mh)) == nullptr) {
+      return false;
+    }
+  }
+
+  uint32_t hash = mime_field_name_hash(field_name_str, field_name_len);
+  uint32_t mask = index->m_capacity - 1;
+
+  for (uint32_t e = hash & mask; index->m_entries[e] != 0; e = (e + 1) & mask) {
+    uint32_t entry = index->m_entries[e];
+    if ((entry & 0xFFFF0000) == (hash & 0xFFFF0000)) {
+      MIMEField *field = _mime_hdr_field_list_search_by_slotnum(mh, (entry & 0xFFFF) - 1);
+      if (field == nullptr || !field->is_live() || !field->is_dup_head()) {
+        mime_hdr_field_index_invalidate(mh); // walk the blocks this time
+        return false;
+      }
+      if ((field_name_len == field->m_len_name) && (strncasecmp(field->m_ptr_name, field_name_str, field_name_len) == 0)) {
+        *found = field;
+        return true;
+      }
+    }
+  }
+
+  // Not in the indexed slots, search the ones allocated after the index was built.
+  uint32_t skip              = index->m_covered;
+  uint32_t walked            = 0;
+  MIMEFieldBlockImpl *fblock = &(mh->m_first_fblock);
+  while (fblock != nullptr && skip >= fblock->m_freetop) {
+    skip -= fblock->m_freetop;
+    fblock = fblock->m_next;
+  }
+  *found = nullptr;
+  for (; fblock != nullptr; fblock = fblock->m_next, skip = 0) {
+    MIMEField *field         = &(fblock->m_field_slots[skip]);
+    MIMEField *too_far_field = &(fblock->m_field_slots[fblock->m_freetop]);
+    for (; field < too_far_field; ++field, ++walked) {
+      if (field->is_live() && (field_name_len == field->m_len_name) &&
+          (strncasecmp(field->m_ptr_name, field_name_str, field_name_len) == 0)) {
+        *found = field;
+        break;
+      }
+    }
+    if (*found) {
+      break;
+    }
+  }
+  // Rebuild once the walk gets as long as a block.
+  if (walked >= MIME_FIELD_BLOCK_SLOTS) {
+    mime_hdr_field_index_invalidate(mh);
+  }
+  return true;
+}
+
 MIMEField *
-mime_hdr_field_find(MIMEHdrImpl *mh, const char *field_name_str, int field_name_len)
+mime_hdr_field_find(MIMEHdrImpl *mh, const char *field_name_str, int field_name_len, HdrHeap *heap)
 {
   HdrTokenHeapPrefix *token_info;
   const bool is_wks = hdrtoken_is_wks(field_name_str);
@@ -1353,7 +1577,13 @@ mime_hdr_field_find(MIMEHdrImpl *mh, const char *field_name_str, int field_name_
     // search by well-known string index or by case-insensitive string match //
     ///////////////////////////////////////////////////////////////////////////
 
-    MIMEField *f = _mime_hdr_field_list_search_by_wks(mh, token_info->wks_idx);
+    MIMEField *f;
+    if (mime_hdr_field_index_find(mh, heap, field_name_str, field_name_len, &f)) {
+      ink_assert((f == nullptr) || f->is_live());
+      return f;
+    }
+
+    f = _mime_hdr_field_list_search_by_wks(mh, token_info->wks_idx);
     ink_assert((f == nullptr) || f->is_live());
 #if TRACK_FIELD_FIND_CALLS
     Debug("http", "mime_hdr_field_find(hdr 0x%X, field %.*s): %s (due to WKS list walk)", mh, field_name_len, field_name_str,
@@ -1361,7 +1591,13 @@ mime_hdr_field_find(MIMEHdrImpl *mh, const char *field_name_str, int field_name_
 #endif
     return f;
   } else {
-    MIMEField *f = _mime_hdr_field_list_search_by_string(mh, field_name_str, field_name_len);
+    MIMEField *f;
+    if (mime_hdr_field_index_find(mh, heap, field_name_str, field_name_len, &f)) {
+      ink_assert((f == nullptr) || f->is_live());
+      return f;
+    }
+
+    f = _mime_hdr_field_list_search_by_string(mh, field_name_str, field_name_len);
 
     ink_assert((f == nullptr) || f->is_live());
 #if TRACK_FIELD_FIND_CALLS
@@ -1588,6 +1824,9 @@ mime_hdr_field_detach(MIMEHdrImpl *mh, MIMEField *field, bool detach_all_dups)
   // to walk the list to find the previous dup in the list to patch out
   // the dup being detached.
 
+  // The field may be attached again under another name, in a slot the index covers.
+  mime_hdr_field_index_invalidate(mh);
+
   if (field->m_flags & MIME_FIELD_SLOT_FLAGS_DUP_HEAD) // head of list?
   {
     if (!next_dup) // only child
@@ -2215,6 +2454,7 @@ mime_field_value_append(HdrHeap *heap, MIMEHdrImpl *mh, MIMEField *field, const
     // Expansion failed.  Create a new string and copy over the value contents
     new_str = heap->allocate_str(new_length);
     memcpy(new_str, field->m_ptr_value, field->m_len_value);
+    heap->free_string(field->m_ptr_value, field->m_len_value);
   }
 
   char *ptr = new_str + field->m_len_value;
@@ -2331,6 +2571,7 @@ ParseResult
 MIMEScanner::get(TextView &input, TextView &output, bool &output_shares_input, bool eof_p, ScanType scan_type)
 {
   ParseResult zret = PARSE_RESULT_CONT;
+  bool nul_p       = false; // Any NUL in the input scanned so far.
   // Need this for handling dangling CR.
   static const char RAW_CR{ParseRules::CHAR_CR};
 
@@ -2369,9 +2610,14 @@ MIMEScanner::get(TextView &input, TextView &output, bool &output_shares_input, b
       }
       break;
     case MIME_PARSE_INSIDE: {
-      auto lf_off = text.find(ParseRules::CHAR_LF);
-      if (lf_off != TextView::npos) {
-        text.remove_prefix(lf_off + 1); // drop up to and including LF
+      // Every byte other than CR and LF is scanned here, look for NUL in the same pass.
+      const char *eol = ts::scan_any(text.data(), text.data_end(), ParseRules::CHAR_LF, '\0');
+      if (eol != text.data_end() && *eol == '\0') {
+        nul_p = true;
+        eol   = ts::scan_any(eol + 1, text.data_end(), ParseRules::CHAR_LF);
+      }
+      if (eol != text.data_end()) {
+        text.remove_prefix(eol - text.data() + 1); // drop up to and including LF
         if (LINE == scan_type) {
           zret    = PARSE_RESULT_OK;
           m_state = MIME_PARSE_BEFORE;
@@ -2458,7 +2704,7 @@ MIMEScanner::get(TextView &input, TextView &output, bool &output_shares_input, b
   }
 
   // Make sure there are no null characters in the input scanned so far
-  if (zret != PARSE_RESULT_ERROR && TextView::npos != parsed_text.find('\0')) {
+  if (zret != PARSE_RESULT_ERROR && nul_p) {
     zret = PARSE_RESULT_ERROR;
   }
 
@@ -3738,6 +3984,7 @@ MIMEHdrImpl::marshal(MarshalXlate *ptr_xlate, int num_ptr, MarshalXlate *str_xla
 {
   // printf("MIMEHdrImpl:marshal  num_ptr = %d  num_str = %d\n", num_ptr, num_str);
   HDR_MARSHAL_PTR(m_fblock_list_tail, MIMEFieldBlockImpl, ptr_xlate, num_ptr);
+  m_field_index = 0; // the index is marshalled as an empty object
   return m_first_fblock.marshal(ptr_xlate, num_ptr, str_xlate, num_str);
 }
 
@@ -3745,6 +3992,7 @@ void
 MIMEHdrImpl::unmarshal(intptr_t offset)
 {
   HDR_UNMARSHAL_PTR(m_fblock_list_tail, MIMEFieldBlockImpl, offset);
+  m_field_index = 0; // older versions left this padding uninitialized
   m_first_fblock.unmarshal(offset);
 }
 
@@ -82,6 +82,7 @@ enum MimeParseState {
 #define MIME_FIELD_SLOT_FLAGS_COOKED (1 << 1)
 
 #define MIME_FIELD_BLOCK_SLOTS 16
+#define MIME_FIELD_INDEX_MIN_SLOTS (2 * MIME_FIELD_BLOCK_SLOTS)
 
 #define MIME_FIELD_SLOTNUM_BITS 4
 #define MIME_FIELD_SLOTNUM_MASK ((1 << MIME_FIELD_SLOTNUM_BITS) - 1)
@@ -205,6 +206,22 @@ struct MIMEFieldBlockImpl : public HdrHeapObjImpl {
   void check_strings(HeapCheck *heaps, int num_heaps);
 };
 
+/** A hash index over the field names of a header with many fields.
+
+    Without it a field that has no slot accelerator is found by walking the field blocks. The index is
+    built by the first lookup that is given the writeable heap of the header once the header has more
+    than MIME_FIELD_INDEX_MIN_SLOTS slots, and holds the dup head of each name in the slots allocated
+    up to then. Slots allocated later are searched linearly. Detaching a field makes it stale, and it
+    is never marshalled.
+ */
+struct MIMEFieldIndexImpl : public HdrHeapObjImpl {
+  // HdrHeapObjImpl is 4 bytes
+  uint32_t m_capacity;   ///< Number of entries, a power of 2.
+  MIMEHdrImpl *m_owner;  ///< The header the index is of.
+  uint32_t m_covered;    ///< Slots that are indexed.
+  uint32_t m_entries[1]; ///< Per entry the slot number + 1 (0 if unused) in the low and name hash bits in the high 16 bits.
+};
+
 /***********************************************************************
  *                                                                     *
  *                              MIMECooked                             *
@@ -252,7 +269,8 @@ struct MIMECooked {
  ***********************************************************************/
 
 struct MIMEHdrImpl : public HdrHeapObjImpl {
-  // HdrHeapObjImpl is 4 bytes, so this will result in 4 bytes padding
+  // HdrHeapObjImpl is 4 bytes, the index position takes what would otherwise be padding
+  uint32_t m_field_index; ///< Position of the MIMEFieldIndexImpl in the heap, 0 if there is none, the low bit if stale.
   uint64_t m_presence_bits;
   uint32_t m_slot_accelerators[4];
 
@@ -703,7 +721,8 @@ void mime_hdr_fields_clear(HdrHeap *heap, MIMEHdrImpl *mh);
 MIMEField *_mime_hdr_field_list_search_by_wks(MIMEHdrImpl *mh, int wks_idx);
 MIMEField *_mime_hdr_field_list_search_by_string(MIMEHdrImpl *mh, const char *field_name_str, int field_name_len);
 MIMEField *_mime_hdr_field_list_search_by_slotnum(MIMEHdrImpl *mh, int slotnum);
-inkcoreapi MIMEField *mime_hdr_field_find(MIMEHdrImpl *mh, const char *field_name_str, int field_name_len);
+inkcoreapi MIMEField *mime_hdr_field_find(MIMEHdrImpl *mh, const char *field_name_str, int field_name_len,
+                                          HdrHeap *heap = nullptr);
 
 MIMEField *mime_hdr_field_get(MIMEHdrImpl *mh, int idx);
 MIMEField *mime_hdr_field_get_slotnum(MIMEHdrImpl *mh, int slotnum);
@@ -1180,14 +1199,14 @@ inline MIMEField *
 MIMEHdr::field_find(const char *name, int length)
 {
   //    ink_assert(valid());
-  return mime_hdr_field_find(m_mime, name, length);
+  return mime_hdr_field_find(m_mime, name, length, m_heap);
 }
 
 inline const MIMEField *
 MIMEHdr::field_find(const char *name, int length) const
 {
   //    ink_assert(valid());
-  MIMEField *retval = mime_hdr_field_find(const_cast<MIMEHdr *>(this)->m_mime, name, length);
+  MIMEField *retval = mime_hdr_field_find(const_cast<MIMEHdr *>(this)->m_mime, name, length, m_heap);
   return retval;
 }
 
@@ -21,6 +21,7 @@
   limitations under the License.
  */
 
+#include <algorithm>
 #include <cassert>
 #include <new>
 #include "tscore/ink_platform.h"
@@ -30,6 +31,8 @@
 #include "MIME.h"
 #include "HTTP.h"
 #include "tscore/Diags.h"
+#include "tscore/Murmur3.h"
+#include "tscore/CharScan.h"
 
 const char *URL_SCHEME_FILE;
 const char *URL_SCHEME_FTP;
@@ -94,9 +97,8 @@ int URL_LEN_MMS;
 int URL_LEN_MMSU;
 int URL_LEN_MMST;
 
-// Whether we should implement url_CryptoHash_get() using url_CryptoHash_get_fast(). Note that
-// url_CryptoHash_get_fast() does NOT produce the same result as url_CryptoHash_get_general().
-static int url_hash_method = 0;
+// The hash of url_CryptoHash_get(), see proxy.config.cache.url_hash.
+static URLHashMethod url_hash_method = URL_HASH_CRYPTO;
 
 // test to see if a character is a valid character for a host in a URI according to
 // RFC 3986 and RFC 1034
@@ -941,23 +943,23 @@ url_to_string(URLImpl *url, Arena *arena, int *length)
  *                                                                     *
  ***********************************************************************/
 
-void
-unescape_str(char *&buf, char *buf_e, const char *&str, const char *str_e, int &state)
+// The value of the hex digit @a c, which must be one.
+static inline int
+hex_digit_value(char c)
 {
-  int copy_len;
-  char *first_pct;
-  int buf_len = (int)(buf_e - buf);
-  int str_len = (int)(str_e - str);
-  int min_len = (int)(str_len < buf_len ? str_len : buf_len);
-
-  first_pct = ink_memcpy_until_char(buf, (char *)str, min_len, '%');
-  copy_len  = (int)(first_pct - str);
-  str += copy_len;
-  buf += copy_len;
-  if (copy_len == min_len) {
-    return;
-  }
+  return (c & 0xF) + 9 * (c >> 6);
+}
+
+/** Percent decode [ @a str, @a str_e ) to [ @a buf, @a buf_e ), advancing both pointers.
 
+    @a state carries a partial escape from one call to the next, 0 if there is none. The text up to
+    the next '%' is found with a vectorized scan and copied in one go, @a buf may be @a str to decode
+    in place. A '%' that is not followed by two hex digits is copied unchanged.
+ */
+template <bool TOLOWER>
+static void
+unescape_str_impl(char *&buf, char *buf_e, const char *&str, const char *str_e, int &state)
+{
   while (str < str_e && (buf != buf_e)) {
     switch (state) {
     case 0:
@@ -965,8 +967,18 @@ unescape_str(char *&buf, char *buf_e, const char *&str, const char *str_e, int &
         str += 1;
         state = 1;
       } else {
-        *buf++ = str[0];
-        str += 1;
+        const char *pct = ts::scan_any(str, str + std::min(str_e - str, buf_e - buf), '%');
+        if (TOLOWER) {
+          while (str < pct) {
+            *buf++ = ParseRules::ink_tolower(*str++);
+          }
+        } else {
+          if (buf != str) {
+            memmove(buf, str, pct - str);
+          }
+          buf += pct - str;
+          str = pct;
+        }
       }
       break;
     case 1:
@@ -974,96 +986,41 @@ unescape_str(char *&buf, char *buf_e, const char *&str, const char *str_e, int &
         str += 1;
         state = 2;
       } else {
-        *buf++ = str[-1];
+        *buf++ = TOLOWER ? ParseRules::ink_tolower(str[-1]) : str[-1];
         state  = 0;
       }
       break;
     case 2:
       if (ParseRules::is_hex(str[0])) {
-        int tmp;
-
-        if (ParseRules::is_alpha(str[-1])) {
-          tmp = (ParseRules::ink_toupper(str[-1]) - 'A' + 10) * 16;
-        } else {
-          tmp = (str[-1] - '0') * 16;
-        }
-        if (ParseRules::is_alpha(str[0])) {
-          tmp += (ParseRules::ink_toupper(str[0]) - 'A' + 10);
-        } else {
-          tmp += str[0] - '0';
-        }
-
-        *buf++ = tmp;
+        *buf++ = hex_digit_value(str[-1]) * 16 + hex_digit_value(str[0]);
         str += 1;
         state = 0;
       } else {
-        *buf++ = str[-2];
+        *buf++ = TOLOWER ? ParseRules::ink_tolower(str[-2]) : str[-2];
         state  = 3;
       }
       break;
     case 3:
-      *buf++ = str[-1];
+      *buf++ = TOLOWER ? ParseRules::ink_tolower(str[-1]) : str[-1];
       state  = 0;
       break;
     }
   }
 }
 
+void
+unescape_str(char *&buf, char *buf_e, const char *&str, const char *str_e, int &state)
+{
+  unescape_str_impl<false>(buf, buf_e, str, str_e, state);
+}
+
 /*-------------------------------------------------------------------------
   -------------------------------------------------------------------------*/
 
 void
 unescape_str_tolower(char *&buf, char *end, const char *&str, const char *str_e, int &state)
 {
-  while (str < str_e && (buf != end)) {
-    switch (state) {
-    case 0:
-      if (str[0] == '%') {
-        str += 1;
-        state = 1;
-      } else {
-        *buf++ = ParseRules::ink_tolower(str[0]);
-        str += 1;
-      }
-      break;
-    case 1:
-      if (ParseRules::is_hex(str[0])) {
-        str += 1;
-        state = 2;
-      } else {
-        *buf++ = ParseRules::ink_tolower(str[-1]);
-        state  = 0;
-      }
-      break;
-    case 2:
-      if (ParseRules::is_hex(str[0])) {
-        int tmp;
-
-        if (ParseRules::is_alpha(str[-1])) {
-          tmp = (ParseRules::ink_toupper(str[-1]) - 'A' + 10) * 16;
-        } else {
-          tmp = (str[-1] - '0') * 16;
-        }
-        if (ParseRules::is_alpha(str[0])) {
-          tmp += (ParseRules::ink_toupper(str[0]) - 'A' + 10);
-        } else {
-          tmp += str[0] - '0';
-        }
-
-        *buf++ = tmp;
-        str += 1;
-        state = 0;
-      } else {
-        *buf++ = ParseRules::ink_tolower(str[-2]);
-        state  = 3;
-      }
-      break;
-    case 3:
-      *buf++ = ParseRules::ink_tolower(str[-1]);
-      state  = 0;
-      break;
-    }
-  }
+  unescape_str_impl<true>(buf, end, str, str_e, state);
 }
 
 /*-------------------------------------------------------------------------
@@ -1100,14 +1057,6 @@ url_unescapify(Arena *arena, const char *str, int length)
  *                                                                     *
  ***********************************************************************/
 
-#define GETNEXT(label) \
-  {                    \
-    cur += 1;          \
-    if (cur >= end) {  \
-      goto label;      \
-    }                  \
-  }
-
 ParseResult
 url_parse_scheme(HdrHeap *heap, URLImpl *url, const char **start, const char *end, bool copy_strings_p)
 {
@@ -1285,7 +1234,7 @@ url_parse_internet(HdrHeap *heap, URLImpl *url, const char **start, char const *
       end = cur; // cause loop exit
       break;
     default:
-      ++cur;
+      cur = ts::scan_any(cur + 1, end, ']', ':', '@', '[', '/');
       break;
     };
   }
@@ -1349,7 +1298,6 @@ url_parse_http(HdrHeap *heap, URLImpl *url, const char **start, const char *end,
   const char *query_end      = nullptr;
   const char *fragment_start = nullptr;
   const char *fragment_end   = nullptr;
-  char mask;
 
   err = url_parse_internet(heap, url, start, end, copy_strings);
   if (err < 0) {
@@ -1361,58 +1309,24 @@ url_parse_http(HdrHeap *heap, URLImpl *url, const char **start, const char *end,
     goto done;
   }
 
+  // Each component ends at the first delimiter of the ones after it.
   path_start = cur;
-  mask       = ';' & '?' & '#';
-parse_path2:
-  if ((*cur & mask) == mask) {
-    if (*cur == ';') {
-      path_end = cur;
-      goto parse_params1;
-    }
-    if (*cur == '?') {
-      path_end = cur;
-      goto parse_query1;
-    }
-    if (*cur == '#') {
-      path_end = cur;
-      goto parse_fragment1;
-    }
-  } else {
-    ink_assert((*cur != ';') && (*cur != '?') && (*cur != '#'));
-  }
-  GETNEXT(done);
-  goto parse_path2;
-
-parse_params1:
-  params_start = cur + 1;
-  GETNEXT(done);
-parse_params2:
-  if (*cur == '?') {
-    params_end = cur;
-    goto parse_query1;
-  }
-  if (*cur == '#') {
-    params_end = cur;
-    goto parse_fragment1;
-  }
-  GETNEXT(done);
-  goto parse_params2;
-
-parse_query1:
-  query_start = cur + 1;
-  GETNEXT(done);
-parse_query2:
-  if (*cur == '#') {
-    query_end = cur;
-    goto parse_fragment1;
-  }
-  GETNEXT(done);
-  goto parse_query2;
-
-parse_fragment1:
-  fragment_start = cur + 1;
-  GETNEXT(done);
-  fragment_end = end;
+  cur        = ts::scan_any(cur, end, ';', '?', '#');
+  path_end   = cur;
+  if (cur < end && *cur == ';') {
+    params_start = ++cur;
+    cur          = ts::scan_any(cur, end, '?', '#');
+    params_end   = cur;
+  }
+  if (cur < end && *cur == '?') {
+    query_start = ++cur;
+    cur         = ts::scan_any(cur, end, '#');
+    query_end   = cur;
+  }
+  if (cur < end && *cur == '#') {
+    fragment_start = ++cur;
+    fragment_end   = end;
+  }
 
 done:
   if (path_start) {
@@ -1632,122 +1546,73 @@ memcpy_tolower(char *d, const char *s, int n)
 
 #define BUFSIZE 512
 
-// fast path for CryptoHash, HTTP, no user/password/params/query,
-// no buffer overflow, no unescaping needed
-
+// Hash the URL component of @a length bytes at @a str, unescaped, and lower cased if @a tolower.
+// A component without escapes nor case to fold is hashed in place, the others go through a
+// buffer, the URL string itself is never built.
 static inline void
-url_CryptoHash_get_fast(const URLImpl *url, CryptoContext &ctx, CryptoHash *hash, cache_generation_t generation)
+url_CryptoHash_update(ats::CryptoContextBase &ctx, const char *str, int length, bool tolower)
 {
-  char buffer[BUFSIZE];
-  char *p;
-
-  p = buffer;
-  memcpy_tolower(p, url->m_ptr_scheme, url->m_len_scheme);
-  p += url->m_len_scheme;
-  *p++ = ':';
-  *p++ = '/';
-  *p++ = '/';
-  // no user
-  *p++ = ':';
-  // no password
-  *p++ = '@';
-  memcpy_tolower(p, url->m_ptr_host, url->m_len_host);
-  p += url->m_len_host;
-  *p++ = '/';
-  memcpy(p, url->m_ptr_path, url->m_len_path);
-  p += url->m_len_path;
-  *p++ = ';';
-  // no params
-  *p++ = '?';
-  // no query
-
-  ink_assert(sizeof(url->m_port) == 2);
-  uint16_t port = (uint16_t)url_canonicalize_port(url->m_url_type, url->m_port);
-  *p++          = ((char *)&port)[0];
-  *p++          = ((char *)&port)[1];
-
-  ctx.update(buffer, p - buffer);
-  if (generation != -1) {
-    ctx.update(&generation, sizeof(generation));
+  if (str == nullptr) {
+    return;
+  }
+  if (!tolower && memchr(str, '%', length) == nullptr) {
+    ctx.update(str, length);
+    return;
   }
 
-  ctx.finalize(*hash);
-}
-
-static inline void
-url_CryptoHash_get_general(const URLImpl *url, CryptoContext &ctx, CryptoHash &hash, cache_generation_t generation)
-{
   char buffer[BUFSIZE];
-  char *p, *e;
-  const char *strs[13], *ends[13];
-  const char *t;
-  in_port_t port;
-  int i, s;
-
-  strs[0] = url->m_ptr_scheme;
-  strs[1] = "://";
-  strs[2] = url->m_ptr_user;
-  strs[3] = ":";
-  strs[4] = url->m_ptr_password;
-  strs[5] = "@";
-  strs[6] = url->m_ptr_host;
-  strs[7] = "/";
-  strs[8] = url->m_ptr_path;
-
-  ends[0] = strs[0] + url->m_len_scheme;
-  ends[1] = strs[1] + 3;
-  ends[2] = strs[2] + url->m_len_user;
-  ends[3] = strs[3] + 1;
-  ends[4] = strs[4] + url->m_len_password;
-  ends[5] = strs[5] + 1;
-  ends[6] = strs[6] + url->m_len_host;
-  ends[7] = strs[7] + 1;
-  ends[8] = strs[8] + url->m_len_path;
-
-  strs[9]  = ";";
-  strs[10] = url->m_ptr_params;
-  strs[11] = "?";
-  strs[12] = url->m_ptr_query;
-  ends[9]  = strs[9] + 1;
-  ends[10] = strs[10] + url->m_len_params;
-  ends[11] = strs[11] + 1;
-  ends[12] = strs[12] + url->m_len_query;
-
-  p = buffer;
-  e = buffer + BUFSIZE;
-
-  for (i = 0; i < 13; i++) {
-    if (strs[i]) {
-      t = strs[i];
-      s = 0;
-
-      while (t < ends[i]) {
-        if ((i == 0) || (i == 6)) { // scheme and host
-          unescape_str_tolower(p, e, t, ends[i], s);
-        } else {
-          unescape_str(p, e, t, ends[i], s);
-        }
+  char *p       = buffer;
+  char *e       = buffer + BUFSIZE;
+  const char *t = str;
+  int s         = 0;
+
+  while (t < str + length) {
+    if (tolower) {
+      unescape_str_tolower(p, e, t, str + length, s);
+    } else {
+      unescape_str(p, e, t, str + length, s);
+    }
 
-        if (p == e) {
-          ctx.update(buffer, BUFSIZE);
-          p = buffer;
-        }
-      }
+    if (p == e) {
+      ctx.update(buffer, BUFSIZE);
+      p = buffer;
     }
   }
 
   if (p != buffer) {
     ctx.update(buffer, p - buffer);
   }
-  int buffer_len = static_cast<int>(p - buffer);
-  port           = url_canonicalize_port(url->m_url_type, url->m_port);
+}
 
+static inline void
+url_CryptoHash_get_general(const URLImpl *url, ats::CryptoContextBase &ctx, CryptoHash &hash, cache_generation_t generation)
+{
+  url_CryptoHash_update(ctx, url->m_ptr_scheme, url->m_len_scheme, true);
+  ctx.update("://", 3);
+  url_CryptoHash_update(ctx, url->m_ptr_user, url->m_len_user, false);
+  ctx.update(":", 1);
+  url_CryptoHash_update(ctx, url->m_ptr_password, url->m_len_password, false);
+  ctx.update("@", 1);
+  url_CryptoHash_update(ctx, url->m_ptr_host, url->m_len_host, true);
+  ctx.update("/", 1);
+  url_CryptoHash_update(ctx, url->m_ptr_path, url->m_len_path, false);
+  ctx.update(";", 1);
+  url_CryptoHash_update(ctx, url->m_ptr_params, url->m_len_params, false);
+  ctx.update("?", 1);
+  url_CryptoHash_update(ctx, url->m_ptr_query, url->m_len_query, false);
+
+  in_port_t port = url_canonicalize_port(url->m_url_type, url->m_port);
   ctx.update(&port, sizeof(port));
   if (generation != -1) {
     ctx.update(&generation, sizeof(generation));
-    Debug("url_cachekey", "Final url string for cache hash key %.*s%d%d", buffer_len, buffer, port, static_cast<int>(generation));
-  } else {
-    Debug("url_cachekey", "Final url string for cache hash key %.*s%d", buffer_len, buffer, port);
+  }
+
+  if (is_debug_tag_set("url_cachekey")) {
+    char buffer[BUFSIZE];
+    int length = 0;
+    url_string_get_buf(const_cast<URLImpl *>(url), buffer, sizeof(buffer), &length);
+    Debug("url_cachekey", "Final url for cache hash key %.*s port %d generation %d", length, buffer, port,
+          static_cast<int>(generation));
   }
   ctx.finalize(hash);
 }
@@ -1755,22 +1620,21 @@ url_CryptoHash_get_general(const URLImpl *url, CryptoContext &ctx, CryptoHash &h
 void
 url_CryptoHash_get(const URLImpl *url, CryptoHash *hash, cache_generation_t generation)
 {
-  URLHashContext ctx;
-  if ((url_hash_method != 0) && (url->m_url_type == URL_TYPE_HTTP) &&
-      ((url->m_len_user + url->m_len_password + url->m_len_params + url->m_len_query) == 0) &&
-      (3 + 1 + 1 + 1 + 1 + 1 + 2 + url->m_len_scheme + url->m_len_host + url->m_len_path < BUFSIZE) &&
-      (memchr(url->m_ptr_host, '%', url->m_len_host) == nullptr) && (memchr(url->m_ptr_path, '%', url->m_len_path) == nullptr)) {
-    url_CryptoHash_get_fast(url, ctx, hash, generation);
-#ifdef DEBUG
-    CryptoHash hash_general;
-    url_CryptoHash_get_general(url, ctx, hash_general, generation);
-    ink_assert(*hash == hash_general);
-#endif
+  if (url_hash_method == URL_HASH_MURMUR3) {
+    Murmur3Context ctx;
+    url_CryptoHash_get_general(url, ctx, *hash, generation);
   } else {
+    URLHashContext ctx;
     url_CryptoHash_get_general(url, ctx, *hash, generation);
   }
 }
 
+void
+url_hash_method_set(URLHashMethod method)
+{
+  url_hash_method = method;
+}
+
 #undef BUFSIZE
 
 /*-------------------------------------------------------------------------
@@ -174,7 +174,14 @@ char *url_string_get_ref(HdrHeap *heap, URLImpl *url, int *length, bool normaliz
 void url_called_set(URLImpl *url);
 char *url_string_get_buf(URLImpl *url, char *dstbuf, int dstbuf_size, int *length);
 
+/// The hash of the cache key of a URL.
+enum URLHashMethod {
+  URL_HASH_CRYPTO,  ///< The crypto hash of @c URLHashContext, MD5 by default.
+  URL_HASH_MURMUR3, ///< MurmurHash3, faster and not cryptographic.
+};
+
 void url_CryptoHash_get(const URLImpl *url, CryptoHash *hash, cache_generation_t generation = -1);
+void url_hash_method_set(URLHashMethod method);
 void url_host_CryptoHash_get(URLImpl *url, CryptoHash *hash);
 const char *url_scheme_set(HdrHeap *heap, URLImpl *url, const char *value, int value_wks_idx, int length, bool copy_string);
 
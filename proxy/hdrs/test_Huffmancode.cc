@@ -134,7 +134,12 @@ values_test()
     encoded_mapped.y[2] = encoded.y[1];
     encoded_mapped.y[3] = encoded.y[0];
 
-    int bytes        = huffman_decode(dst_start, encoded_mapped.y, encoded_size);
+    int bytes = huffman_decode(dst_start, encoded_mapped.y, encoded_size);
+    // [RFC 7541] 5.2. A string containing EOS is a decoding error.
+    if (i / 2 == 256) {
+      assert(bytes == -1);
+      continue;
+    }
     char ascii_value = i / 2;
     assert(dst_start[0] == ascii_value);
     assert(bytes == 1);
@@ -20,8 +20,11 @@
 
 #include "catch.hpp"
 
+#include <string>
+
 #include "HdrHeap.h"
 #include "URL.h"
+#include "MIME.h"
 
 /**
   This test is designed to test numerous pieces of the HdrHeaps including allocations,
@@ -130,3 +133,157 @@ TEST_CASE("HdrHeap", "[proxy][hdrheap]")
   // Clean up
   heap->destroy();
 }
+
+/**
+  Copying a header into the same heap, or headers that share string heaps, must use the string
+  heaps it already has instead of taking more slots and coalescing.
+ */
+TEST_CASE("HdrHeap shared string heaps", "[proxy][hdrheap]")
+{
+  HdrHeap *src[HDR_BUF_RONLY_HEAPS];
+  URLImpl *src_url[HDR_BUF_RONLY_HEAPS];
+
+  for (unsigned i = 0; i < HDR_BUF_RONLY_HEAPS; ++i) {
+    src[i]     = new_HdrHeap();
+    src_url[i] = url_create(src[i]);
+    url_path_set(src[i], src_url[i], "index.html", 10, true);
+  }
+
+  HdrHeap *dst     = new_HdrHeap();
+  URLImpl *dst_url = url_create(dst);
+
+  for (int round = 0; round < 3; ++round) {
+    for (unsigned i = 0; i < HDR_BUF_RONLY_HEAPS; ++i) {
+      url_copy_onto(src_url[i], src[i], dst_url, dst, true);
+      // Still sharing the source string, nothing was coalesced.
+      CHECK(dst_url->m_ptr_path == src_url[i]->m_ptr_path);
+    }
+  }
+  for (unsigned i = 0; i < HDR_BUF_RONLY_HEAPS; ++i) {
+    CHECK(dst->m_ronly_heap[i].m_heap_start != nullptr);
+  }
+  CHECK(dst->m_read_write_heap.get() == nullptr);
+
+  // Strings added to a source after its heap was attached are covered on the next copy.
+  url_host_set(src[0], src_url[0], "example.com", 11, true);
+  url_copy_onto(src_url[0], src[0], dst_url, dst, true);
+  CHECK(dst_url->m_ptr_host == src_url[0]->m_ptr_host);
+  CHECK(dst->m_read_write_heap.get() == nullptr);
+  CHECK(dst->m_ronly_heap[0].contains(dst_url->m_ptr_host));
+
+  // Copying back onto a source does not attach its own read-write heap as read only.
+  url_copy_onto(dst_url, dst, src_url[0], src[0], true);
+  for (auto const &i : src[0]->m_ronly_heap) {
+    CHECK(!src[0]->owns_rw_str_heap(i.m_heap_start));
+  }
+
+  dst->destroy();
+  for (auto heap : src) {
+    heap->destroy();
+  }
+}
+
+TEST_CASE("HdrHeap shrink_str", "[proxy][hdrheap]")
+{
+  HdrHeap *heap = new_HdrHeap();
+
+  // The last string gives its end back to the heap.
+  char *s1             = heap->allocate_str(100);
+  uint32_t free_before = heap->m_read_write_heap->m_free_size;
+  heap->shrink_str(s1, 100, 40);
+  CHECK(heap->m_read_write_heap->m_free_size == free_before + 60);
+  CHECK(heap->m_lost_string_space == 0);
+
+  char *s2 = heap->allocate_str(10);
+  CHECK(s2 == s1 + 40);
+
+  // Any other string only has its end counted as lost.
+  heap->shrink_str(s1, 40, 30);
+  CHECK(heap->m_lost_string_space == 10);
+  CHECK(heap->allocate_str(1) == s2 + 10);
+
+  heap->destroy();
+}
+
+/**
+  Rewriting a field of a large header leaves dead strings behind. They are only coalesced once they
+  outweigh the live strings, and marshalling leaves them out.
+ */
+TEST_CASE("HdrHeap lost string space", "[proxy][hdrheap]")
+{
+  HdrHeap *heap = new_HdrHeap();
+  MIMEHdr hdr;
+  std::string value(200, 'v');
+
+  hdr.create(heap);
+  for (int i = 0; i < 40; ++i) {
+    std::string name = "X-Field-" + std::to_string(i);
+    hdr.value_set(name.data(), name.size(), value.data(), value.size());
+  }
+
+  int64_t coalesces = hdr_str_heap_stats.coalesce_count;
+  for (int i = 0; i < 100; ++i) {
+    std::string rewrite = std::to_string(i) + std::string(100, 'r');
+    hdr.value_set("X-Field-7", 9, rewrite.data(), rewrite.size());
+    hdr.value_append("X-Field-8", 9, "a", 1, true);
+  }
+  // Some 45K is lost on 8K of live strings, a coalesce for each 1K would be over 40.
+  CHECK(hdr_str_heap_stats.coalesce_count - coalesces <= 6);
+  int length;
+  const char *s = hdr.value_get("X-Field-7", 9, &length);
+  CHECK(std::string(s, length) == "99" + std::string(100, 'r'));
+  hdr.value_get("X-Field-8", 9, &length);
+  CHECK(length == 200 + 100 * 3);
+  CHECK(heap->m_lost_string_space > 1024);
+
+  int64_t marshals = hdr_str_heap_stats.marshal_count;
+  int marshal_len  = heap->marshal_length();
+  CHECK(hdr_str_heap_stats.marshal_count == marshals + 1);
+  CHECK(heap->m_lost_string_space == 0);
+  CHECK(marshal_len < heap->m_size + 40 * (200 + 10) + 102 + 500 + 1024);
+
+  heap->destroy();
+}
+
+/**
+  A reset heap holds new headers in its own block and string heap, but only keeps a string heap no
+  other heap shares.
+ */
+TEST_CASE("HdrHeap reset", "[proxy][hdrheap]")
+{
+  HdrHeap *heap = new_HdrHeap();
+  MIMEHdr hdr;
+  std::string value(100, 'v');
+
+  hdr.create(heap);
+  for (int i = 0; i < 200; ++i) {
+    std::string name = "X-Field-" + std::to_string(i);
+    hdr.value_set(name.data(), name.size(), value.data(), value.size());
+  }
+  REQUIRE(heap->m_next != nullptr);
+  HdrStrHeap *str_heap = heap->m_read_write_heap.get();
+
+  hdr.clear();
+  heap->reset();
+  CHECK(heap->m_next == nullptr);
+  CHECK(heap->m_free_size == heap->m_size - HDR_HEAP_HDR_SIZE);
+  CHECK(heap->m_read_write_heap.get() == str_heap);
+  CHECK(heap->m_read_write_heap->m_free_size == str_heap->m_heap_size - sizeof(HdrStrHeap));
+
+  hdr.create(heap);
+  hdr.value_set("X-Reused", 8, "yes", 3);
+  int length;
+  const char *s = hdr.value_get("X-Reused", 8, &length);
+  CHECK(std::string(s, length) == "yes");
+  CHECK(heap->m_read_write_heap->contains(s));
+
+  // A heap that inherited the strings keeps them alive, the reset one starts a new string heap.
+  HdrHeap *other = new_HdrHeap();
+  other->inherit_string_heaps(heap);
+  hdr.clear();
+  heap->reset();
+  CHECK(heap->m_read_write_heap.get() == nullptr);
+  other->destroy();
+
+  heap->destroy();
+}
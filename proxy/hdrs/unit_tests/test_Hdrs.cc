@@ -26,9 +26,11 @@
 #include <initializer_list>
 #include <array>
 #include <new>
+#include <vector>
 
 #include "catch.hpp"
 
+#include "tscore/ink_memory.h"
 #include "HTTP.h"
 
 // replaces test_http_parser_eos_boundary_cases
@@ -115,3 +117,249 @@ TEST_CASE("MIMEScanner_fragments", "[proxy][mimescanner_fragments]")
 
   REQUIRE(message == output);
 }
+
+TEST_CASE("HdrToken_tokenize", "[proxy][hdrtoken]")
+{
+  for (int i = 0; i < hdrtoken_num_wks; ++i) {
+    std::string name{hdrtoken_strs[i], size_t(hdrtoken_str_lengths[i])};
+    const char *wks = nullptr;
+
+    // A copy, not the WKS itself, so the hash table is used.
+    REQUIRE(hdrtoken_tokenize(name.data(), name.size(), &wks) == i);
+    REQUIRE(wks == hdrtoken_strs[i]);
+
+    std::string upper{name}, lower{name};
+    for (auto &c : upper) {
+      c = toupper(c);
+    }
+    for (auto &c : lower) {
+      c = tolower(c);
+    }
+    REQUIRE(hdrtoken_tokenize(upper.data(), upper.size()) == i);
+    REQUIRE(hdrtoken_tokenize(lower.data(), lower.size()) == i);
+
+    // Near misses.
+    REQUIRE(hdrtoken_tokenize(name.data(), name.size() - 1) != i);
+    std::string longer{name + "x"};
+    REQUIRE(hdrtoken_tokenize(longer.data(), longer.size()) != i);
+    std::string changed{name};
+    changed.back() ^= 0x40;
+    REQUIRE(hdrtoken_tokenize(changed.data(), changed.size()) != i);
+  }
+
+  REQUIRE(hdrtoken_tokenize("X-Not-Well-Known", 16) == -1);
+  REQUIRE(hdrtoken_tokenize("", 0) == -1);
+}
+
+TEST_CASE("HTTPCachePolicy", "[proxy][hdrtest]")
+{
+  constexpr ts::TextView const message = "HTTP/1.1 200 OK\r\n"
+                                         "Date: Sun, 06 Nov 1994 08:49:37 GMT\r\n"
+                                         "Last-Modified: Sat, 05 Nov 1994 08:49:37 GMT\r\n"
+                                         "Cache-Control: public, s-maxage=60, max-age=30\r\n"
+                                         "Age: 10\r\n"
+                                         "\r\n";
+  HTTPParser parser;
+  HTTPHdr resp_hdr;
+
+  http_parser_init(&parser);
+  resp_hdr.create(HTTP_TYPE_RESPONSE);
+
+  auto start = message.data();
+  REQUIRE(resp_hdr.parse_resp(&parser, &start, message.data_end(), true) == PARSE_RESULT_DONE);
+
+  HTTPCachePolicy policy(&resp_hdr);
+  REQUIRE(policy.cc_mask == resp_hdr.get_cooked_cc_mask());
+  REQUIRE((policy.cc_mask & MIME_COOKED_MASK_CC_S_MAXAGE) != 0);
+  REQUIRE(policy.cc_s_maxage == 60);
+  REQUIRE(policy.cc_max_age == 30);
+  REQUIRE(!policy.pragma_no_cache);
+  REQUIRE(!policy.has_expires);
+  REQUIRE(policy.has_last_modified);
+  REQUIRE(policy.date == 784111777);
+  REQUIRE(policy.last_modified == policy.date - 86400);
+  REQUIRE(policy.age == 10);
+  REQUIRE(policy.cc_stale_while_revalidate == -1);
+  REQUIRE(policy.cc_stale_if_error == -1);
+
+  // The policy is a copy, it is taken again after the response changes.
+  resp_hdr.set_age(20);
+  REQUIRE(policy.age == 10);
+  policy.init(&resp_hdr);
+  REQUIRE(policy.age == 20);
+
+  const char *cc = "max-age=30, Stale-While-Revalidate=600, stale-if-error=86400";
+  resp_hdr.value_set(MIME_FIELD_CACHE_CONTROL, MIME_LEN_CACHE_CONTROL, cc, strlen(cc));
+  policy.init(&resp_hdr);
+  REQUIRE(policy.cc_max_age == 30);
+  REQUIRE(policy.cc_stale_while_revalidate == 600);
+  REQUIRE(policy.cc_stale_if_error == 86400);
+
+  // Without a value the extension is ignored.
+  cc = "stale-while-revalidate, stale-if-errors=10";
+  resp_hdr.value_set(MIME_FIELD_CACHE_CONTROL, MIME_LEN_CACHE_CONTROL, cc, strlen(cc));
+  policy.init(&resp_hdr);
+  REQUIRE(policy.cc_stale_while_revalidate == -1);
+  REQUIRE(policy.cc_stale_if_error == -1);
+
+  resp_hdr.destroy();
+  http_parser_clear(&parser);
+}
+
+TEST_CASE("MIMEFieldIndex", "[proxy][hdrtest]")
+{
+  HdrHeap *heap = new_HdrHeap();
+  MIMEHdr hdr;
+  std::vector<std::string> names;
+
+  hdr.create(heap);
+  // Enough fields for an index, in several heap blocks.
+  for (int i = 0; i < 70; ++i) {
+    names.push_back("X-Custom-" + std::to_string(i));
+    hdr.value_set(names.back().data(), names.back().size(), "v", 1);
+  }
+  hdr.value_set("Cookie", 6, "a=b", 3);
+  hdr.value_append("Cookie", 6, "c=d", 3, true);
+  MIMEField *dup = hdr.field_create("x-custom-5", 10);
+  hdr.field_value_set(dup, "dup", 3);
+  hdr.field_attach(dup);
+  // A field created before the index is built and attached after.
+  MIMEField *pending = hdr.field_create("X-Pending", 9);
+
+  for (auto const &name : names) {
+    MIMEField *field = hdr.field_find(name.data(), name.size());
+    REQUIRE(field != nullptr);
+    REQUIRE(field == _mime_hdr_field_list_search_by_string(hdr.m_mime, name.data(), name.size()));
+  }
+  REQUIRE(hdr.m_mime->m_field_index != 0);
+  REQUIRE(hdr.field_find("X-Nope", 6) == nullptr);
+  REQUIRE(hdr.field_find("X-Pending", 9) == nullptr);
+  REQUIRE(hdr.field_find("X-CUSTOM-5", 10)->has_dups());
+
+  hdr.field_value_set(pending, "later", 5);
+  hdr.field_attach(pending);
+  REQUIRE(hdr.field_find("x-pending", 9) == pending);
+
+  // Deleting the dup head promotes the dup.
+  hdr.field_delete(hdr.field_find("X-Custom-5", 10), false);
+  REQUIRE(hdr.field_find("X-Custom-5", 10) == dup);
+  hdr.field_delete("X-Custom-7", 10);
+  REQUIRE(hdr.field_find("X-Custom-7", 10) == nullptr);
+
+  // Fields added after the index was built.
+  for (int i = 0; i < 40; ++i) {
+    std::string name = "X-Late-" + std::to_string(i);
+    hdr.value_set(name.data(), name.size(), "v", 1);
+    REQUIRE(hdr.field_find(name.data(), name.size()) != nullptr);
+    REQUIRE(hdr.field_find(names[10].data(), names[10].size()) ==
+            _mime_hdr_field_list_search_by_string(hdr.m_mime, names[10].data(), names[10].size()));
+  }
+  hdr.value_set("X-Custom-7", 10, "again", 5);
+  REQUIRE(hdr.field_find("X-Custom-7", 10) == _mime_hdr_field_list_search_by_string(hdr.m_mime, "X-Custom-7", 10));
+  REQUIRE(hdr.field_find(MIME_FIELD_COOKIE, MIME_LEN_COOKIE) != nullptr);
+
+  // A copy does not share the index, and the index is not marshalled.
+  HdrHeap *heap2 = new_HdrHeap();
+  MIMEHdr copy;
+  copy.create(heap2);
+  copy.copy(&hdr);
+  REQUIRE(copy.m_mime->m_field_index == 0);
+  for (auto const &name : names) {
+    REQUIRE(copy.field_find(name.data(), name.size()) ==
+            _mime_hdr_field_list_search_by_string(copy.m_mime, name.data(), name.size()));
+  }
+  REQUIRE(copy.m_mime->m_field_index != 0);
+
+  int length = heap2->marshal_length();
+  char *buffer = static_cast<char *>(ats_malloc(length));
+  REQUIRE(heap2->marshal(buffer, length) > 0);
+  HdrHeap *marshalled = reinterpret_cast<HdrHeap *>(buffer);
+  HdrHeapObjImpl *obj = nullptr;
+  REQUIRE(marshalled->unmarshal(length, HDR_HEAP_OBJ_MIME_HEADER, &obj, nullptr) > 0);
+  MIMEHdrImpl *mh = static_cast<MIMEHdrImpl *>(obj);
+  REQUIRE(mh->m_field_index == 0);
+  for (auto const &name : names) {
+    REQUIRE(mime_hdr_field_find(mh, name.data(), name.size(), marshalled) ==
+            _mime_hdr_field_list_search_by_string(mh, name.data(), name.size()));
+  }
+  ats_free(buffer);
+
+  hdr.fields_clear();
+  REQUIRE(hdr.m_mime->m_field_index == 0);
+  REQUIRE(hdr.field_find("X-Custom-1", 10) == nullptr);
+
+  heap->destroy();
+  heap2->destroy();
+}
+
+TEST_CASE("URLParse components", "[proxy][hdrtest]")
+{
+  struct Test {
+    ts::TextView url;
+    ts::TextView path, params, query, fragment;
+  };
+  static const std::array<Test, 6> tests = {{
+    {"http://example.com/a/b/c.html", "a/b/c.html", "", "", ""},
+    {"http://example.com/p;x=1?q=2#f", "p", "x=1", "q=2", "f"},
+    {"http://example.com/p?q=a;b#f?g", "p", "", "q=a;b", "f?g"},
+    {"http://user:pw@example.com:8080/a/path/longer/than/16/bytes?a=b", "a/path/longer/than/16/bytes", "", "a=b", ""},
+    {"http://example.com/p#", "p", "", "", ""},
+    {"http://[::1]:80/p;", "p", "", "", ""},
+  }};
+
+  for (auto const &test : tests) {
+    HdrHeap *heap = new_HdrHeap();
+    URL url;
+    url.create(heap);
+    const char *start = test.url.data();
+    REQUIRE(url.parse(&start, test.url.data_end()) == PARSE_RESULT_DONE);
+
+    int length;
+    const char *s = url.path_get(&length);
+    REQUIRE(ts::TextView(s, length) == test.path);
+    s = url.params_get(&length);
+    REQUIRE(ts::TextView(s, length) == test.params);
+    s = url.query_get(&length);
+    REQUIRE(ts::TextView(s, length) == test.query);
+    s = url.fragment_get(&length);
+    REQUIRE(ts::TextView(s, length) == test.fragment);
+    heap->destroy();
+  }
+}
+
+TEST_CASE("unescape_str", "[proxy][hdrtest]")
+{
+  struct Test {
+    ts::TextView in;
+    ts::TextView out;
+    int state;
+  };
+  static const std::array<Test, 5> tests = {{
+    {"/plain/path/that/is/longer/than/sixteen/bytes", "/plain/path/that/is/longer/than/sixteen/bytes", 0},
+    {"/a%20b%2Fc%2fd", "/a b/c/d", 0},
+    {"%zz%4%41", "%zz%4A", 0},
+    {"100%", "100", 1}, // the escape is cut short, the rest is in the state
+    {"%e2%82%ac and some more text after the escape", "\xe2\x82\xac and some more text after the escape", 0},
+  }};
+
+  for (auto const &test : tests) {
+    char buffer[128];
+    char *buf       = buffer;
+    const char *str = test.in.data();
+    int state       = 0;
+
+    unescape_str(buf, buffer + sizeof(buffer), str, test.in.data_end(), state);
+    REQUIRE(ts::TextView(buffer, buf) == test.out);
+    REQUIRE(state == test.state);
+
+    // In place, a byte at a time so each call resumes from the state of the one before.
+    std::string copy(test.in);
+    buf   = copy.data();
+    state = 0;
+    for (const char *s = copy.data(); s < copy.data() + copy.size();) {
+      unescape_str(buf, copy.data() + copy.size(), s, s + 1, state);
+    }
+    REQUIRE(ts::TextView(copy.data(), buf) == test.out);
+    REQUIRE(state == test.state);
+  }
+}
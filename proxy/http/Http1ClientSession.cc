@@ -36,7 +36,9 @@
 #include "HttpSM.h"
 #include "HttpDebugNames.h"
 #include "Http1ServerSession.h"
+#include "HttpSessionAccept.h"
 #include "Plugin.h"
+#include "PluginVC.h"
 
 #define HttpSsnDebug(fmt, ...) SsnDebug(this, "http_cs", fmt, __VA_ARGS__)
 
@@ -62,6 +64,96 @@ ink_mutex debug_cs_list_mutex;
 
 ClassAllocator<Http1ClientSession> http1ClientSessionAllocator("http1ClientSessionAllocator");
 
+extern HttpSessionAccept *plugin_http_accept;
+
+namespace
+{
+/** An internal request for a pipelined request, made ahead of its turn to fill the cache.
+
+    The response is read and thrown away, the request asks for the connection to be closed so its
+    end is the end of the fetch.
+ */
+class PipelinePrefetch : public Continuation
+{
+public:
+  PipelinePrefetch(PluginVC *vc) : Continuation(new_ProxyMutex()), _vc(vc) { SET_HANDLER(&PipelinePrefetch::state_fetch); }
+
+  void
+  start(HTTPHdr *request, ink_hrtime timeout)
+  {
+    SCOPED_MUTEX_LOCK(lock, mutex, this_ethread());
+
+    _request_buffer                = new_MIOBuffer(BUFFER_SIZE_INDEX_4K);
+    IOBufferReader *request_reader = _request_buffer->alloc_reader();
+    int64_t request_len            = write_header(request);
+    _response_buffer               = new_MIOBuffer(BUFFER_SIZE_INDEX_32K);
+    _response_reader               = _response_buffer->alloc_reader();
+
+    _vc->set_inactivity_timeout(timeout);
+    _vc->do_io_write(this, request_len, request_reader);
+    _vc->do_io_read(this, INT64_MAX, _response_buffer);
+  }
+
+private:
+  int64_t
+  write_header(HTTPHdr *h)
+  {
+    int64_t total = 0;
+    int done;
+
+    do {
+      IOBufferBlock *block = _request_buffer->get_current_block();
+      int bufindex         = 0;
+      int tmp              = total;
+
+      done = h->print(block->end(), block->write_avail(), &bufindex, &tmp);
+      total += bufindex;
+      _request_buffer->fill(bufindex);
+      if (!done) {
+        _request_buffer->add_block();
+      }
+    } while (!done);
+
+    return total;
+  }
+
+  int
+  state_fetch(int event, void *data)
+  {
+    switch (event) {
+    case VC_EVENT_READ_READY:
+      _response_reader->consume(_response_reader->read_avail());
+      static_cast<VIO *>(data)->reenable();
+      return EVENT_CONT;
+    case VC_EVENT_WRITE_READY:
+    case VC_EVENT_WRITE_COMPLETE:
+      return EVENT_CONT;
+    default: // VC_EVENT_EOS, VC_EVENT_READ_COMPLETE, the errors and the timeouts
+      break;
+    }
+
+    _vc->do_io_close();
+    free_MIOBuffer(_request_buffer);
+    free_MIOBuffer(_response_buffer);
+    delete this;
+    return EVENT_DONE;
+  }
+
+  PluginVC *_vc;
+  MIOBuffer *_request_buffer       = nullptr;
+  MIOBuffer *_response_buffer      = nullptr;
+  IOBufferReader *_response_reader = nullptr;
+};
+
+// A pipelined request that can be fetched ahead: a GET that the cache can answer for everyone.
+bool
+is_prefetchable(HTTPHdr *request)
+{
+  return request->method_get_wksidx() == HTTP_WKSIDX_GET && !request->presence(MIME_PRESENCE_AUTHORIZATION | MIME_PRESENCE_RANGE);
+}
+
+} // namespace
+
 Http1ClientSession::Http1ClientSession() {}
 
 void
@@ -234,6 +326,7 @@ Http1ClientSession::do_io_close(int alerrno)
 
   // Prevent double closing
   ink_release_assert(read_state != HCS_CLOSED);
+  this->cancel_rebalance();
 
   // If we have an attached server session, release
   //   it back to our shared pool
@@ -367,7 +460,10 @@ Http1ClientSession::state_keep_alive(int event, void *data)
 {
   // Route the event.  It is either for client vc or
   //  the origin server slave vc
-  if (data && data == slave_ka_vio) {
+  if (event == NET_EVENT_MIGRATE) {
+    this->finish_rebalance(read_state == HCS_KEEP_ALIVE && bound_ss == nullptr);
+    return 0;
+  } else if (data && data == slave_ka_vio) {
     return state_slave_keep_alive(event, data);
   } else {
     ink_assert(data && data == ka_vio);
@@ -425,24 +521,85 @@ Http1ClientSession::release(ProxyTransaction *trans)
   if (more_to_read) {
     trans->destroy();
     trans->set_restart_immediate(true);
+    if (pipeline_prefetched > 0) {
+      --pipeline_prefetched;
+    }
     HttpSsnDebug("[%" PRId64 "] data already in buffer, starting new transaction", con_id);
     new_transaction();
   } else {
     HttpSsnDebug("[%" PRId64 "] initiating io for next header", con_id);
     trans->set_restart_immediate(false);
-    read_state = HCS_KEEP_ALIVE;
+    read_state          = HCS_KEEP_ALIVE;
+    pipeline_prefetched = 0;
     SET_HANDLER(&Http1ClientSession::state_keep_alive);
+    // Don't hold the buffer memory while waiting, it comes back with the next request.
+    HTTP_SUM_DYN_STAT(http_keep_alive_buffer_bytes_released_stat, read_buffer->release_blocks());
     ka_vio = this->do_io_read(this, INT64_MAX, read_buffer);
     ink_assert(slave_ka_vio != ka_vio);
 
     if (client_vc) {
       client_vc->cancel_active_timeout();
+      // A bound server session stays on this thread, keep the client with it.
+      if (bound_ss == nullptr) {
+        this->rebalance();
+      }
       client_vc->add_to_keep_alive_queue();
     }
     trans->destroy();
   }
 }
 
+void
+Http1ClientSession::prefetch_pipelined(IOBufferReader *reader, int max_requests, ink_hrtime timeout)
+{
+  // The internal requests are plain HTTP, the remap rules of TLS requests need not match them.
+  if (plugin_http_accept == nullptr || client_vc == nullptr || protocol_contains("tls") != nullptr) {
+    return;
+  }
+
+  // Parse the requests out of a clone of the reader, they are parsed again when their turn comes.
+  IOBufferReader *ahead = reader->clone();
+  int n;
+
+  for (n = 0; n < max_requests && ahead->is_read_avail_more_than(0); ++n) {
+    HTTPParser parser;
+    HTTPHdr request;
+    int bytes_used = 0;
+
+    http_parser_init(&parser);
+    request.create(HTTP_TYPE_REQUEST);
+    ParseResult result = request.parse_req(&parser, ahead, &bytes_used, false);
+    http_parser_clear(&parser);
+
+    // Stop at an incomplete request, and at a body, the next request can not be found without reading it.
+    if (result != PARSE_RESULT_DONE || request.presence(MIME_PRESENCE_TRANSFER_ENCODING) || request.get_content_length() > 0) {
+      request.destroy();
+      break;
+    }
+
+    if (n >= pipeline_prefetched && is_prefetchable(&request)) {
+      PluginVCCore *core = PluginVCCore::alloc(plugin_http_accept);
+      core->set_active_addr(get_client_addr());
+      core->set_plugin_tag("pipeline");
+
+      PluginVC *vc = core->connect();
+      if (vc != nullptr) {
+        if (vc->get_other_side() != nullptr) {
+          vc->get_other_side()->set_is_internal_request(true);
+        }
+        HttpSsnDebug("[%" PRId64 "] fetching pipelined request %d ahead", con_id, n + 1);
+        request.value_set(MIME_FIELD_CONNECTION, MIME_LEN_CONNECTION, "close", 5);
+        (new PipelinePrefetch(vc))->start(&request, timeout);
+        HTTP_INCREMENT_DYN_STAT(http_pipeline_prefetch_requests_stat);
+      }
+    }
+    request.destroy();
+  }
+
+  pipeline_prefetched = std::max(pipeline_prefetched, n);
+  ahead->dealloc();
+}
+
 void
 Http1ClientSession::new_transaction()
 {
@@ -455,6 +612,7 @@ Http1ClientSession::new_transaction()
   // Defensive programming, make sure nothing persists across
   // connection re-use
   half_close = false;
+  this->cancel_rebalance();
 
   read_state = HCS_ACTIVE_READER;
 
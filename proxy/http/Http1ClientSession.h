@@ -121,6 +121,8 @@ public:
   // Indicate we are done with a transaction
   void release(ProxyTransaction *trans) override;
 
+  void prefetch_pipelined(IOBufferReader *reader, int max_requests, ink_hrtime timeout) override;
+
   void attach_server_session(Http1ServerSession *ssession, bool transaction_done = true) override;
 
   Http1ServerSession *
@@ -200,6 +202,9 @@ private:
 
   int released_transactions = 0;
 
+  /// The requests pipelined after the current one that were already fetched ahead.
+  int pipeline_prefetched = 0;
+
 public:
   // Link<Http1ClientSession> debug_link;
   LINK(Http1ClientSession, debug_link);
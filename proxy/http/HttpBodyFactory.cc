@@ -39,6 +39,7 @@
 #include "URL.h"
 #include "logging/Log.h"
 #include "logging/LogAccess.h"
+#include "logging/LogFormat.h"
 #include "HttpCompat.h"
 #include "tscore/I_Layout.h"
 
@@ -1069,6 +1070,35 @@ HttpBodyTemplate::reset()
   template_buffer = nullptr;
   byte_count      = 0;
   ats_free(template_pathname);
+  template_pathname = nullptr;
+  ats_free(printf_str);
+  printf_str = nullptr;
+  fields.reset();
+}
+
+// Divide the template into its text and its log fields, so that each
+// instantiation only has to marshal the fields and not parse them again.
+void
+HttpBodyTemplate::compile()
+{
+  char *fields_str = nullptr;
+  int n_fields     = LogFormat::parse_format_string(template_buffer, &printf_str, &fields_str);
+
+  if (n_fields == 0) {
+    ats_free(printf_str);
+    printf_str = nullptr;
+  } else {
+    bool contains_aggregates;
+    fields.reset(new LogFieldList);
+    int field_count = LogFormat::parse_symbol_string(fields_str, fields.get(), &contains_aggregates);
+    if (field_count != n_fields) {
+      // As with resolve_logfield_string(), the template instantiates to nothing.
+      Warning("template file '%s' contains %d invalid field symbols", template_pathname, n_fields - field_count);
+      ats_free(printf_str);
+      printf_str = nullptr;
+    }
+  }
+  ats_free(fields_str);
 }
 
 int
@@ -1137,6 +1167,8 @@ HttpBodyTemplate::load_from_file(char *dir, char *file)
   byte_count        = new_byte_count;
   template_pathname = ats_strdup(path);
 
+  compile();
+
   return 1;
 }
 
@@ -1147,9 +1179,12 @@ HttpBodyTemplate::build_instantiated_buffer(HttpTransact::State *context, int64_
 
   Debug("body_factory_instantiation", "    before instantiation: [%s]", template_buffer);
 
-  LogAccess la(context->state_machine);
-
-  buffer = resolve_logfield_string(&la, template_buffer);
+  if (fields == nullptr) {
+    buffer = ats_strdup(template_buffer);
+  } else if (printf_str != nullptr) {
+    LogAccess la(context->state_machine);
+    buffer = resolve_logfield_string(&la, fields.get(), printf_str);
+  }
 
   *buflen_return = ((buffer == nullptr) ? 0 : strlen(buffer));
   Debug("body_factory_instantiation", "    after instantiation: [%s]", buffer);
@@ -66,6 +66,8 @@
 #include <memory>
 #include <unordered_map>
 
+class LogFieldList;
+
 #define HTTP_BODY_TEMPLATE_MAGIC 0xB0DFAC00
 #define HTTP_BODY_SET_MAGIC 0xB0DFAC55
 #define HTTP_BODY_FACTORY_MAGIC 0xB0DFACFF
@@ -77,7 +79,9 @@
 //      An HttpBodyTemplate object represents a template with HTML
 //      text, and unexpanded log fields.  The object also has methods
 //      to dump out the contents of the template, and to instantiate
-//      the template into a buffer given a context.
+//      the template into a buffer given a context.  The log fields
+//      are parsed when the template is loaded, instantiating it only
+//      resolves them.
 //
 ////////////////////////////////////////////////////////////////////////
 
@@ -100,6 +104,12 @@ public:
   int64_t byte_count;
   char *template_buffer;
   char *template_pathname;
+
+private:
+  void compile();
+
+  char *printf_str = nullptr;           ///< The text with markers for the log fields, none if the fields are invalid.
+  std::unique_ptr<LogFieldList> fields; ///< The log fields of the template, none if it has no fields.
 };
 
 ////////////////////////////////////////////////////////////////////////
@@ -111,11 +111,23 @@ HttpCacheSM::state_cache_open_read(int event, void *data)
     }
     open_read_cb  = true;
     cache_read_vc = (CacheVConnection *)data;
+    if (write_locked) {
+      // The read stands in for the failed write, HttpSM serves it as a read retry.
+      write_locked  = false;
+      open_write_cb = true;
+    }
     master_sm->handleEvent(event, data);
     break;
 
   case CACHE_EVENT_OPEN_READ_FAILED:
-    if ((intptr_t)data == -ECACHE_DOC_BUSY) {
+    if (write_locked) {
+      // Reading from the writer that holds the write lock did not work out, the cache has
+      // already waited for it. Fail the write as it would have without the read.
+      write_locked  = false;
+      open_read_cb  = true;
+      open_write_cb = true;
+      master_sm->handleEvent(CACHE_EVENT_OPEN_WRITE_FAILED, (void *)-ECACHE_DOC_BUSY);
+    } else if ((intptr_t)data == -ECACHE_DOC_BUSY) {
       // Somebody else is writing the object
       if (open_read_tries <= master_sm->t_state.txn_conf->max_cache_open_read_retries) {
         // Retry to read; maybe the update finishes in time
@@ -171,7 +183,15 @@ HttpCacheSM::state_cache_open_write(int event, void *data)
     break;
 
   case CACHE_EVENT_OPEN_WRITE_FAILED:
-    if (open_write_tries <= master_sm->t_state.txn_conf->max_cache_open_write_retries) {
+    if (read_from_writer((intptr_t)data)) {
+      // Another transaction is writing the object, follow it through the cache rather than
+      // poll for the write lock.
+      Debug("http_cache", "[%" PRId64 "] [state_cache_open_write] write locked, reading from the writer", master_sm->sm_id);
+      write_locked  = true;
+      open_write_cb = false;
+      SET_HANDLER(&HttpCacheSM::state_cache_open_read);
+      do_cache_open_read(cache_key);
+    } else if (open_write_tries <= master_sm->t_state.txn_conf->max_cache_open_write_retries) {
       // Retry open write;
       open_write_cb = false;
       do_schedule_in();
@@ -209,6 +229,19 @@ HttpCacheSM::state_cache_open_write(int event, void *data)
   return VC_EVENT_CONT;
 }
 
+/* Whether a failed open write should become a read of the object the write lock holder is
+   writing. The cache parks that read until the writer has the response headers and the first
+   fragment, so followers are woken by the writer instead of retrying on a timer.
+ */
+bool
+HttpCacheSM::read_from_writer(intptr_t err) const
+{
+  HttpTransact::State const &s = master_sm->t_state;
+
+  return err == -ECACHE_DOC_BUSY && s.txn_conf->cache_open_write_fail_action == HttpTransact::CACHE_WL_FAIL_ACTION_READ_RETRY &&
+         !write_locked && !s.cache_info.object_read && !s.redirect_info.redirect_in_process && read_request_hdr && http_params;
+}
+
 void
 HttpCacheSM::do_schedule_in()
 {
@@ -137,6 +137,12 @@ public:
     return cache_read_vc ? (cache_read_vc->get_volume_number()) : -1;
   }
 
+  const HttpCacheKey &
+  get_cache_key() const
+  {
+    return cache_key;
+  }
+
   inline void
   abort_read()
   {
@@ -184,6 +190,7 @@ public:
 
 private:
   void do_schedule_in();
+  bool read_from_writer(intptr_t err) const;
   Action *do_cache_open_read(const HttpCacheKey &);
 
   int state_cache_open_read(int event, void *data);
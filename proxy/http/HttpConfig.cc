@@ -115,7 +115,8 @@ static const ConfigEnumPair<TSServerSessionSharingMatchType> SessionSharingMatch
 
 static const ConfigEnumPair<TSServerSessionSharingPoolType> SessionSharingPoolStrings[] = {
   {TS_SERVER_SESSION_SHARING_POOL_GLOBAL, "global"},
-  {TS_SERVER_SESSION_SHARING_POOL_THREAD, "thread"}};
+  {TS_SERVER_SESSION_SHARING_POOL_THREAD, "thread"},
+  {TS_SERVER_SESSION_SHARING_POOL_HYBRID, "hybrid"}};
 
 int HttpConfig::m_id = 0;
 HttpConfigParams HttpConfig::m_master;
@@ -206,6 +207,27 @@ http_insert_forwarded_cb(const char *name, RecDataT dtype, RecData data, void *c
   return REC_ERR_OKAY;
 }
 
+// The string heap counts are kept by HdrHeap, which does not have the HTTP raw stats.
+static int
+hdr_str_heap_stat_sync(const char *, RecDataT data_type, RecData *data, RecRawStatBlock *, int id)
+{
+  int64_t value = 0;
+
+  switch (id) {
+  case http_header_heap_str_coalesce_stat:
+    value = hdr_str_heap_stats.coalesce_count.load(std::memory_order_relaxed);
+    break;
+  case http_header_heap_str_coalesce_bytes_stat:
+    value = hdr_str_heap_stats.coalesce_bytes.load(std::memory_order_relaxed);
+    break;
+  case http_header_heap_marshal_coalesce_stat:
+    value = hdr_str_heap_stats.marshal_count.load(std::memory_order_relaxed);
+    break;
+  }
+  RecDataSetFromInt64(data_type, data, value);
+  return REC_ERR_OKAY;
+}
+
 void
 register_stat_callbacks()
 {
@@ -230,6 +252,12 @@ register_stat_callbacks()
   RecRegisterRawStat(http_rsb, RECT_PROCESS, "proxy.process.http.current_server_transactions", RECD_INT, RECP_NON_PERSISTENT,
                      (int)http_current_server_transactions_stat, RecRawStatSyncSum);
   HTTP_CLEAR_DYN_STAT(http_current_server_transactions_stat);
+  RecRegisterRawStat(http_rsb, RECT_PROCESS, "proxy.process.http.keep_alive_buffer_bytes_released", RECD_COUNTER, RECP_PERSISTENT,
+                     (int)http_keep_alive_buffer_bytes_released_stat, RecRawStatSyncSum);
+  RecRegisterRawStat(http_rsb, RECT_PROCESS, "proxy.process.http.overload_shed_requests", RECD_COUNTER, RECP_PERSISTENT,
+                     (int)http_overload_shed_requests_stat, RecRawStatSyncSum);
+  RecRegisterRawStat(http_rsb, RECT_PROCESS, "proxy.process.http.pipeline_prefetch_requests", RECD_COUNTER, RECP_PERSISTENT,
+                     (int)http_pipeline_prefetch_requests_stat, RecRawStatSyncSum);
   // Total connections stats
 
   RecRegisterRawStat(http_rsb, RECT_PROCESS, "proxy.process.http.completed_requests", RECD_COUNTER, RECP_PERSISTENT,
@@ -500,6 +528,9 @@ register_stat_callbacks()
   RecRegisterRawStat(http_rsb, RECT_PROCESS, "proxy.process.http.cache_hit_stale_served", RECD_COUNTER, RECP_PERSISTENT,
                      (int)http_cache_hit_stale_served_stat, RecRawStatSyncCount);
 
+  RecRegisterRawStat(http_rsb, RECT_PROCESS, "proxy.process.http.cache_invalidated", RECD_COUNTER, RECP_PERSISTENT,
+                     (int)http_cache_invalidated_stat, RecRawStatSyncCount);
+
   RecRegisterRawStat(http_rsb, RECT_PROCESS, "proxy.process.http.cache_miss_cold", RECD_COUNTER, RECP_PERSISTENT,
                      (int)http_cache_miss_cold_stat, RecRawStatSyncCount);
 
@@ -858,6 +889,16 @@ register_stat_callbacks()
                      (int)https_total_client_connections_stat, RecRawStatSyncCount);
   RecRegisterRawStat(http_rsb, RECT_PROCESS, "proxy.process.http.origin_connections_throttled_out", RECD_COUNTER, RECP_PERSISTENT,
                      (int)http_origin_connections_throttled_stat, RecRawStatSyncCount);
+  RecRegisterRawStat(http_rsb, RECT_PROCESS, "proxy.process.http.origin_session_pool_hits", RECD_COUNTER, RECP_PERSISTENT,
+                     (int)http_origin_session_pool_hit_stat, RecRawStatSyncCount);
+  RecRegisterRawStat(http_rsb, RECT_PROCESS, "proxy.process.http.origin_session_pool_steals", RECD_COUNTER, RECP_PERSISTENT,
+                     (int)http_origin_session_pool_steal_stat, RecRawStatSyncCount);
+  RecRegisterRawStat(http_rsb, RECT_PROCESS, "proxy.process.http.origin_session_pool_misses", RECD_COUNTER, RECP_PERSISTENT,
+                     (int)http_origin_session_pool_miss_stat, RecRawStatSyncCount);
+  RecRegisterRawStat(http_rsb, RECT_PROCESS, "proxy.process.http.origin_prewarmed_connections", RECD_COUNTER, RECP_PERSISTENT,
+                     (int)http_origin_prewarmed_connections_stat, RecRawStatSyncCount);
+  RecRegisterRawStat(http_rsb, RECT_PROCESS, "proxy.process.http.origin_connect_races", RECD_COUNTER, RECP_PERSISTENT,
+                     (int)http_origin_connect_races_stat, RecRawStatSyncCount);
   RecRegisterRawStat(http_rsb, RECT_PROCESS, "proxy.process.http.post_body_too_large", RECD_COUNTER, RECP_PERSISTENT,
                      (int)http_post_body_too_large, RecRawStatSyncCount);
   // milestones
@@ -901,6 +942,13 @@ register_stat_callbacks()
                      (int)http_sm_start_time_stat, RecRawStatSyncSum);
   RecRegisterRawStat(http_rsb, RECT_PROCESS, "proxy.process.http.milestone.sm_finish", RECD_COUNTER, RECP_PERSISTENT,
                      (int)http_sm_finish_time_stat, RecRawStatSyncSum);
+
+  RecRegisterRawStat(http_rsb, RECT_PROCESS, "proxy.process.http.header_heap.str_coalesce_count", RECD_COUNTER,
+                     RECP_NON_PERSISTENT, (int)http_header_heap_str_coalesce_stat, hdr_str_heap_stat_sync);
+  RecRegisterRawStat(http_rsb, RECT_PROCESS, "proxy.process.http.header_heap.str_coalesce_bytes", RECD_COUNTER,
+                     RECP_NON_PERSISTENT, (int)http_header_heap_str_coalesce_bytes_stat, hdr_str_heap_stat_sync);
+  RecRegisterRawStat(http_rsb, RECT_PROCESS, "proxy.process.http.header_heap.marshal_coalesce_count", RECD_COUNTER,
+                     RECP_NON_PERSISTENT, (int)http_header_heap_marshal_coalesce_stat, hdr_str_heap_stat_sync);
 }
 
 static bool
@@ -984,6 +1032,7 @@ HttpConfig::startup()
 
   HttpEstablishStaticConfigLongLong(c.server_max_connections, "proxy.config.http.server_max_connections");
   HttpEstablishStaticConfigLongLong(c.max_websocket_connections, "proxy.config.http.websocket.max_number_of_connections");
+  HttpEstablishStaticConfigLongLong(c.pipeline_prefetch_max, "proxy.config.http.pipeline_prefetch_max");
   HttpEstablishStaticConfigLongLong(c.origin_min_keep_alive_connections, "proxy.config.http.per_server.min_keep_alive");
   HttpEstablishStaticConfigByte(c.oride.attach_server_session_to_client, "proxy.config.http.attach_server_session_to_client");
 
@@ -997,6 +1046,7 @@ HttpConfig::startup()
   HttpEstablishStaticConfigByte(c.no_origin_server_dns, "proxy.config.http.no_origin_server_dns");
   HttpEstablishStaticConfigByte(c.use_client_target_addr, "proxy.config.http.use_client_target_addr");
   HttpEstablishStaticConfigByte(c.use_client_source_port, "proxy.config.http.use_client_source_port");
+  HttpEstablishStaticConfigLongLong(c.connect_race_delay, "proxy.config.http.connect.race_delay");
   HttpEstablishStaticConfigByte(c.oride.maintain_pristine_host_hdr, "proxy.config.url_remap.pristine_host_hdr");
 
   HttpEstablishStaticConfigByte(c.oride.insert_request_via_string, "proxy.config.http.insert_request_via_str");
@@ -1084,6 +1134,10 @@ HttpConfig::startup()
   HttpEstablishStaticConfigLongLong(c.oride.sock_packet_mark_out, "proxy.config.net.sock_packet_mark_out");
   HttpEstablishStaticConfigLongLong(c.oride.sock_packet_tos_out, "proxy.config.net.sock_packet_tos_out");
 
+  HttpEstablishStaticConfigStringAlloc(c.oride.sock_congestion_control_in, "proxy.config.net.sock_congestion_control_in");
+  HttpEstablishStaticConfigLongLong(c.oride.sock_pacing_rate_in, "proxy.config.net.sock_pacing_rate_in");
+  HttpEstablishStaticConfigLongLong(c.oride.sock_notsent_lowat_in, "proxy.config.net.sock_notsent_lowat_in");
+
   HttpEstablishStaticConfigByte(c.oride.fwd_proxy_auth_to_parent, "proxy.config.http.forward.proxy_auth_to_parent");
 
   HttpEstablishStaticConfigByte(c.oride.anonymize_remove_from, "proxy.config.http.anonymize_remove_from");
@@ -1213,6 +1267,10 @@ HttpConfig::startup()
   HttpEstablishStaticConfigByte(c.redirection_host_no_port, "proxy.config.http.redirect_host_no_port");
   HttpEstablishStaticConfigLongLong(c.oride.number_of_redirections, "proxy.config.http.number_of_redirections");
   HttpEstablishStaticConfigLongLong(c.post_copy_size, "proxy.config.http.post_copy_size");
+  HttpEstablishStaticConfigLongLong(c.request_buffer_max_size, "proxy.config.http.request_buffer_max_size");
+  HttpEstablishStaticConfigByte(c.tunnel_buffer_autotune, "proxy.config.http.tunnel_buffer_autotune");
+  HttpEstablishStaticConfigLongLong(c.tunnel_buffer_max_water_mark, "proxy.config.http.tunnel_buffer_max_water_mark");
+  HttpEstablishStaticConfigLongLong(c.tunnel_buffer_budget, "proxy.config.http.tunnel_buffer_budget");
   HttpEstablishStaticConfigStringAlloc(c.redirect_actions_string, "proxy.config.http.redirect.actions");
 
   HttpEstablishStaticConfigStringAlloc(c.oride.ssl_client_sni_policy, "proxy.config.ssl.client.sni_policy");
@@ -1255,6 +1313,7 @@ HttpConfig::reconfigure()
   params->no_origin_server_dns                     = INT_TO_BOOL(m_master.no_origin_server_dns);
   params->use_client_target_addr                   = m_master.use_client_target_addr;
   params->use_client_source_port                   = INT_TO_BOOL(m_master.use_client_source_port);
+  params->connect_race_delay                       = m_master.connect_race_delay;
   params->oride.maintain_pristine_host_hdr         = INT_TO_BOOL(m_master.oride.maintain_pristine_host_hdr);
 
   params->disable_ssl_parenting        = INT_TO_BOOL(m_master.disable_ssl_parenting);
@@ -1262,6 +1321,7 @@ HttpConfig::reconfigure()
 
   params->server_max_connections    = m_master.server_max_connections;
   params->max_websocket_connections = m_master.max_websocket_connections;
+  params->pipeline_prefetch_max     = m_master.pipeline_prefetch_max;
   params->oride.outbound_conntrack  = m_master.oride.outbound_conntrack;
   // If queuing for outbound connection tracking is enabled without enabling max connections, it is meaningless, so we'll warn
   if (params->outbound_conntrack.queue_size > 0 &&
@@ -1357,6 +1417,10 @@ HttpConfig::reconfigure()
   params->oride.sock_packet_tos_out       = m_master.oride.sock_packet_tos_out;
   params->oride.sock_option_flag_out      = m_master.oride.sock_option_flag_out;
 
+  params->oride.sock_congestion_control_in = ats_strdup(m_master.oride.sock_congestion_control_in);
+  params->oride.sock_pacing_rate_in        = m_master.oride.sock_pacing_rate_in;
+  params->oride.sock_notsent_lowat_in      = m_master.oride.sock_notsent_lowat_in;
+
   // Clear the TCP Fast Open option if it is not supported on this host.
   if ((params->oride.sock_option_flag_out & NetVCOptions::SOCK_OPT_TCP_FAST_OPEN) && !SocketManager::fastopen_supported()) {
     Status("disabling unsupported TCP Fast Open flag on proxy.config.net.sock_option_flag_out");
@@ -1480,6 +1544,10 @@ HttpConfig::reconfigure()
   params->redirection_host_no_port          = INT_TO_BOOL(m_master.redirection_host_no_port);
   params->oride.number_of_redirections      = m_master.oride.number_of_redirections;
   params->post_copy_size                    = m_master.post_copy_size;
+  params->request_buffer_max_size           = m_master.request_buffer_max_size;
+  params->tunnel_buffer_autotune            = INT_TO_BOOL(m_master.tunnel_buffer_autotune);
+  params->tunnel_buffer_max_water_mark      = m_master.tunnel_buffer_max_water_mark;
+  params->tunnel_buffer_budget              = m_master.tunnel_buffer_budget;
   params->redirect_actions_string           = ats_strdup(m_master.redirect_actions_string);
   params->redirect_actions_map = parse_redirect_actions(params->redirect_actions_string, params->redirect_actions_self_action);
 
@@ -67,6 +67,9 @@ enum {
   http_current_client_transactions_stat,
   http_total_incoming_connections_stat,
   http_current_server_transactions_stat,
+  http_keep_alive_buffer_bytes_released_stat,
+  http_overload_shed_requests_stat,
+  http_pipeline_prefetch_requests_stat,
 
   //  Http Abort information (from HttpNetConnection)
   http_ua_msecs_counts_errors_pre_accept_hangups_stat,
@@ -181,6 +184,7 @@ enum {
   http_cache_hit_reval_stat,
   http_cache_hit_ims_stat,
   http_cache_hit_stale_served_stat,
+  http_cache_invalidated_stat,
   http_cache_miss_cold_stat,
   http_cache_miss_changed_stat,
   http_cache_miss_client_no_cache_stat,
@@ -327,6 +331,15 @@ enum {
   http_sm_finish_time_stat,
 
   http_origin_connections_throttled_stat,
+  http_origin_session_pool_hit_stat,
+  http_origin_session_pool_steal_stat,
+  http_origin_session_pool_miss_stat,
+  http_origin_prewarmed_connections_stat,
+  http_origin_connect_races_stat,
+
+  http_header_heap_str_coalesce_stat,
+  http_header_heap_str_coalesce_bytes_stat,
+  http_header_heap_marshal_coalesce_stat,
 
   http_stat_count
 };
@@ -583,6 +596,13 @@ struct OverridableHttpConfigParams {
   MgmtInt sock_packet_mark_out      = 0;
   MgmtInt sock_packet_tos_out       = 0;
 
+  ///////////////////////////////////////
+  // client connection settings        //
+  ///////////////////////////////////////
+  char *sock_congestion_control_in = nullptr;
+  MgmtInt sock_pacing_rate_in      = 0;
+  MgmtInt sock_notsent_lowat_in    = 0;
+
   ///////////////
   // Hdr Limit //
   ///////////////
@@ -708,6 +728,7 @@ public:
   MgmtInt server_max_connections            = 0;
   MgmtInt origin_min_keep_alive_connections = 0; // TODO: This one really ought to be overridable, but difficult right now.
   MgmtInt max_websocket_connections         = -1;
+  MgmtInt pipeline_prefetch_max             = 0; ///< Most pipelined requests to fetch ahead of their turn.
 
   char *proxy_request_via_string    = nullptr;
   char *proxy_response_via_string   = nullptr;
@@ -732,8 +753,20 @@ public:
   int reverse_proxy_no_host_redirect_len = 0;
   int proxy_hostname_len                 = 0;
 
-  MgmtInt post_copy_size = 2048;
-  MgmtInt max_post_size  = 0;
+  MgmtInt post_copy_size          = 2048;
+  MgmtInt max_post_size           = 0;
+  MgmtInt request_buffer_max_size = 0;
+
+  MgmtByte tunnel_buffer_autotune      = 0;
+  MgmtInt tunnel_buffer_max_water_mark = 16777216;
+  MgmtInt tunnel_buffer_budget         = 268435456;
+
+  /// The most a request body is buffered before it is sent when request_buffer_enabled.
+  int64_t
+  request_buffer_limit() const
+  {
+    return request_buffer_max_size > 0 ? request_buffer_max_size : post_copy_size;
+  }
 
   char *redirect_actions_string                        = nullptr;
   IpMap *redirect_actions_map                          = nullptr;
@@ -748,6 +781,7 @@ public:
   MgmtByte no_origin_server_dns     = 0;
   MgmtByte use_client_target_addr   = 0;
   MgmtByte use_client_source_port   = 0;
+  MgmtInt connect_race_delay        = 0;
 
   MgmtByte enable_http_stats = 1; // Can be "slow"
 
@@ -844,6 +878,7 @@ inline HttpConfigParams::~HttpConfigParams()
   ats_free(reverse_proxy_no_host_redirect);
   ats_free(redirect_actions_string);
   ats_free(oride.ssl_client_sni_policy);
+  ats_free(oride.sock_congestion_control_in);
 
   delete connect_ports;
   delete redirect_actions_map;
@@ -0,0 +1,216 @@
+/** @file
+
+  Connections to an origin server raced across its addresses.
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ */
+
+#include "HttpConnectRace.h"
+
+#include <algorithm>
+
+#include "P_Net.h"
+
+namespace
+{
+constexpr char const DEBUG_TAG[] = "http_connect_race";
+}
+
+/// One connection of a race.
+struct HttpConnectRace::Attempt : public Continuation {
+  HttpConnectRace *race;
+  int idx;
+  Action *pending       = nullptr; ///< The connect, until it calls back.
+  NetVConnection *vc    = nullptr;
+  MIOBuffer *buffer     = nullptr;
+  IOBufferReader *empty = nullptr;
+
+  Attempt(HttpConnectRace *race, int idx) : Continuation(race->mutex), race(race), idx(idx)
+  {
+    SET_HANDLER(&Attempt::state_attempt);
+  }
+
+  ~Attempt()
+  {
+    if (pending) {
+      pending->cancel();
+    }
+    if (vc) {
+      vc->do_io_close();
+    }
+    if (buffer) {
+      free_MIOBuffer(buffer);
+    }
+  }
+
+  int
+  state_attempt(int event, void *data)
+  {
+    switch (event) {
+    case NET_EVENT_OPEN:
+      pending = nullptr;
+      vc      = static_cast<NetVConnection *>(data);
+      // As for a transaction, write ready on an empty write is the signal the handshakes are done.
+      buffer = new_empty_MIOBuffer();
+      empty  = buffer->alloc_reader();
+      vc->set_inactivity_timeout(race->_timeout);
+      vc->do_io_write(this, 1, empty);
+      break;
+    case NET_EVENT_OPEN_FAILED:
+      pending = nullptr;
+      race->failed(this, -static_cast<int>(reinterpret_cast<intptr_t>(data)));
+      break;
+    case VC_EVENT_WRITE_READY:
+    case VC_EVENT_WRITE_COMPLETE:
+      race->won(this);
+      break;
+    case VC_EVENT_ERROR:
+      race->failed(this, vc->lerrno ? vc->lerrno : ECONNABORTED);
+      break;
+    default: // timeouts, and EOS for a TLS handshake refused.
+      race->failed(this, event == VC_EVENT_EOS ? ECONNRESET : ETIMEDOUT);
+      break;
+    }
+    return EVENT_DONE;
+  }
+};
+
+void
+HttpConnectRace::RaceAction::cancel(Continuation *c)
+{
+  Action::cancel(c);
+  if (race) {
+    race->destroy();
+  }
+}
+
+HttpConnectRace::HttpConnectRace(Continuation *cont, NetProcessor &processor, ink_hrtime delay, ink_hrtime timeout)
+  : Continuation(cont->mutex), _processor(processor), _delay(delay), _timeout(timeout)
+{
+  _action      = cont;
+  _action.race = this;
+  SET_HANDLER(&HttpConnectRace::state_race);
+}
+
+Action *
+HttpConnectRace::connect_re(Continuation *cont, NetProcessor &processor, IpEndpoint const *targets, int n_targets,
+                            NetVCOptions const &opt, ink_hrtime delay, ink_hrtime timeout)
+{
+  ink_assert(n_targets > 0 && n_targets <= MAX_TARGETS);
+  HttpConnectRace *race = new HttpConnectRace(cont, processor, delay, timeout);
+  race->_opt            = opt;
+  race->_n_targets      = std::min(n_targets, static_cast<int>(MAX_TARGETS));
+  std::copy(targets, targets + race->_n_targets, race->_targets);
+
+  // Everything happens from the event, so that nothing calls back the continuation before this returns.
+  race->wake();
+  return &race->_action;
+}
+
+int
+HttpConnectRace::state_race(int /* event */, void * /* data */)
+{
+  _timer = nullptr;
+  if (_next < _n_targets) {
+    start(_next++);
+    // A failure already woke the race up again.
+    if (_timer == nullptr && _next < _n_targets) {
+      _timer = this_ethread()->schedule_in(this, _delay);
+    }
+  } else if (_attempts.empty()) {
+    Debug(DEBUG_TAG, "all %d connections failed", _n_targets);
+    finish(NET_EVENT_OPEN_FAILED, reinterpret_cast<void *>(static_cast<intptr_t>(-_last_error)));
+  }
+  return EVENT_DONE;
+}
+
+void
+HttpConnectRace::start(int idx)
+{
+  ip_port_text_buffer b;
+  Debug(DEBUG_TAG, "connecting to %s", ats_ip_nptop(&_targets[idx].sa, b, sizeof b));
+
+  Attempt *attempt = new Attempt(this, idx);
+  _attempts.push_back(attempt);
+  _opt.ip_family = _targets[idx].family();
+  Action *action = _processor.connect_re(attempt, &_targets[idx].sa, &_opt);
+  if (action != ACTION_RESULT_DONE) {
+    attempt->pending = action;
+  }
+}
+
+void
+HttpConnectRace::won(Attempt *attempt)
+{
+  ip_port_text_buffer b;
+  Debug(DEBUG_TAG, "connected to %s", ats_ip_nptop(&_targets[attempt->idx].sa, b, sizeof b));
+
+  NetVConnection *vc = attempt->vc;
+  attempt->vc        = nullptr;
+  vc->do_io_write(nullptr, 0, nullptr);
+  // The connection must look like it was opened for the continuation itself.
+  if (UnixNetVConnection *unix_vc = dynamic_cast<UnixNetVConnection *>(vc); unix_vc != nullptr) {
+    unix_vc->action_ = _action.continuation;
+  }
+
+  finish(NET_EVENT_OPEN, vc);
+}
+
+void
+HttpConnectRace::failed(Attempt *attempt, int error)
+{
+  ip_port_text_buffer b;
+  Debug(DEBUG_TAG, "connection to %s failed: %d", ats_ip_nptop(&_targets[attempt->idx].sa, b, sizeof b), error);
+
+  _last_error = error;
+  _attempts.erase(std::find(_attempts.begin(), _attempts.end(), attempt));
+  delete attempt;
+  // The next address is tried at once, or the race is over.
+  wake();
+}
+
+void
+HttpConnectRace::finish(int event, void *data)
+{
+  // The action is still valid in the callback, but it is too late to cancel it.
+  _action.race = nullptr;
+  _action.continuation->handleEvent(event, data);
+  destroy();
+}
+
+void
+HttpConnectRace::wake()
+{
+  if (_timer) {
+    _timer->cancel();
+  }
+  _timer = this_ethread()->schedule_imm(this);
+}
+
+void
+HttpConnectRace::destroy()
+{
+  if (_timer) {
+    _timer->cancel();
+  }
+  for (Attempt *attempt : _attempts) {
+    delete attempt;
+  }
+  delete this;
+}
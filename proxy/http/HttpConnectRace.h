@@ -0,0 +1,92 @@
+/** @file
+
+  Connections to an origin server raced across its addresses.
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ */
+
+#pragma once
+
+#include <vector>
+
+#include "I_EventSystem.h"
+#include "I_NetVConnection.h"
+#include "I_NetProcessor.h"
+#include "tscore/ink_inet.h"
+
+/** Connect to whichever of several addresses answers first, as in RFC 8305 (Happy Eyeballs).
+
+    The attempts are started in the order of the addresses, the next one when the previous one fails
+    or after a delay without an answer. The first connection to finish its handshake, TCP or TLS, is
+    handed to the continuation with NET_EVENT_OPEN and the others are closed. If all of them fail the
+    continuation gets NET_EVENT_OPEN_FAILED with the error of the last one.
+
+    The race runs under the mutex of the continuation, and the returned action cancels it.
+ */
+class HttpConnectRace : public Continuation
+{
+public:
+  /// The most addresses raced for one connection.
+  static constexpr int MAX_TARGETS = 4;
+
+  /** Start a race.
+
+      @param cont Continuation called back with the result.
+      @param processor The processor of the connections, @c netProcessor or @c sslNetProcessor.
+      @param targets The addresses to connect to, with their ports, in order of preference.
+      @param n_targets The number of @a targets, at most @c MAX_TARGETS.
+      @param opt The options of each connection.
+      @param delay The time an attempt is given before the next one is started.
+      @param timeout The time an attempt is given to finish its handshake.
+   */
+  static Action *connect_re(Continuation *cont, NetProcessor &processor, IpEndpoint const *targets, int n_targets,
+                            NetVCOptions const &opt, ink_hrtime delay, ink_hrtime timeout);
+
+private:
+  struct Attempt;
+
+  /// The action of the race, cancelling it drops all the attempts.
+  struct RaceAction : public Action {
+    using Action::operator=;
+    HttpConnectRace *race = nullptr;
+    void cancel(Continuation *c = nullptr) override;
+  };
+
+  HttpConnectRace(Continuation *cont, NetProcessor &processor, ink_hrtime delay, ink_hrtime timeout);
+
+  int state_race(int event, void *data);
+  void start(int idx);
+  void won(Attempt *attempt);
+  void failed(Attempt *attempt, int error);
+  void finish(int event, void *data);
+  void wake();
+  void destroy();
+
+  RaceAction _action;
+  NetProcessor &_processor;
+  NetVCOptions _opt;
+  IpEndpoint _targets[MAX_TARGETS];
+  int _n_targets      = 0;
+  int _next           = 0; ///< Index of the next target to try.
+  int _last_error     = 0;
+  ink_hrtime _delay   = 0;
+  ink_hrtime _timeout = 0;
+  Event *_timer       = nullptr;
+  std::vector<Attempt *> _attempts; ///< Attempts in progress.
+};
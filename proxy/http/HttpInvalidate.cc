@@ -0,0 +1,231 @@
+/** @file
+
+  Invalidation of the cached objects by URL pattern and by tag.
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ */
+
+#include <algorithm>
+
+#include "HttpInvalidate.h"
+#include "HTTP.h"
+#include "tscore/BufferWriter.h"
+
+extern char *readIntoBuffer(const char *file_path, const char *module_name, int *read_size_ptr);
+
+using ts::TextView;
+namespace
+{
+void
+SignalError(ts::BufferWriter &w, bool &flag)
+{
+  if (!flag) {
+    flag = true;
+    pmgmt->signalManager(MGMT_SIGNAL_CONFIG_ERROR, w.data());
+  }
+  Error("%s", w.data());
+}
+
+/// Separators of the tags in the tag header.
+bool
+is_tag_separator(char c)
+{
+  return c == ',' || isspace(static_cast<unsigned char>(c));
+}
+} // namespace
+
+size_t HttpInvalidate::configid = 0;
+
+static ConfigUpdateHandler<HttpInvalidate> *httpInvalidateUpdate;
+
+void
+HttpInvalidate::startup()
+{
+  // Should not have been initialized before
+  ink_assert(HttpInvalidate::configid == 0);
+
+  httpInvalidateUpdate = new ConfigUpdateHandler<HttpInvalidate>();
+  httpInvalidateUpdate->attach("proxy.config.http.cache.invalidate.filename");
+  httpInvalidateUpdate->attach("proxy.config.http.cache.invalidate.tag_header");
+
+  reconfigure();
+}
+
+void
+HttpInvalidate::reconfigure()
+{
+  self_type *new_table;
+
+  Note("invalidate.config loading ...");
+
+  new_table = new self_type("proxy.config.http.cache.invalidate.filename");
+  new_table->BuildTable();
+
+  configid = configProcessor.set(configid, new_table);
+
+  Note("invalidate.config finished loading");
+}
+
+HttpInvalidate *
+HttpInvalidate::acquire()
+{
+  return static_cast<HttpInvalidate *>(configProcessor.get(configid));
+}
+
+void
+HttpInvalidate::release(HttpInvalidate *config)
+{
+  configProcessor.release(configid, config);
+}
+
+HttpInvalidate::HttpInvalidate(const char *config_var) : config_file_path(RecConfigReadConfigPath(config_var))
+{
+  ats_scoped_str header(REC_ConfigReadString("proxy.config.http.cache.invalidate.tag_header"));
+  if (header) {
+    _tag_header = header.get();
+  }
+}
+
+bool
+HttpInvalidate::is_invalidated(std::string_view url, HTTPHdr *response, ink_time_t cached_time) const
+{
+  if (!_url_times.empty()) {
+    int idx = _url_rules.match(url);
+    if (idx >= 0 && cached_time <= _url_times[idx]) {
+      return true;
+    }
+  }
+
+  if (!_tag_times.empty() && !_tag_header.empty()) {
+    for (MIMEField *field = response->field_find(_tag_header.data(), _tag_header.size()); field; field = field->m_next_dup) {
+      int len;
+      const char *value = field->value_get(&len);
+      TextView tags(value, len);
+      while (!tags.ltrim_if(&is_tag_separator).empty()) {
+        TextView tag = tags.take_prefix_if(&is_tag_separator);
+        auto spot    = _tag_times.find(std::string(tag));
+        if (spot != _tag_times.end() && cached_time <= spot->second) {
+          return true;
+        }
+      }
+    }
+  }
+
+  return false;
+}
+
+int
+HttpInvalidate::BuildTable()
+{
+  int file_size     = 0;
+  int line_num      = 0;
+  bool alarmAlready = false;
+  ts::LocalBufferWriter<1024> bw_err;
+  ink_time_t now = ink_time();
+  std::vector<std::pair<ink_time_t, std::string>> url_rules;
+
+  ats_scoped_str file_buff(readIntoBuffer(config_file_path, "invalidate", &file_size));
+
+  if (file_buff == nullptr) {
+    // The file is optional, without it nothing is invalidated.
+    Debug("http_invalidate", "%s could not read %s, no object is invalidated", MODULE_NAME, config_file_path.get());
+    return 1;
+  }
+
+  TextView src(file_buff, file_size);
+  TextView line;
+  auto err_prefix = [&]() -> ts::BufferWriter & {
+    return bw_err.reset().print("{} discarding '{}' entry at line {} : ", MODULE_NAME, config_file_path, line_num);
+  };
+
+  while (!(line = src.take_prefix_at('\n')).empty()) {
+    ++line_num;
+    line.trim_if(&isspace);
+
+    if (line.empty() || *line == '#') {
+      continue;
+    }
+
+    TextView url_regex;
+    TextView tag;
+    TextView time_text;
+    bool line_valid_p = true;
+
+    while (line_valid_p && !line.ltrim_if(&isspace).empty()) {
+      TextView token = line.take_prefix_if(&isspace);
+      TextView value = token.split_suffix_at('=');
+      if (value.empty()) {
+        err_prefix().print("No value found in token '{}'.\0", token);
+        line_valid_p = false;
+      } else if (strcasecmp(token, OPT_URL_REGEX) == 0) {
+        url_regex = value;
+      } else if (strcasecmp(token, OPT_TAG) == 0) {
+        tag = value;
+      } else if (strcasecmp(token, OPT_TIME) == 0) {
+        time_text = value;
+      } else {
+        err_prefix().print("'{}' is not a valid key.\0", token);
+        line_valid_p = false;
+      }
+    }
+
+    if (line_valid_p && url_regex.empty() == tag.empty()) {
+      err_prefix().print("Exactly one of '{}' and '{}' is required.\0", OPT_URL_REGEX, OPT_TAG);
+      line_valid_p = false;
+    }
+
+    TextView parsed;
+    ink_time_t rule_time = line_valid_p ? ts::svtoi(time_text, &parsed) : 0;
+    if (line_valid_p && (time_text.empty() || parsed.size() != time_text.size() || rule_time <= 0)) {
+      err_prefix().print("'{}' is not a valid time.\0", time_text);
+      line_valid_p = false;
+    }
+
+    if (!line_valid_p) {
+      SignalError(bw_err, alarmAlready);
+      continue;
+    }
+
+    // A rule in the future would invalidate every refresh until then, it takes effect now instead.
+    rule_time = std::min(rule_time, now);
+
+    if (!tag.empty()) {
+      ink_time_t &t = _tag_times[std::string(tag)];
+      t             = std::max(t, rule_time);
+    } else {
+      url_rules.emplace_back(rule_time, std::string(url_regex));
+    }
+  }
+
+  // Newest first, the first match of a URL is then its latest rule.
+  std::stable_sort(url_rules.begin(), url_rules.end(), [](auto const &lhs, auto const &rhs) { return lhs.first > rhs.first; });
+  for (auto &rule : url_rules) {
+    std::string_view pattern{rule.second};
+    if (_url_rules.compile(&pattern, 1) > static_cast<int>(_url_times.size())) {
+      _url_times.push_back(rule.first);
+    } else {
+      bw_err.reset().print("{} discarding '{}' entry : invalid regular expression '{}'.\0", MODULE_NAME, config_file_path,
+                           rule.second);
+      SignalError(bw_err, alarmAlready);
+    }
+  }
+
+  Debug("http_invalidate", "%s loaded %zu URL rules and %zu tag rules", MODULE_NAME, _url_times.size(), _tag_times.size());
+  return 0;
+}
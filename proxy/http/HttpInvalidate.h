@@ -0,0 +1,97 @@
+/** @file
+
+  Invalidation of the cached objects by URL pattern and by tag.
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ */
+
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "ProxyConfig.h"
+#include "tscore/Regex.h"
+#include "tscore/ink_time.h"
+#include "tscpp/util/TextView.h"
+
+class HTTPHdr;
+
+/** Invalidation rules of invalidate.config.
+
+    A rule invalidates the objects cached before its time, either those of the URLs that match a
+    regular expression or those tagged with a tag in the header named by
+    @c proxy.config.http.cache.invalidate.tag_header of their cached response, the way the
+    @c Surrogate-Key header of an origin tags its responses. The rules are not applied to the cache
+    when they are loaded, an object is checked as it is looked up, and an invalidated object is
+    revalidated with the origin as if it was stale. Once it is written again it is newer than the
+    rule and is served as usual.
+
+    The URL rules are kept newest first in a single @c DFA so that one match finds the latest rule
+    of a URL, the tags are kept in a hash table.
+ */
+class HttpInvalidate : public ConfigInfo
+{
+public:
+  using self_type     = HttpInvalidate; ///< Self reference type.
+  using scoped_config = ConfigProcessor::scoped_config<self_type, self_type>;
+
+  /// Token strings for configuration
+  static constexpr ts::TextView OPT_URL_REGEX{"url_regex"};
+  static constexpr ts::TextView OPT_TAG{"tag"};
+  static constexpr ts::TextView OPT_TIME{"time"};
+
+  explicit HttpInvalidate(const char *config_var);
+
+  static void startup();
+  static void reconfigure();
+  /// @return The global instance.
+  static HttpInvalidate *acquire();
+  /// Release the configuration.
+  static void release(HttpInvalidate *config);
+
+  /// Check if there is any rule at all.
+  bool
+  empty() const
+  {
+    return _url_times.empty() && _tag_times.empty();
+  }
+
+  /** Check if the object of @a url with the cached @a response is invalidated.
+
+      @a cached_time is the time the response was received from the origin.
+   */
+  bool is_invalidated(std::string_view url, HTTPHdr *response, ink_time_t cached_time) const;
+
+private:
+  static size_t configid; ///< Configuration ID for update management.
+
+  static constexpr const char *MODULE_NAME = "HttpInvalidate";
+
+  int BuildTable();
+
+  ats_scoped_str config_file_path; ///< Path to configuration file.
+  std::string _tag_header;         ///< The name of the header with the tags of a response.
+
+  DFA _url_rules;                     ///< The URL patterns, newest first.
+  std::vector<ink_time_t> _url_times; ///< The time of each URL pattern, in the same order.
+  std::unordered_map<std::string, ink_time_t> _tag_times;
+};
@@ -0,0 +1,317 @@
+/** @file
+
+  Pre-warmed connections to origin servers.
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ */
+
+#include <algorithm>
+
+#include "HttpPreWarm.h"
+#include "P_Net.h"
+#include "P_HostDB.h"
+#include "HttpConfig.h"
+#include "HttpConnectionCount.h"
+#include "HttpSessionManager.h"
+#include "HttpSM.h"
+#include "Http1ServerSession.h"
+#include "tscpp/util/TextView.h"
+
+PreWarmManager prewarmManager;
+
+namespace
+{
+constexpr char const DEBUG_TAG[] = "http_prewarm";
+/// How long a resolved address is used before it is looked up again.
+constexpr ink_hrtime PREWARM_DNS_REFRESH = HRTIME_SECONDS(60);
+
+void
+initialize_thread_for_prewarm(EThread *thread)
+{
+  prewarmManager.start(thread);
+}
+} // namespace
+
+bool
+PreWarmManager::parse(std::string_view text, std::vector<Target> &targets)
+{
+  ts::TextView src{text};
+
+  while (src.ltrim_if([](char c) { return isspace(c) || c == ','; })) {
+    ts::TextView token = src.take_prefix_if([](char c) { return isspace(c) || c == ','; });
+    Target target;
+
+    auto scheme = [&token](std::string_view prefix) -> bool {
+      if (token.size() >= prefix.size() && strncasecmp(token.data(), prefix.data(), prefix.size()) == 0) {
+        token.remove_prefix(prefix.size());
+        return true;
+      }
+      return false;
+    };
+    if (scheme("https://")) {
+      target.tls = true;
+    } else {
+      scheme("http://");
+    }
+
+    ts::TextView host;
+    if (!token.empty() && token.front() == '[') {
+      // IPv6 address, the port follows the brackets.
+      token.remove_prefix(1);
+      host = token.take_prefix_at(']');
+      if (!token.empty() && token.front() != ':') {
+        return false;
+      }
+    } else {
+      host = token.take_prefix_at(':');
+    }
+    if (host.empty()) {
+      return false;
+    }
+
+    target.port = target.tls ? 443 : 80;
+    token.ltrim(':');
+    if (!token.empty()) {
+      ts::TextView parsed;
+      intmax_t port = ts::svtoi(token, &parsed);
+      if (parsed.size() != token.size() || port <= 0 || port > 65535) {
+        return false;
+      }
+      target.port = port;
+    }
+
+    target.host.assign(host.data(), host.size());
+    CryptoContext().hash_immediate(target.host_hash, target.host.data(), target.host.size());
+    targets.push_back(std::move(target));
+  }
+  return true;
+}
+
+void
+PreWarmManager::init()
+{
+  ats_scoped_str origins;
+  int interval = 1;
+  int pool     = 0;
+
+  REC_ReadConfigInteger(_n_connections, "proxy.config.http.prewarm.connections");
+  REC_ReadConfigInteger(interval, "proxy.config.http.prewarm.interval");
+  REC_ReadConfigStringAlloc(origins, "proxy.config.http.prewarm.origins");
+  if (_n_connections <= 0 || !origins || !*origins) {
+    return;
+  }
+
+  HttpConfigParams *params = HttpConfig::acquire();
+  pool                     = params->server_session_sharing_pool;
+  HttpConfig::release(params);
+  if (pool == TS_SERVER_SESSION_SHARING_POOL_GLOBAL) {
+    Warning("proxy.config.http.prewarm.origins requires per thread server session pools, pre-warming is disabled");
+    return;
+  }
+
+  if (!parse(std::string_view{origins.get()}, _targets)) {
+    Warning("proxy.config.http.prewarm.origins '%s' is not valid, only %zu servers are pre-warmed", origins.get(),
+            _targets.size());
+  }
+  if (_targets.empty()) {
+    return;
+  }
+
+  _interval = HRTIME_SECONDS(std::max(interval, 1));
+  Note("Pre-warming %d connections per thread to %zu servers", _n_connections, _targets.size());
+  eventProcessor.schedule_spawn(&initialize_thread_for_prewarm, ET_NET);
+}
+
+void
+PreWarmManager::start(EThread *thread)
+{
+  for (Target const &target : _targets) {
+    thread->schedule_every(new PreWarmQueue(target, _n_connections), _interval);
+  }
+}
+
+PreWarmQueue::PreWarmQueue(PreWarmManager::Target const &target, int n_connections)
+  : Continuation(new_ProxyMutex()), _target(target), _n_connections(n_connections)
+{
+  SET_HANDLER(&PreWarmQueue::main_event);
+}
+
+int
+PreWarmQueue::main_event(int event, void *data)
+{
+  HttpConfigParams *params = HttpConfig::acquire();
+
+  switch (event) {
+  case EVENT_INTERVAL:
+    refill(params);
+    break;
+
+  case EVENT_HOST_DB_LOOKUP: {
+    HostDBInfo *r = static_cast<HostDBInfo *>(data);
+    _dns_action   = nullptr;
+    if (r && !r->is_failed()) {
+      HostDBInfo *info = r->round_robin ? &r->rr()->info(0) : r;
+      _addr.assign(info->ip());
+      _addr.port() = htons(_target.port);
+      _resolved_at = Thread::get_hrtime();
+    } else {
+      Debug(DEBUG_TAG, "DNS lookup of %s failed", _target.host.c_str());
+    }
+    break;
+  }
+
+  case NET_EVENT_OPEN:
+    --_connecting;
+    opened(static_cast<NetVConnection *>(data), params);
+    break;
+
+  case NET_EVENT_OPEN_FAILED:
+    --_connecting;
+    Debug(DEBUG_TAG, "connect to %s failed: %d", _target.host.c_str(), -static_cast<int>(reinterpret_cast<intptr_t>(data)));
+    break;
+
+  case VC_EVENT_WRITE_READY:
+  case VC_EVENT_WRITE_COMPLETE:
+    ready(static_cast<VIO *>(data), true, params);
+    break;
+
+  case VC_EVENT_READ_READY:
+  case VC_EVENT_READ_COMPLETE:
+  case VC_EVENT_EOS:
+  case VC_EVENT_ERROR:
+  case VC_EVENT_INACTIVITY_TIMEOUT:
+  case VC_EVENT_ACTIVE_TIMEOUT:
+    ready(static_cast<VIO *>(data), false, params);
+    break;
+
+  default:
+    ink_assert(!"unexpected event");
+    break;
+  }
+
+  HttpConfig::release(params);
+  return EVENT_DONE;
+}
+
+void
+PreWarmQueue::refill(HttpConfigParams *params)
+{
+  if (_dns_action == nullptr && (!_addr.isValid() || Thread::get_hrtime() - _resolved_at > PREWARM_DNS_REFRESH)) {
+    Action *action = hostDBProcessor.getbyname_re(this, _target.host.c_str(), _target.host.size());
+    if (action != ACTION_RESULT_DONE) {
+      _dns_action = action;
+    }
+  }
+  if (!_addr.isValid()) {
+    return;
+  }
+
+  ServerSessionPool *pool = this_ethread()->server_session_pool;
+  int idle;
+  {
+    MUTEX_TRY_LOCK(lock, pool->mutex, this_ethread());
+    if (!lock.is_locked()) {
+      return; // Try again on the next check.
+    }
+    idle = pool->countSessions(&_addr.sa, _target.host_hash);
+  }
+
+  int need = _n_connections - idle - _connecting - static_cast<int>(_handshaking.size());
+  // Pre-warmed connections count as any others against the upstream limit.
+  if (need > 0 && params->oride.outbound_conntrack.max > 0) {
+    auto ct_state = OutboundConnTrack::obtain(params->oride.outbound_conntrack, _target.host, _addr);
+    need          = std::min(need, params->oride.outbound_conntrack.max - ct_state.drop()->_count.load());
+  }
+  if (need > 0) {
+    Debug(DEBUG_TAG, "%s:%d has %d idle sessions, opening %d", _target.host.c_str(), _target.port, idle, need);
+  }
+  for (int i = 0; i < need; ++i) {
+    connect(params);
+  }
+}
+
+void
+PreWarmQueue::connect(HttpConfigParams *params)
+{
+  OverridableHttpConfigParams *conf = &params->oride;
+  NetVCOptions opt;
+
+  opt.f_blocking_connect = false;
+  opt.set_sock_param(conf->sock_recv_buffer_size_out, conf->sock_send_buffer_size_out, conf->sock_option_flag_out,
+                     conf->sock_packet_mark_out, conf->sock_packet_tos_out);
+  opt.ip_family = _addr.family();
+
+  ++_connecting;
+  if (_target.tls) {
+    set_tls_options(opt, conf);
+    opt.ssl_client_cert_name        = conf->ssl_client_cert_filename;
+    opt.ssl_client_private_key_name = conf->ssl_client_private_key_filename;
+    opt.ssl_client_ca_cert_name     = conf->ssl_client_ca_cert_filename;
+    // The SNI the session is matched on, the host a transaction would send.
+    opt.set_sni_servername(_target.host.data(), _target.host.size());
+    opt.set_ssl_servername(_target.host.c_str());
+    sslNetProcessor.connect_re(this, &_addr.sa, &opt);
+  } else {
+    netProcessor.connect_re(this, &_addr.sa, &opt);
+  }
+}
+
+void
+PreWarmQueue::opened(NetVConnection *netvc, HttpConfigParams *params)
+{
+  Http1ServerSession *session = THREAD_ALLOC_INIT(httpServerSessionAllocator, this_ethread());
+  session->sharing_pool       = static_cast<TSServerSessionSharingPoolType>(params->server_session_sharing_pool);
+  session->sharing_match      = static_cast<TSServerSessionSharingMatchType>(params->oride.server_session_sharing_match);
+  session->new_connection(netvc);
+  session->attach_hostname(_target.host.c_str());
+
+  if (params->oride.outbound_conntrack.max > 0 || params->origin_min_keep_alive_connections > 0) {
+    auto ct_state = OutboundConnTrack::obtain(params->oride.outbound_conntrack, _target.host, _addr);
+    ct_state.reserve();
+    session->enable_outbound_connection_tracking(ct_state.drop());
+  }
+
+  // As for a transaction, write ready is the signal the TCP and TLS handshakes are done.
+  _handshaking.push_back(session);
+  netvc->set_inactivity_timeout(HRTIME_SECONDS(params->oride.connect_attempts_timeout));
+  session->do_io_write(this, 1, session->get_reader());
+}
+
+void
+PreWarmQueue::ready(VIO *vio, bool ok, HttpConfigParams *params)
+{
+  auto spot = std::find_if(_handshaking.begin(), _handshaking.end(),
+                           [vio](Http1ServerSession *ssn) { return ssn->get_netvc() == vio->vc_server; });
+  if (spot == _handshaking.end()) {
+    return;
+  }
+  Http1ServerSession *session = *spot;
+  _handshaking.erase(spot);
+
+  if (!ok) {
+    Debug(DEBUG_TAG, "[%" PRId64 "] handshake with %s failed", session->con_id, _target.host.c_str());
+    session->do_io_close();
+    return;
+  }
+
+  Debug(DEBUG_TAG, "[%" PRId64 "] pre-warmed session to %s ready", session->con_id, _target.host.c_str());
+  HTTP_INCREMENT_DYN_STAT(http_origin_prewarmed_connections_stat);
+  session->get_netvc()->set_inactivity_timeout(HRTIME_SECONDS(params->oride.keep_alive_no_activity_timeout_out));
+  session->release();
+}
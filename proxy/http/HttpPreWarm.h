@@ -0,0 +1,104 @@
+/** @file
+
+  Pre-warmed connections to origin servers.
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ */
+
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "P_EventSystem.h"
+#include "tscore/CryptoHash.h"
+#include "tscore/ink_inet.h"
+
+class Http1ServerSession;
+class NetVConnection;
+struct HttpConfigParams;
+
+/** Keeps idle connections open to a configured set of upstream servers.
+
+    Each net thread keeps @c proxy.config.http.prewarm.connections idle sessions to each server of
+    @c proxy.config.http.prewarm.origins in its server session pool, so the DNS lookup, the TCP
+    connect and the TLS handshake are done before a transaction needs the connection. Sessions taken
+    by transactions are replaced on the next check.
+ */
+class PreWarmManager
+{
+public:
+  /// An upstream server to keep connections to.
+  struct Target {
+    std::string host;
+    in_port_t port = 0;
+    bool tls       = false;
+    CryptoHash host_hash;
+  };
+
+  /// Read the configuration and start the per thread queues.
+  void init();
+  /// Start the queues of @a thread.
+  void start(EThread *thread);
+
+  /** Parse a list of upstream servers.
+
+      The list is separated by spaces or commas, each entry is "[http://|https://]host[:port]". An
+      IPv6 address host is in brackets. The port defaults to 80, or 443 for "https://".
+
+      @return @c false if an entry was not valid, @a targets has the entries before it.
+   */
+  static bool parse(std::string_view text, std::vector<Target> &targets);
+
+private:
+  std::vector<Target> _targets;
+  int _n_connections   = 0; ///< Idle connections per target on each thread.
+  ink_hrtime _interval = 0; ///< How often the queues refill.
+};
+
+extern PreWarmManager prewarmManager;
+
+/** The pre-warmed connections of one net thread to one @c PreWarmManager::Target.
+
+    This runs on its thread only, so the sessions it opens belong to the server session pool of the
+    thread.
+ */
+class PreWarmQueue : public Continuation
+{
+public:
+  PreWarmQueue(PreWarmManager::Target const &target, int n_connections);
+
+  int main_event(int event, void *data);
+
+private:
+  void refill(HttpConfigParams *params);
+  void connect(HttpConfigParams *params);
+  void opened(NetVConnection *netvc, HttpConfigParams *params);
+  void ready(VIO *vio, bool ok, HttpConfigParams *params);
+
+  PreWarmManager::Target const &_target;
+  int _n_connections;
+
+  IpEndpoint _addr;            ///< The resolved address, invalid if there is none.
+  ink_hrtime _resolved_at = 0; ///< When @a _addr was resolved.
+  Action *_dns_action     = nullptr;
+  int _connecting         = 0;                    ///< Connections not yet open.
+  std::vector<Http1ServerSession *> _handshaking; ///< Open connections not yet ready for a transaction.
+};
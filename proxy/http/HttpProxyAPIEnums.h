@@ -45,6 +45,7 @@ typedef enum {
 typedef enum {
   TS_SERVER_SESSION_SHARING_POOL_GLOBAL,
   TS_SERVER_SESSION_SHARING_POOL_THREAD,
+  TS_SERVER_SESSION_SHARING_POOL_HYBRID,
 } TSServerSessionSharingPoolType;
 
 /// Values for per server outbound connection tracking group definition.
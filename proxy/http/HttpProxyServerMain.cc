@@ -27,6 +27,8 @@
 #include "HttpSessionAccept.h"
 #include "ReverseProxy.h"
 #include "HttpSessionManager.h"
+#include "HttpPreWarm.h"
+#include "HttpSlowTxn.h"
 #include "HttpUpdateSM.h"
 #ifdef USE_HTTP_DEBUG_LISTS
 #include "Http1ClientSession.h"
@@ -158,12 +160,23 @@ make_net_accept_options(const HttpProxyPort *port, unsigned nthreads)
 #endif
 
   if (port) {
+    REC_ReadConfigInteger(net.f_deny_filter, "proxy.config.net.listen_deny_filter");
     net.f_inbound_transparent = port->m_inbound_transparent_p;
     net.f_mptcp               = port->m_mptcp;
     net.ip_family             = port->m_family;
     net.local_port            = port->m_port;
     net.f_proxy_protocol      = port->m_proxy_protocol;
 
+    if (!port->m_thread_group.empty()) {
+      EventType etype = eventProcessor.find_event_type(port->m_thread_group);
+      if (etype < 0) {
+        Warning("port %d: net thread group '%s' is not in proxy.config.net.thread_groups, accepting on ET_NET", port->m_port,
+                port->m_thread_group.c_str());
+      } else {
+        net.etype = etype;
+      }
+    }
+
     if (port->m_inbound_ip.isValid()) {
       net.local_ip = port->m_inbound_ip;
     } else if (AF_INET6 == port->m_family && HttpConfig::m_master.inbound_ip6.isIp6()) {
@@ -188,6 +201,7 @@ MakeHttpProxyAcceptor(HttpProxyAcceptor &acceptor, HttpProxyPort &port, unsigned
   accept_opt.setHostResPreference(port.m_host_res_preference);
   accept_opt.setTransparentPassthrough(port.m_transparent_passthrough);
   accept_opt.setSessionProtocolPreference(port.m_session_protocol_preference);
+  accept_opt.setHttp2Urgency(port.m_http2_urgency);
 
   if (port.m_outbound_ip4.isValid()) {
     accept_opt.outbound_ip4 = port.m_outbound_ip4;
@@ -262,6 +276,8 @@ void
 prep_HttpProxyServer()
 {
   httpSessionManager.init();
+  prewarmManager.init();
+  slowTxnCapture.init();
 }
 
 /** Set up all the accepts and sockets.
@@ -271,7 +287,6 @@ init_accept_HttpProxyServer(int n_accept_threads)
 {
   HttpProxyPort::Group &proxy_ports = HttpProxyPort::global();
 
-  init_reverse_proxy();
   http_pages_init();
 
 #ifdef USE_HTTP_DEBUG_LISTS
@@ -362,6 +377,8 @@ start_HttpProxyServer()
   // Set up stat page for http connection count
   statPagesManager.register_http("connection_count", register_ShowConnectionCount);
 
+  slowTxnCapture.start();
+
   // Alert plugins that connections will be accepted.
   APIHook *hook = lifecycle_hooks->get(TS_LIFECYCLE_PORTS_READY_HOOK);
   while (hook) {
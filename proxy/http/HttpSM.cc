@@ -28,8 +28,10 @@
 #include "HttpTransactHeaders.h"
 #include "ProxyConfig.h"
 #include "Http1ServerSession.h"
+#include "Http2ServerSession.h"
 #include "HttpDebugNames.h"
 #include "HttpSessionManager.h"
+#include "HttpSlowTxn.h"
 #include "P_Cache.h"
 #include "P_Net.h"
 #include "StatPages.h"
@@ -49,6 +51,7 @@
 #include <openssl/ssl.h>
 #include <algorithm>
 #include <atomic>
+#include <memory>
 #include <logging/Log.h>
 
 #define DEFAULT_RESPONSE_BUFFER_SIZE_INDEX 6 // 8K
@@ -129,6 +132,9 @@ std::atomic<int64_t> next_sm_id(0);
 
 ClassAllocator<HttpSM> httpSMAllocator("httpSMAllocator");
 
+// Water mark bytes above the default held by the tunnels tuned to their connections.
+static std::atomic<int64_t> tunnel_buffer_budget_used{0};
+
 HttpVCTable::HttpVCTable(HttpSM *mysm)
 {
   memset(&vc_table, 0, sizeof(vc_table));
@@ -289,7 +295,9 @@ HttpSM::HttpSM() : Continuation(nullptr), vc_table(this)
 void
 HttpSM::cleanup()
 {
+  tunnel_buffer_release();
   t_state.destroy();
+  txn_arena.clear();
   api_hooks.clear();
   http_parser_clear(&http_parser);
 
@@ -487,6 +495,8 @@ HttpSM::attach_client_session(ProxyTransaction *client_vc, IOBufferReader *buffe
       // Copy along the TLS handshake timings
       milestones[TS_MILESTONE_TLS_HANDSHAKE_START] = ssl_vc->sslHandshakeBeginTime;
       milestones[TS_MILESTONE_TLS_HANDSHAKE_END]   = ssl_vc->sslHandshakeEndTime;
+      // The first request is the one a client sends in its early data.
+      client_early_data = ssl_vc->get_early_data_len() > 0;
     }
   }
   const char *protocol_str = client_vc->get_protocol_string();
@@ -795,6 +805,15 @@ HttpSM::state_read_client_request_header(int event, void *data)
       ua_entry->read_vio->nbytes = ua_entry->read_vio->ndone;
     }
 
+    // The client sent more requests behind this one, start on them rather than wait for their turn.
+    if (t_state.http_config_param->pipeline_prefetch_max > 0 && ua_buffer_reader->is_read_avail_more_than(0) &&
+        t_state.hdr_info.client_request.method_get_wksidx() == HTTP_WKSIDX_GET &&
+        t_state.hdr_info.client_request.get_content_length() == 0 &&
+        t_state.client_info.transfer_encoding != HttpTransact::CHUNKED_ENCODING && ua_txn->get_proxy_ssn() != nullptr) {
+      ua_txn->get_proxy_ssn()->prefetch_pipelined(ua_buffer_reader, t_state.http_config_param->pipeline_prefetch_max,
+                                                  HRTIME_SECONDS(t_state.txn_conf->transaction_no_activity_timeout_in));
+    }
+
     call_transact_and_set_next_state(HttpTransact::ModifyRequest);
 
     break;
@@ -1453,7 +1472,10 @@ plugins required to work with sni_routing.
         if (!api_timer) {
           api_timer = Thread::get_hrtime_updated();
         }
-        hook->invoke(TS_EVENT_HTTP_READ_REQUEST_HDR + cur_hook_id, this);
+        {
+          CpuProfiler::Scope profile_hook(HttpDebugNames::get_api_hook_name(cur_hook_id));
+          hook->invoke(TS_EVENT_HTTP_READ_REQUEST_HDR + cur_hook_id, this);
+        }
         if (api_timer > 0) { // true if the hook did not call TxnReenable()
           milestone_update_api_time(milestones, api_timer);
           api_timer = -Thread::get_hrtime_updated(); // set in order to track non-active callout duration
@@ -1598,6 +1620,14 @@ HttpSM::handle_api_return()
     // Set back the inactivity timeout
     if (ua_txn) {
       ua_txn->set_inactivity_timeout(HRTIME_SECONDS(t_state.txn_conf->transaction_no_activity_timeout_in));
+
+      // The TCP policy of the client connection can be set per remap rule, e.g. BBR and pacing for video.
+      const OverridableHttpConfigParams *conf = t_state.txn_conf;
+      NetVConnection *netvc                   = ua_txn->get_netvc();
+      if (netvc && (conf->sock_congestion_control_in || conf->sock_pacing_rate_in > 0 || conf->sock_notsent_lowat_in > 0)) {
+        netvc->set_tcp_policy(conf->sock_congestion_control_in ? conf->sock_congestion_control_in : "", conf->sock_pacing_rate_in,
+                              conf->sock_notsent_lowat_in);
+      }
     }
 
     // We only follow 3xx when redirect_in_process == false. Otherwise the redirection has already been launched (in
@@ -1722,22 +1752,28 @@ HttpSM::state_http_server_open(int event, void *data)
   switch (event) {
   case NET_EVENT_OPEN: {
     Http1ServerSession *session =
-      (TS_SERVER_SESSION_SHARING_POOL_THREAD == t_state.http_config_param->server_session_sharing_pool) ?
+      (TS_SERVER_SESSION_SHARING_POOL_GLOBAL != t_state.http_config_param->server_session_sharing_pool) ?
         THREAD_ALLOC_INIT(httpServerSessionAllocator, mutex->thread_holding) :
         httpServerSessionAllocator.alloc();
     session->sharing_pool  = static_cast<TSServerSessionSharingPoolType>(t_state.http_config_param->server_session_sharing_pool);
     session->sharing_match = static_cast<TSServerSessionSharingMatchType>(t_state.txn_conf->server_session_sharing_match);
 
     netvc = static_cast<NetVConnection *>(data);
+    if (connect_raced) {
+      connect_raced = false;
+      ats_ip_copy(&t_state.current.server->dst_addr, netvc->get_remote_addr());
+    }
     session->attach_hostname(t_state.current.server->name);
-    UnixNetVConnection *vc = static_cast<UnixNetVConnection *>(data);
     // Since the UnixNetVConnection::action_ or SocksEntry::action_ may be returned from netProcessor.connect_re, and the
     // SocksEntry::action_ will be copied into UnixNetVConnection::action_ before call back NET_EVENT_OPEN from SocksEntry::free(),
-    // so we just compare the Continuation between pending_action and VC's action_.
-    ink_release_assert(pending_action == nullptr || pending_action->continuation == vc->get_action()->continuation);
+    // so we just compare the Continuation between pending_action and VC's action_. A stream of an Http2ServerSession is
+    // not a UnixNetVConnection, its action is the one returned.
+    if (UnixNetVConnection *vc = dynamic_cast<UnixNetVConnection *>(netvc); vc != nullptr) {
+      ink_release_assert(pending_action == nullptr || pending_action->continuation == vc->get_action()->continuation);
+    }
     pending_action = nullptr;
 
-    session->new_connection(vc);
+    session->new_connection(netvc);
 
     session->state = HSS_ACTIVE;
     ats_ip_copy(&t_state.server_info.src_addr, netvc->get_local_addr());
@@ -1794,6 +1830,7 @@ HttpSM::state_http_server_open(int event, void *data)
   case VC_EVENT_ACTIVE_TIMEOUT:
   case VC_EVENT_ERROR:
   case NET_EVENT_OPEN_FAILED:
+    connect_raced         = false;
     t_state.current.state = HttpTransact::CONNECTION_ERROR;
     // save the errno from the connect fail for future use (passed as negative value, flip back)
     t_state.current.server->set_connect_fail(event == NET_EVENT_OPEN_FAILED ? -reinterpret_cast<intptr_t>(data) : ECONNABORTED);
@@ -2131,6 +2168,7 @@ HttpSM::process_hostdb_info(HostDBInfo *r)
 {
   // Increment the refcount to our item, since we are pointing at it
   t_state.hostdb_entry = Ptr<HostDBInfo>(r);
+  race_addr_count      = 0;
 
   sockaddr const *client_addr = nullptr;
   bool use_client_addr        = t_state.http_config_param->use_client_target_addr == 1 && t_state.client_info.is_transparent &&
@@ -2198,6 +2236,9 @@ HttpSM::process_hostdb_info(HostDBInfo *r)
       t_state.host_db_info = *ret;
       ink_release_assert(!t_state.host_db_info.reverse_dns);
       ink_release_assert(ats_is_ip(t_state.host_db_info.ip()));
+      if (rr && t_state.http_config_param->connect_race_delay > 0) {
+        collect_race_addrs(rr, ret, now);
+      }
     }
   } else {
     SMDebug("http", "[%" PRId64 "] DNS lookup failed for '%s'", sm_id, t_state.dns_info.lookup_name);
@@ -2422,8 +2463,14 @@ HttpSM::state_cache_open_write(int event, void *data)
       break;
     }
     if (t_state.txn_conf->cache_open_write_fail_action == HttpTransact::CACHE_WL_FAIL_ACTION_DEFAULT) {
-      t_state.cache_info.write_lock_state = HttpTransact::CACHE_WL_FAIL;
-      break;
+      // Another transaction is revalidating the object, serve the stale copy meanwhile if its
+      // stale-while-revalidate allows, rather than revalidating it once more.
+      if (!t_state.cache_info.object_read || !HttpTransact::is_stale_while_revalidate_returnable(&t_state)) {
+        t_state.cache_info.write_lock_state = HttpTransact::CACHE_WL_FAIL;
+        break;
+      }
+      SMDebug("http", "[%" PRId64 "] write locked, serving the stale object within stale-while-revalidate", sm_id);
+      t_state.cache_open_write_fail_action = HttpTransact::CACHE_WL_FAIL_ACTION_STALE_ON_REVALIDATE;
     } else {
       t_state.cache_open_write_fail_action = t_state.txn_conf->cache_open_write_fail_action;
       if (!t_state.cache_info.object_read ||
@@ -2441,6 +2488,7 @@ HttpSM::state_cache_open_write(int event, void *data)
     // The write vector was locked and the cache_sm retried
     // and got the read vector again.
     cache_sm.cache_read_vc->get_http_info(&t_state.cache_info.object_read);
+    t_state.cache_info.read_policy_valid = false;
     // ToDo: Should support other levels of cache hits here, but the cache does not support it (yet)
     if (cache_sm.cache_read_vc->is_ram_cache_hit()) {
       t_state.cache_info.hit_miss_code = SQUID_HIT_RAM;
@@ -2517,6 +2565,7 @@ HttpSM::state_cache_open_read(int event, void *data)
     t_state.source = HttpTransact::SOURCE_CACHE;
 
     cache_sm.cache_read_vc->get_http_info(&t_state.cache_info.object_read);
+    t_state.cache_info.read_policy_valid = false;
     // ToDo: Should support other levels of cache hits here, but the cache does not support it (yet)
     if (cache_sm.cache_read_vc->is_ram_cache_hit()) {
       t_state.cache_info.hit_miss_code = SQUID_HIT_RAM;
@@ -2584,9 +2633,11 @@ HttpSM::main_handler(int event, void *data)
     jump_point = vc_entry->vc_handler;
     ink_assert(jump_point != (HttpSMHandler) nullptr);
     ink_assert(vc_entry->vc != (VConnection *)nullptr);
+    CpuProfiler::Scope state(DispatchTrace::handler_address(jump_point));
     (this->*jump_point)(event, data);
   } else {
     ink_assert(default_handler != (HttpSMHandler) nullptr);
+    CpuProfiler::Scope state(DispatchTrace::handler_address(default_handler));
     (this->*default_handler)(event, data);
   }
 
@@ -4248,7 +4299,8 @@ HttpSM::parse_range_and_compare(MIMEField *field, int64_t content_length)
     return;
   }
 
-  ranges = new RangeRecord[n_values];
+  ranges = static_cast<RangeRecord *>(txn_alloc(n_values * sizeof(RangeRecord)));
+  std::uninitialized_fill_n(ranges, n_values, RangeRecord());
   value += 6; // skip leading 'bytes='
   value_len -= 6;
 
@@ -4392,7 +4444,6 @@ HttpSM::parse_range_and_compare(MIMEField *field, int64_t content_length)
 Lfaild:
   t_state.range_in_cache   = false;
   t_state.num_range_fields = -1;
-  delete[] ranges;
   return;
 }
 
@@ -4675,7 +4726,7 @@ HttpSM::send_origin_throttled_response()
   call_transact_and_set_next_state(HttpTransact::HandleResponse);
 }
 
-static void
+void
 set_tls_options(NetVCOptions &opt, OverridableHttpConfigParams *txn_conf)
 {
   char *verify_server = nullptr;
@@ -5070,14 +5121,24 @@ HttpSM::do_http_server_open(bool raw)
       opt.set_ssl_servername(t_state.server_info.name);
     }
 
-    connect_action_handle = sslNetProcessor.connect_re(this,                                 // state machine
-                                                       &t_state.current.server->dst_addr.sa, // addr + port
-                                                       &opt);
+    // Requests that can be sent as a single HTTP/2 stream share a connection to the origin server if it negotiates h2.
+    connect_action_handle = nullptr;
+    if (Http2::enabled_out && !raw && !will_be_private_ss && !is_private() &&
+        TS_SERVER_SESSION_SHARING_MATCH_NONE != t_state.txn_conf->server_session_sharing_match &&
+        t_state.hdr_info.request_content_length != HTTP_UNDEFINED_CL && !t_state.is_websocket &&
+        t_state.method != HTTP_WKSIDX_CONNECT && plugin_tunnel_type == HTTP_NO_PLUGIN_TUNNEL &&
+        t_state.current.request_to != HttpTransact::PARENT_PROXY) {
+      SMDebug("http", "calling Http2ServerSession::connect_re");
+      connect_action_handle =
+        Http2ServerSession::connect_re(this, &t_state.current.server->dst_addr.sa, opt,
+                                       HRTIME_SECONDS(t_state.txn_conf->keep_alive_no_activity_timeout_out));
+    }
+    if (connect_action_handle == nullptr) {
+      connect_action_handle = connect_server(sslNetProcessor, opt);
+    }
   } else {
     SMDebug("http", "calling netProcessor.connect_re");
-    connect_action_handle = netProcessor.connect_re(this,                                 // state machine
-                                                    &t_state.current.server->dst_addr.sa, // addr + port
-                                                    &opt);
+    connect_action_handle = connect_server(netProcessor, opt);
   }
 
   if (connect_action_handle != ACTION_RESULT_DONE) {
@@ -5088,6 +5149,97 @@ HttpSM::do_http_server_open(bool raw)
   return;
 }
 
+/** Open a connection to the server, racing the other addresses of an origin server if there are any.
+
+    The race is only for the first connect of a transaction, the retries go through the addresses
+    one at a time as before.
+ */
+Action *
+HttpSM::connect_server(NetProcessor &processor, NetVCOptions &opt)
+{
+  IpEndpoint targets[HttpConnectRace::MAX_TARGETS];
+  int n_targets = 0;
+
+  if (race_addr_count > 0 && t_state.current.attempts <= 1 && t_state.current.request_to == HttpTransact::ORIGIN_SERVER &&
+      !t_state.outbound_conn_track_state.is_active()) {
+    targets[n_targets++] = t_state.current.server->dst_addr;
+    for (int i = 0; i < race_addr_count; ++i) {
+      // A local address to bind to is for one family only.
+      if (opt.addr_binding != NetVCOptions::ANY_ADDR && race_addrs[i].family() != targets[0].family()) {
+        continue;
+      }
+      targets[n_targets]        = race_addrs[i];
+      targets[n_targets].port() = targets[0].port();
+      ++n_targets;
+    }
+  }
+
+  if (n_targets > 1) {
+    SMDebug("http", "[%" PRId64 "] racing connections to %d addresses", sm_id, n_targets);
+    connect_raced  = true;
+    Action *action = HttpConnectRace::connect_re(this, processor, targets, n_targets, opt,
+                                                 HRTIME_MSECONDS(t_state.http_config_param->connect_race_delay),
+                                                 get_server_connect_timeout());
+    HTTP_INCREMENT_DYN_STAT(http_origin_connect_races_stat);
+    return action;
+  }
+  return processor.connect_re(this,                                 // state machine
+                              &t_state.current.server->dst_addr.sa, // addr + port
+                              &opt);
+}
+
+/** Keep the addresses of @a rr other than @a chosen to race it.
+
+    As in RFC 8305 section 4 the families are interleaved, starting with the other family than the
+    one of @a chosen. Addresses marked down are left out.
+ */
+void
+HttpSM::collect_race_addrs(HostDBRoundRobin *rr, HostDBInfo *chosen, ink_time_t now)
+{
+  constexpr int MAX_ADDRS = HttpConnectRace::MAX_TARGETS - 1;
+  IpEndpoint same[MAX_ADDRS], other[MAX_ADDRS];
+  int n_same = 0, n_other = 0;
+
+  for (int i = 0; i < rr->good; ++i) {
+    HostDBInfo &info = rr->info(i);
+    if (ats_ip_addr_eq(info.ip(), chosen->ip()) ||
+        !info.is_alive(now, static_cast<int32_t>(t_state.txn_conf->down_server_timeout))) {
+      continue;
+    }
+    if (info.ip()->sa_family == chosen->ip()->sa_family) {
+      if (n_same < MAX_ADDRS) {
+        ats_ip_copy(&same[n_same++], info.ip());
+      }
+    } else if (n_other < MAX_ADDRS) {
+      ats_ip_copy(&other[n_other++], info.ip());
+    }
+  }
+
+  for (int i = 0; race_addr_count < MAX_ADDRS && (i < n_same || i < n_other); ++i) {
+    if (i < n_other) {
+      race_addrs[race_addr_count++] = other[i];
+    }
+    if (i < n_same && race_addr_count < MAX_ADDRS) {
+      race_addrs[race_addr_count++] = same[i];
+    }
+  }
+}
+
+/// The time a new server connection is given until the response header starts.
+ink_hrtime
+HttpSM::get_server_connect_timeout()
+{
+  if (t_state.api_txn_connect_timeout_value != -1) {
+    return HRTIME_MSECONDS(t_state.api_txn_connect_timeout_value);
+  }
+  if (t_state.method == HTTP_WKSIDX_POST || t_state.method == HTTP_WKSIDX_PUT) {
+    return HRTIME_SECONDS(t_state.txn_conf->post_connect_attempts_timeout);
+  } else if (t_state.current.server == &t_state.parent_info) {
+    return HRTIME_SECONDS(t_state.txn_conf->parent_connect_timeout);
+  }
+  return HRTIME_SECONDS(t_state.txn_conf->connect_attempts_timeout);
+}
+
 void
 HttpSM::do_api_callout_internal()
 {
@@ -5357,7 +5509,8 @@ HttpSM::handle_post_failure()
   ink_assert(is_waiting_for_full_body || server_entry->eos == true);
 
   if (is_waiting_for_full_body) {
-    call_transact_and_set_next_state(HttpTransact::Forbidden);
+    // The buffer is only dropped when the body outgrows it.
+    call_transact_and_set_next_state(is_postbuf_valid() ? HttpTransact::Forbidden : HttpTransact::PostTooLarge);
     return;
   }
   // First order of business is to clean up from
@@ -5951,21 +6104,7 @@ HttpSM::attach_server_session(Http1ServerSession *s)
   // Set the inactivity timeout to the connect timeout so that we
   //   we fail this server if it doesn't start sending the response
   //   header
-  MgmtInt connect_timeout;
-
-  if (t_state.method == HTTP_WKSIDX_POST || t_state.method == HTTP_WKSIDX_PUT) {
-    connect_timeout = t_state.txn_conf->post_connect_attempts_timeout;
-  } else if (t_state.current.server == &t_state.parent_info) {
-    connect_timeout = t_state.txn_conf->parent_connect_timeout;
-  } else {
-    connect_timeout = t_state.txn_conf->connect_attempts_timeout;
-  }
-
-  if (t_state.api_txn_connect_timeout_value != -1) {
-    server_session->get_netvc()->set_inactivity_timeout(HRTIME_MSECONDS(t_state.api_txn_connect_timeout_value));
-  } else {
-    server_session->get_netvc()->set_inactivity_timeout(HRTIME_SECONDS(connect_timeout));
-  }
+  server_session->get_netvc()->set_inactivity_timeout(get_server_connect_timeout());
 
   if (t_state.api_txn_active_timeout_value != -1) {
     server_session->get_netvc()->set_active_timeout(HRTIME_MSECONDS(t_state.api_txn_active_timeout_value));
@@ -6087,7 +6226,7 @@ HttpSM::setup_cache_read_transfer()
   buf->append_block(HTTP_HEADER_BUFFER_SIZE_INDEX);
 #endif
 
-  buf->water_mark = (int)t_state.txn_conf->default_buffer_water_mark;
+  buf->water_mark = tunnel_buffer_water_mark(doc_size);
 
   IOBufferReader *buf_start = buf->alloc_reader();
 
@@ -6356,6 +6495,84 @@ HttpSM::find_http_resp_buffer_size(int64_t content_length)
   return alloc_index;
 }
 
+#if defined(TCP_INFO) && defined(HAVE_STRUCT_TCP_INFO)
+static bool
+get_tcp_info(NetVConnection *netvc, struct tcp_info &info)
+{
+  socklen_t len = sizeof(info);
+  return netvc != nullptr && getsockopt(netvc->get_socket(), IPPROTO_TCP, TCP_INFO, &info, &len) == 0;
+}
+#endif
+
+// int64_t HttpSM::tunnel_buffer_water_mark(int64_t cl)
+//
+//   Returns the water mark for the buffer of a response tunnel.
+//     With proxy.config.http.tunnel_buffer_autotune it is raised
+//     to what the client connection takes in one round trip, as
+//     far as the origin can fill it in that time, while the
+//     tunnels stay within proxy.config.http.tunnel_buffer_budget
+//
+int64_t
+HttpSM::tunnel_buffer_water_mark(int64_t content_length)
+{
+  const HttpConfigParams *params   = t_state.http_config_param;
+  const int64_t default_water_mark = t_state.txn_conf->default_buffer_water_mark;
+
+  tunnel_buffer_release();
+  if (!params->tunnel_buffer_autotune || (content_length != HTTP_UNDEFINED_CL && content_length <= default_water_mark)) {
+    return default_water_mark;
+  }
+
+  int64_t water_mark = default_water_mark;
+#if defined(TCP_INFO) && defined(HAVE_STRUCT_TCP_INFO)
+  struct tcp_info client = {};
+  if (ua_txn == nullptr || !get_tcp_info(ua_txn->get_netvc(), client) || client.tcpi_rtt == 0) {
+    return default_water_mark;
+  }
+  int64_t window = static_cast<int64_t>(client.tcpi_snd_cwnd) * client.tcpi_snd_mss;
+
+  // The origin receives about rcv_space bytes in each of its round trips.
+  struct tcp_info origin = {};
+  if (server_session != nullptr && get_tcp_info(server_session->get_netvc(), origin) && origin.tcpi_rcv_rtt > 0 &&
+      origin.tcpi_rcv_space > 0) {
+    window = std::min(window, static_cast<int64_t>(origin.tcpi_rcv_space) * client.tcpi_rtt / origin.tcpi_rcv_rtt);
+  }
+  SMDebug("http_tunnel", "client cwnd=%u mss=%u rtt=%uus, origin rcv_space=%u rcv_rtt=%uus, window=%" PRId64,
+          client.tcpi_snd_cwnd, client.tcpi_snd_mss, client.tcpi_rtt, origin.tcpi_rcv_space, origin.tcpi_rcv_rtt, window);
+  water_mark = std::max(water_mark, window);
+#endif
+
+  if (params->tunnel_buffer_max_water_mark > 0) {
+    water_mark = std::min(water_mark, std::max(params->tunnel_buffer_max_water_mark, default_water_mark));
+  }
+  if (content_length != HTTP_UNDEFINED_CL) {
+    water_mark = std::min(water_mark, content_length);
+  }
+
+  const int64_t extra = water_mark - default_water_mark;
+  if (extra > 0) {
+    if (tunnel_buffer_budget_used.fetch_add(extra) + extra > params->tunnel_buffer_budget) {
+      tunnel_buffer_budget_used.fetch_sub(extra);
+      SMDebug("http_tunnel", "tunnel buffer budget of %" PRId64 " is used up, water mark %" PRId64, params->tunnel_buffer_budget,
+              default_water_mark);
+      return default_water_mark;
+    }
+    tunnel_buffer_reserved = extra;
+  }
+
+  SMDebug("http_tunnel", "tuned water mark %" PRId64 " for content length %" PRId64, water_mark, content_length);
+  return water_mark;
+}
+
+void
+HttpSM::tunnel_buffer_release()
+{
+  if (tunnel_buffer_reserved > 0) {
+    tunnel_buffer_budget_used.fetch_sub(tunnel_buffer_reserved);
+    tunnel_buffer_reserved = 0;
+  }
+}
+
 // int HttpSM::server_transfer_init()
 //
 //    Moves data from the header buffer into the reply buffer
@@ -6447,7 +6664,7 @@ HttpSM::setup_transfer_from_transform()
 
   // TODO change this call to new_empty_MIOBuffer()
   MIOBuffer *buf            = new_MIOBuffer(alloc_index);
-  buf->water_mark           = (int)t_state.txn_conf->default_buffer_water_mark;
+  buf->water_mark           = tunnel_buffer_water_mark(HTTP_UNDEFINED_CL);
   IOBufferReader *buf_start = buf->alloc_reader();
 
   HttpTunnelConsumer *c = tunnel.get_consumer(transform_info.vc);
@@ -6551,7 +6768,7 @@ HttpSM::setup_server_transfer()
   MIOBuffer *buf = new_empty_MIOBuffer(alloc_index);
   buf->append_block(HTTP_HEADER_BUFFER_SIZE_INDEX);
 #endif
-  buf->water_mark           = (int)t_state.txn_conf->default_buffer_water_mark;
+  buf->water_mark           = tunnel_buffer_water_mark(t_state.hdr_info.response_content_length);
   IOBufferReader *buf_start = buf->alloc_reader();
 
   // we need to know if we are going to chunk the response or not
@@ -7074,6 +7291,10 @@ HttpSM::update_stats()
           milestones.difference_sec(TS_MILESTONE_SM_START, TS_MILESTONE_PLUGIN_ACTIVE),
           milestones.difference_sec(TS_MILESTONE_SM_START, TS_MILESTONE_PLUGIN_TOTAL));
   }
+
+  if (slowTxnCapture.wants(total_time)) {
+    slowTxnCapture.add(this, total_time);
+  }
 }
 
 //
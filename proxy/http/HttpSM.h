@@ -33,10 +33,13 @@
 
 #include <string_view>
 #include <optional>
+#include <memory>
+#include <cstddef>
 
 #include "tscore/ink_platform.h"
 #include "P_EventSystem.h"
 #include "HttpCacheSM.h"
+#include "HttpConnectRace.h"
 #include "HttpTransact.h"
 #include "UrlRewrite.h"
 #include "HttpTunnel.h"
@@ -44,6 +47,7 @@
 #include "../ProxyTransaction.h"
 #include "HdrUtils.h"
 #include "tscore/History.h"
+#include "tscore/MemArena.h"
 
 #define HTTP_API_CONTINUE (INK_API_EVENT_EVENTS_START + 0)
 #define HTTP_API_ERROR (INK_API_EVENT_EVENTS_START + 1)
@@ -84,6 +88,9 @@ enum BackgroundFill_t {
 
 extern ink_mutex debug_sm_list_mutex;
 
+/// Set the TLS verification options of an outbound connection from a transaction configuration.
+void set_tls_options(NetVCOptions &opt, OverridableHttpConfigParams *txn_conf);
+
 struct HttpVCTableEntry {
   VConnection *vc;
   MIOBuffer *read_buffer;
@@ -338,6 +345,7 @@ public:
   IOBufferReader *get_postbuf_clone_reader();
   bool get_postbuf_done();
   bool is_postbuf_valid();
+  int64_t postbuf_max_size() const;
 
 protected:
   int reentrancy_count = 0;
@@ -358,13 +366,31 @@ public:
 
   History<HISTORY_DEFAULT_SIZE> history;
 
+  /// Allocate @a n bytes, aligned for any type, that are released with the transaction.
+  void *
+  txn_alloc(size_t n)
+  {
+    size_t space = n + alignof(std::max_align_t) - 1;
+    void *ptr    = txn_arena.alloc(space).data();
+    return std::align(alignof(std::max_align_t), n, ptr, space);
+  }
+
 protected:
+  /// Memory for the life of the transaction, released all at once by cleanup().
+  ts::MemArena txn_arena;
+
   IOBufferReader *ua_buffer_reader     = nullptr;
   IOBufferReader *ua_raw_buffer_reader = nullptr;
 
   HttpVCTableEntry *server_entry     = nullptr;
   Http1ServerSession *server_session = nullptr;
 
+  /// Other addresses of the origin server, raced with the chosen one on the first connect.
+  IpEndpoint race_addrs[HttpConnectRace::MAX_TARGETS - 1];
+  int race_addr_count = 0;
+  /// The pending connect is a race, the address connected to is the one of the connection.
+  bool connect_raced = false;
+
   /* Because we don't want to take a session from a shared pool if we know that it will be private,
    * but we cannot set it to private until we have an attached server session.
    * So we use this variable to indicate that
@@ -454,6 +480,9 @@ protected:
   void do_hostdb_reverse_lookup();
   void do_cache_lookup_and_read();
   void do_http_server_open(bool raw = false);
+  Action *connect_server(NetProcessor &processor, NetVCOptions &opt);
+  void collect_race_addrs(HostDBRoundRobin *rr, HostDBInfo *chosen, ink_time_t now);
+  ink_hrtime get_server_connect_timeout();
   void send_origin_throttled_response();
   void do_setup_post_tunnel(HttpVC_t to_vc_type);
   void do_cache_prepare_write();
@@ -518,6 +547,8 @@ protected:
   bool is_bg_fill_necessary(HttpTunnelConsumer *c);
   int find_server_buffer_size();
   int find_http_resp_buffer_size(int64_t cl);
+  int64_t tunnel_buffer_water_mark(int64_t cl);
+  void tunnel_buffer_release();
   int64_t server_transfer_init(MIOBuffer *buf, int hdr_size);
 
 public:
@@ -537,11 +568,13 @@ public:
   int64_t pushed_response_body_bytes = 0;
   bool client_tcp_reused             = false;
   bool client_ssl_reused             = false;
+  bool client_early_data             = false; // the request arrived in TLS 1.3 early data
   bool client_connection_is_ssl      = false;
   bool is_internal                   = false;
   bool server_connection_is_ssl      = false;
   bool is_waiting_for_full_body      = false;
   bool is_using_post_buffer          = false;
+  int64_t tunnel_buffer_reserved     = 0; ///< Water mark above the default, held against the tunnel buffer budget.
   std::optional<bool> mptcp_state; // Don't initialize, that marks it as "not defined".
   const char *client_protocol     = "-";
   const char *client_sec_protocol = "-";
@@ -722,6 +755,13 @@ HttpSM::postbuf_clear()
   this->_postbuf.clear();
 }
 
+// The whole body when buffering it before it is sent, otherwise the part kept for a redirect.
+inline int64_t
+HttpSM::postbuf_max_size() const
+{
+  return is_waiting_for_full_body ? t_state.http_config_param->request_buffer_limit() : t_state.http_config_param->post_copy_size;
+}
+
 inline void
 HttpSM::disable_redirect()
 {
@@ -89,6 +89,10 @@ public:
   SessionProtocolSet session_protocol_preference;
   /// Set the session protocol preference.
   self &setSessionProtocolPreference(SessionProtocolSet const &);
+  /// Schedule HTTP/2 streams by urgency instead of the dependency tree.
+  bool f_http2_urgency = false;
+  /// Set HTTP/2 urgency scheduling.
+  self &setHttp2Urgency(bool);
 };
 
 inline HttpSessionAcceptOptions::HttpSessionAcceptOptions()
@@ -158,6 +162,13 @@ HttpSessionAcceptOptions::setSessionProtocolPreference(SessionProtocolSet const
   session_protocol_preference = sp_set;
   return *this;
 }
+
+inline HttpSessionAcceptOptions &
+HttpSessionAcceptOptions::setHttp2Urgency(bool flag)
+{
+  f_http2_urgency = flag;
+  return *this;
+}
 } // namespace detail
 
 /**
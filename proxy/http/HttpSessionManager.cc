@@ -45,6 +45,35 @@ initialize_thread_for_http_sessions(EThread *thread)
 
 HttpSessionManager httpSessionManager;
 
+namespace
+{
+/** Move @a ss, just taken from @a pool, to the connection of @a ethread.
+
+    @return @c false if it could not be moved, it is back in @a pool then.
+ */
+bool
+migrate_session(ServerSessionPool *pool, Http1ServerSession *ss, HttpSM *sm, EThread *ethread)
+{
+  UnixNetVConnection *server_vc = dynamic_cast<UnixNetVConnection *>(ss->get_netvc());
+  if (server_vc) {
+    UnixNetVConnection *new_vc = server_vc->migrateToCurrentThread(sm, ethread);
+    if (new_vc->thread != ethread) {
+      // Failed to migrate, put it back to the session pool
+      pool->releaseSession(ss);
+      return false;
+    } else if (new_vc != server_vc) {
+      // The VC migrated, keep things from timing out on us
+      new_vc->set_inactivity_timeout(new_vc->get_inactivity_timeout());
+      ss->set_netvc(new_vc);
+    } else {
+      // The VC moved, keep things from timing out on us
+      server_vc->set_inactivity_timeout(server_vc->get_inactivity_timeout());
+    }
+  }
+  return true;
+}
+} // namespace
+
 ServerSessionPool::ServerSessionPool() : Continuation(new_ProxyMutex()), m_ip_pool(1023), m_fqdn_pool(1023)
 {
   SET_HANDLER(&ServerSessionPool::eventHandler);
@@ -60,6 +89,7 @@ ServerSessionPool::purge()
   m_ip_pool.apply([](Http1ServerSession *ssn) -> void { ssn->do_io_close(); });
   m_ip_pool.clear();
   m_fqdn_pool.clear();
+  m_count.store(0, std::memory_order_relaxed);
 }
 
 bool
@@ -117,6 +147,7 @@ ServerSessionPool::acquireSession(sockaddr const *addr, CryptoHash const &hostna
       to_return = last;
       m_fqdn_pool.erase(last);
       m_ip_pool.erase(to_return);
+      m_count.fetch_sub(1, std::memory_order_relaxed);
     }
   } else if (TS_SERVER_SESSION_SHARING_MATCH_NONE != match_style) { // matching is not disabled.
     IPTable::iterator first, last;
@@ -138,6 +169,7 @@ ServerSessionPool::acquireSession(sockaddr const *addr, CryptoHash const &hostna
       to_return = last;
       m_ip_pool.erase(last);
       m_fqdn_pool.erase(to_return);
+      m_count.fetch_sub(1, std::memory_order_relaxed);
     }
   }
   return zret;
@@ -162,6 +194,7 @@ ServerSessionPool::releaseSession(Http1ServerSession *ss)
   // put it in the pools.
   m_ip_pool.insert(ss);
   m_fqdn_pool.insert(ss);
+  m_count.fetch_add(1, std::memory_order_relaxed);
 
   Debug("http_ss",
         "[%" PRId64 "] [release session] "
@@ -169,6 +202,18 @@ ServerSessionPool::releaseSession(Http1ServerSession *ss)
         ss->con_id);
 }
 
+int
+ServerSessionPool::countSessions(sockaddr const *addr, CryptoHash const &hostname_hash)
+{
+  int zret = 0;
+  for (auto spot = m_ip_pool.find(addr); spot != m_ip_pool.end() && spot->_ip_link.equal(addr, spot); ++spot) {
+    if (spot->hostname_hash == hostname_hash) {
+      ++zret;
+    }
+  }
+  return zret;
+}
+
 //   Called from the NetProcessor to let us know that a
 //    connection has closed down
 //
@@ -229,6 +274,7 @@ ServerSessionPool::eventHandler(int event, void *data)
       // Out of the pool! Now!
       m_ip_pool.erase(spot);
       m_fqdn_pool.erase(s);
+      m_count.fetch_sub(1, std::memory_order_relaxed);
       // Drop connection on this end.
       s->do_io_close();
       found = true;
@@ -320,41 +366,38 @@ HttpSessionManager::acquire_session(Continuation * /* cont ATS_UNUSED */, sockad
   // client session
   {
     // Now check to see if we have a connection in our shared connection pool
-    EThread *ethread = this_ethread();
+    EThread *ethread                    = this_ethread();
+    TSServerSessionSharingPoolType pool = static_cast<TSServerSessionSharingPoolType>(
+      sm->t_state.http_config_param->server_session_sharing_pool);
     Ptr<ProxyMutex> pool_mutex =
-      (TS_SERVER_SESSION_SHARING_POOL_THREAD == sm->t_state.http_config_param->server_session_sharing_pool) ?
-        ethread->server_session_pool->mutex :
-        m_g_pool->mutex;
+      (TS_SERVER_SESSION_SHARING_POOL_GLOBAL != pool) ? ethread->server_session_pool->mutex : m_g_pool->mutex;
     MUTEX_TRY_LOCK(lock, pool_mutex, ethread);
     if (lock.is_locked()) {
-      if (TS_SERVER_SESSION_SHARING_POOL_THREAD == sm->t_state.http_config_param->server_session_sharing_pool) {
+      if (TS_SERVER_SESSION_SHARING_POOL_GLOBAL != pool) {
         retval = ethread->server_session_pool->acquireSession(ip, hostname_hash, match_style, sm, to_return);
         Debug("http_ss", "[acquire session] thread pool search %s", to_return ? "successful" : "failed");
+        if (to_return) {
+          HTTP_INCREMENT_DYN_STAT(http_origin_session_pool_hit_stat);
+        } else if (TS_SERVER_SESSION_SHARING_POOL_HYBRID == pool && match_style != TS_SERVER_SESSION_SHARING_MATCH_NONE) {
+          to_return = steal_session(ethread, ip, hostname_hash, match_style, sm);
+          retval    = to_return ? HSM_DONE : HSM_NOT_FOUND;
+        }
       } else {
         retval = m_g_pool->acquireSession(ip, hostname_hash, match_style, sm, to_return);
         Debug("http_ss", "[acquire session] global pool search %s", to_return ? "successful" : "failed");
         // At this point to_return has been removed from the pool. Do we need to move it
         // to the same thread?
+        if (to_return && !migrate_session(m_g_pool, to_return, sm, ethread)) {
+          to_return = nullptr;
+          retval    = HSM_NOT_FOUND;
+        }
         if (to_return) {
-          UnixNetVConnection *server_vc = dynamic_cast<UnixNetVConnection *>(to_return->get_netvc());
-          if (server_vc) {
-            UnixNetVConnection *new_vc = server_vc->migrateToCurrentThread(sm, ethread);
-            if (new_vc->thread != ethread) {
-              // Failed to migrate, put it back to global session pool
-              m_g_pool->releaseSession(to_return);
-              to_return = nullptr;
-              retval    = HSM_NOT_FOUND;
-            } else if (new_vc != server_vc) {
-              // The VC migrated, keep things from timing out on us
-              new_vc->set_inactivity_timeout(new_vc->get_inactivity_timeout());
-              to_return->set_netvc(new_vc);
-            } else {
-              // The VC moved, keep things from timing out on us
-              server_vc->set_inactivity_timeout(server_vc->get_inactivity_timeout());
-            }
-          }
+          HTTP_INCREMENT_DYN_STAT(http_origin_session_pool_hit_stat);
         }
       }
+      if (!to_return && match_style != TS_SERVER_SESSION_SHARING_MATCH_NONE) {
+        HTTP_INCREMENT_DYN_STAT(http_origin_session_pool_miss_stat);
+      }
     } else { // Didn't get the lock.  to_return is still NULL
       retval = HSM_RETRY;
     }
@@ -370,12 +413,49 @@ HttpSessionManager::acquire_session(Continuation * /* cont ATS_UNUSED */, sockad
   return retval;
 }
 
+Http1ServerSession *
+HttpSessionManager::steal_session(EThread *ethread, sockaddr const *addr, CryptoHash const &hostname_hash,
+                                  TSServerSessionSharingMatchType match_style, HttpSM *sm)
+{
+  EventProcessor::ThreadGroupDescriptor const &group = eventProcessor.thread_group[ET_NET];
+  Http1ServerSession *to_return                      = nullptr;
+
+  // Start past this thread so the threads do not all look at the first one. A pool that is empty or
+  // busy is passed over without waiting for it, its sessions are for its own thread first.
+  int start = 0;
+  while (start < group._count && group._thread[start] != ethread) {
+    ++start;
+  }
+  for (int i = 1; i < group._count && !to_return; ++i) {
+    EThread *sibling = group._thread[(start + i) % group._count];
+    if (sibling == nullptr || sibling == ethread || sibling->server_session_pool == nullptr ||
+        (ethread->numa_node != -1 && sibling->numa_node != ethread->numa_node)) {
+      continue;
+    }
+    ServerSessionPool *pool = sibling->server_session_pool;
+    if (pool->m_count.load(std::memory_order_relaxed) == 0) {
+      continue;
+    }
+    MUTEX_TRY_LOCK(lock, pool->mutex, ethread);
+    if (lock.is_locked() && pool->acquireSession(addr, hostname_hash, match_style, sm, to_return) == HSM_DONE &&
+        !migrate_session(pool, to_return, sm, ethread)) {
+      to_return = nullptr;
+    }
+  }
+
+  Debug("http_ss", "[acquire session] sibling thread pool search %s", to_return ? "successful" : "failed");
+  if (to_return) {
+    HTTP_INCREMENT_DYN_STAT(http_origin_session_pool_steal_stat);
+  }
+  return to_return;
+}
+
 HSMresult_t
 HttpSessionManager::release_session(Http1ServerSession *to_release)
 {
   EThread *ethread = this_ethread();
   ServerSessionPool *pool =
-    TS_SERVER_SESSION_SHARING_POOL_THREAD == to_release->sharing_pool ? ethread->server_session_pool : m_g_pool;
+    TS_SERVER_SESSION_SHARING_POOL_GLOBAL != to_release->sharing_pool ? ethread->server_session_pool : m_g_pool;
   bool released_p = true;
 
   // The per thread lock looks like it should not be needed but if it's not locked the close checking I/O op will crash.
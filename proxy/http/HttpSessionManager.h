@@ -32,6 +32,8 @@
 
 #pragma once
 
+#include <atomic>
+
 #include "P_EventSystem.h"
 #include "Http1ServerSession.h"
 #include "tscore/IntrusiveHashMap.h"
@@ -89,6 +91,9 @@ public:
    */
   void releaseSession(Http1ServerSession *ss);
 
+  /// The number of sessions in the pool to @a addr for the host of @a host_hash.
+  int countSessions(sockaddr const *addr, CryptoHash const &host_hash);
+
   /// Close all sessions and then clear the table.
   void purge();
 
@@ -96,6 +101,9 @@ public:
   // Note that each server session is stored in both pools.
   IPTable m_ip_pool;
   FQDNTable m_fqdn_pool;
+
+  /// The number of sessions in the pool, read without the lock by other threads to skip an empty pool.
+  std::atomic<uint32_t> m_count{0};
 };
 
 class HttpSessionManager
@@ -110,6 +118,10 @@ public:
   int main_handler(int event, void *data);
 
 private:
+  /// Take a matching session from the per thread pool of another thread on the NUMA node of @a ethread.
+  Http1ServerSession *steal_session(EThread *ethread, sockaddr const *addr, CryptoHash const &hostname_hash,
+                                    TSServerSessionSharingMatchType match_style, HttpSM *sm);
+
   /// Global pool, used if not per thread pools.
   /// @internal We delay creating this because the session manager is created during global statics init.
   ServerSessionPool *m_g_pool = nullptr;
@@ -0,0 +1,212 @@
+/** @file
+
+  Capture of the slowest transactions.
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ */
+
+#include <algorithm>
+
+#include "tscore/BufferWriter.h"
+
+#include "HttpSlowTxn.h"
+#include "HttpSM.h"
+#include "records/I_RecProcess.h"
+
+SlowTxnCapture slowTxnCapture;
+
+namespace
+{
+constexpr char const DEBUG_TAG[] = "http_slow";
+
+/// The milestones reported as offsets from the start of the transaction, in the order they are usually reached.
+struct {
+  TSMilestonesType ms;
+  const char *name;
+} const milestone_names[] = {
+  {TS_MILESTONE_UA_BEGIN, "ua_begin"},
+  {TS_MILESTONE_UA_FIRST_READ, "ua_first_read"},
+  {TS_MILESTONE_UA_READ_HEADER_DONE, "ua_read_header_done"},
+  {TS_MILESTONE_TLS_HANDSHAKE_START, "tls_handshake_start"},
+  {TS_MILESTONE_TLS_HANDSHAKE_END, "tls_handshake_end"},
+  {TS_MILESTONE_CACHE_OPEN_READ_BEGIN, "cache_open_read_begin"},
+  {TS_MILESTONE_CACHE_OPEN_READ_END, "cache_open_read_end"},
+  {TS_MILESTONE_DNS_LOOKUP_BEGIN, "dns_lookup_begin"},
+  {TS_MILESTONE_DNS_LOOKUP_END, "dns_lookup_end"},
+  {TS_MILESTONE_SERVER_FIRST_CONNECT, "server_first_connect"},
+  {TS_MILESTONE_SERVER_CONNECT, "server_connect"},
+  {TS_MILESTONE_SERVER_CONNECT_END, "server_connect_end"},
+  {TS_MILESTONE_SERVER_BEGIN_WRITE, "server_begin_write"},
+  {TS_MILESTONE_SERVER_FIRST_READ, "server_first_read"},
+  {TS_MILESTONE_SERVER_READ_HEADER_DONE, "server_read_header_done"},
+  {TS_MILESTONE_CACHE_OPEN_WRITE_BEGIN, "cache_open_write_begin"},
+  {TS_MILESTONE_CACHE_OPEN_WRITE_END, "cache_open_write_end"},
+  {TS_MILESTONE_UA_BEGIN_WRITE, "ua_begin_write"},
+  {TS_MILESTONE_SERVER_CLOSE, "server_close"},
+  {TS_MILESTONE_UA_CLOSE, "ua_close"},
+  {TS_MILESTONE_SM_FINISH, "sm_finish"},
+};
+
+/// Milliseconds between two milestones, -1 if either is not set.
+int64_t
+span(TransactionMilestones const &milestones, TSMilestonesType start, TSMilestonesType end)
+{
+  if (milestones[start] == 0 || milestones[end] == 0) {
+    return -1;
+  }
+  return ink_hrtime_to_msec(milestones.elapsed(start, end));
+}
+
+std::string
+describe(HttpSM *sm, ink_hrtime total)
+{
+  HttpTransact::State &s                  = sm->t_state;
+  TransactionMilestones const &milestones = sm->milestones;
+  char url[256]                           = "-";
+  int url_len                             = 1;
+  char client_ip[INET6_ADDRSTRLEN];
+  const char *method = "-";
+  int method_len     = 1;
+  int status         = 0;
+
+  if (s.hdr_info.client_request.valid()) {
+    int skip = 0;
+    url_len  = 0;
+    s.hdr_info.client_request.url_print(url, sizeof(url), &url_len, &skip);
+    if (const char *m = s.hdr_info.client_request.method_get(&method_len); m != nullptr && method_len > 0) {
+      method = m;
+    } else {
+      method_len = 1;
+    }
+  }
+  if (s.hdr_info.client_response.valid()) {
+    status = s.hdr_info.client_response.status_get();
+  }
+  ats_ip_ntop(&s.client_info.src_addr, client_ip, sizeof(client_ip));
+
+  // Everything in milliseconds, the plugin milestones are the time spent in plugins rather than a point in time.
+  ts::LocalBufferWriter<1024> w;
+  w.print("{} ms sm_id={} client={} status={} {} {} dns={} cache_read={} cache_write={} plugin_active={} plugin_total={}",
+          ink_hrtime_to_msec(total), sm->sm_id, std::string_view(client_ip), status, std::string_view(method, method_len),
+          std::string_view(url, url_len), span(milestones, TS_MILESTONE_DNS_LOOKUP_BEGIN, TS_MILESTONE_DNS_LOOKUP_END),
+          span(milestones, TS_MILESTONE_CACHE_OPEN_READ_BEGIN, TS_MILESTONE_CACHE_OPEN_READ_END),
+          span(milestones, TS_MILESTONE_CACHE_OPEN_WRITE_BEGIN, TS_MILESTONE_CACHE_OPEN_WRITE_END),
+          ink_hrtime_to_msec(milestones[TS_MILESTONE_PLUGIN_ACTIVE]), ink_hrtime_to_msec(milestones[TS_MILESTONE_PLUGIN_TOTAL]));
+  for (auto const &m : milestone_names) {
+    if (milestones[m.ms] != 0) {
+      w.print(" {}={}", m.name, ink_hrtime_to_msec(milestones.elapsed(TS_MILESTONE_SM_START, m.ms)));
+    }
+  }
+  return std::string(w.view());
+}
+
+struct SlowTxnPublisher : public Continuation {
+  SlowTxnPublisher() : Continuation(new_ProxyMutex()) { SET_HANDLER(&SlowTxnPublisher::main_event); }
+
+  int
+  main_event(int, void *)
+  {
+    slowTxnCapture.publish();
+    return EVENT_CONT;
+  }
+};
+
+void
+stat_name(char *buff, size_t len, int i)
+{
+  snprintf(buff, len, "proxy.process.http.slow_txn.%d", i);
+}
+} // namespace
+
+void
+SlowTxnCapture::init()
+{
+  int count    = 0;
+  int interval = 60;
+
+  REC_ReadConfigInteger(count, "proxy.config.http.slow.capture.count");
+  REC_ReadConfigInteger(interval, "proxy.config.http.slow.capture.interval");
+  if (count <= 0) {
+    return;
+  }
+
+  for (int i = 0; i < std::min(count, MAX_COUNT); ++i) {
+    char name[64];
+    stat_name(name, sizeof(name), i);
+    RecRegisterStatString(RECT_PROCESS, name, const_cast<char *>(""), RECP_NON_PERSISTENT);
+  }
+  _txns.reserve(std::min(count, MAX_COUNT));
+  _interval = HRTIME_SECONDS(std::max(interval, 1));
+  _count    = std::min(count, MAX_COUNT);
+}
+
+void
+SlowTxnCapture::start()
+{
+  if (_count > 0) {
+    Note("Capturing the %d slowest transactions every %" PRId64 " seconds", _count, ink_hrtime_to_sec(_interval));
+    eventProcessor.schedule_every(new SlowTxnPublisher, _interval, ET_TASK);
+  }
+}
+
+void
+SlowTxnCapture::add(HttpSM *sm, ink_hrtime total)
+{
+  // The text is made before the lock is taken, it may not be kept after all.
+  Txn txn{total, describe(sm, total)};
+
+  std::lock_guard<std::mutex> lock(_mutex);
+  if (static_cast<int>(_txns.size()) == _count) {
+    if (total <= _txns.front().total) {
+      return;
+    }
+    std::pop_heap(_txns.begin(), _txns.end(), heap_order);
+    _txns.back() = std::move(txn);
+  } else {
+    _txns.push_back(std::move(txn));
+  }
+  std::push_heap(_txns.begin(), _txns.end(), heap_order);
+  if (static_cast<int>(_txns.size()) == _count) {
+    _floor.store(_txns.front().total, std::memory_order_relaxed);
+  }
+}
+
+void
+SlowTxnCapture::publish()
+{
+  // The empty vector swapped in has room for the next interval.
+  std::vector<Txn> txns;
+  txns.reserve(_count);
+
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    txns.swap(_txns);
+    _floor.store(0, std::memory_order_relaxed);
+  }
+
+  // Sorting the min heap by the reverse order has the slowest first.
+  std::sort_heap(txns.begin(), txns.end(), heap_order);
+  Debug(DEBUG_TAG, "publishing %zu slow transactions", txns.size());
+  for (int i = 0; i < _count; ++i) {
+    char name[64];
+    stat_name(name, sizeof(name), i);
+    const char *text = i < static_cast<int>(txns.size()) ? txns[i].text.c_str() : "";
+    RecSetRecordString(name, const_cast<char *>(text), REC_SOURCE_EXPLICIT, true);
+  }
+}
@@ -0,0 +1,92 @@
+/** @file
+
+  Capture of the slowest transactions.
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "tscore/ink_hrtime.h"
+
+class HttpSM;
+
+/** Keeps the slowest transactions of each interval.
+
+    The @c proxy.config.http.slow.capture.count slowest transactions that finish during an interval
+    of @c proxy.config.http.slow.capture.interval seconds are kept with the offset of each of their
+    milestones, and the time they spent in DNS, in the cache and in plugins. At the end of the
+    interval they are published, slowest first, in the @c proxy.process.http.slow_txn.<i> string
+    stats, and the capture of the next interval starts over.
+
+    A transaction that is not slower than all those kept when the capture is full costs a single
+    test, the lock is only taken to add one.
+ */
+class SlowTxnCapture
+{
+public:
+  /// The most transactions kept.
+  static constexpr int MAX_COUNT = 100;
+
+  /// Read the configuration and register the stats.
+  void init();
+  /// Start the interval.
+  void start();
+
+  /// Check if a transaction of @a total time would be kept.
+  bool
+  wants(ink_hrtime total) const
+  {
+    return _count > 0 && total > _floor.load(std::memory_order_relaxed);
+  }
+
+  /// Keep @a sm if it is still one of the slowest, @a total is its time.
+  void add(HttpSM *sm, ink_hrtime total);
+
+  /// End the interval and publish its transactions.
+  void publish();
+
+private:
+  struct Txn {
+    ink_hrtime total;
+    std::string text;
+  };
+
+  /// The heap order, the fastest transaction first.
+  static bool
+  heap_order(Txn const &lhs, Txn const &rhs)
+  {
+    return lhs.total > rhs.total;
+  }
+
+  int _count           = 0;
+  ink_hrtime _interval = 0;
+
+  std::mutex _mutex;
+  std::vector<Txn> _txns; ///< A min heap on the total time, @a _count long at most.
+  /// The time to beat, that of the fastest transaction kept when there is no room left or 0.
+  std::atomic<ink_hrtime> _floor{0};
+};
+
+extern SlowTxnCapture slowTxnCapture;
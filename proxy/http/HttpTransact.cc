@@ -31,6 +31,7 @@
 #include "HttpSM.h"
 #include "HttpCacheSM.h" //Added to get the scope of HttpCacheSM object - YTS Team, yamsat
 #include "HttpDebugNames.h"
+#include "HttpInvalidate.h"
 #include <ctime>
 #include "tscore/ParseRules.h"
 #include "HTTP.h"
@@ -77,6 +78,8 @@ static char range_type[] = "multipart/byteranges; boundary=RANGE_SEPARATOR";
 
 extern HttpBodyFactory *body_factory;
 
+Allocator httpTxnConfAllocator("httpTxnConfAllocator", sizeof(OverridableHttpConfigParams));
+
 inline static bool
 is_localhost(const char *name, int len)
 {
@@ -554,6 +557,19 @@ HttpTransact::Forbidden(State *s)
   TRANSACT_RETURN(SM_ACTION_SEND_ERROR_CACHE_NOOP, nullptr);
 }
 
+void
+HttpTransact::PostTooLarge(State *s)
+{
+  TxnDebug("http_trans", "[PostTooLarge] request body exceeds the request buffer");
+  HTTP_INCREMENT_DYN_STAT(http_post_body_too_large);
+  bootstrap_state_variables_from_request(s, &s->hdr_info.client_request);
+  // The rest of the body is still on its way, the connection can't be reused.
+  s->client_info.keep_alive = HTTP_NO_KEEPALIVE;
+  build_error_response(s, HTTP_STATUS_REQUEST_ENTITY_TOO_LARGE, "Request Entity Too Large", "request#entity_too_large");
+  s->squid_codes.log_code = SQUID_LOG_ERR_POST_ENTITY_TOO_LARGE;
+  TRANSACT_RETURN(SM_ACTION_SEND_ERROR_CACHE_NOOP, nullptr);
+}
+
 void
 HttpTransact::HandleBlindTunnel(State *s)
 {
@@ -986,6 +1002,15 @@ HttpTransact::ModifyRequest(State *s)
   // Initialize the state vars necessary to sending error responses
   bootstrap_state_variables_from_request(s, &request);
 
+  // While the net threads are overloaded turn new connections away quickly, sessions already in
+  // progress keep going.
+  if (net_overloaded && !s->state_machine->client_tcp_reused) {
+    HTTP_INCREMENT_DYN_STAT(http_overload_shed_requests_stat);
+    s->client_info.keep_alive = HTTP_NO_KEEPALIVE;
+    build_error_response(s, HTTP_STATUS_SERVICE_UNAVAILABLE, "Overloaded", "congestion#retryAfter");
+    TRANSACT_RETURN(SM_ACTION_SEND_ERROR_CACHE_NOOP, nullptr);
+  }
+
   ////////////////////////////////////////////////
   // If there is no scheme default to http      //
   ////////////////////////////////////////////////
@@ -1176,7 +1201,13 @@ HttpTransact::HandleRequest(State *s)
     }
     if (s->txn_conf->request_buffer_enabled &&
         (s->hdr_info.request_content_length > 0 || s->client_info.transfer_encoding == CHUNKED_ENCODING)) {
-      TRANSACT_RETURN(SM_ACTION_WAIT_FOR_FULL_BODY, nullptr);
+      // A body known to be larger than the buffer is sent as it arrives, as it was without the buffering.
+      if (s->hdr_info.request_content_length > s->http_config_param->request_buffer_limit()) {
+        TxnDebug("http_trans", "request body of %" PRId64 " bytes is larger than the request buffer, not buffering it",
+                 s->hdr_info.request_content_length);
+      } else {
+        TRANSACT_RETURN(SM_ACTION_WAIT_FOR_FULL_BODY, nullptr);
+      }
     }
   }
 
@@ -3039,6 +3070,10 @@ HttpTransact::HandleCacheOpenReadMiss(State *s)
              does_method_effect_cache(s->method) == false || s->range_setup == RANGE_NOT_SATISFIABLE ||
              s->range_setup == RANGE_NOT_HANDLED) {
     s->cache_info.action = CACHE_DO_NO_ACTION;
+  } else if (!cacheProcessor.admit_write(&s->state_machine->get_cache_sm().get_cache_key())) {
+    // Not missed often enough yet to be worth the room it would take in the cache.
+    TxnDebug("http_trans", "[HandleCacheOpenReadMiss] write not admitted");
+    s->cache_info.action = CACHE_DO_NO_ACTION;
   } else {
     s->cache_info.action = CACHE_PREPARE_TO_WRITE;
   }
@@ -3348,6 +3383,10 @@ HttpTransact::handle_response_from_parent(State *s)
     if (s->parent_result.retry) {
       s->parent_params->markParentUp(&s->parent_result);
     }
+    if (s->state_machine->milestones[TS_MILESTONE_SERVER_READ_HEADER_DONE] != 0) {
+      s->parent_params->markParentLatency(
+        &s->parent_result, s->state_machine->milestones.elapsed(TS_MILESTONE_SERVER_CONNECT, TS_MILESTONE_SERVER_READ_HEADER_DONE));
+    }
     handle_forward_server_connection_open(s);
     break;
   case PARENT_RETRY:
@@ -3990,6 +4029,7 @@ HttpTransact::handle_cache_operation_on_forward_server_response(State *s)
   HTTPStatus client_response_code = HTTP_STATUS_NONE;
   const char *warn_text           = nullptr;
   bool cacheable                  = false;
+  bool server_error               = false;
 
   cacheable = is_response_cacheable(s, &s->hdr_info.client_request, &s->hdr_info.server_response);
   TxnDebug("http_trans", "[hcoofsr] response %s cacheable", cacheable ? "is" : "is not");
@@ -4144,9 +4184,11 @@ HttpTransact::handle_cache_operation_on_forward_server_response(State *s)
        negative_revalidating_lifetime. (negative revalidating)
      */
 
-    if ((server_response_code == HTTP_STATUS_INTERNAL_SERVER_ERROR || server_response_code == HTTP_STATUS_GATEWAY_TIMEOUT ||
-         server_response_code == HTTP_STATUS_BAD_GATEWAY || server_response_code == HTTP_STATUS_SERVICE_UNAVAILABLE) &&
-        s->cache_info.action == CACHE_DO_UPDATE && s->txn_conf->negative_revalidating_enabled &&
+    server_error = server_response_code == HTTP_STATUS_INTERNAL_SERVER_ERROR ||
+                   server_response_code == HTTP_STATUS_GATEWAY_TIMEOUT || server_response_code == HTTP_STATUS_BAD_GATEWAY ||
+                   server_response_code == HTTP_STATUS_SERVICE_UNAVAILABLE;
+
+    if (server_error && s->cache_info.action == CACHE_DO_UPDATE && s->txn_conf->negative_revalidating_enabled &&
         is_stale_cache_response_returnable(s)) {
       TxnDebug("http_trans", "[hcoofsr] negative revalidating: revalidate stale object and serve from cache");
 
@@ -4205,6 +4247,15 @@ HttpTransact::handle_cache_operation_on_forward_server_response(State *s)
       return;
     }
 
+    // Otherwise the cached response may still stand in for the error within its stale-if-error window,
+    // it is served as is and left to be revalidated by the next request.
+    if (server_error && s->cache_info.action == CACHE_DO_UPDATE && is_stale_if_error_returnable(s)) {
+      TxnDebug("http_trans", "[hcoofsr] stale-if-error: serving the stale object instead of %d", server_response_code);
+      SET_VIA_STRING(VIA_SERVER_RESULT, VIA_SERVER_ERROR);
+      build_response_from_cache(s, HTTP_WARNING_CODE_REVALIDATION_FAILED);
+      return;
+    }
+
     s->next_action       = SM_ACTION_SERVER_READ;
     client_response_code = server_response_code;
     base_response        = &s->hdr_info.server_response;
@@ -4744,6 +4795,9 @@ HttpTransact::set_headers_for_cache_write(State *s, HTTPInfo *cache_info, HTTPHd
   // add one marker to the content in cache
   // cache_info->response_get()->value_set("@WWW-Auth", 9, "true", 4);
   //}
+
+  // Precompute the variant of the alternate for SelectFromAlternates().
+  HttpTransactCache::store_variant_key(cache_info->request_get(), cache_info->response_get());
   DUMP_HEADER("http_hdrs", cache_info->request_get(), s->state_machine_id, "Cached Request Hdr");
 }
 
@@ -5585,6 +5639,8 @@ HttpTransact::initialize_state_variables_from_request(State *s, HTTPHdr *obsolet
     if (s->pp_info.proxy_protocol_version != NetVConnection::ProxyProtocolVersion::UNDEFINED) {
       ats_ip_copy(s->pp_info.src_addr, vc->pp_info.src_addr);
       ats_ip_copy(s->pp_info.dst_addr, vc->pp_info.dst_addr);
+      memcpy(s->pp_info.tlv, vc->pp_info.tlv, vc->pp_info.tlv_len);
+      s->pp_info.tlv_len = vc->pp_info.tlv_len;
     }
   }
   s->request_data.xact_start                      = s->client_request_time;
@@ -5758,7 +5814,8 @@ HttpTransact::is_cache_response_returnable(State *s)
 bool
 HttpTransact::is_stale_cache_response_returnable(State *s)
 {
-  HTTPHdr *cached_response = s->cache_info.object_read->response_get();
+  HTTPHdr *cached_response       = s->cache_info.object_read->response_get();
+  const HTTPCachePolicy &policy = cached_response_policy(s);
 
   // First check if client allows cached response
   // Note does_client_permit_lookup was set to
@@ -5773,7 +5830,7 @@ HttpTransact::is_stale_cache_response_returnable(State *s)
   uint32_t cc_mask;
   cc_mask = (MIME_COOKED_MASK_CC_MUST_REVALIDATE | MIME_COOKED_MASK_CC_PROXY_REVALIDATE | MIME_COOKED_MASK_CC_NEED_REVALIDATE_ONCE |
              MIME_COOKED_MASK_CC_NO_CACHE | MIME_COOKED_MASK_CC_NO_STORE | MIME_COOKED_MASK_CC_S_MAXAGE);
-  if ((cached_response->get_cooked_cc_mask() & cc_mask) || cached_response->is_pragma_no_cache_set()) {
+  if ((policy.cc_mask & cc_mask) || policy.pragma_no_cache) {
     TxnDebug("http_trans", "[is_stale_cache_response_returnable] "
                            "document headers prevent serving stale");
     return false;
@@ -5781,8 +5838,8 @@ HttpTransact::is_stale_cache_response_returnable(State *s)
   // See how old the document really is.  We don't want create a
   //   stale content museum of documents that are no longer available
   time_t current_age = HttpTransactHeaders::calculate_document_age(s->cache_info.object_read->request_sent_time_get(),
-                                                                   s->cache_info.object_read->response_received_time_get(),
-                                                                   cached_response, cached_response->get_date(), s->current.now);
+                                                                   s->cache_info.object_read->response_received_time_get(), policy,
+                                                                   s->current.now);
   // Negative age is overflow
   if ((current_age < 0) || (current_age > s->txn_conf->cache_max_stale_age)) {
     TxnDebug("http_trans",
@@ -5804,6 +5861,72 @@ HttpTransact::is_stale_cache_response_returnable(State *s)
   return true;
 }
 
+///////////////////////////////////////////////////////////////////////////////
+// Name       : cached_response_staleness()
+// Description: how long the cached response has been stale, in seconds
+//
+// Details    :
+//
+// Negative while it is still fresh. Used with the RFC 5861 windows of the
+// cached response, which count from the end of its freshness.
+///////////////////////////////////////////////////////////////////////////////
+static int64_t
+cached_response_staleness(HttpTransact::State *s)
+{
+  const HTTPCachePolicy &policy = HttpTransact::cached_response_policy(s);
+  bool heuristic                = false;
+  int fresh_limit               = HttpTransact::calculate_document_freshness_limit(s, policy, &heuristic);
+  time_t current_age = HttpTransactHeaders::calculate_document_age(s->cache_info.object_read->request_sent_time_get(),
+                                                                   s->cache_info.object_read->response_received_time_get(), policy,
+                                                                   s->current.now);
+  return current_age < 0 ? INT64_MAX : current_age - fresh_limit;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Name       : is_stale_while_revalidate_returnable()
+// Description: check if the cached response can be served while another
+//              transaction revalidates it
+//
+// Details    :
+//
+// True if the response is within its stale-while-revalidate window and could
+// be served stale at all.
+///////////////////////////////////////////////////////////////////////////////
+bool
+HttpTransact::is_stale_while_revalidate_returnable(State *s)
+{
+  const HTTPCachePolicy &policy = cached_response_policy(s);
+
+  if (policy.cc_stale_while_revalidate < 0 || cached_response_staleness(s) > policy.cc_stale_while_revalidate) {
+    return false;
+  }
+  TxnDebug("http_trans", "[is_stale_while_revalidate_returnable] within stale-while-revalidate=%d",
+           policy.cc_stale_while_revalidate);
+  return is_stale_cache_response_returnable(s);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Name       : is_stale_if_error_returnable()
+// Description: check if the cached response can be served in place of an
+//              error of the origin server
+//
+// Details    :
+//
+// True if the response is within its stale-if-error window and could be
+// served stale at all.
+///////////////////////////////////////////////////////////////////////////////
+bool
+HttpTransact::is_stale_if_error_returnable(State *s)
+{
+  const HTTPCachePolicy &policy = cached_response_policy(s);
+
+  if (policy.cc_stale_if_error < 0 || cached_response_staleness(s) > policy.cc_stale_if_error) {
+    return false;
+  }
+  TxnDebug("http_trans", "[is_stale_if_error_returnable] within stale-if-error=%d", policy.cc_stale_if_error);
+  return is_stale_cache_response_returnable(s);
+}
+
 bool
 HttpTransact::url_looks_dynamic(URL *url)
 {
@@ -7037,23 +7160,44 @@ HttpTransact::does_client_request_permit_storing(CacheControlResult *c, HTTPHdr
   return (true);
 }
 
+//////////////////////////////////////////////////////////////////////////////
+//
+//      const HTTPCachePolicy &HttpTransact::cached_response_policy()
+//
+//      The cache policy of the cached response being looked at. It is
+//      taken the first time it is needed after the cache hands back
+//      object_read, so the freshness and staleness checks share the
+//      parsed dates instead of parsing them again each time.
+//
+//////////////////////////////////////////////////////////////////////////////
+const HTTPCachePolicy &
+HttpTransact::cached_response_policy(State *s)
+{
+  ink_assert(s->cache_info.object_read != nullptr);
+  if (!s->cache_info.read_policy_valid) {
+    s->cache_info.read_policy.init(s->cache_info.object_read->response_get());
+    s->cache_info.read_policy_valid = true;
+  }
+  return s->cache_info.read_policy;
+}
+
 int
-HttpTransact::calculate_document_freshness_limit(State *s, HTTPHdr *response, time_t response_date, bool *heuristic)
+HttpTransact::calculate_document_freshness_limit(State *s, const HTTPCachePolicy &policy, bool *heuristic)
 {
   bool expires_set, date_set, last_modified_set;
   time_t date_value, expires_value, last_modified_value;
   MgmtInt min_freshness_bounds, max_freshness_bounds;
   int freshness_limit = 0;
-  uint32_t cc_mask    = response->get_cooked_cc_mask();
+  uint32_t cc_mask    = policy.cc_mask;
 
   *heuristic = false;
 
   if (cc_mask & (MIME_COOKED_MASK_CC_S_MAXAGE | MIME_COOKED_MASK_CC_MAX_AGE)) {
     if (cc_mask & MIME_COOKED_MASK_CC_S_MAXAGE) {
-      freshness_limit = (int)response->get_cooked_cc_s_maxage();
+      freshness_limit = (int)policy.cc_s_maxage;
       TxnDebug("http_match", "calculate_document_freshness_limit --- s_max_age set, freshness_limit = %d", freshness_limit);
     } else if (cc_mask & MIME_COOKED_MASK_CC_MAX_AGE) {
-      freshness_limit = (int)response->get_cooked_cc_max_age();
+      freshness_limit = (int)policy.cc_max_age;
       TxnDebug("http_match", "calculate_document_freshness_limit --- max_age set, freshness_limit = %d", freshness_limit);
     }
     freshness_limit = std::min(std::max(0, freshness_limit), (int)s->txn_conf->cache_guaranteed_max_lifetime);
@@ -7064,11 +7208,11 @@ HttpTransact::calculate_document_freshness_limit(State *s, HTTPHdr *response, ti
       expires_set   = true;
       expires_value = s->plugin_set_expire_time;
     } else {
-      expires_set   = (response->presence(MIME_PRESENCE_EXPIRES) != 0);
-      expires_value = response->get_expires();
+      expires_set   = policy.has_expires;
+      expires_value = policy.expires;
     }
 
-    date_value = response_date;
+    date_value = policy.date;
     if (date_value > 0) {
       date_set = true;
     } else {
@@ -7096,9 +7240,9 @@ HttpTransact::calculate_document_freshness_limit(State *s, HTTPHdr *response, ti
       freshness_limit = std::min(std::max(0, freshness_limit), (int)s->txn_conf->cache_guaranteed_max_lifetime);
     } else {
       last_modified_value = 0;
-      if (response->presence(MIME_PRESENCE_LAST_MODIFIED)) {
+      if (policy.has_last_modified) {
         last_modified_set   = true;
-        last_modified_value = response->get_last_modified();
+        last_modified_value = policy.last_modified;
         TxnDebug("http_match", "calculate_document_freshness_limit --- Last Modified header = %" PRId64,
                  (int64_t)last_modified_value);
 
@@ -7151,6 +7295,30 @@ HttpTransact::calculate_document_freshness_limit(State *s, HTTPHdr *response, ti
   return (freshness_limit);
 }
 
+//////////////////////////////////////////////////////////////////////////////
+//
+//      bool HttpTransact::is_cached_object_invalidated()
+//
+//      Checks the cached object against the rules of invalidate.config,
+//      on its cache key URL and on the tags of its cached response.
+//
+//////////////////////////////////////////////////////////////////////////////
+bool
+HttpTransact::is_cached_object_invalidated(State *s, HTTPHdr *cached_obj_response)
+{
+  HttpInvalidate::scoped_config invalidate;
+
+  if (!invalidate || invalidate->empty()) {
+    return false;
+  }
+
+  URL *url = s->cache_info.lookup_url ? s->cache_info.lookup_url : s->hdr_info.client_request.url_get();
+  int url_len;
+  const char *url_str = url->string_get_ref(&url_len);
+
+  return invalidate->is_invalidated(std::string_view(url_str, url_len), cached_obj_response, s->response_received_time);
+}
+
 //////////////////////////////////////////////////////////////////////////////
 //
 //
@@ -7170,7 +7338,7 @@ HttpTransact::what_is_document_freshness(State *s, HTTPHdr *client_request, HTTP
   bool heuristic, do_revalidate = false;
   int age_limit;
   int fresh_limit;
-  ink_time_t current_age, response_date;
+  ink_time_t current_age;
   uint32_t cc_mask, cooked_cc_mask;
   uint32_t os_specifies_revalidate;
 
@@ -7181,6 +7349,16 @@ HttpTransact::what_is_document_freshness(State *s, HTTPHdr *client_request, HTTP
     }
   }
 
+  //////////////////////////////////////////////////////
+  // An invalidation rule newer than the cached copy  //
+  // makes it stale whatever its headers say.         //
+  //////////////////////////////////////////////////////
+  if (is_cached_object_invalidated(s, cached_obj_response)) {
+    TxnDebug("http_match", "[what_is_document_freshness] document invalidated by invalidate.config");
+    HTTP_INCREMENT_DYN_STAT(http_cache_invalidated_stat);
+    return (FRESHNESS_STALE);
+  }
+
   //////////////////////////////////////////////////////
   // If config file has a ttl-in-cache field set,     //
   // it has priority over any other http headers and  //
@@ -7200,7 +7378,10 @@ HttpTransact::what_is_document_freshness(State *s, HTTPHdr *client_request, HTTP
     }
   }
 
-  cooked_cc_mask          = cached_obj_response->get_cooked_cc_mask();
+  ink_assert(cached_obj_response == s->cache_info.object_read->response_get());
+  const HTTPCachePolicy &policy = cached_response_policy(s);
+
+  cooked_cc_mask          = policy.cc_mask;
   os_specifies_revalidate = cooked_cc_mask & (MIME_COOKED_MASK_CC_MUST_REVALIDATE | MIME_COOKED_MASK_CC_PROXY_REVALIDATE);
   cc_mask                 = MIME_COOKED_MASK_CC_NEED_REVALIDATE_ONCE;
 
@@ -7212,12 +7393,11 @@ HttpTransact::what_is_document_freshness(State *s, HTTPHdr *client_request, HTTP
     return FRESHNESS_STALE;
   }
 
-  response_date = cached_obj_response->get_date();
-  fresh_limit   = calculate_document_freshness_limit(s, cached_obj_response, response_date, &heuristic);
+  fresh_limit = calculate_document_freshness_limit(s, policy, &heuristic);
   ink_assert(fresh_limit >= 0);
 
-  current_age = HttpTransactHeaders::calculate_document_age(s->request_sent_time, s->response_received_time, cached_obj_response,
-                                                            response_date, s->current.now);
+  current_age =
+    HttpTransactHeaders::calculate_document_age(s->request_sent_time, s->response_received_time, policy, s->current.now);
 
   // First check overflow status
   // Second if current_age is under the max, use the smaller value
@@ -7590,6 +7770,11 @@ HttpTransact::build_request(State *s, HTTPHdr *base_request, HTTPHdr *outgoing_r
   HttpTransactHeaders::add_global_user_agent_header_to_request(s->txn_conf, outgoing_request);
   handle_request_keep_alive_headers(s, outgoing_version, outgoing_request);
 
+  // Tell the origin the request arrived in TLS early data (RFC 8470), it can answer 425 Too Early.
+  if (s->state_machine->client_early_data) {
+    outgoing_request->value_set("Early-Data", 10, "1", 1);
+  }
+
   // handle_conditional_headers appears to be obsolete.  Nothing happens
   // unless s->cache_info.action == HttpTransact::CACHE_DO_UPDATE.  In that
   // case an assert will go off.  The functionality of this method
@@ -75,6 +75,9 @@ class HttpSM;
 
 #define UNKNOWN_INTERNAL_ERROR (INK_START_ERRNO - 1)
 
+/// The per transaction copies of the overridable configuration, only the transactions that override it have one.
+extern Allocator httpTxnConfAllocator;
+
 enum ViaStringIndex_t {
   //
   // General information
@@ -251,6 +254,7 @@ public:
     CACHE_WL_FAIL_ACTION_STALE_ON_REVALIDATE               = 0x02,
     CACHE_WL_FAIL_ACTION_ERROR_ON_MISS_STALE_ON_REVALIDATE = 0x03,
     CACHE_WL_FAIL_ACTION_ERROR_ON_MISS_OR_REVALIDATE       = 0x04,
+    CACHE_WL_FAIL_ACTION_READ_RETRY                        = 0x05,
     TOTAL_CACHE_WL_FAIL_ACTION_TYPES
   };
 
@@ -523,6 +527,8 @@ public:
     SquidHitMissCode hit_miss_code    = SQUID_MISS_NONE;
     URL *parent_selection_url         = nullptr;
     URL parent_selection_url_storage;
+    HTTPCachePolicy read_policy; ///< Of the response of @a object_read, see HttpTransact::cached_response_policy().
+    bool read_policy_valid = false;
 
     _CacheLookupInfo() {}
   } CacheLookupInfo;
@@ -816,8 +822,8 @@ public:
     int64_t range_output_cl  = 0;
     RangeRecord *ranges      = nullptr;
 
-    OverridableHttpConfigParams *txn_conf = nullptr;
-    OverridableHttpConfigParams my_txn_conf; // Storage for plugins, to avoid malloc
+    OverridableHttpConfigParams *txn_conf    = nullptr;
+    OverridableHttpConfigParams *my_txn_conf = nullptr; // Storage for plugins, from httpTxnConfAllocator on the first override
 
     bool transparent_passthrough = false;
     bool range_in_cache          = false;
@@ -868,6 +874,12 @@ public:
       ParentConfig::release(parent_params);
       parent_params = nullptr;
 
+      if (my_txn_conf) {
+        httpTxnConfAllocator.free_void(my_txn_conf);
+        my_txn_conf = nullptr;
+      }
+      txn_conf = nullptr;
+
       hdr_info.client_request.destroy();
       hdr_info.client_response.destroy();
       hdr_info.server_request.destroy();
@@ -887,8 +899,7 @@ public:
       hostdb_entry.clear();
       outbound_conn_track_state.clear();
 
-      delete[] ranges;
-      ranges      = nullptr;
+      ranges      = nullptr; // In the transaction arena of the HttpSM.
       range_setup = RANGE_NONE;
       return;
     }
@@ -897,11 +908,12 @@ public:
     void
     setup_per_txn_configs()
     {
-      if (txn_conf != &my_txn_conf) {
-        // Make sure we copy it first.
-        memcpy(&my_txn_conf, &http_config_param->oride, sizeof(my_txn_conf));
-        txn_conf = &my_txn_conf;
+      if (my_txn_conf == nullptr) {
+        // Copy on the first write, the transactions that never override anything share the global configuration.
+        my_txn_conf = static_cast<OverridableHttpConfigParams *>(httpTxnConfAllocator.alloc_void());
+        memcpy(my_txn_conf, &http_config_param->oride, sizeof(*my_txn_conf));
       }
+      txn_conf = my_txn_conf;
     }
 
     void
@@ -937,6 +949,7 @@ public:
   static void HandleRequestAuthorized(State *s);
   static void BadRequest(State *s);
   static void Forbidden(State *s);
+  static void PostTooLarge(State *s);
   static void PostActiveTimeoutResponse(State *s);
   static void PostInactiveTimeoutResponse(State *s);
   static void HandleFiltering(State *s);
@@ -1016,6 +1029,8 @@ public:
   static bool is_server_negative_cached(State *s);
   static bool is_cache_response_returnable(State *s);
   static bool is_stale_cache_response_returnable(State *s);
+  static bool is_stale_while_revalidate_returnable(State *s);
+  static bool is_stale_if_error_returnable(State *s);
   static bool need_to_revalidate(State *s);
   static bool url_looks_dynamic(URL *url);
   static bool is_request_cache_lookupable(State *s);
@@ -1048,8 +1063,10 @@ public:
 
   static void handle_request_keep_alive_headers(State *s, HTTPVersion ver, HTTPHdr *heads);
   static void handle_response_keep_alive_headers(State *s, HTTPVersion ver, HTTPHdr *heads);
-  static int calculate_document_freshness_limit(State *s, HTTPHdr *response, time_t response_date, bool *heuristic);
+  static int calculate_document_freshness_limit(State *s, const HTTPCachePolicy &policy, bool *heuristic);
+  static const HTTPCachePolicy &cached_response_policy(State *s);
   static int calculate_freshness_fuzz(State *s, int fresh_limit);
+  static bool is_cached_object_invalidated(State *s, HTTPHdr *cached_obj_response);
   static Freshness_t what_is_document_freshness(State *s, HTTPHdr *client_request, HTTPHdr *cached_obj_response);
   static Authentication_t AuthenticationNeeded(const OverridableHttpConfigParams *p, HTTPHdr *client_request,
                                                HTTPHdr *obj_response);
@@ -29,6 +29,7 @@
 #include <ctime>
 #include "HTTP.h"
 #include "HttpCompat.h"
+#include "tscore/HashFNV.h"
 #include "tscore/InkErrno.h"
 
 /**
@@ -150,6 +151,193 @@ is_empty(char *s)
   return (s[0] == NUL);
 }
 
+/// Field of the cached request with its variant key.
+static constexpr char VARIANT_KEY_FIELD[]   = "@Variant-Key";
+static constexpr int VARIANT_KEY_FIELD_LEN = sizeof(VARIANT_KEY_FIELD) - 1;
+
+/**
+  Hash the name and the values of the @a name fields of @a request, lower
+  cased and without white space, as do_vary_header_values_match() compares
+  them.
+
+*/
+static void
+update_variant_key(ATSHash64FNV1a &hash, HTTPHdr *request, const char *name, int name_len)
+{
+  char buffer[256];
+  int n = 0;
+
+  auto put = [&](char c) {
+    if (n == static_cast<int>(sizeof(buffer))) {
+      hash.update(buffer, n);
+      n = 0;
+    }
+    buffer[n++] = c;
+  };
+
+  for (int i = 0; i < name_len; ++i) {
+    put(ParseRules::ink_tolower(name[i]));
+  }
+  put(':');
+  for (MIMEField *field = request->field_find(name, name_len); field != nullptr; field = field->m_next_dup) {
+    int len;
+    const char *value = field->value_get(&len);
+    for (int i = 0; i < len; ++i) {
+      if (!ParseRules::is_ws(value[i])) {
+        put(ParseRules::ink_tolower(value[i]));
+      }
+    }
+    put(',');
+  }
+  put('\n');
+  hash.update(buffer, n);
+}
+
+/**
+  Compute the variant key of @a request for the Vary of @a response.
+
+  It is a hash of the normalized values of the Accept headers and of the
+  headers the response varies on, two requests with the same key are
+  (but for a collision) the same variant. The keys of the alternates are
+  computed as they are written, so that SelectFromAlternates() only has to
+  compute that of the client request.
+
+  @return the key, 0 if the response can't have a key (Vary: *).
+
+*/
+uint64_t
+HttpTransactCache::calculate_variant_key(HTTPHdr *request, HTTPHdr *response)
+{
+  ATSHash64FNV1a hash;
+
+  update_variant_key(hash, request, MIME_FIELD_ACCEPT, MIME_LEN_ACCEPT);
+  update_variant_key(hash, request, MIME_FIELD_ACCEPT_CHARSET, MIME_LEN_ACCEPT_CHARSET);
+  update_variant_key(hash, request, MIME_FIELD_ACCEPT_ENCODING, MIME_LEN_ACCEPT_ENCODING);
+  update_variant_key(hash, request, MIME_FIELD_ACCEPT_LANGUAGE, MIME_LEN_ACCEPT_LANGUAGE);
+
+  if (response->presence(MIME_PRESENCE_VARY)) {
+    StrList vary_list;
+
+    if (response->value_get_comma_list(MIME_FIELD_VARY, MIME_LEN_VARY, &vary_list) > 0) {
+      for (Str *field = vary_list.head; field != nullptr; field = field->next) {
+        if (field->len == 1 && field->str[0] == '*') {
+          return 0;
+        }
+        if (field->len > 0) {
+          update_variant_key(hash, request, field->str, field->len);
+        }
+      }
+    }
+  }
+
+  hash.final();
+  uint64_t key = hash.get();
+  return key != 0 ? key : 1;
+}
+
+/**
+  Store the variant key of the cached @a request of @a response in the
+  request, replacing any value the client sent.
+
+*/
+void
+HttpTransactCache::store_variant_key(HTTPHdr *request, HTTPHdr *response)
+{
+  uint64_t key = calculate_variant_key(request, response);
+
+  if (key == 0) {
+    request->field_delete(VARIANT_KEY_FIELD, VARIANT_KEY_FIELD_LEN);
+  } else {
+    char buffer[17];
+    int len = snprintf(buffer, sizeof(buffer), "%016" PRIx64, key);
+    request->value_set(VARIANT_KEY_FIELD, VARIANT_KEY_FIELD_LEN, buffer, len);
+  }
+}
+
+/**
+  The variant key stored in a cached @a request, 0 if there is none.
+
+*/
+static uint64_t
+stored_variant_key(HTTPHdr *request)
+{
+  int len;
+  const char *value = request->value_get(VARIANT_KEY_FIELD, VARIANT_KEY_FIELD_LEN, &len);
+  uint64_t key      = 0;
+
+  if (value == nullptr || len != 16) {
+    return 0;
+  }
+  for (int i = 0; i < len; ++i) {
+    if (!ParseRules::is_hex(value[i])) {
+      return 0;
+    }
+    key = (key << 4) | (ParseRules::is_digit(value[i]) ? value[i] - '0' : ParseRules::ink_tolower(value[i]) - 'a' + 10);
+  }
+  return key;
+}
+
+/**
+  Select the alternate cached for the same variant as @a client_request.
+
+  This is the common case of a selection, it only compares the variant key
+  of the client request with those of the alternates. When several have
+  the same key the latest is taken, and its match is checked once with
+  calculate_quality_of_match(), which also protects against the collisions
+  of the keys.
+
+  @return index in cache alternates vector, -1 if no alternate has the key.
+
+*/
+int
+HttpTransactCache::SelectByVariantKey(CacheHTTPInfoVector *cache_vector, HTTPHdr *client_request,
+                                      OverridableHttpConfigParams *http_config_params)
+{
+  int alt_count       = cache_vector->count();
+  int best_index      = -1;
+  time_t best_time    = 0;
+  uint64_t client_key = 0;
+  // The Vary the client key was computed for, the alternates usually share it.
+  const char *vary = nullptr;
+  int vary_len     = -1;
+
+  for (int i = 0; i < alt_count; i++) {
+    CacheHTTPInfo *obj = cache_vector->get(i);
+
+    if (obj->object_key_get() == zero_key) {
+      continue;
+    }
+
+    uint64_t key = stored_variant_key(obj->request_get());
+    if (key == 0) {
+      continue;
+    }
+
+    HTTPHdr *cached_response = obj->response_get();
+    int len                  = 0;
+    const char *value        = cached_response->value_get(MIME_FIELD_VARY, MIME_LEN_VARY, &len);
+    if (vary_len < 0 || len != vary_len || (len > 0 && memcmp(value, vary, len) != 0)) {
+      client_key = calculate_variant_key(client_request, cached_response);
+      vary       = value;
+      vary_len   = len;
+    }
+
+    if (key == client_key && (best_index < 0 || obj->response_received_time_get() >= best_time)) {
+      best_index = i;
+      best_time  = obj->response_received_time_get();
+    }
+  }
+
+  if (best_index >= 0) {
+    CacheHTTPInfo *obj = cache_vector->get(best_index);
+    if (calculate_quality_of_match(http_config_params, client_request, obj->request_get(), obj->response_get()) > 0.0) {
+      Debug("http_match", "[SelectByVariantKey] alternate # %d has the variant key of the request", best_index);
+      return best_index;
+    }
+  }
+  return -1;
+}
+
 /**
   Given a set of alternates, select the best match.
 
@@ -189,6 +377,15 @@ HttpTransactCache::SelectFromAlternates(CacheHTTPInfoVector *cache_vector, HTTPH
     return 0;
   }
 
+  // An alternate of the same variant is the common case, the plugins of the
+  // select alternate hook need every alternate scored though.
+  if (alt_count > 1 && http_global_hooks->get(TS_HTTP_SELECT_ALT_HOOK) == nullptr) {
+    int index = SelectByVariantKey(cache_vector, client_request, http_config_params);
+    if (index >= 0) {
+      return index;
+    }
+  }
+
   for (int i = 0; i < alt_count; i++) {
     float Q;
     CacheHTTPInfo *obj       = cache_vector->get(i);
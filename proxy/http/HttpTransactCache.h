@@ -54,6 +54,12 @@ public:
   static int SelectFromAlternates(CacheHTTPInfoVector *cache_vector_data, HTTPHdr *client_request,
                                   OverridableHttpConfigParams *cache_lookup_http_config_params);
 
+  static int SelectByVariantKey(CacheHTTPInfoVector *cache_vector_data, HTTPHdr *client_request,
+                                OverridableHttpConfigParams *cache_lookup_http_config_params);
+
+  static uint64_t calculate_variant_key(HTTPHdr *request, HTTPHdr *response);
+  static void store_variant_key(HTTPHdr *request, HTTPHdr *response);
+
   static float calculate_quality_of_match(OverridableHttpConfigParams *http_config_params, HTTPHdr *client_request,
                                           HTTPHdr *obj_client_request, HTTPHdr *obj_origin_server_response);
 
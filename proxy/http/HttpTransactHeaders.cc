@@ -393,11 +393,9 @@ HttpTransactHeaders::convert_to_1_1_response_header(HTTPHdr *outgoing_response)
 //   Algorithm is straight out of March 1998 1.1 specs, Section 13.2.3
 //
 ///////////////////////////////////////////////////////////////////////////////
-ink_time_t
-HttpTransactHeaders::calculate_document_age(ink_time_t request_time, ink_time_t response_time, HTTPHdr *base_response,
-                                            ink_time_t base_response_date, ink_time_t now)
+static ink_time_t
+document_age(ink_time_t request_time, ink_time_t response_time, ink_time_t age_value, ink_time_t base_response_date, ink_time_t now)
 {
-  ink_time_t age_value              = base_response->get_age();
   ink_time_t date_value             = 0;
   ink_time_t apparent_age           = 0;
   ink_time_t corrected_received_age = 0;
@@ -450,6 +448,20 @@ HttpTransactHeaders::calculate_document_age(ink_time_t request_time, ink_time_t
   return current_age;
 }
 
+ink_time_t
+HttpTransactHeaders::calculate_document_age(ink_time_t request_time, ink_time_t response_time, HTTPHdr *base_response,
+                                            ink_time_t base_response_date, ink_time_t now)
+{
+  return document_age(request_time, response_time, base_response->get_age(), base_response_date, now);
+}
+
+ink_time_t
+HttpTransactHeaders::calculate_document_age(ink_time_t request_time, ink_time_t response_time, const HTTPCachePolicy &policy,
+                                            ink_time_t now)
+{
+  return document_age(request_time, response_time, policy.age, policy.date, now);
+}
+
 bool
 HttpTransactHeaders::does_server_allow_response_to_be_stored(HTTPHdr *resp)
 {
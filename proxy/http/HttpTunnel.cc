@@ -130,42 +130,52 @@ ChunkedHandler::read_size()
     bytes_used = 0;
 
     while (data_size > 0) {
-      bytes_used++;
-      if (state == CHUNK_READ_SIZE) {
-        // The http spec says the chunked size is always in hex
-        if (ParseRules::is_hex(*tmp)) {
-          num_digits++;
-          running_sum *= 16;
-
-          if (ParseRules::is_digit(*tmp)) {
-            running_sum += *tmp - '0';
-          } else {
-            running_sum += ParseRules::ink_tolower(*tmp) - 'a' + 10;
-          }
-        } else {
-          // We are done parsing size
-          if (num_digits == 0 || running_sum < 0) {
-            // Bogus chunk size
-            state = CHUNK_READ_ERROR;
-            done  = true;
-            break;
-          } else {
-            state = CHUNK_READ_SIZE_CRLF; // now look for CRLF
-          }
+      if (state != CHUNK_READ_SIZE) {
+        // Only the linefeed matters here, the chunk extensions and the CRLF after the chunk data
+        // are skipped with memchr rather than a character at a time.
+        const char *lf = static_cast<const char *>(memchr(tmp, '\n', data_size));
+        if (lf == nullptr) {
+          bytes_used += data_size;
+          break;
         }
-      } else if (state == CHUNK_READ_SIZE_CRLF) { // Scan for a linefeed
-        if (ParseRules::is_lf(*tmp)) {
+        int64_t skip = lf - tmp + 1;
+        bytes_used += skip;
+        tmp += skip;
+        data_size -= skip;
+
+        if (state == CHUNK_READ_SIZE_CRLF) {
           Debug("http_chunk", "read chunk size of %d bytes", running_sum);
           bytes_left = (cur_chunk_size = running_sum);
           state      = (running_sum == 0) ? CHUNK_READ_TRAILER_BLANK : CHUNK_READ_CHUNK;
           done       = true;
           break;
         }
-      } else if (state == CHUNK_READ_SIZE_START) {
-        if (ParseRules::is_lf(*tmp)) {
-          running_sum = 0;
-          num_digits  = 0;
-          state       = CHUNK_READ_SIZE;
+        running_sum = 0;
+        num_digits  = 0;
+        state       = CHUNK_READ_SIZE;
+        continue;
+      }
+
+      bytes_used++;
+      // The http spec says the chunked size is always in hex
+      if (ParseRules::is_hex(*tmp)) {
+        num_digits++;
+        running_sum *= 16;
+
+        if (ParseRules::is_digit(*tmp)) {
+          running_sum += *tmp - '0';
+        } else {
+          running_sum += ParseRules::ink_tolower(*tmp) - 'a' + 10;
+        }
+      } else {
+        // We are done parsing size
+        if (num_digits == 0 || running_sum < 0) {
+          // Bogus chunk size
+          state = CHUNK_READ_ERROR;
+          done  = true;
+          break;
+        } else {
+          state = CHUNK_READ_SIZE_CRLF; // now look for CRLF
         }
       }
       tmp++;
@@ -251,6 +261,17 @@ ChunkedHandler::read_trailer()
 
     ink_assert(data_size > 0);
     for (bytes_used = 0; data_size > 0; data_size--) {
+      if (state == CHUNK_READ_TRAILER_LINE) {
+        // The rest of a trailer line does not matter, skip to its linefeed.
+        const char *lf = static_cast<const char *>(memchr(tmp, '\n', data_size));
+        if (lf == nullptr) {
+          bytes_used += data_size;
+          break;
+        }
+        bytes_used += lf - tmp;
+        data_size -= lf - tmp;
+        tmp = lf;
+      }
       bytes_used++;
 
       if (ParseRules::is_cr(*tmp)) {
@@ -892,12 +913,12 @@ HttpTunnel::producer_run(HttpTunnelProducer *p)
   if ((p->vc_type == HT_BUFFER_READ && sm->is_postbuf_valid()) ||
       (p->alive && sm->t_state.method == HTTP_WKSIDX_POST && sm->enable_redirection && p->vc_type == HT_HTTP_CLIENT)) {
     Debug("http_redirect", "[HttpTunnel::producer_run] client post: %" PRId64 " max size: %" PRId64 "",
-          p->buffer_start->read_avail(), HttpConfig::m_master.post_copy_size);
+          p->buffer_start->read_avail(), sm->postbuf_max_size());
 
     // (note that since we are not dechunking POST, this is the chunked size if chunked)
-    if (p->buffer_start->read_avail() > HttpConfig::m_master.post_copy_size) {
+    if (p->buffer_start->read_avail() > sm->postbuf_max_size()) {
       Warning("http_redirect, [HttpTunnel::producer_handler] post exceeds buffer limit, buffer_avail=%" PRId64 " limit=%" PRId64 "",
-              p->buffer_start->read_avail(), HttpConfig::m_master.post_copy_size);
+              p->buffer_start->read_avail(), sm->postbuf_max_size());
       sm->disable_redirect();
       if (p->vc_type == HT_BUFFER_READ) {
         producer_handler(VC_EVENT_ERROR, p);
@@ -1108,10 +1129,10 @@ HttpTunnel::producer_handler(int event, HttpTunnelProducer *p)
        (event == VC_EVENT_READ_READY || event == VC_EVENT_READ_COMPLETE) && p->vc_type == HT_HTTP_CLIENT)) {
     Debug("http_redirect", "[HttpTunnel::producer_handler] [%s %s]", p->name, HttpDebugNames::get_event_name(event));
 
-    if ((sm->postbuf_buffer_avail() + sm->postbuf_reader_avail()) > HttpConfig::m_master.post_copy_size) {
+    if ((sm->postbuf_buffer_avail() + sm->postbuf_reader_avail()) > sm->postbuf_max_size()) {
       Warning("http_redirect, [HttpTunnel::producer_handler] post exceeds buffer limit, buffer_avail=%" PRId64
               " reader_avail=%" PRId64 " limit=%" PRId64 "",
-              sm->postbuf_buffer_avail(), sm->postbuf_reader_avail(), HttpConfig::m_master.post_copy_size);
+              sm->postbuf_buffer_avail(), sm->postbuf_reader_avail(), sm->postbuf_max_size());
       sm->disable_redirect();
       if (p->vc_type == HT_BUFFER_READ) {
         event = VC_EVENT_ERROR;
@@ -49,10 +49,25 @@ RemapPluginInst::init(int argc, char **argv, std::string &error)
 {
   bool result = false;
   result      = _plugin.initInstance(argc, argv, &_instance, error);
+  _args.assign(argv, argv + argc);
 
   return result;
 }
 
+bool
+RemapPluginInst::sameArgs(int argc, char **argv) const
+{
+  if (static_cast<size_t>(argc) != _args.size()) {
+    return false;
+  }
+  for (int i = 0; i < argc; ++i) {
+    if (_args[i] != argv[i]) {
+      return false;
+    }
+  }
+  return true;
+}
+
 void
 RemapPluginInst::done()
 {
@@ -88,8 +103,16 @@ PluginFactory::PluginFactory()
 
 PluginFactory::~PluginFactory()
 {
-  _instList.apply([](RemapPluginInst *pluginInst) -> void { delete pluginInst; });
+  finishCarryOver(false);
+
+  auto release = [](RemapPluginInst *pluginInst) -> void {
+    if (0 == pluginInst->_owners.refcount_dec()) {
+      delete pluginInst;
+    }
+  };
+  _instList.apply(release);
   _instList.clear();
+  std::for_each(_sharedInst.begin(), _sharedInst.end(), release);
 
   fs::remove(_runtimeDir, _ec);
 
@@ -165,6 +188,7 @@ PluginFactory::getRemapPlugin(const fs::path &configPath, int argc, char **argv,
         if (plugin->init(error)) {
           inst = new RemapPluginInst(*plugin);
           inst->init(argc, argv, error);
+          inst->_owners.refcount_inc();
           _instList.append(inst);
         }
 
@@ -177,11 +201,86 @@ PluginFactory::getRemapPlugin(const fs::path &configPath, int argc, char **argv,
     }
   } else {
     Debug(_tag, "plugin '%s' has already been loaded", configPath.c_str());
-    inst = new RemapPluginInst(*plugin);
-    inst->init(argc, argv, error);
-    _instList.append(inst);
+    inst = findCarryOver(plugin, argc, argv);
+    if (nullptr == inst) {
+      inst = new RemapPluginInst(*plugin);
+      inst->init(argc, argv, error);
+      inst->_owners.refcount_inc();
+      _instList.append(inst);
+    }
+  }
+
+  return inst;
+}
+
+/**
+ * @brief Reuse the plugin instances of the config being replaced.
+ *
+ * While the config is loaded, a plugin instance of @a previous for the same plugin DSO and the same parameters is used
+ * instead of initializing a new one. The instances are handed over by finishCarryOver().
+ *
+ * @param previous the factory of the config being replaced, nullptr to initialize all instances.
+ */
+void
+PluginFactory::carryOverFrom(PluginFactory *previous)
+{
+  ink_assert(_carriedInst.empty());
+  _previous = previous;
+}
+
+/**
+ * @brief Finish loading a config with instances carried over from the previous factory.
+ *
+ * @param commit true if the config loaded and will be used, the carried instances are moved from the previous factory
+ * which will not call their 'done' method on reload, false if the config is discarded and the instances stay.
+ */
+void
+PluginFactory::finishCarryOver(bool commit)
+{
+  if (nullptr == _previous) {
+    return;
+  }
+
+  for (RemapPluginInst *inst : _carriedInst) {
+    inst->_carried = false;
+    if (commit) {
+      /* The previous config keeps using the instance until it is destroyed */
+      _previous->_instList.erase(inst);
+      _previous->_sharedInst.push_back(inst);
+      inst->_owners.refcount_inc();
+      _instList.append(inst);
+    }
+  }
+  Debug(_tag, "%s %zu plugin instances of factory '%s'", commit ? "carried over" : "returned", _carriedInst.size(),
+        _previous->getUuid());
+  _carriedInst.clear();
+  _previous = nullptr;
+}
+
+/**
+ * @brief Find an instance of the previous factory to reuse.
+ *
+ * @param plugin the plugin DSO, the same DSO object only if neither the path nor the modification time changed.
+ * @return an instance of @a plugin initialized with the same parameters, nullptr if there is none.
+ */
+RemapPluginInst *
+PluginFactory::findCarryOver(RemapPluginInfo *plugin, int argc, char **argv)
+{
+  if (nullptr == _previous) {
+    return nullptr;
+  }
+
+  auto spot = std::find_if(_previous->_instList.begin(), _previous->_instList.end(), [&](RemapPluginInst const &inst) -> bool {
+    return &inst._plugin == plugin && !inst._carried && inst.sameArgs(argc, argv);
+  });
+  if (spot == _previous->_instList.end()) {
+    return nullptr;
   }
 
+  RemapPluginInst *inst = &*spot;
+  inst->_carried        = true;
+  _carriedInst.push_back(inst);
+  Debug(_tag, "reusing instance of plugin '%s'", plugin->effectivePath().c_str());
   return inst;
 }
 
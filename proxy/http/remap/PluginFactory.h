@@ -23,6 +23,7 @@
 
 #pragma once
 
+#include <string>
 #include <vector>
 
 #include "tscore/Ptr.h"
@@ -49,6 +50,7 @@ public:
   /* Used by the PluginFactory */
   bool init(int argc, char **argv, std::string &error);
   void done();
+  bool sameArgs(int argc, char **argv) const;
 
   /* Used by the traffic server core while processing requests */
   TSRemapStatus doRemap(TSHttpTxn rh, TSRemapRequestInfo *rri);
@@ -63,6 +65,13 @@ public:
   /* Plugin instance = the plugin info + the data returned by the init callback */
   RemapPluginInfo &_plugin;
   void *_instance = nullptr;
+
+  /* The parameters the instance was initialized with, to find it again on a config reload */
+  std::vector<std::string> _args;
+  /* Factories holding the instance, the last one deletes it */
+  RefCountObj _owners;
+  /* Taken by a factory that is still loading its config */
+  bool _carried = false;
 };
 
 /**
@@ -97,6 +106,9 @@ public:
 
   RemapPluginInst *getRemapPlugin(const fs::path &configPath, int argc, char **argv, std::string &error);
 
+  void carryOverFrom(PluginFactory *previous);
+  void finishCarryOver(bool commit);
+
   virtual const char *getUuid();
   void clean(std::string &error);
 
@@ -105,11 +117,15 @@ public:
 protected:
   PluginDso *findByEffectivePath(const fs::path &path);
   fs::path getEffectivePath(const fs::path &configPath);
+  RemapPluginInst *findCarryOver(RemapPluginInfo *plugin, int argc, char **argv);
 
   std::vector<fs::path> _searchDirs; /** @brief ordered list of search paths where we look for plugins */
   fs::path _runtimeDir;              /** @brief the path where we would create a temporary copies of the plugins to load */
 
   PluginInstList _instList;
+  PluginFactory *_previous = nullptr;          /** @brief factory of the config being replaced, to carry instances over from */
+  std::vector<RemapPluginInst *> _carriedInst; /** @brief instances taken from @a _previous, not yet handed over */
+  std::vector<RemapPluginInst *> _sharedInst;  /** @brief instances handed over to a newer factory, still used by our config */
 
   ATSUuid *_uuid = nullptr;
   std::error_code _ec;
@@ -22,6 +22,8 @@
 
  */
 
+#include <algorithm>
+
 #include "UrlRewrite.h"
 #include "ProxyConfig.h"
 #include "ReverseProxy.h"
@@ -702,9 +704,43 @@ UrlRewrite::BuildTable(const char *path)
     forward_mappings_with_recv_port.hash_lookup.reset(nullptr);
   }
 
+  _indexRegexMappings(forward_mappings);
+  _indexRegexMappings(reverse_mappings);
+  _indexRegexMappings(permanent_redirects);
+  _indexRegexMappings(temporary_redirects);
+  _indexRegexMappings(forward_mappings_with_recv_port);
+
   return 0;
 }
 
+/**
+  Indexes the regex mappings of @a store by the literal each regex
+  requires of a host, so a lookup does not run every regex.
+
+*/
+void
+UrlRewrite::_indexRegexMappings(MappingsStore &store)
+{
+  forl_LL(RegexMapping, list_iter, store.regex_list)
+  {
+    int host_len;
+    const char *host    = list_iter->url_map->fromURL.host_get(&host_len);
+    std::string literal = Regex::required_literal(std::string_view(host, host_len));
+
+    if (literal.empty()) {
+      store.regex_unindexed.push_back(list_iter);
+      continue;
+    }
+    unsigned id = store.regex_literals.add(literal);
+    if (id == store.regex_by_literal.size()) {
+      store.regex_by_literal.emplace_back();
+    }
+    store.regex_by_literal[id].push_back(list_iter);
+    Debug("url_rewrite_regex", "Indexed regex [%.*s] by literal [%s]", host_len, host, literal.c_str());
+  }
+  store.regex_literals.compile();
+}
+
 /**
   Inserts arg mapping in h_table with key src_host chaining the mapping
   of existing entries bound to src_host if necessary.
@@ -775,7 +811,7 @@ UrlRewrite::_mappingLookup(MappingsStore &mappings, URL *request_url, int reques
     mapping_container.set(mapping);
     retval = true;
   }
-  if (_regexMappingLookup(mappings.regex_list, request_url, request_port, request_host_lower, request_host_len, rank_ceiling,
+  if (_regexMappingLookup(mappings, request_url, request_port, request_host_lower, request_host_len, rank_ceiling,
                           mapping_container)) {
     Debug("url_rewrite", "Using regex mapping with rank %d", (mapping_container.getMapping())->getRank());
     retval = true;
@@ -832,11 +868,15 @@ lOverFlow:
 }
 
 bool
-UrlRewrite::_regexMappingLookup(RegexMappingList &regex_mappings, URL *request_url, int request_port, const char *request_host,
+UrlRewrite::_regexMappingLookup(MappingsStore &mappings, URL *request_url, int request_port, const char *request_host,
                                 int request_host_len, int rank_ceiling, UrlMappingContainer &mapping_container)
 {
   bool retval = false;
 
+  if (mappings.regex_list.empty()) {
+    return false;
+  }
+
   if (rank_ceiling == -1) { // we will now look at all regex mappings
     rank_ceiling = INT_MAX;
     Debug("url_rewrite_regex", "Going to match all regexes");
@@ -857,9 +897,18 @@ UrlRewrite::_regexMappingLookup(RegexMappingList &regex_mappings, URL *request_u
     request_scheme_len = hdrtoken_wks_to_length(request_scheme);
   }
 
-  // Loop over the entire linked list, or until we're satisfied
-  forl_LL(RegexMapping, list_iter, regex_mappings)
-  {
+  // Only the regexes with no literal, or whose literal is in the host, can match.
+  std::vector<RegexMapping *> candidates(mappings.regex_unindexed);
+  mappings.regex_literals.match(std::string_view(request_host, request_host_len), [&](int id) {
+    candidates.insert(candidates.end(), mappings.regex_by_literal[id].begin(), mappings.regex_by_literal[id].end());
+  });
+  std::sort(candidates.begin(), candidates.end(),
+            [](RegexMapping *lhs, RegexMapping *rhs) { return lhs->url_map->getRank() < rhs->url_map->getRank(); });
+  candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+  Debug("url_rewrite_regex", "Matching %zu candidate regexes", candidates.size());
+
+  // Loop over the candidates in rank order, or until we're satisfied
+  for (RegexMapping *list_iter : candidates) {
     int reg_map_rank = list_iter->url_map->getRank();
 
     if (reg_map_rank > rank_ceiling) {
@@ -29,9 +29,11 @@
 #include "UrlMappingPathIndex.h"
 #include "HttpTransact.h"
 #include "tscore/Regex.h"
+#include "tscore/LiteralMatcher.h"
 #include "PluginFactory.h"
 
 #include <memory>
+#include <vector>
 
 #define URL_REMAP_FILTER_NONE 0x00000000
 #define URL_REMAP_FILTER_REFERER 0x00000001      /* enable "referer" header validation */
@@ -136,6 +138,13 @@ public:
   struct MappingsStore {
     std::unique_ptr<URLTable> hash_lookup;
     RegexMappingList regex_list;
+
+    // The regex mappings by a literal every host they match contains, so a lookup only runs the
+    // regexes whose literal is in the request host, and those with no literal.
+    LiteralMatcher regex_literals;
+    std::vector<std::vector<RegexMapping *>> regex_by_literal;
+    std::vector<RegexMapping *> regex_unindexed;
+
     bool
     empty()
     {
@@ -152,6 +161,9 @@ public:
   {
     _destroyTable(store.hash_lookup);
     _destroyList(store.regex_list);
+    store.regex_literals.clear();
+    store.regex_by_literal.clear();
+    store.regex_unindexed.clear();
   }
 
   bool InsertForwardMapping(mapping_type maptype, url_mapping *mapping, const char *src_host);
@@ -219,12 +231,13 @@ private:
                       UrlMappingContainer &mapping_container);
   url_mapping *_tableLookup(std::unique_ptr<URLTable> &h_table, URL *request_url, int request_port, char *request_host,
                             int request_host_len);
-  bool _regexMappingLookup(RegexMappingList &regex_mappings, URL *request_url, int request_port, const char *request_host,
+  bool _regexMappingLookup(MappingsStore &mappings, URL *request_url, int request_port, const char *request_host,
                            int request_host_len, int rank_ceiling, UrlMappingContainer &mapping_container);
   int _expandSubstitutions(int *matches_info, const RegexMapping *reg_map, const char *matched_string, char *dest_buf,
                            int dest_buf_size);
   void _destroyTable(std::unique_ptr<URLTable> &h_table);
   void _destroyList(RegexMappingList &regexes);
+  void _indexRegexMappings(MappingsStore &store);
   inline bool _addToStore(MappingsStore &store, url_mapping *new_mapping, RegexMapping *reg_map, const char *src_host,
                           bool is_cur_mapping_regex, int &count);
 };
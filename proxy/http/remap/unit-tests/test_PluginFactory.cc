@@ -655,3 +655,86 @@ SCENARIO("notifying plugins of config reload", "[plugin][core]")
     }
   }
 }
+
+SCENARIO("carrying plugin instances over a config reload", "[plugin][core]")
+{
+  fs::path configName = fs::path("plugin_testing_calls.so");
+  fs::path buildPath  = pluginBuildDir / configName;
+
+  static fs::path uuid_t1 = fs::path("c71e2bab-90dc-4770-9535-c9304c3de381"); /* UUID at moment t1 */
+  static fs::path uuid_t2 = fs::path("c71e2bab-90dc-4770-9535-e7304c3ee732"); /* UUID at moment t2 */
+
+  fs::path effectivePath;
+  fs::path runtimePath;
+
+  std::string error;
+
+  char from[]   = "http://example.com";
+  char argA[]   = "http://a.example.com";
+  char argB[]   = "http://b.example.com";
+  char argC[]   = "http://c.example.com";
+  char *argvA[] = {from, argA};
+  char *argvB[] = {from, argB};
+  char *argvC[] = {from, argC};
+
+  GIVEN("a config with 2 instances of a plugin reloaded with one of them unchanged")
+  {
+    setupConfigPathTest(configName, buildPath, uuid_t1, effectivePath, runtimePath, 1556825556);
+    PluginFactoryUnitTest *factory1 = getFactory(uuid_t1);
+    RemapPluginInst *instA          = factory1->getRemapPlugin(configName, 2, argvA, error);
+    RemapPluginInst *instB          = factory1->getRemapPlugin(configName, 2, argvB, error);
+    validateSuccessfulConfigPathTest(instA, error, effectivePath, runtimePath);
+    validateSuccessfulConfigPathTest(instB, error, effectivePath, runtimePath);
+
+    PluginDebugObject *debugObject = getDebugObject(instA->_plugin);
+    debugObject->clear();
+
+    PluginFactoryUnitTest *factory2 = getFactory(uuid_t2);
+    factory2->carryOverFrom(factory1);
+    RemapPluginInst *newA = factory2->getRemapPlugin(configName, 2, argvA, error);
+    RemapPluginInst *newC = factory2->getRemapPlugin(configName, 2, argvC, error);
+
+    /* The unchanged instance is reused and only the new one is initialized */
+    CHECK(newA == instA);
+    CHECK(newC != instB);
+    CHECK(1 == debugObject->initInstanceCalled);
+
+    WHEN("the new config is used")
+    {
+      factory2->finishCarryOver(true);
+      debugObject->clear();
+      factory1->indicateReload();
+
+      THEN("expect only the instance which was not carried over to be deleted")
+      {
+        CHECK(1 == debugObject->deleteInstanceCalled);
+      }
+
+      delete factory1;
+      debugObject->clear();
+      factory2->indicateReload();
+
+      THEN("expect the new config to delete the carried over instance on its reload")
+      {
+        CHECK(2 == debugObject->deleteInstanceCalled);
+      }
+      delete factory2;
+    }
+
+    WHEN("the new config is discarded")
+    {
+      factory2->finishCarryOver(false);
+      delete factory2;
+      debugObject->clear();
+      factory1->indicateReload();
+
+      THEN("expect the previous config to still delete both of its instances")
+      {
+        CHECK(2 == debugObject->deleteInstanceCalled);
+      }
+      delete factory1;
+    }
+
+    clean();
+  }
+}
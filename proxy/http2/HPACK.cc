@@ -96,75 +96,123 @@ typedef enum {
 } TS_HPACK_STATIC_TABLE_ENTRY;
 
 struct StaticTable {
-  StaticTable(const char *n, const char *v) : name(n), value(v), name_size(strlen(name)), value_size(strlen(value)) {}
+  constexpr StaticTable(const char *n, const char *v)
+    : name(n), value(v), name_size(std::char_traits<char>::length(n)), value_size(std::char_traits<char>::length(v))
+  {
+  }
   const char *name;
   const char *value;
   const int name_size;
   const int value_size;
 };
 
-static const StaticTable STATIC_TABLE[] = {{"", ""},
-                                           {":authority", ""},
-                                           {":method", "GET"},
-                                           {":method", "POST"},
-                                           {":path", "/"},
-                                           {":path", "/index.html"},
-                                           {":scheme", "http"},
-                                           {":scheme", "https"},
-                                           {":status", "200"},
-                                           {":status", "204"},
-                                           {":status", "206"},
-                                           {":status", "304"},
-                                           {":status", "400"},
-                                           {":status", "404"},
-                                           {":status", "500"},
-                                           {"accept-charset", ""},
-                                           {"accept-encoding", "gzip, deflate"},
-                                           {"accept-language", ""},
-                                           {"accept-ranges", ""},
-                                           {"accept", ""},
-                                           {"access-control-allow-origin", ""},
-                                           {"age", ""},
-                                           {"allow", ""},
-                                           {"authorization", ""},
-                                           {"cache-control", ""},
-                                           {"content-disposition", ""},
-                                           {"content-encoding", ""},
-                                           {"content-language", ""},
-                                           {"content-length", ""},
-                                           {"content-location", ""},
-                                           {"content-range", ""},
-                                           {"content-type", ""},
-                                           {"cookie", ""},
-                                           {"date", ""},
-                                           {"etag", ""},
-                                           {"expect", ""},
-                                           {"expires", ""},
-                                           {"from", ""},
-                                           {"host", ""},
-                                           {"if-match", ""},
-                                           {"if-modified-since", ""},
-                                           {"if-none-match", ""},
-                                           {"if-range", ""},
-                                           {"if-unmodified-since", ""},
-                                           {"last-modified", ""},
-                                           {"link", ""},
-                                           {"location", ""},
-                                           {"max-forwards", ""},
-                                           {"proxy-authenticate", ""},
-                                           {"proxy-authorization", ""},
-                                           {"range", ""},
-                                           {"referer", ""},
-                                           {"refresh", ""},
-                                           {"retry-after", ""},
-                                           {"server", ""},
-                                           {"set-cookie", ""},
-                                           {"strict-transport-security", ""},
-                                           {"transfer-encoding", ""},
-                                           {"user-agent", ""},
-                                           {"vary", ""},
-                                           {"via", ""},
-                                           {"www-authenticate", ""}};
+static constexpr StaticTable STATIC_TABLE[] = {{"", ""},
+                                               {":authority", ""},
+                                               {":method", "GET"},
+                                               {":method", "POST"},
+                                               {":path", "/"},
+                                               {":path", "/index.html"},
+                                               {":scheme", "http"},
+                                               {":scheme", "https"},
+                                               {":status", "200"},
+                                               {":status", "204"},
+                                               {":status", "206"},
+                                               {":status", "304"},
+                                               {":status", "400"},
+                                               {":status", "404"},
+                                               {":status", "500"},
+                                               {"accept-charset", ""},
+                                               {"accept-encoding", "gzip, deflate"},
+                                               {"accept-language", ""},
+                                               {"accept-ranges", ""},
+                                               {"accept", ""},
+                                               {"access-control-allow-origin", ""},
+                                               {"age", ""},
+                                               {"allow", ""},
+                                               {"authorization", ""},
+                                               {"cache-control", ""},
+                                               {"content-disposition", ""},
+                                               {"content-encoding", ""},
+                                               {"content-language", ""},
+                                               {"content-length", ""},
+                                               {"content-location", ""},
+                                               {"content-range", ""},
+                                               {"content-type", ""},
+                                               {"cookie", ""},
+                                               {"date", ""},
+                                               {"etag", ""},
+                                               {"expect", ""},
+                                               {"expires", ""},
+                                               {"from", ""},
+                                               {"host", ""},
+                                               {"if-match", ""},
+                                               {"if-modified-since", ""},
+                                               {"if-none-match", ""},
+                                               {"if-range", ""},
+                                               {"if-unmodified-since", ""},
+                                               {"last-modified", ""},
+                                               {"link", ""},
+                                               {"location", ""},
+                                               {"max-forwards", ""},
+                                               {"proxy-authenticate", ""},
+                                               {"proxy-authorization", ""},
+                                               {"range", ""},
+                                               {"referer", ""},
+                                               {"refresh", ""},
+                                               {"retry-after", ""},
+                                               {"server", ""},
+                                               {"set-cookie", ""},
+                                               {"strict-transport-security", ""},
+                                               {"transfer-encoding", ""},
+                                               {"user-agent", ""},
+                                               {"vary", ""},
+                                               {"via", ""},
+                                               {"www-authenticate", ""}};
+
+// Case insensitive FNV-1a of a header name, for finding it in the tables.
+static constexpr uint32_t
+hpack_name_hash(const char *name, int name_len)
+{
+  uint32_t hash = 2166136261;
+  for (int i = 0; i < name_len; ++i) {
+    hash = (hash ^ static_cast<uint8_t>(name[i] | 0x20)) * 16777619;
+  }
+  return hash;
+}
+
+// Open addressed hash of the static table names to the first index with the name, entries with
+// the same name are next to each other. 0 is an empty slot.
+struct StaticTableIndex {
+  static constexpr uint32_t SIZE = 128;
+  uint8_t slot[SIZE];
+};
+
+static constexpr StaticTableIndex
+hpack_static_table_index_build()
+{
+  StaticTableIndex index = {};
+
+  for (int i = 1; i < TS_HPACK_STATIC_TABLE_ENTRY_NUM; ++i) {
+    const StaticTable &prev = STATIC_TABLE[i - 1];
+    const StaticTable &cur  = STATIC_TABLE[i];
+    bool same_name          = prev.name_size == cur.name_size;
+    for (int j = 0; same_name && j < cur.name_size; ++j) {
+      same_name = prev.name[j] == cur.name[j];
+    }
+    if (same_name) {
+      continue;
+    }
+    uint32_t slot = hpack_name_hash(cur.name, cur.name_size) % StaticTableIndex::SIZE;
+    while (index.slot[slot]) {
+      slot = (slot + 1) % StaticTableIndex::SIZE;
+    }
+    index.slot[slot] = i;
+  }
+
+  return index;
+}
+
+static constexpr StaticTableIndex STATIC_TABLE_INDEX = hpack_static_table_index_build();
 
 /******************
  * Local functions
@@ -215,48 +263,39 @@ HpackIndexingTable::lookup(const MIMEFieldWrapper &field) const
   return lookup(target_name, target_name_len, target_value, target_value_len);
 }
 
+//
+// An exact match has the lowest index of all with the same name and value, otherwise the name match
+// has the lowest index of all with the name, so static table entries are used first.
+//
 HpackLookupResult
 HpackIndexingTable::lookup(const char *name, int name_len, const char *value, int value_len) const
 {
   HpackLookupResult result;
-  const unsigned int entry_num = TS_HPACK_STATIC_TABLE_ENTRY_NUM + _dynamic_table->length();
-
-  for (unsigned int index = 1; index < entry_num; ++index) {
-    const char *table_name, *table_value;
-    int table_name_len = 0, table_value_len = 0;
-
-    if (index < TS_HPACK_STATIC_TABLE_ENTRY_NUM) {
-      // static table
-      table_name      = STATIC_TABLE[index].name;
-      table_value     = STATIC_TABLE[index].value;
-      table_name_len  = STATIC_TABLE[index].name_size;
-      table_value_len = STATIC_TABLE[index].value_size;
-    } else {
-      // dynamic table
-      const MIMEField *m_field = _dynamic_table->get_header_field(index - TS_HPACK_STATIC_TABLE_ENTRY_NUM);
+  uint32_t name_hash = hpack_name_hash(name, name_len);
+  uint32_t slot      = name_hash % StaticTableIndex::SIZE;
 
-      table_name  = m_field->name_get(&table_name_len);
-      table_value = m_field->value_get(&table_value_len);
-    }
-
-    // Check whether name (and value) are matched
-    if (ptr_len_casecmp(name, name_len, table_name, table_name_len) == 0) {
-      if ((value_len == table_value_len) && (memcmp(value, table_value, value_len) == 0)) {
-        result.index      = index;
-        result.match_type = HpackMatch::EXACT;
-        break;
-      } else if (!result.index) {
-        result.index      = index;
-        result.match_type = HpackMatch::NAME;
+  for (; STATIC_TABLE_INDEX.slot[slot]; slot = (slot + 1) % StaticTableIndex::SIZE) {
+    int index = STATIC_TABLE_INDEX.slot[slot];
+    if (ptr_len_casecmp(name, name_len, STATIC_TABLE[index].name, STATIC_TABLE[index].name_size) == 0) {
+      result.index      = index;
+      result.index_type = HpackIndex::STATIC;
+      result.match_type = HpackMatch::NAME;
+      for (; index < TS_HPACK_STATIC_TABLE_ENTRY_NUM && STATIC_TABLE[index].name_size == name_len &&
+             memcmp(STATIC_TABLE[index].name, STATIC_TABLE[result.index].name, name_len) == 0;
+           ++index) {
+        if (value_len == STATIC_TABLE[index].value_size && memcmp(value, STATIC_TABLE[index].value, value_len) == 0) {
+          result.index      = index;
+          result.match_type = HpackMatch::EXACT;
+          return result;
+        }
       }
+      break;
     }
   }
-  if (result.match_type != HpackMatch::NONE) {
-    if (result.index < TS_HPACK_STATIC_TABLE_ENTRY_NUM) {
-      result.index_type = HpackIndex::STATIC;
-    } else {
-      result.index_type = HpackIndex::DYNAMIC;
-    }
+
+  HpackLookupResult dynamic_result = _dynamic_table->lookup(name, name_len, name_hash, value, value_len);
+  if (dynamic_result.match_type == HpackMatch::EXACT || result.match_type == HpackMatch::NONE) {
+    return dynamic_result;
   }
 
   return result;
@@ -324,6 +363,39 @@ HpackDynamicTable::get_header_field(uint32_t index) const
   return this->_headers.at(this->_headers.size() - index - 1);
 }
 
+HpackLookupResult
+HpackDynamicTable::lookup(const char *name, int name_len, uint32_t name_hash, const char *value, int value_len) const
+{
+  HpackLookupResult result;
+
+  // The newest entry has the lowest index.
+  for (size_t i = this->_headers.size(); i-- > 0;) {
+    if (this->_name_hashes[i] != name_hash) {
+      continue;
+    }
+
+    int table_name_len, table_value_len;
+    const char *table_name  = this->_headers[i]->name_get(&table_name_len);
+    const char *table_value = this->_headers[i]->value_get(&table_value_len);
+
+    if (ptr_len_casecmp(name, name_len, table_name, table_name_len) == 0) {
+      uint32_t index = TS_HPACK_STATIC_TABLE_ENTRY_NUM + (this->_headers.size() - i - 1);
+      if ((value_len == table_value_len) && (memcmp(value, table_value, value_len) == 0)) {
+        result.index      = index;
+        result.index_type = HpackIndex::DYNAMIC;
+        result.match_type = HpackMatch::EXACT;
+        break;
+      } else if (!result.index) {
+        result.index      = index;
+        result.index_type = HpackIndex::DYNAMIC;
+        result.match_type = HpackMatch::NAME;
+      }
+    }
+  }
+
+  return result;
+}
+
 void
 HpackDynamicTable::add_header_field(const MIMEField *field)
 {
@@ -338,6 +410,7 @@ HpackDynamicTable::add_header_field(const MIMEField *field)
     // the maximum size; an attempt to add an entry larger than the entire
     // table causes the table to be emptied of all existing entries.
     this->_headers.clear();
+    this->_name_hashes.clear();
     this->_mhdr->fields_clear();
     this->_current_size = 0;
   } else {
@@ -349,6 +422,7 @@ HpackDynamicTable::add_header_field(const MIMEField *field)
     this->_mhdr->field_attach(new_field);
     // XXX Because entire Vec instance is copied, Its too expensive!
     this->_headers.push_back(new_field);
+    this->_name_hashes.push_back(hpack_name_hash(name, name_len));
   }
 }
 
@@ -408,6 +482,7 @@ HpackDynamicTable::_evict_overflowed_entries()
   }
 
   this->_headers.erase(this->_headers.begin(), this->_headers.begin() + count);
+  this->_name_hashes.erase(this->_name_hashes.begin(), this->_name_hashes.begin() + count);
 
   if (this->_headers.size() == 0) {
     return false;
@@ -595,14 +670,62 @@ decode_indexed_header_field(MIMEFieldWrapper &header, const uint8_t *buf_start,
     int decoded_value_len;
     const char *decoded_value = header.value_get(&decoded_value_len);
 
-    Arena arena;
-    Debug("hpack_decode", "Decoded field: %s: %s", arena.str_store(decoded_name, decoded_name_len),
-          arena.str_store(decoded_value, decoded_value_len));
+    Debug("hpack_decode", "Decoded field: %.*s: %.*s", decoded_name_len, decoded_name, decoded_value_len, decoded_value);
   }
 
   return len;
 }
 
+//
+// [RFC 7541] 5.2. String Literal Representation
+// Same as xpack_decode_string but the string is decoded into the string storage of the header heap,
+// so a field can use it without another copy.
+//
+static int64_t
+decode_string_to_heap(HdrHeap *heap, char **str, uint64_t &str_length, const uint8_t *buf_start, const uint8_t *buf_end)
+{
+  if (buf_start >= buf_end) {
+    return HPACK_ERROR_COMPRESSION_ERROR;
+  }
+
+  const uint8_t *p            = buf_start;
+  bool isHuffman              = *p & 0x80;
+  uint64_t encoded_string_len = 0;
+  int64_t len                 = 0;
+
+  len = xpack_decode_integer(encoded_string_len, p, buf_end, 7);
+  if (len == XPACK_ERROR_COMPRESSION_ERROR) {
+    return HPACK_ERROR_COMPRESSION_ERROR;
+  }
+  p += len;
+
+  if ((p + encoded_string_len) > buf_end) {
+    return HPACK_ERROR_COMPRESSION_ERROR;
+  }
+
+  if (isHuffman) {
+    // The shortest code is 5 bits, allocate for the most symbols that fit and give back the rest
+    int max_len = encoded_string_len * 8 / 5;
+    *str        = heap->allocate_str(max_len);
+
+    len = huffman_decode(*str, p, encoded_string_len);
+    if (len < 0) {
+      heap->shrink_str(*str, max_len, 0);
+      return HPACK_ERROR_COMPRESSION_ERROR;
+    }
+    heap->shrink_str(*str, max_len, len);
+    str_length = len;
+  } else {
+    *str = heap->allocate_str(encoded_string_len);
+
+    memcpy(*str, reinterpret_cast<const char *>(p), encoded_string_len);
+
+    str_length = encoded_string_len;
+  }
+
+  return p + encoded_string_len - buf_start;
+}
+
 //
 // [RFC 7541] 6.2. Literal Header Field Representation
 // Decode Literal Header Field Representation based on HpackFieldType
@@ -634,7 +757,7 @@ decode_literal_header_field(MIMEFieldWrapper &header, const uint8_t *buf_start,
 
   p += len;
 
-  Arena arena;
+  HdrHeap *heap = header.heap_get();
 
   // Decode header field name
   if (index) {
@@ -643,7 +766,7 @@ decode_literal_header_field(MIMEFieldWrapper &header, const uint8_t *buf_start,
     char *name_str        = nullptr;
     uint64_t name_str_len = 0;
 
-    len = xpack_decode_string(arena, &name_str, name_str_len, p, buf_end);
+    len = decode_string_to_heap(heap, &name_str, name_str_len, p, buf_end);
     if (len == XPACK_ERROR_COMPRESSION_ERROR) {
       return HPACK_ERROR_COMPRESSION_ERROR;
     }
@@ -658,20 +781,20 @@ decode_literal_header_field(MIMEFieldWrapper &header, const uint8_t *buf_start,
     }
 
     p += len;
-    header.name_set(name_str, name_str_len);
+    header.name_set_from_heap(name_str, name_str_len);
   }
 
   // Decode header field value
   char *value_str        = nullptr;
   uint64_t value_str_len = 0;
 
-  len = xpack_decode_string(arena, &value_str, value_str_len, p, buf_end);
+  len = decode_string_to_heap(heap, &value_str, value_str_len, p, buf_end);
   if (len == XPACK_ERROR_COMPRESSION_ERROR) {
     return HPACK_ERROR_COMPRESSION_ERROR;
   }
 
   p += len;
-  header.value_set(value_str, value_str_len);
+  header.value_set_from_heap(value_str, value_str_len);
 
   // Incremental Indexing adds header to header table as new entry
   if (isIncremental) {
@@ -685,8 +808,7 @@ decode_literal_header_field(MIMEFieldWrapper &header, const uint8_t *buf_start,
     int decoded_value_len;
     const char *decoded_value = header.value_get(&decoded_value_len);
 
-    Debug("hpack_decode", "Decoded field: %s: %s", arena.str_store(decoded_name, decoded_name_len),
-          arena.str_store(decoded_value, decoded_value_len));
+    Debug("hpack_decode", "Decoded field: %.*s: %.*s", decoded_name_len, decoded_name, decoded_value_len, decoded_value);
   }
 
   if (has_http2_violation) {
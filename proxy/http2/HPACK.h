@@ -78,6 +78,34 @@ public:
     _field->value_set(_heap, _mh, value, value_len);
   }
 
+  // Use a string already allocated in the heap as the name, or the matching well known string.
+  void
+  name_set_from_heap(const char *name, int name_len)
+  {
+    const char *name_wks;
+    int name_wks_idx = hdrtoken_tokenize(name, name_len, &name_wks);
+
+    if (name_wks_idx >= 0) {
+      mime_field_name_set(_heap, _mh, _field, name_wks_idx, name_wks, name_len, false);
+      _heap->shrink_str(name, name_len, 0);
+    } else {
+      mime_field_name_set(_heap, _mh, _field, -1, name, name_len, false);
+    }
+  }
+
+  // Use a string already allocated in the heap as the value.
+  void
+  value_set_from_heap(const char *value, int value_len)
+  {
+    mime_field_value_set(_heap, _mh, _field, value, value_len, false);
+  }
+
+  HdrHeap *
+  heap_get() const
+  {
+    return _heap;
+  }
+
   const char *
   name_get(int *length) const
   {
@@ -115,6 +143,7 @@ public:
   ~HpackDynamicTable()
   {
     _headers.clear();
+    _name_hashes.clear();
     _mhdr->fields_clear();
     _mhdr->destroy();
     delete _mhdr;
@@ -126,6 +155,7 @@ public:
 
   const MIMEField *get_header_field(uint32_t index) const;
   void add_header_field(const MIMEField *field);
+  HpackLookupResult lookup(const char *name, int name_len, uint32_t name_hash, const char *value, int value_len) const;
 
   uint32_t maximum_size() const;
   uint32_t size() const;
@@ -141,6 +171,7 @@ private:
 
   MIMEHdr *_mhdr;
   std::vector<MIMEField *> _headers;
+  std::vector<uint32_t> _name_hashes; ///< Of the names in @a _headers, so @c lookup compares only likely matches.
 };
 
 // [RFC 7541] 2.3. Indexing Table
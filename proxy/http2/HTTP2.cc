@@ -62,6 +62,11 @@ static const char *const HTTP2_STAT_SESSION_DIE_INACTIVE_NAME             = "pro
 static const char *const HTTP2_STAT_SESSION_DIE_EOS_NAME                  = "proxy.process.http2.session_die_eos";
 static const char *const HTTP2_STAT_SESSION_DIE_ERROR_NAME                = "proxy.process.http2.session_die_error";
 static const char *const HTTP2_STAT_SESSION_DIE_HIGH_ERROR_RATE_NAME      = "proxy.process.http2.session_die_high_error_rate";
+static const char *const HTTP2_STAT_CURRENT_SERVER_CONNECTION_NAME        = "proxy.process.http2.current_server_connections";
+static const char *const HTTP2_STAT_TOTAL_SERVER_CONNECTION_NAME          = "proxy.process.http2.total_server_connections";
+static const char *const HTTP2_STAT_CURRENT_SERVER_STREAM_NAME            = "proxy.process.http2.current_server_streams";
+static const char *const HTTP2_STAT_TOTAL_SERVER_STREAM_NAME              = "proxy.process.http2.total_server_streams";
+static const char *const HTTP2_STAT_HDR_HEAPS_REUSED_NAME                 = "proxy.process.http2.header_heaps_reused";
 
 union byte_pointer {
   byte_pointer(void *p) : ptr(p) {}
@@ -420,40 +425,39 @@ http2_convert_header_from_2_to_1_1(HTTPHdr *headers)
   ink_assert(http_hdr_type_get(headers->m_http) != HTTP_TYPE_UNKNOWN);
 
   if (http_hdr_type_get(headers->m_http) == HTTP_TYPE_REQUEST) {
+    MIMEField *scheme_field, *authority_field, *path_field;
     const char *scheme, *authority, *path;
     int scheme_len, authority_len, path_len;
 
     // Get values of :scheme, :authority and :path to assemble requested URL
-    if ((field = headers->field_find(HTTP2_VALUE_SCHEME, HTTP2_LEN_SCHEME)) != nullptr && field->value_is_valid()) {
-      scheme = field->value_get(&scheme_len);
-    } else {
+    if ((scheme_field = headers->field_find(HTTP2_VALUE_SCHEME, HTTP2_LEN_SCHEME)) == nullptr || !scheme_field->value_is_valid()) {
       return PARSE_RESULT_ERROR;
     }
 
-    if ((field = headers->field_find(HTTP2_VALUE_AUTHORITY, HTTP2_LEN_AUTHORITY)) != nullptr && field->value_is_valid()) {
-      authority = field->value_get(&authority_len);
-    } else {
+    if ((authority_field = headers->field_find(HTTP2_VALUE_AUTHORITY, HTTP2_LEN_AUTHORITY)) == nullptr ||
+        !authority_field->value_is_valid()) {
       return PARSE_RESULT_ERROR;
     }
 
-    if ((field = headers->field_find(HTTP2_VALUE_PATH, HTTP2_LEN_PATH)) != nullptr && field->value_is_valid()) {
-      path = field->value_get(&path_len);
-    } else {
+    if ((path_field = headers->field_find(HTTP2_VALUE_PATH, HTTP2_LEN_PATH)) == nullptr || !path_field->value_is_valid()) {
       return PARSE_RESULT_ERROR;
     }
 
-    // Parse URL
-    Arena arena;
-    size_t url_length     = scheme_len + 3 + authority_len + path_len;
-    char *url             = arena.str_alloc(url_length);
+    // Parse URL. It is assembled in the header heap so the URL can refer to it instead of copying
+    // each part again. The allocation may coalesce the heap, get the values only after it.
+    size_t url_length = scheme_field->m_len_value + 3 + authority_field->m_len_value + path_field->m_len_value;
+    char *url         = headers->m_heap->allocate_str(url_length);
+
+    scheme                = scheme_field->value_get(&scheme_len);
+    authority             = authority_field->value_get(&authority_len);
+    path                  = path_field->value_get(&path_len);
     const char *url_start = url;
 
     memcpy(url, scheme, scheme_len);
     memcpy(url + scheme_len, "://", 3);
     memcpy(url + scheme_len + 3, authority, authority_len);
     memcpy(url + scheme_len + 3 + authority_len, path, path_len);
-    url_parse(headers->m_heap, headers->m_http->u.req.m_url_impl, &url_start, url + url_length, true);
-    arena.str_free(url);
+    url_parse(headers->m_heap, headers->m_http->u.req.m_url_impl, &url_start, url + url_length, false);
 
     // Get value of :method
     if ((field = headers->field_find(HTTP2_VALUE_METHOD, HTTP2_LEN_METHOD)) != nullptr && field->value_is_valid()) {
@@ -529,7 +533,6 @@ http2_generate_h2_header_from_1_1(HTTPHdr *headers, HTTPHdr *h2_headers)
     int value_len;
 
     // Add ':authority' header field
-    // TODO: remove host/Host header
     // [RFC 7540] 8.1.2.3. Clients that generate HTTP/2 requests directly SHOULD use the ":authority" pseudo-header field instead of
     // the Host header field.
     field = h2_headers->field_create(HTTP2_VALUE_AUTHORITY, HTTP2_LEN_AUTHORITY);
@@ -552,18 +555,30 @@ http2_generate_h2_header_from_1_1(HTTPHdr *headers, HTTPHdr *h2_headers)
     h2_headers->field_attach(field);
 
     // Add ':path' header field
-    field      = h2_headers->field_create(HTTP2_VALUE_PATH, HTTP2_LEN_PATH);
-    value      = headers->path_get(&value_len);
-    char *path = (char *)ats_malloc(value_len + 1);
-    path[0]    = '/';
+    int query_len     = 0;
+    const char *query = headers->url_get()->query_get(&query_len);
+    field             = h2_headers->field_create(HTTP2_VALUE_PATH, HTTP2_LEN_PATH);
+    value             = headers->path_get(&value_len);
+    int path_len      = 1 + value_len + (query_len > 0 ? 1 + query_len : 0);
+    char *path        = (char *)ats_malloc(path_len);
+    path[0]           = '/';
     memcpy(path + 1, value, value_len);
-    field->value_set(h2_headers->m_heap, h2_headers->m_mime, path, value_len + 1);
+    if (query_len > 0) {
+      path[1 + value_len] = '?';
+      memcpy(path + 2 + value_len, query, query_len);
+    }
+    field->value_set(h2_headers->m_heap, h2_headers->m_mime, path, path_len);
     ats_free(path);
     h2_headers->field_attach(field);
 
     // Add ':scheme' header field
+    // A request in origin form has no scheme, it is only sent over TLS.
     field = h2_headers->field_create(HTTP2_VALUE_SCHEME, HTTP2_LEN_SCHEME);
     value = headers->scheme_get(&value_len);
+    if (value == nullptr || value_len == 0) {
+      value     = URL_SCHEME_HTTPS;
+      value_len = URL_LEN_HTTPS;
+    }
     field->value_set(h2_headers->m_heap, h2_headers->m_mime, value, value_len);
     h2_headers->field_attach(field);
   }
@@ -581,7 +596,13 @@ http2_generate_h2_header_from_1_1(HTTPHdr *headers, HTTPHdr *h2_headers)
         (name_len == MIME_LEN_KEEP_ALIVE && strncasecmp(name, MIME_FIELD_KEEP_ALIVE, name_len) == 0) ||
         (name_len == MIME_LEN_PROXY_CONNECTION && strncasecmp(name, MIME_FIELD_PROXY_CONNECTION, name_len) == 0) ||
         (name_len == MIME_LEN_TRANSFER_ENCODING && strncasecmp(name, MIME_FIELD_TRANSFER_ENCODING, name_len) == 0) ||
-        (name_len == MIME_LEN_UPGRADE && strncasecmp(name, MIME_FIELD_UPGRADE, name_len) == 0)) {
+        (name_len == MIME_LEN_UPGRADE && strncasecmp(name, MIME_FIELD_UPGRADE, name_len) == 0) ||
+        (name_len == MIME_LEN_TE && strncasecmp(name, MIME_FIELD_TE, name_len) == 0)) {
+      continue;
+    }
+    // ':authority' carries the host of a request.
+    if (http_hdr_type_get(headers->m_http) == HTTP_TYPE_REQUEST && name_len == MIME_LEN_HOST &&
+        strncasecmp(name, MIME_FIELD_HOST, name_len) == 0) {
       continue;
     }
     MIMEField *newfield;
@@ -745,6 +766,10 @@ uint32_t Http2::zombie_timeout_in          = 0;
 float Http2::stream_error_rate_threshold   = 0.1;
 uint32_t Http2::max_settings_per_frame     = 7;
 uint32_t Http2::max_settings_per_minute    = 14;
+uint32_t Http2::enabled_out                = 0;
+uint32_t Http2::max_concurrent_streams_out = 100;
+uint32_t Http2::write_buffer_limit         = 131072;
+uint32_t Http2::max_window_size_in         = 0;
 
 void
 Http2::init()
@@ -765,6 +790,10 @@ Http2::init()
   REC_EstablishStaticConfigFloat(stream_error_rate_threshold, "proxy.config.http2.stream_error_rate_threshold");
   REC_EstablishStaticConfigInt32U(max_settings_per_frame, "proxy.config.http2.max_settings_per_frame");
   REC_EstablishStaticConfigInt32U(max_settings_per_minute, "proxy.config.http2.max_settings_per_minute");
+  REC_EstablishStaticConfigInt32U(enabled_out, "proxy.config.http2.enabled_out");
+  REC_EstablishStaticConfigInt32U(max_concurrent_streams_out, "proxy.config.http2.max_concurrent_streams_out");
+  REC_EstablishStaticConfigInt32U(write_buffer_limit, "proxy.config.http2.write_buffer_limit");
+  REC_EstablishStaticConfigInt32U(max_window_size_in, "proxy.config.http2.max_window_size_in");
 
   // If any settings is broken, ATS should not start
   ink_release_assert(http2_settings_parameter_is_valid({HTTP2_SETTINGS_MAX_CONCURRENT_STREAMS, max_concurrent_streams_in}));
@@ -815,6 +844,18 @@ Http2::init()
                      static_cast<int>(HTTP2_STAT_SESSION_DIE_ERROR), RecRawStatSyncSum);
   RecRegisterRawStat(http2_rsb, RECT_PROCESS, HTTP2_STAT_SESSION_DIE_HIGH_ERROR_RATE_NAME, RECD_INT, RECP_PERSISTENT,
                      static_cast<int>(HTTP2_STAT_SESSION_DIE_HIGH_ERROR_RATE), RecRawStatSyncSum);
+  RecRegisterRawStat(http2_rsb, RECT_PROCESS, HTTP2_STAT_CURRENT_SERVER_CONNECTION_NAME, RECD_INT, RECP_NON_PERSISTENT,
+                     static_cast<int>(HTTP2_STAT_CURRENT_SERVER_SESSION_COUNT), RecRawStatSyncSum);
+  HTTP2_CLEAR_DYN_STAT(HTTP2_STAT_CURRENT_SERVER_SESSION_COUNT);
+  RecRegisterRawStat(http2_rsb, RECT_PROCESS, HTTP2_STAT_TOTAL_SERVER_CONNECTION_NAME, RECD_INT, RECP_PERSISTENT,
+                     static_cast<int>(HTTP2_STAT_TOTAL_SERVER_SESSION_COUNT), RecRawStatSyncSum);
+  RecRegisterRawStat(http2_rsb, RECT_PROCESS, HTTP2_STAT_CURRENT_SERVER_STREAM_NAME, RECD_INT, RECP_NON_PERSISTENT,
+                     static_cast<int>(HTTP2_STAT_CURRENT_SERVER_STREAM_COUNT), RecRawStatSyncSum);
+  HTTP2_CLEAR_DYN_STAT(HTTP2_STAT_CURRENT_SERVER_STREAM_COUNT);
+  RecRegisterRawStat(http2_rsb, RECT_PROCESS, HTTP2_STAT_TOTAL_SERVER_STREAM_NAME, RECD_INT, RECP_PERSISTENT,
+                     static_cast<int>(HTTP2_STAT_TOTAL_SERVER_STREAM_COUNT), RecRawStatSyncSum);
+  RecRegisterRawStat(http2_rsb, RECT_PROCESS, HTTP2_STAT_HDR_HEAPS_REUSED_NAME, RECD_INT, RECP_PERSISTENT,
+                     static_cast<int>(HTTP2_STAT_HDR_HEAPS_REUSED), RecRawStatSyncSum);
 }
 
 #if TS_HAS_TESTS
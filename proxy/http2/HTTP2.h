@@ -84,6 +84,11 @@ enum {
   HTTP2_STAT_SESSION_DIE_EOS,
   HTTP2_STAT_SESSION_DIE_ERROR,
   HTTP2_STAT_SESSION_DIE_HIGH_ERROR_RATE,
+  HTTP2_STAT_CURRENT_SERVER_SESSION_COUNT, // Current # of HTTP2 connections to origin servers
+  HTTP2_STAT_TOTAL_SERVER_SESSION_COUNT,
+  HTTP2_STAT_CURRENT_SERVER_STREAM_COUNT, // Current # of streams to origin servers
+  HTTP2_STAT_TOTAL_SERVER_STREAM_COUNT,
+  HTTP2_STAT_HDR_HEAPS_REUSED, // Stream header heaps taken from the session pool
 
   HTTP2_N_STATS // Terminal counter, NOT A STAT INDEX.
 };
@@ -378,6 +383,10 @@ public:
   static float stream_error_rate_threshold;
   static uint32_t max_settings_per_frame;
   static uint32_t max_settings_per_minute;
+  static uint32_t enabled_out;
+  static uint32_t max_concurrent_streams_out;
+  static uint32_t write_buffer_limit;
+  static uint32_t max_window_size_in;
 
   static void init();
 };
@@ -166,7 +166,7 @@ Http2ClientSession::start()
   // this->write_buffer->write(HTTP2_CONNECTION_PREFACE,
   // HTTP2_CONNECTION_PREFACE_LEN);
 
-  this->connection_state.init();
+  this->connection_state.init(this->urgency_scheduling);
   send_connection_event(&this->connection_state, HTTP2_SESSION_EVENT_INIT, this);
   this->handleEvent(VC_EVENT_READ_READY, read_vio);
 }
@@ -278,6 +278,7 @@ Http2ClientSession::do_io_close(int alerrno)
   Http2SsnDebug("session closed");
 
   ink_assert(this->mutex->thread_holding == this_ethread());
+  this->cancel_rebalance();
   send_connection_event(&this->connection_state, HTTP2_SESSION_EVENT_FINI, this);
 
   // Don't send the SSN_CLOSE_HOOK until we got rid of all the streams
@@ -329,6 +330,8 @@ Http2ClientSession::main_event_handler(int event, void *edata)
   switch (event) {
   case VC_EVENT_READ_COMPLETE:
   case VC_EVENT_READ_READY: {
+    // Everything sent in reply to the frames read is written at once.
+    Http2XmitBatch batch(this);
     bool is_zombie = connection_state.get_zombie_event() != nullptr;
     retval         = (this->*session_handler)(event, edata);
     if (is_zombie && connection_state.get_zombie_event() != nullptr) {
@@ -342,7 +345,11 @@ Http2ClientSession::main_event_handler(int event, void *edata)
     total_write_len += frame->size();
     write_vio->nbytes = total_write_len;
     frame->xmit(this->write_buffer);
-    write_reenable();
+    if (xmit_batch_depth > 0) {
+      xmit_reenable_pending = true;
+    } else {
+      write_reenable();
+    }
     retval = 0;
     break;
   }
@@ -357,11 +364,16 @@ Http2ClientSession::main_event_handler(int event, void *edata)
     break;
 
   case VC_EVENT_WRITE_READY:
+  case VC_EVENT_WRITE_COMPLETE:
+    // The socket took some of the buffered frames, send the DATA frames that waited for it.
+    if (client_vc) {
+      connection_state.resume_xmit();
+    }
     retval = 0;
     break;
 
-  case VC_EVENT_WRITE_COMPLETE:
-    // Seems as this is being closed already
+  case NET_EVENT_MIGRATE:
+    this->finish_rebalance(client_vc && !this->is_active() && connection_state.get_client_stream_count() == 0);
     retval = 0;
     break;
 
@@ -573,6 +585,23 @@ Http2ClientSession::state_process_frame_read(int event, VIO *vio, bool inside_fr
     do_complete_frame_read();
   }
 
+  // Acknowledge all the DATA frames of this read with one WINDOW_UPDATE per window.
+  {
+    SCOPED_MUTEX_LOCK(lock, this->connection_state.mutex, this_ethread());
+    if (!this->connection_state.is_state_closed()) {
+      this->connection_state.send_window_update_frames();
+    }
+  }
+
+  // An idle session doesn't hold the buffer memory, it comes back with the next frame.
+  if (connection_state.get_client_stream_count() == 0 && !this->sm_reader->is_read_avail_more_than(0) &&
+      !this->sm_writer->is_read_avail_more_than(0)) {
+    HTTP_SUM_DYN_STAT(http_keep_alive_buffer_bytes_released_stat,
+                      this->read_buffer->release_blocks() + this->write_buffer->release_blocks());
+    SCOPED_MUTEX_LOCK(lock, this->connection_state.mutex, this_ethread());
+    this->connection_state.release_hdr_heaps();
+  }
+
   // If the client hasn't shut us down, reenable
   if (!this->is_client_closed()) {
     vio->reenable();
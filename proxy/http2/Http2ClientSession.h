@@ -87,12 +87,21 @@ public:
     return this->hdr;
   }
 
-  // Allocate an IOBufferBlock for payload of this frame.
+  // Allocate an IOBufferBlock for payload of this frame. The frame header is put at the start of
+  // the same block, so a frame filling the block is written out as one piece.
   void
   alloc(int index)
   {
     this->ioblock = new_IOBufferBlock();
     this->ioblock->alloc(index);
+    this->ioblock->fill(HTTP2_FRAME_HEADER_LEN);
+  }
+
+  // The payload that fits in a frame allocated with @a index.
+  static constexpr int64_t
+  payload_size_for_index(int index)
+  {
+    return BUFFER_SIZE_FOR_INDEX(index) - HTTP2_FRAME_HEADER_LEN;
   }
 
   // Return the writeable buffer space for frame payload
@@ -110,22 +119,21 @@ public:
       ink_assert((int64_t)nbytes <= this->ioblock->write_avail());
       this->ioblock->fill(nbytes);
 
-      this->hdr.length = this->ioblock->size();
+      this->hdr.length = this->ioblock->size() - HTTP2_FRAME_HEADER_LEN;
     }
   }
 
   void
   xmit(MIOBuffer *iobuffer)
   {
-    // Write frame header
-    uint8_t buf[HTTP2_FRAME_HEADER_LEN];
-    http2_write_frame_header(hdr, make_iovec(buf));
-    iobuffer->write(buf, sizeof(buf));
-
-    // Write frame payload
-    // It could be empty (e.g. SETTINGS frame with ACK flag)
-    if (ioblock && ioblock->read_avail() > 0) {
+    if (ioblock) {
+      http2_write_frame_header(hdr, make_iovec(ioblock->start(), HTTP2_FRAME_HEADER_LEN));
       iobuffer->append_block(this->ioblock.get());
+    } else {
+      // No payload (e.g. SETTINGS frame with ACK flag)
+      uint8_t buf[HTTP2_FRAME_HEADER_LEN];
+      http2_write_frame_header(hdr, make_iovec(buf));
+      iobuffer->write(buf, sizeof(buf));
     }
   }
 
@@ -133,7 +141,7 @@ public:
   size()
   {
     if (ioblock) {
-      return HTTP2_FRAME_HEADER_LEN + ioblock->size();
+      return ioblock->size();
     } else {
       return HTTP2_FRAME_HEADER_LEN;
     }
@@ -201,6 +209,26 @@ public:
     write_vio->reenable();
   }
 
+  // Frames sent between these are written with a single write reenable at the end. Use @c Http2XmitBatch.
+  void
+  xmit_batch_begin()
+  {
+    ++xmit_batch_depth;
+  }
+
+  void
+  xmit_batch_end()
+  {
+    ink_assert(xmit_batch_depth > 0);
+    if (--xmit_batch_depth == 0 && xmit_reenable_pending) {
+      xmit_reenable_pending = false;
+      // Nothing to do if the connection was closed in the batch.
+      if (client_vc) {
+        write_reenable();
+      }
+    }
+  }
+
   void set_upgrade_context(HTTPHdr *h);
 
   const Http2UpgradeContext &
@@ -221,6 +249,9 @@ public:
   }
 
   Http2ConnectionState connection_state;
+  /// Schedule the streams by RFC 9218 urgency, set from the proxy port.
+  bool urgency_scheduling = false;
+
   void
   set_dying_event(int event)
   {
@@ -344,8 +375,25 @@ private:
   Http2SessionCod cause_of_death = Http2SessionCod::NOT_PROVIDED;
   bool half_close_local          = false;
   int recursion                  = 0;
+  int xmit_batch_depth           = 0;
+  bool xmit_reenable_pending     = false;
 
   std::unordered_set<std::string> h2_pushed_urls;
 };
 
+/// Frames sent for the lifetime of this are written to the client with one write reenable.
+class Http2XmitBatch
+{
+public:
+  explicit Http2XmitBatch(Http2ClientSession *ssn) : _ssn(ssn) { _ssn->xmit_batch_begin(); }
+  ~Http2XmitBatch() { _ssn->xmit_batch_end(); }
+
+  // noncopyable
+  Http2XmitBatch(Http2XmitBatch &) = delete;
+  Http2XmitBatch &operator=(const Http2XmitBatch &) = delete;
+
+private:
+  Http2ClientSession *_ssn;
+};
+
 extern ClassAllocator<Http2ClientSession> http2ClientSessionAllocator;
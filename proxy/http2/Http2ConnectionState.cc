@@ -44,6 +44,9 @@
 
 using http2_frame_dispatch = Http2Error (*)(Http2ConnectionState &, const Http2Frame &);
 
+// DATA frames sent per turn of send_data_frames_depends_on_priority or _urgency, up to one frame past this.
+static constexpr size_t HTTP2_XMIT_BATCH_SIZE = 64 * 1024;
+
 static const int buffer_size_index[HTTP2_FRAME_TYPE_MAX] = {
   BUFFER_SIZE_INDEX_16K, // HTTP2_FRAME_TYPE_DATA
   BUFFER_SIZE_INDEX_16K, // HTTP2_FRAME_TYPE_HEADERS
@@ -179,20 +182,8 @@ rcv_data_frame(Http2ConnectionState &cstate, const Http2Frame &frame)
   }
   myreader->writer()->dealloc_reader(myreader);
 
-  uint32_t initial_rwnd = cstate.server_settings.get(HTTP2_SETTINGS_INITIAL_WINDOW_SIZE);
-  uint32_t min_rwnd     = std::min(initial_rwnd, cstate.server_settings.get(HTTP2_SETTINGS_MAX_FRAME_SIZE));
-  // Connection level WINDOW UPDATE
-  if (cstate.server_rwnd <= min_rwnd) {
-    Http2WindowSize diff_size = initial_rwnd - cstate.server_rwnd;
-    cstate.server_rwnd += diff_size;
-    cstate.send_window_update_frame(0, diff_size);
-  }
-  // Stream level WINDOW UPDATE
-  if (stream->server_rwnd <= min_rwnd) {
-    Http2WindowSize diff_size = initial_rwnd - stream->server_rwnd;
-    stream->server_rwnd += diff_size;
-    cstate.send_window_update_frame(stream->get_id(), diff_size);
-  }
+  // The WINDOW_UPDATE frames go out once all the frames of this read are handled
+  cstate.received_data(stream, payload_length);
 
   return Http2Error(Http2ErrorClass::HTTP2_ERROR_CLASS_NONE);
 }
@@ -296,7 +287,7 @@ rcv_headers_frame(Http2ConnectionState &cstate, const Http2Frame &frame)
     header_block_fragment_length -= HTTP2_PRIORITY_LEN;
   }
 
-  if (new_stream && Http2::stream_priority_enabled) {
+  if (new_stream && cstate.uses_dependency_tree()) {
     Http2DependencyTree::Node *node = cstate.dependency_tree->find(stream_id);
     if (node != nullptr) {
       stream->priority_node = node;
@@ -414,7 +405,7 @@ rcv_priority_frame(Http2ConnectionState &cstate, const Http2Frame &frame)
                       "PRIORITY frame depends on itself");
   }
 
-  if (!Http2::stream_priority_enabled) {
+  if (!cstate.uses_dependency_tree()) {
     return Http2Error(Http2ErrorClass::HTTP2_ERROR_CLASS_NONE);
   }
 
@@ -640,13 +631,14 @@ rcv_ping_frame(Http2ConnectionState &cstate, const Http2Frame &frame)
                       "ping bad length");
   }
 
+  frame.reader()->memcpy(opaque_data, HTTP2_PING_LEN, 0);
+
   // An endpoint MUST NOT respond to PING frames containing this flag.
   if (frame.header().flags & HTTP2_FLAGS_PING_ACK) {
+    cstate.received_ping_ack(opaque_data);
     return Http2Error(Http2ErrorClass::HTTP2_ERROR_CLASS_NONE);
   }
 
-  frame.reader()->memcpy(opaque_data, HTTP2_PING_LEN, 0);
-
   // ACK (0x1): An endpoint MUST set this flag in PING responses.
   cstate.send_ping_frame(stream_id, HTTP2_FLAGS_PING_ACK, opaque_data);
 
@@ -941,7 +933,11 @@ Http2ConnectionState::main_event_handler(int event, void *edata)
   case HTTP2_SESSION_EVENT_XMIT: {
     REMEMBER(event, this->recursion);
     SCOPED_MUTEX_LOCK(lock, this->mutex, this_ethread());
-    send_data_frames_depends_on_priority();
+    if (urgency_scheduler) {
+      send_data_frames_depends_on_urgency();
+    } else {
+      send_data_frames_depends_on_priority();
+    }
     _scheduled = false;
   } break;
 
@@ -1110,7 +1106,7 @@ Http2ConnectionState::create_stream(Http2StreamId new_id, Http2Error &error)
   }
 
   Http2Stream *new_stream = THREAD_ALLOC_INIT(http2StreamAllocator, this_ethread());
-  new_stream->init(new_id, client_settings.get(HTTP2_SETTINGS_INITIAL_WINDOW_SIZE));
+  new_stream->init(new_id, client_settings.get(HTTP2_SETTINGS_INITIAL_WINDOW_SIZE), get_hdr_heap(), get_hdr_heap());
 
   ink_assert(nullptr != new_stream);
   ink_assert(!stream_list.in(new_stream));
@@ -1221,6 +1217,45 @@ Http2ConnectionState::cleanup_streams()
   }
 }
 
+/**
+   Take an emptied header heap from the pool, or nullptr if it is empty and the header should allocate one.
+*/
+HdrHeap *
+Http2ConnectionState::get_hdr_heap()
+{
+  if (_hdr_heap_pool_count == 0) {
+    return nullptr;
+  }
+  HTTP2_INCREMENT_THREAD_DYN_STAT(HTTP2_STAT_HDR_HEAPS_REUSED, this_ethread());
+  return _hdr_heap_pool[--_hdr_heap_pool_count];
+}
+
+/**
+   Keep the header heap of a destroyed stream for the next stream, it is freed if the pool is full.
+*/
+void
+Http2ConnectionState::recycle_hdr_heap(HdrHeap *heap)
+{
+  if (heap == nullptr) {
+    return;
+  }
+  // Heaps that grew overflow blocks would keep their larger footprint for good, and a closing session needs none.
+  if (_hdr_heap_pool_count == HDR_HEAP_POOL_SIZE || !heap->m_writeable || heap->m_next != nullptr || ua_session == nullptr) {
+    heap->destroy();
+    return;
+  }
+  heap->reset();
+  _hdr_heap_pool[_hdr_heap_pool_count++] = heap;
+}
+
+void
+Http2ConnectionState::release_hdr_heaps()
+{
+  while (_hdr_heap_pool_count > 0) {
+    _hdr_heap_pool[--_hdr_heap_pool_count]->destroy();
+  }
+}
+
 bool
 Http2ConnectionState::delete_stream(Http2Stream *stream)
 {
@@ -1235,7 +1270,9 @@ Http2ConnectionState::delete_stream(Http2Stream *stream)
   Http2StreamDebug(ua_session, stream->get_id(), "Delete stream");
   REMEMBER(NO_EVENT, this->recursion);
 
-  if (Http2::stream_priority_enabled) {
+  if (urgency_scheduler) {
+    urgency_scheduler->deactivate(&stream->urgency_node);
+  } else if (Http2::stream_priority_enabled) {
     Http2DependencyTree::Node *node = stream->priority_node;
     if (node != nullptr) {
       if (node->active) {
@@ -1303,6 +1340,7 @@ Http2ConnectionState::release_stream(Http2Stream *stream)
         // If the number of clients is 0, HTTP2_SESSION_EVENT_FINI is not received or sent, and ua_session is active,
         // then mark the connection as inactive
         ua_session->clear_session_active();
+        ua_session->rebalance();
         UnixNetVConnection *vc = static_cast<UnixNetVConnection *>(ua_session->get_netvc());
         if (vc && vc->active_timeout_in == 0) {
           // With heavy traffic, ua_session could be destroyed. Do not touch ua_session after this.
@@ -1332,11 +1370,39 @@ Http2ConnectionState::schedule_stream(Http2Stream *stream)
 {
   Http2StreamDebug(ua_session, stream->get_id(), "Scheduled");
 
-  Http2DependencyTree::Node *node = stream->priority_node;
-  ink_release_assert(node != nullptr);
+  SCOPED_MUTEX_LOCK(lock, this->mutex, this_ethread());
+  if (urgency_scheduler) {
+    urgency_scheduler->activate(&stream->urgency_node);
+  } else {
+    Http2DependencyTree::Node *node = stream->priority_node;
+    ink_release_assert(node != nullptr);
+    dependency_tree->activate(node);
+  }
+
+  if (!_scheduled) {
+    _scheduled = true;
+
+    SET_HANDLER(&Http2ConnectionState::main_event_handler);
+    this_ethread()->schedule_imm_local((Continuation *)this, HTTP2_SESSION_EVENT_XMIT);
+  }
+}
+
+// Whether the session already holds so much unsent data that more DATA frames would only queue behind it.
+bool
+Http2ConnectionState::is_write_buffer_full()
+{
+  return Http2::write_buffer_limit > 0 && ua_session->write_buffer_size() >= Http2::write_buffer_limit;
+}
 
+// Called by the session when the socket took some of the buffered data.
+void
+Http2ConnectionState::resume_xmit()
+{
   SCOPED_MUTEX_LOCK(lock, this->mutex, this_ethread());
-  dependency_tree->activate(node);
+  if (!_xmit_blocked || is_write_buffer_full()) {
+    return;
+  }
+  _xmit_blocked = false;
 
   if (!_scheduled) {
     _scheduled = true;
@@ -1349,53 +1415,123 @@ Http2ConnectionState::schedule_stream(Http2Stream *stream)
 void
 Http2ConnectionState::send_data_frames_depends_on_priority()
 {
-  Http2DependencyTree::Node *node = dependency_tree->top();
+  // The frames of one turn go out in a single write. Other events get a chance between turns.
+  Http2XmitBatch batch(this->ua_session);
+  size_t sent = 0;
+
+  while (sent < HTTP2_XMIT_BATCH_SIZE) {
+    // Only fill the write buffer as fast as the socket drains it, so the streams scheduled first
+    // are not stuck behind data already buffered for the others.
+    if (is_write_buffer_full()) {
+      _xmit_blocked = true;
+      return;
+    }
 
-  // No node to send or no connection level window left
-  if (node == nullptr || client_rwnd <= 0) {
-    return;
-  }
+    Http2DependencyTree::Node *node = dependency_tree->top();
+
+    // No node to send or no connection level window left
+    if (node == nullptr || client_rwnd <= 0) {
+      return;
+    }
 
-  Http2Stream *stream = static_cast<Http2Stream *>(node->t);
-  ink_release_assert(stream != nullptr);
-  Http2StreamDebug(ua_session, stream->get_id(), "top node, point=%d", node->point);
+    Http2Stream *stream = static_cast<Http2Stream *>(node->t);
+    ink_release_assert(stream != nullptr);
+    Http2StreamDebug(ua_session, stream->get_id(), "top node, point=%d", node->point);
 
-  size_t len                      = 0;
-  Http2SendDataFrameResult result = send_a_data_frame(stream, len);
+    size_t len                      = 0;
+    Http2SendDataFrameResult result = send_a_data_frame(stream, len);
+    sent += HTTP2_FRAME_HEADER_LEN + len;
 
-  switch (result) {
-  case Http2SendDataFrameResult::NO_ERROR: {
-    // No response body to send
-    if (len == 0 && !stream->is_body_done()) {
-      dependency_tree->deactivate(node, len);
-    } else {
-      dependency_tree->update(node, len);
+    switch (result) {
+    case Http2SendDataFrameResult::NO_ERROR: {
+      // No response body to send
+      if (len == 0 && !stream->is_body_done()) {
+        dependency_tree->deactivate(node, len);
+      } else {
+        dependency_tree->update(node, len);
 
-      SCOPED_MUTEX_LOCK(stream_lock, stream->mutex, this_ethread());
-      stream->signal_write_event(true);
+        SCOPED_MUTEX_LOCK(stream_lock, stream->mutex, this_ethread());
+        stream->signal_write_event(true);
+      }
+      break;
+    }
+    case Http2SendDataFrameResult::DONE: {
+      dependency_tree->deactivate(node, len);
+      delete_stream(stream);
+      break;
+    }
+    default:
+      // When no stream level window left, deactivate node once and wait window_update frame
+      dependency_tree->deactivate(node, len);
+      break;
     }
-    break;
-  }
-  case Http2SendDataFrameResult::DONE: {
-    dependency_tree->deactivate(node, len);
-    delete_stream(stream);
-    break;
-  }
-  default:
-    // When no stream level window left, deactivate node once and wait window_update frame
-    dependency_tree->deactivate(node, len);
-    break;
   }
 
   this_ethread()->schedule_imm_local((Continuation *)this, HTTP2_SESSION_EVENT_XMIT);
   return;
 }
 
+void
+Http2ConnectionState::send_data_frames_depends_on_urgency()
+{
+  Http2XmitBatch batch(this->ua_session);
+  size_t sent = 0;
+
+  while (sent < HTTP2_XMIT_BATCH_SIZE) {
+    // Only fill the write buffer as fast as the socket drains it, so the streams scheduled first
+    // are not stuck behind data already buffered for the others.
+    if (is_write_buffer_full()) {
+      _xmit_blocked = true;
+      return;
+    }
+
+    Http2UrgencyScheduler::Node *node = urgency_scheduler->top();
+
+    // No stream to send or no connection level window left
+    if (node == nullptr || client_rwnd <= 0) {
+      return;
+    }
+
+    Http2Stream *stream = static_cast<Http2Stream *>(node->t);
+    Http2StreamDebug(ua_session, stream->get_id(), "top node, urgency=%d incremental=%d", node->urgency, node->incremental);
+
+    size_t len                      = 0;
+    Http2SendDataFrameResult result = send_a_data_frame(stream, len);
+    sent += HTTP2_FRAME_HEADER_LEN + len;
+
+    switch (result) {
+    case Http2SendDataFrameResult::NO_ERROR: {
+      // No response body to send
+      if (len == 0 && !stream->is_body_done()) {
+        urgency_scheduler->deactivate(node);
+      } else {
+        urgency_scheduler->update(node);
+
+        SCOPED_MUTEX_LOCK(stream_lock, stream->mutex, this_ethread());
+        stream->signal_write_event(true);
+      }
+      break;
+    }
+    case Http2SendDataFrameResult::DONE: {
+      urgency_scheduler->deactivate(node);
+      delete_stream(stream);
+      break;
+    }
+    default:
+      // When no stream level window left, deactivate node once and wait window_update frame
+      urgency_scheduler->deactivate(node);
+      break;
+    }
+  }
+
+  this_ethread()->schedule_imm_local((Continuation *)this, HTTP2_SESSION_EVENT_XMIT);
+}
+
 Http2SendDataFrameResult
 Http2ConnectionState::send_a_data_frame(Http2Stream *stream, size_t &payload_length)
 {
   const ssize_t window_size         = std::min(this->client_rwnd, stream->client_rwnd);
-  const size_t buf_len              = BUFFER_SIZE_FOR_INDEX(buffer_size_index[HTTP2_FRAME_TYPE_DATA]);
+  const size_t buf_len              = Http2Frame::payload_size_for_index(buffer_size_index[HTTP2_FRAME_TYPE_DATA]);
   const size_t write_available_size = std::min(buf_len, static_cast<size_t>(window_size));
   payload_length                    = 0;
 
@@ -1479,6 +1615,9 @@ Http2ConnectionState::send_data_frames(Http2Stream *stream)
     return;
   }
 
+  SCOPED_MUTEX_LOCK(lock, this->ua_session->mutex, this_ethread());
+  Http2XmitBatch batch(this->ua_session);
+
   size_t len                      = 0;
   Http2SendDataFrameResult result = Http2SendDataFrameResult::NO_ERROR;
   while (result == Http2SendDataFrameResult::NO_ERROR) {
@@ -1529,7 +1668,8 @@ Http2ConnectionState::send_headers_frame(Http2Stream *stream)
   }
 
   // Send a HEADERS frame
-  if (header_blocks_size <= static_cast<uint32_t>(BUFFER_SIZE_FOR_INDEX(buffer_size_index[HTTP2_FRAME_TYPE_HEADERS]))) {
+  const uint32_t headers_payload_size = Http2Frame::payload_size_for_index(buffer_size_index[HTTP2_FRAME_TYPE_HEADERS]);
+  if (header_blocks_size <= headers_payload_size) {
     payload_length = header_blocks_size;
     flags |= HTTP2_FLAGS_HEADERS_END_HEADERS;
     if (h2_hdr.presence(MIME_PRESENCE_CONTENT_LENGTH) && h2_hdr.get_content_length() == 0) {
@@ -1537,7 +1677,7 @@ Http2ConnectionState::send_headers_frame(Http2Stream *stream)
       stream->send_end_stream = true;
     }
   } else {
-    payload_length = BUFFER_SIZE_FOR_INDEX(buffer_size_index[HTTP2_FRAME_TYPE_HEADERS]);
+    payload_length = headers_payload_size;
   }
   Http2Frame headers(HTTP2_FRAME_TYPE_HEADERS, stream->get_id(), flags);
   headers.alloc(buffer_size_index[HTTP2_FRAME_TYPE_HEADERS]);
@@ -1566,8 +1706,9 @@ Http2ConnectionState::send_headers_frame(Http2Stream *stream)
   flags = 0;
   while (sent < header_blocks_size) {
     Http2StreamDebug(ua_session, stream->get_id(), "Send CONTINUATION frame");
-    payload_length = std::min(static_cast<uint32_t>(BUFFER_SIZE_FOR_INDEX(buffer_size_index[HTTP2_FRAME_TYPE_CONTINUATION])),
-                              static_cast<uint32_t>(header_blocks_size - sent));
+    payload_length =
+      std::min(static_cast<uint32_t>(Http2Frame::payload_size_for_index(buffer_size_index[HTTP2_FRAME_TYPE_CONTINUATION])),
+               static_cast<uint32_t>(header_blocks_size - sent));
     if (sent + payload_length == header_blocks_size) {
       flags |= HTTP2_FLAGS_CONTINUATION_END_HEADERS;
     }
@@ -1640,13 +1781,13 @@ Http2ConnectionState::send_push_promise_frame(Http2Stream *stream, URL &url, con
 
   // Send a PUSH_PROMISE frame
   Http2PushPromise push_promise;
-  if (header_blocks_size <=
-      BUFFER_SIZE_FOR_INDEX(buffer_size_index[HTTP2_FRAME_TYPE_PUSH_PROMISE]) - sizeof(push_promise.promised_streamid)) {
+  const uint32_t push_promise_payload_size =
+    Http2Frame::payload_size_for_index(buffer_size_index[HTTP2_FRAME_TYPE_PUSH_PROMISE]) - sizeof(push_promise.promised_streamid);
+  if (header_blocks_size <= push_promise_payload_size) {
     payload_length = header_blocks_size;
     flags |= HTTP2_FLAGS_PUSH_PROMISE_END_HEADERS;
   } else {
-    payload_length =
-      BUFFER_SIZE_FOR_INDEX(buffer_size_index[HTTP2_FRAME_TYPE_PUSH_PROMISE]) - sizeof(push_promise.promised_streamid);
+    payload_length = push_promise_payload_size;
   }
   Http2Frame push_promise_frame(HTTP2_FRAME_TYPE_PUSH_PROMISE, stream->get_id(), flags);
   push_promise_frame.alloc(buffer_size_index[HTTP2_FRAME_TYPE_PUSH_PROMISE]);
@@ -1663,8 +1804,9 @@ Http2ConnectionState::send_push_promise_frame(Http2Stream *stream, URL &url, con
   flags = 0;
   while (sent < header_blocks_size) {
     Http2StreamDebug(ua_session, stream->get_id(), "Send CONTINUATION frame");
-    payload_length = std::min(static_cast<uint32_t>(BUFFER_SIZE_FOR_INDEX(buffer_size_index[HTTP2_FRAME_TYPE_CONTINUATION])),
-                              static_cast<uint32_t>(header_blocks_size - sent));
+    payload_length =
+      std::min(static_cast<uint32_t>(Http2Frame::payload_size_for_index(buffer_size_index[HTTP2_FRAME_TYPE_CONTINUATION])),
+               static_cast<uint32_t>(header_blocks_size - sent));
     if (sent + payload_length == header_blocks_size) {
       flags |= HTTP2_FLAGS_CONTINUATION_END_HEADERS;
     }
@@ -1687,7 +1829,7 @@ Http2ConnectionState::send_push_promise_frame(Http2Stream *stream, URL &url, con
   }
 
   SCOPED_MUTEX_LOCK(stream_lock, stream->mutex, this_ethread());
-  if (Http2::stream_priority_enabled) {
+  if (this->uses_dependency_tree()) {
     Http2DependencyTree::Node *node = this->dependency_tree->find(id);
     if (node != nullptr) {
       stream->priority_node = node;
@@ -1837,6 +1979,94 @@ Http2ConnectionState::send_goaway_frame(Http2StreamId id, Http2ErrorCode ec)
   this->ua_session->handleEvent(HTTP2_SESSION_EVENT_XMIT, &frame);
 }
 
+/**
+   Account for @a length bytes of DATA received on @a stream.
+
+   The windows are refilled once they are down to half of the target so a client that keeps sending never waits a
+   round trip for a WINDOW_UPDATE, and the refill is left to send_window_update_frames() so all the DATA frames of
+   one read are acknowledged with one frame per window. While the target may still grow, the DATA received during
+   the round trip of a PING estimates the bandwidth-delay product of the connection.
+*/
+void
+Http2ConnectionState::received_data(Http2Stream *stream, uint32_t length)
+{
+  const uint32_t target = this->rwnd_target();
+
+  if (this->server_rwnd <= target / 2) {
+    this->_window_update_pending = true;
+  }
+  if (stream->server_rwnd <= target / 2 && !stream->recv_end_stream) {
+    stream->window_update_pending = true;
+    this->_window_update_pending  = true;
+  }
+
+  if (target < std::min<uint32_t>(Http2::max_window_size_in, HTTP2_MAX_WINDOW_SIZE)) {
+    if (this->_bdp_ping_sent) {
+      this->_bdp_bytes += length;
+    } else {
+      this->_bdp_ping_sent = Thread::get_hrtime();
+      this->_bdp_bytes     = 0;
+      this->send_ping_frame(0, 0, BDP_PING_DATA);
+    }
+  }
+}
+
+/**
+   Grow the receive window target if the DATA received while the BDP PING was in flight filled most of it.
+*/
+void
+Http2ConnectionState::received_ping_ack(const uint8_t *opaque_data)
+{
+  if (!this->_bdp_ping_sent || memcmp(opaque_data, BDP_PING_DATA, HTTP2_PING_LEN) != 0) {
+    return;
+  }
+
+  const uint32_t target = this->rwnd_target();
+  if (this->_bdp_bytes * 3 > static_cast<uint64_t>(target) * 2) {
+    this->_rwnd_target = std::min<uint64_t>(static_cast<uint64_t>(target) * 2,
+                                            std::min<uint32_t>(Http2::max_window_size_in, HTTP2_MAX_WINDOW_SIZE));
+    Http2ConDebug(ua_session, "Receive window target %u -> %u, %" PRIu64 " bytes in %" PRId64 " usec", target,
+                  this->_rwnd_target, this->_bdp_bytes, ink_hrtime_to_usec(Thread::get_hrtime() - this->_bdp_ping_sent));
+    // Open the connection window right away, the streams follow with their next DATA frame.
+    this->_window_update_pending = true;
+  }
+  this->_bdp_ping_sent = 0;
+}
+
+/**
+   Send the WINDOW_UPDATE frames received_data() left pending, at most one for the connection and one per stream.
+*/
+void
+Http2ConnectionState::send_window_update_frames()
+{
+  if (!this->_window_update_pending) {
+    return;
+  }
+  this->_window_update_pending = false;
+
+  const uint32_t target = this->rwnd_target();
+
+  // Connection level WINDOW UPDATE
+  if (this->server_rwnd <= target / 2) {
+    Http2WindowSize diff_size = target - this->server_rwnd;
+    this->server_rwnd += diff_size;
+    this->send_window_update_frame(0, diff_size);
+  }
+
+  // Stream level WINDOW UPDATE
+  for (Http2Stream *s = stream_list.head; s; s = static_cast<Http2Stream *>(s->link.next)) {
+    if (!s->window_update_pending) {
+      continue;
+    }
+    s->window_update_pending = false;
+    if (s->server_rwnd <= target / 2 && !s->recv_end_stream) {
+      Http2WindowSize diff_size = target - s->server_rwnd;
+      s->server_rwnd += diff_size;
+      this->send_window_update_frame(s->get_id(), diff_size);
+    }
+  }
+}
+
 void
 Http2ConnectionState::send_window_update_frame(Http2StreamId id, uint32_t size)
 {
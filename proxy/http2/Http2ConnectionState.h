@@ -28,6 +28,7 @@
 #include "HPACK.h"
 #include "Http2Stream.h"
 #include "Http2DependencyTree.h"
+#include "Http2UrgencyScheduler.h"
 
 class Http2ClientSession;
 
@@ -122,16 +123,23 @@ public:
   HpackHandle *remote_hpack_handle = nullptr;
   DependencyTree *dependency_tree  = nullptr;
 
+  /// Set instead of @a dependency_tree if the streams are scheduled by RFC 9218 urgency.
+  Http2UrgencyScheduler *urgency_scheduler = nullptr;
+
   // Settings.
   Http2ConnectionSettings server_settings;
   Http2ConnectionSettings client_settings;
 
   void
-  init()
+  init(bool urgency_scheduling = false)
   {
     local_hpack_handle  = new HpackHandle(HTTP2_HEADER_TABLE_SIZE);
     remote_hpack_handle = new HpackHandle(HTTP2_HEADER_TABLE_SIZE);
-    dependency_tree     = new DependencyTree(Http2::max_concurrent_streams_in);
+    if (urgency_scheduling) {
+      urgency_scheduler = new Http2UrgencyScheduler();
+    } else {
+      dependency_tree = new DependencyTree(Http2::max_concurrent_streams_in);
+    }
   }
 
   void
@@ -141,14 +149,17 @@ public:
       shutdown_cont_event->cancel();
     }
     cleanup_streams();
+    release_hdr_heaps();
 
     delete local_hpack_handle;
     local_hpack_handle = nullptr;
     delete remote_hpack_handle;
     remote_hpack_handle = nullptr;
     delete dependency_tree;
-    dependency_tree  = nullptr;
-    this->ua_session = nullptr;
+    dependency_tree = nullptr;
+    delete urgency_scheduler;
+    urgency_scheduler = nullptr;
+    this->ua_session  = nullptr;
 
     if (fini_event) {
       fini_event->cancel();
@@ -168,10 +179,16 @@ public:
   Http2Stream *create_stream(Http2StreamId new_id, Http2Error &error);
   Http2Stream *find_stream(Http2StreamId id) const;
   void restart_streams();
+  void resume_xmit();
   bool delete_stream(Http2Stream *stream);
   void release_stream(Http2Stream *stream);
   void cleanup_streams();
 
+  // Header heaps of destroyed streams, reused by the streams created after them
+  HdrHeap *get_hdr_heap();
+  void recycle_hdr_heap(HdrHeap *heap);
+  void release_hdr_heaps();
+
   void update_initial_rwnd(Http2WindowSize new_size);
 
   Http2StreamId
@@ -245,6 +262,7 @@ public:
   // HTTP/2 frame sender
   void schedule_stream(Http2Stream *stream);
   void send_data_frames_depends_on_priority();
+  void send_data_frames_depends_on_urgency();
   void send_data_frames(Http2Stream *stream);
   Http2SendDataFrameResult send_a_data_frame(Http2Stream *stream, size_t &payload_length);
   void send_headers_frame(Http2Stream *stream);
@@ -254,6 +272,25 @@ public:
   void send_ping_frame(Http2StreamId id, uint8_t flag, const uint8_t *opaque_data);
   void send_goaway_frame(Http2StreamId id, Http2ErrorCode ec);
   void send_window_update_frame(Http2StreamId id, uint32_t size);
+  void send_window_update_frames();
+
+  // Receive flow control
+  void received_data(Http2Stream *stream, uint32_t length);
+  void received_ping_ack(const uint8_t *opaque_data);
+
+  /// Check if the streams are sent in priority order rather than as their data arrives.
+  bool
+  is_priority_scheduled() const
+  {
+    return urgency_scheduler != nullptr || Http2::stream_priority_enabled;
+  }
+
+  /// Check if the RFC 7540 priority of the streams is kept in @a dependency_tree.
+  bool
+  uses_dependency_tree() const
+  {
+    return urgency_scheduler == nullptr && Http2::stream_priority_enabled;
+  }
 
   bool
   is_state_closed() const
@@ -316,6 +353,20 @@ public:
 
 private:
   unsigned _adjust_concurrent_stream();
+  bool is_write_buffer_full();
+
+  /// The size the connection and stream receive windows are refilled to.
+  uint32_t
+  rwnd_target() const
+  {
+    return std::max(this->_rwnd_target, server_settings.get(HTTP2_SETTINGS_INITIAL_WINDOW_SIZE));
+  }
+
+  /// Most header heaps kept for new streams, two per stream.
+  static constexpr int HDR_HEAP_POOL_SIZE = 16;
+
+  /// Opaque data of the PING that measures the bandwidth-delay product.
+  static constexpr uint8_t BDP_PING_DATA[HTTP2_PING_LEN] = {'A', 'T', 'S', 'B', 'D', 'P', 0, 0};
 
   // NOTE: 'stream_list' has only active streams.
   //   If given Stream Identifier is not found in stream_list and it is less
@@ -354,6 +405,13 @@ private:
   //     another CONTINUATION frame."
   Http2StreamId continued_stream_id = 0;
   bool _scheduled                   = false;
+  bool _xmit_blocked                = false; ///< DATA frames wait for the session write buffer to drain.
+  bool _window_update_pending       = false; ///< Some receive window is due a refill, see received_data().
+  uint32_t _rwnd_target             = 0;     ///< Receive window grown from the BDP estimate.
+  ink_hrtime _bdp_ping_sent         = 0;     ///< When the outstanding BDP PING was sent, 0 if there is none.
+  uint64_t _bdp_bytes               = 0;     ///< DATA bytes received since the BDP PING was sent.
+  HdrHeap *_hdr_heap_pool[HDR_HEAP_POOL_SIZE] = {nullptr};
+  int _hdr_heap_pool_count                    = 0;
   bool fini_received                = false;
   int recursion                     = 0;
   Http2ShutdownState shutdown_state = HTTP2_SHUTDOWN_NONE;
@@ -0,0 +1,1623 @@
+/** @file
+
+  Http2ServerSession, HTTP/2 connections to origin servers.
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ */
+
+#include <algorithm>
+
+#include "P_Net.h"
+#include "Http2ServerSession.h"
+#include "Http2ClientSession.h"
+
+#define Http2SsDebug(fmt, ...) Debug("http2_ss", "[%" PRId64 "] " fmt, this->con_id, ##__VA_ARGS__)
+#define Http2SsStreamDebug(session, id, fmt, ...) \
+  Debug("http2_ss", "[%" PRId64 "] [%u] " fmt, (session) ? (session)->con_id : -1, id, ##__VA_ARGS__)
+
+ClassAllocator<Http2ServerStream> http2ServerStreamAllocator("http2ServerStreamAllocator");
+
+namespace
+{
+using SessionPool = IntrusiveHashMap<Http2ServerSession::PoolLinkage>;
+
+const std::string_view HTTP2_ALPN_PROTOS{"\x02h2", 3};
+// How long an origin server that did not negotiate "h2" is sent HTTP/1.1 before it is tried again.
+constexpr ink_hrtime HTTP2_H1_ORIGIN_RETRY = HRTIME_MINUTES(5);
+// How long a GOAWAY is given to be written before the connection is closed anyway.
+constexpr ink_hrtime HTTP2_GOAWAY_FLUSH_TIMEOUT = HRTIME_SECONDS(5);
+constexpr Http2StreamId HTTP2_MAX_STREAM_ID     = 0x7FFFFFFF;
+
+int64_t next_con_id = 0;
+
+// The sessions and the origin servers known not to negotiate HTTP/2, of the current thread. Streams
+// run on the thread of their state machine so a session never has to take another thread's lock.
+thread_local SessionPool session_pool;
+thread_local std::unordered_map<uint64_t, ink_hrtime> h1_origins;
+} // namespace
+
+//
+// Http2ServerStream
+//
+
+void
+Http2ServerStream::init(Http2ServerSession *ssn, Continuation *cont)
+{
+  session     = ssn;
+  mutex       = ssn->mutex;
+  open_action = cont;
+  request_header.create(HTTP_TYPE_REQUEST);
+  http_parser_init(&parser);
+  response_buffer = new_MIOBuffer(BUFFER_SIZE_INDEX_4K);
+  response_reader = response_buffer->alloc_reader();
+  local_window    = Http2::initial_window_size;
+
+  ats_ip_copy(&remote_addr, &ssn->server_addr);
+  got_remote_addr = true;
+
+  SET_HANDLER(&Http2ServerStream::main_event_handler);
+  HTTP2_INCREMENT_THREAD_DYN_STAT(HTTP2_STAT_CURRENT_SERVER_STREAM_COUNT, this_ethread());
+  HTTP2_INCREMENT_THREAD_DYN_STAT(HTTP2_STAT_TOTAL_SERVER_STREAM_COUNT, this_ethread());
+}
+
+void
+Http2ServerStream::destroy()
+{
+  Http2SsStreamDebug(session, id, "Destroy stream");
+
+  for (Event **e : {&open_event, &read_event, &write_event, &active_event, &inactive_event}) {
+    if (*e) {
+      (*e)->cancel();
+      *e = nullptr;
+    }
+  }
+  if (session) {
+    session->detach(this);
+    session = nullptr;
+  }
+
+  request_header.destroy();
+  http_parser_clear(&parser);
+  free_MIOBuffer(response_buffer);
+  response_buffer = nullptr;
+  response_reader = nullptr;
+
+  HTTP2_DECREMENT_THREAD_DYN_STAT(HTTP2_STAT_CURRENT_SERVER_STREAM_COUNT, this_ethread());
+
+  // The allocator does not run destructors, drop the references.
+  read_vio.mutex.clear();
+  write_vio.mutex.clear();
+  open_action.mutex.clear();
+  mutex.clear();
+  http2ServerStreamAllocator.free(this);
+}
+
+int
+Http2ServerStream::main_event_handler(int event, void *edata)
+{
+  Event *e = static_cast<Event *>(edata);
+  ++reentrancy_count;
+
+  if (e == open_event) {
+    open_event = nullptr;
+    if (open_action.cancelled) {
+      // The state machine is gone, no one will close the stream.
+      closed = true;
+    } else {
+      MUTEX_TRY_LOCK(lock, open_action.mutex, this_ethread());
+      if (!lock.is_locked()) {
+        open_event = this_ethread()->schedule_in(this, HRTIME_MSECONDS(10), event);
+      } else if (event == NET_EVENT_OPEN) {
+        opened = true;
+        if (session && session->server_vc) {
+          ats_ip_copy(&local_addr, session->server_vc->get_local_addr());
+          got_local_addr = true;
+        }
+        open_action.continuation->handleEvent(NET_EVENT_OPEN, this);
+      } else {
+        closed = true;
+        open_action.continuation->handleEvent(NET_EVENT_OPEN_FAILED, reinterpret_cast<void *>(static_cast<intptr_t>(-open_errno)));
+      }
+    }
+  } else if (e == active_event) {
+    active_event = nullptr;
+    process_timeout(VC_EVENT_ACTIVE_TIMEOUT);
+  } else if (e == inactive_event) {
+    if (inactive_timeout_at && inactive_timeout_at < Thread::get_hrtime()) {
+      process_timeout(VC_EVENT_INACTIVITY_TIMEOUT);
+    }
+  } else if (e == read_event) {
+    read_event = nullptr;
+    process_read();
+  } else if (e == write_event) {
+    write_event = nullptr;
+    process_write();
+  }
+
+  if (--reentrancy_count == 0 && closed) {
+    destroy();
+  }
+  return 0;
+}
+
+void
+Http2ServerStream::open(int event, int lerrno)
+{
+  open_errno = lerrno;
+  if (open_event) {
+    open_event->cancel();
+  }
+  open_event = this_ethread()->schedule_imm(this, event);
+}
+
+void
+Http2ServerStream::signal_read()
+{
+  if (!read_event && !closed) {
+    read_event = this_ethread()->schedule_imm(this, VC_EVENT_READ_READY);
+  }
+}
+
+void
+Http2ServerStream::signal_write()
+{
+  if (!write_event && !closed) {
+    write_event = this_ethread()->schedule_imm(this, VC_EVENT_WRITE_READY);
+  }
+}
+
+bool
+Http2ServerStream::is_done() const
+{
+  return reset || (recv_end_stream && end_stream_sent);
+}
+
+void
+Http2ServerStream::process_read()
+{
+  if (closed || read_vio.op != VIO::READ || read_vio.cont == nullptr) {
+    return;
+  }
+
+  MUTEX_TRY_LOCK(lock, read_vio.mutex, this_ethread());
+  if (!lock.is_locked()) {
+    read_event = this_ethread()->schedule_in(this, HRTIME_MSECONDS(10), VC_EVENT_READ_READY);
+    return;
+  }
+
+  if (errored) {
+    read_vio.cont->handleEvent(VC_EVENT_ERROR, &read_vio);
+    return;
+  }
+
+  int64_t ntodo = read_vio.ntodo();
+  if (ntodo == 0) {
+    return;
+  }
+
+  int64_t avail = response_reader->read_avail();
+  if (avail == 0) {
+    if (recv_end_stream && !eos_sent) {
+      eos_sent = true;
+      read_vio.cont->handleEvent(VC_EVENT_EOS, &read_vio);
+    }
+    return;
+  }
+
+  // Flow control is what limits the buffering, move at most a window at a time.
+  MIOBuffer *writer  = read_vio.get_writer();
+  int64_t water_mark = std::max(writer->water_mark, static_cast<int64_t>(Http2::initial_window_size));
+  int64_t act_on     = std::min({avail, ntodo, water_mark - writer->max_read_avail()});
+  if (act_on <= 0) {
+    return;
+  }
+
+  writer->write(response_reader, act_on);
+  response_reader->consume(act_on);
+  read_vio.ndone += act_on;
+  if (inactive_timeout) {
+    inactive_timeout_at = Thread::get_hrtime() + inactive_timeout;
+  }
+
+  // Open the window again once half of it has been passed on.
+  unacked += act_on;
+  if (session && !recv_end_stream && !reset && unacked >= Http2::initial_window_size / 2) {
+    session->send_window_update(id, unacked);
+    local_window += unacked;
+    unacked = 0;
+  }
+
+  read_vio.cont->handleEvent(read_vio.ntodo() == 0 ? VC_EVENT_READ_COMPLETE : VC_EVENT_READ_READY, &read_vio);
+
+  // The state machine may not take it all, or call back in to read the rest.
+  if (!closed && recv_end_stream && !response_reader->is_read_avail_more_than(0)) {
+    signal_read();
+  }
+}
+
+void
+Http2ServerStream::process_write()
+{
+  if (closed || write_vio.op != VIO::WRITE || write_vio.cont == nullptr) {
+    return;
+  }
+
+  MUTEX_TRY_LOCK(lock, write_vio.mutex, this_ethread());
+  if (!lock.is_locked()) {
+    write_event = this_ethread()->schedule_in(this, HRTIME_MSECONDS(10), VC_EVENT_WRITE_READY);
+    return;
+  }
+
+  if (errored) {
+    // A read request gets the error if there is one.
+    if (read_vio.op != VIO::READ || read_vio.cont == nullptr) {
+      write_vio.cont->handleEvent(VC_EVENT_ERROR, &write_vio);
+    }
+    return;
+  }
+
+  IOBufferReader *reader = write_vio.get_reader();
+  int64_t ndone          = write_vio.ndone;
+
+  if (!header_parsed) {
+    if (write_vio.ntodo() == 0 || !reader->is_read_avail_more_than(0)) {
+      // Nothing to send yet, the state machine writes nothing to learn the connection is up.
+      if (!ready_sent) {
+        ready_sent = true;
+        write_vio.cont->handleEvent(VC_EVENT_WRITE_READY, &write_vio);
+      }
+      return;
+    }
+    int bytes_used     = 0;
+    ParseResult result = request_header.parse_req(&parser, reader, &bytes_used, false);
+    write_vio.ndone += bytes_used;
+    if (result == PARSE_RESULT_ERROR) {
+      Http2SsStreamDebug(session, id, "Request header parse failure");
+      errored = true;
+      write_vio.cont->handleEvent(VC_EVENT_ERROR, &write_vio);
+      return;
+    }
+    if (result == PARSE_RESULT_DONE) {
+      header_parsed = true;
+      if (request_header.presence(MIME_PRESENCE_TRANSFER_ENCODING)) {
+        // The state machine only sends requests with a known length over HTTP/2.
+        Http2SsStreamDebug(session, id, "Request body without a length");
+        errored = true;
+        write_vio.cont->handleEvent(VC_EVENT_ERROR, &write_vio);
+        return;
+      }
+      body_left = std::max(request_header.get_content_length(), static_cast<int64_t>(0));
+    }
+  }
+
+  if (header_parsed && !headers_sent && session) {
+    if (!session->send_headers(this, body_left == 0)) {
+      if (errored) {
+        write_vio.cont->handleEvent(VC_EVENT_ERROR, &write_vio);
+      }
+      // Otherwise waiting for the origin server to allow another stream.
+      return;
+    }
+    headers_sent    = true;
+    end_stream_sent = body_left == 0;
+  }
+
+  if (headers_sent && !end_stream_sent) {
+    int64_t len = std::min({reader->read_avail(), write_vio.ntodo(), body_left});
+    if (reset) {
+      // The origin server does not want the rest of the body.
+      reader->consume(len);
+      write_vio.ndone += len;
+      body_left -= len;
+    } else if (session && len > 0) {
+      int64_t sent = session->send_data(this, reader, len, len == body_left);
+      write_vio.ndone += sent;
+      body_left -= sent;
+      end_stream_sent = body_left == 0;
+    }
+  }
+
+  if (session && end_stream_sent && is_done()) {
+    session->stream_done(this);
+  }
+
+  if (write_vio.ndone != ndone) {
+    if (inactive_timeout) {
+      inactive_timeout_at = Thread::get_hrtime() + inactive_timeout;
+    }
+    write_vio.cont->handleEvent(write_vio.ntodo() == 0 ? VC_EVENT_WRITE_COMPLETE : VC_EVENT_WRITE_READY, &write_vio);
+  }
+}
+
+void
+Http2ServerStream::process_timeout(int event)
+{
+  VIO *vio = nullptr;
+  if (read_vio.op == VIO::READ && read_vio.cont && read_vio.ntodo() > 0) {
+    vio = &read_vio;
+  } else if (write_vio.op == VIO::WRITE && write_vio.cont && write_vio.ntodo() > 0) {
+    vio = &write_vio;
+  }
+  if (vio == nullptr) {
+    return;
+  }
+  if (event == VC_EVENT_INACTIVITY_TIMEOUT) {
+    inactive_timeout_at = 0;
+  }
+
+  MUTEX_TRY_LOCK(lock, vio->mutex, this_ethread());
+  if (lock.is_locked()) {
+    vio->cont->handleEvent(event, vio);
+  } else {
+    this_ethread()->schedule_imm(vio->cont, event, vio);
+  }
+}
+
+bool
+Http2ServerStream::recv_headers(HTTPHdr *hdr, bool end_stream)
+{
+  if (response_started) {
+    // Trailers are not passed on, an HTTP/1.1 response has nowhere to put them.
+    if (!end_stream) {
+      return false;
+    }
+    recv_end_stream = true;
+    signal_read();
+    return true;
+  }
+
+  if (http2_convert_header_from_2_to_1_1(hdr) != PARSE_RESULT_DONE) {
+    return false;
+  }
+
+  HTTPStatus status = hdr->status_get();
+  if (status < 100 || (status < 200 && end_stream)) {
+    return false;
+  }
+  response_started = status >= 200;
+
+  const char *reason = http_hdr_reason_lookup(status);
+  hdr->reason_set(reason, strlen(reason));
+  hdr->value_set(MIME_FIELD_CONNECTION, MIME_LEN_CONNECTION, "close", 5);
+
+  int bufindex;
+  int dumpoffset = 0;
+  int done, tmp;
+  do {
+    bufindex             = 0;
+    tmp                  = dumpoffset;
+    IOBufferBlock *block = response_buffer->get_current_block();
+    if (!block || block->write_avail() == 0) {
+      response_buffer->add_block();
+      block = response_buffer->get_current_block();
+    }
+    done = hdr->print(block->end(), block->write_avail(), &bufindex, &tmp);
+    dumpoffset += bufindex;
+    response_buffer->fill(bufindex);
+    if (!done) {
+      response_buffer->add_block();
+    }
+  } while (!done);
+
+  recv_end_stream = end_stream;
+  signal_read();
+  return true;
+}
+
+bool
+Http2ServerStream::recv_data(IOBufferReader *reader, int64_t len, int64_t offset, bool end_stream)
+{
+  if (!response_started || recv_end_stream) {
+    return false;
+  }
+  response_buffer->write(reader, len, offset);
+  recv_end_stream = end_stream;
+  signal_read();
+  return true;
+}
+
+void
+Http2ServerStream::recv_rst_stream(Http2ErrorCode code)
+{
+  Http2SsStreamDebug(session, id, "Stream reset, error code %u", static_cast<unsigned>(code));
+  reset = true;
+  // A complete response may be followed by NO_ERROR to stop the request body.
+  if (!(recv_end_stream && code == Http2ErrorCode::HTTP2_ERROR_NO_ERROR)) {
+    errored = true;
+  }
+  signal_read();
+  signal_write();
+}
+
+void
+Http2ServerStream::session_closed(int lerrno)
+{
+  session = nullptr;
+  if (!opened) {
+    open(NET_EVENT_OPEN_FAILED, lerrno);
+    return;
+  }
+  if (!(recv_end_stream && (end_stream_sent || reset))) {
+    errored = true;
+  }
+  reset = true;
+  signal_read();
+  signal_write();
+}
+
+VIO *
+Http2ServerStream::do_io_read(Continuation *c, int64_t nbytes, MIOBuffer *buf)
+{
+  if (buf) {
+    read_vio.buffer.writer_for(buf);
+  } else {
+    read_vio.buffer.clear();
+  }
+
+  read_vio.mutex     = c ? c->mutex : this->mutex;
+  read_vio.cont      = c;
+  read_vio.nbytes    = nbytes;
+  read_vio.ndone     = 0;
+  read_vio.vc_server = this;
+  read_vio.op        = c ? VIO::READ : VIO::NONE;
+  eos_sent           = false;
+
+  if (c && buf && nbytes > 0) {
+    signal_read();
+  }
+  return &read_vio;
+}
+
+VIO *
+Http2ServerStream::do_io_write(Continuation *c, int64_t nbytes, IOBufferReader *abuffer, bool owner)
+{
+  if (abuffer) {
+    write_vio.buffer.reader_for(abuffer);
+  } else {
+    write_vio.buffer.clear();
+  }
+
+  write_vio.mutex     = c ? c->mutex : this->mutex;
+  write_vio.cont      = c;
+  write_vio.nbytes    = nbytes;
+  write_vio.ndone     = 0;
+  write_vio.vc_server = this;
+  write_vio.op        = c ? VIO::WRITE : VIO::NONE;
+
+  if (c && abuffer) {
+    signal_write();
+  }
+  return &write_vio;
+}
+
+void
+Http2ServerStream::do_io_close(int /* lerrno ATS_UNUSED */)
+{
+  if (closed) {
+    return;
+  }
+  Http2SsStreamDebug(session, id, "Close stream");
+  closed = true;
+
+  if (session) {
+    if (headers_sent && !is_done()) {
+      session->send_rst_stream(id, Http2ErrorCode::HTTP2_ERROR_CANCEL);
+    }
+    if (session) {
+      session->detach(this);
+      session = nullptr;
+    }
+  }
+
+  read_vio.op    = VIO::NONE;
+  read_vio.cont  = nullptr;
+  write_vio.op   = VIO::NONE;
+  write_vio.cont = nullptr;
+
+  if (reentrancy_count == 0) {
+    destroy();
+  }
+}
+
+void
+Http2ServerStream::do_io_shutdown(ShutdownHowTo_t howto)
+{
+  if (howto == IO_SHUTDOWN_READ || howto == IO_SHUTDOWN_READWRITE) {
+    read_vio.op   = VIO::NONE;
+    read_vio.cont = nullptr;
+  }
+  if (howto == IO_SHUTDOWN_WRITE || howto == IO_SHUTDOWN_READWRITE) {
+    write_vio.op   = VIO::NONE;
+    write_vio.cont = nullptr;
+  }
+}
+
+void
+Http2ServerStream::reenable(VIO *vio)
+{
+  if (vio == &read_vio) {
+    signal_read();
+  } else if (vio == &write_vio) {
+    signal_write();
+  }
+}
+
+void
+Http2ServerStream::reenable_re(VIO *vio)
+{
+  reenable(vio);
+}
+
+void
+Http2ServerStream::set_active_timeout(ink_hrtime timeout_in)
+{
+  active_timeout = timeout_in;
+  cancel_active_timeout();
+  active_timeout = timeout_in;
+  if (active_timeout > 0) {
+    active_event = this_ethread()->schedule_in(this, active_timeout);
+  }
+}
+
+void
+Http2ServerStream::set_inactivity_timeout(ink_hrtime timeout_in)
+{
+  inactive_timeout = timeout_in;
+  if (inactive_timeout > 0) {
+    inactive_timeout_at = Thread::get_hrtime() + inactive_timeout;
+    if (!inactive_event) {
+      inactive_event = this_ethread()->schedule_every(this, HRTIME_SECONDS(1));
+    }
+  } else {
+    cancel_inactivity_timeout();
+  }
+}
+
+void
+Http2ServerStream::cancel_active_timeout()
+{
+  active_timeout = 0;
+  if (active_event) {
+    active_event->cancel();
+    active_event = nullptr;
+  }
+}
+
+void
+Http2ServerStream::cancel_inactivity_timeout()
+{
+  inactive_timeout    = 0;
+  inactive_timeout_at = 0;
+  if (inactive_event) {
+    inactive_event->cancel();
+    inactive_event = nullptr;
+  }
+}
+
+ink_hrtime
+Http2ServerStream::get_active_timeout()
+{
+  return active_timeout;
+}
+
+ink_hrtime
+Http2ServerStream::get_inactivity_timeout()
+{
+  return inactive_timeout;
+}
+
+void
+Http2ServerStream::add_to_keep_alive_queue()
+{
+  // do nothing
+}
+
+void
+Http2ServerStream::remove_from_keep_alive_queue()
+{
+  // do nothing
+}
+
+bool
+Http2ServerStream::add_to_active_queue()
+{
+  // do nothing
+  return true;
+}
+
+SOCKET
+Http2ServerStream::get_socket()
+{
+  // The socket is shared, there is none of our own.
+  return ts::NO_FD;
+}
+
+void
+Http2ServerStream::set_local_addr()
+{
+  // Set when the stream is opened.
+}
+
+void
+Http2ServerStream::set_remote_addr()
+{
+  // Set when the stream is created.
+}
+
+void
+Http2ServerStream::set_remote_addr(const sockaddr * /* new_sa ATS_UNUSED */)
+{
+  return;
+}
+
+void
+Http2ServerStream::set_mptcp_state()
+{
+  return;
+}
+
+int
+Http2ServerStream::set_tcp_congestion_control(int ATS_UNUSED)
+{
+  return -1;
+}
+
+void
+Http2ServerStream::apply_options()
+{
+  // do nothing
+}
+
+int
+Http2ServerStream::populate_protocol(std::string_view *result, int size) const
+{
+  int retval = 0;
+  if (size > retval) {
+    result[retval++] = IP_PROTO_TAG_HTTP_2_0;
+    if (size > retval && session && session->server_vc) {
+      retval += session->server_vc->populate_protocol(result + retval, size - retval);
+    }
+  }
+  return retval;
+}
+
+const char *
+Http2ServerStream::protocol_contains(std::string_view prefix) const
+{
+  if (prefix.size() <= IP_PROTO_TAG_HTTP_2_0.size() && strncmp(IP_PROTO_TAG_HTTP_2_0.data(), prefix.data(), prefix.size()) == 0) {
+    return IP_PROTO_TAG_HTTP_2_0.data();
+  }
+  return session && session->server_vc ? session->server_vc->protocol_contains(prefix) : nullptr;
+}
+
+//
+// Http2ServerSession
+//
+
+Action *
+Http2ServerSession::connect_re(Continuation *cont, sockaddr const *addr, NetVCOptions const &opt, ink_hrtime idle_timeout)
+{
+  // Sessions are shared by the requests to the same address that would get the same TLS session.
+  CryptoHash key;
+  CryptoContext ctx;
+  ctx.update(ats_ip_addr8_cast(addr), ats_ip_addr_size(addr));
+  ctx.update(&ats_ip_port_cast(addr), sizeof(in_port_t));
+  const char *names[] = {opt.sni_servername.get(), opt.ssl_servername.get(), opt.ssl_client_cert_name,
+                         opt.ssl_client_private_key_name, opt.ssl_client_ca_cert_name};
+  for (const char *name : names) {
+    // With the terminating nul so adjacent names can not run together.
+    ctx.update(name ? name : "", name ? strlen(name) + 1 : 1);
+  }
+  ctx.finalize(key);
+
+  if (auto spot = h1_origins.find(key.fold()); spot != h1_origins.end()) {
+    if (Thread::get_hrtime() < spot->second) {
+      return nullptr;
+    }
+    h1_origins.erase(spot);
+  }
+
+  Http2ServerSession *session = nullptr;
+  auto range                  = session_pool.equal_range(key);
+  for (auto spot = range.first; spot != range.second; ++spot) {
+    if (spot->available()) {
+      session = &*spot;
+      break;
+    }
+  }
+
+  Http2ServerStream *stream;
+  if (session) {
+    SCOPED_MUTEX_LOCK(lock, session->mutex, this_ethread());
+    stream = session->new_stream(cont);
+    if (session->state == State::OPEN) {
+      stream->open(NET_EVENT_OPEN);
+    }
+  } else {
+    session          = new Http2ServerSession(key, addr, idle_timeout);
+    session->options = opt;
+    SCOPED_MUTEX_LOCK(lock, session->mutex, this_ethread());
+    stream = session->new_stream(cont);
+    session->start();
+  }
+  Http2SsStreamDebug(session, 0, "Stream for %s", cont ? "state machine" : "none");
+  return &stream->open_action;
+}
+
+Http2ServerSession::Http2ServerSession(CryptoHash const &k, sockaddr const *addr, ink_hrtime timeout)
+  : Continuation(new_ProxyMutex()), key(k), idle_timeout(timeout)
+{
+  ats_ip_copy(&server_addr, addr);
+  con_id = ink_atomic_increment(&next_con_id, 1);
+  HTTP2_INCREMENT_THREAD_DYN_STAT(HTTP2_STAT_CURRENT_SERVER_SESSION_COUNT, this_ethread());
+  HTTP2_INCREMENT_THREAD_DYN_STAT(HTTP2_STAT_TOTAL_SERVER_SESSION_COUNT, this_ethread());
+}
+
+Http2ServerSession::~Http2ServerSession()
+{
+  Http2SsDebug("Session destroyed");
+  if (read_buffer) {
+    free_MIOBuffer(read_buffer);
+  }
+  if (write_buffer) {
+    free_MIOBuffer(write_buffer);
+  }
+  HTTP2_DECREMENT_THREAD_DYN_STAT(HTTP2_STAT_CURRENT_SERVER_SESSION_COUNT, this_ethread());
+}
+
+bool
+Http2ServerSession::available() const
+{
+  if (state > State::OPEN || going_away || stream_count >= Http2::max_concurrent_streams_out) {
+    return false;
+  }
+  return !peer_settings_received || stream_count < peer_settings.get(HTTP2_SETTINGS_MAX_CONCURRENT_STREAMS);
+}
+
+Http2ServerStream *
+Http2ServerSession::new_stream(Continuation *cont)
+{
+  Http2ServerStream *stream = http2ServerStreamAllocator.alloc();
+  stream->init(this, cont);
+  streams.push(stream);
+  ++stream_count;
+  if (idle_event && state == State::OPEN) {
+    idle_event->cancel();
+    idle_event = nullptr;
+  }
+  return stream;
+}
+
+void
+Http2ServerSession::detach(Http2ServerStream *stream)
+{
+  stream_done(stream);
+  if (auto spot = std::find(blocked.begin(), blocked.end(), stream); spot != blocked.end()) {
+    blocked.erase(spot);
+  }
+  streams.remove(stream);
+  --stream_count;
+
+  if (stream_count == 0 && state == State::OPEN) {
+    if (going_away) {
+      close(ECONNRESET);
+    } else {
+      schedule_idle();
+    }
+  }
+}
+
+void
+Http2ServerSession::stream_done(Http2ServerStream *stream)
+{
+  if (stream->id == 0 || active.erase(stream->id) == 0) {
+    return;
+  }
+  // That may be room for a waiting stream.
+  while (!blocked.empty() && active.size() < peer_settings.get(HTTP2_SETTINGS_MAX_CONCURRENT_STREAMS)) {
+    Http2ServerStream *next = blocked.front();
+    blocked.pop_front();
+    next->signal_write();
+  }
+}
+
+void
+Http2ServerSession::start()
+{
+  Http2SsDebug("Connecting");
+  session_pool.insert(this);
+  in_pool = true;
+
+  SET_HANDLER(&Http2ServerSession::state_connecting);
+  options.alpn_protos = HTTP2_ALPN_PROTOS;
+  Action *action      = sslNetProcessor.connect_re(this, &server_addr.sa, &options);
+  if (action != ACTION_RESULT_DONE && state == State::CONNECTING && server_vc == nullptr) {
+    connect_action = action;
+  }
+}
+
+int
+Http2ServerSession::state_connecting(int event, void *edata)
+{
+  switch (event) {
+  case NET_EVENT_OPEN: {
+    connect_action = nullptr;
+    server_vc      = static_cast<NetVConnection *>(edata);
+    SET_HANDLER(&Http2ServerSession::main_event_handler);
+
+    read_buffer  = new_MIOBuffer(HTTP2_HEADER_BUFFER_SIZE_INDEX);
+    read_reader  = read_buffer->alloc_reader();
+    write_buffer = new_MIOBuffer(HTTP2_HEADER_BUFFER_SIZE_INDEX);
+    write_reader = write_buffer->alloc_reader();
+    read_vio     = server_vc->do_io_read(this, INT64_MAX, read_buffer);
+    write_vio    = server_vc->do_io_write(this, 0, write_reader);
+
+    // The preface goes out as soon as the TLS handshake is done, the origin server does not wait
+    // for it to send its own SETTINGS.
+    write_buffer->write(HTTP2_CONNECTION_PREFACE, HTTP2_CONNECTION_PREFACE_LEN);
+    total_write_len += HTTP2_CONNECTION_PREFACE_LEN;
+
+    Http2ConnectionSettings defaults, settings;
+    settings.settings_from_configs();
+    settings.set(HTTP2_SETTINGS_ENABLE_PUSH, 0);
+    settings.set(HTTP2_SETTINGS_MAX_CONCURRENT_STREAMS, HTTP2_MAX_CONCURRENT_STREAMS);
+
+    Http2Frame frame(HTTP2_FRAME_TYPE_SETTINGS, 0, 0);
+    frame.alloc(BUFFER_SIZE_INDEX_128);
+    IOVec iov       = frame.write();
+    uint32_t length = 0;
+    for (int i = HTTP2_SETTINGS_HEADER_TABLE_SIZE; i < HTTP2_SETTINGS_MAX; ++i) {
+      Http2SettingsIdentifier id = static_cast<Http2SettingsIdentifier>(i);
+      if (settings.get(id) != defaults.get(id)) {
+        http2_write_settings({static_cast<uint16_t>(id), settings.get(id)}, iov);
+        iov.iov_base = reinterpret_cast<uint8_t *>(iov.iov_base) + HTTP2_SETTINGS_PARAMETER_LEN;
+        iov.iov_len -= HTTP2_SETTINGS_PARAMETER_LEN;
+        length += HTTP2_SETTINGS_PARAMETER_LEN;
+      }
+    }
+    frame.finalize(length);
+    xmit(frame);
+
+    // The stream windows limit what is buffered, open the connection window all the way.
+    send_window_update(0, HTTP2_MAX_WINDOW_SIZE - HTTP2_INITIAL_WINDOW_SIZE);
+    break;
+  }
+
+  case NET_EVENT_OPEN_FAILED:
+    connect_action = nullptr;
+    Http2SsDebug("Connect failed");
+    close(-static_cast<int>(reinterpret_cast<intptr_t>(edata)));
+    break;
+
+  case HTTP2_SESSION_EVENT_FINI:
+    delete this;
+    break;
+
+  default:
+    ink_assert(!"unexpected event");
+    break;
+  }
+  return 0;
+}
+
+int
+Http2ServerSession::main_event_handler(int event, void *edata)
+{
+  switch (event) {
+  case VC_EVENT_READ_READY:
+  case VC_EVENT_READ_COMPLETE:
+    if (!alpn_checked) {
+      alpn_checked              = true;
+      SSLNetVConnection *ssl_vc = dynamic_cast<SSLNetVConnection *>(server_vc);
+      if (!ssl_vc || ssl_vc->get_alpn_selected() != "h2") {
+        Http2SsDebug("The origin server did not negotiate h2, using HTTP/1.1 for a while");
+        h1_origins[key.fold()] = Thread::get_hrtime() + HTTP2_H1_ORIGIN_RETRY;
+        close(EPROTO);
+        break;
+      }
+    }
+    read_frames();
+    break;
+
+  case VC_EVENT_WRITE_READY:
+    break;
+
+  case VC_EVENT_WRITE_COMPLETE:
+    if (state == State::CLOSING) {
+      close(ECONNRESET);
+    }
+    break;
+
+  case VC_EVENT_EOS:
+  case VC_EVENT_ERROR:
+  case VC_EVENT_ACTIVE_TIMEOUT:
+  case VC_EVENT_INACTIVITY_TIMEOUT:
+    Http2SsDebug("Connection closed, event %d", event);
+    close(ECONNRESET);
+    break;
+
+  case EVENT_INTERVAL:
+    if (edata == idle_event) {
+      idle_event = nullptr;
+      if (state == State::CLOSING) {
+        close(ECONNRESET);
+      } else if (stream_count == 0) {
+        Http2SsDebug("Idle, closing");
+        connection_error(Http2ErrorCode::HTTP2_ERROR_NO_ERROR);
+      }
+    }
+    break;
+
+  case HTTP2_SESSION_EVENT_FINI:
+    delete this;
+    break;
+
+  default:
+    break;
+  }
+  return 0;
+}
+
+void
+Http2ServerSession::read_frames()
+{
+  while (state < State::CLOSING) {
+    if (!current_hdr_read) {
+      if (read_reader->read_avail() < static_cast<int64_t>(HTTP2_FRAME_HEADER_LEN)) {
+        break;
+      }
+      uint8_t buf[HTTP2_FRAME_HEADER_LEN];
+      read_reader->memcpy(buf, sizeof(buf));
+      read_reader->consume(sizeof(buf));
+      http2_parse_frame_header(make_iovec(buf), current_hdr);
+      current_hdr_read = true;
+
+      if (current_hdr.length > Http2::max_frame_size) {
+        connection_error(Http2ErrorCode::HTTP2_ERROR_FRAME_SIZE_ERROR);
+        return;
+      }
+      if (!http2_frame_header_is_valid(current_hdr, Http2::max_frame_size) ||
+          (!peer_settings_received && current_hdr.type != HTTP2_FRAME_TYPE_SETTINGS) ||
+          (continued_stream_id != 0 &&
+           (current_hdr.type != HTTP2_FRAME_TYPE_CONTINUATION || current_hdr.streamid != continued_stream_id))) {
+        connection_error(Http2ErrorCode::HTTP2_ERROR_PROTOCOL_ERROR);
+        return;
+      }
+    }
+    if (read_reader->read_avail() < current_hdr.length) {
+      break;
+    }
+    current_hdr_read = false;
+
+    Http2Error error = process_frame();
+    read_reader->consume(current_hdr.length);
+
+    if (error.cls == Http2ErrorClass::HTTP2_ERROR_CLASS_CONNECTION) {
+      Http2SsDebug("Connection error %u: %s", static_cast<unsigned>(error.code), error.msg);
+      connection_error(error.code);
+      return;
+    } else if (error.cls == Http2ErrorClass::HTTP2_ERROR_CLASS_STREAM) {
+      Http2SsDebug("Stream %u error %u: %s", current_hdr.streamid, static_cast<unsigned>(error.code), error.msg);
+      send_rst_stream(current_hdr.streamid, error.code);
+      if (auto spot = active.find(current_hdr.streamid); spot != active.end()) {
+        Http2ServerStream *stream = spot->second;
+        stream->recv_rst_stream(error.code);
+        stream->errored = true;
+        stream_done(stream);
+      }
+    }
+  }
+
+  if (read_vio && state < State::CLOSING) {
+    read_vio->reenable();
+  }
+}
+
+Http2Error
+Http2ServerSession::process_frame()
+{
+  switch (current_hdr.type) {
+  case HTTP2_FRAME_TYPE_DATA:
+    return recv_data_frame();
+  case HTTP2_FRAME_TYPE_HEADERS:
+  case HTTP2_FRAME_TYPE_CONTINUATION:
+    return recv_headers_frame();
+  case HTTP2_FRAME_TYPE_RST_STREAM:
+    return recv_rst_stream_frame();
+  case HTTP2_FRAME_TYPE_SETTINGS:
+    return recv_settings_frame();
+  case HTTP2_FRAME_TYPE_PING:
+    return recv_ping_frame();
+  case HTTP2_FRAME_TYPE_GOAWAY:
+    return recv_goaway_frame();
+  case HTTP2_FRAME_TYPE_WINDOW_UPDATE:
+    return recv_window_update_frame();
+  case HTTP2_FRAME_TYPE_PUSH_PROMISE:
+    // SETTINGS_ENABLE_PUSH is 0.
+    return Http2Error(Http2ErrorClass::HTTP2_ERROR_CLASS_CONNECTION, Http2ErrorCode::HTTP2_ERROR_PROTOCOL_ERROR,
+                      "push promise received");
+  default:
+    // PRIORITY is advisory and unknown types are ignored.
+    return Http2Error();
+  }
+}
+
+Http2Error
+Http2ServerSession::recv_data_frame()
+{
+  const Http2StreamId id = current_hdr.streamid;
+  const uint32_t length  = current_hdr.length;
+  uint32_t offset        = 0;
+  uint32_t pad_length    = 0;
+
+  if (current_hdr.flags & HTTP2_FLAGS_DATA_PADDED) {
+    uint8_t pad;
+    if (length < HTTP2_DATA_PADLEN_LEN) {
+      return Http2Error(Http2ErrorClass::HTTP2_ERROR_CLASS_CONNECTION, Http2ErrorCode::HTTP2_ERROR_PROTOCOL_ERROR, "bad padding");
+    }
+    read_reader->memcpy(&pad, sizeof(pad));
+    offset     = HTTP2_DATA_PADLEN_LEN;
+    pad_length = pad;
+    if (offset + pad_length > length) {
+      return Http2Error(Http2ErrorClass::HTTP2_ERROR_CLASS_CONNECTION, Http2ErrorCode::HTTP2_ERROR_PROTOCOL_ERROR, "bad padding");
+    }
+  }
+
+  conn_unacked += length;
+  if (conn_unacked >= static_cast<uint32_t>(HTTP2_MAX_WINDOW_SIZE / 2)) {
+    send_window_update(0, conn_unacked);
+    conn_unacked = 0;
+  }
+
+  auto spot = active.find(id);
+  if (spot == active.end()) {
+    if (id >= next_stream_id) {
+      return Http2Error(Http2ErrorClass::HTTP2_ERROR_CLASS_CONNECTION, Http2ErrorCode::HTTP2_ERROR_PROTOCOL_ERROR,
+                        "data on idle stream");
+    }
+    // A stream we have closed, the data was in flight.
+    return Http2Error();
+  }
+
+  Http2ServerStream *stream = spot->second;
+  if (static_cast<Http2WindowSize>(length) > stream->local_window) {
+    return Http2Error(Http2ErrorClass::HTTP2_ERROR_CLASS_STREAM, Http2ErrorCode::HTTP2_ERROR_FLOW_CONTROL_ERROR,
+                      "window exceeded");
+  }
+  stream->local_window -= length;
+  stream->unacked += offset + pad_length;
+
+  bool end_stream = current_hdr.flags & HTTP2_FLAGS_DATA_END_STREAM;
+  if (!stream->recv_data(read_reader, length - offset - pad_length, offset, end_stream)) {
+    return Http2Error(Http2ErrorClass::HTTP2_ERROR_CLASS_STREAM, Http2ErrorCode::HTTP2_ERROR_PROTOCOL_ERROR, "unexpected data");
+  }
+  if (stream->is_done()) {
+    stream_done(stream);
+  }
+  return Http2Error();
+}
+
+Http2Error
+Http2ServerSession::recv_headers_frame()
+{
+  const Http2StreamId id = current_hdr.streamid;
+  uint32_t offset        = 0;
+  uint32_t pad_length    = 0;
+
+  if (id == 0) {
+    return Http2Error(Http2ErrorClass::HTTP2_ERROR_CLASS_CONNECTION, Http2ErrorCode::HTTP2_ERROR_PROTOCOL_ERROR,
+                      "headers on stream 0");
+  }
+
+  if (current_hdr.type == HTTP2_FRAME_TYPE_HEADERS) {
+    if (continued_stream_id != 0 || (active.find(id) == active.end() && id >= next_stream_id)) {
+      return Http2Error(Http2ErrorClass::HTTP2_ERROR_CLASS_CONNECTION, Http2ErrorCode::HTTP2_ERROR_PROTOCOL_ERROR,
+                        "unexpected headers");
+    }
+    if (current_hdr.flags & HTTP2_FLAGS_HEADERS_PADDED) {
+      uint8_t pad;
+      if (current_hdr.length < HTTP2_HEADERS_PADLEN_LEN) {
+        return Http2Error(Http2ErrorClass::HTTP2_ERROR_CLASS_CONNECTION, Http2ErrorCode::HTTP2_ERROR_PROTOCOL_ERROR,
+                          "bad padding");
+      }
+      read_reader->memcpy(&pad, sizeof(pad));
+      offset     = HTTP2_HEADERS_PADLEN_LEN;
+      pad_length = pad;
+    }
+    if (current_hdr.flags & HTTP2_FLAGS_HEADERS_PRIORITY) {
+      offset += HTTP2_PRIORITY_LEN;
+    }
+    if (offset + pad_length > current_hdr.length) {
+      return Http2Error(Http2ErrorClass::HTTP2_ERROR_CLASS_CONNECTION, Http2ErrorCode::HTTP2_ERROR_PROTOCOL_ERROR,
+                        "bad padding");
+    }
+    continued_stream_id  = id;
+    continued_end_stream = current_hdr.flags & HTTP2_FLAGS_HEADERS_END_STREAM;
+    header_block.clear();
+  } else if (continued_stream_id == 0) {
+    return Http2Error(Http2ErrorClass::HTTP2_ERROR_CLASS_CONNECTION, Http2ErrorCode::HTTP2_ERROR_PROTOCOL_ERROR,
+                      "unexpected continuation");
+  }
+
+  size_t fragment = current_hdr.length - offset - pad_length;
+  size_t size     = header_block.size();
+  if (size + fragment > Http2::max_header_list_size) {
+    return Http2Error(Http2ErrorClass::HTTP2_ERROR_CLASS_CONNECTION, Http2ErrorCode::HTTP2_ERROR_ENHANCE_YOUR_CALM,
+                      "header block too large");
+  }
+  header_block.resize(size + fragment);
+  read_reader->memcpy(header_block.data() + size, fragment, offset);
+
+  // HEADERS_END_HEADERS and CONTINUATION_END_HEADERS are the same flag.
+  if (current_hdr.flags & HTTP2_FLAGS_HEADERS_END_HEADERS) {
+    return decode_headers();
+  }
+  return Http2Error();
+}
+
+Http2Error
+Http2ServerSession::decode_headers()
+{
+  Http2StreamId id    = continued_stream_id;
+  continued_stream_id = 0;
+
+  // Every header block is decoded to keep the table in step, even for a stream that is gone.
+  HTTPHdr hdr;
+  hdr.create(HTTP_TYPE_RESPONSE);
+  int64_t result = hpack_decode_header_block(hpack_decoder, &hdr, reinterpret_cast<const uint8_t *>(header_block.data()),
+                                             header_block.size(), Http2::max_header_list_size, Http2::header_table_size);
+  header_block.clear();
+  if (result < 0) {
+    hdr.destroy();
+    return Http2Error(Http2ErrorClass::HTTP2_ERROR_CLASS_CONNECTION,
+                      result == HPACK_ERROR_SIZE_EXCEEDED_ERROR ? Http2ErrorCode::HTTP2_ERROR_ENHANCE_YOUR_CALM :
+                                                                  Http2ErrorCode::HTTP2_ERROR_COMPRESSION_ERROR,
+                      "header block decode failure");
+  }
+
+  Http2Error error;
+  if (auto spot = active.find(id); spot != active.end()) {
+    Http2ServerStream *stream = spot->second;
+    if (!stream->recv_headers(&hdr, continued_end_stream)) {
+      error = Http2Error(Http2ErrorClass::HTTP2_ERROR_CLASS_STREAM, Http2ErrorCode::HTTP2_ERROR_PROTOCOL_ERROR, "bad response");
+    } else if (stream->is_done()) {
+      stream_done(stream);
+    }
+  }
+  hdr.destroy();
+  return error;
+}
+
+Http2Error
+Http2ServerSession::recv_rst_stream_frame()
+{
+  if (current_hdr.streamid == 0) {
+    return Http2Error(Http2ErrorClass::HTTP2_ERROR_CLASS_CONNECTION, Http2ErrorCode::HTTP2_ERROR_PROTOCOL_ERROR,
+                      "reset of stream 0");
+  }
+  if (current_hdr.length != HTTP2_RST_STREAM_LEN) {
+    return Http2Error(Http2ErrorClass::HTTP2_ERROR_CLASS_CONNECTION, Http2ErrorCode::HTTP2_ERROR_FRAME_SIZE_ERROR,
+                      "bad reset length");
+  }
+
+  uint8_t buf[HTTP2_RST_STREAM_LEN];
+  Http2RstStream rst_stream;
+  read_reader->memcpy(buf, sizeof(buf));
+  http2_parse_rst_stream(make_iovec(buf), rst_stream);
+
+  if (auto spot = active.find(current_hdr.streamid); spot != active.end()) {
+    Http2ServerStream *stream = spot->second;
+    stream->recv_rst_stream(static_cast<Http2ErrorCode>(rst_stream.error_code));
+    stream_done(stream);
+  } else if (current_hdr.streamid >= next_stream_id) {
+    return Http2Error(Http2ErrorClass::HTTP2_ERROR_CLASS_CONNECTION, Http2ErrorCode::HTTP2_ERROR_PROTOCOL_ERROR,
+                      "reset of idle stream");
+  }
+  return Http2Error();
+}
+
+Http2Error
+Http2ServerSession::recv_settings_frame()
+{
+  if (current_hdr.streamid != 0) {
+    return Http2Error(Http2ErrorClass::HTTP2_ERROR_CLASS_CONNECTION, Http2ErrorCode::HTTP2_ERROR_PROTOCOL_ERROR,
+                      "settings on a stream");
+  }
+  if (current_hdr.flags & HTTP2_FLAGS_SETTINGS_ACK) {
+    if (current_hdr.length != 0) {
+      return Http2Error(Http2ErrorClass::HTTP2_ERROR_CLASS_CONNECTION, Http2ErrorCode::HTTP2_ERROR_FRAME_SIZE_ERROR,
+                        "settings ack with payload");
+    }
+    return Http2Error();
+  }
+  if (current_hdr.length % HTTP2_SETTINGS_PARAMETER_LEN != 0) {
+    return Http2Error(Http2ErrorClass::HTTP2_ERROR_CLASS_CONNECTION, Http2ErrorCode::HTTP2_ERROR_FRAME_SIZE_ERROR,
+                      "bad settings length");
+  }
+
+  for (uint32_t offset = 0; offset < current_hdr.length; offset += HTTP2_SETTINGS_PARAMETER_LEN) {
+    uint8_t buf[HTTP2_SETTINGS_PARAMETER_LEN];
+    Http2SettingsParameter param;
+    read_reader->memcpy(buf, sizeof(buf), offset);
+    http2_parse_settings_parameter(make_iovec(buf), param);
+    if (!http2_settings_parameter_is_valid(param)) {
+      return Http2Error(Http2ErrorClass::HTTP2_ERROR_CLASS_CONNECTION,
+                        param.id == HTTP2_SETTINGS_INITIAL_WINDOW_SIZE ? Http2ErrorCode::HTTP2_ERROR_FLOW_CONTROL_ERROR :
+                                                                         Http2ErrorCode::HTTP2_ERROR_PROTOCOL_ERROR,
+                        "bad settings value");
+    }
+    if (param.id == 0 || param.id >= HTTP2_SETTINGS_MAX) {
+      continue;
+    }
+    if (param.id == HTTP2_SETTINGS_INITIAL_WINDOW_SIZE) {
+      // [RFC 7540] 6.9.2. The change applies to the windows of all the open streams.
+      Http2WindowSize delta = param.value - peer_settings.get(HTTP2_SETTINGS_INITIAL_WINDOW_SIZE);
+      for (auto &[sid, stream] : active) {
+        stream->peer_window += delta;
+        stream->signal_write();
+      }
+    }
+    peer_settings.set(static_cast<Http2SettingsIdentifier>(param.id), param.value);
+  }
+
+  Http2Frame ack(HTTP2_FRAME_TYPE_SETTINGS, 0, HTTP2_FLAGS_SETTINGS_ACK);
+  xmit(ack);
+
+  if (!peer_settings_received) {
+    Http2SsDebug("Connection open, max concurrent streams %u", peer_settings.get(HTTP2_SETTINGS_MAX_CONCURRENT_STREAMS));
+    peer_settings_received = true;
+    state                  = State::OPEN;
+    for (Http2ServerStream *stream = streams.head; stream; stream = stream->link.next) {
+      stream->open(NET_EVENT_OPEN);
+    }
+  } else {
+    while (!blocked.empty() && active.size() < peer_settings.get(HTTP2_SETTINGS_MAX_CONCURRENT_STREAMS)) {
+      blocked.front()->signal_write();
+      blocked.pop_front();
+    }
+  }
+  return Http2Error();
+}
+
+Http2Error
+Http2ServerSession::recv_ping_frame()
+{
+  if (current_hdr.streamid != 0) {
+    return Http2Error(Http2ErrorClass::HTTP2_ERROR_CLASS_CONNECTION, Http2ErrorCode::HTTP2_ERROR_PROTOCOL_ERROR,
+                      "ping on a stream");
+  }
+  if (current_hdr.length != HTTP2_PING_LEN) {
+    return Http2Error(Http2ErrorClass::HTTP2_ERROR_CLASS_CONNECTION, Http2ErrorCode::HTTP2_ERROR_FRAME_SIZE_ERROR,
+                      "bad ping length");
+  }
+  if (!(current_hdr.flags & HTTP2_FLAGS_PING_ACK)) {
+    uint8_t opaque_data[HTTP2_PING_LEN];
+    read_reader->memcpy(opaque_data, sizeof(opaque_data));
+    Http2Frame ping(HTTP2_FRAME_TYPE_PING, 0, HTTP2_FLAGS_PING_ACK);
+    ping.alloc(BUFFER_SIZE_INDEX_128);
+    http2_write_ping(opaque_data, ping.write());
+    ping.finalize(HTTP2_PING_LEN);
+    xmit(ping);
+  }
+  return Http2Error();
+}
+
+Http2Error
+Http2ServerSession::recv_goaway_frame()
+{
+  if (current_hdr.streamid != 0) {
+    return Http2Error(Http2ErrorClass::HTTP2_ERROR_CLASS_CONNECTION, Http2ErrorCode::HTTP2_ERROR_PROTOCOL_ERROR,
+                      "goaway on a stream");
+  }
+  if (current_hdr.length < HTTP2_GOAWAY_LEN) {
+    return Http2Error(Http2ErrorClass::HTTP2_ERROR_CLASS_CONNECTION, Http2ErrorCode::HTTP2_ERROR_FRAME_SIZE_ERROR,
+                      "bad goaway length");
+  }
+
+  uint8_t buf[HTTP2_GOAWAY_LEN];
+  Http2Goaway goaway;
+  read_reader->memcpy(buf, sizeof(buf));
+  http2_parse_goaway(make_iovec(buf), goaway);
+  Http2SsDebug("GOAWAY received, last stream %u, error code %u", goaway.last_streamid, static_cast<unsigned>(goaway.error_code));
+
+  going_away = true;
+  remove_from_pool();
+
+  // The streams the origin server will not process fail, those that never got their NET_EVENT_OPEN
+  // are sent to open another connection.
+  for (Http2ServerStream *stream = streams.head; stream; stream = stream->link.next) {
+    if (!stream->opened) {
+      stream->open(NET_EVENT_OPEN_FAILED, ECONNRESET);
+    } else if (stream->id == 0 || stream->id > goaway.last_streamid) {
+      stream->recv_rst_stream(Http2ErrorCode::HTTP2_ERROR_REFUSED_STREAM);
+      stream_done(stream);
+    }
+  }
+  blocked.clear();
+  return Http2Error();
+}
+
+Http2Error
+Http2ServerSession::recv_window_update_frame()
+{
+  if (current_hdr.length != HTTP2_WINDOW_UPDATE_LEN) {
+    return Http2Error(Http2ErrorClass::HTTP2_ERROR_CLASS_CONNECTION, Http2ErrorCode::HTTP2_ERROR_FRAME_SIZE_ERROR,
+                      "bad window update length");
+  }
+
+  uint8_t buf[HTTP2_WINDOW_UPDATE_LEN];
+  uint32_t size;
+  read_reader->memcpy(buf, sizeof(buf));
+  http2_parse_window_update(make_iovec(buf), size);
+
+  const Http2ErrorClass cls = current_hdr.streamid == 0 ? Http2ErrorClass::HTTP2_ERROR_CLASS_CONNECTION :
+                                                          Http2ErrorClass::HTTP2_ERROR_CLASS_STREAM;
+  if (size == 0) {
+    return Http2Error(cls, Http2ErrorCode::HTTP2_ERROR_PROTOCOL_ERROR, "window update of 0");
+  }
+
+  if (current_hdr.streamid == 0) {
+    if (size > static_cast<uint32_t>(HTTP2_MAX_WINDOW_SIZE - peer_window)) {
+      return Http2Error(cls, Http2ErrorCode::HTTP2_ERROR_FLOW_CONTROL_ERROR, "window overflow");
+    }
+    peer_window += size;
+    for (auto &[sid, stream] : active) {
+      stream->signal_write();
+    }
+  } else if (auto spot = active.find(current_hdr.streamid); spot != active.end()) {
+    Http2ServerStream *stream = spot->second;
+    if (size > static_cast<uint32_t>(HTTP2_MAX_WINDOW_SIZE - stream->peer_window)) {
+      return Http2Error(cls, Http2ErrorCode::HTTP2_ERROR_FLOW_CONTROL_ERROR, "window overflow");
+    }
+    stream->peer_window += size;
+    stream->signal_write();
+  }
+  return Http2Error();
+}
+
+bool
+Http2ServerSession::send_headers(Http2ServerStream *stream, bool end_stream)
+{
+  if (state != State::OPEN || going_away) {
+    stream->errored = true;
+    return false;
+  }
+  if (active.size() >= peer_settings.get(HTTP2_SETTINGS_MAX_CONCURRENT_STREAMS)) {
+    if (std::find(blocked.begin(), blocked.end(), stream) == blocked.end()) {
+      blocked.push_back(stream);
+    }
+    return false;
+  }
+
+  HTTPHdr *req_header = &stream->request_header;
+  HTTPHdr h2_hdr;
+  http2_generate_h2_header_from_1_1(req_header, &h2_hdr);
+
+  uint32_t buf_len            = req_header->length_get() * 2; // Make it double just in case
+  uint8_t *buf                = static_cast<uint8_t *>(ats_malloc(buf_len));
+  uint32_t header_blocks_size = 0;
+  Http2ErrorCode result       = http2_encode_header_blocks(&h2_hdr, buf, buf_len, &header_blocks_size, hpack_encoder,
+                                                     peer_settings.get(HTTP2_SETTINGS_HEADER_TABLE_SIZE));
+  h2_hdr.destroy();
+  if (result != Http2ErrorCode::HTTP2_ERROR_NO_ERROR) {
+    ats_free(buf);
+    stream->errored = true;
+    return false;
+  }
+
+  stream->id = next_stream_id;
+  next_stream_id += 2;
+  if (next_stream_id > HTTP2_MAX_STREAM_ID) {
+    // Out of stream ids, let the streams finish and open a new connection for the next.
+    going_away = true;
+    remove_from_pool();
+  }
+  stream->peer_window = peer_settings.get(HTTP2_SETTINGS_INITIAL_WINDOW_SIZE);
+  active.emplace(stream->id, stream);
+  Http2SsStreamDebug(this, stream->id, "Send HEADERS frame");
+
+  // Send a HEADERS frame and CONTINUATION frames for the rest of the block.
+  const uint32_t payload_size = Http2Frame::payload_size_for_index(BUFFER_SIZE_INDEX_16K);
+  uint32_t sent               = 0;
+  do {
+    uint32_t payload_length = std::min(payload_size, header_blocks_size - sent);
+    uint8_t flags           = 0;
+    if (sent + payload_length == header_blocks_size) {
+      flags |= HTTP2_FLAGS_HEADERS_END_HEADERS;
+    }
+    if (sent == 0 && end_stream) {
+      flags |= HTTP2_FLAGS_HEADERS_END_STREAM;
+    }
+    Http2Frame frame(sent == 0 ? HTTP2_FRAME_TYPE_HEADERS : HTTP2_FRAME_TYPE_CONTINUATION, stream->id, flags);
+    frame.alloc(BUFFER_SIZE_INDEX_16K);
+    http2_write_headers(buf + sent, payload_length, frame.write());
+    frame.finalize(payload_length);
+    xmit(frame);
+    sent += payload_length;
+  } while (sent < header_blocks_size);
+
+  ats_free(buf);
+  return true;
+}
+
+int64_t
+Http2ServerSession::send_data(Http2ServerStream *stream, IOBufferReader *reader, int64_t len, bool end_stream)
+{
+  const int64_t frame_size =
+    std::min(static_cast<int64_t>(peer_settings.get(HTTP2_SETTINGS_MAX_FRAME_SIZE)),
+             static_cast<int64_t>(Http2Frame::payload_size_for_index(BUFFER_SIZE_INDEX_16K)));
+  int64_t sent = 0;
+
+  do {
+    int64_t window         = std::min(peer_window, stream->peer_window);
+    int64_t payload_length = std::min({len - sent, window, frame_size});
+    if (payload_length <= 0 && (sent < len || !end_stream)) {
+      break;
+    }
+    payload_length = std::max(payload_length, static_cast<int64_t>(0));
+
+    uint8_t flags = (sent + payload_length == len && end_stream) ? HTTP2_FLAGS_DATA_END_STREAM : 0;
+    Http2Frame data(HTTP2_FRAME_TYPE_DATA, stream->id, flags);
+    data.alloc(BUFFER_SIZE_INDEX_16K);
+    reader->read(data.write().iov_base, payload_length);
+    data.finalize(payload_length);
+    peer_window -= payload_length;
+    stream->peer_window -= payload_length;
+    xmit(data);
+    sent += payload_length;
+
+    if (flags) {
+      break;
+    }
+  } while (sent < len);
+
+  return sent;
+}
+
+void
+Http2ServerSession::send_rst_stream(Http2StreamId id, Http2ErrorCode code)
+{
+  Http2SsStreamDebug(this, id, "Send RST_STREAM frame, error code %u", static_cast<unsigned>(code));
+  Http2Frame rst_stream(HTTP2_FRAME_TYPE_RST_STREAM, id, 0);
+  rst_stream.alloc(BUFFER_SIZE_INDEX_128);
+  http2_write_rst_stream(static_cast<uint32_t>(code), rst_stream.write());
+  rst_stream.finalize(HTTP2_RST_STREAM_LEN);
+  xmit(rst_stream);
+}
+
+void
+Http2ServerSession::send_window_update(Http2StreamId id, uint32_t size)
+{
+  Http2Frame window_update(HTTP2_FRAME_TYPE_WINDOW_UPDATE, id, 0);
+  window_update.alloc(BUFFER_SIZE_INDEX_128);
+  http2_write_window_update(size, window_update.write());
+  window_update.finalize(HTTP2_WINDOW_UPDATE_LEN);
+  xmit(window_update);
+}
+
+void
+Http2ServerSession::send_goaway(Http2ErrorCode code)
+{
+  Http2SsDebug("Send GOAWAY frame, error code %u", static_cast<unsigned>(code));
+  Http2Goaway goaway;
+  goaway.error_code = code;
+  Http2Frame frame(HTTP2_FRAME_TYPE_GOAWAY, 0, 0);
+  frame.alloc(BUFFER_SIZE_INDEX_128);
+  http2_write_goaway(goaway, frame.write());
+  frame.finalize(HTTP2_GOAWAY_LEN);
+  xmit(frame);
+}
+
+void
+Http2ServerSession::xmit(Http2Frame &frame)
+{
+  if (write_vio == nullptr) {
+    return;
+  }
+  total_write_len += frame.size();
+  write_vio->nbytes = total_write_len;
+  frame.xmit(write_buffer);
+  write_vio->reenable();
+}
+
+void
+Http2ServerSession::connection_error(Http2ErrorCode code)
+{
+  if (code != Http2ErrorCode::HTTP2_ERROR_NO_ERROR) {
+    HTTP2_INCREMENT_THREAD_DYN_STAT(HTTP2_STAT_CONNECTION_ERRORS_COUNT, this_ethread());
+  }
+  if (write_vio == nullptr) {
+    close(ECONNRESET);
+    return;
+  }
+
+  send_goaway(code);
+  remove_from_pool();
+  fail_streams(ECONNRESET);
+  state = State::CLOSING;
+
+  // Stop reading and close once the GOAWAY is written, or it is given up on.
+  server_vc->do_io_read(this, 0, nullptr);
+  read_vio = nullptr;
+  if (idle_event) {
+    idle_event->cancel();
+  }
+  idle_event = this_ethread()->schedule_in(this, HTTP2_GOAWAY_FLUSH_TIMEOUT);
+}
+
+void
+Http2ServerSession::fail_streams(int lerrno)
+{
+  while (Http2ServerStream *stream = streams.pop()) {
+    stream->session_closed(lerrno);
+  }
+  stream_count = 0;
+  active.clear();
+  blocked.clear();
+}
+
+void
+Http2ServerSession::close(int lerrno)
+{
+  if (state == State::CLOSED) {
+    return;
+  }
+  Http2SsDebug("Session closed");
+  state = State::CLOSED;
+
+  remove_from_pool();
+  fail_streams(lerrno);
+
+  if (connect_action) {
+    connect_action->cancel();
+    connect_action = nullptr;
+  }
+  if (idle_event) {
+    idle_event->cancel();
+    idle_event = nullptr;
+  }
+  if (server_vc) {
+    server_vc->do_io_close();
+    server_vc = nullptr;
+    read_vio  = nullptr;
+    write_vio = nullptr;
+  }
+
+  // This may be called from a stream, free the session once that is done.
+  SET_HANDLER(&Http2ServerSession::main_event_handler);
+  this_ethread()->schedule_imm(this, HTTP2_SESSION_EVENT_FINI);
+}
+
+void
+Http2ServerSession::schedule_idle()
+{
+  if (idle_event) {
+    idle_event->cancel();
+  }
+  idle_event = this_ethread()->schedule_in(this, idle_timeout);
+}
+
+void
+Http2ServerSession::remove_from_pool()
+{
+  if (in_pool) {
+    session_pool.erase(this);
+    in_pool = false;
+  }
+}
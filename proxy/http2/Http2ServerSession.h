@@ -0,0 +1,325 @@
+/** @file
+
+  Http2ServerSession, HTTP/2 connections to origin servers.
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ */
+
+#pragma once
+
+#include <deque>
+#include <string>
+#include <unordered_map>
+
+#include "tscore/CryptoHash.h"
+#include "tscore/IntrusiveHashMap.h"
+#include "tscore/List.h"
+#include "I_NetVConnection.h"
+#include "HTTP.h"
+#include "HTTP2.h"
+#include "HPACK.h"
+#include "Http2ConnectionState.h"
+
+class Http2Frame;
+class Http2ServerSession;
+
+/** A request to an origin server over a shared @c Http2ServerSession.
+
+    To the state machine this is the connection to the origin server. The HTTP/1.1 request written
+    to it is sent as HEADERS and DATA frames and the response frames are read from it as an HTTP/1.1
+    response, so the transaction is handled the same as one over its own connection. The response
+    carries "Connection: close" so the stream is closed, never pooled, when the transaction is done.
+
+    All the events to the state machine are scheduled, none are sent from within a call it makes.
+ */
+class Http2ServerStream : public NetVConnection
+{
+  friend class Http2ServerSession;
+
+public:
+  Http2ServerStream() {}
+
+  void init(Http2ServerSession *session, Continuation *cont);
+  int main_event_handler(int event, void *edata);
+
+  // Implement VConnection interface.
+  VIO *do_io_read(Continuation *c, int64_t nbytes = INT64_MAX, MIOBuffer *buf = nullptr) override;
+  VIO *do_io_write(Continuation *c = nullptr, int64_t nbytes = INT64_MAX, IOBufferReader *buf = nullptr,
+                   bool owner = false) override;
+  void do_io_close(int lerrno = -1) override;
+  void do_io_shutdown(ShutdownHowTo_t howto) override;
+  void reenable(VIO *vio) override;
+  void reenable_re(VIO *vio) override;
+
+  // Timeouts
+  void set_active_timeout(ink_hrtime timeout_in) override;
+  void set_inactivity_timeout(ink_hrtime timeout_in) override;
+  void cancel_active_timeout() override;
+  void cancel_inactivity_timeout() override;
+  void add_to_keep_alive_queue() override;
+  void remove_from_keep_alive_queue() override;
+  bool add_to_active_queue() override;
+  ink_hrtime get_active_timeout() override;
+  ink_hrtime get_inactivity_timeout() override;
+
+  // Pure virtual functions we need to compile
+  SOCKET get_socket() override;
+  void set_local_addr() override;
+  void set_remote_addr() override;
+  void set_remote_addr(const sockaddr *) override;
+  void set_mptcp_state() override;
+  int set_tcp_congestion_control(int) override;
+  void apply_options() override;
+
+  int populate_protocol(std::string_view *results, int n) const override;
+  const char *protocol_contains(std::string_view prefix) const override;
+
+  Http2StreamId
+  get_id() const
+  {
+    return id;
+  }
+
+  LINK(Http2ServerStream, link);
+
+private:
+  void destroy();
+
+  // From the session.
+  void open(int event, int lerrno = 0);
+  bool recv_headers(HTTPHdr *hdr, bool end_stream);
+  bool recv_data(IOBufferReader *reader, int64_t len, int64_t offset, bool end_stream);
+  void recv_rst_stream(Http2ErrorCode code);
+  void session_closed(int lerrno);
+
+  void signal_read();
+  void signal_write();
+  void process_read();
+  void process_write();
+  void process_timeout(int event);
+  bool is_done() const;
+
+  Http2ServerSession *session = nullptr;
+  Http2StreamId id            = 0;
+
+  /// Handed to the state machine until the stream is opened.
+  Action open_action;
+  int open_errno = 0;
+
+  VIO read_vio;
+  VIO write_vio;
+
+  HTTPParser parser;
+  HTTPHdr request_header;
+  int64_t body_left = 0;
+
+  /// The response as HTTP/1.1, until it is moved to @c read_vio.
+  MIOBuffer *response_buffer      = nullptr;
+  IOBufferReader *response_reader = nullptr;
+
+  /// What we may still send.
+  Http2WindowSize peer_window = HTTP2_INITIAL_WINDOW_SIZE;
+  /// What the origin server may still send, and what has been passed on since the last WINDOW_UPDATE.
+  Http2WindowSize local_window = 0;
+  uint32_t unacked             = 0;
+
+  bool opened           = false;
+  bool header_parsed    = false;
+  bool headers_sent     = false;
+  bool end_stream_sent  = false;
+  bool recv_end_stream  = false;
+  bool response_started = false;
+  bool reset            = false; ///< RST_STREAM was sent or received.
+  bool errored          = false;
+  bool closed           = false;
+  bool eos_sent         = false;
+  bool ready_sent       = false;
+
+  Event *open_event     = nullptr;
+  Event *read_event     = nullptr;
+  Event *write_event    = nullptr;
+  Event *active_event   = nullptr;
+  Event *inactive_event = nullptr;
+
+  ink_hrtime active_timeout      = 0;
+  ink_hrtime inactive_timeout    = 0;
+  ink_hrtime inactive_timeout_at = 0;
+
+  int reentrancy_count = 0;
+};
+
+extern ClassAllocator<Http2ServerStream> http2ServerStreamAllocator;
+
+/** An HTTP/2 connection to an origin server shared by many transactions.
+
+    Sessions are kept per thread, by origin server address and TLS client identity, and a new one
+    is opened only when those are all at @c proxy.config.http2.max_concurrent_streams_out streams.
+    Streams that are over the origin server's SETTINGS_MAX_CONCURRENT_STREAMS wait for their
+    HEADERS to go out until one of the open streams closes.
+ */
+class Http2ServerSession : public Continuation
+{
+  friend class Http2ServerStream;
+
+public:
+  using self_type = Http2ServerSession;
+
+  /** Open a stream to @a addr for @a cont, the equivalent of @c NetProcessor::connect_re.
+
+      @a cont gets @c NET_EVENT_OPEN with a @c Http2ServerStream once the origin server's SETTINGS
+      arrive, or @c NET_EVENT_OPEN_FAILED. @a idle_timeout is how long a session opened here is
+      kept without streams.
+
+      @return The action to cancel the open, or @c nullptr if the origin server is known not to
+      negotiate "h2", so the caller opens an HTTP/1.1 connection instead.
+   */
+  static Action *connect_re(Continuation *cont, sockaddr const *addr, NetVCOptions const &opt, ink_hrtime idle_timeout);
+
+  int state_connecting(int event, void *edata);
+  int main_event_handler(int event, void *edata);
+
+  /// Hash map descriptor class for the per thread pool.
+  struct PoolLinkage {
+    self_type *_next = nullptr;
+    self_type *_prev = nullptr;
+
+    static self_type *&next_ptr(self_type *);
+    static self_type *&prev_ptr(self_type *);
+    static uint64_t hash_of(CryptoHash const &key);
+    static CryptoHash const &key_of(self_type *ssn);
+    static bool equal(CryptoHash const &lhs, CryptoHash const &rhs);
+  } _pool_link;
+
+private:
+  enum class State {
+    CONNECTING, ///< Waiting for the connection and the origin server's SETTINGS.
+    OPEN,
+    CLOSING, ///< Flushing a GOAWAY.
+    CLOSED,
+  };
+
+  Http2ServerSession(CryptoHash const &key, sockaddr const *addr, ink_hrtime idle_timeout);
+  ~Http2ServerSession() override;
+
+  bool available() const;
+  Http2ServerStream *new_stream(Continuation *cont);
+  void detach(Http2ServerStream *stream);
+  void stream_done(Http2ServerStream *stream);
+
+  void start();
+  void read_frames();
+  Http2Error process_frame();
+  Http2Error recv_data_frame();
+  Http2Error recv_headers_frame();
+  Http2Error recv_rst_stream_frame();
+  Http2Error recv_settings_frame();
+  Http2Error recv_ping_frame();
+  Http2Error recv_goaway_frame();
+  Http2Error recv_window_update_frame();
+  Http2Error decode_headers();
+
+  bool send_headers(Http2ServerStream *stream, bool end_stream);
+  int64_t send_data(Http2ServerStream *stream, IOBufferReader *reader, int64_t len, bool end_stream);
+  void send_rst_stream(Http2StreamId id, Http2ErrorCode code);
+  void send_window_update(Http2StreamId id, uint32_t size);
+  void send_goaway(Http2ErrorCode code);
+  void xmit(Http2Frame &frame);
+
+  void connection_error(Http2ErrorCode code);
+  void fail_streams(int lerrno);
+  void close(int lerrno);
+  void schedule_idle();
+  void remove_from_pool();
+
+  CryptoHash key;
+  IpEndpoint server_addr;
+  NetVCOptions options;
+  int64_t con_id;
+  State state = State::CONNECTING;
+
+  NetVConnection *server_vc     = nullptr;
+  Action *connect_action        = nullptr;
+  MIOBuffer *read_buffer        = nullptr;
+  IOBufferReader *read_reader   = nullptr;
+  MIOBuffer *write_buffer       = nullptr;
+  IOBufferReader *write_reader  = nullptr;
+  VIO *read_vio                 = nullptr;
+  VIO *write_vio                = nullptr;
+  int64_t total_write_len       = 0;
+  bool alpn_checked             = false;
+  bool in_pool                  = false;
+  bool going_away               = false;
+  Event *idle_event             = nullptr;
+  ink_hrtime idle_timeout       = 0;
+  Http2StreamId next_stream_id  = 1;
+  Http2WindowSize peer_window   = HTTP2_INITIAL_WINDOW_SIZE;
+  uint32_t conn_unacked         = 0;
+  bool peer_settings_received   = false;
+  Http2ConnectionSettings peer_settings;
+
+  HpackHandle hpack_encoder{HTTP2_HEADER_TABLE_SIZE};
+  HpackHandle hpack_decoder{HTTP2_HEADER_TABLE_SIZE};
+
+  // The frame being read.
+  Http2FrameHeader current_hdr = {0, 0, 0, 0};
+  bool current_hdr_read        = false;
+
+  // A header block split over CONTINUATION frames.
+  Http2StreamId continued_stream_id = 0;
+  bool continued_end_stream         = false;
+  std::string header_block;
+
+  /// Every stream on the session, opened or not.
+  DLL<Http2ServerStream> streams;
+  uint32_t stream_count = 0;
+  /// The streams with an id, by id.
+  std::unordered_map<Http2StreamId, Http2ServerStream *> active;
+  /// Streams waiting for the origin server to allow another stream.
+  std::deque<Http2ServerStream *> blocked;
+};
+
+inline Http2ServerSession *&
+Http2ServerSession::PoolLinkage::next_ptr(self_type *ssn)
+{
+  return ssn->_pool_link._next;
+}
+
+inline Http2ServerSession *&
+Http2ServerSession::PoolLinkage::prev_ptr(self_type *ssn)
+{
+  return ssn->_pool_link._prev;
+}
+
+inline uint64_t
+Http2ServerSession::PoolLinkage::hash_of(CryptoHash const &key)
+{
+  return key.fold();
+}
+
+inline CryptoHash const &
+Http2ServerSession::PoolLinkage::key_of(self_type *ssn)
+{
+  return ssn->key;
+}
+
+inline bool
+Http2ServerSession::PoolLinkage::equal(CryptoHash const &lhs, CryptoHash const &rhs)
+{
+  return lhs == rhs;
+}
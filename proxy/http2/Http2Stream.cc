@@ -146,9 +146,27 @@ Http2Stream::decode_header_blocks(HpackHandle &hpack_handle, uint32_t maximum_ta
 void
 Http2Stream::send_request(Http2ConnectionState &cstate)
 {
+  // [RFC 9218] 5. The Priority HTTP Header Field
+  if (cstate.urgency_scheduler) {
+    if (const MIMEField *field = _req_header.field_find("priority", 8); field != nullptr) {
+      int len;
+      const char *value = field->value_get(&len);
+      uint8_t urgency   = urgency_node.urgency;
+      bool incremental  = urgency_node.incremental;
+      if (Http2UrgencyScheduler::parse_priority(std::string_view(value, len), urgency, incremental)) {
+        cstate.urgency_scheduler->set_priority(&urgency_node, urgency, incremental);
+      }
+    }
+  }
+
   // Convert header to HTTP/1.1 format
   http2_convert_header_from_2_to_1_1(&_req_header);
 
+  // The body is added by reference to the session's blocks, the block written here only needs to fit the header.
+  if (request_buffer.get_current_block() == nullptr) {
+    request_buffer.size_index = iobuffer_size_to_index(_req_header.length_get(), CLIENT_CONNECTION_FIRST_READ_BUFFER_SIZE_INDEX);
+  }
+
   // Write header to a buffer.  Borrowing logic from HttpSM::write_header_into_buffer.
   // Seems like a function like this ought to be in HTTPHdr directly
   int bufindex;
@@ -687,7 +705,7 @@ Http2Stream::send_response_body(bool call_update)
   Http2ClientSession *proxy_ssn = static_cast<Http2ClientSession *>(this->get_proxy_ssn());
   inactive_timeout_at           = Thread::get_hrtime() + inactive_timeout;
 
-  if (Http2::stream_priority_enabled) {
+  if (proxy_ssn->connection_state.is_priority_scheduled()) {
     SCOPED_MUTEX_LOCK(lock, proxy_ssn->connection_state.mutex, this_ethread());
     proxy_ssn->connection_state.schedule_stream(this);
     // signal_write_event() will be called from `Http2ConnectionState::send_data_frames_depends_on_priority()`
@@ -729,6 +747,12 @@ Http2Stream::destroy()
   if (proxy_ssn) {
     Http2ClientSession *h2_proxy_ssn = static_cast<Http2ClientSession *>(proxy_ssn);
     SCOPED_MUTEX_LOCK(lock, h2_proxy_ssn->connection_state.mutex, this_ethread());
+    // Hand the header heaps to the next stream of the session
+    h2_proxy_ssn->connection_state.recycle_hdr_heap(_req_header.m_heap);
+    _req_header.clear();
+    h2_proxy_ssn->connection_state.recycle_hdr_heap(response_header.m_heap);
+    response_header.clear();
+
     // Make sure the stream is removed from the stream list and priority tree
     // In many cases, this has been called earlier, so this call is a no-op
     h2_proxy_ssn->connection_state.delete_stream(this);
@@ -28,6 +28,7 @@
 #include "Http2DebugNames.h"
 #include "../http/HttpTunnel.h" // To get ChunkedHandler
 #include "Http2DependencyTree.h"
+#include "Http2UrgencyScheduler.h"
 #include "tscore/History.h"
 
 class Http2Stream;
@@ -45,16 +46,18 @@ public:
   }
 
   void
-  init(Http2StreamId sid, ssize_t initial_rwnd)
+  init(Http2StreamId sid, ssize_t initial_rwnd, HdrHeap *req_heap = nullptr, HdrHeap *resp_heap = nullptr)
   {
     _id               = sid;
+    urgency_node.id   = sid;
+    urgency_node.t    = this;
     _start_time       = Thread::get_hrtime();
     _thread           = this_ethread();
     this->client_rwnd = initial_rwnd;
     sm_reader = request_reader = request_buffer.alloc_reader();
     // FIXME: Are you sure? every "stream" needs request_header?
-    _req_header.create(HTTP_TYPE_REQUEST);
-    response_header.create(HTTP_TYPE_RESPONSE);
+    _req_header.create(HTTP_TYPE_REQUEST, req_heap);
+    response_header.create(HTTP_TYPE_RESPONSE, resp_heap);
     http_parser_init(&http_parser);
   }
 
@@ -157,7 +160,8 @@ public:
 
   // Stream level window size
   ssize_t client_rwnd;
-  ssize_t server_rwnd = Http2::initial_window_size;
+  ssize_t server_rwnd        = Http2::initial_window_size;
+  bool window_update_pending = false; ///< The window is refilled with Http2ConnectionState::send_window_update_frames().
 
   uint8_t *header_blocks        = nullptr;
   uint32_t header_blocks_length = 0;  // total length of header blocks (not include
@@ -177,6 +181,7 @@ public:
   IOBufferReader *request_reader           = nullptr;
   MIOBuffer request_buffer                 = CLIENT_CONNECTION_FIRST_READ_BUFFER_SIZE_INDEX;
   Http2DependencyTree::Node *priority_node = nullptr;
+  Http2UrgencyScheduler::Node urgency_node;
 
   IOBufferReader *response_get_data_reader() const;
   bool
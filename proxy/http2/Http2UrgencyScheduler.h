@@ -0,0 +1,250 @@
+/** @file
+
+  Stream scheduling by the HTTP extensible priorities.
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+#include "tscore/ink_assert.h"
+
+/** A scheduler of the active streams of a connection by RFC 9218 urgency and incremental parameters.
+
+    The active streams are the entries of a binary heap in a single vector, the lowest urgency value
+    first and at the same urgency the non-incremental streams before the incremental ones.
+    Non-incremental streams are sent one after another in stream id order. Incremental streams share
+    the connection, each that sends a frame goes behind the others of its urgency.
+
+    @c top is constant time, @c activate, @c deactivate, @c update and @c set_priority are logarithmic
+    in the number of active streams. Nodes belong to the caller (they are meant to be a member of the
+    stream) so nothing is allocated once the heap has grown to the most streams active at once.
+ */
+class Http2UrgencyScheduler
+{
+public:
+  static constexpr uint8_t URGENCY_MAX     = 7;
+  static constexpr uint8_t URGENCY_DEFAULT = 3;
+
+  struct Node {
+    uint32_t id      = 0;
+    uint8_t urgency  = URGENCY_DEFAULT;
+    bool incremental = false;
+    int32_t index    = -1; ///< Position in the heap, -1 if not active.
+    void *t          = nullptr;
+
+    bool
+    active() const
+    {
+      return index >= 0;
+    }
+  };
+
+  /// The active node to send from next, @c nullptr if there is none.
+  Node *
+  top() const
+  {
+    return _heap.empty() ? nullptr : _heap.front().node;
+  }
+
+  void activate(Node *node);
+  void deactivate(Node *node);
+  /// Note that @a node sent a frame.
+  void update(Node *node);
+  void set_priority(Node *node, uint8_t urgency, bool incremental);
+
+  /// The number of active nodes.
+  uint32_t
+  size() const
+  {
+    return _heap.size();
+  }
+
+  /** Read the urgency and incremental parameters of a Priority header field @a value.
+
+      Unknown and malformed members are ignored, those present and valid are set.
+
+      @return @c true if either parameter was set.
+   */
+  static bool parse_priority(std::string_view value, uint8_t &urgency, bool &incremental);
+
+private:
+  struct Entry {
+    uint64_t key;
+    Node *node;
+  };
+
+  uint64_t _key(Node const *node);
+  void _rekey(Node *node);
+  void _place(uint32_t i, Entry const &e);
+  void _sift_up(uint32_t i);
+  void _sift_down(uint32_t i);
+
+  std::vector<Entry> _heap;
+  uint64_t _round = 0; ///< Order of the incremental streams within an urgency.
+};
+
+inline uint64_t
+Http2UrgencyScheduler::_key(Node const *node)
+{
+  // urgency:3 | incremental:1 | stream id, or the round for incremental streams.
+  uint64_t key = static_cast<uint64_t>(node->urgency) << 60;
+  if (node->incremental) {
+    key |= (uint64_t(1) << 59) | (++_round & ((uint64_t(1) << 59) - 1));
+  } else {
+    key |= node->id;
+  }
+  return key;
+}
+
+inline void
+Http2UrgencyScheduler::_place(uint32_t i, Entry const &e)
+{
+  _heap[i]      = e;
+  e.node->index = i;
+}
+
+inline void
+Http2UrgencyScheduler::_sift_up(uint32_t i)
+{
+  Entry e = _heap[i];
+  while (i > 0) {
+    uint32_t parent = (i - 1) / 2;
+    if (_heap[parent].key <= e.key) {
+      break;
+    }
+    _place(i, _heap[parent]);
+    i = parent;
+  }
+  _place(i, e);
+}
+
+inline void
+Http2UrgencyScheduler::_sift_down(uint32_t i)
+{
+  uint32_t n = _heap.size();
+  Entry e    = _heap[i];
+  for (uint32_t child = 2 * i + 1; child < n; child = 2 * i + 1) {
+    if (child + 1 < n && _heap[child + 1].key < _heap[child].key) {
+      ++child;
+    }
+    if (e.key <= _heap[child].key) {
+      break;
+    }
+    _place(i, _heap[child]);
+    i = child;
+  }
+  _place(i, e);
+}
+
+inline void
+Http2UrgencyScheduler::_rekey(Node *node)
+{
+  uint32_t i   = node->index;
+  uint64_t key = _key(node);
+  bool up      = key < _heap[i].key;
+  _heap[i].key = key;
+  up ? _sift_up(i) : _sift_down(i);
+}
+
+inline void
+Http2UrgencyScheduler::activate(Node *node)
+{
+  if (node->active()) {
+    return;
+  }
+  _heap.push_back(Entry{_key(node), node});
+  node->index = _heap.size() - 1;
+  _sift_up(node->index);
+}
+
+inline void
+Http2UrgencyScheduler::deactivate(Node *node)
+{
+  if (!node->active()) {
+    return;
+  }
+  uint32_t i  = node->index;
+  Entry last  = _heap.back();
+  node->index = -1;
+  _heap.pop_back();
+  if (i < _heap.size()) {
+    _place(i, last);
+    _sift_up(i);
+    _sift_down(last.node->index);
+  }
+}
+
+inline void
+Http2UrgencyScheduler::update(Node *node)
+{
+  // A non-incremental stream keeps its place until it is done.
+  if (node->active() && node->incremental) {
+    _rekey(node);
+  }
+}
+
+inline void
+Http2UrgencyScheduler::set_priority(Node *node, uint8_t urgency, bool incremental)
+{
+  ink_assert(urgency <= URGENCY_MAX);
+  node->urgency     = urgency;
+  node->incremental = incremental;
+  if (node->active()) {
+    _rekey(node);
+  }
+}
+
+inline bool
+Http2UrgencyScheduler::parse_priority(std::string_view value, uint8_t &urgency, bool &incremental)
+{
+  bool found = false;
+
+  while (!value.empty()) {
+    size_t comma          = value.find(',');
+    std::string_view item = value.substr(0, comma);
+    value                 = comma == std::string_view::npos ? std::string_view() : value.substr(comma + 1);
+
+    while (!item.empty() && (item.front() == ' ' || item.front() == '\t')) {
+      item.remove_prefix(1);
+    }
+    // Parameters of a member are not used, drop them.
+    item = item.substr(0, item.find(';'));
+    while (!item.empty() && (item.back() == ' ' || item.back() == '\t')) {
+      item.remove_suffix(1);
+    }
+
+    if (item.size() == 3 && item.substr(0, 2) == "u=" && item[2] >= '0' && item[2] <= '0' + URGENCY_MAX) {
+      urgency = item[2] - '0';
+      found   = true;
+    } else if (item == "i" || item == "i=?1") {
+      incremental = true;
+      found       = true;
+    } else if (item == "i=?0") {
+      incremental = false;
+      found       = true;
+    }
+  }
+
+  return found;
+}
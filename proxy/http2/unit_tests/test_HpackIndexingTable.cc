@@ -0,0 +1,210 @@
+/** @file
+
+  Unit tests for the HPACK indexing table and Huffman coding.
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ */
+
+#include "catch.hpp"
+
+#include <string>
+#include <vector>
+
+#include "HPACK.h"
+#include "HuffmanCodec.h"
+
+namespace
+{
+void
+add_field(HpackIndexingTable &table, MIMEHdr &scratch, const char *name, const char *value)
+{
+  MIMEField *field = scratch.field_create(name, strlen(name));
+  field->value_set(scratch.m_heap, scratch.m_mime, value, strlen(value));
+  table.add_header_field(field);
+  scratch.field_delete(field);
+}
+
+HpackLookupResult
+lookup(const HpackIndexingTable &table, const char *name, const char *value)
+{
+  return table.lookup(name, strlen(name), value, strlen(value));
+}
+
+// Response headers as an origin typically sends them.
+const std::vector<std::pair<std::string, std::string>> response_fields = {
+  {":status", "200"},
+  {"date", "Mon, 21 Oct 2013 20:13:21 GMT"},
+  {"content-type", "text/html; charset=utf-8"},
+  {"content-length", "5120"},
+  {"cache-control", "private, max-age=0"},
+  {"etag", "\"5dc1-5f0a3b6ec1a80\""},
+  {"last-modified", "Mon, 21 Oct 2013 20:13:21 GMT"},
+  {"server", "ATS"},
+  {"vary", "Accept-Encoding"},
+  {"x-request-id", "0b4c8e6a-36b1-4f53-9d9c-1c5e7a8c2f0d"},
+  {"strict-transport-security", "max-age=31536000"},
+};
+} // namespace
+
+TEST_CASE("HPACK static table lookup", "[hpack]")
+{
+  HpackIndexingTable table(4096);
+  HpackLookupResult result;
+
+  result = lookup(table, ":method", "GET");
+  CHECK(result.index == 2);
+  CHECK(result.index_type == HpackIndex::STATIC);
+  CHECK(result.match_type == HpackMatch::EXACT);
+
+  result = lookup(table, ":method", "PUT");
+  CHECK(result.index == 2);
+  CHECK(result.match_type == HpackMatch::NAME);
+
+  result = lookup(table, ":status", "304");
+  CHECK(result.index == 11);
+  CHECK(result.match_type == HpackMatch::EXACT);
+
+  result = lookup(table, "Content-Type", "text/html");
+  CHECK(result.index == 31);
+  CHECK(result.match_type == HpackMatch::NAME);
+
+  result = lookup(table, "www-authenticate", "");
+  CHECK(result.index == 61);
+  CHECK(result.match_type == HpackMatch::EXACT);
+
+  result = lookup(table, "x-unknown", "");
+  CHECK(result.index == 0);
+  CHECK(result.index_type == HpackIndex::NONE);
+  CHECK(result.match_type == HpackMatch::NONE);
+}
+
+TEST_CASE("HPACK dynamic table lookup", "[hpack]")
+{
+  HpackIndexingTable table(4096);
+  MIMEHdr scratch;
+  HpackLookupResult result;
+
+  scratch.create();
+  add_field(table, scratch, "x-custom", "a");
+  add_field(table, scratch, "X-Custom", "b");
+  add_field(table, scratch, "content-type", "text/html");
+
+  // The newest entry is 62.
+  result = lookup(table, "x-custom", "a");
+  CHECK(result.index == 64);
+  CHECK(result.index_type == HpackIndex::DYNAMIC);
+  CHECK(result.match_type == HpackMatch::EXACT);
+
+  result = lookup(table, "x-custom", "c");
+  CHECK(result.index == 63);
+  CHECK(result.match_type == HpackMatch::NAME);
+
+  result = lookup(table, "content-type", "text/html");
+  CHECK(result.index == 62);
+  CHECK(result.match_type == HpackMatch::EXACT);
+
+  // The static table is preferred for a name match.
+  result = lookup(table, "content-type", "text/plain");
+  CHECK(result.index == 31);
+  CHECK(result.index_type == HpackIndex::STATIC);
+  CHECK(result.match_type == HpackMatch::NAME);
+
+  // Evicted entries are not found.
+  table.update_maximum_size(64);
+  result = lookup(table, "x-custom", "a");
+  CHECK(result.match_type == HpackMatch::NONE);
+  result = lookup(table, "content-type", "text/html");
+  CHECK(result.index == 62);
+  CHECK(result.match_type == HpackMatch::EXACT);
+
+  scratch.destroy();
+}
+
+TEST_CASE("HPACK Huffman round trip", "[hpack]")
+{
+  std::string src;
+  for (int i = 0; i < 1024; ++i) {
+    src += static_cast<char>(i * 7 + i / 256);
+  }
+
+  for (size_t len : {0, 1, 5, 31, 32, 33, 1024}) {
+    std::vector<uint8_t> encoded(len * 4 + 4);
+    std::vector<char> decoded(len * 2 + 1);
+
+    int64_t encoded_len = huffman_encode(encoded.data(), reinterpret_cast<const uint8_t *>(src.data()), len);
+    REQUIRE(encoded_len >= 0);
+    int64_t decoded_len = huffman_decode(decoded.data(), encoded.data(), encoded_len);
+    REQUIRE(decoded_len == static_cast<int64_t>(len));
+    CHECK(memcmp(decoded.data(), src.data(), len) == 0);
+  }
+
+  // More than 7 bits of padding.
+  const uint8_t long_padding[] = {0x1f, 0xff};
+  char out[4];
+  CHECK(huffman_decode(out, long_padding, sizeof(long_padding)) == -1);
+  // Padding that is not a prefix of EOS.
+  const uint8_t bad_padding[] = {0x1e};
+  CHECK(huffman_decode(out, bad_padding, sizeof(bad_padding)) == -1);
+}
+
+// Run with "[benchmark]" on the command line.
+TEST_CASE("HPACK benchmark", "[.][benchmark][hpack]")
+{
+  HpackIndexingTable table(4096);
+  MIMEHdr scratch;
+  uint64_t found = 0;
+
+  scratch.create();
+  for (auto const &[name, value] : response_fields) {
+    add_field(table, scratch, name.c_str(), value.c_str());
+  }
+
+  BENCHMARK("lookup response headers")
+  {
+    for (int i = 0; i < 1000; ++i) {
+      for (auto const &[name, value] : response_fields) {
+        found += table.lookup(name.data(), name.size(), value.data(), value.size()).index;
+      }
+    }
+  }
+
+  std::string text;
+  for (auto const &[name, value] : response_fields) {
+    text += value;
+  }
+  std::vector<uint8_t> encoded(text.size() * 4);
+  std::vector<char> decoded(text.size() * 2);
+  int64_t encoded_len = 0;
+
+  BENCHMARK("huffman encode")
+  {
+    for (int i = 0; i < 1000; ++i) {
+      encoded_len = huffman_encode(encoded.data(), reinterpret_cast<const uint8_t *>(text.data()), text.size());
+    }
+  }
+  BENCHMARK("huffman decode")
+  {
+    for (int i = 0; i < 1000; ++i) {
+      found += huffman_decode(decoded.data(), encoded.data(), encoded_len);
+    }
+  }
+  REQUIRE(found > 0);
+
+  scratch.destroy();
+}
@@ -0,0 +1,227 @@
+/** @file
+
+    Unit tests for Http2UrgencyScheduler
+
+    @section license License
+
+    Licensed to the Apache Software Foundation (ASF) under one
+    or more contributor license agreements.  See the NOTICE file
+    distributed with this work for additional information
+    regarding copyright ownership.  The ASF licenses this file
+    to you under the Apache License, Version 2.0 (the
+    "License"); you may not use this file except in compliance
+    with the License.  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+
+#include <string>
+
+#include "Http2UrgencyScheduler.h"
+#include "Http2DependencyTree.h"
+
+using Node = Http2UrgencyScheduler::Node;
+
+namespace
+{
+Node
+make_node(uint32_t id, uint8_t urgency = Http2UrgencyScheduler::URGENCY_DEFAULT, bool incremental = false)
+{
+  Node node;
+  node.id          = id;
+  node.urgency     = urgency;
+  node.incremental = incremental;
+  return node;
+}
+} // namespace
+
+TEST_CASE("Http2UrgencyScheduler urgency order", "[http2][Http2UrgencyScheduler]")
+{
+  Http2UrgencyScheduler scheduler;
+  Node a = make_node(1, 5), b = make_node(3, 1), c = make_node(5, 3);
+
+  REQUIRE(scheduler.top() == nullptr);
+
+  scheduler.activate(&a);
+  scheduler.activate(&b);
+  scheduler.activate(&c);
+  REQUIRE(scheduler.size() == 3);
+
+  REQUIRE(scheduler.top() == &b);
+  scheduler.deactivate(&b);
+  REQUIRE(scheduler.top() == &c);
+  scheduler.deactivate(&c);
+  REQUIRE(scheduler.top() == &a);
+  scheduler.deactivate(&a);
+  REQUIRE(scheduler.top() == nullptr);
+  REQUIRE(scheduler.size() == 0);
+  REQUIRE(!a.active());
+}
+
+TEST_CASE("Http2UrgencyScheduler non-incremental streams in id order", "[http2][Http2UrgencyScheduler]")
+{
+  Http2UrgencyScheduler scheduler;
+  Node a = make_node(7), b = make_node(3), c = make_node(5);
+
+  scheduler.activate(&a);
+  scheduler.activate(&b);
+  scheduler.activate(&c);
+
+  // Sending does not move a non-incremental stream.
+  for (int i = 0; i < 3; ++i) {
+    REQUIRE(scheduler.top() == &b);
+    scheduler.update(&b);
+  }
+  scheduler.deactivate(&b);
+  REQUIRE(scheduler.top() == &c);
+  scheduler.deactivate(&c);
+  REQUIRE(scheduler.top() == &a);
+}
+
+TEST_CASE("Http2UrgencyScheduler incremental streams round robin", "[http2][Http2UrgencyScheduler]")
+{
+  Http2UrgencyScheduler scheduler;
+  Node a = make_node(1, 3, true), b = make_node(3, 3, true), c = make_node(5, 3, true), d = make_node(7, 3, false);
+
+  scheduler.activate(&a);
+  scheduler.activate(&b);
+  scheduler.activate(&c);
+  scheduler.activate(&d);
+
+  // The non-incremental stream of the same urgency goes first.
+  REQUIRE(scheduler.top() == &d);
+  scheduler.deactivate(&d);
+
+  Node *expected[] = {&a, &b, &c, &a, &b, &c};
+  for (Node *node : expected) {
+    REQUIRE(scheduler.top() == node);
+    scheduler.update(node);
+  }
+
+  // A stream that stops in the middle of a round keeps the others in order.
+  REQUIRE(scheduler.top() == &a);
+  scheduler.update(&a);
+  scheduler.deactivate(&b);
+  REQUIRE(scheduler.top() == &c);
+  scheduler.update(&c);
+  REQUIRE(scheduler.top() == &a);
+}
+
+TEST_CASE("Http2UrgencyScheduler reprioritize", "[http2][Http2UrgencyScheduler]")
+{
+  Http2UrgencyScheduler scheduler;
+  Node a = make_node(1), b = make_node(3), c = make_node(5);
+
+  scheduler.activate(&a);
+  scheduler.activate(&b);
+  scheduler.activate(&c);
+  REQUIRE(scheduler.top() == &a);
+
+  scheduler.set_priority(&c, 0, false);
+  REQUIRE(scheduler.top() == &c);
+
+  scheduler.set_priority(&c, 7, false);
+  scheduler.set_priority(&a, 6, true);
+  REQUIRE(scheduler.top() == &b);
+  scheduler.deactivate(&b);
+  REQUIRE(scheduler.top() == &a);
+  scheduler.deactivate(&a);
+  REQUIRE(scheduler.top() == &c);
+
+  // An inactive node takes the new priority when it is activated.
+  scheduler.set_priority(&a, 0, false);
+  REQUIRE(!a.active());
+  scheduler.activate(&a);
+  REQUIRE(scheduler.top() == &a);
+}
+
+TEST_CASE("Http2UrgencyScheduler parse priority", "[http2][Http2UrgencyScheduler]")
+{
+  uint8_t urgency;
+  bool incremental;
+
+  urgency     = Http2UrgencyScheduler::URGENCY_DEFAULT;
+  incremental = false;
+  REQUIRE(Http2UrgencyScheduler::parse_priority("u=1, i", urgency, incremental));
+  REQUIRE(urgency == 1);
+  REQUIRE(incremental);
+
+  REQUIRE(Http2UrgencyScheduler::parse_priority("i=?0", urgency, incremental));
+  REQUIRE(urgency == 1);
+  REQUIRE(!incremental);
+
+  REQUIRE(Http2UrgencyScheduler::parse_priority("foo=bar ,u=7;x=1, i=?1", urgency, incremental));
+  REQUIRE(urgency == 7);
+  REQUIRE(incremental);
+
+  urgency     = Http2UrgencyScheduler::URGENCY_DEFAULT;
+  incremental = false;
+  REQUIRE(!Http2UrgencyScheduler::parse_priority("u=8, u=12, i=1, x", urgency, incremental));
+  REQUIRE(!Http2UrgencyScheduler::parse_priority("", urgency, incremental));
+  REQUIRE(urgency == Http2UrgencyScheduler::URGENCY_DEFAULT);
+  REQUIRE(!incremental);
+}
+
+// Run with "[benchmark]" on the command line.
+TEST_CASE("Http2UrgencyScheduler benchmark", "[.][benchmark][Http2UrgencyScheduler]")
+{
+  static constexpr uint32_t N_STREAMS = 256;
+  static constexpr uint32_t FRAME     = 16384;
+
+  std::string payload("stream");
+  Http2DependencyTree::Tree<std::string *> tree(N_STREAMS);
+  Http2DependencyTree::Node *tree_nodes[N_STREAMS];
+  for (uint32_t i = 0; i < N_STREAMS; ++i) {
+    tree_nodes[i] = tree.add(0, 2 * i + 1, HTTP2_PRIORITY_DEFAULT_WEIGHT, false, &payload);
+    tree.activate(tree_nodes[i]);
+  }
+
+  Http2UrgencyScheduler scheduler;
+  std::vector<Node> nodes(N_STREAMS);
+  for (uint32_t i = 0; i < N_STREAMS; ++i) {
+    nodes[i] = make_node(2 * i + 1, i % (Http2UrgencyScheduler::URGENCY_MAX + 1), true);
+    scheduler.activate(&nodes[i]);
+  }
+
+  BENCHMARK("dependency tree send")
+  {
+    for (uint32_t i = 0; i < N_STREAMS; ++i) {
+      tree.update(tree.top(), FRAME);
+    }
+  }
+
+  BENCHMARK("urgency scheduler send")
+  {
+    for (uint32_t i = 0; i < N_STREAMS; ++i) {
+      scheduler.update(scheduler.top());
+    }
+  }
+
+  BENCHMARK("dependency tree activate")
+  {
+    for (auto node : tree_nodes) {
+      tree.deactivate(node, FRAME);
+    }
+    for (auto node : tree_nodes) {
+      tree.activate(node);
+    }
+  }
+
+  BENCHMARK("urgency scheduler activate")
+  {
+    for (auto &node : nodes) {
+      scheduler.deactivate(&node);
+    }
+    for (auto &node : nodes) {
+      scheduler.activate(&node);
+    }
+  }
+}
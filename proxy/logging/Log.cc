@@ -32,6 +32,9 @@
  class.
 
  ***************************************************************************/
+#include <algorithm>
+#include <vector>
+
 #include "tscore/ink_platform.h"
 #include "tscore/TSSystemState.h"
 #include "P_EventSystem.h"
@@ -44,6 +47,7 @@
 #include "LogFilter.h"
 #include "LogFormat.h"
 #include "LogFile.h"
+#include "LogNetSink.h"
 #include "LogObject.h"
 #include "LogConfig.h"
 #include "LogBuffer.h"
@@ -55,6 +59,9 @@
 
 #define PERIODIC_TASKS_INTERVAL_FALLBACK 5
 
+// The pieces a file holds for a buffer that is late, before it gives up on that buffer.
+#define FLUSH_HELD_MAX 4096
+
 // Log global objects
 inkcoreapi LogObject *Log::error_log = nullptr;
 LogFieldList Log::global_field_list;
@@ -69,6 +76,7 @@ InkAtomicList *Log::flush_data_list;
 
 // Log private objects
 int Log::preproc_threads;
+int Log::flush_threads;
 int Log::init_status                  = 0;
 int Log::config_flags                 = 0;
 bool Log::logging_mode_changed        = false;
@@ -510,6 +518,21 @@ Log::init_fields()
   global_field_list.add(field, false);
   field_symbol_hash.emplace("cqssu", field);
 
+  field = new LogField("client_pp_unique_id", "ppuid", LogField::STRING, &LogAccess::marshal_client_pp_unique_id,
+                       (LogField::UnmarshalFunc)&LogAccess::unmarshal_str);
+  global_field_list.add(field, false);
+  field_symbol_hash.emplace("ppuid", field);
+
+  field = new LogField("client_pp_authority", "ppauth", LogField::STRING, &LogAccess::marshal_client_pp_authority,
+                       (LogField::UnmarshalFunc)&LogAccess::unmarshal_str);
+  global_field_list.add(field, false);
+  field_symbol_hash.emplace("ppauth", field);
+
+  field = new LogField("client_pp_ssl_version", "ppssv", LogField::STRING, &LogAccess::marshal_client_pp_ssl_version,
+                       (LogField::UnmarshalFunc)&LogAccess::unmarshal_str);
+  global_field_list.add(field, false);
+  field_symbol_hash.emplace("ppssv", field);
+
   Ptr<LogFieldAliasTable> finish_status_map = make_ptr(new LogFieldAliasTable);
   finish_status_map->init(N_LOG_FINISH_CODE_TYPES, LOG_FINISH_FIN, "FIN", LOG_FINISH_INTR, "INTR", LOG_FINISH_TIMEOUT, "TIMEOUT");
 
@@ -885,6 +908,11 @@ Log::init_fields()
   global_field_list.add(field, false);
   field_symbol_hash.emplace("ctid", field);
 
+  field = new LogField("log_sample_weight", "lsw", LogField::sINT, &LogAccess::marshal_sample_weight,
+                       &LogAccess::unmarshal_int_to_str);
+  global_field_list.add(field, false);
+  field_symbol_hash.emplace("lsw", field);
+
   init_status |= FIELDS_INITIALIZED;
 }
 
@@ -922,6 +950,7 @@ void
 Log::init(int flags)
 {
   preproc_threads = 1;
+  flush_threads   = 1;
 
   // store the configuration flags
   //
@@ -943,6 +972,7 @@ Log::init(int flags)
 
     config->read_configuration_variables();
     preproc_threads = config->preproc_threads;
+    flush_threads   = config->flush_threads;
 
     int val = (int)REC_ConfigReadInteger("proxy.config.log.logging_enabled");
     if (val < LOG_MODE_NONE || val > LOG_MODE_FULL) {
@@ -1010,7 +1040,7 @@ Log::init_when_enabled()
 
     // create the flush thread
     create_threads();
-    eventProcessor.schedule_every(new PeriodicWakeup(preproc_threads, 1), HRTIME_SECOND, ET_CALL);
+    eventProcessor.schedule_every(new PeriodicWakeup(preproc_threads, flush_threads), HRTIME_SECOND, ET_CALL);
 
     init_status |= FULLY_INITIALIZED;
   }
@@ -1040,18 +1070,37 @@ Log::create_threads()
     eventProcessor.spawn_thread(preproc_cont, desc, stacksize);
   }
 
-  // Now, only one flush thread is supported.
-  // TODO: Enable multiple flush threads, such as
-  //       one flush thread per file.
+  // start the flush threads, each file is written by one of them
   //
-  flush_notify    = new EventNotify;
-  flush_data_list = new InkAtomicList;
-
-  sprintf(desc, "Logging flush buffer list");
-  ink_atomiclist_init(flush_data_list, desc, 0);
-  Continuation *flush_cont = new LoggingFlushContinuation(0);
-  sprintf(desc, "[LOG_FLUSH]");
-  eventProcessor.spawn_thread(flush_cont, desc, stacksize);
+  flush_notify    = new EventNotify[flush_threads];
+  flush_data_list = new InkAtomicList[flush_threads];
+
+  for (int i = 0; i < flush_threads; i++) {
+    ink_atomiclist_init(&flush_data_list[i], "Logging flush buffer list", 0);
+    Continuation *flush_cont = new LoggingFlushContinuation(i);
+    if (flush_threads == 1) {
+      sprintf(desc, "[LOG_FLUSH]");
+    } else {
+      sprintf(desc, "[LOG_FLUSH %d]", i);
+    }
+    eventProcessor.spawn_thread(flush_cont, desc, stacksize);
+  }
+}
+
+/*-------------------------------------------------------------------------
+  Log::add_to_flush_queue
+
+  Hand data that is ready to be written to the flush thread of its file.
+  -------------------------------------------------------------------------*/
+
+void
+Log::add_to_flush_queue(LogFlushData *fdata)
+{
+  int idx = fdata->m_logfile->m_flush_thread % flush_threads;
+
+  RecIncrRawStat(log_rsb, this_thread()->mutex->thread_holding, log_stat_flush_queue_depth_stat, 1);
+  ink_atomiclist_push(&flush_data_list[idx], fdata);
+  flush_notify[idx].signal();
 }
 
 /*-------------------------------------------------------------------------
@@ -1064,6 +1113,8 @@ Log::create_threads()
 int
 Log::access(LogAccess *lad)
 {
+  AtsMemTagScope mem_tag(ATS_MEM_TAG_LOGGING);
+
   // See if transaction logging is disabled
   //
   if (!transaction_logging_enabled()) {
@@ -1221,7 +1272,8 @@ Log::trace_va(bool in, const sockaddr *peer_addr, uint16_t peer_port, const char
 void *
 Log::preproc_thread_main(void *args)
 {
-  int idx = *(int *)args;
+  int idx     = *(int *)args;
+  ats_mem_tag = ATS_MEM_TAG_LOGGING;
 
   Debug("log-preproc", "log preproc thread is alive ...");
 
@@ -1257,23 +1309,121 @@ Log::preproc_thread_main(void *args)
   return nullptr;
 }
 
-void *
-Log::flush_thread_main(void * /* args ATS_UNUSED */)
+/*-------------------------------------------------------------------------
+  write_flush_data
+
+  Write the data of one flush to its file, on the flush thread of the file.
+  -------------------------------------------------------------------------*/
+
+static void
+write_flush_data(LogFlushData *fdata, ProxyMutex *mutex)
 {
   LogBuffer *logbuffer;
+  int len;
+  int total_bytes   = 0;
+  char *buf         = nullptr;
+  int bytes_written = 0;
+  LogFile *logfile  = fdata->m_logfile.get();
+
+  if (fdata->m_data == nullptr) {
+    // only marks the end of a buffer that had nothing to write
+    return;
+  }
+
+  if (logfile->m_file_format == LOG_FILE_BINARY) {
+    logbuffer                      = static_cast<LogBuffer *>(fdata->m_data);
+    LogBufferHeader *buffer_header = logbuffer->header();
+
+    buf         = (char *)buffer_header;
+    total_bytes = buffer_header->byte_count;
+
+  } else if (logfile->m_file_format == LOG_FILE_ASCII || logfile->m_file_format == LOG_FILE_PIPE ||
+             logfile->m_file_format == LOG_FILE_COLUMNAR) {
+    buf         = (char *)fdata->m_data;
+    total_bytes = fdata->m_len;
+
+  } else {
+    ink_release_assert(!"Unknown file format type!");
+  }
+
+  // make sure we're open & ready to write
+  logfile->check_fd();
+  if (!logfile->is_open()) {
+    // a sink that is down was reported when it could not connect
+    if (logfile->m_net_sink) {
+      Debug("log-net", "Sink:%s is not connected, have dropped (%d) bytes.", logfile->get_name(), total_bytes);
+    } else {
+      Warning("File:%s was closed, have dropped (%d) bytes.", logfile->get_name(), total_bytes);
+    }
+
+    RecIncrRawStat(log_rsb, mutex->thread_holding, log_stat_bytes_lost_before_written_to_disk_stat, total_bytes);
+    return;
+  }
+
+  if (logfile->m_net_sink) {
+    // a network sink takes all of the data without blocking, or drops it
+    if (logfile->m_net_sink->write(buf, total_bytes) < 0) {
+      RecIncrRawStat(log_rsb, mutex->thread_holding, log_stat_bytes_lost_before_written_to_disk_stat, total_bytes);
+    } else {
+      bytes_written = total_bytes;
+    }
+  } else {
+    int logfilefd = logfile->get_fd();
+    // This should always be true because we just checked it.
+    ink_assert(logfilefd >= 0);
+
+    // write *all* data to target file as much as possible
+    //
+    while (total_bytes - bytes_written) {
+      if (Log::config->logging_space_exhausted) {
+        Debug("log", "logging space exhausted, failed to write file:%s, have dropped (%d) bytes.", logfile->get_name(),
+              (total_bytes - bytes_written));
+
+        RecIncrRawStat(log_rsb, mutex->thread_holding, log_stat_bytes_lost_before_written_to_disk_stat,
+                       total_bytes - bytes_written);
+        break;
+      }
+
+      len = ::write(logfilefd, &buf[bytes_written], total_bytes - bytes_written);
+
+      if (len < 0) {
+        Error("Failed to write log to %s: [tried %d, wrote %d, %s]", logfile->get_name(), total_bytes - bytes_written,
+              bytes_written, strerror(errno));
+
+        RecIncrRawStat(log_rsb, mutex->thread_holding, log_stat_bytes_lost_before_written_to_disk_stat,
+                       total_bytes - bytes_written);
+        break;
+      }
+      Debug("log", "Successfully wrote some stuff to %s", logfile->get_name());
+      bytes_written += len;
+    }
+  }
+
+  RecIncrRawStat(log_rsb, mutex->thread_holding, log_stat_bytes_written_to_disk_stat, bytes_written);
+
+  if (logfile->m_log) {
+    ink_atomic_increment(&logfile->m_log->m_bytes_written, bytes_written);
+  }
+}
+
+void *
+Log::flush_thread_main(void *args)
+{
+  int idx = *(int *)args;
   LogFlushData *fdata;
   ink_hrtime now, last_time = 0;
-  int len, total_bytes;
   SLL<LogFlushData, LogFlushData::Link_link> link, invert_link;
+  std::vector<LogFile *> files;
   ProxyMutex *mutex = this_thread()->mutex.get();
+  ats_mem_tag       = ATS_MEM_TAG_LOGGING;
 
-  Log::flush_notify->lock();
+  Log::flush_notify[idx].lock();
 
   while (true) {
     if (TSSystemState::is_event_system_shut_down()) {
       return nullptr;
     }
-    fdata = static_cast<LogFlushData *>(ink_atomiclist_popall(flush_data_list));
+    fdata = static_cast<LogFlushData *>(ink_atomiclist_popall(&flush_data_list[idx]));
 
     // invert the list
     //
@@ -1282,81 +1432,49 @@ Log::flush_thread_main(void * /* args ATS_UNUSED */)
       invert_link.push(fdata);
     }
 
-    // process each flush data
+    // The buffers of a file are converted by several preproc threads at
+    // once, so they arrive out of order. Hold each piece with its file
+    // until the pieces of all the buffers before it are written.
     //
     while ((fdata = invert_link.pop())) {
-      char *buf         = nullptr;
-      int bytes_written = 0;
-      LogFile *logfile  = fdata->m_logfile.get();
-
-      if (logfile->m_file_format == LOG_FILE_BINARY) {
-        logbuffer                      = static_cast<LogBuffer *>(fdata->m_data);
-        LogBufferHeader *buffer_header = logbuffer->header();
-
-        buf         = (char *)buffer_header;
-        total_bytes = buffer_header->byte_count;
-
-      } else if (logfile->m_file_format == LOG_FILE_ASCII || logfile->m_file_format == LOG_FILE_PIPE) {
-        buf         = (char *)fdata->m_data;
-        total_bytes = fdata->m_len;
-
-      } else {
-        ink_release_assert(!"Unknown file format type!");
-      }
-
-      // make sure we're open & ready to write
-      logfile->check_fd();
-      if (!logfile->is_open()) {
-        Warning("File:%s was closed, have dropped (%d) bytes.", logfile->get_name(), total_bytes);
-
-        RecIncrRawStat(log_rsb, mutex->thread_holding, log_stat_bytes_lost_before_written_to_disk_stat, total_bytes);
-        delete fdata;
-        continue;
+      LogFile *logfile = fdata->m_logfile.get();
+      logfile->m_flush_held.emplace(fdata->m_seq, fdata);
+      if (std::find(files.begin(), files.end(), logfile) == files.end()) {
+        files.push_back(logfile);
       }
+    }
 
-      int logfilefd = logfile->get_fd();
-      // This should always be true because we just checked it.
-      ink_assert(logfilefd >= 0);
-
-      // write *all* data to target file as much as possible
-      //
-      while (total_bytes - bytes_written) {
-        if (Log::config->logging_space_exhausted) {
-          Debug("log", "logging space exhausted, failed to write file:%s, have dropped (%d) bytes.", logfile->get_name(),
-                (total_bytes - bytes_written));
-
-          RecIncrRawStat(log_rsb, mutex->thread_holding, log_stat_bytes_lost_before_written_to_disk_stat,
-                         total_bytes - bytes_written);
-          break;
+    for (LogFile *logfile : files) {
+      auto &held = logfile->m_flush_held;
+      while (!held.empty()) {
+        auto spot = held.begin();
+        if (spot->first != logfile->m_flush_next) {
+          if (held.size() < FLUSH_HELD_MAX) {
+            break;
+          }
+          // The gap is not going to close, don't hold the file back any longer.
+          Warning("Log buffer %" PRIu64 " of %s never came to be written, skipping it.", logfile->m_flush_next,
+                  logfile->get_name());
+          logfile->m_flush_next = spot->first;
         }
-
-        len = ::write(logfilefd, &buf[bytes_written], total_bytes - bytes_written);
-
-        if (len < 0) {
-          Error("Failed to write log to %s: [tried %d, wrote %d, %s]", logfile->get_name(), total_bytes - bytes_written,
-                bytes_written, strerror(errno));
-
-          RecIncrRawStat(log_rsb, mutex->thread_holding, log_stat_bytes_lost_before_written_to_disk_stat,
-                         total_bytes - bytes_written);
-          break;
+        fdata = spot->second;
+        held.erase(spot);
+        if (fdata->m_last) {
+          logfile->m_flush_next = fdata->m_seq + 1;
         }
-        Debug("log", "Successfully wrote some stuff to %s", logfile->get_name());
-        bytes_written += len;
-      }
-
-      RecIncrRawStat(log_rsb, mutex->thread_holding, log_stat_bytes_written_to_disk_stat, bytes_written);
-
-      if (logfile->m_log) {
-        ink_atomic_increment(&logfile->m_log->m_bytes_written, bytes_written);
+        write_flush_data(fdata, mutex);
+        RecIncrRawStat(log_rsb, mutex->thread_holding, log_stat_flush_queue_depth_stat, -1);
+        // last, as this may release the file
+        delete fdata;
       }
-
-      delete fdata;
     }
+    files.clear();
 
     // Time to work on periodic events??
+    // They are for the whole of logging, the first flush thread runs them.
     //
     now = Thread::get_hrtime() / HRTIME_SECOND;
-    if (now >= last_time + periodic_tasks_interval) {
+    if (idx == 0 && now >= last_time + periodic_tasks_interval) {
       Debug("log-preproc", "periodic tasks for %" PRId64, (int64_t)now);
       periodic_tasks(now);
       last_time = Thread::get_hrtime() / HRTIME_SECOND;
@@ -1366,10 +1484,10 @@ Log::flush_thread_main(void * /* args ATS_UNUSED */)
     // check the queue and find there is nothing to do, then wait
     // again.
     //
-    Log::flush_notify->wait();
+    Log::flush_notify[idx].wait();
   }
 
   /* NOTREACHED */
-  Log::flush_notify->unlock();
+  Log::flush_notify[idx].unlock();
   return nullptr;
 }
@@ -81,17 +81,22 @@ public:
   LogBuffer *logbuffer = nullptr;
   void *m_data;
   int m_len;
+  uint64_t m_seq = 0;    // the buffer this data comes from, in the order of the file
+  bool m_last    = true; // whether it is the last data of that buffer
 
   LogFlushData(LogFile *logfile, void *data, int len = -1) : m_logfile(logfile), m_data(data), m_len(len) {}
   ~LogFlushData()
   {
     switch (m_logfile->m_file_format) {
     case LOG_FILE_BINARY:
-      logbuffer = static_cast<LogBuffer *>(m_data);
-      LogBuffer::destroy(logbuffer);
+      if (m_data) {
+        logbuffer = static_cast<LogBuffer *>(m_data);
+        LogBuffer::destroy(logbuffer);
+      }
       break;
     case LOG_FILE_ASCII:
     case LOG_FILE_PIPE:
+    case LOG_FILE_COLUMNAR:
       free(m_data);
       break;
     case N_LOGFILE_TYPES:
@@ -191,8 +196,10 @@ public:
   static EventNotify *flush_notify;
   static InkAtomicList *flush_data_list;
   static void *flush_thread_main(void *args);
+  static void add_to_flush_queue(LogFlushData *fdata);
 
   static int preproc_threads;
+  static int flush_threads;
 
   // reconfiguration stuff
   static void change_configuration();
@@ -25,6 +25,7 @@
 #include "LogAccess.h"
 
 #include "http/HttpSM.h"
+#include "ProxyProtocol.h"
 #include "MIME.h"
 #include "I_Machine.h"
 #include "LogFormat.h"
@@ -1100,6 +1101,26 @@ resolve_logfield_string(LogAccess *context, const char *format_str)
     ats_free(fields_str);
     return nullptr;
   }
+
+  char *result = resolve_logfield_string(context, &fields, printf_str);
+
+  ats_free(printf_str);
+  ats_free(fields_str);
+
+  return result;
+}
+
+/*-------------------------------------------------------------------------
+  resolve_logfield_string
+
+  As above, for a format string that LogFormat::parse_format_string() and
+  LogFormat::parse_symbol_string() have already divided into its printf
+  string and its fields, so that a format used again and again is only
+  parsed once.
+  -------------------------------------------------------------------------*/
+char *
+resolve_logfield_string(LogAccess *context, LogFieldList *fields, char *printf_str)
+{
   //
   // Ok, now marshal the data out of the LogAccess object and into a
   // temporary storage buffer.  Make sure the LogAccess context is
@@ -1107,9 +1128,9 @@ resolve_logfield_string(LogAccess *context, const char *format_str)
   //
   Debug("log-resolve", "Marshaling data from LogAccess into buffer ...");
   context->init();
-  unsigned bytes_needed = fields.marshal_len(context);
+  unsigned bytes_needed = fields->marshal_len(context);
   char *buf             = (char *)ats_malloc(bytes_needed);
-  unsigned bytes_used   = fields.marshal(context, buf);
+  unsigned bytes_used   = fields->marshal(context, buf);
 
   ink_assert(bytes_needed == bytes_used);
   Debug("log-resolve", "    %u bytes marshalled", bytes_used);
@@ -1122,7 +1143,7 @@ resolve_logfield_string(LogAccess *context, const char *format_str)
   //
   char *result = (char *)ats_malloc(8192);
   unsigned bytes_resolved =
-    LogBuffer::resolve_custom_entry(&fields, printf_str, buf, result, 8191, LogUtils::timestamp(), 0, LOG_SEGMENT_VERSION);
+    LogBuffer::resolve_custom_entry(fields, printf_str, buf, result, 8191, LogUtils::timestamp(), 0, LOG_SEGMENT_VERSION);
   ink_assert(bytes_resolved < 8192);
 
   if (!bytes_resolved) {
@@ -1132,8 +1153,6 @@ resolve_logfield_string(LogAccess *context, const char *format_str)
     result[bytes_resolved] = 0; // NULL terminate
   }
 
-  ats_free(printf_str);
-  ats_free(fields_str);
   ats_free(buf);
 
   return result;
@@ -1774,6 +1793,27 @@ LogAccess::marshal_client_req_id(char *buf)
   return INK_MIN_ALIGN;
 }
 
+/*-------------------------------------------------------------------------
+  -------------------------------------------------------------------------*/
+
+int64_t
+LogAccess::transaction_id() const
+{
+  return m_http_sm ? m_http_sm->sm_id : 0;
+}
+
+/*-------------------------------------------------------------------------
+  -------------------------------------------------------------------------*/
+
+int
+LogAccess::marshal_sample_weight(char *buf)
+{
+  if (buf) {
+    marshal_int(buf, m_sample_weight);
+  }
+  return INK_MIN_ALIGN;
+}
+
 /*-------------------------------------------------------------------------
   -------------------------------------------------------------------------*/
 
@@ -1869,6 +1909,41 @@ LogAccess::marshal_client_security_curve(char *buf)
   return round_len;
 }
 
+/*-------------------------------------------------------------------------
+  The TLVs of the PROXY v2 header the client connection came with.
+  -------------------------------------------------------------------------*/
+
+int
+LogAccess::marshal_client_pp_tlv(char *buf, uint8_t type)
+{
+  std::string_view value = m_http_sm->t_state.pp_info.get_tlv(type);
+  int len                = round_strlen(value.size() + 1); // +1 for eos
+
+  if (buf) {
+    marshal_mem(buf, value.data(), value.size(), len);
+  }
+
+  return len;
+}
+
+int
+LogAccess::marshal_client_pp_unique_id(char *buf)
+{
+  return marshal_client_pp_tlv(buf, PP2_TYPE_UNIQUE_ID);
+}
+
+int
+LogAccess::marshal_client_pp_authority(char *buf)
+{
+  return marshal_client_pp_tlv(buf, PP2_TYPE_AUTHORITY);
+}
+
+int
+LogAccess::marshal_client_pp_ssl_version(char *buf)
+{
+  return marshal_client_pp_tlv(buf, PP2_SUBTYPE_SSL_VERSION);
+}
+
 /*-------------------------------------------------------------------------
   -------------------------------------------------------------------------*/
 
@@ -154,6 +154,9 @@ public:
   inkcoreapi int marshal_client_security_protocol(char *);      // STR
   inkcoreapi int marshal_client_security_cipher_suite(char *);  // STR
   inkcoreapi int marshal_client_security_curve(char *);         // STR
+  inkcoreapi int marshal_client_pp_unique_id(char *);           // STR
+  inkcoreapi int marshal_client_pp_authority(char *);           // STR
+  inkcoreapi int marshal_client_pp_ssl_version(char *);         // STR
   inkcoreapi int marshal_client_finish_status_code(char *);     // INT
   inkcoreapi int marshal_client_req_id(char *);                 // INT
   inkcoreapi int marshal_client_req_uuid(char *);               // STR
@@ -248,6 +251,15 @@ public:
   inkcoreapi int marshal_client_http_connection_id(char *);  // INT
   inkcoreapi int marshal_client_http_transaction_id(char *); // INT
   inkcoreapi int marshal_cache_lookup_url_canon(char *);     // STR
+  inkcoreapi int marshal_sample_weight(char *);              // INT
+
+  // The id used to sample the transactions, and the weight of the entry of the object being marshalled.
+  int64_t transaction_id() const;
+  void
+  set_sample_weight(int64_t weight)
+  {
+    m_sample_weight = weight;
+  }
 
   // named fields from within a http header
   //
@@ -333,6 +345,7 @@ public:
 
 private:
   HttpSM *m_http_sm;
+  int64_t m_sample_weight = 1;
 
   Arena m_arena;
 
@@ -365,6 +378,8 @@ private:
   void validate_unmapped_url_path();
 
   void validate_lookup_url();
+
+  int marshal_client_pp_tlv(char *buf, uint8_t type);
 };
 
 inline int
@@ -405,3 +420,4 @@ LogAccess::marshal_int(char *dest, int64_t source)
   -------------------------------------------------------------------------*/
 
 char *resolve_logfield_string(LogAccess *context, const char *format_str);
+char *resolve_logfield_string(LogAccess *context, LogFieldList *fields, char *printf_str);
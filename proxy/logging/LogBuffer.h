@@ -221,8 +221,9 @@ private:
 
   uint32_t m_id; // unique buffer id (for debugging)
 public:
-  LB_State m_state; // buffer state
-  int m_references; // oustanding checkout_write references.
+  LB_State m_state;         // buffer state
+  int m_references;         // oustanding checkout_write references.
+  uint64_t m_flush_seq = 0; // the order in which the file of the buffer writes it
 
   // noncopyable
   // -- member functions that are not allowed --
@@ -44,5 +44,10 @@ public:
   // return 0 if success, -1 on error.
   //
   virtual int preproc_and_try_delete(LogBuffer *buffer) = 0;
+  //
+  // The drop_buffer() function is told of a buffer that is deleted
+  // instead, as the sink may be waiting for it.
+  //
+  virtual void drop_buffer(LogBuffer *buffer) = 0;
   virtual ~LogBufferSink(){};
 };
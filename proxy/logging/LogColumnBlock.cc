@@ -0,0 +1,299 @@
+/** @file
+
+  Columnar, compressed blocks of log entries.
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  @section description
+  Grouping the values of each field makes them compress much better than
+  the rows of a LogBuffer do: the same hosts, methods, status codes and
+  URL prefixes repeat within a column, and deflate replaces the repeats by
+  references into its window. A reader also only inflates the columns of
+  the fields it wants.
+ */
+
+#include "LogColumnBlock.h"
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+#include <zlib.h>
+
+#include "tscore/ink_align.h"
+#include "tscore/ink_memory.h"
+#include "tscore/Diags.h"
+#include "LogBuffer.h"
+#include "LogField.h"
+#include "LogFormat.h"
+#include "LogLimits.h"
+
+namespace
+{
+void
+append(std::vector<char> &column, const void *data, size_t len)
+{
+  const char *p = static_cast<const char *>(data);
+  column.insert(column.end(), p, p + len);
+}
+
+void
+append_str(std::vector<char> &meta, uint32_t *offset, const char *str)
+{
+  *offset = 0;
+  if (str) {
+    *offset = meta.size();
+    append(meta, str, strlen(str) + 1);
+  }
+}
+
+bool
+inflate_column(const LogColumnHeader &col, const char *packed, std::vector<char> &raw)
+{
+  uLongf raw_len = col.raw_len;
+  raw.resize(col.raw_len);
+  return uncompress(reinterpret_cast<Bytef *>(raw.data()), &raw_len, reinterpret_cast<const Bytef *>(packed), col.packed_len) ==
+           Z_OK &&
+         raw_len == col.raw_len;
+}
+} // namespace
+
+LogColumnBlockHeader *
+LogColumnBlock::encode(LogBufferHeader *header)
+{
+  LogFieldList fieldlist;
+  if (header->format_type == LOG_FORMAT_CUSTOM && header->fmt_fieldlist()) {
+    bool contains_aggregates = false;
+    LogFormat::parse_symbol_string(header->fmt_fieldlist(), &fieldlist, &contains_aggregates);
+  }
+
+  // Text entries are a single string, they are a single column.
+  unsigned n_fields = std::max(fieldlist.count(), 1U);
+  std::vector<std::vector<char>> columns(n_fields + 1);
+  char scratch[LOG_MAX_FORMATTED_LINE];
+
+  LogBufferIterator iter(header);
+  LogEntryHeader *entry;
+  while ((entry = iter.next())) {
+    char *read_from = reinterpret_cast<char *>(entry) + sizeof(LogEntryHeader);
+    char *end       = reinterpret_cast<char *>(entry) + entry->entry_len;
+    LogField *field = fieldlist.first();
+
+    append(columns[0], entry, sizeof(LogEntryHeader));
+    for (unsigned i = 1; i <= n_fields; ++i) {
+      char *start = read_from;
+      if (i == n_fields) {
+        // The last field also takes the padding of the entry.
+        read_from = end;
+      } else {
+        // Unmarshaling is the only way to know where a field ends.
+        field->unmarshal(&read_from, scratch, sizeof(scratch));
+        read_from = std::min(std::max(read_from, start), end);
+        field     = fieldlist.next(field);
+      }
+      uint32_t len = read_from - start;
+      append(columns[0], &len, sizeof(len));
+      append(columns[i], start, len);
+    }
+  }
+
+  uint32_t meta_len = header->data_offset;
+  size_t size       = sizeof(LogColumnBlockHeader) + meta_len + columns.size() * sizeof(LogColumnHeader);
+  for (auto const &column : columns) {
+    size += compressBound(column.size());
+  }
+
+  char *buf                   = static_cast<char *>(ats_malloc(size));
+  LogColumnBlockHeader *block = reinterpret_cast<LogColumnBlockHeader *>(buf);
+  block->cookie               = LOG_COLUMN_COOKIE;
+  block->version              = LOG_COLUMN_VERSION;
+  block->column_count         = columns.size();
+  block->meta_len             = meta_len;
+  block->reserved             = 0;
+  memcpy(block->buffer_header(), header, meta_len);
+
+  LogColumnHeader *dir = reinterpret_cast<LogColumnHeader *>(buf + sizeof(LogColumnBlockHeader) + meta_len);
+  char *packed         = reinterpret_cast<char *>(dir + columns.size());
+  for (unsigned i = 0; i < columns.size(); ++i) {
+    uLongf packed_len = buf + size - packed;
+    if (compress2(reinterpret_cast<Bytef *>(packed), &packed_len, reinterpret_cast<const Bytef *>(columns[i].data()),
+                  columns[i].size(), Z_DEFAULT_COMPRESSION) != Z_OK) {
+      ats_free(buf);
+      return nullptr;
+    }
+    dir[i].raw_len    = columns[i].size();
+    dir[i].packed_len = packed_len;
+    packed += packed_len;
+  }
+  block->byte_count = packed - buf;
+
+  return block;
+}
+
+LogBufferHeader *
+LogColumnBlock::decode(LogColumnBlockHeader *block, const char *symbol_str, const char *printf_str)
+{
+  char *base = reinterpret_cast<char *>(block);
+
+  if (block->cookie != LOG_COLUMN_COOKIE || block->version != LOG_COLUMN_VERSION || block->column_count < 2 ||
+      block->meta_len < sizeof(LogBufferHeader) ||
+      sizeof(LogColumnBlockHeader) + block->meta_len + block->column_count * sizeof(LogColumnHeader) > block->byte_count) {
+    Note("Invalid columnar log block header");
+    return nullptr;
+  }
+
+  LogBufferHeader *meta = block->buffer_header();
+  LogColumnHeader *dir  = reinterpret_cast<LogColumnHeader *>(base + sizeof(LogColumnBlockHeader) + block->meta_len);
+  unsigned n_fields     = block->column_count - 1;
+
+  std::vector<const char *> packed(block->column_count);
+  size_t offset = reinterpret_cast<char *>(dir + block->column_count) - base;
+  for (unsigned i = 0; i < block->column_count; ++i) {
+    packed[i] = base + offset;
+    offset += dir[i].packed_len;
+    if (offset > block->byte_count) {
+      Note("Invalid columnar log block directory");
+      return nullptr;
+    }
+  }
+
+  // The columns of the fields of the buffer, in order.
+  std::vector<unsigned> wanted;
+  if (symbol_str) {
+    LogFieldList fields, projected;
+    bool contains_aggregates = false;
+    if (meta->format_type == LOG_FORMAT_CUSTOM && meta->fmt_fieldlist()) {
+      LogFormat::parse_symbol_string(meta->fmt_fieldlist(), &fields, &contains_aggregates);
+    }
+    if (fields.count() != n_fields || printf_str == nullptr) {
+      Note("Fields can't be selected from this columnar log block");
+      return nullptr;
+    }
+    LogFormat::parse_symbol_string(symbol_str, &projected, &contains_aggregates);
+    for (LogField *want = projected.first(); want; want = projected.next(want)) {
+      unsigned i      = 1;
+      LogField *field = fields.first();
+      for (; field && !(*field == *want); field = fields.next(field)) {
+        ++i;
+      }
+      if (field == nullptr) {
+        Note("Field %s is not in this columnar log block", want->symbol());
+        return nullptr;
+      }
+      wanted.push_back(i);
+    }
+  } else {
+    for (unsigned i = 1; i <= n_fields; ++i) {
+      wanted.push_back(i);
+    }
+  }
+
+  std::vector<std::vector<char>> raw(block->column_count);
+  std::vector<bool> inflated(block->column_count, false);
+  if (!inflate_column(dir[0], packed[0], raw[0])) {
+    Note("Invalid columnar log block entries");
+    return nullptr;
+  }
+  for (unsigned i : wanted) {
+    if (!inflated[i]) {
+      if (!inflate_column(dir[i], packed[i], raw[i])) {
+        Note("Invalid columnar log block column %u", i);
+        return nullptr;
+      }
+      inflated[i] = true;
+    }
+  }
+
+  size_t stride = sizeof(LogEntryHeader) + n_fields * sizeof(uint32_t);
+  if (raw[0].size() != meta->entry_count * stride) {
+    Note("Invalid columnar log block entries");
+    return nullptr;
+  }
+
+  std::vector<char> header;
+  if (symbol_str) {
+    LogBufferHeader h;
+    const char *name = meta->fmt_name_offset ? reinterpret_cast<char *>(meta) + meta->fmt_name_offset : nullptr;
+    memcpy(&h, meta, sizeof(h));
+    append(header, &h, sizeof(h));
+    append_str(header, &h.fmt_name_offset, name);
+    append_str(header, &h.fmt_fieldlist_offset, symbol_str);
+    append_str(header, &h.fmt_printf_offset, printf_str);
+    append_str(header, &h.src_hostname_offset, meta->src_hostname());
+    append_str(header, &h.log_filename_offset, meta->log_filename());
+    memcpy(header.data(), &h, sizeof(h));
+  } else {
+    append(header, meta, block->meta_len);
+  }
+  header.resize(INK_ALIGN_DEFAULT(header.size()), 0);
+
+  // Walk the entries once for the size of the buffer, and once to fill it.
+  std::vector<uint32_t> field_offsets(block->column_count);
+  std::vector<uint32_t> lens(n_fields);
+  size_t size = header.size();
+  for (int pass = 0; pass < 2; ++pass) {
+    char *buf = nullptr;
+    if (pass == 1) {
+      buf = static_cast<char *>(ats_malloc(size));
+      memcpy(buf, header.data(), header.size());
+      size = header.size();
+    }
+    std::fill(field_offsets.begin(), field_offsets.end(), 0);
+
+    for (uint32_t n = 0; n < meta->entry_count; ++n) {
+      const char *entry = raw[0].data() + n * stride;
+      memcpy(lens.data(), entry + sizeof(LogEntryHeader), n_fields * sizeof(uint32_t));
+
+      size_t entry_len = sizeof(LogEntryHeader);
+      for (unsigned i : wanted) {
+        if (field_offsets[i] + lens[i - 1] > raw[i].size()) {
+          Note("Invalid columnar log block column %u", i);
+          return nullptr;
+        }
+        entry_len += lens[i - 1];
+      }
+      entry_len = INK_ALIGN_DEFAULT(entry_len);
+
+      if (buf) {
+        char *write_to = buf + size;
+        // Zero the padding, as the buffer does.
+        memset(write_to, 0, entry_len);
+        memcpy(write_to, entry, sizeof(LogEntryHeader));
+        reinterpret_cast<LogEntryHeader *>(write_to)->entry_len = entry_len;
+        write_to += sizeof(LogEntryHeader);
+        for (unsigned i : wanted) {
+          memcpy(write_to, raw[i].data() + field_offsets[i], lens[i - 1]);
+          write_to += lens[i - 1];
+        }
+      }
+      size += entry_len;
+      for (unsigned i = 1; i <= n_fields; ++i) {
+        field_offsets[i] += lens[i - 1];
+      }
+    }
+
+    if (buf) {
+      LogBufferHeader *out = reinterpret_cast<LogBufferHeader *>(buf);
+      out->byte_count      = size;
+      out->data_offset     = header.size();
+      return out;
+    }
+  }
+
+  return nullptr;
+}
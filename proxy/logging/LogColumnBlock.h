@@ -0,0 +1,82 @@
+/** @file
+
+  Columnar, compressed blocks of log entries.
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ */
+
+#pragma once
+
+#include "tscore/ink_platform.h"
+
+struct LogBufferHeader;
+
+#define LOG_COLUMN_COOKIE 0xc01face
+#define LOG_COLUMN_VERSION 1
+
+/*-------------------------------------------------------------------------
+  LogColumnBlockHeader
+
+  A columnar log file is a sequence of blocks, one for each LogBuffer. The
+  LogBufferHeader of the buffer, with its strings, follows this header as
+  is, so the time range and the format of a block are known without
+  decompressing it. Then comes a LogColumnHeader for each column, and the
+  deflated columns themselves. The first column has, for each entry, its
+  LogEntryHeader and the length of each of its fields; every other column
+  has the values of one field for all the entries.
+  -------------------------------------------------------------------------*/
+
+struct LogColumnBlockHeader {
+  uint32_t cookie;       // so we can find it on disk
+  uint32_t version;      // in case we want to change it later
+  uint32_t byte_count;   // of the whole block
+  uint32_t column_count; // the fields, plus the entry column
+  uint32_t meta_len;     // bytes of the LogBufferHeader and its strings
+  uint32_t reserved;
+
+  LogBufferHeader *
+  buffer_header()
+  {
+    return reinterpret_cast<LogBufferHeader *>(this + 1);
+  }
+};
+
+struct LogColumnHeader {
+  uint32_t raw_len;    // bytes of the column
+  uint32_t packed_len; // bytes of the column deflated
+};
+
+namespace LogColumnBlock
+{
+/** Convert a buffer of entries to a columnar block.
+
+    @return The block, to be freed with @c ats_free, or @c nullptr if it can't be compressed.
+ */
+LogColumnBlockHeader *encode(LogBufferHeader *header);
+
+/** Convert a columnar block back to a buffer of entries.
+
+    Only the columns of the fields in @a symbol_str are decompressed, and the buffer has only
+    them, to be printed with @a printf_str. Without @a symbol_str the buffer has all the fields.
+
+    @return The buffer, to be freed with @c ats_free, or @c nullptr if the block is corrupt or
+    doesn't have all the fields.
+ */
+LogBufferHeader *decode(LogColumnBlockHeader *block, const char *symbol_str = nullptr, const char *printf_str = nullptr);
+} // namespace LogColumnBlock
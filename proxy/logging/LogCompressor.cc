@@ -0,0 +1,328 @@
+/** @file
+
+  Compression of the rolled log files in the background.
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ */
+
+#include "LogCompressor.h"
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <memory>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "tscore/ink_config.h"
+#include "tscore/Diags.h"
+#include "I_EventSystem.h"
+#include "I_Tasks.h"
+
+#ifdef HAVE_ZLIB_H
+#include <zlib.h>
+#endif
+#ifdef HAVE_ZSTD_H
+#include <zstd.h>
+#endif
+
+namespace
+{
+// How much of the file is read and compressed by one event.
+constexpr size_t CHUNK_SIZE = 256 * 1024;
+
+const char *
+format_extension(int format)
+{
+  return format == LogCompressor::GZIP ? ".gz" : ".zst";
+}
+} // namespace
+
+ink_mutex LogCompressor::_queue_mutex = PTHREAD_MUTEX_INITIALIZER;
+LogCompressor *LogCompressor::_instance;
+
+struct LogCompressor::Stream {
+  int format;
+  int in_fd  = -1;
+  int out_fd = -1;
+  struct stat in_stat;
+  std::string out_path;
+  std::string tmp_path;
+  std::unique_ptr<char[]> in_buf{new char[CHUNK_SIZE]};
+  std::unique_ptr<char[]> out_buf{new char[CHUNK_SIZE]};
+#ifdef HAVE_ZLIB_H
+  z_stream zs;
+  bool zs_init = false;
+#endif
+#ifdef HAVE_ZSTD_H
+  ZSTD_CCtx *cctx = nullptr;
+#endif
+
+  explicit Stream(int f) : format(f) {}
+
+  ~Stream()
+  {
+    if (in_fd >= 0) {
+      ::close(in_fd);
+    }
+    if (out_fd >= 0) {
+      ::close(out_fd);
+    }
+#ifdef HAVE_ZLIB_H
+    if (zs_init) {
+      deflateEnd(&zs);
+    }
+#endif
+#ifdef HAVE_ZSTD_H
+    ZSTD_freeCCtx(cctx);
+#endif
+  }
+
+  bool
+  write_out(size_t len)
+  {
+    const char *p = out_buf.get();
+    while (len > 0) {
+      ssize_t n = ::write(out_fd, p, len);
+      if (n < 0) {
+        if (errno == EINTR) {
+          continue;
+        }
+        return false;
+      }
+      p   += n;
+      len -= n;
+    }
+    return true;
+  }
+
+  /// Compress @a len bytes of the input, which are the last ones if @a eof.
+  bool
+  deflate_chunk(size_t len, bool eof)
+  {
+#ifdef HAVE_ZLIB_H
+    if (format == GZIP) {
+      zs.next_in  = reinterpret_cast<Bytef *>(in_buf.get());
+      zs.avail_in = len;
+      do {
+        zs.next_out  = reinterpret_cast<Bytef *>(out_buf.get());
+        zs.avail_out = CHUNK_SIZE;
+        if (deflate(&zs, eof ? Z_FINISH : Z_NO_FLUSH) == Z_STREAM_ERROR || !write_out(CHUNK_SIZE - zs.avail_out)) {
+          return false;
+        }
+      } while (zs.avail_out == 0);
+      return true;
+    }
+#endif
+#ifdef HAVE_ZSTD_H
+    if (format == ZSTD) {
+      ZSTD_inBuffer in = {in_buf.get(), len, 0};
+      bool finished    = false;
+      while (!finished) {
+        ZSTD_outBuffer out = {out_buf.get(), CHUNK_SIZE, 0};
+        size_t remaining   = ZSTD_compressStream2(cctx, &out, &in, eof ? ZSTD_e_end : ZSTD_e_continue);
+        if (ZSTD_isError(remaining) || !write_out(out.pos)) {
+          return false;
+        }
+        finished = eof ? remaining == 0 : in.pos == in.size;
+      }
+      return true;
+    }
+#endif
+    (void)len;
+    (void)eof;
+    return false;
+  }
+};
+
+bool
+LogCompressor::is_supported(int format)
+{
+  switch (format) {
+#ifdef HAVE_ZLIB_H
+  case GZIP:
+    return true;
+#endif
+#ifdef HAVE_ZSTD_H
+  case ZSTD:
+    return true;
+#endif
+  default:
+    return false;
+  }
+}
+
+void
+LogCompressor::compress(const char *path, int format, int64_t rate)
+{
+  if (path == nullptr || !is_supported(format)) {
+    return;
+  }
+
+  ink_scoped_mutex_lock lock(_queue_mutex);
+  if (_instance == nullptr) {
+    _instance = new LogCompressor();
+  }
+  _instance->_queue.push_back({path, format, rate});
+  if (!_instance->_scheduled) {
+    _instance->_scheduled = true;
+    eventProcessor.schedule_imm(_instance, ET_TASK);
+  }
+}
+
+LogCompressor::LogCompressor() : Continuation(new_ProxyMutex())
+{
+  SET_HANDLER(&LogCompressor::compress_event);
+}
+
+int
+LogCompressor::compress_event(int /* event ATS_UNUSED */, void * /* data ATS_UNUSED */)
+{
+  if (_stream == nullptr) {
+    {
+      ink_scoped_mutex_lock lock(_queue_mutex);
+      if (_queue.empty()) {
+        _scheduled = false;
+        return EVENT_DONE;
+      }
+      _job = std::move(_queue.front());
+      _queue.pop_front();
+    }
+    if (!start(_job)) {
+      eventProcessor.schedule_imm(this, ET_TASK);
+      return EVENT_DONE;
+    }
+  }
+
+  bool done   = false;
+  ssize_t len = step(done);
+  if (len < 0 || done) {
+    finish(len >= 0);
+  }
+
+  // Pace the reads, and let the other tasks run between the chunks in any case.
+  if (_job.rate > 0 && len > 0) {
+    eventProcessor.schedule_in(this, HRTIME_SECOND * len / _job.rate, ET_TASK);
+  } else {
+    eventProcessor.schedule_imm(this, ET_TASK);
+  }
+  return EVENT_DONE;
+}
+
+bool
+LogCompressor::start(const Job &job)
+{
+  std::unique_ptr<Stream> stream(new Stream(job.format));
+
+  stream->out_path = job.path + format_extension(job.format);
+  stream->tmp_path = stream->out_path + ".tmp";
+  if (::access(stream->out_path.c_str(), F_OK) == 0) {
+    Warning("not compressing the rolled log %s, %s already exists", job.path.c_str(), stream->out_path.c_str());
+    return false;
+  }
+
+  stream->in_fd = ::open(job.path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (stream->in_fd < 0 || ::fstat(stream->in_fd, &stream->in_stat) < 0) {
+    Warning("unable to open the rolled log %s for compression: %s", job.path.c_str(), strerror(errno));
+    return false;
+  }
+#if HAVE_POSIX_FADVISE
+  posix_fadvise(stream->in_fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+
+  stream->out_fd = ::open(stream->tmp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, stream->in_stat.st_mode & 0777);
+  if (stream->out_fd < 0) {
+    Warning("unable to create %s to compress the rolled log %s: %s", stream->tmp_path.c_str(), job.path.c_str(), strerror(errno));
+    return false;
+  }
+
+#ifdef HAVE_ZLIB_H
+  if (job.format == GZIP) {
+    memset(&stream->zs, 0, sizeof(stream->zs));
+    // A window of 15 bits plus 16 writes a gzip header and trailer.
+    stream->zs_init = deflateInit2(&stream->zs, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) == Z_OK;
+    if (!stream->zs_init) {
+      Warning("unable to initialize the compression of the rolled log %s", job.path.c_str());
+      ::unlink(stream->tmp_path.c_str());
+      return false;
+    }
+  }
+#endif
+#ifdef HAVE_ZSTD_H
+  if (job.format == ZSTD) {
+    stream->cctx = ZSTD_createCCtx();
+    if (stream->cctx == nullptr || ZSTD_isError(ZSTD_CCtx_setParameter(stream->cctx, ZSTD_c_compressionLevel, 3))) {
+      Warning("unable to initialize the compression of the rolled log %s", job.path.c_str());
+      ::unlink(stream->tmp_path.c_str());
+      return false;
+    }
+  }
+#endif
+
+  Debug("log-compress", "compressing the rolled log %s to %s", job.path.c_str(), stream->out_path.c_str());
+  _stream = stream.release();
+  return true;
+}
+
+/// Compress the next chunk of the file, set @a done after the last one.
+/// @return The number of bytes read, or -1 on failure.
+ssize_t
+LogCompressor::step(bool &done)
+{
+  ssize_t len;
+  do {
+    len = ::read(_stream->in_fd, _stream->in_buf.get(), CHUNK_SIZE);
+  } while (len < 0 && errno == EINTR);
+  if (len < 0) {
+    Warning("unable to read the rolled log %s for compression: %s", _job.path.c_str(), strerror(errno));
+    return -1;
+  }
+
+  done = len == 0;
+  if (!_stream->deflate_chunk(len, done)) {
+    Warning("unable to write %s to compress the rolled log %s: %s", _stream->tmp_path.c_str(), _job.path.c_str(), strerror(errno));
+    return -1;
+  }
+  return len;
+}
+
+void
+LogCompressor::finish(bool ok)
+{
+  if (ok) {
+    // Keep the age of the rolled file for the trimming of the rolled logs.
+    struct timespec times[2] = {_stream->in_stat.st_atim, _stream->in_stat.st_mtim};
+    futimens(_stream->out_fd, times);
+    ok = ::close(_stream->out_fd) == 0;
+    _stream->out_fd = -1;
+  }
+
+  if (ok && ::rename(_stream->tmp_path.c_str(), _stream->out_path.c_str()) == 0) {
+    ::unlink(_job.path.c_str());
+    Debug("log-compress", "the rolled log %s was compressed to %s", _job.path.c_str(), _stream->out_path.c_str());
+  } else {
+    if (ok) {
+      Warning("unable to rename %s to %s: %s", _stream->tmp_path.c_str(), _stream->out_path.c_str(), strerror(errno));
+    }
+    ::unlink(_stream->tmp_path.c_str());
+  }
+
+  delete _stream;
+  _stream = nullptr;
+}
@@ -0,0 +1,84 @@
+/** @file
+
+  Compression of the rolled log files in the background.
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <sys/types.h>
+
+#include "I_EventSystem.h"
+#include "tscore/ink_mutex.h"
+
+/*-------------------------------------------------------------------------
+  LogCompressor
+
+  Compresses the files that are rolled, instead of leaving that to an
+  external job. The files are compressed one at a time on an ET_TASK
+  thread, a chunk per event, and the reads are paced to the configured
+  rate so that the compression doesn't compete with the logs being
+  written. The compressed file keeps the name of the rolled file plus
+  the extension of the format, and its modification time, so that the
+  trimming of the rolled files still sees the same age.
+  -------------------------------------------------------------------------*/
+
+class LogCompressor : public Continuation
+{
+public:
+  enum Format {
+    NONE = 0,
+    GZIP = 1,
+    ZSTD = 2,
+  };
+
+  /// Whether this build can write @a format.
+  static bool is_supported(int format);
+
+  /// Queue the rolled file @a path to be compressed to @a format, reading at most @a rate bytes per second, if not 0.
+  static void compress(const char *path, int format, int64_t rate);
+
+private:
+  struct Job {
+    std::string path;
+    int format;
+    int64_t rate;
+  };
+  struct Stream;
+
+  LogCompressor();
+
+  int compress_event(int event, void *data);
+  bool start(const Job &job);
+  ssize_t step(bool &done);
+  void finish(bool ok);
+
+  static ink_mutex _queue_mutex;
+  static LogCompressor *_instance;
+
+  std::deque<Job> _queue; ///< Guarded by @a _queue_mutex.
+  bool _scheduled = false;
+
+  Job _job;
+  Stream *_stream = nullptr; ///< The file being compressed.
+};
@@ -41,6 +41,7 @@
 #include "LogFormat.h"
 #include "LogFile.h"
 #include "LogBuffer.h"
+#include "LogCompressor.h"
 #include "LogObject.h"
 #include "LogConfig.h"
 #include "LogUtils.h"
@@ -73,6 +74,8 @@ LogConfig::setup_default_values()
   hostname = ats_strdup(name);
 
   log_buffer_size       = (int)(10 * LOG_KILOBYTE);
+  log_buffer_shards     = 1;
+  net_sink_buffer_size  = LOG_MEGABYTE;
   max_secs_per_buffer   = 5;
   max_space_mb_for_logs = 100;
   max_space_mb_headroom = 10;
@@ -80,6 +83,7 @@ LogConfig::setup_default_values()
   logfile_dir           = ats_strdup(".");
 
   preproc_threads = 1;
+  flush_threads   = 1;
 
   rolling_enabled          = Log::NO_ROLLING;
   rolling_interval_sec     = 86400; // 24 hours
@@ -87,6 +91,8 @@ LogConfig::setup_default_values()
   rolling_size_mb          = 10;
   rolling_max_count        = 0;
   rolling_allow_empty      = false;
+  rolled_compression       = LogCompressor::NONE;
+  rolled_compression_rate  = 20 * LOG_MEGABYTE;
   auto_delete_rolled_files = true;
   roll_log_files_now       = false;
 
@@ -116,6 +122,16 @@ LogConfig::read_configuration_variables()
     log_buffer_size = val;
   }
 
+  val = (int)REC_ConfigReadInteger("proxy.config.log.log_buffer_shards");
+  if (val > 0 && val <= 256) {
+    log_buffer_shards = val;
+  }
+
+  val = (int)REC_ConfigReadInteger("proxy.config.log.net_sink_buffer_size");
+  if (val >= 0) {
+    net_sink_buffer_size = val;
+  }
+
   val = (int)REC_ConfigReadInteger("proxy.config.log.max_secs_per_buffer");
   if (val > 0) {
     max_secs_per_buffer = val;
@@ -159,6 +175,11 @@ LogConfig::read_configuration_variables()
     preproc_threads = val;
   }
 
+  val = (int)REC_ConfigReadInteger("proxy.config.log.flush_threads");
+  if (val > 0 && val <= 128) {
+    flush_threads = val;
+  }
+
   // ROLLING
 
   // we don't check for valid values of rolling_enabled, rolling_interval_sec,
@@ -182,6 +203,19 @@ LogConfig::read_configuration_variables()
   val                 = (int)REC_ConfigReadInteger("proxy.config.log.rolling_allow_empty");
   rolling_allow_empty = (val > 0);
 
+  val = (int)REC_ConfigReadInteger("proxy.config.log.rolled_compression");
+  if (val == LogCompressor::NONE || LogCompressor::is_supported(val)) {
+    rolled_compression = val;
+  } else {
+    Warning("invalid or unsupported value '%d' for '%s', not compressing the rolled logs", val,
+            "proxy.config.log.rolled_compression");
+    rolled_compression = LogCompressor::NONE;
+  }
+  val = (int)REC_ConfigReadInteger("proxy.config.log.rolled_compression_rate_mb");
+  if (val >= 0) {
+    rolled_compression_rate = (int64_t)val * LOG_MEGABYTE;
+  }
+
   // Read in min_count control values for auto deletion
   if (auto_delete_rolled_files) {
     // For diagnostic logs
@@ -324,6 +358,8 @@ LogConfig::display(FILE *fd)
   fprintf(fd, "-----------------------------\n");
   fprintf(fd, "Config variables:\n");
   fprintf(fd, "   log_buffer_size = %d\n", log_buffer_size);
+  fprintf(fd, "   log_buffer_shards = %d\n", log_buffer_shards);
+  fprintf(fd, "   net_sink_buffer_size = %d\n", net_sink_buffer_size);
   fprintf(fd, "   max_secs_per_buffer = %d\n", max_secs_per_buffer);
   fprintf(fd, "   max_space_mb_for_logs = %d\n", max_space_mb_for_logs);
   fprintf(fd, "   max_space_mb_headroom = %d\n", max_space_mb_headroom);
@@ -332,6 +368,7 @@ LogConfig::display(FILE *fd)
   fprintf(fd, "   logfile_perm = 0%o\n", logfile_perm);
 
   fprintf(fd, "   preproc_threads = %d\n", preproc_threads);
+  fprintf(fd, "   flush_threads = %d\n", flush_threads);
   fprintf(fd, "   rolling_enabled = %d\n", rolling_enabled);
   fprintf(fd, "   rolling_interval_sec = %d\n", rolling_interval_sec);
   fprintf(fd, "   rolling_offset_hr = %d\n", rolling_offset_hr);
@@ -339,6 +376,8 @@ LogConfig::display(FILE *fd)
   fprintf(fd, "   rolling_min_count = %d\n", rolling_min_count);
   fprintf(fd, "   rolling_max_count = %d\n", rolling_max_count);
   fprintf(fd, "   rolling_allow_empty = %d\n", rolling_allow_empty);
+  fprintf(fd, "   rolled_compression = %d\n", rolled_compression);
+  fprintf(fd, "   rolled_compression_rate = %" PRId64 "\n", rolled_compression_rate);
   fprintf(fd, "   auto_delete_rolled_files = %d\n", auto_delete_rolled_files);
   fprintf(fd, "   sampling_frequency = %d\n", sampling_frequency);
   fprintf(fd, "   file_stat_frequency = %d\n", file_stat_frequency);
@@ -418,6 +457,8 @@ LogConfig::register_config_callbacks()
     "proxy.config.log.rolling_offset_hr",     "proxy.config.log.rolling_size_mb",     "proxy.config.log.auto_delete_rolled_files",
     "proxy.config.log.rolling_max_count",     "proxy.config.log.rolling_allow_empty", "proxy.config.log.config.filename",
     "proxy.config.log.sampling_frequency",    "proxy.config.log.file_stat_frequency", "proxy.config.log.space_used_frequency",
+    "proxy.config.log.log_buffer_shards",     "proxy.config.log.net_sink_buffer_size",
+    "proxy.config.log.rolled_compression",    "proxy.config.log.rolled_compression_rate_mb",
   };
 
   for (unsigned i = 0; i < countof(names); ++i) {
@@ -458,6 +499,8 @@ LogConfig::register_stat_callbacks()
                      (int)log_stat_event_log_access_full_stat, RecRawStatSyncCount);
   RecRegisterRawStat(log_rsb, RECT_PROCESS, "proxy.process.log.event_log_access_fail", RECD_COUNTER, RECP_PERSISTENT,
                      (int)log_stat_event_log_access_fail_stat, RecRawStatSyncCount);
+  RecRegisterRawStat(log_rsb, RECT_PROCESS, "proxy.process.log.event_log_access_rate_limited", RECD_COUNTER, RECP_PERSISTENT,
+                     (int)log_stat_event_log_access_rate_limited_stat, RecRawStatSyncCount);
   //
   // number vs bytes of logs
   //
@@ -494,6 +537,8 @@ LogConfig::register_stat_callbacks()
                      (int)log_stat_log_files_open_stat, RecRawStatSyncSum);
   RecRegisterRawStat(log_rsb, RECT_PROCESS, "proxy.process.log.log_files_space_used", RECD_INT, RECP_NON_PERSISTENT,
                      (int)log_stat_log_files_space_used_stat, RecRawStatSyncSum);
+  RecRegisterRawStat(log_rsb, RECT_PROCESS, "proxy.process.log.flush_queue_depth", RECD_INT, RECP_NON_PERSISTENT,
+                     (int)log_stat_flush_queue_depth_stat, RecRawStatSyncSum);
 }
 
 /*-------------------------------------------------------------------------
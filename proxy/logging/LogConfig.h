@@ -49,6 +49,7 @@ enum {
   log_stat_event_log_access_aggr_stat,
   log_stat_event_log_access_full_stat,
   log_stat_event_log_access_fail_stat,
+  log_stat_event_log_access_rate_limited_stat,
 
   // Logging Data
   log_stat_num_sent_to_network_stat,
@@ -70,6 +71,7 @@ enum {
   // Logging I/O
   log_stat_log_files_open_stat,
   log_stat_log_files_space_used_stat,
+  log_stat_flush_queue_depth_stat,
 
   log_stat_count
 };
@@ -238,12 +240,15 @@ public:
   LogFormatList format_list;
 
   int log_buffer_size;
+  int log_buffer_shards;
+  int net_sink_buffer_size;
   int max_secs_per_buffer;
   int max_space_mb_for_logs;
   int max_space_mb_headroom;
   int logfile_perm;
 
   int preproc_threads;
+  int flush_threads;
 
   Log::RollingEnabledValues rolling_enabled;
   int rolling_interval_sec;
@@ -252,6 +257,8 @@ public:
   int rolling_min_count;
   int rolling_max_count;
   bool rolling_allow_empty;
+  int rolled_compression;
+  int64_t rolled_compression_rate;
   bool auto_delete_rolled_files;
 
   IntrusiveHashMap<LogDeletingInfoDescriptor> deleting_info;
@@ -716,6 +716,8 @@ LogFieldList::clear()
     delete f; // safe given the semantics stated above
   }
   m_marshal_len = 0;
+  m_program.clear();
+  m_varlen.clear();
   _badSymbols.clear();
 }
 
@@ -725,13 +727,16 @@ LogFieldList::add(LogField *field, bool copy)
   ink_assert(field != nullptr);
 
   if (copy) {
-    m_field_list.enqueue(new LogField(*field));
-  } else {
-    m_field_list.enqueue(field);
+    field = new LogField(*field);
   }
+  m_field_list.enqueue(field);
 
+  MarshalStep step{field->marshal_func(), field};
+  m_program.push_back(step);
   if (field->type() == LogField::sINT) {
     m_marshal_len += INK_MIN_ALIGN;
+  } else {
+    m_varlen.push_back(step);
   }
 }
 
@@ -771,12 +776,10 @@ unsigned
 LogFieldList::marshal_len(LogAccess *lad)
 {
   int bytes = 0;
-  for (LogField *f = first(); f; f = next(f)) {
-    if (f->type() != LogField::sINT) {
-      const int len = f->marshal_len(lad);
-      ink_release_assert(len >= INK_MIN_ALIGN);
-      bytes += len;
-    }
+  for (const MarshalStep &step : m_varlen) {
+    const int len = step.func ? (lad->*step.func)(nullptr) : step.field->marshal_len(lad);
+    ink_release_assert(len >= INK_MIN_ALIGN);
+    bytes += len;
   }
   return m_marshal_len + bytes;
 }
@@ -786,9 +789,9 @@ LogFieldList::marshal(LogAccess *lad, char *buf)
 {
   char *ptr;
   int bytes = 0;
-  for (LogField *f = first(); f; f = next(f)) {
+  for (const MarshalStep &step : m_program) {
     ptr = &buf[bytes];
-    bytes += f->marshal(lad, ptr);
+    bytes += step.func ? (lad->*step.func)(ptr) : step.field->marshal(lad, ptr);
     ink_assert(bytes % INK_MIN_ALIGN == 0);
   }
   return bytes;
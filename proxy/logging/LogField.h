@@ -25,6 +25,7 @@
 
 #include <string_view>
 #include <string>
+#include <vector>
 
 #include "tscore/ink_platform.h"
 #include "tscore/List.h"
@@ -168,6 +169,13 @@ public:
     return m_agg_op;
   }
 
+  /// The LogAccess routine that marshals this field by itself, or @c nullptr if it needs a container.
+  MarshalFunc
+  marshal_func() const
+  {
+    return m_container == NO_CONTAINER ? m_marshal_func : nullptr;
+  }
+
   bool
   is_time_field() const
   {
@@ -264,8 +272,18 @@ public:
   LogFieldList &operator=(const LogFieldList &rhs) = delete;
 
 private:
+  /// A step of the marshalling program of the list.
+  struct MarshalStep {
+    LogField::MarshalFunc func; ///< Called directly, if the field has no container.
+    LogField *field;
+  };
+
   unsigned m_marshal_len = 0;
   Queue<LogField> m_field_list;
+  // The fields flattened once as they are added, so that marshalling an
+  // entry doesn't walk the list or switch on the container of each field.
+  std::vector<MarshalStep> m_program; // every field, in order
+  std::vector<MarshalStep> m_varlen;  // the fields whose length depends on the entry
   std::string _badSymbols;
 };
 
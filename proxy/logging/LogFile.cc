@@ -27,6 +27,7 @@
 
  ***************************************************************************/
 
+#include <atomic>
 #include <vector>
 #include <string>
 #include <algorithm>
@@ -49,12 +50,18 @@
 #include "LogFilter.h"
 #include "LogFormat.h"
 #include "LogBuffer.h"
+#include "LogColumnBlock.h"
+#include "LogCompressor.h"
 #include "LogFile.h"
+#include "LogNetSink.h"
 #include "LogObject.h"
 #include "LogUtils.h"
 #include "LogConfig.h"
 #include "Log.h"
 
+// The files are spread across the flush threads in the order they are created.
+static std::atomic<unsigned> next_flush_thread{0};
+
 /*-------------------------------------------------------------------------
   LogFile::LogFile
 
@@ -70,15 +77,18 @@ LogFile::LogFile(const char *name, const char *header, LogFileFormat format, uin
     m_signature(signature),
     m_max_line_size(max_line_size)
 {
-  if (m_file_format != LOG_FILE_PIPE) {
+  m_log      = nullptr;
+  m_net_sink = nullptr;
+  if (LogNetSink::is_url(name)) {
+    m_net_sink = new LogNetSink(name, Log::config->net_sink_buffer_size);
+  } else if (m_file_format != LOG_FILE_PIPE) {
     m_log = new BaseLogFile(name, m_signature);
     m_log->set_hostname(Machine::instance()->hostname);
-  } else {
-    m_log = nullptr;
   }
 
   m_fd                = -1;
   m_ascii_buffer_size = (ascii_buffer_size < max_line_size ? max_line_size : ascii_buffer_size);
+  m_flush_thread      = next_flush_thread++;
 
   Debug("log-file", "exiting LogFile constructor, m_name=%s, this=%p", m_name, this);
 }
@@ -97,7 +107,8 @@ LogFile::LogFile(const LogFile &copy)
     m_signature(copy.m_signature),
     m_ascii_buffer_size(copy.m_ascii_buffer_size),
     m_max_line_size(copy.m_max_line_size),
-    m_fd(copy.m_fd)
+    m_fd(copy.m_fd),
+    m_flush_thread(next_flush_thread++)
 {
   ink_release_assert(m_ascii_buffer_size >= m_max_line_size);
 
@@ -107,6 +118,13 @@ LogFile::LogFile(const LogFile &copy)
     m_log = nullptr;
   }
 
+  // the copy has its own connection
+  if (copy.m_net_sink) {
+    m_net_sink = new LogNetSink(m_name, Log::config->net_sink_buffer_size);
+  } else {
+    m_net_sink = nullptr;
+  }
+
   Debug("log-file", "exiting LogFile copy constructor, m_name=%s, this=%p", m_name, this);
 }
 /*-------------------------------------------------------------------------
@@ -117,6 +135,7 @@ LogFile::~LogFile()
 {
   Debug("log-file", "entering LogFile destructor, this=%p", this);
   delete m_log;
+  delete m_net_sink;
   ats_free(m_header);
   ats_free(m_name);
   Debug("log-file", "exiting LogFile destructor, this=%p", this);
@@ -165,6 +184,10 @@ LogFile::open_file()
     return LOG_FILE_NO_ERROR;
   }
 
+  if (m_net_sink) {
+    return m_net_sink->open() ? LOG_FILE_NO_ERROR : LOG_FILE_COULD_NOT_OPEN_FILE;
+  }
+
   bool file_exists = LogFile::exists(m_name);
 
   if (m_file_format == LOG_FILE_PIPE) {
@@ -203,7 +226,7 @@ LogFile::open_file()
   // file.
   //
   if (!file_exists) {
-    if (m_file_format != LOG_FILE_BINARY && m_header && m_log) {
+    if (m_file_format != LOG_FILE_BINARY && m_file_format != LOG_FILE_COLUMNAR && m_header && m_log) {
       Debug("log-file", "writing header to LogFile %s", m_name);
       writeln(m_header, strlen(m_header), fileno(m_log->m_fp), m_name);
     }
@@ -224,6 +247,11 @@ LogFile::open_file()
 void
 LogFile::close_file()
 {
+  if (m_net_sink) {
+    m_net_sink->close();
+    return;
+  }
+
   if (is_open()) {
     if (m_file_format == LOG_FILE_PIPE) {
       ::close(m_fd);
@@ -339,6 +367,10 @@ LogFile::roll(long interval_start, long interval_end, bool reopen_after_rolling)
     if (m_log->roll(interval_start, interval_end)) {
       m_log->close_file();
 
+      if (Log::config && Log::config->rolled_compression != LogCompressor::NONE) {
+        LogCompressor::compress(m_log->get_rolled_name(), Log::config->rolled_compression, Log::config->rolled_compression_rate);
+      }
+
       if (reopen_after_rolling) {
         /* If we re-open now log file will be created even if there is nothing being logged */
         m_log->open_file();
@@ -409,26 +441,73 @@ LogFile::preproc_and_try_delete(LogBuffer *lb)
 
     RecIncrRawStat(log_rsb, mutex->thread_holding, log_stat_bytes_flush_to_disk_stat, lb->header()->byte_count);
 
-    ink_atomiclist_push(Log::flush_data_list, flush_data);
-
-    Log::flush_notify->signal();
+    _add_to_flush_queue(flush_data, lb->m_flush_seq, true);
 
     //
     // LogBuffer will be deleted in flush thread
     //
     return 0;
+  } else if (m_file_format == LOG_FILE_COLUMNAR) {
+    //
+    // The buffer is compressed here, on the preproc thread, so that the
+    // flush thread only has the (much smaller) block to write.
+    //
+    LogColumnBlockHeader *block = LogColumnBlock::encode(buffer_header);
+    if (block == nullptr) {
+      Note("Failed to compress LogBuffer for LogFile %s, have dropped (%" PRIu32 ") bytes.", m_name, buffer_header->byte_count);
+      goto done;
+    }
+
+    LogFlushData *flush_data = new LogFlushData(this, block, block->byte_count);
+
+    ProxyMutex *mutex = this_thread()->mutex.get();
+
+    RecIncrRawStat(log_rsb, mutex->thread_holding, log_stat_num_flush_to_disk_stat, buffer_header->entry_count);
+
+    RecIncrRawStat(log_rsb, mutex->thread_holding, log_stat_bytes_flush_to_disk_stat, block->byte_count);
+
+    _add_to_flush_queue(flush_data, lb->m_flush_seq, true);
+    ret = 0;
   } else if (m_file_format == LOG_FILE_ASCII || m_file_format == LOG_FILE_PIPE) {
-    write_ascii_logbuffer3(buffer_header);
+    write_ascii_logbuffer3(buffer_header, nullptr, lb->m_flush_seq);
     ret = 0;
   } else {
     Note("Cannot write LogBuffer to LogFile %s; invalid file format: %d", m_name, m_file_format);
   }
 
 done:
+  if (ret != 0) {
+    // the flush thread still has to know that this buffer is done with
+    _add_to_flush_queue(new LogFlushData(this, nullptr, 0), lb->m_flush_seq, true);
+  }
   LogBuffer::destroy(lb);
   return ret;
 }
 
+/*-------------------------------------------------------------------------
+  LogFile::drop_buffer
+
+  The buffer won't be written, let the flush thread go on to the next one.
+  -------------------------------------------------------------------------*/
+void
+LogFile::drop_buffer(LogBuffer *lb)
+{
+  _add_to_flush_queue(new LogFlushData(this, nullptr, 0), lb->m_flush_seq, true);
+}
+
+/*-------------------------------------------------------------------------
+  LogFile::_add_to_flush_queue
+
+  Queue data of the buffer numbered @a seq, with @a last for its last data.
+  -------------------------------------------------------------------------*/
+void
+LogFile::_add_to_flush_queue(LogFlushData *flush_data, uint64_t seq, bool last)
+{
+  flush_data->m_seq  = seq;
+  flush_data->m_last = last;
+  Log::add_to_flush_queue(flush_data);
+}
+
 /*-------------------------------------------------------------------------
   LogFile::write_ascii_logbuffer
 
@@ -504,7 +583,7 @@ LogFile::write_ascii_logbuffer(LogBufferHeader *buffer_header, int fd, const cha
 }
 
 int
-LogFile::write_ascii_logbuffer3(LogBufferHeader *buffer_header, const char *alt_format)
+LogFile::write_ascii_logbuffer3(LogBufferHeader *buffer_header, const char *alt_format, uint64_t seq)
 {
   Debug("log-file",
         "entering LogFile::write_ascii_logbuffer3 for %s "
@@ -523,6 +602,7 @@ LogFile::write_ascii_logbuffer3(LogBufferHeader *buffer_header, const char *alt_
   char *fieldlist_str;
   char *printf_str;
   char *ascii_buffer;
+  LogFlushData *last_data = nullptr;
 
   switch (buffer_header->version) {
   case LOG_SEGMENT_VERSION:
@@ -535,6 +615,7 @@ LogFile::write_ascii_logbuffer3(LogBufferHeader *buffer_header, const char *alt_
     Note("Invalid LogBuffer version %d in write_ascii_logbuffer; "
          "current version is %d",
          buffer_header->version, LOG_SEGMENT_VERSION);
+    _add_to_flush_queue(new LogFlushData(this, nullptr, 0), seq, true);
     return 0;
   }
 
@@ -591,13 +672,17 @@ LogFile::write_ascii_logbuffer3(LogBufferHeader *buffer_header, const char *alt_
 
     RecIncrRawStat(log_rsb, mutex->thread_holding, log_stat_bytes_flush_to_disk_stat, fmt_buf_bytes);
 
-    ink_atomiclist_push(Log::flush_data_list, flush_data);
-
-    Log::flush_notify->signal();
+    // one behind, so that the last data of the buffer is marked as such
+    if (last_data) {
+      _add_to_flush_queue(last_data, seq, false);
+    }
+    last_data = flush_data;
 
     total_bytes += fmt_buf_bytes;
   }
 
+  _add_to_flush_queue(last_data ? last_data : new LogFlushData(this, nullptr, 0), seq, true);
+
   return total_bytes;
 }
 
@@ -680,7 +765,7 @@ LogFile::check_fd()
     // attempt to re-open it, which will create the file if it's not
     // there.
     //
-    if (m_name && !LogFile::exists(m_name)) {
+    if (m_name && !m_net_sink && !LogFile::exists(m_name)) {
       close_file();
     }
     stat_check_count = 0;
@@ -710,7 +795,9 @@ LogFile::display(FILE *fd)
 bool
 LogFile::is_open()
 {
-  if (m_file_format == LOG_FILE_PIPE) {
+  if (m_net_sink) {
+    return m_net_sink->is_open();
+  } else if (m_file_format == LOG_FILE_PIPE) {
     return m_fd >= 0;
   } else {
     return m_log && m_log->is_open();
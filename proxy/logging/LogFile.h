@@ -25,6 +25,7 @@
 
 #include <cstdarg>
 #include <cstdio>
+#include <map>
 
 #include "tscore/ink_platform.h"
 #include "LogBufferSink.h"
@@ -34,6 +35,8 @@ struct LogBufferHeader;
 class LogObject;
 class BaseLogFile;
 class BaseMetaInfo;
+class LogNetSink;
+class LogFlushData;
 
 /*-------------------------------------------------------------------------
   LogFile
@@ -57,6 +60,7 @@ public:
   };
 
   int preproc_and_try_delete(LogBuffer *lb) override;
+  void drop_buffer(LogBuffer *lb) override;
 
   bool trim_rolled(size_t rolling_max_count);
   int roll(long interval_start, long interval_end, bool reopen_after_rolling = false);
@@ -79,11 +83,20 @@ public:
   const char *
   get_format_name() const
   {
-    return (m_file_format == LOG_FILE_BINARY ? "binary" : (m_file_format == LOG_FILE_PIPE ? "ascii_pipe" : "ascii"));
+    switch (m_file_format) {
+    case LOG_FILE_BINARY:
+      return "binary";
+    case LOG_FILE_PIPE:
+      return "ascii_pipe";
+    case LOG_FILE_COLUMNAR:
+      return "columnar";
+    default:
+      return "ascii";
+    }
   }
 
   static int write_ascii_logbuffer(LogBufferHeader *buffer_header, int fd, const char *path, const char *alt_format = nullptr);
-  int write_ascii_logbuffer3(LogBufferHeader *buffer_header, const char *alt_format = nullptr);
+  int write_ascii_logbuffer3(LogBufferHeader *buffer_header, const char *alt_format = nullptr, uint64_t seq = 0);
   static bool rolled_logfile(char *file);
   static bool exists(const char *pathname);
 
@@ -115,19 +128,29 @@ private:
   char *m_name;
 
 public:
-  BaseLogFile *m_log; // BaseLogFile backs the actual file on disk
+  BaseLogFile *m_log;     // BaseLogFile backs the actual file on disk
+  LogNetSink *m_net_sink; // or the log is sent to the network, if its name is a URL
   char *m_header;
   uint64_t m_signature;       // signature of log object stored
   size_t m_ascii_buffer_size; // size of ascii buffer
   size_t m_max_line_size;     // size of longest log line (record)
   int m_fd;                   // this could back m_log or a pipe, depending on the situation
 
+  // The buffers are numbered as they are queued, so that the flush thread
+  // writes them in that order even though they are converted in parallel.
+  unsigned m_flush_thread;                               // the flush thread that writes this file
+  uint64_t m_flush_seq  = 0;                             // the number of the next buffer queued
+  uint64_t m_flush_next = 0;                             // the next buffer to write, on the flush thread
+  std::multimap<uint64_t, LogFlushData *> m_flush_held; // data that came before its turn
+
 public:
   Link<LogFile> link;
   // noncopyable
   LogFile &operator=(const LogFile &) = delete;
 
 private:
+  void _add_to_flush_queue(LogFlushData *flush_data, uint64_t seq, bool last);
+
   // -- member functions not allowed --
   LogFile();
 };
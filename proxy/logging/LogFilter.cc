@@ -929,6 +929,39 @@ filters_are_equal(LogFilter *filt1, LogFilter *filt2)
   add() function is overloaded for each sub-type of LogFilter.
   -------------------------------------------------------------------------*/
 
+namespace
+{
+// Filters are tested on every entry, call them by their type rather than
+// through the vtable.
+inline bool
+toss(LogFilter *f, LogAccess *lad)
+{
+  switch (f->type()) {
+  case LogFilter::INT_FILTER:
+    return static_cast<LogFilterInt *>(f)->LogFilterInt::toss_this_entry(lad);
+  case LogFilter::IP_FILTER:
+    return static_cast<LogFilterIP *>(f)->LogFilterIP::toss_this_entry(lad);
+  case LogFilter::STRING_FILTER:
+    return static_cast<LogFilterString *>(f)->LogFilterString::toss_this_entry(lad);
+  default:
+    return f->toss_this_entry(lad);
+  }
+}
+
+inline bool
+wipe(LogFilter *f, LogAccess *lad)
+{
+  switch (f->type()) {
+  case LogFilter::INT_FILTER:
+    return static_cast<LogFilterInt *>(f)->LogFilterInt::wipe_this_entry(lad);
+  case LogFilter::STRING_FILTER:
+    return static_cast<LogFilterString *>(f)->LogFilterString::wipe_this_entry(lad);
+  default:
+    return f->wipe_this_entry(lad);
+  }
+}
+} // namespace
+
 LogFilterList::LogFilterList() {}
 
 /*-------------------------------------------------------------------------
@@ -976,6 +1009,9 @@ LogFilterList::clear()
   while ((f = m_filter_list.dequeue())) {
     delete f; // safe given the semantics stated above
   }
+  m_tossers.clear();
+  m_wipers.clear();
+  m_has_acceptor = false;
 }
 
 /*-------------------------------------------------------------------------
@@ -987,17 +1023,22 @@ LogFilterList::add(LogFilter *filter, bool copy)
   ink_assert(filter != nullptr);
   if (copy) {
     if (filter->type() == LogFilter::INT_FILTER) {
-      LogFilterInt *f = new LogFilterInt(*((LogFilterInt *)filter));
-      m_filter_list.enqueue(f);
+      filter = new LogFilterInt(*((LogFilterInt *)filter));
     } else if (filter->type() == LogFilter::IP_FILTER) {
-      LogFilterIP *f = new LogFilterIP(*((LogFilterIP *)filter));
-      m_filter_list.enqueue(f);
+      filter = new LogFilterIP(*((LogFilterIP *)filter));
     } else {
-      LogFilterString *f = new LogFilterString(*((LogFilterString *)filter));
-      m_filter_list.enqueue(f);
+      filter = new LogFilterString(*((LogFilterString *)filter));
     }
+  }
+  m_filter_list.enqueue(filter);
+
+  if (filter->never_tosses()) {
+    m_has_acceptor = true;
   } else {
-    m_filter_list.enqueue(filter);
+    m_tossers.push_back(filter);
+  }
+  if (filter->can_wipe()) {
+    m_wipers.push_back(filter);
   }
 }
 
@@ -1008,8 +1049,8 @@ bool
 LogFilterList::wipe_this_entry(LogAccess *lad)
 {
   bool wipeFlag = false;
-  for (LogFilter *f = first(); f; f = next(f)) {
-    if (f->wipe_this_entry(lad)) {
+  for (LogFilter *f : m_wipers) {
+    if (wipe(f, lad)) {
       wipeFlag = true;
     }
   }
@@ -1025,8 +1066,8 @@ LogFilterList::toss_this_entry(LogAccess *lad)
   if (m_does_conjunction) {
     // toss if any filter rejects the entry (all filters should accept)
     //
-    for (LogFilter *f = first(); f; f = next(f)) {
-      if (f->toss_this_entry(lad)) {
+    for (LogFilter *f : m_tossers) {
+      if (toss(f, lad)) {
         return true;
       }
     }
@@ -1034,8 +1075,11 @@ LogFilterList::toss_this_entry(LogAccess *lad)
   } else {
     // toss if all filters reject the entry (any filter accepts)
     //
-    for (LogFilter *f = first(); f; f = next(f)) {
-      if (!f->toss_this_entry(lad)) {
+    if (m_has_acceptor) {
+      return false;
+    }
+    for (LogFilter *f : m_tossers) {
+      if (!toss(f, lad)) {
         return false;
       }
     }
@@ -23,6 +23,8 @@
 
 #pragma once
 
+#include <vector>
+
 #include "tscore/ink_platform.h"
 #include "tscore/IpMap.h"
 #include "tscore/Ptr.h"
@@ -96,6 +98,20 @@ public:
   virtual bool wipe_this_entry(LogAccess *lad) = 0;
   virtual void display(FILE *fd = stdout)      = 0;
 
+  /// Whether toss_this_entry() is false whatever the entry.
+  bool
+  never_tosses() const
+  {
+    return m_action == WIPE_FIELD_VALUE || (m_num_values == 0 && m_type != IP_FILTER);
+  }
+
+  /// Whether wipe_this_entry() can be true.
+  bool
+  can_wipe() const
+  {
+    return m_action == WIPE_FIELD_VALUE && m_num_values > 0 && m_type != IP_FILTER;
+  }
+
   static LogFilter *parse(const char *name, Action action, const char *condition);
 
 protected:
@@ -301,6 +317,13 @@ public:
 private:
   Queue<LogFilter> m_filter_list;
 
+  // The list compiled as filters are added: the filters that decide
+  // whether to toss an entry, and those that may wipe one, called without
+  // virtual dispatch on each entry.
+  std::vector<LogFilter *> m_tossers;
+  std::vector<LogFilter *> m_wipers;
+  bool m_has_acceptor = false; // a filter that never tosses, so a disjunction never does either
+
   bool m_does_conjunction = true;
   // If m_does_conjunction = true
   // toss_this_entry returns true
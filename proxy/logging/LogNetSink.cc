@@ -0,0 +1,217 @@
+/** @file
+
+  Log files shipped over the network.
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ */
+
+#include "LogNetSink.h"
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <netdb.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "tscore/Diags.h"
+#include "I_EventSystem.h"
+
+namespace
+{
+constexpr char const TCP_SCHEME[] = "tcp://";
+constexpr char const UDP_SCHEME[] = "udp://";
+
+/// The time between two connection attempts.
+constexpr ink_hrtime RETRY_INTERVAL = HRTIME_SECONDS(5);
+
+/// The largest UDP payload.
+constexpr int MAX_DATAGRAM = 65507;
+} // namespace
+
+bool
+LogNetSink::is_url(const char *name)
+{
+  return name && (strncasecmp(name, TCP_SCHEME, sizeof(TCP_SCHEME) - 1) == 0 ||
+                  strncasecmp(name, UDP_SCHEME, sizeof(UDP_SCHEME) - 1) == 0);
+}
+
+LogNetSink::LogNetSink(const char *url, size_t max_pending) : m_max_pending(max_pending)
+{
+  ink_assert(is_url(url));
+  m_udp = strncasecmp(url, UDP_SCHEME, sizeof(UDP_SCHEME) - 1) == 0;
+
+  // host:port, with the host of an IPv6 address in brackets.
+  std::string authority(url + sizeof(TCP_SCHEME) - 1);
+  authority = authority.substr(0, authority.find('/'));
+  size_t colon = authority.rfind(':');
+  if (colon != std::string::npos && authority.find(']', colon) == std::string::npos) {
+    m_host = authority.substr(0, colon);
+    m_port = authority.substr(colon + 1);
+  } else {
+    m_host = authority;
+  }
+  if (m_host.size() > 1 && m_host.front() == '[' && m_host.back() == ']') {
+    m_host = m_host.substr(1, m_host.size() - 2);
+  }
+}
+
+LogNetSink::~LogNetSink()
+{
+  close();
+}
+
+bool
+LogNetSink::open()
+{
+  if (is_open()) {
+    return true;
+  }
+
+  ink_hrtime now = Thread::get_hrtime();
+  if (m_last_open && now - m_last_open < RETRY_INTERVAL) {
+    errno = EAGAIN;
+    return false;
+  }
+  m_last_open = now;
+
+  if (m_port.empty()) {
+    Warning("log sink %s:? has no port", m_host.c_str());
+    errno = EINVAL;
+    return false;
+  }
+
+  addrinfo hints;
+  addrinfo *result = nullptr;
+  memset(&hints, 0, sizeof(hints));
+  hints.ai_family   = AF_UNSPEC;
+  hints.ai_socktype = m_udp ? SOCK_DGRAM : SOCK_STREAM;
+  if (int err = getaddrinfo(m_host.c_str(), m_port.c_str(), &hints, &result); err != 0) {
+    Warning("could not resolve log sink %s:%s: %s", m_host.c_str(), m_port.c_str(), gai_strerror(err));
+    errno = EHOSTUNREACH;
+    return false;
+  }
+
+  for (addrinfo *ai = result; ai && m_fd < 0; ai = ai->ai_next) {
+    m_fd = socket(ai->ai_family, ai->ai_socktype | SOCK_NONBLOCK | SOCK_CLOEXEC, ai->ai_protocol);
+    if (m_fd < 0) {
+      continue;
+    }
+    // A TCP connection completes in the background, the first writes are queued until it does.
+    if (connect(m_fd, ai->ai_addr, ai->ai_addrlen) < 0 && errno != EINPROGRESS) {
+      ::close(m_fd);
+      m_fd = -1;
+    }
+  }
+  freeaddrinfo(result);
+
+  if (m_fd < 0) {
+    Debug("log-net", "could not connect to log sink %s:%s: %s", m_host.c_str(), m_port.c_str(), strerror(errno));
+    return false;
+  }
+  Debug("log-net", "connecting to log sink %s:%s (fd=%d)", m_host.c_str(), m_port.c_str(), m_fd);
+  return true;
+}
+
+void
+LogNetSink::close()
+{
+  if (m_fd >= 0) {
+    ::close(m_fd);
+    m_fd = -1;
+  }
+  // The rest of a record is of no use on another connection.
+  m_pending.clear();
+  m_pending_done = 0;
+}
+
+bool
+LogNetSink::flush_pending()
+{
+  while (m_pending_done < m_pending.size()) {
+    ssize_t n = send(m_fd, m_pending.data() + m_pending_done, m_pending.size() - m_pending_done, MSG_NOSIGNAL | MSG_DONTWAIT);
+    if (n < 0) {
+      if (errno == EAGAIN || errno == EWOULDBLOCK || errno == ENOTCONN || errno == EINTR) {
+        break;
+      }
+      Warning("lost the connection to log sink %s:%s: %s", m_host.c_str(), m_port.c_str(), strerror(errno));
+      close();
+      return false;
+    }
+    m_pending_done += n;
+  }
+
+  if (m_pending_done == m_pending.size()) {
+    m_pending.clear();
+    m_pending_done = 0;
+  } else if (m_pending_done > m_pending.size() / 2) {
+    m_pending.erase(m_pending.begin(), m_pending.begin() + m_pending_done);
+    m_pending_done = 0;
+  }
+  return true;
+}
+
+int
+LogNetSink::write(const char *data, int len)
+{
+  if (!is_open()) {
+    return -1;
+  }
+
+  if (m_udp) {
+    if (len > MAX_DATAGRAM) {
+      Debug("log-net", "dropped a buffer of %d bytes, too large for a datagram", len);
+      return -1;
+    }
+    if (send(m_fd, data, len, MSG_NOSIGNAL | MSG_DONTWAIT) < 0) {
+      // A refused datagram is reported on a later send, the socket stays usable.
+      Debug("log-net", "dropped a datagram of %d bytes: %s", len, strerror(errno));
+      return -1;
+    }
+    return len;
+  }
+
+  if (!flush_pending()) {
+    return -1;
+  }
+
+  int sent = 0;
+  if (m_pending.empty()) {
+    ssize_t n = send(m_fd, data, len, MSG_NOSIGNAL | MSG_DONTWAIT);
+    if (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != ENOTCONN && errno != EINTR) {
+      Warning("lost the connection to log sink %s:%s: %s", m_host.c_str(), m_port.c_str(), strerror(errno));
+      close();
+      return -1;
+    }
+    sent = n > 0 ? n : 0;
+  }
+
+  // Backpressure: the sink is behind, drop the buffer rather than hold more of it.
+  if (m_pending.size() - m_pending_done + (len - sent) > m_max_pending) {
+    if (sent > 0) {
+      // Part of it is on the wire, the rest has to follow to keep the stream whole.
+      m_pending.insert(m_pending.end(), data + sent, data + len);
+      return len;
+    }
+    Debug("log-net", "dropped a buffer of %d bytes, %zu bytes are pending", len, m_pending.size() - m_pending_done);
+    return -1;
+  }
+  m_pending.insert(m_pending.end(), data + sent, data + len);
+  return len;
+}
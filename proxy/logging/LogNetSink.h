@@ -0,0 +1,83 @@
+/** @file
+
+  Log files shipped over the network.
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "tscore/ink_platform.h"
+#include "tscore/ink_hrtime.h"
+
+/*-------------------------------------------------------------------------
+  LogNetSink
+
+  The destination of a LogFile whose name is a tcp:// or udp:// URL. The
+  flush thread writes each of its buffers, ASCII lines or binary/columnar
+  blocks, to the socket without ever blocking: a TCP stream queues what
+  the socket doesn't take, up to a bound, and a UDP sink sends each
+  buffer as one datagram. Buffers beyond that are dropped whole, so that
+  the receiver always sees complete records.
+  -------------------------------------------------------------------------*/
+
+class LogNetSink
+{
+public:
+  /// Whether @a name is the URL of a network sink.
+  static bool is_url(const char *name);
+
+  LogNetSink(const char *url, size_t max_pending);
+  ~LogNetSink();
+
+  // noncopyable
+  LogNetSink(const LogNetSink &) = delete;
+  LogNetSink &operator=(const LogNetSink &) = delete;
+
+  /// Connect to the sink, if the last attempt is less than a retry interval ago.
+  bool open();
+  void close();
+
+  bool
+  is_open() const
+  {
+    return m_fd >= 0;
+  }
+
+  /** Send, or queue, @a len bytes of @a data.
+
+      @return @a len, or -1 if the data is dropped.
+   */
+  int write(const char *data, int len);
+
+private:
+  bool flush_pending();
+
+  bool m_udp = false;
+  std::string m_host;
+  std::string m_port;
+  size_t m_max_pending;
+  int m_fd               = -1;
+  ink_hrtime m_last_open = 0;
+  std::vector<char> m_pending; ///< Bytes the TCP socket didn't take yet.
+  size_t m_pending_done = 0;   ///< Bytes of @c m_pending already sent.
+};
@@ -32,12 +32,15 @@
 #include "LogUtils.h"
 #include "LogField.h"
 #include "LogObject.h"
+#include "LogNetSink.h"
 #include "LogConfig.h"
 #include "LogAccess.h"
 #include "Log.h"
 #include "tscore/TestBox.h"
 
 #include <algorithm>
+#include <atomic>
+#include <cmath>
 #include <vector>
 
 static bool
@@ -66,6 +69,7 @@ LogBufferManager::preproc_buffers(LogBufferSink *sink)
       Warning("Dropping log buffer, can't keep up.");
       RecIncrRawStat(log_rsb, this_thread()->mutex->thread_holding, log_stat_bytes_lost_before_preproc_stat,
                      b->header()->byte_count);
+      sink->drop_buffer(b);
       delete b;
     } else {
       new_q.push(b);
@@ -111,6 +115,11 @@ LogObject::LogObject(const LogFormat *format, const char *log_dir, const char *b
     m_flags |= BINARY;
   } else if (file_format == LOG_FILE_PIPE) {
     m_flags |= WRITES_TO_PIPE;
+  } else if (file_format == LOG_FILE_COLUMNAR) {
+    m_flags |= COLUMNAR;
+  }
+  if (LogNetSink::is_url(basename)) {
+    m_flags |= WRITES_TO_NETWORK;
   }
 
   generate_filenames(log_dir, basename, file_format);
@@ -124,9 +133,7 @@ LogObject::LogObject(const LogFormat *format, const char *log_dir, const char *b
     m_logFile->open_file();
   }
 
-  LogBuffer *b = new LogBuffer(this, Log::config->log_buffer_size);
-  ink_assert(b);
-  SET_FREELIST_POINTER_VERSION(m_log_buffer, b, 0);
+  _create_log_buffers(Log::config->log_buffer_shards);
 
   _setup_rolling(rolling_enabled, rolling_interval_sec, rolling_offset_hr, rolling_size_mb);
 
@@ -148,6 +155,10 @@ LogObject::LogObject(LogObject &rhs)
     m_last_roll_time(rhs.m_last_roll_time),
     m_max_rolled(rhs.m_max_rolled),
     m_reopen_after_rolling(rhs.m_reopen_after_rolling),
+    m_sample_rate(rhs.m_sample_rate),
+    m_sample_threshold(rhs.m_sample_threshold),
+    m_sample_weight(rhs.m_sample_weight),
+    m_rate_limit(rhs.m_rate_limit),
     m_buffer_manager_idx(rhs.m_buffer_manager_idx)
 {
   m_format         = new LogFormat(*(rhs.m_format));
@@ -168,11 +179,9 @@ LogObject::LogObject(LogObject &rhs)
     add_filter(filter);
   }
 
-  // copy gets a fresh log buffer
+  // copy gets fresh log buffers
   //
-  LogBuffer *b = new LogBuffer(this, Log::config->log_buffer_size);
-  ink_assert(b);
-  SET_FREELIST_POINTER_VERSION(m_log_buffer, b, 0);
+  _create_log_buffers(rhs.m_log_buffer_count);
 
   Debug("log-config",
         "exiting LogObject copy constructor, "
@@ -190,7 +199,33 @@ LogObject::~LogObject()
   ats_free(m_alt_filename);
   delete m_format;
   delete[] m_buffer_manager;
-  delete (LogBuffer *)FREELIST_POINTER(m_log_buffer);
+  for (int i = 0; i < m_log_buffer_count; ++i) {
+    delete (LogBuffer *)FREELIST_POINTER(m_log_buffers[i].head);
+  }
+  delete[] m_log_buffers;
+}
+
+void
+LogObject::_create_log_buffers(int count)
+{
+  m_log_buffer_count = std::max(count, 1);
+  m_log_buffers      = new LogBufferSlot[m_log_buffer_count];
+  for (int i = 0; i < m_log_buffer_count; ++i) {
+    LogBuffer *b = new LogBuffer(this, Log::config->log_buffer_size);
+    ink_assert(b);
+    SET_FREELIST_POINTER_VERSION(m_log_buffers[i].head, b, 0);
+  }
+}
+
+// The work buffer of the calling thread. Each thread keeps to one shard, the threads are spread
+// across the shards in the order they first log, so with a shard per thread nothing is shared.
+head_p *
+LogObject::_thread_log_buffer()
+{
+  static std::atomic<unsigned> next_shard{0};
+  static thread_local unsigned shard = next_shard++;
+
+  return &m_log_buffers[shard % m_log_buffer_count].head;
 }
 
 //-----------------------------------------------------------------------------
@@ -204,12 +239,20 @@ LogObject::~LogObject()
 // 3.- if there is a '.' at the end of the name, then do not add an extension
 //     and remove the '.'. To have a dot at the end of the filename, specify
 //     two ('..').
+// 4.- the tcp:// or udp:// URL of a network sink is used as is.
 //
 void
 LogObject::generate_filenames(const char *log_dir, const char *basename, LogFileFormat file_format)
 {
   ink_assert(log_dir && basename);
 
+  // the URL of a network sink is used as is
+  if (LogNetSink::is_url(basename)) {
+    m_filename = ats_strdup(basename);
+    m_basename = ats_strdup(basename);
+    return;
+  }
+
   int i = -1, len = 0;
   char c;
   while (c = basename[len], c != 0) {
@@ -238,6 +281,10 @@ LogObject::generate_filenames(const char *log_dir, const char *basename, LogFile
       ext     = LOG_FILE_PIPE_OBJECT_FILENAME_EXTENSION;
       ext_len = 5;
       break;
+    case LOG_FILE_COLUMNAR:
+      ext     = LOG_FILE_COLUMNAR_OBJECT_FILENAME_EXTENSION;
+      ext_len = 5;
+      break;
     default:
       ink_assert(!"unknown file format");
     }
@@ -311,8 +358,15 @@ LogObject::compute_signature(LogFormat *format, char *filename, unsigned int fla
     int buf_size = strlen(fl) + strlen(ps) + strlen(filename) + 2;
     char *buffer = (char *)ats_malloc(buf_size);
 
-    ink_string_concatenate_strings(buffer, fl, ps, filename,
-                                   flags & LogObject::BINARY ? "B" : (flags & LogObject::WRITES_TO_PIPE ? "P" : "A"), NULL);
+    const char *mode = "A";
+    if (flags & LogObject::BINARY) {
+      mode = "B";
+    } else if (flags & LogObject::WRITES_TO_PIPE) {
+      mode = "P";
+    } else if (flags & LogObject::COLUMNAR) {
+      mode = "C";
+    }
+    ink_string_concatenate_strings(buffer, fl, ps, filename, mode, NULL);
 
     CryptoHash hash;
     CryptoContext().hash_immediate(hash, buffer, buf_size - 1);
@@ -362,7 +416,7 @@ write_pointer_version(head_p *dst, head_p old_h, void *ptr, head_p::version_type
 }
 
 LogBuffer *
-LogObject::_checkout_write(size_t *write_offset, size_t bytes_needed)
+LogObject::_checkout_write(head_p *slot, size_t *write_offset, size_t bytes_needed)
 {
   LogBuffer::LB_ResultCode result_code;
   LogBuffer *buffer;
@@ -374,8 +428,8 @@ LogObject::_checkout_write(size_t *write_offset, size_t bytes_needed)
     // To avoid a race condition, we keep a count of held references in
     // the pointer itself and add this to m_outstanding_references.
 
-    // Increment the version of m_log_buffer, returning the previous version.
-    head_p h = increment_pointer_version(&m_log_buffer);
+    // Increment the version of the slot, returning the previous version.
+    head_p h = increment_pointer_version(slot);
 
     buffer           = (LogBuffer *)FREELIST_POINTER(h);
     result_code      = buffer->checkout_write(write_offset, bytes_needed);
@@ -396,7 +450,7 @@ LogObject::_checkout_write(size_t *write_offset, size_t bytes_needed)
       INK_WRITE_MEMORY_BARRIER;
 
       do {
-        INK_QUEUE_LD(old_h, m_log_buffer);
+        INK_QUEUE_LD(old_h, *slot);
         // we may depend on comparing the old pointer to the new pointer to detect buffer swaps
         // without worrying about pointer collisions because we always allocate a new LogBuffer
         // before freeing the old one
@@ -409,14 +463,13 @@ LogObject::_checkout_write(size_t *write_offset, size_t bytes_needed)
           new_buffer = nullptr;
           break;
         }
-      } while (write_pointer_version(&m_log_buffer, old_h, new_buffer, 0) == false);
+      } while (write_pointer_version(slot, old_h, new_buffer, 0) == false);
 
       if (FREELIST_POINTER(old_h) == FREELIST_POINTER(h)) {
         ink_atomic_increment(&buffer->m_references, FREELIST_VERSION(old_h) - 1);
 
-        int idx = m_buffer_manager_idx++ % m_flush_threads;
         Debug("log-logbuffer", "adding buffer %d to flush list after checkout", buffer->get_id());
-        m_buffer_manager[idx].add_to_flush_queue(buffer);
+        int idx = add_to_flush_queue(buffer);
         Log::preproc_notify[idx].signal();
         buffer = nullptr;
       }
@@ -443,13 +496,13 @@ LogObject::_checkout_write(size_t *write_offset, size_t bytes_needed)
       // The do-while loop protects us from races while we're examining ptr(old_h) and ptr(h)
       // (essentially an optimistic lock)
       do {
-        INK_QUEUE_LD(old_h, m_log_buffer);
+        INK_QUEUE_LD(old_h, *slot);
         if (FREELIST_POINTER(old_h) != FREELIST_POINTER(h)) {
           // Another thread's allocated a new LogBuffer, we don't need to do anything more
           break;
         }
 
-      } while (!write_pointer_version(&m_log_buffer, old_h, FREELIST_POINTER(h), FREELIST_VERSION(old_h) - 1));
+      } while (!write_pointer_version(slot, old_h, FREELIST_POINTER(h), FREELIST_VERSION(old_h) - 1));
 
       if (FREELIST_POINTER(old_h) != FREELIST_POINTER(h)) {
         // Another thread's allocated a new LogBuffer, meaning this LogObject is no longer referencing the old LogBuffer
@@ -519,9 +572,8 @@ LogObject::log(LogAccess *lad, std::string_view text_entry)
   size_t bytes_needed = 0, bytes_used = 0;
 
   // log to a pipe even if space is exhausted since pipe uses no space
-  // likewise, send data to a remote client even if local space is exhausted
-  // (if there is a remote client, m_logFile will be NULL
-  if (Log::config->logging_space_exhausted && !writes_to_pipe() && m_logFile) {
+  // likewise, send data to a network sink even if local space is exhausted
+  if (Log::config->logging_space_exhausted && writes_to_disk()) {
     Debug("log", "logging space exhausted, can't write to:%s, drop this entry", m_logFile->get_name());
     return Log::FULL;
   }
@@ -537,10 +589,25 @@ LogObject::log(LogAccess *lad, std::string_view text_entry)
     return Log::SKIP;
   }
 
+  if (lad && _sampled_out(lad)) {
+    Debug("log", "entry sampled out, skipping ...");
+    return Log::SKIP;
+  }
+
+  if (_rate_limited()) {
+    Debug("log", "entry over the rate limit of %s, skipping ...", m_basename);
+    RecIncrRawStat(log_rsb, this_thread()->mutex->thread_holding, log_stat_event_log_access_rate_limited_stat, 1);
+    return Log::SKIP;
+  }
+
   if (lad && m_filter_list.wipe_this_entry(lad)) {
     Debug("log", "entry wiped, ...");
   }
 
+  if (lad) {
+    lad->set_sample_weight(m_sample_weight);
+  }
+
   if (lad && m_format->is_aggregate()) {
     // marshal the field data into the temp space provided by the
     // LogFormat object for aggregate formats
@@ -587,7 +654,7 @@ LogObject::log(LogAccess *lad, std::string_view text_entry)
   }
 
   // Now try to place this entry in the current LogBuffer.
-  buffer = _checkout_write(&offset, bytes_needed);
+  buffer = _checkout_write(_thread_log_buffer(), &offset, bytes_needed);
 
   if (!buffer) {
     Note("Skipping the current log entry for %s because its size (%zu) exceeds "
@@ -622,6 +689,61 @@ LogObject::log(LogAccess *lad, std::string_view text_entry)
   return Log::LOG_OK;
 }
 
+void
+LogObject::set_sampling(double sample_rate, int64_t rate_limit)
+{
+  if (sample_rate > 0 && sample_rate < 1) {
+    m_sample_rate      = sample_rate;
+    m_sample_threshold = static_cast<uint64_t>(sample_rate * 18446744073709551616.0); // 2^64
+    m_sample_weight    = std::max<int64_t>(1, std::llround(1 / sample_rate));
+  } else {
+    m_sample_rate      = 1.0;
+    m_sample_threshold = UINT64_MAX;
+    m_sample_weight    = 1;
+  }
+  m_rate_limit = std::max<int64_t>(0, rate_limit);
+}
+
+// The decision only depends on the id of the transaction, so that all of the objects
+// with the same rate keep the same transactions, and those kept at a lower rate are
+// also kept by the objects with a higher one.
+bool
+LogObject::_sampled_out(LogAccess *lad) const
+{
+  if (m_sample_threshold == UINT64_MAX) {
+    return false;
+  }
+
+  // The finalizer of splitmix64, to spread the sequential ids over the whole range.
+  uint64_t h = static_cast<uint64_t>(lad->transaction_id());
+  h          = (h ^ (h >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  h          = (h ^ (h >> 27)) * 0x94d049bb133111ebULL;
+  h          = h ^ (h >> 31);
+  return h >= m_sample_threshold;
+}
+
+// A token bucket holding a second worth of entries, kept as the time at which it is
+// full again so that a single compare and swap takes a token.
+bool
+LogObject::_rate_limited()
+{
+  if (m_rate_limit == 0) {
+    return false;
+  }
+
+  ink_hrtime const interval = HRTIME_SECOND / m_rate_limit;
+  ink_hrtime const now      = Thread::get_hrtime();
+  ink_hrtime tat            = m_rate_tat.load(std::memory_order_relaxed);
+  ink_hrtime next;
+  do {
+    next = std::max(tat, now) + interval;
+    if (next - now > HRTIME_SECOND) {
+      return true;
+    }
+  } while (!m_rate_tat.compare_exchange_weak(tat, next, std::memory_order_relaxed));
+  return false;
+}
+
 void
 LogObject::_setup_rolling(Log::RollingEnabledValues rolling_enabled, int rolling_interval_sec, int rolling_offset_hr,
                           int rolling_size_mb)
@@ -755,8 +877,8 @@ LogObject::_roll_files(long last_roll_time, long time_now)
   unsigned num_rolled = 0;
 
   if (m_logFile) {
-    // no need to roll if object writes to a pipe
-    if (!writes_to_pipe()) {
+    // no need to roll if object writes to a pipe or to the network
+    if (!writes_to_pipe() && !writes_to_network()) {
       num_rolled += m_logFile->roll(last_roll_time, time_now, m_reopen_after_rolling);
 
       if (Log::config->auto_delete_rolled_files && m_max_rolled > 0) {
@@ -772,9 +894,11 @@ LogObject::_roll_files(long last_roll_time, long time_now)
 void
 LogObject::check_buffer_expiration(long time_now)
 {
-  LogBuffer *b = (LogBuffer *)FREELIST_POINTER(m_log_buffer);
-  if (b && time_now > b->expiration_time()) {
-    force_new_buffer();
+  for (int i = 0; i < m_log_buffer_count; ++i) {
+    LogBuffer *b = (LogBuffer *)FREELIST_POINTER(m_log_buffers[i].head);
+    if (b && time_now > b->expiration_time()) {
+      _checkout_write(&m_log_buffers[i].head, nullptr, 0);
+    }
   }
 }
 
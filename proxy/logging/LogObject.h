@@ -31,6 +31,7 @@
 #include "LogBuffer.h"
 #include "LogAccess.h"
 #include "LogFilter.h"
+#include <atomic>
 #include <vector>
 
 /*-------------------------------------------------------------------------
@@ -48,6 +49,7 @@
 #define LOG_FILE_ASCII_OBJECT_FILENAME_EXTENSION ".log"
 #define LOG_FILE_BINARY_OBJECT_FILENAME_EXTENSION ".blog"
 #define LOG_FILE_PIPE_OBJECT_FILENAME_EXTENSION ".pipe"
+#define LOG_FILE_COLUMNAR_OBJECT_FILENAME_EXTENSION ".clog"
 
 #define FLUSH_ARRAY_SIZE (512 * 4)
 
@@ -88,10 +90,14 @@ public:
     BINARY                   = 1,
     WRITES_TO_PIPE           = 4,
     LOG_OBJECT_FMT_TIMESTAMP = 8, // always format a timestamp into each log line (for raw text logs)
+    COLUMNAR                 = 16,
+    WRITES_TO_NETWORK        = 32,
   };
 
   // BINARY: log is written in binary format (rather than ascii)
   // WRITES_TO_PIPE: object writes to a named pipe rather than to a file
+  // COLUMNAR: log is written in compressed blocks of columns (see LogColumnBlock.h)
+  // WRITES_TO_NETWORK: object sends its buffers to a tcp:// or udp:// URL (see LogNetSink.h)
 
   LogObject(const LogFormat *format, const char *log_dir, const char *basename, LogFileFormat file_format, const char *header,
             Log::RollingEnabledValues rolling_enabled, int flush_threads, int rolling_interval_sec = 0, int rolling_offset_hr = 0,
@@ -102,6 +108,9 @@ public:
   void add_filter(LogFilter *filter, bool copy = true);
   void set_filter_list(const LogFilterList &list, bool copy = true);
 
+  /// Log only the fraction @a sample_rate of the transactions, and at most @a rate_limit entries per second if not 0.
+  void set_sampling(double sample_rate, int64_t rate_limit);
+
   inline void
   set_fmt_timestamps()
   {
@@ -129,6 +138,10 @@ public:
   {
     int idx = m_buffer_manager_idx++ % m_flush_threads;
 
+    // the preproc threads may convert the buffers in any order, the file writes them in this one
+    if (m_logFile) {
+      buffer->m_flush_seq = ink_atomic_increment(&m_logFile->m_flush_seq, 1);
+    }
     m_buffer_manager[idx].add_to_flush_queue(buffer);
 
     return idx;
@@ -137,14 +150,16 @@ public:
   inline size_t
   preproc_buffers(int idx = -1)
   {
-    size_t nfb;
+    size_t nfb = 0;
 
     if (idx == -1) {
-      idx = m_buffer_manager_idx++ % m_flush_threads;
+      for (idx = 0; idx < m_flush_threads; ++idx) {
+        nfb += m_buffer_manager[idx].preproc_buffers(m_logFile.get());
+      }
+    } else {
+      nfb = m_buffer_manager[idx].preproc_buffers(m_logFile.get());
     }
 
-    nfb = m_buffer_manager[idx].preproc_buffers(m_logFile.get());
-
     return nfb;
   }
 
@@ -219,9 +234,14 @@ public:
     return (m_flags & WRITES_TO_PIPE) ? true : false;
   }
   inline bool
+  writes_to_network() const
+  {
+    return (m_flags & WRITES_TO_NETWORK) ? true : false;
+  }
+  inline bool
   writes_to_disk()
   {
-    return (m_logFile && !(m_flags & WRITES_TO_PIPE) ? true : false);
+    return (m_logFile && !(m_flags & (WRITES_TO_PIPE | WRITES_TO_NETWORK)) ? true : false);
   }
 
   inline unsigned int
@@ -247,7 +267,9 @@ public:
   inline void
   force_new_buffer()
   {
-    _checkout_write(nullptr, 0);
+    for (int i = 0; i < m_log_buffer_count; ++i) {
+      _checkout_write(&m_log_buffers[i].head, nullptr, 0);
+    }
   }
 
   bool operator==(LogObject &rhs);
@@ -281,7 +303,18 @@ private:
   int m_max_rolled;            // maximum number of rolled logs to be kept, 0 no limit
   bool m_reopen_after_rolling; // reopen log file after rolling (normally it is just renamed and closed)
 
-  head_p m_log_buffer; // current work buffer
+  double m_sample_rate        = 1.0;        // fraction of the transactions logged
+  uint64_t m_sample_threshold = UINT64_MAX; // a transaction is logged if the hash of its id is below this
+  int64_t m_sample_weight     = 1;          // the transactions each entry stands for, see the lsw field
+  int64_t m_rate_limit        = 0;          // maximum entries per second, 0 for no limit
+  std::atomic<ink_hrtime> m_rate_tat{0};    // when the token bucket is full again, see _rate_limited()
+
+  // A current work buffer, on a cache line of its own
+  struct alignas(64) LogBufferSlot {
+    head_p head;
+  };
+  LogBufferSlot *m_log_buffers; // current work buffers, one per shard of the logging threads
+  int m_log_buffer_count;
   unsigned m_buffer_manager_idx;
   LogBufferManager *m_buffer_manager;
 
@@ -289,8 +322,12 @@ private:
   void _setup_rolling(Log::RollingEnabledValues rolling_enabled, int rolling_interval_sec, int rolling_offset_hr,
                       int rolling_size_mb);
   unsigned _roll_files(long interval_start, long interval_end);
+  bool _sampled_out(LogAccess *lad) const;
+  bool _rate_limited();
 
-  LogBuffer *_checkout_write(size_t *write_offset, size_t write_size);
+  void _create_log_buffers(int count);
+  head_p *_thread_log_buffer();
+  LogBuffer *_checkout_write(head_p *slot, size_t *write_offset, size_t write_size);
 
   // noncopyable
   LogObject(const LogObject &) = delete;
@@ -411,7 +448,7 @@ LogObject::operator==(LogObject &old)
           strcmp(m_logFile->get_name(), old.m_logFile->get_name()) == 0 && (m_filter_list == old.m_filter_list) &&
           (m_rolling_interval_sec == old.m_rolling_interval_sec && m_rolling_offset_hr == old.m_rolling_offset_hr &&
            m_rolling_size_mb == old.m_rolling_size_mb && m_reopen_after_rolling == old.m_reopen_after_rolling &&
-           m_max_rolled == old.m_max_rolled));
+           m_max_rolled == old.m_max_rolled && m_sample_rate == old.m_sample_rate && m_rate_limit == old.m_rate_limit));
 }
 
 inline off_t
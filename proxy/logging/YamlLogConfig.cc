@@ -24,6 +24,7 @@
 
 #include "LogConfig.h"
 #include "LogObject.h"
+#include "LogNetSink.h"
 
 #include "tscore/EnumDescriptor.h"
 
@@ -111,7 +112,8 @@ TsEnumDescriptor ROLLING_MODE_LUA  = {
 
 std::set<std::string> valid_log_object_keys = {
   "filename",          "format",          "mode",    "header",    "rolling_enabled",   "rolling_interval_sec",
-  "rolling_offset_hr", "rolling_size_mb", "filters", "min_count", "rolling_max_count", "rolling_allow_empty"};
+  "rolling_offset_hr", "rolling_size_mb", "filters", "min_count", "rolling_max_count", "rolling_allow_empty",
+  "sample_rate",       "rate_limit"};
 
 LogObject *
 YamlLogConfig::decodeLogObject(const YAML::Node &node)
@@ -150,7 +152,9 @@ YamlLogConfig::decodeLogObject(const YAML::Node &node)
     std::string mode = node["mode"].as<std::string>();
     file_type        = (0 == strncasecmp(mode.c_str(), "bin", 3) || (1 == mode.size() && mode[0] == 'b') ?
                    LOG_FILE_BINARY :
-                   (0 == strcasecmp(mode.c_str(), "ascii_pipe") ? LOG_FILE_PIPE : LOG_FILE_ASCII));
+                   (0 == strcasecmp(mode.c_str(), "ascii_pipe") ?
+                      LOG_FILE_PIPE :
+                      (0 == strcasecmp(mode.c_str(), "columnar") ? LOG_FILE_COLUMNAR : LOG_FILE_ASCII)));
   }
 
   int obj_rolling_enabled      = cfg->rolling_enabled;
@@ -160,6 +164,8 @@ YamlLogConfig::decodeLogObject(const YAML::Node &node)
   int obj_min_count            = cfg->rolling_min_count;
   int obj_rolling_max_count    = cfg->rolling_max_count;
   int obj_rolling_allow_empty  = cfg->rolling_allow_empty;
+  double obj_sample_rate       = 1.0;
+  int64_t obj_rate_limit       = 0;
 
   if (node["rolling_enabled"]) {
     auto value          = node["rolling_enabled"].as<std::string>();
@@ -192,6 +198,18 @@ YamlLogConfig::decodeLogObject(const YAML::Node &node)
   if (node["rolling_allow_empty"]) {
     obj_rolling_allow_empty = node["rolling_allow_empty"].as<int>();
   }
+  if (node["sample_rate"]) {
+    obj_sample_rate = node["sample_rate"].as<double>();
+    if (obj_sample_rate <= 0 || obj_sample_rate > 1) {
+      throw YAML::ParserException(node["sample_rate"].Mark(), "'sample_rate' should be above 0 and at most 1");
+    }
+  }
+  if (node["rate_limit"]) {
+    obj_rate_limit = node["rate_limit"].as<int64_t>();
+    if (obj_rate_limit < 0) {
+      throw YAML::ParserException(node["rate_limit"].Mark(), "'rate_limit' should not be negative");
+    }
+  }
   if (!LogRollingEnabledIsValid(obj_rolling_enabled)) {
     Warning("Invalid log rolling value '%d' in log object", obj_rolling_enabled);
   }
@@ -201,6 +219,8 @@ YamlLogConfig::decodeLogObject(const YAML::Node &node)
     Log::config->preproc_threads, obj_rolling_interval_sec, obj_rolling_offset_hr, obj_rolling_size_mb, /* auto_created */ false,
     /* rolling_max_count */ obj_rolling_max_count, /* reopen_after_rolling */ obj_rolling_allow_empty > 0);
 
+  logObject->set_sampling(obj_sample_rate, obj_rate_limit);
+
   // Generate LogDeletingInfo entry for later use
   std::string ext;
   switch (file_type) {
@@ -213,10 +233,16 @@ YamlLogConfig::decodeLogObject(const YAML::Node &node)
   case LOG_FILE_BINARY:
     ext = LOG_FILE_BINARY_OBJECT_FILENAME_EXTENSION;
     break;
+  case LOG_FILE_COLUMNAR:
+    ext = LOG_FILE_COLUMNAR_OBJECT_FILENAME_EXTENSION;
+    break;
   default:
     break;
   }
-  cfg->deleting_info.insert(new LogDeletingInfo(filename + ext, ((obj_min_count == 0) ? INT_MAX : obj_min_count)));
+  // a log sent to the network has no files to delete
+  if (!LogNetSink::is_url(filename.c_str())) {
+    cfg->deleting_info.insert(new LogDeletingInfo(filename + ext, ((obj_min_count == 0) ? INT_MAX : obj_min_count)));
+  }
 
   // filters
   auto filters = node["filters"];
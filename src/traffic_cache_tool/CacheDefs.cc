@@ -244,6 +244,7 @@ Stripe::InitializeMeta()
       j.phase = j.cycle = j.sync_serial = j.write_serial = j.dirty = 0;
       j.create_time                                                = time(nullptr);
       j.sector_size                                                = DEFAULT_HW_SECTOR_SIZE;
+      j.url_hash                                                   = 0;
     }
   }
   if (!freelist) // freelist is not allocated yet
@@ -631,6 +632,15 @@ Stripe::loadDir()
   }
   return zret;
 }
+
+void
+Stripe::unloadDir()
+{
+  if (dir) {
+    ats_free(const_cast<char *>(reinterpret_cast<char const *>(dir)) - this->vol_headerlen());
+    dir = nullptr;
+  }
+}
 //
 // Cache Directory
 //
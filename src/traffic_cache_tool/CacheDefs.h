@@ -158,10 +158,12 @@ public:
   uint32_t write_serial;
   uint32_t dirty;
   uint32_t sector_size;
-  uint32_t unused; // pad out to 8 byte boundary
+  uint32_t url_hash; // proxy.config.cache.url_hash of the keys, 0 in the stripes written before it was kept
   uint16_t freelist[1];
 };
 
+#define DOC_MAGIC ((uint32_t)0x5F129B13)
+
 struct Doc {
   uint32_t magic;     // DOC_MAGIC
   uint32_t len;       // length of this fragment (including hlen & sizeof(Doc), unrounded)
@@ -516,6 +518,8 @@ struct Stripe {
   /// Load metadata for this stripe.
   Errata loadMeta();
   Errata loadDir();
+  /// Free the directory loaded by @c loadDir.
+  void unloadDir();
   int check_loop(int s);
   void dir_check();
   bool walk_bucket_chain(int s); // returns true if there is a loop
@@ -21,6 +21,9 @@
   limitations under the License.
  */
 
+#include <algorithm>
+#include <mutex>
+
 #include "CacheScan.h"
 #include "../../proxy/hdrs/HTTP.h"
 #include "../../proxy/hdrs/HdrHeap.h"
@@ -31,39 +34,31 @@
 
 constexpr HdrHeapMarshalBlocks HTTP_ALT_MARSHAL_SIZE = ts::round_up(sizeof(HTTPCacheAlt));
 
+// The stripes are scanned by several threads, each line is printed whole.
+static std::mutex output_mutex;
+
 namespace ct
 {
 Errata
 CacheScan::Scan(bool search)
 {
-  int64_t guessed_size = 1048576; // 1M
   Errata zret;
   std::bitset<65536> dir_bitset;
-  char *stripe_buff2 = (char *)ats_memalign(ats_pagesize(), guessed_size);
+  // The offset and size of the first fragment of each object, which holds its alternates.
+  std::vector<std::pair<int64_t, int64_t>> heads;
   for (int s = 0; s < this->stripe->_segments; s++) {
     dir_bitset.reset();
+    CacheDirEntry *seg = this->stripe->dir_segment(s);
     for (int b = 0; b < this->stripe->_buckets; b++) {
-      CacheDirEntry *seg = this->stripe->dir_segment(s);
-      CacheDirEntry *e   = dir_bucket(b, seg);
+      CacheDirEntry *e = dir_bucket(b, seg);
       if (dir_offset(e)) {
         do {
           // loop detected
           if (dir_bitset[dir_to_offset(e, seg)]) {
             break;
           }
-          int64_t size = dir_approx_size(e);
-          if (size > guessed_size) {
-            ats_free(stripe_buff2);
-            stripe_buff2 = (char *)ats_memalign(ats_pagesize(), dir_approx_size(e));
-          }
-          int fd         = this->stripe->_span->_fd;
-          int64_t offset = this->stripe->stripe_offset(e);
-          ssize_t n      = pread(fd, stripe_buff2, size, offset);
-          if (n < 0) {
-            std::cout << "Failed to read content from the Stripe.  " << strerror(errno) << std::endl;
-          } else {
-            Doc *doc = reinterpret_cast<Doc *>(stripe_buff2);
-            get_alternates(doc->hdr(), doc->hlen, search);
+          if (dir_head(e)) {
+            heads.emplace_back(this->stripe->stripe_offset(e).count(), dir_approx_size(e));
           }
           dir_bitset[dir_to_offset(e, seg)] = true;
           e                                 = next_dir(e, seg);
@@ -71,7 +66,38 @@ CacheScan::Scan(bool search)
       }
     }
   }
-  ats_free(stripe_buff2);
+  // The directory is no longer needed, it is large for a large stripe.
+  this->stripe->unloadDir();
+
+  // Read the heads in the order they are on the disk, those close to each other at once.
+  std::sort(heads.begin(), heads.end());
+  char *stripe_buff = static_cast<char *>(ats_memalign(ats_pagesize(), READ_SIZE));
+  int fd            = this->stripe->_span->_fd;
+  for (size_t i = 0; i < heads.size();) {
+    int64_t start = heads[i].first;
+    int64_t end   = std::min(start + heads[i].second, start + READ_SIZE);
+    size_t last   = i + 1;
+    while (last < heads.size() && heads[last].first - end <= READ_GAP &&
+           heads[last].first + heads[last].second - start <= READ_SIZE) {
+      end = std::max(end, heads[last].first + heads[last].second);
+      ++last;
+    }
+    ssize_t n = pread(fd, stripe_buff, end - start, start);
+    if (n < 0) {
+      std::cerr << "Failed to read content from the Stripe.  " << strerror(errno) << std::endl;
+    } else {
+      for (; i < last; ++i) {
+        int64_t pos = heads[i].first - start;
+        Doc *doc    = reinterpret_cast<Doc *>(stripe_buff + pos);
+        if (pos + static_cast<int64_t>(sizeof(Doc)) <= n && doc->magic == DOC_MAGIC &&
+            pos + static_cast<int64_t>(sizeof(Doc) + doc->hlen) <= n) {
+          get_alternates(doc->hdr(), doc->hlen, search, doc->total_len);
+        }
+      }
+    }
+    i = last;
+  }
+  ats_free(stripe_buff);
 
   return zret;
 }
@@ -357,7 +383,7 @@ CacheScan::check_url(ts::MemSpan<char> &mem, URLImpl *url)
 }
 
 Errata
-CacheScan::get_alternates(const char *buf, int length, bool search)
+CacheScan::get_alternates(const char *buf, int length, bool search, uint64_t object_size)
 {
   Errata zret;
   ink_assert(!(((intptr_t)buf) & 3)); // buf must be aligned
@@ -386,13 +412,21 @@ CacheScan::get_alternates(const char *buf, int length, bool search)
       if (check_url(doc_mem, url)) {
         std::string str;
 
-        if (search) {
+        if (index) {
+          // one line of tab separated fields per alternate, a single call so that the lines of the threads don't mix
+          ts::bwprint(str, "{}\t{}\t{}://{}:{}/{};{}?{}\n", std::string_view(this->stripe->hashText), object_size,
+                      std::string_view(url->m_ptr_scheme, url->m_len_scheme), std::string_view(url->m_ptr_host, url->m_len_host),
+                      std::string_view(url->m_ptr_port, url->m_len_port), std::string_view(url->m_ptr_path, url->m_len_path),
+                      std::string_view(url->m_ptr_params, url->m_len_params), std::string_view(url->m_ptr_query, url->m_len_query));
+          fwrite(str.data(), 1, str.size(), index);
+        } else if (search) {
           ts::bwprint(str, "{}://{}:{}/{};{}?{}", std::string_view(url->m_ptr_scheme, url->m_len_scheme),
                       std::string_view(url->m_ptr_host, url->m_len_host), std::string_view(url->m_ptr_port, url->m_len_port),
                       std::string_view(url->m_ptr_path, url->m_len_path), std::string_view(url->m_ptr_params, url->m_len_params),
                       std::string_view(url->m_ptr_query, url->m_len_query));
           if (u_matcher->match(str.data())) {
             str = this->stripe->hashText + " " + str;
+            std::lock_guard<std::mutex> lock(output_mutex);
             std::cout << "match found " << str << std::endl;
           }
         } else {
@@ -400,6 +434,7 @@ CacheScan::get_alternates(const char *buf, int length, bool search)
                       std::string_view(url->m_ptr_scheme, url->m_len_scheme), std::string_view(url->m_ptr_host, url->m_len_host),
                       std::string_view(url->m_ptr_port, url->m_len_port), std::string_view(url->m_ptr_path, url->m_len_path),
                       std::string_view(url->m_ptr_params, url->m_len_params), std::string_view(url->m_ptr_query, url->m_len_query));
+          std::lock_guard<std::mutex> lock(output_mutex);
           std::cout << str << std::endl;
         }
       } else {
@@ -41,8 +41,14 @@ class CacheScan
 {
   Stripe *stripe;
   url_matcher *u_matcher;
+  FILE *index = nullptr; ///< Where the index of the cached objects is written, if it is.
 
 public:
+  /// The most bytes read at once, the objects that are close enough on the disk are read together up to that.
+  static constexpr int64_t READ_SIZE = 32 * 1024 * 1024;
+  /// The largest gap between two objects read together, reading it through is cheaper than a seek.
+  static constexpr int64_t READ_GAP = 1024 * 1024;
+
   CacheScan(Stripe *str, ts::file::path const &path) : stripe(str)
   {
     if (!path.empty()) {
@@ -50,8 +56,10 @@ public:
     }
   };
   CacheScan(Stripe *str) : stripe(str) {}
+  /// Write a line to @a index_file for each cached object rather than printing its URL.
+  CacheScan(Stripe *str, FILE *index_file) : stripe(str), index(index_file) {}
   Errata Scan(bool search = false);
-  Errata get_alternates(const char *buf, int length, bool search);
+  Errata get_alternates(const char *buf, int length, bool search, uint64_t object_size = 0);
   int unmarshal(HdrHeap *hh, int buf_length, int obj_type, HdrHeapObjImpl **found_obj, RefCountObj *block_ref);
   Errata unmarshal(char *buf, int len, RefCountObj *block_ref);
   Errata unmarshal(HTTPHdrImpl *obj, intptr_t offset);
@@ -21,6 +21,8 @@
     limitations under the License.
  */
 
+#include <algorithm>
+#include <atomic>
 #include <iostream>
 #include <list>
 #include <memory>
@@ -627,7 +629,8 @@ Cache::dumpSpans(SpanDumpDepth depth)
                             << "\n phase: " << stripe->_meta[i][j].phase << "\n cycle: " << stripe->_meta[i][j].cycle
                             << "\n sync_serial: " << stripe->_meta[i][j].sync_serial
                             << "\n write_serial: " << stripe->_meta[i][j].write_serial << "\n dirty: " << stripe->_meta[i][j].dirty
-                            << "\n sector_size: " << stripe->_meta[i][j].sector_size << std::endl;
+                            << "\n sector_size: " << stripe->_meta[i][j].sector_size
+                            << "\n url_hash: " << stripe->_meta[i][j].url_hash << std::endl;
                 }
               }
               if (!stripe->validate_sync_serial()) {
@@ -1325,24 +1328,28 @@ Get_Response(ts::file::path const &input_file_path)
   }
 }
 
-void static scan_span(Span *span, ts::file::path const &regex_path)
+void static scan_stripe(Stripe *strp, ts::file::path const &regex_path, FILE *index)
 {
-  for (auto strp : span->_stripes) {
-    strp->loadMeta();
-    strp->loadDir();
-
-    if (!regex_path.empty()) {
-      CacheScan cs(strp, regex_path);
-      cs.Scan(true);
-    } else {
-      CacheScan cs(strp);
-      cs.Scan(false);
-    }
+  strp->loadMeta();
+  strp->loadDir();
+
+  if (index) {
+    CacheScan cs(strp, index);
+    cs.Scan(false);
+  } else if (!regex_path.empty()) {
+    CacheScan cs(strp, regex_path);
+    cs.Scan(true);
+  } else {
+    CacheScan cs(strp);
+    cs.Scan(false);
   }
 }
 
+/* Scan the stripes of every span with @a threads threads, one per span by default. The stripes are
+   taken in turns from each span, so that the threads read from as many spans at once as they can.
+ */
 void
-Scan_Cache(ts::file::path const &regex_path)
+Scan_Cache(ts::file::path const &regex_path, int threads, FILE *index = nullptr)
 {
   Cache cache;
   std::vector<std::thread> threadPool;
@@ -1351,19 +1358,60 @@ Scan_Cache(ts::file::path const &regex_path)
       return;
     }
     cache.dumpSpans(Cache::SpanDumpDepth::SPAN);
+
+    std::vector<Stripe *> stripes;
+    std::vector<std::pair<std::list<Stripe *>::iterator, std::list<Stripe *>::iterator>> spans;
     for (auto sp : cache._spans) {
-      threadPool.emplace_back(scan_span, sp, regex_path);
+      spans.emplace_back(sp->_stripes.begin(), sp->_stripes.end());
+    }
+    for (bool more = true; more;) {
+      more = false;
+      for (auto &[spot, limit] : spans) {
+        if (spot != limit) {
+          stripes.push_back(*spot++);
+          more = true;
+        }
+      }
+    }
+
+    std::atomic<size_t> next{0};
+    threads = threads > 0 ? threads : std::max<int>(cache._spans.size(), 1);
+    for (int i = 0; i < threads; ++i) {
+      threadPool.emplace_back([&]() {
+        for (size_t s; (s = next++) < stripes.size();) {
+          scan_stripe(stripes[s], regex_path, index);
+        }
+      });
     }
     for (auto &th : threadPool)
       th.join();
   }
 }
 
+void
+Index_Cache(ts::file::path const &index_path, int threads)
+{
+  if (index_path.empty()) {
+    err.push(0, 1, "The index file is missing, please use --input to name it");
+    return;
+  }
+  FILE *index = fopen(index_path.c_str(), "w");
+  if (index == nullptr) {
+    err.push(0, errno, "Unable to open the index file ", index_path.c_str(), ": ", strerror(errno));
+    return;
+  }
+  Scan_Cache(ts::file::path(), threads, index);
+  if (fclose(index) != 0) {
+    err.push(0, errno, "Unable to write the index file ", index_path.c_str(), ": ", strerror(errno));
+  }
+}
+
 int
 main(int argc, const char *argv[])
 {
   ts::file::path input_url_file;
   std::string inputFile;
+  int threads = 0;
 
   parser.add_global_usage(std::string(argv[0]) + " --spans <SPAN> --volume <FILE> <COMMAND> [<SUBCOMMAND> ...]\n");
   parser.require_commands()
@@ -1373,7 +1421,8 @@ main(int argc, const char *argv[])
     .add_option("--write", "-w", "")
     .add_option("--input", "-i", "", "", 1)
     .add_option("--device", "-d", "", "", 1)
-    .add_option("--aos", "-o", "", "", 1);
+    .add_option("--aos", "-o", "", "", 1)
+    .add_option("--threads", "-t", "", "", 1);
 
   parser.add_command("list", "List elements of the cache", []() { List_Stripes(Cache::SpanDumpDepth::SPAN); })
     .add_command("stripes", "List the stripes", []() { List_Stripes(Cache::SpanDumpDepth::STRIPE); });
@@ -1393,7 +1442,9 @@ main(int argc, const char *argv[])
   parser.add_command("retrieve", " retrieve the response of the given list of URLs", [&]() { Get_Response(input_url_file); });
   parser.add_command("init", " Initializes uninitialized span", [&]() { Init_disk(input_url_file); });
   parser.add_command("scan", " Scans the whole cache and lists the urls of the cached contents",
-                     [&]() { Scan_Cache(input_url_file); });
+                     [&]() { Scan_Cache(input_url_file, threads); });
+  parser.add_command("index", " Scans the whole cache and writes an index of the cached contents to the input file",
+                     [&]() { Index_Cache(input_url_file, threads); });
 
   // parse the arguments
   auto arguments = parser.parse(argv);
@@ -1412,6 +1463,9 @@ main(int argc, const char *argv[])
   if (auto data = arguments.get("device")) {
     inputFile = data.value();
   }
+  if (auto data = arguments.get("threads")) {
+    threads = std::stoi(data.value());
+  }
   if (auto data = arguments.get("write")) {
     OPEN_RW_FLAG = O_RDWR;
     std::cout << "NOTE: Writing to physical devices enabled" << std::endl;
@@ -23,11 +23,71 @@
 
 #include "traffic_ctl.h"
 #include "records/P_RecUtils.h"
+#include "records/I_RecStatsShm.h"
+#include "tscore/Regex.h"
+
+#include <unordered_map>
+
+namespace
+{
+using MetricList = std::vector<std::pair<std::string, std::string>>;
+
+// The metrics of the shared stats segment, in record order, if the server has a recent one.
+bool
+shm_metrics(MetricList &metrics)
+{
+  int64_t updated = 0;
+  bool found      = RecStatsShmRead(
+    RecStatsShmPath().c_str(),
+    [&metrics](const char *name, RecDataT data_type, const RecData &data) {
+      TSRecordValueT value;
+      TSRecordT type;
+      switch (data_type) {
+      case RECD_INT:
+        type          = TS_REC_INT;
+        value.int_val = data.rec_int;
+        break;
+      case RECD_COUNTER:
+        type              = TS_REC_COUNTER;
+        value.counter_val = data.rec_counter;
+        break;
+      case RECD_FLOAT:
+        type            = TS_REC_FLOAT;
+        value.float_val = data.rec_float;
+        break;
+      default:
+        type             = TS_REC_STRING;
+        value.string_val = data.rec_string;
+        break;
+      }
+      metrics.emplace_back(name, CtrlMgmtRecordValue(type, value).c_str());
+    },
+    &updated);
+
+  if (found && time(nullptr) - updated > REC_STATS_SHM_MAX_AGE) {
+    metrics.clear();
+    found = false;
+  }
+  return found;
+}
+} // namespace
 
 void
 CtrlEngine::metric_get()
 {
+  // Metrics the segment has are read from it, the others from the manager.
+  MetricList metrics;
+  std::unordered_map<std::string, std::string> shm;
+  if (shm_metrics(metrics)) {
+    shm.insert(metrics.begin(), metrics.end());
+  }
+
   for (const auto &it : arguments.get("get")) {
+    if (auto found = shm.find(it); found != shm.end()) {
+      std::cout << found->first << ' ' << found->second << std::endl;
+      continue;
+    }
+
     CtrlMgmtRecord record;
     TSMgmtError error;
 
@@ -47,6 +107,24 @@ CtrlEngine::metric_get()
 void
 CtrlEngine::metric_match()
 {
+  MetricList metrics;
+  if (shm_metrics(metrics)) {
+    for (const auto &it : arguments.get("match")) {
+      DFA regex;
+      if (!regex.compile(it.c_str(), RE_CASE_INSENSITIVE | RE_UNANCHORED)) {
+        CtrlMgmtError(TS_ERR_FAIL, "failed to fetch %s", it.c_str());
+        status_code = CTRL_EX_ERROR;
+        return;
+      }
+      for (const auto &metric : metrics) {
+        if (regex.match(metric.first) >= 0) {
+          std::cout << metric.first << ' ' << metric.second << std::endl;
+        }
+      }
+    }
+    return;
+  }
+
   for (const auto &it : arguments.get("match")) {
     CtrlMgmtRecordList reclist;
     TSMgmtError error;
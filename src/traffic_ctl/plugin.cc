@@ -23,6 +23,11 @@
 
 #include "traffic_ctl.h"
 
+#include <cinttypes>
+#include <cstring>
+#include <map>
+#include <string>
+
 void
 CtrlEngine::plugin_msg()
 {
@@ -36,3 +41,52 @@ CtrlEngine::plugin_msg()
     return;
   }
 }
+
+void
+CtrlEngine::plugin_list()
+{
+  // proxy.process.plugin.<plugin>.<hook>.<stat>, the plugin may have dots.
+  static const char prefix[] = "proxy.process.plugin.";
+  struct HookStats {
+    int64_t calls  = 0;
+    int64_t cpu_us = 0;
+  };
+  std::map<std::string, std::map<std::string, HookStats>> plugins;
+  CtrlMgmtRecordList reclist;
+  TSMgmtError error;
+
+  error = reclist.match("^proxy\\.process\\.plugin\\.");
+  if (error != TS_ERR_OKAY) {
+    CtrlMgmtError(error, "failed to fetch the plugin stats");
+    status_code = CTRL_EX_ERROR;
+    return;
+  }
+
+  while (!reclist.empty()) {
+    CtrlMgmtRecord record(reclist.next());
+    std::string name = record.name() + strlen(prefix);
+    size_t stat      = name.rfind('.');
+    size_t hook      = stat == std::string::npos || stat == 0 ? std::string::npos : name.rfind('.', stat - 1);
+    if (hook == std::string::npos) {
+      continue;
+    }
+    HookStats &hs = plugins[name.substr(0, hook)][name.substr(hook + 1, stat - hook - 1)];
+    if (name.compare(stat + 1, std::string::npos, "calls") == 0) {
+      hs.calls = record.as_int();
+    } else if (name.compare(stat + 1, std::string::npos, "cpu_us") == 0) {
+      hs.cpu_us = record.as_int();
+    }
+  }
+
+  if (plugins.empty()) {
+    std::cout << "no plugin hook stats, is proxy.config.plugin.hook_stats set?" << std::endl;
+    return;
+  }
+  printf("%-24s %-32s %12s %14s %10s\n", "PLUGIN", "HOOK", "CALLS", "CPU_US", "AVG_US");
+  for (auto const &[plugin, hooks] : plugins) {
+    for (auto const &[hook, hs] : hooks) {
+      printf("%-24s %-32s %12" PRId64 " %14" PRId64 " %10.1f\n", plugin.c_str(), hook.c_str(), hs.calls, hs.cpu_us,
+             hs.calls ? static_cast<double>(hs.cpu_us) / hs.calls : 0.0);
+    }
+  }
+}
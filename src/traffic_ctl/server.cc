@@ -23,6 +23,10 @@
 
 #include "traffic_ctl.h"
 
+#include <cstring>
+#include <map>
+#include <string>
+
 void
 CtrlEngine::server_restart()
 {
@@ -134,3 +138,69 @@ CtrlEngine::server_drain()
     return;
   }
 }
+
+void
+CtrlEngine::server_trace()
+{
+  std::string path  = arguments.get("output").value();
+  TSMgmtError error = TSDispatchTraceDump(path.c_str());
+
+  if (error != TS_ERR_OKAY) {
+    CtrlMgmtError(error, "server trace failed");
+    status_code = CTRL_EX_ERROR;
+    return;
+  }
+}
+
+void
+CtrlEngine::server_profile()
+{
+  std::string path = arguments.get("output").value();
+  unsigned options = TS_PROFILE_OPT_NONE;
+
+  if (arguments.get("pprof")) {
+    options |= TS_PROFILE_OPT_PPROF;
+  }
+  if (arguments.get("reset")) {
+    options |= TS_PROFILE_OPT_RESET;
+  }
+
+  TSMgmtError error = TSCpuProfileDump(path.c_str(), options);
+  if (error != TS_ERR_OKAY) {
+    CtrlMgmtError(error, "server profile failed");
+    status_code = CTRL_EX_ERROR;
+    return;
+  }
+}
+
+void
+CtrlEngine::server_slow()
+{
+  static const char prefix[] = "proxy.process.http.slow_txn.";
+  std::map<int, std::string> txns;
+  CtrlMgmtRecordList reclist;
+  TSMgmtError error;
+
+  error = reclist.match("^proxy\\.process\\.http\\.slow_txn\\.");
+  if (error != TS_ERR_OKAY) {
+    CtrlMgmtError(error, "failed to fetch the slow transactions");
+    status_code = CTRL_EX_ERROR;
+    return;
+  }
+
+  while (!reclist.empty()) {
+    CtrlMgmtRecord record(reclist.next());
+    CtrlMgmtRecordValue value(record);
+    if (*value.c_str() != '\0') {
+      txns[atoi(record.name() + strlen(prefix))] = value.c_str();
+    }
+  }
+
+  if (txns.empty()) {
+    std::cout << "no slow transactions, is proxy.config.http.slow.capture.count set?" << std::endl;
+    return;
+  }
+  for (auto const &[rank, txn] : txns) {
+    std::cout << txn << std::endl;
+  }
+}
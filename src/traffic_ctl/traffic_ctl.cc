@@ -231,6 +231,8 @@ main(int argc, const char **argv)
   // plugin command
   plugin_command.add_command("msg", "Send message to plugins - a TAG and the message DATA", "", 2, [&]() { engine.plugin_msg(); })
     .add_example_usage("traffic_ctl plugin msg TAG DATA");
+  plugin_command.add_command("list", "Show the time the plugins spend in their hooks", [&]() { engine.plugin_list(); })
+    .add_example_usage("traffic_ctl plugin list");
 
   // server commands
   server_command.add_command("backtrace", "Show a full stack trace of the traffic_server process",
@@ -252,6 +254,16 @@ main(int argc, const char **argv)
     .add_example_usage("traffic_ctl server drain [OPTIONS]")
     .add_option("--no-new-connection", "-N", "Wait for new connections down to threshold before starting draining")
     .add_option("--undo", "-U", "Recover server from the drain mode");
+  server_command.add_command("trace", "Write out the sampled continuation dispatch trace", [&]() { engine.server_trace(); })
+    .add_example_usage("traffic_ctl server trace [OPTIONS]")
+    .add_option("--output", "-o", "File to write the collapsed stacks to, on the traffic_server host", "", 1);
+  server_command.add_command("profile", "Write out the samples of the CPU profiler", [&]() { engine.server_profile(); })
+    .add_example_usage("traffic_ctl server profile [OPTIONS]")
+    .add_option("--output", "-o", "File to write the profile to, on the traffic_server host", "", 1)
+    .add_option("--pprof", "-p", "Write a gperftools CPU profile for pprof instead of collapsed stacks")
+    .add_option("--reset", "-r", "Drop the samples once written");
+  server_command.add_command("slow", "Show the slowest transactions of the last interval", [&]() { engine.server_slow(); })
+    .add_example_usage("traffic_ctl server slow");
 
   // storage commands
   storage_command
@@ -206,6 +206,7 @@ struct CtrlEngine {
 
   // metric methods
   void plugin_msg();
+  void plugin_list();
 
   // server methods
   void server_restart();
@@ -214,6 +215,9 @@ struct CtrlEngine {
   void server_stop();
   void server_start();
   void server_drain();
+  void server_trace();
+  void server_profile();
+  void server_slow();
 
   // storage methods
   void storage_offline();
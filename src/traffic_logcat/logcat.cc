@@ -41,6 +41,7 @@
 #include "LogObject.h"
 #include "LogConfig.h"
 #include "LogBuffer.h"
+#include "LogColumnBlock.h"
 #include "LogUtils.h"
 #include "Log.h"
 
@@ -53,6 +54,11 @@ static int elf2_flag               = 0;
 static int auto_filenames          = 0;
 static int overwrite_existing_file = 0;
 static char output_file[1024];
+static char alt_format[1024];
+
+// the fields and printf string of alt_format, to decode only those columns of columnar logs
+static char *alt_symbol_str = nullptr;
+static char *alt_printf_str = nullptr;
 int auto_clear_cache_flag = 0;
 
 static const ArgumentDescription argument_descriptions[] = {
@@ -66,6 +72,7 @@ static const ArgumentDescription argument_descriptions[] = {
   {"debug_tags", 'T', "Colon-Separated Debug Tags", "S1023", error_tags, NULL, NULL},
   {"overwrite_output", 'w', "Overwrite existing output file(s)", "T", &overwrite_existing_file, NULL, NULL},
   {"elf2", '2', "Convert to Extended2 Logging Format", "T", &elf2_flag, NULL, NULL},
+  {"format", 'F', "Print only these fields, in this custom log format", "S1023", &alt_format, NULL, NULL},
   HELP_ARGUMENT_DESCRIPTION(),
   VERSION_ARGUMENT_DESCRIPTION(),
   RUNROOT_ARGUMENT_DESCRIPTION()};
@@ -114,6 +121,66 @@ follow_rotate(const char *input_file, ino_t old_inode_num)
   }
 }
 
+/*-------------------------------------------------------------------------
+  process_column_block
+
+  Read the rest of a block of a columnar log, whose first bytes are in
+  the given buffer, and print its entries. Only the columns of the fields
+  of the alternate format are decompressed.
+  -------------------------------------------------------------------------*/
+
+static int
+process_column_block(int in_fd, int out_fd, char *first, unsigned first_size)
+{
+  LogColumnBlockHeader block_header;
+  memcpy(&block_header, first, first_size);
+
+  int nread = read(in_fd, reinterpret_cast<char *>(&block_header) + first_size, sizeof(block_header) - first_size);
+  if (nread != static_cast<int>(sizeof(block_header) - first_size)) {
+    if (follow_flag) {
+      return 0;
+    }
+    fprintf(stderr, "Bad columnar block header read!\n");
+    return 1;
+  }
+  if (block_header.byte_count <= sizeof(block_header)) {
+    fprintf(stderr, "No block body!\n");
+    return 1;
+  }
+
+  char *block = static_cast<char *>(ats_malloc(block_header.byte_count));
+  memcpy(block, &block_header, sizeof(block_header));
+
+  // Read the rest of the block (allowing for "partial" reads)
+  unsigned block_bytes = block_header.byte_count - sizeof(block_header);
+  unsigned total_read  = 0;
+  while (total_read < block_bytes) {
+    int rc = read(in_fd, block + sizeof(block_header) + total_read, block_bytes - total_read);
+
+    if ((rc == EOF) && (!follow_flag)) {
+      fprintf(stderr, "Bad columnar block read!\n");
+      ats_free(block);
+      return 1;
+    }
+
+    if (rc > 0) {
+      total_read += rc;
+    }
+  }
+
+  LogBufferHeader *header =
+    LogColumnBlock::decode(reinterpret_cast<LogColumnBlockHeader *>(block), alt_symbol_str, alt_printf_str);
+  ats_free(block);
+  if (header == nullptr) {
+    fprintf(stderr, "Bad columnar block!\n");
+    return 1;
+  }
+
+  LogFile::write_ascii_logbuffer(header, out_fd, ".");
+  ats_free(header);
+  return 0;
+}
+
 static int
 process_file(int in_fd, int out_fd)
 {
@@ -139,6 +206,13 @@ process_file(int in_fd, int out_fd)
       return 0;
     }
 
+    if (header->cookie == LOG_COLUMN_COOKIE) {
+      if (process_column_block(in_fd, out_fd, buffer, first_read_size) != 0) {
+        return 1;
+      }
+      continue;
+    }
+
     // ensure that this is a valid logbuffer header
     //
     if (header->cookie != LOG_SEGMENT_COOKIE) {
@@ -193,14 +267,11 @@ process_file(int in_fd, int out_fd)
       fprintf(stderr, "Read too many bytes!\n");
       return 1;
     }
-    // see if there is an alternate format request from the command
-    // line
-    //
-    const char *alt_format = nullptr;
-    // convert the buffer to ascii entries and place onto stdout
+    // convert the buffer to ascii entries and place onto stdout, in the
+    // alternate format if there is one from the command line
     //
     if (header->fmt_fieldlist()) {
-      bytes += LogFile::write_ascii_logbuffer(header, out_fd, ".", alt_format);
+      bytes += LogFile::write_ascii_logbuffer(header, out_fd, ".", alt_format[0] ? alt_format : nullptr);
     } else {
       // TODO investigate why this buffer goes wonky
     }
@@ -263,6 +334,7 @@ main(int /* argc ATS_UNUSED */, const char *argv[])
   // process command-line arguments
   //
   output_file[0] = 0;
+  alt_format[0]  = 0;
   process_args(&appVersionInfo, argument_descriptions, countof(argument_descriptions), argv);
 
   // check that only one of the -o and -a options was specified
@@ -277,6 +349,11 @@ main(int /* argc ATS_UNUSED */, const char *argv[])
 
   Log::init(Log::NO_REMOTE_MANAGEMENT | Log::LOGCAT);
 
+  if (alt_format[0] && LogFormat::parse_format_string(alt_format, &alt_printf_str, &alt_symbol_str) <= 0) {
+    fprintf(stderr, "Error: invalid format %s\n", alt_format);
+    ::exit(CMD_LINE_OPTION_ERROR);
+  }
+
   // setup output file
   //
   int out_fd = STDOUT_FILENO;
@@ -294,8 +371,9 @@ main(int /* argc ATS_UNUSED */, const char *argv[])
   int error = NO_ERROR;
 
   if (n_file_arguments) {
-    int bin_ext_len   = strlen(LOG_FILE_BINARY_OBJECT_FILENAME_EXTENSION);
-    int ascii_ext_len = strlen(LOG_FILE_ASCII_OBJECT_FILENAME_EXTENSION);
+    int bin_ext_len      = strlen(LOG_FILE_BINARY_OBJECT_FILENAME_EXTENSION);
+    int columnar_ext_len = strlen(LOG_FILE_COLUMNAR_OBJECT_FILENAME_EXTENSION);
+    int ascii_ext_len    = strlen(LOG_FILE_ASCII_OBJECT_FILENAME_EXTENSION);
 
     for (unsigned i = 0; i < n_file_arguments; ++i) {
       int in_fd = open(file_arguments[i], O_RDONLY);
@@ -315,13 +393,16 @@ main(int /* argc ATS_UNUSED */, const char *argv[])
         posix_fadvise(in_fd, 0, 0, POSIX_FADV_SEQUENTIAL);
 #endif
         if (auto_filenames) {
-          // change .blog to .log
+          // change .blog (or .clog) to .log
           //
-          int n = strlen(file_arguments[i]);
-          int copy_len =
-            (n >= bin_ext_len ?
-               (strcmp(&file_arguments[i][n - bin_ext_len], LOG_FILE_BINARY_OBJECT_FILENAME_EXTENSION) == 0 ? n - bin_ext_len : n) :
-               n);
+          int n        = strlen(file_arguments[i]);
+          int copy_len = n;
+          if (n >= bin_ext_len && strcmp(&file_arguments[i][n - bin_ext_len], LOG_FILE_BINARY_OBJECT_FILENAME_EXTENSION) == 0) {
+            copy_len = n - bin_ext_len;
+          } else if (n >= columnar_ext_len &&
+                     strcmp(&file_arguments[i][n - columnar_ext_len], LOG_FILE_COLUMNAR_OBJECT_FILENAME_EXTENSION) == 0) {
+            copy_len = n - columnar_ext_len;
+          }
 
           char *out_filename = (char *)ats_malloc(copy_len + ascii_ext_len + 1);
 
@@ -35,6 +35,7 @@
 #include "LogStandalone.cc"
 
 #include "LogObject.h"
+#include "LogColumnBlock.h"
 #include "hdrs/HTTP.h"
 
 #include <sys/utsname.h>
@@ -57,6 +58,10 @@
 #include <unordered_map>
 #include <unordered_set>
 #include <string_view>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <sys/mman.h>
 
 #ifndef _XOPEN_SOURCE
 #define _XOPEN_SOURCE 600
@@ -341,6 +346,21 @@ typedef std::unordered_map<const char *, OriginStats *, hash_fnv32, eqstr> Origi
 typedef std::unordered_set<const char *, hash_fnv32, eqstr> OriginSet;
 typedef std::unordered_map<const char *, LruStack::iterator, hash_fnv32, eqstr> LruHash;
 
+inline void init_elapsed(OriginStats *stats);
+
+// The stats collected by one parsing thread, merged into the results when the threads are done.
+struct Aggregate {
+  OriginStats totals;
+  OriginStorage origins;
+  int parse_errors = 0;
+
+  Aggregate()
+  {
+    memset(&totals, 0, sizeof(totals));
+    init_elapsed(&totals);
+  }
+};
+
 // Resize a hash-based container.
 template <class T, class N>
 void
@@ -588,11 +608,9 @@ private:
 
 ///////////////////////////////////////////////////////////////////////////////
 // Globals, holding the accumulated stats (ok, I'm lazy ...)
-static OriginStats totals;
-static OriginStorage origins;
+static Aggregate results;
 static OriginSet *origin_set;
 static UrlLru *urls;
-static int parse_errors;
 
 // Command line arguments (parsing)
 struct CommandLineArgs {
@@ -615,6 +633,7 @@ struct CommandLineArgs {
   int concise         = 0; // Eliminate metrics that can be inferred by other values
   int report_per_user = 0; // A flag to aggregate and report stats per user instead of per host if 'true' (default 'false')
   int no_format_check = 0; // A flag to skip the log format check if any of the fields is not a standard squid log format field.
+  int threads         = 1; // Threads parsing the log buffers, 0 for one per CPU
 
   CommandLineArgs() : line_len(DEFAULT_LINE_LEN)
 
@@ -651,6 +670,7 @@ static ArgumentDescription argument_descriptions[] = {
   {"debug_tags", 'T', "Colon-Separated Debug Tags", "S1023", &error_tags, nullptr, nullptr},
   {"report_per_user", 'r', "Report stats per user instead of host", "T", &cl.report_per_user, nullptr, nullptr},
   {"no_format_check", 'n', "Don't validate the log format field names", "T", &cl.no_format_check, nullptr, nullptr},
+  {"threads", 'p', "Number of threads parsing the log, 0 for one per CPU", "I", &cl.threads, nullptr, nullptr},
   HELP_ARGUMENT_DESCRIPTION(),
   VERSION_ARGUMENT_DESCRIPTION(),
   RUNROOT_ARGUMENT_DESCRIPTION()};
@@ -1186,7 +1206,7 @@ update_protocols(OriginStats *stat, bool ipv6, int size)
 ///////////////////////////////////////////////////////////////////////////////
 // Finds or creates a stats structures if missing
 OriginStats *
-find_or_create_stats(const char *key)
+find_or_create_stats(Aggregate &agg, const char *key)
 {
   OriginStats *o_stats = nullptr;
   OriginStorage::iterator o_iter;
@@ -1195,15 +1215,15 @@ find_or_create_stats(const char *key)
   // TODO: If we save state (struct) for a run, we probably need to always
   // update the origin data, no matter what the origin_set is.
   if (origin_set->empty() || (origin_set->find(key) != origin_set->end())) {
-    o_iter = origins.find(key);
-    if (origins.end() == o_iter) {
+    o_iter = agg.origins.find(key);
+    if (agg.origins.end() == o_iter) {
       o_stats = (OriginStats *)ats_malloc(sizeof(OriginStats));
       memset(o_stats, 0, sizeof(OriginStats));
       init_elapsed(o_stats);
       o_server = ats_strdup(key);
       if (o_server) {
         o_stats->server   = o_server;
-        origins[o_server] = o_stats;
+        agg.origins[o_server] = o_stats;
       }
     } else {
       o_stats = o_iter->second;
@@ -1215,15 +1235,15 @@ find_or_create_stats(const char *key)
 ///////////////////////////////////////////////////////////////////////////////
 // Update the stats
 void
-update_stats(OriginStats *o_stats, const HTTPMethod method, URLScheme scheme, int http_code, int size, int result, int hier,
-             int elapsed, bool ipv6)
+update_stats(Aggregate &agg, OriginStats *o_stats, const HTTPMethod method, URLScheme scheme, int http_code, int size, int result,
+             int hier, int elapsed, bool ipv6)
 {
-  update_results_elapsed(&totals, result, elapsed, size);
-  update_codes(&totals, http_code, size);
-  update_methods(&totals, method, size);
-  update_schemes(&totals, scheme, size);
-  update_protocols(&totals, ipv6, size);
-  update_counter(totals.total, size);
+  update_results_elapsed(&agg.totals, result, elapsed, size);
+  update_codes(&agg.totals, http_code, size);
+  update_methods(&agg.totals, method, size);
+  update_schemes(&agg.totals, scheme, size);
+  update_protocols(&agg.totals, ipv6, size);
+  update_counter(agg.totals.total, size);
   if (nullptr != o_stats) {
     update_results_elapsed(o_stats, result, elapsed, size);
     update_codes(o_stats, http_code, size);
@@ -1234,12 +1254,104 @@ update_stats(OriginStats *o_stats, const HTTPMethod method, URLScheme scheme, in
   }
 }
 
+///////////////////////////////////////////////////////////////////////////////
+// Merge the elapsed stats of @a from, over @a from_counter requests, into @a to, over @a to_counter.
+// This has to be done before the counters are merged.
+inline void
+merge_elapsed(ElapsedStats &to, const StatsCounter &to_counter, const ElapsedStats &from, const StatsCounter &from_counter)
+{
+  int64_t count = to_counter.count + from_counter.count;
+
+  if (0 == from_counter.count || -1 == from.min) {
+    return;
+  }
+  if (-1 == to.min || to.min > from.min) {
+    to.min = from.min;
+  }
+  if (to.max < from.max) {
+    to.max = from.max;
+  }
+
+  // Combine the sums and the sums of squares the averages and the deviations stand for.
+  double to_avg = to.avg, to_dev = to.stddev, from_avg = from.avg, from_dev = from.stddev;
+  double sum    = to_avg * to_counter.count + from_avg * from_counter.count;
+  double sum_of_squares =
+    (to_dev * to_dev + to_avg * to_avg) * to_counter.count + (from_dev * from_dev + from_avg * from_avg) * from_counter.count;
+  double avg = sum / count;
+
+  to.avg    = avg;
+  to.stddev = sqrt(std::max(0.0, sum_of_squares / count - avg * avg));
+}
+
+// Add the counters of @a from, a struct of nothing but StatsCounter, to @a to.
+template <class T>
+inline void
+merge_counters(T &to, const T &from)
+{
+  static_assert(sizeof(T) % sizeof(StatsCounter) == 0, "merge_counters() is only for structs of StatsCounter");
+  StatsCounter *t       = reinterpret_cast<StatsCounter *>(&to);
+  const StatsCounter *f = reinterpret_cast<const StatsCounter *>(&from);
+
+  for (size_t i = 0; i < sizeof(T) / sizeof(StatsCounter); ++i) {
+    t[i].count += f[i].count;
+    t[i].bytes += f[i].bytes;
+  }
+}
+
+// Merge the stats of @a from into @a to.
+void
+merge_stats(OriginStats *to, const OriginStats *from)
+{
+  merge_elapsed(to->elapsed.hits.hit, to->results.hits.hit, from->elapsed.hits.hit, from->results.hits.hit);
+  merge_elapsed(to->elapsed.hits.hit_ram, to->results.hits.hit_ram, from->elapsed.hits.hit_ram, from->results.hits.hit_ram);
+  merge_elapsed(to->elapsed.hits.ims, to->results.hits.ims, from->elapsed.hits.ims, from->results.hits.ims);
+  merge_elapsed(to->elapsed.hits.refresh, to->results.hits.refresh, from->elapsed.hits.refresh, from->results.hits.refresh);
+  merge_elapsed(to->elapsed.hits.other, to->results.hits.other, from->elapsed.hits.other, from->results.hits.other);
+  merge_elapsed(to->elapsed.hits.total, to->results.hits.total, from->elapsed.hits.total, from->results.hits.total);
+  merge_elapsed(to->elapsed.misses.miss, to->results.misses.miss, from->elapsed.misses.miss, from->results.misses.miss);
+  merge_elapsed(to->elapsed.misses.ims, to->results.misses.ims, from->elapsed.misses.ims, from->results.misses.ims);
+  merge_elapsed(to->elapsed.misses.refresh, to->results.misses.refresh, from->elapsed.misses.refresh,
+                from->results.misses.refresh);
+  merge_elapsed(to->elapsed.misses.other, to->results.misses.other, from->elapsed.misses.other, from->results.misses.other);
+  merge_elapsed(to->elapsed.misses.total, to->results.misses.total, from->elapsed.misses.total, from->results.misses.total);
+
+  merge_counters(to->total, from->total);
+  merge_counters(to->results, from->results);
+  merge_counters(to->codes, from->codes);
+  merge_counters(to->hierarchies, from->hierarchies);
+  merge_counters(to->schemes, from->schemes);
+  merge_counters(to->protocols, from->protocols);
+  merge_counters(to->methods, from->methods);
+  merge_counters(to->content, from->content);
+}
+
+// Merge the stats of a parsing thread into @a to, taking over its Origins.
+void
+merge_aggregate(Aggregate &to, Aggregate &from)
+{
+  merge_stats(&to.totals, &from.totals);
+  for (auto &o : from.origins) {
+    OriginStorage::iterator i = to.origins.find(o.first);
+
+    if (to.origins.end() == i) {
+      to.origins[o.first] = o.second;
+    } else {
+      merge_stats(i->second, o.second);
+      ats_free(const_cast<char *>(o.second->server));
+      ats_free(o.second);
+    }
+  }
+  from.origins.clear();
+  to.parse_errors += from.parse_errors;
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 // Parse a log buffer
 int
-parse_log_buff(LogBufferHeader *buf_header, bool summary = false, bool aggregate_per_userid = false)
+parse_log_buff(LogBufferHeader *buf_header, Aggregate &agg, bool summary = false, bool aggregate_per_userid = false)
 {
   static LogFieldList *fieldlist = nullptr;
+  static std::once_flag fieldlist_once;
 
   LogEntryHeader *entry;
   LogBufferIterator buf_iter(buf_header);
@@ -1259,12 +1371,12 @@ parse_log_buff(LogBufferHeader *buf_header, bool summary = false, bool aggregate
   HTTPMethod method;
   URLScheme scheme;
 
-  if (!fieldlist) {
+  std::call_once(fieldlist_once, [buf_header]() {
     fieldlist = new LogFieldList;
     ink_assert(fieldlist != nullptr);
     bool agg = false;
     LogFormat::parse_symbol_string(buf_header->fmt_fieldlist(), fieldlist, &agg);
-  }
+  });
 
   if (!cl.no_format_check) {
     // Validate the fieldlist
@@ -1431,7 +1543,7 @@ parse_log_buff(LogBufferHeader *buf_header, bool summary = false, bool aggregate
             *ptr = '\0';
           }
           if (!aggregate_per_userid && !summary) {
-            o_stats = find_or_create_stats(tok);
+            o_stats = find_or_create_stats(agg, tok);
           }
         } else {
           // No method given
@@ -1442,7 +1554,7 @@ parse_log_buff(LogBufferHeader *buf_header, bool summary = false, bool aggregate
         }
         read_from += LogAccess::round_strlen(tok_len + 1);
         if (!aggregate_per_userid) {
-          update_stats(o_stats, method, scheme, http_code, size, result, hier, elapsed, ipv6);
+          update_stats(agg, o_stats, method, scheme, http_code, size, result, hier, elapsed, ipv6);
         }
         break;
 
@@ -1451,9 +1563,9 @@ parse_log_buff(LogBufferHeader *buf_header, bool summary = false, bool aggregate
 
         if (aggregate_per_userid) {
           if (!summary) {
-            o_stats = find_or_create_stats(read_from);
+            o_stats = find_or_create_stats(agg, read_from);
           }
-          update_stats(o_stats, method, scheme, http_code, size, result, hier, elapsed, ipv6);
+          update_stats(agg, o_stats, method, scheme, http_code, size, result, hier, elapsed, ipv6);
         }
 
         if ('-' == *read_from) {
@@ -1468,43 +1580,43 @@ parse_log_buff(LogBufferHeader *buf_header, bool summary = false, bool aggregate
         hier  = *((int64_t *)(read_from));
         switch (hier) {
         case SQUID_HIER_NONE:
-          update_counter(totals.hierarchies.none, size);
+          update_counter(agg.totals.hierarchies.none, size);
           if (o_stats != nullptr) {
             update_counter(o_stats->hierarchies.none, size);
           }
           break;
         case SQUID_HIER_DIRECT:
-          update_counter(totals.hierarchies.direct, size);
+          update_counter(agg.totals.hierarchies.direct, size);
           if (o_stats != nullptr) {
             update_counter(o_stats->hierarchies.direct, size);
           }
           break;
         case SQUID_HIER_SIBLING_HIT:
-          update_counter(totals.hierarchies.sibling, size);
+          update_counter(agg.totals.hierarchies.sibling, size);
           if (o_stats != nullptr) {
             update_counter(o_stats->hierarchies.sibling, size);
           }
           break;
         case SQUID_HIER_PARENT_HIT:
-          update_counter(totals.hierarchies.parent, size);
+          update_counter(agg.totals.hierarchies.parent, size);
           if (o_stats != nullptr) {
             update_counter(o_stats->hierarchies.direct, size);
           }
           break;
         case SQUID_HIER_EMPTY:
-          update_counter(totals.hierarchies.empty, size);
+          update_counter(agg.totals.hierarchies.empty, size);
           if (o_stats != nullptr) {
             update_counter(o_stats->hierarchies.empty, size);
           }
           break;
         default:
           if ((hier >= SQUID_HIER_EMPTY) && (hier < SQUID_HIER_INVALID_ASSIGNED_CODE)) {
-            update_counter(totals.hierarchies.other, size);
+            update_counter(agg.totals.hierarchies.other, size);
             if (o_stats != nullptr) {
               update_counter(o_stats->hierarchies.other, size);
             }
           } else {
-            update_counter(totals.hierarchies.invalid, size);
+            update_counter(agg.totals.hierarchies.invalid, size);
             if (o_stats != nullptr) {
               update_counter(o_stats->hierarchies.invalid, size);
             }
@@ -1526,7 +1638,7 @@ parse_log_buff(LogBufferHeader *buf_header, bool summary = false, bool aggregate
       case P_STATE_TYPE:
         state = P_STATE_END;
         if (IMAG_AS_INT == *reinterpret_cast<int *>(read_from)) {
-          update_counter(totals.content.image.total, size);
+          update_counter(agg.totals.content.image.total, size);
           if (o_stats != nullptr) {
             update_counter(o_stats->content.image.total, size);
           }
@@ -1534,42 +1646,42 @@ parse_log_buff(LogBufferHeader *buf_header, bool summary = false, bool aggregate
           switch (*reinterpret_cast<int *>(tok)) {
           case JPEG_AS_INT:
             tok_len = 10;
-            update_counter(totals.content.image.jpeg, size);
+            update_counter(agg.totals.content.image.jpeg, size);
             if (o_stats != nullptr) {
               update_counter(o_stats->content.image.jpeg, size);
             }
             break;
           case JPG_AS_INT:
             tok_len = 9;
-            update_counter(totals.content.image.jpeg, size);
+            update_counter(agg.totals.content.image.jpeg, size);
             if (o_stats != nullptr) {
               update_counter(o_stats->content.image.jpeg, size);
             }
             break;
           case GIF_AS_INT:
             tok_len = 9;
-            update_counter(totals.content.image.gif, size);
+            update_counter(agg.totals.content.image.gif, size);
             if (o_stats != nullptr) {
               update_counter(o_stats->content.image.gif, size);
             }
             break;
           case PNG_AS_INT:
             tok_len = 9;
-            update_counter(totals.content.image.png, size);
+            update_counter(agg.totals.content.image.png, size);
             if (o_stats != nullptr) {
               update_counter(o_stats->content.image.png, size);
             }
             break;
           case BMP_AS_INT:
             tok_len = 9;
-            update_counter(totals.content.image.bmp, size);
+            update_counter(agg.totals.content.image.bmp, size);
             if (o_stats != nullptr) {
               update_counter(o_stats->content.image.bmp, size);
             }
             break;
           default:
             tok_len = 6 + strlen(tok);
-            update_counter(totals.content.image.other, size);
+            update_counter(agg.totals.content.image.other, size);
             if (o_stats != nullptr) {
               update_counter(o_stats->content.image.other, size);
             }
@@ -1577,7 +1689,7 @@ parse_log_buff(LogBufferHeader *buf_header, bool summary = false, bool aggregate
           }
         } else if (TEXT_AS_INT == *reinterpret_cast<int *>(read_from)) {
           tok = read_from + 5;
-          update_counter(totals.content.text.total, size);
+          update_counter(agg.totals.content.text.total, size);
           if (o_stats != nullptr) {
             update_counter(o_stats->content.text.total, size);
           }
@@ -1585,42 +1697,42 @@ parse_log_buff(LogBufferHeader *buf_header, bool summary = false, bool aggregate
           case JAVA_AS_INT:
             // TODO verify if really "javascript"
             tok_len = 15;
-            update_counter(totals.content.text.javascript, size);
+            update_counter(agg.totals.content.text.javascript, size);
             if (o_stats != nullptr) {
               update_counter(o_stats->content.text.javascript, size);
             }
             break;
           case CSS_AS_INT:
             tok_len = 8;
-            update_counter(totals.content.text.css, size);
+            update_counter(agg.totals.content.text.css, size);
             if (o_stats != nullptr) {
               update_counter(o_stats->content.text.css, size);
             }
             break;
           case XML_AS_INT:
             tok_len = 8;
-            update_counter(totals.content.text.xml, size);
+            update_counter(agg.totals.content.text.xml, size);
             if (o_stats != nullptr) {
               update_counter(o_stats->content.text.xml, size);
             }
             break;
           case HTML_AS_INT:
             tok_len = 9;
-            update_counter(totals.content.text.html, size);
+            update_counter(agg.totals.content.text.html, size);
             if (o_stats != nullptr) {
               update_counter(o_stats->content.text.html, size);
             }
             break;
           case PLAI_AS_INT:
             tok_len = 10;
-            update_counter(totals.content.text.plain, size);
+            update_counter(agg.totals.content.text.plain, size);
             if (o_stats != nullptr) {
               update_counter(o_stats->content.text.plain, size);
             }
             break;
           default:
             tok_len = 5 + strlen(tok);
-            update_counter(totals.content.text.other, size);
+            update_counter(agg.totals.content.text.other, size);
             if (o_stats != nullptr) {
               update_counter(o_stats->content.text.other, size);
             }
@@ -1628,28 +1740,28 @@ parse_log_buff(LogBufferHeader *buf_header, bool summary = false, bool aggregate
           }
         } else if (0 == strncmp(read_from, "application", 11)) {
           tok = read_from + 12;
-          update_counter(totals.content.application.total, size);
+          update_counter(agg.totals.content.application.total, size);
           if (o_stats != nullptr) {
             update_counter(o_stats->content.application.total, size);
           }
           switch (*reinterpret_cast<int *>(tok)) {
           case ZIP_AS_INT:
             tok_len = 15;
-            update_counter(totals.content.application.zip, size);
+            update_counter(agg.totals.content.application.zip, size);
             if (o_stats != nullptr) {
               update_counter(o_stats->content.application.zip, size);
             }
             break;
           case JAVA_AS_INT:
             tok_len = 22;
-            update_counter(totals.content.application.javascript, size);
+            update_counter(agg.totals.content.application.javascript, size);
             if (o_stats != nullptr) {
               update_counter(o_stats->content.application.javascript, size);
             }
             break;
           case X_JA_AS_INT:
             tok_len = 24;
-            update_counter(totals.content.application.javascript, size);
+            update_counter(agg.totals.content.application.javascript, size);
             if (o_stats != nullptr) {
               update_counter(o_stats->content.application.javascript, size);
             }
@@ -1657,19 +1769,19 @@ parse_log_buff(LogBufferHeader *buf_header, bool summary = false, bool aggregate
           case RSSp_AS_INT:
             if (0 == strcmp(tok + 4, "xml")) {
               tok_len = 19;
-              update_counter(totals.content.application.rss_xml, size);
+              update_counter(agg.totals.content.application.rss_xml, size);
               if (o_stats != nullptr) {
                 update_counter(o_stats->content.application.rss_xml, size);
               }
             } else if (0 == strcmp(tok + 4, "atom")) {
               tok_len = 20;
-              update_counter(totals.content.application.rss_atom, size);
+              update_counter(agg.totals.content.application.rss_atom, size);
               if (o_stats != nullptr) {
                 update_counter(o_stats->content.application.rss_atom, size);
               }
             } else {
               tok_len = 12 + strlen(tok);
-              update_counter(totals.content.application.rss_other, size);
+              update_counter(agg.totals.content.application.rss_other, size);
               if (o_stats != nullptr) {
                 update_counter(o_stats->content.application.rss_other, size);
               }
@@ -1678,19 +1790,19 @@ parse_log_buff(LogBufferHeader *buf_header, bool summary = false, bool aggregate
           default:
             if (0 == strcmp(tok, "x-shockwave-flash")) {
               tok_len = 29;
-              update_counter(totals.content.application.shockwave_flash, size);
+              update_counter(agg.totals.content.application.shockwave_flash, size);
               if (o_stats != nullptr) {
                 update_counter(o_stats->content.application.shockwave_flash, size);
               }
             } else if (0 == strcmp(tok, "x-quicktimeplayer")) {
               tok_len = 29;
-              update_counter(totals.content.application.quicktime, size);
+              update_counter(agg.totals.content.application.quicktime, size);
               if (o_stats != nullptr) {
                 update_counter(o_stats->content.application.quicktime, size);
               }
             } else {
               tok_len = 12 + strlen(tok);
-              update_counter(totals.content.application.other, size);
+              update_counter(agg.totals.content.application.other, size);
               if (o_stats != nullptr) {
                 update_counter(o_stats->content.application.other, size);
               }
@@ -1699,35 +1811,35 @@ parse_log_buff(LogBufferHeader *buf_header, bool summary = false, bool aggregate
         } else if (0 == strncmp(read_from, "audio", 5)) {
           tok     = read_from + 6;
           tok_len = 6 + strlen(tok);
-          update_counter(totals.content.audio.total, size);
+          update_counter(agg.totals.content.audio.total, size);
           if (o_stats != nullptr) {
             update_counter(o_stats->content.audio.total, size);
           }
           if ((0 == strcmp(tok, "x-wav")) || (0 == strcmp(tok, "wav"))) {
-            update_counter(totals.content.audio.wav, size);
+            update_counter(agg.totals.content.audio.wav, size);
             if (o_stats != nullptr) {
               update_counter(o_stats->content.audio.wav, size);
             }
           } else if ((0 == strcmp(tok, "x-mpeg")) || (0 == strcmp(tok, "mpeg"))) {
-            update_counter(totals.content.audio.mpeg, size);
+            update_counter(agg.totals.content.audio.mpeg, size);
             if (o_stats != nullptr) {
               update_counter(o_stats->content.audio.mpeg, size);
             }
           } else {
-            update_counter(totals.content.audio.other, size);
+            update_counter(agg.totals.content.audio.other, size);
             if (o_stats != nullptr) {
               update_counter(o_stats->content.audio.other, size);
             }
           }
         } else if ('-' == *read_from) {
           tok_len = 1;
-          update_counter(totals.content.none, size);
+          update_counter(agg.totals.content.none, size);
           if (o_stats != nullptr) {
             update_counter(o_stats->content.none, size);
           }
         } else {
           tok_len = strlen(read_from);
-          update_counter(totals.content.other, size);
+          update_counter(agg.totals.content.other, size);
           if (o_stats != nullptr) {
             update_counter(o_stats->content.other, size);
           }
@@ -1739,7 +1851,7 @@ parse_log_buff(LogBufferHeader *buf_header, bool summary = false, bool aggregate
       case P_STATE_END:
         // Nothing to do really
         if (flag) {
-          parse_errors++;
+          agg.parse_errors++;
         }
         break;
       }
@@ -1750,9 +1862,89 @@ parse_log_buff(LogBufferHeader *buf_header, bool summary = false, bool aggregate
 }
 
 ///////////////////////////////////////////////////////////////////////////////
-// Process a file (FD)
+// Read the payload of a buffer or block, allowing for partial reads.
 int
-process_file(int in_fd, off_t offset, unsigned max_age)
+read_payload(int in_fd, char *buf, int buffer_bytes)
+{
+  const int MAX_READ_TRIES = 5;
+  int total_read           = 0;
+  int read_tries_remaining = MAX_READ_TRIES; // since the data will be old anyway, let's only try a few times.
+  do {
+    int nread = read(in_fd, &buf[total_read], buffer_bytes - total_read);
+    if (EOF == nread || !nread) { // just bail on error
+      Debug("logstats", "Read failed while reading log buffer, wanted %d bytes, nread=%d, errno=%d", buffer_bytes - total_read,
+            nread, errno);
+      return 1;
+    } else {
+      total_read += nread;
+    }
+
+    if (total_read < buffer_bytes) {
+      if (--read_tries_remaining <= 0) {
+        Debug("logstats_failed_retries", "Unable to read after %d tries, total_read=%d, buffer_bytes=%d", MAX_READ_TRIES,
+              total_read, buffer_bytes);
+        return 1;
+      }
+      // let's wait until we get more data on this file descriptor
+      Debug("logstats_partial_read", "Failed to read buffer payload [%d bytes], total_read=%d, buffer_bytes=%d, tries_remaining=%d",
+            buffer_bytes - total_read, total_read, buffer_bytes, read_tries_remaining);
+      usleep(50 * 1000); // wait 50ms
+    }
+  } while (total_read < buffer_bytes);
+
+  return 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Parse a whole block of a columnar log.
+// An old block is skipped by its header, without decompressing it.
+int
+parse_column_block(LogColumnBlockHeader *block, Aggregate &agg, unsigned max_age)
+{
+  if (block->buffer_header()->high_timestamp < max_age) {
+    Debug("logstats", "Skipping old block (age=%d, max=%d)", block->buffer_header()->high_timestamp, max_age);
+    return 0;
+  }
+
+  LogBufferHeader *header = LogColumnBlock::decode(block);
+  if (header == nullptr) {
+    Debug("logstats", "Failed to decode columnar block.");
+    return 1;
+  }
+  int ret = parse_log_buff(header, agg, cl.summary != 0, cl.report_per_user != 0);
+  ats_free(header);
+  if (ret != 0) {
+    Debug("logstats", "Failed to parse log buffer.");
+  }
+  return ret;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Process a block of a columnar log, whose first bytes are in the buffer.
+int
+process_column_block(int in_fd, char *buffer, int buffer_size, unsigned first_read_size, unsigned max_age)
+{
+  LogColumnBlockHeader *block = (LogColumnBlockHeader *)buffer;
+
+  if (read_payload(in_fd, &buffer[first_read_size], sizeof(LogColumnBlockHeader) - first_read_size) != 0) {
+    return 1;
+  }
+  if (block->version != LOG_COLUMN_VERSION || block->byte_count <= sizeof(LogColumnBlockHeader) ||
+      block->byte_count > (unsigned)buffer_size) {
+    Debug("logstats", "Columnar block version %d, byte count [%d] is wrong.", block->version, block->byte_count);
+    return 1;
+  }
+  if (read_payload(in_fd, &buffer[sizeof(LogColumnBlockHeader)], block->byte_count - sizeof(LogColumnBlockHeader)) != 0) {
+    return 1;
+  }
+
+  return parse_column_block(block, results, max_age);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Process a file (FD) by reading it, for the files that can't be mapped.
+int
+read_file(int in_fd, off_t offset, unsigned max_age)
 {
   char buffer[MAX_LOGBUFFER_SIZE];
   int nread, buffer_bytes;
@@ -1783,7 +1975,7 @@ process_file(int in_fd, off_t offset, unsigned max_age)
           return 0;
         }
         // ensure that this is a valid logbuffer header
-        if (header->cookie && (LOG_SEGMENT_COOKIE == header->cookie)) {
+        if (header->cookie && (LOG_SEGMENT_COOKIE == header->cookie || LOG_COLUMN_COOKIE == header->cookie)) {
           offset = 0;
           break;
         }
@@ -1799,12 +1991,19 @@ process_file(int in_fd, off_t offset, unsigned max_age)
       }
 
       // ensure that this is a valid logbuffer header
-      if (header->cookie != LOG_SEGMENT_COOKIE) {
+      if (header->cookie != LOG_SEGMENT_COOKIE && header->cookie != LOG_COLUMN_COOKIE) {
         Debug("logstats", "Invalid segment cookie (expected %d, got %d)", LOG_SEGMENT_COOKIE, header->cookie);
         return 1;
       }
     }
 
+    if (header->cookie == LOG_COLUMN_COOKIE) {
+      if (process_column_block(in_fd, buffer, sizeof(buffer), first_read_size, max_age) != 0) {
+        return 1;
+      }
+      continue;
+    }
+
     Debug("logstats", "LogBuffer version %d, current = %d", header->version, LOG_SEGMENT_VERSION);
     if (header->version != LOG_SEGMENT_VERSION) {
       return 1;
@@ -1831,36 +2030,13 @@ process_file(int in_fd, off_t offset, unsigned max_age)
       return 1;
     }
 
-    const int MAX_READ_TRIES = 5;
-    int total_read           = 0;
-    int read_tries_remaining = MAX_READ_TRIES; // since the data will be old anyway, let's only try a few times.
-    do {
-      nread = read(in_fd, &buffer[sizeof(LogBufferHeader) + total_read], buffer_bytes - total_read);
-      if (EOF == nread || !nread) { // just bail on error
-        Debug("logstats", "Read failed while reading log buffer, wanted %d bytes, nread=%d, errno=%d", buffer_bytes - total_read,
-              nread, errno);
-        return 1;
-      } else {
-        total_read += nread;
-      }
-
-      if (total_read < buffer_bytes) {
-        if (--read_tries_remaining <= 0) {
-          Debug("logstats_failed_retries", "Unable to read after %d tries, total_read=%d, buffer_bytes=%d", MAX_READ_TRIES,
-                total_read, buffer_bytes);
-          return 1;
-        }
-        // let's wait until we get more data on this file descriptor
-        Debug("logstats_partial_read",
-              "Failed to read buffer payload [%d bytes], total_read=%d, buffer_bytes=%d, tries_remaining=%d",
-              buffer_bytes - total_read, total_read, buffer_bytes, read_tries_remaining);
-        usleep(50 * 1000); // wait 50ms
-      }
-    } while (total_read < buffer_bytes);
+    if (read_payload(in_fd, &buffer[sizeof(LogBufferHeader)], buffer_bytes) != 0) {
+      return 1;
+    }
 
     // Possibly skip too old entries (the entire buffer is skipped)
     if (header->high_timestamp >= max_age) {
-      if (parse_log_buff(header, cl.summary != 0, cl.report_per_user != 0) != 0) {
+      if (parse_log_buff(header, results, cl.summary != 0, cl.report_per_user != 0) != 0) {
         Debug("logstats", "Failed to parse log buffer.");
         return 1;
       }
@@ -1872,6 +2048,171 @@ process_file(int in_fd, off_t offset, unsigned max_age)
   return 0;
 }
 
+///////////////////////////////////////////////////////////////////////////////
+// Parse a whole buffer or block of the log.
+int
+parse_segment(char *segment, Aggregate &agg, unsigned max_age)
+{
+  LogBufferHeader *header = (LogBufferHeader *)segment;
+
+  if (header->cookie == LOG_COLUMN_COOKIE) {
+    return parse_column_block((LogColumnBlockHeader *)segment, agg, max_age);
+  }
+  // Possibly skip too old entries (the entire buffer is skipped)
+  if (header->high_timestamp < max_age) {
+    Debug("logstats", "Skipping old buffer (age=%d, max=%d)", header->high_timestamp, max_age);
+    return 0;
+  }
+  if (parse_log_buff(header, agg, cl.summary != 0, cl.report_per_user != 0) != 0) {
+    Debug("logstats", "Failed to parse log buffer.");
+    return 1;
+  }
+  return 0;
+}
+
+// Find the buffers and blocks of the mapped log, from @a start to @a end, with @a start positioned on one
+// unless @a align. An incomplete segment at the end is left out, and @a start is set to it.
+int
+find_segments(char *&start, char *end, bool align, std::vector<char *> &segments)
+{
+  char *p = start;
+
+  if (align) {
+    Debug("logstats", "Re-aligning file read.");
+    for (; p + sizeof(uint32_t) <= end; ++p) {
+      uint32_t cookie;
+
+      memcpy(&cookie, p, sizeof(cookie));
+      if (LOG_SEGMENT_COOKIE == cookie || LOG_COLUMN_COOKIE == cookie) {
+        break;
+      }
+    }
+  }
+
+  for (uint32_t byte_count; p + sizeof(LogBufferHeader) <= end; p += byte_count) {
+    LogBufferHeader *header = (LogBufferHeader *)p;
+
+    if (!header->cookie) {
+      break;
+    }
+    if (header->cookie == LOG_COLUMN_COOKIE) {
+      LogColumnBlockHeader *block = (LogColumnBlockHeader *)p;
+
+      if (block->version != LOG_COLUMN_VERSION || block->byte_count <= sizeof(LogColumnBlockHeader)) {
+        Debug("logstats", "Columnar block version %d, byte count [%d] is wrong.", block->version, block->byte_count);
+        return 1;
+      }
+      byte_count = block->byte_count;
+    } else if (header->cookie == LOG_SEGMENT_COOKIE) {
+      if (header->version != LOG_SEGMENT_VERSION || header->byte_count <= sizeof(LogBufferHeader)) {
+        Debug("logstats", "LogBuffer version %d (current = %d), byte count [%d] is wrong.", header->version, LOG_SEGMENT_VERSION,
+              header->byte_count);
+        return 1;
+      }
+      byte_count = header->byte_count;
+    } else {
+      Debug("logstats", "Invalid segment cookie (expected %d, got %d)", LOG_SEGMENT_COOKIE, header->cookie);
+      return 1;
+    }
+
+    if (byte_count > (unsigned)MAX_LOGBUFFER_SIZE) {
+      Debug("logstats", "Segment byte count [%d] > expected [%d]", byte_count, MAX_LOGBUFFER_SIZE);
+      return 1;
+    }
+    if (byte_count > static_cast<size_t>(end - p)) {
+      Debug("logstats", "Leaving the incomplete segment at the end for the next run.");
+      break;
+    }
+    segments.push_back(p);
+  }
+
+  start = p;
+  return 0;
+}
+
+// Parse the segments with cl.threads threads, each collecting its stats on its own, merged at the end.
+int
+parse_segments(const std::vector<char *> &segments, unsigned max_age)
+{
+  std::atomic<size_t> next{0};
+  std::atomic<bool> failed{false};
+  size_t threads = cl.threads > 0 ? cl.threads : std::max(1u, std::thread::hardware_concurrency());
+
+  // The URL LRU is kept in the order of the log.
+  if (urls) {
+    threads = 1;
+  }
+  threads = std::min(threads, segments.size());
+
+  auto parse = [&](Aggregate &agg) {
+    for (size_t i; !failed && (i = next++) < segments.size();) {
+      if (parse_segment(segments[i], agg, max_age) != 0) {
+        failed = true;
+      }
+    }
+  };
+
+  std::vector<Aggregate> aggs(threads > 1 ? threads - 1 : 0);
+  std::vector<std::thread> workers;
+
+  Debug("logstats", "Parsing %zu segments with %zu threads.", segments.size(), std::max<size_t>(threads, 1));
+  for (auto &agg : aggs) {
+    workers.emplace_back(parse, std::ref(agg));
+  }
+  parse(results);
+  for (size_t i = 0; i < workers.size(); ++i) {
+    workers[i].join();
+    merge_aggregate(results, aggs[i]);
+  }
+
+  return failed ? 1 : 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Process a file (FD), from @a offset or from its current position, through a mapping of it. The position
+// is left after the last complete segment, where an incremental run takes over.
+int
+process_file(int in_fd, off_t offset, unsigned max_age)
+{
+  struct stat st;
+  off_t start = offset > 0 ? offset : lseek(in_fd, 0, SEEK_CUR);
+
+  if (start < 0 || fstat(in_fd, &st) < 0 || !S_ISREG(st.st_mode)) {
+    return read_file(in_fd, offset, max_age);
+  }
+  Debug("logstats", "Processing file [offset=%" PRId64 "].", (int64_t)start);
+  if (start >= st.st_size) {
+    return 0;
+  }
+
+  off_t map_start = start - start % getpagesize();
+  size_t map_len  = st.st_size - map_start;
+  // Private and writable, the parsing terminates the strings in place.
+  char *map = static_cast<char *>(mmap(nullptr, map_len, PROT_READ | PROT_WRITE, MAP_PRIVATE, in_fd, map_start));
+
+  if (MAP_FAILED == map) {
+    Debug("logstats", "Failed to map the file, errno=%d, reading it.", errno);
+    return read_file(in_fd, offset, max_age);
+  }
+#if HAVE_POSIX_MADVISE
+  posix_madvise(map, map_len, POSIX_MADV_SEQUENTIAL);
+#endif
+
+  std::vector<char *> segments;
+  char *p = map + (start - map_start);
+  int ret = find_segments(p, map + map_len, offset > 0, segments);
+
+  if (0 == ret) {
+    ret = parse_segments(segments, max_age);
+  }
+  if (lseek(in_fd, map_start + (p - map), SEEK_SET) < 0) {
+    ret = 1;
+  }
+  munmap(map, map_len);
+
+  return ret;
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 // Determine if this "stat" (Origin Server) is worthwhile to produce a
 // report for.
@@ -2304,9 +2645,9 @@ my_exit(const ExitStatus &status)
     }
   }
 
-  if (!origins.empty()) {
+  if (!results.origins.empty()) {
     // Sort the Origins by 'traffic'
-    for (OriginStorage::iterator i = origins.begin(); i != origins.end(); i++) {
+    for (OriginStorage::iterator i = results.origins.begin(); i != results.origins.end(); i++) {
       if (use_origin(i->second)) {
         vec.push_back(*i);
       }
@@ -2343,11 +2684,11 @@ my_exit(const ExitStatus &status)
     first = false;
     if (cl.json) {
       std::cout << "{ \"total\": {" << std::endl;
-      print_detail_stats(&totals, cl.json, cl.concise);
+      print_detail_stats(&results.totals, cl.json, cl.concise);
       std::cout << "  }";
     } else {
       format_center("Totals (all Origins combined)");
-      print_detail_stats(&totals, cl.json, cl.concise);
+      print_detail_stats(&results.totals, cl.json, cl.concise);
       std::cout << std::endl << std::endl << std::endl;
     }
   }
@@ -2431,11 +2772,7 @@ main(int /* argc ATS_UNUSED */, const char *argv[])
   // Before accessing file system initialize Layout engine
   Layout::create();
 
-  memset(&totals, 0, sizeof(totals));
-  init_elapsed(&totals);
-
-  origin_set   = new OriginSet;
-  parse_errors = 0;
+  origin_set = new OriginSet;
 
   // Command line parsing
   cl.parse_arguments(argv);
@@ -78,6 +78,7 @@ initializeRegistry()
   registerFile("proxy.config.cache.control.filename", "cache.config");
   registerFile("proxy.config.cache.ip_allow.filename", "ip_allow.config");
   registerFile("proxy.config.http.parent_proxy.file", "parent.config");
+  registerFile("proxy.config.http.cache.invalidate.filename", "invalidate.config");
   registerFile("proxy.config.url_remap.filename", "remap.config");
   registerFile("", "volume.config");
   registerFile("proxy.config.cache.hosting_filename", "hosting.config");
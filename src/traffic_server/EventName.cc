@@ -131,6 +131,10 @@ event_int_to_string(int event, int blen, char *buffer)
     return "MGMT_EVENT_HOST_STATUS_UP";
   case MGMT_EVENT_HOST_STATUS_DOWN:
     return "MGMT_EVENT_HOST_STATUS_DOWN";
+  case MGMT_EVENT_DISPATCH_TRACE:
+    return "MGMT_EVENT_DISPATCH_TRACE";
+  case MGMT_EVENT_CPU_PROFILE:
+    return "MGMT_EVENT_CPU_PROFILE";
 
   default:
     if (buffer != nullptr) {
@@ -0,0 +1,529 @@
+/** @file
+
+  In-process benchmark of the HTTP state machine.
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ */
+
+/* The clients are PluginVCs from TSHttpConnect() and the origin is a server intercept answering
+   from memory, so a transaction goes through all of HttpSM and HttpTransact, and the cache if the
+   response is cacheable, without a socket. The first pass counts the freelist allocations, with the
+   per thread freelists disabled so that each one is seen, the second pass measures the requests
+   per second of CPU time used by the whole process, which is the rate one core would sustain.
+
+   The benchmark only runs at the extended regression level:
+
+     TS_BENCH_REQUESTS=100000 TS_BENCH_MIX=small:8,post:1,hit:1 traffic_server -R 3 -r HttpSM_Bench
+
+   TS_BENCH_REQUESTS is the number of requests of each pass, TS_BENCH_CONCURRENCY the number of
+   requests in flight, TS_BENCH_MIX the weight of each kind of request in the mix. The results are
+   printed as RPERF lines, suitable to compare from release to release.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <sys/resource.h>
+
+#include "tscore/ink_config.h"
+#include "tscore/ink_args.h"
+#include "tscore/ink_hrtime.h"
+#include "tscore/ink_inet.h"
+#include "tscore/ink_queue.h"
+#include "tscore/Regression.h"
+#include "ts/ts.h"
+
+namespace
+{
+constexpr char const DEBUG_TAG[]  = "http_bench";
+constexpr char const KIND_FIELD[] = "X-Bench";
+
+/// A kind of request of the mix.
+struct Kind {
+  const char *name;
+  const char *method;
+  int64_t request_body;  ///< Bytes of the request body.
+  int64_t response_body; ///< Bytes of the response body.
+  bool cacheable;        ///< All the requests are for the same URL, which is served from the cache once stored.
+};
+
+const Kind kinds[] = {
+  {"small", "GET", 0, 1024, false},
+  {"large", "GET", 0, 256 * 1024, false},
+  {"post", "POST", 16 * 1024, 1024, false},
+  {"hit", "GET", 0, 8 * 1024, true},
+};
+
+int64_t
+env_int(const char *name, int64_t dflt)
+{
+  const char *value = getenv(name);
+  return value && *value ? std::max<int64_t>(strtoll(value, nullptr, 10), 1) : dflt;
+}
+
+double
+cpu_seconds()
+{
+  rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec + (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1000000.0;
+}
+
+class Bench;
+Bench *bench = nullptr;
+
+/// One request in flight at a time, through a PluginVC.
+struct Client {
+  TSCont cont;
+  TSVConn vc             = nullptr;
+  TSVIO read_vio         = nullptr;
+  TSIOBuffer req_buf     = nullptr;
+  TSIOBufferReader req   = nullptr;
+  TSIOBuffer resp_buf    = nullptr;
+  TSIOBufferReader resp  = nullptr;
+  const Kind *kind       = nullptr;
+  int64_t received       = 0;
+  char status_line[16]   = "";
+  size_t status_line_len = 0;
+
+  Client();
+  void start(int64_t n);
+  void finish(bool ok);
+  static int handler(TSCont contp, TSEvent event, void *edata);
+};
+
+/// The origin side of one transaction, from the server intercept.
+struct OriginConn {
+  TSCont cont;
+  TSVConn vc;
+  TSIOBuffer in_buf;
+  TSIOBufferReader in;
+  TSIOBuffer out_buf = nullptr;
+  std::string request;
+  size_t expected = 0; ///< Bytes of the request, once the header is in.
+
+  explicit OriginConn(TSVConn vc);
+  void respond();
+  void close();
+  static int handler(TSCont contp, TSEvent event, void *edata);
+};
+
+class Bench
+{
+public:
+  Bench(RegressionTest *t, int *pstatus);
+
+  bool parse_mix(const char *mix);
+  void start_pass();
+  /// Take the next request of the pass, @c false once all are issued.
+  bool next(int64_t &n, const Kind *&kind);
+  /// A client is done with the pass.
+  void idle();
+
+  RegressionTest *test;
+  int *pstatus;
+  int64_t requests;
+  int concurrency;
+  std::vector<const Kind *> mix; ///< A kind per unit of weight, the requests go round it.
+  std::vector<std::string> responses;
+  std::vector<Client *> clients;
+  TSCont hook;
+  TSCont origin;
+
+  std::atomic<int64_t> issued{0};
+  std::atomic<int> idle_clients{0};
+  std::atomic<int64_t> failures{0};
+  int pass = 0;
+  ink_hrtime wall_start;
+  double cpu_start;
+
+private:
+  void end_pass();
+};
+
+Client::Client()
+{
+  cont = TSContCreate(&Client::handler, TSMutexCreate());
+  TSContDataSet(cont, this);
+  req_buf  = TSIOBufferCreate();
+  req      = TSIOBufferReaderAlloc(req_buf);
+  resp_buf = TSIOBufferCreate();
+  resp     = TSIOBufferReaderAlloc(resp_buf);
+}
+
+void
+Client::start(int64_t n)
+{
+  std::string text;
+
+  text.append(kind->method).append(" http://bench.invalid/").append(kind->name);
+  if (!kind->cacheable) {
+    text.append("/").append(std::to_string(n));
+  }
+  text.append(" HTTP/1.1\r\nHost: bench.invalid\r\n").append(KIND_FIELD).append(": ").append(kind->name).append("\r\n");
+  if (kind->request_body) {
+    text.append("Content-Length: ").append(std::to_string(kind->request_body)).append("\r\n");
+  }
+  text.append("Connection: close\r\n\r\n").append(kind->request_body, 'x');
+
+  TSIOBufferReaderConsume(req, TSIOBufferReaderAvail(req));
+  TSIOBufferReaderConsume(resp, TSIOBufferReaderAvail(resp));
+  TSIOBufferWrite(req_buf, text.data(), text.size());
+  received        = 0;
+  status_line_len = 0;
+
+  sockaddr_in addr;
+  ats_ip4_set(&addr, htonl(INADDR_LOOPBACK), htons(1));
+  vc = TSHttpConnect(ats_ip_sa_cast(&addr));
+  TSVConnWrite(vc, cont, req, text.size());
+  read_vio = TSVConnRead(vc, cont, resp_buf, INT64_MAX);
+}
+
+void
+Client::finish(bool ok)
+{
+  static const char expected[] = "HTTP/1.1 200";
+
+  TSVConnClose(vc);
+  vc       = nullptr;
+  read_vio = nullptr;
+
+  if (!ok || status_line_len < sizeof(expected) - 1 || memcmp(status_line, expected, sizeof(expected) - 1) != 0 ||
+      received < kind->response_body) {
+    if (bench->failures.fetch_add(1) == 0) {
+      rprintf(bench->test, "a %s request got %" PRId64 " bytes, '%.*s'\n", kind->name, received, static_cast<int>(status_line_len),
+              status_line);
+    }
+  }
+
+  int64_t n;
+  if (bench->next(n, kind)) {
+    start(n);
+  } else {
+    bench->idle();
+  }
+}
+
+int
+Client::handler(TSCont contp, TSEvent event, void *edata)
+{
+  Client *c = static_cast<Client *>(TSContDataGet(contp));
+
+  switch (event) {
+  case TS_EVENT_IMMEDIATE:
+  case TS_EVENT_TIMEOUT: {
+    int64_t n;
+    if (bench->next(n, c->kind)) {
+      c->start(n);
+    } else {
+      bench->idle();
+    }
+    break;
+  }
+
+  case TS_EVENT_VCONN_WRITE_READY:
+  case TS_EVENT_VCONN_WRITE_COMPLETE:
+    break;
+
+  case TS_EVENT_VCONN_READ_READY:
+  case TS_EVENT_VCONN_READ_COMPLETE:
+  case TS_EVENT_VCONN_EOS: {
+    int64_t avail = TSIOBufferReaderAvail(c->resp);
+    if (c->status_line_len < sizeof(c->status_line) - 1) {
+      c->status_line_len += TSIOBufferReaderCopy(c->resp, c->status_line + c->status_line_len,
+                                                 std::min<int64_t>(avail, sizeof(c->status_line) - 1 - c->status_line_len));
+    }
+    TSIOBufferReaderConsume(c->resp, avail);
+    c->received += avail;
+    if (event == TS_EVENT_VCONN_READ_READY) {
+      TSVIOReenable(c->read_vio);
+    } else {
+      c->finish(true);
+    }
+    break;
+  }
+
+  default:
+    TSDebug(DEBUG_TAG, "client got event %d on %p", event, edata);
+    c->finish(false);
+    break;
+  }
+  return 0;
+}
+
+OriginConn::OriginConn(TSVConn v) : vc(v)
+{
+  cont = TSContCreate(&OriginConn::handler, TSMutexCreate());
+  TSContDataSet(cont, this);
+  in_buf = TSIOBufferCreate();
+  in     = TSIOBufferReaderAlloc(in_buf);
+  TSVConnRead(vc, cont, in_buf, INT64_MAX);
+}
+
+void
+OriginConn::respond()
+{
+  std::string_view field(KIND_FIELD);
+  size_t spot             = request.find(field);
+  std::string const *text = &bench->responses[0];
+
+  if (spot != std::string::npos) {
+    std::string_view name(request.data() + spot + field.size() + 2, request.size() - spot - field.size() - 2);
+    for (size_t i = 0; i < countof(kinds); ++i) {
+      if (name.substr(0, strlen(kinds[i].name)) == kinds[i].name) {
+        text = &bench->responses[i];
+      }
+    }
+  }
+
+  out_buf              = TSIOBufferCreate();
+  TSIOBufferReader out = TSIOBufferReaderAlloc(out_buf);
+  TSIOBufferWrite(out_buf, text->data(), text->size());
+  TSVConnWrite(vc, cont, out, text->size());
+}
+
+void
+OriginConn::close()
+{
+  TSVConnClose(vc);
+  TSIOBufferDestroy(in_buf);
+  if (out_buf) {
+    TSIOBufferDestroy(out_buf);
+  }
+  TSContDestroy(cont);
+  delete this;
+}
+
+int
+OriginConn::handler(TSCont contp, TSEvent event, void *edata)
+{
+  OriginConn *o = static_cast<OriginConn *>(TSContDataGet(contp));
+
+  switch (event) {
+  case TS_EVENT_VCONN_READ_READY:
+  case TS_EVENT_VCONN_READ_COMPLETE: {
+    if (o->out_buf) {
+      // The whole request is in, anything more is not ours to answer.
+      TSIOBufferReaderConsume(o->in, TSIOBufferReaderAvail(o->in));
+      break;
+    }
+    int64_t avail = TSIOBufferReaderAvail(o->in);
+    size_t have   = o->request.size();
+    o->request.resize(have + avail);
+    TSIOBufferReaderCopy(o->in, &o->request[have], avail);
+    TSIOBufferReaderConsume(o->in, avail);
+    if (o->expected == 0) {
+      size_t end = o->request.find("\r\n\r\n");
+      if (end != std::string::npos) {
+        o->expected = end + 4;
+        size_t cl   = o->request.find("Content-Length: ");
+        if (cl != std::string::npos && cl < end) {
+          o->expected += strtoll(o->request.c_str() + cl + 16, nullptr, 10);
+        }
+      }
+    }
+    if (o->expected != 0 && o->request.size() >= o->expected) {
+      o->respond();
+    } else {
+      TSVIOReenable(static_cast<TSVIO>(edata));
+    }
+    break;
+  }
+
+  case TS_EVENT_VCONN_WRITE_READY:
+    TSVIOReenable(static_cast<TSVIO>(edata));
+    break;
+
+  default:
+    // The response is out, or the state machine is gone.
+    o->close();
+    break;
+  }
+  return 0;
+}
+
+int
+origin_accept(TSCont, TSEvent event, void *edata)
+{
+  if (event == TS_EVENT_NET_ACCEPT) {
+    new OriginConn(static_cast<TSVConn>(edata));
+  }
+  return 0;
+}
+
+int
+read_request_hook(TSCont, TSEvent, void *edata)
+{
+  TSHttpTxn txnp = static_cast<TSHttpTxn>(edata);
+  TSMBuffer bufp;
+  TSMLoc hdr;
+
+  if (TSHttpTxnClientReqGet(txnp, &bufp, &hdr) == TS_SUCCESS) {
+    TSMLoc field = TSMimeHdrFieldFind(bufp, hdr, KIND_FIELD, sizeof(KIND_FIELD) - 1);
+    if (field != TS_NULL_MLOC) {
+      TSHttpTxnServerIntercept(bench->origin, txnp);
+      TSHandleMLocRelease(bufp, hdr, field);
+    }
+    TSHandleMLocRelease(bufp, TS_NULL_MLOC, hdr);
+  }
+  TSHttpTxnReenable(txnp, TS_EVENT_HTTP_CONTINUE);
+  return 0;
+}
+
+Bench::Bench(RegressionTest *t, int *status) : test(t), pstatus(status)
+{
+  requests    = env_int("TS_BENCH_REQUESTS", 20000);
+  concurrency = env_int("TS_BENCH_CONCURRENCY", 64);
+
+  for (auto const &kind : kinds) {
+    std::string text = "HTTP/1.1 200 OK\r\nContent-Length: " + std::to_string(kind.response_body) + "\r\n";
+    text.append(kind.cacheable ? "Cache-Control: max-age=3600\r\n" : "Cache-Control: no-store\r\n");
+    text.append("Connection: close\r\n\r\n").append(kind.response_body, 'x');
+    responses.push_back(std::move(text));
+  }
+
+  hook   = TSContCreate(&read_request_hook, nullptr);
+  origin = TSContCreate(&origin_accept, TSMutexCreate());
+  TSHttpHookAdd(TS_HTTP_READ_REQUEST_HDR_HOOK, hook);
+  for (int i = 0; i < concurrency; ++i) {
+    clients.push_back(new Client);
+  }
+}
+
+bool
+Bench::parse_mix(const char *text)
+{
+  std::string_view src(text);
+
+  while (!src.empty()) {
+    std::string_view item = src.substr(0, src.find(','));
+    src.remove_prefix(std::min(item.size() + 1, src.size()));
+    std::string_view name = item.substr(0, item.find(':'));
+    int weight            = name.size() < item.size() ? atoi(std::string(item.substr(name.size() + 1)).c_str()) : 1;
+    auto kind             = std::find_if(std::begin(kinds), std::end(kinds), [name](Kind const &k) { return name == k.name; });
+    if (kind == std::end(kinds) || weight <= 0) {
+      rprintf(test, "'%.*s' is not a valid item of the mix, the kinds are small, large, post and hit\n",
+              static_cast<int>(item.size()), item.data());
+      return false;
+    }
+    mix.insert(mix.end(), weight, kind);
+  }
+  return !mix.empty();
+}
+
+void
+Bench::start_pass()
+{
+  issued       = 0;
+  idle_clients = 0;
+  if (pass == 0) {
+    cmd_disable_pfreelist = 1;
+    ink_freelists_count_allocs(true);
+  }
+  wall_start = ink_get_hrtime_internal();
+  cpu_start  = cpu_seconds();
+  for (Client *c : clients) {
+    TSContScheduleOnPool(c->cont, 0, TS_THREAD_POOL_NET);
+  }
+}
+
+bool
+Bench::next(int64_t &n, const Kind *&kind)
+{
+  n = issued.fetch_add(1);
+  if (n >= requests) {
+    return false;
+  }
+  kind = mix[n % mix.size()];
+  return true;
+}
+
+void
+Bench::idle()
+{
+  if (idle_clients.fetch_add(1) + 1 == concurrency) {
+    end_pass();
+  }
+}
+
+void
+Bench::end_pass()
+{
+  double wall = ink_hrtime_to_msec(ink_get_hrtime_internal() - wall_start) / 1000.0;
+  double cpu  = cpu_seconds() - cpu_start;
+
+  if (pass == 0) {
+    struct Count {
+      const char *name;
+      uint64_t allocs;
+    };
+    std::vector<Count> counts;
+    uint64_t total = 0;
+
+    ink_freelists_count_allocs(false);
+    cmd_disable_pfreelist = 0;
+    ink_freelists_get_allocs(
+      [](const char *name, uint64_t allocs, void *data) { static_cast<std::vector<Count> *>(data)->push_back({name, allocs}); },
+      &counts);
+    std::sort(counts.begin(), counts.end(), [](Count const &lhs, Count const &rhs) { return lhs.allocs > rhs.allocs; });
+    for (auto const &c : counts) {
+      total += c.allocs;
+    }
+    rprintf(test, "%" PRId64 " requests, %.0f freelist allocations per request\n", requests, static_cast<double>(total) / requests);
+    for (size_t i = 0; i < std::min<size_t>(counts.size(), 10); ++i) {
+      rprintf(test, "  %10.2f %s\n", static_cast<double>(counts[i].allocs) / requests, counts[i].name);
+    }
+    rperf(test, "allocs_per_request", static_cast<double>(total) / requests);
+
+    ++pass;
+    start_pass();
+    return;
+  }
+
+  rprintf(test, "%" PRId64 " requests in %.3f s, %.3f s of CPU time\n", requests, wall, cpu);
+  rperf(test, "requests_per_second", wall > 0 ? requests / wall : 0);
+  rperf(test, "requests_per_cpu_second", cpu > 0 ? requests / cpu : 0);
+  rperf(test, "cpu_us_per_request", cpu * 1000000.0 / requests);
+  if (failures > 0) {
+    rprintf(test, "%" PRId64 " requests failed\n", failures.load());
+  }
+  *pstatus = failures > 0 ? REGRESSION_TEST_FAILED : REGRESSION_TEST_PASSED;
+}
+} // namespace
+
+EXCLUSIVE_REGRESSION_TEST(HttpSM_Bench)(RegressionTest *t, int level, int *pstatus)
+{
+  if (level < REGRESSION_TEST_EXTENDED) {
+    *pstatus = REGRESSION_TEST_NOT_RUN;
+    return;
+  }
+
+  *pstatus = REGRESSION_TEST_INPROGRESS;
+  bench    = new Bench(t, pstatus);
+  if (!bench->parse_mix(getenv("TS_BENCH_MIX") ? getenv("TS_BENCH_MIX") : "small")) {
+    *pstatus = REGRESSION_TEST_FAILED;
+    return;
+  }
+  rprintf(t, "%" PRId64 " requests per pass, %d in flight\n", bench->requests, bench->concurrency);
+  bench->start_pass();
+}
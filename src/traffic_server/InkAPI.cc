@@ -24,6 +24,7 @@
 #include <cstdio>
 #include <atomic>
 #include <string_view>
+#include <mutex>
 #include <tuple>
 #include <unordered_map>
 #include <string_view>
@@ -32,6 +33,7 @@
 #include "tscore/ink_base64.h"
 #include "tscore/I_Layout.h"
 #include "tscore/I_Version.h"
+#include "tscore/KeyValueStore.h"
 
 #include "InkAPIInternal.h"
 #include "Log.h"
@@ -1101,8 +1103,12 @@ INKContInternal::handle_event(int event, void *edata)
     /* set the plugin context */
     auto *previousContext = pluginThreadContext;
     pluginThreadContext   = reinterpret_cast<PluginThreadContext *>(m_context);
-    int retval            = m_event_func((TSCont)this, (TSEvent)event, edata);
-    pluginThreadContext   = previousContext;
+    int retval;
+    {
+      AtsMemTagScope mem_tag(ATS_MEM_TAG_PLUGIN);
+      retval = m_event_func((TSCont)this, (TSEvent)event, edata);
+    }
+    pluginThreadContext = previousContext;
     if (edata && event == EVENT_INTERVAL) {
       Event *e = reinterpret_cast<Event *>(edata);
       if (e->period != 0) {
@@ -1327,6 +1333,9 @@ APIHook::invoke(int event, void *edata)
     // If we cannot get the lock, the caller needs to restructure to handle rescheduling
     ink_release_assert(0);
   }
+  if (unlikely(PluginHookStats::sampled())) {
+    return PluginHookStats::invoke(m_cont, event, edata);
+  }
   return m_cont->handleEvent(event, edata);
 }
 
@@ -2460,6 +2469,39 @@ TSUrlPercentEncode(TSMBuffer bufp, TSMLoc obj, char *dst, size_t dst_size, size_
   return ret;
 }
 
+TSReturnCode
+TSUrlPercentDecode(TSMBuffer bufp, TSMLoc obj, char *dst, size_t dst_size, size_t *length)
+{
+  sdk_assert(sdk_sanity_check_mbuffer(bufp) == TS_SUCCESS);
+  sdk_assert(sdk_sanity_check_url_handle(obj) == TS_SUCCESS);
+  sdk_assert(sdk_sanity_check_null_ptr((void *)dst) == TS_SUCCESS);
+  sdk_assert(dst_size > 0);
+
+  int url_len;
+  URLImpl *url_impl = (URLImpl *)obj;
+  char *url         = url_string_get(url_impl, nullptr, &url_len, nullptr);
+
+  char *buffer    = dst;
+  const char *src = url;
+  int s           = 0;
+
+  // Leave room for the terminating NUL.
+  unescape_str(buffer, dst + dst_size - 1, src, url + url_len, s);
+  // Copy an escape that the end of the URL cut short as is.
+  for (const char *p = src - (s == 3 ? 1 : s); p < src && buffer < dst + dst_size - 1; ++p) {
+    *buffer++ = *p;
+  }
+  *buffer = '\0';
+  ats_free(url);
+
+  if (length) {
+    *length = buffer - dst;
+  }
+
+  // The decoded URL did not fit.
+  return src < url + url_len ? TS_ERROR : TS_SUCCESS;
+}
+
 // pton
 TSReturnCode
 TSIpStringToAddr(const char *str, size_t str_len, sockaddr *addr)
@@ -2799,7 +2841,7 @@ TSMimeHdrFieldFind(TSMBuffer bufp, TSMLoc hdr_obj, const char *name, int length)
   }
 
   MIMEHdrImpl *mh = _hdr_mloc_to_mime_hdr_impl(hdr_obj);
-  MIMEField *f    = mime_hdr_field_find(mh, name, length);
+  MIMEField *f    = mime_hdr_field_find(mh, name, length, ((HdrHeapSDKHandle *)bufp)->m_heap);
 
   if (f == nullptr) {
     return TS_NULL_MLOC;
@@ -2811,6 +2853,75 @@ TSMimeHdrFieldFind(TSMBuffer bufp, TSMLoc hdr_obj, const char *name, int length)
   return reinterpret_cast<TSMLoc>(h);
 }
 
+int
+TSMimeHdrFieldValuesGet(TSMBuffer bufp, TSMLoc hdr_obj, TSMimeHdrFieldValue *fields, int count)
+{
+  sdk_assert(sdk_sanity_check_mbuffer(bufp) == TS_SUCCESS);
+  sdk_assert((sdk_sanity_check_mime_hdr_handle(hdr_obj) == TS_SUCCESS) ||
+             (sdk_sanity_check_http_hdr_handle(hdr_obj) == TS_SUCCESS));
+  sdk_assert(count == 0 || sdk_sanity_check_null_ptr((void *)fields) == TS_SUCCESS);
+
+  HdrHeap *heap   = ((HdrHeapSDKHandle *)bufp)->m_heap;
+  MIMEHdrImpl *mh = _hdr_mloc_to_mime_hdr_impl(hdr_obj);
+  int found       = 0;
+
+  for (int i = 0; i < count; ++i) {
+    TSMimeHdrFieldValue &fv = fields[i];
+    sdk_assert(sdk_sanity_check_null_ptr((void *)fv.name) == TS_SUCCESS);
+
+    if (fv.name_len == -1) {
+      fv.name_len = strlen(fv.name);
+    }
+
+    MIMEField *f = mime_hdr_field_find(mh, fv.name, fv.name_len, heap);
+    if (f == nullptr) {
+      fv.value     = nullptr;
+      fv.value_len = 0;
+    } else {
+      fv.value = f->value_get(&fv.value_len);
+      ++found;
+    }
+  }
+
+  return found;
+}
+
+TSReturnCode
+TSMimeHdrFieldValuesSet(TSMBuffer bufp, TSMLoc hdr_obj, const TSMimeHdrFieldValue *fields, int count)
+{
+  sdk_assert(sdk_sanity_check_mbuffer(bufp) == TS_SUCCESS);
+  sdk_assert((sdk_sanity_check_mime_hdr_handle(hdr_obj) == TS_SUCCESS) ||
+             (sdk_sanity_check_http_hdr_handle(hdr_obj) == TS_SUCCESS));
+  sdk_assert(count == 0 || sdk_sanity_check_null_ptr((void *)fields) == TS_SUCCESS);
+
+  if (!isWriteable(bufp)) {
+    return TS_ERROR;
+  }
+
+  HdrHeap *heap   = ((HdrHeapSDKHandle *)bufp)->m_heap;
+  MIMEHdrImpl *mh = _hdr_mloc_to_mime_hdr_impl(hdr_obj);
+
+  for (int i = 0; i < count; ++i) {
+    const TSMimeHdrFieldValue &fv = fields[i];
+    sdk_assert(sdk_sanity_check_null_ptr((void *)fv.name) == TS_SUCCESS);
+
+    int name_len = fv.name_len == -1 ? strlen(fv.name) : fv.name_len;
+
+    if (fv.value == nullptr) {
+      MIMEField *f = mime_hdr_field_find(mh, fv.name, name_len, heap);
+      if (f != nullptr) {
+        mime_hdr_field_delete(heap, mh, f, true);
+      }
+    } else {
+      int value_len = fv.value_len == -1 ? strlen(fv.value) : fv.value_len;
+      MIMEField *f  = mime_hdr_prepare_for_value_set(heap, mh, fv.name, name_len);
+      mime_field_value_set(heap, mh, f, fv.value, value_len, true);
+    }
+  }
+
+  return TS_SUCCESS;
+}
+
 TSReturnCode
 TSMimeHdrFieldAppend(TSMBuffer bufp, TSMLoc mh_mloc, TSMLoc field_mloc)
 {
@@ -4372,6 +4483,38 @@ TSMgmtSourceGet(const char *var_name, TSMgmtSource *source)
   return REC_ERR_OKAY == RecGetRecordSource(var_name, reinterpret_cast<RecSourceT *>(source)) ? TS_SUCCESS : TS_ERROR;
 }
 
+TSMgmtRecord
+TSMgmtRecordFind(const char *var_name)
+{
+  sdk_assert(sdk_sanity_check_null_ptr((void *)var_name) == TS_SUCCESS);
+
+  return reinterpret_cast<TSMgmtRecord>(RecFindRecord(var_name));
+}
+
+TSReturnCode
+TSMgmtRecordIntGet(TSMgmtRecord record, TSMgmtInt *result)
+{
+  sdk_assert(sdk_sanity_check_null_ptr((void *)record) == TS_SUCCESS);
+
+  return RecGetRecordInt(reinterpret_cast<RecRecord *>(record), (RecInt *)result) == REC_ERR_OKAY ? TS_SUCCESS : TS_ERROR;
+}
+
+TSReturnCode
+TSMgmtRecordCounterGet(TSMgmtRecord record, TSMgmtCounter *result)
+{
+  sdk_assert(sdk_sanity_check_null_ptr((void *)record) == TS_SUCCESS);
+
+  return RecGetRecordCounter(reinterpret_cast<RecRecord *>(record), (RecCounter *)result) == REC_ERR_OKAY ? TS_SUCCESS : TS_ERROR;
+}
+
+TSReturnCode
+TSMgmtRecordFloatGet(TSMgmtRecord record, TSMgmtFloat *result)
+{
+  sdk_assert(sdk_sanity_check_null_ptr((void *)record) == TS_SUCCESS);
+
+  return RecGetRecordFloat(reinterpret_cast<RecRecord *>(record), (RecFloat *)result) == REC_ERR_OKAY ? TS_SUCCESS : TS_ERROR;
+}
+
 ////////////////////////////////////////////////////////////////////
 //
 // Continuations
@@ -4432,6 +4575,27 @@ TSContDataGet(TSCont contp)
   return i->mdata;
 }
 
+// Schedule @a i on @a eth, through the local queue (no atomic, no signal) if the caller runs on @a eth.
+static Event *
+sdk_schedule_on_thread(INKContInternal *i, EThread *eth, TSHRTime timeout)
+{
+  if (eth == this_ethread()) {
+    return timeout == 0 ? eth->schedule_imm_local(i) : eth->schedule_in_local(i, HRTIME_MSECONDS(timeout));
+  }
+  return timeout == 0 ? eth->schedule_imm(i) : eth->schedule_in(i, HRTIME_MSECONDS(timeout));
+}
+
+// The thread affinity of @a i, if it has none it is set to the caller's event thread.
+static EThread *
+sdk_schedule_affinity(INKContInternal *i)
+{
+  EThread *eth = i->getThreadAffinity();
+  if (eth == nullptr && (eth = this_event_thread()) != nullptr) {
+    i->setThreadAffinity(eth);
+  }
+  return eth;
+}
+
 TSAction
 TSContSchedule(TSCont contp, TSHRTime timeout)
 {
@@ -4445,23 +4609,65 @@ TSContSchedule(TSCont contp, TSHRTime timeout)
     ink_assert(!"not reached");
   }
 
-  EThread *eth = i->getThreadAffinity();
+  EThread *eth = sdk_schedule_affinity(i);
   if (eth == nullptr) {
     return nullptr;
   }
 
-  TSAction action;
-  if (timeout == 0) {
-    action = reinterpret_cast<TSAction>(eth->schedule_imm(i));
-  } else {
-    action = reinterpret_cast<TSAction>(eth->schedule_in(i, HRTIME_MSECONDS(timeout)));
-  }
+  TSAction action = reinterpret_cast<TSAction>(sdk_schedule_on_thread(i, eth, timeout));
 
   /* This is a hack. Should be handled in ink_types */
   action = (TSAction)((uintptr_t)action | 0x1);
   return action;
 }
 
+int
+TSContScheduleBatch(TSCont *contps, int count, TSHRTime timeout, TSAction *actions)
+{
+  sdk_assert(count == 0 || sdk_sanity_check_null_ptr((void *)contps) == TS_SUCCESS);
+
+  int scheduled = 0;
+
+  for (int n = 0; n < count; ++n) {
+    sdk_assert(sdk_sanity_check_iocore_structure(contps[n]) == TS_SUCCESS);
+
+    FORCE_PLUGIN_SCOPED_MUTEX(contps[n]);
+
+    INKContInternal *i = reinterpret_cast<INKContInternal *>(contps[n]);
+    EThread *eth       = sdk_schedule_affinity(i);
+    TSAction action    = nullptr;
+
+    if (eth != nullptr) {
+      if (ink_atomic_increment(static_cast<int *>(&i->m_event_count), 1) < 0) {
+        ink_assert(!"not reached");
+      }
+      action = reinterpret_cast<TSAction>(sdk_schedule_on_thread(i, eth, timeout));
+      /* This is a hack. Should be handled in ink_types */
+      action = (TSAction)((uintptr_t)action | 0x1);
+      ++scheduled;
+    }
+    if (actions) {
+      actions[n] = action;
+    }
+  }
+
+  return scheduled;
+}
+
+TSReturnCode
+TSEventThreadCallbackPost(TSEventThreadCallbackFunc funcp, void *data)
+{
+  sdk_assert(sdk_sanity_check_null_ptr((void *)funcp) == TS_SUCCESS);
+
+  EThread *eth = this_event_thread();
+  if (eth == nullptr) {
+    return TS_ERROR;
+  }
+
+  eth->post_local(funcp, data);
+  return TS_SUCCESS;
+}
+
 TSAction
 TSContScheduleOnPool(TSCont contp, TSHRTime timeout, TSThreadPool tp)
 {
@@ -4533,12 +4739,7 @@ TSContScheduleOnThread(TSCont contp, TSHRTime timeout, TSEventThread ethread)
     i->setThreadAffinity(eth);
   }
 
-  TSAction action;
-  if (timeout == 0) {
-    action = reinterpret_cast<TSAction>(eth->schedule_imm(i));
-  } else {
-    action = reinterpret_cast<TSAction>(eth->schedule_in(i, HRTIME_MSECONDS(timeout)));
-  }
+  TSAction action = reinterpret_cast<TSAction>(sdk_schedule_on_thread(i, eth, timeout));
 
   /* This is a hack. Should be handled in ink_types */
   action = (TSAction)((uintptr_t)action | 0x1);
@@ -4558,7 +4759,7 @@ TSContScheduleEvery(TSCont contp, TSHRTime every /* millisecs */)
     ink_assert(!"not reached");
   }
 
-  EThread *eth = i->getThreadAffinity();
+  EThread *eth = sdk_schedule_affinity(i);
   if (eth == nullptr) {
     return nullptr;
   }
@@ -6174,6 +6375,15 @@ TSHttpTxnArgGet(TSHttpTxn txnp, int arg_idx)
   return sm->t_state.user_args[arg_idx];
 }
 
+void *
+TSHttpTxnArenaAlloc(TSHttpTxn txnp, size_t size)
+{
+  sdk_assert(sdk_sanity_check_txn(txnp) == TS_SUCCESS);
+
+  HttpSM *sm = reinterpret_cast<HttpSM *>(txnp);
+  return sm->txn_alloc(size);
+}
+
 void
 TSHttpSsnArgSet(TSHttpSsn ssnp, int arg_idx, void *arg)
 {
@@ -6987,6 +7197,25 @@ TSNetVConnRemoteAddrGet(TSVConn connp)
   return vc->get_remote_addr();
 }
 
+TSReturnCode
+TSNetVConnProxyProtocolTlvGet(TSVConn connp, int type, const char **value, int *length)
+{
+  sdk_assert(sdk_sanity_check_iocore_structure(connp) == TS_SUCCESS);
+  sdk_assert(value != nullptr && length != nullptr);
+  NetVConnection *vc = reinterpret_cast<NetVConnection *>(connp);
+
+  if (type < 0 || type > UINT8_MAX) {
+    return TS_ERROR;
+  }
+  std::string_view tlv = vc->get_proxy_protocol_tlv(type);
+  if (tlv.data() == nullptr) {
+    return TS_ERROR;
+  }
+  *value  = tlv.data();
+  *length = tlv.size();
+  return TS_SUCCESS;
+}
+
 TSAction
 TSNetConnect(TSCont contp, sockaddr const *addr)
 {
@@ -7220,17 +7449,27 @@ TSCacheScan(TSCont contp, TSCacheKey key, int KB_per_second)
 int
 TSStatCreate(const char *the_name, TSRecordDataType the_type, TSStatPersistence persist, TSStatSync sync)
 {
-  int id                  = ink_atomic_increment(&api_rsb_index, 1);
+  // A histogram takes a raw stat for each of its buckets.
+  int n                   = sync == TS_STAT_SYNC_HISTOGRAM ? REC_HISTOGRAM_BUCKETS : 1;
+  int id                  = ink_atomic_increment(&api_rsb_index, n);
   RecRawStatSyncCb syncer = RecRawStatSyncCount;
 
   // TODO: This only supports "int" data types at this point, since the "Raw" stats
   // interfaces only supports integers. Going forward, we could extend either the "Raw"
   // stats APIs, or make non-int use the direct (synchronous) stats APIs (slower).
   if ((sdk_sanity_check_null_ptr((void *)the_name) != TS_SUCCESS) || (sdk_sanity_check_null_ptr((void *)api_rsb) != TS_SUCCESS) ||
-      (id >= api_rsb->max_stats)) {
+      (id + n > api_rsb->max_stats)) {
     return TS_ERROR;
   }
 
+  if (sync == TS_STAT_SYNC_HISTOGRAM) {
+    // The records of a histogram are gauges of the recent values, they are never persisted.
+    if (RecRegisterRawStatHistogram(api_rsb, RECT_PLUGIN, the_name, id) != REC_ERR_OKAY) {
+      return TS_ERROR;
+    }
+    return id;
+  }
+
   switch (sync) {
   case TS_STAT_SYNC_SUM:
     syncer = RecRawStatSyncSum;
@@ -7267,6 +7506,13 @@ TSStatIntIncrement(int id, TSMgmtInt amount)
   RecIncrRawStat(api_rsb, nullptr, id, amount);
 }
 
+void
+TSStatHistogramRecord(int id, TSMgmtInt value)
+{
+  sdk_assert(sdk_sanity_check_stat_id(id) == TS_SUCCESS);
+  RecIncrRawStatHistogram(api_rsb, nullptr, id, value);
+}
+
 void
 TSStatIntDecrement(int id, TSMgmtInt amount)
 {
@@ -7309,6 +7555,87 @@ TSStatFindName(const char *name, int *idp)
   return TS_SUCCESS;
 }
 
+/**************************    Key Value Stores    ****************************/
+
+namespace
+{
+// The stores by name, they are never destroyed so they can be shared by plugins that come and go.
+std::mutex kv_stores_mutex;
+std::unordered_map<std::string, ts::KeyValueStore *> kv_stores;
+
+inline std::string_view
+kv_key(const char *key, int key_len)
+{
+  return std::string_view(key, key_len < 0 ? strlen(key) : key_len);
+}
+
+inline time_t
+kv_expires(int ttl)
+{
+  return ttl > 0 ? ink_time() + ttl : 0;
+}
+} // namespace
+
+TSKvStore
+TSKvStoreGet(const char *name, int64_t max_bytes)
+{
+  sdk_assert(sdk_sanity_check_null_ptr((void *)name) == TS_SUCCESS);
+  sdk_assert(max_bytes >= 0);
+
+  std::lock_guard<std::mutex> lock(kv_stores_mutex);
+  ts::KeyValueStore *&store = kv_stores[name];
+  if (store == nullptr) {
+    store = new ts::KeyValueStore(max_bytes);
+  }
+  return reinterpret_cast<TSKvStore>(store);
+}
+
+int64_t
+TSKvStoreValueGet(TSKvStore store, const char *key, int key_len, char *buf, int64_t buf_len)
+{
+  sdk_assert(sdk_sanity_check_null_ptr((void *)store) == TS_SUCCESS);
+  sdk_assert(sdk_sanity_check_null_ptr((void *)key) == TS_SUCCESS);
+  sdk_assert(buf_len == 0 || sdk_sanity_check_null_ptr((void *)buf) == TS_SUCCESS);
+
+  std::string value;
+  if (!reinterpret_cast<ts::KeyValueStore *>(store)->get(kv_key(key, key_len), value, ink_time())) {
+    return -1;
+  }
+  if (buf_len > 0) {
+    memcpy(buf, value.data(), std::min<int64_t>(value.size(), buf_len));
+  }
+  return value.size();
+}
+
+TSReturnCode
+TSKvStoreValueSet(TSKvStore store, const char *key, int key_len, const char *value, int64_t value_len, int ttl)
+{
+  sdk_assert(sdk_sanity_check_null_ptr((void *)store) == TS_SUCCESS);
+  sdk_assert(sdk_sanity_check_null_ptr((void *)key) == TS_SUCCESS);
+  sdk_assert(value_len == 0 || sdk_sanity_check_null_ptr((void *)value) == TS_SUCCESS);
+
+  reinterpret_cast<ts::KeyValueStore *>(store)->set(kv_key(key, key_len), std::string_view(value, value_len), kv_expires(ttl));
+  return TS_SUCCESS;
+}
+
+TSReturnCode
+TSKvStoreValueRemove(TSKvStore store, const char *key, int key_len)
+{
+  sdk_assert(sdk_sanity_check_null_ptr((void *)store) == TS_SUCCESS);
+  sdk_assert(sdk_sanity_check_null_ptr((void *)key) == TS_SUCCESS);
+
+  return reinterpret_cast<ts::KeyValueStore *>(store)->remove(kv_key(key, key_len)) ? TS_SUCCESS : TS_ERROR;
+}
+
+int64_t
+TSKvStoreCounterIncrement(TSKvStore store, const char *key, int key_len, int64_t delta, int ttl)
+{
+  sdk_assert(sdk_sanity_check_null_ptr((void *)store) == TS_SUCCESS);
+  sdk_assert(sdk_sanity_check_null_ptr((void *)key) == TS_SUCCESS);
+
+  return reinterpret_cast<ts::KeyValueStore *>(store)->increment(kv_key(key, key_len), delta, kv_expires(ttl), ink_time());
+}
+
 /**************************    Stats API    ****************************/
 // THESE APIS ARE DEPRECATED, USE THE REC APIs INSTEAD
 // #define ink_sanity_check_stat_structure(_x) TS_SUCCESS
@@ -8013,7 +8340,7 @@ TSAIOWrite(int fd, off_t offset, char *buf, const size_t bufSize, TSCont contp)
 TSReturnCode
 TSAIOThreadNumSet(int thread_num)
 {
-#if AIO_MODE == AIO_MODE_NATIVE
+#if AIO_MODE_PER_THREAD
   (void)thread_num;
   return TS_SUCCESS;
 #else
@@ -8416,8 +8743,15 @@ _conf_to_memberp(TSOverridableConfigKey conf, OverridableHttpConfigParams *overr
   case TS_CONFIG_SSL_CERT_FILEPATH:
   case TS_CONFIG_SSL_CLIENT_PRIVATE_KEY_FILENAME:
   case TS_CONFIG_SSL_CLIENT_CA_CERT_FILENAME:
+  case TS_CONFIG_NET_SOCK_CONGESTION_CONTROL_IN:
     // String, must be handled elsewhere
     break;
+  case TS_CONFIG_NET_SOCK_PACING_RATE_IN:
+    ret = _memberp_to_generic(&overridableHttpConfig->sock_pacing_rate_in, conv);
+    break;
+  case TS_CONFIG_NET_SOCK_NOTSENT_LOWAT_IN:
+    ret = _memberp_to_generic(&overridableHttpConfig->sock_notsent_lowat_in, conv);
+    break;
   case TS_CONFIG_PARENT_FAILURES_UPDATE_HOSTDB:
     ret = _memberp_to_generic(&overridableHttpConfig->parent_failures_update_hostdb, conv);
     break;
@@ -8630,6 +8964,13 @@ TSHttpTxnConfigStringSet(TSHttpTxn txnp, TSOverridableConfigKey conf, const char
       s->t_state.txn_conf->ssl_client_ca_cert_filename = const_cast<char *>(value);
     }
     break;
+  case TS_CONFIG_NET_SOCK_CONGESTION_CONTROL_IN:
+    if (value && length > 0) {
+      s->t_state.txn_conf->sock_congestion_control_in = const_cast<char *>(value);
+    } else {
+      s->t_state.txn_conf->sock_congestion_control_in = nullptr;
+    }
+    break;
   case TS_CONFIG_SSL_CERT_FILEPATH:
     /* noop */
     break;
@@ -8670,6 +9011,10 @@ TSHttpTxnConfigStringGet(TSHttpTxn txnp, TSOverridableConfigKey conf, const char
     *value  = sm->t_state.txn_conf->body_factory_template_base;
     *length = sm->t_state.txn_conf->body_factory_template_base_len;
     break;
+  case TS_CONFIG_NET_SOCK_CONGESTION_CONTROL_IN:
+    *value  = sm->t_state.txn_conf->sock_congestion_control_in;
+    *length = *value ? strlen(*value) : 0;
+    break;
   default: {
     MgmtConverter const *conv;
     void *src = _conf_to_memberp(conf, sm->t_state.txn_conf, conv);
@@ -8820,7 +9165,10 @@ static const std::unordered_map<std::string_view, std::tuple<const TSOverridable
    {"proxy.config.ssl.client.cert.filename", {TS_CONFIG_SSL_CLIENT_CERT_FILENAME, TS_RECORDDATATYPE_STRING}},
    {"proxy.config.ssl.client.cert.path", {TS_CONFIG_SSL_CERT_FILEPATH, TS_RECORDDATATYPE_STRING}},
    {"proxy.config.ssl.client.private_key.filename", {TS_CONFIG_SSL_CLIENT_PRIVATE_KEY_FILENAME, TS_RECORDDATATYPE_STRING}},
-   {"proxy.config.ssl.client.CA.cert.filename", {TS_CONFIG_SSL_CLIENT_CA_CERT_FILENAME, TS_RECORDDATATYPE_STRING}}});
+   {"proxy.config.ssl.client.CA.cert.filename", {TS_CONFIG_SSL_CLIENT_CA_CERT_FILENAME, TS_RECORDDATATYPE_STRING}},
+   {"proxy.config.net.sock_congestion_control_in", {TS_CONFIG_NET_SOCK_CONGESTION_CONTROL_IN, TS_RECORDDATATYPE_STRING}},
+   {"proxy.config.net.sock_pacing_rate_in", {TS_CONFIG_NET_SOCK_PACING_RATE_IN, TS_RECORDDATATYPE_INT}},
+   {"proxy.config.net.sock_notsent_lowat_in", {TS_CONFIG_NET_SOCK_NOTSENT_LOWAT_IN, TS_RECORDDATATYPE_INT}}});
 
 TSReturnCode
 TSHttpTxnConfigFind(const char *name, int length, TSOverridableConfigKey *conf, TSRecordDataType *type)
@@ -9428,7 +9776,7 @@ TSVConnReenableEx(TSVConn vconn, TSEvent event)
   }
 }
 
-extern SSLSessionCache *session_cache; // declared extern in P_SSLConfig.h
+extern SSLSessionCacheBackend *session_cache; // declared extern in P_SSLConfig.h
 
 TSSslSession
 TSSslSessionGet(const TSSslSessionID *session_id)
@@ -5815,6 +5815,62 @@ compare_field_values(RegressionTest *test, TSMBuffer bufp1, TSMLoc hdr_loc1, TSM
   return TS_SUCCESS;
 }
 
+//////////////////////////////////////////////
+//       SDK_API_TSMimeHdrFieldValues
+//
+// Unit Test for API: TSMimeHdrFieldValuesGet
+//                    TSMimeHdrFieldValuesSet
+//////////////////////////////////////////////
+
+REGRESSION_TEST(SDK_API_TSMimeHdrFieldValues)(RegressionTest *test, int /* atype ATS_UNUSED */, int *pstatus)
+{
+  TSMBuffer bufp     = TSMBufferCreate();
+  TSMLoc mime_loc    = TS_NULL_MLOC;
+  bool test_passed_1 = false;
+  bool test_passed_2 = false;
+
+  *pstatus = REGRESSION_TEST_INPROGRESS;
+
+  if (TSMimeHdrCreate(bufp, &mime_loc) != TS_SUCCESS) {
+    SDK_RPRINT(test, "TSMimeHdrFieldValuesSet", "TestCase1", TC_FAIL, "Cannot create Mime hdr");
+    TSMBufferDestroy(bufp);
+    *pstatus = REGRESSION_TEST_FAILED;
+    return;
+  }
+
+  TSMimeHdrFieldValue set[] = {{TS_MIME_FIELD_HOST, TS_MIME_LEN_HOST, "example.com", -1},
+                               {"X-Batch", -1, "one", 3},
+                               {TS_MIME_FIELD_AGE, TS_MIME_LEN_AGE, "10", 2}};
+  TSMimeHdrFieldValue get[] = {{TS_MIME_FIELD_HOST, TS_MIME_LEN_HOST, nullptr, 0},
+                               {"x-batch", -1, nullptr, 0},
+                               {TS_MIME_FIELD_AGE, TS_MIME_LEN_AGE, nullptr, 0}};
+
+  if (TSMimeHdrFieldValuesSet(bufp, mime_loc, set, 3) == TS_SUCCESS && TSMimeHdrFieldValuesGet(bufp, mime_loc, get, 3) == 3 &&
+      get[0].value_len == 11 && memcmp(get[0].value, "example.com", 11) == 0 && get[1].value_len == 3 &&
+      memcmp(get[1].value, "one", 3) == 0 && get[2].value_len == 2 && memcmp(get[2].value, "10", 2) == 0) {
+    SDK_RPRINT(test, "TSMimeHdrFieldValuesGet", "TestCase1", TC_PASS, "ok");
+    test_passed_1 = true;
+  } else {
+    SDK_RPRINT(test, "TSMimeHdrFieldValuesGet", "TestCase1", TC_FAIL, "Values set and retrieved differ");
+  }
+
+  // Replace one field and remove another.
+  TSMimeHdrFieldValue update[] = {{"X-Batch", -1, "two", -1}, {TS_MIME_FIELD_AGE, TS_MIME_LEN_AGE, nullptr, 0}};
+  if (TSMimeHdrFieldValuesSet(bufp, mime_loc, update, 2) == TS_SUCCESS && TSMimeHdrFieldValuesGet(bufp, mime_loc, get, 3) == 2 &&
+      get[1].value_len == 3 && memcmp(get[1].value, "two", 3) == 0 && get[2].value == nullptr &&
+      TSMimeHdrFieldsCount(bufp, mime_loc) == 2) {
+    SDK_RPRINT(test, "TSMimeHdrFieldValuesSet", "TestCase1", TC_PASS, "ok");
+    test_passed_2 = true;
+  } else {
+    SDK_RPRINT(test, "TSMimeHdrFieldValuesSet", "TestCase1", TC_FAIL, "Field not replaced or removed");
+  }
+
+  TSHandleMLocRelease(bufp, TS_NULL_MLOC, mime_loc);
+  TSMBufferDestroy(bufp);
+
+  *pstatus = (test_passed_1 && test_passed_2) ? REGRESSION_TEST_PASSED : REGRESSION_TEST_FAILED;
+}
+
 REGRESSION_TEST(SDK_API_TSMimeHdrParse)(RegressionTest *test, int /* atype ATS_UNUSED */, int *pstatus)
 {
   const char *parse_string =
@@ -8669,7 +8725,10 @@ std::array<std::string_view, TS_CONFIG_LAST_ENTRY> SDK_Overridable_Configs = {
    "proxy.config.ssl.client.verify.server.properties",
    "proxy.config.ssl.client.sni_policy",
    "proxy.config.ssl.client.private_key.filename",
-   "proxy.config.ssl.client.CA.cert.filename"}};
+   "proxy.config.ssl.client.CA.cert.filename",
+   "proxy.config.net.sock_congestion_control_in",
+   "proxy.config.net.sock_pacing_rate_in",
+   "proxy.config.net.sock_notsent_lowat_in"}};
 
 REGRESSION_TEST(SDK_API_OVERRIDABLE_CONFIGS)(RegressionTest *test, int /* atype ATS_UNUSED */, int *pstatus)
 {
@@ -9179,3 +9238,29 @@ REGRESSION_TEST(SDK_API_TSStatCreate)(RegressionTest *test, int level, int *psta
 
   box.check(expected >= value, "TSStatIntGet(%s) gave %" PRId64 ", expected at least %" PRId64, name, value, expected);
 }
+
+REGRESSION_TEST(SDK_API_TSKvStore)(RegressionTest *test, int level, int *pstatus)
+{
+  TSKvStore store = TSKvStoreGet("regression.test.kvstore", 1024 * 1024);
+  char buf[16];
+
+  TestBox box(test, pstatus);
+
+  box = REGRESSION_TEST_PASSED;
+
+  box.check(TSKvStoreGet("regression.test.kvstore", 0) == store, "TSKvStoreGet gave another store for the same name");
+
+  TSKvStoreValueSet(store, "key", -1, "value", 5, 0);
+  int64_t len = TSKvStoreValueGet(store, "key", 3, buf, sizeof(buf));
+  box.check(len == 5 && memcmp(buf, "value", 5) == 0, "TSKvStoreValueGet gave %" PRId64 " bytes, expected 'value'", len);
+  box.check(TSKvStoreValueGet(store, "key", -1, nullptr, 0) == 5, "TSKvStoreValueGet didn't give the length of the value");
+
+  box.check(TSKvStoreValueRemove(store, "key", -1) == TS_SUCCESS, "TSKvStoreValueRemove failed");
+  box.check(TSKvStoreValueRemove(store, "key", -1) == TS_ERROR, "TSKvStoreValueRemove removed a missing key");
+  box.check(TSKvStoreValueGet(store, "key", -1, buf, sizeof(buf)) == -1, "TSKvStoreValueGet found a removed key");
+
+  TSKvStoreValueRemove(store, "counter", -1);
+  TSKvStoreCounterIncrement(store, "counter", -1, 2, 60);
+  int64_t count = TSKvStoreCounterIncrement(store, "counter", -1, 3, 60);
+  box.check(count == 5, "TSKvStoreCounterIncrement gave %" PRId64 ", expected 5", count);
+}
@@ -0,0 +1,135 @@
+/** @file
+
+  Concurrent loading of configuration at startup.
+
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ */
+
+#include <algorithm>
+#include <thread>
+
+#include "StartupLoader.h"
+#include "records/I_RecCore.h"
+#include "tscore/Diags.h"
+#include "tscore/ink_assert.h"
+
+void
+StartupLoader::add(const char *name, Load load, std::initializer_list<const char *> after)
+{
+  size_t idx = _tasks.size();
+  Task task;
+
+  task.name = name;
+  task.load = std::move(load);
+  for (const char *dep : after) {
+    auto spot = std::find_if(_tasks.begin(), _tasks.end(), [dep](Task const &t) { return t.name == dep; });
+    ink_release_assert(spot != _tasks.end());
+    spot->dependents.push_back(idx);
+    ++task.waiting;
+  }
+  _tasks.push_back(std::move(task));
+}
+
+void
+StartupLoader::run()
+{
+  int n_threads    = 1;
+  ink_hrtime start = ink_get_hrtime_internal();
+
+  REC_ReadConfigInteger(n_threads, "proxy.config.startup.config_load_threads");
+
+  if (n_threads <= 1) {
+    for (Task &task : _tasks) {
+      Debug("startup", "loading %s", task.name.c_str());
+      ink_hrtime t = ink_get_hrtime_internal();
+      task.load();
+      task.elapsed = ink_get_hrtime_internal() - t;
+      ++_done;
+    }
+  } else {
+    std::vector<std::thread> threads;
+
+    for (size_t i = 0; i < _tasks.size(); ++i) {
+      if (_tasks[i].waiting == 0) {
+        _ready.push_back(i);
+      }
+    }
+    n_threads = std::min<size_t>(n_threads, _tasks.size());
+    for (int i = 1; i < n_threads; ++i) {
+      threads.emplace_back([this]() { work(); });
+    }
+    work();
+    for (std::thread &t : threads) {
+      t.join();
+    }
+  }
+  ink_release_assert(_done == _tasks.size());
+
+  std::string names;
+  for (Task const &task : _tasks) {
+    std::string stat = "proxy.process.startup." + task.name + ".load_time_ms";
+    RecInt msec      = ink_hrtime_to_msec(task.elapsed);
+    RecRegisterStatInt(RECT_PROCESS, stat.c_str(), msec, RECP_NON_PERSISTENT);
+    RecSetRecordInt(stat.c_str(), msec, REC_SOURCE_EXPLICIT);
+    names.append(names.empty() ? "" : ", ").append(task.name);
+  }
+  Note("loaded %s in %" PRId64 " ms on %d threads", names.c_str(), ink_hrtime_to_msec(ink_get_hrtime_internal() - start),
+       std::max(n_threads, 1));
+
+  _tasks.clear();
+  _done = 0;
+}
+
+void
+StartupLoader::work()
+{
+  std::unique_lock<std::mutex> lock(_mutex);
+
+  while (true) {
+    _cond.wait(lock, [this]() { return !_ready.empty() || _done == _tasks.size(); });
+    if (_ready.empty()) {
+      return;
+    }
+    Task &task = _tasks[_ready.front()];
+    _ready.pop_front();
+
+    lock.unlock();
+    Debug("startup", "loading %s", task.name.c_str());
+    ink_hrtime t = ink_get_hrtime_internal();
+    task.load();
+    task.elapsed = ink_get_hrtime_internal() - t;
+    lock.lock();
+
+    finish(task);
+  }
+}
+
+/// Make the loads waiting for @a task ready, with the lock held.
+void
+StartupLoader::finish(Task &task)
+{
+  ++_done;
+  for (size_t idx : task.dependents) {
+    if (--_tasks[idx].waiting == 0) {
+      _ready.push_back(idx);
+    }
+  }
+  _cond.notify_all();
+}
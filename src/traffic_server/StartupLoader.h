@@ -0,0 +1,73 @@
+/** @file
+
+  Concurrent loading of configuration at startup.
+
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ */
+
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <initializer_list>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "tscore/ink_hrtime.h"
+
+/** Loads configuration subsystems that do not depend on each other concurrently.
+
+    Each load is added with a name and the names of the loads that must be done before it starts,
+    which must have been added already, so the order they are added in is always a safe order.
+    @c run runs them on up to @c proxy.config.startup.config_load_threads threads, counting the
+    calling thread, and returns once they are all done. With one thread they run in the order they
+    were added.
+
+    The time each load took is kept in @c proxy.process.startup.<name>.load_time_ms.
+ */
+class StartupLoader
+{
+public:
+  using Load = std::function<void()>;
+
+  void add(const char *name, Load load, std::initializer_list<const char *> after = {});
+  void run();
+
+private:
+  struct Task {
+    std::string name;
+    Load load;
+    int waiting = 0;                ///< Loads it waits for that are not done yet.
+    std::vector<size_t> dependents; ///< Loads waiting for this one.
+    ink_hrtime elapsed = 0;
+  };
+
+  void work();
+  void finish(Task &task);
+
+  std::vector<Task> _tasks;
+
+  std::mutex _mutex;
+  std::condition_variable _cond;
+  std::deque<size_t> _ready; ///< Loads that can start.
+  size_t _done = 0;
+};
@@ -80,6 +80,7 @@ extern "C" int plock(int);
 #include "logging/Log.h"
 #include "CacheControl.h"
 #include "IPAllow.h"
+#include "HttpInvalidate.h"
 #include "ParentSelection.h"
 #include "HostStatus.h"
 #include "MgmtUtils.h"
@@ -89,8 +90,11 @@ extern "C" int plock(int);
 #include "Plugin.h"
 #include "DiagsConfig.h"
 #include "CoreUtils.h"
+#include "EventName.h"
 #include "RemapConfig.h"
 #include "RemapProcessor.h"
+#include "ReverseProxy.h"
+#include "StartupLoader.h"
 #include "I_Tasks.h"
 #include "InkAPIInternal.h"
 #include "HTTP2.h"
@@ -119,6 +123,8 @@ static void mgmt_restart_shutdown_callback(ts::MemSpan<void>);
 static void mgmt_drain_callback(ts::MemSpan<void>);
 static void mgmt_storage_device_cmd_callback(int cmd, std::string_view const &arg);
 static void mgmt_lifecycle_msg_callback(ts::MemSpan<void>);
+static void mgmt_dispatch_trace_callback(ts::MemSpan<void>);
+static void mgmt_cpu_profile_callback(ts::MemSpan<void>);
 static void init_ssl_ctx_callback(void *ctx, bool server);
 static void load_ssl_file_callback(const char *ssl_file);
 static void load_remap_file_callback(const char *remap_file);
@@ -448,6 +454,102 @@ private:
   struct rusage _usage;
 };
 
+#if TS_HAS_JEMALLOC
+// Publish the allocator statistics of jemalloc, so memory use and allocation rates can be
+// followed (and compared between builds) without attaching a profiler.
+class JemallocStats : public Continuation
+{
+public:
+  JemallocStats() : Continuation(new_ProxyMutex())
+  {
+    SET_HANDLER(&JemallocStats::periodic);
+    for (const char *name : {ALLOCATED, ACTIVE, RESIDENT, MAPPED, ALLOCATIONS}) {
+      RecRegisterStatInt(RECT_PROCESS, name, static_cast<RecInt>(0), RECP_NON_PERSISTENT);
+    }
+  }
+
+  int
+  periodic(int /* event ATS_UNUSED */, Event * /* e ATS_UNUSED */)
+  {
+    // The statistics of jemalloc are a snapshot, taken when the epoch is advanced.
+    uint64_t epoch = 1;
+    size_t len     = sizeof(epoch);
+    if (mallctl("epoch", &epoch, &len, &epoch, len) != 0) {
+      return EVENT_CONT;
+    }
+
+    RecSetRecordInt(ALLOCATED, read<size_t>("stats.allocated"), REC_SOURCE_DEFAULT);
+    RecSetRecordInt(ACTIVE, read<size_t>("stats.active"), REC_SOURCE_DEFAULT);
+    RecSetRecordInt(RESIDENT, read<size_t>("stats.resident"), REC_SOURCE_DEFAULT);
+    RecSetRecordInt(MAPPED, read<size_t>("stats.mapped"), REC_SOURCE_DEFAULT);
+#ifdef MALLCTL_ARENAS_ALL
+    // The number of allocations ever made, over all the arenas.
+    char small[64], large[64];
+    snprintf(small, sizeof(small), "stats.arenas.%u.small.nmalloc", static_cast<unsigned>(MALLCTL_ARENAS_ALL));
+    snprintf(large, sizeof(large), "stats.arenas.%u.large.nmalloc", static_cast<unsigned>(MALLCTL_ARENAS_ALL));
+    RecSetRecordInt(ALLOCATIONS, read<uint64_t>(small) + read<uint64_t>(large), REC_SOURCE_DEFAULT);
+#endif
+    return EVENT_CONT;
+  }
+
+private:
+  static constexpr const char *ALLOCATED   = "proxy.process.traffic_server.memory.jemalloc.allocated";
+  static constexpr const char *ACTIVE      = "proxy.process.traffic_server.memory.jemalloc.active";
+  static constexpr const char *RESIDENT    = "proxy.process.traffic_server.memory.jemalloc.resident";
+  static constexpr const char *MAPPED      = "proxy.process.traffic_server.memory.jemalloc.mapped";
+  static constexpr const char *ALLOCATIONS = "proxy.process.traffic_server.memory.jemalloc.allocations";
+
+  // Statistics that jemalloc was built without read as 0.
+  template <typename T>
+  static RecInt
+  read(const char *key)
+  {
+    T value    = 0;
+    size_t len = sizeof(value);
+    return mallctl(key, &value, &len, nullptr, 0) == 0 ? static_cast<RecInt>(value) : 0;
+  }
+};
+#endif /* TS_HAS_JEMALLOC */
+
+// Publish the memory accounted to each of the subsystems, see AtsMemTag.
+class MemoryTagStats : public Continuation
+{
+public:
+  MemoryTagStats() : Continuation(new_ProxyMutex())
+  {
+    SET_HANDLER(&MemoryTagStats::periodic);
+    // The bytes in use are only known when the tags have arenas of their own.
+    _in_use = ats_mem_tag_in_use(ATS_MEM_TAG_CACHE) >= 0;
+    for (int tag = 0; tag < ATS_MEM_TAG_COUNT; ++tag) {
+      RecRegisterStatInt(RECT_PROCESS, name(tag, "allocated").c_str(), static_cast<RecInt>(0), RECP_NON_PERSISTENT);
+      if (_in_use && tag != ATS_MEM_TAG_OTHER) {
+        RecRegisterStatInt(RECT_PROCESS, name(tag, "in_use").c_str(), static_cast<RecInt>(0), RECP_NON_PERSISTENT);
+      }
+    }
+  }
+
+  int
+  periodic(int /* event ATS_UNUSED */, Event * /* e ATS_UNUSED */)
+  {
+    for (int tag = 0; tag < ATS_MEM_TAG_COUNT; ++tag) {
+      RecSetRecordInt(name(tag, "allocated").c_str(), ats_mem_tag_allocated(static_cast<AtsMemTag>(tag)), REC_SOURCE_DEFAULT);
+      if (_in_use && tag != ATS_MEM_TAG_OTHER) {
+        RecSetRecordInt(name(tag, "in_use").c_str(), ats_mem_tag_in_use(static_cast<AtsMemTag>(tag)), REC_SOURCE_DEFAULT);
+      }
+    }
+    return EVENT_CONT;
+  }
+
+private:
+  static std::string
+  name(int tag, const char *what)
+  {
+    return std::string("proxy.process.traffic_server.memory.") + ats_mem_tag_name(static_cast<AtsMemTag>(tag)) + '.' + what;
+  }
+
+  bool _in_use = false;
+};
+
 void
 set_debug_ip(const char *ip_string)
 {
@@ -705,6 +807,7 @@ CB_After_Cache_Init()
       Debug("cache_bc", "Pre 4.0 stripe (cache version %d.%d) found, forcing MMH hash for cache URLs",
             cacheProcessor.min_stripe_version._major, cacheProcessor.min_stripe_version._minor);
       URLHashContext::Setting = URLHashContext::MMH;
+      url_hash_method_set(URL_HASH_CRYPTO);
     }
   }
 #endif
@@ -1823,6 +1926,8 @@ main(int /* argc ATS_UNUSED */, const char **argv)
   // !! ET_NET threads start here !!
   // This means any spawn scheduling must be done before this point.
   eventProcessor.start(num_of_net_threads, stacksize);
+  ink_net_register_thread_stats(num_of_net_threads);
+  ink_net_spawn_thread_groups(stacksize);
 
   int num_remap_threads = 0;
   REC_ReadConfigInteger(num_remap_threads, "proxy.config.remap.num_remap_threads");
@@ -1838,6 +1943,13 @@ main(int /* argc ATS_UNUSED */, const char **argv)
   eventProcessor.schedule_every(new SignalContinuation, HRTIME_MSECOND * 500, ET_CALL);
   eventProcessor.schedule_every(new DiagsLogContinuation, HRTIME_SECOND, ET_TASK);
   eventProcessor.schedule_every(new MemoryLimit, HRTIME_SECOND * 10, ET_TASK);
+#if TS_HAS_JEMALLOC
+  eventProcessor.schedule_every(new JemallocStats, HRTIME_SECOND, ET_TASK);
+#endif
+  eventProcessor.schedule_every(new MemoryTagStats, HRTIME_SECOND, ET_TASK);
+  start_overload_monitor();
+  start_buffer_slab_trim();
+  start_lock_profiling();
   REC_RegisterConfigUpdateFunc("proxy.config.dump_mem_info_frequency", init_memory_tracker, nullptr);
   init_memory_tracker(nullptr, RECD_NULL, RecData(), nullptr);
 
@@ -1861,16 +1973,20 @@ main(int /* argc ATS_UNUSED */, const char **argv)
       }
     }
   } else {
+    StartupLoader loader;
+
     remapProcessor.start(num_remap_threads, stacksize);
     RecProcessStart();
-    initCacheControl();
-    IpAllow::startup();
-    HostStatus::instance().loadHostStatusFromStats();
-    netProcessor.init_socks();
-    ParentConfig::startup();
+    loader.add("cache_control", &initCacheControl);
+    loader.add("ip_allow", &IpAllow::startup);
+    loader.add("invalidate", &HttpInvalidate::startup);
+    loader.add("host_status", []() { HostStatus::instance().loadHostStatusFromStats(); });
+    loader.add("socks", []() { netProcessor.init_socks(); });
+    loader.add("parent", &ParentConfig::startup, {"host_status"});
 #ifdef SPLIT_DNS
-    SplitDNSConfig::startup();
+    loader.add("split_dns", &SplitDNSConfig::startup);
 #endif
+    loader.run();
 
     // Initialize HTTP/2
     Http2::init();
@@ -1892,7 +2008,10 @@ main(int /* argc ATS_UNUSED */, const char **argv)
 
     SSLConfigParams::init_ssl_ctx_cb  = init_ssl_ctx_callback;
     SSLConfigParams::load_ssl_file_cb = load_ssl_file_callback;
-    sslNetProcessor.start(-1, stacksize);
+    // The certificates and the remap rules, with their plugins, are the largest configurations.
+    loader.add("ssl", [stacksize]() { sslNetProcessor.start(-1, stacksize); });
+    loader.add("remap", []() { init_reverse_proxy(); });
+    loader.run();
 
     pmgmt->registerPluginCallbacks(global_config_cbs);
 
@@ -1976,6 +2095,8 @@ main(int /* argc ATS_UNUSED */, const char **argv)
       mgmt_storage_device_cmd_callback(MGMT_EVENT_STORAGE_DEVICE_CMD_OFFLINE, span.view());
     });
     pmgmt->registerMgmtCallback(MGMT_EVENT_LIFECYCLE_MESSAGE, &mgmt_lifecycle_msg_callback);
+    pmgmt->registerMgmtCallback(MGMT_EVENT_DISPATCH_TRACE, &mgmt_dispatch_trace_callback);
+    pmgmt->registerMgmtCallback(MGMT_EVENT_CPU_PROFILE, &mgmt_cpu_profile_callback);
 
     ink_set_thread_name("[TS_MAIN]");
 
@@ -2050,6 +2171,45 @@ mgmt_storage_device_cmd_callback(int cmd, std::string_view const &arg)
   }
 }
 
+static void
+mgmt_dispatch_trace_callback(ts::MemSpan<void> span)
+{
+  // data is the file to write, empty for the default.
+  std::string path{span.rebind<char>().data()};
+
+  if (path.empty()) {
+    path = RecConfigReadLogDir() + "/dispatch_trace.folded";
+  }
+  if (DispatchTrace::sample_rate <= 0) {
+    Warning("writing the dispatch trace, but proxy.config.exec_thread.dispatch_trace is not enabled");
+  }
+  DispatchTrace::dump(path.c_str(), &event_int_to_string);
+}
+
+static void
+mgmt_cpu_profile_callback(ts::MemSpan<void> span)
+{
+  // data is a '1' for a gperftools profile, a '1' to reset the profiler once written, and the file to write.
+  std::string_view arg{span.rebind<char>().data()};
+  if (arg.size() < 2) {
+    Error("CPU profile - malformed request - discarded.");
+    return;
+  }
+  bool pprof = arg[0] == '1';
+  bool reset = arg[1] == '1';
+  std::string path{arg.substr(2)};
+
+  if (path.empty()) {
+    path = RecConfigReadLogDir() + (pprof ? "/cpu_profile.prof" : "/cpu_profile.folded");
+  }
+  if (!CpuProfiler::running()) {
+    Warning("writing the CPU profile, but proxy.config.exec_thread.cpu_profile is not enabled");
+  }
+  if (CpuProfiler::dump(path.c_str(), pprof ? CpuProfiler::PPROF : CpuProfiler::COLLAPSED) && reset) {
+    CpuProfiler::reset();
+  }
+}
+
 static void
 mgmt_lifecycle_msg_callback(ts::MemSpan<void> span)
 {
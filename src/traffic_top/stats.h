@@ -31,6 +31,7 @@
 #include <cinttypes>
 #include <sys/time.h>
 #include "mgmtapi.h"
+#include "records/I_RecStatsShm.h"
 
 using namespace std;
 
@@ -83,7 +84,8 @@ public:
       char hostname[25];
       hostname[sizeof(hostname) - 1] = '\0';
       gethostname(hostname, sizeof(hostname) - 1);
-      _host = hostname;
+      _host     = hostname;
+      _shm_path = RecStatsShmPath();
     }
 
     _time_diff = 0;
@@ -265,6 +267,70 @@ public:
     lookup_table.insert(make_pair("client_dyn_ka", LookupItem("Dynamic KA", "ka_total", "ka_count", 3)));
   }
 
+  // Fill the stats from the shared stats segment of the server, if it has a recent one.
+  bool
+  getShmStats()
+  {
+    int64_t updated = 0;
+    bool found      = RecStatsShmRead(
+      _shm_path.c_str(),
+      [this](const char *name, RecDataT data_type, const RecData &data) {
+        char buffer[32];
+        if (data_type == RECD_STRING) {
+          (*_stats)[name] = data.rec_string;
+          return;
+        } else if (data_type == RECD_FLOAT) {
+          snprintf(buffer, sizeof(buffer), "%f", data.rec_float);
+        } else {
+          snprintf(buffer, sizeof(buffer), "%" PRId64, data_type == RECD_INT ? data.rec_int : data.rec_counter);
+        }
+        (*_stats)[name] = buffer;
+      },
+      &updated);
+
+    // A segment left behind by a server that is gone is no use.
+    if (found && time(nullptr) - updated > REC_STATS_SHM_MAX_AGE) {
+      _stats->clear();
+      found = false;
+    }
+    return found;
+  }
+
+  // The per thread and per disk stats, as many as the server has.
+  void
+  getThreadStats()
+  {
+    static const char *const thread_stats[] = {"proxy.process.eventloop.thread.%d.busy_pct",
+                                               "proxy.process.eventloop.thread.%d.loops",
+                                               "proxy.process.eventloop.thread.%d.events",
+                                               "proxy.process.eventloop.thread.%d.events_max",
+                                               "proxy.process.net.thread.%d.connections",
+                                               "proxy.process.net.thread.%d.active_connections"};
+    static const char *const disk_stats[]   = {"proxy.process.aio.disk.%d.latency_us.count",
+                                             "proxy.process.aio.disk.%d.latency_us.p50",
+                                             "proxy.process.aio.disk.%d.latency_us.p99"};
+
+    for (const auto &stats : {make_pair(thread_stats, countof(thread_stats)), make_pair(disk_stats, countof(disk_stats))}) {
+      for (int i = 0;; ++i) {
+        bool found = false;
+        for (size_t s = 0; s < stats.second; ++s) {
+          char name[128];
+          int64_t value = 0;
+          snprintf(name, sizeof(name), stats.first[s], i);
+          if (TSRecordGetInt(name, &value) == TS_ERR_OKAY) {
+            char buffer[32];
+            snprintf(buffer, sizeof(buffer), "%" PRId64, value);
+            (*_stats)[name] = buffer;
+            found           = true;
+          }
+        }
+        if (!found) {
+          break;
+        }
+      }
+    }
+  }
+
   void
   getStats()
   {
@@ -280,22 +346,27 @@ public:
       gettimeofday(&_time, nullptr);
       double now = _time.tv_sec + (double)_time.tv_usec / 1000000;
 
+      bool from_shm = getShmStats();
       for (map<string, LookupItem>::const_iterator lookup_it = lookup_table.begin(); lookup_it != lookup_table.end(); ++lookup_it) {
         const LookupItem &item = lookup_it->second;
 
         if (item.type == 1 || item.type == 2 || item.type == 5 || item.type == 8) {
           if (strcmp(item.pretty, "Version") == 0) {
-            // special case for Version information
+            // special case for Version information, it doesn't change so it is only asked for once
             TSString strValue = nullptr;
-            if (TSRecordGetString(item.name, &strValue) == TS_ERR_OKAY) {
-              string key     = item.name;
-              (*_stats)[key] = strValue;
+            if (_version.empty() && from_shm && hasStat(item.name)) {
+              _version = (*_stats)[item.name];
+            } else if (_version.empty() && TSRecordGetString(item.name, &strValue) == TS_ERR_OKAY) {
+              _version = strValue;
               TSfree(strValue);
-            } else {
+            } else if (_version.empty()) {
               fprintf(stderr, "Error getting stat: %s when calling TSRecordGetString() failed: file \"%s\", line %d\n\n", item.name,
                       __FILE__, __LINE__);
               abort();
             }
+            (*_stats)[item.name] = _version;
+          } else if (from_shm) {
+            continue;
           } else {
             if (TSRecordGetInt(item.name, &value) != TS_ERR_OKAY) {
               fprintf(stderr, "Error getting stat: %s when calling TSRecordGetInt() failed: file \"%s\", line %d\n\n", item.name,
@@ -310,6 +381,9 @@ public:
           }
         }
       }
+      if (!from_shm) {
+        getThreadStats();
+      }
       _old_time  = _now;
       _now       = now;
       _time_diff = _now - _old_time;
@@ -358,6 +432,24 @@ public:
     }
   }
 
+  // Whether the server has the stat @a name.
+  bool
+  hasStat(const string &name) const
+  {
+    return _stats->find(name) != _stats->end();
+  }
+
+  // The value of the stat @a name, or its rate per second for @a rate.
+  double
+  getNamedStat(const string &name, bool rate) const
+  {
+    double value = getValue(name, _stats);
+    if (rate && _old_stats != nullptr && _absolute == false && _time_diff > 0) {
+      value = (value - getValue(name, _old_stats)) / _time_diff;
+    }
+    return value;
+  }
+
   int64_t
   getValue(const string &key, const map<string, string> *stats) const
   {
@@ -381,7 +473,7 @@ public:
   getStat(const string &key, string &value)
   {
     map<string, LookupItem>::const_iterator lookup_it = lookup_table.find(key);
-    assert(lookup_it != lookup_table.end());
+    ink_assert(lookup_it != lookup_table.end());
     const LookupItem &item = lookup_it->second;
 
     map<string, string>::const_iterator stats_it = _stats->find(item.name);
@@ -396,7 +488,7 @@ public:
   getStat(const string &key, double &value, string &prettyName, int &type, int overrideType = 0)
   {
     map<string, LookupItem>::const_iterator lookup_it = lookup_table.find(key);
-    assert(lookup_it != lookup_table.end());
+    ink_assert(lookup_it != lookup_table.end());
     const LookupItem &item = lookup_it->second;
     prettyName             = item.pretty;
     if (overrideType != 0) {
@@ -529,6 +621,8 @@ private:
   map<string, LookupItem> lookup_table;
   string _url;
   string _host;
+  string _shm_path;
+  string _version;
   double _old_time;
   double _now;
   double _time_diff;
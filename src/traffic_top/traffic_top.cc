@@ -220,6 +220,56 @@ response_code_page(Stats &stats)
   makeTable(42, 1, response3, stats);
 }
 
+//----------------------------------------------------------------------------
+static void
+thread_page(Stats &stats)
+{
+  attron(COLOR_PAIR(colorPair::border));
+  attron(A_BOLD);
+  mvprintw(0, 0, "      EVENT THREADS (last 10 seconds)                                          ");
+  mvprintw(0, 56, "      CACHE DISKS       ");
+  for (int i = 0; i <= 22; ++i) {
+    mvprintw(i, 55, " ");
+  }
+  attroff(COLOR_PAIR(colorPair::border));
+  attroff(A_BOLD);
+
+  mvprintw(1, 0, "Thread    Busy   Loops  Events Max Evt   Conns  Active");
+  mvprintw(1, 56, "D   Ops/s  p50us  p99us");
+
+  char name[128];
+  for (int i = 0; i < 21; ++i) {
+    snprintf(name, sizeof(name), "proxy.process.eventloop.thread.%d.busy_pct", i);
+    if (!stats.hasStat(name)) {
+      break;
+    }
+    static const char *const columns[] = {"eventloop.thread.%d.loops", "eventloop.thread.%d.events",
+                                          "eventloop.thread.%d.events_max", "net.thread.%d.connections",
+                                          "net.thread.%d.active_connections"};
+    mvprintw(i + 2, 0, "%6d", i);
+    prettyPrint(7, i + 2, stats.getNamedStat(name, false), 4);
+    for (unsigned c = 0; c < countof(columns); ++c) {
+      char column[128];
+      snprintf(column, sizeof(column), columns[c], i);
+      snprintf(name, sizeof(name), "proxy.process.%s", column);
+      prettyPrint(15 + c * 8, i + 2, stats.getNamedStat(name, false), 1);
+    }
+  }
+
+  for (int i = 0; i < 21; ++i) {
+    snprintf(name, sizeof(name), "proxy.process.aio.disk.%d.latency_us.count", i);
+    if (!stats.hasStat(name)) {
+      break;
+    }
+    mvprintw(i + 2, 56, "%-2d", i);
+    prettyPrint(58, i + 2, stats.getNamedStat(name, true), 1);
+    snprintf(name, sizeof(name), "proxy.process.aio.disk.%d.latency_us.p50", i);
+    prettyPrint(65, i + 2, stats.getNamedStat(name, false), 1);
+    snprintf(name, sizeof(name), "proxy.process.aio.disk.%d.latency_us.p99", i);
+    prettyPrint(72, i + 2, stats.getNamedStat(name, false), 1);
+  }
+}
+
 //----------------------------------------------------------------------------
 static void
 help(const string &host, const string &version)
@@ -253,6 +303,8 @@ help(const string &host, const string &version)
     mvprintw(11, 0, "Changed    => Requests that required entries in cache to be updated");
     mvprintw(12, 0, "Changed    => Requests that can't be cached for some reason");
     mvprintw(12, 0, "No Cache   => Requests that the client sent Cache-Control: no-cache header");
+    mvprintw(13, 0, "Busy       => Part of the time an event thread was not waiting for activity");
+    mvprintw(14, 0, "Max Evt    => Most events a thread ran in one loop, how deep its queues got");
 
     attron(COLOR_PAIR(colorPair::border));
     attron(A_BOLD);
@@ -458,9 +510,10 @@ main(int argc, const char **argv)
   enum Page {
     MAIN_PAGE,
     RESPONSE_PAGE,
+    THREAD_PAGE,
   };
   Page page       = MAIN_PAGE;
-  string page_alt = "(r)esponse";
+  string page_alt = "(r)esponse (t)hreads";
 
   while (true) {
     attron(COLOR_PAIR(colorPair::border));
@@ -481,6 +534,8 @@ main(int argc, const char **argv)
       main_stats_page(stats);
     } else if (page == RESPONSE_PAGE) {
       response_code_page(stats);
+    } else if (page == THREAD_PAGE) {
+      thread_page(stats);
     }
 
     curs_set(0);
@@ -496,11 +551,15 @@ main(int argc, const char **argv)
       goto quit;
     case 'm':
       page     = MAIN_PAGE;
-      page_alt = "(r)esponse";
+      page_alt = "(r)esponse (t)hreads";
       break;
     case 'r':
       page     = RESPONSE_PAGE;
-      page_alt = "(m)ain";
+      page_alt = "(m)ain (t)hreads";
+      break;
+    case 't':
+      page     = THREAD_PAGE;
+      page_alt = "(m)ain (r)esponse";
       break;
     case 'a':
       absolute = stats.toggleAbsolute();
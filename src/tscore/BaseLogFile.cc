@@ -197,6 +197,7 @@ BaseLogFile::roll(long interval_start, long interval_end)
   // reset m_start_time
   m_start_time    = 0;
   m_bytes_written = 0;
+  m_rolled_name   = ats_strdup(roll_name);
 
   log_log_trace("The logfile %s was rolled to %s.\n", m_name.get(), roll_name);
 
@@ -238,9 +239,18 @@ BaseLogFile::rolled_logfile(char *path)
 {
   const int target_len = (int)strlen(LOGFILE_ROLLED_EXTENSION);
   int len              = (int)strlen(path);
+  // A rolled file may have been compressed since, see LogCompressor.
+  static const char *const compressed_extensions[] = {".gz", ".zst"};
+  for (const char *ext : compressed_extensions) {
+    int ext_len = (int)strlen(ext);
+    if (len > ext_len && !strcmp(&path[len - ext_len], ext)) {
+      len -= ext_len;
+      break;
+    }
+  }
   if (len > target_len) {
     char *str = &path[len - target_len];
-    if (!strcmp(str, LOGFILE_ROLLED_EXTENSION)) {
+    if (!strncmp(str, LOGFILE_ROLLED_EXTENSION, target_len)) {
       return true;
     }
   }
@@ -0,0 +1,165 @@
+/** @file
+
+  CRC32C (Castagnoli) checksums.
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ */
+
+#include <array>
+#include <cstring>
+
+#include "tscore/CRC32C.h"
+
+#if defined(__x86_64__)
+#include <nmmintrin.h>
+#elif defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)
+#include <arm_acle.h>
+#endif
+
+namespace
+{
+constexpr uint32_t POLY = 0x82F63B78; // The reflected Castagnoli polynomial.
+
+using Table = std::array<std::array<uint32_t, 256>, 8>;
+
+/// The tables of slicing by 8, @c TABLE[k][b] is the CRC of byte @a b followed by @a k zero bytes.
+constexpr Table
+make_table()
+{
+  Table t{};
+  for (uint32_t b = 0; b < 256; ++b) {
+    uint32_t crc = b;
+    for (int i = 0; i < 8; ++i) {
+      crc = (crc >> 1) ^ (POLY & (0 - (crc & 1)));
+    }
+    t[0][b] = crc;
+  }
+  for (uint32_t b = 0; b < 256; ++b) {
+    for (int k = 1; k < 8; ++k) {
+      t[k][b] = (t[k - 1][b] >> 8) ^ t[0][t[k - 1][b] & 0xFF];
+    }
+  }
+  return t;
+}
+
+constexpr Table TABLE = make_table();
+
+uint32_t
+crc32c_table(uint32_t crc, const uint8_t *p, size_t n)
+{
+  for (; n >= 8; n -= 8, p += 8) {
+    uint32_t lo;
+    uint32_t hi;
+    memcpy(&lo, p, 4);
+    memcpy(&hi, p + 4, 4);
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    lo = __builtin_bswap32(lo);
+    hi = __builtin_bswap32(hi);
+#endif
+    lo ^= crc;
+    crc = TABLE[7][lo & 0xFF] ^ TABLE[6][(lo >> 8) & 0xFF] ^ TABLE[5][(lo >> 16) & 0xFF] ^ TABLE[4][lo >> 24] ^
+          TABLE[3][hi & 0xFF] ^ TABLE[2][(hi >> 8) & 0xFF] ^ TABLE[1][(hi >> 16) & 0xFF] ^ TABLE[0][hi >> 24];
+  }
+  for (; n > 0; --n) {
+    crc = (crc >> 8) ^ TABLE[0][(crc ^ *p++) & 0xFF];
+  }
+  return crc;
+}
+
+#if defined(__x86_64__)
+__attribute__((target("sse4.2"))) uint32_t
+crc32c_hw(uint32_t crc, const uint8_t *p, size_t n)
+{
+  uint64_t crc64 = crc;
+  for (; n >= 8; n -= 8, p += 8) {
+    uint64_t v;
+    memcpy(&v, p, 8);
+    crc64 = _mm_crc32_u64(crc64, v);
+  }
+  crc = static_cast<uint32_t>(crc64);
+  for (; n > 0; --n) {
+    crc = _mm_crc32_u8(crc, *p++);
+  }
+  return crc;
+}
+
+bool
+have_hw()
+{
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("sse4.2");
+}
+#elif defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)
+uint32_t
+crc32c_hw(uint32_t crc, const uint8_t *p, size_t n)
+{
+  for (; n >= 8; n -= 8, p += 8) {
+    uint64_t v;
+    memcpy(&v, p, 8);
+    crc = __crc32cd(crc, v);
+  }
+  for (; n > 0; --n) {
+    crc = __crc32cb(crc, *p++);
+  }
+  return crc;
+}
+
+bool
+have_hw()
+{
+  return true;
+}
+#else
+uint32_t
+crc32c_hw(uint32_t crc, const uint8_t *p, size_t n)
+{
+  return crc32c_table(crc, p, n);
+}
+
+bool
+have_hw()
+{
+  return false;
+}
+#endif
+
+const bool HW = have_hw();
+} // namespace
+
+namespace ts
+{
+uint32_t
+crc32c(const void *data, size_t length, uint32_t crc)
+{
+  const uint8_t *p = static_cast<const uint8_t *>(data);
+  return ~(HW ? crc32c_hw(~crc, p, length) : crc32c_table(~crc, p, length));
+}
+
+uint32_t
+crc32c_portable(const void *data, size_t length, uint32_t crc)
+{
+  return ~crc32c_table(~crc, static_cast<const uint8_t *>(data), length);
+}
+
+bool
+crc32c_hardware()
+{
+  return HW;
+}
+} // namespace ts
@@ -20,6 +20,7 @@
  */
 
 #include "tscore/ConsistentHash.h"
+#include <algorithm>
 #include <cstring>
 #include <string>
 #include <sstream>
@@ -43,6 +44,8 @@ ATSConsistentHash::insert(ATSConsistentHashNode *node, float weight, ATSHash64 *
   ATSHash64 *thash;
   std::ostringstream string_stream;
   std::string std_string;
+  std::vector<std::pair<uint64_t, ATSConsistentHashNode *>> points;
+  auto by_key = [](auto const &a, auto const &b) { return a.first < b.first; };
 
   if (h) {
     thash = h;
@@ -60,9 +63,50 @@ ATSConsistentHash::insert(ATSConsistentHashNode *node, float weight, ATSHash64 *
     thash->update(numstr, strlen(numstr));
     thash->update(std_string.c_str(), strlen(std_string.c_str()));
     thash->final();
-    NodeMap.insert(std::pair<uint64_t, ATSConsistentHashNode *>(thash->get(), node));
+    points.emplace_back(thash->get(), node);
     thash->clear();
   }
+
+  // Merge the sorted points of the node after those of the ring. As with a map, the first node
+  // inserted at a point keeps it: the sort and the merge are stable and only the first of equal
+  // points is kept.
+  std::stable_sort(points.begin(), points.end(), by_key);
+
+  std::vector<std::pair<uint64_t, ATSConsistentHashNode *>> ring;
+  ring.reserve(keys.size() + points.size());
+  for (size_t n = 0; n < keys.size(); n++) {
+    ring.emplace_back(keys[n], nodes[n]);
+  }
+  ring.insert(ring.end(), points.begin(), points.end());
+  std::inplace_merge(ring.begin(), ring.begin() + keys.size(), ring.end(), by_key);
+  ring.erase(std::unique(ring.begin(), ring.end(), [](auto const &a, auto const &b) { return a.first == b.first; }), ring.end());
+
+  keys.resize(ring.size());
+  nodes.resize(ring.size());
+  for (size_t n = 0; n < ring.size(); n++) {
+    keys[n]  = ring[n].first;
+    nodes[n] = ring[n].second;
+  }
+}
+
+size_t
+ATSConsistentHash::lower_bound(uint64_t hashval) const
+{
+  const uint64_t *base = keys.data();
+  size_t len           = keys.size();
+
+  if (len == 0) {
+    return 0;
+  }
+
+  // Halve the range without a branch on the comparison, the compiler makes it a conditional move.
+  while (len > 1) {
+    size_t half = len / 2;
+    base += (base[half - 1] < hashval) ? half : 0;
+    len -= half;
+  }
+
+  return (base - keys.data()) + (*base < hashval);
 }
 
 ATSConsistentHashNode *
@@ -99,26 +143,26 @@ ATSConsistentHash::lookup(const char *url, ATSConsistentHashIter *i, bool *w, AT
     url_hash = thash->get();
     thash->clear();
 
-    *iter = NodeMap.lower_bound(url_hash);
+    *iter = lower_bound(url_hash);
 
-    if (*iter == NodeMap.end()) {
+    if (*iter == keys.size()) {
       *wptr = true;
-      *iter = NodeMap.begin();
+      *iter = 0;
     }
   } else {
     (*iter)++;
   }
 
-  if (!(*wptr) && *iter == NodeMap.end()) {
+  if (!(*wptr) && *iter >= keys.size()) {
     *wptr = true;
-    *iter = NodeMap.begin();
+    *iter = 0;
   }
 
-  if (*wptr && *iter == NodeMap.end()) {
+  if (*wptr && *iter >= keys.size()) {
     return nullptr;
   }
 
-  return (*iter)->second;
+  return nodes[*iter];
 }
 
 ATSConsistentHashNode *
@@ -149,32 +193,36 @@ ATSConsistentHash::lookup_available(const char *url, ATSConsistentHashIter *i, b
     iter = &NodeMapIterUp;
   }
 
+  if (keys.empty()) {
+    return nullptr;
+  }
+
   if (url) {
     thash->update(url, strlen(url));
     thash->final();
     url_hash = thash->get();
     thash->clear();
 
-    *iter = NodeMap.lower_bound(url_hash);
+    *iter = lower_bound(url_hash);
   }
 
-  if (*iter == NodeMap.end()) {
+  if (*iter >= keys.size()) {
     *wptr = true;
-    *iter = NodeMap.begin();
+    *iter = 0;
   }
 
-  while (!(*iter)->second->available) {
+  while (!nodes[*iter]->available) {
     (*iter)++;
 
-    if (!(*wptr) && *iter == NodeMap.end()) {
+    if (!(*wptr) && *iter == keys.size()) {
       *wptr = true;
-      *iter = NodeMap.begin();
-    } else if (*wptr && *iter == NodeMap.end()) {
+      *iter = 0;
+    } else if (*wptr && *iter == keys.size()) {
       return nullptr;
     }
   }
 
-  return (*iter)->second;
+  return nodes[*iter];
 }
 
 ATSConsistentHashNode *
@@ -195,14 +243,18 @@ ATSConsistentHash::lookup_by_hashval(uint64_t hashval, ATSConsistentHashIter *i,
     iter = &NodeMapIterUp;
   }
 
-  *iter = NodeMap.lower_bound(hashval);
+  if (keys.empty()) {
+    return nullptr;
+  }
+
+  *iter = lower_bound(hashval);
 
-  if (*iter == NodeMap.end()) {
+  if (*iter == keys.size()) {
     *wptr = true;
-    *iter = NodeMap.begin();
+    *iter = 0;
   }
 
-  return (*iter)->second;
+  return nodes[*iter];
 }
 
 ATSConsistentHash::~ATSConsistentHash()
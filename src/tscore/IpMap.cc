@@ -47,6 +47,8 @@
 #include "tscore/ink_inet.h"
 #include "tscore/BufferWriter.h"
 
+#include <vector>
+
 namespace ts
 {
 namespace detail
@@ -1104,6 +1106,74 @@ namespace detail
   {
     friend class ::IpMap;
   };
+
+  /** The ranges of an @c IpMap in sorted arrays.
+
+      The minimums of the ranges are kept apart from the rest so that the search only touches them,
+      the ranges are disjoint and so sorted by their minimum as well as their maximum.
+  */
+  struct IpMapFlat {
+    /// An IPv6 address as two integers in host order, which compare as the address does.
+    struct Ip6Key {
+      uint64_t _hi;
+      uint64_t _lo;
+
+      explicit Ip6Key(in6_addr const &addr)
+      {
+        _hi = _lo = 0;
+        for (int i = 0; i < 8; ++i) {
+          _hi = (_hi << 8) | addr.s6_addr[i];
+          _lo = (_lo << 8) | addr.s6_addr[i + 8];
+        }
+      }
+
+      bool
+      operator<=(Ip6Key const &that) const
+      {
+        return _hi < that._hi || (_hi == that._hi && _lo <= that._lo);
+      }
+    };
+
+    template <typename K> struct Table {
+      std::vector<K> _min;
+      std::vector<K> _max;
+      std::vector<void *> _data;
+
+      void
+      push_back(K const &min, K const &max, void *data)
+      {
+        _min.push_back(min);
+        _max.push_back(max);
+        _data.push_back(data);
+      }
+
+      bool
+      contains(K const &target, void **ptr) const
+      {
+        size_t n = _min.size();
+        if (n == 0) {
+          return false;
+        }
+        // Find the last range that starts at or before @a target, without branches to mispredict.
+        size_t base = 0;
+        while (n > 1) {
+          size_t half = n / 2;
+          base        = (_min[base + half] <= target) ? base + half : base;
+          n -= half;
+        }
+        if (!(_min[base] <= target && target <= _max[base])) {
+          return false;
+        }
+        if (ptr) {
+          *ptr = _data[base];
+        }
+        return true;
+      }
+    };
+
+    Table<in_addr_t> _v4; ///< Host order.
+    Table<Ip6Key> _v6;
+  };
 } // namespace detail
 
 template <typename N>
@@ -1115,10 +1185,11 @@ bwformat(BufferWriter &w, BWFSpec const &spec, detail::IpMapBase<N> const &map)
 
 } // namespace ts
 //----------------------------------------------------------------------------
-IpMap::IpMap(IpMap::self_type &&that) noexcept : _m4(that._m4), _m6(that._m6)
+IpMap::IpMap(IpMap::self_type &&that) noexcept : _m4(that._m4), _m6(that._m6), _flat(that._flat)
 {
-  that._m4 = nullptr;
-  that._m6 = nullptr;
+  that._m4   = nullptr;
+  that._m6   = nullptr;
+  that._flat = nullptr;
 }
 
 IpMap::self_type &
@@ -1128,6 +1199,7 @@ IpMap::operator=(IpMap::self_type &&that)
     this->clear();
     std::swap(_m4, that._m4);
     std::swap(_m6, that._m6);
+    std::swap(_flat, that._flat);
   }
   return *this;
 }
@@ -1136,6 +1208,14 @@ IpMap::~IpMap()
 {
   delete _m4;
   delete _m6;
+  delete _flat;
+}
+
+inline void
+IpMap::thaw()
+{
+  delete _flat;
+  _flat = nullptr;
 }
 
 inline ts::detail::Ip4Map *
@@ -1161,9 +1241,17 @@ IpMap::contains(sockaddr const *target, void **ptr) const
 {
   bool zret = false;
   if (AF_INET == target->sa_family) {
-    zret = _m4 && _m4->contains(ntohl(ats_ip4_addr_cast(target)), ptr);
+    if (_flat) {
+      zret = _flat->_v4.contains(ntohl(ats_ip4_addr_cast(target)), ptr);
+    } else {
+      zret = _m4 && _m4->contains(ntohl(ats_ip4_addr_cast(target)), ptr);
+    }
   } else if (AF_INET6 == target->sa_family) {
-    zret = _m6 && _m6->contains(ats_ip6_cast(target), ptr);
+    if (_flat) {
+      zret = _flat->_v6.contains(ts::detail::IpMapFlat::Ip6Key(ats_ip6_addr_cast(target)), ptr);
+    } else {
+      zret = _m6 && _m6->contains(ats_ip6_cast(target), ptr);
+    }
   }
   return zret;
 }
@@ -1171,12 +1259,16 @@ IpMap::contains(sockaddr const *target, void **ptr) const
 bool
 IpMap::contains(in_addr_t target, void **ptr) const
 {
+  if (_flat) {
+    return _flat->_v4.contains(ntohl(target), ptr);
+  }
   return _m4 && _m4->contains(ntohl(target), ptr);
 }
 
 IpMap &
 IpMap::mark(sockaddr const *min, sockaddr const *max, void *data)
 {
+  this->thaw();
   ink_assert(min->sa_family == max->sa_family);
   if (AF_INET == min->sa_family) {
     this->force4()->mark(ntohl(ats_ip4_addr_cast(min)), ntohl(ats_ip4_addr_cast(max)), data);
@@ -1189,6 +1281,7 @@ IpMap::mark(sockaddr const *min, sockaddr const *max, void *data)
 IpMap &
 IpMap::mark(in_addr_t min, in_addr_t max, void *data)
 {
+  this->thaw();
   this->force4()->mark(ntohl(min), ntohl(max), data);
   return *this;
 }
@@ -1196,6 +1289,7 @@ IpMap::mark(in_addr_t min, in_addr_t max, void *data)
 IpMap &
 IpMap::unmark(sockaddr const *min, sockaddr const *max)
 {
+  this->thaw();
   ink_assert(min->sa_family == max->sa_family);
   if (AF_INET == min->sa_family) {
     if (_m4) {
@@ -1212,6 +1306,7 @@ IpMap::unmark(sockaddr const *min, sockaddr const *max)
 IpMap &
 IpMap::unmark(in_addr_t min, in_addr_t max)
 {
+  this->thaw();
   if (_m4) {
     _m4->unmark(ntohl(min), ntohl(max));
   }
@@ -1221,6 +1316,7 @@ IpMap::unmark(in_addr_t min, in_addr_t max)
 IpMap &
 IpMap::fill(sockaddr const *min, sockaddr const *max, void *data)
 {
+  this->thaw();
   ink_assert(min->sa_family == max->sa_family);
   if (AF_INET == min->sa_family) {
     this->force4()->fill(ntohl(ats_ip4_addr_cast(min)), ntohl(ats_ip4_addr_cast(max)), data);
@@ -1233,6 +1329,7 @@ IpMap::fill(sockaddr const *min, sockaddr const *max, void *data)
 IpMap &
 IpMap::fill(in_addr_t min, in_addr_t max, void *data)
 {
+  this->thaw();
   this->force4()->fill(ntohl(min), ntohl(max), data);
   return *this;
 }
@@ -1253,6 +1350,7 @@ IpMap::count() const
 IpMap &
 IpMap::clear()
 {
+  this->thaw();
   if (_m4) {
     _m4->clear();
   }
@@ -1262,6 +1360,22 @@ IpMap::clear()
   return *this;
 }
 
+IpMap &
+IpMap::freeze()
+{
+  this->thaw();
+  _flat = new ts::detail::IpMapFlat;
+  for (auto &node : *this) {
+    if (AF_INET == node.min()->sa_family) {
+      _flat->_v4.push_back(ntohl(ats_ip4_addr_cast(node.min())), ntohl(ats_ip4_addr_cast(node.max())), node.data());
+    } else {
+      _flat->_v6.push_back(ts::detail::IpMapFlat::Ip6Key(ats_ip6_addr_cast(node.min())),
+                           ts::detail::IpMapFlat::Ip6Key(ats_ip6_addr_cast(node.max())), node.data());
+    }
+  }
+  return *this;
+}
+
 IpMap::iterator
 IpMap::begin() const
 {
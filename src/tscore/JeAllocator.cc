@@ -23,6 +23,7 @@
 #include "tscore/ink_error.h"
 #include "tscore/ink_assert.h"
 #include "tscore/ink_align.h"
+#include "tscore/hugepages.h"
 #include "tscore/JeAllocator.h"
 
 namespace jearena
@@ -146,4 +147,124 @@ globalJemallocNodumpAllocator()
   static auto instance = new JemallocNodumpAllocator();
   return *instance;
 }
+
+#ifdef JEMALLOC_FREELIST_ALLOCATOR_SUPPORTED
+
+int JemallocFreelistAllocator::count_ = 0;
+thread_local int JemallocFreelistAllocator::tcaches_[MAX_ALLOCATORS];
+
+void *
+JemallocFreelistAllocator::alloc(extent_hooks_t *extent, void *new_addr, size_t size, size_t alignment, bool *zero, bool *commit,
+                                 unsigned arena_ind)
+{
+  Hooks *hooks = reinterpret_cast<Hooks *>(extent);
+  void *result = hooks->original_alloc(extent, new_addr, size, alignment, zero, commit, arena_ind);
+
+  if (result != nullptr) {
+    // Both advices stay on the mapping when jemalloc purges its pages.
+#ifdef MADV_HUGEPAGE
+    if (ats_hugepage_enabled()) {
+      ats_madvise((caddr_t)result, size, MADV_HUGEPAGE);
+    }
+#endif
+#ifdef MADV_DONTDUMP
+    if (hooks->dontdump) {
+      ats_madvise((caddr_t)result, size, MADV_DONTDUMP);
+    }
+#endif
+  }
+
+  return result;
+}
+
+JemallocFreelistAllocator::JemallocFreelistAllocator(bool dontdump)
+{
+  index_ = count_++;
+  ink_release_assert(index_ < MAX_ALLOCATORS);
+
+  size_t arena_index_len_ = sizeof(arena_index_);
+  if (auto ret = mallctl("arenas.create", &arena_index_, &arena_index_len_, nullptr, 0)) {
+    ink_abort("Unable to extend arena: %s", std::strerror(ret));
+  }
+
+  // Read the existing hooks
+  const auto key = "arena." + std::to_string(arena_index_) + ".extent_hooks";
+  extent_hooks_t *hooks;
+  size_t hooks_len = sizeof(hooks);
+  if (auto ret = mallctl(key.c_str(), &hooks, &hooks_len, nullptr, 0)) {
+    ink_abort("Unable to get the hooks: %s", std::strerror(ret));
+  }
+
+  // Set the custom hook, the others are the original ones so that the purging works as usual.
+  hooks_.hooks              = *hooks;
+  hooks_.hooks.alloc        = &JemallocFreelistAllocator::alloc;
+  hooks_.original_alloc     = hooks->alloc;
+  hooks_.dontdump           = dontdump;
+  extent_hooks_t *new_hooks = &hooks_.hooks;
+  if (auto ret = mallctl(key.c_str(), nullptr, nullptr, &new_hooks, sizeof(new_hooks))) {
+    ink_abort("Unable to set the hooks: %s", std::strerror(ret));
+  }
+}
+
+int
+JemallocFreelistAllocator::tcache_flags()
+{
+  // The default cache of the thread would hand out memory of the other arenas.
+  int &tcache = tcaches_[index_];
+  if (unlikely(tcache == 0)) {
+    unsigned id;
+    size_t len = sizeof(id);
+    tcache     = mallctl("tcache.create", &id, &len, nullptr, 0) == 0 ? static_cast<int>(id) + 1 : -1;
+  }
+  return tcache > 0 ? MALLOCX_TCACHE(tcache - 1) : MALLOCX_TCACHE_NONE;
+}
+
+void *
+JemallocFreelistAllocator::allocate(InkFreeList *f)
+{
+  int flags = MALLOCX_ARENA(arena_index_) | tcache_flags();
+  if (f->alignment) {
+    flags |= MALLOCX_ALIGN(f->alignment);
+  }
+
+  void *newp = mallocx(f->type_size, flags);
+  if (unlikely(newp == nullptr)) {
+    ink_abort("couldn't allocate %u bytes", f->type_size);
+  }
+  return newp;
+}
+
+void
+JemallocFreelistAllocator::deallocate(InkFreeList * /* f ATS_UNUSED */, void *ptr)
+{
+  if (likely(ptr)) {
+    dallocx(ptr, tcache_flags());
+  }
+}
+
+#else /* JEMALLOC_FREELIST_ALLOCATOR_SUPPORTED */
+
+JemallocFreelistAllocator::JemallocFreelistAllocator(bool /* dontdump ATS_UNUSED */) {}
+
+void *
+JemallocFreelistAllocator::allocate(InkFreeList *f)
+{
+  return ats_memalign(f->alignment, f->type_size);
+}
+
+void
+JemallocFreelistAllocator::deallocate(InkFreeList * /* f ATS_UNUSED */, void *ptr)
+{
+  ats_memalign_free(ptr);
+}
+
+#endif /* JEMALLOC_FREELIST_ALLOCATOR_SUPPORTED */
+
+JemallocFreelistAllocator &
+globalJemallocFreelistAllocator(bool dontdump)
+{
+  static auto dontdump_instance = new JemallocFreelistAllocator(true);
+  static auto instance          = new JemallocFreelistAllocator(false);
+  return dontdump ? *dontdump_instance : *instance;
+}
 } // namespace jearena
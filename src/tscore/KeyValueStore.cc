@@ -0,0 +1,201 @@
+/** @file
+
+  Concurrent key value store with expiration and a memory limit.
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ */
+
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+
+#include "tscore/KeyValueStore.h"
+
+namespace ts
+{
+KeyValueStore::KeyValueStore(size_t max_bytes) : _partition_max(max_bytes / PARTITIONS)
+{
+  // A limit too small for an entry would evict everything, keep at least one entry of each partition.
+  if (max_bytes > 0 && _partition_max == 0) {
+    _partition_max = 1;
+  }
+}
+
+KeyValueStore::Partition &
+KeyValueStore::partition_of(std::string_view key)
+{
+  return _partitions[std::hash<std::string_view>()(key) % PARTITIONS];
+}
+
+KeyValueStore::Map::iterator
+KeyValueStore::find(Partition &p, std::string_view key, time_t now)
+{
+  auto spot = p.map.find(std::string(key));
+  if (spot == p.map.end()) {
+    return spot;
+  }
+  if (spot->second.expires != 0 && spot->second.expires <= now) {
+    erase(p, spot);
+    return p.map.end();
+  }
+  p.lru.splice(p.lru.begin(), p.lru, spot->second.lru);
+  return spot;
+}
+
+KeyValueStore::Map::iterator
+KeyValueStore::insert(Partition &p, std::string_view key)
+{
+  auto spot        = p.map.emplace(std::string(key), Entry()).first;
+  spot->second.lru = p.lru.insert(p.lru.begin(), spot);
+
+  p.bytes += charge(spot->first, spot->second.value);
+  return spot;
+}
+
+void
+KeyValueStore::erase(Partition &p, Map::iterator spot)
+{
+  p.bytes -= charge(spot->first, spot->second.value);
+  p.lru.erase(spot->second.lru);
+  p.map.erase(spot);
+}
+
+void
+KeyValueStore::resize(Partition &p, Map::iterator spot, std::string_view value)
+{
+  p.bytes -= spot->second.value.size();
+  spot->second.value.assign(value.data(), value.size());
+  p.bytes += spot->second.value.size();
+}
+
+void
+KeyValueStore::evict(Partition &p, Map::iterator keep)
+{
+  while (_partition_max != 0 && p.bytes > _partition_max && p.lru.back() != keep) {
+    erase(p, p.lru.back());
+  }
+}
+
+bool
+KeyValueStore::get(std::string_view key, std::string &value, time_t now)
+{
+  Partition &p = partition_of(key);
+  std::lock_guard<std::mutex> lock(p.mutex);
+
+  auto spot = find(p, key, now);
+  if (spot == p.map.end()) {
+    return false;
+  }
+  value = spot->second.value;
+  return true;
+}
+
+void
+KeyValueStore::set(std::string_view key, std::string_view value, time_t expires)
+{
+  Partition &p = partition_of(key);
+  std::lock_guard<std::mutex> lock(p.mutex);
+
+  auto spot = p.map.find(std::string(key));
+  if (spot == p.map.end()) {
+    spot = insert(p, key);
+  } else {
+    p.lru.splice(p.lru.begin(), p.lru, spot->second.lru);
+  }
+  resize(p, spot, value);
+  spot->second.expires = expires;
+  evict(p, spot);
+}
+
+bool
+KeyValueStore::add(std::string_view key, std::string_view value, time_t expires, time_t now)
+{
+  Partition &p = partition_of(key);
+  std::lock_guard<std::mutex> lock(p.mutex);
+
+  if (find(p, key, now) != p.map.end()) {
+    return false;
+  }
+  auto spot = insert(p, key);
+  resize(p, spot, value);
+  spot->second.expires = expires;
+  evict(p, spot);
+  return true;
+}
+
+bool
+KeyValueStore::remove(std::string_view key)
+{
+  Partition &p = partition_of(key);
+  std::lock_guard<std::mutex> lock(p.mutex);
+
+  auto spot = p.map.find(std::string(key));
+  if (spot == p.map.end()) {
+    return false;
+  }
+  erase(p, spot);
+  return true;
+}
+
+int64_t
+KeyValueStore::increment(std::string_view key, int64_t delta, time_t expires, time_t now)
+{
+  Partition &p = partition_of(key);
+  std::lock_guard<std::mutex> lock(p.mutex);
+
+  int64_t n = delta;
+  auto spot = find(p, key, now);
+  if (spot == p.map.end()) {
+    spot                 = insert(p, key);
+    spot->second.expires = expires;
+  } else {
+    n += strtoll(spot->second.value.c_str(), nullptr, 10);
+  }
+
+  char text[24];
+  int len = snprintf(text, sizeof(text), "%" PRId64, n);
+  resize(p, spot, std::string_view(text, len));
+  evict(p, spot);
+  return n;
+}
+
+size_t
+KeyValueStore::count()
+{
+  size_t n = 0;
+  for (auto &p : _partitions) {
+    std::lock_guard<std::mutex> lock(p.mutex);
+    n += p.map.size();
+  }
+  return n;
+}
+
+size_t
+KeyValueStore::bytes()
+{
+  size_t n = 0;
+  for (auto &p : _partitions) {
+    std::lock_guard<std::mutex> lock(p.mutex);
+    n += p.bytes;
+  }
+  return n;
+}
+
+} // namespace ts
@@ -0,0 +1,88 @@
+/** @file
+
+  Match a set of literal strings in one pass over a subject.
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ */
+
+#include <algorithm>
+#include <deque>
+
+#include "tscore/LiteralMatcher.h"
+
+int
+LiteralMatcher::add(std::string_view literal)
+{
+  ink_release_assert(!_compiled);
+  ink_assert(!literal.empty());
+
+  int node = 0;
+  for (char c : literal) {
+    int next = child(node, c);
+    if (next < 0) {
+      next      = static_cast<int>(_nodes.size());
+      auto spot  = std::lower_bound(_nodes[node].edges.begin(), _nodes[node].edges.end(), c,
+                                    [](std::pair<char, int> const &edge, char ch) { return edge.first < ch; });
+      _nodes[node].edges.emplace(spot, c, next);
+      _nodes.emplace_back();
+    }
+    node = next;
+  }
+  if (_nodes[node].output < 0) {
+    _nodes[node].output = _count++;
+  }
+  return _nodes[node].output;
+}
+
+void
+LiteralMatcher::compile()
+{
+  std::deque<int> queue;
+
+  // Breadth first, so the fail node of each node is done before the node.
+  for (auto const &edge : _nodes[0].edges) {
+    _nodes[edge.second].fail = 0;
+    queue.push_back(edge.second);
+  }
+  while (!queue.empty()) {
+    int node = queue.front();
+    queue.pop_front();
+    for (auto const &[c, next] : _nodes[node].edges) {
+      int fail = _nodes[node].fail;
+      int target;
+      while ((target = child(fail, c)) < 0 && fail != 0) {
+        fail = _nodes[fail].fail;
+      }
+      _nodes[next].fail = target < 0 ? 0 : target;
+      int f             = _nodes[next].fail;
+      _nodes[next].dict = _nodes[f].output >= 0 ? f : _nodes[f].dict;
+      queue.push_back(next);
+    }
+  }
+  _compiled = true;
+}
+
+void
+LiteralMatcher::clear()
+{
+  _nodes.clear();
+  _nodes.emplace_back();
+  _count    = 0;
+  _compiled = false;
+}
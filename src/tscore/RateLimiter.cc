@@ -0,0 +1,92 @@
+/** @file
+
+  Token bucket rate limits for many keys at once.
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ */
+
+#include <algorithm>
+#include <functional>
+
+#include "tscore/RateLimiter.h"
+
+namespace ts
+{
+RateLimiter::RateLimiter(double rate, double burst, size_t max_keys)
+  : _rate(rate / 1e9), _burst(std::max(burst, 1.0)), _partition_max(std::max<size_t>(max_keys / PARTITIONS, 1))
+{
+}
+
+double
+RateLimiter::refill(Bucket const &bucket, int64_t now) const
+{
+  return std::min(_burst, bucket.tokens + std::max<int64_t>(now - bucket.updated, 0) * _rate);
+}
+
+void
+RateLimiter::sweep(Partition &p, int64_t now)
+{
+  for (auto spot = p.buckets.begin(); spot != p.buckets.end();) {
+    if (refill(spot->second, now) >= _burst) {
+      spot = p.buckets.erase(spot);
+    } else {
+      ++spot;
+    }
+  }
+}
+
+bool
+RateLimiter::admit(std::string_view key, int64_t now)
+{
+  Partition &p = _partitions[std::hash<std::string_view>()(key) % PARTITIONS];
+  std::lock_guard<std::mutex> lock(p.mutex);
+
+  auto spot = p.buckets.find(std::string(key));
+  if (spot == p.buckets.end()) {
+    if (p.buckets.size() >= _partition_max) {
+      sweep(p, now);
+      if (p.buckets.size() >= _partition_max) {
+        return true;
+      }
+    }
+    spot = p.buckets.emplace(std::string(key), Bucket{_burst, now}).first;
+  }
+
+  Bucket &bucket = spot->second;
+  bucket.tokens  = refill(bucket, now);
+  bucket.updated = std::max(bucket.updated, now);
+  if (bucket.tokens < 1.0) {
+    return false;
+  }
+  bucket.tokens -= 1.0;
+  return true;
+}
+
+size_t
+RateLimiter::count()
+{
+  size_t n = 0;
+  for (auto &p : _partitions) {
+    std::lock_guard<std::mutex> lock(p.mutex);
+    n += p.buckets.size();
+  }
+  return n;
+}
+
+} // namespace ts
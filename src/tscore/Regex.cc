@@ -21,7 +21,12 @@
   limitations under the License.
  */
 
+#include <algorithm>
 #include <array>
+#include <cctype>
+#include <cstring>
+#include <mutex>
+#include <unordered_map>
 
 #include "tscore/ink_platform.h"
 #include "tscore/ink_thread.h"
@@ -50,6 +55,55 @@ get_jit_stack(void *data ATS_UNUSED)
 }
 #endif
 
+namespace
+{
+struct RegexCache {
+  std::mutex mutex;
+  std::unordered_map<std::string, std::weak_ptr<Regex>> regexes;
+  size_t sweep_size = 64; ///< Drop the freed patterns when there are this many.
+};
+
+// Never destroyed, the users may be freed after the static destructors run.
+RegexCache &
+regex_cache()
+{
+  static RegexCache *cache = new RegexCache;
+  return *cache;
+}
+} // namespace
+
+std::shared_ptr<Regex>
+Regex::intern(std::string_view pattern, unsigned flags)
+{
+  std::string key{pattern};
+  key += '\0';
+  key += std::to_string(flags);
+
+  RegexCache &cache = regex_cache();
+  std::lock_guard<std::mutex> lock(cache.mutex);
+
+  if (auto spot = cache.regexes.find(key); spot != cache.regexes.end()) {
+    if (auto regex = spot->second.lock()) {
+      return regex;
+    }
+  }
+
+  auto regex = std::make_shared<Regex>();
+  if (!regex->compile(std::string{pattern}.c_str(), flags)) {
+    return nullptr;
+  }
+  cache.regexes[key] = regex;
+
+  if (cache.regexes.size() >= cache.sweep_size) {
+    for (auto spot = cache.regexes.begin(); spot != cache.regexes.end();) {
+      spot = spot->second.expired() ? cache.regexes.erase(spot) : std::next(spot);
+    }
+    cache.sweep_size = std::max<size_t>(64, 2 * cache.regexes.size());
+  }
+
+  return regex;
+}
+
 Regex::Regex(Regex &&that) noexcept : regex(that.regex), regex_extra(that.regex_extra)
 {
   that.regex       = nullptr;
@@ -108,6 +162,144 @@ Regex::get_capture_count()
   return captures;
 }
 
+std::string
+Regex::required_literal(std::string_view pattern)
+{
+  // Escapes of a class or an assertion, which match no particular character.
+  static constexpr char const CLASS_ESCAPES[] = "dDwWsShHvVRbBAzZG";
+
+  std::string best;
+  std::string run;           // The literal characters since the last thing that was not one.
+  bool last_literal = false; // The last atom is the last character of @a run.
+  bool atom         = false; // There is an atom a quantifier would apply to.
+  int depth         = 0;     // Nothing in a group is taken, a group may be optional or alternated.
+  size_t const n    = pattern.size();
+
+  auto end_run = [&]() -> void {
+    if (run.size() > best.size()) {
+      best = run;
+    }
+    run.clear();
+    last_literal = false;
+  };
+
+  for (size_t i = 0; i < n; ++i) {
+    char c       = pattern[i];
+    bool literal = false;
+
+    if (c == '\\') {
+      if (++i == n) {
+        return {};
+      }
+      c = pattern[i];
+      if (!isalnum(static_cast<unsigned char>(c))) {
+        literal = true;
+      } else if (strchr(CLASS_ESCAPES, c) == nullptr) {
+        return {}; // Back references, code points, quoting and the like.
+      }
+    } else if (c == '[') {
+      size_t j = i + 1;
+      if (j < n && pattern[j] == '^') {
+        ++j;
+      }
+      if (j < n && pattern[j] == ']') {
+        ++j;
+      }
+      for (; j < n && pattern[j] != ']'; ++j) {
+        if (pattern[j] == '\\') {
+          ++j;
+        } else if (pattern[j] == '[' && j + 1 < n && pattern[j + 1] == ':') {
+          size_t close = pattern.find(":]", j + 2);
+          if (close == std::string_view::npos) {
+            return {};
+          }
+          j = close + 1;
+        }
+      }
+      if (j >= n) {
+        return {};
+      }
+      i = j;
+    } else if (c == '(') {
+      if (i + 1 < n && pattern[i + 1] == '?') {
+        if (i + 2 >= n || pattern[i + 2] != ':') {
+          return {}; // Options or assertions, which may change what the rest matches.
+        }
+        i += 2;
+      }
+      if (depth++ == 0) {
+        end_run();
+      }
+      atom = false;
+      continue;
+    } else if (c == ')') {
+      if (depth == 0) {
+        return {};
+      }
+      atom = --depth == 0;
+      continue;
+    } else if (c == '|') {
+      if (depth == 0) {
+        return {}; // Nothing is required of every alternative.
+      }
+      continue;
+    } else if (c == '*' || c == '+' || c == '?' || c == '{') {
+      bool optional = c != '+';
+      if (c == '{') {
+        size_t j = i + 1;
+        int min  = 0;
+        for (; j < n && isdigit(static_cast<unsigned char>(pattern[j])); ++j) {
+          min = std::min(min * 10 + (pattern[j] - '0'), 1000);
+        }
+        if (j == i + 1) {
+          return {};
+        }
+        for (; j < n && (pattern[j] == ',' || isdigit(static_cast<unsigned char>(pattern[j]))); ++j) {
+        }
+        if (j >= n || pattern[j] != '}') {
+          return {};
+        }
+        optional = min == 0;
+        i        = j;
+      }
+      if (i + 1 < n && (pattern[i + 1] == '?' || pattern[i + 1] == '+')) {
+        ++i; // Lazy or possessive, which does not change what must match.
+      }
+      if (depth > 0) {
+        continue;
+      }
+      if (!atom) {
+        return {};
+      }
+      if (last_literal && optional) {
+        run.pop_back();
+      }
+      end_run();
+      atom = false;
+      continue;
+    } else if (c != '.' && c != '^' && c != '$') {
+      literal = true;
+    }
+
+    if (depth > 0) {
+      continue;
+    }
+    if (literal) {
+      run += c;
+      last_literal = true;
+    } else {
+      end_run();
+    }
+    atom = literal || (c != '^' && c != '$');
+  }
+
+  if (depth != 0) {
+    return {};
+  }
+  end_run();
+  return best;
+}
+
 bool
 Regex::exec(std::string_view const &str)
 {
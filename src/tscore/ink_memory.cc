@@ -38,8 +38,171 @@
 #define _XOPEN_SOURCE 600
 #endif
 #endif
+#include <atomic>
+#include <climits>
 #include <cstdlib>
 #include <cstring>
+#include <mutex>
+#include <new>
+
+#if TS_HAS_JEMALLOC && JEMALLOC_VERSION_MAJOR >= 5
+#define ATS_MEM_TAG_ARENAS 1
+#endif
+
+thread_local AtsMemTag ats_mem_tag = ATS_MEM_TAG_OTHER;
+
+namespace
+{
+const char *const mem_tag_names[ATS_MEM_TAG_COUNT] = {"other", "cache", "hostdb", "ssl", "hdrs", "logging", "plugin"};
+
+// The counters of one thread, only written by that thread. They are never freed, so that an allocation
+// made while the thread exits still has somewhere to go, and the totals are kept after the thread is gone.
+struct MemTagCounters {
+  std::atomic<int64_t> allocated[ATS_MEM_TAG_COUNT] = {};
+  MemTagCounters *next                              = nullptr;
+};
+
+std::mutex mem_tag_mutex;
+MemTagCounters *mem_tag_threads; // Guarded by @a mem_tag_mutex.
+thread_local MemTagCounters *mem_tag_counters;
+
+inline void
+mem_tag_account(AtsMemTag tag, size_t size)
+{
+  MemTagCounters *c = mem_tag_counters;
+  if (unlikely(c == nullptr)) {
+    // Plain calloc, as this is in the middle of an allocation already.
+    void *mem = calloc(1, sizeof(MemTagCounters));
+    if (mem == nullptr) {
+      return;
+    }
+    c = new (mem) MemTagCounters;
+    std::lock_guard<std::mutex> lock(mem_tag_mutex);
+    c->next          = mem_tag_threads;
+    mem_tag_threads  = c;
+    mem_tag_counters = c;
+  }
+  // Only this thread writes it, the readers don't need more than the store to be atomic.
+  c->allocated[tag].store(c->allocated[tag].load(std::memory_order_relaxed) + size, std::memory_order_relaxed);
+}
+
+#if ATS_MEM_TAG_ARENAS
+// The arena of each tag, 0 until it is created and UINT_MAX if that failed, arena 0 is never one of ours.
+std::atomic<unsigned> mem_tag_arenas[ATS_MEM_TAG_COUNT];
+// The cache of this thread for each arena, plus one, and -1 if it could not be created.
+thread_local int mem_tag_tcaches[ATS_MEM_TAG_COUNT];
+
+// The mallocx() flags for the arena of @a tag, 0 for the default arenas.
+int
+mem_tag_flags(AtsMemTag tag)
+{
+  if (tag == ATS_MEM_TAG_OTHER) {
+    return 0;
+  }
+
+  unsigned arena = mem_tag_arenas[tag].load(std::memory_order_acquire);
+  if (unlikely(arena == 0)) {
+    std::lock_guard<std::mutex> lock(mem_tag_mutex);
+    arena = mem_tag_arenas[tag].load(std::memory_order_relaxed);
+    if (arena == 0) {
+      size_t len = sizeof(arena);
+      if (mallctl("arenas.create", &arena, &len, nullptr, 0) != 0) {
+        arena = UINT_MAX;
+      }
+      mem_tag_arenas[tag].store(arena, std::memory_order_release);
+    }
+  }
+  if (arena == UINT_MAX) {
+    return 0;
+  }
+
+  // A thread cache of its own for the arena, the default one would mix the arenas up.
+  int &tcache = mem_tag_tcaches[tag];
+  if (unlikely(tcache == 0)) {
+    unsigned id;
+    size_t len = sizeof(id);
+    tcache     = mallctl("tcache.create", &id, &len, nullptr, 0) == 0 ? static_cast<int>(id) + 1 : -1;
+  }
+  return MALLOCX_ARENA(arena) | (tcache > 0 ? MALLOCX_TCACHE(tcache - 1) : MALLOCX_TCACHE_NONE);
+}
+#endif
+
+// Allocate @a size bytes for the current tag, @a alignment is 0 for the default one.
+inline void *
+mem_tag_alloc(size_t size, size_t alignment, bool zero)
+{
+  AtsMemTag tag = ats_mem_tag;
+  mem_tag_account(tag, size);
+#if ATS_MEM_TAG_ARENAS
+  // An alignment that isn't a power of two is left to posix_memalign() to reject.
+  if (int flags = mem_tag_flags(tag); flags != 0 && (alignment & (alignment - 1)) == 0) {
+    flags     |= (zero ? MALLOCX_ZERO : 0) | (alignment ? MALLOCX_ALIGN(alignment) : 0);
+    void *ptr  = mallocx(size, flags);
+    errno      = ptr ? errno : ENOMEM;
+    return ptr;
+  }
+#endif
+  if (alignment) {
+    void *ptr   = nullptr;
+    int retcode = posix_memalign(&ptr, alignment, size);
+    errno       = retcode;
+    return retcode ? nullptr : ptr;
+  }
+  return zero ? calloc(1, size) : malloc(size);
+}
+} // namespace
+
+const char *
+ats_mem_tag_name(AtsMemTag tag)
+{
+  return mem_tag_names[tag];
+}
+
+int64_t
+ats_mem_tag_allocated(AtsMemTag tag)
+{
+  int64_t total = 0;
+  std::lock_guard<std::mutex> lock(mem_tag_mutex);
+  for (MemTagCounters *c = mem_tag_threads; c != nullptr; c = c->next) {
+    total += c->allocated[tag].load(std::memory_order_relaxed);
+  }
+  return total;
+}
+
+int64_t
+ats_mem_tag_in_use(AtsMemTag tag)
+{
+#if ATS_MEM_TAG_ARENAS
+  if (tag == ATS_MEM_TAG_OTHER) {
+    return -1;
+  }
+  unsigned arena = mem_tag_arenas[tag].load(std::memory_order_acquire);
+  if (arena == 0 || arena == UINT_MAX) {
+    return 0;
+  }
+
+  // Refresh the statistics of jemalloc, they are only updated by a write of the epoch.
+  uint64_t epoch = 1;
+  size_t len     = sizeof(epoch);
+  mallctl("epoch", &epoch, &len, &epoch, len);
+
+  char name[64];
+  size_t small = 0, large = 0;
+  len = sizeof(size_t);
+  snprintf(name, sizeof(name), "stats.arenas.%u.small.allocated", arena);
+  if (mallctl(name, &small, &len, nullptr, 0) != 0) {
+    return -1;
+  }
+  snprintf(name, sizeof(name), "stats.arenas.%u.large.allocated", arena);
+  if (mallctl(name, &large, &len, nullptr, 0) != 0) {
+    return -1;
+  }
+  return small + large;
+#else
+  (void)tag;
+  return -1;
+#endif
+}
 
 void *
 ats_malloc(size_t size)
@@ -56,7 +219,7 @@ ats_malloc(size_t size)
   // Useful for tracing bad mallocs
   // ink_stack_trace_dump();
   if (likely(size > 0)) {
-    if (unlikely((ptr = malloc(size)) == nullptr)) {
+    if (unlikely((ptr = mem_tag_alloc(size, 0, false)) == nullptr)) {
       ink_abort("couldn't allocate %zu bytes", size);
     }
   }
@@ -66,7 +229,12 @@ ats_malloc(size_t size)
 void *
 ats_calloc(size_t nelem, size_t elsize)
 {
-  void *ptr = calloc(nelem, elsize);
+  void *ptr = nullptr;
+  size_t size;
+  if (likely(!__builtin_mul_overflow(nelem, elsize, &size))) {
+    // calloc() of nothing still gives a pointer to free.
+    ptr = mem_tag_alloc(size ? size : 1, 0, true);
+  }
   if (unlikely(ptr == nullptr)) {
     ink_abort("couldn't allocate %zu %zu byte elements", nelem, elsize);
   }
@@ -76,7 +244,20 @@ ats_calloc(size_t nelem, size_t elsize)
 void *
 ats_realloc(void *ptr, size_t size)
 {
-  void *newptr = realloc(ptr, size);
+  void *newptr;
+  if (ptr == nullptr) {
+    newptr = mem_tag_alloc(size ? size : 1, 0, false);
+  } else {
+    AtsMemTag tag = ats_mem_tag;
+    mem_tag_account(tag, size);
+#if ATS_MEM_TAG_ARENAS
+    // Growing moves the memory to the arena of the current tag, like any other allocation would.
+    int flags = mem_tag_flags(tag);
+    newptr    = flags != 0 && size > 0 ? rallocx(ptr, size, flags) : realloc(ptr, size);
+#else
+    newptr = realloc(ptr, size);
+#endif
+  }
   if (unlikely(newptr == nullptr)) {
     ink_abort("couldn't reallocate %zu bytes", size);
   }
@@ -99,7 +280,8 @@ ats_memalign(size_t alignment, size_t size)
     alignment = PAGE_SIZE;
 #endif
 
-  int retcode = posix_memalign(&ptr, alignment, size);
+  ptr         = mem_tag_alloc(size, alignment, false);
+  int retcode = ptr == nullptr ? (errno ? errno : ENOMEM) : 0;
 
   if (unlikely(retcode)) {
     if (retcode == EINVAL) {
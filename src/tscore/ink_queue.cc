@@ -37,18 +37,23 @@
   ****************************************************************************/
 
 #include "tscore/ink_config.h"
+#include <algorithm>
 #include <cassert>
 #include <memory.h>
 #include <cstdlib>
 #include <unistd.h>
 #include <sys/types.h>
 #include <sys/mman.h>
+#if defined(linux)
+#include <sys/syscall.h>
+#endif
 #include "tscore/ink_atomic.h"
 #include "tscore/ink_queue.h"
 #include "tscore/ink_memory.h"
 #include "tscore/ink_error.h"
 #include "tscore/ink_assert.h"
 #include "tscore/ink_align.h"
+#include "tscore/ink_mutex.h"
 #include "tscore/hugepages.h"
 #include "tscore/Diags.h"
 #include "tscore/JeAllocator.h"
@@ -87,12 +92,28 @@ static void *malloc_new(InkFreeList *f);
 static void malloc_free(InkFreeList *f, void *item);
 static void malloc_bulkfree(InkFreeList *f, void *head, void *tail, size_t num_item);
 
+static void *magazine_new(InkFreeList *f);
+static void magazine_free(InkFreeList *f, void *item);
+static void magazine_bulkfree(InkFreeList *f, void *head, void *tail, size_t num_item);
+
+static void *jemalloc_new(InkFreeList *f);
+static void jemalloc_free(InkFreeList *f, void *item);
+static void jemalloc_bulkfree(InkFreeList *f, void *head, void *tail, size_t num_item);
+
 static const ink_freelist_ops malloc_ops   = {malloc_new, malloc_free, malloc_bulkfree};
 static const ink_freelist_ops freelist_ops = {freelist_new, freelist_free, freelist_bulkfree};
+static const ink_freelist_ops magazine_ops = {magazine_new, magazine_free, magazine_bulkfree};
+static const ink_freelist_ops jemalloc_ops = {jemalloc_new, jemalloc_free, jemalloc_bulkfree};
+#if TS_USE_JEMALLOC_FREELISTS
+static const ink_freelist_ops *default_ops = &jemalloc_ops;
+#else
 static const ink_freelist_ops *default_ops = &freelist_ops;
+#endif
 
 static ink_freelist_list *freelists                = nullptr;
 static const ink_freelist_ops *freelist_global_ops = default_ops;
+static uint32_t freelist_count                     = 0;
+static bool freelist_count_allocs                  = false;
 
 const InkFreeListOps *
 ink_freelist_malloc_ops()
@@ -113,7 +134,251 @@ ink_freelist_init_ops(int nofl_class, int nofl_proxy)
   // allocated from the freelist are freed by malloc.
   ink_release_assert(freelist_global_ops == default_ops);
 
-  freelist_global_ops = (nofl_class || nofl_proxy) ? ink_freelist_malloc_ops() : ink_freelist_freelist_ops();
+  freelist_global_ops = (nofl_class || nofl_proxy) ? ink_freelist_malloc_ops() : default_ops;
+}
+
+/*
+ * Magazines
+ *
+ * With magazines enabled each thread keeps up to two magazines worth of free items per freelist and
+ * only trades whole magazines with a depot, a small mutex protected stack of full magazines per
+ * NUMA node. The global lock free list is only touched when a depot runs empty or over, so the CAS
+ * on its head, and the cache line it lives on, stops bouncing between sockets.
+ *
+ * Items in thread caches and in flight count as used, f->used only changes when a magazine moves
+ * between a thread and the depot or the global list.
+ */
+
+#define MAGAZINE_MAX_NODES 8
+#define MAGAZINE_DEPOT_SIZE 16
+
+struct InkMagazine {
+  void *head;
+  void *tail;
+};
+
+struct _InkMagazineDepot {
+  struct Node {
+    ink_mutex lock;
+    int count;
+    InkMagazine full[MAGAZINE_DEPOT_SIZE];
+  } node[MAGAZINE_MAX_NODES];
+};
+
+struct InkThreadMagazine {
+  InkFreeList *fl;
+  void *head;
+  uint32_t count;
+};
+
+static uint32_t magazine_size = 0;
+
+// The free items of one thread, returned to the global lists when the thread exits.
+struct InkThreadMagazines {
+  InkThreadMagazine *mag = nullptr;
+  uint32_t n             = 0;
+  int node               = -1;
+
+  ~InkThreadMagazines();
+};
+
+static thread_local InkThreadMagazines thread_magazines;
+
+void
+ink_freelist_init_magazines(uint32_t size)
+{
+  // Items move freely between the freelist and the magazines, so unlike the ops this can be enabled at any time.
+  if (size == 0 || freelist_global_ops != &freelist_ops) {
+    return;
+  }
+  magazine_size       = size;
+  freelist_global_ops = &magazine_ops;
+  Debug(DEBUG_TAG "_init", "magazines of %" PRIu32 " items", size);
+}
+
+// Threads bound to a node say so, others are placed by the CPU they first allocate on.
+void
+ink_freelist_set_thread_node(int node)
+{
+  thread_magazines.node = node % MAGAZINE_MAX_NODES;
+}
+
+static int
+magazine_node()
+{
+  if (unlikely(thread_magazines.node < 0)) {
+    unsigned cpu = 0, node = 0;
+#if defined(linux) && defined(SYS_getcpu)
+    if (syscall(SYS_getcpu, &cpu, &node, nullptr) != 0) {
+      node = 0;
+    }
+#endif
+    thread_magazines.node = node % MAGAZINE_MAX_NODES;
+  }
+  return thread_magazines.node;
+}
+
+static InkThreadMagazine *
+thread_magazine(InkFreeList *f)
+{
+  InkThreadMagazines &tm = thread_magazines;
+  if (unlikely(f->id >= tm.n)) {
+    uint32_t n = std::max(f->id + 1, ink_atomic_increment(&freelist_count, 0));
+    tm.mag     = static_cast<InkThreadMagazine *>(ats_realloc(tm.mag, n * sizeof(InkThreadMagazine)));
+    memset(tm.mag + tm.n, 0, (n - tm.n) * sizeof(InkThreadMagazine));
+    tm.n = n;
+  }
+  InkThreadMagazine *m = &tm.mag[f->id];
+  m->fl                = f;
+  return m;
+}
+
+static _InkMagazineDepot *
+magazine_depot(InkFreeList *f)
+{
+  _InkMagazineDepot *d = f->depot;
+  if (unlikely(d == nullptr)) {
+    _InkMagazineDepot *nd = static_cast<_InkMagazineDepot *>(ats_malloc(sizeof(_InkMagazineDepot)));
+    for (auto &n : nd->node) {
+      ink_mutex_init(&n.lock);
+      n.count = 0;
+    }
+    if (ink_atomic_cas(&f->depot, static_cast<_InkMagazineDepot *>(nullptr), nd)) {
+      d = nd;
+    } else {
+      for (auto &n : nd->node) {
+        ink_mutex_destroy(&n.lock);
+      }
+      ats_free(nd);
+      d = f->depot;
+    }
+  }
+  return d;
+}
+
+// Never cache more than a couple of chunks, whatever the magazine size, huge buffers come few to a chunk.
+static inline uint32_t
+magazine_items(InkFreeList *f)
+{
+  return std::min(magazine_size, std::max(f->chunk_size, 1u));
+}
+
+// Hand a full magazine to the depot of this node, or the global list if that is full too.
+static void
+magazine_put(InkFreeList *f, void *head, void *tail)
+{
+  _InkMagazineDepot::Node &n = magazine_depot(f)->node[magazine_node()];
+
+  ink_mutex_acquire(&n.lock);
+  if (n.count < MAGAZINE_DEPOT_SIZE) {
+    n.full[n.count++] = {head, tail};
+    ink_mutex_release(&n.lock);
+  } else {
+    ink_mutex_release(&n.lock);
+    freelist_bulkfree(f, head, tail, magazine_items(f));
+  }
+  ink_atomic_decrement((int *)&f->used, magazine_items(f));
+}
+
+// Fill @a m with a magazine from the depot of this node, from the global list if there are none.
+static void
+magazine_get(InkFreeList *f, InkThreadMagazine *m)
+{
+  _InkMagazineDepot::Node &n = magazine_depot(f)->node[magazine_node()];
+  uint32_t size              = magazine_items(f);
+  InkMagazine full{nullptr, nullptr};
+
+  ink_mutex_acquire(&n.lock);
+  if (n.count > 0) {
+    full = n.full[--n.count];
+  }
+  ink_mutex_release(&n.lock);
+
+  if (full.head) {
+    *(void **)full.tail = m->head;
+    m->head             = full.head;
+  } else {
+    for (uint32_t i = 0; i < size; ++i) {
+      void *item     = freelist_new(f);
+      *(void **)item = m->head;
+      m->head        = item;
+    }
+  }
+  m->count += size;
+  ink_atomic_increment((int *)&f->used, size);
+}
+
+// Give back one magazine once the thread holds two.
+static void
+magazine_trim(InkFreeList *f, InkThreadMagazine *m)
+{
+  uint32_t size = magazine_items(f);
+
+  while (m->count >= 2 * size) {
+    void *head = m->head;
+    void *tail = head;
+    for (uint32_t i = 1; i < size; ++i) {
+      tail = *(void **)tail;
+    }
+    m->head = *(void **)tail;
+    m->count -= size;
+    magazine_put(f, head, tail);
+  }
+}
+
+static void *
+magazine_new(InkFreeList *f)
+{
+  InkThreadMagazine *m = thread_magazine(f);
+
+  if (unlikely(m->count == 0)) {
+    magazine_get(f, m);
+  }
+  void *item = m->head;
+  m->head    = *(void **)item;
+  --m->count;
+  ink_assert(!((uintptr_t)item & (((uintptr_t)f->alignment) - 1)));
+
+  return item;
+}
+
+static void
+magazine_free(InkFreeList *f, void *item)
+{
+  InkThreadMagazine *m = thread_magazine(f);
+
+  *(void **)item = m->head;
+  m->head        = item;
+  if (unlikely(++m->count >= 2 * magazine_items(f))) {
+    magazine_trim(f, m);
+  }
+}
+
+static void
+magazine_bulkfree(InkFreeList *f, void *head, void *tail, size_t num_item)
+{
+  InkThreadMagazine *m = thread_magazine(f);
+
+  *(void **)tail = m->head;
+  m->head        = head;
+  m->count += num_item;
+  magazine_trim(f, m);
+}
+
+InkThreadMagazines::~InkThreadMagazines()
+{
+  for (uint32_t i = 0; i < n; ++i) {
+    InkThreadMagazine &m = mag[i];
+    if (m.count) {
+      void *tail = m.head;
+      while (*(void **)tail) {
+        tail = *(void **)tail;
+      }
+      freelist_bulkfree(m.fl, m.head, tail, m.count);
+      ink_atomic_decrement((int *)&m.fl->used, m.count);
+    }
+  }
+  ats_free(mag);
 }
 
 void
@@ -133,6 +398,7 @@ ink_freelist_init(InkFreeList **fl, const char *name, uint32_t type_size, uint32
   freelists = fll;
 
   f->name = name;
+  f->id   = ink_atomic_increment(&freelist_count, 1);
   /* quick test for power of 2 */
   ink_assert(!(alignment & (alignment - 1)));
   // It is never useful to have alignment requirement looser than a page size
@@ -183,8 +449,13 @@ void *
 ink_freelist_new(InkFreeList *f)
 {
   void *ptr;
+  const ink_freelist_ops *ops = freelist_global_ops;
 
-  if (likely(ptr = freelist_global_ops->fl_new(f))) {
+  if (unlikely(freelist_count_allocs)) {
+    ink_atomic_increment(&f->allocs, static_cast<uint64_t>(1));
+  }
+  // The magazines only account for whole magazines.
+  if (likely(ptr = ops->fl_new(f)) && ops != &magazine_ops) {
     ink_atomic_increment((int *)&f->used, 1);
   }
 
@@ -273,9 +544,12 @@ void
 ink_freelist_free(InkFreeList *f, void *item)
 {
   if (likely(item != nullptr)) {
+    const ink_freelist_ops *ops = freelist_global_ops;
     ink_assert(f->used != 0);
-    freelist_global_ops->fl_free(f, item);
-    ink_atomic_decrement((int *)&f->used, 1);
+    ops->fl_free(f, item);
+    if (ops != &magazine_ops) {
+      ink_atomic_decrement((int *)&f->used, 1);
+    }
   }
 }
 
@@ -329,10 +603,13 @@ malloc_free(InkFreeList *f, void *item)
 void
 ink_freelist_free_bulk(InkFreeList *f, void *head, void *tail, size_t num_item)
 {
+  const ink_freelist_ops *ops = freelist_global_ops;
   ink_assert(f->used >= num_item);
 
-  freelist_global_ops->fl_bulkfree(f, head, tail, num_item);
-  ink_atomic_decrement((int *)&f->used, num_item);
+  ops->fl_bulkfree(f, head, tail, num_item);
+  if (ops != &magazine_ops) {
+    ink_atomic_decrement((int *)&f->used, num_item);
+  }
 }
 
 static void
@@ -399,6 +676,46 @@ malloc_bulkfree(InkFreeList *f, void *head, void *tail, size_t num_item)
   }
 }
 
+/*
+ * jemalloc
+ *
+ * With --enable-jemalloc-freelists every item comes from a jemalloc arena of the freelists, one for those
+ * that leave their memory out of the core dumps and one for the others, see JemallocFreelistAllocator.
+ * The allocated count follows the items handed out, as there are no chunks.
+ */
+
+static void *
+jemalloc_new(InkFreeList *f)
+{
+  void *newp = jearena::globalJemallocFreelistAllocator(f->advice).allocate(f);
+  ink_atomic_increment((int *)&f->allocated, 1);
+  return newp;
+}
+
+static void
+jemalloc_free(InkFreeList *f, void *item)
+{
+  jearena::globalJemallocFreelistAllocator(f->advice).deallocate(f, item);
+  ink_atomic_decrement((int *)&f->allocated, 1);
+}
+
+static void
+jemalloc_bulkfree(InkFreeList *f, void *head, void *tail, size_t num_item)
+{
+  jearena::JemallocFreelistAllocator &jfa = jearena::globalJemallocFreelistAllocator(f->advice);
+  void *item                              = head;
+  void *next;
+
+  // Avoid compiler warnings
+  (void)tail;
+
+  for (size_t i = 0; i < num_item && item; ++i, item = next) {
+    next = *(void **)item; // find next item before freeing current item
+    jfa.deallocate(f, item);
+  }
+  ink_atomic_decrement((int *)&f->allocated, num_item);
+}
+
 void
 ink_freelists_snap_baseline()
 {
@@ -411,6 +728,27 @@ ink_freelists_snap_baseline()
   }
 }
 
+void
+ink_freelists_count_allocs(bool enable)
+{
+  if (enable) {
+    for (ink_freelist_list *fll = freelists; fll; fll = fll->next) {
+      fll->fl->allocs = 0;
+    }
+  }
+  freelist_count_allocs = enable;
+}
+
+void
+ink_freelists_get_allocs(void (*cb)(const char *name, uint64_t allocs, void *data), void *data)
+{
+  for (ink_freelist_list *fll = freelists; fll; fll = fll->next) {
+    if (fll->fl->allocs != 0) {
+      cb(fll->fl->name ? fll->fl->name : "<unknown>", fll->fl->allocs, data);
+    }
+  }
+}
+
 void
 ink_freelists_dump_baselinerel(FILE *f)
 {
@@ -0,0 +1,71 @@
+/** @file
+
+    Unit tests for CRC32C
+
+    @section license License
+
+    Licensed to the Apache Software Foundation (ASF) under one
+    or more contributor license agreements.  See the NOTICE file
+    distributed with this work for additional information
+    regarding copyright ownership.  The ASF licenses this file
+    to you under the Apache License, Version 2.0 (the
+    "License"); you may not use this file except in compliance
+    with the License.  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include <cstring>
+#include <string>
+
+#include "tscore/CRC32C.h"
+#include "catch.hpp"
+
+TEST_CASE("CRC32C", "[libts][CRC32C]")
+{
+  SECTION("Known values")
+  {
+    CHECK(ts::crc32c("", 0) == 0);
+    CHECK(ts::crc32c("123456789", 9) == 0xE3069283);
+    CHECK(ts::crc32c_portable("123456789", 9) == 0xE3069283);
+
+    // RFC 3720 B.4
+    uint8_t data[32];
+    memset(data, 0, sizeof(data));
+    CHECK(ts::crc32c(data, sizeof(data)) == 0x8A9136AA);
+    memset(data, 0xFF, sizeof(data));
+    CHECK(ts::crc32c(data, sizeof(data)) == 0x62A8AB43);
+    for (unsigned i = 0; i < sizeof(data); ++i) {
+      data[i] = i;
+    }
+    CHECK(ts::crc32c(data, sizeof(data)) == 0x46DD794E);
+  }
+
+  SECTION("Every length and alignment matches the table")
+  {
+    std::string data;
+    for (int i = 0; i < 300; ++i) {
+      data += static_cast<char>(i * 131 + 7);
+    }
+    for (size_t length = 0; length + 8 <= data.size(); ++length) {
+      for (size_t offset = 0; offset < 8; ++offset) {
+        CHECK(ts::crc32c(data.data() + offset, length) == ts::crc32c_portable(data.data() + offset, length));
+      }
+    }
+  }
+
+  SECTION("Continued")
+  {
+    std::string data(1000, 'x');
+    for (size_t split : {0, 1, 7, 8, 500, 999}) {
+      CHECK(ts::crc32c(data.data() + split, data.size() - split, ts::crc32c(data.data(), split)) ==
+            ts::crc32c(data.data(), data.size()));
+    }
+  }
+}
@@ -0,0 +1,125 @@
+/** @file
+
+    Unit tests and benchmark for CharScan
+
+    @section license License
+
+    Licensed to the Apache Software Foundation (ASF) under one
+    or more contributor license agreements.  See the NOTICE file
+    distributed with this work for additional information
+    regarding copyright ownership.  The ASF licenses this file
+    to you under the Apache License, Version 2.0 (the
+    "License"); you may not use this file except in compliance
+    with the License.  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include <cstring>
+#include <string>
+
+#include "tscore/CharScan.h"
+#include "catch.hpp"
+
+TEST_CASE("CharScan", "[libts][CharScan]")
+{
+  char buff[100];
+
+  // Every length and match position, so each of the vector widths and the tail are covered.
+  for (int len = 0; len <= 80; ++len) {
+    for (int pos = 0; pos <= len; ++pos) {
+      memset(buff, 'a', sizeof(buff));
+      if (pos < len) {
+        buff[pos] = (pos & 1) ? '\n' : '\0';
+      }
+      // A match just past the end must not be seen.
+      buff[len]         = '\n';
+      const char *found = ts::scan_any(buff, buff + len, '\n', '\0');
+      REQUIRE(found == ts::scan_any_scalar(buff, buff + len, '\n', '\0'));
+      REQUIRE(found == buff + pos);
+    }
+  }
+
+  // The first of several matches.
+  strcpy(buff, "Host: example.com\r\nAccept: */*\r\n\r\n");
+  const char *end = buff + strlen(buff);
+  REQUIRE(ts::scan_any(buff, end, '\n') == buff + 18);
+  REQUIRE(ts::scan_any(buff, end, '\r', '\n', ':') == buff + 4);
+  REQUIRE(ts::scan_any(buff, end, '\0') == end);
+
+  // High bytes are not confused with anything.
+  memset(buff, 0xff, sizeof(buff));
+  REQUIRE(ts::scan_any(buff, buff + sizeof(buff), '\x7f') == buff + sizeof(buff));
+  buff[70] = '\x7f';
+  REQUIRE(ts::scan_any(buff, buff + sizeof(buff), '\x7f') == buff + 70);
+}
+
+TEST_CASE("CharScan equal_nocase", "[libts][CharScan]")
+{
+  std::string lower = "strict-transport-security: max-age=31536000; includesubdomains";
+  std::string upper = "STRICT-TRANSPORT-SECURITY: MAX-AGE=31536000; INCLUDESUBDOMAINS";
+
+  for (size_t n = 0; n <= lower.size(); ++n) {
+    REQUIRE(ts::equal_nocase(lower.data(), upper.data(), n));
+    // A difference at the start, in the middle and at the end of the range.
+    for (size_t pos : {size_t(0), n / 2, n - 1}) {
+      if (pos < n) {
+        std::string other = upper;
+        other[pos] ^= 0x01;
+        REQUIRE(!ts::equal_nocase(lower.data(), other.data(), n));
+      }
+    }
+  }
+
+  // Only letters are folded, characters that differ in the same bit as letters do not match.
+  REQUIRE(!ts::equal_nocase("@[\\]^_@[\\]^_@[\\]^_", "`{|}~\x7f`{|}~\x7f`{|}~\x7f", 18));
+  REQUIRE(!ts::equal_nocase("-0123", "\r\x10\x11\x12\x13", 5));
+  REQUIRE(ts::equal_nocase("\xc9\xe9-0123-AbCdEfGhIjKlMnOpQrStUvWxYz", "\xc9\xe9-0123-aBcDeFgHiJkLmNoPqRsTuVwXyZ", 34));
+  REQUIRE(!ts::equal_nocase("\xc9\xc9-0123-AbCdEfGhIjKlMnOpQrStUvWxYz", "\xe9\xe9-0123-aBcDeFgHiJkLmNoPqRsTuVwXyZ", 34));
+}
+
+// Run with "[benchmark]" on the command line.
+TEST_CASE("CharScan benchmark", "[.][benchmark][CharScan]")
+{
+  std::string block;
+  while (block.size() < 64 * 1024) {
+    block += "User-Agent: Mozilla/5.0 (X11; Linux x86_64) AppleWebKit/537.36 (KHTML, like Gecko) Chrome/80.0 Safari/537.36\r\n"
+             "Accept: text/html,application/xhtml+xml,application/xml;q=0.9,*/*;q=0.8\r\n"
+             "Cookie: a=1; b=2\r\n";
+  }
+  const char *start = block.data();
+  const char *end   = start + block.size();
+  size_t lines      = 0;
+
+  BENCHMARK("scalar LF or NUL")
+  {
+    for (const char *s = start; (s = ts::scan_any_scalar(s, end, '\n', '\0')) < end; ++s) {
+      ++lines;
+    }
+  }
+  BENCHMARK("memchr LF then NUL")
+  {
+    for (const char *s = start; s < end; ++s) {
+      const char *lf = static_cast<const char *>(memchr(s, '\n', end - s));
+      lf             = lf ? lf : end;
+      if (memchr(s, '\0', lf - s)) {
+        break;
+      }
+      s = lf;
+      ++lines;
+    }
+  }
+  BENCHMARK("vector LF or NUL")
+  {
+    for (const char *s = start; (s = ts::scan_any(s, end, '\n', '\0')) < end; ++s) {
+      ++lines;
+    }
+  }
+  REQUIRE(lines > 0);
+}
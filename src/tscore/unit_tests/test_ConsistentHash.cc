@@ -0,0 +1,124 @@
+/** @file
+
+    Unit tests for ATSConsistentHash
+
+    @section license License
+
+    Licensed to the Apache Software Foundation (ASF) under one
+    or more contributor license agreements.  See the NOTICE file
+    distributed with this work for additional information
+    regarding copyright ownership.  The ASF licenses this file
+    to you under the Apache License, Version 2.0 (the
+    "License"); you may not use this file except in compliance
+    with the License.  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include <cstring>
+#include <map>
+#include <string>
+
+#include "tscore/ConsistentHash.h"
+#include "tscore/HashSip.h"
+#include "catch.hpp"
+
+namespace
+{
+constexpr int N_NODES  = 20;
+constexpr int REPLICAS = 64;
+
+struct Ring {
+  ATSConsistentHashNode nodes[N_NODES];
+  std::string names[N_NODES];
+  ATSConsistentHash hash{REPLICAS, new ATSHash64Sip24()};
+  std::map<uint64_t, ATSConsistentHashNode *> expected; ///< The ring as a map, first insert wins.
+
+  Ring()
+  {
+    ATSHash64Sip24 h;
+    char numstr[256];
+
+    for (int n = 0; n < N_NODES; ++n) {
+      names[n]           = "parent" + std::to_string(n) + ".example.com";
+      nodes[n].name      = const_cast<char *>(names[n].c_str());
+      nodes[n].available = true;
+      float weight       = 1.0 + (n % 3);
+      hash.insert(&nodes[n], weight);
+
+      for (int i = 0; i < static_cast<int>(REPLICAS * weight); ++i) {
+        snprintf(numstr, sizeof(numstr), "%d-", i);
+        h.update(numstr, strlen(numstr));
+        h.update(names[n].c_str(), names[n].size());
+        h.final();
+        expected.emplace(h.get(), &nodes[n]);
+        h.clear();
+      }
+    }
+  }
+
+  ATSConsistentHashNode *
+  expected_at(uint64_t hashval)
+  {
+    auto spot = expected.lower_bound(hashval);
+    return spot == expected.end() ? expected.begin()->second : spot->second;
+  }
+};
+} // namespace
+
+TEST_CASE("ConsistentHash lookup", "[libts][ConsistentHash]")
+{
+  Ring ring;
+
+  REQUIRE(ring.hash.size() == ring.expected.size());
+
+  // Every point, the values around it and the ends of the ring.
+  for (auto const &point : ring.expected) {
+    for (uint64_t hashval : {point.first - 1, point.first, point.first + 1}) {
+      REQUIRE(ring.hash.lookup_by_hashval(hashval) == ring.expected_at(hashval));
+    }
+  }
+  REQUIRE(ring.hash.lookup_by_hashval(0) == ring.expected_at(0));
+  REQUIRE(ring.hash.lookup_by_hashval(UINT64_MAX) == ring.expected.begin()->second);
+
+  // Walking the ring visits the points in order and wraps once.
+  ATSConsistentHashIter iter;
+  bool wrapped = false;
+  auto spot    = ring.expected.lower_bound(UINT64_MAX / 2);
+  REQUIRE(ring.hash.lookup_by_hashval(UINT64_MAX / 2, &iter, &wrapped) == spot->second);
+  for (size_t n = 1; n < ring.expected.size(); ++n) {
+    if (++spot == ring.expected.end()) {
+      spot = ring.expected.begin();
+    }
+    REQUIRE(ring.hash.lookup(nullptr, &iter, &wrapped) == spot->second);
+  }
+  REQUIRE(wrapped);
+}
+
+TEST_CASE("ConsistentHash available", "[libts][ConsistentHash]")
+{
+  Ring ring;
+  ATSConsistentHashIter iter;
+  bool wrapped = false;
+
+  for (auto &node : ring.nodes) {
+    node.available = false;
+  }
+  ring.nodes[7].available = true;
+  REQUIRE(ring.hash.lookup_available("/some/path", &iter, &wrapped) == &ring.nodes[7]);
+
+  ring.nodes[7].available = false;
+  wrapped                 = false;
+  REQUIRE(ring.hash.lookup_available("/some/path", &iter, &wrapped) == nullptr);
+
+  ATSConsistentHash empty(REPLICAS, new ATSHash64Sip24());
+  REQUIRE(empty.lookup_by_hashval(42) == nullptr);
+  REQUIRE(empty.lookup("/some/path") == nullptr);
+  REQUIRE(empty.lookup_available("/some/path") == nullptr);
+}
@@ -631,3 +631,74 @@ TEST_CASE("IpMap CloseIntersection", "[libts][ipmap]")
   std::cout << w.print("{::x}", m2).view() << std::endl;
 #endif
 };
+
+TEST_CASE("IpMap Freeze", "[libts][ipmap]")
+{
+  IpMap map;
+  IpMap frozen;
+  void *const marks[] = {reinterpret_cast<void *>(1), reinterpret_cast<void *>(2), reinterpret_cast<void *>(3)};
+  uint32_t seed       = 1;
+  auto random         = [&seed]() -> uint32_t { return seed = seed * 1103515245 + 12345; };
+
+  // Overlapping ranges, so the painting leaves ranges of all sizes.
+  for (int i = 0; i < 2000; ++i) {
+    in_addr_t min = random();
+    in_addr_t max = min + (random() % (1 << (i % 24)));
+    if (max < min) {
+      max = min;
+    }
+    void *mark = marks[i % 3];
+    map.mark(htonl(min), htonl(max), mark);
+    frozen.mark(htonl(min), htonl(max), mark);
+
+    IpEndpoint l6, u6;
+    l6.setToAnyAddr(AF_INET6);
+    l6.sin6.sin6_addr.s6_addr[0] = random() >> 24;
+    l6.sin6.sin6_addr.s6_addr[1] = random() >> 24;
+    u6                           = l6;
+    u6.sin6.sin6_addr.s6_addr[2] = 0xff;
+    map.mark(&l6, &u6, mark);
+    frozen.mark(&l6, &u6, mark);
+  }
+  frozen.freeze();
+  REQUIRE(frozen.count() == map.count());
+
+  auto check = [&]() {
+    for (auto &spot : map) {
+      IpEndpoint addr;
+      for (sockaddr const *edge : {spot.min(), spot.max()}) {
+        void *expected = nullptr;
+        void *found    = nullptr;
+        addr.assign(edge);
+        REQUIRE(frozen.contains(&addr, &found));
+        REQUIRE(map.contains(&addr, &expected));
+        REQUIRE(found == expected);
+      }
+    }
+    for (int i = 0; i < 100000; ++i) {
+      in_addr_t target = htonl(random());
+      void *expected   = nullptr;
+      void *found      = nullptr;
+      REQUIRE(frozen.contains(target, &found) == map.contains(target, &expected));
+      REQUIRE(found == expected);
+
+      IpEndpoint addr6;
+      addr6.setToAnyAddr(AF_INET6);
+      for (int k = 0; k < 4; ++k) {
+        addr6.sin6.sin6_addr.s6_addr[k] = random() >> 24;
+      }
+      REQUIRE(frozen.contains(&addr6, &found) == map.contains(&addr6, &expected));
+      REQUIRE(found == expected);
+    }
+  };
+  check();
+
+  // A change after freezing is still seen.
+  frozen.unmark(htonl(0), htonl(0x7fffffff));
+  map.unmark(htonl(0), htonl(0x7fffffff));
+  check();
+
+  IpMap empty;
+  empty.freeze();
+  REQUIRE(!empty.contains(htonl(42)));
+}
@@ -0,0 +1,143 @@
+/** @file
+
+    Unit tests for KeyValueStore
+
+    @section license License
+
+    Licensed to the Apache Software Foundation (ASF) under one
+    or more contributor license agreements.  See the NOTICE file
+    distributed with this work for additional information
+    regarding copyright ownership.  The ASF licenses this file
+    to you under the Apache License, Version 2.0 (the
+    "License"); you may not use this file except in compliance
+    with the License.  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include <thread>
+#include <vector>
+
+#include "tscore/KeyValueStore.h"
+#include "catch.hpp"
+
+using ts::KeyValueStore;
+
+TEST_CASE("KeyValueStore values", "[libts][KeyValueStore]")
+{
+  KeyValueStore store;
+  std::string value;
+
+  REQUIRE(!store.get("alpha", value, 100));
+
+  store.set("alpha", "one", 0);
+  store.set("bravo", "two", 200);
+  REQUIRE(store.get("alpha", value, 100));
+  REQUIRE(value == "one");
+  REQUIRE(store.get("bravo", value, 100));
+  REQUIRE(value == "two");
+  REQUIRE(store.count() == 2);
+
+  // Replaced values are charged for their new size.
+  store.set("alpha", "the first", 0);
+  REQUIRE(store.get("alpha", value, 100));
+  REQUIRE(value == "the first");
+  REQUIRE(store.bytes() == 2 * KeyValueStore::ENTRY_OVERHEAD + 5 + 9 + 5 + 3);
+
+  // Expired entries are not found, and are removed when they are looked up.
+  REQUIRE(!store.get("bravo", value, 200));
+  REQUIRE(store.count() == 1);
+
+  REQUIRE(store.remove("alpha"));
+  REQUIRE(!store.remove("alpha"));
+  REQUIRE(!store.get("alpha", value, 100));
+  REQUIRE(store.count() == 0);
+  REQUIRE(store.bytes() == 0);
+}
+
+TEST_CASE("KeyValueStore counters", "[libts][KeyValueStore]")
+{
+  KeyValueStore store;
+  std::string value;
+
+  REQUIRE(store.increment("hits", 1, 110, 100) == 1);
+  REQUIRE(store.increment("hits", 5, 500, 105) == 6);
+  REQUIRE(store.increment("hits", -2, 500, 109) == 4);
+  REQUIRE(store.get("hits", value, 109));
+  REQUIRE(value == "4");
+
+  // The counter keeps the expiration time it was created with, then starts over.
+  REQUIRE(store.increment("hits", 1, 120, 110) == 1);
+
+  store.set("text", "not a number", 0);
+  REQUIRE(store.increment("text", 3, 0, 100) == 3);
+}
+
+TEST_CASE("KeyValueStore add", "[libts][KeyValueStore]")
+{
+  KeyValueStore store;
+  std::string value;
+
+  REQUIRE(store.add("alpha", "one", 200, 100));
+  REQUIRE(!store.add("alpha", "two", 300, 150));
+  REQUIRE(store.get("alpha", value, 150));
+  REQUIRE(value == "one");
+
+  // An expired entry can be added again.
+  REQUIRE(store.add("alpha", "three", 300, 200));
+  REQUIRE(store.get("alpha", value, 250));
+  REQUIRE(value == "three");
+  REQUIRE(store.count() == 1);
+}
+
+TEST_CASE("KeyValueStore limit", "[libts][KeyValueStore]")
+{
+  constexpr size_t LIMIT = 64 * 1024;
+  KeyValueStore store(LIMIT);
+  std::string value;
+
+  for (int i = 0; i < 10000; ++i) {
+    store.set(std::to_string(i), std::string(32, 'x'), 0);
+  }
+  REQUIRE(store.bytes() <= LIMIT);
+  REQUIRE(store.count() > 0);
+  REQUIRE(store.count() < 10000);
+
+  // The most recent entries are kept.
+  REQUIRE(store.get("9999", value, 0));
+  REQUIRE(!store.get("0", value, 0));
+
+  // An entry larger than the share of its partition is kept until the next one.
+  store.set("big", std::string(LIMIT, 'x'), 0);
+  REQUIRE(store.get("big", value, 0));
+  REQUIRE(value.size() == LIMIT);
+}
+
+TEST_CASE("KeyValueStore threads", "[libts][KeyValueStore]")
+{
+  constexpr int THREADS = 8;
+  constexpr int ROUNDS  = 10000;
+  KeyValueStore store;
+  std::vector<std::thread> threads;
+
+  for (int t = 0; t < THREADS; ++t) {
+    threads.emplace_back([&store]() {
+      for (int i = 0; i < ROUNDS; ++i) {
+        store.increment("shared", 1, 0, 0);
+        store.increment(std::to_string(i % 100), 1, 0, 0);
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  REQUIRE(store.increment("shared", 0, 0, 0) == THREADS * ROUNDS);
+  REQUIRE(store.increment("42", 0, 0, 0) == THREADS * ROUNDS / 100);
+}
@@ -0,0 +1,103 @@
+/** @file
+
+    Unit tests for LatencyHistogram
+
+    @section license License
+
+    Licensed to the Apache Software Foundation (ASF) under one
+    or more contributor license agreements.  See the NOTICE file
+    distributed with this work for additional information
+    regarding copyright ownership.  The ASF licenses this file
+    to you under the Apache License, Version 2.0 (the
+    "License"); you may not use this file except in compliance
+    with the License.  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include "tscore/LatencyHistogram.h"
+#include "catch.hpp"
+
+TEST_CASE("LatencyHistogram buckets", "[libts][LatencyHistogram]")
+{
+  // Small values are exact.
+  for (int64_t v = 0; v < LatencyHistogram::SUB; ++v) {
+    REQUIRE(LatencyHistogram::upper_bound(LatencyHistogram::bucket_of(v)) == v);
+  }
+  REQUIRE(LatencyHistogram::bucket_of(-5) == 0);
+
+  // Every value is within its bucket and the relative error is bounded.
+  int prev = 0;
+  for (int64_t v = 1; v < (int64_t(1) << LatencyHistogram::MAX_BITS); v += 1 + v / 5) {
+    int idx = LatencyHistogram::bucket_of(v);
+    REQUIRE(idx >= prev);
+    REQUIRE(idx < LatencyHistogram::N_BUCKETS);
+    REQUIRE(LatencyHistogram::upper_bound(idx) >= v);
+    REQUIRE(LatencyHistogram::upper_bound(idx) - v <= v / LatencyHistogram::SUB);
+    REQUIRE((idx == 0 || LatencyHistogram::upper_bound(idx - 1) < v));
+    prev = idx;
+  }
+  REQUIRE(LatencyHistogram::bucket_of(INT64_MAX) == LatencyHistogram::N_BUCKETS - 1);
+}
+
+TEST_CASE("LatencyHistogram percentiles", "[libts][LatencyHistogram]")
+{
+  LatencyHistogram h;
+
+  REQUIRE(h.count() == 0);
+  REQUIRE(h.percentile(0.99) == 0);
+  REQUIRE(h.max() == 0);
+
+  for (int64_t v = 1; v <= 1000; ++v) {
+    h.record(v * 1000);
+  }
+  REQUIRE(h.count() == 1000);
+  int64_t p50 = h.percentile(0.5);
+  REQUIRE(p50 >= 500000);
+  REQUIRE(p50 <= 500000 + 500000 / LatencyHistogram::SUB);
+  int64_t p99 = h.percentile(0.99);
+  REQUIRE(p99 >= 990000);
+  REQUIRE(p99 <= 990000 + 990000 / LatencyHistogram::SUB);
+  REQUIRE(h.max() >= 1000000);
+  REQUIRE(h.percentile(1.0) == h.max());
+
+  // One outlier moves the max but not the median.
+  h.record(int64_t(1) << 30);
+  REQUIRE(h.max() >= int64_t(1) << 30);
+  REQUIRE(h.percentile(0.5) == p50);
+}
+
+TEST_CASE("LatencyHistogram delta", "[libts][LatencyHistogram]")
+{
+  LatencyHistogram live, prev, interval;
+
+  for (int i = 0; i < 100; ++i) {
+    live.record(10);
+  }
+  interval.delta(live, prev);
+  REQUIRE(interval.count() == 100);
+  REQUIRE(interval.max() == 10);
+
+  for (int i = 0; i < 10; ++i) {
+    live.record(100000);
+  }
+  interval.delta(live, prev);
+  REQUIRE(interval.count() == 10);
+  REQUIRE(interval.percentile(0.5) >= 100000);
+
+  interval.delta(live, prev);
+  REQUIRE(interval.count() == 0);
+
+  LatencyHistogram sum;
+  sum += live;
+  sum += live;
+  REQUIRE(sum.count() == 220);
+  sum.clear();
+  REQUIRE(sum.count() == 0);
+}
@@ -0,0 +1,99 @@
+/** @file
+
+    Unit tests for LiteralMatcher
+
+    @section license License
+
+    Licensed to the Apache Software Foundation (ASF) under one
+    or more contributor license agreements.  See the NOTICE file
+    distributed with this work for additional information
+    regarding copyright ownership.  The ASF licenses this file
+    to you under the Apache License, Version 2.0 (the
+    "License"); you may not use this file except in compliance
+    with the License.  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include <set>
+#include <string>
+#include <vector>
+
+#include "tscore/LiteralMatcher.h"
+#include "catch.hpp"
+
+// The ids of the literals in @a text.
+static std::set<int>
+found(LiteralMatcher const &m, std::string_view text)
+{
+  std::set<int> ids;
+  m.match(text, [&ids](int id) { ids.insert(id); });
+  return ids;
+}
+
+TEST_CASE("LiteralMatcher", "[libts][LiteralMatcher]")
+{
+  LiteralMatcher m;
+
+  REQUIRE(m.empty());
+  REQUIRE(found(m, "anything").empty());
+
+  int he   = m.add("he");
+  int she  = m.add("she");
+  int his  = m.add("his");
+  int hers = m.add("hers");
+  REQUIRE(m.add("she") == she);
+  REQUIRE(m.count() == 4);
+  m.compile();
+
+  REQUIRE(found(m, "ushers") == std::set<int>{he, she, hers});
+  REQUIRE(found(m, "this") == std::set<int>{his});
+  REQUIRE(found(m, "h").empty());
+  REQUIRE(found(m, "").empty());
+
+  SECTION("Repeats")
+  {
+    int count = 0;
+    m.match("hehehe", [&](int id) { count += id == he; });
+    REQUIRE(count == 3);
+  }
+
+  SECTION("Clear")
+  {
+    m.clear();
+    REQUIRE(m.empty());
+    REQUIRE(m.add("his") == 0);
+    m.compile();
+    REQUIRE(found(m, "ushers").empty());
+    REQUIRE(found(m, "this") == std::set<int>{0});
+  }
+}
+
+TEST_CASE("LiteralMatcher Hosts", "[libts][LiteralMatcher]")
+{
+  std::vector<std::string> hosts{".example.com", "cdn.", ".example.org", "img", "mple"};
+  std::vector<std::string> subjects{"www.example.com", "cdn.example.org", "img.cdn.example.net", "example", "foo.bar"};
+  LiteralMatcher m;
+
+  for (auto const &h : hosts) {
+    m.add(h);
+  }
+  m.compile();
+
+  // Every literal found is in the subject, and every literal in the subject is found.
+  for (auto const &s : subjects) {
+    std::set<int> expected;
+    for (unsigned i = 0; i < hosts.size(); ++i) {
+      if (s.find(hosts[i]) != std::string::npos) {
+        expected.insert(i);
+      }
+    }
+    REQUIRE(found(m, s) == expected);
+  }
+}
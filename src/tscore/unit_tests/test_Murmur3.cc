@@ -0,0 +1,73 @@
+/** @file
+
+    Unit tests for Murmur3Context
+
+    @section license License
+
+    Licensed to the Apache Software Foundation (ASF) under one
+    or more contributor license agreements.  See the NOTICE file
+    distributed with this work for additional information
+    regarding copyright ownership.  The ASF licenses this file
+    to you under the Apache License, Version 2.0 (the
+    "License"); you may not use this file except in compliance
+    with the License.  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include <algorithm>
+#include <cstring>
+
+#include "tscore/Murmur3.h"
+#include "catch.hpp"
+
+namespace
+{
+const char FOX[] = "The quick brown fox jumps over the lazy dog";
+
+CryptoHash
+hash_of(const char *data, int length)
+{
+  Murmur3Context ctx;
+  CryptoHash hash;
+  ctx.hash_immediate(hash, data, length);
+  return hash;
+}
+} // namespace
+
+TEST_CASE("Murmur3 reference", "[libts][Murmur3]")
+{
+  // Reference values of MurmurHash3_x64_128 with a seed of 0.
+  CryptoHash hash = hash_of(FOX, strlen(FOX));
+  REQUIRE(hash.u64[0] == 0xe34bbc7bbc071b6cULL);
+  REQUIRE(hash.u64[1] == 0x7a433ca9c49a9347ULL);
+
+  hash = hash_of("hello", 5);
+  REQUIRE(hash.u64[0] == 0xcbd8a7b341bd9b02ULL);
+  REQUIRE(hash.u64[1] == 0x5b1e906a48ae1d19ULL);
+
+  REQUIRE(hash_of("", 0) == CRYPTO_HASH_ZERO);
+}
+
+TEST_CASE("Murmur3 updates", "[libts][Murmur3]")
+{
+  int length       = strlen(FOX);
+  CryptoHash whole = hash_of(FOX, length);
+
+  // Any split of the data in updates gives the same hash.
+  for (int step = 1; step <= length; ++step) {
+    Murmur3Context ctx;
+    CryptoHash hash;
+    for (int offset = 0; offset < length; offset += step) {
+      ctx.update(FOX + offset, std::min(step, length - offset));
+    }
+    ctx.finalize(hash);
+    REQUIRE(hash == whole);
+  }
+}
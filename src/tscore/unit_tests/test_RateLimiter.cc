@@ -0,0 +1,106 @@
+/** @file
+
+    Unit tests for RateLimiter
+
+    @section license License
+
+    Licensed to the Apache Software Foundation (ASF) under one
+    or more contributor license agreements.  See the NOTICE file
+    distributed with this work for additional information
+    regarding copyright ownership.  The ASF licenses this file
+    to you under the Apache License, Version 2.0 (the
+    "License"); you may not use this file except in compliance
+    with the License.  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "tscore/RateLimiter.h"
+#include "catch.hpp"
+
+using ts::RateLimiter;
+
+namespace
+{
+constexpr int64_t SECOND = 1000000000;
+}
+
+TEST_CASE("RateLimiter burst and rate", "[libts][RateLimiter]")
+{
+  RateLimiter limiter(10, 5);
+  int64_t now = 100 * SECOND;
+
+  // A new key gets the whole burst at once.
+  for (int i = 0; i < 5; ++i) {
+    REQUIRE(limiter.admit("client", now));
+  }
+  REQUIRE(!limiter.admit("client", now));
+
+  // Other keys have their own buckets.
+  REQUIRE(limiter.admit("other", now));
+
+  // Then 10 per second.
+  REQUIRE(!limiter.admit("client", now + SECOND / 20));
+  REQUIRE(limiter.admit("client", now + SECOND / 10));
+  REQUIRE(!limiter.admit("client", now + SECOND / 10));
+
+  // A bucket does not fill past the burst.
+  now += 60 * SECOND;
+  for (int i = 0; i < 5; ++i) {
+    REQUIRE(limiter.admit("client", now));
+  }
+  REQUIRE(!limiter.admit("client", now));
+
+  // A time from the past does not refill or drain the bucket.
+  REQUIRE(!limiter.admit("client", now - SECOND));
+  REQUIRE(limiter.admit("client", now + SECOND / 10));
+}
+
+TEST_CASE("RateLimiter keys", "[libts][RateLimiter]")
+{
+  RateLimiter limiter(1, 1, RateLimiter::PARTITIONS * 4);
+  int64_t now = 0;
+
+  for (int i = 0; i < 10000; ++i) {
+    limiter.admit(std::to_string(i), now);
+  }
+  REQUIRE(limiter.count() <= RateLimiter::PARTITIONS * 4);
+
+  // The full buckets make room for new keys.
+  now += 10 * SECOND;
+  REQUIRE(limiter.admit("new", now));
+  REQUIRE(!limiter.admit("new", now));
+}
+
+TEST_CASE("RateLimiter threads", "[libts][RateLimiter]")
+{
+  constexpr int THREADS = 8;
+  RateLimiter limiter(1, 1000);
+  std::atomic<int> admitted{0};
+  std::vector<std::thread> threads;
+
+  for (int t = 0; t < THREADS; ++t) {
+    threads.emplace_back([&]() {
+      for (int i = 0; i < 1000; ++i) {
+        if (limiter.admit("shared", 0)) {
+          ++admitted;
+        }
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  REQUIRE(admitted == 1000);
+}
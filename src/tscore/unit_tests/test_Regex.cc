@@ -22,6 +22,7 @@
 
 #include <array>
 #include <string_view>
+#include <utility>
 
 #include "tscore/ink_assert.h"
 #include "tscore/ink_defs.h"
@@ -52,3 +53,37 @@ TEST_CASE("Regex", "[libts][Regex]")
     }
   }
 }
+
+TEST_CASE("Regex required literal", "[libts][Regex]")
+{
+  std::array<std::pair<std::string_view, std::string_view>, 12> cases{{{"example\\.com", "example.com"},
+                                                                        {"(.*)\\.example\\.com$", ".example.com"},
+                                                                        {"^www\\.(foo|bar)\\.com", "www."},
+                                                                        {"[a-z]+\\.cdn\\.net", ".cdn.net"},
+                                                                        {"abc?d", "ab"},
+                                                                        {"x{0,3}yyy", "yyy"},
+                                                                        {"foo(?:bar)?baz", "foo"},
+                                                                        {"a|b", ""},
+                                                                        {"(?i)abc", ""},
+                                                                        {"\\x41bcd", ""},
+                                                                        {"(abc", ""},
+                                                                        {".*", ""}}};
+
+  for (auto const &[pattern, literal] : cases) {
+    INFO(pattern);
+    REQUIRE(Regex::required_literal(pattern) == literal);
+  }
+}
+
+TEST_CASE("Regex intern", "[libts][Regex]")
+{
+  auto foo = Regex::intern("^foo");
+  REQUIRE(foo != nullptr);
+  REQUIRE(Regex::intern("^foo") == foo);
+  REQUIRE(Regex::intern("^foo", RE_CASE_INSENSITIVE) != foo);
+  REQUIRE(Regex::intern("(foo") == nullptr);
+
+  REQUIRE(foo->exec("foobar"));
+  REQUIRE_FALSE(foo->exec("barfoo"));
+  REQUIRE(Regex::intern("^foo", RE_CASE_INSENSITIVE)->exec("FOO"));
+}
@@ -0,0 +1,138 @@
+/** @file
+
+    Unit tests for TimerWheel
+
+    @section license License
+
+    Licensed to the Apache Software Foundation (ASF) under one
+    or more contributor license agreements.  See the NOTICE file
+    distributed with this work for additional information
+    regarding copyright ownership.  The ASF licenses this file
+    to you under the Apache License, Version 2.0 (the
+    "License"); you may not use this file except in compliance
+    with the License.  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include <vector>
+#include <random>
+
+#include "tscore/TimerWheel.h"
+#include "catch.hpp"
+
+struct T {
+  ink_hrtime at = 0;
+  LINK(T, link);
+};
+
+using Wheel = TimerWheel<T, &T::at>;
+
+// Run the wheel forward one tick at a time to @a end, check each entry comes due in its tick.
+static void
+run_to(Wheel &w, ink_hrtime start, ink_hrtime end, ink_hrtime step)
+{
+  for (ink_hrtime now = start; now <= end; now += step) {
+    w.advance(now);
+    while (T *t = w.pop_ready()) {
+      REQUIRE(t->at / step <= now / step);
+      REQUIRE(t->at / step > (now - step) / step);
+      t->at = -1;
+    }
+  }
+}
+
+TEST_CASE("TimerWheel basic", "[libts][TimerWheel]")
+{
+  Wheel w(1, 1000);
+  T a, b, c;
+
+  REQUIRE(w.empty());
+  REQUIRE(w.earliest() == INT64_MAX);
+
+  a.at = 900; // already passed
+  b.at = 1010;
+  c.at = 1000 + 300;
+  w.insert(&a);
+  w.insert(&b);
+  w.insert(&c);
+  REQUIRE(w.size() == 3);
+  REQUIRE(w.earliest() == 1000);
+  REQUIRE(w.pop_ready() == &a);
+  REQUIRE(w.pop_ready() == nullptr);
+
+  REQUIRE(w.earliest() == 1010);
+  w.advance(1009);
+  REQUIRE(w.pop_ready() == nullptr);
+  w.advance(1010);
+  REQUIRE(w.pop_ready() == &b);
+
+  // In the second level now, the earliest is where its slot is moved down.
+  REQUIRE(w.earliest() == 1280);
+  w.remove(&c);
+  REQUIRE(w.empty());
+  REQUIRE(w.earliest() == INT64_MAX);
+}
+
+TEST_CASE("TimerWheel levels", "[libts][TimerWheel]")
+{
+  const ink_hrtime start = 12345;
+  Wheel w(1, start);
+  std::vector<T> ts(2000);
+  std::mt19937_64 rng(7);
+
+  // Spread over every level, including the overflow list.
+  for (size_t i = 0; i < ts.size(); ++i) {
+    ink_hrtime span = ink_hrtime(1) << (8 * (i % 5) + 4);
+    ts[i].at        = start + 1 + rng() % span;
+    w.insert(&ts[i]);
+  }
+  // Drop every fourth entry again.
+  size_t removed = 0;
+  for (size_t i = 0; i < ts.size(); i += 4) {
+    w.remove(&ts[i]);
+    ts[i].at = -1;
+    ++removed;
+  }
+  REQUIRE(w.size() == ts.size() - removed);
+
+  // Jump from one time to the next, everything that comes due must be in the tick reached.
+  ink_hrtime now = start;
+  while (!w.empty()) {
+    ink_hrtime next = w.earliest();
+    REQUIRE(next > now);
+    w.advance(next);
+    while (T *t = w.pop_ready()) {
+      REQUIRE(t->at <= next);
+      REQUIRE(t->at > now);
+      t->at = -1;
+    }
+    now = next;
+  }
+  for (auto &t : ts) {
+    REQUIRE(t.at == -1);
+  }
+}
+
+TEST_CASE("TimerWheel ticks", "[libts][TimerWheel]")
+{
+  const ink_hrtime tick = 10;
+  Wheel w(tick, 0);
+  std::vector<T> ts(500);
+
+  for (size_t i = 0; i < ts.size(); ++i) {
+    ts[i].at = i * 37 + 15;
+    w.insert(&ts[i]);
+  }
+  run_to(w, tick, 500 * 37 + tick, tick);
+  for (auto &t : ts) {
+    REQUIRE(t.at == -1);
+  }
+  REQUIRE(w.empty());
+}
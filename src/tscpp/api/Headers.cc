@@ -97,58 +97,40 @@ HeaderFieldName::operator!=(const std::string &field_name)
   return !operator==(field_name.c_str());
 }
 
-/**
- * @private
- */
-struct HeaderFieldValueIteratorState : noncopyable {
-  TSMBuffer hdr_buf_ = nullptr;
-  TSMLoc hdr_loc_    = nullptr;
-  TSMLoc field_loc_  = nullptr;
-  int index_         = 0;
-  HeaderFieldValueIteratorState() {}
-  void
-  reset(TSMBuffer bufp, TSMLoc hdr_loc, TSMLoc field_loc, int index)
-  {
-    hdr_buf_   = bufp;
-    hdr_loc_   = hdr_loc;
-    field_loc_ = field_loc;
-    index_     = index;
-  }
-};
-
 header_field_value_iterator::header_field_value_iterator(void *bufp, void *hdr_loc, void *field_loc, int index)
 {
-  state_ = new HeaderFieldValueIteratorState();
-  state_->reset(static_cast<TSMBuffer>(bufp), static_cast<TSMLoc>(hdr_loc), static_cast<TSMLoc>(field_loc), index);
+  state_.hdr_buf_   = static_cast<TSMBuffer>(bufp);
+  state_.hdr_loc_   = static_cast<TSMLoc>(hdr_loc);
+  state_.field_loc_ = static_cast<TSMLoc>(field_loc);
+  state_.index_     = index;
 }
 
-header_field_value_iterator::header_field_value_iterator(const header_field_value_iterator &it)
-{
-  state_ = new HeaderFieldValueIteratorState();
-  state_->reset(it.state_->hdr_buf_, it.state_->hdr_loc_, it.state_->field_loc_, it.state_->index_);
-}
+header_field_value_iterator::header_field_value_iterator(const header_field_value_iterator &it) = default;
+
+header_field_value_iterator::~header_field_value_iterator() = default;
 
-header_field_value_iterator::~header_field_value_iterator()
+std::string header_field_value_iterator::operator*()
 {
-  delete state_;
+  return std::string(view());
 }
 
-std::string header_field_value_iterator::operator*()
+std::string_view
+header_field_value_iterator::view() const
 {
-  if (state_->index_ >= 0) {
+  if (state_.index_ >= 0) {
     int length      = 0;
-    const char *str = TSMimeHdrFieldValueStringGet(state_->hdr_buf_, state_->hdr_loc_, state_->field_loc_, state_->index_, &length);
+    const char *str = TSMimeHdrFieldValueStringGet(state_.hdr_buf_, state_.hdr_loc_, state_.field_loc_, state_.index_, &length);
     if (length && str) {
-      return std::string(str, length);
+      return std::string_view(str, length);
     }
   }
-  return std::string();
+  return std::string_view();
 }
 
 header_field_value_iterator &
 header_field_value_iterator::operator++()
 {
-  ++state_->index_;
+  ++state_.index_;
   return *this;
 }
 
@@ -163,8 +145,8 @@ header_field_value_iterator::operator++(int)
 bool
 header_field_value_iterator::operator==(const header_field_value_iterator &rhs) const
 {
-  return (state_->hdr_buf_ == rhs.state_->hdr_buf_) && (state_->hdr_loc_ == rhs.state_->hdr_loc_) &&
-         (state_->field_loc_ == rhs.state_->field_loc_) && (state_->index_ == rhs.state_->index_);
+  return (state_.hdr_buf_ == rhs.state_.hdr_buf_) && (state_.hdr_loc_ == rhs.state_.hdr_loc_) &&
+         (state_.field_loc_ == rhs.state_.field_loc_) && (state_.index_ == rhs.state_.index_);
 }
 
 bool
@@ -173,66 +155,55 @@ header_field_value_iterator::operator!=(const header_field_value_iterator &rhs)
   return !operator==(rhs);
 }
 
-/**
- * @private
- */
-struct MLocContainer {
-  TSMBuffer hdr_buf_;
-  TSMLoc hdr_loc_;
-  TSMLoc field_loc_;
-  MLocContainer(TSMBuffer bufp, TSMLoc hdr_loc, TSMLoc field_loc) : hdr_buf_(bufp), hdr_loc_(hdr_loc), field_loc_(field_loc) {}
-  ~MLocContainer()
-  {
-    if (field_loc_ != TS_NULL_MLOC) {
-      TSHandleMLocRelease(hdr_buf_, hdr_loc_, field_loc_);
-    }
-  }
-};
-
-/**
- * @private
- */
-struct HeaderFieldIteratorState {
-  std::shared_ptr<MLocContainer> mloc_container_;
-  HeaderFieldIteratorState(TSMBuffer bufp, TSMLoc hdr_loc, TSMLoc field_loc)
-    : mloc_container_(new MLocContainer(bufp, hdr_loc, field_loc))
-  {
+HeaderFieldIteratorState::HeaderFieldIteratorState(TSMBuffer bufp, TSMLoc hdr_loc, TSMLoc field_loc)
+  : hdr_buf_(bufp), hdr_loc_(hdr_loc), field_loc_(field_loc)
+{
+  if (field_loc != TS_NULL_MLOC) {
+    field_handle_.reset(field_loc, [bufp, hdr_loc](void *loc) { TSHandleMLocRelease(bufp, hdr_loc, static_cast<TSMLoc>(loc)); });
   }
-};
+}
 
 HeaderField::~HeaderField() {}
 
 HeaderField::size_type
 HeaderField::size() const
 {
-  return TSMimeHdrFieldValuesCount(iter_.state_->mloc_container_->hdr_buf_, iter_.state_->mloc_container_->hdr_loc_,
-                                   iter_.state_->mloc_container_->field_loc_);
+  return TSMimeHdrFieldValuesCount(iter_.state_.hdr_buf_, iter_.state_.hdr_loc_, iter_.state_.field_loc_);
 }
 
 header_field_value_iterator
 HeaderField::begin()
 {
-  return header_field_value_iterator(iter_.state_->mloc_container_->hdr_buf_, iter_.state_->mloc_container_->hdr_loc_,
-                                     iter_.state_->mloc_container_->field_loc_, 0);
+  return header_field_value_iterator(iter_.state_.hdr_buf_, iter_.state_.hdr_loc_, iter_.state_.field_loc_, 0);
 }
 
 header_field_value_iterator
 HeaderField::end()
 {
-  return header_field_value_iterator(iter_.state_->mloc_container_->hdr_buf_, iter_.state_->mloc_container_->hdr_loc_,
-                                     iter_.state_->mloc_container_->field_loc_, size());
+  return header_field_value_iterator(iter_.state_.hdr_buf_, iter_.state_.hdr_loc_, iter_.state_.field_loc_, size());
 }
 
 HeaderFieldName
 HeaderField::name() const
+{
+  return std::string(nameView());
+}
+
+std::string_view
+HeaderField::nameView() const
 {
   int length      = 0;
-  const char *str = TSMimeHdrFieldNameGet(iter_.state_->mloc_container_->hdr_buf_, iter_.state_->mloc_container_->hdr_loc_,
-                                          iter_.state_->mloc_container_->field_loc_, &length);
+  const char *str = TSMimeHdrFieldNameGet(iter_.state_.hdr_buf_, iter_.state_.hdr_loc_, iter_.state_.field_loc_, &length);
   if (str && length) {
-    return std::string(str, length);
+    return std::string_view(str, length);
   }
-  return std::string();
+  return std::string_view();
+}
+
+std::string_view
+HeaderField::valueView(int index) const
+{
+  return header_field_value_iterator(iter_.state_.hdr_buf_, iter_.state_.hdr_loc_, iter_.state_.field_loc_, index).view();
 }
 
 std::string
@@ -243,7 +214,7 @@ HeaderField::values(const char *join)
     if (ret.size()) {
       ret.append(join);
     }
-    ret.append(*it);
+    ret.append(it.view());
   }
   return ret;
 }
@@ -288,15 +259,13 @@ HeaderField::empty()
 bool
 HeaderField::clear()
 {
-  return (TSMimeHdrFieldValuesClear(iter_.state_->mloc_container_->hdr_buf_, iter_.state_->mloc_container_->hdr_loc_,
-                                    iter_.state_->mloc_container_->field_loc_) == TS_SUCCESS);
+  return (TSMimeHdrFieldValuesClear(iter_.state_.hdr_buf_, iter_.state_.hdr_loc_, iter_.state_.field_loc_) == TS_SUCCESS);
 }
 
 bool
 HeaderField::erase(header_field_value_iterator it)
 {
-  return (TSMimeHdrFieldValueDelete(it.state_->hdr_buf_, it.state_->hdr_loc_, it.state_->field_loc_, it.state_->index_) ==
-          TS_SUCCESS);
+  return (TSMimeHdrFieldValueDelete(it.state_.hdr_buf_, it.state_.hdr_loc_, it.state_.field_loc_, it.state_.index_) == TS_SUCCESS);
 }
 
 bool
@@ -308,21 +277,22 @@ HeaderField::append(const std::string &value)
 bool
 HeaderField::append(const char *value, int length)
 {
-  return (TSMimeHdrFieldValueStringInsert(iter_.state_->mloc_container_->hdr_buf_, iter_.state_->mloc_container_->hdr_loc_,
-                                          iter_.state_->mloc_container_->field_loc_, -1, value, -1) == TS_SUCCESS);
+  return (TSMimeHdrFieldValueStringInsert(iter_.state_.hdr_buf_, iter_.state_.hdr_loc_, iter_.state_.field_loc_, -1, value,
+                                          length) == TS_SUCCESS);
 }
 
 bool
 HeaderField::setName(const std::string &str)
 {
-  return (TSMimeHdrFieldNameSet(iter_.state_->mloc_container_->hdr_buf_, iter_.state_->mloc_container_->hdr_loc_,
-                                iter_.state_->mloc_container_->field_loc_, str.c_str(), str.length()) == TS_SUCCESS);
+  return (TSMimeHdrFieldNameSet(iter_.state_.hdr_buf_, iter_.state_.hdr_loc_, iter_.state_.field_loc_, str.c_str(), str.length()) ==
+          TS_SUCCESS);
 }
 
 bool
 HeaderField::operator==(const char *field_name) const
 {
-  return (::strcasecmp(name(), field_name) == 0);
+  std::string_view name = nameView();
+  return name.size() == strlen(field_name) && ::strncasecmp(name.data(), field_name, name.size()) == 0;
 }
 
 bool
@@ -365,8 +335,7 @@ HeaderField::operator=(const char *field_value)
 
 std::string HeaderField::operator[](const int index)
 {
-  return *header_field_value_iterator(iter_.state_->mloc_container_->hdr_buf_, iter_.state_->mloc_container_->hdr_loc_,
-                                      iter_.state_->mloc_container_->field_loc_, index);
+  return std::string(valueView(index));
 }
 
 std::string
@@ -392,46 +361,31 @@ operator<<(std::ostream &os, HeaderField &obj)
 }
 
 header_field_iterator::header_field_iterator(void *hdr_buf, void *hdr_loc, void *field_loc)
-  : state_(
-      new HeaderFieldIteratorState(static_cast<TSMBuffer>(hdr_buf), static_cast<TSMLoc>(hdr_loc), static_cast<TSMLoc>(field_loc)))
+  : state_(static_cast<TSMBuffer>(hdr_buf), static_cast<TSMLoc>(hdr_loc), static_cast<TSMLoc>(field_loc))
 {
 }
 
-header_field_iterator::header_field_iterator(const header_field_iterator &it) : state_(new HeaderFieldIteratorState(*it.state_)) {}
+header_field_iterator::header_field_iterator(const header_field_iterator &it) = default;
 
 header_field_iterator &
-header_field_iterator::operator=(const header_field_iterator &rhs)
-{
-  if (this != &rhs) {
-    delete state_;
-    state_ = new HeaderFieldIteratorState(*rhs.state_);
-  }
-  return *this;
-}
+header_field_iterator::operator=(const header_field_iterator &rhs) = default;
 
-header_field_iterator::~header_field_iterator()
-{
-  delete state_;
-}
+header_field_iterator::~header_field_iterator() = default;
 
 // utility function to use to advance iterators using different functions
-HeaderFieldIteratorState *
-advanceIterator(HeaderFieldIteratorState *state, TSMLoc (*getNextField)(TSMBuffer, TSMLoc, TSMLoc))
-{
-  if (state->mloc_container_->field_loc_ != TS_NULL_MLOC) {
-    TSMBuffer hdr_buf     = state->mloc_container_->hdr_buf_;
-    TSMLoc hdr_loc        = state->mloc_container_->hdr_loc_;
-    TSMLoc next_field_loc = getNextField(hdr_buf, hdr_loc, state->mloc_container_->field_loc_);
-    delete state;
-    state = new HeaderFieldIteratorState(hdr_buf, hdr_loc, next_field_loc);
+static void
+advanceIterator(HeaderFieldIteratorState &state, TSMLoc (*getNextField)(TSMBuffer, TSMLoc, TSMLoc))
+{
+  if (state.field_loc_ != TS_NULL_MLOC) {
+    TSMLoc next_field_loc = getNextField(state.hdr_buf_, state.hdr_loc_, state.field_loc_);
+    state                 = HeaderFieldIteratorState(state.hdr_buf_, state.hdr_loc_, next_field_loc);
   }
-  return state;
 }
 
 header_field_iterator &
 header_field_iterator::operator++()
 {
-  state_ = advanceIterator(state_, TSMimeHdrFieldNext);
+  advanceIterator(state_, TSMimeHdrFieldNext);
   return *this;
 }
 
@@ -446,16 +400,15 @@ header_field_iterator::operator++(int)
 header_field_iterator &
 header_field_iterator::nextDup()
 {
-  state_ = advanceIterator(state_, TSMimeHdrFieldNextDup);
+  advanceIterator(state_, TSMimeHdrFieldNextDup);
   return *this;
 }
 
 bool
 header_field_iterator::operator==(const header_field_iterator &rhs) const
 {
-  return (state_->mloc_container_->hdr_buf_ == rhs.state_->mloc_container_->hdr_buf_) &&
-         (state_->mloc_container_->hdr_loc_ == rhs.state_->mloc_container_->hdr_loc_) &&
-         (state_->mloc_container_->field_loc_ == rhs.state_->mloc_container_->field_loc_);
+  return (state_.hdr_buf_ == rhs.state_.hdr_buf_) && (state_.hdr_loc_ == rhs.state_.hdr_loc_) &&
+         (state_.field_loc_ == rhs.state_.field_loc_);
 }
 
 bool
@@ -473,14 +426,33 @@ HeaderField header_field_iterator::operator*()
  * @private
  */
 struct HeadersState : noncopyable {
-  TSMBuffer hdr_buf_;
-  TSMLoc hdr_loc_;
-  bool self_created_structures_;
-  HeadersState()
+  TSMBuffer hdr_buf_            = nullptr;
+  TSMLoc hdr_loc_               = nullptr;
+  bool detached_                = true; ///< Not bound to a header yet, it has its own.
+  bool self_created_structures_ = false;
+
+  // The own header of detached headers is only created on first use, most headers (e.g. all those
+  // of a Transaction) are bound to a transaction header before they are used.
+  TSMBuffer
+  buf()
   {
-    hdr_buf_                 = TSMBufferCreate();
-    hdr_loc_                 = TSHttpHdrCreate(hdr_buf_);
-    self_created_structures_ = true;
+    create();
+    return hdr_buf_;
+  }
+  TSMLoc
+  loc()
+  {
+    create();
+    return hdr_loc_;
+  }
+  void
+  create()
+  {
+    if (detached_ && !self_created_structures_) {
+      hdr_buf_                 = TSMBufferCreate();
+      hdr_loc_                 = TSHttpHdrCreate(hdr_buf_);
+      self_created_structures_ = true;
+    }
   }
   void
   reset(TSMBuffer bufp, TSMLoc hdr_loc)
@@ -490,8 +462,9 @@ struct HeadersState : noncopyable {
       TSMBufferDestroy(hdr_buf_);
       self_created_structures_ = false;
     }
-    hdr_buf_ = bufp;
-    hdr_loc_ = hdr_loc;
+    detached_ = false;
+    hdr_buf_  = bufp;
+    hdr_loc_  = hdr_loc;
   }
   ~HeadersState() { reset(nullptr, nullptr); }
 };
@@ -521,7 +494,7 @@ Headers::~Headers()
 bool
 Headers::isInitialized() const
 {
-  return (state_->hdr_buf_ && state_->hdr_loc_);
+  return state_->detached_ || (state_->hdr_buf_ && state_->hdr_loc_);
 }
 
 bool
@@ -533,38 +506,37 @@ Headers::empty()
 Headers::size_type
 Headers::size() const
 {
-  return TSMimeHdrFieldsCount(state_->hdr_buf_, state_->hdr_loc_);
+  return TSMimeHdrFieldsCount(state_->buf(), state_->loc());
 }
 
 Headers::size_type
 Headers::lengthBytes() const
 {
-  return TSMimeHdrLengthGet(state_->hdr_buf_, state_->hdr_loc_);
+  return TSMimeHdrLengthGet(state_->buf(), state_->loc());
 }
 
 header_field_iterator
 Headers::begin()
 {
-  return header_field_iterator(state_->hdr_buf_, state_->hdr_loc_, TSMimeHdrFieldGet(state_->hdr_buf_, state_->hdr_loc_, 0));
+  return header_field_iterator(state_->buf(), state_->loc(), TSMimeHdrFieldGet(state_->buf(), state_->loc(), 0));
 }
 
 header_field_iterator
 Headers::end()
 {
-  return header_field_iterator(state_->hdr_buf_, state_->hdr_loc_, TS_NULL_MLOC);
+  return header_field_iterator(state_->buf(), state_->loc(), TS_NULL_MLOC);
 }
 
 bool
 Headers::clear()
 {
-  return (TSMimeHdrFieldsClear(state_->hdr_buf_, state_->hdr_loc_) == TS_SUCCESS);
+  return (TSMimeHdrFieldsClear(state_->buf(), state_->loc()) == TS_SUCCESS);
 }
 
 bool
 Headers::erase(header_field_iterator it)
 {
-  return (TSMimeHdrFieldDestroy(it.state_->mloc_container_->hdr_buf_, it.state_->mloc_container_->hdr_loc_,
-                                it.state_->mloc_container_->field_loc_) == TS_SUCCESS);
+  return (TSMimeHdrFieldDestroy(it.state_.hdr_buf_, it.state_.hdr_loc_, it.state_.field_loc_) == TS_SUCCESS);
 }
 
 Headers::size_type
@@ -591,10 +563,8 @@ Headers::size_type
 Headers::count(const char *key, int length)
 {
   size_type ret_count = 0;
-  for (header_field_iterator it = begin(); it != end(); ++it) {
-    if ((*it).name() == key) {
-      ret_count++;
-    }
+  for (header_field_iterator it = find(key, length); it != end(); it.nextDup()) {
+    ret_count++;
   }
   return ret_count;
 }
@@ -640,9 +610,9 @@ Headers::find(const std::string &key)
 header_field_iterator
 Headers::find(const char *key, int length)
 {
-  TSMLoc field_loc = TSMimeHdrFieldFind(state_->hdr_buf_, state_->hdr_loc_, key, length);
+  TSMLoc field_loc = TSMimeHdrFieldFind(state_->buf(), state_->loc(), key, length);
   if (field_loc != TS_NULL_MLOC) {
-    return header_field_iterator(state_->hdr_buf_, state_->hdr_loc_, field_loc);
+    return header_field_iterator(state_->buf(), state_->loc(), field_loc);
   }
 
   return end();
@@ -653,11 +623,11 @@ Headers::append(const std::string &key, const std::string &value)
 {
   TSMLoc field_loc = TS_NULL_MLOC;
 
-  if (TSMimeHdrFieldCreate(state_->hdr_buf_, state_->hdr_loc_, &field_loc) == TS_SUCCESS) {
-    TSMimeHdrFieldNameSet(state_->hdr_buf_, state_->hdr_loc_, field_loc, key.c_str(), key.length());
-    TSMimeHdrFieldAppend(state_->hdr_buf_, state_->hdr_loc_, field_loc);
-    TSMimeHdrFieldValueStringInsert(state_->hdr_buf_, state_->hdr_loc_, field_loc, 0, value.c_str(), value.length());
-    return header_field_iterator(state_->hdr_buf_, state_->hdr_loc_, field_loc);
+  if (TSMimeHdrFieldCreate(state_->buf(), state_->loc(), &field_loc) == TS_SUCCESS) {
+    TSMimeHdrFieldNameSet(state_->buf(), state_->loc(), field_loc, key.c_str(), key.length());
+    TSMimeHdrFieldAppend(state_->buf(), state_->loc(), field_loc);
+    TSMimeHdrFieldValueStringInsert(state_->buf(), state_->loc(), field_loc, 0, value.c_str(), value.length());
+    return header_field_iterator(state_->buf(), state_->loc(), field_loc);
   } else {
     return end();
   }
@@ -0,0 +1,86 @@
+'''
+'''
+#  Licensed to the Apache Software Foundation (ASF) under one
+#  or more contributor license agreements.  See the NOTICE file
+#  distributed with this work for additional information
+#  regarding copyright ownership.  The ASF licenses this file
+#  to you under the Apache License, Version 2.0 (the
+#  "License"); you may not use this file except in compliance
+#  with the License.  You may obtain a copy of the License at
+#
+#      http://www.apache.org/licenses/LICENSE-2.0
+#
+#  Unless required by applicable law or agreed to in writing, software
+#  distributed under the License is distributed on an "AS IS" BASIS,
+#  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+#  See the License for the specific language governing permissions and
+#  limitations under the License.
+
+import os
+Test.Summary = '''
+Run fixed workloads and compare the requests per second, p99 latency, CPU and
+allocations per request against the stored baselines
+'''
+# traffic_load is only installed with --enable-test-tools
+Test.SkipUnless(
+    Condition.ProgramExists('traffic_load')
+)
+Test.ContinueOnFail = True
+
+ts = Test.MakeATSProcess("ts", select_ports=True, enable_tls=True)
+server = Test.MakeOriginServer("server")
+
+server.addResponse("sessionlog.json",
+                   {"headers": "GET /hit HTTP/1.1\r\nHost: www.example.com\r\n\r\n", "timestamp": "1469733493.993", "body": ""},
+                   {"headers": "HTTP/1.1 200 OK\r\nServer: microserver\r\nCache-Control: max-age=3600\r\nContent-Length: 1024\r\n\r\n",
+                    "timestamp": "1469733493.993", "body": "x" * 1024})
+server.addResponse("sessionlog.json",
+                   {"headers": "GET /origin HTTP/1.1\r\nHost: www.example.com\r\n\r\n", "timestamp": "1469733493.993", "body": ""},
+                   {"headers": "HTTP/1.1 200 OK\r\nServer: microserver\r\nCache-Control: no-store\r\nContent-Length: 1024\r\n\r\n",
+                    "timestamp": "1469733493.993", "body": "x" * 1024})
+
+ts.addSSLfile(os.path.join(Test.Variables.AtsTestToolsDir, "microserver", "ssl", "server.pem"))
+ts.Disk.ssl_multicert_config.AddLine(
+    'dest_ip=* ssl_cert_name=server.pem ssl_key_name=server.pem'
+)
+ts.Disk.remap_config.AddLine(
+    'map http://www.example.com http://127.0.0.1:{0}'.format(server.Variables.Port)
+)
+ts.Disk.remap_config.AddLine(
+    'map https://www.example.com http://127.0.0.1:{0}'.format(server.Variables.Port)
+)
+ts.Disk.records_config.update({
+    'proxy.config.ssl.server.cert.path': '{0}'.format(ts.Variables.SSLDir),
+    'proxy.config.ssl.server.private_key.path': '{0}'.format(ts.Variables.SSLDir),
+    'proxy.config.http.cache.http': 1,
+    'proxy.config.http.wait_for_cache': 1,
+})
+
+# Set ATS_PERF_UPDATE_BASELINES to store what this machine measures as the new baselines.
+baselines = os.path.join(Test.TestDirectory, 'baselines.json')
+gate = 'python3 {0} --baselines {1} --bindir {2} --runtime-dir {3} --host www.example.com'.format(
+    os.path.join(Test.TestDirectory, 'perf_gate.py'), baselines, ts.Variables.BINDIR, ts.Variables.RUNTIMEDIR)
+if os.environ.get('ATS_PERF_UPDATE_BASELINES'):
+    gate += ' --update'
+
+workloads = [
+    # name, port, options
+    ('h1_cache_hit', ts.Variables.port, '--url /hit --rate 1000'),
+    ('h1_origin', ts.Variables.port, '--url /origin --rate 200'),
+    ('h2_tls_cache_hit', ts.Variables.ssl_port, '--url /hit --rate 1000 --tls --h2'),
+]
+
+for i, (name, port, options) in enumerate(workloads):
+    tr = Test.AddTestRun("Workload {0}".format(name))
+    tr.Processes.Default.Command = '{0} --name {1} --port {2} --results {3} {4}'.format(
+        gate, name, port, os.path.join(Test.RunDirectory, name + '.json'), options)
+    tr.Processes.Default.Env = ts.Env
+    tr.Processes.Default.ReturnCode = 0
+    if i == 0:
+        tr.Processes.Default.StartBefore(server)
+        tr.Processes.Default.StartBefore(Test.Processes.ts, ready=When.PortsOpen([ts.Variables.port, ts.Variables.ssl_port]))
+    tr.Processes.Default.Streams.stdout = Testers.ExcludesExpression("REGRESSION", "No metric may regress")
+    tr.Processes.Default.Streams.stdout += Testers.ContainsExpression("{0}: (PASS|baseline updated)".format(name),
+                                                                      "The workload should meet its baselines")
+    tr.StillRunningAfter = ts
+    tr.StillRunningAfter = server
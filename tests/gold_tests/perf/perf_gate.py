@@ -0,0 +1,182 @@
+'''
+Run a fixed workload against a running traffic_server with traffic_load and
+compare what it measures against the stored baselines.
+'''
+#  Licensed to the Apache Software Foundation (ASF) under one
+#  or more contributor license agreements.  See the NOTICE file
+#  distributed with this work for additional information
+#  regarding copyright ownership.  The ASF licenses this file
+#  to you under the Apache License, Version 2.0 (the
+#  "License"); you may not use this file except in compliance
+#  with the License.  You may obtain a copy of the License at
+#
+#      http://www.apache.org/licenses/LICENSE-2.0
+#
+#  Unless required by applicable law or agreed to in writing, software
+#  distributed under the License is distributed on an "AS IS" BASIS,
+#  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+#  See the License for the specific language governing permissions and
+#  limitations under the License.
+
+import argparse
+import json
+import os
+import re
+import subprocess
+import sys
+import time
+
+ALLOCATIONS_STAT = 'proxy.process.traffic_server.memory.jemalloc.allocations'
+
+# Whether a larger value of a metric is better, the others regress when they grow.
+HIGHER_IS_BETTER = {
+    'rps': True,
+    'p99_ms': False,
+    'cpu_us_per_request': False,
+    'allocations_per_request': False,
+}
+
+
+def server_pid(runtime_dir):
+    with open(os.path.join(runtime_dir, 'server.lock')) as f:
+        return int(f.read().split()[0])
+
+
+def cpu_seconds(pid):
+    '''The user and system CPU time the process has used.'''
+    with open('/proc/{0}/stat'.format(pid)) as f:
+        # The command name can hold spaces, the fields are counted from the end of it.
+        fields = f.read().rsplit(')', 1)[1].split()
+    return (int(fields[11]) + int(fields[12])) / os.sysconf('SC_CLK_TCK')
+
+
+def metric(bindir, name):
+    '''The value of a statistic, or None if the server does not have it.'''
+    try:
+        out = subprocess.check_output([os.path.join(bindir, 'traffic_ctl'), 'metric', 'get', name],
+                                      stderr=subprocess.DEVNULL).decode('utf-8')
+    except subprocess.CalledProcessError:
+        return None
+    fields = out.split()
+    if len(fields) != 2 or fields[0] != name:
+        return None
+    return int(fields[1])
+
+
+def run_load(args):
+    command = [os.path.join(args.bindir, 'traffic_load'),
+               '-p', str(args.port),
+               '-u', args.url,
+               '-r', str(args.rate),
+               '-d', str(args.duration),
+               '-c', str(args.connections),
+               '-t', str(args.threads)]
+    if args.host:
+        command += ['-H', args.host]
+    if args.tls:
+        command.append('-S')
+    if args.h2:
+        command.append('-2')
+    print(' '.join(command))
+    sys.stdout.flush()
+    proc = subprocess.run(command, stdout=subprocess.PIPE, stderr=subprocess.STDOUT)
+    out = proc.stdout.decode('utf-8')
+    print(out)
+
+    done = re.search(r'^(\d+) requests in ([\d.]+) s \(([\d.]+)/s', out, re.MULTILINE)
+    p99 = re.search(r' p99 ([\d.]+) ', out)
+    if proc.returncode != 0 or done is None or p99 is None:
+        return None
+    return {'requests': int(done.group(1)), 'rps': float(done.group(3)), 'p99_ms': float(p99.group(1))}
+
+
+def check(name, results, baseline, tolerance):
+    '''Compare the results to the baseline, return whether none of them regressed.'''
+    ok = True
+    for key, value in sorted(results.items()):
+        if key not in HIGHER_IS_BETTER:
+            continue
+        expected = baseline.get(key)
+        if isinstance(expected, dict):
+            band = expected.get('tolerance', tolerance)
+            expected = expected.get('value')
+        else:
+            band = tolerance
+        if expected is None:
+            print('{0} {1}: {2:.3f} (no baseline)'.format(name, key, value))
+            continue
+        if HIGHER_IS_BETTER[key]:
+            limit = expected * (1 - band)
+            passed = value >= limit
+        else:
+            limit = expected * (1 + band)
+            passed = value <= limit
+        print('{0} {1}: {2:.3f} baseline {3:.3f} limit {4:.3f} {5}'.format(
+            name, key, value, expected, limit, 'PASS' if passed else 'REGRESSION'))
+        ok = ok and passed
+    return ok
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument('--name', required=True, help='name of the workload in the baselines')
+    parser.add_argument('--baselines', required=True, help='JSON file of the baselines')
+    parser.add_argument('--bindir', required=True, help='directory of traffic_load and traffic_ctl')
+    parser.add_argument('--runtime-dir', required=True, help='runtime directory of traffic_server')
+    parser.add_argument('--port', type=int, required=True, help='proxy port')
+    parser.add_argument('--host', help='Host of the requests')
+    parser.add_argument('--url', default='/', help='URL or path to request')
+    parser.add_argument('--rate', type=float, default=1000, help='requests per second')
+    parser.add_argument('--duration', type=int, default=10, help='seconds')
+    parser.add_argument('--connections', type=int, default=16)
+    parser.add_argument('--threads', type=int, default=2)
+    parser.add_argument('--tls', action='store_true')
+    parser.add_argument('--h2', action='store_true')
+    parser.add_argument('--results', help='write the measurements to this JSON file')
+    parser.add_argument('--update', action='store_true', help='store the measurements as the new baseline')
+    args = parser.parse_args()
+
+    pid = server_pid(args.runtime_dir)
+    cpu_before = cpu_seconds(pid)
+    allocations_before = metric(args.bindir, ALLOCATIONS_STAT)
+
+    results = run_load(args)
+    if results is None:
+        print('{0}: the workload did not complete'.format(args.name))
+        return 1
+
+    cpu_after = cpu_seconds(pid)
+    requests = max(1, results['requests'])
+    results['cpu_us_per_request'] = (cpu_after - cpu_before) * 1e6 / requests
+    if allocations_before is not None:
+        # The allocator statistics are only refreshed every second.
+        time.sleep(2)
+        allocations_after = metric(args.bindir, ALLOCATIONS_STAT)
+        if allocations_after is not None:
+            results['allocations_per_request'] = (allocations_after - allocations_before) / requests
+
+    if args.results:
+        with open(args.results, 'w') as f:
+            json.dump(results, f, indent=2, sort_keys=True)
+
+    with open(args.baselines) as f:
+        baselines = json.load(f)
+
+    if args.update:
+        baselines['workloads'][args.name] = {k: round(v, 3) for k, v in results.items() if k in HIGHER_IS_BETTER}
+        with open(args.baselines, 'w') as f:
+            json.dump(baselines, f, indent=2, sort_keys=True)
+            f.write('\n')
+        print('{0}: baseline updated'.format(args.name))
+        return 0
+
+    baseline = baselines['workloads'].get(args.name, {})
+    if not check(args.name, results, baseline, baselines.get('tolerance', 0.25)):
+        print('{0}: FAIL'.format(args.name))
+        return 1
+    print('{0}: PASS'.format(args.name))
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,1459 @@
+/** @file
+
+  An open-loop HTTP/1.1 and HTTP/2 load generator.
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ */
+
+// The requests are sent at a constant rate, each one at the time it is scheduled for, whether or
+// not the earlier ones have been answered. A closed-loop client such as jtest only sends when a
+// connection is free, so a slow response holds back the requests behind it and their wait is never
+// measured. Here the latency of a request counts from the time it was scheduled, a request that
+// waits for a free connection is charged for its wait.
+//
+// Each thread runs its own epoll loop with its share of the connections and of the rate. A
+// connection is HTTP/1.1 with one request at a time, or HTTP/2 with many streams, in the clear or
+// over TLS. The latencies can be written out in the HdrHistogram percentile distribution format.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cinttypes>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <signal.h>
+#include <strings.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <openssl/err.h>
+#include <openssl/ssl.h>
+
+#include "tscore/ink_defs.h"
+#include "tscore/ink_args.h"
+#include "tscore/I_Version.h"
+#include "tscore/Arena.h"
+
+#include "HuffmanCodec.h"
+#include "XPACK.h"
+
+using Clock = std::chrono::steady_clock;
+
+static AppVersionInfo appVersionInfo;
+
+static char proxy_host[256]  = "127.0.0.1";
+static int proxy_port        = 8080;
+static char host_header[256] = "";
+static char url_file[256]    = "";
+static char url[1024]        = "/";
+static double rate           = 1000;
+static int duration          = 10;
+static int nthreads          = 4;
+static int nconnections      = 64;
+static int max_streams       = 100;
+static int tls               = 0;
+static int h2                = 0;
+static int io_timeout        = 10;
+static char hgrm_file[256]   = "";
+static int verbose           = 0;
+
+static const ArgumentDescription argument_descriptions[] = {
+  {"proxy_host", 'P', "Proxy Host", "S255", proxy_host, "LOAD_PROXY_HOST", nullptr},
+  {"proxy_port", 'p', "Proxy Port", "I", &proxy_port, "LOAD_PROXY_PORT", nullptr},
+  {"host", 'H', "Host of the Requests (default: proxy host:port)", "S255", host_header, "LOAD_HOST", nullptr},
+  {"url", 'u', "URL or Path to Request", "S1023", url, "LOAD_URL", nullptr},
+  {"urls", 'U', "URLs from File, one per line", "S255", url_file, "LOAD_URLS", nullptr},
+  {"rate", 'r', "Requests per Second", "D", &rate, "LOAD_RATE", nullptr},
+  {"duration", 'd', "Duration (seconds)", "I", &duration, "LOAD_DURATION", nullptr},
+  {"threads", 't', "Threads", "I", &nthreads, "LOAD_THREADS", nullptr},
+  {"connections", 'c', "Connections", "I", &nconnections, "LOAD_CONNECTIONS", nullptr},
+  {"streams", 'm', "Most HTTP/2 Streams of a Connection", "I", &max_streams, "LOAD_STREAMS", nullptr},
+  {"tls", 'S', "Use TLS", "F", &tls, "LOAD_TLS", nullptr},
+  {"h2", '2', "Use HTTP/2", "F", &h2, "LOAD_H2", nullptr},
+  {"timeout", 'T', "Request Timeout (seconds)", "I", &io_timeout, "LOAD_TIMEOUT", nullptr},
+  {"histogram", 'o', "Write the Latencies to File (HdrHistogram format)", "S255", hgrm_file, "LOAD_HISTOGRAM", nullptr},
+  {"verbose", 'v', "Verbose Flag", "F", &verbose, "LOAD_VERBOSE", nullptr},
+  HELP_ARGUMENT_DESCRIPTION(),
+  VERSION_ARGUMENT_DESCRIPTION()};
+
+static int64_t
+now_us()
+{
+  return std::chrono::duration_cast<std::chrono::microseconds>(Clock::now().time_since_epoch()).count();
+}
+
+//
+// Latencies.
+//
+
+/// Counts of latencies in microseconds, in 256 buckets for each power of two (within 0.4%).
+class Histogram
+{
+public:
+  static constexpr int SUB_BITS = 8;
+  static constexpr int SUB      = 1 << SUB_BITS;
+  static constexpr int BUCKETS  = (65 - SUB_BITS) * SUB;
+
+  void
+  add(uint64_t us)
+  {
+    ++_counts[index(us)];
+    ++_count;
+    _sum += us;
+    _sum_squares += static_cast<double>(us) * us;
+    _max = std::max(_max, us);
+  }
+
+  void
+  merge(const Histogram &that)
+  {
+    for (int i = 0; i < BUCKETS; ++i) {
+      _counts[i] += that._counts[i];
+    }
+    _count += that._count;
+    _sum += that._sum;
+    _sum_squares += that._sum_squares;
+    _max = std::max(_max, that._max);
+  }
+
+  uint64_t
+  count() const
+  {
+    return _count;
+  }
+
+  /// The least latency that @a p of the latencies are not above, to within a bucket.
+  uint64_t
+  percentile(double p) const
+  {
+    uint64_t rank = std::max<uint64_t>(1, std::ceil(p * _count));
+    uint64_t seen = 0;
+    for (int i = 0; i < BUCKETS; ++i) {
+      seen += _counts[i];
+      if (seen >= rank) {
+        return std::min(upper(i), _max);
+      }
+    }
+    return _max;
+  }
+
+  void
+  print(FILE *fp) const
+  {
+    if (_count == 0) {
+      fprintf(fp, "no latencies\n");
+      return;
+    }
+    fprintf(fp, "latency (ms): mean %.3f stddev %.3f p50 %.3f p75 %.3f p90 %.3f p99 %.3f p99.9 %.3f p99.99 %.3f max %.3f\n",
+            mean() / 1000.0, stddev() / 1000.0, percentile(0.5) / 1000.0, percentile(0.75) / 1000.0, percentile(0.9) / 1000.0,
+            percentile(0.99) / 1000.0, percentile(0.999) / 1000.0, percentile(0.9999) / 1000.0, _max / 1000.0);
+  }
+
+  /// Write the percentile distribution the way HdrHistogram does, in milliseconds, for its plotting tools.
+  void
+  print_hgrm(FILE *fp) const
+  {
+    static constexpr int TICKS_PER_HALF = 5;
+
+    fprintf(fp, "%12s %14s %10s %14s\n\n", "Value", "Percentile", "TotalCount", "1/(1-Percentile)");
+    uint64_t seen = 0;
+    int i         = -1;
+    for (int half = 0; half < 64 && seen < _count; ++half) {
+      double low  = 1 - std::ldexp(1.0, -half);
+      double high = 1 - std::ldexp(1.0, -half - 1);
+      for (int tick = 0; tick < TICKS_PER_HALF && seen < _count; ++tick) {
+        double p      = low + (high - low) * tick / TICKS_PER_HALF;
+        uint64_t rank = std::max<uint64_t>(1, std::ceil(p * _count));
+        while (seen < rank) {
+          seen += _counts[++i];
+        }
+        fprintf(fp, "%12.3f %2.12f %10" PRIu64 " %14.2f\n", std::min(upper(i), _max) / 1000.0, p, seen, 1 / (1 - p));
+      }
+    }
+    fprintf(fp, "%12.3f %2.12f %10" PRIu64 "\n", _max / 1000.0, 1.0, _count);
+    fprintf(fp, "#[Mean    = %12.3f, StdDeviation   = %12.3f]\n", mean() / 1000.0, stddev() / 1000.0);
+    fprintf(fp, "#[Max     = %12.3f, Total count    = %12" PRIu64 "]\n", _max / 1000.0, _count);
+    fprintf(fp, "#[Buckets = %12d, SubBuckets     = %12d]\n", BUCKETS / SUB, SUB);
+  }
+
+private:
+  double
+  mean() const
+  {
+    return _count ? static_cast<double>(_sum) / _count : 0;
+  }
+
+  double
+  stddev() const
+  {
+    return _count ? std::sqrt(std::max(0.0, _sum_squares / _count - mean() * mean())) : 0;
+  }
+
+  static int
+  index(uint64_t v)
+  {
+    if (v < SUB) {
+      return static_cast<int>(v);
+    }
+    int e = 63 - __builtin_clzll(v);
+    return (e - SUB_BITS + 1) * SUB + static_cast<int>((v >> (e - SUB_BITS)) - SUB);
+  }
+
+  static uint64_t
+  upper(int i)
+  {
+    if (i < SUB) {
+      return i;
+    }
+    int e = i / SUB + SUB_BITS - 1;
+    return ((static_cast<uint64_t>(i % SUB + SUB) + 1) << (e - SUB_BITS)) - 1;
+  }
+
+  uint64_t _counts[BUCKETS] = {0};
+  uint64_t _count           = 0;
+  uint64_t _sum             = 0;
+  double _sum_squares       = 0;
+  uint64_t _max             = 0;
+};
+
+//
+// HTTP/2 framing and HPACK, just what a client needs.
+//
+
+enum {
+  H2_DATA          = 0x0,
+  H2_HEADERS       = 0x1,
+  H2_RST_STREAM    = 0x3,
+  H2_SETTINGS      = 0x4,
+  H2_PING          = 0x6,
+  H2_GOAWAY        = 0x7,
+  H2_WINDOW_UPDATE = 0x8,
+  H2_CONTINUATION  = 0x9,
+};
+
+enum {
+  H2_FLAG_END_STREAM  = 0x1,
+  H2_FLAG_ACK         = 0x1,
+  H2_FLAG_END_HEADERS = 0x4,
+  H2_FLAG_PADDED      = 0x8,
+  H2_FLAG_PRIORITY    = 0x20,
+};
+
+static constexpr uint32_t H2_SETTINGS_ENABLE_PUSH            = 0x2;
+static constexpr uint32_t H2_SETTINGS_MAX_CONCURRENT_STREAMS = 0x3;
+static constexpr uint32_t H2_SETTINGS_INITIAL_WINDOW_SIZE    = 0x4;
+static constexpr uint32_t H2_MAX_WINDOW_SIZE                 = 0x7fffffff;
+static constexpr uint32_t H2_INITIAL_WINDOW_SIZE             = 65535;
+static constexpr uint32_t H2_ERROR_CANCEL                    = 0x8;
+static constexpr size_t HPACK_TABLE_SIZE                     = 4096; // the default, the client does not change it
+static const char H2_PREFACE[]                               = "PRI * HTTP/2.0\r\n\r\nSM\r\n\r\n";
+
+static uint32_t
+get_u32(const uint8_t *p)
+{
+  return (static_cast<uint32_t>(p[0]) << 24) | (p[1] << 16) | (p[2] << 8) | p[3];
+}
+
+static void
+put_u32(uint8_t *p, uint32_t v)
+{
+  p[0] = v >> 24;
+  p[1] = v >> 16;
+  p[2] = v >> 8;
+  p[3] = v;
+}
+
+static void
+h2_setting(uint8_t *p, uint16_t id, uint32_t value)
+{
+  p[0] = id >> 8;
+  p[1] = id;
+  put_u32(p + 2, value);
+}
+
+static void
+h2_frame(std::string &out, uint8_t type, uint8_t flags, uint32_t stream, const void *payload, size_t len)
+{
+  uint8_t head[9] = {static_cast<uint8_t>(len >> 16), static_cast<uint8_t>(len >> 8), static_cast<uint8_t>(len), type, flags,
+                     static_cast<uint8_t>(stream >> 24), static_cast<uint8_t>(stream >> 16), static_cast<uint8_t>(stream >> 8),
+                     static_cast<uint8_t>(stream)};
+  out.append(reinterpret_cast<char *>(head), sizeof(head));
+  out.append(static_cast<const char *>(payload), len);
+}
+
+// [RFC 7541] Appendix A. Static Table Definition
+static const std::pair<const char *, const char *> hpack_static_table[] = {
+  {":authority", ""},
+  {":method", "GET"},
+  {":method", "POST"},
+  {":path", "/"},
+  {":path", "/index.html"},
+  {":scheme", "http"},
+  {":scheme", "https"},
+  {":status", "200"},
+  {":status", "204"},
+  {":status", "206"},
+  {":status", "304"},
+  {":status", "400"},
+  {":status", "404"},
+  {":status", "500"},
+  {"accept-charset", ""},
+  {"accept-encoding", "gzip, deflate"},
+  {"accept-language", ""},
+  {"accept-ranges", ""},
+  {"accept", ""},
+  {"access-control-allow-origin", ""},
+  {"age", ""},
+  {"allow", ""},
+  {"authorization", ""},
+  {"cache-control", ""},
+  {"content-disposition", ""},
+  {"content-encoding", ""},
+  {"content-language", ""},
+  {"content-length", ""},
+  {"content-location", ""},
+  {"content-range", ""},
+  {"content-type", ""},
+  {"cookie", ""},
+  {"date", ""},
+  {"etag", ""},
+  {"expect", ""},
+  {"expires", ""},
+  {"from", ""},
+  {"host", ""},
+  {"if-match", ""},
+  {"if-modified-since", ""},
+  {"if-none-match", ""},
+  {"if-range", ""},
+  {"if-unmodified-since", ""},
+  {"last-modified", ""},
+  {"link", ""},
+  {"location", ""},
+  {"max-forwards", ""},
+  {"proxy-authenticate", ""},
+  {"proxy-authorization", ""},
+  {"range", ""},
+  {"referer", ""},
+  {"refresh", ""},
+  {"retry-after", ""},
+  {"server", ""},
+  {"set-cookie", ""},
+  {"strict-transport-security", ""},
+  {"transfer-encoding", ""},
+  {"user-agent", ""},
+  {"vary", ""},
+  {"via", ""},
+  {"www-authenticate", ""},
+};
+static constexpr uint64_t HPACK_STATIC_TABLE_ENTRIES = sizeof(hpack_static_table) / sizeof(hpack_static_table[0]);
+static constexpr uint64_t HPACK_INDEX_AUTHORITY      = 1;
+static constexpr uint64_t HPACK_INDEX_PATH           = 4;
+static constexpr uint64_t HPACK_INDEX_USER_AGENT     = 58;
+
+/// Decodes the header blocks of a connection, it only keeps the dynamic table and the status.
+class HpackDecoder
+{
+public:
+  /// Decode the block at @a p, set @a status from its :status, return @c false on a compression error.
+  bool
+  decode(const uint8_t *p, const uint8_t *end, int &status)
+  {
+    bool ok = true;
+    while (ok && p < end) {
+      std::string name, value;
+      uint64_t index = 0;
+      int64_t n;
+
+      if (*p & 0x80) { // indexed
+        n  = xpack_decode_integer(index, p, end, 7);
+        ok = n > 0 && lookup(index, &name, &value);
+      } else if ((*p & 0xe0) == 0x20) { // dynamic table size update
+        n  = xpack_decode_integer(index, p, end, 5);
+        ok = n > 0 && index <= HPACK_TABLE_SIZE;
+        if (ok) {
+          _max_size = index;
+          evict(0);
+        }
+        p += n;
+        continue;
+      } else { // literal, with incremental indexing or not
+        bool incremental = (*p & 0xc0) == 0x40;
+        n                = xpack_decode_integer(index, p, end, incremental ? 6 : 4);
+        ok               = n > 0 && (index == 0 || lookup(index, &name, nullptr));
+        if (ok && index == 0) {
+          p += n;
+          n  = decode_string(p, end, name);
+          ok = n > 0;
+        }
+        if (ok) {
+          p += n;
+          n  = decode_string(p, end, value);
+          ok = n > 0;
+        }
+        if (ok && incremental) {
+          add(name, value);
+        }
+      }
+      p += std::max<int64_t>(n, 0);
+      if (ok && name == ":status") {
+        status = atoi(value.c_str());
+      }
+    }
+    _arena.reset();
+    return ok;
+  }
+
+private:
+  int64_t
+  decode_string(const uint8_t *p, const uint8_t *end, std::string &str)
+  {
+    char *s         = nullptr;
+    uint64_t length = 0;
+    int64_t n       = xpack_decode_string(_arena, &s, length, p, end);
+    if (n > 0) {
+      str.assign(s, length);
+    }
+    return n;
+  }
+
+  bool
+  lookup(uint64_t index, std::string *name, std::string *value) const
+  {
+    const char *n = nullptr, *v = nullptr;
+    if (index == 0) {
+      return false;
+    } else if (index <= HPACK_STATIC_TABLE_ENTRIES) {
+      n = hpack_static_table[index - 1].first;
+      v = hpack_static_table[index - 1].second;
+    } else if (index - HPACK_STATIC_TABLE_ENTRIES <= _table.size()) {
+      const auto &entry = _table[index - HPACK_STATIC_TABLE_ENTRIES - 1];
+      n                 = entry.first.c_str();
+      v                 = entry.second.c_str();
+    } else {
+      return false;
+    }
+    *name = n;
+    if (value != nullptr) {
+      *value = v;
+    }
+    return true;
+  }
+
+  // [RFC 7541] 4.1. Calculating Table Size
+  static size_t
+  entry_size(const std::string &name, const std::string &value)
+  {
+    return name.size() + value.size() + 32;
+  }
+
+  void
+  evict(size_t needed)
+  {
+    while (!_table.empty() && _size + needed > _max_size) {
+      _size -= entry_size(_table.back().first, _table.back().second);
+      _table.pop_back();
+    }
+  }
+
+  void
+  add(const std::string &name, const std::string &value)
+  {
+    size_t size = entry_size(name, value);
+    evict(size);
+    if (size <= _max_size) {
+      _table.emplace_front(name, value);
+      _size += size;
+    }
+  }
+
+  std::deque<std::pair<std::string, std::string>> _table; ///< Newest first.
+  size_t _size     = 0;
+  size_t _max_size = HPACK_TABLE_SIZE;
+  Arena _arena;
+};
+
+//
+// What is requested.
+//
+
+struct Target {
+  std::string h1_request; ///< The whole HTTP/1.1 request.
+  std::string h2_block;   ///< The HPACK header block of the HTTP/2 request, it only uses the static table.
+};
+
+static std::vector<Target> targets;
+
+static Target
+make_target(const std::string &spec)
+{
+  std::string authority = *host_header ? host_header : std::string(proxy_host) + ':' + std::to_string(proxy_port);
+  std::string path      = spec;
+  size_t scheme         = spec.find("://");
+  if (scheme != std::string::npos) {
+    size_t slash = spec.find('/', scheme + 3);
+    authority    = spec.substr(scheme + 3, slash == std::string::npos ? std::string::npos : slash - scheme - 3);
+    path         = slash == std::string::npos ? "/" : spec.substr(slash);
+  }
+
+  Target target;
+  // An absolute URL is sent as is, for a forward proxy.
+  target.h1_request = "GET " + spec + " HTTP/1.1\r\nHost: " + authority + "\r\nUser-Agent: traffic_load\r\n\r\n";
+
+  uint8_t buf[4096];
+  uint8_t *p   = buf;
+  uint8_t *end = buf + sizeof(buf);
+  *p++         = 0x82;              // :method GET
+  *p++         = tls ? 0x87 : 0x86; // :scheme https or http
+  std::pair<uint64_t, const std::string *> fields[] = {{HPACK_INDEX_PATH, &path}, {HPACK_INDEX_AUTHORITY, &authority}};
+  for (auto &field : fields) {
+    // Literal without indexing, the name from the static table.
+    *p = 0;
+    p += xpack_encode_integer(p, end, field.first, 4);
+    p += xpack_encode_string(p, end, field.second->data(), field.second->size());
+  }
+  *p = 0;
+  p += xpack_encode_integer(p, end, HPACK_INDEX_USER_AGENT, 4);
+  p += xpack_encode_string(p, end, "traffic_load", strlen("traffic_load"));
+  target.h2_block.assign(reinterpret_cast<char *>(buf), p - buf);
+  return target;
+}
+
+//
+// The load.
+//
+
+struct Request {
+  int64_t scheduled    = 0; ///< When it was to be sent, the latency counts from here.
+  const Target *target = nullptr;
+};
+
+struct Stream {
+  Request request;
+  int64_t sent = 0;
+  int status   = 0;
+};
+
+struct Connection {
+  enum State { CLOSED, CONNECTING, HANDSHAKE, OPEN };
+
+  State state      = CLOSED;
+  int fd           = -1;
+  SSL *ssl         = nullptr;
+  uint32_t events  = 0;
+  int64_t since    = 0; ///< When the connection started to connect.
+  int64_t retry_at = 0; ///< A closed connection reconnects from then.
+  std::string out;
+  size_t out_offset = 0;
+  std::string in;
+
+  // HTTP/1.1, one request at a time.
+  bool busy = false;
+  Stream current;
+  bool in_body       = false;
+  bool chunked       = false;
+  bool close_after   = false;
+  int64_t body_left  = 0; ///< Of a Content-Length body, -1 for a body that ends with the connection.
+  int64_t chunk_left = 0;
+
+  // HTTP/2.
+  std::unordered_map<uint32_t, Stream> streams;
+  uint32_t next_stream  = 1;
+  uint32_t peer_streams = UINT32_MAX; ///< SETTINGS_MAX_CONCURRENT_STREAMS of the server.
+  bool draining         = false;     ///< After a GOAWAY.
+  uint64_t unacked_data = 0;
+  HpackDecoder hpack;
+  std::string block; ///< The header block being received.
+  uint32_t block_stream = 0;
+  uint8_t block_flags   = 0;
+};
+
+static constexpr int64_t RETRY_DELAY = 100000; // after a failed connection, not to spin on a host that turns us away
+
+// The states of a chunked body, besides the rest of a chunk.
+static constexpr int64_t CHUNK_SIZE     = -1;
+static constexpr int64_t CHUNK_CRLF     = -2;
+static constexpr int64_t CHUNK_TRAILERS = -3;
+
+struct Counters {
+  std::atomic<uint64_t> completed{0};
+  std::atomic<uint64_t> errors{0};
+  std::atomic<uint64_t> timeouts{0};
+  std::atomic<uint64_t> queued{0}; ///< Requests due that wait for a connection.
+  std::atomic<uint64_t> open{0};   ///< Open connections.
+};
+
+class Worker
+{
+public:
+  Worker(int index, const struct sockaddr_storage &addr, socklen_t addr_len, SSL_CTX *tls_ctx)
+    : _index(index), _addr(addr), _addr_len(addr_len), _tls_ctx(tls_ctx)
+  {
+    _connections.resize(nconnections / nthreads + (index < nconnections % nthreads));
+    _interval    = nthreads * 1e6 / rate;
+    _next_target = index % targets.size();
+  }
+
+  void
+  run(int64_t start, int64_t end)
+  {
+    struct epoll_event events[64];
+    int64_t timeout = io_timeout * 1000000LL;
+    _epoll          = epoll_create1(0);
+    _start          = start;
+
+    for (;;) {
+      int64_t now  = now_us();
+      bool sending = schedule(now, end);
+      maintain(now);
+      dispatch(now);
+      if (!sending && _pending.empty() && outstanding() == 0) {
+        break;
+      }
+      if (now >= end + timeout) {
+        break;
+      }
+
+      int64_t wait = sending ? scheduled(_sent) - now : 100000;
+      int n        = epoll_wait(_epoll, events, countof(events), static_cast<int>(std::clamp<int64_t>(wait / 1000, 0, 100)));
+      for (int i = 0; i < n; ++i) {
+        handle(*static_cast<Connection *>(events[i].data.ptr), events[i].events);
+      }
+    }
+
+    counters.timeouts += _pending.size() + outstanding();
+    for (auto &c : _connections) {
+      close_connection(c, 0);
+    }
+    close(_epoll);
+    finished = now_us();
+  }
+
+  Counters counters;
+  Histogram latency;
+  int64_t finished     = 0; ///< When the last response came or timed out.
+  uint64_t statuses[6] = {0}; ///< Of the responses, by the first digit, 0 for a bad one.
+
+private:
+  int64_t
+  scheduled(uint64_t n) const
+  {
+    // The threads take turns, so that together they send at the rate.
+    return _start + static_cast<int64_t>((n + static_cast<double>(_index) / nthreads) * _interval);
+  }
+
+  /// Queue the requests due at @a now, return @c false once the requests up to @a end are queued.
+  bool
+  schedule(int64_t now, int64_t end)
+  {
+    for (int64_t at = scheduled(_sent); at <= now; at = scheduled(_sent)) {
+      if (at >= end) {
+        return false;
+      }
+      _pending.push_back({at, &targets[_next_target]});
+      _next_target = (_next_target + 1) % targets.size();
+      ++_sent;
+    }
+    return scheduled(_sent) < end;
+  }
+
+  size_t
+  outstanding() const
+  {
+    size_t n = 0;
+    for (auto &c : _connections) {
+      n += c.busy + c.streams.size();
+    }
+    return n;
+  }
+
+  /// Reconnect, and time out the requests that waited too long.
+  void
+  maintain(int64_t now)
+  {
+    int64_t timeout = io_timeout * 1000000LL;
+
+    while (!_pending.empty() && _pending.front().scheduled + timeout <= now) {
+      _pending.pop_front();
+      ++counters.timeouts;
+    }
+    for (auto &c : _connections) {
+      if (c.state == Connection::CLOSED) {
+        if (c.retry_at <= now) {
+          connect(c, now);
+        }
+      } else if (c.state != Connection::OPEN) {
+        if (c.since + timeout <= now) {
+          fail(c, "connect timed out");
+        }
+      } else if (c.busy && c.current.sent + timeout <= now) {
+        ++counters.timeouts;
+        c.busy = false;
+        close_connection(c, now);
+      } else if (!c.streams.empty()) {
+        for (auto spot = c.streams.begin(); spot != c.streams.end();) {
+          if (spot->second.sent + timeout <= now) {
+            uint8_t code[4];
+            put_u32(code, H2_ERROR_CANCEL);
+            h2_frame(c.out, H2_RST_STREAM, 0, spot->first, code, sizeof(code));
+            ++counters.timeouts;
+            spot = c.streams.erase(spot);
+          } else {
+            ++spot;
+          }
+        }
+        flush(c);
+      }
+    }
+    counters.queued = _pending.size();
+  }
+
+  /// Send the queued requests on the connections that can take them.
+  void
+  dispatch(int64_t now)
+  {
+    size_t count = _connections.size();
+    for (size_t i = 0; i < count && !_pending.empty(); ++i) {
+      Connection &c = _connections[(_next_connection + i) % count];
+      if (c.state != Connection::OPEN) {
+        continue;
+      }
+      if (!h2) {
+        if (!c.busy) {
+          c.busy        = true;
+          c.current     = {_pending.front(), now, 0};
+          c.in_body     = false;
+          c.close_after = false;
+          c.out += _pending.front().target->h1_request;
+          _pending.pop_front();
+          flush(c);
+        }
+        continue;
+      }
+      bool sent = false;
+      while (!_pending.empty() && !c.draining && c.streams.size() < std::min<uint32_t>(max_streams, c.peer_streams) &&
+             c.next_stream < H2_MAX_WINDOW_SIZE) {
+        const std::string &block = _pending.front().target->h2_block;
+        h2_frame(c.out, H2_HEADERS, H2_FLAG_END_STREAM | H2_FLAG_END_HEADERS, c.next_stream, block.data(), block.size());
+        c.streams[c.next_stream] = {_pending.front(), now, 0};
+        c.next_stream += 2;
+        _pending.pop_front();
+        sent = true;
+      }
+      if (sent) {
+        flush(c);
+      }
+    }
+    _next_connection = (_next_connection + 1) % count;
+    counters.queued  = _pending.size();
+  }
+
+  void
+  complete(const Stream &stream, int status, int64_t now)
+  {
+    latency.add(now - stream.request.scheduled);
+    ++statuses[status >= 100 && status < 600 ? status / 100 : 0];
+    ++counters.completed;
+  }
+
+  //
+  // Connections.
+  //
+
+  void
+  connect(Connection &c, int64_t now)
+  {
+    c.fd = socket(_addr.ss_family, SOCK_STREAM | SOCK_NONBLOCK, 0);
+    if (c.fd < 0) {
+      ++counters.errors;
+      c.retry_at = now + RETRY_DELAY;
+      return;
+    }
+    int one = 1;
+    setsockopt(c.fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+    c.state  = Connection::CONNECTING;
+    c.since  = now;
+    c.events = EPOLLIN | EPOLLOUT;
+    struct epoll_event ev;
+    ev.events   = c.events;
+    ev.data.ptr = &c;
+    epoll_ctl(_epoll, EPOLL_CTL_ADD, c.fd, &ev);
+    if (::connect(c.fd, reinterpret_cast<const struct sockaddr *>(&_addr), _addr_len) != 0 && errno != EINPROGRESS) {
+      fail(c, strerror(errno));
+    }
+  }
+
+  void
+  want_write(Connection &c, bool write)
+  {
+    uint32_t events = EPOLLIN | (write ? static_cast<uint32_t>(EPOLLOUT) : 0);
+    if (events != c.events) {
+      struct epoll_event ev;
+      ev.events   = events;
+      ev.data.ptr = &c;
+      epoll_ctl(_epoll, EPOLL_CTL_MOD, c.fd, &ev);
+      c.events = events;
+    }
+  }
+
+  /// Close @a c, it reconnects at @a retry_at.
+  void
+  close_connection(Connection &c, int64_t retry_at)
+  {
+    if (c.state == Connection::CLOSED) {
+      return;
+    }
+    if (c.state == Connection::OPEN) {
+      --counters.open;
+    }
+    if (c.ssl != nullptr) {
+      SSL_free(c.ssl);
+      c.ssl = nullptr;
+    }
+    close(c.fd);
+    c.fd       = -1;
+    c.state    = Connection::CLOSED;
+    c.retry_at = retry_at;
+    c.out.clear();
+    c.out_offset = 0;
+    c.in.clear();
+    c.busy = false;
+    c.streams.clear();
+    c.next_stream  = 1;
+    c.peer_streams = UINT32_MAX;
+    c.draining     = false;
+    c.unacked_data = 0;
+    c.hpack        = HpackDecoder();
+    c.block.clear();
+  }
+
+  /// Close @a c after an error, each request it had in flight failed.
+  void
+  fail(Connection &c, const char *what)
+  {
+    if (verbose) {
+      fprintf(stderr, "connection failed: %s\n", what);
+    }
+    counters.errors += std::max<size_t>(1, c.busy + c.streams.size());
+    close_connection(c, now_us() + RETRY_DELAY);
+  }
+
+  void
+  opened(Connection &c)
+  {
+    c.state = Connection::OPEN;
+    ++counters.open;
+    want_write(c, false);
+    if (h2) {
+      // The windows are opened all the way, the connection window is topped up as the data comes.
+      uint8_t settings[12];
+      h2_setting(settings, H2_SETTINGS_ENABLE_PUSH, 0);
+      h2_setting(settings + 6, H2_SETTINGS_INITIAL_WINDOW_SIZE, H2_MAX_WINDOW_SIZE);
+      uint8_t increment[4];
+      put_u32(increment, H2_MAX_WINDOW_SIZE - H2_INITIAL_WINDOW_SIZE);
+
+      c.out.append(H2_PREFACE, sizeof(H2_PREFACE) - 1);
+      h2_frame(c.out, H2_SETTINGS, 0, 0, settings, sizeof(settings));
+      h2_frame(c.out, H2_WINDOW_UPDATE, 0, 0, increment, sizeof(increment));
+      flush(c);
+    }
+  }
+
+  void
+  handshake(Connection &c)
+  {
+    int r = SSL_connect(c.ssl);
+    if (r == 1) {
+      const unsigned char *alpn = nullptr;
+      unsigned int alpn_len     = 0;
+      SSL_get0_alpn_selected(c.ssl, &alpn, &alpn_len);
+      if (h2 && (alpn_len != 2 || memcmp(alpn, "h2", 2) != 0)) {
+        fail(c, "the server did not negotiate h2");
+        return;
+      }
+      opened(c);
+      return;
+    }
+    switch (SSL_get_error(c.ssl, r)) {
+    case SSL_ERROR_WANT_READ:
+      want_write(c, false);
+      break;
+    case SSL_ERROR_WANT_WRITE:
+      want_write(c, true);
+      break;
+    default:
+      fail(c, "TLS handshake failed");
+      break;
+    }
+  }
+
+  void
+  handle(Connection &c, uint32_t events)
+  {
+    switch (c.state) {
+    case Connection::CLOSED:
+      // Closed by an earlier event of the same wait.
+      return;
+    case Connection::CONNECTING: {
+      int error     = 0;
+      socklen_t len = sizeof(error);
+      if (getsockopt(c.fd, SOL_SOCKET, SO_ERROR, &error, &len) != 0 || error != 0) {
+        fail(c, strerror(error ? error : errno));
+      } else if (tls) {
+        c.state = Connection::HANDSHAKE;
+        c.ssl   = SSL_new(_tls_ctx);
+        SSL_set_fd(c.ssl, c.fd);
+        std::string sni = *host_header ? host_header : proxy_host;
+        SSL_set_tlsext_host_name(c.ssl, sni.substr(0, sni.find(':')).c_str());
+        handshake(c);
+      } else {
+        opened(c);
+      }
+      return;
+    }
+    case Connection::HANDSHAKE:
+      handshake(c);
+      return;
+    case Connection::OPEN:
+      break;
+    }
+
+    if (events & EPOLLOUT) {
+      flush(c);
+    }
+    if (c.state == Connection::OPEN && (events & (EPOLLIN | EPOLLHUP | EPOLLERR))) {
+      receive(c);
+    }
+  }
+
+  void
+  flush(Connection &c)
+  {
+    while (c.state == Connection::OPEN && c.out_offset < c.out.size()) {
+      const char *data = c.out.data() + c.out_offset;
+      size_t len       = c.out.size() - c.out_offset;
+      ssize_t n;
+      if (c.ssl != nullptr) {
+        n = SSL_write(c.ssl, data, len);
+        if (n <= 0) {
+          int error = SSL_get_error(c.ssl, n);
+          if (error == SSL_ERROR_WANT_WRITE || error == SSL_ERROR_WANT_READ) {
+            want_write(c, error == SSL_ERROR_WANT_WRITE);
+            return;
+          }
+          fail(c, "TLS write failed");
+          return;
+        }
+      } else {
+        n = write(c.fd, data, len);
+        if (n < 0) {
+          if (errno == EAGAIN || errno == EINTR) {
+            want_write(c, true);
+            return;
+          }
+          fail(c, strerror(errno));
+          return;
+        }
+      }
+      c.out_offset += n;
+    }
+    if (c.state == Connection::OPEN) {
+      c.out.clear();
+      c.out_offset = 0;
+      want_write(c, false);
+    }
+  }
+
+  void
+  receive(Connection &c)
+  {
+    char buf[64 * 1024];
+    bool eof = false;
+    for (;;) {
+      ssize_t n;
+      if (c.ssl != nullptr) {
+        n = SSL_read(c.ssl, buf, sizeof(buf));
+        if (n <= 0) {
+          int error = SSL_get_error(c.ssl, n);
+          if (error == SSL_ERROR_WANT_READ || error == SSL_ERROR_WANT_WRITE) {
+            break;
+          }
+          eof = true;
+          break;
+        }
+      } else {
+        n = read(c.fd, buf, sizeof(buf));
+        if (n < 0 && (errno == EAGAIN || errno == EINTR)) {
+          break;
+        } else if (n <= 0) {
+          eof = true;
+          break;
+        }
+      }
+      c.in.append(buf, n);
+    }
+
+    int64_t now = now_us();
+    bool ok     = h2 ? receive_h2(c, now) : receive_h1(c, now);
+    if (!ok) {
+      fail(c, "bad response");
+    } else if (eof && c.state == Connection::OPEN) {
+      if (c.busy && c.in_body && c.body_left < 0) {
+        complete(c.current, c.current.status, now);
+        c.busy = false;
+      }
+      if (c.busy || !c.streams.empty()) {
+        fail(c, "closed by the server");
+      } else {
+        close_connection(c, now);
+      }
+    }
+  }
+
+  //
+  // HTTP/1.1
+  //
+
+  bool
+  receive_h1(Connection &c, int64_t now)
+  {
+    while (c.busy) {
+      if (!c.in_body) {
+        size_t end = c.in.find("\r\n\r\n");
+        if (end == std::string::npos) {
+          return c.in.size() < 64 * 1024;
+        }
+        if (c.in.compare(0, 7, "HTTP/1.") != 0 || end < 12) {
+          return false;
+        }
+        int status  = atoi(c.in.c_str() + 9);
+        c.body_left = -1;
+        c.chunked   = false;
+        for (size_t line = c.in.find("\r\n") + 2; line < end;) {
+          size_t eol   = c.in.find("\r\n", line);
+          size_t colon = c.in.find(':', line);
+          if (colon < eol) {
+            std::string name  = c.in.substr(line, colon - line);
+            size_t value      = std::min(c.in.find_first_not_of(" \t", colon + 1), eol);
+            std::string field = c.in.substr(value, eol - value);
+            if (strcasecmp(name.c_str(), "Content-Length") == 0) {
+              c.body_left = strtoll(field.c_str(), nullptr, 10);
+            } else if (strcasecmp(name.c_str(), "Transfer-Encoding") == 0 && strcasestr(field.c_str(), "chunked") != nullptr) {
+              c.chunked = true;
+            } else if (strcasecmp(name.c_str(), "Connection") == 0 && strcasestr(field.c_str(), "close") != nullptr) {
+              c.close_after = true;
+            }
+          }
+          line = eol + 2;
+        }
+        c.in.erase(0, end + 4);
+        if (status < 200) {
+          continue; // an interim response, the final one follows
+        }
+        c.current.status = status;
+        c.in_body        = true;
+        if (status == 204 || status == 304) {
+          c.body_left = 0;
+          c.chunked   = false;
+        } else if (c.chunked) {
+          c.chunk_left = CHUNK_SIZE;
+        } else if (c.body_left < 0) {
+          c.close_after = true;
+        }
+      }
+
+      if (c.chunked) {
+        if (!receive_chunks(c)) {
+          return c.chunk_left != CHUNK_SIZE || c.in.size() < 1024;
+        }
+      } else if (c.body_left < 0) {
+        c.in.clear();
+        return true;
+      } else {
+        int64_t n = std::min<int64_t>(c.body_left, c.in.size());
+        c.in.erase(0, n);
+        c.body_left -= n;
+        if (c.body_left > 0) {
+          return true;
+        }
+      }
+
+      complete(c.current, c.current.status, now);
+      c.busy = false;
+      if (c.close_after) {
+        close_connection(c, now);
+      }
+    }
+    return c.in.empty();
+  }
+
+  /// Skip the chunks of the body, return @c true at its end.
+  bool
+  receive_chunks(Connection &c)
+  {
+    for (;;) {
+      if (c.chunk_left > 0) {
+        int64_t n = std::min<int64_t>(c.chunk_left, c.in.size());
+        c.in.erase(0, n);
+        c.chunk_left -= n;
+        if (c.chunk_left > 0) {
+          return false;
+        }
+        c.chunk_left = CHUNK_CRLF;
+      }
+      if (c.chunk_left == CHUNK_CRLF) {
+        if (c.in.size() < 2) {
+          return false;
+        }
+        c.in.erase(0, 2);
+        c.chunk_left = CHUNK_SIZE;
+      }
+      size_t eol = c.in.find("\r\n");
+      if (eol == std::string::npos) {
+        return false;
+      }
+      if (c.chunk_left == CHUNK_TRAILERS) {
+        c.in.erase(0, eol + 2);
+        if (eol == 0) {
+          return true;
+        }
+        continue;
+      }
+      int64_t size = strtoll(c.in.c_str(), nullptr, 16);
+      c.in.erase(0, eol + 2);
+      c.chunk_left = size > 0 ? size : CHUNK_TRAILERS;
+    }
+  }
+
+  //
+  // HTTP/2
+  //
+
+  bool
+  receive_h2(Connection &c, int64_t now)
+  {
+    size_t offset = 0;
+    while (c.state == Connection::OPEN && c.in.size() - offset >= 9) {
+      const uint8_t *frame = reinterpret_cast<const uint8_t *>(c.in.data()) + offset;
+      size_t len           = (frame[0] << 16) | (frame[1] << 8) | frame[2];
+      if (c.in.size() - offset < 9 + len) {
+        break;
+      }
+      if (!h2_frame_received(c, frame[3], frame[4], get_u32(frame + 5) & 0x7fffffff, frame + 9, len, now)) {
+        return false;
+      }
+      offset += 9 + len;
+    }
+    if (c.state == Connection::OPEN) {
+      c.in.erase(0, offset);
+      flush(c);
+    }
+    return true;
+  }
+
+  bool
+  h2_frame_received(Connection &c, uint8_t type, uint8_t flags, uint32_t stream, const uint8_t *payload, size_t len, int64_t now)
+  {
+    static constexpr uint64_t WINDOW_UPDATE_THRESHOLD = 1 << 30;
+
+    switch (type) {
+    case H2_DATA:
+      c.unacked_data += len;
+      if (c.unacked_data >= WINDOW_UPDATE_THRESHOLD) {
+        uint8_t increment[4];
+        put_u32(increment, c.unacked_data);
+        h2_frame(c.out, H2_WINDOW_UPDATE, 0, 0, increment, sizeof(increment));
+        c.unacked_data = 0;
+      }
+      if (flags & H2_FLAG_END_STREAM) {
+        stream_done(c, stream, now);
+      }
+      break;
+    case H2_HEADERS: {
+      size_t skip = 0, pad = 0;
+      if (flags & H2_FLAG_PADDED) {
+        pad  = len > 0 ? payload[0] : 0;
+        skip = 1;
+      }
+      if (flags & H2_FLAG_PRIORITY) {
+        skip += 5;
+      }
+      if (skip + pad > len) {
+        return false;
+      }
+      c.block.assign(reinterpret_cast<const char *>(payload) + skip, len - skip - pad);
+      c.block_stream = stream;
+      c.block_flags  = flags;
+      if (flags & H2_FLAG_END_HEADERS) {
+        return headers_received(c, now);
+      }
+      break;
+    }
+    case H2_CONTINUATION:
+      if (stream != c.block_stream) {
+        return false;
+      }
+      c.block.append(reinterpret_cast<const char *>(payload), len);
+      if (flags & H2_FLAG_END_HEADERS) {
+        return headers_received(c, now);
+      }
+      break;
+    case H2_RST_STREAM:
+      if (c.streams.erase(stream)) {
+        ++counters.errors;
+      }
+      break;
+    case H2_SETTINGS:
+      if (!(flags & H2_FLAG_ACK)) {
+        for (size_t i = 0; i + 6 <= len; i += 6) {
+          if (((payload[i] << 8) | payload[i + 1]) == H2_SETTINGS_MAX_CONCURRENT_STREAMS) {
+            c.peer_streams = get_u32(payload + i + 2);
+          }
+        }
+        h2_frame(c.out, H2_SETTINGS, H2_FLAG_ACK, 0, nullptr, 0);
+      }
+      break;
+    case H2_PING:
+      if (!(flags & H2_FLAG_ACK)) {
+        h2_frame(c.out, H2_PING, H2_FLAG_ACK, 0, payload, len);
+      }
+      break;
+    case H2_GOAWAY: {
+      // The streams after the last one were not processed, send them again on another connection.
+      uint32_t last = len >= 4 ? get_u32(payload) & 0x7fffffff : 0;
+      for (auto spot = c.streams.begin(); spot != c.streams.end();) {
+        if (spot->first > last) {
+          _pending.push_front(spot->second.request);
+          spot = c.streams.erase(spot);
+        } else {
+          ++spot;
+        }
+      }
+      c.draining = true;
+      break;
+    }
+    default:
+      break;
+    }
+    if (c.draining && c.streams.empty()) {
+      close_connection(c, now);
+    }
+    return true;
+  }
+
+  bool
+  headers_received(Connection &c, int64_t now)
+  {
+    int status = 0;
+    if (!c.hpack.decode(reinterpret_cast<const uint8_t *>(c.block.data()),
+                        reinterpret_cast<const uint8_t *>(c.block.data()) + c.block.size(), status)) {
+      return false;
+    }
+    auto spot = c.streams.find(c.block_stream);
+    if (spot != c.streams.end() && spot->second.status < 200 && status != 0) {
+      spot->second.status = status;
+    }
+    if (c.block_flags & H2_FLAG_END_STREAM) {
+      stream_done(c, c.block_stream, now);
+    }
+    return true;
+  }
+
+  void
+  stream_done(Connection &c, uint32_t stream, int64_t now)
+  {
+    auto spot = c.streams.find(stream);
+    if (spot != c.streams.end()) {
+      complete(spot->second, spot->second.status, now);
+      c.streams.erase(spot);
+    }
+  }
+
+  int _index;
+  struct sockaddr_storage _addr;
+  socklen_t _addr_len;
+  SSL_CTX *_tls_ctx;
+  int _epoll       = -1;
+  int64_t _start   = 0;
+  double _interval = 0; ///< Between the requests of this thread, in microseconds.
+  uint64_t _sent   = 0; ///< Requests scheduled so far.
+  size_t _next_target     = 0;
+  size_t _next_connection = 0;
+  std::vector<Connection> _connections;
+  std::deque<Request> _pending;
+};
+
+static bool
+load_targets()
+{
+  if (*url_file == '\0') {
+    targets.push_back(make_target(url));
+    return true;
+  }
+  FILE *fp = fopen(url_file, "r");
+  if (fp == nullptr) {
+    fprintf(stderr, "unable to open %s: %s\n", url_file, strerror(errno));
+    return false;
+  }
+  char line[4096];
+  while (fgets(line, sizeof(line), fp) != nullptr) {
+    std::string spec(line);
+    spec.erase(spec.find_last_not_of(" \t\r\n") + 1);
+    if (!spec.empty() && spec[0] != '#') {
+      targets.push_back(make_target(spec));
+    }
+  }
+  fclose(fp);
+  if (targets.empty()) {
+    fprintf(stderr, "no URLs in %s\n", url_file);
+    return false;
+  }
+  return true;
+}
+
+int
+main(int /* argc ATS_UNUSED */, const char *argv[])
+{
+  appVersionInfo.setup(PACKAGE_NAME, "traffic_load", PACKAGE_VERSION, __DATE__, __TIME__, BUILD_MACHINE, BUILD_PERSON, "");
+  process_args(&appVersionInfo, argument_descriptions, countof(argument_descriptions), argv);
+  setvbuf(stdout, nullptr, _IOLBF, 0);
+  signal(SIGPIPE, SIG_IGN);
+
+  nthreads     = std::max(1, nthreads);
+  nconnections = std::max(nthreads, nconnections);
+  max_streams  = std::max(1, max_streams);
+  if (rate <= 0 || duration <= 0) {
+    usage(argument_descriptions, countof(argument_descriptions), "Usage: traffic_load [options]");
+  }
+
+  hpack_huffman_init();
+  if (!load_targets()) {
+    return 1;
+  }
+
+  struct addrinfo hints, *ai = nullptr;
+  memset(&hints, 0, sizeof(hints));
+  hints.ai_socktype = SOCK_STREAM;
+  if (getaddrinfo(proxy_host, std::to_string(proxy_port).c_str(), &hints, &ai) != 0 || ai == nullptr) {
+    fprintf(stderr, "unable to resolve %s\n", proxy_host);
+    return 1;
+  }
+  struct sockaddr_storage addr;
+  socklen_t addr_len = ai->ai_addrlen;
+  memcpy(&addr, ai->ai_addr, ai->ai_addrlen);
+  freeaddrinfo(ai);
+
+  SSL_CTX *tls_ctx = nullptr;
+  if (tls) {
+    SSL_library_init();
+    SSL_load_error_strings();
+    tls_ctx = SSL_CTX_new(SSLv23_client_method());
+    SSL_CTX_set_verify(tls_ctx, SSL_VERIFY_NONE, nullptr);
+    SSL_CTX_set_mode(tls_ctx, SSL_MODE_ENABLE_PARTIAL_WRITE | SSL_MODE_ACCEPT_MOVING_WRITE_BUFFER);
+    if (h2) {
+      SSL_CTX_set_alpn_protos(tls_ctx, reinterpret_cast<const unsigned char *>("\x02h2"), 3);
+    } else {
+      SSL_CTX_set_alpn_protos(tls_ctx, reinterpret_cast<const unsigned char *>("\x08http/1.1"), 9);
+    }
+  }
+
+  printf("%.0f requests/sec for %d seconds over %d %s%s connections, %d threads\n", rate, duration, nconnections,
+         h2 ? "HTTP/2" : "HTTP/1.1", tls ? " TLS" : "", nthreads);
+
+  // Give the connections a moment to open before the first requests are due.
+  int64_t start = now_us() + 500000;
+  int64_t end   = start + duration * 1000000LL;
+  std::vector<std::unique_ptr<Worker>> workers;
+  std::vector<std::thread> threads;
+  std::atomic<int> running{nthreads};
+  for (int i = 0; i < nthreads; ++i) {
+    workers.emplace_back(new Worker(i, addr, addr_len, tls_ctx));
+  }
+  for (auto &worker : workers) {
+    threads.emplace_back([&worker, &running, start, end]() {
+      worker->run(start, end);
+      --running;
+    });
+  }
+
+  printf("%6s %10s %8s %8s %8s %6s\n", "sec", "done/sec", "errors", "timeouts", "queued", "conns");
+  uint64_t last_completed = 0;
+  for (int second = 1; running > 0; ++second) {
+    std::this_thread::sleep_until(Clock::time_point(std::chrono::microseconds(start + second * 1000000LL)));
+    uint64_t completed = 0, errors = 0, timeouts = 0, queued = 0, open = 0;
+    for (auto &worker : workers) {
+      completed += worker->counters.completed;
+      errors += worker->counters.errors;
+      timeouts += worker->counters.timeouts;
+      queued += worker->counters.queued;
+      open += worker->counters.open;
+    }
+    printf("%6d %10" PRIu64 " %8" PRIu64 " %8" PRIu64 " %8" PRIu64 " %6" PRIu64 "\n", second, completed - last_completed, errors,
+           timeouts, queued, open);
+    last_completed = completed;
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  Histogram latency;
+  uint64_t completed = 0, errors = 0, timeouts = 0, statuses[6] = {0};
+  int64_t finished   = start;
+  for (auto &worker : workers) {
+    latency.merge(worker->latency);
+    finished = std::max(finished, worker->finished);
+    completed += worker->counters.completed;
+    errors += worker->counters.errors;
+    timeouts += worker->counters.timeouts;
+    for (int i = 0; i < 6; ++i) {
+      statuses[i] += worker->statuses[i];
+    }
+  }
+  double elapsed = std::max(1e-6, (finished - start) / 1e6);
+  printf("%" PRIu64 " requests in %.3f s (%.1f/s of %.1f/s), %" PRIu64 " errors, %" PRIu64 " timeouts\n", completed, elapsed,
+         completed / elapsed, rate, errors, timeouts);
+  printf("status 1xx %" PRIu64 ", 2xx %" PRIu64 ", 3xx %" PRIu64 ", 4xx %" PRIu64 ", 5xx %" PRIu64 ", bad %" PRIu64 "\n",
+         statuses[1], statuses[2], statuses[3], statuses[4], statuses[5], statuses[0]);
+  latency.print(stdout);
+
+  if (*hgrm_file) {
+    FILE *fp = fopen(hgrm_file, "w");
+    if (fp == nullptr) {
+      fprintf(stderr, "unable to write %s: %s\n", hgrm_file, strerror(errno));
+      return 1;
+    }
+    latency.print_hgrm(fp);
+    fclose(fp);
+  }
+  return errors == 0 && timeouts == 0 ? 0 : 1;
+}
@@ -0,0 +1,1032 @@
+/** @file
+
+  Replay the sessions captured by the traffic_dump plugin, for load testing.
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ */
+
+// The client sends the client requests of the captured sessions to the proxy, one connection per
+// session, at the times and with the concurrency they were captured with. It adds a "uuid" field
+// with the transaction UUID to each request, the server looks the field up to answer with the
+// captured server response, so the origin side of the proxy sees the captured traffic as well.
+// The same process can be both, or they can run on different hosts.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cinttypes>
+#include <climits>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <dirent.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include <openssl/err.h>
+#include <openssl/ssl.h>
+
+#include <yaml-cpp/yaml.h>
+
+#include "tscore/ink_defs.h"
+#include "tscore/ink_args.h"
+#include "tscore/I_Version.h"
+
+using Clock = std::chrono::steady_clock;
+
+static AppVersionInfo appVersionInfo;
+
+static char proxy_host[256]  = "127.0.0.1";
+static int proxy_port        = 0;
+static int proxy_tls_port    = 0;
+static int server_port       = 0;
+static int server_tls_port   = 0;
+static char server_cert[256] = "";
+static char server_key[256]  = "";
+static int nthreads          = 64;
+static double speed          = 1.0;
+static int repeat            = 1;
+static int io_timeout        = 30;
+static int verbose           = 0;
+
+static const ArgumentDescription argument_descriptions[] = {
+  {"proxy_host", 'P', "Proxy Host", "S255", proxy_host, "REPLAY_PROXY_HOST", nullptr},
+  {"proxy_port", 'p', "Proxy Port (0:no client)", "I", &proxy_port, "REPLAY_PROXY_PORT", nullptr},
+  {"proxy_tls_port", 'q', "Proxy TLS Port, for the TLS sessions", "I", &proxy_tls_port, "REPLAY_PROXY_TLS_PORT", nullptr},
+  {"server_port", 's', "Server Port (0:no server)", "I", &server_port, "REPLAY_SERVER_PORT", nullptr},
+  {"server_tls_port", 'S', "Server TLS Port", "I", &server_tls_port, "REPLAY_SERVER_TLS_PORT", nullptr},
+  {"server_cert", 'c', "Server Certificate Chain (PEM)", "S255", server_cert, "REPLAY_SERVER_CERT", nullptr},
+  {"server_key", 'k', "Server Private Key (PEM, default: certificate)", "S255", server_key, "REPLAY_SERVER_KEY", nullptr},
+  {"threads", 't', "Client Threads (most sessions at once)", "I", &nthreads, "REPLAY_THREADS", nullptr},
+  {"speed", 'r', "Replay Speed (1:as captured, 0:no delays)", "D", &speed, "REPLAY_SPEED", nullptr},
+  {"repeat", 'n', "Number of Times to Replay", "I", &repeat, "REPLAY_REPEAT", nullptr},
+  {"timeout", 'T', "Network Timeout (seconds)", "I", &io_timeout, "REPLAY_TIMEOUT", nullptr},
+  {"verbose", 'v', "Verbose Flag", "F", &verbose, "REPLAY_VERBOSE", nullptr},
+  HELP_ARGUMENT_DESCRIPTION(),
+  VERSION_ARGUMENT_DESCRIPTION()};
+
+//
+// The captured sessions.
+//
+
+using Fields = std::vector<std::pair<std::string, std::string>>;
+
+struct Message {
+  bool present = false;
+  std::string method;
+  std::string url;
+  int status = 0;
+  std::string reason;
+  Fields fields;
+  int64_t body_size = 0;
+  std::string body; ///< The captured content, if there is any, else @a body_size bytes are made up.
+  bool has_body_data = false;
+};
+
+struct Transaction {
+  std::string uuid;
+  double start_time = 0; ///< Seconds since the epoch, 0 if not known.
+  Message client_request;
+  Message proxy_request;
+  Message server_response;
+  Message proxy_response;
+};
+
+struct Session {
+  bool tls            = false;
+  bool h2             = false;
+  double connect_time = 0; ///< Seconds since the epoch, 0 if not known.
+  std::vector<Transaction> transactions;
+};
+
+// traffic_dump writes nanoseconds, the schema allows seconds.
+static double
+epoch_seconds(const YAML::Node &node)
+{
+  if (!node) {
+    return 0;
+  }
+  double t = node.as<double>();
+  return t > 1e12 ? t / 1e9 : t;
+}
+
+static std::string
+decode(const std::string &value, const std::string &encoding)
+{
+  if (encoding != "uri") {
+    return value; // "esc_json" was undone by the parser.
+  }
+  std::string result;
+  for (size_t i = 0; i < value.size(); ++i) {
+    if (value[i] == '%' && i + 2 < value.size() && isxdigit(value[i + 1]) && isxdigit(value[i + 2])) {
+      result += static_cast<char>(std::stoi(value.substr(i + 1, 2), nullptr, 16));
+      i += 2;
+    } else {
+      result += value[i];
+    }
+  }
+  return result;
+}
+
+static void
+load_message(const YAML::Node &node, Message &msg)
+{
+  if (!node || !node.IsMap()) {
+    return;
+  }
+  msg.present = true;
+  if (node["method"]) {
+    msg.method = node["method"].as<std::string>();
+  }
+  if (node["url"]) {
+    msg.url = node["url"].as<std::string>();
+  }
+  if (node["status"]) {
+    msg.status = node["status"].as<int>();
+  }
+  if (node["reason"]) {
+    msg.reason = node["reason"].as<std::string>();
+  }
+  if (const YAML::Node headers = node["headers"]; headers && headers["fields"]) {
+    std::string encoding = headers["encoding"] ? headers["encoding"].as<std::string>() : "plain";
+    for (const auto &field : headers["fields"]) {
+      if (field.IsSequence() && field.size() == 2) {
+        msg.fields.emplace_back(field[0].as<std::string>(), decode(field[1].as<std::string>(), encoding));
+      }
+    }
+  }
+  if (const YAML::Node content = node["content"]; content && content.IsMap()) {
+    if (content["data"]) {
+      std::string encoding = content["encoding"] ? content["encoding"].as<std::string>() : "plain";
+      msg.body             = decode(content["data"].as<std::string>(), encoding);
+      msg.body_size        = msg.body.size();
+      msg.has_body_data    = true;
+    } else if (content["size"]) {
+      msg.body_size = std::max(static_cast<int64_t>(0), content["size"].as<int64_t>());
+    }
+  }
+}
+
+static bool
+load_file(const std::string &path, std::vector<Session> &sessions)
+{
+  try {
+    YAML::Node root = YAML::LoadFile(path);
+    for (const auto &s : root["sessions"]) {
+      Session session;
+      for (const auto &tag : s["protocol"]) {
+        std::string t = tag.as<std::string>();
+        session.tls |= t.compare(0, 3, "tls") == 0;
+        session.h2 |= t == "h2";
+      }
+      // traffic_dump writes "connection-time", the schema says "connect-time".
+      session.connect_time = epoch_seconds(s["connect-time"] ? s["connect-time"] : s["connection-time"]);
+      for (const auto &t : s["transactions"]) {
+        Transaction txn;
+        if (t["uuid"]) {
+          txn.uuid = t["uuid"].as<std::string>();
+        }
+        txn.start_time = epoch_seconds(t["start-time"]);
+        load_message(t["client-request"], txn.client_request);
+        load_message(t["proxy-request"], txn.proxy_request);
+        load_message(t["server-response"], txn.server_response);
+        load_message(t["proxy-response"], txn.proxy_response);
+        if (txn.client_request.present && !txn.client_request.method.empty()) {
+          session.transactions.push_back(std::move(txn));
+        }
+      }
+      if (!session.transactions.empty()) {
+        sessions.push_back(std::move(session));
+      }
+    }
+  } catch (const YAML::Exception &e) {
+    // A session still being written, or cut off by a restart, does not parse.
+    fprintf(stderr, "skipping %s: %s\n", path.c_str(), e.what());
+    return false;
+  }
+  return true;
+}
+
+static void
+load_path(const std::string &path, std::vector<Session> &sessions)
+{
+  struct stat st;
+  if (stat(path.c_str(), &st) != 0) {
+    fprintf(stderr, "skipping %s: %s\n", path.c_str(), strerror(errno));
+    return;
+  }
+  if (!S_ISDIR(st.st_mode)) {
+    load_file(path, sessions);
+    return;
+  }
+  // traffic_dump spreads the sessions over subdirectories.
+  DIR *dir = opendir(path.c_str());
+  if (dir == nullptr) {
+    fprintf(stderr, "skipping %s: %s\n", path.c_str(), strerror(errno));
+    return;
+  }
+  std::vector<std::string> names;
+  while (struct dirent *entry = readdir(dir)) {
+    if (entry->d_name[0] != '.') {
+      names.emplace_back(entry->d_name);
+    }
+  }
+  closedir(dir);
+  std::sort(names.begin(), names.end());
+  for (const auto &name : names) {
+    load_path(path + "/" + name, sessions);
+  }
+}
+
+//
+// HTTP/1.1 over a blocking socket, with or without TLS.
+//
+
+class Connection
+{
+public:
+  Connection() = default;
+  Connection(int fd, SSL *ssl) : _fd(fd), _ssl(ssl) {}
+  ~Connection() { close(); }
+  Connection(const Connection &) = delete;
+  Connection &operator=(const Connection &) = delete;
+
+  bool
+  is_open() const
+  {
+    return _fd >= 0;
+  }
+
+  bool
+  connect(const char *host, int port, SSL_CTX *tls_ctx, const std::string &sni)
+  {
+    struct addrinfo hints, *addrs = nullptr;
+    char service[16];
+
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family   = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    snprintf(service, sizeof(service), "%d", port);
+    if (getaddrinfo(host, service, &hints, &addrs) != 0) {
+      return false;
+    }
+    for (struct addrinfo *a = addrs; a && _fd < 0; a = a->ai_next) {
+      _fd = socket(a->ai_family, a->ai_socktype, a->ai_protocol);
+      if (_fd >= 0 && ::connect(_fd, a->ai_addr, a->ai_addrlen) != 0) {
+        ::close(_fd);
+        _fd = -1;
+      }
+    }
+    freeaddrinfo(addrs);
+    if (_fd < 0) {
+      return false;
+    }
+    setup_socket(_fd);
+
+    if (tls_ctx != nullptr) {
+      _ssl = SSL_new(tls_ctx);
+      SSL_set_fd(_ssl, _fd);
+      if (!sni.empty()) {
+        SSL_set_tlsext_host_name(_ssl, sni.c_str());
+      }
+      if (SSL_connect(_ssl) != 1) {
+        close();
+        return false;
+      }
+    }
+    return true;
+  }
+
+  static void
+  setup_socket(int fd)
+  {
+    struct timeval tv = {io_timeout, 0};
+    int one           = 1;
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+  }
+
+  void
+  close()
+  {
+    if (_ssl != nullptr) {
+      SSL_shutdown(_ssl);
+      SSL_free(_ssl);
+      _ssl = nullptr;
+    }
+    if (_fd >= 0) {
+      ::close(_fd);
+      _fd = -1;
+    }
+    _buf.clear();
+    _pos = 0;
+  }
+
+  bool
+  write(const char *data, size_t len)
+  {
+    while (len > 0) {
+      ssize_t n = _ssl ? SSL_write(_ssl, data, static_cast<int>(std::min(len, static_cast<size_t>(INT_MAX)))) :
+                         send(_fd, data, len, MSG_NOSIGNAL);
+      if (n <= 0) {
+        return false;
+      }
+      data += n;
+      len -= n;
+    }
+    return true;
+  }
+
+  bool
+  write(const std::string &s)
+  {
+    return write(s.data(), s.size());
+  }
+
+  /// Write @a size bytes of @a data, or of filler if there is no @a data.
+  bool
+  write_body(const Message &msg, int64_t size)
+  {
+    static const std::string filler(16384, 'x');
+
+    if (msg.has_body_data) {
+      return write(msg.body.data(), std::min(static_cast<size_t>(size), msg.body.size()));
+    }
+    while (size > 0) {
+      size_t n = std::min(static_cast<size_t>(size), filler.size());
+      if (!write(filler.data(), n)) {
+        return false;
+      }
+      size -= n;
+    }
+    return true;
+  }
+
+  bool
+  read_line(std::string &line)
+  {
+    for (;;) {
+      size_t eol = _buf.find('\n', _pos);
+      if (eol != std::string::npos) {
+        line.assign(_buf, _pos, eol - _pos);
+        if (!line.empty() && line.back() == '\r') {
+          line.pop_back();
+        }
+        _pos = eol + 1;
+        return true;
+      }
+      if (!fill()) {
+        return false;
+      }
+    }
+  }
+
+  /// Read and drop @a n bytes, or up to the end of the connection if @a n is negative.
+  bool
+  skip(int64_t n)
+  {
+    while (n != 0) {
+      if (_pos == _buf.size() && !fill()) {
+        return n < 0;
+      }
+      size_t avail = _buf.size() - _pos;
+      size_t take  = n < 0 ? avail : std::min(avail, static_cast<size_t>(n));
+      _pos += take;
+      if (n > 0) {
+        n -= take;
+      }
+    }
+    return true;
+  }
+
+private:
+  bool
+  fill()
+  {
+    char chunk[32768];
+
+    if (_pos > 0) {
+      _buf.erase(0, _pos);
+      _pos = 0;
+    }
+    ssize_t n = _ssl ? SSL_read(_ssl, chunk, sizeof(chunk)) : recv(_fd, chunk, sizeof(chunk), 0);
+    if (n <= 0) {
+      return false;
+    }
+    _buf.append(chunk, n);
+    return true;
+  }
+
+  int _fd   = -1;
+  SSL *_ssl = nullptr;
+  std::string _buf;
+  size_t _pos = 0;
+};
+
+static bool
+iequals(const std::string &a, const char *b)
+{
+  return strcasecmp(a.c_str(), b) == 0;
+}
+
+static const std::string *
+find_field(const Fields &fields, const char *name)
+{
+  for (const auto &field : fields) {
+    if (iequals(field.first, name)) {
+      return &field.second;
+    }
+  }
+  return nullptr;
+}
+
+// The framing of a message is made up again for the size it is sent with.
+static bool
+is_hop_field(const std::string &name)
+{
+  return iequals(name, "Content-Length") || iequals(name, "Transfer-Encoding") || iequals(name, "Connection") ||
+         iequals(name, "Keep-Alive") || iequals(name, "Proxy-Connection") || iequals(name, "uuid");
+}
+
+static bool
+read_header(Connection &conn, std::string &start_line, Fields &fields)
+{
+  std::string line;
+
+  fields.clear();
+  do {
+    if (!conn.read_line(start_line)) {
+      return false;
+    }
+  } while (start_line.empty());
+
+  while (conn.read_line(line)) {
+    if (line.empty()) {
+      return true;
+    }
+    size_t colon = line.find(':');
+    if (colon != std::string::npos) {
+      size_t value = line.find_first_not_of(" \t", colon + 1);
+      fields.emplace_back(line.substr(0, colon), value == std::string::npos ? "" : line.substr(value));
+    }
+  }
+  return false;
+}
+
+/// Read the body framed by @a fields, @a to_close is set if it ends with the connection.
+static bool
+read_body(Connection &conn, const Fields &fields, bool is_response, bool &to_close)
+{
+  const std::string *te = find_field(fields, "Transfer-Encoding");
+  const std::string *cl = find_field(fields, "Content-Length");
+
+  if (te != nullptr && strcasestr(te->c_str(), "chunked") != nullptr) {
+    std::string line;
+    for (;;) {
+      if (!conn.read_line(line)) {
+        return false;
+      }
+      int64_t size = strtoll(line.c_str(), nullptr, 16);
+      if (size == 0) {
+        // Trailers, up to the empty line.
+        while (conn.read_line(line) && !line.empty()) {
+        }
+        return true;
+      }
+      if (!conn.skip(size) || !conn.read_line(line)) {
+        return false;
+      }
+    }
+  }
+  if (cl != nullptr) {
+    return conn.skip(strtoll(cl->c_str(), nullptr, 10));
+  }
+  if (is_response) {
+    to_close = true;
+    return conn.skip(-1);
+  }
+  return true;
+}
+
+static bool
+wants_close(const Fields &fields)
+{
+  const std::string *c = find_field(fields, "Connection");
+  return c != nullptr && strcasestr(c->c_str(), "close") != nullptr;
+}
+
+static bool
+response_has_body(const std::string &method, int status)
+{
+  return method != "HEAD" && status >= 200 && status != 204 && status != 304;
+}
+
+// The path of a URL, as the origin server gets it.
+static std::string
+url_path(const std::string &url)
+{
+  size_t scheme = url.find("://");
+  if (scheme == std::string::npos || url[0] == '/') {
+    return url;
+  }
+  size_t path = url.find('/', scheme + 3);
+  return path == std::string::npos ? "/" : url.substr(path);
+}
+
+//
+// Latencies.
+//
+
+/// Counts of latencies in microseconds, in 16 buckets for each power of two.
+class Histogram
+{
+public:
+  static constexpr int SUB     = 16;
+  static constexpr int BUCKETS = 61 * SUB;
+
+  void
+  add(uint64_t us)
+  {
+    ++_counts[index(us)];
+    ++_count;
+    _sum += us;
+    _min = std::min(_min, us);
+    _max = std::max(_max, us);
+  }
+
+  void
+  merge(const Histogram &that)
+  {
+    for (int i = 0; i < BUCKETS; ++i) {
+      _counts[i] += that._counts[i];
+    }
+    _count += that._count;
+    _sum += that._sum;
+    _min = std::min(_min, that._min);
+    _max = std::max(_max, that._max);
+  }
+
+  /// The least latency that @a p of the latencies are not above, to within a bucket.
+  uint64_t
+  percentile(double p) const
+  {
+    uint64_t rank = static_cast<uint64_t>(p * _count + 0.5);
+    uint64_t seen = 0;
+    for (int i = 0; i < BUCKETS; ++i) {
+      seen += _counts[i];
+      if (seen >= rank && seen > 0) {
+        return std::min(upper(i), _max);
+      }
+    }
+    return _max;
+  }
+
+  void
+  print(FILE *fp) const
+  {
+    if (_count == 0) {
+      fprintf(fp, "no latencies\n");
+      return;
+    }
+    fprintf(fp, "latency (ms): min %.3f mean %.3f p50 %.3f p90 %.3f p99 %.3f p99.9 %.3f max %.3f\n", _min / 1000.0,
+            _sum / 1000.0 / _count, percentile(0.5) / 1000.0, percentile(0.9) / 1000.0, percentile(0.99) / 1000.0,
+            percentile(0.999) / 1000.0, _max / 1000.0);
+    // Powers of two are enough to see the shape.
+    uint64_t seen = 0;
+    for (int i = 0; i < BUCKETS; i += SUB) {
+      uint64_t n = 0;
+      for (int j = i; j < i + SUB; ++j) {
+        n += _counts[j];
+      }
+      if (n > 0) {
+        seen += n;
+        fprintf(fp, "  <= %10.3f ms %10" PRIu64 " %6.2f%% %6.2f%%\n", upper(i + SUB - 1) / 1000.0, n, 100.0 * n / _count,
+                100.0 * seen / _count);
+      }
+    }
+  }
+
+private:
+  static int
+  index(uint64_t v)
+  {
+    if (v < SUB) {
+      return static_cast<int>(v);
+    }
+    int e = 63 - __builtin_clzll(v);
+    return (e - 3) * SUB + static_cast<int>((v >> (e - 4)) - SUB);
+  }
+
+  static uint64_t
+  upper(int i)
+  {
+    if (i < SUB) {
+      return i;
+    }
+    int e = i / SUB + 3;
+    return ((static_cast<uint64_t>(i % SUB + SUB) + 1) << (e - 4)) - 1;
+  }
+
+  uint64_t _counts[BUCKETS] = {0};
+  uint64_t _count           = 0;
+  uint64_t _sum             = 0;
+  uint64_t _min             = UINT64_MAX;
+  uint64_t _max             = 0;
+};
+
+struct Stats {
+  Histogram latency;
+  uint64_t sessions       = 0;
+  uint64_t transactions   = 0;
+  uint64_t errors         = 0; ///< Connections or transactions that failed.
+  uint64_t mismatches     = 0; ///< Responses with another status than the proxy sent when captured.
+  uint64_t late_sessions  = 0; ///< Sessions that started more than a second after their time.
+  uint64_t h2_sessions    = 0; ///< Captured over HTTP/2, replayed over HTTP/1.1.
+  uint64_t tls_downgraded = 0; ///< Captured over TLS, replayed without it as there is no TLS port.
+
+  void
+  merge(const Stats &that)
+  {
+    latency.merge(that.latency);
+    sessions += that.sessions;
+    transactions += that.transactions;
+    errors += that.errors;
+    mismatches += that.mismatches;
+    late_sessions += that.late_sessions;
+    h2_sessions += that.h2_sessions;
+    tls_downgraded += that.tls_downgraded;
+  }
+};
+
+//
+// The server.
+//
+
+class Responses
+{
+public:
+  void
+  add(const Transaction &txn)
+  {
+    if (!txn.server_response.present) {
+      return;
+    }
+    if (!txn.uuid.empty()) {
+      _by_uuid[txn.uuid] = &txn.server_response;
+    }
+    const Message &req = txn.proxy_request.present ? txn.proxy_request : txn.client_request;
+    _by_url[req.method + ' ' + url_path(req.url)] = &txn.server_response;
+  }
+
+  /// The response for the transaction in the "uuid" field, else the last one for the URL.
+  const Message *
+  find(const std::string *uuid, const std::string &method, const std::string &url) const
+  {
+    if (uuid != nullptr) {
+      if (auto spot = _by_uuid.find(*uuid); spot != _by_uuid.end()) {
+        return spot->second;
+      }
+    }
+    auto spot = _by_url.find(method + ' ' + url_path(url));
+    return spot == _by_url.end() ? nullptr : spot->second;
+  }
+
+private:
+  std::unordered_map<std::string, const Message *> _by_uuid;
+  std::unordered_map<std::string, const Message *> _by_url;
+};
+
+static Responses responses;
+
+static void
+serve(int fd, SSL_CTX *tls_ctx)
+{
+  SSL *ssl = nullptr;
+
+  Connection::setup_socket(fd);
+  if (tls_ctx != nullptr) {
+    ssl = SSL_new(tls_ctx);
+    SSL_set_fd(ssl, fd);
+    if (SSL_accept(ssl) != 1) {
+      SSL_free(ssl);
+      close(fd);
+      return;
+    }
+  }
+
+  Connection conn(fd, ssl);
+  std::string request_line;
+  Fields fields;
+  while (read_header(conn, request_line, fields)) {
+    bool to_close = false;
+    if (!read_body(conn, fields, false, to_close)) {
+      break;
+    }
+    size_t sp1         = request_line.find(' ');
+    size_t sp2         = request_line.find(' ', sp1 + 1);
+    std::string method = request_line.substr(0, sp1);
+    std::string url    = sp1 == std::string::npos ? "" : request_line.substr(sp1 + 1, sp2 - sp1 - 1);
+
+    const Message *resp = responses.find(find_field(fields, "uuid"), method, url);
+    std::string header;
+    int64_t body_size = 0;
+    if (resp == nullptr) {
+      if (verbose) {
+        fprintf(stderr, "no response for %s\n", request_line.c_str());
+      }
+      header = "HTTP/1.1 404 Not Found\r\nContent-Length: 0\r\n";
+    } else {
+      header = "HTTP/1.1 " + std::to_string(resp->status) + ' ' + resp->reason + "\r\n";
+      for (const auto &field : resp->fields) {
+        if (!is_hop_field(field.first)) {
+          header += field.first + ": " + field.second + "\r\n";
+        }
+      }
+      if (resp->status >= 200 && resp->status != 204 && resp->status != 304) {
+        body_size = resp->body_size;
+        header += "Content-Length: " + std::to_string(body_size) + "\r\n";
+      }
+    }
+    bool done = wants_close(fields);
+    if (done) {
+      header += "Connection: close\r\n";
+    }
+    header += "\r\n";
+    if (!conn.write(header) || (resp != nullptr && method != "HEAD" && !conn.write_body(*resp, body_size)) || done) {
+      break;
+    }
+  }
+}
+
+static bool
+listen_on(int port, SSL_CTX *tls_ctx)
+{
+  int fd  = socket(AF_INET6, SOCK_STREAM, 0);
+  int one = 1, zero = 0;
+  struct sockaddr_in6 addr;
+
+  memset(&addr, 0, sizeof(addr));
+  addr.sin6_family = AF_INET6;
+  addr.sin6_addr   = in6addr_any;
+  addr.sin6_port   = htons(port);
+  if (fd < 0 || setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one)) != 0 ||
+      setsockopt(fd, IPPROTO_IPV6, IPV6_V6ONLY, &zero, sizeof(zero)) != 0 ||
+      bind(fd, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr)) != 0 || listen(fd, 1024) != 0) {
+    fprintf(stderr, "unable to listen on port %d: %s\n", port, strerror(errno));
+    return false;
+  }
+
+  std::thread([fd, port, tls_ctx]() {
+    for (;;) {
+      int conn = accept(fd, nullptr, nullptr);
+      if (conn >= 0) {
+        std::thread(serve, conn, tls_ctx).detach();
+      } else if (errno != EINTR && errno != ECONNABORTED) {
+        fprintf(stderr, "accept failed on port %d: %s\n", port, strerror(errno));
+        sleep(1);
+      }
+    }
+  }).detach();
+  return true;
+}
+
+//
+// The client.
+//
+
+static void
+replay_session(const Session &session, Clock::time_point begin, double base, SSL_CTX *tls_ctx, Stats &stats)
+{
+  Connection conn;
+  std::string status_line;
+  Fields fields;
+  bool tls = session.tls && proxy_tls_port != 0;
+
+  ++stats.sessions;
+  stats.h2_sessions += session.h2;
+  if (session.tls && !tls) {
+    ++stats.tls_downgraded;
+  }
+
+  const std::string *host = find_field(session.transactions.front().client_request.fields, "Host");
+  std::string sni         = host ? host->substr(0, host->find(':')) : "";
+
+  for (const auto &txn : session.transactions) {
+    const Message &req = txn.client_request;
+
+    if (speed > 0 && txn.start_time > 0 && base > 0) {
+      std::this_thread::sleep_until(begin + std::chrono::duration_cast<Clock::duration>(
+                                              std::chrono::duration<double>((txn.start_time - base) / speed)));
+    }
+    if (!conn.is_open() && !conn.connect(proxy_host, tls ? proxy_tls_port : proxy_port, tls ? tls_ctx : nullptr, sni)) {
+      ++stats.errors;
+      if (verbose) {
+        fprintf(stderr, "unable to connect to %s:%d\n", proxy_host, tls ? proxy_tls_port : proxy_port);
+      }
+      return;
+    }
+
+    std::string header = req.method + ' ' + req.url + " HTTP/1.1\r\n";
+    for (const auto &field : req.fields) {
+      if (!is_hop_field(field.first)) {
+        header += field.first + ": " + field.second + "\r\n";
+      }
+    }
+    if (req.body_size > 0 || req.method == "POST" || req.method == "PUT") {
+      header += "Content-Length: " + std::to_string(req.body_size) + "\r\n";
+    }
+    if (!txn.uuid.empty()) {
+      header += "uuid: " + txn.uuid + "\r\n";
+    }
+    header += "\r\n";
+
+    Clock::time_point start = Clock::now();
+    bool to_close           = false;
+    bool ok                 = conn.write(header) && conn.write_body(req, req.body_size) && read_header(conn, status_line, fields);
+    int status              = ok ? atoi(status_line.c_str() + std::min(status_line.size(), static_cast<size_t>(9))) : 0;
+    // Interim responses come before the final one.
+    while (ok && status >= 100 && status < 200) {
+      ok     = read_header(conn, status_line, fields);
+      status = ok ? atoi(status_line.c_str() + std::min(status_line.size(), static_cast<size_t>(9))) : 0;
+    }
+    if (ok && response_has_body(req.method, status)) {
+      ok = read_body(conn, fields, true, to_close);
+    }
+    if (!ok) {
+      ++stats.errors;
+      if (verbose) {
+        fprintf(stderr, "%s %s failed\n", req.method.c_str(), req.url.c_str());
+      }
+      conn.close();
+      continue;
+    }
+
+    ++stats.transactions;
+    stats.latency.add(std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - start).count());
+    if (txn.proxy_response.present && txn.proxy_response.status != status) {
+      ++stats.mismatches;
+      if (verbose) {
+        fprintf(stderr, "%s %s: status %d, captured %d\n", req.method.c_str(), req.url.c_str(), status,
+                txn.proxy_response.status);
+      }
+    }
+    if (to_close || wants_close(fields)) {
+      conn.close();
+    }
+  }
+}
+
+static Stats
+replay(const std::vector<Session> &sessions, SSL_CTX *tls_ctx)
+{
+  // The sessions in the order they started, each starts at its offset from the first one.
+  std::vector<const Session *> order;
+  double base = 0;
+  for (const auto &session : sessions) {
+    order.push_back(&session);
+    if (session.connect_time > 0 && (base == 0 || session.connect_time < base)) {
+      base = session.connect_time;
+    }
+  }
+  std::stable_sort(order.begin(), order.end(),
+                   [](const Session *a, const Session *b) { return a->connect_time < b->connect_time; });
+
+  std::atomic<size_t> next{0};
+  std::mutex mutex;
+  Stats total;
+  Clock::time_point begin = Clock::now();
+  std::vector<std::thread> workers;
+
+  for (int i = 0; i < std::max(1, nthreads); ++i) {
+    workers.emplace_back([&]() {
+      Stats stats;
+      for (size_t n = next++; n < order.size(); n = next++) {
+        const Session &session = *order[n];
+        if (speed > 0 && session.connect_time > 0 && base > 0) {
+          Clock::time_point at = begin + std::chrono::duration_cast<Clock::duration>(
+                                           std::chrono::duration<double>((session.connect_time - base) / speed));
+          if (Clock::now() > at + std::chrono::seconds(1)) {
+            ++stats.late_sessions;
+          }
+          std::this_thread::sleep_until(at);
+        }
+        replay_session(session, begin, base, tls_ctx, stats);
+      }
+      std::lock_guard<std::mutex> lock(mutex);
+      total.merge(stats);
+    });
+  }
+  for (auto &worker : workers) {
+    worker.join();
+  }
+
+  double secs = std::chrono::duration<double>(Clock::now() - begin).count();
+  printf("%" PRIu64 " sessions, %" PRIu64 " transactions in %.3f s (%.1f/s), %" PRIu64 " errors, %" PRIu64 " status mismatches\n",
+         total.sessions, total.transactions, secs, secs > 0 ? total.transactions / secs : 0.0, total.errors, total.mismatches);
+  if (total.late_sessions || total.h2_sessions || total.tls_downgraded) {
+    printf("%" PRIu64 " sessions started late (add threads), %" PRIu64 " HTTP/2 sessions replayed over HTTP/1.1, %" PRIu64
+           " TLS sessions replayed without TLS\n",
+           total.late_sessions, total.h2_sessions, total.tls_downgraded);
+  }
+  total.latency.print(stdout);
+  return total;
+}
+
+int
+main(int /* argc ATS_UNUSED */, const char *argv[])
+{
+  appVersionInfo.setup(PACKAGE_NAME, "traffic_replay", PACKAGE_VERSION, __DATE__, __TIME__, BUILD_MACHINE, BUILD_PERSON, "");
+  process_args(&appVersionInfo, argument_descriptions, countof(argument_descriptions), argv,
+               "Usage: traffic_replay [options] <replay file or directory> ...");
+  setvbuf(stdout, nullptr, _IOLBF, 0);
+  signal(SIGPIPE, SIG_IGN);
+
+  bool client = proxy_port != 0 || proxy_tls_port != 0;
+  bool server = server_port != 0 || server_tls_port != 0;
+  if (n_file_arguments == 0 || (!client && !server)) {
+    usage(argument_descriptions, countof(argument_descriptions), "Usage: traffic_replay [options] <replay file or directory> ...");
+  }
+
+  std::vector<Session> sessions;
+  for (unsigned i = 0; i < n_file_arguments; ++i) {
+    load_path(file_arguments[i], sessions);
+  }
+  size_t ntxns = 0;
+  for (const auto &session : sessions) {
+    ntxns += session.transactions.size();
+  }
+  printf("loaded %zu sessions, %zu transactions\n", sessions.size(), ntxns);
+  if (sessions.empty()) {
+    return 1;
+  }
+
+  SSL_library_init();
+  SSL_load_error_strings();
+
+  if (server) {
+    for (const auto &session : sessions) {
+      for (const auto &txn : session.transactions) {
+        responses.add(txn);
+      }
+    }
+    if (server_port != 0 && !listen_on(server_port, nullptr)) {
+      return 1;
+    }
+    if (server_tls_port != 0) {
+      SSL_CTX *ctx = SSL_CTX_new(SSLv23_server_method());
+      if (SSL_CTX_use_certificate_chain_file(ctx, server_cert) != 1 ||
+          SSL_CTX_use_PrivateKey_file(ctx, *server_key ? server_key : server_cert, SSL_FILETYPE_PEM) != 1) {
+        fprintf(stderr, "unable to load the server certificate %s\n", server_cert);
+        ERR_print_errors_fp(stderr);
+        return 1;
+      }
+      if (!listen_on(server_tls_port, ctx)) {
+        return 1;
+      }
+    }
+  }
+
+  if (!client) {
+    for (;;) {
+      pause();
+    }
+  }
+
+  SSL_CTX *tls_ctx = SSL_CTX_new(SSLv23_client_method());
+  SSL_CTX_set_verify(tls_ctx, SSL_VERIFY_NONE, nullptr);
+
+  uint64_t errors = 0;
+  for (int i = 0; i < std::max(1, repeat); ++i) {
+    errors += replay(sessions, tls_ctx).errors;
+  }
+  return errors == 0 ? 0 : 1;
+}